@@ -228,15 +228,75 @@ namespace BasisClasses
     };
   }
     
+  void Basis::evaluateGrid(const Coord ctype,
+			   const std::vector<double>& x,
+			   const std::vector<double>& y,
+			   const std::vector<double>& z,
+			   std::vector<Eigen::Tensor<float, 3>>& out)
+  {
+    int nx = x.size(), ny = y.size(), nz = z.size();
+    int nf = getFieldLabels(ctype).size();
+
+    out.resize(nf);
+    for (auto & t : out) t.resize(nx, ny, nz);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<nx*ny; c++) {
+
+      int i = c/ny;
+      int j = c - i*ny;
+
+      // Quantities that depend on the column only
+      //
+      double R   = sqrt(x[i]*x[i] + y[j]*y[j]);
+      double phi = atan2(y[j], x[i]);
+
+      for (int k=0; k<nz; k++) {
+
+	std::vector<double> v;
+
+	if (ctype == Coord::Spherical) {
+	  double r = sqrt(R*R + z[k]*z[k]) + 1.0e-18;
+	  v = sph_eval(r, z[k]/r, phi);
+	} else if (ctype == Coord::Cylindrical) {
+	  v = cyl_eval(R + 1.0e-18, z[k], phi);
+	} else {
+	  v = crt_eval(x[i], y[j], z[k]);
+	}
+
+	for (int n=0; n<nf; n++) out[n](i, j, k) = v[n];
+      }
+    }
+  }
+
   std::vector<double> Basis::getFields(double x, double y, double z)
   {
+    auto guard = lock();
     return crt_eval(x, y, z);
   }
     
+  void Basis::addAccel(const Eigen::MatrixXd& ps, Eigen::MatrixXd& accel)
+  {
+    auto guard = lock();
+
+    const int rows = ps.rows();
+
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int n=0; n<rows; n++) {
+      auto v = crt_eval(ps(n, 0) - coefctr[0],
+			ps(n, 1) - coefctr[1],
+			ps(n, 2) - coefctr[2]);
+      // First 6 fields are density and potential, followed by acceleration
+      for (int k=0; k<3; k++) accel(n, k) += v[6+k] - pseudo(k);
+    }
+  }
+
   std::tuple<std::map<std::string, Eigen::VectorXd>, Eigen::VectorXd>
   Basis::getFieldsCoefs
   (double x, double y, double z, std::shared_ptr<CoefClasses::Coefs> coefs)
   {
+    auto guard = lock();
+
     // Python dictonary for return
     std::map<std::string, Eigen::VectorXd> ret;
 
@@ -267,6 +327,7 @@ namespace BasisClasses
   // Generate coefficients from the accumulated array values
   CoefClasses::CoefStrPtr Basis::makeFromArray(double time)
   {
+    auto guard = lock();
     make_coefs();
     load_coefs(coefret, time);
     return coefret;
@@ -278,6 +339,7 @@ namespace BasisClasses
   (Eigen::VectorXd& m, RowMatrixXd& p, double time, std::vector<double> ctr,
    bool roundrobin, bool posvelrows)
   {
+    auto guard = lock();
     initFromArray(ctr);
     addFromArray(m, p, roundrobin, posvelrows);
     return makeFromArray(time);
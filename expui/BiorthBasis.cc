@@ -3,6 +3,7 @@
 #include <YamlCheck.H>
 #include <EXPException.H>
 #include <BiorthBasis.H>
+#include <TableCache.H>
 #include <DiskModels.H>
 #include <exputils.H>
 #include <gaussQ.H>
@@ -45,6 +46,7 @@ namespace BasisClasses
     "EVEN_L",
     "EVEN_M",
     "M0_ONLY",
+    "legTol",
     "NOISE",
     "noiseN",
     "noise_model_file",
@@ -62,7 +64,8 @@ namespace BasisClasses
     "cachename",
     "modelname",
     "pyname",
-    "rnum"
+    "rnum",
+    "cuda"
   };
 
   std::vector<std::string> BiorthBasis::getFieldLabels(const Coord ctype)
@@ -173,6 +176,7 @@ namespace BasisClasses
       N1 = 0;
       N2 = std::numeric_limits<int>::max();
       NO_L0 = NO_L1 = EVEN_L = EVEN_M = M0_only = false;
+      legTol = 0.0;
       
       if (conf["N1"]   )     N1        = conf["N1"].as<bool>();
       if (conf["N2"]   )     N2        = conf["N2"].as<bool>();
@@ -181,6 +185,7 @@ namespace BasisClasses
       if (conf["EVEN_L"])    EVEN_L    = conf["EVEN_L"].as<bool>();
       if (conf["EVEN_M"])    EVEN_M    = conf["EVEN_M"].as<bool>();
       if (conf["M0_ONLY"])   M0_only   = conf["M0_ONLY"].as<bool>();
+      if (conf["legTol"])    legTol    = conf["legTol"].as<double>();
     } 
     catch (YAML::Exception & error) {
       if (myid==0) std::cout << "Error parsing parameter stanza for <"
@@ -193,6 +198,8 @@ namespace BasisClasses
       throw std::runtime_error("Spherical: error parsing YAML");
     }
 
+    if (legTol>0.0) legtable = std::make_shared<LegendreTable>(lmax, legTol);
+
     // Number of possible threads
     int nthrds = omp_get_max_threads();
     
@@ -214,6 +221,13 @@ namespace BasisClasses
     for (auto & v : dlegs ) v.resize(lmax+1, lmax+1);
     for (auto & v : d2legs) v.resize(lmax+1, lmax+1);
 
+    // Per-thread accumulation
+    //
+    expcoefT.resize(nthrds);
+    for (auto & v : expcoefT) v = Eigen::MatrixXd::Zero((lmax+1)*(lmax+1), nmax);
+    usedT.assign(nthrds, 0);
+    massT.assign(nthrds, 0.0);
+
     expcoef.resize((lmax+1)*(lmax+1), nmax);
     expcoef.setZero();
       
@@ -250,6 +264,7 @@ namespace BasisClasses
     try {
       if (conf["modelname"]) model_file = conf["modelname"].as<std::string>();
       if (conf["cachename"]) cachename  = conf["cachename"].as<std::string>();
+      if (conf["cuda"])      use_cuda   = conf["cuda"].as<bool>();
     } 
     catch (YAML::Exception & error) {
       if (myid==0) std::cout << "Error parsing parameter stanza for <"
@@ -274,6 +289,15 @@ namespace BasisClasses
 	 "reading a previously generated basis cache\n");
     }
 
+#if HAVE_LIBCUDA==0
+    if (use_cuda) {
+      if (myid==0)
+	std::cout << "---- SphericalSL: this build has no CUDA support, "
+		  << "accumulating on the CPU" << std::endl;
+      use_cuda = false;
+    }
+#endif
+
     // Set MPI flag in SLGridSph from MPI_Initialized
     SLGridSph::mpi = use_mpi ? 1 : 0;
     
@@ -288,10 +312,15 @@ namespace BasisClasses
     if (not conf["rmax"] or rmax > mod->get_max_radius()) 
       rmax = mod->get_max_radius()*0.99;
     
-    // Finally, make the Sturm-Lioville basis...
-    sl = std::make_shared<SLGridSph>
-      (model_file, lmax, nmax, numr, rmin, rmax, true, cmap, rmap,
-       0, 1, cachename);
+    // Finally, make the Sturm-Lioville basis, or share the tables of
+    // an identical instance
+    sl = TableCache::get<SLGridSph>
+      ("sphereSL" + TableCache::normalize(conf), {model_file, cachename},
+       [&]() {
+	 return std::make_shared<SLGridSph>
+	   (model_file, lmax, nmax, numr, rmin, rmax, true, cmap, rmap,
+	    0, 1, cachename);
+       });
     
     // Test basis for consistency
     orthoTest(200);
@@ -304,6 +333,10 @@ namespace BasisClasses
 	rnum = conf["rnum"].as<int>();
       else
 	rnum = 2000;
+
+      // Optional persistent cache for the Bessel function zeros
+      if (conf["cachename"])
+	SphBessRoots::cache(conf["cachename"].as<std::string>());
     } 
     catch (YAML::Exception & error) {
       if (myid==0) std::cout << "Error parsing parameter stanza for <"
@@ -316,8 +349,13 @@ namespace BasisClasses
       throw std::runtime_error("SphericalSL: error parsing YAML");
     }
     
-    // Finally, make the Sturm-Lioville basis...
-    bess = std::make_shared<BiorthBess>(rmax, lmax, nmax, rnum);
+    // Finally, make the Bessel function tables, or share the tables
+    // of an identical instance
+    bess = TableCache::get<BiorthBess>
+      ("Bessel" + TableCache::normalize(conf), {},
+       [&]() {
+	 return std::make_shared<BiorthBess>(rmax, lmax, nmax, rnum);
+       });
 
     // Test basis for consistency
     orthoTest(200);
@@ -326,6 +364,9 @@ namespace BasisClasses
   void Spherical::reset_coefs(void)
   {
     if (expcoef.rows()>0 && expcoef.cols()>0) expcoef.setZero();
+    for (auto & v : expcoefT) v.setZero();
+    std::fill(usedT.begin(), usedT.end(), 0);
+    std::fill(massT.begin(), massT.end(), 0.0);
     totalMass = 0.0;
     used = 0;
   }
@@ -443,12 +484,14 @@ namespace BasisClasses
     
     if (r < rmin or r > rmax) return;
     
-    used++;
-    totalMass += mass;
+    usedT[tid]++;
+    massT[tid] += mass;
     
     get_pot(potd[tid], rs);
     
     legendre_R(lmax, costh, legs[tid]);
+
+    auto & coef = expcoefT[tid];
     
     // L loop
     for (int l=0, loffset=0; l<=lmax; loffset+=(2*l+1), l++) {
@@ -463,7 +506,7 @@ namespace BasisClasses
 	  fac = factorial(l, m) * legs[tid](l, m);
 	  for (int n=0; n<nmax; n++) {
 	    fac4 = potd[tid](l, n)*fac;
-	    expcoef(loffset+moffset, n) += fac4 * norm * mass;
+	    coef(loffset+moffset, n) += fac4 * norm * mass;
 	  }
 	  
 	  moffset++;
@@ -474,8 +517,8 @@ namespace BasisClasses
 	  fac2 = fac*sin(phi*m);
 	  for (int n=0; n<nmax; n++) {
 	    fac4 = potd[tid](l, n);
-	    expcoef(loffset+moffset  , n) += fac1 * fac4 * norm * mass;
-	    expcoef(loffset+moffset+1, n) += fac2 * fac4 * norm * mass;
+	    coef(loffset+moffset  , n) += fac1 * fac4 * norm * mass;
+	    coef(loffset+moffset+1, n) += fac2 * fac4 * norm * mass;
 	  }
 	  
 	  moffset+=2;
@@ -487,15 +530,26 @@ namespace BasisClasses
   
   void Spherical::make_coefs()
   {
+    // Sum the thread contributions
+    //
+    for (int t=0; t<expcoefT.size(); t++) {
+      expcoef   += expcoefT[t];
+      used      += usedT[t];
+      totalMass += massT[t];
+      expcoefT[t].setZero();
+      usedT[t] = 0;
+      massT[t] = 0.0;
+    }
+
     if (use_mpi) {
       
       MPI_Allreduce(MPI_IN_PLACE, &used, 1, MPI_INT,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
       
       for (int l=0; l<(lmax+1)*(lmax+1); l++) {
 	work = expcoef.row(l);
 	MPI_Allreduce(MPI_IN_PLACE, work.data(), nmax, MPI_DOUBLE,
-		      MPI_SUM, MPI_COMM_WORLD);
+		      MPI_SUM, comm);
 	expcoef.row(l) = work;
       }
     }
@@ -503,12 +557,22 @@ namespace BasisClasses
   
   std::vector<double>
   Spherical::sph_eval(double r, double costh, double phi)
+  {
+    Eigen::VectorXd cosm(lmax+1), sinm(lmax+1);
+    sinecosine_R(lmax, phi, cosm, sinm);
+
+    return sph_eval_trig(r, costh, cosm, sinm);
+  }
+
+  std::vector<double>
+  Spherical::sph_eval_trig(double r, double costh,
+			   const Eigen::VectorXd& cosm,
+			   const Eigen::VectorXd& sinm)
   {
     // Get thread id
     int tid = omp_get_thread_num();
 
-    double fac1, cosm, sinm;
-    double sinth = -sqrt(fabs(1.0 - costh*costh));
+    double fac1;
     
     fac1 = factorial(0, 0);
     
@@ -567,9 +631,8 @@ namespace BasisClasses
 	  moffset++;
 	}
 	else {
-	  cosm = cos(phi*m);
-	  sinm = sin(phi*m);
-	  
+	  double cm = cosm[m], sm = sinm[m];
+
 	  double sumR0=0.0, sumP0=0.0, sumD0=0.0;
 	  double sumR1=0.0, sumP1=0.0, sumD1=0.0;
 	  for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -581,11 +644,11 @@ namespace BasisClasses
 	    sumD1 += expcoef(loffset+moffset+1, n) * dpot[tid](l, n);
 	  }
 	  
-	  den1 += fac1 * legs[tid] (l, m) *  ( sumR0*cosm + sumR1*sinm );
-	  pot1 += fac1 * legs[tid] (l, m) *  ( sumP0*cosm + sumP1*sinm );
-	  potr += fac1 * legs[tid] (l, m) *  ( sumD0*cosm + sumD1*sinm );
-	  pott += fac1 * dlegs[tid](l, m) *  ( sumP0*cosm + sumP1*sinm );
-	  potp += fac1 * legs[tid] (l, m) *  (-sumP0*sinm + sumP1*cosm ) * m;
+	  den1 += fac1 * legs[tid] (l, m) *  ( sumR0*cm + sumR1*sm );
+	  pot1 += fac1 * legs[tid] (l, m) *  ( sumP0*cm + sumP1*sm );
+	  potr += fac1 * legs[tid] (l, m) *  ( sumD0*cm + sumD1*sm );
+	  pott += fac1 * dlegs[tid](l, m) *  ( sumP0*cm + sumP1*sm );
+	  potp += fac1 * legs[tid] (l, m) *  (-sumP0*sm + sumP1*cm ) * m;
 	  
 	  moffset +=2;
 	}
@@ -641,6 +704,66 @@ namespace BasisClasses
     
     return {v[0], v[1], v[2], v[3], v[4], v[5], tpotx, tpoty, v[7]};
   }
+
+  void Spherical::evaluateGrid(const Coord ctype,
+			       const std::vector<double>& x,
+			       const std::vector<double>& y,
+			       const std::vector<double>& z,
+			       std::vector<Eigen::Tensor<float, 3>>& out)
+  {
+    int nx = x.size(), ny = y.size(), nz = z.size();
+    int nf = getFieldLabels(ctype).size();
+
+    out.resize(nf);
+    for (auto & t : out) t.resize(nx, ny, nz);
+
+#pragma omp parallel
+    {
+      Eigen::VectorXd cosm(lmax+1), sinm(lmax+1);
+
+#pragma omp for schedule(dynamic)
+      for (int c=0; c<nx*ny; c++) {
+
+	int i = c/ny;
+	int j = c - i*ny;
+
+	// The azimuthal factors are the same for the entire column
+	//
+	double R   = sqrt(x[i]*x[i] + y[j]*y[j]);
+	double phi = atan2(y[j], x[i]);
+
+	sinecosine_R(lmax, phi, cosm, sinm);
+
+	// Offset the axis as in the point-wise evaluation
+	//
+	if (ctype == Coord::Cylindrical) R += 1.0e-18;
+
+	for (int k=0; k<nz; k++) {
+
+	  double r = sqrt(R*R + z[k]*z[k]) + 1.0e-18;
+	  double costh = z[k]/r, sinth = R/r;
+
+	  auto v = sph_eval_trig(r, costh, cosm, sinm);
+
+	  if (ctype != Coord::Spherical) {
+	    double potR = v[6]*sinth + v[7]*costh;
+	    double potz = v[6]*costh - v[7]*sinth;
+
+	    if (ctype == Coord::Cylindrical) {
+	      v[6] = potR;
+	      v[7] = potz;
+	    } else {
+	      v[6] = potR*x[i]/R - v[8]*y[j]/R;
+	      v[7] = potR*y[j]/R + v[8]*x[i]/R;
+	      v[8] = potz;
+	    }
+	  }
+
+	  for (int n=0; n<nf; n++) out[n](i, j, k) = v[n];
+	}
+      }
+    }
+  }
   
 
   Spherical::BasisArray SphericalSL::getBasis
@@ -720,6 +843,8 @@ namespace BasisClasses
   
   void BiorthBasis::legendre_R(int lmax, double x, Eigen::MatrixXd& p)
   {
+    if (legtable and legtable->Lmax()==lmax) return legtable->eval(x, p);
+
     double fact, somx2, pll, pl1, pl2;
     
     p(0, 0) = pll = 1.0;
@@ -771,6 +896,8 @@ namespace BasisClasses
   void BiorthBasis::legendre_R(int lmax, double x, Eigen::MatrixXd& p,
 			      Eigen::MatrixXd &dp)
   {
+    if (legtable and legtable->Lmax()==lmax) return legtable->eval(x, p, dp);
+
     double fact, somx2, pll, pl1, pl2;
     
     p(0, 0) = pll = 1.0;
@@ -855,6 +982,23 @@ namespace BasisClasses
     }
     
   }
+
+  void BiorthBasis::sinecosine_R(int mmax, double phi,
+				 Eigen::VectorXd& c, Eigen::VectorXd& s)
+  {
+    c[0] = 1.0;
+    s[0] = 0.0;
+
+    if (mmax<1) return;
+
+    c[1] = cos(phi);
+    s[1] = sin(phi);
+
+    for (int m=2; m<=mmax; m++) {
+      c[m] = 2.0*c[1]*c[m-1] - c[m-2];
+      s[m] = 2.0*c[1]*s[m-1] - s[m-2];
+    }
+  }
   
   // Disk target types for cylindrical basis construction
   const std::map<std::string, Cylindrical::DiskType> Cylindrical::dtlookup =
@@ -928,7 +1072,11 @@ namespace BasisClasses
     "playback",
     "coefCompute",
     "coefMaster",
-    "pyname"
+    "pyname",
+    "mmapcache",
+    "tabtol",
+    "floattable",
+    "loadtables"
   };
 
   Cylindrical::Cylindrical(const YAML::Node& CONF) :
@@ -1069,6 +1217,10 @@ namespace BasisClasses
     tnum        = 80;
     ashift      = 0.0;
     logarithmic = false;
+    mmapcache   = false;
+    tabtol      = 0.0;
+    floattable  = false;
+    loadtables  = "all";
     density     = true;
     EVEN_M      = false;
     cmapR       = 1;
@@ -1145,6 +1297,10 @@ namespace BasisClasses
 
       if (conf["ashift"    ])     ashift  = conf["ashift"    ].as<double>();
       if (conf["logr"      ]) logarithmic = conf["logr"      ].as<bool>();
+      if (conf["mmapcache" ])   mmapcache = conf["mmapcache" ].as<bool>();
+      if (conf["tabtol"    ])      tabtol = conf["tabtol"    ].as<double>();
+      if (conf["floattable"])  floattable = conf["floattable"].as<bool>();
+      if (conf["loadtables"])  loadtables = conf["loadtables"].as<std::string>();
       if (conf["EVEN_M"    ])     EVEN_M  = conf["EVEN_M"    ].as<bool>();
       if (conf["cmapr"     ])      cmapR  = conf["cmapr"     ].as<int>();
       if (conf["cmapz"     ])      cmapZ  = conf["cmapz"     ].as<int>();
@@ -1215,6 +1371,10 @@ namespace BasisClasses
     EmpCylSL::CMAPZ       = cmapZ;
     EmpCylSL::logarithmic = logarithmic;
     EmpCylSL::VFLAG       = vflag;
+    EmpCylSL::MMAPCACHE   = mmapcache;
+    EmpCylSL::TABTOL      = tabtol;
+    EmpCylSL::FLOATTABLE  = floattable;
+    EmpCylSL::LOADTABLES  = EmpCylSL::parseTables(loadtables);
     
     // Check for non-null cache file name.  This must be specified
     // to prevent recomputation and unexpected behavior.
@@ -1577,7 +1737,8 @@ namespace BasisClasses
     "tksmooth",
     "tkcum",
     "tk_type",
-    "cachename"
+    "cachename",
+    "loadtables"
   };
 
   FlatDisk::FlatDisk(const YAML::Node& CONF) :
@@ -1675,9 +1836,13 @@ namespace BasisClasses
 	 "reading a previously generated basis cache\n");
     }
 
-    // Finally, make the basis
+    // Finally, make the basis, or share the tables of an identical
+    // instance
     //
-    ortho = std::make_shared<BiorthCyl>(conf);
+    ortho = TableCache::get<BiorthCyl>
+      ("flatdisk" + TableCache::normalize(conf),
+       {conf["cachename"].as<std::string>()},
+       [&]() { return std::make_shared<BiorthCyl>(conf); });
     
     // Orthogonality sanity check
     //
@@ -1699,6 +1864,11 @@ namespace BasisClasses
     for (auto & v : potZ) v.resize(mmax+1, nmax);
     for (auto & v : dend) v.resize(mmax+1, nmax);
 
+    cosm.resize(nthrds);
+    sinm.resize(nthrds);
+    for (auto & v : cosm) v.resize(mmax+1);
+    for (auto & v : sinm) v.resize(mmax+1);
+
     expcoef.resize(2*mmax+1, nmax);
     expcoef.setZero();
       
@@ -1819,6 +1989,7 @@ namespace BasisClasses
       double phi = atan2(y, x);
 
       ortho->get_pot(potd[tid], R, 0.0);
+      sinecosine_R(mmax, phi, cosm[tid], sinm[tid]);
     
       // M loop
       for (int m=0, moffset=0; m<=mmax; m++) {
@@ -1831,8 +2002,8 @@ namespace BasisClasses
 	  moffset++;
 	}
 	else {
-	  double ccos = cos(phi*m);
-	  double ssin = sin(phi*m);
+	  double ccos = cosm[tid][m];
+	  double ssin = sinm[tid][m];
 	  for (int n=0; n<nmax; n++) {
 	    expcoef(moffset  , n) += ccos * potd[tid](m, n) * mass * norm1;
 	    expcoef(moffset+1, n) += ssin * potd[tid](m, n) * mass * norm1;
@@ -1849,12 +2020,12 @@ namespace BasisClasses
     if (use_mpi) {
       
       MPI_Allreduce(MPI_IN_PLACE, &used, 1, MPI_INT,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
       
       for (int m=0; m<2*mmax+1; m++) {
 	work = expcoef.row(m);
 	MPI_Allreduce(MPI_IN_PLACE, work.data(), nmax, MPI_DOUBLE,
-		      MPI_SUM, MPI_COMM_WORLD);
+		      MPI_SUM, comm);
 	expcoef.row(m) = work;
       }
     }
@@ -1884,10 +2055,8 @@ namespace BasisClasses
 
     // Get the basis fields
     //
-    ortho->get_dens   (dend[tid],  R, z);
-    ortho->get_pot    (potd[tid],  R, z);
-    ortho->get_rforce (potR[tid],  R, z);
-    ortho->get_zforce (potZ[tid],  R, z);
+    ortho->get_all(dend[tid], potd[tid], potR[tid], potZ[tid], R, z);
+    sinecosine_R(mmax, phi, cosm[tid], sinm[tid]);
     
     // m loop
     //
@@ -1908,7 +2077,7 @@ namespace BasisClasses
 	
 	moffset++;
       } else {
-	double cosm = cos(phi*m), sinm = sin(phi*m);
+	double ccos = cosm[tid][m], ssin = sinm[tid][m];
 	double vc, vs;
 
 	vc = vs = 0.0;
@@ -1917,7 +2086,7 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * dend[tid](m, n);
 	}
 	
-	den1 += (vc*cosm + vs*sinm) * norm1;
+	den1 += (vc*ccos + vs*ssin) * norm1;
       
 	vc = vs = 0.0;
 	for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -1925,8 +2094,8 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * potd[tid](m, n);
 	}
 	
-	pot1 += ( vc*cosm + vs*sinm) * norm1;
-	ppot += (-vc*sinm + vs*cosm) * m * norm1;
+	pot1 += ( vc*ccos + vs*ssin) * norm1;
+	ppot += (-vc*ssin + vs*ccos) * m * norm1;
 
 	vc = vs = 0.0;
 	for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -1934,7 +2103,7 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * potR[tid](m, n);
 	}
 
-	rpot += (vc*cosm + vs*sinm) * norm1;
+	rpot += (vc*ccos + vs*ssin) * norm1;
 	
 	vc = vs = 0.0;
 	for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -1942,7 +2111,7 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * potZ[tid](m, n);
 	}
 
-	zpot += (vc*cosm + vs*sinm) * norm1;
+	zpot += (vc*ccos + vs*ssin) * norm1;
 
 	moffset +=2;
       }
@@ -2147,6 +2316,11 @@ namespace BasisClasses
     for (auto & v : potR) v.resize(mmax+1, nmax);
     for (auto & v : dend) v.resize(mmax+1, nmax);
 
+    cosm.resize(nthrds);
+    sinm.resize(nthrds);
+    for (auto & v : cosm) v.resize(mmax+1);
+    for (auto & v : sinm) v.resize(mmax+1);
+
     expcoef.resize(2*mmax+1, nmax);
     expcoef.setZero();
       
@@ -2380,9 +2554,13 @@ namespace BasisClasses
 
     double Rmax = scale*100.0;
 
+#pragma omp parallel for
     for (int m=0; m<=mmax; m++) {
 
-      ret[m].setZero();
+      // Tabulate the basis at the knots, one row per knot, with the
+      // quadrature weight folded into the potential
+      //
+      Eigen::MatrixXd P(num, nmax), D(num, nmax);
 
       for (int i=0; i<num; i++) {
 	double r = lq.knot(i) * Rmax, fac = lq.weight(i) * Rmax;
@@ -2391,12 +2569,11 @@ namespace BasisClasses
 	potl(m, r/scale, vpot);
 	dens(m, r/scale, vden);
 
-	for (int j=0; j<nmax; j++) {
-	  for (int k=0; k<nmax; k++) {
-	    ret[m](j, k) += fac * vpot(j) * vden(k) * r * 2.0*M_PI * fac1*fac2;
-	  }
-	}
+	P.row(i) = fac * r * 2.0*M_PI * fac1*fac2 * vpot.transpose();
+	D.row(i) = vden.transpose();
       }
+
+      ret[m] = P.transpose() * D;
     }
 
     // DEBUG
@@ -2520,6 +2697,7 @@ namespace BasisClasses
     double phi = atan2(y, x);
 
     get_pot(potd[tid], R);
+    sinecosine_R(mmax, phi, cosm[tid], sinm[tid]);
     
     // M loop
     for (int m=0, moffset=0; m<=mmax; m++) {
@@ -2532,8 +2710,8 @@ namespace BasisClasses
 	moffset++;
       }
       else {
-	double ccos = cos(phi*m);
-	double ssin = sin(phi*m);
+	double ccos = cosm[tid][m];
+	double ssin = sinm[tid][m];
 	for (int n=0; n<nmax; n++) {
 	  expcoef(moffset  , n) += ccos * potd[tid](m, n) * mass * norm1;
 	  expcoef(moffset+1, n) += ssin * potd[tid](m, n) * mass * norm1;
@@ -2548,12 +2726,12 @@ namespace BasisClasses
     if (use_mpi) {
       
       MPI_Allreduce(MPI_IN_PLACE, &used, 1, MPI_INT,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
       
       for (int m=0; m<2*mmax+1; m++) {
 	work = expcoef.row(m);
 	MPI_Allreduce(MPI_IN_PLACE, work.data(), nmax, MPI_DOUBLE,
-		      MPI_SUM, MPI_COMM_WORLD);
+		      MPI_SUM, comm);
 	expcoef.row(m) = work;
       }
     }
@@ -2575,6 +2753,7 @@ namespace BasisClasses
     get_dens  (dend[tid], R);
     get_pot   (potd[tid], R);
     get_force (potR[tid], R);
+    sinecosine_R(mmax, phi, cosm[tid], sinm[tid]);
     
     // m loop
     //
@@ -2594,7 +2773,7 @@ namespace BasisClasses
 	
 	moffset++;
       } else {
-	double cosm = cos(phi*m), sinm = sin(phi*m);
+	double ccos = cosm[tid][m], ssin = sinm[tid][m];
 	double vc, vs;
 
 	vc = vs = 0.0;
@@ -2603,7 +2782,7 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * dend[tid](m, n);
 	}
 	
-	den1 += (vc*cosm + vs*sinm) * norm1;
+	den1 += (vc*ccos + vs*ssin) * norm1;
       
 	vc = vs = 0.0;
 	for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -2611,8 +2790,8 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * potd[tid](m, n);
 	}
 	
-	pot1 += ( vc*cosm + vs*sinm) * norm1;
-	ppot += (-vc*sinm + vs*cosm) * m * norm1;
+	pot1 += ( vc*ccos + vs*ssin) * norm1;
+	ppot += (-vc*ssin + vs*ccos) * m * norm1;
 
 	vc = vs = 0.0;
 	for (int n=std::max<int>(0, N1); n<=std::min<int>(nmax-1, N2); n++) {
@@ -2620,7 +2799,7 @@ namespace BasisClasses
 	  vs += expcoef(moffset+1, n) * potR[tid](m, n);
 	}
 
-	rpot += (vc*cosm + vs*sinm) * norm1;
+	rpot += (vc*ccos + vs*ssin) * norm1;
 	
 	moffset +=2;
       }
@@ -2946,10 +3125,10 @@ namespace BasisClasses
     if (use_mpi) {
       
       MPI_Allreduce(MPI_IN_PLACE, &used, 1, MPI_INT,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
       
       MPI_Allreduce(MPI_IN_PLACE, expcoef.data(), expcoef.size(), MPI_DOUBLE_COMPLEX,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
     }
   }
   
@@ -3091,6 +3270,118 @@ namespace BasisClasses
   }
 
 
+  void Slab::evaluateGrid(const Coord ctype,
+			  const std::vector<double>& x,
+			  const std::vector<double>& y,
+			  const std::vector<double>& z,
+			  std::vector<Eigen::Tensor<float, 3>>& out)
+  {
+    int nx = x.size(), ny = y.size(), nz = z.size();
+    int nf = getFieldLabels(ctype).size();
+
+    out.resize(nf);
+    for (auto & t : out) t.resize(nx, ny, nz);
+
+    // Horizontal phase factors, one row per grid point
+    //
+    Eigen::MatrixXcd Ex, Ey;
+    BiorthCube::phases(x.data(), nx, nmaxx, Ex);
+    BiorthCube::phases(y.data(), ny, nmaxy, Ey);
+
+#pragma omp parallel
+    {
+      Eigen::VectorXd vpot(nmaxz), vfrc(nmaxz), vden(nmaxz);
+
+      // Potential, density and the three force components by
+      // horizontal wave number at one height
+      //
+      std::vector<Eigen::MatrixXcd> G(5, Eigen::MatrixXcd(imx, imy));
+      Eigen::MatrixXd F[5];
+
+#pragma omp for schedule(dynamic)
+      for (int k=0; k<nz; k++) {
+
+	// Contract the vertical basis with the coefficients; the
+	// same selection as eval()
+	//
+	for (int ix=0; ix<imx; ix++) {
+	  int ii = ix - nmaxx;
+	  int iix = abs(ii);
+
+	  for (int iy=0; iy<imy; iy++) {
+	    int jj = iy - nmaxy;
+	    int iiy = abs(jj);
+
+	    if (iix<nminx || iiy<nminy) {
+	      for (auto & g : G) g(ix, iy) = 0.0;
+	      continue;
+	    }
+
+	    if (iix>=iiy) {
+	      ortho->get_pot  (vpot, z[k], iix, iiy);
+	      ortho->get_force(vfrc, z[k], iix, iiy);
+	      ortho->get_dens (vden, z[k], iix, iiy);
+	    }
+	    else {
+	      ortho->get_pot  (vpot, z[k], iiy, iix);
+	      ortho->get_force(vfrc, z[k], iiy, iix);
+	      ortho->get_dens (vden, z[k], iiy, iix);
+	    }
+
+	    std::complex<double> sp(0.0), sf(0.0), sd(0.0);
+	    for (int iz=0; iz<imz; iz++) {
+	      sp += vpot[iz]*expcoef(ix, iy, iz);
+	      sf += vfrc[iz]*expcoef(ix, iy, iz);
+	      sd += vden[iz]*expcoef(ix, iy, iz);
+	    }
+
+	    G[0](ix, iy) = sp;
+	    G[1](ix, iy) = sd;
+	    G[2](ix, iy) = -kfac*static_cast<double>(ii)*sp;
+	    G[3](ix, iy) = -kfac*static_cast<double>(jj)*sp;
+	    G[4](ix, iy) = -sf;
+	  }
+	}
+
+	// Contract the horizontal phase factors for the entire plane
+	//
+	for (int f=0; f<5; f++) F[f] = (Ex * G[f] * Ey.transpose()).real();
+
+	for (int i=0; i<nx; i++) {
+	  for (int j=0; j<ny; j++) {
+	    double pot  = F[0](i, j), den  = F[1](i, j);
+	    double frcx = F[2](i, j), frcy = F[3](i, j), frcz = F[4](i, j);
+
+	    double v[9] = {0, den, den, 0, pot, pot, frcx, frcy, frcz};
+
+	    // Projections as in cyl_eval() and sph_eval()
+	    //
+	    if (ctype == Coord::Cylindrical or ctype == Coord::Spherical) {
+	      double phi = atan2(y[j], x[i]);
+	      double cosp = cos(phi), sinp = sin(phi);
+
+	      if (ctype == Coord::Cylindrical) {
+		v[6] = -(frcx*cosp + frcy*sinp);
+		v[7] = -frcz;
+		v[8] = -(-frcx*sinp + frcy*cosp);
+	      } else {
+		double R = sqrt(x[i]*x[i] + y[j]*y[j]);
+		double r = sqrt(R*R + z[k]*z[k]) + 1.0e-18;
+		double costh = z[k]/r, sinth = sqrt(fabs(1.0 - costh*costh));
+
+		v[6] = -(frcx*cosp*sinth + frcy*sinp*sinth + frcz*costh);
+		v[7] = -(frcx*cosp*costh + frcy*sinp*costh - frcz*sinth);
+		v[8] = -(-frcx*sinp + frcy*cosp);
+	      }
+	    }
+
+	    for (int n=0; n<nf; n++) out[n](i, j, k) = v[n];
+	  }
+	}
+      }
+    }
+  }
+
   Slab::BasisArray Slab::getBasis
   (double zmin, double zmax, int numgrid)
   {
@@ -3168,7 +3459,9 @@ namespace BasisClasses
     "knots",
     "verbose",
     "check",
-    "method"
+    "method",
+    "nufft",
+    "nuffttol"
   };
 
   Cube::Cube(const YAML::Node& CONF) : BiorthBasis(CONF, "cube")
@@ -3198,6 +3491,12 @@ namespace BasisClasses
     //
     bool check = false;
 
+    // Use the non-uniform FFT for accumulation and evaluation (false
+    // by default)
+    //
+    bool   nufft    = false;
+    double nuffttol = 1.0e-8;
+
     // Check for unmatched keys
     //
     auto unmatched = YamlCheck(conf, valid_keys);
@@ -3222,6 +3521,9 @@ namespace BasisClasses
       if (conf["knots"])      knots = conf["knots"].as<int>();
 
       if (conf["check"])      check = conf["check"].as<bool>();
+
+      if (conf["nufft"])      nufft = conf["nufft"].as<bool>();
+      if (conf["nuffttol"])   nuffttol = conf["nuffttol"].as<double>();
     } 
     catch (YAML::Exception & error) {
       if (myid==0) std::cout << "Error parsing parameter stanza for <"
@@ -3249,6 +3551,12 @@ namespace BasisClasses
     expcoef.resize(2*nmaxx+1, 2*nmaxy+1, 2*nmaxz+1);
     expcoef.setZero();
       
+    // Density, potential and three force components
+    //
+    if (nufft)
+      nuft = std::make_shared<NUFFT3d>(nmaxx, nmaxy, nmaxz, nthrds,
+				       nuffttol, 5);
+
     used = 0;
 
     // Set cartesian coordindates
@@ -3258,6 +3566,7 @@ namespace BasisClasses
   
   void Cube::reset_coefs(void)
   {
+    if (nuft) nuft->reset();
     expcoef.setZero();
     totalMass = 0.0;
     used = 0;
@@ -3307,6 +3616,8 @@ namespace BasisClasses
     expcoef = *cf->coefs;
 
     coefctr = {0.0, 0.0, 0.0};
+
+    if (nuft) nufft_prepare();
   }
 
   void Cube::accumulate(double x, double y, double z, double mass)
@@ -3327,6 +3638,13 @@ namespace BasisClasses
     else
       z -= std::floor( z);
     
+    // Spread onto the grid of this thread; the sums are done in
+    // make_coefs()
+    //
+    if (nuft) {
+      nuft->spread(omp_get_thread_num(), x, y, z, mass);
+      return;
+    }
     
     // Recursion multipliers
     Eigen::Vector3cd step
@@ -3363,14 +3681,92 @@ namespace BasisClasses
   
   void Cube::make_coefs()
   {
+    if (nuft) {
+      NUFFT3d::coefType F;
+      nuft->transform(F);
+
+      for (int ix=0; ix<=2*nmaxx; ix++) {
+	for (int iy=0; iy<=2*nmaxy; iy++) {
+	  for (int iz=0; iz<=2*nmaxz; iz++) {
+	    int ii = ix-nmaxx;
+	    int jj = iy-nmaxy;
+	    int kk = iz-nmaxz;
+
+	    if (ii==0 and jj==0 and kk==0) continue;
+
+	    double norm = 1.0/sqrt(M_PI*(ii*ii + jj*jj + kk*kk));
+
+	    expcoef(ix, iy, iz) += - F(ix, iy, iz) * norm;
+	  }
+	}
+      }
+    }
+
     if (use_mpi) {
       
       MPI_Allreduce(MPI_IN_PLACE, &used, 1, MPI_INT,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
       
       MPI_Allreduce(MPI_IN_PLACE, expcoef.data(), expcoef.size(), MPI_DOUBLE_COMPLEX,
-		    MPI_SUM, MPI_COMM_WORLD);
+		    MPI_SUM, comm);
+    }
+
+    if (nuft) nufft_prepare();
+  }
+  
+  void Cube::nufft_prepare()
+  {
+    // Same wave number selection as BiorthCube::get_dens(),
+    // get_pot() and get_force()
+    //
+    std::vector<NUFFT3d::coefType> a(5);
+    for (auto & v : a) {
+      v.resize(2*nmaxx+1, 2*nmaxy+1, 2*nmaxz+1);
+      v.setZero();
+    }
+
+    const double dfac = 2.0*M_PI;
+
+    for (int ix=0; ix<=2*nmaxx; ix++) {
+      for (int iy=0; iy<=2*nmaxy; iy++) {
+	for (int iz=0; iz<=2*nmaxz; iz++) {
+	  int ii = ix-nmaxx;
+	  int jj = iy-nmaxy;
+	  int kk = iz-nmaxz;
+
+	  if (ii==0 and jj==0 and kk==0) continue;
+	  if (abs(ii)>nminx or abs(jj)>nminy or abs(kk)>nminz) continue;
+
+	  double k2 = M_PI*(ii*ii + jj*jj + kk*kk);
+	  std::complex<double> fac = expcoef(ix, iy, iz);
+
+	  a[0](ix, iy, iz) = -fac*sqrt(k2);
+	  a[1](ix, iy, iz) =  fac/sqrt(k2);
+	  a[2](ix, iy, iz) = -std::complex<double>(0.0, dfac*ii)*a[1](ix, iy, iz);
+	  a[3](ix, iy, iz) = -std::complex<double>(0.0, dfac*jj)*a[1](ix, iy, iz);
+	  a[4](ix, iy, iz) = -std::complex<double>(0.0, dfac*kk)*a[1](ix, iy, iz);
+	}
+      }
+    }
+
+    nuft->prepare(a);
+  }
+
+  std::tuple<double, double, Eigen::Vector3d>
+  Cube::fields(const Eigen::Vector3d& pos)
+  {
+    if (nuft) {
+      double f[5];
+      nuft->interpolate(pos(0), pos(1), pos(2), f);
+      return {f[0], f[1], {f[2], f[3], f[4]}};
     }
+
+    double den = ortho->get_dens(expcoef, pos).real();
+    double pot = ortho->get_pot (expcoef, pos).real();
+
+    Eigen::Vector3d frc = ortho->get_force(expcoef, pos).real();
+
+    return {den, pot, frc};
   }
   
   std::vector<double> Cube::crt_eval(double x, double y, double z)
@@ -3382,14 +3778,11 @@ namespace BasisClasses
     Eigen::Vector3d pos {x, y, z};
 
     // Get the basis fields
-    double den1 = ortho->get_dens(expcoef, pos).real();
-    double pot1 = ortho->get_pot (expcoef, pos).real();
-
-    auto frc = ortho->get_force(expcoef, pos);
+    auto [den1, pot1, frc] = fields(pos);
     
-    double frcx = -frc(0).real();
-    double frcy = -frc(1).real();
-    double frcz = -frc(2).real();
+    double frcx = -frc(0);
+    double frcy = -frc(1);
+    double frcz = -frc(2);
 
     return {0, den1, den1, 0, pot1, pot1, frcx, frcy, frcz};
   }
@@ -3406,12 +3799,9 @@ namespace BasisClasses
     Eigen::Vector3d pos {x, y, z};
 
     // Get the basis fields
-    double den1 = ortho->get_dens(expcoef, pos).real();
-    double pot1 = ortho->get_pot (expcoef, pos).real();
-
-    auto frc = ortho->get_force(expcoef, pos);
+    auto [den1, pot1, frc] = fields(pos);
     
-    double frcx = frc(0).real(), frcy = frc(1).real(), frcz = frc(2).real();
+    double frcx = frc(0), frcy = frc(1), frcz = frc(2);
 
     double potR =  frcx*cos(phi) + frcy*sin(phi);
     double potp = -frcx*sin(phi) + frcy*cos(phi);
@@ -3437,14 +3827,11 @@ namespace BasisClasses
     Eigen::Vector3d pos {x, y, z};
 
     // Get the basis fields
-    double den1 = ortho->get_dens(expcoef, pos).real();
-    double pot1 = ortho->get_pot (expcoef, pos).real();
-
-    auto frc = ortho->get_force(expcoef, pos);
+    auto [den1, pot1, frc] = fields(pos);
     
-    double frcx = frc(0).real();
-    double frcy = frc(1).real();
-    double frcz = frc(2).real();
+    double frcx = frc(0);
+    double frcy = frc(1);
+    double frcz = frc(2);
 
     double potr =  frcx*cos(phi)*sinth + frcy*sin(phi)*sinth + frcz*costh;
     double pott =  frcx*cos(phi)*costh + frcy*sin(phi)*costh - frcz*sinth;
@@ -3457,6 +3844,85 @@ namespace BasisClasses
     return {0, den1, den1, 0, pot1, pot1, potr, pott, potp};
   }
 
+  void Cube::evaluateGrid(const Coord ctype,
+			  const std::vector<double>& x,
+			  const std::vector<double>& y,
+			  const std::vector<double>& z,
+			  std::vector<Eigen::Tensor<float, 3>>& out)
+  {
+    int nx = x.size(), ny = y.size(), nz = z.size();
+    int nf = getFieldLabels(ctype).size();
+
+    // Density, potential and force on the grid; the exact sums are
+    // used even with the non-uniform FFT since the separable
+    // contraction is cheaper on a grid
+    //
+    std::vector<Eigen::MatrixXd> F;
+    ortho->get_fields(expcoef, x, y, z, F);
+
+    out.resize(nf);
+    for (auto & t : out) t.resize(nx, ny, nz);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<nx*ny; c++) {
+
+      int i = c/ny;
+      int j = c - i*ny;
+
+      double phi = atan2(y[j], x[i]);
+      double cosp = cos(phi), sinp = sin(phi);
+      double R = sqrt(x[i]*x[i] + y[j]*y[j]);
+
+      for (int k=0; k<nz; k++) {
+	int col = j + ny*k;
+
+	double den  = F[0](i, col), pot  = F[1](i, col);
+	double frcx = F[2](i, col), frcy = F[3](i, col), frcz = F[4](i, col);
+
+	double v[9] = {0, den, den, 0, pot, pot, -frcx, -frcy, -frcz};
+
+	// Projections as in cyl_eval() and sph_eval()
+	//
+	if (ctype == Coord::Cylindrical) {
+	  v[6] = -(frcx*cosp + frcy*sinp);
+	  v[7] = -frcz;
+	  v[8] = -(-frcx*sinp + frcy*cosp);
+	} else if (ctype == Coord::Spherical) {
+	  double r = sqrt(R*R + z[k]*z[k]) + 1.0e-18;
+	  double costh = z[k]/r, sinth = sqrt(fabs(1.0 - costh*costh));
+
+	  v[6] = -(frcx*cosp*sinth + frcy*sinp*sinth + frcz*costh);
+	  v[7] = -(frcx*cosp*costh + frcy*sinp*costh - frcz*sinth);
+	  v[8] = -(-frcx*sinp + frcy*cosp);
+	}
+
+	for (int n=0; n<nf; n++) out[n](i, j, k) = v[n];
+      }
+    }
+  }
+
+  void Cube::addAccel(const Eigen::MatrixXd& ps, Eigen::MatrixXd& accel)
+  {
+    // The interpolation is cheaper per point than the direct sum
+    //
+    if (nuft) {
+      Basis::addAccel(ps, accel);
+      return;
+    }
+
+    auto guard = lock();
+
+    Eigen::MatrixXd pos = ps.leftCols(3);
+    for (int k=0; k<3; k++) pos.col(k).array() -= coefctr[k];
+
+    Eigen::MatrixXd F = ortho->get_fields(expcoef, pos);
+
+    // Same sign as crt_eval()
+    //
+    for (int k=0; k<3; k++)
+      accel.col(k).array() -= F.col(2+k).array() + pseudo(k);
+  }
+
   std::vector<Eigen::MatrixXd> Cube::orthoCheck(int knots)
   {
     std::vector<Eigen::MatrixXd> ret;
@@ -3465,8 +3931,8 @@ namespace BasisClasses
   }
   
   // Generate coeffients from a particle reader
-  CoefClasses::CoefStrPtr BiorthBasis::createFromReader
-  (PR::PRptr reader, std::vector<double> ctr)
+  CoefClasses::CoefStrPtr BiorthBasis::newCoefStruct
+  (const std::vector<double>& ctr)
   {
     CoefClasses::CoefStrPtr coef;
 
@@ -3496,34 +3962,187 @@ namespace BasisClasses
     //
     if (addCenter) coef->ctr = ctr;
 
-    std::vector<double> pp(3), vv(3);
+    return coef;
+  }
+
+  void BiorthBasis::accumulateChunk(const PR::ParticleChunk& c,
+				    const std::vector<double>& ctr,
+				    const Callback& sel,
+				    const SelectorPtr& expr)
+  {
+    const long N = c.size;
 
-    reset_coefs();
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
+    ParticleSelector::Mask mask;
+    if (expr) mask = expr->select(c);
+
+    auto chosen = [&](long n) { return not expr or mask(n); };
+
+    if (useDevice() and not sel) {
+      const long M = expr ? mask.count() : N;
+      Eigen::MatrixXd pos(3, M);
+      Eigen::VectorXd mass(M);
+      for (long n=0, m=0; n<N; n++) {
+	if (not chosen(n)) continue;
+	for (int k=0; k<3; k++) pos(k, m) = c.pos[3*n+k] - ctr[k];
+	mass(m++) = c.mass[n];
+      }
+      if (M) accumulateDevice(pos, mass);
+    }
+    else if (parallelAccumulate() and not sel) {
+#pragma omp parallel for schedule(static)
+      for (long n=0; n<N; n++) {
+	if (not chosen(n)) continue;
+	const double *pos = c.pos + 3*n;
+	accumulate(pos[0]-ctr[0], pos[1]-ctr[1], pos[2]-ctr[2], c.mass[n]);
+      }
+    }
+    else {
+      std::vector<double> pp(3), vv(3);
+
+      for (long n=0; n<N; n++) {
 
-      bool use = false;
+	if (not chosen(n)) continue;
+
+	const double *pos = c.pos + 3*n;
+	bool use = true;
       
-      if (ftor) {
-	pp.assign(p->pos, p->pos+3);
-	vv.assign(p->vel, p->vel+3);
-	use = ftor(p->mass, pp, vv, p->indx);
-      } else {
-	use = true;
+	if (sel) {
+	  pp.assign(pos, pos+3);
+	  vv.assign(c.vel + 3*n, c.vel + 3*n + 3);
+	  use = sel(c.mass[n], pp, vv, c.indx[n]);
+	}
+
+	if (use) accumulate(pos[0]-ctr[0],
+			    pos[1]-ctr[1],
+			    pos[2]-ctr[2],
+			    c.mass[n]);
       }
+    }
+  }
+
+  CoefClasses::CoefStrPtr BiorthBasis::createFromReader
+  (PR::PRptr reader, std::vector<double> ctr)
+  {
+    auto guard = lock();
+    auto coef  = newCoefStruct(ctr);
 
-      if (use) accumulate(p->pos[0]-ctr[0],
-			  p->pos[1]-ctr[1],
-			  p->pos[2]-ctr[2],
-			  p->mass);
+    reset_coefs();
+
+    // Only masses and positions are read unless a selector needs
+    // the other fields
+    //
+    PR::FieldSelection fields(reader, ftor or psel ? PR::FieldAll :
+			      PR::FieldMass | PR::FieldPosition);
+
+    // Batch the particles for the device
+    //
+    if (useDevice() and not ftor and not psel) {
+      Eigen::MatrixXd pos(3, deviceBatch);
+      Eigen::VectorXd mass(deviceBatch);
+      long cnt = 0;
+
+      for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+	for (size_t n=0; n<c.size; n++) {
+	  for (int k=0; k<3; k++) pos(k, cnt) = c.pos[3*n+k] - ctr[k];
+	  mass(cnt) = c.mass[n];
+	  if (++cnt == deviceBatch) {
+	    accumulateDevice(pos, mass);
+	    cnt = 0;
+	  }
+	}
+      }
+      if (cnt) accumulateDevice(pos.leftCols(cnt), mass.head(cnt));
+
+      make_coefs();
+      load_coefs(coef, reader->CurrentTime());
+      return coef;
     }
+
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk())
+      accumulateChunk(c, ctr, ftor, psel);
+
     make_coefs();
     load_coefs(coef, reader->CurrentTime());
     return coef;
   }
 
+  std::vector<CoefClasses::CoefStrPtr> BiorthBasis::createFromReader
+  (PR::PRptr reader, const std::vector<Selected>& bases,
+   std::vector<double> ctr)
+  {
+    const int nb = bases.size();
+
+    std::vector<std::unique_lock<std::recursive_mutex>> guards;
+    std::vector<CoefClasses::CoefStrPtr> ret(nb);
+    std::vector<Callback> sel(nb);
+    std::vector<int> single, shared;
+
+    for (int i=0; i<nb; i++) {
+      auto & b = bases[i].first;
+
+      if (not b)
+	throw std::invalid_argument("BiorthBasis::createFromReader: null basis");
+
+      for (int j=0; j<i; j++) {
+	if (bases[j].first == b)
+	  throw std::invalid_argument
+	    ("BiorthBasis::createFromReader: a basis may appear only once");
+      }
+
+      guards.push_back(b->lock());
+
+      ret[i] = b->newCoefStruct(ctr);
+      sel[i] = bases[i].second ? bases[i].second : b->ftor;
+      b->reset_coefs();
+
+      if (b->parallelAccumulate() and not sel[i] and not b->useDevice())
+	shared.push_back(i);
+      else
+	single.push_back(i);
+    }
+
+    // Only masses and positions are read unless a selector needs
+    // the other fields
+    //
+    unsigned need = PR::FieldMass | PR::FieldPosition;
+    for (int i=0; i<nb; i++) {
+      if (sel[i] or bases[i].first->psel) need = PR::FieldAll;
+    }
+    PR::FieldSelection fields(reader, need);
+
+    // One pass over the particles
+    //
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+
+      // Bases that accumulate on one thread take the chunk side by side
+      //
+#pragma omp parallel for schedule(dynamic)
+      for (int j=0; j<single.size(); j++) {
+	int i = single[j];
+	bases[i].first->accumulateChunk(c, ctr, sel[i], bases[i].first->psel);
+      }
+
+      // The others use all of the threads in turn
+      //
+      for (auto i : shared)
+	bases[i].first->accumulateChunk(c, ctr, sel[i], bases[i].first->psel);
+    }
+
+    // The coefficients are reduced in list order on every process
+    //
+    double time = reader->CurrentTime();
+    for (int i=0; i<nb; i++) {
+      bases[i].first->make_coefs();
+      bases[i].first->load_coefs(ret[i], time);
+    }
+
+    return ret;
+  }
+
   // Generate coefficients from a phase-space table
   void BiorthBasis::initFromArray(std::vector<double> ctr)
   {
+    auto guard = lock();
     if (name.compare("sphereSL") == 0)
       coefret = std::make_shared<CoefClasses::SphStruct>();
     else if (name.compare("cylinder") == 0)
@@ -3562,6 +4181,33 @@ namespace BasisClasses
   void BiorthBasis::addFromArray(Eigen::VectorXd& m, RowMatrixXd& p,
 				 bool RoundRobin, bool PosVelRows)
   {
+    // View the row-major array as column major with swapped strides
+    //
+    Eigen::Map<const Eigen::MatrixXd, 0,
+	       Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>>
+      view(p.data(), p.rows(), p.cols(),
+	   Eigen::Stride<Eigen::Dynamic, Eigen::Dynamic>(1, p.cols()));
+
+    accumulateView<double>(m, view, RoundRobin, PosVelRows);
+  }
+
+  void BiorthBasis::addFromArray(MassRef<double> m, ArrayRef<double> p,
+				 bool RoundRobin, bool PosVelRows)
+  {
+    accumulateView<double>(m, p, RoundRobin, PosVelRows);
+  }
+
+  void BiorthBasis::addFromArray(MassRef<float> m, ArrayRef<float> p,
+				 bool RoundRobin, bool PosVelRows)
+  {
+    accumulateView<float>(m, p, RoundRobin, PosVelRows);
+  }
+
+  template<typename T>
+  void BiorthBasis::accumulateView(const MassRef<T>& m, const ArrayRef<T>& p,
+				   bool RoundRobin, bool PosVelRows)
+  {
+    auto guard = lock();
     // Sanity check: is coefficient instance created?  This is not
     // foolproof.  It is really up the user to make sure that a call
     // to initFromArray() comes first.
@@ -3599,8 +4245,6 @@ namespace BasisClasses
 		<< "if this assumption is wrong." << std::endl;
     }
 
-    std::vector<double> p1(3), v1(3, 0);
-
     if (PosVelRows) {
       if (p.rows()<3) {
 	std::ostringstream msg;
@@ -3608,51 +4252,85 @@ namespace BasisClasses
 	  "least three rows for x, y, z.  Yours has " << p.rows() << ".";
 	throw std::runtime_error(msg.str());
       }
+    } else {
+      if (p.cols()<3) {
+	std::ostringstream msg;
+	msg << "Basis::addFromArray: you must pass a position array with at "
+	  "least three columns for x, y, z.  Yours has " << p.cols() << ".";
+	throw std::runtime_error(msg.str());
+      }
+    }
 
-      for (int n=0; n<p.cols(); n++) {
+    const long N = PosVelRows ? p.cols() : p.rows();
 
-	if (n % numprocs==myid or not RoundRobin) {
+    if (m.size() < N) {
+      std::ostringstream msg;
+      msg << "Basis::addFromArray: the mass vector has " << m.size()
+	  << " entries for " << N << " particles.";
+      throw std::runtime_error(msg.str());
+    }
 
-	  bool use = true;
-	  if (ftor) {
-	    for (int k=0; k<3; k++) p1[k] = p(k, n);
-	    use = ftor(m(n), p1, v1, coefindx);
-	  } else {
-	    use = true;
-	  }
+    auto pos = [&](long n, int k) -> double
+    { return PosVelRows ? p(k, n) : p(n, k); };
+
+    // The selector sees the particles in order with their sequence
+    // index, so only the unselected case is threaded
+    //
+    if (useDevice() and not ftor) {
+
+      Eigen::MatrixXd pbuf(3, std::min<long>(N, deviceBatch));
+      Eigen::VectorXd mbuf(pbuf.cols());
+      long cnt = 0;
+
+      for (long n=0; n<N; n++) {
+	if (n % numprocs==myid or not RoundRobin) {
+	  for (int k=0; k<3; k++) pbuf(k, cnt) = pos(n, k) - coefctr[k];
+	  mbuf(cnt) = m(n);
 	  coefindx++;
-	  
-	  if (use) accumulate(p(0, n)-coefctr[0],
-			      p(1, n)-coefctr[1],
-			      p(2, n)-coefctr[2], m(n));
+	  if (++cnt == pbuf.cols()) {
+	    accumulateDevice(pbuf, mbuf);
+	    cnt = 0;
+	  }
 	}
       }
-      
-    } else {
+      if (cnt) accumulateDevice(pbuf.leftCols(cnt), mbuf.head(cnt));
 
-      if (p.cols()<3) {
-	std::ostringstream msg;
-	msg << "Basis::addFromArray: you must pass a position array with at "
-	  "least three columns for x, y, z.  Yours has " << p.cols() << ".";
-	throw std::runtime_error(msg.str());
+    } else if (parallelAccumulate() and not ftor) {
+
+      unsigned long count = 0;
+
+#pragma omp parallel for schedule(static) reduction(+:count)
+      for (long n=0; n<N; n++) {
+	if (n % numprocs==myid or not RoundRobin) {
+	  accumulate(pos(n, 0)-coefctr[0],
+		     pos(n, 1)-coefctr[1],
+		     pos(n, 2)-coefctr[2], m(n));
+	  count++;
+	}
       }
 
-      for (int n=0; n<p.rows(); n++) {
+      coefindx += count;
+
+    } else {
+
+      std::vector<double> p1(3), v1(3, 0);
+
+      for (long n=0; n<N; n++) {
 
 	if (n % numprocs==myid or not RoundRobin) {
 
 	  bool use = true;
 	  if (ftor) {
-	    for (int k=0; k<3; k++) p1[k] = p(n, k);
+	    for (int k=0; k<3; k++) p1[k] = pos(n, k);
 	    use = ftor(m(n), p1, v1, coefindx);
 	  } else {
 	    use = true;
 	  }
 	  coefindx++;
 	  
-	  if (use) accumulate(p(n, 0)-coefctr[0],
-			      p(n, 1)-coefctr[1],
-			      p(n, 2)-coefctr[2], m(n));
+	  if (use) accumulate(pos(n, 0)-coefctr[0],
+			      pos(n, 1)-coefctr[1],
+			      pos(n, 2)-coefctr[2], m(n));
 	}
       }
     }
@@ -3661,6 +4339,7 @@ namespace BasisClasses
   // Generate coefficients from the accumulated array values
   CoefClasses::CoefStrPtr BiorthBasis::makeFromArray(double time)
   {
+    auto guard = lock();
     make_coefs();
     load_coefs(coefret, time);
     return coefret;
@@ -3672,6 +4351,7 @@ namespace BasisClasses
   (Eigen::VectorXd& m, RowMatrixXd& p, double time, std::vector<double> ctr,
    bool RoundRobin, bool PosVelRows)
   {
+    auto guard = lock();
     initFromArray(ctr);
     addFromArray(m, p, RoundRobin, PosVelRows);
     return makeFromArray(time);
@@ -3681,24 +4361,9 @@ namespace BasisClasses
   Eigen::MatrixXd& AccelFunc::evalaccel
   (Eigen::MatrixXd& ps, Eigen::MatrixXd& accel, BasisCoef mod)
   {
-    // Get Model
-    //
-    auto basis = std::get<0>(mod);
-
-    // Get expansion center
+    // Evaluate the model for all orbits in one batch
     //
-    auto ctr = basis->getCenter();
-
-    // Get fields
-    //
-    int rows = accel.rows();
-    for (int n=0; n<rows; n++) {
-      auto v = basis->getFields(ps(n, 0) - ctr[0],
-				ps(n, 1) - ctr[1],
-				ps(n, 2) - ctr[2]);
-      // First 6 fields are density and potential, follewed by acceleration
-      for (int k=0; k<3; k++) accel(n, k) += v[6+k] - basis->pseudo(k);
-    }
+    std::get<0>(mod)->addAccel(ps, accel);
 
     return accel;
   }
@@ -3717,7 +4382,7 @@ namespace BasisClasses
 
     // Interpolate coefficients
     //
-    auto times = coefs->Times();
+    auto & times = coefs->getSeriesTimes();
 
     if (t<times.front() or t>times.back()) {
       std::ostringstream sout;
@@ -3748,12 +4413,7 @@ namespace BasisClasses
     //
     newcoef->time = t;
 
-    auto & cN = newcoef->store;
-    auto & cA = coefsA->store;
-    auto & cB = coefsB->store;
-
-    for (int i=0; i<newcoef->store.size(); i++)
-      cN(i) = a * cA(i) + b * cB(i);
+    newcoef->store = std::get<0>(coefs->interpolate(t));
 
     // Interpolate center
     //
@@ -3781,7 +4441,7 @@ namespace BasisClasses
 
       // Interpolate coefficients
       //
-      auto times = coefs->Times();
+      auto & times = coefs->getSeriesTimes();
 
       if (t<times.front() or t>times.back()) {
 	std::ostringstream sout;
@@ -3812,12 +4472,7 @@ namespace BasisClasses
       //
       newcoef->time = t;
 
-      auto & cN = newcoef->store;
-      auto & cA = coefsA ->store;
-      auto & cB = coefsB ->store;
-
-      for (int i=0; i<cN.size(); i++)
-	cN(i) = a * cA(i) + b * cB(i);
+      newcoef->store = std::get<0>(coefs->interpolate(t));
 
       // Interpolate center
       //
@@ -3834,36 +4489,115 @@ namespace BasisClasses
     // END: component model loop
   }
   
-  //! Take one leap frog step; this can/should be generalized to a
-  //! one-step class in the long run
-  std::tuple<double, Eigen::MatrixXd>
-  OneStep(double t, double h,
-	  Eigen::MatrixXd& ps, Eigen::MatrixXd& accel,
-	  std::vector<BasisCoef> bfe, AccelFunctor F)
+  //! Sum the acceleration of all components at time t.  The
+  //! coefficients for t are installed once per component and then
+  //! shared by every orbit.
+  static void
+  totalAccel(double t, Eigen::MatrixXd& ps, Eigen::MatrixXd& accel,
+	     std::vector<BasisCoef>& bfe, AccelFunctor& F)
   {
-    int rows = ps.rows();
+    accel.setZero();
+    for (auto & mod : bfe) F(t, ps, accel, mod);
+  }
 
-    // Drift 1/2
+  //! Advance positions by the current velocities
+  static void drift(Eigen::MatrixXd& ps, double h)
+  {
+    const int rows = ps.rows();
+#pragma omp parallel for schedule(static)
     for (int n=0; n<rows; n++) {
-      for (int k=0; k<3; k++) ps(n, k) += ps(n, 3+k)*0.5*h;
+      for (int k=0; k<3; k++) ps(n, k) += ps(n, 3+k)*h;
     }
+  }
 
-    // Kick
-    accel.setZero();
-    for (auto mod : bfe) {
-      accel = F(t, ps, accel, mod);
-    }
+  //! Advance velocities by the acceleration
+  static void kick(Eigen::MatrixXd& ps, const Eigen::MatrixXd& accel, double h)
+  {
+    const int rows = ps.rows();
+#pragma omp parallel for schedule(static)
     for (int n=0; n<rows; n++) {
       for (int k=0; k<3; k++) ps(n, 3+k) += accel(n, k)*h;
     }
-    
-    // Drift 1/2
-    for (int n=0; n<rows; n++) {
-      for (int k=0; k<3; k++) ps(n, k) += ps(n, 3+k)*0.5*h;
-    }
+  }
+
+  //! Integration schemes for IntegrateOrbits
+  enum class Stepper { leapfrog, yoshida, rk4 };
+
+  static const std::map<std::string, Stepper> stepperLookup =
+    { {"leapfrog", Stepper::leapfrog},
+      {"yoshida",  Stepper::yoshida},
+      {"rk4",      Stepper::rk4} };
+
+  //! Take one step of size h from time t in place, returning t+h
+  static double
+  OneStep(Stepper method, double t, double h,
+	  Eigen::MatrixXd& ps, Eigen::MatrixXd& accel,
+	  std::vector<BasisCoef>& bfe, AccelFunctor& F)
+  {
+    switch (method) {
+
+    case Stepper::leapfrog:
+      // Drift-kick-drift with the force at the midpoint
+      drift(ps, 0.5*h);
+      totalAccel(t + 0.5*h, ps, accel, bfe, F);
+      kick(ps, accel, h);
+      drift(ps, 0.5*h);
+      break;
 
+    case Stepper::yoshida:
+      {
+	// Fourth-order symplectic composition of three leap frog
+	// steps (Yoshida 1990)
+	const double w1 = 1.0/(2.0 - std::cbrt(2.0));
+	const double w0 = 1.0 - 2.0*w1;
+	const double c[4] = {0.5*w1, 0.5*(w0+w1), 0.5*(w0+w1), 0.5*w1};
+	const double d[3] = {w1, w0, w1};
+
+	double tt = t;
+	for (int j=0; j<3; j++) {
+	  drift(ps, c[j]*h);
+	  tt += c[j]*h;
+	  totalAccel(tt, ps, accel, bfe, F);
+	  kick(ps, accel, d[j]*h);
+	}
+	drift(ps, c[3]*h);
+      }
+      break;
+
+    case Stepper::rk4:
+      {
+	// Classical fourth-order Runge-Kutta on (x, v)
+	const int rows = ps.rows();
+	Eigen::MatrixXd y(ps), k(rows, 6), sum = Eigen::MatrixXd::Zero(rows, 6);
+
+	const double a[4] = {0.0, 0.5, 0.5, 1.0};
+	const double b[4] = {1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0};
+
+	for (int j=0; j<4; j++) {
+	  if (j) {
+#pragma omp parallel for schedule(static)
+	    for (int n=0; n<rows; n++)
+	      for (int i=0; i<6; i++) y(n, i) = ps(n, i) + a[j]*h*k(n, i);
+	  }
+
+	  totalAccel(t + a[j]*h, y, accel, bfe, F);
+
+#pragma omp parallel for schedule(static)
+	  for (int n=0; n<rows; n++) {
+	    for (int i=0; i<3; i++) {
+	      k(n, i)   = y(n, 3+i);
+	      k(n, 3+i) = accel(n, i);
+	    }
+	    for (int i=0; i<6; i++) sum(n, i) += b[j]*k(n, i);
+	  }
+	}
+
+	ps += h*sum;
+      }
+      break;
+    }
 
-    return std::tuple<double, Eigen::MatrixXd>(t+h, ps);
+    return t + h;
   }
 
 
@@ -3871,8 +4605,15 @@ namespace BasisClasses
   IntegrateOrbits
   (double tinit, double tfinal, double h,
    Eigen::MatrixXd ps, std::vector<BasisCoef> bfe, AccelFunctor F,
-   int nout)
+   int nout, const std::string method)
   {
+    auto it = stepperLookup.find(method);
+    if (it == stepperLookup.end())
+      throw std::runtime_error
+	("BasisClasses::IntegrateOrbits: unknown method <" + method + ">; "
+	 "choose leapfrog, yoshida, or rk4");
+    Stepper stepper = it->second;
+
     int rows = ps.rows();
     int cols = ps.cols();
 
@@ -3889,6 +4630,18 @@ namespace BasisClasses
     //
     Eigen::MatrixXd accel(rows, 3);
 
+    // Hold the bases for the entire integration, locking in address
+    // order so that concurrent integrations sharing a basis cannot
+    // deadlock
+    //
+    std::vector<Basis*> held;
+    for (auto & mod : bfe) held.push_back(std::get<0>(mod).get());
+    std::sort(held.begin(), held.end());
+    held.erase(std::unique(held.begin(), held.end()), held.end());
+
+    std::vector<std::unique_lock<std::recursive_mutex>> guards;
+    for (auto b : held) guards.push_back(b->lock());
+
     // Sanity check
     //
     if (tfinal == tinit) {
@@ -3986,9 +4739,10 @@ namespace BasisClasses
     // Do the integration using stride for output
     while (s++ < numT) {
       if ( (tfinal - tnow)*sgn < h*sgn) h = tfinal - tnow;
-      std::tie(tnow, ps) = OneStep(tnow, h, ps, accel, bfe, F);
+      tnow = OneStep(stepper, tnow, h, ps, accel, bfe, F);
       if (cnt < nout and s % stride == 0) {
 	times(cnt) = tnow;
+#pragma omp parallel for schedule(static)
 	for (int n=0; n<rows; n++)
 	  for (int k=0; k<6; k++) ret(n, k, cnt) = ps(n, k);
 	cnt += 1;
@@ -149,6 +149,8 @@ void BiorthBess::make_grid()
   double r = 0.0;
   for (int ir=0; ir<RNUM; ir++, r+=r_grid_del) r_grid[ir] = r;
 
+  std::vector<double> xb(RNUM), jb(RNUM);
+
   for (int l=0; l<=lmax; l++) {
     potl_grid[l].rw .resize(nmax, RNUM);
     potl_grid[l].rw2.resize(nmax, RNUM);
@@ -158,10 +160,19 @@ void BiorthBess::make_grid()
     p = std::make_shared<Roots>(l, nmax);
 
     for (int n=0; n<nmax; n++) {
-      r = 0.0;
-      for (int ir=0; ir<RNUM; ir++, r+=r_grid_del) {
-	potl_grid[l].rw(n, ir) = potl(r, n);
-	dens_grid[l].rw(n, ir) = dens(r, n);
+      // The potential and density differ only by their normalization,
+      // so evaluate j_l over the whole radial grid once
+      double alpha = p->a[n];
+      double pnorm = M_SQRT2/fabs(alpha*EXPmath::sph_bessel(l+1, alpha)) *
+	pow(rmax, -0.5);
+      double dnorm = pnorm*alpha*alpha/(rmax*rmax);
+
+      for (int ir=0; ir<RNUM; ir++) xb[ir] = alpha*r_grid[ir]/rmax;
+      SphBessRoots::eval(l, xb.data(), jb.data(), RNUM);
+
+      for (int ir=0; ir<RNUM; ir++) {
+	potl_grid[l].rw(n, ir) = pnorm*jb[ir];
+	dens_grid[l].rw(n, ir) = dnorm*jb[ir];
       }
       
       {
@@ -203,14 +214,6 @@ void BiorthBess::make_grid()
 
 std::vector<Eigen::MatrixXd> BiorthBess::orthoCheck(int num)
 {
-  // Allocate storage
-  //
-  std::vector<Eigen::MatrixXd> one(lmax+1);
-  for (auto & u : one) {
-    u.resize(nmax, nmax);
-    u.setZero();
-  }
-
   // Number of knots
   //
   LegeQuad wk(num);
@@ -219,11 +222,14 @@ std::vector<Eigen::MatrixXd> BiorthBess::orthoCheck(int num)
   //
   double dr = rmax - rmin;
 
-  Eigen::MatrixXd p(lmax+1, nmax), d(lmax+1, nmax);
-
-
-  // Biorthogonal integral loop
+  // Tabulate the basis at every knot: one row per knot for each L,
+  // with the quadrature weight folded into the potential
   //
+  std::vector<Eigen::MatrixXd> P(lmax+1), D(lmax+1);
+  for (auto & v : P) v.resize(num, nmax);
+  for (auto & v : D) v.resize(num, nmax);
+
+#pragma omp parallel for
   for (int i=0; i<num; i++) {
 
     double r = rmin + dr*wk.knot(i);
@@ -231,19 +237,22 @@ std::vector<Eigen::MatrixXd> BiorthBess::orthoCheck(int num)
 
     // Evaluate basis at radius r
     //
+    Eigen::MatrixXd p, d;
     get_potl(r, p);
     get_dens(r, d);
 
-    // Contribution to the integrand
-    //
-    for (int L=0, cnt=0; L<=lmax; L++) {
-      for (int n1=0; n1<nmax; n1++) {
-	for (int n2=0; n2<nmax; n2++, cnt++) {
-	  one[L](n1, n2) += w * p(L, n1) * d(L, n2);
-	}
-      }
+    for (int L=0; L<=lmax; L++) {
+      P[L].row(i) = w*p.row(L);
+      D[L].row(i) = d.row(L);
     }
   }
 
+  // Biorthogonal integrals
+  //
+  std::vector<Eigen::MatrixXd> one(lmax+1);
+
+#pragma omp parallel for
+  for (int L=0; L<=lmax; L++) one[L] = P[L].transpose() * D[L];
+
   return one;
 }
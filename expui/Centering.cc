@@ -3,6 +3,8 @@
 #include <localmpi.H>
 #include <KDtree.H>
 
+#include <random>
+
 namespace Utility
 {
   std::vector<double> getDensityCenter(PR::PRptr reader, int stride,
@@ -22,15 +24,20 @@ namespace Utility
     std::vector<double> ctr(3, 0.0);
 
     using point3 = KDtree::point<double, 3>;
-    using tree3  = KDtree::kdtree<double, 3>;
+    using tree3  = KDtree::flatTree<double, 3>;
 
     std::vector<point3> points;
 
     double KDmass = 0.0, dentot = 0.0;
     
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
-      KDmass += p->mass;
-      points.push_back(point3({p->pos[0], p->pos[1], p->pos[2]}, p->mass));
+    PR::FieldSelection fields(reader, PR::FieldMass | PR::FieldPosition);
+
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+      for (size_t n=0; n<c.size; n++) {
+	const double *pos = c.pos + 3*n;
+	KDmass += c.mass[n];
+	points.push_back(point3({pos[0], pos[1], pos[2]}, c.mass[n]));
+      }
     }
 	
     if (use_mpi) {
@@ -87,24 +94,35 @@ namespace Utility
 
     // Run through the bodies or subsampled bodies
     //
+    std::vector<int> which;
+    std::vector<point3> query;
+
     for (int j=0; j<nbods; j++) {
       if (j % numprocs == myid) {
 	int i = j;		    // Default to no permutation
 	if (sigma) i = (*sigma)[j]; // The permutation if required
+	which.push_back(i);
+	query.push_back(points[i]);
+      }
+    }
 
-	auto ret = tree.nearestN(points[i], Ndens);
+    // Batched neighbor search on the tree's threads
+    //
+    auto res = tree.nearestN(query, Ndens);
 
-	double volume = 4.0*M_PI/3.0*std::pow(std::get<2>(ret), 3.0);
-	double density = 0.0;
-	if (volume>0.0 and KDmass>0.0) {
-	  density = std::get<1>(ret)/volume/KDmass;
-	  if (Nsort>0) {
-	    stack.insert({density, i});
-	    if (stack.size()>Nsort) stack.erase(stack.begin());
-	  } else {
-	    for (int k=0; k<3; k++) ctr[k] += density * points[i].get(k);
-	    dentot += density;
-	  }
+    for (size_t q=0; q<which.size(); q++) {
+      int i = which[q];
+
+      double volume = 4.0*M_PI/3.0*std::pow(res[q].second, 3.0);
+      double density = 0.0;
+      if (volume>0.0 and KDmass>0.0) {
+	density = res[q].first/volume/KDmass;
+	if (Nsort>0) {
+	  stack.insert({density, i});
+	  if (stack.size()>Nsort) stack.erase(stack.begin());
+	} else {
+	  for (int k=0; k<3; k++) ctr[k] += density * points[i].get(k);
+	  dentot += density;
 	}
       }
     }
@@ -163,15 +181,174 @@ namespace Utility
     return ctr;
   }
 
+  std::vector<double> getDensityCenterShrink(PR::PRptr reader, int Nsub,
+					     int Ncore, int Ndens)
+  {
+    int use_mpi;
+    MPI_Initialized(&use_mpi);
+
+    if (use_mpi) {
+      MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+      MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    }
+
+    // The bodies on this process; x, y, z, mass
+    //
+    std::vector<double> local;
+    PR::FieldSelection fields(reader, PR::FieldMass | PR::FieldPosition);
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+      for (size_t n=0; n<c.size; n++) {
+	const double *pos = c.pos + 3*n;
+	local.insert(local.end(), {pos[0], pos[1], pos[2], c.mass[n]});
+      }
+    }
+
+    size_t nlocal = local.size()/4;
+
+    // Gather a variable length list of 4-tuples onto every process
+    //
+    auto gather = [&](const std::vector<double>& in) {
+      if (not use_mpi) return in;
+      int sz = in.size();
+      std::vector<int> cnts(numprocs), disp(numprocs, 0);
+      MPI_Allgather(&sz, 1, MPI_INT, cnts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+      for (int n=1; n<numprocs; n++) disp[n] = disp[n-1] + cnts[n-1];
+      std::vector<double> out(disp[numprocs-1] + cnts[numprocs-1]);
+      MPI_Allgatherv(in.data(), sz, MPI_DOUBLE, out.data(), cnts.data(),
+		     disp.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+      return out;
+    };
+
+    // Reservoir sample of this process' share of Nsub
+    //
+    size_t nsub = std::max<size_t>(1, Nsub/(use_mpi ? numprocs : 1));
+    std::vector<double> sub;
+    std::mt19937 gen(11 + myid);
+
+    for (size_t i=0; i<nlocal; i++) {
+      if (i < nsub) {
+	sub.insert(sub.end(), local.begin()+4*i, local.begin()+4*i+4);
+      } else {
+	std::uniform_int_distribution<size_t> pick(0, i);
+	size_t j = pick(gen);
+	if (j < nsub) std::copy(local.begin()+4*i, local.begin()+4*i+4,
+				sub.begin()+4*j);
+      }
+    }
+
+    sub = gather(sub);
+    size_t ns = sub.size()/4;
+
+    std::vector<double> ctr(3, 0.0);
+    if (ns==0) return ctr;
+
+    // Shrinking sphere on the subsample: every process does the same
+    // computation on the same data
+    //
+    auto center = [&](double r2max) {
+      std::vector<double> c(3, 0.0);
+      double m = 0.0;
+      size_t cnt = 0;
+      for (size_t i=0; i<ns; i++) {
+	double r2 = 0.0;
+	for (int k=0; k<3; k++) r2 += (sub[4*i+k] - ctr[k])*(sub[4*i+k] - ctr[k]);
+	if (r2 <= r2max) {
+	  for (int k=0; k<3; k++) c[k] += sub[4*i+3]*sub[4*i+k];
+	  m += sub[4*i+3];
+	  cnt++;
+	}
+      }
+      if (m>0.0) for (int k=0; k<3; k++) ctr[k] = c[k]/m;
+      return cnt;
+    };
+
+    center(std::numeric_limits<double>::max());
+
+    double rmax = 0.0;
+    for (size_t i=0; i<ns; i++) {
+      double r2 = 0.0;
+      for (int k=0; k<3; k++) r2 += (sub[4*i+k] - ctr[k])*(sub[4*i+k] - ctr[k]);
+      rmax = std::max(rmax, r2);
+    }
+    rmax = sqrt(rmax);
+
+    const double shrink = 0.9;
+    const int    maxit  = 500;	// Guards against coincident bodies
+    for (int it=0; it<maxit; it++) {
+      if (center(rmax*rmax) <= static_cast<size_t>(Ncore)) break;
+      rmax *= shrink;
+    }
+
+    // Exact density estimate near the center: every process keeps
+    // the bodies inside rmax; the densities are computed for bodies
+    // inside rmax/2 so that their neighbor balls lie inside the tree
+    //
+    std::vector<double> core;
+    for (size_t i=0; i<nlocal; i++) {
+      double r2 = 0.0;
+      for (int k=0; k<3; k++) r2 += (local[4*i+k] - ctr[k])*(local[4*i+k] - ctr[k]);
+      if (r2 < rmax*rmax)
+	core.insert(core.end(), local.begin()+4*i, local.begin()+4*i+4);
+    }
+
+    core = gather(core);
+
+    using point3 = KDtree::point<double, 3>;
+    using tree3  = KDtree::flatTree<double, 3>;
+
+    std::vector<point3> points, query;
+    double KDmass = 0.0;
+    for (size_t i=0; i<core.size()/4; i++) {
+      points.push_back(point3({core[4*i+0], core[4*i+1], core[4*i+2]}, core[4*i+3]));
+      KDmass += core[4*i+3];
+    }
+
+    if (points.size() <= static_cast<size_t>(Ndens)) return ctr;
+
+    for (size_t i=0; i<points.size(); i++) {
+      if (static_cast<int>(i % numprocs) != myid) continue;
+      double r2 = 0.0;
+      for (int k=0; k<3; k++) r2 += (points[i].get(k) - ctr[k])*(points[i].get(k) - ctr[k]);
+      if (r2 < 0.25*rmax*rmax) query.push_back(points[i]);
+    }
+
+    tree3 tree(points.begin(), points.end());
+    auto res = query.size() ? tree.nearestN(query, Ndens) :
+      std::vector<std::pair<double, double>>();
+
+    std::vector<double> wctr(4, 0.0);
+    for (size_t q=0; q<query.size(); q++) {
+      double volume = 4.0*M_PI/3.0*std::pow(res[q].second, 3.0);
+      if (volume>0.0 and KDmass>0.0) {
+	double density = res[q].first/volume/KDmass;
+	for (int k=0; k<3; k++) wctr[k] += density * query[q].get(k);
+	wctr[3] += density;
+      }
+    }
+
+    if (use_mpi)
+      MPI_Allreduce(MPI_IN_PLACE, wctr.data(), 4, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    if (wctr[3]>0.0) {
+      for (int k=0; k<3; k++) ctr[k] = wctr[k]/wctr[3];
+    }
+
+    return ctr;
+  }
+
   //! Brute force center of mass computation
   std::vector<double> getCenterOfMass(PR::PRptr reader)
   {
     std::vector<double> ctr(3, 0.0);
     double mastot = 0.0;
   
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
-      for (int k=0; k<3; k++) ctr[k] += p->mass * p->pos[k];
-      mastot += p->mass;
+    PR::FieldSelection fields(reader, PR::FieldMass | PR::FieldPosition);
+
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+      for (size_t n=0; n<c.size; n++) {
+	for (int k=0; k<3; k++) ctr[k] += c.mass[n] * c.pos[3*n+k];
+	mastot += c.mass[n];
+      }
     }
     
     int use_mpi;
@@ -40,6 +40,7 @@ namespace MSSA
     if (coefs)  ret->coefs  = coefs-> deepcopy();
 
     ret->data       = data;
+    ret->views      = views;
     ret->times      = times;
 
     return ret;
@@ -48,6 +49,11 @@ namespace MSSA
   // Copy to workset coefficient set
   CoefClasses::CoefsPtr CoefDB::endUpdate()
   {
+    // The snapshots are changed in place so they must all be in
+    // memory
+    //
+    coefs->materialize();
+
     // Make a new Coefs instance
     //
     if (dynamic_cast<CoefClasses::SphCoefs*>(coefs.get())) {
@@ -80,6 +86,8 @@ namespace MSSA
   
   void CoefDB::background()
   {
+    coefs->materialize();
+
     if (dynamic_cast<CoefClasses::SphCoefs*>(coefs.get()))
       restore_background_sphere();
     else if (dynamic_cast<CoefClasses::CylCoefs*>(coefs.get()))
@@ -118,6 +126,60 @@ namespace MSSA
     }
   }
 
+  CoefDB::Channel CoefDB::channel(const Key& k)
+  {
+    auto d = data.find(k);
+    if (d != data.end())
+      return Channel(d->second.data(), d->second.size(), Eigen::InnerStride<>(1));
+
+    auto v = views.find(k);
+    if (v == views.end())
+      throw std::runtime_error("CoefDB::channel: key is not a channel");
+
+    // Row-major complex series: one double pair per element
+    //
+    auto & S = coefs->getSeries();
+    const double *p = reinterpret_cast<const double*>(S.data());
+    return Channel(p + 2*v->second.first + v->second.second, S.rows(),
+		   Eigen::InnerStride<>(2*S.cols()));
+  }
+
+  void CoefDB::pack_series(std::initializer_list<const std::vector<Key>*> klist,
+			   std::function<int(const Key&)> col, int part)
+  {
+    auto imag = [part](const Key& k) { return part>=0 and k[part] ? 1 : 0; };
+
+    if (coefs->isLazy()) {
+      // Stream the snapshots in time order through the cache
+      //
+      int ntimes = times.size();
+      for (auto kl : klist) {
+	for (auto & k : *kl) data[k].resize(ntimes);
+      }
+
+      for (int t=0; t<ntimes; t++) {
+	auto cf = coefs->getCoefStruct(times[t]);
+	auto & c = cf->store;
+	for (auto kl : klist) {
+	  for (auto & k : *kl) {
+	    if (imag(k)) data[k][t] = c(col(k)).imag();
+	    else         data[k][t] = c(col(k)).real();
+	  }
+	}
+      }
+    } else {
+      // Each channel is a strided column of the contiguous series
+      //
+      coefs->getSeries();
+      for (auto kl : klist) {
+	for (auto & k : *kl) {
+	  data.erase(k);
+	  views[k] = {col(k), imag(k)};
+	}
+      }
+    }
+  }
+
   void CoefDB::pack_cylinder()
   {
     auto cur = dynamic_cast<CoefClasses::CylCoefs*>(coefs.get());
@@ -130,7 +192,6 @@ namespace MSSA
 
     int mmax = cf->mmax;
     int nmax = cf->nmax;
-    int ntimes = times.size();
     
     // Promote desired keys into c/s pairs
     //
@@ -174,52 +235,37 @@ namespace MSSA
 
     // Only pack the keys in the list
     //
-    for (auto k : keys) {
-      data[k].resize(ntimes);
-    }
+    auto col = [mmax](const Key& k) { return k[0] + (mmax+1)*k[1]; };
 
-    for (auto k : bkeys) {
-      data[k].resize(ntimes);
-    }
-
-    for (int t=0; t<ntimes; t++) {
-      cf = dynamic_cast<CoefClasses::CylStruct*>
-	( cur->getCoefStruct(times[t]).get() );
-
-      for (auto k : keys) {
-	if (k[2]==0)
-	  data[k][t] = (*cf->coefs)(k[0], k[1]).real();
-	else
-	  data[k][t] = (*cf->coefs)(k[0], k[1]).imag();
-      }
-
-      for (auto k : bkeys) {
-	if (k[2]==0)
-	  data[k][t] = (*cf->coefs)(k[0], k[1]).real();
-	else
-	  data[k][t] = (*cf->coefs)(k[0], k[1]).imag();
-      }
-    }
+    pack_series({&keys, &bkeys}, col, 2);
   }
 
   void CoefDB::unpack_cylinder()
   {
+    std::vector<Channel> C, S;
+    for (auto k : keys0) {
+      auto c = k, s = k;
+      c.push_back(0); s.push_back(1);
+      C.push_back(channel(c));
+      S.push_back(k[0] ? channel(s) : C.back());
+    }
+
     for (int i=0; i<times.size(); i++) {
       auto cf = dynamic_cast<CoefClasses::CylStruct*>
 	( coefs->getCoefStruct(times[i]).get() );
       
-      for (auto k : keys0) {
-	auto c = k, s = k;
-	c.push_back(0); s.push_back(1);
+      for (int j=0; j<keys0.size(); j++) {
+	int m = keys0[j][0], n = keys0[j][1];
 
-	int m = k[0], n = k[1];
-
-	if (m==0) (*cf->coefs)(m, n) = {data[c][i], 0.0};
-	else      (*cf->coefs)(m, n) = {data[c][i], data[s][i]};
+	if (m==0) (*cf->coefs)(m, n) = {C[j][i], 0.0    };
+	else      (*cf->coefs)(m, n) = {C[j][i], S[j][i]};
       }
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
 
   void CoefDB::pack_cylfld()
@@ -303,6 +349,9 @@ namespace MSSA
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
 
   void CoefDB::pack_sphere()
@@ -317,7 +366,6 @@ namespace MSSA
 
     int lmax   = cf->lmax;
     int nmax   = cf->nmax;
-    int ntimes = times.size();
     
     // Make extended key list
     //
@@ -340,12 +388,10 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	if (k[1]>0) {
 	  v[3] = 1;
 	  keys.push_back(v);
-	  data[v].resize(ntimes);
 	}
       }
       else {
@@ -364,58 +410,53 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	if (k[1]>0) {
 	  v[3] = 1;
 	  keys.push_back(v);
-	  data[v].resize(ntimes);
 	}
       }
     }
 
     auto I = [](const Key& k) { return k[0]*(k[0]+1)/2 + k[1]; };
 
-    for (int t=0; t<ntimes; t++) {
-      cf = dynamic_cast<CoefClasses::SphStruct*>
-	( cur->getCoefStruct(times[t]).get() );
+    int  ldim = (lmax+1)*(lmax+2)/2;
+    auto col  = [I, ldim](const Key& k) { return I(k) + ldim*k[2]; };
 
-      for (auto k : keys)  {
-	auto c = (*cf->coefs)(I(k), k[2]);
-	data[k][t] = c.real();
-	if (k[3]) data[k][t] = c.imag();
-      }
-
-      for (auto k : bkeys)  {
-	auto c = (*cf->coefs)(I(k), k[2]);
-	data[k][t] = c.real();
-	if (k[3]) data[k][t] = c.imag();
-      }
-    }
+    pack_series({&keys, &bkeys}, col, 3);
   }
 
   void CoefDB::unpack_sphere()
   {
     auto I = [](const Key& k) { return k[0]*(k[0]+1)/2 + k[1]; };
 
+    std::vector<Channel> C, S;
+    for (auto k : keys0) {
+      auto c = k, s = k;
+      c.push_back(0);
+      s.push_back(1);
+      C.push_back(channel(c));
+      S.push_back(k[1] ? channel(s) : C.back());
+    }
+
     for (int i=0; i<times.size(); i++) {
 
       auto cf = dynamic_cast<CoefClasses::SphStruct*>
 	( coefs->getCoefStruct(times[i]).get() );
       
-      for (auto k : keys0) {
-	auto c = k, s = k;
-	c.push_back(0);
-	s.push_back(1);
-
+      for (int j=0; j<keys0.size(); j++) {
+	auto & k = keys0[j];
 	int m = k[1], n = k[2];
 
-	if (m==0) (*cf->coefs)(I(k), n) = {data[c][i], 0.0       };
-	else      (*cf->coefs)(I(k), n) = {data[c][i], data[s][i]};
+	if (m==0) (*cf->coefs)(I(k), n) = {C[j][i], 0.0    };
+	else      (*cf->coefs)(I(k), n) = {C[j][i], S[j][i]};
       }
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
 
   void CoefDB::pack_sphfld()
@@ -509,6 +550,9 @@ namespace MSSA
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
   
   void CoefDB::pack_slab()
@@ -524,7 +568,6 @@ namespace MSSA
     int nmaxx   = cf->nmaxx;
     int nmaxy   = cf->nmaxy;
     int nmaxz   = cf->nmaxz;
-    int ntimes  = times.size();
 
     // Make extended key list
     //
@@ -547,11 +590,9 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	v[3] = 1;
 	keys.push_back(v);
-	data[v].resize(ntimes);
       }
       else {
 	throw std::runtime_error("CoefDB::pack_slab: key is out of bounds");
@@ -569,30 +610,18 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	v[3] = 1;
 	keys.push_back(v);
-	data[v].resize(ntimes);
       }
     }
 
-    for (int t=0; t<ntimes; t++) {
-      cf = dynamic_cast<CoefClasses::SlabStruct*>
-	( cur->getCoefStruct(times[t]).get() );
-
-      for (auto k : keys)  {
-	auto c = (*cf->coefs)(k[0], k[1], k[2]);
-	if (k[3]) data[k][t] = c.imag();
-	else      data[k][t] = c.real();
-      }
+    // Column-major (x, y, z) store
+    //
+    int nx = 2*nmaxx + 1, ny = 2*nmaxy + 1;
+    auto col = [nx, ny](const Key& k) { return k[0] + nx*(k[1] + ny*k[2]); };
 
-      for (auto k : bkeys)  {
-	auto c = (*cf->coefs)(k[0], k[1], k[2]);
-	if (k[3]) data[k][t] = c.imag();
-	else      data[k][t] = c.real();
-      }
-    }
+    pack_series({&keys, &bkeys}, col, 3);
   }
 
   void CoefDB::pack_cube()
@@ -608,7 +637,6 @@ namespace MSSA
     int nmaxx   = cf->nmaxx;
     int nmaxy   = cf->nmaxy;
     int nmaxz   = cf->nmaxz;
-    int ntimes  = times.size();
 
     // Make extended key list
     //
@@ -631,11 +659,9 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	v[3] = 1;
 	keys.push_back(v);
-	data[v].resize(ntimes);
       }
       else {
 	throw std::runtime_error("CoefDB::pack_cube: key is out of bounds");
@@ -653,68 +679,74 @@ namespace MSSA
 	auto v = k;
 	v.push_back(0);
 	keys.push_back(v);
-	data[v].resize(ntimes);
 
 	v[3] = 1;
 	keys.push_back(v);
-	data[v].resize(ntimes);
       }
     }
 
-    for (int t=0; t<ntimes; t++) {
-      cf = dynamic_cast<CoefClasses::CubeStruct*>
-	( cur->getCoefStruct(times[t]).get() );
-
-      for (auto k : keys)  {
-	auto c = (*cf->coefs)(k[0], k[1], k[2]);
-	if (k[3]) data[k][t] = c.imag();
-	else      data[k][t] = c.real();
-      }
+    // Column-major (x, y, z) store
+    //
+    int nx = 2*nmaxx + 1, ny = 2*nmaxy + 1;
+    auto col = [nx, ny](const Key& k) { return k[0] + nx*(k[1] + ny*k[2]); };
 
-      for (auto k : bkeys)  {
-	auto c = (*cf->coefs)(k[0], k[1], k[2]);
-	if (k[3]) data[k][t] = c.imag();
-	else      data[k][t] = c.real();
-      }
-    }
+    pack_series({&keys, &bkeys}, col, 3);
   }
 
   void CoefDB::unpack_slab()
   {
+    std::vector<Channel> C, S;
+    for (auto k : keys0) {
+      auto c = k, s = k;
+      c.push_back(0);
+      s.push_back(1);
+      C.push_back(channel(c));
+      S.push_back(channel(s));
+    }
+
     for (int i=0; i<times.size(); i++) {
 
       auto cf = dynamic_cast<CoefClasses::SlabStruct*>
 	( coefs->getCoefStruct(times[i]).get() );
       
-      for (auto k : keys0) {
-	auto c = k, s = k;
-	c.push_back(0);
-	s.push_back(1);
-
-	(*cf->coefs)(k[0], k[1], k[2]) = {data[c][i], data[s][i]};
+      for (int j=0; j<keys0.size(); j++) {
+	auto & k = keys0[j];
+	(*cf->coefs)(k[0], k[1], k[2]) = {C[j][i], S[j][i]};
       }
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
   
   void CoefDB::unpack_cube()
   {
+    std::vector<Channel> C, S;
+    for (auto k : keys0) {
+      auto c = k, s = k;
+      c.push_back(0);
+      s.push_back(1);
+      C.push_back(channel(c));
+      S.push_back(channel(s));
+    }
+
     for (int i=0; i<times.size(); i++) {
 
       auto cf = dynamic_cast<CoefClasses::CubeStruct*>
 	( coefs->getCoefStruct(times[i]).get() );
       
-      for (auto k : keys0) {
-	auto c = k, s = k;
-	c.push_back(0);
-	s.push_back(1);
-
-	(*cf->coefs)(k[0], k[1], k[2]) = {data[c][i], data[s][i]};
+      for (int j=0; j<keys0.size(); j++) {
+	auto & k = keys0[j];
+	(*cf->coefs)(k[0], k[1], k[2]) = {C[j][i], S[j][i]};
       }
       // END key loop
     }
     // END time loop
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
   
   void CoefDB::pack_table()
@@ -728,7 +760,6 @@ namespace MSSA
       ( cur->getCoefStruct(times[0]).get() );
 
     int cols    = cf->cols;
-    int ntimes  = times.size();
     
     // Promote desired keys which are the data columns
     //
@@ -753,25 +784,18 @@ namespace MSSA
     //
     bkeys.clear();
 
-    for (unsigned c=0; c<cols; c++) {
-      Key key = {c};
-      data[key].resize(ntimes);
-    }
-
-    for (int t=0; t<ntimes; t++) {
-      for (unsigned c=0; c<cols; c++) {
-	Key key = {c};
-
-	cf = dynamic_cast<CoefClasses::TblStruct*>
-	  ( cur->getCoefStruct(times[t]).get() );
+    // Every column is a channel
+    //
+    std::vector<Key> all;
+    for (unsigned c=0; c<cols; c++) all.push_back({c});
 
-	data[key][t] = (*cf->coefs)(c).real();
-      }
-    }
+    pack_series({&all}, [](const Key& k) { return k[0]; }, -1);
   }
 
   void CoefDB::unpack_table()
   {
+    std::vector<Channel> C;
+
     for (int i=0; i<times.size(); i++) {
 
       auto cf = dynamic_cast<CoefClasses::TblStruct*>
@@ -779,14 +803,20 @@ namespace MSSA
 
       int cols = cf->cols;
 
+      if (i==0) {
+	for (unsigned c=0; c<cols; c++) C.push_back(channel({c}));
+      }
+
       for (unsigned c=0; c<cols; c++) {
-	Key key = {c};
-	(*cf->coefs)(c) = data[key][i];
+	(*cf->coefs)(c) = C[c][i];
       }
       // End field loop
     }
     // END time loop
 
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
 
 
@@ -870,6 +900,9 @@ namespace MSSA
     }
     // END time loop
 
+
+    // The snapshots were changed in place
+    coefs->invalidate();
   }
 
 
@@ -986,8 +1019,10 @@ namespace MSSA
 
       for (auto k : bkeys)  {
 	auto c = ar(I(k), k[2]);
-	data[k][t] = c.real();
-	if (k[3]) data[k][t] = c.imag();
+	auto & d = data[k];
+	d.resize(times.size());
+	d[t] = c.real();
+	if (k[3]) d[t] = c.imag();
       }
     }
   }
@@ -1006,10 +1041,12 @@ namespace MSSA
       auto & ar = *(cf->coefs);
 
       for (auto k : bkeys) {
+	auto & d = data[k];
+	d.resize(times.size());
 	if (k[2]==0)
-	  data[k][t] = ar(k[0], k[1]).real();
+	  d[t] = ar(k[0], k[1]).real();
 	else
-	  data[k][t] = ar(k[0], k[1]).imag();
+	  d[t] = ar(k[0], k[1]).imag();
       }
     }
   }
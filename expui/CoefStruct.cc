@@ -355,6 +355,52 @@ namespace CoefClasses
     return true;
   }
   
+  size_t CylStruct::scan(const char* p, size_t n, double& time)
+  {
+    const unsigned int cmagic = 0xc0a57a3;
+    unsigned int tmagic;
+    size_t head;
+    int mmax, nmax;
+
+    if (n < sizeof(unsigned int)) return 0;
+    std::memcpy(&tmagic, p, sizeof(unsigned int));
+
+    if (tmagic == cmagic) {
+      unsigned ssize;
+      if (n < 2*sizeof(unsigned int)) return 0;
+      std::memcpy(&ssize, p+sizeof(unsigned int), sizeof(unsigned int));
+      head = 2*sizeof(unsigned int) + ssize;
+      if (n < head) return 0;
+
+      try {
+	YAML::Node node = YAML::Load(std::string(p+2*sizeof(unsigned int), ssize));
+	time = node["time"].as<double>();
+	nmax = node["nmax"].as<int>();
+	mmax = node["mmax"].as<int>();
+      }
+      catch (YAML::Exception& e) {
+	return 0;
+      }
+    } else {
+      CylCoefHeader header;
+      head = sizeof(CylCoefHeader);
+      if (n < head) return 0;
+      std::memcpy(&header, p, head);
+      time = header.time;
+      nmax = header.nmax;
+      mmax = header.mmax;
+    }
+
+    if (mmax<0 or nmax<=0) return 0;
+
+    // Cosine terms for every m and sine terms for m>0
+    //
+    size_t len = head + sizeof(double)*nmax*(2*mmax+1);
+    if (n < len) return 0;
+
+    return len;
+  }
+  
   bool SphStruct::read(std::istream& in, bool exp_type, bool verbose)
   {
     in.exceptions ( std::istream::failbit | std::istream::badbit );
@@ -491,6 +537,52 @@ namespace CoefClasses
     return true;
   }
 
+  size_t SphStruct::scan(const char* p, size_t n, double& time)
+  {
+    const unsigned int cmagic = 0xc0a57a2;
+    unsigned int tmagic;
+    size_t head;
+    int lmax, nmax;
+
+    if (n < sizeof(unsigned int)) return 0;
+    std::memcpy(&tmagic, p, sizeof(unsigned int));
+
+    if (tmagic == cmagic) {
+      unsigned hsize;
+      if (n < 2*sizeof(unsigned int)) return 0;
+      std::memcpy(&hsize, p+sizeof(unsigned int), sizeof(unsigned int));
+      head = 2*sizeof(unsigned int) + hsize;
+      if (n < head) return 0;
+
+      try {
+	YAML::Node node = YAML::Load(std::string(p+2*sizeof(unsigned int), hsize));
+	lmax = node["lmax"].as<int>();
+	nmax = node["nmax"].as<int>();
+	time = node["time"].as<double>();
+      }
+      catch (YAML::Exception& e) {
+	return 0;
+      }
+    } else {
+      SphCoefHeader header;
+      head = sizeof(SphCoefHeader);
+      if (n < head) return 0;
+      std::memcpy(&header, p, head);
+      time = header.tnow;
+      nmax = header.nmax;
+      lmax = header.Lmax;
+    }
+
+    if (lmax<0 or nmax<=0) return 0;
+
+    // One value for m=0 and two for m>0: (lmax+1)^2 per radial order
+    //
+    size_t len = head + sizeof(double)*nmax*(lmax+1)*(lmax+1);
+    if (n < len) return 0;
+
+    return len;
+  }
+
   bool SlabStruct::read(std::istream& in, bool exp_type, bool verbose)
   {
     std::cout << "SlabStruct: no native coefficient format for this class" << std::endl;
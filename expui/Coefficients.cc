@@ -1,5 +1,7 @@
 #include <filesystem>
+#include <algorithm>
 #include <iterator>
+#include <numeric>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -12,13 +14,77 @@
 #include <Eigen/Dense>
 #include <yaml-cpp/yaml.h>
 
+#include <hdf5.h>
 #include <highfive/highfive.hpp>
 #include <highfive/eigen.hpp>
 
+#include <FilePrefetch.H>
+#include <MappedFile.H>
 #include <Coefficients.H>
 
 namespace CoefClasses
 {
+  namespace
+  {
+  //! Read the records of a native coefficient file through a memory
+  //! map.  The record offsets are found in one pass over the headers,
+  //! applying stride and the time range without decoding the skipped
+  //! records; the selected records are then decoded in parallel.
+  //! Returns false if the file cannot be mapped.
+  template<class Struct>
+  bool readMapped(const std::string& file, int stride,
+		  double tmin, double tmax, bool verbose,
+		  std::vector<std::shared_ptr<Struct>>& ret)
+  {
+    MappedFile map(file);
+    if (not map) return false;
+
+    // Scan
+    //
+    std::vector<std::pair<size_t, size_t>> recs;
+    size_t pos = 0;
+    int count = 0;
+    double time;
+    while (pos < map.size) {
+      size_t len = Struct::scan(map.data + pos, map.size - pos, time);
+      if (len==0) {
+	std::cerr << "---- Coefs: truncated or unreadable record at byte "
+		  << pos << " of <" << file << ">, stopping" << std::endl;
+	break;
+      }
+      if (count++ % stride == 0 and time >= tmin and time <= tmax)
+	recs.push_back({pos, len});
+      pos += len;
+    }
+
+    // Decode; a failed record truncates the series as in the stream
+    // reader
+    //
+    ret.resize(recs.size());
+    std::vector<unsigned char> good(recs.size(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t j=0; j<recs.size(); j++) {
+      try {
+	MemStream in(map.data + recs[j].first, recs[j].second);
+	auto c = std::make_shared<Struct>();
+	if (c->read(in, verbose)) {
+	  ret[j]  = c;
+	  good[j] = 1;
+	}
+      }
+      catch (std::exception& error) {
+	std::cerr << "---- Coefs: error decoding record at byte "
+		  << recs[j].first << ": " << error.what() << std::endl;
+      }
+    }
+
+    auto bad = std::find(good.begin(), good.end(), 0);
+    ret.resize(bad - good.begin());
+
+    return true;
+  }
+  }
   
   void Coefs::copyfields(std::shared_ptr<Coefs> p)
   {
@@ -31,10 +97,606 @@ namespace CoefClasses
     p->times    = times;
   }
 
+  LazyH5::LazyH5(const std::vector<double>& times, Fetch fetch,
+		 size_t block, size_t nblocks) :
+    times(times), fetch(fetch), block(block), nblocks(nblocks)
+  {
+    for (size_t i=0; i<times.size(); i++) index[times[i]] = i;
+  }
+
+  CoefStrPtr LazyH5::get(size_t i)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+
+    size_t b = i/block, first = b*block;
+
+    auto it = cache.find(b);
+    if (it != cache.end()) {
+      lru.splice(lru.begin(), lru, it->second.first);
+      return it->second.second[i - first];
+    }
+
+    // Read the block
+    //
+    auto blk = fetch(first, std::min(first+block, times.size()));
+
+    // Drop the least recently used blocks
+    //
+    while (cache.size() >= nblocks) {
+      cache.erase(lru.back());
+      lru.pop_back();
+    }
+
+    lru.push_front(b);
+    cache[b] = {lru.begin(), blk};
+
+    return blk[i - first];
+  }
+
+  //! Read the given rows of a chunked H5 layout.  The span between
+  //! the first and last row is read with one selection per harmonic
+  //! block.
+  static std::vector<CoefStrPtr> readSeriesRows
+  (const HighFive::Group& series, const LazyH5::Builder& make,
+   const std::vector<size_t>& want)
+  {
+    std::vector<CoefStrPtr> ret;
+    if (want.empty()) return ret;
+
+    int rows, cols;
+    series.getAttribute("rows").read(rows);
+    series.getAttribute("cols").read(cols);
+
+    auto mm = std::minmax_element(want.begin(), want.end());
+    size_t lo = *mm.first, n = *mm.second - lo + 1, C = cols;
+
+    std::vector<double> time(n), ctr(3*n), buf(2*n*C);
+
+    series.getDataSet("time").select({lo}, {n})
+      .read_raw(time.data(), HighFive::AtomicType<double>());
+    series.getDataSet("center").select({lo, 0}, {n, 3})
+      .read_raw(ctr.data(), HighFive::AtomicType<double>());
+
+    std::vector<Eigen::VectorXcd> store(want.size(),
+					Eigen::VectorXcd(rows*cols));
+
+    auto harm = series.getGroup("coefficients");
+
+    for (int r=0; r<rows; r++) {
+      harm.getDataSet(std::to_string(r)).select({lo, 0, 0}, {n, C, 2})
+	.read_raw(buf.data(), HighFive::AtomicType<double>());
+
+      for (size_t k=0; k<want.size(); k++) {
+	const double *v = &buf[2*C*(want[k] - lo)];
+	for (int c=0; c<cols; c++)
+	  store[k](c*rows + r) = {v[2*c], v[2*c+1]};
+      }
+    }
+
+    for (size_t k=0; k<want.size(); k++) {
+      size_t t = want[k] - lo;
+      std::vector<double> center(&ctr[3*t], &ctr[3*t+3]);
+      ret.push_back(make(time[t], center, store[k]));
+    }
+
+    return ret;
+  }
+
+  //! The contents of a compressed archive: a snapshot is the mean
+  //! plus its row of the weights times the basis
+  struct PCAArchive
+  {
+    std::vector<double> time, ctr, residual;
+    Eigen::VectorXcd mean;
+    Eigen::MatrixXcd basis, weights;
+
+    //! Read the pca group
+    PCAArchive(const HighFive::Group& grp)
+    {
+      unsigned K;
+      grp.getAttribute("rank").read(K);
+
+      grp.getDataSet("time").read(time);
+      grp.getDataSet("residual").read(residual);
+
+      size_t T = time.size();
+      size_t D = grp.getDataSet("mean").getDimensions()[0];
+
+      ctr    .resize(3*T);
+      mean   .resize(D);
+      basis  .resize(K, D);
+      weights.resize(T, K);
+
+      // The complex values are stored as (real, imag) pairs
+      //
+      std::vector<double> buf(2*std::max(D*K, T*K));
+
+      grp.getDataSet("center").read_raw(ctr.data(), HighFive::AtomicType<double>());
+      grp.getDataSet("mean").read_raw(reinterpret_cast<double*>(mean.data()),
+				      HighFive::AtomicType<double>());
+
+      if (K) {
+	grp.getDataSet("basis").read_raw(buf.data(), HighFive::AtomicType<double>());
+	for (size_t k=0; k<K; k++)
+	  for (size_t d=0; d<D; d++)
+	    basis(k, d) = {buf[2*(k*D+d)], buf[2*(k*D+d)+1]};
+
+	grp.getDataSet("weights").read_raw(buf.data(), HighFive::AtomicType<double>());
+	for (size_t t=0; t<T; t++)
+	  for (size_t k=0; k<K; k++)
+	    weights(t, k) = {buf[2*(t*K+k)], buf[2*(t*K+k)+1]};
+      }
+    }
+
+    //! Reconstruct row t
+    CoefStrPtr row(size_t t, const LazyH5::Builder& make) const
+    {
+      Eigen::VectorXcd store = mean;
+      if (basis.rows()) store += (weights.row(t) * basis).transpose();
+      std::vector<double> center(&ctr[3*t], &ctr[3*t+3]);
+      return make(time[t], center, store);
+    }
+  };
+
+  void Coefs::readH5Snapshots
+  (HighFive::File& file, unsigned count, int stride,
+   double Tmin, double Tmax, bool Lazy, LazyH5::Reader reader,
+   LazyH5::Builder make, std::function<void(double, CoefStrPtr)> insert)
+  {
+    stride = std::max<int>(1, stride);
+
+    // Look for the chunked and compressed layouts
+    //
+    bool chunked = false, pca = false;
+    if (file.hasAttribute("layout")) {
+      std::string layout;
+      file.getAttribute("layout").read(layout);
+      chunked = layout == "chunked";
+      pca     = layout == "pca";
+    }
+
+    // Rounded snapshot times and their group names or rows
+    //
+    std::vector<double> tlist;
+    std::vector<std::string> groups;
+    std::vector<size_t> rows;
+
+    LazyH5::Fetch fetch;
+
+    // Remember the source for refresh()
+    //
+    h5chunked = chunked;
+    h5pca     = pca;
+    h5stride  = stride;
+    h5tmin    = Tmin;
+    h5tmax    = Tmax;
+    h5reader  = reader;
+    h5make    = make;
+
+    if (pca) {
+
+      auto arch = std::make_shared<const PCAArchive>(file.getGroup("pca"));
+
+      double retained;
+      file.getGroup("pca").getAttribute("retained").read(retained);
+
+      if (myid==0)
+	std::cerr << "---- Coefs::factory: compressed archive with "
+		  << arch->basis.rows() << " components retaining "
+		  << retained << " of the variance" << std::endl;
+
+      unsigned last = std::min<size_t>(count, arch->time.size());
+      h5residual.clear();
+      for (unsigned n=0; n<last; n+=stride) {
+	if (arch->time[n] < Tmin or arch->time[n] > Tmax) continue;
+	rows .push_back(n);
+	tlist.push_back(roundTime(arch->time[n]));
+	h5residual[tlist.back()] = arch->residual[n];
+      }
+
+      h5next = last;
+
+      if (not Lazy) {
+	for (auto n : rows) {
+	  auto c = arch->row(n, make);
+	  insert(roundTime(c->time), c);
+	}
+	return;
+      }
+
+      fetch = [arch, make, rows](size_t first, size_t last)
+      {
+	std::vector<CoefStrPtr> ret;
+	for (size_t j=first; j<last; j++) ret.push_back(arch->row(rows[j], make));
+	return ret;
+      };
+
+    } else if (chunked) {
+
+      auto series = file.getGroup("series");
+
+      std::vector<double> Times;
+      series.getDataSet("time").read(Times);
+
+      unsigned last = std::min<size_t>(count, Times.size());
+      for (unsigned n=0; n<last; n+=stride) {
+	if (Times[n] < Tmin or Times[n] > Tmax) continue;
+	rows .push_back(n);
+	tlist.push_back(roundTime(Times[n]));
+      }
+
+      h5next = (last + stride - 1)/stride*stride;
+
+      // Read the rows in windows of the block size
+      //
+      if (not Lazy) {
+	for (size_t k=0; k<rows.size(); k+=lazyBlock) {
+	  std::vector<size_t> want(rows.begin() + k,
+				   rows.begin() + std::min(k+lazyBlock, rows.size()));
+	  for (auto c : readSeriesRows(series, make, want))
+	    insert(roundTime(c->time), c);
+	}
+	return;
+      }
+
+      fetch = [series, make, rows](size_t first, size_t last)
+      {
+	return readSeriesRows(series, make,
+			      std::vector<size_t>(rows.begin() + first,
+						  rows.begin() + last));
+      };
+
+    } else {
+
+      h5next = (count + stride - 1)/stride*stride;
+
+      // Open the snapshot group
+      //
+      auto snaps = file.getGroup("snapshots");
+
+      for (unsigned n=0; n<count; n+=stride) {
+      
+	std::ostringstream sout;
+	sout << std::setw(8) << std::setfill('0') << std::right << n;
+      
+	auto stanza = snaps.getGroup(sout.str());
+      
+	double Time;
+	stanza.getAttribute("Time").read(Time);
+      
+	if (Time < Tmin or Time > Tmax) continue;
+
+	// Only index the stanza in lazy mode
+	//
+	if (Lazy) {
+	  groups.push_back(sout.str());
+	  tlist.push_back(roundTime(Time));
+	} else {
+	  insert(roundTime(Time), reader(stanza));
+	}
+      }
+
+      if (not Lazy) return;
+
+      fetch = [snaps, groups, reader](size_t first, size_t last)
+      {
+	std::vector<CoefStrPtr> ret;
+	for (size_t j=first; j<last; j++) {
+	  auto stanza = snaps.getGroup(groups[j]);
+	  ret.push_back(reader(stanza));
+	}
+	return ret;
+      };
+    }
+
+    // Order by time; a repeated time keeps the last stanza, as in
+    // the in-memory map
+    //
+    std::vector<size_t> order(tlist.size()), sel;
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+		     [&](size_t a, size_t b) { return tlist[a] < tlist[b]; });
+
+    std::vector<double> times;
+    for (auto k : order) {
+      if (times.size() and times.back() == tlist[k]) {
+	sel.back() = k;
+      } else {
+	sel  .push_back(k);
+	times.push_back(tlist[k]);
+      }
+    }
+
+    // Map the time-ordered positions to the file positions
+    //
+    auto source = [fetch, sel](size_t first, size_t last)
+    {
+      std::vector<CoefStrPtr> ret;
+
+      // Fetch runs of consecutive file positions at once
+      //
+      for (size_t j=first; j<last;) {
+	size_t k = j+1;
+	while (k<last and sel[k]==sel[k-1]+1) k++;
+	auto blk = fetch(sel[j], sel[k-1]+1);
+	ret.insert(ret.end(), blk.begin(), blk.end());
+	j = k;
+      }
+      return ret;
+    };
+
+    lazy = std::make_shared<LazyH5>(times, source, lazyBlock, lazyBlocks);
+  }
+
+  void Coefs::materialize()
+  {
+    if (lazy) {
+      // Leave lazy mode first so that add() stores the snapshots
+      //
+      auto src = lazy;
+      lazy.reset();
+
+      for (size_t i=0; i<src->size(); i++) add(src->get(i));
+    }
+
+    // Make the zeroed snapshots
+    //
+    auto z = zeros;
+    for (auto t : z) peek(t);
+  }
+
+  CoefStrPtr Coefs::peek(double time)
+  {
+    bool was = peeking;
+    peeking = true;
+    try {
+      auto p = getCoefStruct(time);
+      peeking = was;
+      return p;
+    }
+    catch (...) {
+      peeking = was;
+      throw;
+    }
+  }
+
+  void Coefs::pack()
+  {
+    materialize();
+
+    stimes = Times();
+    tindex.clear();
+
+    int ntim = stimes.size();
+    int ncof = ntim ? peek(stimes[0])->store.size() : 0;
+
+    series.resize(ntim, ncof);
+
+    for (int t=0; t<ntim; t++) {
+      auto c = peek(stimes[t]);
+      if (c->store.size() != ncof)
+	throw CoefsError("Coefs::pack: snapshots differ in size");
+      series.row(t) = c->store.transpose();
+      tindex[roundTime(stimes[t])] = t;
+    }
+
+    stale = false;
+  }
+
+  Eigen::MatrixXd& Coefs::cachedPower(int min, int max)
+  {
+    if (min != pmin or max != pmax) {
+      prows.clear();
+      pmin = min;
+      pmax = max;
+    }
+
+    auto T = Times();
+
+    // Snapshots without a cached row
+    //
+    std::vector<double> todo;
+    for (auto t : T) {
+      if (prows.find(roundTime(t)) == prows.end()) todo.push_back(t);
+    }
+
+    // Only one block of snapshots is held at a time.  The reads are
+    // serial; the power of the snapshots in a block is not.
+    //
+    const int nblk = std::max<int>(1, lazyBlock);
+
+    std::vector<CoefStrPtr> snap;
+    std::vector<Eigen::VectorXd> rows;
+
+    for (int b=0; b<todo.size(); b+=nblk) {
+      int e = std::min<int>(todo.size(), b + nblk);
+
+      snap.resize(e - b);
+      rows.resize(e - b);
+      for (int i=b; i<e; i++) snap[i-b] = peek(todo[i]);
+
+#pragma omp parallel for
+      for (int i=0; i<e-b; i++)
+	rows[i] = powerRow(snap[i], min, max);
+
+      for (int i=b; i<e; i++) prows[roundTime(todo[i])] = std::move(rows[i-b]);
+    }
+
+    snap.clear();
+
+    // Assemble in time order
+    //
+    if (T.size()) {
+      int ncol = prows[roundTime(T[0])].size();
+      power.resize(T.size(), ncol);
+      for (int t=0; t<T.size(); t++) {
+	auto & row = prows[roundTime(T[t])];
+	if (row.size() != ncol)
+	  throw CoefsError("Coefs::Power: snapshots differ in size");
+	power.row(t) = row.transpose();
+      }
+    } else {
+      power.resize(0, 0);
+    }
+
+    return power;
+  }
+
+  void Coefs::setInterpolation(const std::string& method)
+  {
+    if      (method == "linear") cubic = false;
+    else if (method == "cubic")  cubic = true;
+    else
+      throw CoefsError("Coefs::setInterpolation: unknown method <" + method +
+		       ">; choose linear or cubic");
+    cached = dcached = false;
+  }
+
+  void Coefs::shareSeries()
+  {
+    int flag = 0;
+    MPI_Initialized(&flag);
+    if (not flag) return;
+
+    // Times are known on every rank without reading the snapshots
+    //
+    std::vector<double> T = getSeriesTimes();
+    int ntim = T.size(), ncof = 0;
+
+    bool leader = NodeSharedComm::isLeader();
+    if (leader and ntim) ncof = peek(T[0])->store.size();
+    MPI_Bcast(&ncof, 1, MPI_INT, 0, NodeSharedComm::nodeComm());
+
+    auto table = std::make_shared<NodeShared<double>>();
+    table->allocate(2*size_t(ntim)*ncof, true);
+
+    if (table->writer()) {
+      for (int t=0; t<ntim; t++) {
+	auto c = peek(T[t]);
+	if (c->store.size() != ncof)
+	  throw CoefsError("Coefs::shareSeries: snapshots differ in size");
+	std::copy(c->store.data(), c->store.data() + ncof,
+		  reinterpret_cast<std::complex<double>*>(table->data()) +
+		  size_t(t)*ncof);
+      }
+    }
+    table->sync();
+
+    // Drop the private snapshots; the index is all that is left
+    //
+    clear();
+    series.resize(0, 0);
+
+    stimes = T;
+    tindex.clear();
+    for (int t=0; t<ntim; t++) tindex[roundTime(T[t])] = t;
+
+    sseries = table;
+    stale   = false;
+  }
+
+  Eigen::VectorXcd Coefs::seriesRow(int i)
+  {
+    if (sseries) {
+      int ncof = sseries->size()/(2*stimes.size());
+      return Eigen::Map<const Eigen::VectorXcd>
+	(reinterpret_cast<const std::complex<double>*>(sseries->data()) +
+	 size_t(i)*ncof, ncof);
+    }
+    if (lazy) return lazy->get(i)->store;
+    return series.row(i).transpose();
+  }
+
+  int Coefs::bracket(const std::vector<double>& times, double time)
+  {
+    int n = times.size();
+
+    // Check for a uniform grid once per change of the container
+    //
+    if (dtGrid < 0.0) {
+      dtGrid = 0.0;
+      if (n>2) {
+	double dt = (times.back() - times.front())/(n-1);
+	bool uniform = dt > 0.0;
+	for (int i=1; i<n and uniform; i++) {
+	  if (std::fabs(times[i] - times[i-1] - dt) > 1.0e-6*dt)
+	    uniform = false;
+	}
+	if (uniform) {
+	  t0Grid = times.front();
+	  dtGrid = dt;
+	}
+      }
+    }
+
+    int i;
+    if (dtGrid > 0.0) {
+      i = std::floor((time - t0Grid)/dtGrid);
+      i = std::max<int>(0, std::min<int>(n-2, i));
+      // Guard against round off at the bin edges
+      while (i>0   and times[i]   > time) i--;
+      while (i<n-2 and times[i+1] < time) i++;
+    } else {
+      auto it = std::upper_bound(times.begin(), times.end(), time);
+      i = std::distance(times.begin(), it) - 1;
+      i = std::max<int>(0, std::min<int>(n-2, i));
+    }
+
+    return i;
+  }
+
+  Eigen::VectorXcd Coefs::slope(const std::vector<double>& times, int i)
+  {
+    int n = times.size();
+
+    // One-sided at the ends
+    //
+    if (i==0)   return (seriesRow(1) - seriesRow(0))/(times[1] - times[0]);
+    if (i==n-1) return (seriesRow(n-1) - seriesRow(n-2))/(times[n-1] - times[n-2]);
+
+    // Three-point (parabolic) estimate for an uneven grid
+    //
+    double hl = times[i] - times[i-1], hr = times[i+1] - times[i];
+    Eigen::VectorXcd c = seriesRow(i);
+    return ( hl*(seriesRow(i+1) - c)/hr + hr*(c - seriesRow(i-1))/hl )/(hl + hr);
+  }
+
+  void Coefs::interpolant(double time, bool deriv)
+  {
+    auto & times = getSeriesTimes();
+
+    int iA = bracket(times, time), iB = iA + 1;
+    double h = times[iB] - times[iA];
+    double s = (time - times[iA])/h;
+
+    Eigen::VectorXcd yA = seriesRow(iA), yB = seriesRow(iB);
+
+    if (cubic) {
+      Eigen::VectorXcd mA = slope(times, iA), mB = slope(times, iB);
+
+      double s2 = s*s, s3 = s2*s;
+      arr = (2.0*s3 - 3.0*s2 + 1.0)*yA + (s3 - 2.0*s2 + s)*h*mA +
+	(-2.0*s3 + 3.0*s2)*yB + (s3 - s2)*h*mB;
+
+      if (deriv)
+	darr = (6.0*s2 - 6.0*s)/h*(yA - yB) + (3.0*s2 - 4.0*s + 1.0)*mA +
+	  (3.0*s2 - 2.0*s)*mB;
+    } else {
+      arr = (1.0 - s)*yA + s*yB;
+      if (deriv) darr = (yB - yA)/h;
+    }
+
+    tcache  = time;
+    cached  = true;
+    dcached = deriv;
+  }
+
   std::tuple<Eigen::VectorXcd&, bool> Coefs::interpolate(double time)
   {
     bool onGrid = true;
 
+    auto & times = getSeriesTimes();
+
     if (time < times.front()-deltaT or time > times.back()+deltaT) {
       
       const  int max_oab = 8;	// Allow 'slop' off grid attempts
@@ -47,35 +709,19 @@ namespace CoefClasses
       if (cnt_oab > max_oab) onGrid = false;
     }
 
-    auto it = std::lower_bound(times.begin(), times.end(), time);
-    auto lo = it, hi = it;
-
-    if (hi == std::prev(times.end()) or hi == times.end()) {
-      hi = std::prev(times.end());
-      lo = hi - 1;
-    } else hi++;
-    
-    double A = (*hi - time)/(*hi - *lo);
-    double B = (time - *lo)/(*hi - *lo);
-    
-    int iA = std::distance(times.begin(), lo);
-    int iB = std::distance(times.begin(), hi);
-
-    auto cA = getCoefStruct(times[iA]);
-    auto cB = getCoefStruct(times[iB]);
-
-    int siz = cA->store.size();
-    arr.resize(siz);
-
-    for (int c=0; c<siz; c++) {
-      arr(c) = A*cA->store(c) + B*cB->store(c);
-    }
+    if (not cached or time != tcache) interpolant(time, false);
 
     return {arr, onGrid};
   }
+
+  Eigen::VectorXcd& Coefs::derivative(double time)
+  {
+    if (not dcached or time != tcache) interpolant(time, true);
+    return darr;
+  }
   
   SphCoefs::SphCoefs(HighFive::File& file, int stride,
-		     double Tmin, double Tmax, bool verbose) :
+		     double Tmin, double Tmax, bool verbose, bool Lazy) :
     Coefs("sphere", verbose)
   {
     std::string config, geometry, forceID;
@@ -97,17 +743,35 @@ namespace CoefClasses
     bool H5back = true;
     if (file.hasAttribute("CoefficientOutputVersion")) H5back = false;
 
-    // Open the snapshot group
+    // Make one snapshot from its coefficient vector
     //
-    auto snaps = file.getGroup("snapshots");
-    
-    for (unsigned n=0; n<count; n+=stride) {
-      
-      std::ostringstream sout;
-      sout << std::setw(8) << std::setfill('0') << std::right << n;
-      
-      auto stanza = snaps.getGroup(sout.str());
+    int lmax = Lmax, nmax = Nmax;
+
+    auto make = [lmax, nmax, scale, geometry, forceID]
+      (double Time, const std::vector<double>& ctr,
+       const Eigen::VectorXcd& store) -> CoefStrPtr
+    {
+      auto coef = std::make_shared<SphStruct>();
       
+      if (ctr.size()) coef->ctr = ctr;
+
+      coef->lmax  = lmax;
+      coef->nmax  = nmax;
+      coef->time  = Time;
+      coef->scale = scale;
+      coef->geom  = geometry;
+      coef->id    = forceID;
+
+      coef->allocate();
+      coef->store = store;
+
+      return coef;
+    };
+
+    // Read one snapshot stanza
+    //
+    auto reader = [make, H5back](HighFive::Group& stanza) -> CoefStrPtr
+    {
       double Time;
       stanza.getAttribute("Time").read(Time);
       
@@ -118,8 +782,6 @@ namespace CoefClasses
 	stanza.getAttribute("Center").read(ctr);
       }
 
-      if (Time < Tmin or Time > Tmax) continue;
-
       auto in = stanza.getDataSet("coefficients").read<Eigen::MatrixXcd>();
 
       // If we have a legacy set of coefficients, re-order the
@@ -139,39 +801,31 @@ namespace CoefClasses
       
       // Pack the data into the coefficient variable
       //
-      auto coef = std::make_shared<SphStruct>();
-      
-      if (ctr.size()) coef->ctr = ctr;
+      return make(Time, ctr,
+		  Eigen::Map<Eigen::VectorXcd>(in.data(), in.size()));
+    };
 
-      coef->lmax  = Lmax;
-      coef->nmax  = Nmax;
-      coef->time  = Time;
-      coef->scale = scale;
-      coef->geom  = geometry;
-      coef->id    = forceID;
+    readH5Snapshots(file, count, stride, Tmin, Tmax, Lazy, reader, make,
+		    [this](double T, CoefStrPtr c)
+		    { coefs[T] = std::dynamic_pointer_cast<SphStruct>(c); });
 
-      coef->allocate();
-      *coef->coefs = in;
-      
-      coefs[roundTime(Time)] = coef;
-    }
-
-    times.clear();
-    for (auto t : coefs) times.push_back(t.first);
+    Times();
   }
   
   std::shared_ptr<Coefs> SphCoefs::deepcopy()
   {
+    materialize();
+
     auto ret = std::make_shared<SphCoefs>();
 
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<SphStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->Lmax = Lmax;
     ret->Nmax = Nmax;
@@ -181,16 +835,18 @@ namespace CoefClasses
 
   std::shared_ptr<Coefs> CylCoefs::deepcopy()
   {
+    materialize();
+
     auto ret = std::make_shared<CylCoefs>();
 
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<CylStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->Mmax  = Mmax;
     ret->Nmax  = Nmax;
@@ -206,11 +862,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<SlabStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->NmaxX  = NmaxX;
     ret->NmaxY  = NmaxY;
@@ -226,11 +882,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<CubeStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->NmaxX  = NmaxX;
     ret->NmaxY  = NmaxY;
@@ -246,11 +902,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<TblStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->data  = data;
     ret->times = times;
@@ -266,11 +922,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<TrajStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->data  = data;
     ret->times = times;
@@ -356,11 +1012,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<SphFldStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->Nfld = Nfld;
     ret->Lmax = Lmax;
@@ -447,11 +1103,11 @@ namespace CoefClasses
     // Copy the base-class fields
     copyfields(ret);
 
-    // Copy the local structures from the map to the struct pointers
-    // by copyfing fields, not the pointer
-    for (auto v : coefs)
-      ret->coefs[v.first] =
-	std::dynamic_pointer_cast<CylFldStruct>(v.second->deepcopy());
+    // Share the snapshots until one side changes them
+    for (auto v : coefs) {
+      v.second->shared = true;
+      ret->coefs[v.first] = v.second;
+    }
 
     ret->Nfld = Nfld;
     ret->Mmax = Mmax;
@@ -461,14 +1117,32 @@ namespace CoefClasses
   }
 
 
-  Eigen::VectorXcd& SphCoefs::getData(double time)
+  SphStrPtr SphCoefs::lookup(double time)
   {
+    if (lazy) {
+      int i = lazy->find(roundTime(time));
+      if (i<0) return 0;
+      return std::dynamic_pointer_cast<SphStruct>(lazy->get(i));
+    }
+
     auto it = coefs.find(roundTime(time));
+    if (it == coefs.end()) return 0;
 
-    if (it == coefs.end()) {
+    // A listed zero snapshot is made on first use
+    if (zeros.count(it->first))
+      return std::dynamic_pointer_cast<SphStruct>(peek(it->first));
+
+    return it->second;
+  }
+
+  Eigen::VectorXcd& SphCoefs::getData(double time)
+  {
+    auto p = lookup(time);
+
+    if (not p) {
       arr.resize(0);
     } else {
-      arr = it->second->store;
+      arr = p->store;
     }
     
     return arr;
@@ -476,12 +1150,12 @@ namespace CoefClasses
   
   Eigen::MatrixXcd& SphCoefs::getMatrix(double time)
   {
-    auto it = coefs.find(roundTime(time));
+    auto p = lookup(time);
 
-    if (it == coefs.end()) {
+    if (not p) {
       arr.resize(0);
     } else {
-      arr = it->second->store;
+      arr = p->store;
       int ldim = (Lmax+1)*(Lmax+2)/2;
       mat = Eigen::Map<Eigen::MatrixXcd>(arr.data(), ldim, Nmax); 
     }
@@ -491,6 +1165,9 @@ namespace CoefClasses
   
   void SphCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    materialize();
+    invalidate(time);
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -498,6 +1175,7 @@ namespace CoefClasses
       str << "SphCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::SphStruct::coefType>
 	(it->second->store.data(), (Lmax+1)*(Lmax+2)/2, Nmax);
@@ -506,6 +1184,9 @@ namespace CoefClasses
   
   void SphCoefs::setMatrix(double time, Eigen::MatrixXcd& dat)
   {
+    materialize();
+    invalidate(time);
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -513,6 +1194,7 @@ namespace CoefClasses
       str << "SphCoefs::setMatrix: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->allocate();
       *it->second->coefs = dat;
     }
@@ -520,16 +1202,19 @@ namespace CoefClasses
   
   Eigen::Tensor<std::complex<double>, 3> SphCoefs::getAllCoefs()
   {
+    materialize();
+
     Eigen::Tensor<std::complex<double>, 3> ret;
 
-    auto times = Times();
+    auto & S     = getSeries();
+    auto & times = getSeriesTimes();
     int ntim = times.size();
 
     // Resize the tensor
     ret.resize((Lmax+1)*(Lmax+2)/2, Nmax, ntim);
 
     for (int t=0; t<ntim; t++) {
-      auto & cof = *(coefs[roundTime(times[t])]->coefs);
+      Eigen::Map<const Eigen::MatrixXcd> cof(S.data() + t*S.cols(), (Lmax+1)*(Lmax+2)/2, Nmax);
       for (int l=0; l<(Lmax+2)*(Lmax+1)/2; l++) {
 	for (int n=0; n<Nmax; n++) {
 	  ret(l, n, t) = cof(l, n);
@@ -590,30 +1275,35 @@ namespace CoefClasses
   void SphCoefs::readNativeCoefs(const std::string& file, int stride,
 				 double tmin, double tmax)
   {
-    std::ifstream in(file);
+    std::vector<SphStrPtr> recs;
+    if (readMapped(file, stride, tmin, tmax, verbose, recs)) {
+      for (auto c : recs) coefs[roundTime(c->time)] = c;
+    } else {
+      std::ifstream in(file);
     
-    if (not in) {
-      throw std::runtime_error("SphCoefs ERROR (runtime) opening file <" + file + ">");
-    }
+      if (not in) {
+	throw std::runtime_error("SphCoefs ERROR (runtime) opening file <" + file + ">");
+      }
     
-    int count = 0;
-    while (in) {
-      try {
-	SphStrPtr c = std::make_shared<SphStruct>();
-	if (not c->read(in, verbose)) break;
+      int count = 0;
+      while (in) {
+	try {
+	  SphStrPtr c = std::make_shared<SphStruct>();
+	  if (not c->read(in, verbose)) break;
 
-	if (count++ % stride) continue;
-	if (c->time < tmin or c->time > tmax) continue;
+	  if (count++ % stride) continue;
+	  if (c->time < tmin or c->time > tmax) continue;
 
-	coefs[roundTime(c->time)] = c;
-      }
-      catch(std::runtime_error& error) {
-	std::cout << "SphCoefs ERROR (runtime): " << error.what() << std::endl;
-	break;
-      }
-      catch(std::logic_error& error) {
-	std::cout << "SphCoefs ERROR (logic): " << error.what() << std::endl;
-	break;
+	  coefs[roundTime(c->time)] = c;
+	}
+	catch(std::runtime_error& error) {
+	  std::cout << "SphCoefs ERROR (runtime): " << error.what() << std::endl;
+	  break;
+	}
+	catch(std::logic_error& error) {
+	  std::cout << "SphCoefs ERROR (logic): " << error.what() << std::endl;
+	  break;
+	}
       }
     }
 
@@ -646,6 +1336,8 @@ namespace CoefClasses
   
   unsigned SphCoefs::WriteH5Times(HighFive::Group& snaps, unsigned count)
   {
+    materialize();
+
     for (auto c : coefs) {
       auto C = c.second;
       
@@ -691,6 +1383,8 @@ namespace CoefClasses
   
   void SphCoefs::dump(int lmin, int lmax, int nmin, int nmax)
   {
+    materialize();
+
     for (auto c : coefs) {
       unsigned I = 0;
       if (lmin>0) I += lmin*lmin;
@@ -717,11 +1411,25 @@ namespace CoefClasses
     bool ret = true;
     
     auto other = std::dynamic_pointer_cast<SphCoefs>(check);
+    if (not other) {
+      std::cout << "Other coefficients are not spherical" << std::endl;
+      return false;
+    }
     
+    // Snapshots are compared one at a time, so either set may be
+    // lazy and neither is read into memory as a whole
+    //
+    auto has = [other](double t)
+    {
+      if (other->lazy) return other->lazy->find(t) >= 0;
+      return other->coefs.find(t) != other->coefs.end();
+    };
+
     // Check that every time in this one is in the other
-    for (auto v : coefs) {
-      if (other->coefs.find(roundTime(v.first)) == other->coefs.end()) {
-	std::cout << "Can't find Time=" << v.first << std::endl;
+    auto T = Times();
+    for (auto t : T) {
+      if (not has(roundTime(t))) {
+	std::cout << "Can't find Time=" << t << std::endl;
 	ret = false;
       }
     }
@@ -733,23 +1441,17 @@ namespace CoefClasses
     }
 
     if (ret) {
-      std::cout << "Times are the same, now checking parameters at each time"
-		<< std::endl;
-      for (auto v : coefs) {
-	auto it = other->coefs.find(v.first);
-	if (v.second->lmax != it->second->lmax) ret = false;
-	if (v.second->nmax != it->second->nmax) ret = false;
-	if (v.second->time != it->second->time) ret = false;
-      }
-    }
-    
-    if (ret) {
-      std::cout << "Parameters are the same, now checking coefficients"
-		<< std::endl;
-      for (auto v : coefs) {
-	auto it = other->coefs.find(v.first);
-	auto & cv = *(v.second->coefs);
-	auto & ci = *(it->second->coefs);
+      std::cout << "Times are the same, now checking parameters and "
+		<< "coefficients at each time" << std::endl;
+      for (auto t : T) {
+	auto a = lookup(t), b = other->lookup(t);
+	if (a->lmax != b->lmax or a->nmax != b->nmax or a->time != b->time) {
+	  std::cout << "Parameters differ at Time=" << t << std::endl;
+	  ret = false;
+	  continue;
+	}
+	auto & cv = *(a->coefs);
+	auto & ci = *(b->coefs);
 	for (int i=0; i<cv.rows(); i++) {
 	  for (int j=0; j<cv.cols(); j++) {
 	    if (cv(i, j) != ci(i, j)) {
@@ -766,37 +1468,35 @@ namespace CoefClasses
     return ret;
   }
   
-  Eigen::MatrixXd& SphCoefs::Power(int min, int max)
+  Eigen::VectorXd SphCoefs::powerRow(CoefStrPtr coef, int min, int max)
   {
-    if (coefs.size()) {
-      
-      int lmax = coefs.begin()->second->lmax;
-      int nmax = coefs.begin()->second->nmax;
-      power.resize(coefs.size(), lmax+1);
-      power.setZero();
-      
-      int T=0;
-      for (auto v : coefs) {
-	for (int l=0, L=0; l<=lmax; l++) {
-	  for (int m=0; m<=l; m++, L++) {
-	    auto rad = v.second->coefs->row(L);
-	    for (int n=std::max<int>(0, min); n<std::min<int>(nmax, max); n++) {
-	      double val = std::abs(rad(n));
-	      power(T, l) += val * val;
-	    }
-	  }
-	}
-	T++;
+    auto p = std::dynamic_pointer_cast<SphStruct>(coef);
+    int lmax = p->lmax, nmax = p->nmax;
+    Eigen::Map<const Eigen::MatrixXcd> cof(p->store.data(), (lmax+1)*(lmax+2)/2, nmax);
+    Eigen::VectorXd ret = Eigen::VectorXd::Zero(lmax+1);
+
+    int nbeg = std::max<int>(0, min), nend = std::min<int>(nmax, max);
+    if (nend <= nbeg) return ret;
+
+    for (int l=0, L=0; l<=lmax; l++) {
+      for (int m=0; m<=l; m++, L++) {
+	ret(l) += cof.row(L).segment(nbeg, nend-nbeg).squaredNorm();
       }
-    } else {
-      power.resize(0, 0);
     }
-    
-    return power;
+
+    return ret;
+  }
+
+  Eigen::MatrixXd& SphCoefs::Power(int min, int max)
+  {
+    return cachedPower(min, max);
   }
   
   void SphCoefs::add(CoefStrPtr coef)
   {
+    materialize();
+    invalidate(coef->time);
+
     auto p = std::dynamic_pointer_cast<SphStruct>(coef);
     if (not p) throw std::runtime_error("SphCoefs::add: Null coefficient structure, nothing added!");
 
@@ -806,7 +1506,7 @@ namespace CoefClasses
   }
 
   CylCoefs::CylCoefs(HighFive::File& file, int stride,
-		     double Tmin, double Tmax, bool verbose) :
+		     double Tmin, double Tmax, bool verbose, bool Lazy) :
     Coefs("cylinder", verbose)
   {
     unsigned count;
@@ -824,17 +1524,32 @@ namespace CoefClasses
     bool H5back = true;
     if (file.hasAttribute("CoefficientOutputVersion")) H5back = false;
 
-    // Open the snapshot group
+    // Make one snapshot from its coefficient vector
     //
-    auto snaps = file.getGroup("snapshots");
-    
-    for (unsigned n=0; n<count; n+=stride) {
-      
-      std::ostringstream sout;
-      sout << std::setw(8) << std::setfill('0') << std::right << n;
-      
-      auto stanza = snaps.getGroup(sout.str());
+    int mmax = Mmax, nmax = Nmax;
+
+    auto make = [mmax, nmax]
+      (double Time, const std::vector<double>& ctr,
+       const Eigen::VectorXcd& store) -> CoefStrPtr
+    {
+      auto coef = std::make_shared<CylStruct>();
       
+      if (ctr.size()) coef->ctr = ctr;
+
+      coef->mmax = mmax;
+      coef->nmax = nmax;
+      coef->time = Time;
+
+      coef->allocate();
+      coef->store = store;
+
+      return coef;
+    };
+
+    // Read one snapshot stanza
+    //
+    auto reader = [make, nmax, H5back](HighFive::Group& stanza) -> CoefStrPtr
+    {
       double Time;
       stanza.getAttribute("Time").read(Time);
       
@@ -845,8 +1560,6 @@ namespace CoefClasses
 	stanza.getAttribute("Center").read(ctr);
       }
 
-      if (Time < Tmin or Time > Tmax) continue;
-
       auto in = stanza.getDataSet("coefficients").read<Eigen::MatrixXcd>();
 
       // If we have a legacy set of coefficients, re-order the
@@ -866,32 +1579,47 @@ namespace CoefClasses
       
       // Work around for previous unitiaized data bug; enforces real data
       //
-      for (int n=0; n<Nmax; n++) in(0, n) = std::real(in(0, n));
+      for (int n=0; n<nmax; n++) in(0, n) = std::real(in(0, n));
 
       // Pack the data into the coefficient variable
       //
-      auto coef = std::make_shared<CylStruct>();
-      
-      if (ctr.size()) coef->ctr = ctr;
+      return make(Time, ctr,
+		  Eigen::Map<Eigen::VectorXcd>(in.data(), in.size()));
+    };
 
-      coef->assign(in, Mmax, Nmax);
-      coef->time = Time;
-      
-      coefs[roundTime(Time)] = coef;
-    }
+    readH5Snapshots(file, count, stride, Tmin, Tmax, Lazy, reader, make,
+		    [this](double T, CoefStrPtr c)
+		    { coefs[T] = std::dynamic_pointer_cast<CylStruct>(c); });
 
-    times.clear();
-    for (auto t : coefs) times.push_back(t.first);
+    Times();
   }
   
-  Eigen::VectorXcd& CylCoefs::getData(double time)
+  CylStrPtr CylCoefs::lookup(double time)
   {
+    if (lazy) {
+      int i = lazy->find(roundTime(time));
+      if (i<0) return 0;
+      return std::dynamic_pointer_cast<CylStruct>(lazy->get(i));
+    }
+
     auto it = coefs.find(roundTime(time));
+    if (it == coefs.end()) return 0;
 
-    if (it == coefs.end()) {
+    // A listed zero snapshot is made on first use
+    if (zeros.count(it->first))
+      return std::dynamic_pointer_cast<CylStruct>(peek(it->first));
+
+    return it->second;
+  }
+
+  Eigen::VectorXcd& CylCoefs::getData(double time)
+  {
+    auto p = lookup(time);
+
+    if (not p) {
       arr.resize(0);
     } else {
-      arr = it->second->store;
+      arr = p->store;
     }
     
     return arr;
@@ -899,12 +1627,12 @@ namespace CoefClasses
   
   Eigen::MatrixXcd& CylCoefs::getMatrix(double time)
   {
-    auto it = coefs.find(roundTime(time));
+    auto p = lookup(time);
 
-    if (it == coefs.end()) {
+    if (not p) {
       arr.resize(0);
     } else {
-      arr = it->second->store;
+      arr = p->store;
       mat = Eigen::Map<Eigen::MatrixXcd>(arr.data(), Mmax+1, Nmax); 
     }
     
@@ -913,6 +1641,9 @@ namespace CoefClasses
   
   void CylCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    materialize();
+    invalidate(time);
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -920,6 +1651,7 @@ namespace CoefClasses
       str << "CylCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::CylStruct::coefType>
 	(it->second->store.data(), Mmax+1, Nmax);
@@ -928,6 +1660,9 @@ namespace CoefClasses
 
   void CylCoefs::setMatrix(double time, Eigen::MatrixXcd& dat)
   {
+    materialize();
+    invalidate(time);
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -935,6 +1670,7 @@ namespace CoefClasses
       str << "CylCoefs::setMatrix: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->allocate();
       *it->second->coefs = dat;
     }
@@ -942,9 +1678,12 @@ namespace CoefClasses
 
   Eigen::Tensor<std::complex<double>, 3> CylCoefs::getAllCoefs()
   {
+    materialize();
+
     Eigen::Tensor<std::complex<double>, 3> ret;
 
-    auto times = Times();
+    auto & S     = getSeries();
+    auto & times = getSeriesTimes();
 
     int ntim = times.size();
 
@@ -952,7 +1691,7 @@ namespace CoefClasses
     ret.resize(Mmax+1, Nmax, ntim);
     
     for (int t=0; t<ntim; t++) {
-      auto & cof = *coefs[roundTime(times[t])]->coefs;
+      Eigen::Map<const Eigen::MatrixXcd> cof(S.data() + t*S.cols(), Mmax+1, Nmax);
       for (int m=0; m<Mmax+1; m++) {
 	for (int n=0; n<Nmax; n++) {
 	  ret(m, n, t) = cof(m, n);
@@ -998,21 +1737,26 @@ namespace CoefClasses
   void CylCoefs::readNativeCoefs(const std::string& file, int stride,
 				 double tmin, double tmax)
   {
-    std::ifstream in(file);
+    std::vector<CylStrPtr> recs;
+    if (readMapped(file, stride, tmin, tmax, verbose, recs)) {
+      for (auto c : recs) coefs[roundTime(c->time)] = c;
+    } else {
+      std::ifstream in(file);
     
-    if (not in) {
-      throw std::runtime_error("CylCoefs ERROR (runtime) opening file <" + file + ">");
-    }
+      if (not in) {
+	throw std::runtime_error("CylCoefs ERROR (runtime) opening file <" + file + ">");
+      }
     
-    int count = 0;
-    while (in) {
-      CylStrPtr c = std::make_shared<CylStruct>();
-      if (not c->read(in, verbose)) break;
+      int count = 0;
+      while (in) {
+	CylStrPtr c = std::make_shared<CylStruct>();
+	if (not c->read(in, verbose)) break;
       
-      if (count++ % stride) continue;
-      if (c->time < tmin or c->time > tmax) continue;
+	if (count++ % stride) continue;
+	if (c->time < tmin or c->time > tmax) continue;
 
-      coefs[roundTime(c->time)] = c;
+	coefs[roundTime(c->time)] = c;
+      }
     }
 
     if (coefs.size()) {
@@ -1040,6 +1784,8 @@ namespace CoefClasses
   
   unsigned CylCoefs::WriteH5Times(HighFive::Group& snaps, unsigned count)
   {
+    materialize();
+
     for (auto c : coefs) {
       auto C = c.second;
       
@@ -1077,6 +1823,8 @@ namespace CoefClasses
   
   void CylCoefs::dump(int mmin, int mmax, int nmin, int nmax)
   {
+    materialize();
+
     
     for (auto c : coefs) {
 
@@ -1102,37 +1850,28 @@ namespace CoefClasses
     
   }
   
+  Eigen::VectorXd CylCoefs::powerRow(CoefStrPtr coef, int min, int max)
+  {
+    auto p = std::dynamic_pointer_cast<CylStruct>(coef);
+    int mmax = p->mmax, nmax = p->nmax;
+    Eigen::Map<const Eigen::MatrixXcd> cof(p->store.data(), mmax+1, nmax);
+
+    int nbeg = std::max<int>(0, min), nend = std::min<int>(nmax, max);
+    if (nend <= nbeg) return Eigen::VectorXd::Zero(mmax+1);
+
+    return cof.middleCols(nbeg, nend-nbeg).rowwise().squaredNorm();
+  }
+
   Eigen::MatrixXd& CylCoefs::Power(int min, int max)
   {
-    if (coefs.size()) {
-      
-      int mmax = coefs.begin()->second->mmax;
-      int nmax = coefs.begin()->second->nmax;
-      
-      power.resize(coefs.size(), mmax+1);
-      power.setZero();
-      
-      int T=0;
-      for (auto v : coefs) {
-	for (int m=0; m<=mmax; m++) {
-	  auto rad = (*v.second->coefs).row(m);
-	  for (int n=std::max<int>(0, min); n<std::min<int>(nmax, max); n++) {
-	    double val = std::abs(rad(n));
-	    power(T, m) += val * val;
-	  }
-	}
-	T++;
-      }
-    } else {
-      power.resize(0, 0);
-    }
-    
-    return power;
+    return cachedPower(min, max);
   }
   
   std::tuple<Eigen::MatrixXd&, Eigen::MatrixXd&>
   CylCoefs::EvenOddPower(int nodd, int min, int max)
   {
+    materialize();
+
     if (coefs.size()) {
       
       if (nodd<0) {
@@ -1174,10 +1913,14 @@ namespace CoefClasses
       powerO.resize(coefs.size(), mmax+1);
       powerO.setZero();
       
-      int T=0;
-      for (auto v : coefs) {
+      // Read the snapshots from the contiguous series
+      //
+      auto & S = getSeries();
+
+      for (int T=0; T<S.rows(); T++) {
+	Eigen::Map<const Eigen::MatrixXcd> cof(S.data() + T*S.cols(), mmax+1, nmax);
 	for (int m=0; m<=mmax; m++) {
-	  auto rad = (*v.second->coefs).row(m);
+	  auto rad = cof.row(m);
 	  // Even
 	  for (int n=std::max<int>(0, min); n<std::min<int>(nmax-nodd, max); n++) {
 	    double val = std::abs(rad(n));
@@ -1189,7 +1932,6 @@ namespace CoefClasses
 	    powerO(T, m) += val * val;
 	  }
 	}
-	T++;
       }
     } else {
       powerE.resize(0, 0);
@@ -1269,6 +2011,8 @@ namespace CoefClasses
 
   void SlabCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -1276,6 +2020,7 @@ namespace CoefClasses
       str << "CylCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::SlabStruct::coefType>
 	(it->second->store.data(), 2*NmaxX+1, 2*NmaxY+1, NmaxZ);
@@ -1284,6 +2029,8 @@ namespace CoefClasses
 
   void SlabCoefs::setTensor(double time, const Eigen3d& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -1621,6 +2368,8 @@ namespace CoefClasses
 
   void CubeCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -1628,6 +2377,7 @@ namespace CoefClasses
       str << "CubeCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::CubeStruct::coefType>
 	(it->second->store.data(), 2*NmaxX+1, 2*NmaxY+1, 2*NmaxZ+1);
@@ -1636,6 +2386,8 @@ namespace CoefClasses
 
   void CubeCoefs::setTensor(double time, const Eigen3d& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -2009,6 +2761,8 @@ namespace CoefClasses
   
   void TrajectoryData::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -2016,6 +2770,7 @@ namespace CoefClasses
       str << "TrajectoryData::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::TrajStruct::coefType>
 	(it->second->store.data(), it->second->traj, it->second->rank);
@@ -2255,6 +3010,8 @@ namespace CoefClasses
   
   void TableData::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -2262,6 +3019,7 @@ namespace CoefClasses
       str << "TableData::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<CoefClasses::TblStruct::coefType>
 	(it->second->store.data(), dat.size());
@@ -2391,7 +3149,7 @@ namespace CoefClasses
 
 
   std::shared_ptr<Coefs> Coefs::factory
-  (const std::string& file, int stride, double tmin, double tmax)
+  (const std::string& file, int stride, double tmin, double tmax, bool lazy)
   {
     std::shared_ptr<Coefs> coefs;
     
@@ -2418,9 +3176,11 @@ namespace CoefClasses
 	//
 	if (h5file.hasAttribute("forceID")) {
 	  if (geometry.compare("sphere")==0) {
-	    coefs = std::make_shared<SphCoefs>(h5file, stride, tmin, tmax);
+	    coefs = std::make_shared<SphCoefs>(h5file, stride, tmin, tmax,
+					       false, lazy);
 	  } else if (geometry.compare("cylinder")==0) {
-	    coefs = std::make_shared<CylCoefs>(h5file, stride, tmin, tmax);
+	    coefs = std::make_shared<CylCoefs>(h5file, stride, tmin, tmax,
+					       false, lazy);
 	  } else if (geometry.compare("slab")==0) {
 	    coefs = std::make_shared<SlabCoefs>(h5file, stride, tmin, tmax);
 	  } else if (geometry.compare("cube")==0) {
@@ -2449,6 +3209,8 @@ namespace CoefClasses
 	throw std::runtime_error(msg + err.what());
       }
 	
+      if (coefs and coefs->h5make) coefs->h5source = file;
+
       return coefs;
       
     } catch (HighFive::Exception& err) {
@@ -2531,40 +3293,41 @@ namespace CoefClasses
   {
     bool ret = true;
     
-    auto other = dynamic_cast<CylCoefs*>(check.get());
+    auto other = std::dynamic_pointer_cast<CylCoefs>(check);
+    if (not other) {
+      std::cout << "Other coefficients are not cylindrical" << std::endl;
+      return false;
+    }
     
+    // Snapshots are compared one at a time, so either set may be
+    // lazy and neither is read into memory as a whole
+    //
+    auto has = [other](double t)
+    {
+      if (other->lazy) return other->lazy->find(t) >= 0;
+      return other->coefs.find(t) != other->coefs.end();
+    };
+
     // Check that every time in this one is in the other
     //
-    for (auto v : coefs) {
-      if (other->coefs.find(v.first) == other->coefs.end()) {
-	std::cout << "Can't find Time=" << v.first << std::endl;
+    auto T = Times();
+    for (auto t : T) {
+      if (not has(roundTime(t))) {
+	std::cout << "Can't find Time=" << t << std::endl;
 	ret = false;
       }
     }
     
     if (ret) {
-      std::cout << "Times are the same, now checking parameters at each time"
-		<< std::endl;
-      for (auto v : coefs) {
-	auto it = other->coefs.find(v.first);
-	if (v.second->mmax != it->second->mmax) ret = false;
-	if (v.second->nmax != it->second->nmax) ret = false;
-	if (v.second->time != it->second->time) ret = false;
-      }
-    }
-    
-    if (ret) {
-      std::cout << "Parameters are the same, now checking coefficients time"
-		<< std::endl;
-      for (auto v : coefs) {
-	auto it = other->coefs.find(v.first);
-	for (int m=0; m<v.second->mmax; m++) {
-	  for (int n=0; n<v.second->nmax; n++) { 
-	    if ((*v.second->coefs)(m, n) != (*it->second->coefs)(m, n)) {
-	      ret = false;
-	    }
-	  }
+      std::cout << "Times are the same, now checking parameters and "
+		<< "coefficients at each time" << std::endl;
+      for (auto t : T) {
+	auto a = lookup(t), b = other->lookup(t);
+	if (a->mmax != b->mmax or a->nmax != b->nmax or a->time != b->time) {
+	  ret = false;
+	  continue;
 	}
+	if (*a->coefs != *b->coefs) ret = false;
       }
     }
     
@@ -2574,11 +3337,22 @@ namespace CoefClasses
   void Coefs::WriteH5Coefs(const std::string& prefix)
   {
     try {
+      // Use the chunked layout if requested and available
+      //
+      bool chunked = h5window>0 and seriesShape().first>0;
+
+      // SWMR needs the latest file format
+      //
+      HighFive::FileAccessProps fapl;
+      if (h5swmr and chunked and h5pcaRank==0 and h5pcaTol==0.0)
+	fapl.add(HighFive::FileVersionBounds(H5F_LIBVER_LATEST,
+					     H5F_LIBVER_LATEST));
+
       // Create a new hdf5 file
       //
       HighFive::File file(prefix,
 			  HighFive::File::ReadWrite |
-			  HighFive::File::Create);
+			  HighFive::File::Create, fapl);
       
       // Write the Version string
       //
@@ -2606,13 +3380,37 @@ namespace CoefClasses
       unsigned count = 0;
       HighFive::DataSet dataset = file.createDataSet("count", count);
       
-      // Create a new group for coefficient snapshots
+      if (h5window>0 and not chunked)
+	std::cerr << "Coefs::WriteH5Coefs: no chunked layout for geometry <"
+		  << geometry << ">, writing snapshots" << std::endl;
+
+      // The compressed archive takes precedence
       //
-      HighFive::Group group = file.createGroup("snapshots");
+      bool pca = (h5pcaRank>0 or h5pcaTol>0.0) and seriesShape().first>0;
+
+      if ((h5pcaRank>0 or h5pcaTol>0.0) and not pca)
+	std::cerr << "Coefs::WriteH5Coefs: no compressed layout for geometry <"
+		  << geometry << ">, writing snapshots" << std::endl;
+
+      if (pca) {
+	std::string layout("pca");
+	file.createAttribute<std::string>("layout", HighFive::DataSpace::From(layout)).write(layout);
+
+	count = WriteH5PCA(file);
+      } else if (chunked) {
+	std::string layout("chunked");
+	file.createAttribute<std::string>("layout", HighFive::DataSpace::From(layout)).write(layout);
+
+	count = WriteH5Series(file, count, true);
+      } else {
+	// Create a new group for coefficient snapshots
+	//
+	HighFive::Group group = file.createGroup("snapshots");
       
-      // Write the coefficients
-      //
-      count = WriteH5Times(group, count);
+	// Write the coefficients
+	//
+	count = WriteH5Times(group, count);
+      }
       
       // Update the count
       //
@@ -2624,24 +3422,274 @@ namespace CoefClasses
     
   }
   
+  unsigned Coefs::WriteH5Series(HighFive::File& file, unsigned count,
+			       bool create)
+  {
+    materialize();
+
+    int rows, cols;
+    std::tie(rows, cols) = seriesShape();
+
+    const size_t U = HighFive::DataSpace::UNLIMITED, C = cols;
+
+    if (create) {
+      HighFive::Group series = file.createGroup("series");
+
+      series.createAttribute<int>("rows", HighFive::DataSpace::From(rows)).write(rows);
+      series.createAttribute<int>("cols", HighFive::DataSpace::From(cols)).write(cols);
+      series.createAttribute<unsigned>("window", HighFive::DataSpace::From(h5window)).write(h5window);
+
+      // Extendible in time, chunked by time window
+      //
+      auto extendible = [&](HighFive::Group& grp, const std::string& name,
+			std::vector<size_t> dims)
+      {
+	std::vector<size_t> maxdims(dims);
+	std::vector<hsize_t> chunk {h5window};
+	chunk.insert(chunk.end(), dims.begin(), dims.end());
+	dims   .insert(dims   .begin(), 0);
+	maxdims.insert(maxdims.begin(), U);
+
+	HighFive::DataSetCreateProps props;
+	props.add(HighFive::Chunking(chunk));
+	if (h5deflate) {
+	  props.add(HighFive::Shuffle());
+	  props.add(HighFive::Deflate(h5deflate));
+	}
+
+	grp.createDataSet<double>(name, HighFive::DataSpace(dims, maxdims), props);
+      };
+
+      extendible(series, "time",   {});
+      extendible(series, "center", {3});
+
+      HighFive::Group harm = series.createGroup("coefficients");
+      for (int r=0; r<rows; r++) extendible(harm, std::to_string(r), {C, 2});
+    }
+
+    HighFive::Group series = file.getGroup("series");
+
+    int frows, fcols;
+    series.getAttribute("rows").read(frows);
+    series.getAttribute("cols").read(fcols);
+
+    if (frows != rows or fcols != cols)
+      throw CoefsError("Coefs::WriteH5Series: coefficient shape does not "
+		       "match the H5 file");
+
+    // Gather the new snapshots
+    //
+    std::vector<CoefStrPtr> snaps;
+    for (auto t : Times()) snaps.push_back(peek(t));
+
+    const size_t n = snaps.size();
+    if (n==0) return count;
+
+    std::vector<double> time(n), ctr(3*n, 0.0), buf(2*n*C);
+
+    for (size_t t=0; t<n; t++) {
+      if (snaps[t]->store.size() != rows*cols)
+	throw CoefsError("Coefs::WriteH5Series: snapshots differ in size");
+      time[t] = snaps[t]->time;
+      if (snaps[t]->ctr.size()==3)
+	std::copy(snaps[t]->ctr.begin(), snaps[t]->ctr.end(), &ctr[3*t]);
+    }
+
+    // Extend by n rows and write them
+    //
+    auto append = [&](HighFive::DataSet ds, std::vector<size_t> dims,
+		      const std::vector<double>& v)
+    {
+      std::vector<size_t> offs(dims.size()+1, 0), size(dims);
+      offs[0] = count;
+      dims.insert(dims.begin(), n);
+      size.insert(size.begin(), count + n);
+
+      ds.resize(size);
+      ds.select(offs, dims).write_raw(v.data(), HighFive::AtomicType<double>());
+    };
+
+    append(series.getDataSet("time"),   {},  time);
+    append(series.getDataSet("center"), {3}, ctr );
+
+    HighFive::Group harm = series.getGroup("coefficients");
+
+    for (int r=0; r<rows; r++) {
+      for (size_t t=0; t<n; t++) {
+	for (int c=0; c<cols; c++) {
+	  auto v = snaps[t]->store(c*rows + r);
+	  buf[2*(t*C+c)  ] = v.real();
+	  buf[2*(t*C+c)+1] = v.imag();
+	}
+      }
+      append(harm.getDataSet(std::to_string(r)), {C, 2}, buf);
+    }
+
+    return count + n;
+  }
+
+  unsigned Coefs::WriteH5PCA(HighFive::File& file)
+  {
+    materialize();
+
+    // Gather the snapshots
+    //
+    std::vector<CoefStrPtr> snaps;
+    for (auto t : Times()) snaps.push_back(peek(t));
+
+    const size_t T = snaps.size();
+    if (T==0)
+      throw CoefsError("Coefs::WriteH5PCA: no snapshots to archive");
+
+    const size_t D = snaps[0]->store.size();
+
+    Eigen::MatrixXcd X(T, D);
+    std::vector<double> time(T), ctr(3*T, 0.0), residual(T);
+
+    for (size_t t=0; t<T; t++) {
+      if (snaps[t]->store.size() != D)
+	throw CoefsError("Coefs::WriteH5PCA: snapshots differ in size");
+      X.row(t) = snaps[t]->store.transpose();
+      time[t]  = snaps[t]->time;
+      if (snaps[t]->ctr.size()==3)
+	std::copy(snaps[t]->ctr.begin(), snaps[t]->ctr.end(), &ctr[3*t]);
+    }
+
+    // Remove the mean and factor the remainder
+    //
+    Eigen::VectorXcd mean = X.colwise().mean().transpose();
+    X.rowwise() -= mean.transpose();
+
+    Eigen::BDCSVD<Eigen::MatrixXcd> svd(X, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    Eigen::VectorXd S = svd.singularValues();
+
+    // Rank from the tolerance and the cap
+    //
+    double total = S.squaredNorm();
+    size_t K = S.size();
+    if (h5pcaTol>0.0 and total>0.0) {
+      double tail = total;
+      for (K=0; K<static_cast<size_t>(S.size()); K++) {
+	if (tail <= h5pcaTol*h5pcaTol*total) break;
+	tail -= S(K)*S(K);
+      }
+    }
+    if (h5pcaRank>0) K = std::min<size_t>(K, h5pcaRank);
+    K = std::max<size_t>(std::min<size_t>(1, S.size()), K);
+
+    Eigen::MatrixXcd basis   = svd.matrixV().leftCols(K).adjoint();
+    Eigen::MatrixXcd weights = svd.matrixU().leftCols(K) * S.head(K).asDiagonal();
+
+    double retained = total>0.0 ? S.head(K).squaredNorm()/total : 1.0;
+
+    // Residual of each snapshot
+    //
+    for (size_t t=0; t<T; t++)
+      residual[t] = (X.row(t) - weights.row(t)*basis).norm();
+
+    // Write
+    //
+    HighFive::Group grp = file.createGroup("pca");
+
+    int rows, cols;
+    std::tie(rows, cols) = seriesShape();
+
+    unsigned rank = K;
+    grp.createAttribute<int>("rows", HighFive::DataSpace::From(rows)).write(rows);
+    grp.createAttribute<int>("cols", HighFive::DataSpace::From(cols)).write(cols);
+    grp.createAttribute<unsigned>("rank", HighFive::DataSpace::From(rank)).write(rank);
+    grp.createAttribute<double>("retained", HighFive::DataSpace::From(retained)).write(retained);
+    grp.createAttribute<double>("tolerance", HighFive::DataSpace::From(h5pcaTol)).write(h5pcaTol);
+
+    auto create = [&](const std::string& name, std::vector<size_t> dims,
+		      const double* v)
+    {
+      HighFive::DataSetCreateProps props;
+      if (h5deflate) {
+	std::vector<hsize_t> chunk(dims.begin(), dims.end());
+	chunk[0] = std::min<hsize_t>(chunk[0], 1024);
+	props.add(HighFive::Chunking(chunk));
+	props.add(HighFive::Shuffle());
+	props.add(HighFive::Deflate(h5deflate));
+      }
+      grp.createDataSet<double>(name, HighFive::DataSpace(dims), props)
+	.write_raw(v, HighFive::AtomicType<double>());
+    };
+
+    // Row-major copies of the complex matrices as (real, imag) pairs
+    //
+    auto pairs = [](const Eigen::MatrixXcd& m)
+    {
+      std::vector<double> v(2*m.size());
+      for (Eigen::Index i=0; i<m.rows(); i++)
+	for (Eigen::Index j=0; j<m.cols(); j++) {
+	  v[2*(i*m.cols()+j)  ] = m(i, j).real();
+	  v[2*(i*m.cols()+j)+1] = m(i, j).imag();
+	}
+      return v;
+    };
+
+    create("time",     {T},       time.data());
+    create("center",   {T, 3},    ctr.data());
+    create("residual", {T},       residual.data());
+    create("mean",     {D, 2},    pairs(mean).data());
+    create("basis",    {K, D, 2}, pairs(basis).data());
+    create("weights",  {T, K, 2}, pairs(weights).data());
+
+    if (verbose)
+      std::cout << "Coefs::WriteH5PCA: " << T << " snapshots, " << K
+		<< " of " << S.size() << " components, retaining "
+		<< retained << " of the variance" << std::endl;
+
+    return T;
+  }
+
   void Coefs::ExtendH5Coefs(const std::string& prefix)
   {
     try {
       // Open an hdf5 file
       //
-      HighFive::File file(prefix, HighFive::File::ReadWrite);
+      HighFive::FileAccessProps fapl;
+      if (h5swmr)
+	fapl.add(HighFive::FileVersionBounds(H5F_LIBVER_LATEST,
+					     H5F_LIBVER_LATEST));
+
+      HighFive::File file(prefix, HighFive::File::ReadWrite, fapl);
       
+      // Append in the layout of the file
+      //
+      std::string layout;
+      if (file.hasAttribute("layout"))
+	file.getAttribute("layout").read(layout);
+
+      if (layout == "pca")
+	throw CoefsError("Coefs::ExtendH5Coefs: <" + prefix + "> is a "
+			 "compressed archive, which cannot be extended");
+
+      // Switch to SWMR writing before any object is opened; the
+      // chunked layout only extends and writes existing datasets
+      //
+      if (h5swmr and layout == "chunked") {
+	if (H5Fstart_swmr_write(file.getId()) < 0)
+	  std::cerr << "Coefs::ExtendH5Coefs: could not start SWMR writing "
+		    << "for <" << prefix << ">" << std::endl;
+      }
+
       // Get the dataset
       HighFive::DataSet dataset = file.getDataSet("count");
       
       unsigned count;
       dataset.read(count);
       
-      HighFive::Group group = file.getGroup("snapshots");
+      if (layout == "chunked") {
+	count = WriteH5Series(file, count, false);
+      } else {
+	HighFive::Group group = file.getGroup("snapshots");
       
-      // Write the coefficients
-      //
-      count = WriteH5Times(group, count);
+	// Write the coefficients
+	//
+	count = WriteH5Times(group, count);
+      }
       
       // Update the count
       //
@@ -2653,8 +3701,170 @@ namespace CoefClasses
     
   }
   
+  unsigned Coefs::refresh()
+  {
+    if (h5source.empty() or not h5make)
+      throw CoefsError("Coefs::refresh: coefficients were not read from "
+		       "a spherical or cylindrical H5 file");
+
+    std::vector<CoefStrPtr> snaps;
+
+    // A compressed archive is written once
+    //
+    if (h5pca) return 0;
+
+    if (h5chunked) {
+      snaps = refreshSeries();
+    } else {
+      try {
+	HighFive::SilenceHDF5 quiet;
+	HighFive::File file(h5source, HighFive::File::ReadOnly);
+
+	unsigned count;
+	file.getDataSet("count").read(count);
+
+	auto group = file.getGroup("snapshots");
+
+	for (; h5next<count; h5next+=h5stride) {
+	  std::ostringstream sout;
+	  sout << std::setw(8) << std::setfill('0') << std::right << h5next;
+
+	  auto stanza = group.getGroup(sout.str());
+
+	  double Time;
+	  stanza.getAttribute("Time").read(Time);
+
+	  if (Time < h5tmin or Time > h5tmax) continue;
+
+	  snaps.push_back(h5reader(stanza));
+	}
+      }
+      catch (HighFive::Exception& err) {
+	// The writer holds the file; try again later
+	return 0;
+      }
+    }
+
+    for (auto & c : snaps) add(c);
+
+    return snaps.size();
+  }
+
+  //! Close an HDF5 C API identifier on leaving scope
+  struct H5Handle
+  {
+    hid_t id;
+    herr_t (*close)(hid_t);
+    H5Handle(hid_t id, herr_t (*close)(hid_t)) : id(id), close(close) {}
+    H5Handle(H5Handle&& p) noexcept : id(p.id), close(p.close) { p.id = -1; }
+    H5Handle(const H5Handle&) = delete;
+    ~H5Handle() { if (id >= 0) close(id); }
+    operator hid_t() const { return id; }
+  };
+
+  std::vector<CoefStrPtr> Coefs::refreshSeries()
+  {
+    std::vector<CoefStrPtr> ret;
+
+    HighFive::SilenceHDF5 quiet;
+
+    // SWMR read mode if the writer is in SWMR write mode; this fails
+    // for files that are not in the latest format
+    //
+    H5Handle file(H5Fopen(h5source.c_str(),
+			  H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, H5P_DEFAULT),
+		  H5Fclose);
+    if (file < 0)
+      file.id = H5Fopen(h5source.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file < 0) return ret;	// The writer holds the file
+
+    int rows, cols;
+    {
+      H5Handle a(H5Aopen_by_name(file, "series", "rows",
+				 H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+      H5Handle b(H5Aopen_by_name(file, "series", "cols",
+				 H5P_DEFAULT, H5P_DEFAULT), H5Aclose);
+      if (a < 0 or b < 0 or
+	  H5Aread(a, H5T_NATIVE_INT, &rows) < 0 or
+	  H5Aread(b, H5T_NATIVE_INT, &cols) < 0)
+	throw CoefsError("Coefs::refresh: no series in <" + h5source + ">");
+    }
+
+    // The count is written last, so rows below it are complete
+    //
+    unsigned count = 0;
+    {
+      H5Handle ds(H5Dopen2(file, "count", H5P_DEFAULT), H5Dclose);
+      if (ds < 0 or H5Dread(ds, H5T_NATIVE_UINT, H5S_ALL, H5S_ALL,
+			    H5P_DEFAULT, &count) < 0) return ret;
+    }
+
+    if (h5next >= count) return ret;
+
+    std::vector<H5Handle> harm;
+    H5Handle time  (H5Dopen2(file, "series/time",   H5P_DEFAULT), H5Dclose);
+    H5Handle center(H5Dopen2(file, "series/center", H5P_DEFAULT), H5Dclose);
+    for (int r=0; r<rows; r++) {
+      std::string name = "series/coefficients/" + std::to_string(r);
+      harm.emplace_back(H5Dopen2(file, name.c_str(), H5P_DEFAULT), H5Dclose);
+    }
+
+    // Read n rows from lo of a dataset with trailing dimensions tail
+    //
+    auto read = [](hid_t ds, hsize_t lo, hsize_t n,
+		   std::vector<hsize_t> tail, double* buf)
+    {
+      std::vector<hsize_t> offs(tail.size()+1, 0), size(tail);
+      offs[0] = lo;
+      size.insert(size.begin(), n);
+
+      H5Handle fsp(H5Dget_space(ds), H5Sclose);
+      H5Handle msp(H5Screate_simple(size.size(), size.data(), nullptr),
+		   H5Sclose);
+      if (H5Sselect_hyperslab(fsp, H5S_SELECT_SET, offs.data(), nullptr,
+			      size.data(), nullptr) < 0 or
+	  H5Dread(ds, H5T_NATIVE_DOUBLE, msp, fsp, H5P_DEFAULT, buf) < 0)
+	throw CoefsError("Coefs::refresh: could not read the series");
+    };
+
+    const hsize_t C = cols;
+
+    // Read the new rows a block at a time
+    //
+    for (hsize_t lo=h5next; lo<count; lo+=lazyBlock) {
+      hsize_t n = std::min<hsize_t>(lazyBlock, count - lo);
+
+      std::vector<double> tt(n), ctr(3*n), buf(2*n*C);
+      read(time,   lo, n, {},  tt.data());
+      read(center, lo, n, {3}, ctr.data());
+
+      std::vector<Eigen::VectorXcd> store(n, Eigen::VectorXcd(rows*cols));
+
+      for (int r=0; r<rows; r++) {
+	read(harm[r], lo, n, {C, 2}, buf.data());
+	for (hsize_t t=0; t<n; t++) {
+	  const double *v = &buf[2*C*t];
+	  for (int c=0; c<cols; c++)
+	    store[t](c*rows + r) = {v[2*c], v[2*c+1]};
+	}
+      }
+
+      for (; h5next<lo+n; h5next+=h5stride) {
+	hsize_t t = h5next - lo;
+	if (tt[t] < h5tmin or tt[t] > h5tmax) continue;
+	std::vector<double> c(&ctr[3*t], &ctr[3*t+3]);
+	ret.push_back(h5make(tt[t], c, store[t]));
+      }
+    }
+
+    return ret;
+  }
+
   void CylCoefs::add(CoefStrPtr coef)
   {
+    materialize();
+    invalidate(coef->time);
+
     auto p = std::dynamic_pointer_cast<CylStruct>(coef);
     if (not p) throw std::runtime_error("CylCoefs::add: Null coefficient structure, nothing added!");
 
@@ -2665,6 +3875,8 @@ namespace CoefClasses
 
   void CubeCoefs::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<CubeStruct>(coef);
     if (not p) throw std::runtime_error("CubeCoefs::add: Null coefficient structure, nothing added!");
 
@@ -2676,6 +3888,8 @@ namespace CoefClasses
 
   void SlabCoefs::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<SlabStruct>(coef);
     if (not p) throw std::runtime_error("SlabCoefs::add: Null coefficient structure, nothing added!");
 
@@ -2687,6 +3901,8 @@ namespace CoefClasses
 
   void TableData::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<TblStruct>(coef);
     if (not p) throw std::runtime_error("TableData::add: Null coefficient structure, nothing added!");
 
@@ -2695,6 +3911,8 @@ namespace CoefClasses
 
   void TrajectoryData::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<TrajStruct>(coef);
     if (not p) throw std::runtime_error("TrajectoryData::add: Null coefficient structure, nothing added!");
 
@@ -2704,6 +3922,8 @@ namespace CoefClasses
 
   void SphFldCoefs::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<SphFldStruct>(coef);
     Nfld = p->nfld;
     Lmax = p->lmax;
@@ -2713,6 +3933,8 @@ namespace CoefClasses
 
   void CylFldCoefs::add(CoefStrPtr coef)
   {
+    invalidate();
+
     auto p = std::dynamic_pointer_cast<CylFldStruct>(coef);
     if (not p) throw std::runtime_error("CylFldCoefs::add: Null coefficient structure, nothing added!");
 
@@ -2753,6 +3975,8 @@ namespace CoefClasses
   
   void SphFldCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -2760,6 +3984,7 @@ namespace CoefClasses
       str << "SphFldCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<SphFldStruct::coefType>
 	(it->second->store.data(), Nfld, (Lmax+1)*(Lmax+2)/2, Nmax);
@@ -2768,6 +3993,8 @@ namespace CoefClasses
   
   void SphFldCoefs::setMatrix(double time, SphFldStruct::dataType& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -2775,6 +4002,7 @@ namespace CoefClasses
       str << "SphFldCoefs::setMatrix: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->allocate();
       *it->second->coefs = dat;
     }
@@ -3192,6 +4420,8 @@ namespace CoefClasses
   
   void CylFldCoefs::setData(double time, Eigen::VectorXcd& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -3199,6 +4429,7 @@ namespace CoefClasses
       str << "CylFldCoefs::setData: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->store = dat;
       it->second->coefs = std::make_shared<SphFldStruct::coefType>
 	(it->second->store.data(), Nfld, Mmax+1, Nmax);
@@ -3207,6 +4438,8 @@ namespace CoefClasses
   
   void CylFldCoefs::setMatrix(double time, CylFldStruct::dataType& dat)
   {
+    invalidate();
+
     auto it = coefs.find(roundTime(time));
 
     if (it == coefs.end()) {
@@ -3214,6 +4447,7 @@ namespace CoefClasses
       str << "CylFldCoefs::setMatrix: requested time=" << time << " not found";
       throw std::runtime_error(str.str());
     } else {
+      unshare(it->second, it->first);
       it->second->allocate();
       *it->second->coefs = dat;
     }
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <cmath>
+
+#include <CrossValidation.H>
+
+namespace BasisClasses
+{
+  CrossValidation::CrossValidation(std::shared_ptr<BiorthBasis> basis,
+				   int npart) : basis(basis), npart(npart)
+  {
+    if (npart < 2)
+      throw std::invalid_argument("CrossValidation: need at least 2 partitions");
+  }
+
+  void CrossValidation::compute(PR::PRptr reader, std::vector<double> ctr)
+  {
+    // Sort this process' particles into partitions in one pass
+    //
+    std::vector<std::vector<double>> m(npart), p(npart);
+    size_t cnt = 0;
+
+    PR::FieldSelection fields(reader, PR::FieldMass | PR::FieldPosition);
+
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+      for (size_t n=0; n<c.size; n++, cnt++) {
+	int j = cnt % npart;
+	m[j].push_back(c.mass[n]);
+	p[j].insert(p[j].end(), c.pos + 3*n, c.pos + 3*n + 3);
+      }
+    }
+
+    // Each process has its own particles, so no round robin
+    //
+    std::vector<CoefClasses::CoefStrPtr> coefs(npart);
+    std::vector<double> mass(npart);
+
+    for (int j=0; j<npart; j++) {
+      Eigen::VectorXd M = Eigen::Map<Eigen::VectorXd>(m[j].data(), m[j].size());
+      RowMatrixXd P = Eigen::Map<RowMatrixXd>(p[j].data(), m[j].size(), 3);
+      std::vector<double>().swap(m[j]);
+      std::vector<double>().swap(p[j]);
+
+      coefs[j] = basis->createFromArray(M, P, reader->CurrentTime(), ctr,
+					false, false)->deepcopy();
+      mass[j]  = M.sum();
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, mass.data(), npart, MPI_DOUBLE, MPI_SUM,
+		  MPI_COMM_WORLD);
+
+    finish(coefs, mass);
+  }
+
+  void CrossValidation::compute(Eigen::VectorXd& mass, RowMatrixXd& pos,
+				double time, std::vector<double> ctr)
+  {
+    const long N = mass.size();
+
+    if (pos.rows() != N or pos.cols() < 3)
+      throw std::invalid_argument("CrossValidation::compute: expected a mass "
+				  "vector and an n x 3 position array");
+
+    std::vector<CoefClasses::CoefStrPtr> coefs(npart);
+    std::vector<double> pmass(npart);
+
+    for (int j=0; j<npart; j++) {
+      long nj = (N - j + npart - 1)/npart;
+      Eigen::VectorXd M(nj);
+      RowMatrixXd P(nj, 3);
+      for (long i=0; i<nj; i++) {
+	M(i) = mass(j + i*npart);
+	P.row(i) = pos.row(j + i*npart).head(3);
+      }
+
+      // Every process holds the full arrays: use round robin
+      //
+      coefs[j] = basis->createFromArray(M, P, time, ctr, true, false)->deepcopy();
+      pmass[j] = M.sum();
+    }
+
+    finish(coefs, pmass);
+  }
+
+  void CrossValidation::finish(std::vector<CoefClasses::CoefStrPtr>& coefs,
+			       std::vector<double>& mass)
+  {
+    // Coefficient labels from the storage layout
+    //
+    int rows, cols;
+
+    if (auto c = std::dynamic_pointer_cast<CoefClasses::SphStruct>(coefs[0])) {
+      rows = c->coefs->rows();
+      cols = c->coefs->cols();
+      hmax = c->lmax;
+      harm.resize(rows);
+      for (int l=0, k=0; l<=c->lmax; l++)
+	for (int m=0; m<=l; m++) harm[k++] = l;
+    }
+    else if (auto c = std::dynamic_pointer_cast<CoefClasses::CylStruct>(coefs[0])) {
+      rows = c->coefs->rows();
+      cols = c->coefs->cols();
+      hmax = c->mmax;
+      harm.resize(rows);
+      for (int m=0; m<rows; m++) harm[m] = m;
+    }
+    else {
+      std::ostringstream sout;
+      sout << "CrossValidation: geometry <" << coefs[0]->geom
+	   << "> is not supported";
+      throw std::runtime_error(sout.str());
+    }
+
+    nmax = cols;
+
+    // Column-major store: row index is the harmonic
+    //
+    const int K = rows*cols;
+    std::vector<int> h(K);
+    rad.resize(K);
+    for (int n=0; n<cols; n++) {
+      for (int r=0; r<rows; r++) {
+	h  [r + rows*n] = harm[r];
+	rad[r + rows*n] = n;
+      }
+    }
+    harm = h;
+
+    // Partition sums
+    //
+    part.resize(K, npart);
+    for (int j=0; j<npart; j++) part.col(j) = coefs[j]->store;
+
+    double mtot = 0.0;
+    for (auto v : mass) mtot += v;
+    if (mtot <= 0.0)
+      throw std::runtime_error("CrossValidation: no mass in the partitions");
+
+    frac.resize(npart);
+    for (int j=0; j<npart; j++) frac(j) = mass[j]/mtot;
+
+    // The total, which is also left installed in the basis
+    //
+    total = coefs[0]->deepcopy();
+    total->store = part.rowwise().sum();
+    basis->set_coefs(total);
+
+    // Training and held-out estimates for each fold, normalized to the
+    // total mass
+    //
+    B.resize(K, npart);
+    E.resize(K, npart);
+    for (int j=0; j<npart; j++) {
+      if (frac(j) <= 0.0 or frac(j) >= 1.0)
+	throw std::runtime_error("CrossValidation: empty partition");
+      B.col(j) = (total->store - part.col(j))/(1.0 - frac(j));
+      E.col(j) = part.col(j)/frac(j);
+    }
+
+    // Signal-to-noise in each fold from the spread of the training
+    // partitions about the training estimate
+    //
+    S.setZero(K, npart);
+    if (npart > 2) {
+      const int m = npart - 1;
+
+#pragma omp parallel for
+      for (int j=0; j<npart; j++) {
+	Eigen::VectorXd var = Eigen::VectorXd::Zero(K);
+	for (int q=0; q<npart; q++) {
+	  if (q==j) continue;
+	  var += (E.col(q) - B.col(j)).cwiseAbs2();
+	}
+	var /= m*(m-1);
+	for (int k=0; k<K; k++)
+	  S(k, j) = var(k) > 0.0 ? std::norm(B(k, j))/var(k) : 0.0;
+      }
+    }
+  }
+
+  Eigen::MatrixXd CrossValidation::truncation()
+  {
+    if (B.size()==0)
+      throw std::runtime_error("CrossValidation::truncation: call compute() first");
+
+    // The weights are 0 or 1 and the same for every fold, so the fold
+    // average may be taken per coefficient
+    //
+    Eigen::VectorXd c =
+      ((B.cwiseAbs2() - 2.0*(B.conjugate().cwiseProduct(E)).real())
+       .rowwise().sum())/npart;
+
+    Eigen::MatrixXd ret = Eigen::MatrixXd::Zero(hmax+1, nmax);
+    for (int k=0; k<c.size(); k++) ret(harm[k], rad[k]) += c(k);
+
+    // Cumulative in both indices
+    //
+    for (int h=0; h<=hmax; h++)
+      for (int n=1; n<nmax; n++) ret(h, n) += ret(h, n-1);
+
+    for (int h=1; h<=hmax; h++) ret.row(h) += ret.row(h-1);
+
+    return ret;
+  }
+
+  Eigen::VectorXd CrossValidation::snr(const std::vector<double>& thresholds,
+				       bool Hall, double Hexp)
+  {
+    if (B.size()==0)
+      throw std::runtime_error("CrossValidation::snr: call compute() first");
+
+    if (npart < 3)
+      throw std::runtime_error("CrossValidation::snr: need at least 3 partitions");
+
+    const int ns = thresholds.size();
+    const int K  = B.rows();
+
+    // The two terms of the score for each coefficient and fold
+    //
+    Eigen::MatrixXd quad  = B.cwiseAbs2();
+    Eigen::MatrixXd cross = 2.0*(B.conjugate().cwiseProduct(E)).real();
+
+    Eigen::VectorXd ret(ns);
+
+#pragma omp parallel for
+    for (int i=0; i<ns; i++) {
+      double s = thresholds[i], sum = 0.0;
+
+      for (int j=0; j<npart; j++) {
+	for (int k=0; k<K; k++) {
+	  double w;
+	  if (Hall)
+	    w = S(k, j) > 0.0 ? 1.0/(pow(s/S(k, j), Hexp) + 1.0) : 0.0;
+	  else
+	    w = S(k, j) >= s ? 1.0 : 0.0;
+	  sum += w*w*quad(k, j) - w*cross(k, j);
+	}
+      }
+
+      ret(i) = sum/npart;
+    }
+
+    return ret;
+  }
+
+}
@@ -165,6 +165,12 @@ namespace BasisClasses
     //
     ortho = std::make_shared<OrthoFunction>(nmax, densfunc, rmin, rmax, rmapping, dof);
 
+    // Per-thread evaluation storage for accumulation
+    //
+    orthoT.resize(nt);
+    tableT.resize(nt);
+    for (auto & v : orthoT) v.resize(nmax+1);
+
     // Initialize fieldlabels
     //
     fieldLabels.clear();
@@ -311,17 +317,67 @@ namespace BasisClasses
   void FieldBasis::accumulate(double mass,
 			      double x, double y, double z,
 			      double u, double v, double w)
+  {
+    int tid = omp_get_thread_num();
+    const double pos[3] = {x, y, z}, vel[3] = {u, v, w};
+
+    auto & p = orthoT[tid];
+    if (dof==2) ortho->eval(sqrt(x*x + y*y), p);
+    else        ortho->eval(sqrt(x*x + y*y + z*z), p);
+
+    addParticle(tid, mass, pos, vel, p);
+  }
+
+  void FieldBasis::accumulate(int n, const double* mass,
+			      const double* pos, const double* vel)
+  {
+    // Particles per block: large enough to amortize the table
+    // evaluation and small enough for the table to stay in cache
+    //
+    constexpr int block = 256;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int b=0; b<n; b+=block) {
+
+      int tid = omp_get_thread_num();
+      int nb  = std::min<int>(block, n - b);
+
+      // Orthogonal functions for the whole block into this thread's
+      // table, sized on first use
+      //
+      double rad[block];
+      for (int i=0; i<nb; i++) {
+	const double *x = pos + 3*(b + i);
+	double R2 = x[0]*x[0] + x[1]*x[1];
+	rad[i] = sqrt(dof==2 ? R2 : R2 + x[2]*x[2]);
+      }
+
+      auto & tab = tableT[tid];
+      if (tab.rows() < block) tab.resize(block, nmax+1);
+      ortho->eval(rad, nb, tab);
+
+      for (int i=0; i<nb; i++)
+	addParticle(tid, mass[b+i], pos + 3*(b+i), vel + 3*(b+i),
+		    tab.row(i).transpose());
+    }
+  }
+
+  void FieldBasis::addParticle(int tid, double mass,
+			       const double* pos, const double* vel,
+			       const OrthoVector& p)
   {
     constexpr std::complex<double> I(0, 1);
     constexpr double fac0 = 0.25*M_2_SQRTPI;
 
-    int tid = omp_get_thread_num();
-    PS3 pos{x, y, z}, vel{u, v, w};
+    double x = pos[0], y = pos[1], z = pos[2];
 
     // Compute the field value array
     //
     std::vector<double> vec;
-    if (fieldFunc) vec = fieldFunc(mass, pos, vel);
+    if (fieldFunc) {
+      PS3 ps{x, y, z}, vs{vel[0], vel[1], vel[2]};
+      vec = fieldFunc(mass, ps, vs);
+    }
     
     // Compute spherical/polar coordinates
     //
@@ -335,8 +391,6 @@ namespace BasisClasses
 
     if (dof==2) {
       
-      auto p = (*ortho)(R);
-    
       (*coefs[tid])(0, 0, 0) += mass*p(0)*fac0;
 
       for (int m=0; m<=lmax; m++) {
@@ -354,8 +408,6 @@ namespace BasisClasses
       
     } else {
     
-      auto p = (*ortho)(r);
-      
       (*coefs[tid])(0, 0, 0) += mass*p(0);
 
       for (int l=0, lm=0; l<=lmax; l++) {
@@ -394,10 +446,10 @@ namespace BasisClasses
       
     if (use_mpi) {
       MPI_Allreduce(MPI_IN_PLACE, store[0].data(), store[0].size(),
-		    MPI_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+		    MPI_DOUBLE_COMPLEX, MPI_SUM, comm);
 
-      MPI_Allreduce(&usedT[0], &used,      1, MPI_INT,    MPI_SUM, MPI_COMM_WORLD);
-      MPI_Allreduce(&massT[0], &totalMass, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      MPI_Allreduce(&usedT[0], &used,      1, MPI_INT,    MPI_SUM, comm);
+      MPI_Allreduce(&massT[0], &totalMass, 1, MPI_DOUBLE, MPI_SUM, comm);
     } else {
       used = usedT[0];
       totalMass = massT[0];
@@ -530,6 +582,7 @@ namespace BasisClasses
   CoefClasses::CoefStrPtr FieldBasis::createFromReader
   (PR::PRptr reader, std::vector<double> ctr)
   {
+    auto guard = lock();
     CoefClasses::CoefStrPtr coef;
     
     if (dof==3)
@@ -554,29 +607,46 @@ namespace BasisClasses
     //
     if (addCenter) coef->ctr = ctr;
 
-    std::vector<double> pp(3), vv(3);
+    std::vector<double> pp(3), vv(3), mm, xx, uu;
+    ParticleSelector::Mask mask;
 
     reset_coefs();
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+
+      if (psel) mask = psel->select(c);
+
+      // Gather the selected particles of the chunk, centered.  The
+      // selector callback stays on this thread.
+      //
+      mm.clear();
+      xx.clear();
+      uu.clear();
+
+      for (size_t n=0; n<c.size; n++) {
+
+	if (psel and not mask(n)) continue;
 
-      bool use = false;
+	const double *pos = c.pos + 3*n, *vel = c.vel + 3*n;
+	bool use = false;
       
-      if (ftor) {
-	pp.assign(p->pos, p->pos+3);
-	vv.assign(p->vel, p->vel+3);
-	use = ftor(p->mass, pp, vv, p->indx);
-      } else {
-	use = true;
-      }
+	if (ftor) {
+	  pp.assign(pos, pos+3);
+	  vv.assign(vel, vel+3);
+	  use = ftor(c.mass[n], pp, vv, c.indx[n]);
+	} else {
+	  use = true;
+	}
 
-      if (use) accumulate(p->mass,
-			  p->pos[0]-ctr[0],
-			  p->pos[1]-ctr[1],
-			  p->pos[2]-ctr[2],
-			  p->vel[0],
-			  p->vel[1],
-			  p->vel[2]);
+	if (use) {
+	  mm.push_back(c.mass[n]);
+	  for (int k=0; k<3; k++) {
+	    xx.push_back(pos[k] - ctr[k]);
+	    uu.push_back(vel[k]);
+	  }
+	}
+      }
 
+      accumulate(mm.size(), mm.data(), xx.data(), uu.data());
     }
     make_coefs();
     load_coefs(coef, reader->CurrentTime());
@@ -586,6 +656,7 @@ namespace BasisClasses
   // Generate coefficients from a phase-space table
   void FieldBasis::initFromArray(std::vector<double> ctr)
   {
+    auto guard = lock();
     if (dof==3)
       coefret = std::make_shared<CoefClasses::SphFldStruct>();
     else if (dof==2)
@@ -622,6 +693,7 @@ namespace BasisClasses
   void FieldBasis::addFromArray(Eigen::VectorXd& m, RowMatrixXd& p,
 				bool roundrobin, bool posvelrows)
   {
+    auto guard = lock();
     // Sanity check: is coefficient instance created?  This is not
     // foolproof.  It is really up the user to make sure that a call
     // to initFromArray() comes first.
@@ -633,7 +705,18 @@ namespace BasisClasses
       throw std::runtime_error(msg);
     }
 
-    std::vector<double> p1(3), v1(3);
+    std::vector<double> p1(3), v1(3), mm, xx, uu;
+
+    // Gather the selected particles, centered, for the batched
+    // accumulation
+    //
+    auto add = [&](double mass, double x, double y, double z,
+		   double u, double v, double w)
+    {
+      mm.push_back(mass);
+      xx.insert(xx.end(), {x - coefctr[0], y - coefctr[1], z - coefctr[2]});
+      uu.insert(uu.end(), {u, v, w});
+    };
 
     if (posvelrows) {
 
@@ -661,13 +744,8 @@ namespace BasisClasses
 	  }
 	  coefindx++;
 	  
-	  if (use) accumulate(m(n),
-			      p(0, n)-coefctr[0],
-			      p(1, n)-coefctr[1],
-			      p(2, n)-coefctr[2],
-			      p(3, n),
-			      p(4, n),
-			      p(5, n));
+	  if (use) add(m(n), p(0, n), p(1, n), p(2, n),
+		       p(3, n), p(4, n), p(5, n));
 	}
       }
       
@@ -696,16 +774,13 @@ namespace BasisClasses
 	  }
 	  coefindx++;
 	  
-	  if (use) accumulate(m(n),
-			      p(n, 0)-coefctr[0],
-			      p(n, 1)-coefctr[1],
-			      p(n, 2)-coefctr[2], 
-			      p(n, 3),
-			      p(n, 4),
-			      p(n, 5));
+	  if (use) add(m(n), p(n, 0), p(n, 1), p(n, 2),
+		       p(n, 3), p(n, 4), p(n, 5));
 	}
       }
     }
+
+    accumulate(mm.size(), mm.data(), xx.data(), uu.data());
   }
 
   std::vector<double> cylVel(double mass,
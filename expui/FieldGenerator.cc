@@ -2,12 +2,20 @@
 #include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <future>
+#include <tuple>
+#include <array>
 #include <cctype>
 #include <string>
 
+#include <hdf5.h>
+#include <highfive/highfive.hpp>
+
 #include <FieldGenerator.H>
-#include <DataGrid.H>
+#include <VtiGrid.H>
+#include <writePVD.H>
 #include <localmpi.H>
+#include <omp.h>
 
 // Verbose output for checking stack usage
 #ifdef DEBUG
@@ -84,11 +92,19 @@ namespace Field
     }
   }
   
+  std::pair<int, int> FieldGenerator::timeBlock(int part, int nparts) const
+  {
+    const long n = times.size();
+    return {part*n/nparts, (part+1)*n/nparts};
+  }
+
   std::map<double, std::map<std::string, Eigen::VectorXf>>
   FieldGenerator::lines
   (BasisClasses::BasisPtr basis, CoefClasses::CoefsPtr coefs,
    std::vector<double> beg, std::vector<double> end, int num)
   {
+    auto guard = basis->lock();
+
     // Check
     //
     if (beg.size()!=3 or end.size()!=3) {
@@ -124,56 +140,55 @@ namespace Field
     for (int k=0; k<3; k++) dd[k] = (end[k] - beg[k])/(num-1);
     double dlen = sqrt(dd[0]*dd[0] + dd[1]*dd[1] + dd[2]*dd[2]);
 
-    for (int icnt=0; icnt<times.size(); icnt++) {
+    auto [tbeg, tend] = timeBlock(myid, numprocs);
 
-      if (icnt % numprocs == myid) {
-      
-	double T = times[icnt];
+    for (int icnt=tbeg; icnt<tend; icnt++) {
 
-	if (not coefs->getCoefStruct(T)) {
-	  std::cout << "Could not find time=" << T << ", continuing"
-		    << std::endl;
-	  continue;
-	}
+      double T = times[icnt];
+
+      if (not coefs->getCoefStruct(T)) {
+	std::cout << "Could not find time=" << T << ", continuing"
+		  << std::endl;
+	continue;
+      }
 
-	basis->set_coefs(coefs->getCoefStruct(T));
+      basis->set_coefs(coefs->getCoefStruct(T));
+
+      double r, phi, costh, R;
+      double p0, p1, d0, d1, f1, f2, f3;
 
-	double r, phi, costh, R;
-	double p0, p1, d0, d1, f1, f2, f3;
-      
 #pragma omp parallel for
-	for (int ncnt=0; ncnt<num; ncnt++) {
-
-	  double x = beg[0] + dd[0]*ncnt;
-	  double y = beg[1] + dd[1]*ncnt;
-	  double z = beg[2] + dd[2]*ncnt;
-	  
-	  std::vector<double> v;
-
-	  if (ctype == BasisClasses::Basis::Coord::Spherical) {
-	    r     = sqrt(x*x + y*y + z*z) + 1.0e-18;
-	    costh = z/r;
-	    phi   = atan2(y, x);
-	    v = (*basis)(r, costh, phi, ctype);
-	  } else if (ctype == BasisClasses::Basis::Coord::Cylindrical) {
-	    R     = sqrt(x*x + y*y) + 1.0e-18;
-	    phi   = atan2(y, x);
-	    v = (*basis)(R, z, phi, ctype);
-	  } else {		// A default
-	    ctype = BasisClasses::Basis::Coord::Cartesian;
-	    v = (*basis)(x, y, z, ctype);
-	  }
-	  
-	  frame["x"      ](ncnt) = x;
-	  frame["y"      ](ncnt) = y;
-	  frame["z"      ](ncnt) = z;
-	  frame["arc"    ](ncnt) = dlen*ncnt;
+      for (int ncnt=0; ncnt<num; ncnt++) {
+
+	double x = beg[0] + dd[0]*ncnt;
+	double y = beg[1] + dd[1]*ncnt;
+	double z = beg[2] + dd[2]*ncnt;
+
+	std::vector<double> v;
 
-	  for (int n=0; n<labels.size(); n++) frame[labels[n]](ncnt) = v[n];
+	if (ctype == BasisClasses::Basis::Coord::Spherical) {
+	  r     = sqrt(x*x + y*y + z*z) + 1.0e-18;
+	  costh = z/r;
+	  phi   = atan2(y, x);
+	  v = (*basis)(r, costh, phi, ctype);
+	} else if (ctype == BasisClasses::Basis::Coord::Cylindrical) {
+	  R     = sqrt(x*x + y*y) + 1.0e-18;
+	  phi   = atan2(y, x);
+	  v = (*basis)(R, z, phi, ctype);
+	} else {		// A default
+	  ctype = BasisClasses::Basis::Coord::Cartesian;
+	  v = (*basis)(x, y, z, ctype);
 	}
 
-	ret[T] = frame;
+	frame["x"      ](ncnt) = x;
+	frame["y"      ](ncnt) = y;
+	frame["z"      ](ncnt) = z;
+	frame["arc"    ](ncnt) = dlen*ncnt;
+
+	for (int n=0; n<labels.size(); n++) frame[labels[n]](ncnt) = v[n];
       }
+
+      ret[T] = frame;
     }
     
     if (use_mpi) {
@@ -227,6 +242,7 @@ namespace Field
 	    for (int k=0; k<nf; k++) {
 	      MPI_Probe(n, 203, MPI_COMM_WORLD, &status);
 	      MPI_Get_count(&status, MPI_CHAR, &l);
+	      bf.resize(l);
 	      MPI_Recv(bf.data(), l, MPI_CHAR, n, 203, MPI_COMM_WORLD, &status);
 
 	      // Sanity check on the field name
@@ -329,6 +345,8 @@ namespace Field
   FieldGenerator::slices(BasisClasses::BasisPtr basis,
 			 CoefClasses::CoefsPtr coefs)
   {
+    auto guard = basis->lock();
+
     // Set midplane evaluation parameters
     //
     basis->setMidplane(midplane);
@@ -372,16 +390,28 @@ namespace Field
     if (i1<0 or i2<0 or i3<0)
       throw std::runtime_error("FieldGenerator::slices: bad grid specification");
 
-    int ncnt = 0;		// Process counter for MPI
-
     std::map<std::string, Eigen::MatrixXf> frame;
     for (auto label : labels) {
       frame[label].resize(grid[i1], grid[i2]);
     }	
 
-    for (auto T : times) {
+    // Grid axes for the batched evaluation
+    //
+    std::vector<std::vector<double>> axes(3);
+    for (int n=0; n<3; n++) {
+      if (n==i3) axes[n].push_back(pos[n]);
+      else {
+	for (int i=0; i<grid[n]; i++) axes[n].push_back(pmin[n] + del[n]*i);
+      }
+    }
+
+    std::vector<Eigen::Tensor<float, 3>> block;
 
-      if (ncnt++ % numprocs > 0) continue;
+    auto [tbeg, tend] = timeBlock(myid, numprocs);
+
+    for (int icnt=tbeg; icnt<tend; icnt++) {
+
+      double T = times[icnt];
 
       if (not coefs->getCoefStruct(T)) {
 	std::cout << "Could not find time=" << T << ", continuing" << std::endl;
@@ -390,53 +420,21 @@ namespace Field
 
       basis->set_coefs(coefs->getCoefStruct(T));
 
-      int totpix = grid[i1] * grid[i2];
-
-#pragma omp parallel for
-      for (int k=0; k<totpix; k++) {
-
-	// Create the pair of indices from the pixel number
-	//
-	int i = k/grid[i2];
-	int j = k - i*grid[i2];
-
-	// Compute the coordinates from the indices
-	//
-	std::vector<double> pp(pos);
-
-	pp[i1] = pmin[i1] + del[i1]*i;
-	pp[i2] = pmin[i2] + del[i2]*j;
-
-	// Cartesian to spherical for all_eval
-	//
-	double x = pp[0];
-	double y = pp[1];
-	double z = pp[2];
-
-	// Coordinate values
-	double r, costh, phi, R;
-
-	// Return values
-	double p0, p1, d0, d1, f1, f2, f3;
-	std::vector<double> v;
-
-	if (ctype == BasisClasses::Basis::Coord::Spherical) {
-	  r     = sqrt(x*x + y*y + z*z) + 1.0e-18;
-	  costh = z/r;
-	  phi   = atan2(y, x);
-	  v = (*basis)(r, costh, phi, ctype);
-	} else if (ctype == BasisClasses::Basis::Coord::Cylindrical) {
-	  R     = sqrt(x*x + y*y) + 1.0e-18;
-	  phi   = atan2(y, x);
-	  v = (*basis)(R, z, phi, ctype);
-	} else {
-	  v = (*basis)(x, y, z, BasisClasses::Basis::Coord::Cartesian);
+      // Evaluate the slice as a grid block with a single plane in
+      // the i3 direction
+      //
+      basis->evaluateGrid(ctype, axes[0], axes[1], axes[2], block);
+
+      std::vector<int> idx(3, 0);
+      for (int n=0; n<labels.size(); n++) {
+	auto & f = frame[labels[n]];
+	for (int i=0; i<grid[i1]; i++) {
+	  for (int j=0; j<grid[i2]; j++) {
+	    idx[i1] = i;
+	    idx[i2] = j;
+	    f(i, j) = block[n](idx[0], idx[1], idx[2]);
+	  }
 	}
-	
-	// Pack the frame structure
-	//
-	for (int n=0; n<labels.size(); n++)
-	  frame[labels[n]](i, j) = v[n];
       }
 
       ret[T] = frame;
@@ -481,6 +479,7 @@ namespace Field
 	      //
 	      MPI_Probe(n, 105, MPI_COMM_WORLD, &status);
 	      MPI_Get_count(&status, MPI_CHAR, &l);
+	      bf.resize(l);
 	      MPI_Recv(bf.data(), l, MPI_CHAR, n, 105, MPI_COMM_WORLD, &status);
 	      std::string s(bf.data(), l);
 	      
@@ -512,7 +511,8 @@ namespace Field
   void FieldGenerator::file_slices(BasisClasses::BasisPtr basis,
 				   CoefClasses::CoefsPtr  coefs,
 				   const std::string      prefix,
-				   const std::string      outdir)
+				   const std::string      outdir,
+				   bool                   compress)
   {
     if (myid==0) {
       // Verify existence of directory
@@ -535,31 +535,40 @@ namespace Field
 	} else i3 = i;
       }
 
-      int icnt = 0;
-
-      for (auto & frame : db) {
+      std::vector<std::map<double, std::map<std::string, Eigen::MatrixXf>>::iterator> frames;
+      for (auto it=db.begin(); it!=db.end(); it++) frames.push_back(it);
 
-	DataGrid datagrid(grid[i1], grid[i2], 1,
-			  pmin[i1], pmax[i1], pmin[i2], pmax[i2], 0, 0);
+      const int nframes = frames.size();
+      std::vector<double> T(nframes);
+      std::vector<std::string> files(nframes), errors(nframes);
 
-	std::vector<double> tmp(grid[i1]*grid[i2]);
+      // The matrices are column major, so the first index varies
+      // fastest as the writer expects
+      //
+#pragma omp parallel for schedule(dynamic)
+      for (int icnt=0; icnt<nframes; icnt++) {
+	try {
+	  VtiGrid datagrid(grid[i1], grid[i2], 1,
+			   pmin[i1], pmax[i1], pmin[i2], pmax[i2], 0, 0,
+			   1, compress);
 
-	for (auto & v : frame.second) {
+	  for (auto & v : frames[icnt]->second)
+	    datagrid.Add(v.second.data(), v.first);
 
-	  for (int i=0; i<grid[i1]; i++) {
-	    for (int j=0; j<grid[i2]; j++) {
-	      tmp[j*grid[i1] + i] = v.second(i, j);
-	    }
-	  }
+	  std::string name = prefix + "_surface_" + std::to_string(icnt);
+	  datagrid.Write(outdir + "/" + name);
 
-	  datagrid.Add(tmp, v.first);
+	  T[icnt]     = frames[icnt]->first;
+	  files[icnt] = datagrid.FileName(name);
+	}
+	catch (std::exception& e) {
+	  errors[icnt] = e.what();
 	}
-
-	std::ostringstream sout;
-	sout << outdir << "/" << prefix << "_surface_" << icnt;
-	datagrid.Write(sout.str());
-	icnt++;
       }
+
+      for (auto & e : errors) if (e.size()) throw std::runtime_error(e);
+
+      writePVD(outdir + "/" + prefix + "_surface.pvd", T, files);
     }
   }
   
@@ -568,6 +577,8 @@ namespace Field
   FieldGenerator::volumes(BasisClasses::BasisPtr basis,
 			  CoefClasses::CoefsPtr coefs)
   {
+    auto guard = basis->lock();
+
     std::map<double, std::map<std::string, Eigen::Tensor<float, 3>>> ret;
 
     // Now get the desired coordinate type
@@ -590,52 +601,29 @@ namespace Field
 	(pmax[1] - pmin[1])/std::max<int>(grid[1]-1, 1),
 	(pmax[2] - pmin[2])/std::max<int>(grid[2]-1, 1) };
     
-    int ncnt = 0;		// Process counter for MPI
-
-    for (auto T : times) {
-
-      if (ncnt++ % numprocs > 0) continue;
+    // Grid axes for the batched evaluation
+    //
+    std::vector<std::vector<double>> axes(3);
+    for (int n=0; n<3; n++) {
+      for (int i=0; i<grid[n]; i++) axes[n].push_back(pmin[n] + del[n]*i);
+    }
 
-      basis->set_coefs(coefs->getCoefStruct(T));
+    std::vector<Eigen::Tensor<float, 3>> block;
 
-      int totpix = grid[0] * grid[1] * grid[2];
+    auto [tbeg, tend] = timeBlock(myid, numprocs);
 
-#pragma omp parallel for
-      for (int n=0; n<totpix; n++) {
+    for (int icnt=tbeg; icnt<tend; icnt++) {
 
-	// Unpack the index triple by integer division
-	//
-	int i = n/(grid[1]*grid[2]);
-	int j = (n - i*grid[1]*grid[2])/grid[2];
-	int k = n - (i*grid[1] + j)*grid[2];
+      double T = times[icnt];
 
-	// Compute the coordinates from the indices
-	//
-	double x = pmin[0] + del[0]*i;
-	double y = pmin[1] + del[1]*j;
-	double z = pmin[2] + del[2]*k;
-	    
-	std::vector<double> v;
+      basis->set_coefs(coefs->getCoefStruct(T));
 
-	if (ctype == BasisClasses::Basis::Coord::Spherical) {
-	  double r     = sqrt(x*x + y*y + z*z) + 1.0e-18;
-	  double costh = z/r;
-	  double phi   = atan2(y, x);
-	  v = (*basis)(r, costh, phi, ctype);
-	} else if (ctype == BasisClasses::Basis::Coord::Cylindrical) {
-	  double R     = sqrt(x*x + y*y) + 1.0e-18;
-	  double phi   = atan2(y, x);
-	  v = (*basis)(R, z, phi, ctype);
-	} else {
-	  ctype = BasisClasses::Basis::Coord::Cartesian;
-	  v = (*basis)(x, y, z, ctype);
-	}
+      // Evaluate the entire volume in one batch
+      //
+      basis->evaluateGrid(ctype, axes[0], axes[1], axes[2], block);
 
-	// Pack the frame structure
-	//
-	for (int n=0; n<labels.size(); n++)
-	  frame[labels[n]](i, j, k) = v[n];
-      }
+      for (int n=0; n<labels.size(); n++)
+	frame[labels[n]] = std::move(block[n]);
 
       ret[T] = frame;
 
@@ -690,6 +678,7 @@ namespace Field
 	      //
 	      MPI_Probe(n, 105, MPI_COMM_WORLD, &status);
 	      MPI_Get_count(&status, MPI_CHAR, &l);
+	      bf.resize(l);
 	      MPI_Recv(bf.data(), l, MPI_CHAR, n, 105, MPI_COMM_WORLD, &status);
 	      std::string s(bf.data(), l);
 	      
@@ -725,7 +714,8 @@ namespace Field
   void FieldGenerator::file_volumes(BasisClasses::BasisPtr basis,
 				    CoefClasses::CoefsPtr  coefs,
 				    const std::string      prefix,
-				    const std::string      outdir)
+				    const std::string      outdir,
+				    bool                   compress)
   {
     if (myid==0) {
       // Verify existence of directory
@@ -737,106 +727,398 @@ namespace Field
 
     auto db = volumes(basis, coefs);
 
-    int bunch = db.size()/numprocs;
-    int first = bunch*myid;
-    int last  = std::min<int>(bunch*(myid+1), db.size());
+    // The frames are gathered on the root node
+    //
+    if (myid) return;
 
-#pragma omp parallel for
-    for (int icnt=first; icnt<last; icnt++) {
+    const int nframes = db.size();
+    if (nframes==0) return;
+
+    // Split each volume into enough pieces to keep all threads busy
+    // when there are fewer frames than threads
+    //
+    int nthrds = omp_get_max_threads();
+    int pieces = (nthrds + nframes - 1)/nframes;
+
+    std::vector<std::unique_ptr<VtiGrid>> grids(nframes);
+    std::vector<std::string> names(nframes), files(nframes);
+    std::vector<double> T(nframes);
+
+    int icnt = 0;
+    for (auto & v : db) {
+      auto g = std::make_unique<VtiGrid>(grid[0], grid[1], grid[2],
+					 pmin[0], pmax[0],
+					 pmin[1], pmax[1],
+					 pmin[2], pmax[2],
+					 pieces, compress);
+
+      // The tensors are column major, so x varies fastest as the
+      // writer expects
+      //
+      for (auto & f : v.second) g->Add(f.second.data(), f.first);
+
+      names[icnt] = prefix + "_volume_" + std::to_string(icnt);
+      files[icnt] = g->FileName(names[icnt]);
+      T[icnt]     = v.first;
+      grids[icnt++] = std::move(g);
+
+      v.second.clear();		// The writer holds its own copy
+    }
+
+    // Write every piece of every frame in parallel
+    //
+    std::vector<std::pair<int, int>> work;
+    for (int n=0; n<nframes; n++) {
+      for (int p=0; p<grids[n]->Pieces(); p++) work.push_back({n, p});
+    }
+
+    std::vector<std::string> errors(work.size());
+
+#pragma omp parallel for schedule(dynamic)
+    for (int w=0; w<work.size(); w++) {
+      auto [n, p] = work[w];
+      try {
+	grids[n]->WritePiece(outdir + "/" + names[n], p);
+	if (p==0) grids[n]->WriteIndex(outdir + "/" + names[n]);
+      }
+      catch (std::exception& e) {
+	errors[w] = e.what();
+      }
+    }
+
+    for (auto & e : errors) if (e.size()) throw std::runtime_error(e);
+
+    writePVD(outdir + "/" + prefix + "_volume.pvd", T, files);
+  }
+  
+  //! IEEE 754 binary16 as an HDF5 floating point type; the library
+  //! converts to and from native floats on write and read
+  static hid_t float16Type()
+  {
+    hid_t t = H5Tcopy(H5T_IEEE_F32LE);
+    H5Tset_fields(t, 15, 10, 5, 0, 10);
+    H5Tset_size(t, 2);
+    H5Tset_ebias(t, 15);
+    return t;
+  }
+
+  void FieldGenerator::stream_volumes(BasisClasses::BasisPtr basis,
+				      CoefClasses::CoefsPtr  coefs,
+				      const std::string      filename,
+				      int stride, bool half, int tiles)
+  {
+    auto guard = basis->lock();
+
+    if (stride<1)
+      throw std::runtime_error("FieldGenerator::stream_volumes: "
+			       "stride must be positive");
+
+    check_times(coefs);
+
+    auto ctype  = basis->coordinates;
+    auto labels = basis->getFieldLabels(ctype);
+    int  nf     = labels.size();
+
+    // Downsampled grid axes
+    //
+    std::vector<std::vector<double>> axes(3);
+    std::vector<size_t> dims(3);
+    for (int n=0; n<3; n++) {
+      double del = (pmax[n] - pmin[n])/std::max<int>(grid[n]-1, 1);
+      for (int i=0; i<grid[n]; i+=stride) axes[n].push_back(pmin[n] + del*i);
+      dims[n] = axes[n].size();
+    }
+
+    const size_t nx = dims[0], ny = dims[1], nz = dims[2];
+    const int ntimes = times.size();
+
+    if (tiles<1 or tiles>numprocs or tiles>nx)
+      throw std::runtime_error("FieldGenerator::stream_volumes: tiles must "
+			       "be positive and no more than the number of "
+			       "processes or x planes");
+
+    // The processes form groups of 'tiles' ranks.  Each group takes a
+    // contiguous block of times, so that a lazy coefficient source is
+    // read only for the blocks that the group needs, and each rank in
+    // the group evaluates one slab of x planes.  Ranks left over from
+    // the last whole group are idle.
+    //
+    const int ngroups = numprocs/tiles;
+    const int nactive = ngroups*tiles;
 
-      auto it = db.begin();
-      std::advance(it, icnt);
+    auto tile = [&](int r) -> std::pair<size_t, size_t>
+    { int k = r % tiles; return {k*nx/tiles, (k+1)*nx/tiles}; };
 
-      DataGrid datagrid(grid[0], grid[1], grid[2],
-			pmin[0], pmax[0],
-			pmin[1], pmax[1],
-			pmin[2], pmax[2]);
+    int tbeg = 0, tend = 0;
+    if (myid < nactive) std::tie(tbeg, tend) = timeBlock(myid/tiles, ngroups);
 
-      std::vector<double> tmp(grid[0]*grid[1]*grid[2]);
+    auto [xbeg, xend] = tile(myid);
+    std::vector<double> xaxis(axes[0].begin()+xbeg, axes[0].begin()+xend);
+    const size_t nxt = xend - xbeg;
 
-      for (auto & v : it->second) {
-	  
-	for (int i=0; i<grid[0]; i++) {
-	  for (int j=0; j<grid[1]; j++) {
-	    for (int k=0; k<grid[2]; k++) {
-	      tmp[(k*grid[1] + j)*grid[0] + i] = v.second(i, j, k);
+    // Create the file and the datasets on the root node
+    //
+    std::unique_ptr<HighFive::File> file;
+    std::vector<hid_t> dsets;
+
+    auto close = [&]()
+    {
+      for (auto d : dsets) H5Dclose(d);
+      dsets.clear();
+    };
+
+    // Write the x planes [x0, x0+n) of time t; buf holds the fields
+    // in dataset order
+    //
+    auto write = [&](int t, size_t x0, size_t n, const std::vector<float>& buf)
+    {
+      hsize_t beg[4] = {hsize_t(t), x0, 0, 0};
+      hsize_t cnt[4] = {1, n, ny, nz};
+      hsize_t len    = n*ny*nz;
+
+      hid_t mspace = H5Screate_simple(1, &len, NULL);
+
+      for (int f=0; f<nf; f++) {
+	hid_t fspace = H5Dget_space(dsets[f]);
+	herr_t err =
+	  H5Sselect_hyperslab(fspace, H5S_SELECT_SET, beg, NULL, cnt, NULL);
+	if (err>=0)
+	  err = H5Dwrite(dsets[f], H5T_NATIVE_FLOAT, mspace, fspace,
+			 H5P_DEFAULT, buf.data() + f*len);
+	H5Sclose(fspace);
+
+	if (err<0) {
+	  H5Sclose(mspace);
+	  throw std::runtime_error("FieldGenerator::stream_volumes: error "
+				   "writing <" + labels[f] + "> to " + filename);
+	}
+      }
+
+      H5Sclose(mspace);
+    };
+
+    if (myid==0) {
+      file = std::make_unique<HighFive::File>(filename, HighFive::File::Overwrite);
+
+      std::vector<int> shape {int(nx), int(ny), int(nz)};
+      file->createAttribute<double>("pmin", HighFive::DataSpace::From(pmin)).write(pmin);
+      file->createAttribute<double>("pmax", HighFive::DataSpace::From(pmax)).write(pmax);
+      file->createAttribute<int>("grid", HighFive::DataSpace::From(shape)).write(shape);
+      file->createAttribute<int>("stride", HighFive::DataSpace::From(stride)).write(stride);
+      file->createAttribute<std::string>("fields", HighFive::DataSpace::From(labels)).write(labels);
+      file->createDataSet("times", times);
+
+      // One time slab per chunk, split in x if a slab exceeds
+      // 2^24 values
+      //
+      hsize_t cx = std::max<size_t>(1, std::min<size_t>(nx, (1<<24)/(ny*nz)));
+
+      hsize_t cur[4]   = {hsize_t(ntimes), nx, ny, nz};
+      hsize_t max[4]   = {H5S_UNLIMITED, nx, ny, nz};
+      hsize_t chunk[4] = {1, cx, ny, nz};
+
+      hid_t dtype  = half ? float16Type() : H5Tcopy(H5T_NATIVE_FLOAT);
+      hid_t space  = H5Screate_simple(4, cur, max);
+      hid_t dcpl   = H5Pcreate(H5P_DATASET_CREATE);
+      H5Pset_chunk(dcpl, 4, chunk);
+
+      HighFive::Group group = file->createGroup("fields");
+
+      for (auto & label : labels) {
+	hid_t d = H5Dcreate2(group.getId(), label.c_str(), dtype, space,
+			     H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	if (d<0) break;
+	dsets.push_back(d);
+      }
+
+      H5Pclose(dcpl);
+      H5Sclose(space);
+      H5Tclose(dtype);
+
+      if (dsets.size() != nf) {
+	close();
+	throw std::runtime_error("FieldGenerator::stream_volumes: could not "
+				 "create the field datasets in " + filename);
+      }
+    }
+
+    // In each round, every group evaluates the next time of its
+    // block.  The root gathers the round and hands it to a writer
+    // task while the next round is evaluated.
+    //
+    struct Part
+    {
+      int t;
+      size_t x0, n;
+      std::vector<float> buf;
+    };
+
+    const int nrounds = (ntimes + ngroups - 1)/ngroups;
+
+    std::future<void> pending;
+    std::vector<Eigen::Tensor<float, 3>> block;
+
+    try {
+      for (int k=0; k<nrounds; k++) {
+
+	int t = tbeg + k;
+	std::vector<float> buf;
+
+	if (t<tend) {
+	  basis->set_coefs(coefs->getCoefStruct(times[t]));
+	  basis->evaluateGrid(ctype, xaxis, axes[1], axes[2], block);
+
+	  // Pack in row-major order
+	  //
+	  const size_t len = nxt*ny*nz;
+	  buf.resize(nf*len);
+#pragma omp parallel for collapse(2)
+	  for (int n=0; n<nf; n++) {
+	    for (int i=0; i<nxt; i++) {
+	      float* p = buf.data() + n*len + i*ny*nz;
+	      for (int j=0; j<ny; j++) {
+		for (int l=0; l<nz; l++) *(p++) = block[n](i, j, l);
+	      }
 	    }
 	  }
 	}
-	
-	datagrid.Add(tmp, v.first);
+
+	if (myid==0) {
+	  std::vector<Part> round;
+	  if (t<tend) round.push_back({t, xbeg, nxt, std::move(buf)});
+
+	  for (int r=1; r<nactive; r++) {
+	    auto [b, e] = timeBlock(r/tiles, ngroups);
+	    if (b + k >= e) continue;
+
+	    auto [x0, x1] = tile(r);
+	    Part p {b + k, x0, x1 - x0, std::vector<float>(nf*(x1 - x0)*ny*nz)};
+	    MPI_Recv(p.buf.data(), p.buf.size(), MPI_FLOAT, r, 107,
+		     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+	    round.push_back(std::move(p));
+	  }
+
+	  if (pending.valid()) pending.get();
+
+	  pending = std::async(std::launch::async,
+			       [&write, round=std::move(round)]()
+			       {
+				 for (auto & p : round)
+				   write(p.t, p.x0, p.n, p.buf);
+			       });
+	}
+	else if (t<tend) {
+	  MPI_Send(buf.data(), buf.size(), MPI_FLOAT, 0, 107, MPI_COMM_WORLD);
+	}
       }
-      
-      std::ostringstream sout;
-      sout << outdir << "/" << prefix << "_volume_" << icnt;
-      datagrid.Write(sout.str());
+
+      if (pending.valid()) pending.get();
     }
+    catch (...) {
+      if (pending.valid()) pending.wait();
+      close();
+      throw;
+    }
+
+    close();
   }
-  
+
+  // Sum of nb bins filled from every particle of the reader by
+  // fill(chunk, n, bins).  Each thread fills a private copy of the
+  // bins, so no update is shared, and the copies are added once at
+  // the end.
+  //
+  template<class Fill>
+  static std::vector<double> threadedBins(PR::PRptr reader, size_t nb,
+					  Fill fill)
+  {
+    const int nthrds = omp_get_max_threads();
+    std::vector<std::vector<double>> bins(nthrds);
+
+    PR::FieldSelection fields(reader, PR::FieldMass | PR::FieldPosition);
+
+    for (auto c=reader->firstChunk(); c.size; c=reader->nextChunk()) {
+#pragma omp parallel
+      {
+	auto & b = bins[omp_get_thread_num()];
+	if (b.size() != nb) b.assign(nb, 0.0);
+
+#pragma omp for schedule(static)
+	for (long n=0; n<c.size; n++) fill(c, n, b.data());
+      }
+    }
+
+    std::vector<double> ret(nb, 0.0);
+#pragma omp parallel for schedule(static)
+    for (long i=0; i<nb; i++) {
+      for (auto & b : bins) if (b.size()) ret[i] += b[i];
+    }
+
+    return ret;
+  }
+
   std::map<std::string, Eigen::MatrixXf>
   FieldGenerator::histogram2d(PR::PRptr reader, std::vector<double> ctr)
   {
 
     std::map<std::string, Eigen::MatrixXf> ret;
-    std::map<std::string, double> fac;
 
     std::vector<double> del(3, 0.0);
     for (int k=0; k<3; k++) {
       if (grid[k]>0) del[k] = (pmax[k] - pmin[k])/grid[k];
     }
 
-    if (grid[0]>0 and grid[1]>0) {
-      ret["xy"] = Eigen::MatrixXf::Zero(grid[0], grid[1]);
-      fac["xy"] = 1.0/(del[0]*del[1]);
-    }
-
-    if (grid[0]>0 and grid[2]>0) {
-      ret["xz"] = Eigen::MatrixXf::Zero(grid[0], grid[2]);
-      fac["xz"] = 1.0/(del[0]*del[2]);
-    }
-
-    if (grid[1]>0 and grid[2]>0) {
-      ret["yz"] = Eigen::MatrixXf::Zero(grid[1], grid[2]);
-      fac["yz"] = 1.0/(del[1]*del[2]);
+    // The three projections share one pass over the particles.  Each
+    // image is a column-major block of the bins.
+    //
+    struct Image
+    {
+      std::string name;
+      int i, j;
+      size_t off;
+      double fac;
+    };
+
+    std::vector<Image> images;
+    size_t nb = 0;
+
+    const std::vector<std::tuple<std::string, int, int>> planes
+      { {"xy", 0, 1}, {"xz", 0, 2}, {"yz", 1, 2} };
+
+    for (auto [name, i, j] : planes) {
+      if (grid[i]>0 and grid[j]>0) {
+	images.push_back({name, i, j, nb, 1.0/(del[i]*del[j])});
+	nb += static_cast<size_t>(grid[i])*grid[j];
+      }
     }
-    
-    std::vector<double> pp(3);
-    std::vector<bool> bb(3);
-
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
 
+    auto fill = [&](const PR::ParticleChunk& c, size_t n, double* bins)
+    {
+      double pp[3];
+      bool   bb[3];
       for (int k=0; k<3; k++) {
-	pp[k] = p->pos[k] - ctr[k];
+	pp[k] = c.pos[3*n+k] - ctr[k];
 	bb[k] = pp[k] >= pmin[k] and pp[k] < pmax[k] and del[k] > 0.0;
       }
 
-      // x-y
-      if (bb[0] and bb[1]) {
-	int indx1 = floor( (pp[0] - pmin[0])/del[0] );
-	int indx2 = floor( (pp[1] - pmin[1])/del[1] );
-
-	if (indx1>=0 and indx1<grid[0] and indx2>=0 and indx2<grid[1])
-	  ret["xy"](indx1, indx2) += p->mass * fac["xy"];
-      }
-
-      // x-z
-      if (bb[0] and bb[2]) {
-	int indx1 = floor( (pp[0] - pmin[0])/del[0] );
-	int indx2 = floor( (pp[2] - pmin[2])/del[2] );
+      for (auto & h : images) {
+	if (bb[h.i] and bb[h.j]) {
+	  int indx1 = floor( (pp[h.i] - pmin[h.i])/del[h.i] );
+	  int indx2 = floor( (pp[h.j] - pmin[h.j])/del[h.j] );
 
-	if (indx1>=0 and indx1<grid[0] and indx2>=0 and indx2<grid[2] )
-	  ret["xz"](indx1, indx2) += p->mass * fac["xz"];
+	  if (indx1>=0 and indx1<grid[h.i] and indx2>=0 and indx2<grid[h.j])
+	    bins[h.off + indx1 + static_cast<size_t>(grid[h.i])*indx2] +=
+	      c.mass[n] * h.fac;
+	}
       }
+    };
 
-      // y-z
-      if (bb[1] and bb[2]) {
-	int indx1 = floor( (pp[1] - pmin[1])/del[1] );
-	int indx2 = floor( (pp[2] - pmin[2])/del[2] );
+    auto bins = threadedBins(reader, nb, fill);
 
-	if (indx1>=0 and indx1<grid[1] and indx2>=0 and indx2<grid[2] )
-	  ret["yz"](indx1, indx2) += p->mass * fac["yz"];
-      }
-      
+    for (auto & h : images) {
+      auto & m = ret[h.name];
+      m.resize(grid[h.i], grid[h.j]);
+      for (size_t k=0; k<m.size(); k++) m.data()[k] = bins[h.off + k];
     }
 
     if (use_mpi) {
@@ -857,62 +1139,86 @@ namespace Field
   Eigen::VectorXf
   FieldGenerator::histogram1d(PR::PRptr reader, double rmax, int nbins,
 			      std::string proj, std::vector<double> ctr)
+  {
+    return histogram1d(reader, rmax, nbins, std::vector<std::string>{proj},
+		       ctr)[proj];
+  }
+
+  std::map<std::string, Eigen::VectorXf>
+  FieldGenerator::histogram1d(PR::PRptr reader, double rmax, int nbins,
+			      std::vector<std::string> projs,
+			      std::vector<double> ctr)
   {
     const double pi = 3.14159265358979323846;
 
-    Eigen::VectorXf ret = Eigen::VectorXf::Zero(nbins);
     double del = rmax/nbins;
     
-    enum class Projection {xy, xz, yz, r} type;
-    if      (proj == "xy") type = Projection::xy;
-    else if (proj == "xz") type = Projection::xz;
-    else if (proj == "yz") type = Projection::yz;
-    else if (proj == "r" ) type = Projection::r;
-    else {
-      std::ostringstream sout;
-      sout << "FieldGenerator::histogram1d: error parsing projection <" << proj
-	   << ">.  Must be one of \"xy\", \"xz\", \"yz, \"r\".";
-      std::runtime_error(sout.str());
+    // The squared radius in each projection sums the squares of the
+    // selected coordinates
+    //
+    std::vector<std::array<double, 3>> use;
+    for (auto & proj : projs) {
+      if      (proj == "xy") use.push_back({1, 1, 0});
+      else if (proj == "xz") use.push_back({1, 0, 1});
+      else if (proj == "yz") use.push_back({0, 1, 1});
+      else if (proj == "r" ) use.push_back({1, 1, 1});
+      else {
+	std::ostringstream sout;
+	sout << "FieldGenerator::histogram1d: error parsing projection <"
+	     << proj << ">.  Must be one of \"xy\", \"xz\", \"yz, \"r\".";
+	throw std::runtime_error(sout.str());
+      }
     }
 
-    // Make the histogram
+    const int np = projs.size();
+
+    // Make the histograms in one pass
     //
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
-      double rad = 0.0;
+    auto fill = [&](const PR::ParticleChunk& c, size_t n, double* bins)
+    {
+      double pp[3];
       for (int k=0; k<3; k++) {
-	double pp = p->pos[k] - ctr[k];
-	if      (type == Projection::xy and (k==0 or k==1))
-	  rad += pp*pp;		// Cylindrical radius x^2 + y^2	
-	else if (type == Projection::xz and (k==0 or k==2))
-	  rad += pp*pp;		// Cylindrical radius x^2 + z^2	
-	else if (type == Projection::yz and (k==1 or k==2))
-	  rad += pp*pp;		// Cylindrical radius y^2 + z^2	
-	else if (type == Projection::r)
-	  rad += pp*pp;		// Spherical radius
+	pp[k] = c.pos[3*n+k] - ctr[k];
+	pp[k] *= pp[k];
       }
 
-      int indx = floor(sqrt(rad)/del);
-      if (indx>=0 and indx<nbins) ret[indx] += p->mass;
-    }
-    
-    // Accumulate between MPI nodes; return value to root node
-    //
-    if (use_mpi) {
-      if (myid==0) 
-	MPI_Reduce(MPI_IN_PLACE, ret.data(), ret.size(),
-		   MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
-      else
-	MPI_Reduce(ret.data(), NULL, ret.size(),
-		   MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
-    }
+      for (int j=0; j<np; j++) {
+	double rad = use[j][0]*pp[0] + use[j][1]*pp[1] + use[j][2]*pp[2];
+	int indx = floor(sqrt(rad)/del);
+	if (indx>=0 and indx<nbins) bins[j*nbins + indx] += c.mass[n];
+      }
+    };
 
-    // Inverse area or volume for density norm
-    //
-    for (int i=0; i<nbins; i++) {
-      if (type == Projection::r) // Spherical shells
-	ret[i] /= 4.0*pi/3.0*del*del*del*(3*i*(i+1) + 1);
-      else			 // Cylindrical shells
-	ret[i] /= pi*del*del*(2*i + 1);
+    auto bins = threadedBins(reader, static_cast<size_t>(np)*nbins, fill);
+
+    std::map<std::string, Eigen::VectorXf> ret;
+
+    for (int j=0; j<np; j++) {
+
+      Eigen::VectorXf h(nbins);
+      for (int i=0; i<nbins; i++) h[i] = bins[j*nbins + i];
+
+      // Accumulate between MPI nodes; return value to root node
+      //
+      if (use_mpi) {
+	if (myid==0) 
+	  MPI_Reduce(MPI_IN_PLACE, h.data(), h.size(),
+		     MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
+	else
+	  MPI_Reduce(h.data(), NULL, h.size(),
+		     MPI_FLOAT, MPI_SUM, 0, MPI_COMM_WORLD);
+      }
+
+      // Inverse area or volume for density norm
+      //
+      for (int i=0; i<nbins; i++) {
+	if (projs[j] == "r")	// Spherical shells
+	  h[i] /= 4.0*pi/3.0*del*del*del*(3*i*(i+1) + 1);
+	else			// Cylindrical shells
+	  h[i] /= pi*del*del*(2*i + 1);
+      }
+
+      ret[projs[j]] = h;
     }
     
     return ret;
@@ -936,16 +1242,20 @@ namespace Field
     
     // Make the histogram
     //
-    for (auto p=reader->firstParticle(); p!=0; p=reader->nextParticle()) {
+    auto fill = [&](const PR::ParticleChunk& c, size_t n, double* bins)
+    {
       double rad = 0.0;
       for (int k=0; k<3; k++) {
-	double pp = p->pos[k] - ctr[k];
+	double pp = c.pos[3*n+k] - ctr[k];
 	rad += pp*pp;
       }
 
-      int indx = floor((log(sqrt(rad)) - lrmin)/del);
-      if (indx>=0 and indx<nbins) ret[indx] += p->mass;
-    }
+      int indx = floor((0.5*log(rad) - lrmin)/del);
+      if (indx>=0 and indx<nbins) bins[indx] += c.mass[n];
+    };
+
+    auto bins = threadedBins(reader, nbins, fill);
+    for (int i=0; i<nbins; i++) ret[i] = bins[i];
     
     // Accumulate between MPI nodes; return value to root node
     //
@@ -975,6 +1285,8 @@ namespace Field
   FieldGenerator::points(BasisClasses::BasisPtr basis,
 			 CoefClasses::CoefsPtr coefs)
   {
+    auto guard = basis->lock();
+
     // Sanity check on mesh
     //
     if (mesh.size() == 0)
@@ -999,16 +1311,21 @@ namespace Field
     //
     auto labels = basis->getFieldLabels(ctype);
 
-    int ncnt = 0;		// Process counter for MPI
-
     std::map<std::string, Eigen::VectorXf> frame;
     for (auto label : labels) {
       frame[label].resize(mesh.rows());
     }	
 
-    for (auto T : times) {
+    // Direct access to the frame fields for the threaded loop
+    //
+    std::vector<Eigen::VectorXf*> fields;
+    for (auto label : labels) fields.push_back(&frame[label]);
+
+    auto [tbeg, tend] = timeBlock(myid, numprocs);
+
+    for (int icnt=tbeg; icnt<tend; icnt++) {
 
-      if (ncnt++ % numprocs > 0) continue;
+      double T = times[icnt];
 
       if (not coefs->getCoefStruct(T)) {
 	std::cout << "Could not find time=" << T << ", continuing" << std::endl;
@@ -1048,8 +1365,7 @@ namespace Field
 	
 	// Pack the frame structure
 	//
-	for (int n=0; n<labels.size(); n++)
-	  frame[labels[n]](k) = v[n];
+	for (int n=0; n<labels.size(); n++) (*fields[n])(k) = v[n];
       }
 
       ret[T] = frame;
@@ -1094,6 +1410,7 @@ namespace Field
 	      //
 	      MPI_Probe(n, 105, MPI_COMM_WORLD, &status);
 	      MPI_Get_count(&status, MPI_CHAR, &l);
+	      bf.resize(l);
 	      MPI_Recv(bf.data(), l, MPI_CHAR, n, 105, MPI_COMM_WORLD, &status);
 	      std::string s(bf.data(), l);
 	      
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+#include <cmath>
+
+#include <omp.h>
+
+#include "HankelOperator.H"
+
+namespace MSSA
+{
+  //! Smallest integer >= n whose only prime factors are 2, 3 and 5
+  static int smooth_size(int n)
+  {
+    for (;; n++) {
+      int m = n;
+      for (int p : {2, 3, 5}) while (m % p == 0) m /= p;
+      if (m==1) return n;
+    }
+  }
+
+  FFTConvolver::FFTConvolver(int n)
+  {
+    if (n<1)
+      throw std::runtime_error("FFTConvolver: length must be positive");
+
+    nfft  = smooth_size(n);
+    nfreq = nfft/2 + 1;
+
+    std::vector<double> in(nfft);
+    std::vector<std::complex<double>> out(nfreq);
+
+    fwd = fftw_plan_dft_r2c_1d(nfft, in.data(),
+			       reinterpret_cast<fftw_complex*>(out.data()),
+			       FFTW_ESTIMATE | FFTW_UNALIGNED);
+
+    bwd = fftw_plan_dft_c2r_1d(nfft,
+			       reinterpret_cast<fftw_complex*>(out.data()),
+			       in.data(), FFTW_ESTIMATE | FFTW_UNALIGNED);
+  }
+
+  FFTConvolver::~FFTConvolver()
+  {
+    fftw_destroy_plan(fwd);
+    fftw_destroy_plan(bwd);
+  }
+
+  FFTConvolver::Spectrum
+  FFTConvolver::transform(const double* a, int na) const
+  {
+    if (na>nfft)
+      throw std::runtime_error("FFTConvolver::transform: sequence too long");
+
+    std::vector<double> in(nfft, 0.0);
+    std::copy(a, a + na, in.begin());
+
+    Spectrum ret(nfreq);
+    fftw_execute_dft_r2c(fwd, in.data(),
+			 reinterpret_cast<fftw_complex*>(ret.data()));
+    return ret;
+  }
+
+  void FFTConvolver::convolve(const Spectrum& A, const double* b, int nb,
+			      double* out, int nout) const
+  {
+    if (nb>nfft or nout>nfft or static_cast<int>(A.size()) != nfreq)
+      throw std::runtime_error("FFTConvolver::convolve: wrong dimensions");
+
+    auto B = transform(b, nb);
+    for (int k=0; k<nfreq; k++) B[k] *= A[k];
+
+    std::vector<double> in(nfft);
+    fftw_execute_dft_c2r(bwd, reinterpret_cast<fftw_complex*>(B.data()),
+			 in.data());
+
+    for (int i=0; i<nout; i++) out[i] = in[i]/nfft;
+  }
+
+  HankelOperator::HankelOperator
+  (const std::vector<const std::vector<double>*>& chan, int numW) :
+    numW(numW), nkeys(chan.size())
+  {
+    if (nkeys==0)
+      throw std::runtime_error("HankelOperator: no channels");
+
+    numT = chan[0]->size();
+
+    // A circular correlation of this length has no wrap-around in
+    // the lags that are used
+    //
+    nfft  = smooth_size(numT);
+    nfreq = nfft/2 + 1;
+
+    std::vector<double> in(nfft);
+    std::vector<std::complex<double>> out(nfreq);
+
+    fwd = fftw_plan_dft_r2c_1d(nfft, in.data(),
+			       reinterpret_cast<fftw_complex*>(out.data()),
+			       FFTW_ESTIMATE | FFTW_UNALIGNED);
+
+    bwd = fftw_plan_dft_c2r_1d(nfft,
+			       reinterpret_cast<fftw_complex*>(out.data()),
+			       in.data(), FFTW_ESTIMATE | FFTW_UNALIGNED);
+
+    // Transform the channels and sum x_n[t]^2 over the channels
+    //
+    X.resize(nkeys);
+    x2.assign(numT, 0.0);
+
+    for (int n=0; n<nkeys; n++) {
+      auto & x = *chan[n];
+      if (static_cast<int>(x.size()) != numT)
+	throw std::runtime_error("HankelOperator: channels differ in length");
+
+      std::fill(in.begin(), in.end(), 0.0);
+      std::copy(x.begin(), x.end(), in.begin());
+
+      X[n].resize(nfreq);
+      fftw_execute_dft_r2c(fwd, in.data(),
+			   reinterpret_cast<fftw_complex*>(X[n].data()));
+
+      for (int t=0; t<numT; t++) x2[t] += x[t]*x[t];
+    }
+
+    setWindow(numW);
+  }
+
+  void HankelOperator::setWindow(int W)
+  {
+    numW = W;
+    numK = numT - numW + 1;
+
+    if (numW<1 or numK<1)
+      throw std::runtime_error("HankelOperator: window does not fit the series");
+
+    // Each value times the number of entries of Y holding it
+    //
+    norm2 = 0.0;
+    for (int t=0; t<numT; t++) {
+      int c = std::min<int>({t, numW-1, numK-1, numT-1-t}) + 1;
+      norm2 += x2[t]*c;
+    }
+  }
+
+  HankelOperator::~HankelOperator()
+  {
+    fftw_destroy_plan(fwd);
+    fftw_destroy_plan(bwd);
+  }
+
+  Eigen::MatrixXd HankelOperator::apply(const Eigen::MatrixXd& V) const
+  {
+    if (V.rows() != cols())
+      throw std::runtime_error("HankelOperator::apply: wrong dimensions");
+
+    Eigen::MatrixXd ret(numK, V.cols());
+
+#pragma omp parallel
+    {
+      std::vector<double> in(nfft);
+      std::vector<std::complex<double>> out(nfreq), acc(nfreq);
+
+#pragma omp for
+      for (int c=0; c<V.cols(); c++) {
+
+	// Sum the channel correlations in frequency space
+	//
+	std::fill(acc.begin(), acc.end(), 0.0);
+
+	for (int n=0; n<nkeys; n++) {
+	  std::fill(in.begin(), in.end(), 0.0);
+	  for (int j=0; j<numW; j++) in[j] = V(numW*n + numW-1-j, c);
+
+	  fftw_execute_dft_r2c(fwd, in.data(),
+			       reinterpret_cast<fftw_complex*>(out.data()));
+
+	  for (int k=0; k<nfreq; k++) acc[k] += X[n][k]*out[k];
+	}
+
+	fftw_execute_dft_c2r(bwd, reinterpret_cast<fftw_complex*>(acc.data()),
+			     in.data());
+
+	for (int i=0; i<numK; i++) ret(i, c) = in[i + numW-1]/nfft;
+      }
+    }
+
+    return ret;
+  }
+
+  Eigen::MatrixXd HankelOperator::adjoint(const Eigen::MatrixXd& U) const
+  {
+    if (U.rows() != rows())
+      throw std::runtime_error("HankelOperator::adjoint: wrong dimensions");
+
+    Eigen::MatrixXd ret(cols(), U.cols());
+
+#pragma omp parallel
+    {
+      std::vector<double> in(nfft);
+      std::vector<std::complex<double>> uf(nfreq), out(nfreq);
+
+#pragma omp for
+      for (int c=0; c<U.cols(); c++) {
+
+	std::fill(in.begin(), in.end(), 0.0);
+	for (int i=0; i<numK; i++) in[i] = U(numK-1-i, c);
+
+	fftw_execute_dft_r2c(fwd, in.data(),
+			     reinterpret_cast<fftw_complex*>(uf.data()));
+
+	for (int n=0; n<nkeys; n++) {
+	  for (int k=0; k<nfreq; k++) out[k] = X[n][k]*uf[k];
+
+	  fftw_execute_dft_c2r(bwd, reinterpret_cast<fftw_complex*>(out.data()),
+			       in.data());
+
+	  for (int j=0; j<numW; j++) ret(numW*n + j, c) = in[j + numK-1]/nfft;
+	}
+      }
+    }
+
+    return ret;
+  }
+
+  //! Orthonormal basis for the range of A
+  static Eigen::MatrixXd orthonormalize(const Eigen::MatrixXd& A)
+  {
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
+    return qr.householderQ() * Eigen::MatrixXd::Identity(A.rows(), A.cols());
+  }
+
+  HankelSVD::HankelSVD(const HankelOperator& A, int rank, int iter, int over,
+		       const Eigen::MatrixXd& start)
+  {
+    int m = std::min<int>(A.rows(), A.cols());
+
+    rank  = std::max<int>(1, std::min<int>(rank, m));
+    int r = std::min<int>(rank + std::max<int>(0, over), m);
+
+    // Gaussian test matrix (fixed seed for reproducible analyses)
+    //
+    std::mt19937 gen(11);
+    std::normal_distribution<double> normal;
+
+    Eigen::MatrixXd Omega(A.cols(), r);
+    for (int j=0; j<r; j++)
+      for (int i=0; i<A.cols(); i++) Omega(i, j) = normal(gen);
+
+    // Warm start from a previous subspace estimate
+    //
+    if (start.size()) {
+      if (start.rows() != A.cols())
+	throw std::runtime_error("HankelSVD: wrong dimensions for the start subspace");
+      int k = std::min<int>(r, start.cols());
+      Omega.leftCols(k) = start.leftCols(k);
+    }
+
+    // Range finder with subspace iterations
+    //
+    Eigen::MatrixXd Q = orthonormalize(A.apply(Omega));
+
+    for (int q=0; q<iter; q++) {
+      Q = orthonormalize(A.adjoint(Q));
+      Q = orthonormalize(A.apply(Q));
+    }
+
+    // B^T = Y^T Q is small: cols x r
+    //
+    Eigen::MatrixXd BT = A.adjoint(Q);
+
+    Eigen::BDCSVD<Eigen::MatrixXd>
+      svd(BT, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+    // B = Q^T Y = W S Z^T with W = svd.matrixV(), Z = svd.matrixU()
+    //
+    m_vectorS = svd.singularValues().head(rank);
+    m_matrixU = Q * svd.matrixV().leftCols(rank);
+    m_matrixV = svd.matrixU().leftCols(rank);
+  }
+}
@@ -1,110 +1,255 @@
 #include <random>
 #include <chrono>
+#include <cmath>
 
 #include <KMeans.H>
 
 namespace MSSA
 {
 
-  void KMeans::kMeansClustering::iterate(KMeans::KMeansDistance& distance,
-					 int niter, int k, int s, bool verbose)
+  void KMeans::kMeansClustering::seed(KMeans::KMeansDistance& distance, int k)
   {
-    // Compute initial cen
-    //
-    cen.clear();
-    
-    if (s>0) {
-      // Seed centers by stride
-      for (int i=0; i<classes.size(); i+=s) {
-	if (cen.size()>=k) break;
-	cen.push_back(classes.at(i)->x);
-      }
-      k = cen.size();
-    } else {
-      // Obtain a seed from the system clock
-      unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    const int N = classes.size();
+    k = std::min<int>(k, N);
+
+    // Obtain a seed from the system clock
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
       
-      // Make a random generator
-      std::mt19937 gen(seed);
+    // Make a random generator
+    std::mt19937 gen(seed);
+
+    // First center uniformly from the initial point list
+    std::uniform_int_distribution<int> uni(0, N-1);
+    cen.push_back(classes[uni(gen)]->x);
 
-      // Randomly shuffle a list of indexes
-      std::vector<int> indx;
-      for (int i=0; i<classes.size(); i++) indx.push_back(i);
-      std::shuffle(indx.begin(), indx.end(), gen);
+    // Then with probability proportional to the squared distance to
+    // the nearest center so far (Arthur & Vassilvitskii 2007)
+    //
+    std::vector<double> mind(N, std::numeric_limits<double>::max()), D;
+
+    while (cen.size() < k) {
+      distance.table(classes, {cen.back()}, D);
+
+      std::vector<double> wght(N);
+      double sum = 0.0;
+      for (int i=0; i<N; i++) {
+	if (D[i] < mind[i]) mind[i] = D[i];
+	double d = mind[i] < std::numeric_limits<double>::max() ? mind[i] : 0.0;
+	if (not (d > 0.0)) d = 0.0;
+	wght[i] = distance.squaredEuclidean() ? d : d*d;
+	sum += wght[i];
+      }
 
-      // Seed centers randomly from the initial point list
-      for (int i=0; i<k; ++i) {
-	cen.push_back(classes.at(indx[i])->x);
+      if (sum > 0.0) {
+	std::discrete_distribution<int> pick(wght.begin(), wght.end());
+	cen.push_back(classes[pick(gen)]->x);
+      } else {
+	cen.push_back(classes[uni(gen)]->x);
       }
     }
-    
-    // Save last center
+  }
+
+  std::vector<double>
+  KMeans::kMeansClustering::update(int k, bool verbose, int n)
+  {
+    // Initialize for update
     //
-    auto last(cen);
-    
-    // Iterations
+    std::vector<int> nPoints(k, 0);
+    std::vector< std::vector<double> > sumX(k);
+    for (int id=0; id<k; id++) sumX[id].resize(ndim, 0);
+      
+    // Iterate over points to append data to new centroid
     //
-    for (int n=0; n<niter; n++) {
+    for (auto p : classes) {
+      if (p->cid>=0) {
+	nPoints[p->cid] += 1;
+	for (int i=0; i<ndim; i++) sumX[p->cid][i] += p->x[i];
+      }
+    }
       
+    // Compute the new centroid
+    //
+    auto last = cen;
+    for (int id=0; id<k; id++) {
+      if (nPoints[id]) {
+	for (int i=0; i<ndim; i++)
+	  cen[id][i] = sumX[id][i]/nPoints[id];
+      }
+    }
+      
+    std::vector<double> cdiff(k, 0.0);
+    total = 0.0;
+    for (int id=0; id<k; id++) {
+      for (int i=0; i<ndim; i++)
+	cdiff[id] += (cen[id][i] - last[id][i])*(cen[id][i] - last[id][i]);
+      total += cdiff[id];
+    }
+      
+    if (verbose) {
+      std::cout << "Iteration " << n << ", total=" << total << std::endl;
       for (int id=0; id<k; id++) {
-	for (auto p : classes) {
-	  double dist = distance(p->x, cen[id]);
+	std::cout << std::setw(12) << cdiff[id];
+	for (int i=0; i<ndim; i++)
+	  std::cout << std::setw(12) << cen[id][i];
+	std::cout << std::endl;
+      }
+    }
+
+    for (auto & v : cdiff) v = std::sqrt(v);
+    return cdiff;
+  }
+
+  void KMeans::kMeansClustering::lloyd(KMeans::KMeansDistance& distance,
+				       int niter, int k, bool verbose)
+  {
+    const int N = classes.size();
+    std::vector<double> D;
+
+    for (int n=0; n<niter; n++) {
+
+      distance.table(classes, cen, D);
+
+#pragma omp parallel for
+      for (int i=0; i<N; i++) {
+	auto p = classes[i];
+	p->minDist = std::numeric_limits<double>::max();
+	for (int id=0; id<k; id++) {
+	  double dist = D[i*k + id];
 	  if (dist < p->minDist) {
 	    p->minDist = dist;
 	    p->cid = id;
 	  }
 	}
       }
+
+      update(k, verbose, n);
       
-      // Initialize for update
-      //
-      std::vector<int> nPoints(k, 0);
-      std::vector< std::vector<double> > sumX(k);
-      for (int id=0; id<k; id++) sumX[id].resize(ndim, 0);
-      
-      // Iterate over points to append data to new centroid
-      //
-      for (auto p : classes) {
-	if (p->cid>=0) {
-	  nPoints[p->cid] += 1;
-	  for (int i=0; i<ndim; i++) sumX[p->cid][i] += p->x[i];
-	  p->minDist = std::numeric_limits<double>::max();
+      if (total<=0.0) break;
+    }
+  }
+
+  void KMeans::kMeansClustering::hamerly(KMeans::KMeansDistance& distance,
+					 int niter, int k, bool verbose)
+  {
+    const int N = classes.size();
+
+    // Upper bound on the distance to the assigned center and lower
+    // bound on the distance to any other center (Hamerly 2010)
+    //
+    std::vector<double> upper(N), lower(N);
+
+    auto scan = [&](int i)
+    {
+      auto p = classes[i];
+      double d1 = std::numeric_limits<double>::max(), d2 = d1;
+      for (int id=0; id<k; id++) {
+	double d = std::sqrt(distance(p->x, cen[id]));
+	if (d < d1) {
+	  d2 = d1;
+	  d1 = d;
+	  p->cid = id;
+	} else if (d < d2) {
+	  d2 = d;
 	}
       }
+      upper[i] = d1;
+      lower[i] = d2;
+    };
+
+#pragma omp parallel for
+    for (int i=0; i<N; i++) scan(i);
+
+    for (int n=0; n<niter; n++) {
+
+      auto delta = update(k, verbose, n);
       
-      // Compute the new centroid
+      if (total<=0.0) break;
+
+      // Half the distance from each center to its nearest neighbor
       //
-      last = cen;
-      for (int id=0; id<k; id++) {
-	if (nPoints[id]) {
-	  for (int i=0; i<ndim; i++)
-	    cen[id][i] = sumX[id][i]/nPoints[id];
+      std::vector<double> half(k, std::numeric_limits<double>::max());
+      for (int a=0; a<k; a++) {
+	for (int b=a+1; b<k; b++) {
+	  double d = 0.5*std::sqrt(distance(cen[a], cen[b]));
+	  half[a] = std::min<double>(half[a], d);
+	  half[b] = std::min<double>(half[b], d);
 	}
       }
-      
-      std::vector<double> cdiff(k, 0.0);
-      total = 0.0;
-      for (int id=0; id<k; id++) {
-	for (int i=0; i<ndim; i++)
-	  cdiff[id] += (cen[id][i] - last[id][i])*(cen[id][i] - last[id][i]);
-	total += cdiff[id];
+
+      // Largest and second largest center motion for the lower bounds
+      //
+      int r = std::max_element(delta.begin(), delta.end()) - delta.begin();
+      double m1 = delta[r], m2 = 0.0;
+      for (int id=0; id<k; id++) if (id != r) m2 = std::max<double>(m2, delta[id]);
+
+#pragma omp parallel for
+      for (int i=0; i<N; i++) {
+	auto p = classes[i];
+	int a  = p->cid;
+
+	upper[i] += delta[a];
+	lower[i] -= a==r ? m2 : m1;
+
+	double m = std::max<double>(half[a], lower[i]);
+	if (upper[i] <= m) continue;
+
+	// Tighten the upper bound before a full scan
+	//
+	upper[i] = std::sqrt(distance(p->x, cen[a]));
+	if (upper[i] <= m) continue;
+
+	scan(i);
       }
-      
-      if (verbose) {
-	std::cout << "Iteration " << n << ", total=" << total << std::endl;
-	for (int id=0; id<k; id++) {
-	  std::cout << std::setw(12) << cdiff[id];
-	  for (int i=0; i<ndim; i++)
-	    std::cout << std::setw(12) << cen[id][i];
-	  std::cout << std::endl;
-	}
+    }
+
+    for (int i=0; i<N; i++) classes[i]->minDist = upper[i]*upper[i];
+  }
+
+  void KMeans::kMeansClustering::iterate(KMeans::KMeansDistance& distance,
+					 int niter, int k, int s, bool verbose)
+  {
+    distance.prepare(classes);
+
+    for (auto p : classes) {
+      p->cid     = -1;
+      p->minDist = std::numeric_limits<double>::max();
+    }
+
+    // Compute initial cen
+    //
+    cen.clear();
+    
+    if (s>0) {
+      // Seed centers by stride
+      for (int i=0; i<classes.size(); i+=s) {
+	if (cen.size()>=k) break;
+	cen.push_back(classes.at(i)->x);
       }
-      
-      if (total<=0.0) break;
+    } else {
+      seed(distance, k);
     }
     
+    k = cen.size();
+    total = 0.0;
+
+    if (distance.squaredEuclidean())
+      hamerly(distance, niter, k, verbose);
+    else
+      lloyd(distance, niter, k, verbose);
   }
   
+  void KMeans::KMeansDistance::table(const std::vector<Ptr>& points,
+				     const std::vector<std::vector<double>>& cen,
+				     std::vector<double>& D)
+  {
+    const int N = points.size(), k = cen.size();
+    D.resize(static_cast<size_t>(N)*k);
+
+#pragma omp parallel for
+    for (int i=0; i<N; i++) {
+      for (int j=0; j<k; j++) D[i*k + j] = (*this)(points[i]->x, cen[j]);
+    }
+  }
   
   double KMeans::EuclideanDistance::operator()
     (const std::vector<double>& x, const std::vector<double>& y)
@@ -116,46 +261,33 @@ namespace MSSA
   }
   
   
-  double KMeans::WcorrDistance::operator()
-    (const std::vector<double>& x, const std::vector<double>& y)
+  KMeans::WcorrBase::WcorrBase(int numT, int numW, int nchn) :
+    numT(numT), numW(numW), nchn(nchn)
   {
-    // A Lambda for the weight function
-    auto w = [&](int i) {
-      if      (i < Lstar) return i;
-      else if (i < Kstar) return Lstar;
-      else                return numT - i + 1;
-    };
-    
-    double corr = 0.0, nrmx = 0.0, nrmy = 0.0;
+    Lstar  = std::min<int>(numT - numW, numW);
+    Kstar  = std::max<int>(numT - numW, numW);
+
+    // The weight function
+    //
+    sw.resize(numT*nchn);
     for (int i=0; i<numT; i++) {
-      corr += w(i) * x[i] * y[i];
-      nrmx += w(i) * x[i] * x[i];
-      nrmy += w(i) * y[i] * y[i];
+      double w;
+      if      (i < Lstar) w = i;
+      else if (i < Kstar) w = Lstar;
+      else                w = numT - i + 1;
+      for (int n=0; n<nchn; n++) sw[i+n*numT] = std::sqrt(w);
     }
-    
-    double ret = 1.0;
-    if (nrmx*nrmy > 0.0) ret -= sqrt(corr/sqrt(nrmx*nrmy));
-    
-    return ret;
   }
   
-  double KMeans::WcorrDistMulti::operator()
+  double KMeans::WcorrBase::operator()
     (const std::vector<double>& x, const std::vector<double>& y)
   {
-    // A Lambda for the weight function
-    auto w = [&](int i) {
-      if      (i < Lstar) return i;
-      else if (i < Kstar) return Lstar;
-      else                return numT - i + 1;
-    };
-    
     double corr = 0.0, nrmx = 0.0, nrmy = 0.0;
-    for (int n=0; n<nchn; n++) {
-      for (int i=0; i<numT; i++) {
-	corr += w(i) * x[i+n*numT] * y[i+n*numT];
-	nrmx += w(i) * x[i+n*numT] * x[i+n*numT];
-	nrmy += w(i) * y[i+n*numT] * y[i+n*numT];
-      }
+    for (int i=0; i<numT*nchn; i++) {
+      double w = sw[i]*sw[i];
+      corr += w * x[i] * y[i];
+      nrmx += w * x[i] * x[i];
+      nrmy += w * y[i] * y[i];
     }
     
     double ret = 1.0;
@@ -163,6 +295,61 @@ namespace MSSA
     
     return ret;
   }
+
+  std::vector<double>
+  KMeans::WcorrBase::scale(const std::vector<double>& x) const
+  {
+    std::vector<double> ret(numT*nchn);
+    double nrm = 0.0;
+    for (int i=0; i<numT*nchn; i++) {
+      ret[i] = sw[i]*x[i];
+      nrm   += ret[i]*ret[i];
+    }
+
+    if (nrm > 0.0) {
+      nrm = std::sqrt(nrm);
+      for (auto & v : ret) v /= nrm;
+    } else {
+      ret.clear();
+    }
+
+    return ret;
+  }
+
+  void KMeans::WcorrBase::prepare(const std::vector<Ptr>& points)
+  {
+    z.resize(points.size());
+
+#pragma omp parallel for
+    for (int i=0; i<points.size(); i++) z[i] = scale(points[i]->x);
+  }
+
+  void KMeans::WcorrBase::table(const std::vector<Ptr>& points,
+				const std::vector<std::vector<double>>& cen,
+				std::vector<double>& D)
+  {
+    if (z.size() != points.size()) prepare(points);
+
+    const int N = points.size(), k = cen.size(), M = numT*nchn;
+
+    std::vector<std::vector<double>> zc(k);
+    for (int j=0; j<k; j++) zc[j] = scale(cen[j]);
+
+    D.resize(static_cast<size_t>(N)*k);
+
+#pragma omp parallel for
+    for (int i=0; i<N; i++) {
+      for (int j=0; j<k; j++) {
+	double ret = 1.0;
+	if (z[i].size() and zc[j].size()) {
+	  double corr = 0.0;
+	  for (int m=0; m<M; m++) corr += z[i][m]*zc[j][m];
+	  ret -= sqrt(corr);
+	}
+	D[i*k + j] = ret;
+      }
+    }
+  }
   
 }
 // END namespace MSSA
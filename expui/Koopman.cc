@@ -6,7 +6,8 @@
 // Martinsson, and Tropp by default.  Use BDCSVD or Jacobi flags for
 // the standard methods.  Using the randomized method together with
 // trajectory matrix rather than covariance matrix analysis may lead
-// to large errors in eigenvectors.
+// to large errors in eigenvectors.  The GPU flag computes the
+// randomized SVD on the device with cuSOLVER.
 //
 // The implementation here follows:
 //
@@ -15,6 +16,14 @@
 // Decomposition: Theory and Applications", Journal of Computational
 // Dynamics, 1(2), 391-421
 //
+// The kernel mode replaces the state by Nystrom features of a
+// Gaussian or polynomial kernel evaluated against a random subset of
+// landmark snapshots, following:
+//
+// Matthew O. Williams, Clarence W. Rowley and Ioannis G. Kevrekidis,
+// 2015, "A kernel-based method for data-driven Koopman spectral
+// analysis", Journal of Computational Dynamics, 2(2), 247-265
+//
 
 #include <filesystem>
 #include <stdexcept>
@@ -22,8 +31,11 @@
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <numeric>
 #include <vector>
 #include <limits>
+#include <random>
 #include <cmath>
 #include <map>
 
@@ -47,6 +59,9 @@
 #include <Koopman.H>
 
 #include <RedSVD.H>
+#include <cudaSVD.H>
+#include <StateHash.H>
+#include <StreamingDMD.H>
 #include <YamlConfig.H>
 #include <YamlCheck.H>
 #include <EXPException.H>
@@ -73,10 +88,38 @@ namespace MSSA {
     //
     nkeys = data.size();
 
-    // Enforce nev to be <= rank
+    // Enforce nev to be <= rank.  The kernel features have at most
+    // one dimension per landmark.
+    //
+    int rank = nkeys;
+    if (kernel.size()) rank = std::min<int>(landmarks, numT-1);
+
+    if (nev > rank) std::cout << "Koopman: setting nEV=" << rank << std::endl;
+    nev = std::min<int>(nev, rank);
+
+    // Streaming mode: absorb the snapshot pairs one at a time with
+    // bounded memory rather than forming the state matrices
     //
-    if (nev > nkeys) std::cout << "Koopman: setting nEV=" << nkeys << std::endl;
-    nev = std::min<int>(nev, nkeys);
+    if (params["streaming"]) {
+      int maxRank = nev;
+      if (params["maxRank"]) maxRank = params["maxRank"].as<int>();
+
+      stream = std::make_shared<StreamingDMD>(maxRank);
+      streamSnapshots(0);
+
+      X0.resize(0, 0);
+      X1.resize(0, 0);
+      S .resize(0);
+      V .resize(0, 0);
+
+      U = stream->basis();
+      A = stream->op();
+
+      koopman_modes();
+      return;
+    }
+
+    stream.reset();
 
     // Allocate trajectory arrays
     //
@@ -97,44 +140,254 @@ namespace MSSA {
       n++;
     }
 
+    // Kernel EDMD: the same operator fit on the Nystrom features.
+    // The features are computed once for all times; the pairs are
+    // the leading and trailing columns.
+    //
+    if (kernel.size()) {
+      Eigen::MatrixXd F = kernelFeatures();
+
+      decompose(F.leftCols(numT-1));
+
+      // Keep the leading nEV nonzero singular values; the features
+      // are often nearly degenerate
+      //
+      int r = 0;
+      while (r < std::min<int>(nev, S.size()) and
+	     S(r) > std::numeric_limits<double>::epsilon()*S(0)*S.size()) r++;
+
+      S = S.head(r).eval();
+      U = U.leftCols(r).eval();
+      V = V.leftCols(r).eval();
+
+      A = U.transpose() * (F.rightCols(numT-1) * V) *
+	S.cwiseInverse().asDiagonal();
+
+      koopman_modes();
+      return;
+    }
+
     // Approximate the pseudoinverse using the rank-r SVD
     // approximation of the initial state matrix
     //
+    decompose(X0);
+
+    // Compute the approximation to the Koopman operator for the rank
+    // reduced approximation
+    //
+    Eigen::MatrixXd D = S.asDiagonal();
+
+    // E.g. Tu et al. 2014, equation 4 (parens to enforce effficient
+    // order)
+    //
+    A = U.transpose() * (X1 * V) * D.inverse();
+
+    koopman_modes();
+  }
+
+  void Koopman::decompose(const Eigen::MatrixXd& X)
+  {
     // Use one of the built-in Eigen3 algorithms
     //
     if (params["Jacobi"]) {
       // -->Using Jacobi
       Eigen::JacobiSVD<Eigen::MatrixXd>
-	svd(X0, Eigen::ComputeThinU | Eigen::ComputeThinV);
+	svd(X, Eigen::ComputeThinU | Eigen::ComputeThinV);
       S = svd.singularValues();
       U = svd.matrixU();
       V = svd.matrixV();
     } else if (params["BDCSVD"]) {
       // -->Using BDC
       Eigen::BDCSVD<Eigen::MatrixXd>
-	svd(X0, Eigen::ComputeThinU | Eigen::ComputeThinV);
+	svd(X, Eigen::ComputeThinU | Eigen::ComputeThinV);
       S = svd.singularValues();
       U = svd.matrixU();
       V = svd.matrixV();
+    } else if (params["randomized"]) {
+      // -->Randomized DMD (Erichson et al. 2019): compress the state
+      //    onto a sketched basis Q with oversampling and subspace
+      //    iterations and decompose the small matrix Q^T X
+      int over = 10, iter = 2;
+      if (params["oversample"]) over = params["oversample"].as<int>();
+      if (params["powerIter"] ) iter = params["powerIter" ].as<int>();
+
+      if (useGPU and cudaRandomizedSVD(X, nev, S, U, V, over, iter)) {
+
+	// Keep the nonzero part
+	//
+	int r = 0;
+	while (r < S.size() and
+	       S(r) > std::numeric_limits<double>::epsilon()*S(0)) r++;
+
+	S = S.head(r).eval();
+	U = U.leftCols(r).eval();
+	V = V.leftCols(r).eval();
+
+      } else {
+
+	int l = std::min<int>({nev + over, static_cast<int>(X.rows()),
+			       static_cast<int>(X.cols())});
+
+	Eigen::MatrixXd O(X.cols(), l);
+	RedSVD::sample_gaussian(O);
+
+	Eigen::MatrixXd Q = X * O;
+	RedSVD::gram_schmidt(Q);
+
+	for (int q=0; q<iter; q++) {
+	  Eigen::MatrixXd Z = X.transpose() * Q;
+	  RedSVD::gram_schmidt(Z);
+	  Q = X * Z;
+	  RedSVD::gram_schmidt(Q);
+	}
+
+	Eigen::BDCSVD<Eigen::MatrixXd>
+	  svd(Q.transpose() * X, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+	// Keep the nonzero part of the leading nev
+	//
+	auto s = svd.singularValues();
+	int r = 0;
+	while (r < std::min<int>(nev, s.size()) and
+	       s(r) > std::numeric_limits<double>::epsilon()*s(0)) r++;
+
+	S = s.head(r);
+	U = Q * svd.matrixU().leftCols(r);
+	V = svd.matrixV().leftCols(r);
+      }
+    } else if (useGPU and cudaRandomizedSVD(X, nev, S, U, V)) {
+      // -->Randomized SVD on the device
     } else {
       // -->Use Random approximation algorithm from Halko, Martinsson,
       //    and Tropp
-      RedSVD::RedSVD<Eigen::MatrixXd> svd(X0, nev);
+      RedSVD::RedSVD<Eigen::MatrixXd> svd(X, nev);
       S = svd.singularValues();
       U = svd.matrixU();
       V = svd.matrixV();
     }
+  }
 
-    // Compute the approximation to the Koopman operator for the rank
-    // reduced approximation
+  Eigen::MatrixXd Koopman::kernelMatrix(const Eigen::MatrixXd& Z,
+				       const Eigen::MatrixXd& X)
+  {
+    const int m = Z.cols(), n = X.cols();
+    constexpr int block = 256;
+
+    Eigen::MatrixXd K(m, n);
+    Eigen::VectorXd zz = Z.colwise().squaredNorm().transpose();
+
+    const bool gauss = kernel == "gaussian";
+    const double fac = gauss ? 0.5/(bandwidth*bandwidth) : 1.0/bandwidth;
+
+    // Each block is a small product followed by the elementwise
+    // kernel; Eigen runs single threaded inside the parallel region
     //
-    Eigen::MatrixXd D = S.asDiagonal();
+#pragma omp parallel for schedule(dynamic)
+    for (int b=0; b<n; b+=block) {
+      int nb = std::min<int>(block, n - b);
+
+      K.middleCols(b, nb).noalias() = Z.transpose() * X.middleCols(b, nb);
+
+      for (int j=b; j<b+nb; j++) {
+	if (gauss) {
+	  double xx = X.col(j).squaredNorm();
+	  for (int i=0; i<m; i++) {
+	    double d2 = std::max<double>(zz(i) + xx - 2.0*K(i, j), 0.0);
+	    K(i, j) = exp(-fac*d2);
+	  }
+	} else {
+	  for (int i=0; i<m; i++)
+	    K(i, j) = pow(fac*K(i, j) + offset, degree);
+	}
+      }
+    }
 
-    // E.g. Tu et al. 2014, equation 4 (parens to enforce effficient
-    // order)
+    return K;
+  }
+
+  Eigen::MatrixXd Koopman::kernelFeatures()
+  {
+    // All times as columns
     //
-    A = U.transpose() * (X1 * V) * D.inverse();
+    Eigen::MatrixXd X(nkeys, numT);
+    X.leftCols(numT-1) = X0;
+    X.col(numT-1) = X1.col(numT-2);
+
+    // Landmarks: a random subset of the snapshots
+    //
+    int m = std::min<int>(landmarks, numT);
+
+    std::vector<int> indx(numT);
+    std::iota(indx.begin(), indx.end(), 0);
+    std::mt19937 gen(seed);
+    for (int i=0; i<m; i++) {
+      std::uniform_int_distribution<int> pick(i, numT-1);
+      std::swap(indx[i], indx[pick(gen)]);
+    }
+    std::sort(indx.begin(), indx.begin()+m);
+
+    Eigen::MatrixXd Z(nkeys, m);
+    for (int i=0; i<m; i++) Z.col(i) = X.col(indx[i]);
+
+    // Default scale: the median landmark separation for the
+    // Gaussian kernel and the mean squared norm for the polynomial
+    // kernel
+    //
+    if (bandwidth <= 0.0) {
+      if (kernel == "gaussian") {
+	std::vector<double> dist;
+	for (int i=0; i<m; i++)
+	  for (int j=i+1; j<m; j++) dist.push_back((Z.col(i) - Z.col(j)).norm());
+	if (dist.size()) {
+	  std::nth_element(dist.begin(), dist.begin() + dist.size()/2, dist.end());
+	  bandwidth = dist[dist.size()/2];
+	}
+      } else {
+	bandwidth = Z.colwise().squaredNorm().mean();
+      }
+      if (bandwidth <= 0.0) bandwidth = 1.0;
+
+      if (verbose)
+	std::cout << "Koopman: kernel scale=" << bandwidth << std::endl;
+    }
 
+    // Nystrom map K_mm^{-1/2} k_m(x), keeping the well-conditioned
+    // part of the landmark kernel
+    //
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(kernelMatrix(Z, Z));
+
+    const Eigen::VectorXd& ev = es.eigenvalues(); // Ascending
+    double tol = std::max<double>(ev(m-1), 0.0) * 1.0e-10;
+    int k0 = 0;
+    while (k0 < m and ev(k0) <= tol) k0++;
+
+    if (k0 == m)
+      throw std::runtime_error("Koopman: the landmark kernel matrix is zero");
+
+    Eigen::MatrixXd T =
+      ev.tail(m-k0).cwiseSqrt().cwiseInverse().asDiagonal() *
+      es.eigenvectors().rightCols(m-k0).transpose();
+
+    if (verbose)
+      std::cout << "Koopman: " << m << " landmarks, " << m-k0
+		<< " features" << std::endl;
+
+    return T * kernelMatrix(Z, X);
+  }
+
+  Eigen::VectorXcd Koopman::amplitudes()
+  {
+    if (B0.size()) return B0;
+
+    int n = 0;
+    Eigen::VectorXd xx(nkeys);
+    for (auto & u : data) xx[n++] = u.second[0];
+
+    return Phi.inverse() * xx;
+  }
+
+  void Koopman::koopman_modes()
+  {
     // Now compute the eigenvalues and eigenvectors
     //
     Eigen::EigenSolver<Eigen::MatrixXd> sol(A, true);
@@ -150,19 +403,92 @@ namespace MSSA {
       else Linv(i) = 0.0;
     }
 
-    // Projected mode for testing
+    B0.resize(0);
+
+    // Kernel EDMD: the eigenfunctions at the snapshots are the
+    // columns of W^{-1} S V^T, so the least-squares modes mapping
+    // them back to the state are X0 V S^{-1} W and the amplitudes
+    // are the eigenfunctions at the first time
     //
-    if (project) {
+    if (kernel.size()) {
+      Phi = X0 * V * S.cwiseInverse().asDiagonal() * W;
+      B0  = W.inverse() * (S.asDiagonal() * V.row(0).transpose());
+    }
+    // Projected mode for testing and for streaming, which keeps no
+    // snapshots
+    //
+    else if (project or stream) {
       Phi = U * W;
     }
     // This is the exact mode from Tu et al. 2014, equation 9
     //
     else {
+      Eigen::MatrixXd D = S.asDiagonal();
       Phi = Linv.asDiagonal() * X1 * V * D.inverse() * W;
     }
     
     computed = true;
     reconstructed = false;
+
+    writeCache();
+  }
+
+  void Koopman::streamSnapshots(int t0)
+  {
+    Eigen::VectorXd x(nkeys), y(nkeys);
+
+    for (int t=t0; t<numT-1; t++) {
+      int n = 0;
+      for (auto & u : data) {
+	x(n) = u.second[t+0];
+	y(n) = u.second[t+1];
+	n++;
+      }
+      stream->push(x, y);
+    }
+  }
+
+  void Koopman::update(const mssaConfig& config)
+  {
+    CoefContainer db(config, cflags);
+
+    // The new times must extend the current series
+    //
+    const int T0 = numT, T1 = db.times.size();
+
+    if (T1 < T0)
+      throw std::runtime_error("Koopman::update: fewer times than the current series");
+
+    for (int t=0; t<T0; t++) {
+      double dt = std::fabs(db.times[t] - coefDB.times[t]);
+      if (dt > 1.0e-8*std::max<double>(1.0, std::fabs(coefDB.times[t])))
+	throw std::runtime_error("Koopman::update: times do not extend the current series");
+    }
+
+    if (T1 == T0) return;
+
+    for (auto & u : data) {
+      auto v = db.getData(u.first);
+      if (static_cast<int>(v.size()) != T1)
+	throw std::runtime_error("Koopman::update: channels do not match the analysis");
+      u.second.assign(v.begin(), v.end());
+    }
+
+    coefDB = db;
+    numT   = T1;
+    computeFingerprint();
+
+    // Only the new pairs are absorbed by a streaming analysis; other
+    // modes are recomputed on demand
+    //
+    if (computed and stream) {
+      streamSnapshots(T0-1);
+      U = stream->basis();
+      A = stream->op();
+      koopman_modes();
+    } else {
+      computed = reconstructed = false;
+    }
   }
 
   void Koopman::reconstruct(const std::vector<int>& evlist)
@@ -173,7 +499,7 @@ namespace MSSA {
 
     // Make a zero vector
     //
-    Eigen::VectorXcd I(nev); I.setZero();
+    Eigen::VectorXcd I(L.size()); I.setZero();
 
     auto lsz = evlist.size();
 
@@ -182,16 +508,11 @@ namespace MSSA {
 
     if (lsz) {
 
-      int n = 0;
-      Eigen::VectorXd xx(nkeys);
-      xx.setZero();
-      for (auto u : data) xx[n++] = data[u.first][0];
-	
       for (auto v : evlist) {
-	if (v<nev) I[v] = 1.0;
+	if (v<L.size()) I[v] = 1.0;
       }
 
-      Eigen::VectorXcd B  = Phi.inverse() * xx;
+      Eigen::VectorXcd B  = amplitudes();
       Eigen::MatrixXcd LL = I.asDiagonal();
 	
       // Propagate the solution using the approximate Koopman operator
@@ -231,17 +552,17 @@ namespace MSSA {
 
     retF.setZero();
 
-    int nn = 0;
-    Eigen::VectorXd xx(nkeys);
-    for (auto u : data) xx[nn++] = data[u.first][0];
-    
-    Eigen::VectorXcd B = Phi.inverse() * xx;
+    Eigen::VectorXcd B = amplitudes();
     Eigen::VectorXcd LL = Eigen::VectorXd::Ones(L.size());
 
+    // Mode j contributes Phi(n, j)*L(j)^t*B(j) to channel n
+    //
+    int nmode = std::min<int>(nev, L.size());
+
     for (int i=0; i<numT; i++) {
-      for (int j=0; j<nev; j++) {
+      for (int j=0; j<nmode; j++) {
 	for (int n=0; n<nkeys; n++) {
-	  retF(j, n) += std::norm( Phi(j, n)*LL(n)*B(n) );
+	  retF(j, n) += std::norm( Phi(n, j)*LL(j)*B(j) );
 	}
       }
       LL = LL.array() * L.array();
@@ -582,7 +903,20 @@ namespace MSSA {
     "Jacobi",
     "BDCSVD",
     "project",
-    "output"
+    "output",
+    "cache",
+    "randomized",
+    "oversample",
+    "powerIter",
+    "streaming",
+    "maxRank",
+    "GPU",
+    "kernel",
+    "landmarks",
+    "bandwidth",
+    "degree",
+    "offset",
+    "seed"
   };
 
   void Koopman::assignParameters(const std::string flags)
@@ -611,10 +945,44 @@ namespace MSSA {
       verbose  = bool(params["verbose"]);
       powerf   = bool(params["power"  ]);
       project  = bool(params["project"]);
+      useGPU   = bool(params["GPU"    ]);
+
+#if HAVE_LIBCUDA==0
+      if (useGPU) {
+	std::cout << "---- Koopman: this build has no CUDA support, "
+		  << "using the CPU SVD" << std::endl;
+	useGPU = false;
+      }
+#endif
 
       if (params["output"] ) prefix = params["output"].as<std::string>();
       else                   prefix = "exp_edmd";
 
+      // Kernel EDMD
+      //
+      kernel    = "";
+      landmarks = 500;
+      degree    = 2;
+      bandwidth = 0.0;
+      offset    = 1.0;
+      seed      = 11;
+
+      if (params["kernel"]   ) kernel    = params["kernel"   ].as<std::string>();
+      if (params["landmarks"]) landmarks = params["landmarks"].as<int>();
+      if (params["degree"]   ) degree    = params["degree"   ].as<int>();
+      if (params["bandwidth"]) bandwidth = params["bandwidth"].as<double>();
+      if (params["offset"]   ) offset    = params["offset"   ].as<double>();
+      if (params["seed"]     ) seed      = params["seed"     ].as<unsigned>();
+
+      if (kernel.size()) {
+	if (kernel != "gaussian" and kernel != "polynomial")
+	  throw std::runtime_error("Koopman: kernel must be 'gaussian' or 'polynomial'");
+	if (params["streaming"])
+	  throw std::runtime_error("Koopman: 'kernel' and 'streaming' may not be combined");
+	if (landmarks < 2)
+	  throw std::runtime_error("Koopman: at least 2 landmarks are required");
+      }
+
     }
     catch (const YAML::ParserException& e) {
       std::cout << "Koopman::assignParameters, parsing error=" << e.what()
@@ -624,6 +992,92 @@ namespace MSSA {
   }
 
 
+  void Koopman::computeFingerprint()
+  {
+    StateHash hash;
+
+    hash.add(stateVersion);
+    hash.add(nev);
+
+    // Parameters that change the decomposition
+    //
+    for (auto key : {"Jacobi", "BDCSVD", "project", "randomized",
+		     "oversample", "powerIter", "streaming", "maxRank", "GPU",
+		     "kernel", "landmarks", "bandwidth", "degree", "offset",
+		     "seed"})
+      hash.add(params, key);
+
+    // The input series
+    //
+    hash.add(coefDB.times);
+    for (auto & u : data) {
+      hash.add(u.first);
+      hash.add(u.second);
+    }
+
+    fingerprint = hash.value();
+  }
+
+  bool Koopman::readCache()
+  {
+    if (not params["cache"]) return false;
+
+    auto prefix = params["cache"].as<std::string>();
+    auto file   = prefix + "_edmd.h5";
+
+    if (not std::filesystem::exists(file)) return false;
+
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File h5file(file, HighFive::File::ReadOnly);
+
+      if (not h5file.hasAttribute("version") or
+	  not h5file.hasAttribute("fingerprint")) return false;
+
+      int version;
+      unsigned long long fp;
+      h5file.getAttribute("version").read(version);
+      h5file.getAttribute("fingerprint").read(fp);
+
+      if (version != stateVersion or fp != fingerprint) return false;
+    }
+    catch (HighFive::Exception& err) {
+      return false;
+    }
+
+    // A matching cache that fails to load is recomputed
+    //
+    try {
+      restoreState(prefix);
+    }
+    catch (std::exception& e) {
+      computed = reconstructed = false;
+      std::cout << "Koopman: could not restore cache <" << file << ">: "
+		<< e.what() << std::endl;
+      return false;
+    }
+
+    if (verbose)
+      std::cout << "Koopman: restored analysis from <" << file << ">"
+		<< std::endl;
+
+    return true;
+  }
+
+  void Koopman::writeCache()
+  {
+    if (not params["cache"]) return;
+
+    auto prefix = params["cache"].as<std::string>();
+    auto file   = prefix + "_edmd.h5";
+
+    // Replace a stale cache
+    //
+    std::filesystem::remove(file);
+
+    saveState(prefix);
+  }
+
   // Save current KOOPMAN state to an HDF5 file with the given prefix
   void Koopman::saveState(const std::string& prefix)
   {
@@ -656,6 +1110,12 @@ namespace MSSA {
       //
       file.createAttribute<int>("nEV", HighFive::DataSpace::From(nev)).write(nev);
 
+      // Layout version and input fingerprint for cache validation
+      //
+      int version = stateVersion;
+      file.createAttribute<int>("version", HighFive::DataSpace::From(version)).write(version);
+      file.createAttribute<unsigned long long>("fingerprint", HighFive::DataSpace::From(fingerprint)).write(fingerprint);
+
       // Save the key list
       //
       std::vector<Key> keylist;
@@ -682,14 +1142,16 @@ namespace MSSA {
       HighFive::Group analysis = file.createGroup("koopman_analysis");
 
       analysis.createDataSet("Phi",  Phi);
-      analysis.createDataSet("X0",   X0 );
-      analysis.createDataSet("X1",   X1 );
+      if (X0.size()) analysis.createDataSet("X0", X0);
+      if (X1.size()) analysis.createDataSet("X1", X1);
+      if (S.size()) analysis.createDataSet("S", S);
       analysis.createDataSet("U",    U  );
-      analysis.createDataSet("V",    V  );
+      if (V.size()) analysis.createDataSet("V", V);
       analysis.createDataSet("A",    A  );
       analysis.createDataSet("L",    L  );
       analysis.createDataSet("W",    W  );
-      analysis.createDataSet("Y",    Y  );
+      if (Y.size()) analysis.createDataSet("Y", Y);
+      if (B0.size()) analysis.createDataSet("B0", B0);
 
     } catch (HighFive::Exception& err) {
       std::cerr << err.what() << std::endl;
@@ -794,14 +1256,24 @@ namespace MSSA {
       auto analysis = h5file.getGroup("koopman_analysis");
 
       Phi = analysis.getDataSet("Phi").read<Eigen::MatrixXcd>();
-      X0  = analysis.getDataSet("X0" ).read<Eigen::MatrixXd >();
-      X1  = analysis.getDataSet("X1" ).read<Eigen::MatrixXd >();
+      if (analysis.exist("X0"))
+	X0 = analysis.getDataSet("X0").read<Eigen::MatrixXd>();
+      if (analysis.exist("X1"))
+	X1 = analysis.getDataSet("X1").read<Eigen::MatrixXd>();
+      if (analysis.exist("S"))
+	S = analysis.getDataSet("S").read<Eigen::VectorXd>();
       U   = analysis.getDataSet("U"  ).read<Eigen::MatrixXd >();
-      V   = analysis.getDataSet("V"  ).read<Eigen::MatrixXd >();
+      if (analysis.exist("V"))
+	V = analysis.getDataSet("V").read<Eigen::MatrixXd>();
       A   = analysis.getDataSet("A"  ).read<Eigen::MatrixXd >();
       L   = analysis.getDataSet("L"  ).read<Eigen::VectorXcd>();
       W   = analysis.getDataSet("W"  ).read<Eigen::MatrixXcd>();
-      Y   = analysis.getDataSet("Y"  ).read<Eigen::MatrixXd >();
+      if (analysis.exist("Y"))
+	Y = analysis.getDataSet("Y").read<Eigen::MatrixXd>();
+      if (analysis.exist("B0"))
+	B0 = analysis.getDataSet("B0").read<Eigen::VectorXcd>();
+      else
+	B0.resize(0);
 
       computed = true;
 
@@ -829,6 +1301,7 @@ namespace MSSA {
 
     // Now open and parse the coefficient files
     //
+    cflags = flags;
     coefDB = CoefContainer(config, flags);
 
     numT = coefDB.times.size();
@@ -836,11 +1309,17 @@ namespace MSSA {
     // Generate all the channels
     //
     for (auto key : coefDB.getKeys()) {
-      data[key] = coefDB.getData(key);
+      auto v = coefDB.getData(key);
+      data[key].assign(v.begin(), v.end());
     }
 
     computed      = false;
     reconstructed = false;
+
+    // Skip the analysis if a matching one was saved
+    //
+    computeFingerprint();
+    readCache();
   }
   // END Koopman constructor
 
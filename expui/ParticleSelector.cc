@@ -0,0 +1,335 @@
+#include <stdexcept>
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <map>
+
+#include <ParticleSelector.H>
+
+namespace BasisClasses
+{
+  namespace
+  {
+    using Values  = ParticleSelector::Values;
+    using Node    = ParticleSelector::Node;
+    using NodePtr = ParticleSelector::NodePtr;
+
+    // Component k of the interleaved triples in p
+    //
+    Eigen::Map<const Eigen::ArrayXd, 0, Eigen::InnerStride<3>>
+    triple(const double *p, size_t n, int k)
+    {
+      return {p + k, static_cast<Eigen::Index>(n), Eigen::InnerStride<3>()};
+    }
+
+    struct Constant : Node
+    {
+      double v;
+      Constant(double v) : v(v) {}
+      Values eval(const PR::ParticleChunk& c) const
+      { return Values::Constant(c.size, v); }
+    };
+
+    enum class Var {mass, x, y, z, vx, vy, vz, r, R, vel, index};
+
+    struct Variable : Node
+    {
+      Var v;
+      Variable(Var v) : v(v) {}
+      Values eval(const PR::ParticleChunk& c) const
+      {
+	const Eigen::Index n = c.size;
+	switch (v) {
+	case Var::mass: return Eigen::Map<const Eigen::ArrayXd>(c.mass, n);
+	case Var::x:    return triple(c.pos, n, 0);
+	case Var::y:    return triple(c.pos, n, 1);
+	case Var::z:    return triple(c.pos, n, 2);
+	case Var::vx:   return triple(c.vel, n, 0);
+	case Var::vy:   return triple(c.vel, n, 1);
+	case Var::vz:   return triple(c.vel, n, 2);
+	case Var::R:
+	  return (triple(c.pos, n, 0).square() +
+		  triple(c.pos, n, 1).square()).sqrt();
+	case Var::r:
+	  return (triple(c.pos, n, 0).square() +
+		  triple(c.pos, n, 1).square() +
+		  triple(c.pos, n, 2).square()).sqrt();
+	case Var::vel:
+	  return (triple(c.vel, n, 0).square() +
+		  triple(c.vel, n, 1).square() +
+		  triple(c.vel, n, 2).square()).sqrt();
+	case Var::index:
+	  if (c.indx)
+	    return Eigen::Map<const Eigen::Array<unsigned long, Eigen::Dynamic, 1>>
+	      (c.indx, n).cast<double>();
+	  return Values::Zero(n);
+	}
+	return Values::Zero(n);
+      }
+    };
+
+    enum class Op {neg, lnot, abs, sqrt, log10, exp,
+		   add, sub, mul, div, land, lor,
+		   lt, le, gt, ge, eq, ne};
+
+    struct Unary : Node
+    {
+      Op op;
+      NodePtr a;
+      Unary(Op op, NodePtr a) : op(op), a(std::move(a)) {}
+      Values eval(const PR::ParticleChunk& c) const
+      {
+	Values v = a->eval(c);
+	switch (op) {
+	case Op::neg:   return -v;
+	case Op::lnot:  return (v == 0.0).cast<double>();
+	case Op::abs:   return v.abs();
+	case Op::sqrt:  return v.sqrt();
+	case Op::log10: return v.log10();
+	case Op::exp:   return v.exp();
+	default:        return v;
+	}
+      }
+    };
+
+    struct Binary : Node
+    {
+      Op op;
+      NodePtr a, b;
+      Binary(Op op, NodePtr a, NodePtr b) :
+	op(op), a(std::move(a)), b(std::move(b)) {}
+      Values eval(const PR::ParticleChunk& c) const
+      {
+	Values u = a->eval(c), v = b->eval(c);
+	switch (op) {
+	case Op::add:  return u + v;
+	case Op::sub:  return u - v;
+	case Op::mul:  return u * v;
+	case Op::div:  return u / v;
+	case Op::land: return ((u != 0.0) && (v != 0.0)).cast<double>();
+	case Op::lor:  return ((u != 0.0) || (v != 0.0)).cast<double>();
+	default:       return u;
+	}
+      }
+    };
+
+    // A chain of comparisons: each adjacent pair must hold
+    //
+    struct Compare : Node
+    {
+      std::vector<NodePtr> terms;
+      std::vector<Op> ops;
+      Values eval(const PR::ParticleChunk& c) const
+      {
+	Values ret = Values::Ones(c.size);
+	Values u = terms[0]->eval(c);
+	for (size_t i=0; i<ops.size(); i++) {
+	  Values v = terms[i+1]->eval(c);
+	  switch (ops[i]) {
+	  case Op::lt: ret *= (u <  v).cast<double>(); break;
+	  case Op::le: ret *= (u <= v).cast<double>(); break;
+	  case Op::gt: ret *= (u >  v).cast<double>(); break;
+	  case Op::ge: ret *= (u >= v).cast<double>(); break;
+	  case Op::eq: ret *= (u == v).cast<double>(); break;
+	  case Op::ne: ret *= (u != v).cast<double>(); break;
+	  default: break;
+	  }
+	  u.swap(v);
+	}
+	return ret;
+      }
+    };
+
+    // Recursive descent parser for the grammar in ParticleSelector.H
+    //
+    class Parser
+    {
+      const std::string& s;
+      size_t p = 0;
+
+      [[noreturn]] void fail(const std::string& msg)
+      {
+	std::ostringstream sout;
+	sout << "ParticleSelector: " << msg << " at position " << p
+	     << " in <" << s << ">";
+	throw std::invalid_argument(sout.str());
+      }
+
+      void skip() { while (p<s.size() and std::isspace(s[p])) p++; }
+
+      // Consume the symbol if it is next
+      bool accept(const std::string& t)
+      {
+	skip();
+	if (s.compare(p, t.size(), t) != 0) return false;
+	p += t.size();
+	return true;
+      }
+
+      // Consume the keyword if it is the next word
+      bool keyword(const std::string& k)
+      {
+	skip();
+	if (s.compare(p, k.size(), k) != 0) return false;
+	size_t e = p + k.size();
+	if (e<s.size() and (std::isalnum(s[e]) or s[e]=='_')) return false;
+	p = e;
+	return true;
+      }
+
+      NodePtr expr()
+      {
+	auto a = term();
+	while (keyword("or") or accept("||"))
+	  a = std::make_unique<Binary>(Op::lor, std::move(a), term());
+	return a;
+      }
+
+      NodePtr term()
+      {
+	auto a = factor();
+	while (keyword("and") or accept("&&"))
+	  a = std::make_unique<Binary>(Op::land, std::move(a), factor());
+	return a;
+      }
+
+      NodePtr factor()
+      {
+	skip();
+	if (keyword("not") or
+	    (s.compare(p, 1, "!")==0 and s.compare(p, 2, "!=")!=0 and accept("!")))
+	  return std::make_unique<Unary>(Op::lnot, factor());
+	return compare();
+      }
+
+      bool compareOp(Op& op)
+      {
+	if (accept("<=")) { op = Op::le; return true; }
+	if (accept(">=")) { op = Op::ge; return true; }
+	if (accept("==")) { op = Op::eq; return true; }
+	if (accept("!=")) { op = Op::ne; return true; }
+	if (accept("<" )) { op = Op::lt; return true; }
+	if (accept(">" )) { op = Op::gt; return true; }
+	return false;
+      }
+
+      NodePtr compare()
+      {
+	auto a = sum();
+	Op op;
+	if (not compareOp(op)) return a;
+
+	auto c = std::make_unique<Compare>();
+	c->terms.push_back(std::move(a));
+	do {
+	  c->ops.push_back(op);
+	  c->terms.push_back(sum());
+	} while (compareOp(op));
+
+	return c;
+      }
+
+      NodePtr sum()
+      {
+	auto a = product();
+	while (true) {
+	  if      (accept("+")) a = std::make_unique<Binary>(Op::add, std::move(a), product());
+	  else if (accept("-")) a = std::make_unique<Binary>(Op::sub, std::move(a), product());
+	  else return a;
+	}
+      }
+
+      NodePtr product()
+      {
+	auto a = unary();
+	while (true) {
+	  if      (accept("*")) a = std::make_unique<Binary>(Op::mul, std::move(a), unary());
+	  else if (accept("/")) a = std::make_unique<Binary>(Op::div, std::move(a), unary());
+	  else return a;
+	}
+      }
+
+      NodePtr unary()
+      {
+	if (accept("-")) return std::make_unique<Unary>(Op::neg, unary());
+	if (accept("+")) return unary();
+	return atom();
+      }
+
+      NodePtr atom()
+      {
+	skip();
+	if (p == s.size()) fail("unexpected end");
+
+	if (accept("(")) {
+	  auto a = expr();
+	  if (not accept(")")) fail("expected ')'");
+	  return a;
+	}
+
+	// Number
+	//
+	if (std::isdigit(s[p]) or s[p]=='.') {
+	  const char *b = s.c_str() + p;
+	  char *e;
+	  double v = std::strtod(b, &e);
+	  if (e == b) fail("bad number");
+	  p += e - b;
+	  return std::make_unique<Constant>(v);
+	}
+
+	// Variable or function
+	//
+	if (std::isalpha(s[p]) or s[p]=='_') {
+	  size_t b = p;
+	  while (p<s.size() and (std::isalnum(s[p]) or s[p]=='_')) p++;
+	  std::string id = s.substr(b, p-b);
+
+	  static const std::map<std::string, Op> funcs
+	    { {"abs", Op::abs}, {"sqrt", Op::sqrt}, {"log10", Op::log10},
+	      {"exp", Op::exp} };
+
+	  static const std::map<std::string, Var> vars
+	    { {"mass", Var::mass}, {"x", Var::x}, {"y", Var::y},
+	      {"z", Var::z}, {"vx", Var::vx}, {"vy", Var::vy},
+	      {"vz", Var::vz}, {"u", Var::vx}, {"v", Var::vy},
+	      {"w", Var::vz}, {"r", Var::r}, {"R", Var::R},
+	      {"vel", Var::vel}, {"index", Var::index} };
+
+	  auto f = funcs.find(id);
+	  if (f != funcs.end()) {
+	    if (not accept("(")) fail("expected '(' after " + id);
+	    auto a = expr();
+	    if (not accept(")")) fail("expected ')'");
+	    return std::make_unique<Unary>(f->second, std::move(a));
+	  }
+
+	  auto v = vars.find(id);
+	  if (v != vars.end()) return std::make_unique<Variable>(v->second);
+
+	  p = b;
+	  fail("unknown name <" + id + ">");
+	}
+
+	fail("unexpected character");
+      }
+
+    public:
+
+      Parser(const std::string& s) : s(s) {}
+
+      NodePtr parse()
+      {
+	auto a = expr();
+	skip();
+	if (p != s.size()) fail("unexpected text");
+	return a;
+      }
+    };
+  }
+
+  ParticleSelector::ParticleSelector(const std::string& expr) : expr(expr)
+  {
+    root = Parser(this->expr).parse();
+  }
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include "StreamingDMD.H"
+
+namespace MSSA
+{
+  StreamingDMD::StreamingDMD(int maxRank, double tol) :
+    maxRank(maxRank), tol(tol)
+  {
+    if (maxRank<1)
+      throw std::runtime_error("StreamingDMD: maximum rank must be positive");
+  }
+
+  bool StreamingDMD::expand(Eigen::MatrixXd& Q, const Eigen::VectorXd& v)
+  {
+    double nv = v.norm();
+    if (nv<=0.0 or Q.cols()>=Q.rows()) return false;
+
+    // Classical Gram-Schmidt with one reorthogonalization
+    //
+    Eigen::VectorXd e = v - Q*(Q.transpose()*v);
+    e -= Q*(Q.transpose()*e);
+
+    double ne = e.norm();
+    if (ne <= tol*nv) return false;
+
+    int k = Q.cols();
+    Q.conservativeResize(Eigen::NoChange, k+1);
+    Q.col(k) = e/ne;
+
+    return true;
+  }
+
+  Eigen::MatrixXd StreamingDMD::compress(Eigen::MatrixXd& Q, Eigen::MatrixXd& G)
+  {
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(G);
+
+    // Eigenvalues are in increasing order
+    //
+    Eigen::MatrixXd R = es.eigenvectors().rightCols(maxRank).rowwise().reverse();
+
+    Q = Q*R;
+    G = R.transpose()*G*R;
+
+    return R;
+  }
+
+  void StreamingDMD::push(const Eigen::VectorXd& x, const Eigen::VectorXd& y)
+  {
+    if (count==0) {
+      Qx.resize(x.size(), 0);
+      Qy.resize(y.size(), 0);
+      A .resize(0, 0);
+      Gx.resize(0, 0);
+      Gy.resize(0, 0);
+    }
+
+    if (x.size() != Qx.rows() or y.size() != Qy.rows())
+      throw std::runtime_error("StreamingDMD::push: snapshot size changed");
+
+    // Grow the bases, padding the sums with zeros
+    //
+    if (expand(Qx, x)) {
+      int k = Qx.cols();
+      A .conservativeResize(A.rows(), k);  A .col(k-1).setZero();
+      Gx.conservativeResize(k, k);         Gx.col(k-1).setZero();
+      Gx.row(k-1).setZero();
+    }
+
+    if (expand(Qy, y)) {
+      int k = Qy.cols();
+      A .conservativeResize(k, A.cols());  A .row(k-1).setZero();
+      Gy.conservativeResize(k, k);         Gy.col(k-1).setZero();
+      Gy.row(k-1).setZero();
+    }
+
+    // Bound the memory
+    //
+    if (Qx.cols() > maxRank) A = A * compress(Qx, Gx);
+    if (Qy.cols() > maxRank) A = compress(Qy, Gy).transpose() * A;
+
+    // Absorb the projected pair
+    //
+    Eigen::VectorXd xt = Qx.transpose()*x;
+    Eigen::VectorXd yt = Qy.transpose()*y;
+
+    A  += yt*xt.transpose();
+    Gx += xt*xt.transpose();
+    Gy += yt*yt.transpose();
+
+    count++;
+  }
+
+  Eigen::MatrixXd StreamingDMD::op() const
+  {
+    if (count==0)
+      throw std::runtime_error("StreamingDMD::op: no snapshots");
+
+    // Pseudoinverse of Gx
+    //
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(Gx);
+    Eigen::VectorXd ev = es.eigenvalues();
+
+    double cut = tol*std::max<double>(ev.maxCoeff(), 0.0);
+    for (int i=0; i<ev.size(); i++) ev(i) = ev(i) > cut ? 1.0/ev(i) : 0.0;
+
+    Eigen::MatrixXd Ginv =
+      es.eigenvectors() * ev.asDiagonal() * es.eigenvectors().transpose();
+
+    return (Qx.transpose()*Qy) * A * Ginv;
+  }
+}
@@ -266,4 +266,43 @@ namespace MSSA {
     // Done
   }
 
+  // Update sign of right vectors V only, given the projections XtU =
+  // X^T U and XV = X V of the data matrix onto the singular vectors.
+  // With orthonormal U and V, removing the other triplets from X does
+  // not change these projections so X itself is not needed.
+  //
+  void SvdSignChoice
+  (const Eigen::MatrixXd& XtU, const Eigen::MatrixXd& XV, Eigen::MatrixXd& V)
+  {
+    int K = V.cols();
+
+    if (XtU.cols() != K or XV.cols() != K)
+      throw std::invalid_argument("SvdSignChoice: projections have wrong dimensions");
+
+    auto sgn = [](double val) -> int
+    {
+      return (0.0 < val) - (val < 0.0);
+    };
+    
+#pragma omp parallel for
+    for (int k=0; k<K; k++) {
+      // sum of sgn(d)*d^2 for each side
+      double sL = XtU.col(k).dot(XtU.col(k).cwiseAbs());
+      double sR = XV .col(k).dot(XV .col(k).cwiseAbs());
+
+      // If signs are opposite, flip the one with the smaller absolute
+      // value
+      //
+      if (sL*sR < 0.0) {
+	if (std::abs(sL) < std::abs(sR))
+	  sL = -sL;
+	else
+	  sR = -sR;
+      }
+      
+      // Apply
+      V.col(k) *= sgn(sR);
+    }
+  }
+
 }
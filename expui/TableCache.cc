@@ -0,0 +1,89 @@
+#include <sys/stat.h>
+
+#include <mpi.h>
+
+#include "TableCache.H"
+
+namespace BasisClasses
+{
+  std::map<std::string, TableCache::Entry> TableCache::registry;
+  std::mutex TableCache::mtx;
+  bool TableCache::enabled = true;
+
+  std::vector<long long>
+  TableCache::mtimes(const std::vector<std::string>& files)
+  {
+    std::vector<long long> ret;
+    for (auto & f : files) {
+      struct stat info;
+      if (stat(f.c_str(), &info) == 0)
+	ret.push_back(static_cast<long long>(info.st_mtime));
+      else
+	ret.push_back(-1);
+    }
+    return ret;
+  }
+
+  bool TableCache::agree(bool hit)
+  {
+    int flag;
+    MPI_Initialized(&flag);
+    if (not flag) return hit;
+
+    int mine = hit ? 1 : 0, all = 0;
+    MPI_Allreduce(&mine, &all, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    return all == 1;
+  }
+
+  void TableCache::emit(YAML::Emitter& out, const YAML::Node& node)
+  {
+    switch (node.Type()) {
+    case YAML::NodeType::Map:
+      {
+	// Assigning a YAML::Node writes through to the original, so
+	// order the keys with a map rather than sorting nodes in place
+	//
+	std::map<std::string, YAML::Node> items;
+	for (auto it : node) items.emplace(it.first.as<std::string>(), it.second);
+
+	out << YAML::BeginMap;
+	for (auto & v : items) {
+	  out << YAML::Key << v.first << YAML::Value;
+	  emit(out, v.second);
+	}
+	out << YAML::EndMap;
+      }
+      break;
+    case YAML::NodeType::Sequence:
+      out << YAML::BeginSeq;
+      for (auto v : node) emit(out, v);
+      out << YAML::EndSeq;
+      break;
+    case YAML::NodeType::Scalar:
+      out << node.Scalar();
+      break;
+    default:
+      out << YAML::Null;
+    }
+  }
+
+  std::string TableCache::normalize(const YAML::Node& node)
+  {
+    YAML::Emitter out;
+    out << YAML::Flow;
+    emit(out, node);
+    return out.c_str();
+  }
+
+  void TableCache::clear()
+  {
+    std::lock_guard<std::mutex> guard(mtx);
+    registry.clear();
+  }
+
+  size_t TableCache::size()
+  {
+    std::lock_guard<std::mutex> guard(mtx);
+    return registry.size();
+  }
+}
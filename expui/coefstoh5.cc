@@ -3,6 +3,8 @@
 #include <fstream>
 #include <memory>
 
+#include <omp.h>
+
 #include <cxxopts.H>
 #include <libvars.H>
 #include <Coefficients.H>
@@ -11,6 +13,8 @@ int main(int argc, char **argv)
 {
   std::string infile, prefix;
   bool verbose = false;
+  int stride, nthrds, window, level;
+  double tmin, tmax;
 
   //
   // Parse Command line
@@ -29,6 +33,18 @@ int main(int argc, char **argv)
      cxxopts::value<std::string>(infile)->default_value("coef.dat"))
     ("p,prefix", "prefix for h5 coefficient file",
      cxxopts::value<std::string>(prefix)->default_value("new"))
+    ("stride", "keep every stride-th snapshot of the native file",
+     cxxopts::value<int>(stride)->default_value("1"))
+    ("tmin", "earliest snapshot time to keep",
+     cxxopts::value<double>(tmin)->default_value("-1.0e42"))
+    ("tmax", "latest snapshot time to keep",
+     cxxopts::value<double>(tmax)->default_value("1.0e42"))
+    ("t,threads", "number of threads decoding the native file (0 for the OpenMP default)",
+     cxxopts::value<int>(nthrds)->default_value("0"))
+    ("w,window", "write the chunked layout with this many snapshots per chunk (0 for one group per snapshot)",
+     cxxopts::value<int>(window)->default_value("0"))
+    ("z,deflate", "deflate level for the chunked layout",
+     cxxopts::value<int>(level)->default_value("0"))
      ;
   
   cxxopts::ParseResult vm;
@@ -47,6 +63,14 @@ int main(int argc, char **argv)
 
   if (vm.count("verbose")) verbose = true;
 
+  if (stride < 1) stride = 1;
+
+  // The native records are located by a scan of the memory-mapped
+  // file, which applies stride, tmin and tmax without decoding the
+  // skipped records, and the rest are decoded by these threads
+  //
+  if (nthrds > 0) omp_set_num_threads(nthrds);
+
   std::shared_ptr<CoefClasses::Coefs> coefs;
 
   // These first two are only needed for converting old-style
@@ -55,11 +79,17 @@ int main(int argc, char **argv)
   // specification.
   //
   if (vm.count("cylinder"))	
-    coefs = std::make_shared<CoefClasses::CylCoefs>(infile);
+    coefs = std::make_shared<CoefClasses::CylCoefs>(infile, stride, tmin, tmax);
   else if (vm.count("sphere"))
-    coefs = std::make_shared<CoefClasses::SphCoefs>(infile);
+    coefs = std::make_shared<CoefClasses::SphCoefs>(infile, stride, tmin, tmax);
   else
-    coefs = CoefClasses::Coefs::factory(infile);
+    coefs = CoefClasses::Coefs::factory(infile, stride, tmin, tmax);
+
+  if (verbose)
+    std::cout << "Read " << coefs->Times().size() << " snapshots from <"
+	      << infile << ">" << std::endl;
+
+  if (window > 0) coefs->setH5Chunked(window, level);
 
   // Do the writing
   //
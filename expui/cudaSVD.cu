@@ -0,0 +1,229 @@
+// -*- C++ -*-
+
+#include <stdexcept>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <vector>
+
+#include <cuda_runtime.h>
+#include <cublas_v2.h>
+#include <cusolverDn.h>
+
+#include <thrust/device_vector.h>
+
+#include <cudaSVD.H>
+
+// Randomized SVD on the device
+//
+// Matrices are column major on both sides, as in Eigen, so the host
+// arrays are copied without transposition.  The sketch is drawn on
+// the host from a fixed seed so that repeated analyses give the same
+// factorization.
+
+namespace MSSA
+{
+  static void check(cublasStatus_t s, const char* what)
+  {
+    if (s != CUBLAS_STATUS_SUCCESS) {
+      std::ostringstream sout;
+      sout << "cudaRandomizedSVD: " << what << " failed with status " << s;
+      throw std::runtime_error(sout.str());
+    }
+  }
+
+  static void check(cusolverStatus_t s, const char* what)
+  {
+    if (s != CUSOLVER_STATUS_SUCCESS) {
+      std::ostringstream sout;
+      sout << "cudaRandomizedSVD: " << what << " failed with status " << s;
+      throw std::runtime_error(sout.str());
+    }
+  }
+
+  static void check(cudaError_t s, const char* what)
+  {
+    if (s != cudaSuccess) {
+      std::ostringstream sout;
+      sout << "cudaRandomizedSVD: " << what << " failed: "
+	   << cudaGetErrorString(s);
+      throw std::runtime_error(sout.str());
+    }
+  }
+
+  static double* ptr(thrust::device_vector<double>& v)
+  {
+    return thrust::raw_pointer_cast(v.data());
+  }
+
+  //! cuBLAS and cuSOLVER handles with a QR workspace
+  struct cudaSVDWork
+  {
+    cublasHandle_t blas;
+    cusolverDnHandle_t solver;
+    thrust::device_vector<double> tau, work;
+    thrust::device_vector<int> info;
+
+    cudaSVDWork()
+    {
+      check(cublasCreate(&blas), "cublasCreate");
+      check(cusolverDnCreate(&solver), "cusolverDnCreate");
+      info.resize(1);
+    }
+
+    ~cudaSVDWork()
+    {
+      cusolverDnDestroy(solver);
+      cublasDestroy(blas);
+    }
+
+    //! Replace the m x n matrix Q (m >= n) by the Q factor of its QR
+    //! decomposition
+    void orthonormalize(thrust::device_vector<double>& Q, int m, int n)
+    {
+      int lwork1 = 0, lwork2 = 0;
+      check(cusolverDnDgeqrf_bufferSize(solver, m, n, ptr(Q), m, &lwork1),
+	    "geqrf_bufferSize");
+
+      tau.resize(n);
+
+      check(cusolverDnDorgqr_bufferSize(solver, m, n, n, ptr(Q), m,
+					ptr(tau), &lwork2),
+	    "orgqr_bufferSize");
+
+      work.resize(std::max<int>(lwork1, lwork2));
+
+      check(cusolverDnDgeqrf(solver, m, n, ptr(Q), m, ptr(tau),
+			     ptr(work), work.size(),
+			     thrust::raw_pointer_cast(info.data())),
+	    "geqrf");
+
+      check(cusolverDnDorgqr(solver, m, n, n, ptr(Q), m, ptr(tau),
+			     ptr(work), work.size(),
+			     thrust::raw_pointer_cast(info.data())),
+	    "orgqr");
+
+      int ret = info[0];
+      if (ret) {
+	std::ostringstream sout;
+	sout << "cudaRandomizedSVD: QR failed with info=" << ret;
+	throw std::runtime_error(sout.str());
+      }
+    }
+  };
+
+  bool cudaRandomizedSVD(const Eigen::MatrixXd& A, int rank,
+			 Eigen::VectorXd& S, Eigen::MatrixXd& U,
+			 Eigen::MatrixXd& V, int over, int iter)
+  {
+    // Fall back to the CPU if there is no device
+    //
+    int ndev = 0;
+    if (cudaGetDeviceCount(&ndev) != cudaSuccess or ndev==0) {
+      cudaGetLastError();	// Clear the error state
+      static bool first = true;
+      if (first) {
+	std::cout << "---- cudaRandomizedSVD: no CUDA device, "
+		  << "using the CPU" << std::endl;
+	first = false;
+      }
+      return false;
+    }
+
+    const int m = A.rows(), n = A.cols();
+    const double one = 1.0, zero = 0.0;
+
+    // Sketch size
+    //
+    rank = std::min<int>({rank, m, n});
+    if (rank<=0) return false;
+    int l = std::min<int>({rank + over, m, n});
+
+    cudaSVDWork w;
+
+    thrust::device_vector<double>
+      dA(size_t(m)*n), dQ(size_t(m)*l), dZ(size_t(n)*l);
+    check(cudaMemcpy(ptr(dA), A.data(), sizeof(double)*size_t(m)*n,
+		     cudaMemcpyHostToDevice), "copy A");
+
+    // Gaussian test matrix
+    //
+    {
+      std::mt19937 gen(11);
+      std::normal_distribution<double> d;
+      std::vector<double> O(size_t(n)*l);
+      for (auto & v : O) v = d(gen);
+      thrust::copy(O.begin(), O.end(), dZ.begin());
+    }
+
+    // Q = orth(A O)
+    //
+    check(cublasDgemm(w.blas, CUBLAS_OP_N, CUBLAS_OP_N, m, l, n,
+		      &one, ptr(dA), m, ptr(dZ), n, &zero, ptr(dQ), m),
+	  "dgemm A*O");
+    w.orthonormalize(dQ, m, l);
+
+    // Subspace iterations: Z = orth(A^T Q), Q = orth(A Z)
+    //
+    for (int q=0; q<iter; q++) {
+      check(cublasDgemm(w.blas, CUBLAS_OP_T, CUBLAS_OP_N, n, l, m,
+			&one, ptr(dA), m, ptr(dQ), m, &zero, ptr(dZ), n),
+	    "dgemm A^T*Q");
+      w.orthonormalize(dZ, n, l);
+
+      check(cublasDgemm(w.blas, CUBLAS_OP_N, CUBLAS_OP_N, m, l, n,
+			&one, ptr(dA), m, ptr(dZ), n, &zero, ptr(dQ), m),
+	    "dgemm A*Z");
+      w.orthonormalize(dQ, m, l);
+    }
+
+    // B^T = A^T Q is n x l with n >= l, as gesvd requires.  With
+    // B^T = Ub Sb Vb^T, A ~ Q B = (Q Vb) Sb Ub^T.
+    //
+    check(cublasDgemm(w.blas, CUBLAS_OP_T, CUBLAS_OP_N, n, l, m,
+		      &one, ptr(dA), m, ptr(dQ), m, &zero, ptr(dZ), n),
+	  "dgemm A^T*Q");
+
+    thrust::device_vector<double>
+      dS(l), dUb(size_t(n)*l), dVbt(l*l), dU(size_t(m)*l);
+
+    int lwork = 0;
+    check(cusolverDnDgesvd_bufferSize(w.solver, n, l, &lwork),
+	  "gesvd_bufferSize");
+    w.work.resize(lwork);
+
+    check(cusolverDnDgesvd(w.solver, 'S', 'A', n, l, ptr(dZ), n, ptr(dS),
+			   ptr(dUb), n, ptr(dVbt), l, ptr(w.work), lwork,
+			   nullptr, thrust::raw_pointer_cast(w.info.data())),
+	  "gesvd");
+
+    int ret = w.info[0];
+    if (ret) {
+      std::ostringstream sout;
+      sout << "cudaRandomizedSVD: gesvd failed with info=" << ret;
+      throw std::runtime_error(sout.str());
+    }
+
+    // U = Q Vb = Q (Vb^T)^T
+    //
+    check(cublasDgemm(w.blas, CUBLAS_OP_N, CUBLAS_OP_T, m, l, l,
+		      &one, ptr(dQ), m, ptr(dVbt), l, &zero, ptr(dU), m),
+	  "dgemm Q*Vb");
+
+    // Copy back the leading rank triplets
+    //
+    S.resize(rank);
+    U.resize(m, rank);
+    V.resize(n, rank);
+
+    check(cudaMemcpy(S.data(), ptr(dS), sizeof(double)*rank,
+		     cudaMemcpyDeviceToHost), "copy S");
+    check(cudaMemcpy(U.data(), ptr(dU), sizeof(double)*size_t(m)*rank,
+		     cudaMemcpyDeviceToHost), "copy U");
+    check(cudaMemcpy(V.data(), ptr(dUb), sizeof(double)*size_t(n)*rank,
+		     cudaMemcpyDeviceToHost), "copy V");
+
+    return true;
+  }
+}
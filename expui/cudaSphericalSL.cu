@@ -0,0 +1,196 @@
+// -*- C++ -*-
+
+#include <BiorthBasis.H>
+
+// GPU coefficient accumulation for SphericalSL
+//
+// Uses the SLGridSph texture tables (see SLGridSph::initialize_cuda)
+// in the same way as the simulation's SphericalBasis.  One thread per
+// particle; each thread walks the associated Legendre functions by
+// recursion in l for each m so that no per-thread table is needed,
+// and the contributions are summed over each block before being added
+// to the coefficient array.
+
+namespace BasisClasses
+{
+  //! Mapping constants passed by value to the kernel
+  struct SphMapping
+  {
+    cuFP_t rscale, xmin, dxi, scale, rmin, rmax;
+    int numr, cmap;
+  };
+
+  __device__ static
+  cuFP_t slRtoXi(cuFP_t r, const SphMapping& c)
+  {
+    if (c.cmap==1) return (r/c.rscale-1.0)/(r/c.rscale+1.0);
+    if (c.cmap==2) return log(r);
+    return r;
+  }
+
+  __device__ static
+  cuFP_t slFetch(cudaTextureObject_t t, int i)
+  {
+#if cuREAL == 4
+    return tex1D<float>(t, i);
+#else
+    return int2_as_double(tex1D<int2>(t, i));
+#endif
+  }
+
+  //! Sum v over the block and add the result to *out.  Every thread
+  //! of the block must call this.
+  __device__ static
+  void slBlockAdd(cuFP_t v, cuFP_t* out)
+  {
+    __shared__ cuFP_t part[BLOCK_SIZE/32];
+
+    const int lane = threadIdx.x % 32, warp = threadIdx.x / 32;
+
+    for (int off=16; off>0; off/=2) v += __shfl_down_sync(0xffffffff, v, off);
+    if (lane==0) part[warp] = v;
+    __syncthreads();
+
+    if (warp==0) {
+      v = lane < blockDim.x/32 ? part[lane] : 0.0;
+      for (int off=16; off>0; off/=2) v += __shfl_down_sync(0xffffffff, v, off);
+      if (lane==0) atomicAdd(out, v);
+    }
+    __syncthreads();
+  }
+
+  __global__ static void
+  slCoefKernel(dArray<cuFP_t> pos, dArray<cuFP_t> mass,
+	       dArray<cudaTextureObject_t> tex, dArray<cuFP_t> fac,
+	       dArray<cuFP_t> coef, dArray<cuFP_t> used,
+	       SphMapping c, int lmax, int nmax, int N)
+  {
+    const int i = blockDim.x * blockIdx.x + threadIdx.x;
+    const cuFP_t norm = -4.0*M_PI;
+
+    // Off-grid and padding threads contribute zero but still take part
+    // in the block sums
+    //
+    cuFP_t wgt = 0.0, x = 0.0, cosph = 1.0, sinph = 0.0, a = 1.0, p0 = 0.0;
+    int ind = 0;
+
+    if (i < N) {
+      cuFP_t xx = pos._v[3*i+0], yy = pos._v[3*i+1], zz = pos._v[3*i+2];
+      cuFP_t r  = sqrt(xx*xx + yy*yy + zz*zz) + 1.0e-20;
+
+      if (r >= c.rmin and r <= c.rmax) {
+	wgt = mass._v[i];
+	x   = zz/r;
+
+	cuFP_t phi = atan2(yy, xx);
+	cosph = cos(phi);
+	sinph = sin(phi);
+
+	cuFP_t xi = (slRtoXi(r/c.scale, c) - c.xmin)/c.dxi;
+	ind = floor(xi);
+	if (ind<0) ind = 0;
+	if (ind>c.numr-2) ind = c.numr - 2;
+
+	a  = cuFP_t(ind+1) - xi;
+	p0 = a*slFetch(tex._v[0], ind) + (1.0-a)*slFetch(tex._v[0], ind+1);
+      }
+    }
+
+    slBlockAdd(wgt > 0.0 ? 1.0 : 0.0, &used._v[0]);
+    slBlockAdd(wgt, &used._v[1]);
+
+    const cuFP_t b = 1.0 - a;
+    const cuFP_t somx2 = sqrt((1.0 - x)*(1.0 + x));
+
+    cuFP_t pmm = 1.0, fact = 1.0;	// P_m^m
+    cuFP_t cm  = 1.0, sm = 0.0;	// cos(m phi), sin(m phi)
+
+    for (int m=0; m<=lmax; m++) {
+
+      if (m>0) {
+	pmm  *= -fact*somx2;
+	fact += 2.0;
+	cuFP_t t = cm*cosph - sm*sinph;
+	sm = sm*cosph + cm*sinph;
+	cm = t;
+      }
+
+      cuFP_t pl2 = 0.0, pl1 = pmm;
+
+      for (int l=m; l<=lmax; l++) {
+
+	cuFP_t plm;			// P_l^m by upward recursion
+	if      (l==m)   plm = pmm;
+	else if (l==m+1) plm = x*(2*m+1)*pmm;
+	else             plm = (x*(2*l-1)*pl1 - (l+m-1)*pl2)/(l-m);
+
+	if (l>m) { pl2 = pl1; pl1 = plm; }
+
+	cuFP_t f = fac._v[l*(lmax+1)+m] * plm * p0 * norm * wgt;
+	int row  = m==0 ? l*l : l*l + 2*m - 1;
+
+	for (int n=0; n<nmax; n++) {
+	  int k = 1 + l*nmax + n;
+	  cuFP_t v = f*(a*slFetch(tex._v[k], ind) + b*slFetch(tex._v[k], ind+1));
+
+	  slBlockAdd(v*cm, &coef._v[row*nmax + n]);
+	  if (m>0) slBlockAdd(v*sm, &coef._v[(row+1)*nmax + n]);
+	}
+      }
+    }
+  }
+
+  void SphericalSL::accumulateDevice(const Eigen::MatrixXd& pos,
+				     const Eigen::VectorXd& mass)
+  {
+    const int N = pos.cols();
+    if (N==0) return;
+
+    // Copy the tables to the device on first use
+    //
+    if (tex.size()==0) sl->initialize_cuda(cuArray, tex);
+
+    cudaMappingConstants f = sl->getCudaMappingConstants();
+    SphMapping c {f.rscale, f.xmin, f.dxi, scale, rmin, rmax, f.numr, f.cmapR};
+
+    thrust::host_vector<cuFP_t> h_pos(pos.data(), pos.data() + 3*N);
+    thrust::host_vector<cuFP_t> h_mass(mass.data(), mass.data() + N);
+    thrust::host_vector<cuFP_t> h_fac((lmax+1)*(lmax+1), 0.0);
+
+    for (int l=0; l<=lmax; l++)
+      for (int m=0; m<=l; m++) h_fac[l*(lmax+1)+m] = factorial(l, m);
+
+    thrust::device_vector<cuFP_t> d_pos = h_pos, d_mass = h_mass, d_fac = h_fac;
+    thrust::device_vector<cuFP_t> d_coef((lmax+1)*(lmax+1)*nmax, 0.0);
+    thrust::device_vector<cuFP_t> d_used(2, 0.0);
+    thrust::device_vector<cudaTextureObject_t> d_tex = tex;
+
+    unsigned int gridSize = (N + BLOCK_SIZE - 1)/BLOCK_SIZE;
+
+    slCoefKernel<<<gridSize, BLOCK_SIZE>>>
+      (toKernel(d_pos), toKernel(d_mass), toKernel(d_tex), toKernel(d_fac),
+       toKernel(d_coef), toKernel(d_used), c, lmax, nmax, N);
+
+    cuda_safe_call(cudaGetLastError(), __FILE__, __LINE__,
+		   "SphericalSL::accumulateDevice: kernel launch");
+
+    thrust::host_vector<cuFP_t> h_coef = d_coef, h_used = d_used;
+
+    // Add to the first thread's tables; make_coefs() does the rest
+    //
+    auto & coef = expcoefT[0];
+    for (int j=0; j<coef.rows(); j++)
+      for (int n=0; n<nmax; n++) coef(j, n) += h_coef[j*nmax + n];
+
+    usedT[0] += static_cast<int>(h_used[0] + 0.5);
+    massT[0] += h_used[1];
+  }
+
+  void SphericalSL::cuda_destroy()
+  {
+    for (auto t : tex) if (t) cudaDestroyTextureObject(t);
+    for (auto a : cuArray) if (a) cudaFreeArray(a);
+    tex.clear();
+    cuArray.clear();
+  }
+}
@@ -6,17 +6,23 @@
 // Halko, Martinsson, and Tropp by default.  Use BDCSVD or Jacobi
 // flags for the standard methods.  Using the randomized method
 // together with trajectory matrix rather than covariance matrix
-// analysis may lead to large errors in eigenvectors.
+// analysis may lead to large errors in eigenvectors.  The GPU flag
+// computes the randomized SVD on the device with cuSOLVER.
 //
 
 #include <filesystem>
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <memory>
+#include <random>
 #include <limits>
+#include <numeric>
+#include <utility>
 #include <cmath>
 #include <map>
 
@@ -34,12 +40,16 @@
 */
 
 #include <omp.h>
+#include <mpi.h>
 
 #include <KMeans.H>
 
 #include <expMSSA.H>
 
 #include <RedSVD.H>
+#include <cudaSVD.H>
+#include <HankelOperator.H>
+#include <StateHash.H>
 #include <YamlConfig.H>
 #include <YamlCheck.H>
 #include <EXPException.H>
@@ -65,6 +75,111 @@ namespace MSSA {
   (const Eigen::MatrixXd& X,
    const Eigen::MatrixXd& U, const Eigen::VectorXd& S, Eigen::MatrixXd& V);
 
+  // Update sign of right vectors V only from the data projections
+  void SvdSignChoice
+  (const Eigen::MatrixXd& XtU, const Eigen::MatrixXd& XV, Eigen::MatrixXd& V);
+
+  //! W-correlation matrix of the leading nPC columns summed over the
+  //! given reconstructions.  The weighted Gram matrix is a single
+  //! product of the stacked, sqrt(weight)-scaled columns.  The window
+  //! defaults to the number of columns.
+  static Eigen::MatrixXd wCorrGram
+  (const std::vector<const Eigen::MatrixXd*>& RC, int nPC, int window=0)
+  {
+    int numT   = RC[0]->rows();
+    int numW   = window>0 ? window : RC[0]->cols();
+    int Lstar  = std::min<int>(numT - numW, numW);
+    int Kstar  = std::max<int>(numT - numW, numW);
+
+    // The weight function
+    Eigen::VectorXd w(numT);
+    for (int i=0; i<numT; i++) {
+      if      (i < Lstar) w(i) = i;
+      else if (i < Kstar) w(i) = Lstar;
+      else                w(i) = numT - i + 1;
+    }
+    w = w.cwiseSqrt();
+
+    int rank = std::min<int>({nPC, numW, static_cast<int>(RC[0]->cols())});
+
+    Eigen::MatrixXd M(numT*RC.size(), rank);
+    for (size_t n=0; n<RC.size(); n++)
+      M.middleRows(numT*n, numT) = w.asDiagonal() * RC[n]->leftCols(rank);
+
+    Eigen::MatrixXd ret(rank, rank);
+    ret.setZero();
+    ret.selfadjointView<Eigen::Lower>().rankUpdate(M.transpose());
+
+    // Normalize, with unit diagonal
+    //
+    Eigen::VectorXd d = ret.diagonal();
+    for (int m=0; m<rank; m++) {
+      for (int n=0; n<m; n++) {
+	if (d(m)>0.0 and d(n)>0.0) ret(m, n) /= sqrt(d(m)*d(n));
+	ret(n, m) = ret(m, n);
+      }
+      ret(m, m) = 1.0;
+    }
+
+    return ret;
+  }
+
+  //! Reconstructed series of the given components for each channel
+  //! block of the eigenvectors U with window numW.  Column w of rc[n]
+  //! holds component w of channel n.
+  static void diagonalAverage(const Eigen::MatrixXd& PC,
+			      const Eigen::MatrixXd& U, int numT, int numW,
+			      const std::vector<int>& comps,
+			      std::vector<Eigen::MatrixXd*>& rc)
+  {
+    const int numK  = numT - numW + 1;
+    const int nkeys = rc.size();
+    const int ncs   = comps.size();
+
+    // Each RC column is the convolution of a PC with the channel
+    // block of its eigenvector, divided by the number of terms on
+    // the antidiagonal.  Direct sums are cheaper for short windows.
+    //
+    const bool useFFT = numW > 32;
+
+    std::unique_ptr<MSSA::FFTConvolver> fft;
+    std::vector<MSSA::FFTConvolver::Spectrum> P(PC.cols());
+
+    if (useFFT) {
+      fft = std::make_unique<MSSA::FFTConvolver>(numT);
+#pragma omp parallel for
+      for (int c=0; c<ncs; c++)
+	P[comps[c]] = fft->transform(PC.col(comps[c]).data(), numK);
+    }
+
+    auto weight = [&](int i)
+    {
+      if (i<numW)           return 1.0/(1.0 + i); // Lower
+      else if (i<numT-numW) return 1.0/numW;      // Middle
+      else                  return 1.0/(numT - i); // Upper
+    };
+
+#pragma omp parallel for schedule(dynamic)
+    for (int q=0; q<nkeys*ncs; q++) {
+      int n = q / ncs, w = comps[q % ncs];
+
+      const double* rho = U.col(w).data() + numW*n;
+      double* out = rc[n]->col(w).data();
+
+      if (useFFT) {
+	fft->convolve(P[w], rho, numW, out, numT);
+	for (int i=0; i<numT; i++) out[i] *= weight(i);
+      } else {
+	for (int i=0; i<numT; i++) {
+	  int L = std::max<int>(0, i - numK + 1), H = std::min<int>(i, numW-1);
+	  double sum = 0.0;
+	  for (int j=L; j<=H; j++) sum += PC(i - j, w) * rho[j];
+	  out[i] = sum * weight(i);
+	}
+      }
+    }
+  }
+
   Eigen::MatrixXd expMSSA::wCorrKey(const Key& key, int nPC)
   {
     if (RC.find(key)==RC.end()) {
@@ -87,49 +202,7 @@ namespace MSSA {
       nlast = ncomp;
     }
 
-    auto R     = RC[key];
-
-    int numT   = R.rows();
-    int numW   = R.cols();
-    int Lstar  = std::min<int>(numT - numW, numW);
-    int Kstar  = std::max<int>(numT - numW, numW);
-
-    // A Lambda for the weight function
-    auto w = [&](int i) {
-      if      (i < Lstar) return i;
-      else if (i < Kstar) return Lstar;
-      else                return numT - i + 1;
-    };
-
-    int rank = std::min<int>(nPC, numW);
-
-    Eigen::MatrixXd ret = Eigen::MatrixXd::Zero(rank, rank);
-    for (int m=0; m<rank; m++) {
-      for (int n=m; n<rank; n++) {
-	for (int i=0; i<numT; i++) ret(m, n) += w(i) * R(i, m)*R(i, n);
-      }
-    }
-
-    // Normalize
-    //
-    for (int m=0; m<rank; m++) {
-      for (int n=m+1; n<rank; n++) {
-	if (ret(m, m)>0.0 and ret(n, n)>0.0)
-	  ret(m, n) /= sqrt(ret(m, m)*ret(n, n));
-      }
-    }
-
-    // Unit diagonal
-    //
-    for (int m=0; m<rank; m++) ret(m, m) = 1.0;
-
-    // Complete
-    //
-    for (int m=0; m<rank; m++) {
-      for (int n=0; n<m; n++) ret(m, n) = ret(n, m);
-    }
-
-    return ret;
+    return wCorrGram({&RC[key]}, nPC);
   }
 
 
@@ -151,50 +224,10 @@ namespace MSSA {
       nlast = ncomp;
     }
 
-    int numT   = RC.begin()->second.rows();
-    int numW   = RC.begin()->second.cols();
-    int Lstar  = std::min<int>(numT - numW, numW);
-    int Kstar  = std::max<int>(numT - numW, numW);
-
-    // A Lambda for the weight function
-    auto w = [&](int i) {
-      if      (i < Lstar) return i;
-      else if (i < Kstar) return Lstar;
-      else                return numT - i + 1;
-    };
-
-    int rank = std::min<int>(nPC, numW);
-
-    Eigen::MatrixXd ret = Eigen::MatrixXd::Zero(rank, rank);
-    for (auto R : RC) {
-      for (int m=0; m<rank; m++) {
-	for (int n=m; n<rank; n++) {
-	  for (int i=0; i<numT; i++)
-	    ret(m, n) += w(i) * R.second(i, m)*R.second(i, n);
-	}
-      }
-    }
-
-    // Normalize
-    //
-    for (int m=0; m<rank; m++) {
-      for (int n=m+1; n<rank; n++) {
-	if (ret(m, m)>0.0 and ret(n, n)>0.0)
-	  ret(m, n) /= sqrt(ret(m, m)*ret(n, n));
-      }
-    }
-
-    // Unit diagonal
-    //
-    for (int m=0; m<rank; m++) ret(m, m) = 1.0;
-
-    // Complete
-    //
-    for (int m=0; m<rank; m++) {
-      for (int n=0; n<m; n++) ret(m, n) = ret(n, m);
-    }
+    std::vector<const Eigen::MatrixXd*> R;
+    for (auto & u : RC) R.push_back(&u.second);
 
-    return ret;
+    return wCorrGram(R, nPC);
   }
 
   Eigen::MatrixXd expMSSA::wCorr
@@ -265,6 +298,22 @@ namespace MSSA {
 
     numK = numT - numW + 1;
 
+    // Distributed mode: each rank holds a block of channels
+    //
+    if (params["MPI"]) {
+      mpi_analysis();
+      writeCache();
+      return;
+    }
+
+    // Operator mode: the trajectory matrix is never formed
+    //
+    if (params["Hankel"]) {
+      hankel_analysis();
+      writeCache();
+      return;
+    }
+
     Y.resize(numK, numW*nkeys);
     Y.fill(0.0);
 
@@ -375,15 +424,25 @@ namespace MSSA {
     } else {
       // -->Use Random approximation algorithm from Halko, Martinsson,
       //    and Tropp
+      Eigen::MatrixXd UU, VV;
       if (trajectory) {		// Trajectory matrix
-	auto YY = Y/Scale;
-	RedSVD::RedSVD<Eigen::MatrixXd> svd(YY, srank);
-	S = svd.singularValues();
-	U = svd.matrixV();
-	if (useSignChoice) SvdSignChoice(YY, svd.matrixU(), S, U);
+	Eigen::MatrixXd YY = Y/Scale;
+	if (useGPU and cudaRandomizedSVD(YY, srank, S, UU, VV)) {
+	  U = VV;
+	  if (useSignChoice) SvdSignChoice(YY, std::as_const(UU), S, U);
+	} else {
+	  RedSVD::RedSVD<Eigen::MatrixXd> svd(YY, srank);
+	  S = svd.singularValues();
+	  U = svd.matrixV();
+	  if (useSignChoice) SvdSignChoice(YY, svd.matrixU(), S, U);
+	}
       }
       else {			// Covariance matrix
-	if (params["RedSym"]) {
+	if (useGPU and not params["RedSym"] and
+	    cudaRandomizedSVD(cov, srank, S, UU, VV)) {
+	  U = UU;
+	  if (useSignChoice) SvdSignChoice(cov, U, S, U.transpose());
+	} else if (params["RedSym"]) {
 	  RedSVD::RedSymEigen<Eigen::MatrixXd> eigen(cov, srank);
 	  S = eigen.eigenvalues().reverse();
 	  U = eigen.eigenvectors().rowwise().reverse();
@@ -422,6 +481,383 @@ namespace MSSA {
     computed      = true;
     fullRecon     = false;
     reconstructed = false;
+
+    writeCache();
+  }
+
+  void expMSSA::hankel_analysis()
+  {
+    std::vector<const std::vector<double>*> chan;
+    for (auto k : mean) chan.push_back(&data[k.first]);
+
+    HankelOperator op(chan, numW);
+
+    // The trajectory matrix is not kept
+    //
+    Y.resize(0, 0);
+
+    // The rank defaults to the number of PCs here since the point is
+    // to avoid work proportional to the full trajectory matrix
+    //
+    int srank = std::min<int>(op.rows(), op.cols());
+    if (params["rank"])
+      srank = std::min<int>(srank, params["rank"].as<int>());
+    else
+      srank = std::min<int>(srank, npc);
+
+    npc = std::min<int>(npc, srank);
+
+    int iter = 2;
+    if (params["HankelIter"]) iter = params["HankelIter"].as<int>();
+
+    double Scale = op.norm();
+
+    if (Scale<=0.0) {
+      std::cout << "Frobenius norm of trajectory matrix is <= 0!" << std::endl;
+      exit(-1);
+    }
+
+    HankelSVD svd(op, srank, iter);
+
+    S = svd.singularValues();
+    U = svd.matrixV();
+
+    // Compute the PCs by projecting the data
+    //
+    PC = op.apply(U);
+
+    if (useSignChoice) {
+      Eigen::MatrixXd U0 = U;
+      SvdSignChoice(op.adjoint(svd.matrixU()), PC, U);
+      for (int k=0; k<U.cols(); k++)
+	if (U.col(k).dot(U0.col(k)) < 0.0) PC.col(k) *= -1.0;
+    }
+
+    std::cout << "shape U = " << U.rows() << " x "
+	      << U.cols() << std::endl;
+
+    std::cout << "shape Y = " << op.rows() << " x "
+	      << op.cols() << " (implicit)" << std::endl;
+
+    for (int i=0; i<S.size(); i++) S(i) = S(i)*S(i)/numK;
+
+    npc = std::min<int>(npc, numW*nkeys);
+
+    computed      = true;
+    fullRecon     = false;
+    reconstructed = false;
+  }
+
+  //! Resample the channel blocks of the columns of V from window W0
+  //! to window W1 by linear interpolation in the lag
+  static Eigen::MatrixXd resampleWindow(const Eigen::MatrixXd& V,
+					int W0, int W1, int nkeys)
+  {
+    Eigen::MatrixXd ret(W1*nkeys, V.cols());
+
+    for (int c=0; c<V.cols(); c++) {
+      for (int n=0; n<nkeys; n++) {
+	for (int j=0; j<W1; j++) {
+	  double x = W1>1 ? static_cast<double>(j)*(W0-1)/(W1-1) : 0.0;
+	  int    i = std::min<int>(static_cast<int>(x), W0-2);
+	  if (i<0) {
+	    ret(W1*n+j, c) = V(W0*n, c);
+	  } else {
+	    double a = x - i;
+	    ret(W1*n+j, c) = (1.0 - a)*V(W0*n+i, c) + a*V(W0*n+i+1, c);
+	  }
+	}
+      }
+    }
+
+    return ret;
+  }
+
+  std::map<int, std::tuple<Eigen::VectorXd, Eigen::MatrixXd>>
+  expMSSA::windowSweep(const std::vector<int>& windows, int nPC)
+  {
+    if (nPC<2) {
+      throw std::runtime_error("expMSSA::windowSweep: nPC must be >= 2 for a meaningful correlation");
+    }
+
+    // Valid windows in increasing order
+    //
+    std::vector<int> wins;
+    for (auto w : windows) if (w>1 and w<=numT/2) wins.push_back(w);
+    std::sort(wins.begin(), wins.end());
+    wins.erase(std::unique(wins.begin(), wins.end()), wins.end());
+
+    if (wins.empty()) {
+      throw std::runtime_error("expMSSA::windowSweep: no window in [2, numT/2]");
+    }
+
+    // The channel transforms are made once for all windows
+    //
+    std::vector<const std::vector<double>*> chan;
+    for (auto k : mean) chan.push_back(&data[k.first]);
+
+    const int nchan = chan.size();
+
+    HankelOperator op(chan, wins[0]);
+
+    int iter = 2;
+    if (params["HankelIter"]) iter = params["HankelIter"].as<int>();
+
+    std::map<int, std::tuple<Eigen::VectorXd, Eigen::MatrixXd>> ret;
+    Eigen::MatrixXd Vlast;
+    int Wlast = 0;
+
+    for (auto W : wins) {
+
+      op.setWindow(W);
+      const int K = numT - W + 1;
+
+      int srank = std::min<int>({op.rows(), op.cols(), npc});
+      if (params["rank"])
+	srank = std::min<int>(srank, params["rank"].as<int>());
+
+      // Warm start from the subspace of the previous window with one
+      // subspace iteration fewer
+      //
+      Eigen::MatrixXd start;
+      if (Wlast) start = resampleWindow(Vlast, Wlast, W, nchan);
+
+      HankelSVD svd(op, srank, Wlast ? std::max<int>(iter-1, 1) : iter,
+		    10, start);
+
+      Eigen::VectorXd ev = svd.singularValues();
+      for (int i=0; i<ev.size(); i++) ev(i) = ev(i)*ev(i)/K;
+
+      Eigen::MatrixXd V  = svd.matrixV();
+      Eigen::MatrixXd pc = op.apply(V);
+
+      // W-correlation of the leading components over all channels
+      //
+      int nc = std::min<int>({nPC, W, static_cast<int>(V.cols())});
+
+      std::vector<int> comps(nc);
+      std::iota(comps.begin(), comps.end(), 0);
+
+      std::vector<Eigen::MatrixXd> rc(nchan, Eigen::MatrixXd::Zero(numT, nc));
+      std::vector<Eigen::MatrixXd*> prc;
+      for (auto & m : rc) prc.push_back(&m);
+
+      diagonalAverage(pc, V, numT, W, comps, prc);
+
+      std::vector<const Eigen::MatrixXd*> R(prc.begin(), prc.end());
+
+      ret[W] = {ev, wCorrGram(R, nc, W)};
+
+      if (verbose)
+	std::cout << "expMSSA::windowSweep: window=" << W
+		  << " rank=" << ev.size() << std::endl;
+
+      Vlast = V;
+      Wlast = W;
+    }
+
+    return ret;
+  }
+
+  //! Thin QR of a matrix distributed over ranks by row blocks (TSQR).
+  //! Returns the local rows of Q; R is the same on every rank.
+  static Eigen::MatrixXd tsqr(const Eigen::MatrixXd& A, Eigen::MatrixXd& R,
+			      bool use_mpi, int np, int id)
+  {
+    const int l = A.cols();
+
+    // Local factorization, padded to l columns of Q and l rows of R
+    //
+    Eigen::MatrixXd Q0 = Eigen::MatrixXd::Zero(A.rows(), l);
+    Eigen::MatrixXd R0 = Eigen::MatrixXd::Zero(l, l);
+
+    if (A.rows()) {
+      int k = std::min<int>(A.rows(), l);
+      Eigen::HouseholderQR<Eigen::MatrixXd> qr(A);
+      Q0.leftCols(k) = qr.householderQ() * Eigen::MatrixXd::Identity(A.rows(), k);
+      R0.topRows(k)  = qr.matrixQR().topRows(k).triangularView<Eigen::Upper>();
+    }
+
+    // Factor the stacked R blocks, identically on every rank
+    //
+    std::vector<double> buf(l*l*np);
+    if (use_mpi)
+      MPI_Allgather(R0.data(), l*l, MPI_DOUBLE, buf.data(), l*l, MPI_DOUBLE,
+		    MPI_COMM_WORLD);
+    else
+      std::copy(R0.data(), R0.data() + l*l, buf.begin());
+
+    Eigen::MatrixXd Rall(l*np, l);
+    for (int p=0; p<np; p++)
+      Rall.middleRows(l*p, l) = Eigen::Map<Eigen::MatrixXd>(buf.data() + l*l*p, l, l);
+
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(Rall);
+    Eigen::MatrixXd Qh = qr.householderQ() * Eigen::MatrixXd::Identity(l*np, l);
+    R = qr.matrixQR().topRows(l).triangularView<Eigen::Upper>();
+
+    return Q0 * Qh.middleRows(l*id, l);
+  }
+
+  void expMSSA::mpi_analysis()
+  {
+    int use_mpi;
+    MPI_Initialized(&use_mpi);
+
+    int np = 1, id = 0;
+    if (use_mpi) {
+      MPI_Comm_size(MPI_COMM_WORLD, &np);
+      MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    }
+
+    // Contiguous block of channels for this rank
+    //
+    std::vector<int> first(np+1);
+    for (int p=0; p<=np; p++) first[p] = static_cast<long>(nkeys)*p/np;
+
+    const int nloc = first[id+1] - first[id];
+
+    // Local columns of the trajectory matrix
+    //
+    Eigen::MatrixXd Yp(numK, numW*nloc);
+    {
+      int n = 0;
+      for (auto k : mean) {
+	if (n >= first[id] and n < first[id+1]) {
+	  int c = numW*(n - first[id]);
+	  auto & x = data[k.first];
+	  for (int j=0; j<numW; j++) {
+	    for (int i=0; i<numK; i++) Yp(i, c+j) = x[i + j];
+	  }
+	}
+	n++;
+      }
+    }
+
+    // The full trajectory matrix is not kept
+    //
+    Y.resize(0, 0);
+
+    auto allsum = [&](double* p, int n)
+    {
+      if (use_mpi)
+	MPI_Allreduce(MPI_IN_PLACE, p, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    };
+
+    // Gather row blocks of a matrix distributed like the columns of Y
+    //
+    auto gather = [&](const Eigen::MatrixXd& A)
+    {
+      const int nc = A.cols();
+      Eigen::MatrixXd At = A.transpose(), ret(nc, numW*nkeys);
+
+      if (use_mpi) {
+	std::vector<int> cnts(np), disp(np);
+	for (int p=0; p<np; p++) {
+	  cnts[p] = nc*numW*(first[p+1] - first[p]);
+	  disp[p] = nc*numW*first[p];
+	}
+	MPI_Allgatherv(At.data(), At.size(), MPI_DOUBLE,
+		       ret.data(), cnts.data(), disp.data(), MPI_DOUBLE,
+		       MPI_COMM_WORLD);
+      } else {
+	ret = At;
+      }
+
+      return Eigen::MatrixXd(ret.transpose());
+    };
+
+    const int ncols = numW*nkeys;
+
+    double norm2 = Yp.squaredNorm();
+    allsum(&norm2, 1);
+
+    if (norm2<=0.0) {
+      std::cout << "Frobenius norm of trajectory matrix is <= 0!" << std::endl;
+      exit(-1);
+    }
+
+    // As in operator mode, the rank defaults to the number of PCs
+    //
+    int m = std::min<int>(numK, ncols);
+    int srank = std::min<int>(m, npc);
+    if (params["rank"])
+      srank = std::min<int>(m, params["rank"].as<int>());
+
+    srank = std::max<int>(1, srank);
+    npc   = std::min<int>(npc, srank);
+
+    int iter = 2;
+    if (params["HankelIter"]) iter = params["HankelIter"].as<int>();
+
+    const int r = std::min<int>(srank + 10, m);
+
+    // Gaussian test matrix with a fixed seed.  Every rank draws the
+    // full matrix so the result does not depend on the rank count.
+    //
+    std::mt19937 gen(11);
+    std::normal_distribution<double> normal;
+
+    const int c0 = numW*first[id], c1 = numW*first[id+1];
+    Eigen::MatrixXd Omega(c1 - c0, r);
+    for (int j=0; j<r; j++) {
+      for (int i=0; i<ncols; i++) {
+	double z = normal(gen);
+	if (i>=c0 and i<c1) Omega(i-c0, j) = z;
+      }
+    }
+
+    // Range finder with subspace iterations.  Products with Y are
+    // sums of the local products; products with Y^T stay local.
+    //
+    auto range = [&](const Eigen::MatrixXd& W)
+    {
+      Eigen::MatrixXd Z = Yp * W;
+      allsum(Z.data(), Z.size());
+      Eigen::HouseholderQR<Eigen::MatrixXd> qr(Z);
+      return Eigen::MatrixXd(qr.householderQ() * Eigen::MatrixXd::Identity(numK, r));
+    };
+
+    Eigen::MatrixXd R, Q = range(Omega);
+
+    for (int q=0; q<iter; q++) Q = range(tsqr(Yp.transpose()*Q, R, use_mpi, np, id));
+
+    // B^T = Y^T Q = Qb R is distributed by rows; the SVD of the small
+    // factor R gives that of B
+    //
+    Eigen::MatrixXd Qb = tsqr(Yp.transpose()*Q, R, use_mpi, np, id);
+
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(R, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+    S = svd.singularValues().head(srank);
+    U = gather(Qb * svd.matrixU().leftCols(srank));
+
+    // Left singular vectors and PCs, replicated
+    //
+    Eigen::MatrixXd L = Q * svd.matrixV().leftCols(srank);
+    PC = L * S.asDiagonal();
+
+    if (useSignChoice) {
+      Eigen::MatrixXd U0 = U;
+      SvdSignChoice(gather(Yp.transpose()*L), PC, U);
+      for (int k=0; k<U.cols(); k++)
+	if (U.col(k).dot(U0.col(k)) < 0.0) PC.col(k) *= -1.0;
+    }
+
+    if (id==0) {
+      std::cout << "shape U = " << U.rows() << " x "
+		<< U.cols() << std::endl;
+
+      std::cout << "shape Y = " << numK << " x "
+		<< ncols << " (" << np << " ranks)" << std::endl;
+    }
+
+    for (int i=0; i<S.size(); i++) S(i) = S(i)*S(i)/numK;
+
+    npc = std::min<int>(npc, numW*nkeys);
+
+    computed      = true;
+    fullRecon     = false;
+    reconstructed = false;
   }
 
   void expMSSA::reconstruct(const std::vector<int>& evlist)
@@ -430,13 +866,6 @@ namespace MSSA {
     //
     if (not computed) mssa_analysis();
 
-    // Use the OpenMP implementation
-    const bool useOpenMP  = true;
-
-    // Some speed up by reordering memory access at the expense of
-    // some memory
-    const bool useReverse = false;
-
     // Reconstructed time series
     //
     ncomp = std::min<int>({numW, npc, static_cast<int>(PC.cols())});
@@ -447,6 +876,8 @@ namespace MSSA {
 
     auto lsz = evlist.size();
 
+    evlast = evlist;
+
     if (lsz) {
       for (auto v : evlist) if (v<ncomp) I[v] = true;
     }
@@ -458,125 +889,145 @@ namespace MSSA {
 
     if (lsz) {
 
-      // Embedded time series matrix
+      // Channels in the order of the eigenvector blocks
       //
-      Eigen::MatrixXd Z;
-      if (useReverse) Z.resize(numT, numW);
+      std::vector<Eigen::MatrixXd*> rc;
+      for (auto & u : mean) rc.push_back(&RC[u.first]);
 
-      // Split eigenvectors into channel sequences
+      // Selected components
       //
-      std::map<Key, Eigen::MatrixXd, mSSAkeyCompare> rho;
+      std::vector<int> comps;
+      for (int w=0; w<ncomp; w++) if (I[w]) comps.push_back(w);
 
-      int n = 0;
-      for (auto u : mean) {
-	rho[u.first].resize(numW, ncomp);
-	rho[u.first].fill(0.0);
-	for (int i=0; i<numW; i++) {
-	  for (int j=0; j<ncomp; j++)
-	    if (I[j]) rho[u.first](i, j) = U(numW*n + i, j);
-	}
-	n++;
-      }
+      diagonalAverage(PC, U, numT, numW, comps, rc);
+    }
 
-#pragma omp parallel
-      if (useOpenMP) {
-	// Parallelize the map iteration by wrapping it in a standard loop.
-	// Ungainly for sure but it works.
-	//
-	int thread_count = omp_get_num_threads();
-	int thread_num   = omp_get_thread_num();
-	size_t map_size  = mean.size();
-
-	auto u = mean.begin();
-	for (int i=0; i<thread_num and u!=mean.end(); i++) u++;
-
-	for (int q=thread_num; q<map_size; q+=thread_count) {
-
-	  for (int w=0; w<ncomp; w++) {
-
-	    // Choose limits and weight
-	    //
-	    for (int i=0; i<numT; i++) {
-	      double W;
-	      int L, U;
-
-	      if (i<numW) {		// Lower
-		W = 1.0/(1.0 + i);
-		L = 0;
-		U = i + 1;
-	      } else if (i<numT-numW) { // Middle
-		W = 1.0/numW;
-		L = 0;
-		U = numW;
-	      } else {		// Upper
-		W = 1.0/(numT - i);
-		L = i - numT + numW;
-		U = numW;
-	      }
+    fullRecon = false;
+    reconstructed = true;
+  }
 
-	      RC[u->first](i, w) = 0.0;
-	      for (int j=L; j<U; j++) {
-		RC[u->first](i, w) += PC(i - j, w) * rho[u->first](j, w) * W;
-	      }
-	    }
-	  }
+  void expMSSA::update(const mssaConfig& config)
+  {
+    CoefContainer db(config, cflags);
+
+    // The new times must extend the current series
+    //
+    const size_t T0 = numT, T1 = db.times.size();
+
+    if (T1 < T0)
+      throw std::runtime_error("expMSSA::update: fewer times than the current series");
+
+    for (size_t t=0; t<T0; t++) {
+      double dt = std::fabs(db.times[t] - coefDB.times[t]);
+      if (dt > 1.0e-8*std::max<double>(1.0, std::fabs(coefDB.times[t])))
+	throw std::runtime_error("expMSSA::update: times do not extend the current series");
+    }
+
+    if (T1 == T0) return;
 
-	  if (q+thread_count < map_size) std::advance(u, thread_count);
+    // Detrend the new values as in the constructor with the original
+    // normalization
+    //
+    for (auto & u : mean) {
+      Key k = u.first;
+      auto v = db.getData(k);
+
+      if (v.size() != T1)
+	throw std::runtime_error("expMSSA::update: channels do not match the analysis");
+
+      for (size_t t=T0; t<T1; t++) {
+	double y = v[t];
+	if (type == TrendType::totPow) {
+	  if (useMean) y -= mean[k];
+	  y /= totPow;
+	} else if (type == TrendType::totVar) {
+	  y -= mean[k];
+	  if (totVar>0.0) y /= totVar;
+	} else {
+	  y -= mean[k];
+	  if (var[k]>0.0) y /= var[k];
 	}
+	data[k].push_back(y);
       }
-      // The original serial implementation
-      //
-      else {
+    }
 
-	for (auto u : mean) {
+    coefDB = db;
+    computeFingerprint();
+    numT   = T1;
 
-	  for (int w=0; w<ncomp; w++) {
+    // The full analysis will see all of the data
+    //
+    if (not computed) return;
 
-	    // Build reverse embedded time series.
-	    //
-	    if (useReverse) {
-	      Z.fill(0.0);
-	      for (int j=0; j<numW; j++) {
-		for (int i=0; i<numT; i++)
-		  if (i - j >= 0 and i - j < numK) Z(i, j) = PC(i - j, w);
-	      }
-	    }
+    int numK0 = numK;
+    numK = numT - numW + 1;
 
-	    // Choose limits and weight
-	    //
-	    for (int i=0; i<numT; i++) {
-	      double W;
-	      int L, U;
-
-	      if (i<numW) {	// Lower
-		W = 1.0/(1.0 + i);
-		L = 0;
-		U = i + 1;
-	      } else if (i<numT-numW) { // Middle
-		W = 1.0/numW;
-		L = 0;
-		U = numW;
-	      } else {		// Upper
-		W = 1.0/(numT - i);
-		L = i - numT + numW;
-		U = numW;
-	      }
+    const int m = numK - numK0, ncol = numW*nkeys;
 
-	      RC[u.first](i, w) = 0.0;
-	      for (int j=L; j<U; j++) {
-		if (useReverse)
-		  RC[u.first](i, w) += Z(i, j) * rho[u.first](j, w) * W;
-		else
-		  RC[u.first](i, w) += PC(i - j, w) * rho[u.first](j, w) * W;
-	      }
-	    }
-	  }
+    // New lagged vectors as columns
+    //
+    Eigen::MatrixXd A(ncol, m);
+    {
+      int n = 0;
+      for (auto k : mean) {
+	auto & d = data[k.first];
+	for (int i=0; i<m; i++) {
+	  for (int j=0; j<numW; j++) A(numW*n + j, i) = d[numK0 + i + j];
 	}
+	n++;
       }
     }
 
+    // Singular values of the trajectory matrix from the eigenvalues
+    //
+    int r = std::min<int>(U.cols(), S.size());
+    Eigen::VectorXd s = (S.head(r)*numK0).cwiseMax(0.0).cwiseSqrt();
+
+    // Brand's update of Y^T = U s P^T by the new columns: project,
+    // orthonormalize the residual and rediagonalize the small core
+    //
+    Eigen::MatrixXd V0 = U.leftCols(r);
+    Eigen::MatrixXd M  = V0.transpose()*A;
+    Eigen::MatrixXd R  = A - V0*M;
+
+    int mr = std::min<int>(m, ncol);
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(R);
+    Eigen::MatrixXd J = qr.householderQ()*Eigen::MatrixXd::Identity(ncol, mr);
+    Eigen::MatrixXd K = J.transpose()*R;
+
+    Eigen::MatrixXd core = Eigen::MatrixXd::Zero(r+mr, r+m);
+    core.topLeftCorner(r, r)  = s.asDiagonal();
+    core.topRightCorner(r, m) = M;
+    core.bottomRightCorner(mr, m) = K;
+
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(core, Eigen::ComputeThinU);
+
+    Eigen::MatrixXd basis(ncol, r+mr);
+    basis << V0, J;
+
+    U = basis*svd.matrixU().leftCols(r);
+    S = svd.singularValues().head(r);
+    for (int i=0; i<r; i++) S(i) = S(i)*S(i)/numK;
+
+    // Keep the signs of the previous vectors for continuity
+    //
+    for (int k=0; k<r; k++)
+      if (U.col(k).dot(V0.col(k)) < 0.0) U.col(k) *= -1.0;
+
+    // The explicit trajectory matrix is no longer current
+    //
+    Y.resize(0, 0);
+
+    // Compute the PCs by projecting the data
+    //
+    std::vector<const std::vector<double>*> chan;
+    for (auto k : mean) chan.push_back(&data[k.first]);
+
+    PC = HankelOperator(chan, numW).apply(U);
+
     fullRecon = false;
-    reconstructed = true;
+
+    if (reconstructed) reconstruct(evlast);
   }
 
   // This computes an image of the contributions
@@ -603,55 +1054,34 @@ namespace MSSA {
     retF.resize(ncomp, mean.size());
     retG.resize(ncomp, mean.size());
 
-    int nk = 0;
-    retF.setZero();
-    for (auto u : mean) {
-      auto key = u.first;
-      for (int j=0; j<ncomp; j++) {
-	for (int i=0; i<numT; i++) {
-	  retF(j, nk) += RC[u.first](i, j)*RC[u.first](i, j);
-	}
-      }
-      nk++;
-    }
+    std::vector<const Eigen::MatrixXd*> rc;
+    for (auto & u : mean) rc.push_back(&RC[u.first]);
+    const int nk = rc.size();
+
+#pragma omp parallel for
+    for (int n=0; n<nk; n++)
+      retF.col(n) = rc[n]->leftCols(ncomp).colwise().squaredNorm().transpose();
 
     retG = retF;
 
     // This is norm for each series over the entire reconstruction
     // (that is, fixed coefficient channel, summed over all PCs)
 
-    Eigen::VectorXd norm(nk);
-    norm.setZero();
+    Eigen::VectorXd norm = retF.colwise().sum().transpose();
 
     for (int n=0; n<nk; n++) {
-      for (int j=0; j<ncomp; j++) {
-	norm[n] += retF(j, n);
-      }
+      if (norm[n]>0.0) retF.col(n) /= norm[n];
     }
+    retF = retF.cwiseSqrt();
 
-    for (int n=0; n<nk; n++) {
-      for (int j=0; j<ncomp; j++) {
-	if (norm[n]>0.0) retF(j, n) /= norm[n];
-	retF(j, n) = sqrt(retF(j, n));
-      }
-    }
-
-    norm.resize(ncomp);
-    norm.setZero();
-
-    for (int n=0; n<nk; n++) {
-      for (int j=0; j<ncomp; j++) {
-	norm[j] += retG(j, n);
-      }
-    }
+    // And over all channels for each PC
+    //
+    norm = retG.rowwise().sum();
 
-    for (int n=0; n<nk; n++) {
-      for (int j=0; j<ncomp; j++) {
-	if (norm[j]>0.0) retG(j, n) /= norm[j];
-	retG(j, n) = sqrt(retG(j, n));
-      }
+    for (int j=0; j<ncomp; j++) {
+      if (norm[j]>0.0) retG.row(j) /= norm[j];
     }
-
+    retG = retG.cwiseSqrt();
 
     return std::tuple<Eigen::MatrixXd, Eigen::MatrixXd>(retF, retG);
   }
@@ -1352,21 +1782,27 @@ namespace MSSA {
     //
     auto newdata = data;
 
-    for (int i=0; i<numT; i++) {
-      for (auto u : mean) {
-	double disp = totVar;
-	if (type == TrendType::totPow) disp = totPow;
-	if (disp==0.0) disp = var[u.first];
+    std::vector<Key> keys;
+    for (auto & u : mean) keys.push_back(u.first);
 
-	double acc = 0.0;
-	for (int j=0; j<ncomp; j++) acc += RC[u.first](i, j);
+    std::vector<std::vector<double>*> out;
+    for (auto & k : keys) out.push_back(&newdata[k]);
 
+#pragma omp parallel for
+    for (int n=0; n<static_cast<int>(keys.size()); n++) {
+      const Key& k = keys[n];
 
-  	newdata[u.first][i] = acc*disp;
-	if (reconstructmean) {
-	  if (useMean) newdata[u.first][i] += u.second;
-	}
-      }
+      double disp = totVar;
+      if (type == TrendType::totPow) disp = totPow;
+      if (disp==0.0) disp = var.at(k);
+
+      double off = 0.0;
+      if (reconstructmean and useMean) off = mean.at(k);
+
+      Eigen::VectorXd acc = RC.at(k).leftCols(ncomp).rowwise().sum();
+
+      auto & v = *out[n];
+      for (int i=0; i<numT; i++) v[i] = acc(i)*disp + off;
     }
 
     // Copy to the working data
@@ -1388,6 +1824,10 @@ namespace MSSA {
     "Jacobi",
     "BDCSVD",
     "Traj",
+    "Hankel",
+    "HankelIter",
+    "MPI",
+    "cache",
     "RedSym",
     "rank",
     "Sign",
@@ -1399,7 +1839,8 @@ namespace MSSA {
     "output",
     "totVar",
     "totPow",
-    "noMean"
+    "noMean",
+    "GPU"
   };
 
   void expMSSA::assignParameters(const std::string flags)
@@ -1429,6 +1870,15 @@ namespace MSSA {
       verbose  = bool(params["verbose"   ]);
       flip     = bool(params["flip"      ]);
       powerf   = bool(params["power"     ]);
+      useGPU   = bool(params["GPU"       ]);
+
+#if HAVE_LIBCUDA==0
+      if (useGPU) {
+	std::cout << "---- expMSSA: this build has no CUDA support, "
+		  << "using the CPU SVD" << std::endl;
+	useGPU = false;
+      }
+#endif
 
       if (params["evtol"]  ) evtol    = params["evtol"].as<double>();
       else                   evtol    = 0.01;
@@ -1445,6 +1895,104 @@ namespace MSSA {
   }
 
 
+  void expMSSA::computeFingerprint()
+  {
+    StateHash hash;
+
+    hash.add(stateVersion);
+    hash.add(numW);
+    hash.add(npc);
+    hash.add(trajectory);
+    hash.add(useSignChoice);
+    hash.add(static_cast<int>(type));
+
+    // Parameters that change the decomposition
+    //
+    for (auto key : {"Jacobi", "BDCSVD", "Traj", "Hankel", "HankelIter",
+		     "MPI", "RedSym", "rank", "Sign", "totVar", "totPow",
+		     "noMean", "GPU"})
+      hash.add(params, key);
+
+    // The input series
+    //
+    hash.add(coefDB.times);
+    for (auto & u : mean) {
+      hash.add(u.first);
+      hash.add(u.second);
+      hash.add(var[u.first]);
+      hash.add(data[u.first]);
+    }
+
+    fingerprint = hash.value();
+  }
+
+  bool expMSSA::readCache()
+  {
+    if (not params["cache"]) return false;
+
+    auto prefix = params["cache"].as<std::string>();
+    auto file   = prefix + "_mssa.h5";
+
+    if (not std::filesystem::exists(file)) return false;
+
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File h5file(file, HighFive::File::ReadOnly);
+
+      if (not h5file.hasAttribute("version") or
+	  not h5file.hasAttribute("fingerprint")) return false;
+
+      int version;
+      unsigned long long fp;
+      h5file.getAttribute("version").read(version);
+      h5file.getAttribute("fingerprint").read(fp);
+
+      if (version != stateVersion or fp != fingerprint) return false;
+    }
+    catch (HighFive::Exception& err) {
+      return false;
+    }
+
+    // A matching cache that fails to load is recomputed
+    //
+    try {
+      restoreState(prefix);
+    }
+    catch (std::exception& e) {
+      computed = reconstructed = false;
+      std::cout << "expMSSA: could not restore cache <" << file << ">: "
+		<< e.what() << std::endl;
+      return false;
+    }
+
+    if (verbose)
+      std::cout << "expMSSA: restored analysis from <" << file << ">"
+		<< std::endl;
+
+    return true;
+  }
+
+  void expMSSA::writeCache()
+  {
+    if (not params["cache"]) return;
+
+    // One writer in MPI mode
+    //
+    int use_mpi, id = 0;
+    MPI_Initialized(&use_mpi);
+    if (use_mpi) MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    if (id) return;
+
+    auto prefix = params["cache"].as<std::string>();
+    auto file   = prefix + "_mssa.h5";
+
+    // Replace a stale cache
+    //
+    std::filesystem::remove(file);
+
+    saveState(prefix);
+  }
+
   // Save current MSSA state to an HDF5 file with the given prefix
   void expMSSA::saveState(const std::string& prefix)
   {
@@ -1486,6 +2034,12 @@ namespace MSSA {
       int trend = static_cast<std::underlying_type<TrendType>::type>(type);
       file.createAttribute<int>("trendType", HighFive::DataSpace::From(trend)).write(trend);
 
+      // Layout version and input fingerprint for cache validation
+      //
+      int version = stateVersion;
+      file.createAttribute<int>("version", HighFive::DataSpace::From(version)).write(version);
+      file.createAttribute<unsigned long long>("fingerprint", HighFive::DataSpace::From(fingerprint)).write(fingerprint);
+
       // Save the key list
       //
       std::vector<Key> keylist;
@@ -1511,7 +2065,7 @@ namespace MSSA {
       //
       HighFive::Group analysis = file.createGroup("mssa_analysis");
 
-      analysis.createDataSet("Y",  Y );
+      if (Y.size()) analysis.createDataSet("Y",  Y );
       analysis.createDataSet("S",  S );
       analysis.createDataSet("U",  U );
       analysis.createDataSet("PC", PC);
@@ -1656,7 +2210,8 @@ namespace MSSA {
 
       auto analysis = h5file.getGroup("mssa_analysis");
 
-      Y  = analysis.getDataSet("Y" ).read<Eigen::MatrixXd>();
+      if (analysis.exist("Y"))	// Not kept in operator mode
+	Y  = analysis.getDataSet("Y" ).read<Eigen::MatrixXd>();
       S  = analysis.getDataSet("S" ).read<Eigen::VectorXd>();
       U  = analysis.getDataSet("U" ).read<Eigen::MatrixXd>();
       PC = analysis.getDataSet("PC").read<Eigen::MatrixXd>();
@@ -1988,6 +2543,7 @@ namespace MSSA {
 
     // Now open and parse the coefficient files
     //
+    cflags = flags;
     coefDB = CoefContainer(config, flags);
 
     numT = coefDB.times.size();
@@ -2082,6 +2638,11 @@ namespace MSSA {
     }
     computed      = false;
     reconstructed = false;
+
+    // Skip the analysis if a matching one was saved
+    //
+    computeFingerprint();
+    readCache();
   }
   // END expMSSA constructor
 
@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <fstream>
 #include <memory>
+#include <limits>
 
 #include <cxxopts.H>
 #include <libvars.H>
@@ -44,8 +45,13 @@ int main(int argc, char **argv)
 
   if (vm.count("verbose")) verbose = true;
 
+  // The H5 file is read on demand a block at a time as the
+  // snapshots are compared
+  //
   auto coefs0 = CoefClasses::Coefs::factory(infile);
-  auto coefs1 = CoefClasses::Coefs::factory(prefix + ".h5");
+  auto coefs1 = CoefClasses::Coefs::factory
+    (prefix + ".h5", 1, -std::numeric_limits<double>::max(),
+     std::numeric_limits<double>::max(), true);
 
   // Is data identical?
   //
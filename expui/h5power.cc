@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <fstream>
 #include <memory>
+#include <limits>
 
 #include <cxxopts.H>
 #include <libvars.H>
@@ -11,6 +12,7 @@ int main(int argc, char **argv)
 {
   std::string infile, prefix;
   bool verbose = false;
+  int nmin, nmax, block, nblocks;
 
   //
   // Parse Command line
@@ -26,6 +28,14 @@ int main(int argc, char **argv)
      cxxopts::value<std::string>(infile)->default_value("coef.dat"))
     ("p,prefix", "prefix for the output data file",
      cxxopts::value<std::string>(prefix)->default_value("power"))
+    ("nmin", "minimum radial order",
+     cxxopts::value<int>(nmin)->default_value("0"))
+    ("nmax", "maximum radial order (exclusive)",
+     cxxopts::value<int>(nmax)->default_value("2147483647"))
+    ("block", "snapshots read at once",
+     cxxopts::value<int>(block)->default_value("64"))
+    ("nblocks", "number of snapshot blocks cached",
+     cxxopts::value<int>(nblocks)->default_value("4"))
      ;
   
   cxxopts::ParseResult vm;
@@ -44,9 +54,16 @@ int main(int argc, char **argv)
 
   if (vm.count("verbose")) verbose = true;
 
-  auto coefs = CoefClasses::Coefs::factory(infile);
+  // Stream the snapshots of H5 files through a bounded cache rather
+  // than reading the whole file
+  //
+  CoefClasses::Coefs::setLazyCache(block, nblocks);
+
+  auto coefs = CoefClasses::Coefs::factory
+    (infile, 1, -std::numeric_limits<double>::max(),
+     std::numeric_limits<double>::max(), true);
 
-  auto power = coefs->Power();
+  auto power = coefs->Power(nmin, nmax);
   auto times = coefs->Times();
 
   std::ofstream out(prefix + ".dat");
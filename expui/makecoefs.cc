@@ -1,4 +1,5 @@
 #include <filesystem>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -15,6 +16,11 @@
 int main(int argc, char **argv)
 {
   std::string runtag, outdir, config, type, delim, files, comp;
+  int ngroups;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+  MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
   // Parse Command line
   //
@@ -39,6 +45,8 @@ int main(int argc, char **argv)
      cxxopts::value<std::string>(config)->default_value("basis.yaml"))
     ("c,comp", "The component name",
      cxxopts::value<std::string>(comp)->default_value("dark"))
+    ("g,groups", "split the ranks into this many groups, each computing whole snapshots",
+     cxxopts::value<int>(ngroups)->default_value("1"))
      ;
   
   cxxopts::ParseResult vm;
@@ -46,12 +54,14 @@ int main(int argc, char **argv)
   try {
     vm = options.parse(argc, argv);
   } catch (cxxopts::OptionException& e) {
-    std::cout << "Option error: " << e.what() << std::endl;
+    if (myid==0) std::cout << "Option error: " << e.what() << std::endl;
+    MPI_Finalize();
     exit(-1);
   }
 
   if (vm.count("help")) {
-    std::cout << options.help() << std::endl;
+    if (myid==0) std::cout << options.help() << std::endl;
+    MPI_Finalize();
     return 1;
   }
 
@@ -64,11 +74,17 @@ int main(int argc, char **argv)
   bool hdf5_exists = std::filesystem::exists(runtag + ".h5");
 
   if (hdf5_exists and not extend) {
-    std::cout << "HDF5 file <" << runtag + ".h5" << "> exists.  Use --extend flag if you would like to append the new coefficients" << std::endl;
+    if (myid==0)
+      std::cout << "HDF5 file <" << runtag + ".h5" << "> exists.  Use --extend flag if you would like to append the new coefficients" << std::endl;
 
+    MPI_Finalize();
     return(1);
   }
 
+  ngroups = std::max<int>(1, std::min<int>(ngroups, numprocs));
+
+  int status = 0;
+
   try {
 
     // Read the YAML from a file (could use a YAML emitter to do this on
@@ -76,7 +92,8 @@ int main(int argc, char **argv)
     //
     YAML::Node yaml = YAML::LoadFile(config);
     
-    // Create the basis object
+    // Create the basis object.  The tables are computed once by all
+    // ranks and then shared by the groups.
     //
     auto basis = BasisClasses::Basis::factory(yaml);
     
@@ -84,9 +101,31 @@ int main(int argc, char **argv)
     //
     CoefClasses::CoefsPtr coefs;
     
+    // Pipeline mode: each group of ranks reads and accumulates whole
+    // snapshots on its own, so the reductions only span the group.
+    // The readers and the basis divide the work using the rank and
+    // size of the group.
+    //
+    int world_id = myid, world_size = numprocs, group = 0;
+    MPI_Comm group_comm = MPI_COMM_WORLD;
+
+    if (ngroups > 1) {
+      group = world_id*ngroups/world_size;
+      MPI_Comm_split(MPI_COMM_WORLD, group, world_id, &group_comm);
+      MPI_Comm_rank(group_comm, &myid);
+      MPI_Comm_size(group_comm, &numprocs);
+      basis->setComm(group_comm);
+    }
+
     // Loop through list of snapshots
     //
+    int nbatch = 0;
     for (auto batch : PR::ParticleReader::parseFileList(files, delim)) {
+
+      // Round robin over the groups
+      //
+      if (nbatch++ % ngroups != group) continue;
+
       // Cast to a Biorth basis
       //
       auto biorth = dynamic_pointer_cast<BasisClasses::BiorthBasis>(basis);
@@ -107,24 +146,73 @@ int main(int argc, char **argv)
 	
       // Some running commentary
       //
-      if (vm.count("verbose")) {
-	std::cout << "---- Finished the batch:";
+      if (vm.count("verbose") and myid==0) {
+	if (ngroups > 1)
+	  std::cout << "---- Group " << group << " finished the batch:";
+	else
+	  std::cout << "---- Finished the batch:";
 	for (auto f : batch) std::cout << " " << f;
 	std::cout << std::endl;
       }
     }
-    
+
+    // Merge the group results in time order
+    //
+    if (ngroups > 1) {
+      std::string part = runtag + ".group" + std::to_string(group);
+      if (myid==0 and coefs) coefs->WriteH5Coefs(part);
+
+      MPI_Barrier(MPI_COMM_WORLD);
+
+      // Back to a single group
+      //
+      basis->setComm(MPI_COMM_WORLD);
+      MPI_Comm_free(&group_comm);
+      myid = world_id;
+      numprocs = world_size;
+
+      coefs.reset();
+
+      if (myid==0) {
+	std::vector<std::pair<double, CoefClasses::CoefStrPtr>> snaps;
+
+	for (int g=0; g<ngroups; g++) {
+	  std::string name = runtag + ".group" + std::to_string(g);
+	  if (not std::filesystem::exists(name)) continue;
+
+	  auto c = CoefClasses::Coefs::factory(name);
+	  for (auto t : c->Times()) snaps.push_back({t, c->getCoefStruct(t)});
+	  std::filesystem::remove(name);
+	}
+
+	std::sort(snaps.begin(), snaps.end(),
+		  [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	for (auto & v : snaps) coefs = CoefClasses::Coefs::addcoef(coefs, v.second);
+      }
+    }
+
     // Write an H5 file
     //
-    if (hdf5_exists and extend)
-      coefs->ExtendH5Coefs(runtag);
-    else
-      coefs->WriteH5Coefs(runtag);
+    if (myid==0) {
+      if (not coefs)
+	throw std::runtime_error("no snapshots were processed");
+
+      if (hdf5_exists and extend)
+	coefs->ExtendH5Coefs(runtag);
+      else
+	coefs->WriteH5Coefs(runtag);
+    }
 
     // Make some surface files
     //
     if (surface) {
 
+      // Only the root has the merged coefficients
+      //
+      MPI_Barrier(MPI_COMM_WORLD);
+      if (ngroups > 1) coefs = CoefClasses::Coefs::factory(runtag);
+
       std::vector<double> time = coefs->Times();
       std::vector<double> pmin = {-1.0, -1.0, 0.0};
       std::vector<double> pmax = { 1.0,  1.0, 0.0};
@@ -144,10 +232,12 @@ int main(int argc, char **argv)
   catch (const std::runtime_error& error) {
     std::cout << "makecoefs: found a problem" << std::endl
 	      << error.what() << std::endl;
-    return(1);
+    status = 1;
+    MPI_Abort(MPI_COMM_WORLD, status);
   }
 
   // Done
   //
-  return(0);
+  MPI_Finalize();
+  return(status);
 }
@@ -3,6 +3,8 @@
 #include <BarrierWrapper.H>
 #include <unistd.h>
 
+#include <algorithm>
+#include <numeric>
 #include <cstring>
 #include <sstream>
 #include <list>
@@ -38,6 +40,8 @@ int    BarrierWrapper::loop_delay    = 100;
 				// Buffer size for checking working
 				// labels
 int    BarrierWrapper::cbufsz        = 128;
+				// Per-site wait telemetry
+bool   BarrierWrapper::telemetry     = false;
 
 BarrierWrapper::BarrierWrapper(MPI_Comm communicator, bool label)
 {
@@ -137,6 +141,108 @@ void BarrierWrapper::light_operator(const string& label,
 }
 
 
+void BarrierWrapper::telemetry_operator(const string& label,
+					const char* file, const int line)
+{
+  // Set the global debug info
+  //
+  inOper = true;
+  lbOper = label;
+  flOper = string(file);
+  lnOper = line;
+
+  double t0 = MPI_Wtime();
+  MPI_Barrier(comm);
+  double dt = MPI_Wtime() - t0;
+
+  std::ostringstream sid;
+  sid << label << " [" << file << ":" << line << "]";
+
+  auto & site = sites[sid.str()];
+  site.count++;
+  site.wait   += dt;
+  site.maxwait = std::max<double>(site.maxwait, dt);
+  wait_total  += dt;
+
+  // Reset the global debug info
+  //
+  inOper = false;
+}
+
+
+void BarrierWrapper::telemetryReport(std::ostream& out, int step)
+{
+  // Every process passes every site, so the maps have the same keys
+  // unless a barrier was skipped somewhere
+  //
+  int nsite = sites.size(), nmin, nmax;
+  MPI_Allreduce(&nsite, &nmin, 1, MPI_INT, MPI_MIN, comm);
+  MPI_Allreduce(&nsite, &nmax, 1, MPI_INT, MPI_MAX, comm);
+
+  if (nmin != nmax) {
+    if (localid==0)
+      out << "# Step " << step << ": barrier sites differ between "
+	  << "processes (" << nmin << " to " << nmax << "), no report"
+	  << std::endl;
+    sites.clear();
+    return;
+  }
+
+  // Layout of MPI_DOUBLE_INT for the MAXLOC and MINLOC reductions
+  //
+  struct Loc { double val; int rank; };
+  std::vector<Loc> mine(nsite), wmax(nsite), wmin(nsite);
+  std::vector<double> w(nsite), wsum(nsite), peak(nsite), single(nsite);
+  std::vector<std::string> names;
+
+  int j = 0;
+  for (auto & v : sites) {
+    names.push_back(v.first);
+    w[j] = mine[j].val = v.second.wait;
+    mine[j].rank = localid;
+    single[j]    = v.second.maxwait;
+    j++;
+  }
+
+  MPI_Reduce(mine.data(), wmax.data(), nsite, MPI_DOUBLE_INT, MPI_MAXLOC, 0, comm);
+  MPI_Reduce(mine.data(), wmin.data(), nsite, MPI_DOUBLE_INT, MPI_MINLOC, 0, comm);
+  MPI_Reduce(w.data(), wsum.data(), nsite, MPI_DOUBLE, MPI_SUM, 0, comm);
+  MPI_Reduce(single.data(), peak.data(), nsite, MPI_DOUBLE, MPI_MAX, 0, comm);
+
+  if (localid==0) {
+
+    // Worst sites first
+    //
+    std::vector<int> order(nsite);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+	      [&](int a, int b) { return wmax[a].val > wmax[b].val; });
+
+    out << "# Step " << step << std::endl
+	<< "# " << std::setw(12) << "Calls"
+	<< std::setw(14) << "Max wait" << std::setw(7) << "Proc"
+	<< std::setw(14) << "Min wait" << std::setw(7) << "Proc"
+	<< std::setw(14) << "Mean wait"
+	<< std::setw(14) << "Max single" << "  Site" << std::endl
+	<< "# " << std::setw(12) << "--------"
+	<< std::setw(14) << "----------" << std::setw(7) << "-----"
+	<< std::setw(14) << "----------" << std::setw(7) << "-----"
+	<< std::setw(14) << "----------"
+	<< std::setw(14) << "----------" << "  ----" << std::endl;
+
+    for (auto j : order) {
+      out << "  " << std::setw(12) << sites[names[j]].count
+	  << std::setw(14) << wmax[j].val << std::setw(7) << wmax[j].rank
+	  << std::setw(14) << wmin[j].val << std::setw(7) << wmin[j].rank
+	  << std::setw(14) << wsum[j]/commsize
+	  << std::setw(14) << peak[j] << "  " << names[j] << std::endl;
+    }
+  }
+
+  sites.clear();
+}
+
+
 // This loop defeats the purpose of this entire class and should ONLY
 // be used for debugging
 //
@@ -4,6 +4,8 @@
 #include <iomanip>
 #include <sstream>
 #include <memory>
+#include <numeric>
+#include <random>
 #include <limits>
 #include <string>
 
@@ -266,7 +268,7 @@ BiorthCube::get_force(const BiorthCube::coefType& c, Eigen::Vector3d x)
 	double norm = 1.0/sqrt(M_PI*ii.dot(ii));
 
 	for (int k=0; k<3; k++)
-	  force(k) -= std::complex<double>(0.0, dfac*i(k))*fac*norm;
+	  force(k) -= std::complex<double>(0.0, dfac*ii(k))*fac*norm;
       }
     }
   }
@@ -274,12 +276,140 @@ BiorthCube::get_force(const BiorthCube::coefType& c, Eigen::Vector3d x)
   return force;
 }
 
-Eigen::MatrixXcd BiorthCube::orthoCheck()
+void BiorthCube::phases(const double* x, int n, int nmax, Eigen::MatrixXcd& E)
+{
+  E.resize(n, 2*nmax+1);
+
+  for (int p=0; p<n; p++) {
+    std::complex<double> step = std::exp(kfac*x[p]);
+    std::complex<double> curr = std::exp(-kfac*(x[p]*nmax));
+    for (int i=0; i<=2*nmax; i++, curr*=step) E(p, i) = curr;
+  }
+}
+
+Eigen::MatrixXcd
+BiorthCube::fieldCoefs(const BiorthCube::coefType& c)
+{
+  const int dx = 2*nmax(0)+1, dy = 2*nmax(1)+1, dz = 2*nmax(2)+1;
+
+  Eigen::MatrixXcd W = Eigen::MatrixXcd::Zero(dz, 5*dx*dy);
+
+  for (int ix=0; ix<dx; ix++) {
+    for (int iy=0; iy<dy; iy++) {
+      for (int iz=0; iz<dz; iz++) {
+
+	Eigen::Vector3i ii {ix-nmax(0), iy-nmax(1), iz-nmax(2)};
+
+	// Same wave number selection as get_pot(), get_dens() and
+	// get_force()
+	//
+	if (ii(0)==0 && ii(1)==0 && ii(2)==0) continue;
+
+	if (abs(ii(0)) > nmin(0) ||
+	    abs(ii(1)) > nmin(1) ||
+	    abs(ii(2)) > nmin(2)  ) continue;
+
+	double k2 = M_PI*ii.dot(ii);
+	std::complex<double> pot = c(ix, iy, iz)/sqrt(k2);
+
+	W(iz, ix*dy + iy)          = -c(ix, iy, iz)*sqrt(k2);
+	W(iz, (dx + ix)*dy + iy)   = pot;
+	for (int k=0; k<3; k++)
+	  W(iz, ((2+k)*dx + ix)*dy + iy) =
+	    -std::complex<double>(0.0, dfac*ii(k))*pot;
+      }
+    }
+  }
+
+  return W;
+}
+
+Eigen::MatrixXd
+BiorthCube::get_fields(const BiorthCube::coefType& c, const Eigen::MatrixXd& x)
+{
+  const int dx = 2*nmax(0)+1, dy = 2*nmax(1)+1;
+  const int N = x.rows(), blk = 256;
+
+  Eigen::MatrixXd ret(N, 5);
+  Eigen::MatrixXcd W = fieldCoefs(c);
+  Eigen::MatrixXd  X = x.leftCols(3);
+
+#pragma omp parallel
+  {
+    Eigen::MatrixXcd Ex, Ey, Ez, T;
+    Eigen::VectorXcd acc;
+
+#pragma omp for schedule(dynamic)
+    for (int b=0; b<N; b+=blk) {
+      int n = std::min<int>(blk, N-b);
+
+      phases(X.col(0).data()+b, n, nmax(0), Ex);
+      phases(X.col(1).data()+b, n, nmax(1), Ey);
+      phases(X.col(2).data()+b, n, nmax(2), Ez);
+
+      // Contract z: column (f*dx + ix)*dy + iy for each point
+      //
+      T.noalias() = Ez * W;
+
+      // Contract y and x
+      //
+      for (int f=0; f<5; f++) {
+	acc.setZero(n);
+	for (int ix=0; ix<dx; ix++)
+	  acc.array() += Ex.col(ix).array() *
+	    (T.middleCols((f*dx + ix)*dy, dy).array() * Ey.array()).rowwise().sum();
+	ret.col(f).segment(b, n) = acc.real();
+      }
+    }
+  }
+
+  return ret;
+}
+
+void BiorthCube::get_fields(const BiorthCube::coefType& c,
+			    const std::vector<double>& x,
+			    const std::vector<double>& y,
+			    const std::vector<double>& z,
+			    std::vector<Eigen::MatrixXd>& out)
+{
+  const int dx = 2*nmax(0)+1, dy = 2*nmax(1)+1;
+  const int nx = x.size(), ny = y.size(), nz = z.size();
+
+  Eigen::MatrixXcd Ex, Ey, Ez;
+  phases(x.data(), nx, nmax(0), Ex);
+  phases(y.data(), ny, nmax(1), Ey);
+  phases(z.data(), nz, nmax(2), Ez);
+
+  // Contract z: one row per z knot
+  //
+  Eigen::MatrixXcd T = Ez * fieldCoefs(c);
+
+  out.resize(5);
+
+  for (int f=0; f<5; f++) {
+
+    // Contract y: row ix holds the (y, z) plane for x wave number ix
+    //
+    Eigen::MatrixXcd U(dx, ny*nz);
+
+#pragma omp parallel for
+    for (int ix=0; ix<dx; ix++) {
+      Eigen::MatrixXcd P = Ey * T.middleCols((f*dx + ix)*dy, dy).transpose();
+      U.row(ix) = Eigen::Map<Eigen::RowVectorXcd>(P.data(), ny*nz);
+    }
+
+    // Contract x
+    //
+    out[f] = (Ex * U).real();
+  }
+}
+
+Eigen::MatrixXcd BiorthCube::orthoCheck(int nsample)
 {
   Eigen::Vector3i d {2*nmax(0)+1, 2*nmax(1)+1, 2*nmax(2)+1};
   int dim = d(0)*d(1)*d(2);
   Eigen::MatrixXcd ortho(dim, dim);
-  ortho.setZero();
+  ortho.setIdentity();
 
   double dx = 1.0/knots, dy = 1.0/knots, dz = 1.0/knots;
   double vol = dx*dy*dz;
@@ -303,31 +433,47 @@ Eigen::MatrixXcd BiorthCube::orthoCheck()
   };
 
 
-  // Centered rectangle quadrature for Fourier basis
+  // Rows of the inner-product matrix to compute: all of them, or a
+  // random sample of nsample rows.  Rows not sampled are left as
+  // the identity.
   //
-  Eigen::Vector3d x;		// Position vector
-  for (int i=0; i<knots; i++) {
-    x(0) = dx*i;
+  std::vector<int> rows(dim);
+  std::iota(rows.begin(), rows.end(), 0);
+  if (nsample>0 and nsample<dim) {
+    std::shuffle(rows.begin(), rows.end(), random_gen);
+    rows.resize(nsample);
+    std::sort(rows.begin(), rows.end());
+  }
+  int nrow = rows.size();
 
-    for (int j=0; j<knots; j++) {
-      x(1) = dy*j;
+  // Centered rectangle quadrature for Fourier basis.  The basis is
+  // tabulated on one plane of knots at a time so that the plane's
+  // contribution is a single matrix product.
+  //
+  const int nplane = knots*knots;
+  Eigen::MatrixXcd P(nrow, nplane), D(dim, nplane), O(nrow, dim);
+  O.setZero();
 
-      for (int k=0; k<knots; k++) {
-	x(2) = dz*k;
+  for (int i=0; i<knots; i++) {
 
 #pragma omp parallel for
-	for (int indx=0; indx<dim*dim; indx++) {
-	  int indx1 = indx/dim;
-	  int indx2 = indx - indx1*dim;
+    for (int jk=0; jk<nplane; jk++) {
+      int j = jk/knots;
+      int k = jk - j*knots;
 
-	  ortho(indx1, indx2) += vol *
-	    pot(x, index(indx1)) * std::conj(-dens(x, index(indx2)));
-	}
-	// Progress bar
-	if (progress) ++(*progress);
-      }
+      Eigen::Vector3d x(dx*i, dy*j, dz*k);
+
+      for (int n=0; n<dim; n++) D(n, jk) = -dens(x, index(n));
+      for (int q=0; q<nrow; q++) P(q, jk) = pot(x, index(rows[q]));
     }
+
+    O.noalias() += vol * P * D.adjoint();
+
+    // Progress bar
+    if (progress) *progress += nplane;
   }
+
+  for (int q=0; q<nrow; q++) ortho.row(rows[q]) = O.row(q);
   
   // Artifically insert the undefined constant term
   //
@@ -112,6 +112,16 @@ BiorthCyl::BiorthCyl(const YAML::Node& conf) : conf(conf)
 
     if (conf["diskconf"])    diskconf  = conf["diskconf"];
     else throw std::runtime_error("BiorthCyl: you must specify the diskconf stanza");
+
+    // Tables read from the cache
+    std::string tables("all");
+    if (conf["loadtables"])  tables = conf["loadtables"].as<std::string>();
+
+    if      (tables == "all")     loaded = Tables::all;
+    else if (tables == "forces")  loaded = Tables::forces;
+    else if (tables == "density") loaded = Tables::density;
+    else throw std::runtime_error("BiorthCyl: loadtables must be one of "
+				  "'all', 'forces' or 'density'");
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in BiorthCyl: "
@@ -134,8 +144,173 @@ BiorthCyl::BiorthCyl(const YAML::Node& conf) : conf(conf)
   
   initialize();
 
-  if (not ReadH5Cache()) create_tables();
+  // The load profile applies to tables read from the cache only;
+  // computing the basis needs all of them
+  //
+  if (not ReadH5Cache()) {
+    if (loaded != Tables::all) {
+      loaded = Tables::all;
+      allocate_grids();
+    }
+    create_tables();
+  }
+
+  pack_table();
+}
+
+void BiorthCyl::pack_table()
+{
+  // Offsets of the loaded fields in each packed cell
+  //
+  pfield = 0;
+  poff[fDens] = hasDen() ? pfield++ : -1;
+  poff[fPot ] = pfield++;
+  poff[fRfc ] = hasFrc() ? pfield++ : -1;
+  poff[fZfc ] = hasFrc() ? pfield++ : -1;
+
+  std::array<std::vector<std::vector<Eigen::MatrixXd>>*, NFIELD> grid =
+    {&dens, &pot, &rforce, &zforce};
+
+  const int K = (mmax+1)*nmax*pfield;
+
+  ptable.resize(static_cast<size_t>(numx)*numy*K);
+
+  for (int ix=0; ix<numx; ix++) {
+    for (int iy=0; iy<numy; iy++) {
+      double *t = &ptable[(static_cast<size_t>(ix)*numy + iy)*K];
+      for (int m=0; m<=mmax; m++) {
+	for (int n=0; n<nmax; n++, t+=pfield) {
+	  for (int f=0; f<NFIELD; f++)
+	    if (poff[f]>=0) t[poff[f]] = (*grid[f])[m][n](ix, iy);
+	}
+      }
+    }
+  }
+}
+
+BiorthCyl::Cell BiorthCyl::locate(double R, double Z)
+{
+  Cell c;
+
+  double z = fabs(Z);
+
+  // Off grid
+  c.off = R/scale>rcylmax or z/scale>rcylmax;
+  if (c.off) return c;
 
+  // Remove mid-plane discontinuity in the vertical force
+  if (z/scale < 1.0e-6) c.zsign = 0.0;
+  else                  c.zsign = Z<0.0 ? -1.0 : 1.0;
+
+  double X = (r_to_xi(R) - xmin)/dx;
+  double Y = (z_to_yi(z) - ymin)/dy;
+
+  c.ix = (int)X;
+  c.iy = (int)Y;
+
+  if (c.ix < 0) {
+    c.ix = 0;
+    X    = 0.0;
+  }
+  if (c.iy < 0) {
+    c.iy = 0;
+    Y    = 0.0;
+  }
+
+  if (c.ix >= numx-1) {
+    c.ix = numx-2;
+    X    = numx-1;
+  }
+  if (c.iy >= numy-1) {
+    c.iy = numy-2;
+    Y    = numy-1;
+  }
+
+  double delx0 = (double)c.ix + 1.0 - X;
+  double dely0 = (double)c.iy + 1.0 - Y;
+  double delx1 = X - (double)c.ix;
+  double dely1 = Y - (double)c.iy;
+
+  c.c00 = delx0*dely0;
+  c.c10 = delx1*dely0;
+  c.c01 = delx0*dely1;
+  c.c11 = delx1*dely1;
+
+  return c;
+}
+
+void BiorthCyl::eval_cell(const Cell& c, double* out)
+{
+  const int K = (mmax+1)*nmax*NFIELD;
+  const int P = (mmax+1)*nmax*pfield;
+
+  if (c.off) {
+    std::fill(out, out+K, 0.0);
+    return;
+  }
+
+  // The corners (ix, iy+1) and (ix+1, iy+1) follow (ix, iy) and
+  // (ix+1, iy) in the table
+  //
+  const double *a = &ptable[(static_cast<size_t>(c.ix)*numy + c.iy)*P];
+  const double *b = a + static_cast<size_t>(numy)*P;
+  const double *d = a + P;
+  const double *e = b + P;
+
+  if (pfield == NFIELD) {
+    for (int j=0; j<K; j++)
+      out[j] = a[j]*c.c00 + b[j]*c.c10 + d[j]*c.c01 + e[j]*c.c11;
+  } else {
+    // Interpolate the loaded fields and spread them to the full
+    // layout with zeros for the others
+    //
+    thread_local std::vector<double> work;
+    work.resize(P);
+
+    for (int j=0; j<P; j++)
+      work[j] = a[j]*c.c00 + b[j]*c.c10 + d[j]*c.c01 + e[j]*c.c11;
+
+    for (int i=0; i<(mmax+1)*nmax; i++) {
+      for (int f=0; f<NFIELD; f++)
+	out[i*NFIELD + f] = poff[f]>=0 ? work[i*pfield + poff[f]] : 0.0;
+    }
+  }
+
+  for (int j=fZfc; j<K; j+=NFIELD) out[j] *= c.zsign;
+}
+
+void BiorthCyl::get_all(Eigen::MatrixXd& d, Eigen::MatrixXd& p,
+			Eigen::MatrixXd& fr, Eigen::MatrixXd& fz,
+			double r, double z)
+{
+  thread_local std::vector<double> work;
+  work.resize(batchSize());
+
+  eval_cell(locate(r, z), work.data());
+
+  d .resize(mmax+1, nmax);
+  p .resize(mmax+1, nmax);
+  fr.resize(mmax+1, nmax);
+  fz.resize(mmax+1, nmax);
+
+  for (int m=0, j=0; m<=mmax; m++) {
+    for (int n=0; n<nmax; n++, j+=NFIELD) {
+      d (m, n) = work[j+fDens];
+      p (m, n) = work[j+fPot ];
+      fr(m, n) = work[j+fRfc ];
+      fz(m, n) = work[j+fZfc ];
+    }
+  }
+}
+
+void BiorthCyl::get_all(int npts, const double* r, const double* z,
+			double* out)
+{
+  std::vector<Cell> cells(npts);
+  for (int i=0; i<npts; i++) cells[i] = locate(r[i], z[i]);
+
+  const int K = batchSize();
+  for (int i=0; i<npts; i++) eval_cell(cells[i], out + static_cast<size_t>(i)*K);
 }
 
 void BiorthCyl::initialize()
@@ -156,17 +331,28 @@ void BiorthCyl::initialize()
   zforce .resize(mmax+1);
 
   for (int m=0; m<=mmax; m++) {
-
     dens  [m].resize(nmax);
     pot   [m].resize(nmax);
     rforce[m].resize(nmax);
     zforce[m].resize(nmax);
+  }
 
+  allocate_grids();
+}
+
+void BiorthCyl::allocate_grids()
+{
+  // Tables that are not loaded are empty
+  //
+  int fx = hasFrc() ? numx : 0, fy = hasFrc() ? numy : 0;
+  int gx = hasDen() ? numx : 0, gy = hasDen() ? numy : 0;
+
+  for (int m=0; m<=mmax; m++) {
     for (int n=0; n<nmax; n++) {
-      dens  [m][n].resize(numx, numy);
+      dens  [m][n].resize(gx, gy);
       pot   [m][n].resize(numx, numy);
-      rforce[m][n].resize(numx, numy);
-      zforce[m][n].resize(numx, numy);
+      rforce[m][n].resize(fx, fy);
+      zforce[m][n].resize(fx, fy);
     }
   }
 }
@@ -191,6 +377,12 @@ void BiorthCyl::create_tables()
   }
 
 
+  // Grid radii and heights
+  //
+  Eigen::VectorXd rgrid(numx), zgrid(numy);
+  for (int ix=0; ix<numx; ix++) rgrid[ix] = xi_to_r(xmin + dx*ix);
+  for (int iy=0; iy<numy; iy++) zgrid[iy] = yi_to_z(ymin + dy*iy);
+
   // Pack basis grids
   //
   for (int m=0; m<=mmax; m++) {
@@ -206,34 +398,33 @@ void BiorthCyl::create_tables()
       rforce[m][n].setZero();
       zforce[m][n].setZero();
 
-      // Create the functor
+      // Each process computes whole grids; the inverse transforms
+      // for all heights are one matrix product per field
       //
-      auto func = [&, this](double R)
-      {
-	return emp.get_dens(R, m, n);
-      };
-
-      int count = 0;
-
-      for (int ix=0; ix<numx; ix++) {
-	double r = xi_to_r(xmin + dx*ix);
-
-	for (int iy=0; iy<numy; iy++) {
-	  double z = yi_to_z(ymin + dy*iy);
-	  
-	  if (count++ % numprocs == myid) {
-	    if (fabs(z)<1.0e-6) dens[m][n](ix, iy) = -emp.get_dens(r, m, n);
-	    pot   [m][n](ix, iy) = potrz(r, z, func, PotRZ::Field::potential);
-	    rforce[m][n](ix, iy) = potrz(r, z, func, PotRZ::Field::rforce   );
-	    zforce[m][n](ix, iy) = potrz(r, z, func, PotRZ::Field::zforce   );
+      if ((m*nmax + n) % numprocs == myid) {
+
+	// Create the functor
+	//
+	auto func = [&, this](double R)
+	{
+	  return emp.get_dens(R, m, n);
+	};
+
+	for (int ix=0; ix<numx; ix++) {
+	  for (int iy=0; iy<numy; iy++) {
+	    if (fabs(zgrid[iy])<1.0e-6)
+	      dens[m][n](ix, iy) = -emp.get_dens(rgrid[ix], m, n);
 	  }
 	}
-	// END: y loop
-	if (verbose and myid==0) {
-	  ++(*progress);
-	}
+
+	pot   [m][n] = potrz(rgrid, zgrid, func, PotRZ::Field::potential);
+	rforce[m][n] = potrz(rgrid, zgrid, func, PotRZ::Field::rforce   );
+	zforce[m][n] = potrz(rgrid, zgrid, func, PotRZ::Field::zforce   );
+      }
+
+      if (verbose and myid==0) {
+	(*progress) += numx;
       }
-      // END: x loop
     }
     // END: n loop
   }
@@ -355,6 +546,9 @@ void BiorthCyl::interp(double R, double Z,
   ret.resize(mmax+1, nmax);
   ret.setZero();
 
+  // Table not loaded
+  if (mat[0][0].size()==0) return;
+
   // Off grid in radial dimension
   if (R/scale>rcylmax) return;
 
@@ -423,6 +617,9 @@ double BiorthCyl::interp(int m, int n, double R, double Z,
   // Off grid in radial dimension
   if (R/scale>rcylmax or n>=nmax or m>mmax) return ret;
 
+  // Table not loaded
+  if (mat[m][n].size()==0) return ret;
+
   double z = fabs(Z);
 
   // Off grid in vertical dimension
@@ -524,10 +721,15 @@ void BiorthCyl::ReadH5Arrays(HighFive::Group& harmonic)
       sout << n;
       auto arrays = order.getGroup(sout.str());
 
-      arrays.getDataSet("density")  .read(dens  [m][n]);
+      // Tables that are not loaded are not read
+      //
+      if (hasDen())
+	arrays.getDataSet("density")  .read(dens  [m][n]);
       arrays.getDataSet("potential").read(pot   [m][n]);
-      arrays.getDataSet("rforce")   .read(rforce[m][n]);
-      arrays.getDataSet("zforce")   .read(zforce[m][n]);
+      if (hasFrc()) {
+	arrays.getDataSet("rforce")   .read(rforce[m][n]);
+	arrays.getDataSet("zforce")   .read(zforce[m][n]);
+      }
     }
   }
 
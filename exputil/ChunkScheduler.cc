@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+
+#include <ChunkScheduler.H>
+
+int ChunkScheduler::default_chunk = 16;
+
+void ChunkScheduler::reset(const LevelList& levlist,
+			   unsigned lo, unsigned hi, int nthreads, bool steal,
+			   int chunk, double frac)
+{
+  this->nthreads = std::max<int>(1, nthreads);
+  this->chunk    = std::max<int>(1, chunk);
+  this->steal    = steal;
+
+  levs  .clear();
+  counts.clear();
+  first .clear();
+
+  for (unsigned lev=lo; lev<=hi and lev<levlist.size(); lev++) {
+    int n = levlist[lev].size();
+    if (frac<1.0) n = static_cast<int>(std::floor(frac*n));
+    if (n>0) {
+      levs  .push_back(lev);
+      counts.push_back(n);
+    }
+  }
+
+  if (ncursor < this->nthreads) {
+    cursors.reset(new Cursor [this->nthreads]);
+    ncursor = this->nthreads;
+  }
+
+  if (steal) {
+    // Number the blocks consecutively through the levels and give
+    // each thread an equal span of blocks
+    //
+    long total = 0;
+    for (auto n : counts) {
+      first.push_back(total);
+      total += (n + this->chunk - 1)/this->chunk;
+    }
+
+    for (int id=0; id<this->nthreads; id++) {
+      cursors[id].pos.store(total*id/this->nthreads, std::memory_order_relaxed);
+      cursors[id].stop   = total*(id+1)/this->nthreads;
+      cursors[id].victim = (id+1) % this->nthreads;
+    }
+  } else {
+    // Each thread visits every level once
+    //
+    for (int id=0; id<this->nthreads; id++) {
+      cursors[id].pos.store(0, std::memory_order_relaxed);
+      cursors[id].stop   = counts.size();
+      cursors[id].victim = id;
+    }
+  }
+}
+
+void ChunkScheduler::decode(long c, unsigned& lev, int& beg, int& end)
+{
+  int k = std::upper_bound(first.begin(), first.end(), c) - first.begin() - 1;
+  lev = levs[k];
+  beg = (c - first[k])*chunk;
+  end = std::min<int>(beg + chunk, counts[k]);
+}
+
+bool ChunkScheduler::next(int id, unsigned& lev, int& beg, int& end)
+{
+  Cursor & mine = cursors[id];
+
+  if (not steal) {
+    long k;
+    while ((k = mine.pos.fetch_add(1, std::memory_order_relaxed)) < mine.stop) {
+      long n = counts[k];
+      beg = n*id/nthreads;
+      end = n*(id+1)/nthreads;
+      lev = levs[k];
+      if (end>beg) return true;
+    }
+    return false;
+  }
+
+  // Own span first . . .
+  //
+  long c = mine.pos.fetch_add(1, std::memory_order_relaxed);
+  if (c < mine.stop) {
+    decode(c, lev, beg, end);
+    return true;
+  }
+
+  // . . . then the remaining spans of the other threads, each in turn
+  //
+  while (mine.victim != id) {
+    Cursor & other = cursors[mine.victim];
+    if (other.pos.load(std::memory_order_relaxed) < other.stop) {
+      c = other.pos.fetch_add(1, std::memory_order_relaxed);
+      if (c < other.stop) {
+	decode(c, lev, beg, end);
+	return true;
+      }
+    }
+    mine.victim = (mine.victim + 1) % nthreads;
+  }
+
+  return false;
+}
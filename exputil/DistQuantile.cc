@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include <DistQuantile.H>
+
+DistQuantile::DistQuantile(MPI_Comm comm, int nbins, unsigned long ngather) :
+  comm(comm), nbins(std::max<int>(nbins, 2)), ngather(ngather)
+{
+  // Nothing
+}
+
+std::vector<double>
+DistQuantile::select(std::vector<double>& data,
+		     const std::vector<unsigned long>& ranks)
+{
+  const int nq = ranks.size();
+  std::vector<double> ret(nq, 0.0);
+
+  std::sort(data.begin(), data.end());
+
+  unsigned long n = data.size(), N;
+  MPI_Allreduce(&n, &N, 1, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+  if (N==0) return ret;
+
+  // Global range as the half-open interval [lo, hi)
+  //
+  double mm[2] = {std::numeric_limits<double>::max(),
+		  std::numeric_limits<double>::max()};
+  if (n) {
+    mm[0] =  data.front();
+    mm[1] = -data.back();
+  }
+  MPI_Allreduce(MPI_IN_PLACE, mm, 2, MPI_DOUBLE, MPI_MIN, comm);
+
+  const double inf = std::numeric_limits<double>::infinity();
+
+  // Bracket for each rank: 'below' values lie under lo and 'count'
+  // values lie in [lo, hi)
+  //
+  struct Bracket
+  {
+    double lo, hi;
+    unsigned long rank, below, count;
+    bool done;
+  };
+
+  std::vector<Bracket> br(nq);
+  for (int i=0; i<nq; i++)
+    br[i] = {mm[0], std::nextafter(-mm[1], inf),
+	     std::min<unsigned long>(ranks[i], N-1), 0, N, false};
+
+  auto local = [&data](double x)
+  {
+    return std::lower_bound(data.begin(), data.end(), x) - data.begin();
+  };
+
+  auto edge = [this](const Bracket& b, int j)
+  {
+    if (j==nbins) return b.hi;
+    return b.lo + (b.hi - b.lo)*j/nbins;
+  };
+
+  int numprocs;
+  MPI_Comm_size(comm, &numprocs);
+  std::vector<int> cnts(numprocs), disp(numprocs);
+  std::vector<unsigned long> hist;
+  std::vector<double> vals;
+
+  while (true) {
+
+    std::vector<int> active;
+
+    for (int i=0; i<nq; i++) {
+      auto & b = br[i];
+      if (b.done) continue;
+
+      // Only one representable value is left
+      //
+      if (std::nextafter(b.lo, inf) >= b.hi) {
+	ret[i] = b.lo;
+	b.done = true;
+      }
+      // Few enough to pick directly
+      //
+      else if (b.count <= ngather) {
+	int beg = local(b.lo), end = local(b.hi), m = end - beg;
+
+	MPI_Allgather(&m, 1, MPI_INT, cnts.data(), 1, MPI_INT, comm);
+	for (int p=0, off=0; p<numprocs; p++) {
+	  disp[p] = off;
+	  off += cnts[p];
+	}
+
+	vals.resize(b.count);
+	MPI_Allgatherv(data.data() + beg, m, MPI_DOUBLE, vals.data(),
+		       cnts.data(), disp.data(), MPI_DOUBLE, comm);
+
+	auto k = vals.begin() + (b.rank - b.below);
+	std::nth_element(vals.begin(), k, vals.end());
+	ret[i] = *k;
+	b.done = true;
+      }
+      else active.push_back(i);
+    }
+
+    if (active.empty()) break;
+
+    // One histogram of each open bracket, summed over processes
+    //
+    hist.resize(active.size()*nbins);
+
+    for (size_t a=0; a<active.size(); a++) {
+      auto & b = br[active[a]];
+      long last = local(b.lo);
+      for (int j=0; j<nbins; j++) {
+	long next = local(edge(b, j+1));
+	hist[a*nbins + j] = next - last;
+	last = next;
+      }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, hist.data(), hist.size(), MPI_UNSIGNED_LONG,
+		  MPI_SUM, comm);
+
+    // Narrow to the bin holding the rank
+    //
+    for (size_t a=0; a<active.size(); a++) {
+      auto & b = br[active[a]];
+      unsigned long cum = b.below;
+      int j = 0;
+      while (j<nbins-1 and cum + hist[a*nbins + j] <= b.rank)
+	cum += hist[a*nbins + j++];
+
+      double lo = edge(b, j), hi = edge(b, j+1);
+      b.lo    = lo;
+      b.hi    = hi;
+      b.below = cum;
+      b.count = hist[a*nbins + j];
+    }
+  }
+
+  return ret;
+}
+
+std::vector<double>
+DistQuantile::quantiles(std::vector<double>& data,
+			const std::vector<double>& q, unsigned long* ntot)
+{
+  unsigned long n = data.size(), N;
+  MPI_Allreduce(&n, &N, 1, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+  if (ntot) *ntot = N;
+
+  std::vector<unsigned long> ranks(q.size());
+  for (size_t i=0; i<q.size(); i++)
+    ranks[i] = static_cast<unsigned long>(std::max<double>(q[i]*N + 0.5, 0.0));
+
+  return select(data, ranks);
+}
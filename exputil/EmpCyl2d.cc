@@ -4,17 +4,24 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <atomic>
+#include <thread>
 #include <cmath>
 
 #include <yaml-cpp/yaml.h>
 
 #include <EXPException.H>
+#include <ThreadPool.H>
 #include <EmpCyl2d.H>
 
 // Set to true for orthogonality checking
 //
 bool EmpCyl2d::Basis2d::debug = false;
 
+// Table construction threads
+//
+int EmpCyl2d::threads = 0;
+
 // Clutton-Brock two-dimensional disk
 //
 class EmpCyl2d::CluttonBrock : public EmpCyl2d::Basis2d
@@ -528,79 +535,97 @@ void EmpCyl2d::create_tables()
   dpot_array.resize(mmax+1);
   rot_matrix.resize(mmax+1);
 
-  Eigen::MatrixXd D(nmaxfid, nmaxfid);
+  // Quadrature knots and weights times the disk density, common to
+  // all harmonics
+  //
+  double ximin = map.r_to_xi(rmin);
+  double ximax = map.r_to_xi(rmax);
 
-  for (int m=0; m<=mmax; m++) {
+  std::vector<double> rk(knots), wk(knots);
+  for (int k=0; k<knots; k++) {
+    double xx  = ximin + (ximax - ximin)*lw.knot(k);
+    rk[k] = map.xi_to_r(xx);
+    wk[k] = lw.weight(k) * rk[k] / map.d_xi_to_r(xx) * (ximax - ximin) *
+      disk->dens(rk[k]);
+  }
 
-    // Compute the covariance matrix D
-    //
-    D.setZero();
+  // Radial grid
+  //
+  double lrmin = rmin, lrmax = rmax;
+  if (logr) {
+    lrmin = log(rmin);
+    lrmax = log(rmax);
+  }
+  double dr = (lrmax - lrmin)/(numr - 1);
 
-    double ximin = map.r_to_xi(rmin);
-    double ximax = map.r_to_xi(rmax);
+  xgrid.resize(numr);
+  for (int i=0; i<numr; i++) {
+    xgrid[i] = lrmin + dr*i;
+    if (logr) xgrid[i] = exp(xgrid[i]);
+  }
 
-    for (int k=0; k<knots; k++) {
-      double xx  = ximin + (ximax - ximin)*lw.knot(k);
-      double rr  = map.xi_to_r(xx);
-      double fac = lw.weight(k) * rr / map.d_xi_to_r(xx) * (ximax - ximin);
-    
-      for (int j=0; j<nmaxfid; j++) {
-	for (int l=0; l<nmaxfid; l++) {
-	  D(j, l) += fac * disk->dens(rr) *
-	    basis->potl(m, j, rr) * basis->potl(m, l, rr)
-	    / sqrt(basis->norm(j, m)*basis->norm(l, m));
-	}
-      }
-    }
-    
-    // Perform the SVD
-    //
-    Eigen::BDCSVD<Eigen::MatrixXd>
-      svd(D, Eigen::ComputeThinU | Eigen::ComputeThinV);
+  // The harmonics are independent; hand them out one at a time
+  //
+  int nthrd = threads>0 ? threads :
+    std::max<int>(1, std::thread::hardware_concurrency());
 
-    auto S = svd.singularValues();
-    auto U = svd.matrixU();
-    
-    // Compute basis functions
-    //
-    double lrmin = rmin, lrmax = rmax;
-    if (logr) {
-      lrmin = log(rmin);
-      lrmax = log(rmax);
-    }
-    double dr = (lrmax - lrmin)/(numr - 1), r;
+  std::atomic<int> next(0);
 
-    Eigen::VectorXd pot(nmaxfid), den(nmaxfid), dph(nmaxfid);
+  ThreadPool::instance().run(std::min<int>(nthrd, mmax+1), [&](int)
+  {
+    Eigen::MatrixXd D(nmaxfid, nmaxfid);
+    Eigen::VectorXd pot(nmaxfid), den(nmaxfid), dph(nmaxfid), fnorm(nmaxfid);
 
-    potl_array[m].resize(numr, nmax);
-    dens_array[m].resize(numr, nmax);
-    dpot_array[m].resize(numr, nmax);
-    rot_matrix[m] = U.transpose();
-    
-    if (m==0) xgrid.resize(numr);
+    for (int m=next++; m<=mmax; m=next++) {
 
-    for (int i=0; i<numr; i++) {
-      r = lrmin + dr*i;
-      if (logr) r = exp(r);
-      if (m==0) xgrid[i] = r;
-
-      for (int n=0; n<nmaxfid; n++) {
-	pot(n) = basis->potl(m, n, r) / sqrt(basis->norm(n, m));
-	den(n) = basis->dens(m, n, r) / sqrt(basis->norm(n, m));
-	dph(n) = basis->dpot(m, n, r) / sqrt(basis->norm(n, m));
+      for (int n=0; n<nmaxfid; n++) fnorm(n) = 1.0/sqrt(basis->norm(n, m));
+
+      // Compute the covariance matrix D
+      //
+      D.setZero();
+
+      for (int k=0; k<knots; k++) {
+	for (int n=0; n<nmaxfid; n++)
+	  pot(n) = basis->potl(m, n, rk[k]) * fnorm(n);
+	D.selfadjointView<Eigen::Lower>().rankUpdate(pot, wk[k]);
       }
+      D = D.selfadjointView<Eigen::Lower>();
+
+      // Perform the SVD
+      //
+      Eigen::BDCSVD<Eigen::MatrixXd>
+	svd(D, Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+      Eigen::MatrixXd U = svd.matrixU();
+    
+      // Compute basis functions
+      //
+      potl_array[m].resize(numr, nmax);
+      dens_array[m].resize(numr, nmax);
+      dpot_array[m].resize(numr, nmax);
+      rot_matrix[m] = U.transpose();
+    
+      for (int i=0; i<numr; i++) {
+	double r = xgrid[i];
+
+	for (int n=0; n<nmaxfid; n++) {
+	  pot(n) = basis->potl(m, n, r) * fnorm(n);
+	  den(n) = basis->dens(m, n, r) * fnorm(n);
+	  dph(n) = basis->dpot(m, n, r) * fnorm(n);
+	}
       
-      pot = U.transpose() * pot;
-      den = U.transpose() * den;
-      dph = U.transpose() * dph;
+	pot = U.transpose() * pot;
+	den = U.transpose() * den;
+	dph = U.transpose() * dph;
       
-      for (int n=0; n<nmax; n++) {
-	potl_array[m](i, n) = pot(n);
-	dens_array[m](i, n) = den(n);
-	dpot_array[m](i, n) = dph(n);
+	for (int n=0; n<nmax; n++) {
+	  potl_array[m](i, n) = pot(n);
+	  dens_array[m](i, n) = den(n);
+	  dpot_array[m](i, n) = dph(n);
+	}
       }
     }
-  }
+  });
 
   if (myid==0) WriteH5Cache();
 }
@@ -679,23 +704,21 @@ std::vector<Eigen::MatrixXd> EmpCyl2d::orthoCheck()
 {
   std::vector<Eigen::MatrixXd> ret(mmax+1);
 
-  for (int M=0; M<=mmax; M++) {
-
-    ret[M].resize(nmax, nmax);
-    ret[M].setZero();
-
-    for (int i=1; i<numr; i++) {
-      for (int j=0; j<nmax; j++) {
-	for (int l=0; l<nmax; l++) {
-	  ret[M](j, l) +=
-	    (xgrid[i-1] * potl_array[M](i-1, j) * dens_array[M](i-1, l) +
-	     xgrid[i  ] * potl_array[M](i  , j) * dens_array[M](i  , l) ) *
-	    (xgrid[i] - xgrid[i-1]) * 0.5;
-	}
-      }
-    }
+  // Trapezoidal weights in R dR, the same for every M
+  //
+  Eigen::VectorXd wgt = Eigen::VectorXd::Zero(numr);
+  for (int i=1; i<numr; i++) {
+    double h = (xgrid[i] - xgrid[i-1]) * 0.5;
+    wgt[i-1] += xgrid[i-1] * h;
+    wgt[i  ] += xgrid[i  ] * h;
+  }
 
-    ret[M] *= 2.0*M_PI;
+  // One weighted matrix product per M
+  //
+#pragma omp parallel for
+  for (int M=0; M<=mmax; M++) {
+    ret[M] = 2.0*M_PI *
+      potl_array[M].transpose() * wgt.asDiagonal() * dens_array[M];
   }
 
   return ret;
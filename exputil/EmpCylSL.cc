@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -15,6 +16,7 @@
 #include <interp.H>
 #include <thread>
 #include <exp_thread.h>
+#include <ThreadPool.H>
 #include <EXPException.H>
 #include <exputils.H>
 
@@ -37,6 +39,7 @@
 #include <numerical.H>
 #include <gaussQ.H>
 #include <EmpCylSL.H>
+#include <TopEigen.H>
 #include <DataGrid.H>
 
 #include <libvars.H>
@@ -52,15 +55,28 @@ bool     EmpCylSL::PCAEOF          = false;
 bool     EmpCylSL::PCADRY          = true;
 bool     EmpCylSL::logarithmic     = false;
 bool     EmpCylSL::enforce_limits  = false;
+bool     EmpCylSL::PACKED          = true;
+bool     EmpCylSL::NODESHARED      = false;
+bool     EmpCylSL::EIGTHREAD       = true;
+bool     EmpCylSL::MMAPCACHE       = false;
+bool     EmpCylSL::FLOATTABLE      = false;
+bool     EmpCylSL::FLOATREDUCE     = false;
+EmpCylSL::Tables EmpCylSL::LOADTABLES = EmpCylSL::Tables::all;
 int      EmpCylSL::CMAPR           = 1;
 int      EmpCylSL::CMAPZ           = 1;
 int      EmpCylSL::NUMX            = 256;
 int      EmpCylSL::NUMY            = 128;
+double   EmpCylSL::TABTOL          = 0.0;
+int      EmpCylSL::numxFull        = 0;
+int      EmpCylSL::numyFull        = 0;
+double   EmpCylSL::tabErr          = 0.0;
 int      EmpCylSL::NOUT            = 12;
 int      EmpCylSL::NUMR            = 2000;
 unsigned EmpCylSL::VFLAG           = 0;
 unsigned EmpCylSL::VTKFRQ          = 1;
 double   EmpCylSL::HEXP            = 1.0;
+int      EmpCylSL::HALLREUSE       = 1;
+double   EmpCylSL::HALLTOL         = 0.0;
 double   EmpCylSL::RMIN            = 0.001;
 double   EmpCylSL::RMAX            = 20.0;
 double   EmpCylSL::HFAC            = 0.2;
@@ -440,32 +456,128 @@ EmpCylSL::cacheInfo(const std::string& cachefile, bool verbose)
   return ret;
 }
 
+//! Deprojection side-file attributes that must match for reuse
+static YAML::Node deprojKey(double H, double Rf, int NUMR, int NINT,
+			    double RMIN, double RMAX,
+			    EmpCylSL::AxiDiskPtr func)
+{
+  YAML::Node key;
+  key["model"]  = func->getID();
+  key["params"] = func->getParams();
+  key["H"]      = H;
+  key["Rf"]     = Rf;
+  key["NUMR"]   = NUMR;
+  key["NINT"]   = NINT;
+  key["RMIN"]   = RMIN;
+  key["RMAX"]   = RMAX;
+  return key;
+}
+
+bool EmpCylSL::read_deprojection(const std::string& file,
+				 const std::string& key,
+				 std::vector<double>& rl,
+				 std::vector<double>& rho,
+				 std::vector<double>& mass)
+{
+  if (not std::filesystem::exists(file)) return false;
+
+  try {
+    HighFive::SilenceHDF5 quiet;
+    HighFive::File h5(file, HighFive::File::ReadOnly);
+
+    if (getH5<std::string>("Version", h5).compare(DeprojVersion)) return false;
+    if (getH5<std::string>("key", h5).compare(key)) return false;
+
+    h5.getDataSet("rl"  ).read(rl);
+    h5.getDataSet("rho" ).read(rho);
+    h5.getDataSet("mass").read(mass);
+  }
+  catch (std::exception& e) {
+    if (myid==0)
+      std::cerr << "EmpCylSL::create_deprojection: ignoring <" << file
+		<< ">: " << e.what() << std::endl;
+    return false;
+  }
+
+  return rl.size()==rho.size() and rl.size()==mass.size() and rl.size()>1;
+}
+
+void EmpCylSL::write_deprojection(const std::string& file,
+				  const std::string& key,
+				  const std::vector<double>& rl,
+				  const std::vector<double>& rho,
+				  const std::vector<double>& mass)
+{
+  try {
+    HighFive::File h5(file, HighFive::File::Overwrite);
+
+    h5.createAttribute<std::string>("Version", HighFive::DataSpace::From(DeprojVersion)).write(DeprojVersion);
+    h5.createAttribute<std::string>("key", HighFive::DataSpace::From(key)).write(key);
+
+    h5.createDataSet("rl",   rl  );
+    h5.createDataSet("rho",  rho );
+    h5.createDataSet("mass", mass);
+  }
+  catch (std::exception& e) {
+    std::cerr << "EmpCylSL::create_deprojection: could not write <" << file
+	      << ">: " << e.what() << std::endl;
+  }
+}
+
 void EmpCylSL::create_deprojection(double H, double Rf, int NUMR, int NINT,
 				   AxiDiskPtr func)
 {
+  // Reuse the tables from the side file if they were computed for
+  // the same model and quadrature.  The default ID does not identify
+  // the model, so those are always recomputed.
+  //
+  std::string dfile, dkey;
+  if (cachefile.size() and func->getID() != "AxiDisk") {
+    dfile = cachefile + ".deproj";
+    YAML::Emitter out;
+    out << YAML::Flow << deprojKey(H, Rf, NUMR, NINT, RMIN, RMAX, func);
+    dkey = out.c_str();
+
+    std::vector<double> rl, rho, mass;
+    if (read_deprojection(dfile, dkey, rl, rho, mass)) {
+      if (myid==0 and VFLAG & 1)
+	std::cout << "EmpCylSL::create_deprojection: using <" << dfile << ">"
+		  << std::endl;
+      densRg = Linear1d(rl, rho);
+      massRg = Linear1d(rl, mass);
+      mtype  = Deproject;
+      return;
+    }
+  }
+
   LegeQuad lq(NINT);
 
-  std::vector<double> rr(NUMR), rl(NUMR), sigI(NUMR), rhoI(NUMR, 0.0);
+  std::vector<double> rr(NUMR), rl(NUMR), sigI(NUMR, 0.0), rhoI(NUMR, 0.0);
 
   double Rmin = log(RMIN);
   double Rmax = log(RMAX);
 
   double dr = (Rmax - Rmin)/(NUMR-1);
 
-  // Compute surface mass density, Sigma(R)
+  for (int i=0; i<NUMR; i++) {
+    rl[i] = Rmin + dr*i;	// Save for finite difference
+    rr[i] = exp(rl[i]);
+  }
+
+  // Compute surface mass density, Sigma(R).  The model evaluations
+  // dominate, so the radii are split between processes and threads.
   //
+  omp_set_dynamic(0);
+  omp_set_num_threads(nthrds);
+
+#pragma omp parallel for schedule(dynamic)
   for (int i=0; i<NUMR; i++) {
-    double r = Rmin + dr*i;
+    if (use_mpi and i % numprocs != myid) continue;
 
-    // Save for finite difference
-    //
-    rl[i] = r;
-    r = exp(r);
-    rr[i] = r;
+    double r = rr[i];
 
     // Interval by Legendre
     //
-    sigI[i] = 0.0;
     for (int n=0; n<NINT; n++) {
       double y   = lq.knot(n);
       double y12 = 1.0 - y*y;
@@ -475,10 +587,15 @@ void EmpCylSL::create_deprojection(double H, double Rf, int NUMR, int NINT,
     }
   }
 
+  if (use_mpi)
+    MPI_Allreduce(MPI_IN_PLACE, sigI.data(), NUMR, MPI_DOUBLE, MPI_SUM,
+		  MPI_COMM_WORLD);
+
   Linear1d surf(rl, sigI);
   
   // Now, compute Abel inverion integral
   //
+#pragma omp parallel for
   for (int i=0; i<NUMR; i++) {
     double r = rr[i];
 
@@ -524,6 +641,9 @@ void EmpCylSL::create_deprojection(double H, double Rf, int NUMR, int NINT,
     }
   }
 
+  if (dfile.size() and myid==0)
+    write_deprojection(dfile, dkey, rl, rho, mass);
+
   // Finalize
   //
   densRg = Linear1d(rl, rho);
@@ -695,6 +815,22 @@ void EmpCylSL::send_eof_grid()
   auto blab = [](auto& s, auto& t, auto id, auto m, auto v) {};
 #endif
 
+  // Node-shared grids: the leaders receive the whole contiguous store
+  // and the other ranks see it through the shared window
+  //
+  if (gridstore.isShared()) {
+    MPI_Comm leaders = NodeSharedArray::leaderComm();
+    if (leaders != MPI_COMM_NULL) {
+      const size_t block = 1<<28;
+      for (size_t beg=0; beg<gridstore.size(); beg+=block) {
+	int cnt = std::min<size_t>(block, gridstore.size() - beg);
+	MPI_Bcast(gridstore.data() + beg, cnt, MPI_DOUBLE, 0, leaders);
+      }
+    }
+    gridstore.sync();
+    return;
+  }
+
   // Send to workers
   // 
   for (int m=0; m<=MMAX; m++) {
@@ -708,20 +844,26 @@ void EmpCylSL::send_eof_grid()
 		MPI_DOUBLE, 0, MPI_COMM_WORLD);
       blab("after", "potC", myid, m, v);
 
-      blab("before", "rforceC", myid, m, v);
-      MPI_Bcast(rforceC[m][v].data(), rforceC[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "rforceC", myid, m, v);
-
-      blab("before", "zforceC", myid, m, v);
-      MPI_Bcast(zforceC[m][v].data(), zforceC[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "zforceC", myid, m, v);
+      // Grids that are not loaded are not sent
+      //
+      if (hasFrc()) {
+	blab("before", "rforceC", myid, m, v);
+	MPI_Bcast(rforceC[m][v].data(), rforceC[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "rforceC", myid, m, v);
+
+	blab("before", "zforceC", myid, m, v);
+	MPI_Bcast(zforceC[m][v].data(), zforceC[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "zforceC", myid, m, v);
+      }
 
-      blab("before", "densC", myid, m, v);
-      MPI_Bcast(densC[m][v].data(), densC[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "densC", myid, m, v);
+      if (hasDen()) {
+	blab("before", "densC", myid, m, v);
+	MPI_Bcast(densC[m][v].data(), densC[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "densC", myid, m, v);
+      }
     }
   }
 
@@ -736,20 +878,26 @@ void EmpCylSL::send_eof_grid()
 		MPI_DOUBLE, 0, MPI_COMM_WORLD);
       blab("after", "potS", myid, m, v);
 
-      blab("before", "rforceS", myid, m, v);
-      MPI_Bcast(rforceS[m][v].data(), rforceS[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "rforceS", myid, m, v);
-
-      blab("before", "zforceS", myid, m, v);
-      MPI_Bcast(zforceS[m][v].data(), zforceS[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "zforceS", myid, m, v);
+      // Grids that are not loaded are not sent
+      //
+      if (hasFrc()) {
+	blab("before", "rforceS", myid, m, v);
+	MPI_Bcast(rforceS[m][v].data(), rforceS[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "rforceS", myid, m, v);
+
+	blab("before", "zforceS", myid, m, v);
+	MPI_Bcast(zforceS[m][v].data(), zforceS[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "zforceS", myid, m, v);
+      }
 
-      blab("before", "densS", myid, m, v);
-      MPI_Bcast(densS[m][v].data(), densS[m][v].size(),
-		MPI_DOUBLE, 0, MPI_COMM_WORLD);
-      blab("after", "densS", myid, m, v);
+      if (hasDen()) {
+	blab("before", "densS", myid, m, v);
+	MPI_Bcast(densS[m][v].data(), densS[m][v].size(),
+		  MPI_DOUBLE, 0, MPI_COMM_WORLD);
+	blab("after", "densS", myid, m, v);
+      }
     }
       
   }
@@ -889,6 +1037,8 @@ int EmpCylSL::read_eof_file(const string& eof_file)
 	      << std::endl;
 
 
+  pack_tables();
+
   // EOF basis complete but need to compute coefficients
   //
   eof_made = true;
@@ -899,25 +1049,49 @@ int EmpCylSL::read_eof_file(const string& eof_file)
 
 int EmpCylSL::read_cache(void)
 {
+  if (TABTOL>0.0) adopt_resolution();
+
+  // Tables read from the cache may be restricted to those needed;
+  // a mapped table is always complete
+  //
+  loaded = mapCache() ? Tables::all : LOADTABLES;
+
   setup_table();
   setup_accumulation();
 
-  // Root tries to read table
+  // Root tries to read table.  With a mappable cache, every process
+  // maps the table from the file instead.
   //
-  int retcode;
-  if (myid==0)  retcode = cache_grid(0, cachefile);
-  if (use_mpi)  MPI_Bcast(&retcode, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  if (!retcode) return 0;
+  bool local = use_mpi and mapCache();
+
+  int retcode = 0;
+  if (myid==0 or local) retcode = cache_grid(0, cachefile);
+  if (local)
+    MPI_Allreduce(MPI_IN_PLACE, &retcode, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  else if (use_mpi)
+    MPI_Bcast(&retcode, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  // The tables will be computed: restore the full storage
+  //
+  if (!retcode) {
+    if (loaded != Tables::all) {
+      loaded = Tables::all;
+      allocate_grids();
+    }
+    return 0;
+  }
 
   // Send table to worker processes
   //
-  if (use_mpi)  send_eof_grid();
+  if (use_mpi and not local) send_eof_grid();
 
   if (myid==0) {
     std::cout << "---- EmpCylSL::read_cache: table forwarded to all processes"
 	      << std::endl;
   }
 
+  pack_tables();
+
   // EOF complete, but still need to compute coefficients
   //
   eof_made = true;
@@ -1135,29 +1309,28 @@ int EmpCylSL::cache_grid(int readwrite, std::string cachename)
 	  return 0;
 	}
 
-      // Read table
+      // Read table.  Grids that are not loaded are skipped.
       //
-      Eigen::MatrixXd work(NUMY+1, NUMX+1);
+      const std::streamoff gsize = sizeof(double)*(NUMX+1)*(NUMY+1);
+
+      auto read = [&](GridMap& g, bool held)
+      {
+	if (not held) {
+	  in.seekg(gsize, std::ios::cur);
+	  return;
+	}
+	for (int ix=0; ix<=NUMX; ix++)
+	  for (int iy=0; iy<=NUMY; iy++)
+	    in.read((char *)&g(ix, iy), sizeof(double));
+      };
       
       for (int m=0; m<=MMAX; m++) {
 	
 	for (int v=0; v<rank3; v++) {
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&potC[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&rforceC[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&zforceC[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&densC[m][v](ix, iy), sizeof(double));
+	  read(potC   [m][v], true    );
+	  read(rforceC[m][v], hasFrc());
+	  read(zforceC[m][v], hasFrc());
+	  read(densC  [m][v], hasDen());
 	}
 	
       }
@@ -1165,22 +1338,10 @@ int EmpCylSL::cache_grid(int readwrite, std::string cachename)
       for (int m=1; m<=MMAX; m++) {
 
 	for (int v=0; v<rank3; v++) {
-
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&potS[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&rforceS[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&zforceS[m][v](ix, iy), sizeof(double));
-	  
-	  for (int ix=0; ix<=NUMX; ix++)
-	    for (int iy=0; iy<=NUMY; iy++)
-	      in.read((char *)&densS[m][v](ix, iy), sizeof(double));
+	  read(potS   [m][v], true    );
+	  read(rforceS[m][v], hasFrc());
+	  read(zforceS[m][v], hasFrc());
+	  read(densS  [m][v], hasDen());
 	}
 	
       }
@@ -1270,6 +1431,13 @@ YAML::Node EmpCylSL::getHeader_hdf5(const std::string& cachefile)
     node["ascl"]     = getDbl("ascl");
     node["hscl"]     = getDbl("hscl");
     node["cmass"]    = getDbl("cmass");
+
+    if (file.hasAttribute("tabtol")) {
+      node["numxfull"] = getInt("numxfull");
+      node["numyfull"] = getInt("numyfull");
+      node["tabtol"]   = getDbl("tabtol");
+      node["taberr"]   = getDbl("taberr");
+    }
   }
   catch (YAML::Exception& error) {
     std::ostringstream sout;
@@ -1863,16 +2031,20 @@ void EmpCylSL::setup_accumulation(int mlevel)
     howmany1.resize(multistep+1);
     howmany .resize(multistep+1, 0);
 
+    // The accumulators of the current state are per thread; the last
+    // state is only read after the reduction and has one copy
+    //
     for (unsigned M=0; M<=multistep; M++) {
-      cosL[M] = std::make_shared<VectorD2>(nthrds);
+      cosL[M] = std::make_shared<VectorD2>(1);
       cosN[M] = std::make_shared<VectorD2>(nthrds);
-      sinL[M] = std::make_shared<VectorD2>(nthrds);
+      sinL[M] = std::make_shared<VectorD2>(1);
       sinN[M] = std::make_shared<VectorD2>(nthrds);
       
+      cosL(M)[0].resize(MMAX+1);
+      sinL(M)[0].resize(MMAX+1);
+
       for (int nth=0; nth<nthrds; nth++) {
-	cosL(M)[nth].resize(MMAX+1);
 	cosN(M)[nth].resize(MMAX+1);
-	sinL(M)[nth].resize(MMAX+1);
 	sinN(M)[nth].resize(MMAX+1);
       }
 
@@ -1885,36 +2057,30 @@ void EmpCylSL::setup_accumulation(int mlevel)
 
     cylmass_made = false;
 
-    for (unsigned M=0; M<=multistep; M++) {
-      
-      for (int nth=0; nth<nthrds; nth++) {
+    // Each thread allocates and first touches its own accumulators
+    // so that they are local to the thread's memory node
+    //
+    ThreadPool::instance().run(nthrds, [&](int nth)
+    {
+      for (unsigned M=0; M<=multistep; M++) {
 	
 	for (int m=0; m<=MMAX; m++) {
 	  
-	  cosN(M)[nth][m].resize(NORDER);
-	  cosL(M)[nth][m].resize(NORDER);
+	  cosN(M)[nth][m].setZero(NORDER);
+	  if (nth==0) cosL(M)[0][m].setZero(NORDER);
 	  
 	  if (m>0) {
-	    sinN(M)[nth][m].resize(NORDER);
-	    sinL(M)[nth][m].resize(NORDER);
+	    sinN(M)[nth][m].setZero(NORDER);
+	    if (nth==0) sinL(M)[0][m].setZero(NORDER);
 	  }
 	}
       }
-    }
+    });
     
     for (int m=0; m<=MMAX; m++) {
       accum_cos[m].resize(NORDER);
       if (m>0) accum_sin[m].resize(NORDER);
     }
-    
-    for (unsigned M=0; M<=multistep; M++) {
-      for (int nth=0; nth<nthrds; nth++) {
-	for (int m=0; m<=MMAX; m++) {
-	  cosN(M)[nth][m].setZero();
-	  if (m>0) sinN(M)[nth][m].setZero();
-	}
-      }
-    }
 
     if (PCAVAR and sampT>0) {
       for (int nth=0; nth<nthrds; nth++) {
@@ -1967,15 +2133,12 @@ void EmpCylSL::setup_accumulation(int mlevel)
   //
   howmany[mlevel] = 0;
 
-  // Swap buffers
+  // The reduced current state becomes the last state
   //
-  auto p  = cosL[mlevel];
-  cosL[mlevel] = cosN[mlevel];
-  cosN[mlevel] = p;
-    
-  p       = sinL[mlevel];
-  sinL[mlevel] = sinN[mlevel];
-  sinN[mlevel] = p;
+  for (int m=0; m<=MMAX; m++) {
+    cosL(mlevel)[0][m] = cosN(mlevel)[0][m];
+    if (m>0) sinL(mlevel)[0][m] = sinN(mlevel)[0][m];
+  }
     
   // Clean current coefficient files
   //
@@ -1990,6 +2153,17 @@ void EmpCylSL::setup_accumulation(int mlevel)
   }
     
   coefs_made[mlevel] = false;
+  coefs_reduced.erase(mlevel);
+
+  // Moment grids for binned accumulation
+  //
+  if (binned) {
+    size_t ngrid = (NUMX+1)*(NUMY+1)*(2*MMAX+1);
+    bingrid.resize(nthrds);
+    for (auto & v : bingrid) v.assign(ngrid, 0.0);
+    binLevel   = mlevel;
+    binPending = false;
+  }
 
   // DONE
 }
@@ -2004,8 +2178,11 @@ void EmpCylSL::init_pca()
 
     pthread_mutex_init(&used_lock, NULL);
 
-    if (PCAEOF)
+    if (PCAEOF) {
       tvar.resize(nthrds);
+      pcabuf.resize(nthrds);
+      pcavec.resize(nthrds);
+    }
 
     if (PCAVAR) {
       covV  .resize(nthrds);
@@ -2020,6 +2197,9 @@ void EmpCylSL::init_pca()
       if (PCAEOF) {
 	tvar[nth].resize(MMAX + 1);
 	for (auto & v : tvar[nth]) v.resize(rank3, rank3);
+	pcabuf[nth].resize(MMAX + 1);
+	for (auto & v : pcabuf[nth]) v.resize(rank3);
+	pcavec[nth].resize(rank3);
       }
 
       if (PCAVAR) {
@@ -2044,173 +2224,506 @@ void EmpCylSL::init_pca()
   }
 }
 
-void EmpCylSL::setup_table()
+EmpCylSL::Tables EmpCylSL::parseTables(const std::string& name)
 {
-  // Create storage for EOF tables
-  //
-  rank2   = NMAX*(LMAX+1);
-  rank3   = NORDER;
-    
-  Rtable  = M_SQRT1_2 * RMAX;
-  XMIN    = r_to_xi(RMIN*ASCALE);
-  XMAX    = r_to_xi(Rtable*ASCALE);
-  dX      = (XMAX - XMIN)/NUMX;
+  if (name == "all")     return Tables::all;
+  if (name == "forces")  return Tables::forces;
+  if (name == "density") return Tables::density;
 
-  YMIN    = z_to_y(-Rtable*ASCALE);
-  YMAX    = z_to_y( Rtable*ASCALE);
-  dY      = (YMAX - YMIN)/NUMY;
+  throw std::runtime_error("EmpCylSL::parseTables: tables must be one of "
+			   "'all', 'forces' or 'density', found '" +
+			   name + "'");
+}
 
-  potC    .resize(MMAX+1);
-  rforceC .resize(MMAX+1);
-  zforceC .resize(MMAX+1);
-  
-  potS    .resize(MMAX+1);
-  rforceS .resize(MMAX+1);
-  zforceS .resize(MMAX+1);
-  
-  densC   .resize(MMAX+1);
-  densS   .resize(MMAX+1);
+void EmpCylSL::allocate_grids()
+{
+  const size_t ngrid = (NUMX+1)*(NUMY+1);
+  const int    nfld  = 1 + 2*hasFrc() + hasDen();
+  const size_t total = nfld*ngrid*rank3*(2*MMAX+1);
 
-  for (int m=0; m<=MMAX; m++) {
+  bool share = NODESHARED and use_mpi;
 
-    potC[m]   .resize(rank3);
-    rforceC[m].resize(rank3);
-    zforceC[m].resize(rank3);
-    densC[m]  .resize(rank3);
-    
-    for (int v=0; v<rank3; v++) {
-      potC   [m][v].resize(NUMX+1, NUMY+1);
-      rforceC[m][v].resize(NUMX+1, NUMY+1);
-      zforceC[m][v].resize(NUMX+1, NUMY+1);
-      densC  [m][v].resize(NUMX+1, NUMY+1);
-    }
+  // Reuse the current storage if nothing has changed
+  //
+  // Reuse the current storage if nothing has changed.  A read-only
+  // file mapping is always replaced.
+  //
+  if (gridstore.size() != total or gridstore.isShared() != share or
+      gridstore.isMapped() or potC.size() != MMAX+1) {
+
+    gridstore.allocate(total, share);
+    bind_grids();
   }
-  
-  for (int m=1; m<=MMAX; m++) {
-    
-    potS[m]   .resize(rank3);
-    rforceS[m].resize(rank3);
-    zforceS[m].resize(rank3);
-    densS[m]  .resize(rank3);
-    
+}
+
+void EmpCylSL::bind_grids()
+{
+  const size_t ngrid = (NUMX+1)*(NUMY+1);
+
+  double *next = gridstore.data();
+
+  // Fields that are not loaded share one grid of zeros
+  //
+  if (loaded == Tables::all)
+    zerogrid.resize(0, 0);
+  else
+    zerogrid = Eigen::MatrixXd::Zero(NUMX+1, NUMY+1);
+
+  auto bind = [&](std::vector<std::vector<GridMap>>& grid, int m, bool held)
+  {
+    grid[m].clear();
     for (int v=0; v<rank3; v++) {
-      potS   [m][v].resize(NUMX+1, NUMY+1);
-      rforceS[m][v].resize(NUMX+1, NUMY+1);
-      zforceS[m][v].resize(NUMX+1, NUMY+1);
-      densS  [m][v].resize(NUMX+1, NUMY+1);
+      if (held) {
+	grid[m].emplace_back(next, NUMX+1, NUMY+1);
+	next += ngrid;
+      } else {
+	grid[m].emplace_back(zerogrid.data(), NUMX+1, NUMY+1);
+      }
     }
-  }
+  };
 
-  vc.resize(nthrds);
-  vs.resize(nthrds);
-  for (int i=0; i<nthrds; i++) {
-    vc[i].resize(max<int>(1,MMAX)+1, rank3);
-    vs[i].resize(max<int>(1,MMAX)+1, rank3);
+  for (auto g : {&potC, &rforceC, &zforceC, &densC,
+		 &potS, &rforceS, &zforceS, &densS}) {
+    g->clear();
+    g->resize(MMAX+1);
   }
 
+  for (int m=0; m<=MMAX; m++) {
+    bind(potC,    m, true    );
+    bind(rforceC, m, hasFrc());
+    bind(zforceC, m, hasFrc());
+    bind(densC,   m, hasDen());
+  }
+    
+  for (int m=1; m<=MMAX; m++) {
+    bind(potS,    m, true    );
+    bind(rforceS, m, hasFrc());
+    bind(zforceS, m, hasFrc());
+    bind(densS,   m, hasDen());
+  }
 }
 
-void EmpCylSL::setup_eof()
+double EmpCylSL::decimation_error(int fx, int fy, double tol)
 {
-  if (SC.size()==0 and SCe.size()==0) {
-
-    setup_table();
+  double worst = 0.0;
 
-    tpot   .resize(NORDER);
-    trforce.resize(NORDER);
-    tzforce.resize(NORDER);
-    tdens  .resize(NORDER);
+  auto check = [&](const GridMap& g)
+  {
+    double scale = g.cwiseAbs().maxCoeff();
+    if (scale<=0.0) return;
 
-    for (int n=0; n<NORDER; n++) {
-      tpot[n].resize(NUMX+1, NUMY+1);
-      trforce[n].resize(NUMX+1, NUMY+1);
-      tzforce[n].resize(NUMX+1, NUMY+1);
-      tdens[n].resize(NUMX+1, NUMY+1);
-    }
+    for (int ix=0; ix<=NUMX; ix++) {
+      int jx = std::min<int>(ix/fx, NUMX/fx-1);
+      double a = static_cast<double>(ix - jx*fx)/fx;
 
-    if (EvenOdd) {
-      SCe.resize(nthrds);
-      SSe.resize(nthrds);
+      for (int iy=0; iy<=NUMY; iy++) {
+	int jy = std::min<int>(iy/fy, NUMY/fy-1);
+	double b = static_cast<double>(iy - jy*fy)/fy;
 
-      SCo.resize(nthrds);
-      SSo.resize(nthrds);
+	double v =
+	  (1.0-a)*(1.0-b)*g( jx   *fx,  jy   *fy) +
+	  a      *(1.0-b)*g((jx+1)*fx,  jy   *fy) +
+	  (1.0-a)*b      *g( jx   *fx, (jy+1)*fy) +
+	  a      *b      *g((jx+1)*fx, (jy+1)*fy) ;
 
-      for (int nth=0; nth<nthrds; nth++) {
-	SCe[nth].resize(MMAX+1);
-	SSe[nth].resize(MMAX+1);
+	worst = std::max<double>(worst, fabs(v - g(ix, iy))/scale);
+      }
+    }
+  };
 
-	SCo[nth].resize(MMAX+1);
-	SSo[nth].resize(MMAX+1);
+  for (int m=0; m<=MMAX and worst<=tol; m++) {
+    for (int n=0; n<rank3 and worst<=tol; n++) {
+      check(potC[m][n]);
+      check(rforceC[m][n]);
+      check(zforceC[m][n]);
+      check(densC[m][n]);
+      if (m) {
+	check(potS[m][n]);
+	check(rforceS[m][n]);
+	check(zforceS[m][n]);
+	check(densS[m][n]);
       }
+    }
+  }
 
-      lE.resize(MMAX+1);
-      lO.resize(MMAX+1);
+  return worst;
+}
 
-    } else {
-      SC.resize(nthrds);
-      SS.resize(nthrds);
+void EmpCylSL::choose_resolution()
+{
+  if (numxFull) return;		// Already chosen
 
-      for (int nth=0; nth<nthrds; nth++) {
-	SC[nth].resize(MMAX+1);
-	SS[nth].resize(MMAX+1);
-      }
+  // The grids are identical on every process so each makes the same
+  // choice
+  //
+  int bestx = 1, besty = 1;
+  size_t best = static_cast<size_t>(NUMX+1)*(NUMY+1);
+  double err  = 0.0;
+
+  // Keep at least 8 cells in each dimension
+  //
+  for (int fx=1; NUMX%fx==0 and NUMX/fx>=8; fx*=2) {
+    for (int fy=1; NUMY%fy==0 and NUMY/fy>=8; fy*=2) {
+      size_t size = static_cast<size_t>(NUMX/fx+1)*(NUMY/fy+1);
+      if (size >= best) continue;
+      double e = decimation_error(fx, fy, TABTOL);
+      if (e > TABTOL) break;	// Coarser in y will not do better
+      bestx = fx;
+      besty = fy;
+      best  = size;
+      err   = e;
     }
+  }
 
-    potd.resize(LMAX+1, NMAX);
-    dpot.resize(LMAX+1, NMAX);
-    dend.resize(LMAX+1, NMAX);
+  numxFull = NUMX;
+  numyFull = NUMY;
+  tabErr   = err;
 
-    cosm .resize(nthrds);
-    sinm .resize(nthrds);
-    legs .resize(nthrds);
-    dlegs.resize(nthrds);
-    for (int i=0; i<nthrds; i++) {
-      cosm[i].resize(LMAX+1);
-      sinm[i].resize(LMAX+1);
-      legs[i].resize(LMAX+1, LMAX+1);
-      dlegs[i].resize(LMAX+1, LMAX+1);
-    }
+  if (myid==0)
+    std::cout << "---- EmpCylSL: table resolution " << NUMX/bestx
+	      << "x" << NUMY/besty << " of " << NUMX << "x" << NUMY
+	      << ", relative interpolation error " << err << std::endl;
 
-    if (EvenOdd) {
-      varE.resize(MMAX+1);
-      varO.resize(MMAX+1);
+  if (bestx==1 and besty==1) return;
 
-      for (int m=0; m<=MMAX; m++) {
+  // Resample into the smaller store
+  //
+  std::vector<Eigen::MatrixXd> save;
+  auto keep = [&](const GridMap& g)
+  {
+    Eigen::MatrixXd c(NUMX/bestx+1, NUMY/besty+1);
+    for (int ix=0; ix<c.rows(); ix++)
+      for (int iy=0; iy<c.cols(); iy++) c(ix, iy) = g(ix*bestx, iy*besty);
+    save.push_back(c);
+  };
 
-	lE[m].clear();	// Store even l values
-	lO[m].clear();	// Store odd  l values
+  for (int m=0; m<=MMAX; m++) {
+    for (int n=0; n<rank3; n++) {
+      keep(potC[m][n]); keep(rforceC[m][n]); keep(zforceC[m][n]); keep(densC[m][n]);
+      if (m==0) continue;
+      keep(potS[m][n]); keep(rforceS[m][n]); keep(zforceS[m][n]); keep(densS[m][n]);
+    }
+  }
 
-	for (int l=m; l<=LMAX; l++) {
-	  // Symmetry for the associated Legendre polynomials
-	  //   |   depends on whether l+m is even or odd
-	  //   v        
-	  if ((l+m) % 2==0) lE[m].push_back(l);
-	  else              lO[m].push_back(l);
-	}
-	
-	int Esiz = lE[m].size();
-	int Osiz = lO[m].size();
+  NUMX /= bestx;
+  NUMY /= besty;
+  dX = (XMAX - XMIN)/NUMX;
+  dY = (YMAX - YMIN)/NUMY;
 
-	varE[m].resize(NMAX*Esiz, NMAX*Esiz);
-	varO[m].resize(NMAX*Osiz, NMAX*Osiz);
-      }
+  allocate_grids();
 
-    } else {
-      var.resize(MMAX+1);
-      for (int m=0; m<=MMAX; m++)
-	var[m].resize(NMAX*(LMAX-m+1), NMAX*(LMAX-m+1));
+  if (gridstore.writer()) {
+    auto next = save.begin();
+    for (int m=0; m<=MMAX; m++) {
+      for (int n=0; n<rank3; n++) {
+	potC[m][n] = *next++; rforceC[m][n] = *next++;
+	zforceC[m][n] = *next++; densC[m][n] = *next++;
+	if (m==0) continue;
+	potS[m][n] = *next++; rforceS[m][n] = *next++;
+	zforceS[m][n] = *next++; densS[m][n] = *next++;
+      }
     }
+  }
 
-    for (int nth=0; nth<nthrds; nth++) {
-
-      for (int m=0; m<=MMAX; m++) {
+  gridstore.sync();
+}
 
-	if (EvenOdd) {
-	  int Esiz = lE[m].size();
-	  int Osiz = lO[m].size();
+void EmpCylSL::adopt_resolution()
+{
+  if (numxFull) return;		// Already chosen
 
-	  SCe[nth][m].resize(NMAX*Esiz);
-	  SCo[nth][m].resize(NMAX*Osiz);
+  int dims[2] = {NUMX, NUMY}, found = 0;
+
+  if (myid==0 and std::filesystem::exists(cachefile)) {
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File file(cachefile, HighFive::File::ReadOnly);
+
+      if (file.hasAttribute("tabtol")) {
+	double tol;
+	int nx, ny, fx, fy;
+	file.getAttribute("tabtol").read(tol);
+	file.getAttribute("numxfull").read(fx);
+	file.getAttribute("numyfull").read(fy);
+	file.getAttribute("numx").read(nx);
+	file.getAttribute("numy").read(ny);
+	if (fabs(tol - TABTOL) < 1.0e-16 and fx==NUMX and fy==NUMY) {
+	  dims[0] = nx;
+	  dims[1] = ny;
+	  found   = 1;
+	  file.getAttribute("taberr").read(tabErr);
+	}
+      }
+    }
+    catch (HighFive::Exception& err) {
+      // Not a usable cache; read_cache() will say so
+    }
+  }
+
+  if (use_mpi) {
+    MPI_Bcast(dims,    2, MPI_INT,    0, MPI_COMM_WORLD);
+    MPI_Bcast(&found,  1, MPI_INT,    0, MPI_COMM_WORLD);
+    MPI_Bcast(&tabErr, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  }
+
+  // Otherwise the basis is computed and choose_resolution() decides
+  //
+  if (not found) return;
+
+  numxFull = NUMX;
+  numyFull = NUMY;
+  NUMX     = dims[0];
+  NUMY     = dims[1];
+
+  if (myid==0)
+    std::cout << "---- EmpCylSL: table resolution " << NUMX << "x" << NUMY
+	      << " of " << numxFull << "x" << numyFull << " from <"
+	      << cachefile << ">, relative interpolation error " << tabErr
+	      << std::endl;
+}
+
+void EmpCylSL::setup_table()
+{
+  // Create storage for EOF tables
+  //
+  rank2   = NMAX*(LMAX+1);
+  rank3   = NORDER;
+    
+  Rtable  = M_SQRT1_2 * RMAX;
+  XMIN    = r_to_xi(RMIN*ASCALE);
+  XMAX    = r_to_xi(Rtable*ASCALE);
+  dX      = (XMAX - XMIN)/NUMX;
+
+  YMIN    = z_to_y(-Rtable*ASCALE);
+  YMAX    = z_to_y( Rtable*ASCALE);
+  dY      = (YMAX - YMIN)/NUMY;
+
+  allocate_grids();
+
+  vc.resize(nthrds);
+  vs.resize(nthrds);
+  for (int i=0; i<nthrds; i++) {
+    vc[i].resize(max<int>(1,MMAX)+1, rank3);
+    vs[i].resize(max<int>(1,MMAX)+1, rank3);
+  }
+
+}
+
+void EmpCylSL::pack_tables()
+{
+  // Offsets of the loaded fields in each packed cell
+  //
+  pfield = 0;
+  for (int f=0; f<NFIELD; f++) {
+    bool held = true;
+    if (f==fRfcC or f==fZfcC or f==fRfcS or f==fZfcS) held = hasFrc();
+    if (f==fDenC or f==fDenS)                         held = hasDen();
+    poff[f] = held ? pfield++ : -1;
+  }
+
+  if (not PACKED) {
+    ptable.release();
+    ftable.release();
+    return;
+  }
+
+  const int ncell = (MMAX+1)*rank3*pfield;
+  const bool share = NODESHARED and use_mpi;
+
+  std::array<std::vector<std::vector<GridMap>>*, NFIELD> grid =
+    {&potC, &rforceC, &zforceC, &densC, &potS, &rforceS, &zforceS, &densS};
+
+  auto fill = [&](auto& tab)
+  {
+    tab.allocate((NUMX+1)*(NUMY+1)*ncell, share);
+
+    // With node-shared tables only the leader fills the table
+    //
+    if (tab.writer()) {
+
+      for (int ix=0; ix<=NUMX; ix++) {
+	for (int iy=0; iy<=NUMY; iy++) {
+	  auto *t = tab.data() + (ix*(NUMY+1) + iy)*ncell;
+	  for (int m=0; m<=MMAX; m++) {
+	    for (int n=0; n<rank3; n++, t+=pfield) {
+	      for (int f=0; f<NFIELD; f++) {
+		if (poff[f]<0) continue;
+		// No sine terms for m=0
+		t[poff[f]] = (m or f<fPotS) ? (*grid[f])[m][n](ix, iy) : 0.0;
+	      }
+	    }
+	  }
+	}
+      }
+    }
+
+    tab.sync();
+  };
+
+  if (FLOATTABLE) {
+    ptable.release();
+    fill(ftable);
+    if (myid==0) float_report();
+  } else {
+    ftable.release();
+    fill(ptable);
+  }
+}
+
+
+void EmpCylSL::float_report()
+{
+  // Largest rounding error of the float table for each field,
+  // relative to the largest magnitude of that field.  The bilinear
+  // weights sum to one, so this also bounds the relative error of
+  // every interpolated basis value.
+  //
+  const int ncell = (MMAX+1)*rank3*pfield;
+
+  std::array<std::vector<std::vector<GridMap>>*, NFIELD> grid =
+    {&potC, &rforceC, &zforceC, &densC, &potS, &rforceS, &zforceS, &densS};
+
+  std::array<double, NFIELD> maxv, maxe;
+  maxv.fill(0.0);
+  maxe.fill(0.0);
+
+  for (int ix=0; ix<=NUMX; ix++) {
+    for (int iy=0; iy<=NUMY; iy++) {
+      const float *t = ftable.data() + (ix*(NUMY+1) + iy)*ncell;
+      for (int m=0; m<=MMAX; m++) {
+	for (int n=0; n<rank3; n++, t+=pfield) {
+	  for (int f=0; f<NFIELD; f++) {
+	    if (poff[f]<0 or (m==0 and f>=fPotS)) continue;
+	    double v = (*grid[f])[m][n](ix, iy);
+	    maxv[f] = std::max<double>(maxv[f], fabs(v));
+	    maxe[f] = std::max<double>(maxe[f], fabs(v - t[poff[f]]));
+	  }
+	}
+      }
+    }
+  }
+
+  const char *labs[] = {"potC", "rforceC", "zforceC", "densC",
+			"potS", "rforceS", "zforceS", "densS"};
+
+  std::cout << "---- EmpCylSL: float table relative error";
+  for (int f=0; f<NFIELD; f++) {
+    if (f>=fPotS and MMAX==0) break;
+    if (poff[f]<0) continue;
+    std::cout << (f ? ", " : " ") << labs[f] << "="
+	      << (maxv[f]>0.0 ? maxe[f]/maxv[f] : 0.0);
+  }
+  std::cout << std::endl;
+}
+
+void EmpCylSL::setup_eof()
+{
+  // Computing the basis needs all of the tables
+  //
+  if (loaded != Tables::all) {
+    loaded = Tables::all;
+    allocate_grids();
+  }
+
+  if (SC.size()==0 and SCe.size()==0) {
+
+    setup_table();
+
+    tpot   .resize(NORDER);
+    trforce.resize(NORDER);
+    tzforce.resize(NORDER);
+    tdens  .resize(NORDER);
+
+    for (int n=0; n<NORDER; n++) {
+      tpot[n].resize(NUMX+1, NUMY+1);
+      trforce[n].resize(NUMX+1, NUMY+1);
+      tzforce[n].resize(NUMX+1, NUMY+1);
+      tdens[n].resize(NUMX+1, NUMY+1);
+    }
+
+    if (EvenOdd) {
+      SCe.resize(nthrds);
+      SSe.resize(nthrds);
+
+      SCo.resize(nthrds);
+      SSo.resize(nthrds);
+
+      for (int nth=0; nth<nthrds; nth++) {
+	SCe[nth].resize(MMAX+1);
+	SSe[nth].resize(MMAX+1);
+
+	SCo[nth].resize(MMAX+1);
+	SSo[nth].resize(MMAX+1);
+      }
+
+      lE.resize(MMAX+1);
+      lO.resize(MMAX+1);
+
+    } else {
+      SC.resize(nthrds);
+      SS.resize(nthrds);
+
+      for (int nth=0; nth<nthrds; nth++) {
+	SC[nth].resize(MMAX+1);
+	SS[nth].resize(MMAX+1);
+      }
+    }
+
+    potd.resize(LMAX+1, NMAX);
+    dpot.resize(LMAX+1, NMAX);
+    dend.resize(LMAX+1, NMAX);
+
+    cosm .resize(nthrds);
+    sinm .resize(nthrds);
+    legs .resize(nthrds);
+    dlegs.resize(nthrds);
+    for (int i=0; i<nthrds; i++) {
+      cosm[i].resize(LMAX+1);
+      sinm[i].resize(LMAX+1);
+      legs[i].resize(LMAX+1, LMAX+1);
+      dlegs[i].resize(LMAX+1, LMAX+1);
+    }
+
+    if (EvenOdd) {
+      varE.resize(MMAX+1);
+      varO.resize(MMAX+1);
+
+      for (int m=0; m<=MMAX; m++) {
+
+	lE[m].clear();	// Store even l values
+	lO[m].clear();	// Store odd  l values
+
+	for (int l=m; l<=LMAX; l++) {
+	  // Symmetry for the associated Legendre polynomials
+	  //   |   depends on whether l+m is even or odd
+	  //   v        
+	  if ((l+m) % 2==0) lE[m].push_back(l);
+	  else              lO[m].push_back(l);
+	}
+	
+	int Esiz = lE[m].size();
+	int Osiz = lO[m].size();
+
+	varE[m].resize(NMAX*Esiz, NMAX*Esiz);
+	varO[m].resize(NMAX*Osiz, NMAX*Osiz);
+      }
+
+    } else {
+      var.resize(MMAX+1);
+      for (int m=0; m<=MMAX; m++)
+	var[m].resize(NMAX*(LMAX-m+1), NMAX*(LMAX-m+1));
+    }
+
+    for (int nth=0; nth<nthrds; nth++) {
+
+      for (int m=0; m<=MMAX; m++) {
+
+	if (EvenOdd) {
+	  int Esiz = lE[m].size();
+	  int Osiz = lO[m].size();
+
+	  SCe[nth][m].resize(NMAX*Esiz);
+	  SCo[nth][m].resize(NMAX*Osiz);
 
 	  if (m) {
 	    SSe[nth][m].resize(NMAX*Esiz);
@@ -2258,6 +2771,41 @@ void EmpCylSL::setup_eof()
     mpi_double_buf3.resize(rank3);
   }
 
+  // Blocked covariance updates, see accumulate_eof()
+  //
+  if (eofbuf.size()==0) {
+    lA.resize(MMAX+1);
+    for (int m=0; m<=MMAX; m++) {
+      lA[m].clear();
+      for (int l=m; l<=LMAX; l++) lA[m].push_back(l);
+    }
+
+    eofvec.resize(nthrds);
+    for (auto & v : eofvec) v.resize(NMAX*(LMAX+1));
+
+    eofbuf.resize(nthrds);
+    for (auto & t : eofbuf) {
+      t.resize(MMAX+1);
+      for (int m=0; m<=MMAX; m++) {
+	if (EvenOdd) {
+	  t[m][0].resize(NMAX*lE[m].size());
+	  t[m][1].resize(NMAX*lO[m].size());
+	  if (m>0) {
+	    t[m][2].resize(NMAX*lE[m].size());
+	    t[m][3].resize(NMAX*lO[m].size());
+	  }
+	} else {
+	  t[m][0].resize(NMAX*lA[m].size());
+	  if (m>0) t[m][2].resize(NMAX*lA[m].size());
+	}
+      }
+    }
+  } else {
+    for (auto & t : eofbuf)
+      for (auto & b : t)
+	for (auto & v : b) v.resize(v.rank());
+  }
+
   for (int nth=0; nth<nthrds; nth++) {
     for (int m=0; m<=MMAX; m++)  {
       
@@ -2624,8 +3172,6 @@ void EmpCylSL::accumulate_eof(double r, double z, double phi, double mass,
   legendre_R(LMAX, costh, legs[id]);
   sinecosine_R(LMAX, phi, cosm[id], sinm[id]);
 
-  int nn1, nn2;
-
   // *** m loop
   for (int m=0; m<=MMAX; m++) {
 
@@ -2653,136 +3199,71 @@ void EmpCylSL::accumulate_eof(double r, double z, double phi, double mass,
 
     } // *** ir loop
 
-    for (int ir1=0; ir1<NMAX; ir1++) {
-
-      if (EvenOdd) {
-	int Esiz = lE[m].size();
-	int Osiz = lO[m].size();
-
-	for (int il1=0; il1<Esiz; il1++) {
-
-	  int l1 = lE[m][il1];
-	  nn1 = ir1 + NMAX*il1;
-
-	  if (m==0) {
-	  
-	    for (int ir2=0; ir2<NMAX; ir2++) {
-
-	      for (int il2=0; il2<Esiz; il2++) {
-
-		int l2 = lE[m][il2];
-		nn2 = ir2 + NMAX*il2;
-
-		SCe[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-	      }
-	    }
-
-	  } else {
-
-	    for (int ir2=0; ir2<NMAX; ir2++) {
-
-	      for (int il2=0; il2<Esiz; il2++) {
-
-		int l2 = lE[m][il2];
-		nn2 = ir2 + NMAX*il2;
-		
-		SCe[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-		
-		SSe[id][m][nn1][nn2] += 
-		  facS[id](ir1, l1-m)*facS[id](ir2, l2-m) * mass;
-	      }
-	    }
-	  }
-
-	} // *** Even l loop
-
-	for (int il1=0; il1<Osiz; il1++) {
-
-	  int l1 = lO[m][il1];
-	  nn1 = ir1 + NMAX*il1;
-
-	  if (m==0) {
-	  
-	    for (int ir2=0; ir2<NMAX; ir2++) {
-
-	      for (int il2=0; il2<Osiz; il2++) {
-
-		int l2 = lO[m][il2];
-		nn2 = ir2 + NMAX*il2;
-
-		SCo[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-	      }
-	    }
+    // The covariance takes the vector of facC (facS) values with
+    // index ir + NMAX*il over the l values of each block
+    //
+    Eigen::VectorXd& v = eofvec[id];
 
-	  } else {
+    auto add = [&](const Eigen::MatrixXd& fac, const std::vector<int>& L,
+		   SyrkBuffer& buf, std::vector<std::vector<double>>& S)
+    {
+      int n = 0;
+      for (int il=0; il<L.size(); il++)
+	for (int ir=0; ir<NMAX; ir++) v[n++] = fac(ir, L[il]-m);
+      buf.add(v.head(n), mass, [&S](int i) { return S[i].data(); });
+    };
 
-	    for (int ir2=0; ir2<NMAX; ir2++) {
+    auto & buf = eofbuf[id][m];
 
-	      for (int il2=0; il2<Osiz; il2++) {
+    if (EvenOdd) {
+      add(facC[id], lE[m], buf[0], SCe[id][m]);
+      add(facC[id], lO[m], buf[1], SCo[id][m]);
+      if (m>0) {
+	add(facS[id], lE[m], buf[2], SSe[id][m]);
+	add(facS[id], lO[m], buf[3], SSo[id][m]);
+      }
+    } else {
+      add(facC[id], lA[m], buf[0], SC[id][m]);
+      if (m>0)
+	add(facS[id], lA[m], buf[2], SS[id][m]);
+    }
 
-		int l2 = lO[m][il2];
-		nn2 = ir2 + NMAX*il2;
+  } // *** m loop
+  
+}
 
-		SCo[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-		
-		SSo[id][m][nn1][nn2] += 
-		  facS[id](ir1, l1-m)*facS[id](ir2, l2-m) * mass;
-	      }
-	    }
-	  }
+void EmpCylSL::flush_eof()
+{
+  for (int nth=0; nth<eofbuf.size(); nth++) {
+    for (int m=0; m<=MMAX; m++) {
+      auto & buf = eofbuf[nth][m];
 
-	} // *** Odd l loop
+      auto flush = [](SyrkBuffer& b, std::vector<std::vector<double>>& S)
+      {
+	b.flush([&S](int i) { return S[i].data(); });
+      };
 
+      if (EvenOdd) {
+	flush(buf[0], SCe[nth][m]);
+	flush(buf[1], SCo[nth][m]);
+	if (m>0) {
+	  flush(buf[2], SSe[nth][m]);
+	  flush(buf[3], SSo[nth][m]);
+	}
       } else {
-      
-	for (int l1=m; l1<=LMAX; l1++) {
-	  nn1 = ir1 + NMAX*(l1-m);
-
-	  if (m==0) {
-	  
-	    for (int ir2=0; ir2<NMAX; ir2++) {
-	      for (int l2=m; l2<=LMAX; l2++) {
-		nn2 = ir2 + NMAX*(l2-m);
-		
-		SC[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-	      }
-	    }
-	    
-	  } else {
-
-	    for (int ir2=0; ir2<NMAX; ir2++) {
-	      for (int l2=m; l2<=LMAX; l2++) {
-		nn2 = ir2 + NMAX*(l2-m);
-		
-		SC[id][m][nn1][nn2] += 
-		  facC[id](ir1, l1-m)*facC[id](ir2, l2-m) * mass;
-
-		SS[id][m][nn1][nn2] += 
-		  facS[id](ir1, l1-m)*facS[id](ir2, l2-m) * mass;
-	      }
-	    }
-	  }
-	  
-	} // *** l loop
-	
-      } // *** EvenOdd loop
-
-    } // *** ir loop
-
-  } // *** m loop
-  
+	flush(buf[0], SC[nth][m]);
+	if (m>0) flush(buf[2], SS[nth][m]);
+      }
+    }
+  }
 }
 
-void EmpCylSL::make_eof(void)
+void EmpCylSL::reduce_eof(void)
 {
-  Timer timer;
   int icnt;
 
+  flush_eof();
+
   if (use_mpi and MPIin_eof.size()==0) {
     MPIin_eof .resize(rank2*(rank2+1)/2);
     MPIout_eof.resize(rank2*(rank2+1)/2);
@@ -3071,7 +3552,14 @@ void EmpCylSL::make_eof(void)
     // END: MPI process loop (okay for a single process)
   }
   // END: DEBUG
+}
+
+
+void EmpCylSL::make_eof(void)
+{
+  Timer timer;
 
+  reduce_eof();
 
   // Enter this loop for each MPI process
   //
@@ -3205,35 +3693,73 @@ void EmpCylSL::make_eof(void)
   //
   // Do the following loop for a single process
   else {
+    solve_eof_local();
+  }
+
+  finish_eof();
+}
+
+
+void EmpCylSL::solve_eof_local(void)
+{
+  Timer timer;
+
+  // The grids are computed in place without MPI traffic so that
+  // this may be called from a helper thread
+  //
+  bool save_mpi = use_mpi;
+  use_mpi = false;
+
+  // Solve the eigenproblems concurrently first; eigen_problem then
+  // computes the grids from the stored solutions
+  //
+  if (EIGTHREAD) presolve_eof();
 
-    // Non-MPI loop
-    //
-    for (int M=0; M<=MMAX; M++) {
-      if (VFLAG & 16) {
-	std::cout << "Process " << std::setw(4) << myid
-		  << ": Begin computing M=" << M << std::endl;
-	timer.reset();
-	timer.start();
-      }
+  for (int M=0; M<=MMAX; M++) {
+    if (VFLAG & 16) {
+      std::cout << "Process " << std::setw(4) << myid
+		<< ": Begin computing M=" << M << std::endl;
+      timer.reset();
+      timer.start();
+    }
 
-      if (M==0) {
-	eigen_problem(1, M, timer); // Cosine
-      } else {
-	eigen_problem(0, M, timer); // Sine
-	eigen_problem(1, M, timer); // Cosine
-      }
+    if (M==0) {
+      eigen_problem(1, M, timer); // Cosine
+    } else {
+      eigen_problem(0, M, timer); // Sine
+      eigen_problem(1, M, timer); // Cosine
+    }
 
-      if (VFLAG & 16) {
-	std::cout << "Process " << std::setw(4) << myid
-		  << ": Computed M=" << M << " in "
-		  << timer.stop()  << " seconds" << std::endl;
-      }
+    if (VFLAG & 16) {
+      std::cout << "Process " << std::setw(4) << myid
+		<< ": Computed M=" << M << " in "
+		<< timer.stop()  << " seconds" << std::endl;
     }
   }
 
+  presolve.clear();
+  use_mpi = save_mpi;
+}
+
+
+void EmpCylSL::share_eof(void)
+{
+  if (use_mpi) send_eof_grid();
+  finish_eof();
+}
+
+
+void EmpCylSL::finish_eof(void)
+{
+  // Smallest tables that meet the interpolation target
+  //
+  if (TABTOL>0.0) choose_resolution();
+
   // Cache table for restarts
   //
   if (myid==0) cache_grid(1, cachefile);
+
+  pack_tables();
   
   // Basis complete but still need to compute coefficients
   //
@@ -3248,6 +3774,91 @@ void EmpCylSL::make_eof(void)
 }
 
 
+Eigen::MatrixXd EmpCylSL::covariance(int request_id, int M, int part)
+{
+  // Select the accumulated upper triangle
+  //
+  std::vector<std::vector<double>> *cov;
+  int siz;
+
+  if (part==1) {
+    cov = request_id ? &SCe[0][M] : &SSe[0][M];
+    siz = NMAX*lE[M].size();
+  } else if (part==2) {
+    cov = request_id ? &SCo[0][M] : &SSo[0][M];
+    siz = NMAX*lO[M].size();
+  } else {
+    cov = request_id ? &SC[0][M] : &SS[0][M];
+    siz = NMAX*(LMAX-M+1);
+  }
+
+  Eigen::MatrixXd var(siz, siz);
+
+  double maxV = 0.0;
+  for (int i=0; i<siz; i++) {
+    for (int j=i; j<siz; j++) {
+      var(i, j) = var(j, i) = (*cov)[i][j];
+      maxV = std::max<double>(maxV, fabs(var(i, j)));
+    }
+  }
+
+  // The sine covariance may vanish for an axisymmetric distribution
+  //
+  if (request_id or maxV>1.0e-5) var /= maxV;
+
+  return var;
+}
+
+
+void EmpCylSL::eigen_solve(int request_id, int M, int part,
+			   const Eigen::MatrixXd& var,
+			   Eigen::VectorXd& ev, Eigen::MatrixXd& ef)
+{
+  unsigned k = (M*2 + request_id)*3 + part;
+
+  if (k < presolve.size() and presolve[k].ok) {
+    ev = std::move(presolve[k].ev);
+    ef = std::move(presolve[k].ef);
+    presolve[k].ok = false;
+  } else {
+    TopEigen(var, NORDER, ev, ef);
+  }
+}
+
+
+void EmpCylSL::presolve_eof()
+{
+  // List the eigenproblems: sine (0) and cosine (1) for each M, and
+  // even and odd parts for EvenOdd
+  //
+  std::vector<std::array<int, 3>> todo;
+
+  for (int M=0; M<=MMAX; M++) {
+    for (int request_id=(M==0 ? 1 : 0); request_id<2; request_id++) {
+      if (EvenOdd) {
+	todo.push_back({request_id, M, 1});
+	todo.push_back({request_id, M, 2});
+      } else {
+	todo.push_back({request_id, M, 0});
+      }
+    }
+  }
+
+  presolve.resize((MMAX+1)*6);
+  for (auto & v : presolve) v.ok = false;
+
+  // The problems are independent and solved concurrently
+  //
+#pragma omp parallel for schedule(dynamic)
+  for (size_t t=0; t<todo.size(); t++) {
+    int request_id = todo[t][0], M = todo[t][1], part = todo[t][2];
+    auto & sol = presolve[(M*2 + request_id)*3 + part];
+    TopEigen(covariance(request_id, M, part), NORDER, sol.ev, sol.ef);
+    sol.ok = true;
+  }
+}
+
+
 void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
 {
 
@@ -3256,76 +3867,12 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
     // Cosine components
     //
     if (EvenOdd) {
-      int Esiz = lE[M].size();
-      int Osiz = lO[M].size();
-	    
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=i; j<NMAX*Esiz; j++)
-	  varE[M](i, j) = SCe[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=i; j<NMAX*Esiz; j++) {
-	  varE[M](j, i) = SCe[0][M][i][j];
-	}
-      }
-      
-      double maxV = 0.0;
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=0; j<NMAX*Esiz; j++) {
-	  double tmp = fabs(varE[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      varE[M] /= maxV;
-      
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++)
-	  varO[M](i, j) = SCo[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++) {
-	  varO[M](j, i) = SCo[0][M][i][j];
-	}
-      }
-      
-      maxV = 0.0;
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++) {
-	  double tmp = fabs(varO[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      varO[M] /= maxV;
-      
+      varE[M] = covariance(request_id, M, 1);
+      varO[M] = covariance(request_id, M, 2);
     } else {
-      
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++)
-	  var[M](i, j) = SC[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++) {
-	  var[M](j, i) = SC[0][M][i][j];
-	}
-      }
-      
-      double maxV = 0.0;
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++) {
-	  double tmp = fabs(var[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      var[M] /= maxV;
+      var[M]  = covariance(request_id, M, 0);
     }
     
-    
     //==========================
     // Solve eigenvalue problem 
     //==========================
@@ -3426,14 +3973,8 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
     
     if (EvenOdd) {
       
-      Eigen::EigenSolver<Eigen::MatrixXd> esE(varE[M]);
-      Eigen::EigenSolver<Eigen::MatrixXd> esO(varO[M]);
-      
-      evE = esE.eigenvalues().real();
-      evO = esO.eigenvalues().real();
-      
-      efE = esE.eigenvectors().real();
-      efO = esO.eigenvectors().real();
+      eigen_solve(request_id, M, 1, varE[M], evE, efE);
+      eigen_solve(request_id, M, 2, varO[M], evO, efO);
       
       // Choose sign conventions for the ef table
       //
@@ -3489,14 +4030,11 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
       
     } else {
       
-      Eigen::EigenSolver<Eigen::MatrixXd> es(var[M]);
-      
-      ev = es.eigenvalues().real();
-      ef = es.eigenvectors().real();
+      eigen_solve(request_id, M, 0, var[M], ev, ef);
       
       // Sign convention
       //
-      int nfid = std::min<int>(4, efE.rows()) - 1;
+      int nfid = std::min<int>(4, ef.rows()) - 1;
       for (int j=0; j<ef.cols(); j++) {
 	if (ef(nfid, j) < 0.0) ef.col(j) *= -1;
       }
@@ -3537,76 +4075,10 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
     // Sine components
     //
     if (EvenOdd) {
-      int Esiz = lE[M].size();
-      int Osiz = lO[M].size();
-      
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=i; j<NMAX*Esiz; j++)
-	  varE[M](i, j) = SSe[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=i; j<NMAX*Esiz; j++) {
-	  varE[M](j, i) = SSe[0][M][i][j];
-	}
-      }
-      
-      double maxV = 0.0;
-      for (int i=0; i<NMAX*Esiz; i++) {
-	for (int j=i; j<NMAX*Esiz; j++) {
-	  double tmp = fabs(varE[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      if (maxV>1.0e-5)
-	varE[M] /= maxV;
-      
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++)
-	  varO[M](i, j) = SSo[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++) {
-	  varO[M](j, i) = SSo[0][M][i][j];
-	}
-      }
-      
-      maxV = 0.0;
-      for (int i=0; i<NMAX*Osiz; i++) {
-	for (int j=i; j<NMAX*Osiz; j++) {
-	  double tmp = fabs(varO[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      if (maxV>1.0e-5)
-	varO[M] /= maxV;
-      
+      varE[M] = covariance(request_id, M, 1);
+      varO[M] = covariance(request_id, M, 2);
     } else {
-      
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++)
-	  var[M](i, j) = SS[0][M][i][j];
-      }
-      
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++) {
-	  var[M](j, i) = SS[0][M][i][j];
-	}
-      }
-      
-      double maxV = 0.0;
-      for (int i=0; i<NMAX*(LMAX-M+1); i++) {
-	for (int j=i; j<NMAX*(LMAX-M+1); j++) {
-	  double tmp = fabs(var[M](i, j));
-	  if (tmp > maxV) maxV = tmp;
-	}
-      }
-      
-      if (maxV>1.0e-5)
-	var[M] /= maxV;
+      var[M]  = covariance(request_id, M, 0);
     }
     
     //==========================
@@ -3665,14 +4137,8 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
     
     if (EvenOdd) {
       
-      Eigen::EigenSolver<Eigen::MatrixXd> esE(varE[M]);
-      Eigen::EigenSolver<Eigen::MatrixXd> esO(varO[M]);
-      
-      evE = esE.eigenvalues().real();
-      evO = esO.eigenvalues().real();
-      
-      efE = esE.eigenvectors().real();
-      efO = esO.eigenvectors().real();
+      eigen_solve(request_id, M, 1, varE[M], evE, efE);
+      eigen_solve(request_id, M, 2, varO[M], evO, efO);
       
 
       // Sign convention
@@ -3718,14 +4184,11 @@ void EmpCylSL::eigen_problem(int request_id, int M, Timer& timer)
       
     } else {
       
-      Eigen::EigenSolver<Eigen::MatrixXd> es(var[M]);
-      
-      ev = es.eigenvalues().real();
-      ef = es.eigenvectors().real();
+      eigen_solve(request_id, M, 0, var[M], ev, ef);
       
       // Sign convention
       //
-      int nfid = std::min<int>(4, efE.rows()) - 1;
+      int nfid = std::min<int>(4, ef.rows()) - 1;
       for (int j=0; j<ef.cols(); j++) {
 	if (ef(nfid, j) < 0.0) ef.col(j) *= -1;
       }
@@ -3951,11 +4414,14 @@ void EmpCylSL::getPotParticle(double x, double y, double z,
   double R = sqrt(x*x + y*y);
   double phi = atan2(y, x);
   
+  const double *cosm1, *sinm1;
+  sinecosine_M(phi, cosm1, sinm1);
+
   get_pot(vc[0], vs[0], R, z);
   for (int mm=0; mm<=MMAX; mm++) {
     for (int nn=0; nn<rank3; nn++) {
-      retC[mm][nn] = vc[0](mm, nn)*cos(phi*mm);
-      if (mm>0) retS[mm][nn] = vs[0](mm, nn)*sin(phi*mm);
+      retC[mm][nn] = vc[0](mm, nn)*cosm1[mm];
+      if (mm>0) retS[mm][nn] = vs[0](mm, nn)*sinm1[mm];
     }
   }
 }
@@ -3978,6 +4444,79 @@ void EmpCylSL::accumulate(double r, double z, double phi, double mass,
 
   howmany1[mlevel][id]++;
 
+  // Deposit onto the table nodes; the basis is applied in
+  // bin_project()
+  //
+  if (binned and mlevel==binLevel and bingrid.size() and
+      not (compute and (PCAVAR or PCAEOF))) {
+
+    if (z/ASCALE > Rtable) z =  Rtable*ASCALE;
+    if (z/ASCALE <-Rtable) z = -Rtable*ASCALE;
+
+    // Same node and weights as get_pot()
+    //
+    double X = (r_to_xi(r) - XMIN)/dX;
+    double Y = (z_to_y(z)  - YMIN)/dY;
+
+    int ix = (int)X;
+    int iy = (int)Y;
+
+    if (ix < 0) {
+      ix = 0;
+      if (enforce_limits) X = 0.0;
+    }
+    if (iy < 0) {
+      iy = 0;
+      if (enforce_limits) Y = 0.0;
+    }
+    if (ix >= NUMX) {
+      ix = NUMX-1;
+      if (enforce_limits) X = NUMX;
+    }
+    if (iy >= NUMY) {
+      iy = NUMY-1;
+      if (enforce_limits) Y = NUMY;
+    }
+
+    double delx0 = (double)ix + 1.0 - X;
+    double dely0 = (double)iy + 1.0 - Y;
+    double delx1 = X - (double)ix;
+    double dely1 = Y - (double)iy;
+
+    const int nm = 2*MMAX + 1;
+    double *g00 = &bingrid[id][(ix*(NUMY+1) + iy)*nm];
+    double *g01 = g00 + nm;
+    double *g10 = g00 + (NUMY+1)*nm;
+    double *g11 = g10 + nm;
+
+    double c00 = mass*delx0*dely0;
+    double c10 = mass*delx1*dely0;
+    double c01 = mass*delx0*dely1;
+    double c11 = mass*delx1*dely1;
+
+    const double *cosm1, *sinm1;
+    sinecosine_M(phi, cosm1, sinm1);
+
+    for (int mm=0; mm<=MMAX; mm++) {
+      g00[mm] += c00*cosm1[mm];
+      g10[mm] += c10*cosm1[mm];
+      g01[mm] += c01*cosm1[mm];
+      g11[mm] += c11*cosm1[mm];
+    }
+
+    for (int mm=1; mm<=MMAX; mm++) {
+      g00[MMAX+mm] += c00*sinm1[mm];
+      g10[MMAX+mm] += c10*sinm1[mm];
+      g01[MMAX+mm] += c01*sinm1[mm];
+      g11[MMAX+mm] += c11*sinm1[mm];
+    }
+
+    cylmass1[id] += mass;
+    binPending = true;
+
+    return;
+  }
+
   double msin, mcos;
   int mm;
   
@@ -3994,10 +4533,13 @@ void EmpCylSL::accumulate(double r, double z, double phi, double mass,
 
   get_pot(vc[id], vs[id], r, z);
 
+  const double *cosm1, *sinm1;
+  sinecosine_M(phi, cosm1, sinm1);
+
   for (mm=0; mm<=MMAX; mm++) {
 
-    mcos = cos(phi*mm);
-    msin = sin(phi*mm);
+    mcos = cosm1[mm];
+    msin = sinm1[mm];
 
     for (int nn=0; nn<rank3; nn++) {
       double hold = norm * mass * mcos * vc[id](mm, nn);
@@ -4028,28 +4570,92 @@ void EmpCylSL::accumulate(double r, double z, double phi, double mass,
       if (compute and PCAEOF) {
 	double hold1 = vc[id](mm, nn), hold2 = 0.0;
 	if (mm>0) hold2 = vs[id](mm, nn);
-	double modu1 = sqrt(hold1*hold1 + hold2*hold2)*norm;
-	for (int oo=0; oo<rank3; oo++) {
-	  hold1 = vc[id](mm, oo), hold2 = 0.0;
-	  if (mm>0) hold2 = vs[id](mm, oo);
-	  double modu2 = sqrt(hold1*hold1 + hold2*hold2)*norm;
-	  tvar[id][mm](nn, oo) += modu1 * modu2 * mass;
-	}
+	pcavec[id][nn] = sqrt(hold1*hold1 + hold2*hold2)*norm;
       }
     }
 
-    cylmass1[id] += mass;
+    if (compute and PCAEOF) pcabuf[id][mm].add(pcavec[id], mass, tvar[id][mm]);
+  }
+
+  cylmass1[id] += mass;
+}
+
+
+void EmpCylSL::flush_pca()
+{
+  for (int nth=0; nth<pcabuf.size(); nth++) {
+    for (int mm=0; mm<=MMAX; mm++) {
+      pcabuf[nth][mm].flush(tvar[nth][mm]);
+      SyrkBuffer::symmetrize(tvar[nth][mm]);
+    }
+  }
+}
+
+void EmpCylSL::bin_project()
+{
+  if (not binPending) return;
+  binPending = false;
+
+  const int nm = 2*MMAX + 1;
+  const int ng = (NUMX+1)*(NUMY+1);
+  const double norm = -4.0*M_PI;
+
+  // Sum the thread grids
+  //
+  std::vector<double>& g = bingrid[0];
+  for (int nth=1; nth<nthrds; nth++) {
+#pragma omp parallel for
+    for (size_t k=0; k<g.size(); k++) {
+      g[k] += bingrid[nth][k];
+      bingrid[nth][k] = 0.0;
+    }
+  }
+
+  // Same harmonic selection as get_pot()
+  //
+  int mlim = std::min<int>(MLIM, MMAX);
+
+#pragma omp parallel for
+  for (int mm=0; mm<=mlim; mm++) {
+
+    if (EVEN_M && (mm/2)*2 != mm) continue;
+
+    for (int nn=0; nn<rank3; nn++) {
+      const double *pc = potC[mm][nn].data();
+      const double *ps = mm ? potS[mm][nn].data() : 0;
+      double sc = 0.0, ss = 0.0;
+
+      // The grids are column major in (ix, iy)
+      //
+      for (int ix=0; ix<=NUMX; ix++) {
+	for (int iy=0; iy<=NUMY; iy++) {
+	  const double *v = &g[(ix*(NUMY+1) + iy)*nm];
+	  int k = ix + (NUMX+1)*iy;
+	  sc += pc[k]*v[mm];
+	  if (mm) ss += ps[k]*v[MMAX+mm];
+	}
+      }
+
+      cosN(binLevel)[0][mm][nn] += norm*sc;
+      if (mm) sinN(binLevel)[0][mm][nn] += norm*ss;
+    }
   }
 
+  std::fill(g.begin(), g.end(), 0.0);
 }
 
 
 void EmpCylSL::make_coefficients(unsigned M0, bool compute)
 {
+  if (binned) bin_project();
+
+  if (compute and PCAEOF) flush_pca();
+
   if (MPIin.size()==0) {
-				// Vector reduction
-    MPIin  .resize(rank3*(MMAX+1));
-    MPIout .resize(rank3*(MMAX+1));
+				// Vector reduction (packed cosine and
+				// sine coefficients)
+    MPIin  .resize(2*rank3*(MMAX+1));
+    MPIout .resize(2*rank3*(MMAX+1));
 				// Matrix reduction
     MPIin2 .resize(rank3*rank3*(MMAX+1));
     MPIout2.resize(rank3*rank3*(MMAX+1));
@@ -4078,41 +4684,7 @@ void EmpCylSL::make_coefficients(unsigned M0, bool compute)
     }
 				// Begin distribution loop
 				//
-    for (int mm=0; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	MPIin[mm*rank3 + nn] = cosN(M)[0][mm][nn];
-    
-    if (use_mpi)
-      MPI_Allreduce ( MPIin.data(), MPIout.data(), rank3*(MMAX+1),
-		      MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    else
-      MPIout = MPIin;
-
-    for (int mm=0; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	if (multistep)
-	  cosN(M)[0][mm][nn] = MPIout[mm*rank3 + nn];
-	else
-	  accum_cos[mm][nn] = MPIout[mm*rank3 + nn];
-    
-
-    for (int mm=1; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	MPIin[mm*rank3 + nn] = sinN(M)[0][mm][nn];
-    
-    if (use_mpi)
-      MPI_Allreduce ( MPIin.data(), MPIout.data(), rank3*(MMAX+1),
-		      MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    else
-      MPIout = MPIin;
-  
-  
-  for (int mm=1; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	if (multistep)
-	  sinN(M)[0][mm][nn] = MPIout[mm*rank3 + nn];
-	else
-	  accum_sin[mm][nn] = MPIout[mm*rank3 + nn];
+    reduce_coefs(M);
     
     coefs_made[M] = true;
   }
@@ -4153,9 +4725,9 @@ void EmpCylSL::make_coefficients(unsigned M0, bool compute)
     if (PCAVAR) {
       if (use_mpi) {
 	MPI_Allreduce ( &numbT1[0][0], &numbT[0], sampT,
-			MPI_UNSIGNED, MPI_SUM, MPI_COMM_WORLD);
+			MPI_UNSIGNED, MPI_SUM, comm);
 	MPI_Allreduce ( &massT1[0][0], &massT[0], sampT,
-			MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+			MPI_DOUBLE, MPI_SUM, comm);
       } else {
 	numbT = numbT1[0];
 	massT = massT1[0];
@@ -4176,7 +4748,7 @@ void EmpCylSL::make_coefficients(unsigned M0, bool compute)
   
       if (use_mpi)
 	MPI_Allreduce ( MPIinT.data(), MPIotT.data(), rank3*rank3*(MMAX+1),
-			MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+			MPI_DOUBLE, MPI_SUM, comm);
       else
 	MPIotT = MPIinT;
       
@@ -4201,10 +4773,10 @@ void EmpCylSL::make_coefficients(unsigned M0, bool compute)
 
       if (use_mpi) {
 	MPI_Allreduce ( MPIin.data(), MPIout.data(), rank3*(MMAX+1),
-			MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+			MPI_DOUBLE, MPI_SUM, comm);
 
 	MPI_Allreduce ( MPIin2.data(), MPIout2.data(), rank3*rank3*(MMAX+1),
-			MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+			MPI_DOUBLE, MPI_SUM, comm);
       } else {
 	MPIout  = MPIin;
 	MPIout2 = MPIin2;
@@ -4223,6 +4795,45 @@ void EmpCylSL::make_coefficients(unsigned M0, bool compute)
   }
 }
 
+void EmpCylSL::reduce_coefs(unsigned M)
+{
+  // Cosine terms in the first half of the buffer and sine terms in
+  // the second half, so that a level takes one reduction
+  //
+  int off = rank3*(MMAX+1);
+
+  for (int mm=0; mm<=MMAX; mm++)
+    for (int nn=0; nn<rank3; nn++) {
+      MPIin[mm*rank3 + nn] = cosN(M)[0][mm][nn];
+      MPIin[off + mm*rank3 + nn] = mm ? sinN(M)[0][mm][nn] : 0.0;
+    }
+
+  if (use_mpi and coefs_reduced.erase(M)==0) {
+    if (FLOATREDUCE) {
+      freduce.pack(M, MPIin.data(), 2*off);
+      freduce.reduce(comm);
+      freduce.unpack(MPIout.data());
+    } else
+      NodeSharedComm::allreduce ( MPIin.data(), MPIout.data(), 2*off,
+				  MPI_DOUBLE, MPI_SUM, comm);
+  } else
+    MPIout = MPIin;
+
+  for (int mm=0; mm<=MMAX; mm++)
+    for (int nn=0; nn<rank3; nn++)
+      if (multistep)
+	cosN(M)[0][mm][nn] = MPIout[mm*rank3 + nn];
+      else
+	accum_cos[mm][nn] = MPIout[mm*rank3 + nn];
+
+  for (int mm=1; mm<=MMAX; mm++)
+    for (int nn=0; nn<rank3; nn++)
+      if (multistep)
+	sinN(M)[0][mm][nn] = MPIout[off + mm*rank3 + nn];
+      else
+	accum_sin[mm][nn] = MPIout[off + mm*rank3 + nn];
+}
+
 void EmpCylSL::reset_mass(void)
 { 
   cylmass=0.0; 
@@ -4232,11 +4843,15 @@ void EmpCylSL::reset_mass(void)
 
 void EmpCylSL::make_coefficients(bool compute)
 {
+  if (binned) bin_project();
+
+  if (compute and PCAEOF) flush_pca();
+
   if (!cylmass_made) {
 
     if (use_mpi)
       MPI_Allreduce(&cylmass1[0], &cylmass, 1, MPI_DOUBLE, MPI_SUM, 
-		    MPI_COMM_WORLD);
+		    comm);
     else
       cylmass = cylmass1[0];
     
@@ -4245,9 +4860,10 @@ void EmpCylSL::make_coefficients(bool compute)
   
   if (coefs_made_all()) return;
 
-  if (MPIin.size()==0) {	// Vector reduction
-    MPIin  .resize(rank3*(MMAX+1));
-    MPIout .resize(rank3*(MMAX+1));
+  if (MPIin.size()==0) {	// Vector reduction (packed cosine
+				// and sine coefficients)
+    MPIin  .resize(2*rank3*(MMAX+1));
+    MPIout .resize(2*rank3*(MMAX+1));
 				// Matrix reduction
     MPIin2 .resize(rank3*rank3*(MMAX+1));
     MPIout2.resize(rank3*rank3*(MMAX+1));
@@ -4312,22 +4928,7 @@ void EmpCylSL::make_coefficients(bool compute)
     else
       howmany[M] = howmany1[M][0];
 
-    for (int mm=0; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	MPIin[mm*rank3 + nn] = cosN(M)[0][mm][nn];
-  
-    if (use_mpi)
-      MPI_Allreduce ( MPIin.data(), MPIout.data(), rank3*(MMAX+1),
-		      MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    else
-      MPIout = MPIin;
-
-    for (int mm=0; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	if (multistep)
-	  cosN(M)[0][mm][nn] = MPIout[mm*rank3 + nn];
-	else
-	  accum_cos[mm][nn] = MPIout[mm*rank3 + nn];
+    reduce_coefs(M);
   }
   
 
@@ -4368,28 +4969,6 @@ void EmpCylSL::make_coefficients(bool compute)
   } // SELECT
 
 
-  for (unsigned M=0; M<=multistep; M++) {
-    
-    if (coefs_made[M]) continue;
-
-    for (int mm=1; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	MPIin[mm*rank3 + nn] = sinN(M)[0][mm][nn];
-  
-    if (use_mpi)
-      MPI_Allreduce ( MPIin.data(), MPIout.data(), rank3*(MMAX+1),
-		      MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    else
-      MPIout = MPIin;
-
-    for (int mm=1; mm<=MMAX; mm++)
-      for (int nn=0; nn<rank3; nn++)
-	if (multistep)
-	  sinN(M)[0][mm][nn] = MPIout[mm*rank3 + nn];
-	else
-	  accum_sin[mm][nn] = MPIout[mm*rank3 + nn];
-  }
-  
   if (compute and PCAVAR) {
 				// Mass used to compute variance in
 				// each partition
@@ -4514,6 +5093,11 @@ void EmpCylSL::pca_hall(bool compute, bool subsamp)
 
     if (PCAEOF) eofvec.resize(rank3);
 
+    if (hallEvec.size() != MMAX+1) {
+      hallEvec.resize(MMAX+1);
+      hallCovr.resize(MMAX+1);
+    }
+
     // Loop through each harmonic subspace [EVEN cosines]
     //
     for (int mm=0; mm<=MMAX; mm++) {
@@ -4564,18 +5148,42 @@ void EmpCylSL::pca_hall(bool compute, bool subsamp)
 	  }
 	}
 	
-	Eigen::EigenSolver<Eigen::MatrixXd> es((*pb)[mm]->covrJK);
+	// Decompose on every HALLREUSE analysis, or sooner if the
+	// covariance has drifted by more than HALLTOL
+	//
+	auto & covr = (*pb)[mm]->covrJK;
 
-	(*pb)[mm]->evalJK = es.eigenvalues().real();
-	(*pb)[mm]->evecJK = es.eigenvectors().real();
+	bool refresh = hallCount % std::max<int>(HALLREUSE, 1) == 0 or
+	  hallEvec[mm].size()==0;
 
-	// Sign convention
-	//
-	int nfid = std::min<int>(4, efE.rows()) - 1;
-	for (int j=0; j<(*pb)[mm]->evecJK.cols(); j++) {
-	  if ((*pb)[mm]->evecJK(nfid, j) < 0.0) (*pb)[mm]->evecJK.col(j) *= -1;
+	if (not refresh and HALLTOL>0.0) {
+	  double norm = hallCovr[mm].norm();
+	  refresh = norm<=0.0 or (covr - hallCovr[mm]).norm() > HALLTOL*norm;
+	}
+
+	if (refresh) {
+	  Eigen::EigenSolver<Eigen::MatrixXd> es(covr);
+
+	  (*pb)[mm]->evalJK = es.eigenvalues().real();
+	  (*pb)[mm]->evecJK = es.eigenvectors().real();
+
+	  // Sign convention
+	  //
+	  int nfid = std::min<int>(4, efE.rows()) - 1;
+	  for (int j=0; j<(*pb)[mm]->evecJK.cols(); j++) {
+	    if ((*pb)[mm]->evecJK(nfid, j) < 0.0) (*pb)[mm]->evecJK.col(j) *= -1;
+	  }
+
+	  hallEvec[mm] = (*pb)[mm]->evecJK;
+	  hallCovr[mm] = covr;
+	} else {
+	  // Cached transform; the variances along its directions are
+	  // the diagonal of the projected covariance
+	  //
+	  (*pb)[mm]->evecJK = hallEvec[mm];
+	  (*pb)[mm]->evalJK =
+	    (hallEvec[mm].transpose() * covr * hallEvec[mm]).diagonal();
 	}
-
       }
     
       // Transformation output
@@ -4798,6 +5406,7 @@ void EmpCylSL::pca_hall(bool compute, bool subsamp)
     }
 
     eofcount++;
+    if (PCAVAR) hallCount++;
   }
     
   if (VFLAG & 4)
@@ -5104,16 +5713,29 @@ void EmpCylSL::accumulated_eval(double r, double z, double phi,
   double c11 = delx1*dely1;
   
   double ccos, ssin=0.0, fac;
+
+  const double *cosm1, *sinm1;
+  sinecosine_M(phi, cosm1, sinm1);
   
+  // Use the interleaved table: each corner is one contiguous run
+  //
+  if (packed()) {
+    packed_eval(ix, iy, c00, c10, c01, c11, cosm1, sinm1, 1,
+		p0, p, fr, fz, fp);
+    return;
+  }
+
   for (int mm=std::max<int>(0, MMIN); mm<=std::min<int>(MLIM, MMAX); mm++) {
     
     // Suppress odd M terms?
     if (EVEN_M && (mm/2)*2 != mm) continue;
 
-    ccos = cos(phi*mm);
-    ssin = sin(phi*mm);
+    ccos = cosm1[mm];
+    ssin = sinm1[mm];
 
     for (int n=std::max<int>(0, NMIN); n<std::min<int>(NLIM, rank3); n++) {
+
+      if (sparseTerms and not activeMask[mm*rank3 + n]) continue;
       
       fac = accum_cos[mm][n] * ccos;
       
@@ -5201,6 +5823,348 @@ void EmpCylSL::accumulated_eval(double r, double z, double phi,
 }
 
 
+void EmpCylSL::packed_eval(int ix, int iy,
+			   double c00, double c10, double c01, double c11,
+			   const double* cosm1, const double* sinm1, int stride,
+			   double& p0, double& p, double& fr, double& fz,
+			   double& fp)
+{
+  if (ftable.size())
+    packed_sum(ftable, ix, iy, c00, c10, c01, c11, cosm1, sinm1, stride,
+	       p0, p, fr, fz, fp);
+  else
+    packed_sum(ptable, ix, iy, c00, c10, c01, c11, cosm1, sinm1, stride,
+	       p0, p, fr, fz, fp);
+}
+
+
+void EmpCylSL::set_active(double tol)
+{
+  sparseTerms = false;
+
+  // The coefficients must be final: accumulated_eval() would
+  // otherwise make them during the force pass
+  //
+  if (accum_cos.size()==0 or not coefs_made_all()) return;
+
+  double cmax = 0.0;
+  if (tol>0.0) {
+    for (int mm=0; mm<=MMAX; mm++) {
+      cmax = std::max<double>(cmax, accum_cos[mm].cwiseAbs().maxCoeff());
+      if (mm) cmax = std::max<double>(cmax, accum_sin[mm].cwiseAbs().maxCoeff());
+    }
+  }
+  tol *= cmax;
+
+  activeTerms.clear();
+  activeMask.assign((MMAX+1)*rank3, 0);
+
+  // Same selection as the full loops; NaN values are kept
+  //
+  for (int mm=std::max<int>(0, MMIN); mm<=std::min<int>(MLIM, MMAX); mm++) {
+
+    if (EVEN_M && (mm/2)*2 != mm) continue;
+
+    for (int n=std::max<int>(0, NMIN); n<std::min<int>(NLIM, rank3); n++) {
+      bool keep = not (fabs(accum_cos[mm][n]) <= tol);
+      if (mm) keep = keep or not (fabs(accum_sin[mm][n]) <= tol);
+      if (keep) {
+	activeTerms.push_back(mm*rank3 + n);
+	activeMask[mm*rank3 + n] = 1;
+      }
+    }
+  }
+
+  sparseTerms = true;
+}
+
+
+template<typename T>
+void EmpCylSL::packed_sum(const NodeShared<T>& tab, int ix, int iy,
+			  double c00, double c10, double c01, double c11,
+			  const double* cosm1, const double* sinm1, int stride,
+			  double& p0, double& p, double& fr, double& fz,
+			  double& fp)
+{
+  // Table values are promoted so that the sums are in double
+  //
+  const T *t00 = pcell(tab, ix  , iy  ), *t10 = pcell(tab, ix+1, iy  );
+  const T *t01 = pcell(tab, ix  , iy+1), *t11 = pcell(tab, ix+1, iy+1);
+
+  auto val = [&](int k) -> double {
+    return t00[k]*c00 + t10[k]*c10 + t01[k]*c01 + t11[k]*c11;
+  };
+
+  // Field offsets in a packed cell; the forces may not be loaded
+  //
+  const int oPc = poff[fPotC], oRc = poff[fRfcC], oZc = poff[fZfcC];
+  const int oPs = poff[fPotS], oRs = poff[fRfcS], oZs = poff[fZfcS];
+  const bool frc = oRc >= 0;
+
+  double fac;
+
+  // Only the significant terms
+  //
+  if (sparseTerms) {
+
+    bool m0 = std::max<int>(0, MMIN)==0 and std::min<int>(MLIM, MMAX)>=0;
+
+    for (int k : activeTerms) {
+
+      int mm = k/rank3, n = k - mm*rank3;
+
+      if (m0 and mm>0) {
+	p0 = p;
+	m0 = false;
+      }
+
+      double ccos = cosm1[mm*stride];
+      double ssin = sinm1[mm*stride];
+
+      k *= pfield;
+
+      double pv = val(k+oPc);
+
+      fac = accum_cos[mm][n] * ccos;
+
+      p  += fac * pv;
+      if (frc) {
+	fr += fac * val(k+oRc);
+	fz += fac * val(k+oZc);
+      }
+
+      fac = accum_cos[mm][n] * ssin;
+      
+      fp += fac * mm * pv;
+
+      if (mm) {
+
+	pv = val(k+oPs);
+
+	fac = accum_sin[mm][n] * ssin;
+
+	p  += fac * pv;
+	if (frc) {
+	  fr += fac * val(k+oRs);
+	  fz += fac * val(k+oZs);
+	}
+
+	fac = -accum_sin[mm][n] * ccos;
+
+	fp += fac * mm * pv;
+      }
+    }
+
+    if (m0) p0 = p;
+
+    return;
+  }
+
+  for (int mm=std::max<int>(0, MMIN); mm<=std::min<int>(MLIM, MMAX); mm++) {
+    
+    // Suppress odd M terms?
+    if (EVEN_M && (mm/2)*2 != mm) continue;
+
+    double ccos = cosm1[mm*stride];
+    double ssin = sinm1[mm*stride];
+
+    for (int n=std::max<int>(0, NMIN); n<std::min<int>(NLIM, rank3); n++) {
+
+      int k = (mm*rank3 + n)*pfield;
+	
+      double pv = val(k+oPc);
+
+      fac = accum_cos[mm][n] * ccos;
+
+      p  += fac * pv;
+      if (frc) {
+	fr += fac * val(k+oRc);
+	fz += fac * val(k+oZc);
+      }
+
+      fac = accum_cos[mm][n] * ssin;
+      
+      fp += fac * mm * pv;
+
+      if (mm) {
+
+	pv = val(k+oPs);
+
+	fac = accum_sin[mm][n] * ssin;
+
+	p  += fac * pv;
+	if (frc) {
+	  fr += fac * val(k+oRs);
+	  fz += fac * val(k+oZs);
+	}
+
+	fac = -accum_sin[mm][n] * ccos;
+
+	fp += fac * mm * pv;
+      }
+    }
+
+    if (mm==0) p0 = p;
+  }
+}
+
+
+void EmpCylSL::accumulated_eval_batch(int N, const double* R,
+				      const double* z, const double* phi,
+				      double* p0, double* p,
+				      double* fr, double* fz, double* fp)
+{
+  if (!coefs_made_all()) {
+    if (VFLAG>3)
+      std::cerr << "Process " << myid << ": in EmpCylSL::accumlated_eval_batch, "
+		<< "calling make_coefficients()" << std::endl;
+    make_coefficients();
+  }
+
+  // No packed table: evaluate one at a time
+  //
+  if (not packed()) {
+    for (int b=0; b<N; b++) {
+      p0[b] = 0.0;
+      accumulated_eval(R[b], z[b], phi[b], p0[b], p[b], fr[b], fz[b], fp[b]);
+    }
+    return;
+  }
+
+  thread_local std::vector<int>    cell;
+  thread_local std::vector<double> wght, trig;
+
+  cell.resize(2*N);
+  wght.resize(4*N);
+
+  // Grid location and bilinear weights for the block
+  //
+  for (int b=0; b<N; b++) {
+
+    p0[b] = p[b] = fr[b] = fz[b] = fp[b] = 0.0;
+
+    double rr = sqrt(R[b]*R[b] + z[b]*z[b]);
+    if (rr/ASCALE>Rtable) {
+      cell[2*b] = -1;
+      continue;
+    }
+
+    double X = (r_to_xi(R[b]) - XMIN)/dX;
+    double Y = (z_to_y(z[b])  - YMIN)/dY;
+
+    int ix = (int)X;
+    int iy = (int)Y;
+  
+    if (ix < 0) {
+      ix = 0;
+      if (enforce_limits) X = 0.0;
+    }
+    if (iy < 0) {
+      iy = 0;
+      if (enforce_limits) Y = 0.0;
+    }
+  
+    if (ix >= NUMX) {
+      ix = NUMX-1;
+      if (enforce_limits) X = NUMX;
+    }
+    if (iy >= NUMY) {
+      iy = NUMY-1;
+      if (enforce_limits) Y = NUMY;
+    }
+
+    double delx0 = (double)ix + 1.0 - X;
+    double dely0 = (double)iy + 1.0 - Y;
+    double delx1 = X - (double)ix;
+    double dely1 = Y - (double)iy;
+
+    cell[2*b+0] = ix;
+    cell[2*b+1] = iy;
+
+    wght[4*b+0] = delx0*dely0;
+    wght[4*b+1] = delx1*dely0;
+    wght[4*b+2] = delx0*dely1;
+    wght[4*b+3] = delx1*dely1;
+  }
+
+  // Azimuthal recursion for the block with the particle index
+  // fastest
+  //
+  const int M1 = std::max<int>(1, MMAX) + 1;
+
+  trig.resize(2*M1*N);
+  double *cb = trig.data(), *sb = cb + M1*N;
+
+  for (int b=0; b<N; b++) {
+    cb[b]   = 1.0;
+    sb[b]   = 0.0;
+    cb[N+b] = cos(phi[b]);
+    sb[N+b] = sin(phi[b]);
+  }
+
+  for (int m=2; m<=MMAX; m++) {
+    double *c2 = cb + (m-2)*N, *c1 = cb + (m-1)*N, *c0 = cb + m*N;
+    double *s2 = sb + (m-2)*N, *s1 = sb + (m-1)*N, *s0 = sb + m*N;
+#pragma omp simd
+    for (int b=0; b<N; b++) {
+      c0[b] = 2.0*cb[N+b]*c1[b] - c2[b];
+      s0[b] = 2.0*cb[N+b]*s1[b] - s2[b];
+    }
+  }
+
+  // Basis sums
+  //
+  for (int b=0; b<N; b++) {
+    if (cell[2*b]<0) continue;
+    const double *w = &wght[4*b];
+    packed_eval(cell[2*b], cell[2*b+1], w[0], w[1], w[2], w[3],
+		cb + b, sb + b, N, p0[b], p[b], fr[b], fz[b], fp[b]);
+  }
+}
+
+
+template<typename T>
+double EmpCylSL::packed_dens(const NodeShared<T>& tab, int ix, int iy,
+			     double c00, double c10, double c01, double c11,
+			     const double* cosm1, const double* sinm1,
+			     double& d0)
+{
+  const T *t00 = pcell(tab, ix  , iy  ), *t10 = pcell(tab, ix+1, iy  );
+  const T *t01 = pcell(tab, ix  , iy+1), *t11 = pcell(tab, ix+1, iy+1);
+
+  double ans = 0.0;
+
+  // The density may not be loaded
+  //
+  d0 = 0.0;
+  if (poff[fDenC] < 0) return ans;
+
+  for (int mm=std::max<int>(0, MMIN); mm<=std::min<int>(MLIM, MMAX); mm++) {
+
+    double ccos = cosm1[mm];
+    double ssin = sinm1[mm];
+
+    for (int n=std::max<int>(0, NMIN); n<std::min<int>(NLIM, rank3); n++) {
+
+      int k = (mm*rank3 + n)*pfield + poff[fDenC];
+
+      ans += accum_cos[mm][n]*ccos *
+	(t00[k]*c00 + t10[k]*c10 + t01[k]*c01 + t11[k]*c11);
+
+      if (mm) {
+	k += poff[fDenS] - poff[fDenC];
+	ans += accum_sin[mm][n]*ssin *
+	  (t00[k]*c00 + t10[k]*c10 + t01[k]*c01 + t11[k]*c11);
+      }
+    }
+
+    if (mm==0) d0 = ans;
+  }
+
+  return ans;
+}
+
+
 double EmpCylSL::accumulated_dens_eval(double r, double z, double phi, 
 				       double& d0)
 {
@@ -5253,10 +6217,20 @@ double EmpCylSL::accumulated_dens_eval(double r, double z, double phi,
 
   double ccos, ssin=0.0, fac;
 
+  const double *cosm1, *sinm1;
+  sinecosine_M(phi, cosm1, sinm1);
+
+  // Use the interleaved table
+  //
+  if (ftable.size())
+    return packed_dens(ftable, ix, iy, c00, c10, c01, c11, cosm1, sinm1, d0);
+  if (ptable.size())
+    return packed_dens(ptable, ix, iy, c00, c10, c01, c11, cosm1, sinm1, d0);
+
   for (int mm=std::max<int>(0, MMIN); mm<=std::min<int>(MLIM, MMAX); mm++) {
 
-    ccos = cos(phi*mm);
-    ssin = sin(phi*mm);
+    ccos = cosm1[mm];
+    ssin = sinm1[mm];
 
     for (int n=std::max<int>(0, NMIN); n<std::min<int>(NLIM, rank3); n++) {
 
@@ -6430,6 +7404,23 @@ void EmpCylSL::sinecosine_R(int mmax, double phi,
 }
 
 
+void EmpCylSL::sinecosine_M(double phi, const double*& c, const double*& s)
+{
+  thread_local Eigen::VectorXd cosm1, sinm1;
+
+  int msize = std::max<int>(1, MMAX) + 1;
+  if (cosm1.size() != msize) {
+    cosm1.resize(msize);
+    sinm1.resize(msize);
+  }
+
+  sinecosine_R(MMAX, phi, cosm1, sinm1);
+
+  c = cosm1.data();
+  s = sinm1.data();
+}
+
+
 void EmpCylSL::dump_eof_file(const string& eof_file, const string& output)
 {
   ifstream in(eof_file.c_str());
@@ -6989,11 +7980,50 @@ void EmpCylSL::ortho_check(std::ostream& out)
 //
 std::vector<Eigen::MatrixXd> EmpCylSL::orthoCheck()
 {
-  std::vector<Eigen::MatrixXd> ret;
+  std::vector<Eigen::MatrixXd> ret(MMAX+1);
+
+  // Quadrature weights on the grid: trapezoidal rule times the
+  // Jacobian.  These are the same for every m and n.
+  //
+  Eigen::MatrixXd wgt(NUMX+1, NUMY+1);
+
+  for (int ix=0; ix<=NUMX; ix++) {
+    double x  = XMIN + dX*ix;
+    double r  = xi_to_r(x);
+    double fx = 1.0;
+				// Trapezoidal rule
+    if (ix ==0 or ix==NUMX) fx = 0.5;
+	
+    for (int iy=0; iy<=NUMY; iy++) {
+      double y = YMIN + dY*iy;
+      double fy = 1.0;
+				// Trapezoidal rule
+      if (iy ==0 or iy==NUMY) fy = 0.5;
+
+      wgt(ix, iy) = r/d_xi_to_r(x) * d_y_to_z(y) * fx * fy;
+    }
+  }
+
+  const int ngrid = wgt.size();
+  Eigen::Map<const Eigen::VectorXd> W(wgt.data(), ngrid);
+
+  // The tables as columns, so that each orthogonality matrix is one
+  // matrix product
+  //
+  Eigen::MatrixXd P(ngrid, NORDER), D(ngrid, NORDER);
+
+  auto inner = [&](std::vector<GridMap>& pot, std::vector<GridMap>& dens)
+  {
+#pragma omp parallel for
+    for (int n=0; n<NORDER; n++) {
+      P.col(n) = W.cwiseProduct(Eigen::Map<const Eigen::VectorXd>(pot[n].data(), ngrid));
+      D.col(n) = Eigen::Map<const Eigen::VectorXd>(dens[n].data(), ngrid);
+    }
+
+    Eigen::MatrixXd ans = P.transpose() * D;
+    return ans;
+  };
 
-  ret.resize(MMAX+1);
-  for (auto & v : ret) v.resize(NORDER, NORDER);
-  
   for (int mm=0; mm<=MMAX; mm++) {
 
     // Normalization:
@@ -7004,46 +8034,17 @@ std::vector<Eigen::MatrixXd> EmpCylSL::orthoCheck()
     double fac = -4.0*M_PI * (2.0*M_PI) * dX * dY;
     if (mm) fac *= 0.5;
 
-    // Compute orthogonality matrix
-    //
-
-    // Unroll loop for OpenMP
-#pragma omp parallel for
-    for (int nn=0; nn<NORDER*NORDER; nn++) {
-      int n1 = nn/NORDER;
-      int n2 = nn - n1*NORDER;
-      
-      double sumC = 0.0, sumS = 0.0;
-
-      for (int ix=0; ix<=NUMX; ix++) {
-	double x  = XMIN + dX*ix;
-	double r  = xi_to_r(x);
-	double fx = 1.0;
-				// Trapezoidal rule
-	if (ix ==0 or ix==NUMX) fx = 0.5;
-	
-	for (int iy=0; iy<=NUMY; iy++) {
-	  
-	  double y = YMIN + dY*iy;
-	  double fy = 1.0;
-				// Trapezoidal rule
-	  if (iy ==0 or iy==NUMX) fy = 0.5;
-
-	  double jac = fac * r/d_xi_to_r(x) * d_y_to_z(y) * fx * fy;
+    Eigen::MatrixXd sumC = fac * inner(potC[mm], densC[mm]);
 
-	  sumC += jac * potC[mm][n1](ix, iy) * densC[mm][n2](ix, iy);
-	  if (mm) sumS += jac * potS[mm][n1](ix, iy) * densS[mm][n2](ix, iy);
-	}
-      }
-	
-      // Combine sines and cosines.  sumC and sumS should each by
-      // unity or zero so the returns below combine sumC and sumS
-      // for m>0.
-      //
-      if (mm==0)
-	ret[mm](n1, n2) = sumC;
-      else
-	ret[mm](n1, n2) = sqrt(0.5*(sumC*sumC + sumS*sumS));
+    // Combine sines and cosines.  sumC and sumS should each by
+    // unity or zero so the returns below combine sumC and sumS
+    // for m>0.
+    //
+    if (mm==0)
+      ret[mm] = sumC;
+    else {
+      Eigen::MatrixXd sumS = fac * inner(potS[mm], densS[mm]);
+      ret[mm] = (0.5*(sumC.array().square() + sumS.array().square())).sqrt();
     }
   }
 
@@ -7166,14 +8167,34 @@ void EmpCylSL::getPotSC(int mm, int n, double R, double z,
       potS[mm][n](ix+1, iy+1) * c11 ;
 }
 
+//! HighFive file access property: objects of at least threshold
+//! bytes start at a multiple of alignment in the file
+struct H5Alignment
+{
+  hsize_t threshold, alignment;
+  void apply(hid_t hid) const { H5Pset_alignment(hid, threshold, alignment); }
+};
+
 void EmpCylSL::WriteH5Cache()
 {
   if (myid) return;		// Only root node writes the cache
 
+  // The cache must hold all of the tables
+  //
+  if (loaded != Tables::all) {
+    std::cerr << "---- EmpCylSL::WriteH5Cache: only some of the tables "
+	      << "are loaded; the cache is not written" << std::endl;
+    return;
+  }
+
   try {
-    // Create a new hdf5 file or overwrite an existing file
+    // Create a new hdf5 file or overwrite an existing file.  Large
+    // datasets are page aligned so that the table may be mapped.
     //
-    HighFive::File file(cachefile, HighFive::File::ReadWrite | HighFive::File::Create);
+    HighFive::FileAccessProps fapl;
+    if (MMAPCACHE) fapl.add(H5Alignment{1<<16, 4096});
+
+    HighFive::File file(cachefile, HighFive::File::ReadWrite | HighFive::File::Create, fapl);
     
     // For basis ID
     std::string forceID("Cylinder"), geometry("cylinder");
@@ -7189,6 +8210,16 @@ void EmpCylSL::WriteH5Cache()
     file.createAttribute<int>        ("mmax",    HighFive::DataSpace::From(MMAX)).    write(MMAX);
     file.createAttribute<int>        ("numx",    HighFive::DataSpace::From(NUMX)).    write(NUMX);
     file.createAttribute<int>        ("numy",    HighFive::DataSpace::From(NUMY)).    write(NUMY);
+
+    // Resolution selection: the configured sizes and the target and
+    // achieved interpolation error
+    //
+    int numxfull = numxFull ? numxFull : NUMX;
+    int numyfull = numyFull ? numyFull : NUMY;
+    file.createAttribute<int>        ("numxfull", HighFive::DataSpace::From(numxfull)).write(numxfull);
+    file.createAttribute<int>        ("numyfull", HighFive::DataSpace::From(numyfull)).write(numyfull);
+    file.createAttribute<double>     ("tabtol",   HighFive::DataSpace::From(TABTOL)).  write(TABTOL);
+    file.createAttribute<double>     ("taberr",   HighFive::DataSpace::From(tabErr)).  write(tabErr);
     file.createAttribute<int>        ("nmax",    HighFive::DataSpace::From(NORDER)).  write(NORDER);
     file.createAttribute<int>        ("lmaxfid", HighFive::DataSpace::From(LMAX)).    write(LMAX);
     file.createAttribute<int>        ("nmaxfid", HighFive::DataSpace::From(NMAX)).    write(NMAX);
@@ -7219,10 +8250,10 @@ void EmpCylSL::WriteH5Cache()
 	sout << n;
 	auto order = harmonic.createGroup(sout.str());
       
-	order.createDataSet("potC",    potC   [m][n]);
-	order.createDataSet("rforceC", rforceC[m][n]);
-	order.createDataSet("zforceC", zforceC[m][n]);
-	order.createDataSet("densC",   densC  [m][n]);
+	order.createDataSet("potC",    Eigen::MatrixXd(potC   [m][n]));
+	order.createDataSet("rforceC", Eigen::MatrixXd(rforceC[m][n]));
+	order.createDataSet("zforceC", Eigen::MatrixXd(zforceC[m][n]));
+	order.createDataSet("densC",   Eigen::MatrixXd(densC  [m][n]));
       }
     }
 
@@ -7243,13 +8274,22 @@ void EmpCylSL::WriteH5Cache()
 	sout << n;
 	auto order = harmonic.createGroup(sout.str());
       
-	order.createDataSet("potS",    potS   [m][n]);
-	order.createDataSet("rforceS", rforceS[m][n]);
-	order.createDataSet("zforceS", zforceS[m][n]);
-	order.createDataSet("densS",   densS  [m][n]);
+	order.createDataSet("potS",    Eigen::MatrixXd(potS   [m][n]));
+	order.createDataSet("rforceS", Eigen::MatrixXd(rforceS[m][n]));
+	order.createDataSet("zforceS", Eigen::MatrixXd(zforceS[m][n]));
+	order.createDataSet("densS",   Eigen::MatrixXd(densS  [m][n]));
       }
     }
 
+    // All grids in storage order as one contiguous, uncompressed
+    // dataset for read-only mapping
+    //
+    if (MMAPCACHE) {
+      std::vector<size_t> dims {gridstore.size()};
+      file.createDataSet<double>("Table", HighFive::DataSpace(dims))
+	.write_raw(gridstore.data());
+    }
+
   } catch (HighFive::Exception& err) {
     std::cerr << err.what() << std::endl;
   }
@@ -7332,38 +8372,43 @@ bool EmpCylSL::ReadH5Cache()
     if (not checkDbl(HSCALE,   "hscl"))      return false;
     if (not checkDbl(cylmass,  "cmass"))     return false;
 
+    // Tables reduced for a different target are recomputed
+    //
+    if (TABTOL>0.0) {
+      if (not file.hasAttribute("tabtol")) return false;
+      if (not checkDbl(TABTOL, "tabtol"))  return false;
+    }
+
     // Set EvenOdd if values seem sane
     //
     if (Nodd>=0 and Nodd<=NORDER and Nodd+Neven==NORDER) {
       EvenOdd  = true;
     }
 
-    // Allocate arrays for storing grids
+    // The grids were allocated by setup_table() with the dimensions
+    // checked above
     //
-    potC    .resize(MMAX+1);
-    rforceC .resize(MMAX+1);
-    zforceC .resize(MMAX+1);
-  
-    potS    .resize(MMAX+1);
-    rforceS .resize(MMAX+1);
-    zforceS .resize(MMAX+1);
-  
-    densC   .resize(MMAX+1);
-    densS   .resize(MMAX+1);
+    if (potC.size() != MMAX+1) allocate_grids();
 
-    for (int m=0; m<=MMAX; m++) {
-      potC[m]   .resize(NORDER);
-      rforceC[m].resize(NORDER);
-      zforceC[m].resize(NORDER);
-      densC[m]  .resize(NORDER);
-    }
+    // Map the contiguous table if present
+    //
+    if (mapCache() and file.exist("Table")) {
+      auto   table = file.getDataSet("Table");
+      size_t total = gridstore.size();
+      haddr_t off  = H5Dget_offset(table.getId());
+
+      if (table.getSpace().getElementCount() == total and
+	  off != HADDR_UNDEF and gridstore.map(cachefile, off, total)) {
+	bind_grids();
+	if (myid==0) std::cout << "---- EmpCylSL::ReadH5Cache: "
+			       << "mapped <" << cachefile << ">" << std::endl;
+	return true;
+      }
 
-    for (int m=1; m<=MMAX; m++) {
-      potS[m]   .resize(NORDER);
-      rforceS[m].resize(NORDER);
-      zforceS[m].resize(NORDER);
-      densS[m]  .resize(NORDER);
-    }    
+      // map() releases the storage on failure
+      //
+      allocate_grids();
+    }
 
     // Read arrays and data from H5 file
     //
@@ -7385,9 +8430,12 @@ bool EmpCylSL::ReadH5Cache()
 	auto order = harmonic.getGroup(sout.str());
       
 	potC   [m][n] = order.getDataSet("potC")   .read<Eigen::MatrixXd>();
-	rforceC[m][n] = order.getDataSet("rforceC").read<Eigen::MatrixXd>();
-	zforceC[m][n] = order.getDataSet("zforceC").read<Eigen::MatrixXd>();
-	densC  [m][n] = order.getDataSet("densC")  .read<Eigen::MatrixXd>();
+	if (hasFrc()) {
+	  rforceC[m][n] = order.getDataSet("rforceC").read<Eigen::MatrixXd>();
+	  zforceC[m][n] = order.getDataSet("zforceC").read<Eigen::MatrixXd>();
+	}
+	if (hasDen())
+	  densC[m][n] = order.getDataSet("densC").read<Eigen::MatrixXd>();
       }
     }
 
@@ -7408,9 +8456,12 @@ bool EmpCylSL::ReadH5Cache()
 	auto order = harmonic.getGroup(sout.str());
       
 	potS   [m][n] = order.getDataSet("potS")   .read<Eigen::MatrixXd>();
-	rforceS[m][n] = order.getDataSet("rforceS").read<Eigen::MatrixXd>();
-	zforceS[m][n] = order.getDataSet("zforceS").read<Eigen::MatrixXd>();
-	densS  [m][n] = order.getDataSet("densS")  .read<Eigen::MatrixXd>();
+	if (hasFrc()) {
+	  rforceS[m][n] = order.getDataSet("rforceS").read<Eigen::MatrixXd>();
+	  zforceS[m][n] = order.getDataSet("zforceS").read<Eigen::MatrixXd>();
+	}
+	if (hasDen())
+	  densS[m][n] = order.getDataSet("densS").read<Eigen::MatrixXd>();
       }
     }
 
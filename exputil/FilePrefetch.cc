@@ -0,0 +1,121 @@
+#include <stdexcept>
+#include <algorithm>
+#include <fstream>
+
+#include <FilePrefetch.H>
+
+FilePrefetch::FilePrefetch(const std::vector<std::string>& files, int depth) :
+  files(files), depth(std::max<int>(1, depth)), next(0), low(0), stop(false)
+{
+  int nthrds = std::min<size_t>(this->depth, files.size());
+  for (int i=0; i<nthrds; i++) pool.emplace_back(&FilePrefetch::worker, this);
+}
+
+FilePrefetch::~FilePrefetch()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+  for (auto & t : pool) t.join();
+}
+
+FilePrefetch::Buffer FilePrefetch::load(const std::string& name)
+{
+  std::ifstream in(name, std::ios::binary | std::ios::ate);
+  if (not in) throw std::runtime_error("FilePrefetch: could not open <" + name + ">");
+
+  auto ret = std::make_shared<std::vector<char>>(in.tellg());
+  in.seekg(0);
+  in.read(ret->data(), ret->size());
+  if (not in) throw std::runtime_error("FilePrefetch: could not read <" + name + ">");
+
+  return ret;
+}
+
+void FilePrefetch::worker()
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (true) {
+    cv.wait(lock, [this]{
+      return stop or (next < files.size() and next < low + depth);
+    });
+    if (stop) return;
+
+    size_t i = next++;
+    busy.insert(i);
+    lock.unlock();
+
+    Buffer data;
+    std::string error;
+    try {
+      data = load(files[i]);
+    }
+    catch (std::exception& e) {
+      error = e.what();
+    }
+
+    lock.lock();
+    busy.erase(i);
+    if (data) ready[i]  = data;
+    else      errors[i] = error;
+    cv.notify_all();
+  }
+}
+
+FilePrefetch::Buffer FilePrefetch::get(size_t i)
+{
+  if (i >= files.size())
+    throw std::runtime_error("FilePrefetch: file index out of range");
+
+  std::unique_lock<std::mutex> lock(mtx);
+
+  // Slide the window and skip over files that will not be asked for
+  //
+  low  = std::max(low, i);
+  next = std::max(next, i);
+  cv.notify_all();
+
+  // Handed out before: read it here
+  //
+  if (i < next and not ready.count(i) and not errors.count(i) and
+      not busy.count(i)) {
+    lock.unlock();
+    return load(files[i]);
+  }
+
+  cv.wait(lock, [this, i]{ return ready.count(i) or errors.count(i); });
+
+  auto e = errors.find(i);
+  if (e != errors.end()) {
+    std::string msg = e->second;
+    errors.erase(e);
+    throw std::runtime_error(msg);
+  }
+
+  Buffer ret = ready[i];
+  ready.erase(i);
+
+  // Drop anything before the window
+  //
+  ready.erase(ready.begin(), ready.lower_bound(low));
+
+  return ret;
+}
+
+MemStream::MemBuf::pos_type
+MemStream::MemBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+			   std::ios_base::openmode which)
+{
+  char *p;
+  if      (dir == std::ios_base::beg) p = eback() + off;
+  else if (dir == std::ios_base::cur) p = gptr()  + off;
+  else                                p = egptr() + off;
+
+  if (p < eback() or p > egptr()) return pos_type(off_type(-1));
+
+  setg(eback(), p, egptr());
+  return pos_type(p - eback());
+}
@@ -38,15 +38,11 @@ HankelTransform::HankelTransform(double h, double nu, int N)
     throw std::runtime_error(sout.str());
   }
 
-  // Sets maximum number of nodes to about 2^15:
-  //
-  const int maxN = 32769;
-  
-  // Imports zeros of the Bessel function. Initializing this way speeds up calls
+  // Only the first N zeros are used by the quadrature
   //
   try {
-    boost::math::cyl_bessel_j_zero(this->nu, 1, maxN, std::back_inserter(zeros));
-    for (size_t i = 0; i < maxN; i++) {
+    boost::math::cyl_bessel_j_zero(this->nu, 1, N, std::back_inserter(zeros));
+    for (int i = 0; i < N; i++) {
       xi.push_back( zeros[i]/M_PI );
 
       // Evaluate the Bessel functions of the first and second
@@ -55,6 +51,24 @@ HankelTransform::HankelTransform(double h, double nu, int N)
       double Jp1 = boost::math::cyl_bessel_j(nu+1.0, M_PI*xi[i]);
       w.push_back( boost::math::cyl_neumann(nu, M_PI*xi[i])/Jp1);  
     }
+
+    // Nodes and weights of the mapped formula (Equation 5.2)
+    //
+    for (int i = 0; i < N; i++) {
+      double knots = M_PI/h*get_psi( h*xi[i] );
+      double psip  = get_psip( h*xi[i] );
+      if (std::isnan(psip)) psip = 1.0; // Sanity check
+      xM.push_back(knots);
+      wM.push_back(M_PI * w[i] * boost::math::cyl_bessel_j(nu, knots) * psip);
+    }
+
+    // Nodes and weights of the linear formula (Equation 1.1)
+    //
+    for (int i = 0; i < N; i++) {
+      double knots = xi[i]*h;
+      xL.push_back(knots);
+      wL.push_back(h * w[i] * boost::math::cyl_bessel_j(nu, knots));
+    }
   }
   catch (std::exception& ex) {
     std::cout << "Thrown exception " << ex.what() << std::endl;
@@ -80,29 +94,10 @@ double HankelTransform::get_psip(double t)
 double HankelTransform::ogata_transformed
 (std::function<double (double) > f, double q, double h)
 {
-  double nu = this->nu;
-  int N = this->N;
-
   double val = 0;
 
   try {
-    for (size_t i = 0; i < (unsigned)N; i++) {
-      double knots = M_PI/h*get_psi( h*xi[i] );
-      double Jnu = boost::math::cyl_bessel_j(nu,knots);
-      double temp =  get_psip( h*xi[i] ), psip;
-
-      // Sanity check
-      if (std::isnan(temp)) {
-        psip = 1.0;
-      }
-      else
-      {
-        psip = temp;
-      };
-
-      double F = fk_trans(knots, f, q);
-      val += M_PI * w[i]* F * Jnu * psip;
-    }
+    for (size_t i = 0; i < xM.size(); i++) val += wM[i] * fk_trans(xM[i], f, q);
   }
   catch (std::exception& ex)
   {
@@ -117,18 +112,11 @@ double HankelTransform::ogata_transformed
 //
 double HankelTransform::ogata_linear
 (std::function<double (double) > f, double q, double h){
-  double nu = this->nu;
-  int N = this->N;
-
   double val = 0;
 
   try
   {
-    for (size_t i = 0; i < (unsigned)N; i++) {
-      double knots = xi[i]*h;
-      double F = fk_trans(knots, f, q)*boost::math::cyl_bessel_j(nu, knots);
-      val += h * w[i] * F;
-    }
+    for (size_t i = 0; i < xL.size(); i++) val += wL[i] * fk_trans(xL[i], f, q);
   }
   catch(std::exception& ex)
   {
@@ -153,3 +141,12 @@ double HankelTransform::operator()(std::function<double (double) > g,  double q)
 
   return result;
 };
+
+// Compute the Ogata quadrature for a set of q values
+std::vector<double> HankelTransform::operator()
+(std::function<double (double) > g, const std::vector<double>& q)
+{
+  std::vector<double> result(q.size());
+  for (size_t j=0; j<q.size(); j++) result[j] = (*this)(g, q[j]);
+  return result;
+};
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <HugePages.H>
+
+int         HugePages::mode      = HugePages::Off;
+std::size_t HugePages::threshold = std::size_t(1) << 21;
+
+namespace
+{
+  const std::size_t huge = std::size_t(1) << 21;
+
+  // Huge page mappings and their lengths
+  std::unordered_map<void*, std::size_t> maps;
+  std::mutex lock;
+
+  std::size_t roundup(std::size_t bytes)
+  {
+    return (bytes + huge - 1)/huge*huge;
+  }
+
+#ifdef __linux__
+  // Anonymous mapping of len bytes on a 2 MB boundary with
+  // transparent huge pages requested
+  void* transparent(std::size_t len)
+  {
+    void *p = mmap(nullptr, len + huge, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+
+    // Trim to the boundary
+    //
+    std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+    std::uintptr_t b = (a + huge - 1)/huge*huge;
+    if (b > a) munmap(p, b - a);
+    munmap(reinterpret_cast<void*>(b + len), a + huge - b);
+
+    p = reinterpret_cast<void*>(b);
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE);
+#endif
+    return p;
+  }
+
+  // Mapping from the preallocated huge page pool
+  void* explicit_pool(std::size_t len)
+  {
+#ifdef MAP_HUGETLB
+    void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) return p;
+#endif
+    return nullptr;
+  }
+#endif
+}
+
+void* HugePages::allocate(std::size_t bytes)
+{
+#ifdef __linux__
+  if (mode != Off and bytes >= threshold) {
+    std::size_t len = roundup(bytes);
+    void *p = nullptr;
+    if (mode == Explicit) p = explicit_pool(len);
+    if (p == nullptr)     p = transparent(len);
+    if (p) {
+      std::lock_guard<std::mutex> guard(lock);
+      maps[p] = len;
+      return p;
+    }
+  }
+#endif
+
+  // The heap: aligned_alloc needs a multiple of the alignment
+  //
+  void *p = std::aligned_alloc(64, (bytes + 63)/64*64);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void HugePages::deallocate(void* p)
+{
+  if (p == nullptr) return;
+
+#ifdef __linux__
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = maps.find(p);
+    if (it != maps.end()) {
+      munmap(p, it->second);
+      maps.erase(it);
+      return;
+    }
+  }
+#endif
+
+  std::free(p);
+}
+
+void HugePages::advise(void* p, std::size_t bytes)
+{
+#if defined(__linux__) and defined(MADV_HUGEPAGE)
+  if (mode == Off or p == nullptr) return;
+
+  std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+  std::uintptr_t b = (a + huge - 1)/huge*huge;
+  std::uintptr_t e = (a + bytes)/huge*huge;
+
+  if (e > b) madvise(reinterpret_cast<void*>(b), e - b, MADV_HUGEPAGE);
+#endif
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cmath>
+
+#include <LegendreTable.H>
+
+// Machine constant for Legendre, as in Basis
+//
+constexpr double MINEPS = 3.0*std::numeric_limits<double>::epsilon();
+
+int LegendreTable::maxNodes = 16384;
+
+LegendreTable::LegendreTable(int lmax, double tol) : lmax(lmax)
+{
+  K = (lmax+1)*(lmax+2)/2;
+
+  off.resize(lmax+2, 0);
+  for (int m=0; m<=lmax; m++) off[m+1] = off[m] + lmax + 1 - m;
+
+  for (N=32*(lmax+1); ; N*=2) {
+
+    h = M_PI/N;
+    tab.resize(3*K*(N+1));
+
+#pragma omp parallel for schedule(static)
+    for (int i=0; i<=N; i++) {
+      double *p = &tab[3*K*i];
+      direct(h*i, p, p+K, p+2*K);
+    }
+
+    err = measure();
+    if (err <= tol or 2*N > maxNodes) break;
+  }
+}
+
+void LegendreTable::direct(double theta, double* p, double* t, double* s) const
+{
+  const double x = cos(theta), sx = sin(theta);
+
+  auto k = [&](int l, int m) { return off[m] + l - m; };
+
+  // Recurrence as in Basis::legendre_R with sin(theta) in place of
+  // sqrt(1 - x^2)
+  //
+  double pll = 1.0, fact = 1.0;
+  p[0] = 1.0;
+  for (int m=1; m<=lmax; m++) {
+    pll *= -fact*sx;
+    p[k(m, m)] = pll;
+    fact += 2.0;
+  }
+
+  for (int m=0; m<lmax; m++) {
+    double pl2 = p[k(m, m)], pl1 = x*(2*m+1)*pl2;
+    p[k(m+1, m)] = pl1;
+    for (int l=m+2; l<=lmax; l++) {
+      pll = (x*(2*l-1)*pl1 - (l+m-1)*pl2)/(l-m);
+      p[k(l, m)] = pll;
+      pl2 = pl1;
+      pl1 = pll;
+    }
+  }
+
+  // d/dtheta P_l^m = [P_l^{m+1} - (l+m)(l-m+1) P_l^{m-1}]/2, which is
+  // regular at the poles; P_l^{-1} = -P_l^1/(l(l+1)).  The same
+  // relation applied to the first derivative gives the second.
+  //
+  auto deriv = [&](const double* f, double* d)
+  {
+    for (int l=0; l<=lmax; l++) {
+      for (int m=0; m<=l; m++) {
+	double up = m<l ? f[k(l, m+1)] : 0.0;
+	if (m==0) d[k(l, 0)] = up;
+	else      d[k(l, m)] = 0.5*(up - (l+m)*(l-m+1)*f[k(l, m-1)]);
+      }
+    }
+  };
+
+  deriv(p, t);
+  deriv(t, s);
+}
+
+LegendreTable::Cell LegendreTable::cell(double x) const
+{
+  x = std::min<double>(std::max<double>(x, -1.0), 1.0);
+
+  double theta = acos(x);
+  int i = std::min<int>(theta/h, N-1);
+  double u = theta/h - i;
+
+  // Cubic Hermite basis
+  //
+  Cell c;
+  c.a   = &tab[3*K*i];
+  c.h00 = (1.0 + 2.0*u)*(1.0 - u)*(1.0 - u);
+  c.h10 = h*u*(1.0 - u)*(1.0 - u);
+  c.h01 = u*u*(3.0 - 2.0*u);
+  c.h11 = h*u*u*(u - 1.0);
+
+  // dP/dx = -dP/dtheta/sin(theta), away from the poles
+  //
+  x = std::min<double>(std::max<double>(x, -1.0 + MINEPS), 1.0 - MINEPS);
+  c.fac = -1.0/sqrt((1.0 - x)*(1.0 + x));
+
+  return c;
+}
+
+void LegendreTable::interp(const Cell& c, int k, int n, double* p,
+			   double* d, double fac) const
+{
+  const double *a = c.a + k, *b = a + 3*K;
+
+#pragma omp simd
+  for (int j=0; j<n; j++)
+    p[j] = c.h00*a[j] + c.h10*a[K+j] + c.h01*b[j] + c.h11*b[K+j];
+
+  if (d) {
+    const double g00 = fac*c.h00, g10 = fac*c.h10;
+    const double g01 = fac*c.h01, g11 = fac*c.h11;
+#pragma omp simd
+    for (int j=0; j<n; j++)
+      d[j] = g00*a[K+j] + g10*a[2*K+j] + g01*b[K+j] + g11*b[2*K+j];
+  }
+}
+
+double LegendreTable::measure() const
+{
+  // Scale of each function and of its derivative
+  //
+  std::vector<double> sp(K, 0.0), st(K, 0.0);
+  for (int i=0; i<=N; i++) {
+    const double *a = &tab[3*K*i];
+    for (int k=0; k<K; k++) {
+      sp[k] = std::max<double>(sp[k], fabs(a[k]));
+      st[k] = std::max<double>(st[k], fabs(a[K+k]));
+    }
+  }
+
+  double worst = 0.0;
+
+#pragma omp parallel
+  {
+    std::vector<double> p(K), t(K), s(K), q(K), d(K);
+    double mine = 0.0;
+
+#pragma omp for schedule(static)
+    for (int i=0; i<N; i++) {
+      double theta = h*(i + 0.5);
+      direct(theta, p.data(), t.data(), s.data());
+      interp(cell(cos(theta)), 0, K, q.data(), d.data(), 1.0);
+      for (int k=0; k<K; k++) {
+	if (sp[k]>0.0) mine = std::max<double>(mine, fabs(q[k] - p[k])/sp[k]);
+	if (st[k]>0.0) mine = std::max<double>(mine, fabs(d[k] - t[k])/st[k]);
+      }
+    }
+
+#pragma omp critical
+    worst = std::max<double>(worst, mine);
+  }
+
+  return worst;
+}
+
+void LegendreTable::eval(double x, Eigen::MatrixXd& p) const
+{
+  Cell c = cell(x);
+
+  // Each m is a contiguous segment of a column of p
+  //
+  for (int m=0; m<=lmax; m++)
+    interp(c, off[m], lmax+1-m, &p(m, m), nullptr, 0.0);
+}
+
+void LegendreTable::eval(double x, Eigen::MatrixXd& p,
+			 Eigen::MatrixXd& dp) const
+{
+  Cell c = cell(x);
+
+  for (int m=0; m<=lmax; m++)
+    interp(c, off[m], lmax+1-m, &p(m, m), &dp(m, m), c.fac);
+}
+
+void LegendreTable::eval(int nb, const double* x, Eigen::MatrixXd& p) const
+{
+  const int L = lmax + 1;
+
+  p.resize(nb, L*L);
+
+  thread_local std::vector<double> q;
+  q.resize(K);
+
+  for (int b=0; b<nb; b++) {
+    interp(cell(x[b]), 0, K, q.data(), nullptr, 0.0);
+    for (int m=0; m<=lmax; m++)
+      for (int l=m; l<=lmax; l++) p(b, l*L+m) = q[off[m]+l-m];
+  }
+}
+
+void LegendreTable::eval(int nb, const double* x,
+			 Eigen::MatrixXd& p, Eigen::MatrixXd& dp) const
+{
+  const int L = lmax + 1;
+
+  p .resize(nb, L*L);
+  dp.resize(nb, L*L);
+
+  thread_local std::vector<double> q, d;
+  q.resize(K);
+  d.resize(K);
+
+  for (int b=0; b<nb; b++) {
+    Cell c = cell(x[b]);
+    interp(c, 0, K, q.data(), d.data(), c.fac);
+    for (int m=0; m<=lmax; m++) {
+      for (int l=m; l<=lmax; l++) {
+	p (b, l*L+m) = q[off[m]+l-m];
+	dp(b, l*L+m) = d[off[m]+l-m];
+      }
+    }
+  }
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+
+#include <LevelList.H>
+
+void LevelList::resize(unsigned nlev)
+{
+  seq.clear();
+  where.clear();
+  gen++;
+  off.assign(std::max<unsigned>(nlev, 1) + 1, 0);
+}
+
+void LevelList::assign(const std::vector<std::vector<int>>& lists)
+{
+  resize(lists.size());
+
+  size_t n = 0;
+  for (auto & v : lists) n += v.size();
+
+  seq.reserve(n);
+  where.reserve(n);
+
+  for (unsigned lev=0; lev<lists.size(); lev++) {
+    off[lev] = seq.size();
+    for (auto indx : lists[lev]) {
+      where[indx] = seq.size();
+      seq.push_back(indx);
+    }
+  }
+  off.back() = seq.size();
+}
+
+void LevelList::exchange(size_t i, size_t j)
+{
+  if (i==j) return;
+  gen++;
+  std::swap(seq[i], seq[j]);
+  where[seq[i]] = i;
+  where[seq[j]] = j;
+}
+
+unsigned LevelList::bucket(size_t p) const
+{
+  // Last level whose start is at or before p; empty levels share
+  // their start with the next level so take the upper bound
+  //
+  return std::upper_bound(off.begin(), off.end()-1, p) - off.begin() - 1;
+}
+
+void LevelList::shift(size_t p, unsigned from, unsigned to)
+{
+  if (from != to) gen++;
+
+  // Upward: swap to the end of the current level and move the
+  // boundary below it
+  //
+  for (unsigned l=from; l<to; l++) {
+    size_t last = off[l+1] - 1;
+    exchange(p, last);
+    p = last;
+    off[l+1]--;
+  }
+
+  // Downward: swap to the start of the current level and move the
+  // boundary above it
+  //
+  for (unsigned l=from; l>to; l--) {
+    size_t first = off[l];
+    exchange(p, first);
+    p = first;
+    off[l]++;
+  }
+}
+
+void LevelList::insert(int indx, unsigned lev)
+{
+  unsigned top = size() - 1;
+  lev = std::min<unsigned>(lev, top);
+
+  where[indx] = seq.size();
+  seq.push_back(indx);
+  off[top+1]++;
+  gen++;
+
+  shift(seq.size()-1, top, lev);
+}
+
+void LevelList::insert(std::vector<Entry>& batch)
+{
+  if (batch.empty()) return;
+
+  const unsigned nlev = size();
+  for (auto & v : batch) v.second = std::min<unsigned>(v.second, nlev-1);
+
+  // LSD radix sort by sequence number, 8 bits per pass, and then a
+  // stable counting sort by level
+  //
+  std::vector<Entry> work(batch.size());
+  for (int shift=0; shift<32; shift+=8) {
+    size_t cnt[257] = {0};
+    for (auto & v : batch) cnt[((static_cast<unsigned>(v.first) >> shift) & 0xff) + 1]++;
+    for (int b=0; b<256; b++) cnt[b+1] += cnt[b];
+    for (auto & v : batch) work[cnt[(static_cast<unsigned>(v.first) >> shift) & 0xff]++] = v;
+    batch.swap(work);
+  }
+
+  std::vector<size_t> num(nlev+1, 0);
+  for (auto & v : batch) num[v.second+1]++;
+  for (unsigned l=0; l<nlev; l++) num[l+1] += num[l];
+  for (auto & v : batch) work[num[v.second]++] = v;
+  batch.swap(work);
+
+  // num[l] is now the number of arrivals at levels up to l, so level
+  // l moves up by num[l-1] and gains num[l] - num[l-1] entries
+  //
+  seq.resize(seq.size() + batch.size());
+  where.reserve(seq.size());
+  gen++;
+
+  const std::vector<size_t> old(off);
+
+  for (int l=nlev-1; l>=0; l--) {
+    size_t delta = l ? num[l-1] : 0;
+    size_t beg = old[l], end = old[l+1], len = end - beg;
+
+    // Move the level up by delta: only its first delta entries need
+    // to go, to the positions just past its old end
+    //
+    if (delta) {
+      size_t m = std::min(delta, len);
+      for (size_t i=0; i<m; i++) {
+	size_t to = delta >= len ? beg + delta + i : end + i;
+	seq[to] = seq[beg + i];
+	where[seq[to]] = to;
+      }
+    }
+
+    // Append the arrivals
+    //
+    size_t p = beg + delta + len;
+    for (size_t i=delta; i<num[l]; i++) {
+      seq[p] = batch[i].first;
+      where[seq[p]] = p;
+      p++;
+    }
+
+    off[l+1] = p;
+    off[l]   = beg + delta;
+  }
+}
+
+bool LevelList::erase(int indx)
+{
+  auto it = where.find(indx);
+  if (it == where.end()) return false;
+
+  unsigned top = size() - 1;
+  shift(it->second, bucket(it->second), top);
+
+  // Now in the top level, which ends the array
+  //
+  exchange(where[indx], seq.size()-1);
+  seq.pop_back();
+  off[top+1]--;
+  gen++;
+  where.erase(indx);
+
+  return true;
+}
+
+bool LevelList::move(int indx, unsigned lev)
+{
+  auto it = where.find(indx);
+  if (it == where.end()) return false;
+
+  lev = std::min<unsigned>(lev, size()-1);
+  shift(it->second, bucket(it->second), lev);
+
+  return true;
+}
+
+int LevelList::level(int indx) const
+{
+  auto it = where.find(indx);
+  if (it == where.end()) return -1;
+  return bucket(it->second);
+}
+
+LevelList::Level LevelList::range(unsigned lo, unsigned hi) const
+{
+  hi = std::min<unsigned>(hi, size()-1);
+  if (lo > hi) return Level(seq.data(), seq.data());
+  return Level(seq.data() + off[lo], seq.data() + off[hi+1]);
+}
+
+void LevelList::sort(const std::function<uint64_t(int)>& key)
+{
+  std::vector<std::pair<uint64_t, int>> work;
+
+  gen++;
+
+  for (unsigned lev=0; lev<size(); lev++) {
+    work.clear();
+    for (size_t p=off[lev]; p<off[lev+1]; p++)
+      work.push_back({key(seq[p]), seq[p]});
+
+    std::sort(work.begin(), work.end());
+
+    size_t p = off[lev];
+    for (auto & v : work) {
+      seq[p] = v.second;
+      where[v.second] = p++;
+    }
+  }
+}
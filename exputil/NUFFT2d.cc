@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include <NUFFT2d.H>
+
+//! Smallest integer >= n whose only prime factors are 2, 3 and 5
+static int smooth_size(int n)
+{
+  for (;; n++) {
+    int m = n;
+    for (int p : {2, 3, 5}) while (m % p == 0) m /= p;
+    if (m==1) return n;
+  }
+}
+
+NUFFT2d::NUFFT2d(int nx, int ny, int nset, double tol) : nset(nset)
+{
+  if (nx<0 or ny<0)
+    throw std::runtime_error("NUFFT2d: wave number limits must be >= 0");
+
+  if (nset<1)
+    throw std::runtime_error("NUFFT2d: need at least one weight set");
+
+  if (tol<=0.0 or tol>=1.0)
+    throw std::runtime_error("NUFFT2d: tolerance must be in (0, 1)");
+
+  nmax[0] = nx;
+  nmax[1] = ny;
+
+  // Same kernel as NUFFT3d: about one digit of accuracy per grid
+  // point of half width on the twofold oversampled grid
+  //
+  nsp = static_cast<int>(std::ceil(-std::log10(tol)));
+  nsp = std::max<int>(2, std::min<int>(maxsp, nsp));
+
+  for (int d=0; d<2; d++) {
+    int M    = 2*nmax[d] + 1;	// Number of modes
+    ngrid[d] = smooth_size(std::max<int>(2*M, 2*nsp));
+
+    double R = static_cast<double>(ngrid[d])/M;
+    tau[d]   = M_PI*nsp/(M*M*R*(R - 0.5));
+
+    deconv[d].resize(M);
+    for (int k=-nmax[d]; k<=nmax[d]; k++)
+      deconv[d][k+nmax[d]] =
+	std::sqrt(M_PI/tau[d])*std::exp(k*k*tau[d])/ngrid[d];
+  }
+
+  gsize = static_cast<size_t>(ngrid[0])*ngrid[1];
+
+  work.resize(gsize*nset);
+
+  auto p = reinterpret_cast<fftw_complex*>(work.data());
+  plan = fftw_plan_many_dft(2, ngrid, nset,
+			    p, 0, nset, 1,
+			    p, 0, nset, 1,
+			    FFTW_FORWARD, FFTW_ESTIMATE);
+}
+
+NUFFT2d::~NUFFT2d()
+{
+  fftw_destroy_plan(plan);
+}
+
+void NUFFT2d::weights(int d, double x, int* indx, double* w) const
+{
+  const int N = ngrid[d];
+
+  // Grid units in the periodic unit interval
+  //
+  double u  = (x - std::floor(x))*N;
+  int    m0 = static_cast<int>(std::floor(u)) - nsp + 1;
+  double h  = 2.0*M_PI/N;
+
+  for (int l=0; l<2*nsp; l++) {
+    int    m = m0 + l;
+    double r = (u - m)*h;
+    w[l]     = std::exp(-r*r/(4.0*tau[d]));
+    indx[l]  = ((m % N) + N) % N;
+  }
+}
+
+void NUFFT2d::reset()
+{
+  std::fill(work.begin(), work.end(), 0.0);
+}
+
+void NUFFT2d::spread(double x, double y, const double* w)
+{
+  const int nw = 2*nsp;
+  int    ix[2*maxsp], iy[2*maxsp];
+  double wx[2*maxsp], wy[2*maxsp];
+
+  weights(0, x, ix, wx);
+  weights(1, y, iy, wy);
+
+  for (int a=0; a<nw; a++) {
+    std::complex<double> *row = &work[static_cast<size_t>(ix[a])*ngrid[1]*nset];
+    for (int b=0; b<nw; b++) {
+      double fxy = wx[a]*wy[b];
+      std::complex<double> *v = row + iy[b]*nset;
+      for (int s=0; s<nset; s++) v[s] += fxy*w[s];
+    }
+  }
+}
+
+void NUFFT2d::transform(std::vector<Eigen::MatrixXcd>& F)
+{
+  fftw_execute(plan);
+
+  // Remove the kernel
+  //
+  F.resize(nset);
+  for (auto & f : F) f.resize(2*nmax[0]+1, 2*nmax[1]+1);
+
+  for (int ix=0; ix<=2*nmax[0]; ix++) {
+    int i = mode(0, ix-nmax[0]);
+    for (int iy=0; iy<=2*nmax[1]; iy++) {
+      int j = mode(1, iy-nmax[1]);
+      double fxy = deconv[0][ix]*deconv[1][iy];
+      const std::complex<double> *v =
+	&work[(static_cast<size_t>(i)*ngrid[1] + j)*nset];
+      for (int s=0; s<nset; s++) F[s](ix, iy) = fxy*v[s];
+    }
+  }
+}
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+#include <NUFFT3d.H>
+
+//! Smallest integer >= n whose only prime factors are 2, 3 and 5
+static int smooth_size(int n)
+{
+  for (;; n++) {
+    int m = n;
+    for (int p : {2, 3, 5}) while (m % p == 0) m /= p;
+    if (m==1) return n;
+  }
+}
+
+NUFFT3d::NUFFT3d(int nx, int ny, int nz, int nthrds, double tol, int nfield) :
+  nthrds(std::max<int>(1, nthrds)), nfield(std::max<int>(0, nfield))
+{
+  if (nx<0 or ny<0 or nz<0)
+    throw std::runtime_error("NUFFT3d: wave number limits must be >= 0");
+
+  if (tol<=0.0 or tol>=1.0)
+    throw std::runtime_error("NUFFT3d: tolerance must be in (0, 1)");
+
+  if (this->nfield > maxfield)
+    throw std::runtime_error("NUFFT3d: too many type-2 fields");
+
+  nmax[0] = nx;
+  nmax[1] = ny;
+  nmax[2] = nz;
+
+  // With a twofold oversampled grid, the truncated Gaussian gains
+  // about one digit of accuracy per grid point of half width
+  //
+  nsp = static_cast<int>(std::ceil(-std::log10(tol)));
+  nsp = std::max<int>(2, std::min<int>(maxsp, nsp));
+
+  for (int d=0; d<3; d++) {
+    int M    = 2*nmax[d] + 1;	// Number of modes
+    ngrid[d] = smooth_size(std::max<int>(2*M, 2*nsp));
+
+    double R = static_cast<double>(ngrid[d])/M;
+    tau[d]   = M_PI*nsp/(M*M*R*(R - 0.5));
+
+    // Inverse Fourier coefficient of the periodic Gaussian,
+    // sqrt(pi/tau) exp(k^2 tau), with the 1/ngrid discretization
+    // factor of the grid quadrature
+    //
+    deconv[d].resize(M);
+    for (int k=-nmax[d]; k<=nmax[d]; k++)
+      deconv[d][k+nmax[d]] =
+	std::sqrt(M_PI/tau[d])*std::exp(k*k*tau[d])/ngrid[d];
+  }
+
+  gsize = static_cast<size_t>(ngrid[0])*ngrid[1]*ngrid[2];
+
+  sgrid.resize(this->nthrds);
+  for (auto & g : sgrid) g.resize(gsize, 0.0);
+
+  work1.resize(gsize);
+
+  plan1 = fftw_plan_dft_3d(ngrid[0], ngrid[1], ngrid[2],
+			   reinterpret_cast<fftw_complex*>(work1.data()),
+			   reinterpret_cast<fftw_complex*>(work1.data()),
+			   FFTW_FORWARD, FFTW_ESTIMATE);
+
+  // Interleaved field pairs for type 2
+  //
+  npair = (this->nfield + 1)/2;
+  plan2 = 0;
+
+  if (npair) {
+    work2.resize(gsize*npair);
+    auto p = reinterpret_cast<fftw_complex*>(work2.data());
+    plan2 = fftw_plan_many_dft(3, ngrid, npair,
+			       p, 0, npair, 1,
+			       p, 0, npair, 1,
+			       FFTW_BACKWARD, FFTW_ESTIMATE);
+  }
+}
+
+NUFFT3d::~NUFFT3d()
+{
+  fftw_destroy_plan(plan1);
+  if (plan2) fftw_destroy_plan(plan2);
+}
+
+void NUFFT3d::weights(int d, double x, int* indx, double* w) const
+{
+  const int N = ngrid[d];
+
+  // Grid units in the periodic unit interval
+  //
+  double u  = (x - std::floor(x))*N;
+  int    m0 = static_cast<int>(std::floor(u)) - nsp + 1;
+  double h  = 2.0*M_PI/N;
+
+  for (int l=0; l<2*nsp; l++) {
+    int    m = m0 + l;
+    double r = (u - m)*h;
+    w[l]     = std::exp(-r*r/(4.0*tau[d]));
+    indx[l]  = ((m % N) + N) % N;
+  }
+}
+
+void NUFFT3d::reset()
+{
+  for (auto & g : sgrid) std::fill(g.begin(), g.end(), 0.0);
+}
+
+void NUFFT3d::spread(int id, double x, double y, double z, double w)
+{
+  const int nw = 2*nsp;
+  int    ix[2*maxsp], iy[2*maxsp], iz[2*maxsp];
+  double wx[2*maxsp], wy[2*maxsp], wz[2*maxsp];
+
+  weights(0, x, ix, wx);
+  weights(1, y, iy, wy);
+  weights(2, z, iz, wz);
+
+  double *g = sgrid[id].data();
+
+  for (int a=0; a<nw; a++) {
+    double fx = w*wx[a];
+    for (int b=0; b<nw; b++) {
+      double fxy = fx*wy[b];
+      double *row = g + cell(ix[a], iy[b], 0);
+      for (int c=0; c<nw; c++) row[iz[c]] += fxy*wz[c];
+    }
+  }
+}
+
+void NUFFT3d::transform(coefType& F)
+{
+  // Sum the thread grids
+  //
+#pragma omp parallel for
+  for (size_t n=0; n<gsize; n++) {
+    double sum = 0.0;
+    for (int t=0; t<nthrds; t++) sum += sgrid[t][n];
+    work1[n] = sum;
+  }
+
+  fftw_execute(plan1);
+
+  // Remove the kernel
+  //
+  F.resize(2*nmax[0]+1, 2*nmax[1]+1, 2*nmax[2]+1);
+
+#pragma omp parallel for
+  for (int ix=0; ix<=2*nmax[0]; ix++) {
+    int i = mode(0, ix-nmax[0]);
+    for (int iy=0; iy<=2*nmax[1]; iy++) {
+      int j = mode(1, iy-nmax[1]);
+      double fxy = deconv[0][ix]*deconv[1][iy];
+      for (int iz=0; iz<=2*nmax[2]; iz++) {
+	int k = mode(2, iz-nmax[2]);
+	F(ix, iy, iz) = fxy*deconv[2][iz]*work1[cell(i, j, k)];
+      }
+    }
+  }
+}
+
+void NUFFT3d::prepare(const std::vector<coefType>& a)
+{
+  if (static_cast<int>(a.size()) != nfield)
+    throw std::runtime_error("NUFFT3d::prepare: wrong number of fields");
+
+  std::fill(work2.begin(), work2.end(), 0.0);
+
+  const std::complex<double> I(0.0, 1.0);
+  const int mx = 2*nmax[0], my = 2*nmax[1], mz = 2*nmax[2];
+
+  // Load the Hermitian part of each field, so that its series is
+  // real, with the second field of each pair in the imaginary part
+  //
+#pragma omp parallel for
+  for (int ix=0; ix<=mx; ix++) {
+    int i = mode(0, ix-nmax[0]);
+    for (int iy=0; iy<=my; iy++) {
+      int j = mode(1, iy-nmax[1]);
+      double fxy = deconv[0][ix]*deconv[1][iy];
+      for (int iz=0; iz<=mz; iz++) {
+	int k = mode(2, iz-nmax[2]);
+	double fac = 0.5*fxy*deconv[2][iz];
+	std::complex<double> *p = &work2[cell(i, j, k)*npair];
+	for (int f=0; f<nfield; f++) {
+	  auto h = fac*(a[f](ix, iy, iz) + std::conj(a[f](mx-ix, my-iy, mz-iz)));
+	  p[f/2] += f % 2 ? I*h : h;
+	}
+      }
+    }
+  }
+
+  fftw_execute(plan2);
+}
+
+void NUFFT3d::interpolate(double x, double y, double z, double* f) const
+{
+  const int nw = 2*nsp;
+  int    ix[2*maxsp], iy[2*maxsp], iz[2*maxsp];
+  double wx[2*maxsp], wy[2*maxsp], wz[2*maxsp];
+
+  weights(0, x, ix, wx);
+  weights(1, y, iy, wy);
+  weights(2, z, iz, wz);
+
+  std::complex<double> sum[(maxfield+1)/2];
+  for (int p=0; p<npair; p++) sum[p] = 0.0;
+
+  for (int a=0; a<nw; a++) {
+    for (int b=0; b<nw; b++) {
+      double fxy = wx[a]*wy[b];
+      const std::complex<double> *row = &work2[cell(ix[a], iy[b], 0)*npair];
+      for (int c=0; c<nw; c++) {
+	const std::complex<double> *v = row + iz[c]*npair;
+	double fac = fxy*wz[c];
+	for (int p=0; p<npair; p++) sum[p] += fac*v[p];
+      }
+    }
+  }
+
+  for (int n=0; n<nfield; n++)
+    f[n] = n % 2 ? sum[n/2].imag() : sum[n/2].real();
+}
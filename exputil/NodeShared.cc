@@ -0,0 +1,199 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <NodeShared.H>
+
+static MPI_Comm node_comm   = MPI_COMM_NULL;
+static MPI_Comm leader_comm = MPI_COMM_NULL;
+static int      node_rank   = 0;
+
+// Split MPI_COMM_WORLD by node and build the leader communicator.
+// The key preserves the world ordering so that world rank 0 is local
+// rank 0 on its node and rank 0 among the leaders.
+//
+static void make_comms()
+{
+  if (node_comm != MPI_COMM_NULL) return;
+
+  int world_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank,
+		      MPI_INFO_NULL, &node_comm);
+  MPI_Comm_rank(node_comm, &node_rank);
+
+  MPI_Comm_split(MPI_COMM_WORLD, node_rank==0 ? 0 : MPI_UNDEFINED,
+		 world_rank, &leader_comm);
+}
+
+MPI_Comm NodeSharedComm::nodeComm()
+{
+  make_comms();
+  return node_comm;
+}
+
+MPI_Comm NodeSharedComm::leaderComm()
+{
+  make_comms();
+  return leader_comm;
+}
+
+bool NodeSharedComm::isLeader()
+{
+  make_comms();
+  return node_rank==0;
+}
+
+bool NodeSharedComm::hierarchical = false;
+
+int NodeSharedComm::allreduce(const void* sendbuf, void* recvbuf, int count,
+			      MPI_Datatype type, MPI_Op op, MPI_Comm comm)
+{
+  if (not hierarchical or comm != MPI_COMM_WORLD)
+    return MPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+
+  // Nothing to gain with one rank per node or a single node
+  //
+  static int nlocal = 0, nworld = 0;
+  if (nlocal==0) {
+    MPI_Comm_size(nodeComm(), &nlocal);
+    MPI_Comm_size(MPI_COMM_WORLD, &nworld);
+  }
+
+  if (nlocal==1 or nlocal==nworld)
+    return MPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+
+  // Reduce onto the leader.  Only the root may pass MPI_IN_PLACE.
+  //
+  int ret;
+  if (isLeader())
+    ret = MPI_Reduce(sendbuf, recvbuf, count, type, op, 0, nodeComm());
+  else
+    ret = MPI_Reduce(sendbuf==MPI_IN_PLACE ? recvbuf : sendbuf, nullptr,
+		     count, type, op, 0, nodeComm());
+  if (ret != MPI_SUCCESS) return ret;
+
+  // Combine the node sums
+  //
+  if (isLeader()) {
+    ret = MPI_Allreduce(MPI_IN_PLACE, recvbuf, count, type, op,
+			leaderComm());
+    if (ret != MPI_SUCCESS) return ret;
+  }
+
+  return MPI_Bcast(recvbuf, count, type, 0, nodeComm());
+}
+
+template<typename T>
+void NodeShared<T>::allocate(size_t n, bool share)
+{
+  release();
+
+  int flag = 0;
+  MPI_Initialized(&flag);
+
+  shared = share and flag;
+  count  = n;
+
+  if (not shared) {
+    local.resize(n);
+    base = local.data();
+    return;
+  }
+
+  // The leader owns the whole segment; the others attach to it
+  //
+  MPI_Aint bytes = isLeader() ? n*sizeof(T) : 0;
+  T *mine;
+
+  MPI_Win_allocate_shared(bytes, sizeof(T), MPI_INFO_NULL,
+			  nodeComm(), &mine, &win);
+
+  MPI_Aint size;
+  int disp;
+  MPI_Win_shared_query(win, 0, &size, &disp, &base);
+
+  if (isLeader()) HugePages::advise(mine, bytes);
+}
+
+template<typename T>
+bool NodeShared<T>::map(const std::string& file, size_t offset, size_t n)
+{
+  release();
+
+  if (offset % alignof(T)) return false;
+
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat sb;
+  if (fstat(fd, &sb) or offset + n*sizeof(T) > size_t(sb.st_size)) {
+    close(fd);
+    return false;
+  }
+
+  // The mapping must start on a page boundary
+  //
+  size_t page  = sysconf(_SC_PAGESIZE);
+  size_t start = offset/page*page;
+
+  mbytes = offset - start + n*sizeof(T);
+  mbase  = mmap(nullptr, mbytes, PROT_READ, MAP_SHARED, fd, start);
+  close(fd);
+
+  if (mbase == MAP_FAILED) {
+    mbase  = nullptr;
+    mbytes = 0;
+    return false;
+  }
+
+  base  = reinterpret_cast<T*>(static_cast<char*>(mbase) + offset - start);
+
+  // Honored for file pages only by kernels with read-only THP for
+  // file systems
+  //
+  HugePages::advise(mbase, mbytes);
+  count = n;
+
+  return true;
+}
+
+template<typename T>
+void NodeShared<T>::release()
+{
+  if (mbase) {
+    munmap(mbase, mbytes);
+    mbase  = nullptr;
+    mbytes = 0;
+  }
+
+  if (win != MPI_WIN_NULL) {
+    int done = 0;
+    MPI_Finalized(&done);
+    if (not done) MPI_Win_free(&win);
+    win = MPI_WIN_NULL;
+  }
+
+  local.clear();
+  local.shrink_to_fit();
+  base   = nullptr;
+  count  = 0;
+  shared = false;
+}
+
+template<typename T>
+void NodeShared<T>::sync()
+{
+  if (not shared) return;
+
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+  MPI_Win_sync(win);
+  MPI_Barrier(nodeComm());
+  MPI_Win_sync(win);
+  MPI_Win_unlock_all(win);
+}
+
+template class NodeShared<double>;
+template class NodeShared<float>;
@@ -68,30 +68,51 @@ Eigen::VectorXd OrthoFunction::poly_eval(double t, int n)
   return ret;
 }
 
-Eigen::MatrixXd OrthoFunction::testOrtho()
+void OrthoFunction::recursion(const double* y, int n,
+			      Eigen::Ref<Eigen::MatrixXd> p)
 {
-  Eigen::MatrixXd ret(nmax+1, nmax+1);
-  ret.setZero();
+  double* p0 = &p(0, 0);
+#pragma omp simd
+  for (int i=0; i<n; i++) p0[i] = 1.0;
+
+  if (nmax) {
+    double* p1 = &p(0, 1);
+    const double a = alph[0];
+#pragma omp simd
+    for (int i=0; i<n; i++) p1[i] = y[i] - a;
+
+    for (int j=1; j<nmax; j++) {
+      const double* pm = &p(0, j-1);
+      const double* pc = &p(0, j  );
+      double*       pn = &p(0, j+1);
+      const double a = alph[j], b = beta[j];
+#pragma omp simd
+      for (int i=0; i<n; i++) pn[i] = (y[i] - a)*pc[i] - b*pm[i];
+    }
+  }
+}
 
+Eigen::MatrixXd OrthoFunction::testOrtho()
+{
+  // Abscissae, weights and weight function at the knots
+  Eigen::VectorXd y(knots), f(knots), w(knots);
   for (int i=0; i<knots; i++) {
-    // Get abscissa and weight
     double x = xmin + dx*lq->knot(i);
     double r = x_to_r(x);
-    double f = dx*lq->weight(i)*d_r_to_x(x)*pow(r, dof-1);
-    double y = 2.0*r/scale; if (segment) y = x;
+    f[i] = dx*lq->weight(i)*d_r_to_x(x)*pow(r, dof-1);
+    y[i] = 2.0*r/scale; if (segment) y[i] = x;
+    w[i] = W(r);
+  }
 
-    // Evaluate polynomial
-    Eigen::VectorXd p = poly_eval(y, nmax) * W(r);
+  // Evaluate the polynomials at all knots at once
+  Eigen::MatrixXd p(knots, nmax+1);
+  recursion(y.data(), knots, p);
 
-    // Compute scalar products
-    for (int n1=0; n1<=nmax; n1++) {
-      for (int n2=0; n2<=nmax; n2++) {
-	ret(n1, n2) += f * p(n1) * p(n2) / sqrt(norm[n1]*norm[n2]);
-      }
-    }
-  }
+  // Scalar products by quadrature
+  for (int j=0; j<=nmax; j++)
+    p.col(j).array() *= w.array()*f.array().sqrt()/sqrt(norm[j]);
 
-  return ret;
+  return p.transpose()*p;
 }
 
 void OrthoFunction::dumpOrtho(const std::string& filename)
@@ -121,6 +142,20 @@ void OrthoFunction::dumpOrtho(const std::string& filename)
 }
 
 Eigen::VectorXd OrthoFunction::operator()(double r)
+{
+  Eigen::VectorXd p(nmax+1);
+  eval(r, p);
+  return p;
+}
+
+Eigen::MatrixXd OrthoFunction::operator()(const Eigen::VectorXd& r)
+{
+  Eigen::MatrixXd p(r.size(), nmax+1);
+  eval(r.data(), r.size(), p);
+  return p;
+}
+
+void OrthoFunction::eval(double r, Eigen::Ref<Eigen::VectorXd> p)
 {
   // Enforce bounds
   r = std::max<double>(rmin, std::min<double>(rmax, r));
@@ -133,8 +168,40 @@ Eigen::VectorXd OrthoFunction::operator()(double r)
   if (segment) y = r_to_x(r);
 
   // Generate normalized orthogonal functions
-  auto p = poly_eval(y, nmax);
-  for (int i=0; i<=nmax; i++) p(i) *= w/sqrt(norm[i]);
+  p[0] = 1.0;
+  if (nmax) {
+    p[1] = y - alph[0];
+    for (int j=1; j<nmax; j++)
+      p[j+1] = (y - alph[j])*p[j] - beta[j]*p[j-1];
+  }
 
-  return p;
+  for (int j=0; j<=nmax; j++) p[j] *= w/sqrt(norm[j]);
+}
+
+void OrthoFunction::eval(const double* r, int n, Eigen::Ref<Eigen::MatrixXd> p)
+{
+  constexpr int block = 64;
+  double y[block], w[block];
+
+  for (int b=0; b<n; b+=block) {
+    int nb = std::min<int>(block, n - b);
+
+    // Weight and system for each radius, with bounds enforced
+    for (int i=0; i<nb; i++) {
+      double rr = std::max<double>(rmin, std::min<double>(rmax, r[b+i]));
+      w[i] = W(rr);
+      y[i] = segment ? r_to_x(rr) : 2.0*rr/scale;
+    }
+
+    // Three-term recursion for the block
+    recursion(y, nb, p.middleRows(b, nb));
+
+    // Normalize
+    for (int j=0; j<=nmax; j++) {
+      double* pj = &p(b, j);
+      const double fac = 1.0/sqrt(norm[j]);
+#pragma omp simd
+      for (int i=0; i<nb; i++) pj[i] *= w[i]*fac;
+    }
+  }
 }
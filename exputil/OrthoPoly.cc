@@ -25,6 +25,7 @@ Eigen::VectorXd OrthoPoly::fv(const double x, const int n)
   Eigen::VectorXd t(n+1);
 
   t[0] = f0(x);
+  if (n==0) return t;
   t[1] = f1(x);
 
   double g2;
@@ -44,3 +45,24 @@ Eigen::VectorXd OrthoPoly::fv(const double x, const int n)
   return t;
 }
 
+
+void OrthoPoly::fv(const double* x, const int np, const int n,
+		   Eigen::Ref<Eigen::MatrixXd> t)
+{
+  for (int i=0; i<np; i++) t(i, 0) = f0(x[i]);
+  if (n==0) return;
+  for (int i=0; i<np; i++) t(i, 1) = f1(x[i]);
+
+  for (int nn=2; nn<=n; nn++) {
+    const double c1 = coef1(nn-1), c2 = coef2(nn-1);
+    const double c3 = coef3(nn-1), c4 = coef4(nn-1);
+
+    const double* g2 = &t(0, nn-2);
+    const double* g1 = &t(0, nn-1);
+    double*       g0 = &t(0, nn  );
+
+#pragma omp simd
+    for (int i=0; i<np; i++)
+      g0[i] = ( (c2 + c3*x[i])*g1[i] - c4*g2[i] )/c1;
+  }
+}
@@ -3,6 +3,7 @@
 #include <iomanip>
 #include <sstream>
 #include <cstring>
+#include <charconv>
 
 // Needed from EXP/src . . .
 typedef std::pair<unsigned short, unsigned short> speciesKey;
@@ -466,6 +467,53 @@ int Particle::writeBinaryMPI(char *buf, unsigned rsize, bool indexing)
 }
 
 
+int Particle::readBinaryMPI(const char *buf, unsigned rsize, bool indexing,
+			    int seq)
+{
+  // Pointer offset
+  int p = 0;
+
+  // Read a floating value of the record size
+  auto next = [&]() -> double
+  {
+    double v;
+    if (rsize == sizeof(float)) {
+      float tf;
+      memcpy (&tf, buf+p, rsize);
+      v = tf;
+    }
+    else {
+      memcpy (&v, buf+p, rsize);
+    }
+    p += rsize;
+    return v;
+  };
+
+  if (indexing) {		// Index value if this field is recorded
+    memcpy (&indx, buf+p, sizeof(unsigned long));
+    p += sizeof(unsigned long);
+  }
+  else
+    indx = seq;
+
+  mass = next();
+  for (int i=0; i<3; i++) pos[i] = next();
+  for (int i=0; i<3; i++) vel[i] = next();
+  pot    = next();
+  potext = 0.0;
+
+  level = multistep;
+
+  if (iattrib.size()) {
+    memcpy (&iattrib[0], buf+p, sizeof(int)*iattrib.size());
+    p += sizeof(int)*iattrib.size();
+  }
+
+  for (auto& jt : dattrib) jt = next();
+
+  return p;
+}
+
 void Particle::readAscii(bool indexing, int seq, std::istream* fin)
 {
   //
@@ -504,25 +552,51 @@ void Particle::readAscii(bool indexing, int seq, std::istream* fin)
   }
 }
 
-void Particle::writeAscii(bool indexing, bool accel, std::ostream* out)
+namespace
 {
-  if (indexing) *out << std::setw(12) << indx;
-  *out << std::setw(18) << mass;
-  for (int i=0; i<3; i++) *out << std::setw(18) << pos[i];
-  for (int i=0; i<3; i++) *out << std::setw(18) << vel[i];
+  //! Append a value right aligned in a field of the given width in
+  //! the default stream format (%g with precision 6 for reals)
+  template<typename T>
+  void appendField(std::string& buf, T value, int width)
+  {
+    char tmp[32];
+    std::to_chars_result res;
+    if constexpr (std::is_floating_point_v<T>)
+      res = std::to_chars(tmp, tmp+sizeof(tmp), value,
+			  std::chars_format::general, 6);
+    else
+      res = std::to_chars(tmp, tmp+sizeof(tmp), value);
+
+    int len = res.ptr - tmp;
+    if (len < width) buf.append(width - len, ' ');
+    buf.append(tmp, len);
+  }
+}
+
+void Particle::formatAscii(bool indexing, bool accel, std::string& buf) const
+{
+  if (indexing) appendField(buf, indx, 12);
+  appendField(buf, mass, 18);
+  for (int i=0; i<3; i++) appendField(buf, pos[i], 18);
+  for (int i=0; i<3; i++) appendField(buf, vel[i], 18);
   if (accel)
-    for (int i=0; i<3; i++) *out << std::setw(18) << acc[i];
-    
-  *out << std::setw(18) << pot;
-  *out << std::setw(18) << potext;
+    for (int i=0; i<3; i++) appendField(buf, acc[i], 18);
 
-  for (auto it : iattrib)
-    *out << std::setw(10) << it;
+  appendField(buf, pot,    18);
+  appendField(buf, potext, 18);
 
-  for (auto jt : dattrib)
-    *out << std::setw(18) << jt;
-  
-  *out << std::endl;
+  for (auto it : iattrib) appendField(buf, it, 10);
+
+  for (auto jt : dattrib) appendField(buf, jt, 18);
+
+  buf.push_back('\n');
+}
+
+void Particle::writeAscii(bool indexing, bool accel, std::ostream* out)
+{
+  std::string buf;
+  formatAscii(indexing, accel, buf);
+  *out << buf << std::flush;
 }
 
 // For debugging . . . 
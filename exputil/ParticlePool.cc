@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstddef>
+
+#include <ParticlePool.H>
+
+size_t ParticlePool::default_slab = 4096;
+
+ParticlePool::ParticlePool(size_t slabsize) : slabsize(slabsize)
+{
+  if (this->slabsize==0) this->slabsize = default_slab;
+  cbsize = 0;
+  inuse  = 0;
+}
+
+void ParticlePool::addSlab()
+{
+  slabs.push_back(std::unique_ptr<Particle[]>(new Particle [slabsize]));
+  Particle *p = slabs.back().get();
+
+  // Hand out the lowest addresses first
+  //
+  freelist.reserve(freelist.size() + slabsize);
+  for (size_t n=slabsize; n>0; n--) freelist.push_back(p + n - 1);
+}
+
+PartPtr ParticlePool::Get(unsigned niattrib, unsigned ndattrib)
+{
+  Particle *p;
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (freelist.empty()) addSlab();
+    p = freelist.back();
+    freelist.pop_back();
+    inuse++;
+  }
+
+  // Reinitialize the recycled slot.  The assignments reuse the
+  // attribute vector capacity from the previous occupant.
+  //
+  p->mass = p->pot = p->potext = 0.0;
+  for (int k=0; k<3; k++) p->pos[k] = p->vel[k] = p->acc[k] = 0.0;
+  p->level  = 0;
+  p->dtreq  = -1;
+  p->scale  = -1;
+  p->effort = Particle::effort_default;
+  p->indx   = 0;
+  p->tree   = 0u;
+  p->key    = 0u;
+  p->skey   = Particle::defaultKey;
+  p->iattrib.assign(niattrib, 0);
+  p->dattrib.assign(ndattrib, 0.0);
+
+  auto self = shared_from_this();
+  return PartPtr(p, Deleter{self}, BlockAllocator<Particle>(self));
+}
+
+void ParticlePool::release(Particle* p)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  freelist.push_back(p);
+  inuse--;
+}
+
+void* ParticlePool::getBlock(size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(lock);
+
+  // The pool recycles blocks of the first size requested, which is
+  // the control block size for PartPtr.  Any other size goes to the
+  // global allocator.
+  //
+  const size_t align = alignof(std::max_align_t);
+  size_t want = (bytes + align - 1)/align*align;
+
+  if (cbsize==0) cbsize = want;
+
+  if (want != cbsize) return ::operator new(bytes);
+
+  if (cbfree.empty()) {
+    cbslabs.push_back(std::unique_ptr<char[]>(new char [cbsize*slabsize]));
+    char *c = cbslabs.back().get();
+    cbfree.reserve(cbfree.size() + slabsize);
+    for (size_t n=slabsize; n>0; n--) cbfree.push_back(c + cbsize*(n-1));
+  }
+
+  void *ret = cbfree.back();
+  cbfree.pop_back();
+  return ret;
+}
+
+void ParticlePool::putBlock(void* p, size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(lock);
+
+  const size_t align = alignof(std::max_align_t);
+  size_t want = (bytes + align - 1)/align*align;
+
+  if (want != cbsize) ::operator delete(p);
+  else                cbfree.push_back(p);
+}
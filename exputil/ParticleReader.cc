@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -6,6 +7,7 @@
 #include <memory>
 #include <numeric>
 #include <string>
+#include <tuple>
 #include <vector>
 
 
@@ -14,15 +16,53 @@
 #include <mpi.h>		// MPI support
 
 #include <H5Cpp.h>		// HDF5 C++ support
+#include <hdf5_hl.h>		// HDF5 file images
+#include <highfive/highfive.hpp>
 
 #include <ParticleReader.H>
 #include <EXPException.H>
+#include <MappedFile.H>
 #include <P2Quantile.H>
 #include <gadget.H>
 #include <Sutils.H>		// For string trimming
 
 namespace PR {
 
+  //! Bodies per read into the staging buffers of the Gadget readers
+  static constexpr unsigned long slabRows = 1048576;
+
+  void ParticleBlock::resize(size_t n, unsigned f)
+  {
+    size   = n;
+    loaded = f;
+    mass.resize(f & FieldMass     ? n   : 0);
+    pos .resize(f & FieldPosition ? 3*n : 0);
+    vel .resize(f & FieldVelocity ? 3*n : 0);
+    indx.resize(f & FieldIndex    ? n   : 0);
+  }
+
+  ParticleChunk ParticleBlock::view(size_t first, size_t n) const
+  {
+    ParticleChunk ret;
+    ret.size = n;
+    if (mass.size()) ret.mass = &mass[first];
+    if (pos .size()) ret.pos  = &pos [3*first];
+    if (vel .size()) ret.vel  = &vel [3*first];
+    if (indx.size()) ret.indx = &indx[first];
+    return ret;
+  }
+
+  void ParticleBlock::unpack(size_t n, Particle& P) const
+  {
+    P.mass  = mass.size() ? mass[n] : 0.0;
+    P.indx  = indx.size() ? indx[n] : 0;
+    P.level = 0;
+    for (int k=0; k<3; k++) {
+      P.pos[k] = pos.size() ? pos[3*n+k] : 0.0;
+      P.vel[k] = vel.size() ? vel[3*n+k] : 0.0;
+    }
+  }
+
   std::vector<std::string> GadgetNative::Ptypes
   {"Gas", "Halo", "Disk", "Bulge", "Stars", "Bndry"};
   
@@ -37,16 +77,15 @@ namespace PR {
     
     ptype = 1;			// Default is halo particles
 
+    if (_files.empty()) {
+      std::cerr << "GadgetNative: no files found" << std::endl;
+    }
+
     getNumbers();		// Get the number of particles in all
 				// files
 
-    totalCount = 0;		// Initialization of particles read
-
-    curfile = _files.begin();	// Set file to first one
-
-    if (not nextFile()) {	// Try opening
-      std::cerr << "GadgetNative: no files found" << std::endl;
-    }
+    totalCount = nptot[ptype];	// The files are read on first use
+    curfile    = _files.begin();
   }
 
 
@@ -80,7 +119,7 @@ namespace PR {
       time = header.time;
 
       for (int n=0; n<6; n++) {
-	nptot[n] += npart[n];
+	nptot[n] += header.npart[n];
 	if (header.npart[n] > 0) pfound.insert(Ptypes[n]);
       }
     }
@@ -98,16 +137,68 @@ namespace PR {
     return true;
   }
 
+  //! Read the items [lo, hi) of one type from a Gadget block of total
+  //! dim-vectors of T that begins with skip items of the preceding
+  //! types, converting to U in slabs.  A null out skips the block
+  //! without reading it.  The block sizes are computed from the
+  //! header since the 32-bit block markers overflow for large files.
+  template<typename T, typename U>
+  static void readGadgetBlock(std::istream& file, const char* name,
+			      unsigned long total, unsigned long skip,
+			      unsigned long lo, unsigned long hi,
+			      int dim, U* out)
+  {
+    int blk1, blk2;
+    file.read((char*)&blk1, sizeof(int)); // block count
+
+    const std::streamoff item = dim*sizeof(T);
+
+    if (out) {
+      file.seekg((skip + lo)*item, std::ios::cur);
+      std::vector<T> buf;
+      for (unsigned long n=lo; n<hi; n+=slabRows) {
+	unsigned long m = std::min<unsigned long>(slabRows, hi - n);
+	buf.resize(m*dim);
+	file.read((char*)buf.data(), m*item);
+	std::copy(buf.begin(), buf.end(), out + (n - lo)*dim);
+      }
+      file.seekg((total - skip - hi)*item, std::ios::cur);
+    } else {
+      file.seekg(total*item, std::ios::cur);
+    }
+
+    file.read((char*)&blk2, sizeof(int)); // block count
+    if (blk1 != blk2) {
+      std::cout << "GadgetNative " << name << " block read: "
+		<< "blk1=" << blk1 << " != blk2=" << blk2
+		<< std::endl;
+    }
+  }
+
   void GadgetNative::read_and_load()
   {
-    // attempt to open file
+    // attempt to open file, or take it from the prefetcher
     //
-    std::ifstream file(*curfile, std::ios::binary | std::ios::in);
-    if (!file.is_open()) {
-      std::ostringstream ost;
-      ost << "Error opening file: " << *curfile;
-      throw GenericError(ost.str(), __FILE__, __LINE__, 1041, true);
+    std::shared_ptr<std::istream> fin;
+
+    if (fetch) {
+      try {
+	fin = std::make_shared<MemStream>(fetch->get(curfile - _files.begin()));
+      }
+      catch (std::runtime_error& e) {
+	throw GenericError(e.what(), __FILE__, __LINE__, 1041, true);
+      }
+    } else {
+      auto f = std::make_shared<std::ifstream>(*curfile, std::ios::binary | std::ios::in);
+      if (!f->is_open()) {
+	std::ostringstream ost;
+	ost << "Error opening file: " << *curfile;
+	throw GenericError(ost.str(), __FILE__, __LINE__, 1041, true);
+      }
+      fin = f;
     }
+
+    std::istream& file = *fin;
     
     if (myid==0 and _verbose)
       std::cout << "GadgetNative: opened <" << *curfile << ">" << std::endl;
@@ -130,166 +221,104 @@ namespace PR {
     
     time = header.time;
 
-    // Total number of particles in this stanza.  Note: this needs to be
-    // generalized for reading multiple Gadget native files per snap
-    //
-    totalCount = header.npart[ptype];
-    
-    particles.clear();		// Should be empty, but enforce that
-    
-    Particle P;			// Temporary for packing array
-    
-    // Read positions
+    // This process reads the contiguous share [lo, hi) of its type.
+    // Each block holds all types in order.
     //
-    file.read((char*)&blk1, sizeof(int)); // block count
-    
-    float temp[3];		// Pos/vel temporary
-    
-    for (int k=0; k<6; k++) {
-      if ( k == ptype ) {
-	for (int n=0; n<header.npart[k]; n++) {
-	  file.read((char*)temp, 3*sizeof(float));
-	  if (n % numprocs == myid) {
-	    P.pos[0] = temp[0];
-	    P.pos[1] = temp[1];
-	    P.pos[2] = temp[2];
-	    P.level  = 0;		// Assign level 0 to all particles
-	    particles.push_back(P);
-	  }
-	}
-      }
-      else {
-	file.seekg(header.npart[k]*3*sizeof(float), std::ios::cur);
-      }
-    }
-    
-    file.read((char*)&blk2, sizeof(int)); // block count
-    if (blk1 != blk2) {
-      std::cout << "GadgetNative position block read: "
-		<< "blk1=" << blk1 << " != blk2=" << blk2
-		<< std::endl;
-    }
+    auto range = share(header.npart[ptype]);
+    unsigned long lo = range.first, hi = range.second;
 
-    file.read((char*)&blk1, sizeof(int)); // block count
-    
-    // Read velocities
-    //
+    unsigned long total = 0, skip = 0, mtotal = 0, mskip = 0;
     for (int k=0; k<6; k++) {
-      if ( k == ptype ) {
-	int pc = 0;
-	for (int n=0; n<header.npart[k]; n++) {
-	  file.read((char*)temp, 3*sizeof(float));
-	  if (n % numprocs == myid) {
-	    particles[pc].vel[0] = temp[0];
-	    particles[pc].vel[1] = temp[1];
-	    particles[pc].vel[2] = temp[2];
-	    pc++;
-	  }
-	}
-      }
-      else {
-	file.seekg(header.npart[k]*3*sizeof(float), std::ios::cur);
+      total += header.npart[k];
+      if (k < ptype) skip += header.npart[k];
+      if (header.npart[k]>0 and header.mass[k]==0) {
+	mtotal += header.npart[k];
+	if (k < ptype) mskip += header.npart[k];
       }
-      
-    }
-    
-    file.read((char*)&blk2, sizeof(int)); // block count
-    if (blk1 != blk2) {
-      std::cout << "GadgetNative velocity block read: "
-		<< "blk1=" << blk1 << " != blk2=" << blk2
-		<< std::endl;
     }
 
-    file.read((char*)&blk1, sizeof(int));
-    
-    // Read particle ID
+    // Only the fields requested by the caller are read; the other
+    // blocks are skipped.  Masses from the header count as read.
     //
-    for (int k=0; k<6; k++) {
-      if ( k == ptype ) {
-	int pc = 0;
-	for (int n=0; n<header.npart[k]; n++) {
-	  int temp;
-	  file.read((char*)&temp, sizeof(int));
-	  if (n % numprocs == myid) {
-	    particles[pc].indx = temp;
-	    pc++;
-	  }
-	}
-      }
-      else {
-	file.seekg(header.npart[k]*sizeof(int), std::ios::cur);
-      }
-    }
-    
-    file.read((char*)&blk2, sizeof(int)); // block count
-    if (blk1 != blk2) {
-      std::cout << "GadgetNative id block read: "
-		<< "blk1=" << blk1 << " != blk2=" << blk2
-		<< std::endl;
-    }
+    block.resize(hi - lo, fields);
 
-    // Do we need to read mass stanza?
-    bool with_mass = false;
-    for (int k=0; k<6; k++) {
-      if (header.npart[k]>0 and header.mass[k] ==0) with_mass = true;
-    }
+    auto dest = [this](unsigned f, auto& v)
+    { return (fields & f) ? v.data() : nullptr; };
 
-    if (with_mass) {
-      // file.seekg(sizeof(int), std::ios::cur); // block count
-      file.read((char*)&blk1, sizeof(int));
-    }
-    
-    for (int k=0; k<6; k++) {
-      if ( k == ptype) {
-	int pc = 0;
-	for (int n=0; n<header.npart[k]; n++) {
-	  if (n % numprocs == myid) {
-	    if (header.mass[k]==0) {
-	      file.read((char*)temp, sizeof(float));
-	      particles[pc].mass = temp[0];
-	    }
-	    else
-	      particles[pc].mass = header.mass[k];
-	    pc++;
-	  }
-	}
-      }
-      else {
-	if (header.mass[k]==0)
-	  file.seekg(header.npart[k]*sizeof(float), std::ios::cur);
-      }
-    }
-    
-    if (with_mass) {
-      file.read((char*)&blk2, sizeof(int)); // block count
-      if (blk1 != blk2) {
-	std::cout << "GadgetNative id block read: "
-		  << "blk1=" << blk1 << " != blk2=" << blk2
-		  << std::endl;
-      }
+    readGadgetBlock<float>(file, "position", total, skip, lo, hi, 3,
+			   dest(FieldPosition, block.pos));
+
+    readGadgetBlock<float>(file, "velocity", total, skip, lo, hi, 3,
+			   dest(FieldVelocity, block.vel));
+
+    readGadgetBlock<int>(file, "id", total, skip, lo, hi, 1,
+			 dest(FieldIndex, block.indx));
+
+    if (fields & FieldMass) {
+      if (header.mass[ptype]==0)
+	readGadgetBlock<float>(file, "mass", mtotal, mskip, lo, hi, 1,
+			       block.mass.data());
+      else
+	std::fill(block.mass.begin(), block.mass.end(), header.mass[ptype]);
     }
     
     // Add other fields, as necessary. Acceleration?
     
-    file.close();
     if (myid==0 and _verbose) std::cout << "done." << std::endl;
   }
+
+  void GadgetNative::restart()
+  {
+    pcount = 0;
+
+    // A single file already in memory with the requested fields
+    //
+    if (not stale and _files.size()==1 and (fields & ~block.loaded)==0)
+      return;
+
+    stale   = false;
+    block.resize(0, 0);
+    curfile = _files.begin();
+    fetch   = startPrefetch(_files);
+  }
+
+  ParticleChunk GadgetNative::view(size_t maxn)
+  {
+    // This process' share of a file may be empty
+    //
+    while (pcount >= block.size) {
+      if (not nextFile()) return ParticleChunk();
+      pcount = 0;
+    }
+
+    auto ret = block.view(pcount, std::min<size_t>(maxn, block.size - pcount));
+    pcount += ret.size;
+    return ret;
+  }
+
+  ParticleChunk GadgetNative::firstChunk(size_t maxn)
+  {
+    restart();
+    return view(maxn);
+  }
+
+  ParticleChunk GadgetNative::nextChunk(size_t maxn)
+  {
+    return view(maxn);
+  }
   
   const Particle* GadgetNative::firstParticle()
   {
-    pcount = 0;
-    
-    return &particles[pcount++];
+    restart();
+    return nextParticle();
   }
   
   const Particle* GadgetNative::nextParticle()
   {
-    if (pcount < particles.size()) {
-      return &particles[pcount++];
-    } else {
-      if (nextFile()) return firstParticle();
-      return 0;
-    }
+    auto c = view(1);
+    if (c.size==0) return 0;
+    block.unpack(pcount-1, P);
+    return &P;
   }
   
   
@@ -307,14 +336,14 @@ namespace PR {
     
     ptype = 1;			// Default is halo particles
 
-    totalCount = 0;		// Initialization of particles read
+    if (_files.empty()) {
+      std::cerr << "GadgetHDF5: no files found" << std::endl;
+    }
 
     getNumbers();
-    curfile = _files.begin();
 
-    if (not nextFile()) {
-      std::cerr << "GadgetNative: no files found" << std::endl;
-    }
+    totalCount = nptot[ptype];	// The files are read on first use
+    curfile    = _files.begin();
   }
 
   void GadgetHDF5::getNumbers()
@@ -403,6 +432,51 @@ namespace PR {
   }
 
 
+  //! Select the rows [lo, hi) of a file dataspace and return the
+  //! matching memory dataspace
+  static H5::DataSpace selectRows(H5::DataSpace& fspace, hsize_t lo, hsize_t hi)
+  {
+    int rank = fspace.getSimpleExtentNdims();
+    std::vector<hsize_t> count(rank), offset(rank, 0);
+    fspace.getSimpleExtentDims(count.data(), NULL);
+
+    offset[0] = lo;
+    count[0]  = hi - lo;
+    
+    H5::DataSpace mspace(rank, count.data());
+    if (hi > lo) {
+      fspace.selectHyperslab(H5S_SELECT_SET, count.data(), offset.data());
+    } else {
+      fspace.selectNone();
+      mspace.selectNone();
+    }
+    
+    return mspace;
+  }
+
+  //! Read the rows [lo, hi) of a dataset of scalars or vectors in
+  //! hyperslabs of at most slabRows rows through a staging buffer of
+  //! type T, converting to U
+  template<typename T, typename U>
+  static void readRows(H5::DataSet& dataset, const H5::PredType& type,
+		       hsize_t lo, hsize_t hi, U* out)
+  {
+    H5::DataSpace fspace = dataset.getSpace();
+
+    hsize_t dims[2] = {0, 1};
+    fspace.getSimpleExtentDims(dims, NULL);
+    const hsize_t dim = fspace.getSimpleExtentNdims() > 1 ? dims[1] : 1;
+
+    std::vector<T> buf;
+    for (hsize_t n=lo; n<hi; n+=slabRows) {
+      hsize_t m = std::min<hsize_t>(slabRows, hi - n);
+      H5::DataSpace mspace = selectRows(fspace, n, n + m);
+      buf.resize(m*dim);
+      dataset.read(buf.data(), type, mspace, fspace);
+      std::copy(buf.begin(), buf.end(), out + (n - lo)*dim);
+    }
+  }
+
   void GadgetHDF5::read_and_load()
   {
     // Try to catch and HDF5 and parsing errors
@@ -414,8 +488,39 @@ namespace PR {
       
       const H5std_string FILE_NAME (*curfile);
       const H5std_string GROUP_NAME_what ("/Header");
-      
-      H5::H5File    file( FILE_NAME, H5F_ACC_RDONLY );
+
+      // A prefetched file is opened as an in-memory image that
+      // must outlive the file object
+      //
+      FilePrefetch::Buffer image;
+      std::unique_ptr<H5::H5File> fptr;
+
+      if (fetch) {
+	try {
+	  image = fetch->get(curfile - _files.begin());
+	}
+	catch (std::runtime_error& e) {
+	  throw GenericError(e.what(), __FILE__, __LINE__, 1041, true);
+	}
+
+	hid_t fid = H5LTopen_file_image(image->data(), image->size(),
+					H5LT_FILE_IMAGE_DONT_COPY |
+					H5LT_FILE_IMAGE_DONT_RELEASE);
+	if (fid < 0) {
+	  std::ostringstream ost;
+	  ost << "Error opening HDF5 file image: " << *curfile;
+	  throw GenericError(ost.str(), __FILE__, __LINE__, 1041, true);
+	}
+
+	// Leave the file object with the only reference
+	//
+	fptr = std::make_unique<H5::H5File>(fid);
+	if (H5Iget_ref(fid) > 1) H5Idec_ref(fid);
+      } else {
+	fptr = std::make_unique<H5::H5File>( FILE_NAME, H5F_ACC_RDONLY );
+      }
+
+      H5::H5File& file = *fptr;
       // H5::Group     what(file.openGroup( GROUP_NAME_what ));
       H5::Group     what = file.openGroup( GROUP_NAME_what );
       
@@ -443,151 +548,77 @@ namespace PR {
 	attr.read(type, npart);
       }
       
+      // This process reads the rows [lo, hi) of every dataset that
+      // holds a requested field.  Masses from the header count as
+      // read.
+      //
+      auto range = share(npart[ptype]);
+      hsize_t lo = range.first, hi = range.second;
+
+      block.resize(hi - lo, fields);
+
       if (npart[ptype]>0) {
 	std::ostringstream sout;
 	sout << "PartType" << ptype;
 	
-	totalCount = npart[ptype];
-
 	std::string grpnam = "/" + sout.str();
-	// H5::Group grp(file.openGroup(grpnam));
 	H5::Group grp = file.openGroup(grpnam);
-	H5::DataSet dataset = grp.openDataSet("Coordinates");
-	H5::DataSpace dataspace = dataset.getSpace();
-	
-	// Get the number of dimensions in the dataspace.
-	//
-	int rank = dataspace.getSimpleExtentNdims();
-	
-	// Get the dimension size of each dimension in the dataspace and
-	// display them.
-	//
-	hsize_t dims[2];
-	int ndims = dataspace.getSimpleExtentDims( dims, NULL);
-	if (myid==0 and _verbose)
-	  std::cout << "GadgetHDF5: coordinate rank " << rank
-		    << ", dimensions " <<
-	    (unsigned long)(dims[0]) << " x " <<
-	    (unsigned long)(dims[1]) << std::endl;
-	
-	// Define the memory space to read dataset.
-	//
-	H5::DataSpace mspace(rank, dims);
-	
-	std::vector<float> buf(dims[0]*dims[1]);
-	dataset.read(&buf[0], H5::PredType::NATIVE_FLOAT, mspace, dataspace );
-	
-	if (myid==0 and _verbose)
-	  std::cout << "GadgetHDF5: coordinate storage size="
-		    << dataset.getStorageSize() << std::endl;
-	
-	// Clear and load the particle vector
-	//
-	particles.clear();
-
-	Particle P;		// Working particle will be copied
-	for (int n=0; n<dims[0]; n++) {
-	  if (n % numprocs ==  myid) {
-	    P.mass  = mass[ptype];
-	    P.level = 0;
-	    for (int k=0; k<3; k++) P.pos[k] = buf[n*3+k];
-	    particles.push_back(P);
-	  }
+
+	if (fields & FieldPosition) {
+	  H5::DataSet dataset = grp.openDataSet("Coordinates");
+	  readRows<float>(dataset, H5::PredType::NATIVE_FLOAT, lo, hi,
+			  block.pos.data());
+	  if (myid==0 and _verbose)
+	    std::cout << "GadgetHDF5: coordinate storage size="
+		      << dataset.getStorageSize() << std::endl;
 	}
-	
-	// Get velocities
-	dataspace.close();
-	dataset.close();
-	dataset = grp.openDataSet("Velocities");
-	dataspace = dataset.getSpace();
-	
-	std::vector<float> vel(dims[0]*dims[1]);
-	dataset.read(&vel[0], H5::PredType::NATIVE_FLOAT, mspace, dataspace );
-	
-	if (myid==0 and _verbose)
-	  std::cout << "GadgetHDF5: velocity storage size="
-		    << dataset.getStorageSize() << std::endl;
-	
-	auto it = particles.begin();
-	for (int n=0; n<dims[0]; n++) {
-	  if (n % numprocs ==  myid) {
-	    for (int k=0; k<3; k++) it->vel[k] = vel[n*3+k];
-	    it++;
-	  }
+
+	if (fields & FieldVelocity) {
+	  H5::DataSet dataset = grp.openDataSet("Velocities");
+	  readRows<float>(dataset, H5::PredType::NATIVE_FLOAT, lo, hi,
+			  block.vel.data());
+	  if (myid==0 and _verbose)
+	    std::cout << "GadgetHDF5: velocity storage size="
+		      << dataset.getStorageSize() << std::endl;
 	}
 	
-	dataspace.close();
-	
-	// Try to get Masses.  This will override the assignment from
-	// the header if the data exists.
+	// Masses from the file override the header value if the
+	// dataset exists
 	//
-	try {
-	  dataset = grp.openDataSet("Masses");
-	
-	  if (myid==0 and _verbose)
-	    std::cout << "GadgetHDF5: mass storage size="
-		      << dataset.getStorageSize() << std::endl;
-	  
-	  if (dataset.getStorageSize()) {
-	    
-	    dataspace = dataset.getSpace();
-	    
-	    int rank = dataspace.getSimpleExtentNdims();
-	    
-	    auto dims = std::make_unique<hsize_t[]>(rank);
-	    
-	    int ndims = dataspace.getSimpleExtentDims(dims.get(), NULL);
-	    
-	    H5::DataSpace mspace(rank, dims.get());
-	    
-	    std::vector<float> masses(dims[0]);
-	    dataset.read(&masses[0], H5::PredType::NATIVE_FLOAT, mspace, dataspace );
-	  
-	    auto it = particles.begin();
-	    for (int n=0; n<dims[0]; n++) {
-	      if (n % numprocs == myid) (it++)->mass = masses[n];
+	if (fields & FieldMass) {
+	  bool found = false;
+	  try {
+	    H5::DataSet dataset = grp.openDataSet("Masses");
+	    if (myid==0 and _verbose)
+	      std::cout << "GadgetHDF5: mass storage size="
+			<< dataset.getStorageSize() << std::endl;
+	    if (dataset.getStorageSize()) {
+	      readRows<float>(dataset, H5::PredType::NATIVE_FLOAT, lo, hi,
+			      block.mass.data());
+	      found = true;
 	    }
 	  }
+	  catch(H5::GroupIException error)
+	    {
+	      error.printErrorStack();
+	    }
+	  if (not found)
+	    std::fill(block.mass.begin(), block.mass.end(), mass[ptype]);
 	}
-	catch(H5::GroupIException error)
-	  {
-	    error.printErrorStack();
-	  }
 
-	
-	dataspace.close();
-	dataset.close();
-	
-	// Try to get particle ids
+	// Particle ids, or the position in the file if there are none
 	//
-	dataset = grp.openDataSet("ParticleIDs");
-	
-	
-	if (myid==0 and _verbose)
-	  std::cout << "GadgetHDF5: particle ID storage size="
-		    << dataset.getStorageSize() << std::endl;
-	
-	if (dataset.getStorageSize()) {
-	  
-	  dataspace = dataset.getSpace();
-	  
-	  int rank = dataspace.getSimpleExtentNdims();
-	  
-	  auto dims = std::make_unique<hsize_t[]>(rank);
-	  
-	  int ndims = dataspace.getSimpleExtentDims( dims.get(), NULL);
-	  
-	  H5::DataSpace mspace(rank, dims.get());
-	  
-	  std::vector<unsigned> seq(dims[0]);
-	  dataset.read(&seq[0], H5::PredType::NATIVE_UINT32, mspace, dataspace );
-	  
-	  auto it = particles.begin();
-	  for (int n=0; n<dims[0]; n++) {
-	    if (n % numprocs == myid) (it++)->indx = seq[n];
+	if (fields & FieldIndex) {
+	  H5::DataSet dataset = grp.openDataSet("ParticleIDs");
+	  if (myid==0 and _verbose)
+	    std::cout << "GadgetHDF5: particle ID storage size="
+		      << dataset.getStorageSize() << std::endl;
+	  if (dataset.getStorageSize()) {
+	    readRows<unsigned long>(dataset, H5::PredType::NATIVE_ULONG,
+				    lo, hi, block.indx.data());
+	  } else {
+	    std::iota(block.indx.begin(), block.indx.end(), lo + 1);
 	  }
-	} else {
-	  for (int n=0; n<dims[0]; n++) particles[n].indx = n + 1;
 	}
       } else {
 	std::cerr << "GadgetHDF5:: zero pass particles for type <"
@@ -619,21 +650,58 @@ namespace PR {
       }
   }
   
-  const Particle* GadgetHDF5::firstParticle()
+  void GadgetHDF5::restart()
   {
     pcount = 0;
-    
-    return & particles[pcount++];
+
+    // A single file already in memory with the requested fields
+    //
+    if (not stale and _files.size()==1 and (fields & ~block.loaded)==0)
+      return;
+
+    stale   = false;
+    block.resize(0, 0);
+    curfile = _files.begin();
+    fetch   = startPrefetch(_files);
+  }
+
+  ParticleChunk GadgetHDF5::view(size_t maxn)
+  {
+    // This process' share of a file may be empty
+    //
+    while (pcount >= block.size) {
+      if (not nextFile()) return ParticleChunk();
+      pcount = 0;
+    }
+
+    auto ret = block.view(pcount, std::min<size_t>(maxn, block.size - pcount));
+    pcount += ret.size;
+    return ret;
+  }
+
+  ParticleChunk GadgetHDF5::firstChunk(size_t maxn)
+  {
+    restart();
+    return view(maxn);
+  }
+
+  ParticleChunk GadgetHDF5::nextChunk(size_t maxn)
+  {
+    return view(maxn);
+  }
+  
+  const Particle* GadgetHDF5::firstParticle()
+  {
+    restart();
+    return nextParticle();
   }
   
   const Particle* GadgetHDF5::nextParticle()
   {
-    if (pcount < particles.size()) {
-      return & particles[pcount++];
-    } else {
-      if (nextFile()) return firstParticle();
-      else return 0;
-    }
+    auto c = view(1);
+    if (c.size==0) return 0;
+    block.unpack(pcount-1, P);
+    return &P;
   }
   
   
@@ -1042,9 +1110,13 @@ namespace PR {
   
   const Particle* PSPout::firstParticle()
   {
-    pcount = 0;
+    // Seek directly to this process' share of the stanza
+    //
+    auto range = share(spos->comp.nbod);
+    pcount = range.first;
+    pend   = range.second;
     
-    in.seekg(cur->pspos);
+    in.seekg(cur->pspos + static_cast<std::streamoff>(pcount*recordSize()));
     
     return nextParticle();
   }
@@ -1053,87 +1125,157 @@ namespace PR {
   {
     badstatus(in);		// DEBUG
     
-    // Stagger on first read
-    // ---------------------
-    
-    if (pcount==0) {
-      for (int n=0; n<myid; n++) {
-	if (pcount < spos->comp.nbod) {
-	  if (spos->r_size == 4) {
-	    fpart.skip(in, pcount++, spos);
-	  } else {
-	    dpart.skip(in, pcount++, spos);
-	  }
-	}
-      }
-    }
-    
     // Read partcle
     // ------------
-    if (pcount < spos->comp.nbod) {
+    if (pcount < pend) {
       
-      if (spos->r_size == 4)
+      if (spos->r_size == 4) {
 	fpart.read(in, pcount++, spos);
-      else
-	dpart.read(in, pcount++, spos);
-      
-      // Stride by numprocs-1
-      // --------------------
-      for (int n=0; n<numprocs-1; n++)  {
-	if (pcount < spos->comp.nbod) {
-	  if (spos->r_size == 4)
-	    fpart.skip(in, pcount++, spos);
-	  else
-	    dpart.skip(in, pcount++, spos);
-	}
-      }
-      
-      if (spos->r_size == 4)
 	return static_cast<Particle*>(&fpart);
-      else
+      } else {
+	dpart.read(in, pcount++, spos);
 	return static_cast<Particle*>(&dpart);
+      }
       
     } else
       return 0;
   }
   
+  std::pair<std::string, std::streamoff>
+  PSPspl::location(const std::string& blob)
+  {
+    auto at = blob.find_last_of('@');
+    if (at == std::string::npos or at+1 == blob.size() or
+	blob.find_first_not_of("0123456789", at+1) != std::string::npos)
+      return {blob, 0};
+
+    return {blob.substr(0, at), std::stoll(blob.substr(at+1))};
+  }
+
+  const std::vector<unsigned long>& PSPspl::blobStarts()
+  {
+    auto it = starts.find(spos->name);
+    if (it != starts.end()) return it->second;
+
+    // Each blob begins with its particle count
+    //
+    std::vector<unsigned long> ret(1, 0);
+    std::ifstream blb;
+    std::string cur;
+    for (auto & f : spos->nparts) {
+      auto loc = location(f);
+      if (loc.first != cur or not blb.good()) {
+	blb.close();
+	blb.clear();
+	blb.open(loc.first);
+	cur = loc.first;
+      }
+      blb.seekg(loc.second);
+      unsigned int n = 0;
+      blb.read((char*)&n, sizeof(unsigned int));
+      if (not blb.good()) {
+	std::ostringstream sout;
+	sout << "Could not get particle count from <" << f << ">";
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+      }
+      ret.push_back(ret.back() + n);
+    }
+
+    return starts[spos->name] = ret;
+  }
+
   const Particle* PSPspl::firstParticle()
   {
-    pcount = 0;
+    auto range = share(spos->comp.nbod);
+    pcount = range.first;
+    pend   = range.second;
+
+    blob.reset();
+    fetch.reset();
+
+    if (pcount >= pend) return 0;
     
-    // Set iterator to beginning of vector
-    fit = spos->nparts.begin();
+    // Find the blobs holding this process' share
+    //
+    auto & start = blobStarts();
+    size_t b = std::upper_bound(start.begin(), start.end(), pcount) - start.begin() - 1;
+    size_t e = std::upper_bound(start.begin(), start.end(), pend-1) - start.begin();
+
+    fbeg = fit = spos->nparts.begin() + b;
+
+    // The files holding those blobs, each listed once
+    files.clear();
+    fileOf.clear();
+    for (auto f=fbeg; f!=spos->nparts.begin() + e; f++) {
+      auto name = location(*f).first;
+      if (files.empty() or files.back() != name) files.push_back(name);
+      fileOf.push_back(files.size()-1);
+    }
+    curFile = files.size();
+    fileData.reset();
+
+    // Read those files ahead
+    fetch = startPrefetch(files);
     
-    // Open next file in sequence
+    // Open the first blob and seek to the first record
     openNextBlob();
+
+    fcount = pcount - start[b];
+    blob->seekg(fcount*recordSize(), std::ios::cur);
     
     return nextParticle();
   }
   
   void PSPspl::openNextBlob()
   {
-    // Close current file
-    //
-    if (in.is_open()) in.close();
-    
+    auto loc = location(*fit);
+    size_t f = fileOf[fit - fbeg];
     std::string curfile(*fit);
+
+    if (fetch) {
+      try {
+	if (f != curFile) fileData = fetch->get(f);
+	auto m = std::make_shared<MemStream>(fileData);
+	m->exceptions(std::istream::failbit | std::istream::badbit);
+	m->seekg(loc.second);
+	blob = m;
+      } catch (std::ios_base::failure& e) {
+	std::ostringstream sout;
+	sout << "Could not seek to SPL blob <" << curfile << ">";
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+      } catch (std::runtime_error& e) {
+	throw GenericError(e.what(), __FILE__, __LINE__, 1041, true);
+      }
+    } else {
+      // Keep the file open for the next blob in the same file
+      //
+      if (f != curFile) {
+	if (in.is_open()) in.close();
+	try {
+	  in.open(loc.first);
+	} catch (...) {
+	  std::ostringstream sout;
+	  sout << "Could not open SPL blob <" << curfile << ">";
+	  throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+	}
+      }
+
+      if (in.good()) in.seekg(loc.second);
     
-    try {
-      in.open(curfile);
-    } catch (...) {
-      std::ostringstream sout;
-      sout << "Could not open SPL blob <" << curfile << ">";
-      throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
-    }
-    
-    if (not in.good()) {
-      std::ostringstream sout;
-      sout << "Could not open SPL blob <" << curfile << ">";
-      throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+      if (not in.good()) {
+	std::ostringstream sout;
+	sout << "Could not open SPL blob <" << curfile << ">";
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+      }
+
+      // Not owned
+      blob = std::shared_ptr<std::istream>(&in, [](std::istream*){});
     }
+
+    curFile = f;
     
     try {
-      in.read((char*)&N, sizeof(unsigned int));
+      blob->read((char*)&N, sizeof(unsigned int));
     } catch (...) {
       std::ostringstream sout;
       sout << "Could not get particle count from <" << curfile << ">";
@@ -1148,53 +1290,23 @@ namespace PR {
   
   const Particle* PSPspl::nextParticle()
   {
-    badstatus(in);		// DEBUG
-    
-    // Stagger on first read
-    // ---------------------
-    if (pcount==0) {
-      for (int n=0; n<myid; n++) {
-	if (pcount < spos->comp.nbod) {
-	  if (fcount==N) openNextBlob();
-	  if (spos->r_size == 4)
-	    fpart.skip(in, pcount++, spos);
-	  else
-	    dpart.skip(in, pcount++, spos);
-	  fcount++;
-	}
-      }
-    }
-    
     // Read partcle
     // ------------
-    if (pcount < spos->comp.nbod) {
+    if (pcount < pend) {
+      
+      while (fcount==N) openNextBlob();
       
-      if (fcount==N) openNextBlob();
+      badstatus(*blob);		// DEBUG
       
       // Read blob
-      if (spos->r_size == 4)
-	fpart.read(in, pcount++, spos);
-      else
-	dpart.read(in, pcount++, spos);
       fcount++;
-      
-      // Stride by numprocs-1
-      // --------------------
-      for (int n=0; n<numprocs-1; n++)  {
-	if (pcount < spos->comp.nbod) {
-	  if (fcount==N) openNextBlob();
-	  if (spos->r_size == 4)
-	    fpart.skip(in, pcount++, spos);
-	  else
-	    dpart.skip(in, pcount++, spos);
-	  fcount++;
-	}
-      }
-      
-      if (spos->r_size == 4)
+      if (spos->r_size == 4) {
+	fpart.read(*blob, pcount++, spos);
 	return static_cast<Particle*>(&fpart);
-      else
+      } else {
+	dpart.read(*blob, pcount++, spos);
 	return static_cast<Particle*>(&dpart);
+      }
       
     } else
       return 0;
@@ -1294,8 +1406,47 @@ namespace PR {
   }
   
   
+  ParticleChunk ParticleReader::firstChunk(size_t maxn)
+  {
+    chunk_next = firstParticle();
+    return nextChunk(maxn);
+  }
+
+  ParticleChunk ParticleReader::nextChunk(size_t maxn)
+  {
+    chunk_mass.resize(maxn);
+    chunk_pos .resize(3*maxn);
+    chunk_vel .resize(3*maxn);
+    chunk_indx.resize(maxn);
+
+    // The particle returned by the reader may be overwritten by the
+    // following call so copy it first
+    //
+    size_t n = 0;
+    while (chunk_next and n<maxn) {
+      chunk_mass[n] = chunk_next->mass;
+      chunk_indx[n] = chunk_next->indx;
+      for (int k=0; k<3; k++) {
+	chunk_pos[3*n+k] = chunk_next->pos[k];
+	chunk_vel[3*n+k] = chunk_next->vel[k];
+      }
+      n++;
+      chunk_next = nextParticle();
+    }
+
+    ParticleChunk ret;
+    ret.size = n;
+    ret.mass = chunk_mass.data();
+    ret.pos  = chunk_pos.data();
+    ret.vel  = chunk_vel.data();
+    ret.indx = chunk_indx.data();
+    return ret;
+  }
+
+  int ParticleReader::prefetch = 2;
+
   std::vector<std::string> ParticleReader::readerTypes
-  {"PSPout", "PSPspl", "GadgetNative", "GadgetHDF5", "TipsyNative", "TipsyXDR", "Bonsai"};
+  {"PSPout", "PSPspl", "PSC", "PSPhdf5", "GadgetNative", "GadgetHDF5", "TipsyNative", "TipsyXDR", "Bonsai"};
   
   
   std::vector<std::vector<std::string>>
@@ -1373,6 +1524,10 @@ namespace PR {
       ret = std::make_shared<PSPout>(file, verbose);
     else if (reader.find("PSPspl") == 0)
       ret = std::make_shared<PSPspl>(file, verbose);
+    else if (reader.find("PSC") == 0)
+      ret = std::make_shared<PSC>(file, verbose);
+    else if (reader.find("PSPhdf5") == 0)
+      ret = std::make_shared<PSPhdf5>(file, verbose);
     else if (reader.find("GadgetNative") == 0)
       ret = std::make_shared<GadgetNative>(file, verbose);
     else if (reader.find("GadgetHDF5") == 0)
@@ -1414,12 +1569,510 @@ namespace PR {
     return ret;
   }
 
+  PSC::PSC(const std::vector<std::string>& file, bool verbose) :
+    cur(0), curindx(-1), _verbose(verbose), radial(false), boxed(false),
+    wpos(0), pcount(0)
+  {
+    if (file.size()==0)
+      throw GenericError("PSC: no master file", __FILE__, __LINE__, 1041, true);
+
+    // Blobs are named relative to the master
+    //
+    auto pos = file[0].find_last_of('/');
+    if (pos != std::string::npos) dir = file[0].substr(0, pos+1);
+
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File master(file[0], HighFive::File::ReadOnly);
+
+      int ncomp;
+      master.getAttribute("Time" ).read(time);
+      master.getAttribute("Ncomp").read(ncomp);
+      master.getAttribute("Blobs").read(blobs);
+
+      for (int i=0; i<ncomp; i++) {
+	HighFive::Group grp = master.getGroup("Component_" + std::to_string(i));
+
+	Stanza S;
+	unsigned long nchunks;
+	grp.getAttribute("name"   ).read(S.name);
+	grp.getAttribute("config" ).read(S.config);
+	grp.getAttribute("niatr"  ).read(S.niatr);
+	grp.getAttribute("ndatr"  ).read(S.ndatr);
+	grp.getAttribute("nbod"   ).read(S.nbod);
+	grp.getAttribute("nchunks").read(nchunks);
+
+	if (nchunks) {
+	  std::vector<double> index;
+	  grp.getDataSet("chunks").read(index);
+
+	  const int nidx = 11;
+	  for (unsigned long j=0; j<nchunks; j++) {
+	    const double *v = &index[j*nidx];
+	    Chunk c;
+	    c.blob  = v[0];
+	    c.first = v[1];
+	    c.count = v[2];
+	    c.rmin  = v[3];
+	    c.rmax  = v[4];
+	    for (int k=0; k<3; k++) {
+	      c.lo[k] = v[5+2*k];
+	      c.hi[k] = v[6+2*k];
+	    }
+	    S.chunks.push_back(c);
+	  }
+	}
+
+	stanzas.push_back(S);
+      }
+    }
+    catch (HighFive::Exception& err) {
+      std::ostringstream sout;
+      sout << "PSC: error reading master file <" << file[0] << ">: "
+	   << err.what();
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+    }
+
+    if (myid==0 and _verbose)
+      std::cout << "PSC: found " << stanzas.size() << " components in "
+		<< blobs.size() << " blobs" << std::endl;
+
+    if (stanzas.size()) SelectType(stanzas.front().name);
+  }
+
+  std::vector<std::string> PSC::GetTypes()
+  {
+    std::vector<std::string> ret;
+    for (auto & s : stanzas) ret.push_back(s.name);
+    return ret;
+  }
+
+  void PSC::SelectType(const std::string& name)
+  {
+    for (size_t i=0; i<stanzas.size(); i++) {
+      if (stanzas[i].name == name) {
+	cur     = &stanzas[i];
+	curindx = i;
+	assign();
+	return;
+      }
+    }
+
+    std::cout << "PSC error: no particle type <" << name << ">" << std::endl;
+    throw std::runtime_error("PSC error: non-existent particle type");
+  }
+
+  void PSC::SetRadialRange(double rmin, double rmax)
+  {
+    rsel[0] = rmin;
+    rsel[1] = rmax;
+    radial  = true;
+    assign();
+  }
+
+  void PSC::SetBox(const std::vector<double>& lo, const std::vector<double>& hi)
+  {
+    if (lo.size()<3 or hi.size()<3)
+      throw std::runtime_error("PSC::SetBox: need three limits");
+
+    for (int k=0; k<3; k++) {
+      bsel[2*k+0] = lo[k];
+      bsel[2*k+1] = hi[k];
+    }
+    boxed = true;
+    assign();
+  }
+
+  bool PSC::selected(const Chunk& c) const
+  {
+    if (radial and (c.rmax < rsel[0] or c.rmin >= rsel[1])) return false;
+    if (boxed) {
+      for (int k=0; k<3; k++)
+	if (c.hi[k] < bsel[2*k] or c.lo[k] >= bsel[2*k+1]) return false;
+    }
+    return true;
+  }
+
+  bool PSC::selected(const Particle& p) const
+  {
+    if (radial) {
+      double r = sqrt(p.pos[0]*p.pos[0] + p.pos[1]*p.pos[1] + p.pos[2]*p.pos[2]);
+      if (r < rsel[0] or r >= rsel[1]) return false;
+    }
+    if (boxed) {
+      for (int k=0; k<3; k++)
+	if (p.pos[k] < bsel[2*k] or p.pos[k] >= bsel[2*k+1]) return false;
+    }
+    return true;
+  }
+
+  void PSC::assign()
+  {
+    work.clear();
+    if (not cur) return;
+
+    // Stride the selected chunks over the processes
+    //
+    size_t n = 0;
+    for (size_t j=0; j<cur->chunks.size(); j++) {
+      if (not selected(cur->chunks[j])) continue;
+      if (n++ % numprocs == myid) work.push_back(j);
+    }
+
+    wpos = 0;
+    particles.clear();
+    pcount = 0;
+  }
+
+  bool PSC::loadChunk()
+  {
+    particles.clear();
+    pcount = 0;
+
+    while (particles.size()==0) {
+
+      if (wpos >= work.size()) return false;
+
+      const Chunk& c = cur->chunks[work[wpos++]];
+      std::string blob = dir + blobs[c.blob];
+      std::string gname = "Component_" + std::to_string(curindx);
+
+      try {
+	HighFive::SilenceHDF5 quiet;
+	HighFive::File file(blob, HighFive::File::ReadOnly);
+	HighFive::Group grp = file.getGroup(gname);
+
+	const size_t N = c.count, F = c.first;
+	const int ni = cur->niatr, nd = cur->ndatr;
+
+	std::vector<unsigned long> indx;
+	std::vector<double> mass, pos, vel, pot, dattrib;
+	std::vector<int> iattrib;
+
+	grp.getDataSet("indx").select({F}, {N}).read(indx);
+	grp.getDataSet("mass").select({F}, {N}).read(mass);
+	grp.getDataSet("pos" ).select({3*F}, {3*N}).read(pos);
+	grp.getDataSet("vel" ).select({3*F}, {3*N}).read(vel);
+	grp.getDataSet("pot" ).select({F}, {N}).read(pot);
+	if (ni) grp.getDataSet("iattrib").select({ni*F}, {ni*N}).read(iattrib);
+	if (nd) grp.getDataSet("dattrib").select({nd*F}, {nd*N}).read(dattrib);
+
+	Particle P(ni, nd);
+	for (size_t n=0; n<N; n++) {
+	  P.indx = indx[n];
+	  P.mass = mass[n];
+	  P.pot  = pot [n];
+	  for (int k=0; k<3; k++) {
+	    P.pos[k] = pos[3*n+k];
+	    P.vel[k] = vel[3*n+k];
+	  }
+	  for (int k=0; k<ni; k++) P.iattrib[k] = iattrib[n*ni+k];
+	  for (int k=0; k<nd; k++) P.dattrib[k] = dattrib[n*nd+k];
+
+	  if (selected(P)) particles.push_back(P);
+	}
+      }
+      catch (HighFive::Exception& err) {
+	std::ostringstream sout;
+	sout << "PSC: error reading blob <" << blob << ">: " << err.what();
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+      }
+    }
+
+    return true;
+  }
+
+  const Particle* PSC::firstParticle()
+  {
+    wpos = 0;
+    if (not loadChunk()) return 0;
+    return &particles[pcount++];
+  }
+
+  const Particle* PSC::nextParticle()
+  {
+    if (pcount < particles.size()) return &particles[pcount++];
+    if (not loadChunk()) return 0;
+    return &particles[pcount++];
+  }
+
+  PSPhdf5::PSPhdf5(const std::vector<std::string>& files, bool verbose) :
+    cur(0), curindx(-1), _verbose(verbose), first(0), last(0), next(0),
+    bsize(0), pcount(0)
+  {
+    if (files.size()==0)
+      throw GenericError("PSPhdf5: no file", __FILE__, __LINE__, 1041, true);
+
+    file = files[0];
+
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File h5(file, HighFive::File::ReadOnly);
+
+      int ncomp;
+      h5.getAttribute("Time" ).read(time);
+      h5.getAttribute("Ncomp").read(ncomp);
+
+      for (int i=0; i<ncomp; i++) {
+	HighFive::Group grp = h5.getGroup("Component_" + std::to_string(i));
+
+	Stanza S;
+	grp.getAttribute("name"  ).read(S.name);
+	grp.getAttribute("config").read(S.config);
+	grp.getAttribute("niatr" ).read(S.niatr);
+	grp.getAttribute("ndatr" ).read(S.ndatr);
+	grp.getAttribute("nbod"  ).read(S.nbod);
+
+	stanzas.push_back(S);
+      }
+    }
+    catch (HighFive::Exception& err) {
+      std::ostringstream sout;
+      sout << "PSPhdf5: error reading <" << file << ">: " << err.what();
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+    }
+
+    if (myid==0 and _verbose)
+      std::cout << "PSPhdf5: found " << stanzas.size() << " components"
+		<< std::endl;
+
+    if (stanzas.size()) SelectType(stanzas.front().name);
+  }
+
+  std::vector<std::string> PSPhdf5::GetTypes()
+  {
+    std::vector<std::string> ret;
+    for (auto & s : stanzas) ret.push_back(s.name);
+    return ret;
+  }
+
+  void PSPhdf5::SelectType(const std::string& name)
+  {
+    for (size_t i=0; i<stanzas.size(); i++) {
+      if (stanzas[i].name == name) {
+	cur     = &stanzas[i];
+	curindx = i;
+
+	// Contiguous slab for this process
+	//
+	std::tie(first, last) = share(cur->nbod);
+	next  = first;
+
+	P      = Particle(cur->niatr, cur->ndatr);
+	bsize  = 0;
+	pcount = 0;
+	return;
+      }
+    }
+
+    std::cout << "PSPhdf5 error: no particle type <" << name << ">" << std::endl;
+    throw std::runtime_error("PSPhdf5 error: non-existent particle type");
+  }
+
+  bool PSPhdf5::nextBlock()
+  {
+    bsize  = 0;
+    pcount = 0;
+
+    if (next >= last) return false;
+
+    const size_t F = next, N = std::min<unsigned long>(blocksize, last - next);
+    const size_t ni = cur->niatr, nd = cur->ndatr;
+    next += N;
+
+    try {
+      HighFive::SilenceHDF5 quiet;
+      HighFive::File h5(file, HighFive::File::ReadOnly);
+      HighFive::Group grp = h5.getGroup("Component_" + std::to_string(curindx));
+
+      bindx   .resize(N);
+      bmass   .resize(N);
+      bpos    .resize(3*N);
+      bvel    .resize(3*N);
+      bpot    .resize(N);
+      bpotext .resize(N);
+      bdattrib.resize(N*nd);
+      biattrib.resize(N*ni);
+
+      // The hyperslab reads convert float datasets to double
+      //
+      auto slab = [&](const std::string& name, size_t ncol, auto& v)
+      {
+	using T = typename std::decay_t<decltype(v)>::value_type;
+	auto ds = grp.getDataSet(name);
+	if (ncol>1)
+	  ds.select({F, 0}, {N, ncol}).read_raw(v.data(), HighFive::AtomicType<T>());
+	else
+	  ds.select({F}, {N}).read_raw(v.data(), HighFive::AtomicType<T>());
+      };
+
+      slab("indx",   1, bindx);
+      slab("mass",   1, bmass);
+      slab("pos",    3, bpos);
+      slab("vel",    3, bvel);
+      slab("pot",    1, bpot);
+      slab("potext", 1, bpotext);
+      if (ni) slab("iattrib", ni, biattrib);
+      if (nd) slab("dattrib", nd, bdattrib);
+    }
+    catch (HighFive::Exception& err) {
+      std::ostringstream sout;
+      sout << "PSPhdf5: error reading <" << file << ">: " << err.what();
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1041, true);
+    }
+
+    bsize = N;
+
+    return true;
+  }
+
+  const Particle* PSPhdf5::unpack(size_t n)
+  {
+    const size_t ni = cur->niatr, nd = cur->ndatr;
+
+    P.indx   = bindx  [n];
+    P.mass   = bmass  [n];
+    P.pot    = bpot   [n];
+    P.potext = bpotext[n];
+    for (int k=0; k<3; k++) {
+      P.pos[k] = bpos[3*n+k];
+      P.vel[k] = bvel[3*n+k];
+    }
+    for (size_t k=0; k<ni; k++) P.iattrib[k] = biattrib[n*ni+k];
+    for (size_t k=0; k<nd; k++) P.dattrib[k] = bdattrib[n*nd+k];
+
+    return &P;
+  }
+
+  const Particle* PSPhdf5::firstParticle()
+  {
+    next = first;
+    if (not nextBlock()) return 0;
+    return unpack(pcount++);
+  }
+
+  const Particle* PSPhdf5::nextParticle()
+  {
+    if (pcount < bsize) return unpack(pcount++);
+    if (not nextBlock()) return 0;
+    return unpack(pcount++);
+  }
+
+  ParticleChunk PSPhdf5::view(size_t maxn)
+  {
+    ParticleChunk ret;
+    if (pcount >= bsize and not nextBlock()) return ret;
+
+    ret.size = std::min<size_t>(maxn, bsize - pcount);
+    ret.mass = &bmass[pcount];
+    ret.pos  = &bpos [3*pcount];
+    ret.vel  = &bvel [3*pcount];
+    ret.indx = &bindx[pcount];
+
+    pcount += ret.size;
+    return ret;
+  }
+
+  ParticleChunk PSPhdf5::firstChunk(size_t maxn)
+  {
+    next   = first;
+    bsize  = 0;
+    pcount = 0;
+    return view(maxn);
+  }
+
+  ParticleChunk PSPhdf5::nextChunk(size_t maxn)
+  {
+    return view(maxn);
+  }
+
   std::vector<std::string> Tipsy::Ptypes
   {"Gas", "Dark", "Star"};
   
   std::unordered_map<std::string, int> Tipsy::findP
   { {"Gas", 0}, {"Dark", 1}, {"Star", 2} };
   
+  bool Tipsy::mapped = true;
+
+  namespace
+  {
+    //! Value of type T from bytes p that are big endian if swap is
+    //! true and in host order otherwise
+    template<typename T>
+    inline T decode(const char* p, bool swap)
+    {
+      T v;
+      if (swap) {
+	char b[sizeof(T)];
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	std::reverse_copy(p, p+sizeof(T), b);
+#else
+	std::copy(p, p+sizeof(T), b);
+#endif
+	std::memcpy(&v, b, sizeof(T));
+      } else {
+	std::memcpy(&v, p, sizeof(T));
+      }
+      return v;
+    }
+
+    //! Size of the header in a mapped file
+    size_t tipsyHeaderSize(bool xdr)
+    {
+#ifdef TIPSY_32BYTE_PAD
+      return 32;
+#else
+      return xdr ? 28 : sizeof(TipsyReader::Header);
+#endif
+    }
+
+    //! Decode the header of a mapped file
+    TipsyReader::Header tipsyHeader(const MappedFile& map, bool xdr,
+				    const std::string& file)
+    {
+      if (map.size < tipsyHeaderSize(xdr)) {
+	std::ostringstream sout;
+	sout << "Tipsy: <" << file << "> is too short for a header";
+	throw std::runtime_error(sout.str());
+      }
+
+      TipsyReader::Header h;
+      if (xdr) {
+	h.time    = decode<double>(map.data,    true);
+	h.nbodies = decode<int>   (map.data+ 8, true);
+	h.ndim    = decode<int>   (map.data+12, true);
+	h.nsph    = decode<int>   (map.data+16, true);
+	h.ndark   = decode<int>   (map.data+20, true);
+	h.nstar   = decode<int>   (map.data+24, true);
+      } else {
+	std::memcpy(&h, map.data, sizeof(h));
+      }
+      return h;
+    }
+  }
+
+  TipsyReader::Header Tipsy::readHeader(const std::string& file)
+  {
+    if (mapped) {
+      MappedFile map(file);
+      if (map) return tipsyHeader(map, ttype == TipsyType::xdr, file);
+    }
+
+    // Make a tipsy native reader
+    if (ttype == TipsyType::native)
+      return TipsyReader::TipsyNative(file).header;
+    // Native tipsy with ID conversion
+    else if (ttype == TipsyType::bonsai)
+      return TipsyReader::TipsyNative(file).header;
+    // Make a tipsy xdr reader
+    else {
+#ifdef HAVE_XDR
+      return TipsyReader::TipsyXDR(file).header;
+#else
+      return TipsyReader::TipsyNative(file).header;
+#endif
+    }
+  }
   
   void Tipsy::getNumbers()
   {
@@ -1429,34 +2082,22 @@ namespace PR {
     unsigned fcnt = 0;
     for (auto file : files) {
 
-      // Make a tipsy native reader
-      if (ttype == TipsyType::native)
-	ps = std::make_shared<TipsyReader::TipsyNative>(file);
-      // Native tipsy with ID conversion
-      else if (ttype == TipsyType::bonsai)
-	ps = std::make_shared<TipsyReader::TipsyNative>(file);
-      // Make a tipsy xdr reader
-      else {
-#ifdef HAVE_XDR
-	ps = std::make_shared<TipsyReader::TipsyXDR>(file);
-#else
-	ps = std::make_shared<TipsyReader::TipsyNative>(file);
-#endif
-      }
+      auto header = readHeader(file);
+      if (fcnt==0) time = header.time;
 
-      if (ps->header.nsph ) {
+      if (header.nsph ) {
 	types.insert("Gas");
-	Ngas += ps->header.nsph;
+	Ngas += header.nsph;
       }
 
-      if (ps->header.ndark) {
+      if (header.ndark) {
 	types.insert("Dark");
-	Ndark += ps->header.ndark;
+	Ndark += header.ndark;
       }
 
-      if (ps->header.nstar) {
+      if (header.nstar) {
 	types.insert("Star");
-	Nstar += ps->header.nstar;
+	Nstar += header.nstar;
       }
 
       fcnt++;
@@ -1466,23 +2107,119 @@ namespace PR {
     for (auto s : types) curTypes.push_back(s);
   }
 
-  bool Tipsy::nextFile()
+  bool Tipsy::readMapped(const std::string& file)
   {
-    if (curfile==files.end()) return false;
-    
+    MappedFile map(file);
+    if (not map) return false;
+
+    bool xdr  = ttype == TipsyType::xdr;
+    auto head = tipsyHeader(map, xdr, file);
+    time = head.time;
+
+    auto it = findP.find(curName);
+    if (it == findP.end()) {
+      block.resize(0, 0);
+      return true;
+    }
+
+    // Record range of the current type
+    //
+    const unsigned long count[3] = {
+      static_cast<unsigned long>(head.nsph),
+      static_cast<unsigned long>(head.ndark),
+      static_cast<unsigned long>(head.nstar) };
+
+    const size_t rsize[3] = {
+      sizeof(TipsyReader::gas_particle),
+      sizeof(TipsyReader::dark_particle),
+      sizeof(TipsyReader::star_particle) };
+
+    int t = it->second;
+    size_t base = tipsyHeaderSize(xdr);
+    for (int i=0; i<t; i++) base += count[i]*rsize[i];
+
+    if (base + count[t]*rsize[t] > map.size) {
+      std::ostringstream sout;
+      sout << "Tipsy: <" << file << "> is shorter than its header implies";
+      throw std::runtime_error(sout.str());
+    }
+
+    // This process' share, decoded in parallel.  Each record is mass,
+    // position, velocity, the type's own fields and the potential,
+    // which holds the index in Bonsai files.
+    //
+    auto r = share(count[t]);
+    size_t n = r.second - r.first;
+    block.resize(n, fields);
+
+    const char* first = map.data + base + r.first*rsize[t];
+    const size_t sz   = sizeof(TipsyReader::Real);
+    const size_t phi  = rsize[t] - sz;
+    const bool bonsai = ttype == TipsyType::bonsai;
+
+    using TipsyReader::Real;
+
+#pragma omp parallel for schedule(static)
+    for (size_t i=0; i<n; i++) {
+      const char* p = first + i*rsize[t];
+      if (block.mass.size()) block.mass[i] = decode<Real>(p, xdr);
+      for (int k=0; k<3; k++) {
+	if (block.pos.size()) block.pos[3*i+k] = decode<Real>(p + (1+k)*sz, xdr);
+	if (block.vel.size()) block.vel[3*i+k] = decode<Real>(p + (4+k)*sz, xdr);
+      }
+      if (block.indx.size())
+	block.indx[i] = bonsai ? decode<int>(p + phi, xdr) : 0;
+    }
+
+    return true;
+  }
+
+  void Tipsy::readStream(const std::string& file)
+  {
+    std::shared_ptr<TipsyReader::TipsyFile> ps;
+
     if (ttype == TipsyType::native)
-      ps = std::make_shared<TipsyReader::TipsyNative>(*curfile);
+      ps = std::make_shared<TipsyReader::TipsyNative>(file);
     else if (ttype == TipsyType::bonsai)
-      ps = std::make_shared<TipsyReader::TipsyNative>(*curfile);
+      ps = std::make_shared<TipsyReader::TipsyNative>(file);
     else {
 #ifdef HAVE_XDR
-      ps = std::make_shared<TipsyReader::TipsyXDR>(*curfile);
+      ps = std::make_shared<TipsyReader::TipsyXDR>(file);
 #else
-      ps = std::make_shared<TipsyReader::TipsyNative>(*curfile);
+      ps = std::make_shared<TipsyReader::TipsyNative>(file);
 #endif
     }
 
-    ps->readParticles();
+    ps->readParticles(myid, numprocs);
+    time = ps->header.time;
+
+    const bool bonsai = ttype == TipsyType::bonsai;
+
+    auto copy = [&](auto& v)
+    {
+      block.resize(v.size(), fields);
+#pragma omp parallel for schedule(static)
+      for (size_t i=0; i<v.size(); i++) {
+	if (block.mass.size()) block.mass[i] = v[i].mass;
+	for (int k=0; k<3; k++) {
+	  if (block.pos.size()) block.pos[3*i+k] = v[i].pos[k];
+	  if (block.vel.size()) block.vel[3*i+k] = v[i].vel[k];
+	}
+	if (block.indx.size()) block.indx[i] = bonsai ? v[i].ID() : 0;
+      }
+    };
+
+    if      (curName=="Gas" ) copy(ps->gas_particles);
+    else if (curName=="Dark") copy(ps->dark_particles);
+    else if (curName=="Star") copy(ps->star_particles);
+    else block.resize(0, 0);
+  }
+
+  bool Tipsy::nextFile()
+  {
+    if (curfile==files.end()) return false;
+    
+    if (not mapped or not readMapped(*curfile)) readStream(*curfile);
 
     curfile++;
     return true;
@@ -1495,9 +2232,6 @@ namespace PR {
     files.push_back(file);
     getNumbers();
     curfile = files.begin();
-    if (not nextFile()) {
-      std::cerr << "Tipsy: no files found" << std::endl;
-    }
   }
   
   Tipsy::Tipsy(const std::vector<std::string>& filelist, TipsyType Type,
@@ -1505,11 +2239,11 @@ namespace PR {
   {
     ttype = Type;
     files = filelist;
-    getNumbers();
-    curfile = files.begin();
-    if (not nextFile()) {
+    if (files.empty()) {
       std::cerr << "Tipsy: no files found" << std::endl;
     }
+    getNumbers();
+    curfile = files.begin();
   }
   
   void Tipsy::SelectType(const std::string& name)
@@ -1522,54 +2256,9 @@ namespace PR {
       curName = name;
     }
 
-    curfile = files.begin();	// Set to first file and open
-    nextFile();
+    stale = true;		// Read on first use
   }
 
-  void Tipsy::packParticle()
-  {
-    if (curName=="Gas") {
-      P.mass  = ps->gas_particles[pcount].mass;
-      P.level = 0;
-      for (int k=0; k<3; k++) {
-	P.pos[k] = ps->gas_particles[pcount].pos[k];
-	P.vel[k] = ps->gas_particles[pcount].vel[k];
-      }
-      if (ttype == TipsyType::bonsai) P.indx = ps->gas_particles[pcount].ID();
-      pcount++;
-      return;
-    }
-      
-    if (curName=="Dark") {
-      P.mass  = ps->dark_particles[pcount].mass;
-      P.level = 0;
-      for (int k=0; k<3; k++) {
-	P.pos[k] = ps->dark_particles[pcount].pos[k];
-	P.vel[k] = ps->dark_particles[pcount].vel[k];
-      }
-      if (ttype == TipsyType::bonsai) P.indx = ps->dark_particles[pcount].ID();
-      pcount++;
-      return;
-    }
-      
-    if (curName=="Star") {
-      P.mass  = ps->star_particles[pcount].mass;
-      P.level = 0;
-      for (int k=0; k<3; k++) {
-	P.pos[k] = ps->star_particles[pcount].pos[k];
-	P.vel[k] = ps->star_particles[pcount].vel[k];
-      }
-      if (ttype == TipsyType::bonsai) P.indx = ps->star_particles[pcount].ID();
-      pcount++;
-      return;
-    }
-    
-    std::string msg = "Tipsy error: particle type must be one of "
-      "Gas, Dark, Star. You selected [" + curName + "]";
-    throw GenericError(msg, __FILE__, __LINE__, 1041, true);
-  }
-
-  
   unsigned long Tipsy::CurrentNumber()
   {
     if (curName=="Gas") {
@@ -1583,31 +2272,61 @@ namespace PR {
     }
   }
   
-  const Particle* Tipsy::firstParticle()
+  void Tipsy::restart()
   {
     pcount = 0;
-    packParticle();
-    return &P;
+
+    // A single file already in memory with the requested fields
+    //
+    if (not stale and files.size()==1 and (fields & ~block.loaded)==0)
+      return;
+
+    stale   = false;
+    block.resize(0, 0);
+    curfile = files.begin();
   }
-    
-  const Particle* Tipsy::nextParticle()
+
+  ParticleChunk Tipsy::view(size_t maxn)
   {
-    if (curName=="Gas"  and pcount==ps->gas_particles.size()) {
-      if (nextFile()) return firstParticle();
-      else return NULL;
-    }
-    
-    if (curName=="Dark" and pcount==ps->dark_particles.size()) {
-      if (nextFile()) return firstParticle();
-      else return NULL;
+    // This process' share of a file may be empty
+    //
+    while (pcount >= block.size) {
+      if (not nextFile()) return ParticleChunk();
+      pcount = 0;
     }
 
-    if (curName=="Star" and pcount==ps->star_particles.size()) {
-      if (nextFile()) return firstParticle();
-      else return NULL;
+    auto ret = block.view(pcount, std::min<size_t>(maxn, block.size - pcount));
+    pcount += ret.size;
+    return ret;
+  }
+
+  ParticleChunk Tipsy::firstChunk(size_t maxn)
+  {
+    restart();
+    return view(maxn);
+  }
+
+  ParticleChunk Tipsy::nextChunk(size_t maxn)
+  {
+    return view(maxn);
+  }
+
+  const Particle* Tipsy::firstParticle()
+  {
+    restart();
+    return nextParticle();
+  }
+    
+  const Particle* Tipsy::nextParticle()
+  {
+    // Files may contribute no bodies of this type to this process
+    //
+    while (pcount >= block.size) {
+      if (not nextFile()) return NULL;
+      pcount = 0;
     }
 
-    packParticle();
+    block.unpack(pcount++, P);
     return &P;
   }
 
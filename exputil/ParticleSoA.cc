@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <limits>
+
+#include <ParticleSoA.H>
+
+double ParticleSoA::dense_fraction = 0.25;
+
+ParticleSoA::ParticleSoA(int niattrib, int ndattrib) :
+  niattrib(niattrib), ndattrib(ndattrib)
+{
+  iattrib.resize(niattrib);
+  dattrib.resize(ndattrib);
+  dense   = false;
+  seq_min = seq_max = 0;
+}
+
+void ParticleSoA::resize(size_t n)
+{
+  // Only one precision of the force outputs is allocated
+  //
+  size_t nd = single ? 0 : n, nf = single ? n : 0;
+
+  mass   .resize(n);
+  pot    .resize(nd);
+  potext .resize(nd);
+  fpot   .resize(nf);
+  fpotext.resize(nf);
+  level  .resize(n);
+  for (int k=0; k<3; k++) {
+    pos [k].resize(n);
+    vel [k].resize(n);
+    acc [k].resize(nd);
+    facc[k].resize(nf);
+  }
+  for (auto & v : iattrib) v.resize(n);
+  for (auto & v : dattrib) v.resize(n);
+
+  seq     .resize(n);
+  part    .resize(n);
+  detached.resize(n);
+}
+
+void ParticleSoA::clear()
+{
+  resize(0);
+  dmap.clear();
+  smap.clear();
+  dense = false;
+}
+
+void ParticleSoA::load(int s, Particle* p, bool zero)
+{
+  mass  [s] = p->mass;
+  level [s] = p->level;
+  for (int k=0; k<3; k++) {
+    pos[k][s] = p->pos[k];
+    vel[k][s] = p->vel[k];
+  }
+
+  if (single) {
+    fpot   [s] = zero ? 0.0f : p->pot;
+    fpotext[s] = zero ? 0.0f : p->potext;
+    for (int k=0; k<3; k++) facc[k][s] = zero ? 0.0f : p->acc[k];
+  } else {
+    pot    [s] = zero ? 0.0 : p->pot;
+    potext [s] = zero ? 0.0 : p->potext;
+    for (int k=0; k<3; k++) acc[k][s] = zero ? 0.0 : p->acc[k];
+  }
+
+  int ni = std::min<int>(niattrib, p->iattrib.size());
+  int nd = std::min<int>(ndattrib, p->dattrib.size());
+  for (int j=0; j<ni; j++) iattrib[j][s] = p->iattrib[j];
+  for (int j=0; j<nd; j++) dattrib[j][s] = p->dattrib[j];
+
+  seq     [s] = p->indx;
+  part    [s] = p;
+  detached[s] = 0;
+}
+
+void ParticleSoA::store(int s)
+{
+  Particle *p = part[s];
+
+  p->mass   = mass  [s];
+  p->pot    = getPot(s);
+  p->potext = getPotExt(s);
+  p->level  = level [s];
+  for (int k=0; k<3; k++) {
+    p->pos[k] = pos[k][s];
+    p->vel[k] = vel[k][s];
+    p->acc[k] = getAcc(k, s);
+  }
+
+  int ni = std::min<int>(niattrib, p->iattrib.size());
+  int nd = std::min<int>(ndattrib, p->dattrib.size());
+  for (int j=0; j<ni; j++) p->iattrib[j] = iattrib[j][s];
+  for (int j=0; j<nd; j++) p->dattrib[j] = dattrib[j][s];
+}
+
+void ParticleSoA::makeIndex()
+{
+  size_t n = seq.size();
+
+  dmap.clear();
+  smap.clear();
+
+  if (n==0) {
+    dense = false;
+    return;
+  }
+
+  auto mm = std::minmax_element(seq.begin(), seq.end());
+  seq_min = *mm.first;
+  seq_max = *mm.second;
+
+  // Use the flat table if the sequence range is compact enough
+  //
+  size_t range = seq_max - seq_min + 1;
+  dense = static_cast<double>(n) >= dense_fraction*range and
+    range < static_cast<size_t>(std::numeric_limits<int>::max());
+
+  if (dense) {
+    dmap.resize(range, -1);
+    for (size_t s=0; s<n; s++) dmap[seq[s] - seq_min] = s;
+  } else {
+    smap.reserve(n);
+    for (size_t s=0; s<n; s++) smap[seq[s]] = s;
+  }
+}
+
+void ParticleSoA::gather(PartMap& particles)
+{
+  resize(particles.size());
+
+  int s = 0;
+  for (auto & v : particles) load(s++, v.second.get());
+
+  makeIndex();
+}
+
+void ParticleSoA::gather(PartMap& particles,
+			 const LevelList& levlist,
+			 unsigned lo, unsigned hi, bool zero)
+{
+  // Levels [lo, hi] are one contiguous run of the level list
+  //
+  auto run = levlist.range(lo, hi);
+  size_t n = run.size();
+
+  resize(n);
+
+  // Slots are assigned in level-list order so that a pass over a
+  // level reads the arrays sequentially
+  //
+  int s = 0;
+  for (auto indx : run) {
+    auto it = particles.find(indx);
+    if (it != particles.end()) load(s++, it->second.get(), zero);
+  }
+
+  if (s < static_cast<int>(n)) resize(s);
+
+  makeIndex();
+}
+
+void ParticleSoA::scatter()
+{
+  int n = seq.size();
+  for (int s=0; s<n; s++) {
+    if (not detached[s]) store(s);
+  }
+}
@@ -1,5 +1,8 @@
 #include <iostream>
+#include <sstream>
+#include <mutex>
 #include <cmath>
+#include <map>
 
 #include "QDHT.H"
 
@@ -7,6 +10,70 @@ bool QDHT::debug = false;
 
 Eigen::VectorXd bessjz(int n, int m);
 
+namespace
+{
+  std::mutex kernelLock;
+  std::map<std::pair<int, int>, std::shared_ptr<const QDHT::Kernel>> kernels;
+}
+
+std::shared_ptr<const QDHT::Kernel> QDHT::kernel(int nu, int N)
+{
+  std::lock_guard<std::mutex> lock(kernelLock);
+
+  auto it = kernels.find({nu, N});
+  if (it != kernels.end()) return it->second;
+
+  auto ret = std::make_shared<Kernel>();
+
+  // Imports zeros of the Bessel function
+  //
+  try {
+    ret->zeros = bessjz(nu, N+1);
+  }
+  catch (std::exception& ex) {
+    std::cout << "Thrown exception " << ex.what() << std::endl;
+  }
+
+  // The total bandwidth: R*V
+  //
+  double S = ret->zeros[N];
+
+  // Get the Bessel function of order nu+1 evaluated at the roots
+  //
+  ret->Jp.resize(N);
+  for (int i=0; i<N; i++) {
+    ret->Jp[i] = EXPmath::cyl_bessel_j(nu+1.0, ret->zeros[i]);
+  }
+
+  // The transform matrix
+  //
+  ret->T.resize(N, N);
+  for (int i=0; i<N; i++) {
+    for (int j=i; j<N; j++) {
+      ret->T(i, j) = 2.0/S *
+	EXPmath::cyl_bessel_j(nu, ret->zeros[i]*ret->zeros[j]/S) /
+	(ret->Jp[i]*ret->Jp[j]);
+      if (i != j) ret->T(j, i) = ret->T(i, j);
+    }
+  }
+
+  ret->K = ret->Jp.asDiagonal() * ret->T * ret->Jp.cwiseInverse().asDiagonal();
+
+  kernels[{nu, N}] = ret;
+
+  return ret;
+}
+
+void QDHT::forget()
+{
+  std::lock_guard<std::mutex> lock(kernelLock);
+
+  for (auto it=kernels.begin(); it!=kernels.end();) {
+    if (it->second.use_count()==1) it = kernels.erase(it);
+    else it++;
+  }
+}
+
 // Constructor
 QDHT::QDHT(int nu, int N, double R) : nu(nu), N(N), R(R)
 {
@@ -28,44 +95,23 @@ QDHT::QDHT(int nu, int N, double R) : nu(nu), N(N), R(R)
     throw std::runtime_error(sout.str());
   }
 
-  // Imports zeros of the Bessel function. Initializing this way speeds up calls
+  // The zeros and transform matrix are shared by all instances with
+  // this order and size
   //
-  try {
-    zeros  = bessjz(nu, N+1);
-  }
-  catch (std::exception& ex) {
-    std::cout << "Thrown exception " << ex.what() << std::endl;
-  }
+  ker = kernel(nu, N);
 
   // Assign the total bandwidth: R*V
-  S = zeros[N];
+  S = ker->zeros[N];
 
   // Deduce V from S and R
   V = S/R;
 
-  // Assign the workspace
+  // The radial and spatial frequency vectors
   r.resize(N);
   k.resize(N);
-  T.resize(N, N);
-  Jp.resize(N);
-
-  // Get the Bessel function of order nu+1 evaluated at the roots
   for (int i=0; i<N; i++) {
-    Jp[i] = EXPmath::cyl_bessel_j(nu+1.0, zeros[i]);
-  }
-
-  // Precompute the radial and spatial frequency vectors and the
-  // transform matrix
-  for (int i=0; i<N; i++) {
-    r(i) = zeros[i]/V;
-    k(i) = zeros[i]/R;
-
-    for (int j=i; j<N; j++) {
-
-      T(i, j) = 2.0/S *
-	EXPmath::cyl_bessel_j(nu, zeros[i]*zeros[j]/S) / (Jp[i]*Jp[j]);
-      if (i != j) T(j, i) = T(i, j);
-    }
+    r(i) = ker->zeros[i]/V;
+    k(i) = ker->zeros[i]/R;
   }
 
   if (debug) check();
@@ -74,29 +120,47 @@ QDHT::QDHT(int nu, int N, double R) : nu(nu), N(N), R(R)
 
 Eigen::VectorXd QDHT::operator()(Eigen::VectorXd& v, bool forward)
 {
-  if (forward) {
-    Eigen::VectorXd F = v.array() / Jp.array() * R;
-    auto G = T * F;
-    return G.array() * Jp.array() / V;
-  } else {
-    Eigen::VectorXd G = v.array() / Jp.array() * V;
-    auto F = T * G;
-    return F.array() * Jp.array() / R;
-  }
+  if (forward) return ker->K * v * (R/V);
+  else         return ker->K * v * (V/R);
 }
 
+Eigen::MatrixXd QDHT::transform(const Eigen::MatrixXd& v, bool forward)
+{
+  if (forward) return ker->K * v * (R/V);
+  else         return ker->K * v * (V/R);
+}
 
 double QDHT::operator()(double r, Eigen::VectorXd& v)
 {
+  const auto & Jp = ker->Jp;
   double ret = 0.0;
   for (int i=0; i<N; i++) {
-    ret +=  2.0/(R*R*Jp[i]*Jp[i])*v[i]*EXPmath::cyl_bessel_j(nu, zeros[i]*r/R);
+    ret +=  2.0/(R*R*Jp[i]*Jp[i])*v[i]*EXPmath::cyl_bessel_j(nu, ker->zeros[i]*r/R);
   }
   return ret;
 }
 
+Eigen::MatrixXd QDHT::inverse(const Eigen::VectorXd& rr, const Eigen::MatrixXd& v)
+{
+  // Reuse the kernel from the last call if the radii are the same
+  //
+  if (evalR.size() != rr.size() or evalR != rr) {
+    const auto & Jp = ker->Jp;
+    evalR = rr;
+    evalB.resize(rr.size(), N);
+    for (int i=0; i<N; i++) {
+      double fac = 2.0/(R*R*Jp[i]*Jp[i]);
+      for (int j=0; j<rr.size(); j++)
+	evalB(j, i) = fac*EXPmath::cyl_bessel_j(nu, ker->zeros[i]*rr[j]/R);
+    }
+  }
+
+  return evalB * v;
+}
+
 void QDHT::check()
 {
+  const auto & T = ker->T;
   double det = T.determinant();
   std::cout << "QDHT: solution quality=" << std::fabs(det-1.0)
 	    << " det=" << det << std::endl;
@@ -32,6 +32,11 @@
 #include <string>
 #include <cmath>
 #include <map>
+#include <atomic>
+#include <thread>
+
+#include <highfive/highfive.hpp>
+#include <highfive/eigen.hpp>
 
 #include <numerical.H>
 #include <gaussQ.H>
@@ -40,6 +45,7 @@
 #include <massmodel.H>
 
 #include <QPDistF.H>
+#include <ThreadPool.H>
 
 bool QPDistF::MassEGrid    = true;
 bool QPDistF::MassLinear   = true;
@@ -47,6 +53,7 @@ int QPDistF::ITERMAX       = 1000;
 double QPDistF::ITERTOL    = 1.0e-6;
 double QPDistF::FSIGE      = 1.2;
 double QPDistF::FSIGK      = 2.0;
+int QPDistF::threads       = 0;
 
 extern "C" int ql0001_(int *m,int *me,int *mmax,int *n,int *nmax,int *mnn,
             double *c,double *d,double *a,double *b,double *xl,
@@ -254,6 +261,16 @@ void QPDistF::compute_distribution(void)
 {
   df_computed = true;
 
+  // Use the saved fit if it was made for this model and these
+  // parameters
+  //
+  if (cachefile.size() and load_state(cachefile, true)) {
+    orb = std::make_shared<SphericalOrbit>(t);
+    if (verbose>0)
+      cout << "QPDistF: read fit from <" << cachefile << ">" << endl;
+    return;
+  }
+
   //
   // Set-up model
   //
@@ -362,112 +379,122 @@ void QPDistF::compute_distribution(void)
     Dgrid[i] = t->get_density(Rgrid[i]);
   }
 
-  double vrmax, vv, th, pot, E, K, dt=0.5*M_PI/NUMT;
+  if (t->dof()!=2 and t->dof()!=3) {
+    cerr << "QPDistF: dof=" << t->dof() << ", must be 2 or 3" << endl;
+  }
+
+  // Projection of the kernels onto the radial grid.  Row k holds
+  // basis element i = ix*KGRID + iy at Rgrid[k].  The kernels are
+  // separable in E and K, so each quadrature point adds an outer
+  // product.  The radial knots are independent and are divided
+  // between threads, each with its own orbit instance.
+  //
+  int N = EGRID*KGRID;		// Number of variables
+  Eigen::MatrixXd basis(MGRID, N);
+
+  double dt=0.5*M_PI/NUMT;
   LegeQuad wk(NINT);
   orb = std::make_shared<SphericalOrbit>(t);
-  std::vector<Eigen::MatrixXd> basis(MGRID);
-  for (int k=0; k<MGRID; k++) {
 
-    basis[k].resize(EGRID, KGRID);
-    basis[k].setZero();
+  std::atomic<int> next(0);
+
+  auto work = [&](int id)
+  {
+    SphericalOrbit orbt(t);
+    Eigen::VectorXd gE(EGRID), gK(KGRID);
+    Eigen::MatrixXd bk(EGRID, KGRID);
+
+    auto add = [&](double fac, double E, double K)
+    {
+      for (int i=0; i<EGRID; i++) {
+	double z = (E - Egrid[i])/sigma_E[i];
+	gE[i] = exp(-0.5*z*z)/sigma_E[i];
+      }
+      for (int j=0; j<KGRID; j++) {
+	double z = (K - Kgrid[j])/sigma_K[j];
+	gK[j] = exp(-0.5*z*z)/sigma_K[j];
+      }
+      bk.noalias() += fac/(2.0*M_PI) * gE * gK.transpose();
+    };
+
+    for (int k=next++; k<MGRID; k=next++) {
 
+      bk.setZero();
 				// Gravitational potential at R
-    pot = t->get_pot(Rgrid[k]);
+      double pot = t->get_pot(Rgrid[k]);
 				// Maximum ("escape") velocity at R
-    vrmax = sqrt(2.0*(Emax - pot));
+      double vrmax = sqrt(2.0*(Emax - pot));
 
-    double ktmax = 0.0;
+      double ktmax = 0.0;
 
-    if (t->dof()==2) {
+      if (t->dof()==2) {
 
-      for (int iR=0; iR<NINT; iR++) {
+	for (int iR=0; iR<NINT; iR++) {
 
-	vv = vrmax * sqrt( wk.knot(iR) );
-	E = 0.5*vv*vv + pot;
+	  double vv = vrmax * sqrt( wk.knot(iR) );
+	  double E = 0.5*vv*vv + pot;
+	  orbt.new_orbit(E, 0.5);
 
-	for (int iT=1; iT<=NUMT; iT++) {
-	  th = dt * ((double)iT - 0.5);
-	  orb->new_orbit(E, 0.5);
-	  K = Rgrid[k]*vv*sin(th)/orb->Jmax();
+	  for (int iT=1; iT<=NUMT; iT++) {
+	    double th = dt * ((double)iT - 0.5);
+	    double K = Rgrid[k]*vv*sin(th)/orbt.Jmax();
 
-	  if (verbose>4) if (K>ktmax) ktmax = K;
+	    if (verbose>4) if (K>ktmax) ktmax = K;
 
-	  for (int i=0; i<EGRID; i++) {
-	    for (int j=0; j<KGRID; j++) {
-	      basis[k](i, j) += 2.0*dt*wk.weight(iR)*vrmax*vrmax *
-		kernel(E, K, Egrid[i], Kgrid[j], sigma_E[i], sigma_K[j]);
-	    }
+	    add(2.0*dt*wk.weight(iR)*vrmax*vrmax, E, K);
 	  }
-	  
 	}
-	if (verbose>4)
-	  cout << "QPDistF::compute_distribution: Kmax = " << ktmax << endl;
-      }
-    } else if (t->dof()==3) {
 
-      for (int ix=0; ix<NINT; ix++) {
-	double x = wk.knot(ix);
+      } else if (t->dof()==3) {
+
+	for (int ix=0; ix<NINT; ix++) {
+	  double x = wk.knot(ix);
 
-	for (int iy=0; iy<NINT; iy++) {
-	  double y = wk.knot(iy);
+	  for (int iy=0; iy<NINT; iy++) {
+	    double y = wk.knot(iy);
 
-	  double E = pot + 0.5*vrmax*vrmax*(x*x + (1.0-x*x)*y*y);
-	  double J = vrmax*sqrt(1.0 - x*x)*y*Rgrid[k];
+	    double E = pot + 0.5*vrmax*vrmax*(x*x + (1.0-x*x)*y*y);
+	    double J = vrmax*sqrt(1.0 - x*x)*y*Rgrid[k];
 
-	  orb->new_orbit(E, 0.5);
-	  K = J/orb->Jmax();
+	    orbt.new_orbit(E, 0.5);
+	    double K = J/orbt.Jmax();
 
-	  if (verbose>4) if (K>ktmax) ktmax = K;
+	    if (verbose>4) if (K>ktmax) ktmax = K;
 
-	  double fac = wk.weight(ix)*wk.weight(iy) * 4.0*M_PI *
-	    vrmax*vrmax*vrmax * (1.0 - x*x)*y;
+	    double fac = wk.weight(ix)*wk.weight(iy) * 4.0*M_PI *
+	      vrmax*vrmax*vrmax * (1.0 - x*x)*y;
 
-	  for (int i=0; i<EGRID; i++) {
-	    for (int j=0; j<KGRID; j++) {
-	      basis[k](i, j) += fac *
-		kernel(E, K, Egrid[i], Kgrid[j], sigma_E[i], sigma_K[j]);
-	    }
+	    add(fac, E, K);
 	  }
 	}
+
       }
-      
+
       if (verbose>4)
 	cout << "QPDistF::compute_distribution: Kmax = " << ktmax << endl;
-    } else {
-      cerr << "QPDistF: dof=" << t->dof() << ", must be 2 or 3" << endl;
-    }
 
-    /*
-      for (int iR=0; iR<NINT; iR++) {
-
-	vv = vrmax * sqrt( wk.knot(iR) );
-	E = 0.5*vv*vv + pot;
+      for (int i=0, ix=0; ix<EGRID; ix++) {
+	for (int iy=0; iy<KGRID; iy++) basis(k, i++) = bk(ix, iy);
+      }
+    }
+  };
 
-	for (int iT=1; iT<=NUMT; iT++) {
-	  th = dt * ((double)iT - 0.5);
-	  orb->new_orbit(E, 0.5);
-	  K = Rgrid[k]*vv*sin(th)/orb->Jmax();
+  int nthrds = threads>0 ? threads : std::thread::hardware_concurrency();
+  nthrds = std::max<int>(1, std::min<int>(nthrds, MGRID));
+  if (verbose>4) nthrds = 1;	// Keep the diagnostic output in order
 
-	  if (verbose>4) if (K>ktmax) ktmax = K;
+  if (nthrds>1) ThreadPool::instance().run(nthrds, work);
+  else          work(0);
 
-	  for (i=0; i<EGRID; i++) {
-	    for (j=0; j<KGRID; j++) {
-	      basis[k][i][j] += 2.0*dt*wk.weight(iR)*vrmax*vrmax * 
-		2.0*M_PI*vv*sin(th) *
-		kernel(E, K, Egrid[i], Kgrid[j], sigma_E[i], sigma_K[j]);
-	    }
-	  }
-	  
-	}
-	if (verbose>4)
-	  cout << "QPDistF::compute_distribution: Kmax = " << ktmax << endl;
+  for (int k=0; k<MGRID; k++) {
+    for (int i=0; i<N; i++) {
+      if (std::isnan(basis(k, i))) {
+	cout << "Basis NaN k=" << k << " ix=" << i/KGRID << " iy=" << i%KGRID
+	     << endl;
+	exit(-1);
       }
-    } else {
-      cerr << "QPDistF: dof=" << t->dof() << ", must be 2 or 3" << endl;
     }
-    */
   }
-  
 
   //======================================================================
   // Set up for QLD
@@ -476,7 +503,6 @@ void QPDistF::compute_distribution(void)
   int M=0;			// Number of constraints
   int ME=0;			// Number of equality constraints
   int MMAX=1;			// Row dimension of A
-  int N=EGRID*KGRID;		// Number of variables
   int NMAX=N;			// Row dimension of C
   int MNN=M+2*N;
 
@@ -519,34 +545,7 @@ void QPDistF::compute_distribution(void)
 
   
 				// Objective function
-  C.setZero();
-  
-  for (int i=0, ix=0; ix<EGRID; ix++) {
-    for (int iy=0; iy<KGRID; iy++) {
-
-      for (int j=0, jx=0; jx<EGRID; jx++) {
-	for (int jy=0; jy<KGRID; jy++) {
-	  
-	  for (int k=0; k<MGRID; k++) {
-	    C(i, j) += basis[k](ix, iy)*basis[k](jx, jy);
-	    if (std::isnan(basis[k](ix, iy))) {
-	      cout << "Basis NaN k=" << k << " ix=" << ix << " iy=" << iy
-		   << endl;
-	      exit(-1);
-	    }
-	    if (std::isnan(basis[k](jx, jy))) {
-	      cout << "Basis NaN k=" << k << " jx=" << jx << " jy=" << jy
-		   << endl;
-	      exit(-1);
-	    }
-	  
-	  }
-	  j++;
-	}
-      }
-      i++;
-    }
-  }
+  C.noalias() = basis.transpose()*basis;
 
   Eigen::MatrixXd C0(C);
 
@@ -568,19 +567,10 @@ void QPDistF::compute_distribution(void)
   }
 
 				// And constant vector
-  D.setZero();
-  for (int i=0, ix=0; ix<EGRID; ix++) {
-    for (int iy=0; iy<KGRID; iy++) {
-      for (int k=0; k<MGRID; k++)
-	D[i] -= Dgrid[k] *  basis[k](ix, iy);
-      i++;
-    }
-  }
+  D.noalias() = -basis.transpose()*Dgrid;
   
 				// Constant
-  double constant=0.0;
-  for (int k=0; k<MGRID; k++)
-    constant += Dgrid[k] * Dgrid[k];
+  double constant = Dgrid.squaredNorm();
      
 				// Limits
   for (int i=0, ix=0; ix<EGRID; ix++) {
@@ -643,16 +633,8 @@ void QPDistF::compute_distribution(void)
 
 				// Diagnostic output
 
-  obj0 = 0.5*constant;
-  obj = obj0;
-  for (int i=0; i<N; i++) {
-    for (int j=0; j<N; j++) {
-      obj0 += 0.5 * X[i] * C0(i, j) * X[j];
-      obj  += 0.5 * X[i] * C (i, j) *  X[j];
-    }
-    obj0 += D[i]*X[i];
-    obj  += D[i]*X[i];
-  }
+  obj0 = 0.5*constant + 0.5*X.dot(C0*X) + D.dot(X);
+  obj  = 0.5*constant + 0.5*X.dot(C *X) + D.dot(X);
 
   if (verbose>0) {
     cout << "----------------" << endl;
@@ -699,6 +681,7 @@ void QPDistF::compute_distribution(void)
   }
   Spline(JMAXE, JMAX, 1.0e30, 1.0e30, JMAX2);
 
+  if (cachefile.size()) write_state(cachefile);
 }
 
 
@@ -1021,104 +1004,152 @@ double QPDistF::dfdK_EK(double E, double K)
 }
 
 // Write out all the necessary information to recreate the DF from a
-// file
+// file (HDF5)
 
 void QPDistF::write_state(string& name)
 {
-  std::ofstream out(name.c_str());
-  if (!out) {
-    std::cerr << "Couldn't open <" << name << "> to save state!" << std::endl;
-    return;
+  try {
+    HighFive::File file(name, HighFive::File::Overwrite);
+
+    std::string model = t->ModelID;
+
+    file.createAttribute<std::string>("model", HighFive::DataSpace::From(model)).write(model);
+    file.createAttribute<double>("RMMAX",  HighFive::DataSpace::From(RMMAX)). write(RMMAX);
+    file.createAttribute<double>("REMAX",  HighFive::DataSpace::From(REMAX)). write(REMAX);
+    file.createAttribute<int>   ("EGRID",  HighFive::DataSpace::From(EGRID)). write(EGRID);
+    file.createAttribute<int>   ("KGRID",  HighFive::DataSpace::From(KGRID)). write(KGRID);
+    file.createAttribute<int>   ("MGRID",  HighFive::DataSpace::From(MGRID)). write(MGRID);
+    file.createAttribute<double>("SIGMA",  HighFive::DataSpace::From(SIGMA)). write(SIGMA);
+    file.createAttribute<double>("LAMBDA", HighFive::DataSpace::From(LAMBDA)).write(LAMBDA);
+    file.createAttribute<double>("ALPHA",  HighFive::DataSpace::From(ALPHA)). write(ALPHA);
+    file.createAttribute<double>("BETA",   HighFive::DataSpace::From(BETA)).  write(BETA);
+    file.createAttribute<double>("GAMA",   HighFive::DataSpace::From(GAMA)).  write(GAMA);
+    file.createAttribute<double>("ROFF",   HighFive::DataSpace::From(ROFF)).  write(ROFF);
+    file.createAttribute<double>("EOFF",   HighFive::DataSpace::From(EOFF)).  write(EOFF);
+    file.createAttribute<double>("KOFF",   HighFive::DataSpace::From(KOFF)).  write(KOFF);
+    file.createAttribute<double>("KMIN",   HighFive::DataSpace::From(KMIN)).  write(KMIN);
+    file.createAttribute<double>("KMAX",   HighFive::DataSpace::From(KMAX)).  write(KMAX);
+    file.createAttribute<int>   ("NINT",   HighFive::DataSpace::From(NINT)).  write(NINT);
+    file.createAttribute<int>   ("NUMT",   HighFive::DataSpace::From(NUMT)).  write(NUMT);
+
+    int megrid = MassEGrid ? 1 : 0, mlinear = MassLinear ? 1 : 0;
+    file.createAttribute<int>   ("MassEGrid",  HighFive::DataSpace::From(megrid)). write(megrid);
+    file.createAttribute<int>   ("MassLinear", HighFive::DataSpace::From(mlinear)).write(mlinear);
+    file.createAttribute<double>("FSIGE",      HighFive::DataSpace::From(FSIGE)).  write(FSIGE);
+    file.createAttribute<double>("FSIGK",      HighFive::DataSpace::From(FSIGK)).  write(FSIGK);
+
+    file.createAttribute<double>("obj0",   HighFive::DataSpace::From(obj0)).  write(obj0);
+    file.createAttribute<double>("obj",    HighFive::DataSpace::From(obj)).   write(obj);
+    file.createAttribute<double>("Emin",   HighFive::DataSpace::From(Emin)).  write(Emin);
+    file.createAttribute<double>("Emax",   HighFive::DataSpace::From(Emax)).  write(Emax);
+    file.createAttribute<double>("TOLE",   HighFive::DataSpace::From(TOLE)).  write(TOLE);
+
+    file.createDataSet("Egrid",   Egrid);
+    file.createDataSet("sigma_E", sigma_E);
+    file.createDataSet("Kgrid",   Kgrid);
+    file.createDataSet("sigma_K", sigma_K);
+    file.createDataSet("X",       X);
+    file.createDataSet("JMAXE",   JMAXE);
+    file.createDataSet("JMAX",    JMAX);
+    file.createDataSet("JMAX2",   JMAX2);
+
+  } catch (HighFive::Exception& err) {
+    std::cerr << "QPDistF: couldn't save state to <" << name << ">: "
+	      << err.what() << std::endl;
   }
-
-  out.write((char *)&RMMAX, sizeof(double));
-  out.write((char *)&REMAX, sizeof(double));
-  out.write((char *)&EGRID, sizeof(int));
-  out.write((char *)&KGRID, sizeof(int));
-  out.write((char *)&MGRID, sizeof(int));
-  out.write((char *)&SIGMA, sizeof(double));
-  out.write((char *)&LAMBDA, sizeof(double));
-  out.write((char *)&ALPHA, sizeof(double));
-  out.write((char *)&BETA, sizeof(double));
-  out.write((char *)&GAMA, sizeof(double));
-  out.write((char *)&ROFF, sizeof(double));
-  out.write((char *)&EOFF, sizeof(double));
-  out.write((char *)&KOFF, sizeof(double));
-  out.write((char *)&NINT, sizeof(double));
-  out.write((char *)&NUMT, sizeof(double));
-
-  out.write((char *)Egrid.data(),   EGRID*sizeof(double));
-  out.write((char *)sigma_E.data(), EGRID*sizeof(double));
-  out.write((char *)Kgrid.data(),   EGRID*sizeof(double));
-  out.write((char *)sigma_K.data(), KGRID*sizeof(double));
-  out.write((char *)X.data(),       EGRID*KGRID*sizeof(double));
-  out.write((char *)&obj0,          sizeof(double));
-  out.write((char *)&obj ,          sizeof(double));
-
-  out.write((char *)&NJMAX , sizeof(int));
-  out.write((char *)&Emin, sizeof(double));
-  out.write((char *)&Emax, sizeof(double));
-  out.write((char *)&TOLE, sizeof(double));
-  out.write((char *)JMAXE.data(), NJMAX*sizeof(double));
-  out.write((char *)JMAX.data(),  NJMAX*sizeof(double));
-  out.write((char *)JMAX2.data(), NJMAX*sizeof(double));
 }
 
 // Reinitialize the DF from a saved state
 
 void QPDistF::read_state(string& name)
 {
-  std::ifstream in(name.c_str());
-  if (!in) {
+  if (not load_state(name, false)) {
     std::cerr << "Couldn't open <" << name << "> to read state!" << std::endl;
     exit(-1);
   }
+}
 
-  in.read((char *)&RMMAX, sizeof(double));
-  in.read((char *)&REMAX, sizeof(double));
-  in.read((char *)&EGRID, sizeof(int));
-  in.read((char *)&KGRID, sizeof(int));
-  in.read((char *)&MGRID, sizeof(int));
-  in.read((char *)&SIGMA, sizeof(double));
-  in.read((char *)&LAMBDA, sizeof(double));
-  in.read((char *)&ALPHA, sizeof(double));
-  in.read((char *)&BETA, sizeof(double));
-  in.read((char *)&GAMA, sizeof(double));
-  in.read((char *)&ROFF, sizeof(double));
-  in.read((char *)&EOFF, sizeof(double));
-  in.read((char *)&KOFF, sizeof(double));
-  in.read((char *)&NINT, sizeof(double));
-  in.read((char *)&NUMT, sizeof(double));
-
-  Egrid.resize(EGRID);
-  in.read((char *)Egrid.data(), EGRID*sizeof(double));
-
-  sigma_E.resize(EGRID);
-  in.read((char *)sigma_E.data(), EGRID*sizeof(double));
-
-  Kgrid.resize(KGRID);
-  in.read((char *)Kgrid.data(), KGRID*sizeof(double));
-
-  sigma_K.resize(KGRID);
-  in.read((char *)sigma_K.data(), KGRID*sizeof(double));
-  
-  X.resize(EGRID*KGRID);
-  in.read((char *)X.data(), EGRID*KGRID*sizeof(double));
-
-  in.read((char *)&obj0, sizeof(double));
-  in.read((char *)&obj , sizeof(double));
+// Read a saved state.  If match is true, the state is only used if
+// it was computed for the current model and parameters.  Returns
+// false if the state was not used.
 
-  in.read((char *)&NJMAX , sizeof(int));
-  in.read((char *)&Emin, sizeof(double));
-  in.read((char *)&Emax, sizeof(double));
-  in.read((char *)&TOLE, sizeof(double));
+bool QPDistF::load_state(const std::string& name, bool match)
+{
+  try {
+    // Silence the HDF5 error stack
+    //
+    HighFive::SilenceHDF5 quiet;
+
+    HighFive::File file(name, HighFive::File::ReadOnly);
+
+    auto getD = [&file](const std::string& attr)
+    {
+      double v; file.getAttribute(attr).read(v); return v;
+    };
+
+    auto getI = [&file](const std::string& attr)
+    {
+      int v; file.getAttribute(attr).read(v); return v;
+    };
+
+    if (match) {
+      std::string model;
+      file.getAttribute("model").read(model);
+
+      if (model  != t->ModelID       or
+	  RMMAX  != getD("RMMAX")    or REMAX  != getD("REMAX")  or
+	  EGRID  != getI("EGRID")    or KGRID  != getI("KGRID")  or
+	  MGRID  != getI("MGRID")    or SIGMA  != getD("SIGMA")  or
+	  LAMBDA != getD("LAMBDA")   or ALPHA  != getD("ALPHA")  or
+	  BETA   != getD("BETA")     or GAMA   != getD("GAMA")   or
+	  ROFF   != getD("ROFF")     or EOFF   != getD("EOFF")   or
+	  KOFF   != getD("KOFF")     or KMIN   != getD("KMIN")   or
+	  KMAX   != getD("KMAX")     or NINT   != getI("NINT")   or
+	  NUMT   != getI("NUMT")     or
+	  FSIGE  != getD("FSIGE")    or FSIGK  != getD("FSIGK")  or
+	  int(MassEGrid)  != getI("MassEGrid")                   or
+	  int(MassLinear) != getI("MassLinear")) return false;
+    }
 
-  JMAXE.resize(NJMAX);
-  JMAX .resize(NJMAX);
-  JMAX2.resize(NJMAX);
+    RMMAX  = getD("RMMAX");
+    REMAX  = getD("REMAX");
+    EGRID  = getI("EGRID");
+    KGRID  = getI("KGRID");
+    MGRID  = getI("MGRID");
+    SIGMA  = getD("SIGMA");
+    LAMBDA = getD("LAMBDA");
+    ALPHA  = getD("ALPHA");
+    BETA   = getD("BETA");
+    GAMA   = getD("GAMA");
+    ROFF   = getD("ROFF");
+    EOFF   = getD("EOFF");
+    KOFF   = getD("KOFF");
+    KMIN   = getD("KMIN");
+    KMAX   = getD("KMAX");
+    NINT   = getI("NINT");
+    NUMT   = getI("NUMT");
+
+    obj0   = getD("obj0");
+    obj    = getD("obj");
+    Emin   = getD("Emin");
+    Emax   = getD("Emax");
+    TOLE   = getD("TOLE");
+
+    Egrid   = file.getDataSet("Egrid")  .read<Eigen::VectorXd>();
+    sigma_E = file.getDataSet("sigma_E").read<Eigen::VectorXd>();
+    Kgrid   = file.getDataSet("Kgrid")  .read<Eigen::VectorXd>();
+    sigma_K = file.getDataSet("sigma_K").read<Eigen::VectorXd>();
+    X       = file.getDataSet("X")      .read<Eigen::VectorXd>();
+    JMAXE   = file.getDataSet("JMAXE")  .read<Eigen::VectorXd>();
+    JMAX    = file.getDataSet("JMAX")   .read<Eigen::VectorXd>();
+    JMAX2   = file.getDataSet("JMAX2")  .read<Eigen::VectorXd>();
+
+    NJMAX  = JMAXE.size();
+    IFAIL  = 0;
+
+  } catch (HighFive::Exception& err) {
+    return false;
+  }
 
-  in.read((char *)JMAXE.data(), NJMAX*sizeof(double));
-  in.read((char *)JMAX.data(),  NJMAX*sizeof(double));
-  in.read((char *)JMAX2.data(), NJMAX*sizeof(double));
+  return true;
 }
-
@@ -16,8 +16,11 @@
 #include <iomanip>
 #include <cstdlib>
 #include <vector>
+#include <atomic>
+#include <thread>
 
 #include <EXPException.H>
+#include <ThreadPool.H>
 #include <SLGridMP2.H>
 #include <massmodel.H>
 #include <EXPmath.H>
@@ -78,8 +81,25 @@ std::string sledge_error(int flag)
   }
 }
 
-static double L2, M2, K2;
-static int sl_dim;
+// Per thread, so that independent problems may be solved
+// concurrently (see extend_table)
+static thread_local double L2, M2, K2;
+static thread_local int sl_dim;
+
+// Number of threads for table construction.  SLEDGE keeps its state
+// in COMMON blocks that are thread private only when it is compiled
+// with OpenMP.
+//
+static int table_threads(int threads, bool mpi)
+{
+#ifdef _OPENMP
+  if (threads>0) return threads;
+  if (mpi)       return 1;
+  return std::max<int>(1, std::thread::hardware_concurrency());
+#else
+  return 1;
+#endif
+}
 
 
 //======================================================================
@@ -88,6 +108,7 @@ static int sl_dim;
 
 
 int SLGridSph::mpi = 0;		// initially off
+int SLGridSph::threads = 0;	// default count
 
 extern "C" {
   int sledge_(logical* job, doublereal* cons, logical* endfin, 
@@ -429,11 +450,7 @@ void SLGridSph::initialize(int LMAX, int NMAX, int NUMR,
 
       table = table_ptr_1D(new TableSph [lmax+1]);
 
-      for (l=0; l<=lmax; l++) {
-	if (tbdbg) std::cerr << "Begin [" << l << "] . . ." << std::endl;
-	compute_table(&(table[l]), l);
-	if (tbdbg) std::cerr << ". . . done" << std::endl;
-      }
+      extend_table(-1, 0);
     }
     // END single process stanza
 
@@ -442,6 +459,16 @@ void SLGridSph::initialize(int LMAX, int NMAX, int NUMR,
     if (myid==0 and cache) WriteH5Cache();
   }
   // END: make tables
+  else if (lcache<lmax or ncache<nmax) {
+
+    // Solve only the harmonics and orders missing from the cache
+    //
+    if (mpi) mpi_setup();
+
+    extend_table(lcache, ncache);
+
+    if (myid==0) WriteH5Cache();
+  }
 
   if (tbdbg)
     std::cerr << "Process " << myid << ": exiting constructor" << std::endl;
@@ -482,6 +509,9 @@ void check_vector_values_SL(const Eigen::VectorXd& v)
 
 bool SLGridSph::ReadH5Cache(void)
 {
+  lcache = -1;
+  ncache = 0;
+
   if (!cache) return false;
 
   // First attempt to read the file
@@ -555,8 +585,6 @@ bool SLGridSph::ReadH5Cache(void)
     // Parameter check
     //
     if (not checkStr(modl,     "model"))     return false;
-    if (not checkInt(lmax,     "lmax"))      return false;
-    if (not checkInt(nmax,     "nmax"))      return false;
     if (not checkInt(numr,     "numr"))      return false;
     if (not checkInt(cmap,     "cmap"))      return false;
     if (not checkDbl(rmin,     "rmin"))      return false;
@@ -572,6 +600,21 @@ bool SLGridSph::ReadH5Cache(void)
       if (not checkDbl(rmap,   "rmapping"))  return false;
     }
 
+    // A cache with fewer harmonics or orders than wanted is read and
+    // then extended (see initialize)
+    //
+    h5file.getAttribute("lmax").read(lcache);
+    h5file.getAttribute("nmax").read(ncache);
+
+    if (lcache > lmax or ncache > nmax) {
+      if (myid==0)
+	std::cout << "---- SLGridSph::ReadH5Cache: "
+		  << "cache has lmax=" << lcache << ", nmax=" << ncache
+		  << "; wanted at most lmax=" << lmax << ", nmax=" << nmax
+		  << std::endl;
+      return false;
+    }
+
     // Harmonic order
     //
     auto harmonic = h5file.getGroup("Harmonic");
@@ -580,7 +623,7 @@ bool SLGridSph::ReadH5Cache(void)
     //
     table = table_ptr_1D(new TableSph [lmax+1]);
 
-    for (int l=0; l<=lmax; l++) {
+    for (int l=0; l<=lcache; l++) {
       std::ostringstream sout;
       sout << l;
       auto arrays = harmonic.getGroup(sout.str());
@@ -591,10 +634,15 @@ bool SLGridSph::ReadH5Cache(void)
       arrays.getDataSet("ef").read<Eigen::MatrixXd>(table[l].ef);
     }
     
-    if (myid==0)
+    if (myid==0) {
       std::cout << "---- SLGridSph::ReadH5Cache: "
 		<< "successfully read basis cache <" << sph_cache_name
 		<< ">" << std::endl;
+      if (lcache<lmax or ncache<nmax)
+	std::cout << "---- SLGridSph::ReadH5Cache: "
+		  << "extending from lmax=" << lcache << ", nmax=" << ncache
+		  << std::endl;
+    }
 
     return true;
     
@@ -977,6 +1025,135 @@ void SLGridSph::get_force(Eigen::MatrixXd& mat, double x, int which)
 }
 
 
+void SLGridSph::batch_xi(const double* r, int nb, int which,
+			 std::vector<double>& x)
+{
+  x.resize(nb);
+
+  for (int b=0; b<nb; b++) {
+    double xx = r[b];
+    if (which || !cmap)
+      xx = r_to_xi(xx);
+    else {
+      if (cmap==1) {
+	if (xx<-1.0) xx=-1.0;
+	if (xx>=1.0) xx=1.0-XOFFSET;
+      }
+      if (cmap==2) {
+	if (xx<xmin) xx=xmin;
+	if (xx>xmax) xx=xmax;
+      }
+    }
+    x[b] = xx;
+  }
+}
+
+void SLGridSph::get_pot_batch(Eigen::MatrixXd& mat, const double* r, int nb,
+			      int which)
+{
+  // Per-thread work space for the grid indices and weights
+  //
+  thread_local std::vector<double> x, w1, w2;
+  thread_local std::vector<int> ix;
+
+  batch_xi(r, nb, which, x);
+
+  ix.resize(nb);
+  w1.resize(nb);
+  w2.resize(nb);
+
+  for (int b=0; b<nb; b++) {
+    int indx = (int)( (x[b]-xmin)/dxi );
+    if (indx<0) indx = 0;
+    if (indx>numr-2) indx = numr - 2;
+
+    double x1 = (xi[indx+1] - x[b])/dxi;
+    double x2 = (x[b] - xi[indx])/dxi;
+#ifdef USE_TABLE
+    double pf = x1*p0[indx] + x2*p0[indx+1];
+#else
+    double pf = sphpot(xi_to_r(x[b]));
+#endif
+    ix[b] = indx;
+    w1[b] = x1*pf;
+    w2[b] = x2*pf;
+  }
+
+  mat.resize(nb, (lmax+1)*nmax);
+
+  for (int l=0; l<=lmax; l++) {
+    const double* ef = table[l].ef.data();
+    const int     ld = table[l].ef.rows();
+
+    for (int n=0; n<nmax; n++) {
+      const double fac = 1.0/sqrt(table[l].ev[n]);
+      const int*    ip = ix.data();
+      const double* a  = w1.data();
+      const double* c  = w2.data();
+      double* out = &mat(0, l*nmax + n);
+
+#pragma omp simd
+      for (int b=0; b<nb; b++) {
+	int i = n + ip[b]*ld;
+	out[b] = (a[b]*ef[i] + c[b]*ef[i+ld])*fac;
+      }
+    }
+  }
+}
+
+void SLGridSph::get_force_batch(Eigen::MatrixXd& mat, const double* r, int nb,
+				int which)
+{
+  // Per-thread work space for the grid indices and weights
+  //
+  thread_local std::vector<double> x, w0, w1, w2;
+  thread_local std::vector<int> ix;
+
+  batch_xi(r, nb, which, x);
+
+  ix.resize(nb);
+  w0.resize(nb);
+  w1.resize(nb);
+  w2.resize(nb);
+
+  for (int b=0; b<nb; b++) {
+    int indx = (int)( (x[b]-xmin)/dxi );
+    if (indx<1) indx = 1;
+    if (indx>numr-2) indx = numr - 2;
+
+    double p   = (x[b] - xi[indx])/dxi;
+    double fac = d_xi_to_r(x[b])/dxi;
+
+    ix[b] = indx;
+    w0[b] =  fac*(p - 0.5)*p0[indx-1];
+    w1[b] = -fac*2.0*p    *p0[indx  ];
+    w2[b] =  fac*(p + 0.5)*p0[indx+1];
+  }
+
+  mat.resize(nb, (lmax+1)*nmax);
+
+  for (int l=0; l<=lmax; l++) {
+    const double* ef = table[l].ef.data();
+    const int     ld = table[l].ef.rows();
+
+    for (int n=0; n<nmax; n++) {
+      const double fac = 1.0/sqrt(table[l].ev[n]);
+      const int*    ip = ix.data();
+      const double* a  = w0.data();
+      const double* c  = w1.data();
+      const double* d  = w2.data();
+      double* out = &mat(0, l*nmax + n);
+
+#pragma omp simd
+      for (int b=0; b<nb; b++) {
+	int i = n + ip[b]*ld;
+	out[b] = (a[b]*ef[i-ld] + c[b]*ef[i] + d[b]*ef[i+ld])*fac;
+      }
+    }
+  }
+}
+
+
 void SLGridSph::get_pot(Eigen::VectorXd& vec, double x, int l, int which)
 {
   if (which || !cmap)
@@ -1088,7 +1265,7 @@ void SLGridSph::get_force(Eigen::VectorXd& vec, double x, int l, int which)
 
 }
 
-void SLGridSph::compute_table(struct TableSph* table, int l)
+void SLGridSph::compute_table(struct TableSph* table, int l, int nfirst)
 {
 
   double cons[8] = {0.0, 0.0, 0.0, 0.0,   0.0, 0.0,   0.0, 0.0};
@@ -1108,7 +1285,7 @@ void SLGridSph::compute_table(struct TableSph* table, int l)
   cons[7] = rmax;
   L2 = l*(l+1);
   NUM = numr;
-  N = nmax;
+  N = nmax - nfirst;		// Orders nfirst through nmax-1
   
   // integer iflag[nmax], invec[nmax+3];
   integer *iflag = new integer [nmax];
@@ -1145,7 +1322,7 @@ void SLGridSph::compute_table(struct TableSph* table, int l)
   invec[1] = 3;			// spectrum is ignored
   invec[2] = N;			// estimates for N eigenvalues/functions
 
-  for (int i=0; i<N; i++) invec[3+i] = i;
+  for (int i=0; i<N; i++) invec[3+i] = nfirst + i;
 
   //
   //     Set the JOB(*) vector:
@@ -1262,12 +1439,12 @@ void SLGridSph::compute_table(struct TableSph* table, int l)
     }
   }
   
-				// Load table
-
-  table->ev.resize(N);
-  for (int i=0; i<N; i++) table->ev[i] = ev[i];
+				// Load table, keeping the orders
+				// below nfirst
+  table->ev.conservativeResize(nmax);
+  for (int i=0; i<N; i++) table->ev[nfirst+i] = ev[i];
 
-  table->ef.resize(N, numr);
+  table->ef.conservativeResize(nmax, numr);
 
   // Choose sign conventions for the ef table
   //
@@ -1279,7 +1456,7 @@ void SLGridSph::compute_table(struct TableSph* table, int l)
   
   for (int i=0; i<numr; i++) {
     for(int j=0; j<N; j++) 
-      table->ef(j, i) = ef[j*NUM+i] * sgn(j);
+      table->ef(nfirst+j, i) = ef[j*NUM+i] * sgn(j);
   }
 
   table->l = l;
@@ -1295,6 +1472,48 @@ void SLGridSph::compute_table(struct TableSph* table, int l)
 }
 
 
+void SLGridSph::extend_table(int lc, int nc)
+{
+  auto missing = [&](int l) { return l>lc or nc<nmax; };
+
+  // This process's share of the harmonics
+  //
+  std::vector<int> work;
+  for (int l=0; l<=lmax; l++) {
+    if (not missing(l)) continue;
+    if (mpi and l % mpi_numprocs != mpi_myid) continue;
+    work.push_back(l);
+  }
+
+  // The solves are independent; hand them out one at a time since
+  // their cost varies with l
+  //
+  std::atomic<int> next(0);
+
+  ThreadPool::instance().run(table_threads(threads, mpi), [&](int)
+  {
+    for (int k=next++; k<static_cast<int>(work.size()); k=next++) {
+      int l = work[k];
+      if (tbdbg) std::cerr << "Begin [" << l << "] . . ." << std::endl;
+      compute_table(&table[l], l, l>lc ? 0 : nc);
+      if (tbdbg) std::cerr << ". . . done [" << l << "]" << std::endl;
+    }
+  });
+
+  // Share the new tables
+  //
+  if (mpi) {
+    for (int l=0; l<=lmax; l++) {
+      if (not missing(l)) continue;
+      int root = l % mpi_numprocs;
+      if (root == mpi_myid) mpi_pack_table(&table[l], l);
+      MPI_Bcast(&mpi_buf[0], mpi_bufsz, MPI_PACKED, root, MPI_COMM_WORLD);
+      if (root != mpi_myid) mpi_unpack_table();
+    }
+  }
+}
+
+
 void SLGridSph::init_table(void)
 {
   xi.resize(numr);
@@ -1702,44 +1921,40 @@ std::vector<Eigen::MatrixXd> SLGridSph::orthoCheck(int num)
   double ximin = r_to_xi(rmin);
   double ximax = r_to_xi(rmax);
 
-  // Initialize the return matrices
-  std::vector<Eigen::MatrixXd> ret(lmax+1);
-  for (auto & v : ret) v.resize(nmax, nmax);
-
-  // Do each harmonic order
-  for (int L=0; L<=lmax; L++) {
+  // Tabulate all (l, n) at each knot once.  P[L] and D[L] have one
+  // row per knot; the quadrature weight and Jacobian are folded into
+  // the potential.
+  std::vector<Eigen::MatrixXd> P(lmax+1), D(lmax+1);
+  for (auto & v : P) v.resize(num, nmax);
+  for (auto & v : D) v.resize(num, nmax);
 
-    // Unroll the loop for OpenMP parallelization
 #pragma omp parallel for
-    for (int nn=0; nn<nmax*nmax; nn++) {
-      int n1 = nn/nmax;
-      int n2 = nn - n1*nmax;
-      
-      // The inner product
-      double ans=0.0;
-      for (int i=0; i<num; i++) {
-	
-	double x = ximin + (ximax - ximin)*lw.knot(i);
-	double r = xi_to_r(x);
-	  
-	ans += r*r*get_pot(x, L, n1, 0)*
-	  get_dens(x, L, n2, 0) /
-	  d_xi_to_r(x) * (ximax - ximin)*lw.weight(i);
-	  
-      }
-      // END: inner product
-	    
-      // Assign the matrix element
-      //
-      ret[L](n1, n2) = - ans;
-      //               ^
-      //               |
-      //               +--- Switch to normed scalar product rather
-      //                    that normed gravitational energy
+  for (int i=0; i<num; i++) {
+    double x = ximin + (ximax - ximin)*lw.knot(i);
+    double r = xi_to_r(x);
+    double w = r*r/d_xi_to_r(x) * (ximax - ximin)*lw.weight(i);
+
+    Eigen::MatrixXd pt, dt;
+    get_pot (pt, x, 0);
+    get_dens(dt, x, 0);
+
+    for (int L=0; L<=lmax; L++) {
+      P[L].row(i) = w*pt.row(L);
+      D[L].row(i) = dt.row(L);
     }
-    // END: unrolled loop
   }
-  // END: harmonic order loop
+
+  // Each inner-product matrix is then one matrix product
+  std::vector<Eigen::MatrixXd> ret(lmax+1);
+
+#pragma omp parallel for
+  for (int L=0; L<=lmax; L++) {
+    ret[L] = - P[L].transpose() * D[L];
+    //       ^
+    //       |
+    //       +--- Switch to normed scalar product rather
+    //            that normed gravitational energy
+  }
   
   return ret;
 }
@@ -1751,12 +1966,13 @@ std::vector<Eigen::MatrixXd> SLGridSph::orthoCheck(int num)
 
 int    SLGridSlab::mpi   = 0;	// initially off
 int    SLGridSlab::cache = 1;	// initially yes
+int    SLGridSlab::threads = 0;	// default count
 double SLGridSlab::H     = 0.1;	// Scale height
 double SLGridSlab::L     = 1.0;	// Periodic box size
 double SLGridSlab::ZBEG  = 0.0;	// Offset on from origin
 double SLGridSlab::ZEND  = 0.0;	// Offset on potential zero
 
-static double KKZ;
+static thread_local double KKZ;
 
 static double poffset=0.0;
 
@@ -2044,6 +2260,12 @@ SLGridSlab::SLGridSlab(int NUMK, int NMAX, int NUMZ, double ZMAX,
 	if (cache) WriteH5Cache();
 
       }
+      else if (kcache<numk or ncache<nmax) {
+				// Solve only the wave numbers and
+				// orders missing from the cache
+	extend_table(kcache, ncache);
+	WriteH5Cache();
+      }
 
       //
       // <Tell workers to continue>
@@ -2096,17 +2318,16 @@ SLGridSlab::SLGridSlab(int NUMK, int NMAX, int NUMZ, double ZMAX,
 
     if (!ReadH5Cache()) {
 
-      for (kx=0; kx<=numk; kx++) {
-	for (ky=0; ky<=kx; ky++) {
-	  if (tbdbg) std::cerr << "Begin [" << kx << ", " << ky << "] . . ."
-			       << std::endl;
-	  compute_table(&(table[kx][ky]), kx, ky);
-	  if (tbdbg) std::cerr << ". . . done" << std::endl;
-	}
-      }
+      extend_table(-1, 0);
 
       if (cache) WriteH5Cache();
     }
+    else if (kcache<numk or ncache<nmax) {
+				// Solve only the wave numbers and
+				// orders missing from the cache
+      extend_table(kcache, ncache);
+      WriteH5Cache();
+    }
   }
 
   if (tbdbg)
@@ -2119,6 +2340,9 @@ const string slab_cache_name = ".slgrid_slab_cache";
 
 bool SLGridSlab::ReadH5Cache(void)
 {
+  kcache = -1;
+  ncache = 0;
+
   if (!cache) return false;
 
   // First attempt to read the file
@@ -2179,8 +2403,6 @@ bool SLGridSlab::ReadH5Cache(void)
     // Parameter check
     //
     if (not checkStr(type,     "type"))      return false;
-    if (not checkInt(numk,     "numk"))      return false;
-    if (not checkInt(nmax,     "nmax"))      return false;
     if (not checkInt(numz,     "numz"))      return false;
     if (not checkDbl(H,        "H"))         return false;
     if (not checkDbl(L,        "L"))         return false;
@@ -2188,6 +2410,21 @@ bool SLGridSlab::ReadH5Cache(void)
     if (not checkDbl(ZBEG,     "ZBEG"))      return false;
     if (not checkDbl(ZEND,     "ZEND"))      return false;
 
+    // A cache with fewer wave numbers or orders than wanted is read
+    // and then extended (see the constructor)
+    //
+    h5file.getAttribute("numk").read(kcache);
+    h5file.getAttribute("nmax").read(ncache);
+
+    if (kcache > numk or ncache > nmax) {
+      if (myid==0)
+	std::cout << "---- SLGridSlab::ReadH5Cache: "
+		  << "cache has numk=" << kcache << ", nmax=" << ncache
+		  << "; wanted at most numk=" << numk << ", nmax=" << nmax
+		  << std::endl;
+      return false;
+    }
+
     // Harmonic order
     //
     auto harmonic = h5file.getGroup("Harmonic");
@@ -2199,7 +2436,7 @@ bool SLGridSlab::ReadH5Cache(void)
     for (int kx=0; kx<=numk; kx++)
       table[kx] = table_ptr_1D(new TableSlab [kx+1]);
 
-    for (int kx=0; kx<=numk; kx++) {
+    for (int kx=0; kx<=kcache; kx++) {
       for (int ky=0; ky<=kx; ky++) {
 	std::ostringstream sout;
 	sout << kx << " " << ky;
@@ -2210,10 +2447,15 @@ bool SLGridSlab::ReadH5Cache(void)
       }
     }
     
-    if (myid==0)
+    if (myid==0) {
       std::cout << "---- SLGridSlab::ReadH5Cache: "
 		<< "successfully read basis cache <" << slab_cache_name
 		<< ">" << std::endl;
+      if (kcache<numk or ncache<nmax)
+	std::cout << "---- SLGridSlab::ReadH5Cache: "
+		  << "extending from numk=" << kcache << ", nmax=" << ncache
+		  << std::endl;
+    }
 
     return true;
     
@@ -2365,6 +2607,21 @@ double SLGridSlab::get_pot(double x, int kx, int ky, int n, int which)
 }
 
 
+void SLGridSlab::pot_cell(double z, int& indx, double& x1, double& x2, int& sign)
+{
+  sign = z<0.0 ? -1 : 1;
+
+  double x = mM->z_to_xi(fabs(z));
+
+  indx = (int)( (x-xmin)/dxi );
+  if (indx<0) indx = 0;
+  if (indx>numz-2) indx = numz - 2;
+
+  x1 = (xi[indx+1] - x)/dxi;
+  x2 = (x - xi[indx])/dxi;
+}
+
+
 double SLGridSlab::get_dens(double x, int kx, int ky, int n, int which)
 {
   int hold;
@@ -2674,7 +2931,8 @@ void SLGridSlab::get_force(Eigen::VectorXd& vec, double x, int kx, int ky, int w
 
 }
 
-void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
+void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY,
+			       int nfirst)
 {
   double cons[8]    = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, ZBEG, zmax};
   double tol[6]     = {1.0e-6, 1.0e-7, 1.0e-6,1.0e-7, 1.0e-6,1.0e-7};
@@ -2692,6 +2950,11 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 				// and antisymmetric (keeping equal number
 				// of each or one more symmetric
   N = (int)( 0.5*nmax + 0.501);
+				// Orders below nfirst are already in
+				// the table: N0 symmetric and M0
+				// antisymmetric of M in total
+  int N0 = (int)( 0.5*nfirst + 0.501);
+  int M  = nmax - N, M0 = nfirst - N0;
   
   integer *iflag = new integer [nmax];
   integer *invec = new integer [nmax+3];
@@ -2726,9 +2989,9 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 
   invec[0] = VERBOSE;		// little printing (1), no printing (0)
   invec[1] = 3;			// spectrum is ignored
-  invec[2] = N;			// estimates for N eigenvalues/functions
+  invec[2] = N - N0;		// estimates for N-N0 eigenvalues/functions
 
-  for (int i=0; i<N; i++) invec[3+i] = i;
+  for (int i=0; i<N-N0; i++) invec[3+i] = N0 + i;
 
   //
   //     Set the JOB(*) vector:
@@ -2749,15 +3012,16 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
   //
   sl_dim = 1;
 
-  sledge_(job, cons, endfin, invec, tol, type, ev, &NUM, xef, ef, pdef,
-	   t, rho, iflag, store);
+  if (N > N0)
+    sledge_(job, cons, endfin, invec, tol, type, ev, &NUM, xef, ef, pdef,
+	    t, rho, iflag, store);
 
   //
   //     Check for errors
   //
 #ifdef SLEDGE_THROW
   unsigned bad = 0;		// Number of non-zero iflag values
-  for (int i=0; i<N; i++) {
+  for (int i=0; i<N-N0; i++) {
     if (iflag[i] != 0) bad++;
   }
 
@@ -2786,7 +3050,7 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 		<< std::setw(40) << "---------"
 		<< std::endl;
       
-      for (int i=0; i<N; i++) {
+      for (int i=0; i<N-N0; i++) {
 	std::cout << std::setw(15) << invec[3+i] 
 		  << std::setw(15) << ev[i]
 		  << std::setw(40) << sledge_error(iflag[i])
@@ -2818,7 +3082,7 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
     std::cout.setf(ios::scientific);
 
     std::cout << "Even:" << std::endl;
-    for (int i=0; i<N; i++) {
+    for (int i=0; i<N-N0; i++) {
       std::cout << std::setw(15) << invec[3+i] 
 		<< std::setw(15) << ev[i]
 		<< std::setw( 5) << iflag[i]
@@ -2848,25 +3112,25 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 
   // Allocate memory for table
   //
-  table->ev.resize(nmax);
-  table->ef.resize(nmax, numz);
+  table->ev.conservativeResize(nmax);
+  table->ef.conservativeResize(nmax, numz);
 
   // Load table
   //
-  for (int i=0; i<N; i++) table->ev[i*2] = ev[i];
+  for (int i=0; i<N-N0; i++) table->ev[(N0+i)*2] = ev[i];
 
   // Choose sign conventions for the ef table
   //
   {
     int nfid = std::min<int>(nevsign, NUM) - 1;
-    Eigen::VectorXi sgn = Eigen::VectorXi::Ones(N);
-    for (int j=0; j<N; j++) {
+    Eigen::VectorXi sgn = Eigen::VectorXi::Ones(N-N0);
+    for (int j=0; j<N-N0; j++) {
       if (ef[j*NUM+nfid]<0.0) sgn(j) = -1;
     }
   
     for (int i=0; i<numz; i++) {
-      for (int j=0; j<N; j++) 
-	table->ef(j*2, i) = ef[j*NUM+i] * sgn(j);
+      for (int j=0; j<N-N0; j++) 
+	table->ef((N0+j)*2, i) = ef[j*NUM+i] * sgn(j);
     }
   }
 
@@ -2875,16 +3139,19 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
   cons[2] = 0.0;
 
 				// Redo to get antisymmetric functions
+  invec[2] = M > M0 ? std::max<int>(N - N0, M - M0) : 0;
+  for (int i=0; i<invec[2]; i++) invec[3+i] = M0 + i;
 
-  sledge_(job, cons, endfin, invec, tol, type, ev, &NUM, xef, ef, pdef,
-	  t, rho, iflag, store);
+  if (M > M0)
+    sledge_(job, cons, endfin, invec, tol, type, ev, &NUM, xef, ef, pdef,
+	    t, rho, iflag, store);
 
   //
   //     Check for errors
   //
 #ifdef SLEDGE_THROW
   bad = 0;			// Accumulate sledge error count
-  for (int i=0; i<N; i++) {
+  for (int i=0; i<invec[2]; i++) {
     if (iflag[i] != 0) bad++;
   }
 
@@ -2912,7 +3179,7 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 		<< std::setw(40) << "---------"
 		<< std::endl;
       
-      for (int i=0; i<N; i++) {
+      for (int i=0; i<invec[2]; i++) {
 	std::cout << std::setw(15) << invec[3+i] 
 		  << std::setw(15) << ev[i]
 		  << std::setw(40) << sledge_error(iflag[i])
@@ -2943,7 +3210,7 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
     std::cout.setf(ios::scientific);
     
     std::cout << "Odd:" << std::endl;
-    for (int i=0; i<N; i++) {
+    for (int i=0; i<invec[2]; i++) {
       std::cout << std::setw(15) << invec[3+i] 
 		<< std::setw(15) << ev[i]
 		<< std::setw( 5) << iflag[i]
@@ -2970,9 +3237,9 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 
 				// Load table
 
-  N = nmax - N;
+  N = M - M0;
 
-  for (int i=0; i<N; i++) table->ev[i*2+1] = ev[i];
+  for (int i=0; i<N; i++) table->ev[(M0+i)*2+1] = ev[i];
 
   // Choose sign conventions for the ef table
   //
@@ -2985,12 +3252,12 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
   
     for (int i=0; i<numz; i++) {
       for (int j=0; j<N; j++) 
-	table->ef(j*2+1, i) = ef[j*NUM+i] * sgn(j);
+	table->ef((M0+j)*2+1, i) = ef[j*NUM+i] * sgn(j);
     }
   }
 
 				// Correct for symmetrizing
-  table->ef *= 7.071067811865475e-01;
+  table->ef.bottomRows(nmax - nfirst) *= 7.071067811865475e-01;
 
   table->kx = KX;
   table->ky = KY;
@@ -3005,6 +3272,31 @@ void SLGridSlab::compute_table(struct TableSlab* table, int KX, int KY)
 }
 
 
+void SLGridSlab::extend_table(int kc, int nc)
+{
+  std::vector<std::pair<int, int>> work;
+  for (int kx=0; kx<=numk; kx++) {
+    for (int ky=0; ky<=kx; ky++) {
+      if (kx>kc or nc<nmax) work.push_back({kx, ky});
+    }
+  }
+
+  std::atomic<int> next(0);
+
+  ThreadPool::instance().run(table_threads(threads, false), [&](int)
+  {
+    for (int k=next++; k<static_cast<int>(work.size()); k=next++) {
+      int kx = work[k].first, ky = work[k].second;
+      if (tbdbg) std::cerr << "Begin [" << kx << ", " << ky << "] . . ."
+			   << std::endl;
+      compute_table(&table[kx][ky], kx, ky, kx>kc ? 0 : nc);
+      if (tbdbg) std::cerr << ". . . done [" << kx << ", " << ky << "]"
+			   << std::endl;
+    }
+  });
+}
+
+
 void SLGridSlab::init_table(void)
 {
   xi.resize(numz);
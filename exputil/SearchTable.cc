@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+
+#include <SearchTable.H>
+
+void SearchTable::initialize()
+{
+  n = xv.size();
+  spacing = Spacing::General;
+  x0 = 0.0;
+  dx = 1.0;
+
+  if (n < 2) return;
+
+  // Uniform in x or in log x to rounding?
+  //
+  auto uniform = [this](auto f, double& a, double& h)
+  {
+    a = f(xv[0]);
+    h = (f(xv[n-1]) - a)/(n-1);
+    if (not (h > 0.0)) return false;
+    for (int i=1; i<n; i++) {
+      if (fabs(f(xv[i]) - (a + h*i)) > 1.0e-8*h) return false;
+    }
+    return true;
+  };
+
+  if (uniform([](double z) { return z; }, x0, dx)) {
+    spacing = Spacing::Linear;
+    return;
+  }
+
+  if (xv[0] > 0.0 and
+      uniform([](double z) { return log(z); }, x0, dx)) {
+    spacing = Spacing::Logarithmic;
+    return;
+  }
+
+  // Bucket index: one bucket per knot on average
+  //
+  x0 = xv[0];
+  dx = (xv[n-1] - xv[0])/(n-1);
+  if (not (dx > 0.0)) dx = 1.0;
+
+  bucket.resize(n+1);
+  for (int j=0, k=0; j<=n; j++) {
+    double edge = x0 + dx*j;
+    while (k < n-2 and xv[k+1] <= edge) k++;
+    bucket[j] = k;
+  }
+}
+
+int SearchTable::index(double v) const
+{
+  if (n < 2) return 0;
+
+  double f;
+
+  switch (spacing) {
+  case Spacing::Linear:
+    f = std::floor((v - x0)/dx);
+    break;
+  case Spacing::Logarithmic:
+    f = v > 0.0 ? std::floor((log(v) - x0)/dx) : 0.0;
+    break;
+  default:
+    {
+      f = std::floor((v - x0)/dx);
+      if (not (f >= 0.0)) return 0;
+      if (f >= n)  f = n;
+      int j  = static_cast<int>(f);
+      int lo = bucket[j];
+      int hi = j<n ? bucket[j+1] : n-2;
+      return lo + partition_point(xv.data() + lo + 1, hi - lo,
+				  [v](double z) { return z <= v; });
+    }
+  }
+
+  int k = static_cast<int>(std::clamp<double>(f, 0.0, n-2));
+
+  // Correct the rounding
+  //
+  while (k > 0   and xv[k]   >  v) k--;
+  while (k < n-2 and xv[k+1] <= v) k++;
+
+  return k;
+}
+
+void SearchTable::locate_many(const double* v, int m, int* k) const
+{
+  if (m <= 0) return;
+
+  int j = index(v[0]);
+  k[0] = j;
+
+  for (int i=1; i<m; i++) {
+    while (j < n-2 and xv[j+1] <= v[i]) j++;
+    k[i] = j;
+  }
+}
@@ -0,0 +1,246 @@
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+#include <yaml-cpp/yaml.h>
+
+#include <mpi.h>
+
+#include <SnapshotIndex.H>
+#include <EXPException.H>
+
+namespace PR
+{
+  //! Increment when the layout of the sidecar file changes
+  static const int indexVersion = 1;
+
+  SnapshotIndex::SnapshotIndex
+  (const std::string& reader,
+   const std::vector<std::vector<std::string>>& batches,
+   const std::string& indexfile, bool verbose) :
+    reader(reader), indexfile(indexfile), verbose(verbose)
+  {
+    int flag;
+    MPI_Initialized(&flag);
+    if (flag) MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    else      myid = 0;
+
+    // Default sidecar in the directory of the first snapshot
+    //
+    if (this->indexfile.empty()) {
+      std::filesystem::path dir(".");
+      if (batches.size() and batches[0].size())
+	dir = std::filesystem::path(batches[0][0]).parent_path();
+      if (dir.empty()) dir = ".";
+      this->indexfile = (dir / (".snapindex." + reader + ".yaml")).string();
+    }
+
+    load();
+
+    // Check the requested snapshots against the index
+    //
+    unsigned scanned = 0;
+
+    for (auto & b : batches) {
+      if (b.empty()) continue;
+
+      std::vector<unsigned long long> sizes;
+      std::vector<long long> mtimes;
+      if (not stamp(b, sizes, mtimes)) {
+	if (myid==0)
+	  std::cerr << "SnapshotIndex: missing file in snapshot <"
+		    << b[0] << ">, skipping" << std::endl;
+	continue;
+      }
+
+      auto it = known.find(b[0]);
+      if (it == known.end() or it->second.files  != b or
+	  it->second.sizes != sizes or it->second.mtimes != mtimes) {
+	known[b[0]] = scan(b);
+	scanned++;
+      }
+
+      entries.push_back(known[b[0]]);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(),
+		     [](const Entry& a, const Entry& b)
+		     { return a.time < b.time; });
+
+    if (myid==0 and verbose)
+      std::cout << "SnapshotIndex: " << entries.size() << " snapshots, "
+		<< scanned << " scanned, index <" << this->indexfile << ">"
+		<< std::endl;
+
+    if (scanned) save();
+  }
+
+  bool SnapshotIndex::stamp(const std::vector<std::string>& files,
+			    std::vector<unsigned long long>& sizes,
+			    std::vector<long long>& mtimes)
+  {
+    sizes.clear();
+    mtimes.clear();
+
+    for (auto & f : files) {
+      std::error_code ec;
+      auto sz = std::filesystem::file_size(f, ec);
+      if (ec) return false;
+      auto mt = std::filesystem::last_write_time(f, ec);
+      if (ec) return false;
+      sizes.push_back(sz);
+      mtimes.push_back(mt.time_since_epoch().count());
+    }
+
+    return true;
+  }
+
+  SnapshotIndex::Entry
+  SnapshotIndex::scan(const std::vector<std::string>& files)
+  {
+    Entry e;
+    e.files = files;
+    stamp(files, e.sizes, e.mtimes);
+
+    auto rd = ParticleReader::createReader(reader, files, myid, false);
+
+    e.time = rd->CurrentTime();
+
+    for (auto & t : rd->GetTypes()) {
+      rd->SelectType(t);
+      e.counts[t] = rd->CurrentNumber();
+    }
+
+    // Component offsets in a single PSP file
+    //
+    if (auto psp = dynamic_cast<PSPout*>(rd.get())) {
+      for (auto s=psp->GetStanza(); s; s=psp->NextStanza())
+	e.offsets[s->name] = static_cast<long long>(s->pspos);
+    }
+
+    if (myid==0 and verbose)
+      std::cout << "SnapshotIndex: scanned <" << files[0] << "> T="
+		<< e.time << std::endl;
+
+    return e;
+  }
+
+  void SnapshotIndex::load()
+  {
+    if (not std::filesystem::exists(indexfile)) return;
+
+    try {
+      YAML::Node node = YAML::LoadFile(indexfile);
+
+      if (node["version"].as<int>() != indexVersion or
+	  node["reader"].as<std::string>() != reader) {
+	if (myid==0 and verbose)
+	  std::cout << "SnapshotIndex: <" << indexfile << "> is for another "
+		    << "reader or version; rebuilding" << std::endl;
+	return;
+      }
+
+      for (auto s : node["snapshots"]) {
+	Entry e;
+	e.files  = s["files" ].as<std::vector<std::string>>();
+	e.sizes  = s["sizes" ].as<std::vector<unsigned long long>>();
+	e.mtimes = s["mtimes"].as<std::vector<long long>>();
+	e.time   = s["time"  ].as<double>();
+	e.counts = s["counts"].as<std::map<std::string, unsigned long>>();
+	if (s["offsets"])
+	  e.offsets = s["offsets"].as<std::map<std::string, long long>>();
+	if (e.files.size()) known[e.files[0]] = e;
+      }
+    }
+    catch (YAML::Exception& error) {
+      if (myid==0)
+	std::cerr << "SnapshotIndex: error parsing <" << indexfile << ">: "
+		  << error.what() << "; rebuilding" << std::endl;
+      known.clear();
+    }
+  }
+
+  void SnapshotIndex::save()
+  {
+    if (myid) return;
+
+    YAML::Node node;
+    node["version"] = indexVersion;
+    node["reader"]  = reader;
+
+    for (auto & v : known) {
+      auto & e = v.second;
+      YAML::Node s;
+      s["files" ] = e.files;
+      s["sizes" ] = e.sizes;
+      s["mtimes"] = e.mtimes;
+      s["time"  ] = e.time;
+      s["counts"] = e.counts;
+      if (e.offsets.size()) s["offsets"] = e.offsets;
+      s["files" ].SetStyle(YAML::EmitterStyle::Flow);
+      s["sizes" ].SetStyle(YAML::EmitterStyle::Flow);
+      s["mtimes"].SetStyle(YAML::EmitterStyle::Flow);
+      s["counts"].SetStyle(YAML::EmitterStyle::Flow);
+      if (e.offsets.size()) s["offsets"].SetStyle(YAML::EmitterStyle::Flow);
+      node["snapshots"].push_back(s);
+    }
+
+    // Write a temporary and rename so that the index is replaced in
+    // one step
+    //
+    std::string temp = indexfile + ".tmp";
+    {
+      std::ofstream out(temp);
+      if (not out) {
+	std::cerr << "SnapshotIndex: could not write <" << temp << ">; "
+		  << "the index will not be saved" << std::endl;
+	return;
+      }
+      out << node << std::endl;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, indexfile, ec);
+    if (ec)
+      std::cerr << "SnapshotIndex: could not rename <" << temp << ">: "
+		<< ec.message() << std::endl;
+  }
+
+  std::vector<double> SnapshotIndex::times() const
+  {
+    std::vector<double> ret;
+    for (auto & e : entries) ret.push_back(e.time);
+    return ret;
+  }
+
+  std::vector<size_t> SnapshotIndex::select(double tmin, double tmax) const
+  {
+    std::vector<size_t> ret;
+    for (size_t i=0; i<entries.size(); i++) {
+      if (entries[i].time >= tmin and entries[i].time <= tmax)
+	ret.push_back(i);
+    }
+    return ret;
+  }
+
+  size_t SnapshotIndex::nearest(double t) const
+  {
+    if (entries.empty())
+      throw std::runtime_error("SnapshotIndex::nearest: the index is empty");
+
+    size_t best = 0;
+    for (size_t i=1; i<entries.size(); i++) {
+      if (fabs(entries[i].time - t) < fabs(entries[best].time - t)) best = i;
+    }
+    return best;
+  }
+
+  PRptr SnapshotIndex::createReader(size_t i) const
+  {
+    return ParticleReader::createReader(reader, entries.at(i).files,
+					myid, verbose);
+  }
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <sstream>
+#include <cmath>
+
+#include <highfive/highfive.hpp>
+#include <highfive/eigen.hpp>
+
+#include <SphBessRoots.H>
+#include <localmpi.H>
+#include <EXPmath.H>
+
+std::map<int, Eigen::VectorXd> SphBessRoots::table;
+std::string                    SphBessRoots::cachefile;
+std::mutex                     SphBessRoots::mtx;
+
+Eigen::VectorXd SphBessRoots::get(int l, int n)
+{
+  std::lock_guard<std::mutex> guard(mtx);
+
+  auto it = table.find(l);
+  if (it != table.end() and it->second.size() >= n)
+    return it->second.head(n);
+
+  table[l] = sbessjz(l, n);
+
+  if (cachefile.size()) write();
+
+  return table[l];
+}
+
+void SphBessRoots::cache(const std::string& file)
+{
+  std::lock_guard<std::mutex> guard(mtx);
+
+  if (file == cachefile) return;
+  cachefile = file;
+
+  try {
+    // Silence the HDF5 error stack
+    //
+    HighFive::SilenceHDF5 quiet;
+
+    HighFive::File h5(cachefile, HighFive::File::ReadOnly);
+
+    for (auto name : h5.listObjectNames()) {
+      int l = std::stoi(name);
+      Eigen::VectorXd a = h5.getDataSet(name).read<Eigen::VectorXd>();
+      auto it = table.find(l);
+      if (it == table.end() or it->second.size() < a.size()) table[l] = a;
+    }
+
+  } catch (HighFive::Exception& err) {
+    // No cache yet; it is written on the first extension
+    return;
+  }
+
+  if (myid==0) std::cout << "---- SphBessRoots::cache: "
+			 << "read Bessel zeros <" << cachefile << ">"
+			 << std::endl;
+}
+
+void SphBessRoots::write()
+{
+  if (myid) return;
+
+  try {
+    HighFive::File h5(cachefile, HighFive::File::Overwrite);
+
+    for (auto & v : table) {
+      std::ostringstream sout;
+      sout << v.first;
+      h5.createDataSet(sout.str(), v.second);
+    }
+
+  } catch (HighFive::Exception& err) {
+    std::cerr << "---- SphBessRoots::write: " << err.what() << std::endl;
+  }
+}
+
+void SphBessRoots::eval(int l, const double* x, double* y, int n)
+{
+  for (int i=0; i<n; i++) {
+    double z = x[i];
+
+    if (z > l and z > 0.0) {
+      double s = sin(z), c = cos(z);
+      double j0 = s/z, j1 = (s/z - c)/z;
+      if (l==0) { y[i] = j0; continue; }
+      for (int k=1; k<l; k++) {
+	double j2 = (2*k+1)/z*j1 - j0;
+	j0 = j1;
+	j1 = j2;
+      }
+      y[i] = j1;
+    } else {
+      y[i] = EXPmath::sph_bessel(l, z);
+    }
+  }
+}
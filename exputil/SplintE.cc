@@ -3,13 +3,15 @@
 #include <cstdlib>
 #include <Eigen/Eigen>
 
+#include <SearchTable.H>
+
 using namespace std;
 
 void Splint1(const Eigen::VectorXd &xa,
 	     const Eigen::VectorXd &ya,
 	     const Eigen::VectorXd &y2a, double x, double &y, int even=0)
 {
-  int klo, khi, n1, n2, k;
+  int klo, khi;
   double h,b,a;
   
   int sz = xa.size();
@@ -21,13 +23,8 @@ void Splint1(const Eigen::VectorXd &xa,
     khi=klo+1;
   }
   else {
-    klo = 0;
-    khi = sz-1;
-    while (khi-klo > 1) {
-      k = (khi+klo) >> 1;
-      if (xa[k] > x) khi = k;
-      else klo = k;
-    }
+    klo = SearchHint::bracket(xa.data(), sz, x);
+    khi = klo+1;
   }
 
   h=xa[khi]-xa[klo];
@@ -46,7 +43,7 @@ void Splint2(const Eigen::VectorXd &xa,
 	     const Eigen::VectorXd &ya,
 	     const Eigen::VectorXd &y2a, double x, double &y, double &dy, int even=0)
 {
-  int klo, khi, k;
+  int klo, khi;
   double h, b, a;
   
   int sz = xa.size();
@@ -58,13 +55,8 @@ void Splint2(const Eigen::VectorXd &xa,
     khi=klo+1;
   }
   else {
-    klo = 0;
-    khi = sz-1;
-    while (khi-klo > 1) {
-      k = (khi+klo) >> 1;
-      if (xa[k] > x) khi = k;
-      else klo = k;
-    }
+    klo = SearchHint::bracket(xa.data(), sz, x);
+    khi = klo+1;
   }
 
   h=xa[khi]-xa[klo];
@@ -88,7 +80,7 @@ void Splint3(const Eigen::VectorXd &xa,
 	     const Eigen::VectorXd &y2a,
 	     double x, double &y, double &dy, double &ddy, int even=0)
 {
-  int klo, khi, k;
+  int klo, khi;
   double h,b,a;
   
   int sz = xa.size();
@@ -100,13 +92,8 @@ void Splint3(const Eigen::VectorXd &xa,
     khi = klo+1;
   }
   else {
-    klo = 0;
-    khi = sz-1;
-    while (khi-klo > 1) {
-      k = (khi+klo) >> 1;
-      if (xa[k] > x) khi = k;
-      else klo = k;
-    }
+    klo = SearchHint::bracket(xa.data(), sz, x);
+    khi = klo+1;
   }
 
   h = xa[khi]-xa[klo];
@@ -123,3 +110,56 @@ void Splint3(const Eigen::VectorXd &xa,
       *h/6.0;
   ddy = a*y2a[klo]+b*y2a[khi];
 }
+
+
+// Versions with a precomputed search table for the abscissae
+
+void Splint1(const SearchTable &xs,
+	     const Eigen::VectorXd &ya,
+	     const Eigen::VectorXd &y2a, double x, double &y)
+{
+  const Eigen::VectorXd &xa = xs.x();
+
+  int klo = xs.index(x), khi = klo+1;
+
+  double h = xa[khi]-xa[klo];
+  double a = (xa[khi]-x)/h;
+  double b = (x-xa[klo])/h;
+  y = a*ya[klo]+b*ya[khi]+((a*a*a-a)*y2a[klo]+(b*b*b-b)*y2a[khi])*(h*h)/6.0;
+}
+
+void Splint2(const SearchTable &xs,
+	     const Eigen::VectorXd &ya,
+	     const Eigen::VectorXd &y2a, double x, double &y, double &dy)
+{
+  const Eigen::VectorXd &xa = xs.x();
+
+  int klo = xs.index(x), khi = klo+1;
+
+  double h = xa[khi]-xa[klo];
+  double a = (xa[khi]-x)/h;
+  double b = (x-xa[klo])/h;
+  y = a*ya[klo]+b*ya[khi]+((a*a*a-a)*y2a[klo]+(b*b*b-b)*y2a[khi])*(h*h)/6.0;
+  dy = (-ya[klo]+ya[khi])/h +
+    (-(3.0*a*a-1.0)*y2a[klo]+(3.0*b*b-1.0)*y2a[khi])
+    *h/6.0;
+}
+
+void Splint3(const SearchTable &xs,
+	     const Eigen::VectorXd &ya,
+	     const Eigen::VectorXd &y2a,
+	     double x, double &y, double &dy, double &ddy)
+{
+  const Eigen::VectorXd &xa = xs.x();
+
+  int klo = xs.index(x), khi = klo+1;
+
+  double h = xa[khi]-xa[klo];
+  double a = (xa[khi]-x)/h;
+  double b = (x-xa[klo])/h;
+  y = a*ya[klo]+b*ya[khi]+((a*a*a-a)*y2a[klo]+(b*b*b-b)*y2a[khi])*(h*h)/6.0;
+  dy = (-ya[klo]+ya[khi])/h +
+    (-(3.0*a*a-1.0)*y2a[klo]+(3.0*b*b-1.0)*y2a[khi])
+      *h/6.0;
+  ddy = a*y2a[klo]+b*y2a[khi];
+}
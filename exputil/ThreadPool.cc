@@ -0,0 +1,142 @@
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <ThreadPool.H>
+
+// True inside a pool task; nested run() calls execute serially
+static thread_local bool in_pool_task = false;
+
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::ThreadPool()
+{
+  generation = 0;
+  nactive    = 0;
+  pending    = 0;
+  shutdown   = false;
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    shutdown = true;
+  }
+  start.notify_all();
+  for (auto & t : workers) t.join();
+}
+
+void ThreadPool::grow(int n)
+{
+  while (static_cast<int>(workers.size()) < n) {
+    int id = workers.size() + 1;
+    workers.emplace_back(&ThreadPool::worker, this, id);
+    pinWorker(id);
+  }
+}
+
+void ThreadPool::pinWorker(int id)
+{
+#ifdef __linux__
+  if (cores.empty()) return;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cores[id % cores.size()], &set);
+  pthread_setaffinity_np(workers[id-1].native_handle(), sizeof(set), &set);
+#endif
+}
+
+void ThreadPool::pin(const std::vector<int>& c)
+{
+  std::lock_guard<std::mutex> serial(dispatch);
+
+  cores = c;
+  for (size_t i=0; i<workers.size(); i++) pinWorker(i+1);
+}
+
+void ThreadPool::worker(int id)
+{
+  unsigned long seen = 0;
+
+  in_pool_task = true;
+
+  while (true) {
+    std::function<void(int)> job;
+
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      start.wait(guard, [&]{ return shutdown or generation != seen; });
+      if (shutdown) return;
+      seen = generation;
+      if (id >= nactive) continue; // Not needed for this pass
+      job = task;
+    }
+
+    try {
+      job(id);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> guard(lock);
+      if (not error) error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (--pending == 0) done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::run(int n, const std::function<void(int)>& fn)
+{
+  // Serial execution for a single thread or a nested call
+  //
+  if (n<=1 or in_pool_task) {
+    for (int i=0; i<n; i++) fn(i);
+    return;
+  }
+
+  std::lock_guard<std::mutex> serial(dispatch);
+
+  grow(n-1);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    task    = fn;
+    nactive = n;
+    pending = n - 1;
+    error   = nullptr;
+    generation++;
+  }
+  start.notify_all();
+
+  // The caller is thread 0
+  //
+  std::exception_ptr mine;
+  in_pool_task = true;
+  try {
+    fn(0);
+  }
+  catch (...) {
+    mine = std::current_exception();
+  }
+  in_pool_task = false;
+
+  std::exception_ptr theirs;
+  {
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&]{ return pending == 0; });
+    theirs = error;
+    task   = nullptr;
+  }
+
+  if (mine)   std::rethrow_exception(mine);
+  if (theirs) std::rethrow_exception(theirs);
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <Eigen/Eigenvalues>
+
+#include <TopEigen.H>
+
+//! Solve (T - mu I) x = b in place for the symmetric tridiagonal T
+//! with diagonal d and off-diagonal e by Gaussian elimination with
+//! partial pivoting.  Zero pivots are replaced by tiny.
+static void tridiag_solve(const Eigen::VectorXd& d, const Eigen::VectorXd& e,
+			  double mu, double tiny, Eigen::VectorXd& x)
+{
+  const int n = d.size();
+
+  std::vector<double> dl(n), dd(n), du(n), du2(n, 0.0);
+  std::vector<bool> swap(n, false);
+
+  for (int i=0; i<n; i++) {
+    dd[i] = d[i] - mu;
+    if (i<n-1) dl[i] = du[i] = e[i];
+  }
+
+  // Factor
+  //
+  for (int i=0; i<n-1; i++) {
+    if (std::fabs(dd[i]) >= std::fabs(dl[i])) {
+      if (std::fabs(dd[i]) < tiny) dd[i] = tiny;
+      double fact = dl[i]/dd[i];
+      dl[i] = fact;
+      dd[i+1] -= fact*du[i];
+    } else {
+      double fact = dd[i]/dl[i];
+      dd[i] = dl[i];
+      dl[i] = fact;
+      double temp = du[i];
+      du[i] = dd[i+1];
+      dd[i+1] = temp - fact*dd[i+1];
+      if (i<n-2) {
+	du2[i] = du[i+1];
+	du[i+1] = -fact*du[i+1];
+      }
+      swap[i] = true;
+    }
+  }
+  if (std::fabs(dd[n-1]) < tiny) dd[n-1] = tiny;
+
+  // Forward substitution
+  //
+  for (int i=0; i<n-1; i++) {
+    if (swap[i]) {
+      double temp = x[i] - dl[i]*x[i+1];
+      x[i] = x[i+1];
+      x[i+1] = temp;
+    } else {
+      x[i+1] -= dl[i]*x[i];
+    }
+  }
+
+  // Back substitution
+  //
+  x[n-1] /= dd[n-1];
+  if (n>1) x[n-2] = (x[n-2] - du[n-2]*x[n-1])/dd[n-2];
+  for (int i=n-3; i>=0; i--)
+    x[i] = (x[i] - du[i]*x[i+1] - du2[i]*x[i+2])/dd[i];
+}
+
+
+void TopEigen(const Eigen::MatrixXd& A, int k,
+	      Eigen::VectorXd& eval, Eigen::MatrixXd& evec)
+{
+  const int n = A.rows();
+  k = std::max<int>(0, std::min<int>(k, n));
+
+  // Full decomposition for small problems or most of the spectrum
+  //
+  if (n <= 32 or 2*k >= n) {
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(A);
+    eval = es.eigenvalues().reverse().head(k);
+    evec = es.eigenvectors().rowwise().reverse().leftCols(k);
+    return;
+  }
+
+  // Reduce to tridiagonal form and get all eigenvalues (ascending)
+  //
+  Eigen::Tridiagonalization<Eigen::MatrixXd> tri(A);
+  Eigen::VectorXd d = tri.diagonal();
+  Eigen::VectorXd e = tri.subDiagonal();
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es;
+  es.computeFromTridiagonal(d, e, Eigen::EigenvaluesOnly);
+  const Eigen::VectorXd& lam = es.eigenvalues();
+
+  double tnorm = 0.0;
+  for (int i=0; i<n; i++) {
+    double row = std::fabs(d[i]);
+    if (i>0)   row += std::fabs(e[i-1]);
+    if (i<n-1) row += std::fabs(e[i]);
+    tnorm = std::max<double>(tnorm, row);
+  }
+  if (tnorm==0.0) tnorm = 1.0;
+
+  const double eps  = std::numeric_limits<double>::epsilon();
+  const double tiny = eps*tnorm;
+  const double gap  = 1.0e-3*tnorm;	// Reorthogonalization cluster width
+  const int    nits = 5;
+
+  // Inverse iteration for the eigenvectors of T
+  //
+  Eigen::MatrixXd Z(n, k);
+  eval.resize(k);
+
+  for (int j=0; j<k; j++) {
+    double mu = lam[n-1-j];
+    eval[j] = mu;
+
+    // Separate coincident eigenvalues so that the iterates differ
+    //
+    if (j>0 and std::fabs(mu - eval[j-1]) < 10.0*tiny)
+      mu = eval[j-1] - 10.0*tiny;
+
+    Eigen::VectorXd x(n);
+    for (int i=0; i<n; i++) x[i] = 1.0 + 0.5*std::sin(1.0 + i + 7.0*j);
+    x.normalize();
+
+    for (int it=0; it<nits; it++) {
+      tridiag_solve(d, e, mu, tiny, x);
+
+      for (int i=0; i<j; i++) {
+	if (std::fabs(eval[i] - eval[j]) < gap)
+	  x -= Z.col(i).dot(x) * Z.col(i);
+      }
+
+      double norm = x.norm();
+      if (norm==0.0) {
+	x.setConstant(1.0);
+	norm = x.norm();
+      }
+      x /= norm;
+    }
+
+    Z.col(j) = x;
+  }
+
+  // Back to the basis of A
+  //
+  evec = tri.matrixQ() * Z;
+}
@@ -29,8 +29,9 @@
  *
  *  Notes:
  *  -----
- *  Simple binary search.  Locate_with_guard() always returns a grid
- *  point within the specfied range
+ *  Branchless binary search, checking the interval found by the
+ *  previous call in this thread first.  Locate_with_guard() always
+ *  returns a grid point within the specfied range
  *
  *  By:
  *  --
@@ -46,22 +47,29 @@
 #include <deque>
 #include <Eigen/Eigen>
 
+#include <SearchTable.H>
+
 template <class V>
 int Vlocate(double x, const V& xx)
 {
-  int min = 0;
-  int max = xx.size() - 1;
-  int jl = min-1;
-  int ju = max+1;
-  int ascnd = xx[max] > xx[min];
-
-  while (ju-jl > 1) {
-    int jm = (ju+jl) >> 1;
-    if ((x > xx[jm]) == ascnd)
-      jl = jm;
-    else
-      ju = jm;
-  }
+  int n = xx.size();
+  int ascnd = xx[n-1] > xx[0];
+
+  auto below = [x, ascnd](double z) { return (x > z) == ascnd; };
+
+  // Try the interval from the last search of this table first
+  //
+  thread_local const void* key = 0;
+  thread_local int last = 0;
+
+  if (key == &xx and last >= 0 and last < n-1 and
+      below(xx[last]) and not below(xx[last+1])) return last;
+
+  int jl = partition_point(xx, n, below) - 1;
+
+  key  = &xx;
+  last = jl;
+
   return jl;
 }
 
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+#include <config_exp.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <VtiGrid.H>
+
+namespace
+{
+  // Uncompressed bytes per zlib block, as in the VTK writers
+  const size_t blockSize = 1<<16;
+
+  bool littleEndian()
+  {
+    const uint16_t one = 1;
+    unsigned char c;
+    std::memcpy(&c, &one, 1);
+    return c==1;
+  }
+
+  std::string header(const std::string& type, bool compress)
+  {
+    std::ostringstream sout;
+    sout << "<?xml version=\"1.0\"?>" << std::endl
+	 << "<VTKFile type=\"" << type << "\" version=\"1.0\" byte_order=\""
+	 << (littleEndian() ? "LittleEndian" : "BigEndian")
+	 << "\" header_type=\"UInt64\"";
+    if (compress) sout << " compressor=\"vtkZLibDataCompressor\"";
+    sout << ">" << std::endl;
+    return sout.str();
+  }
+
+  // Field names are attribute values
+  std::string escape(const std::string& s)
+  {
+    std::string r;
+    for (auto c : s) {
+      switch (c) {
+      case '<': r += "&lt;";   break;
+      case '>': r += "&gt;";   break;
+      case '&': r += "&amp;";  break;
+      case '"': r += "&quot;"; break;
+      default:  r += c;
+      }
+    }
+    return r;
+  }
+
+  void put64(std::string& buf, uint64_t v)
+  {
+    buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+  }
+
+  // Append one array in VTK's binary appended layout: a byte count
+  // and the raw bytes, or with compression a block table and the
+  // deflated blocks
+  void appendArray(std::string& buf, const float* data, size_t n,
+		   bool compress)
+  {
+    const char* src = reinterpret_cast<const char*>(data);
+    const size_t bytes = n*sizeof(float);
+
+#ifdef HAVE_ZLIB
+    if (compress) {
+      const size_t nb = (bytes + blockSize - 1)/blockSize;
+      const size_t last = bytes - (nb ? (nb-1)*blockSize : 0);
+
+      std::vector<std::string> blocks(nb);
+      for (size_t b=0; b<nb; b++) {
+	size_t len = b+1==nb ? last : blockSize;
+	uLongf clen = compressBound(len);
+	blocks[b].resize(clen);
+	if (compress2(reinterpret_cast<Bytef*>(&blocks[b][0]), &clen,
+		      reinterpret_cast<const Bytef*>(src + b*blockSize), len,
+		      Z_DEFAULT_COMPRESSION) != Z_OK)
+	  throw std::runtime_error("VtiGrid: zlib compression failed");
+	blocks[b].resize(clen);
+      }
+
+      put64(buf, nb);
+      put64(buf, blockSize);
+      put64(buf, last);
+      for (auto & b : blocks) put64(buf, b.size());
+      for (auto & b : blocks) buf += b;
+      return;
+    }
+#endif
+
+    put64(buf, bytes);
+    buf.append(src, bytes);
+  }
+}
+
+VtiGrid::VtiGrid(int nx, int ny, int nz,
+		 double xmin, double xmax,
+		 double ymin, double ymax,
+		 double zmin, double zmax,
+		 int pieces, bool compress) :
+  ThreeDGrid(nx, ny, nz, xmin, xmax, ymin, ymax, zmin, zmax),
+  compress(compress)
+{
+#ifndef HAVE_ZLIB
+  this->compress = false;
+#endif
+
+  int dims[3] = {nx, ny, nz};
+  npieces = std::max<int>(1, std::min<int>(pieces, dims[splitAxis()]-1));
+}
+
+int VtiGrid::splitAxis() const
+{
+  if (nz>1) return 2;
+  if (ny>1) return 1;
+  return 0;
+}
+
+void VtiGrid::pieceRange(int p, int& beg, int& end) const
+{
+  int dims[3] = {nx, ny, nz};
+  int m = std::max<int>(dims[splitAxis()]-1, 0);
+  beg = p*m/npieces;
+  end = (p+1)*m/npieces;
+}
+
+std::string VtiGrid::extent(int beg, int end) const
+{
+  int dims[3] = {nx, ny, nz}, a = splitAxis();
+  std::ostringstream sout;
+  for (int k=0; k<3; k++) {
+    if (k) sout << " ";
+    if (k==a) sout << beg << " " << end;
+    else      sout << 0 << " " << dims[k]-1;
+  }
+  return sout.str();
+}
+
+std::string VtiGrid::geometry() const
+{
+  auto del = [](int n, float a, float b)
+  { return n>1 ? (b - a)/(n-1) : 1.0f; };
+
+  std::ostringstream sout;
+  sout << std::setprecision(std::numeric_limits<float>::max_digits10)
+       << "Origin=\"" << xmin << " " << ymin << " " << (nz>1 ? zmin : 0.0f)
+       << "\" Spacing=\"" << del(nx, xmin, xmax) << " "
+       << del(ny, ymin, ymax) << " " << del(nz, zmin, zmax) << "\"";
+  return sout.str();
+}
+
+void VtiGrid::Add(const std::vector<double>& data, const std::string& name)
+{
+  auto & v = dataSet[name];
+  v.resize(static_cast<size_t>(nx)*ny*nz);
+  for (size_t i=0; i<v.size(); i++) v[i] = static_cast<float>(data[i]);
+}
+
+void VtiGrid::Add(const float* data, const std::string& name)
+{
+  dataSet[name].assign(data, data + static_cast<size_t>(nx)*ny*nz);
+}
+
+std::string VtiGrid::FileName(const std::string& name) const
+{
+  return name + (npieces>1 ? ".pvti" : ".vti");
+}
+
+void VtiGrid::WritePiece(const std::string& name, int p) const
+{
+  int beg, end;
+  pieceRange(p, beg, end);
+
+  // The pieces are slabs of the outermost split axis, so each one is
+  // contiguous in the x-fastest arrays
+  //
+  int dims[3] = {nx, ny, nz};
+  size_t stride = 1;
+  for (int k=0; k<splitAxis(); k++) stride *= dims[k];
+  const size_t first = beg*stride, count = (end - beg + 1)*stride;
+
+  std::string ext = extent(beg, end), buf;
+  std::ostringstream xml;
+
+  xml << header("ImageData", compress)
+      << "  <ImageData WholeExtent=\"" << ext << "\" " << geometry() << ">"
+      << std::endl
+      << "    <Piece Extent=\"" << ext << "\">" << std::endl
+      << "      <PointData>" << std::endl;
+
+  for (auto & v : dataSet) {
+    xml << "        <DataArray type=\"Float32\" Name=\"" << escape(v.first)
+	<< "\" format=\"appended\" offset=\"" << buf.size() << "\"/>"
+	<< std::endl;
+    appendArray(buf, v.second.data() + first, count, compress);
+  }
+
+  xml << "      </PointData>" << std::endl
+      << "      <CellData>" << std::endl
+      << "      </CellData>" << std::endl
+      << "    </Piece>" << std::endl
+      << "  </ImageData>" << std::endl
+      << "  <AppendedData encoding=\"raw\">" << std::endl << "   _";
+
+  std::string file = npieces>1 ?
+    name + "_" + std::to_string(p) + ".vti" : name + ".vti";
+
+  std::ofstream out(file, std::ios::binary);
+  if (not out)
+    throw std::runtime_error("VtiGrid::WritePiece: could not open file <" +
+			     file + ">");
+
+  out << xml.str();
+  out.write(buf.data(), buf.size());
+  out << std::endl << "  </AppendedData>" << std::endl
+      << "</VTKFile>" << std::endl;
+}
+
+std::string VtiGrid::WriteIndex(const std::string& name) const
+{
+  if (npieces==1) return FileName(name);
+
+  // Pieces are referenced relative to the index
+  //
+  std::string base = name.substr(name.find_last_of('/') + 1);
+
+  std::string file = FileName(name);
+  std::ofstream out(file);
+  if (not out)
+    throw std::runtime_error("VtiGrid::WriteIndex: could not open file <" +
+			     file + ">");
+
+  int dims[3] = {nx, ny, nz};
+
+  out << header("PImageData", compress)
+      << "  <PImageData WholeExtent=\"" << extent(0, dims[splitAxis()]-1)
+      << "\" GhostLevel=\"0\" " << geometry() << ">" << std::endl
+      << "    <PPointData>" << std::endl;
+
+  for (auto & v : dataSet)
+    out << "      <PDataArray type=\"Float32\" Name=\"" << escape(v.first)
+	<< "\"/>" << std::endl;
+
+  out << "    </PPointData>" << std::endl;
+
+  for (int p=0; p<npieces; p++) {
+    int beg, end;
+    pieceRange(p, beg, end);
+    out << "    <Piece Extent=\"" << extent(beg, end) << "\" Source=\""
+	<< base << "_" << p << ".vti\"/>" << std::endl;
+  }
+
+  out << "  </PImageData>" << std::endl
+      << "</VTKFile>" << std::endl;
+
+  return file;
+}
+
+void VtiGrid::Write(const std::string& name)
+{
+  std::vector<std::string> errors(npieces);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int p=0; p<npieces; p++) {
+    try {
+      WritePiece(name, p);
+    }
+    catch (std::exception& e) {
+      errors[p] = e.what();
+    }
+  }
+
+  for (auto & e : errors) if (e.size()) throw std::runtime_error(e);
+
+  WriteIndex(name);
+}
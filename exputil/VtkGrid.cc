@@ -125,8 +125,9 @@ void VtkGrid::Write(const std::string& name)
 #else
   writer->SetInputData(dataSet);
 #endif
-  writer->SetDataModeToAscii();
-  // writer->SetDataModeToBinary();
+  writer->SetDataModeToAppended();
+  writer->EncodeAppendedDataOff();
+  writer->SetCompressorTypeToZLib();
   writer->Write();
 }
 
@@ -2,6 +2,9 @@
 #include <cstdlib>
 #include <cmath>
 #include <string>
+#include <mutex>
+#include <tuple>
+#include <map>
 
 #include <gaussQ.H>
 
@@ -12,6 +15,51 @@ extern "C" {
   void Laguerre(int n, double alpha, double abscis[], double weight[]);
 };
 
+std::shared_ptr<const GaussQuad::Rule>
+GaussQuad::rule(Kind kind, int N, double ALPHA, double BETA)
+{
+  using Key = std::tuple<Kind, int, double, double>;
+
+  static std::map<Key, std::shared_ptr<const Rule>> cache;
+  static std::mutex mtx;
+
+  if (kind != Kind::Jacobi) BETA = 0.0;
+
+  Key key(kind, N, ALPHA, BETA);
+
+  // The rule generators keep their state in file-scope statics, so
+  // the computation is done under the lock as well
+  //
+  std::lock_guard<std::mutex> guard(mtx);
+
+  auto it = cache.find(key);
+  if (it != cache.end()) return it->second;
+
+  auto q = std::make_shared<Rule>();
+  q->r.resize(N);
+  q->w.resize(N);
+
+  switch (kind) {
+  case Kind::Hermite:
+    Hermite( N, ALPHA, q->r.data(), q->w.data() );
+    for (auto & v : q->w) v *= exp(lgamma(0.5+0.5*ALPHA));
+    break;
+  case Kind::Laguerre:
+    Laguerre( N, ALPHA, q->r.data(), q->w.data() );
+    for (auto & v : q->w) v *= exp(lgamma(1.0+ALPHA));
+    break;
+  case Kind::Jacobi:
+    Jacobi( N, ALPHA, BETA, q->r.data(), q->w.data() );
+    for (auto & v : q->w)
+      v *= exp(lgamma(1.0+ALPHA) + lgamma(1.0+BETA) - lgamma(2.0+ALPHA+BETA));
+    break;
+  }
+
+  cache[key] = q;
+
+  return q;
+}
+
 HermQuad::HermQuad(int N, double ALPHA)
 {
   FunctionID = "HermQuad";
@@ -19,12 +67,9 @@ HermQuad::HermQuad(int N, double ALPHA)
   n = N;
   alpha = ALPHA;
 
-  w.resize(n);
-  r.resize(n);
-
-  Hermite( n, alpha, r.data(), w.data() );
-
-  for (auto & v : w) v *= exp(lgamma(0.5+0.5*alpha));
+  auto q = rule(Kind::Hermite, n, alpha);
+  r = q->r;
+  w = q->w;
 }
 
 LaguQuad::LaguQuad(int N, double ALPHA)
@@ -34,12 +79,9 @@ LaguQuad::LaguQuad(int N, double ALPHA)
   n = N;
   alpha = ALPHA;
 
-  w.resize(n);
-  r.resize(n);
-
-  Laguerre( n, alpha, r.data(), w.data() );
-
-  for (auto & v : w) v *= exp(lgamma(1.0+alpha));
+  auto q = rule(Kind::Laguerre, n, alpha);
+  r = q->r;
+  w = q->w;
 }
 
 JacoQuad::JacoQuad(int N, double ALPHA, double BETA)
@@ -50,12 +92,7 @@ JacoQuad::JacoQuad(int N, double ALPHA, double BETA)
   alpha = ALPHA;
   beta = BETA;
 
-  w.resize(n);
-  r.resize(n);
-
-  Jacobi( n, alpha, beta, r.data(), w.data() );
-
-  for (auto & v : w )
-    v *= exp(lgamma(1.0+alpha) + lgamma(1.0+beta) - lgamma(2.0+alpha+beta));
+  auto q = rule(Kind::Jacobi, n, alpha, beta);
+  r = q->r;
+  w = q->w;
 }
-
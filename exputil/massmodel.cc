@@ -102,6 +102,8 @@ SphericalModelTable::SphericalModelTable
   else
     Spline(pot.x, pot.y, -1.0e30, -1.0e30, pot.y2);
   
+  rgrid = SearchTable(pot.x);
+
   num_params = 0;
 
   if (from.getline(cbuf, MAXLINE)) {
@@ -174,6 +176,8 @@ SphericalModelTable::SphericalModelTable
   else
     Spline(pot.x, pot.y, -1.0e30, -1.0e30, pot.y2);
   
+  rgrid = SearchTable(pot.x);
+
   num_params = 0;
 
   diverge = DIVERGE;
@@ -234,6 +238,8 @@ SphericalModelTable::SphericalModelTable
   else
     Spline(pot.x, pot.y, -1.0e30, -1.0e30, pot.y2);
   
+  rgrid = SearchTable(pot.x);
+
   num_params = 0;
 
   diverge = DIVERGE;
@@ -259,7 +265,7 @@ double SphericalModelTable::get_mass(double r)
   if (linear)
     ans = odd2(r, mass.x, mass.y, even);
   else
-    Splint1(mass.x, mass.y, mass.y2, r, ans, even);
+    Splint1(rgrid, mass.y, mass.y2, r, ans);
   return ans;
 }
 
@@ -275,7 +281,7 @@ double SphericalModelTable::get_density(double r)
       if (linear)
 	ans = odd2(r, density.x, density.y, even);
       else
-	Splint1(density.x, density.y, density.y2, r, ans, even);
+	Splint1(rgrid, density.y, density.y2, r, ans);
     }
     return ans*pow(r, -diverge_rfac);
   }
@@ -285,7 +291,7 @@ double SphericalModelTable::get_density(double r)
   if (linear)
     ans = odd2(r, density.x, density.y, even);
   else
-    Splint1(density.x, density.y, density.y2, r, ans, even);
+    Splint1(rgrid, density.y, density.y2, r, ans);
 
   return ans;
 }
@@ -316,7 +322,7 @@ double SphericalModelTable::get_pot(const double r)
   if (linear)
     ans = odd2(r, pot.x, pot.y, even);
   else
-    Splint1(pot.x, pot.y, pot.y2, r, ans, even);
+    Splint1(rgrid, pot.y, pot.y2, r, ans);
 
   return ans;
 }
@@ -333,7 +339,7 @@ double SphericalModelTable::get_dpot(const double r)
       if (linear)
 	ans = drv2(pot.x[0], pot.x, pot.y, even);
       else
-	Splint2(pot.x, pot.y, pot.y2, pot.x[0], dum, ans, even);
+	Splint2(rgrid, pot.y, pot.y2, pot.x[0], dum, ans);
     }
   }
   else if (r>pot.x[pot.num-1]) 
@@ -342,7 +348,7 @@ double SphericalModelTable::get_dpot(const double r)
     if (linear)
       ans = drv2(r, pot.x, pot.y, even);
     else
-      Splint2(pot.x, pot.y, pot.y2, r, dum, ans, even);
+      Splint2(rgrid, pot.y, pot.y2, r, dum, ans);
   }
 
   return ans;
@@ -371,7 +377,7 @@ void SphericalModelTable::get_pot_dpot(const double r, double& ur, double &dur)
 	dur = drv2(pot.x[0], pot.x, pot.y, even);
       }
       else
-	Splint2(pot.x, pot.y, pot.y2, pot.x[0], ur, dur, even);
+	Splint2(rgrid, pot.y, pot.y2, pot.x[0], ur, dur);
     }
   }
   else if (r>pot.x[pot.num-1]) {
@@ -384,11 +390,57 @@ void SphericalModelTable::get_pot_dpot(const double r, double& ur, double &dur)
       dur = drv2(r, pot.x, pot.y, even);
     }
     else
-      Splint2(pot.x, pot.y, pot.y2, r, ur, dur, even);
+      Splint2(rgrid, pot.y, pot.y2, r, ur, dur);
   }
 
 }
 
+void SphericalModelTable::get_pot_dpot_batch(const double* r, int n,
+					     double* ur, double* dur)
+{
+  // Interval lookup.  The search table maps uniform and logarithmic
+  // grids directly and uses its bucket index otherwise.
+  //
+  thread_local std::vector<int> kv;
+  if (kv.size() < static_cast<size_t>(n)) kv.resize(n);
+  int* K = kv.data();
+
+  for (int i=0; i<n; i++) K[i] = rgrid.index(r[i]);
+
+  // Interpolation: no branches, so the loops vectorize with gathers
+  //
+  const double *X = pot.x.data(), *Y = pot.y.data(), *Y2 = pot.y2.data();
+
+  if (linear) {
+#pragma omp simd
+    for (int i=0; i<n; i++) {
+      int k = K[i];
+      double h = X[k+1] - X[k];
+      ur[i]  = (Y[k+1]*(r[i] - X[k]) - Y[k]*(r[i] - X[k+1]))/h;
+      dur[i] = (Y[k+1] - Y[k])/h;
+    }
+  } else {
+#pragma omp simd
+    for (int i=0; i<n; i++) {
+      int k = K[i];
+      double h = X[k+1] - X[k];
+      double a = (X[k+1] - r[i])/h;
+      double b = (r[i] - X[k])/h;
+      ur[i]  = a*Y[k] + b*Y[k+1] +
+	((a*a*a - a)*Y2[k] + (b*b*b - b)*Y2[k+1])*(h*h)/6.0;
+      dur[i] = (-Y[k] + Y[k+1])/h +
+	(-(3.0*a*a - 1.0)*Y2[k] + (3.0*b*b - 1.0)*Y2[k+1])*h/6.0;
+    }
+  }
+
+  // Radii off the grid take the scalar path
+  //
+  const double rmin = pot.x[0], rmax = pot.x[pot.num-1];
+  for (int i=0; i<n; i++) {
+    if (r[i] < rmin or r[i] > rmax) get_pot_dpot(r[i], ur[i], dur[i]);
+  }
+}
+
 double SphericalModelTable::get_dpot2(const double r)
 {
   double dum, ans;
@@ -398,12 +450,12 @@ double SphericalModelTable::get_dpot2(const double r)
       ans = 4.0*M_PI*density.y[0]*pow(r, -diverge_rfac)*
 	(1.0-diverge_rfac)/(3.0-diverge_rfac);
     else
-      Splint2(pot.x, pot.y, pot.y2, pot.x[0], dum, ans, even);
+      Splint2(rgrid, pot.y, pot.y2, pot.x[0], dum, ans);
   }
   else if (r>pot.x[pot.num-1]) 
     ans = 2.0*pot.y[pot.num-1]*pot.x[pot.num-1]/(r*r*r);
   else
-    Splint3(pot.x, pot.y, pot.y2, r, dum, dum, ans, even);
+    Splint3(rgrid, pot.y, pot.y2, r, dum, dum, ans);
 
   return ans;
 }
@@ -589,6 +641,12 @@ void EmbeddedDiskModel::save_df(string& file)
   df->write_state(file);
 }
 
+void EmbeddedDiskModel::cache_df(const string& file)
+{
+  if (!dist_defined) bomb("Embedded: <distf> not defined yet . . .");
+  df->set_cache(file);
+}
+
 
 SphericalModelMulti::SphericalModelMulti(AxiSymModPtr Real,
 					 AxiSymModPtr Fake) 
@@ -32,10 +32,13 @@
 #include <fstream>
 #include <random>
 #include <memory>
+#include <atomic>
+#include <limits>
 #include <cmath>
 
 #include <localmpi.H>
 #include <massmodel.H>
+#include <ThreadPool.H>
 #include <interp.H>
 
 #ifdef DEBUG
@@ -123,20 +126,20 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(int& ierr)
     
     for (it=0; it<gen_itmax; it++) {
 
-      double xxx = Emin + tol + (Emax - Emin - 2.0*tol)*Unit(random_gen);
-      double yyy = gen_kmin + tol + (1.0 - gen_kmin - 2.0*tol)*Unit(random_gen);
+      double xxx = Emin + tol + (Emax - Emin - 2.0*tol)*gen_unit();
+      double yyy = gen_kmin + tol + (1.0 - gen_kmin - 2.0*tol)*gen_unit();
 
       gen_orb.new_orbit(xxx, yyy);
 
       double zzz = distf(xxx, gen_orb.AngMom()) * gen_orb.Jmax()/gen_orb.get_freq(1);
 
-      if (Unit(random_gen) > zzz/gen_fomax ) continue;
+      if (gen_unit() > zzz/gen_fomax ) continue;
 
-      w1 = 2.0*M_PI*Unit(random_gen);
+      w1 = 2.0*M_PI*gen_unit();
       T = w1/gen_orb.get_freq(1);
       
       r = gen_orb.get_angle(6, T);
-      phi = 2.0*M_PI*Unit(random_gen) - gen_orb.get_angle(5, T);
+      phi = 2.0*M_PI*gen_unit() - gen_orb.get_angle(5, T);
 
       pot = get_pot(r);
 
@@ -212,7 +215,7 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(int& ierr)
       gen_firstime = false;
     }
 
-    r = odd2(Unit(random_gen)*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
+    r = odd2(gen_unit()*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
     fmax = odd2(r, gen_rloc, gen_fmax, 1);
     if (gen_logr) r = exp(r);
 
@@ -223,18 +226,18 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(int& ierr)
     
     for (it=0; it<gen_itmax; it++) {
 
-      double xxx = sqrt(Unit(random_gen));
-      double yyy = 0.5*M_PI*Unit(random_gen);
+      double xxx = sqrt(gen_unit());
+      double yyy = 0.5*M_PI*gen_unit();
 
       vr = vmax*xxx*cos(yyy);
       vt = vmax*xxx*sin(yyy);
       eee = pot + 0.5*(vr*vr + vt*vt);
 
-      if (Unit(random_gen) > distf(eee, r*vt)/fmax ) continue;
+      if (gen_unit() > distf(eee, r*vt)/fmax ) continue;
 
-      if (Unit(random_gen)<0.5) vr *= -1.0;
+      if (gen_unit()<0.5) vr *= -1.0;
     
-      phi = 2.0*M_PI*Unit(random_gen);
+      phi = 2.0*M_PI*gen_unit();
 
       break;
     }
@@ -244,7 +247,7 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(int& ierr)
                 
   Eigen::VectorXd out(7);
 
-  static unsigned totcnt = 0, toomany = 0;
+  static std::atomic<unsigned> totcnt(0), toomany(0);
   totcnt++;
   
   if (it==gen_itmax) {
@@ -341,18 +344,18 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(double r, int& ierr)
     
   for (it=0; it<gen_itmax; it++) {
 
-    double xxx = sqrt(Unit(random_gen));
-    double yyy = 0.5*M_PI*Unit(random_gen);
+    double xxx = sqrt(gen_unit());
+    double yyy = 0.5*M_PI*gen_unit();
 
     vr = vmax*xxx*cos(yyy);
     vt = vmax*xxx*sin(yyy);
     eee = pot + 0.5*(vr*vr + vt*vt);
 
-    if (Unit(random_gen) > distf(eee, r*vt)/fmax ) continue;
+    if (gen_unit() > distf(eee, r*vt)/fmax ) continue;
     
-    if (Unit(random_gen)<0.5) vr *= -1.0;
+    if (gen_unit()<0.5) vr *= -1.0;
     
-    phi = 2.0*M_PI*Unit(random_gen);
+    phi = 2.0*M_PI*gen_unit();
 
     break;
   }
@@ -360,7 +363,7 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(double r, int& ierr)
   
   Eigen::VectorXd out(7);
 
-  static unsigned totcnt = 0, toomany = 0;
+  static std::atomic<unsigned> totcnt(0), toomany(0);
   totcnt++;
 
   if (it==gen_itmax) {
@@ -392,6 +395,59 @@ Eigen::VectorXd AxiSymModel::gen_point_2d(double r, int& ierr)
 }
 
 
+thread_local Philox* AxiSymModel::gen_stream = 0;
+
+double AxiSymModel::gen_unit()
+{
+  if (gen_stream) return gen_stream->unit();
+  return Unit(random_gen);
+}
+
+int AxiSymModel::realize(uint64_t seed, uint64_t first, int n,
+			 Eigen::MatrixXd& ps, int nthrds)
+{
+  ps.resize(n, 7);
+
+  // Make the generation tables here rather than in the threads.  The
+  // point is drawn from a stream that is never assigned to a body.
+  //
+  {
+    Philox prime(seed, std::numeric_limits<uint64_t>::max());
+    int ierr;
+    gen_stream = &prime;
+    gen_point(ierr);
+    gen_stream = 0;
+  }
+
+  // Bodies are handed out in blocks; the result for each body only
+  // depends on its index
+  //
+  const int chunk = 256;
+  std::atomic<int> next(0), rejected(0);
+
+  auto work = [&](int id)
+  {
+    int ierr, bad = 0;
+    for (int i0=next.fetch_add(chunk); i0<n; i0=next.fetch_add(chunk)) {
+      for (int i=i0; i<std::min<int>(n, i0+chunk); i++) {
+	Philox gen(seed, first + i);
+	gen_stream = &gen;
+	do {
+	  ps.row(i) = gen_point(ierr).transpose();
+	  if (ierr) bad++;
+	} while (ierr);
+	gen_stream = 0;
+      }
+    }
+    rejected += bad;
+  };
+
+  if (nthrds>1) ThreadPool::instance().run(nthrds, work);
+  else          work(0);
+
+  return rejected;
+}
+
 Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
 {
   if (!dist_defined) {
@@ -490,7 +546,7 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
     gen_firstime = false;
   }
 
-  r = odd2(Unit(random_gen)*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
+  r = odd2(gen_unit()*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
   fmax = odd2(r, gen_rloc, gen_fmax, 1);
   if (gen_logr) r = exp(r);
   
@@ -504,8 +560,8 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
 
   for (it=0; it<gen_itmax; it++) {
 
-    double xxx = -2.0*cos(acos(Unit(random_gen))/3.0 - 2.0*M_PI/3.0);
-    double yyy = (1.0 - xxx*xxx)*Unit(random_gen);
+    double xxx = -2.0*cos(acos(gen_unit())/3.0 - 2.0*M_PI/3.0);
+    double yyy = (1.0 - xxx*xxx)*gen_unit();
 
     vr = vmax*xxx;
     vt = vmax*sqrt(yyy);
@@ -521,11 +577,11 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
     }
     */
 
-    if (Unit(random_gen) > distf(eee, r*vt)/fmax ) continue;
+    if (gen_unit() > distf(eee, r*vt)/fmax ) continue;
 
-    if (Unit(random_gen)<0.5) vr *= -1.0;
+    if (gen_unit()<0.5) vr *= -1.0;
     
-    azi = 2.0*M_PI*Unit(random_gen);
+    azi = 2.0*M_PI*gen_unit();
     vt1 = vt*cos(azi);
     vt2 = vt*sin(azi);
 
@@ -534,7 +590,7 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
                 
   Eigen::VectorXd out(7);
 
-  static unsigned totcnt = 0, toomany = 0;
+  static std::atomic<unsigned> totcnt(0), toomany(0);
   totcnt++;
 
   if (it==gen_itmax) {
@@ -551,10 +607,10 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(int& ierr)
 
   ierr = 0;
   
-  if (Unit(random_gen)>=0.5) vr *= -1.0;
+  if (gen_unit()>=0.5) vr *= -1.0;
 
-  phi = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -699,8 +755,8 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(double Emin, double Emax,
   double kmin = max<double>(Kmin, gen_tolK);
   double kmax = min<double>(Kmax, 1.0 - gen_tolK);
 
-  E = odd2(Mmin + (Mmax-Mmin)*Unit(random_gen), EgridMass, Egrid, 0);
-  K = sqrt(kmin*kmin + (kmax*kmax - kmin*kmin)*Unit(random_gen));
+  E = odd2(Mmin + (Mmax-Mmin)*gen_unit(), EgridMass, Egrid, 0);
+  K = sqrt(kmin*kmin + (kmax*kmax - kmin*kmin)*gen_unit());
 
   int indxE = int( (E - Emin_grid)/dEgrid );
   int indxK = int( (K - gen_tolK)/dKgrid );
@@ -720,7 +776,7 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(double Emin, double Emax,
   r = 0.0;
   J = 0.0;
   jmax = 0.0;
-  w1t = M_PI*Unit(random_gen);
+  w1t = M_PI*gen_unit();
 
   for (int ie=0; ie<2; ie++) {
     J += cE[ie]*Jmax[indxE+ie] * K;
@@ -743,16 +799,16 @@ Eigen::VectorXd AxiSymModel::gen_point_3d(double Emin, double Emax,
   }
   vr = sqrt( 2.0*(E - pot) - vt*vt );
 
-  if (Unit(random_gen)<0.5) vr *= -1.0;
+  if (gen_unit()<0.5) vr *= -1.0;
     
-  azi = 2.0*M_PI*Unit(random_gen);
+  azi = 2.0*M_PI*gen_unit();
   vt1 = vt*cos(azi);
   vt2 = vt*sin(azi);
 
   Eigen::VectorXd out(7);
 
-  phi = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -867,7 +923,7 @@ Eigen::VectorXd AxiSymModel::gen_point_jeans_3d(int& ierr)
     gen_firstime_jeans = false;
   }
 
-  r = odd2(Unit(random_gen)*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
+  r = odd2(gen_unit()*gen_mass[gen_N-1], gen_mass, gen_rloc, 0);
   vv = odd2(r, gen_rloc, gen_fmax);
 
   if (gen_logr) r = exp(r);
@@ -879,22 +935,22 @@ Eigen::VectorXd AxiSymModel::gen_point_jeans_3d(int& ierr)
     vtot = 0.0;
     
   
-  double xxx = -2.0*cos(acos(Unit(random_gen))/3.0 - 2.0*M_PI/3.0);
-  double yyy = (1.0 - xxx*xxx)*Unit(random_gen);
+  double xxx = -2.0*cos(acos(gen_unit())/3.0 - 2.0*M_PI/3.0);
+  double yyy = (1.0 - xxx*xxx)*gen_unit();
 
   vr = vtot*xxx;
   vt = vtot*sqrt(yyy);
 
-  azi = 2.0*M_PI*Unit(random_gen);
+  azi = 2.0*M_PI*gen_unit();
   vt1 = vt*cos(azi);
   vt2 = vt*sin(azi);
 
   Eigen::VectorXd out(7);
 
-  if (Unit(random_gen)>=0.5) vr *= -1.0;
+  if (gen_unit()>=0.5) vr *= -1.0;
 
-  phi = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -1010,25 +1066,25 @@ void AxiSymModel::gen_velocity(double* pos, double* vel, int& ierr)
 
   for (it=0; it<gen_itmax; it++) {
 
-    double xxx = -2.0*cos(acos(Unit(random_gen))/3.0 - 2.0*M_PI/3.0);
-    double yyy = (1.0 - xxx*xxx)*Unit(random_gen);
+    double xxx = -2.0*cos(acos(gen_unit())/3.0 - 2.0*M_PI/3.0);
+    double yyy = (1.0 - xxx*xxx)*gen_unit();
 
     vr = vmax*xxx;
     vt = vmax*sqrt(yyy);
     eee = pot + 0.5*(vr*vr + vt*vt);
 
-    if (Unit(random_gen) > distf(eee, r*vt)/fmax ) continue;
+    if (gen_unit() > distf(eee, r*vt)/fmax ) continue;
 
-    if (Unit(random_gen)<0.5) vr *= -1.0;
+    if (gen_unit()<0.5) vr *= -1.0;
     
-    azi = 2.0*M_PI*Unit(random_gen);
+    azi = 2.0*M_PI*gen_unit();
     vt1 = vt*cos(azi);
     vt2 = vt*sin(azi);
 
     break;
   }
                 
-  static unsigned totcnt = 0, toomany = 0;
+  static std::atomic<unsigned> totcnt(0), toomany(0);
   totcnt++;
 
   if (it==gen_itmax) {
@@ -1044,7 +1100,7 @@ void AxiSymModel::gen_velocity(double* pos, double* vel, int& ierr)
 
   ierr = 0;
   
-  if (Unit(random_gen)>=0.5) vr *= -1.0;
+  if (gen_unit()>=0.5) vr *= -1.0;
 
   phi = atan2(pos[1], pos[0]);
   cost = pos[2]/(r+1.0e-18);
@@ -1258,7 +1314,7 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
   // v
 #if  FIXED_RADIUS>0
   // Generate a radius (outside the loop)
-  mass = gen_mass[0] + Unit(random_gen)*(gen_mass[gen_N-1]-gen_mass[0]);
+  mass = gen_mass[0] + gen_unit()*(gen_mass[gen_N-1]-gen_mass[0]);
   r    = odd2(mass, gen_mass, gen_rloc, 0);
   fmax = odd2(r, gen_rloc, gen_fmax, 1);
   if (gen_logr) r = exp(r);
@@ -1274,7 +1330,7 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
   for (it=0; it<gen_itmax; it++) {
 
     // Generate a radius (inside the loop)
-    mass = gen_mass[0] + Unit(random_gen)*(gen_mass[gen_N-1]-gen_mass[0]);
+    mass = gen_mass[0] + gen_unit()*(gen_mass[gen_N-1]-gen_mass[0]);
     r = odd2(mass, gen_mass, gen_rloc, 0);
     fmax = odd2(r, gen_rloc, gen_fmax, 1);
     if (gen_logr) r = exp(r);
@@ -1283,8 +1339,8 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
     vmax = sqrt(2.0*max<double>(Emax - pot, 0.0));
 #endif
 
-    double xxx = 2.0*sin(asin(Unit(random_gen))/3.0);
-    double yyy = (1.0 - xxx*xxx)*Unit(random_gen);
+    double xxx = 2.0*sin(asin(gen_unit())/3.0);
+    double yyy = (1.0 - xxx*xxx)*gen_unit();
 
     vr = vmax*xxx;
     vt = vmax*sqrt(yyy);
@@ -1300,15 +1356,15 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
       continue;
     }
 
-    if (Unit(random_gen) > vvv/fmax ) {
+    if (gen_unit() > vvv/fmax ) {
       reject++;
       maxv3 = std::max<double>(maxv3, vvv);
       continue;
     }
 
-    if (Unit(random_gen) < 0.5) vr *= -1.0;
+    if (gen_unit() < 0.5) vr *= -1.0;
     
-    azi = 2.0*M_PI*Unit(random_gen);
+    azi = 2.0*M_PI*gen_unit();
     vt1 = vt*cos(azi);
     vt2 = vt*sin(azi);
 
@@ -1317,7 +1373,7 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
                 
   Eigen::VectorXd out(7);
 
-  static unsigned totcnt = 0, toomany = 0;
+  static std::atomic<unsigned> totcnt(0), toomany(0);
   totcnt++;
 
 
@@ -1338,10 +1394,10 @@ Eigen::VectorXd SphericalModelMulti::gen_point(int& ierr)
 
   ierr = 0;
   
-  if (Unit(random_gen)>=0.5) vr *= -1.0;
+  if (gen_unit()>=0.5) vr *= -1.0;
 
-  phi  = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi  = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -1484,8 +1540,8 @@ Eigen::VectorXd SphericalModelMulti::gen_point(double radius, int& ierr)
   int it;			// Iteration counter
   for (it=0; it<gen_itmax; it++) {
 
-    double xxx = 2.0*sin(asin(Unit(random_gen))/3.0);
-    double yyy = (1.0 - xxx*xxx)*Unit(random_gen);
+    double xxx = 2.0*sin(asin(gen_unit())/3.0);
+    double yyy = (1.0 - xxx*xxx)*gen_unit();
 
     vr = vmax*xxx;
     vt = vmax*sqrt(yyy);
@@ -1493,14 +1549,14 @@ Eigen::VectorXd SphericalModelMulti::gen_point(double radius, int& ierr)
 
     if (fmax<=0.0) continue;
 
-    if (Unit(random_gen) > fake->distf(eee, r*vt)/fmax ) {
+    if (gen_unit() > fake->distf(eee, r*vt)/fmax ) {
       reject++;
       continue;
     }
 
-    if (Unit(random_gen)<0.5) vr *= -1.0;
+    if (gen_unit()<0.5) vr *= -1.0;
     
-    azi = 2.0*M_PI*Unit(random_gen);
+    azi = 2.0*M_PI*gen_unit();
     vt1 = vt*cos(azi);
     vt2 = vt*sin(azi);
 
@@ -1511,7 +1567,7 @@ Eigen::VectorXd SphericalModelMulti::gen_point(double radius, int& ierr)
 
   if (it==gen_itmax) {
     if (verbose) {
-      static unsigned totcnt = 0;
+      static std::atomic<unsigned> totcnt(0);
       std::cerr << "Velocity selection failed [" << std::setw(7) << ++totcnt
 		<< "," << std::setw(4) << myid << "]: r="
 		<< std::setw(12) << r
@@ -1526,10 +1582,10 @@ Eigen::VectorXd SphericalModelMulti::gen_point(double radius, int& ierr)
 
   ierr = 0;
   
-  if (Unit(random_gen)>=0.5) vr *= -1.0;
+  if (gen_unit()>=0.5) vr *= -1.0;
 
-  phi  = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi  = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -1680,8 +1736,8 @@ Eigen::VectorXd
   double kmin = max<double>(Kmin, gen_tolK);
   double kmax = min<double>(Kmax, 1.0 - gen_tolK);
 
-  E = odd2(Mmin + (Mmax-Mmin)*Unit(random_gen), EgridMass, Egrid, 0);
-  K = sqrt(kmin*kmin + (kmax*kmax - kmin*kmin)*Unit(random_gen));
+  E = odd2(Mmin + (Mmax-Mmin)*gen_unit(), EgridMass, Egrid, 0);
+  K = sqrt(kmin*kmin + (kmax*kmax - kmin*kmin)*gen_unit());
 
   int indxE = int( (E - Emin_grid)/dEgrid );
   int indxK = int( (K - gen_tolK)/dKgrid );
@@ -1701,7 +1757,7 @@ Eigen::VectorXd
   r = 0.0;
   J = 0.0;
   jmax = 0.0;
-  w1t = M_PI*Unit(random_gen);
+  w1t = M_PI*gen_unit();
 
   for (int ie=0; ie<2; ie++) {
     J += cE[ie]*Jmax[indxE+ie] * K;
@@ -1724,16 +1780,16 @@ Eigen::VectorXd
   }
   vr = sqrt( 2.0*(E - pot) - vt*vt );
 
-  if (Unit(random_gen)<0.5) vr *= -1.0;
+  if (gen_unit()<0.5) vr *= -1.0;
     
-  azi = 2.0*M_PI*Unit(random_gen);
+  azi = 2.0*M_PI*gen_unit();
   vt1 = vt*cos(azi);
   vt2 = vt*sin(azi);
 
   Eigen::VectorXd out(7);
 
-  phi = 2.0*M_PI*Unit(random_gen);
-  cost = 2.0*(Unit(random_gen) - 0.5);
+  phi = 2.0*M_PI*gen_unit();
+  cost = 2.0*(gen_unit() - 0.5);
   sint = sqrt(1.0 - cost*cost);
   cosp = cos(phi);
   sinp = sin(phi);
@@ -67,7 +67,9 @@ C      GETRN, MESH, POWER, PQRINT, REGULR, SHOOT, START, STEP, and
 C      ZZERO.
 C
 C      There are 4 blocks of labeled COMMON with the names SLREAL,
-C      SLINT, SLLOG, and SLCLSS.
+C      SLINT, SLLOG, and SLCLSS.  These and the SAVEd locals are
+C      declared THREADPRIVATE so that separate threads may solve
+C      independent problems when compiled with OpenMP.
 C
 C      This is the double precision version of the code; all floating
 C      point variables should be declared DOUBLE PRECISION in the
@@ -839,6 +841,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0, TWO = 2.0, 
      &           FOUR = 4.0, TOLMAX = 1.D-4)
       DATA DENSLO,DENSOP,DENSHI/4.0, 6.0, 12.0/
@@ -1327,7 +1330,9 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLINT/,/SLLOG/,/SLREAL/)
       SAVE CUTOFF
+C$OMP THREADPRIVATE(CUTOFF)
 C
       NFIRST = -5
       NLAST = -5
@@ -1462,6 +1467,7 @@ C
      &                 ZERO,HALF,ONE,TWO,PI
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0, TWO = 2.0,
      &           PI = 3.14159265358979324D0)
 C
@@ -1552,6 +1558,7 @@ C
      &                 ZERO,HALF,ONE,TWO,PI
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0, TWO = 2.0,
      &           PI = 3.14159265358979324D0)
 C
@@ -1627,6 +1634,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, TWO = 2.0)
 C
 C     Set COUNTZ so that zeros are counted in SHOOT.
@@ -1775,6 +1783,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, TENTH = 0.1D0, ONE = 1.0, TWO = 2.0,
      &           EIGHT = 8.0)
 C
@@ -1942,6 +1951,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, QUART = 0.25D0, HALF = 0.5D0, 
      &           QUART3 = 0.75D0, ONE = 1.0, TWO = 2.0, FOUR = 4.0)
 C
@@ -2500,6 +2510,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0,
      &           TWO = 2.0, THREE = 3.0, FOUR = 4.0, SIX = 6.0,
      &           EIGHT = 8.0, TEN = 10.0, TOLMIN = 5.D-3)
@@ -3344,7 +3355,9 @@ C
      &                 RTOL,T,TOL1,TOL2,VTEMP,W(40,11),
      &                 ZERO,TENTH,HALF,ONE,TWO
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLREAL/)
       SAVE R,W
+C$OMP THREADPRIVATE(R,W)
 C
 C     The local arrays RATIO(*), R(*,*), and W(*,*) must be declared to 
 C     have at least as many rows as the value of MAXLVL initialized in
@@ -3531,6 +3544,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, C10M4 = 1.D-4, HALF = 0.5D0, ONE = 1.0,
      &           TWO = 2.0, THREE = 3.0, FIVE = 5.0, C15 = 15.0,
      &           C21 = 21.0)
@@ -3911,6 +3925,7 @@ C
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLCLSS/CP,CR,CUTOFF,D,EMU,EP,EQLNF,ER,ETA,PNU,KCLASS
+C$OMP THREADPRIVATE(/SLREAL/,/SLLOG/,/SLINT/,/SLCLSS/)
       PARAMETER (ZERO = 0.0, C10M4 = 1.D-4, HALF = 0.5D0, ONE = 1.D0,
      &           TWO = 2.0, THREE = 3.0, FIVE = 5.0, C15 = 15.0,
      &           C21 = 21.0)
@@ -4010,6 +4025,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, TENTH = 0.1D0, HALF = 0.5D0, ONE = 1.0,
      &           TWO = 2.0, FOUR = 4.0)
       SAVE ENDA,ENDB
@@ -4414,6 +4430,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
+C$OMP THREADPRIVATE(/SLINT/,/SLREAL/,/SLLOG/)
       PARAMETER (ZERO = 0.0, TWO = 2.0, FOUR = 4.0)
       IF (LNF) THEN
          CALL COEFF(X,PX,QX,RX)
@@ -4526,6 +4543,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0 ,ONE = 1.0, THREE = 3.0,
      &           FIVE = 5.0, TEN = 10.0, TOLMIN = 1.D-3)
 C
@@ -4754,6 +4772,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0, TWO = 2.0,
      &           PI = 3.141592653589793D0)
       DATA IMAX/1000000/
@@ -4920,6 +4939,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLINT/,/SLLOG/,/SLREAL/)
       PARAMETER (ZERO = 0.0, HALF = 0.5D0, ONE = 1.0,
      &           PIOVR2 = 1.5707963267948966D0, TWO = 2.0, FIVE = 5.0,
      &           HUNDRD = 100.0)
@@ -5042,6 +5062,7 @@ C
       COMMON /SLINT/FLAG,LEVEL,MAXEXT,MAXINT,MAXLVL,NCOEFF,NSGNF,NXINIT
       COMMON /SLLOG/AFIN,BFIN,COUNTZ,LFLAG,LNF,LC,OSC,REG
       COMMON /SLREAL/A1,A1P,A2,A2P,B1,B2,A,B,U,UNDER
+C$OMP THREADPRIVATE(/SLCLSS/,/SLINT/,/SLLOG/,/SLREAL/)
 C
       DOUBLE PRECISION DX,FP,FR,OVER,QX,T,TMU,Z,
      &            ZERO,HNDRTH,QUART,HALF,ONE,TWO,SIX,TWELVE,TWENTY
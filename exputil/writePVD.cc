@@ -39,9 +39,12 @@ void writePVD(const std::string& filename,
   for (size_t i=0; i<times.size(); i++) {
     rapidxml::xml_node<>* child = doc.allocate_node(rapidxml::node_element, "DataSet");
 
-    child->append_attribute(doc.allocate_attribute("timestep", std::to_string(times[i]).c_str()));
+    // rapidxml keeps pointers, so the time string must live in the
+    // document
+    child->append_attribute(doc.allocate_attribute("timestep", doc.allocate_string(std::to_string(times[i]).c_str())));
     child->append_attribute(doc.allocate_attribute("part", "0"));
     child->append_attribute(doc.allocate_attribute("file", files[i].c_str()));
+    coll->append_node(child);
   }
 
   // Write the property tree to the XML file.
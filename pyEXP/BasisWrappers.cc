@@ -7,9 +7,12 @@
 
 #include <BiorthBasis.H>
 #include <FieldBasis.H>
+#include <TableCache.H>
+#include <CrossValidation.H>
 
 namespace py = pybind11;
 #include <TensorToArray.H>
+#include <ExecControl.H>
 
 void BasisFactoryClasses(py::module &m)
 {
@@ -110,6 +113,10 @@ void BasisFactoryClasses(py::module &m)
     the mass and position vector.   You may clear and turn off the
     selector using the 'clrSelector()' member.
 
+    For 'createFromReader()', a selection expression such as
+    'setSelector("r < 2 and abs(z) < 0.1")' is evaluated in C++ over
+    each chunk of particles and is much faster than a functor.
+
     The FieldBasis class requires a user-specified phase-space field
     functor that produces an list of quantities derived from the
     phase space for each particle.  For example, to get a total
@@ -182,6 +189,7 @@ void BasisFactoryClasses(py::module &m)
     Orbit integration
     -----------------
     The IntegrateOrbits routine uses a fixed time step leap frog integrator
+    (or optionally a fourth-order Yoshida or Runge-Kutta scheme)
     to advance orbits from tinit to tfinal with time step h.  The initial
     positions and velocities are supplied in an nx6 NumPy array.  Tuples
     of the basis (a Basis instance) and coefficient database (a Coefs
@@ -811,6 +819,18 @@ void BasisFactoryClasses(py::module &m)
          config : str
              the YAML config string
 
+         Returns
+         -------
+         None
+         )")
+    .def_static("clearTableCache", &BasisClasses::TableCache::clear,
+	 R"(
+         Release the shared basis tables
+
+         Bases created with identical configurations share one set of
+         basis function tables, which are kept for reuse after the
+         bases are deleted.  This releases the tables not in use.
+
          Returns
          -------
          None
@@ -846,6 +866,7 @@ void BasisFactoryClasses(py::module &m)
 	   return A.createFromArray(mass, ps, time, center,
 				    roundrobin, posvelrows);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Generate the coefficients from a mass and position array or,
 	 phase-space array, time, and an optional expansion center location. 
@@ -886,6 +907,7 @@ void BasisFactoryClasses(py::module &m)
 	 {
 	   return A.makeFromArray(time);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Make the coefficients
 
@@ -909,7 +931,9 @@ void BasisFactoryClasses(py::module &m)
          )",
 	 py::arg("time")
 	 )
-    .def("setSelector", &BasisClasses::Basis::setSelector,
+    .def("setSelector",
+	 py::overload_cast<const BasisClasses::Callback&>
+	 (&BasisClasses::Basis::setSelector),
 	 R"(
          Register a Python particle selection functor. 
 
@@ -921,9 +945,47 @@ void BasisFactoryClasses(py::module &m)
          --------
          clrSelector : clears the selection set here
          )")
+    .def("setSelector",
+	 py::overload_cast<const std::string&>
+	 (&BasisClasses::Basis::setSelector),
+	 R"(
+         Register a particle selection expression, for example
+         '0.01 < R < 0.1 and abs(z) < 0.02'.  The expression is
+         parsed once and evaluated in C++ for each chunk of
+         particles from a reader, so it is much faster than a
+         Python functor and keeps the accumulation threaded.
+
+         The variables are mass, x, y, z, vx, vy, vz (or u, v, w),
+         the spherical and cylindrical radii r and R, the speed vel
+         and the particle index.  Terms combine with the arithmetic
+         operators, abs(), sqrt(), log10() and exp(), the
+         comparisons < <= > >= == != (which may be chained, as in
+         'a < b < c'), and 'and', 'or', 'not' with parentheses.
+         The expression applies to createFromReader() only; a
+         functor, if also registered, must select the particle too.
+
+         Parameters
+         ----------
+         expr : str
+             the selection expression
+
+         Returns
+         -------
+         None
+
+         Raises
+         ------
+         ValueError
+             if the expression does not parse
+
+         See also
+         --------
+         clrSelector : clears the selection set here
+         )", py::arg("expr"))
     .def("clrSelector", &BasisClasses::Basis::clrSelector,
 	 R"(
          Clear the previously registered particle selection functor
+         and expression
 
          Returns
          -------
@@ -969,7 +1031,14 @@ void BasisFactoryClasses(py::module &m)
          Needed for copying objects in the Python interpreter.  This can not be
          instantiated directly.
         )", py::arg("YAMLstring"))
-    .def("createFromReader", &BasisClasses::BiorthBasis::createFromReader,
+    .def("createFromReader",
+	 [](BasisClasses::BiorthBasis& A, PR::PRptr reader,
+	    std::vector<double> center, int threads)
+	 {
+	   ExecScope scope(threads);
+	   return A.createFromReader(reader, center);
+	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Generate the coefficients from the supplied ParticleReader
 
@@ -979,6 +1048,9 @@ void BasisFactoryClasses(py::module &m)
              the ParticleReader instance
          center : list, default=[0, 0, 0]
 	     an optional expansion center location
+         threads : int, default=0
+             OpenMP threads for this call; 0 keeps the current count.
+             The count may only be lowered.
 
          Returns
          -------
@@ -986,15 +1058,100 @@ void BasisFactoryClasses(py::module &m)
              the basis coefficients computed from the particles
          )",
 	 py::arg("reader"), 
+	 py::arg("center") = std::vector<double>(3, 0.0),
+	 py::arg("threads") = 0)
+    .def("createFromReader_async",
+	 [](std::shared_ptr<BasisClasses::BiorthBasis> A, PR::PRptr reader,
+	    std::vector<double> center, int threads)
+	 {
+	   return launchAsync([A, reader, center, threads]()
+	   {
+	     ExecScope scope(threads);
+	     return A->createFromReader(reader, center);
+	   });
+	 },
+	 R"(
+         Generate the coefficients from the supplied ParticleReader
+         on a background thread
+
+         Parameters
+         ----------
+         reader : Particle reader
+             the ParticleReader instance
+         center : list, default=[0, 0, 0]
+	     an optional expansion center location
+         threads : int, default=0
+             OpenMP threads for this call; 0 keeps the current count
+
+         Returns
+         -------
+         concurrent.futures.Future
+             resolves to the CoefStruct computed from the particles
+
+         Notes
+         -----
+         The calls run in order on the pyEXP worker pool (see
+         pyEXP.util.setAsyncWorkers) while the interpreter continues.
+         Calls on the same basis are serialized by the basis lock.
+         Do not use the reader from Python until the future is done.
+
+         See also
+         --------
+         createFromReader
+         )",
+	 py::arg("reader"), 
+	 py::arg("center") = std::vector<double>(3, 0.0),
+	 py::arg("threads") = 0)
+    .def_static("createAllFromReader",
+	 py::overload_cast<PR::PRptr,
+	 const std::vector<BasisClasses::BiorthBasis::Selected>&,
+	 std::vector<double>>(&BasisClasses::BiorthBasis::createFromReader),
+	 py::call_guard<py::gil_scoped_release>(),
+	 R"(
+         Generate the coefficients for several bases in one pass over
+         the supplied ParticleReader
+
+         Parameters
+         ----------
+         reader : Particle reader
+             the ParticleReader instance
+         bases : list(tuple(Basis, function))
+             each basis with its particle selector, or None to use
+             the selector registered with the basis.  A basis may
+             appear only once.
+         center : list, default=[0, 0, 0]
+	     an optional expansion center location
+
+         Returns
+         -------
+         list(CoefStruct)
+             the coefficients for each basis in the order of the list
+
+         Notes
+         -----
+         The snapshot is read and centered once.  Bases with a
+         selector take each chunk of particles side by side on
+         separate threads.
+
+         See also
+         --------
+         createFromReader
+         )",
+	 py::arg("reader"), py::arg("bases"),
 	 py::arg("center") = std::vector<double>(3, 0.0))
     .def("createFromArray",
-	 [](BasisClasses::BiorthBasis& A, Eigen::VectorXd& mass, RowMatrixXd& pos,
+	 [](BasisClasses::BiorthBasis& A,
+	    BasisClasses::BiorthBasis::MassRef<double> mass,
+	    BasisClasses::BiorthBasis::ArrayRef<double> pos,
 	    double time, std::vector<double> center,
 	    bool roundrobin, bool posvelrows)
 	 {
-	   return A.createFromArray(mass, pos, time, center,
-				    roundrobin, posvelrows);
+	   auto guard = A.lock();
+	   A.initFromArray(center);
+	   A.addFromArray(mass, pos, roundrobin, posvelrows);
+	   return A.makeFromArray(time);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Generate the coefficients from a mass and position array,
 	 time, and an optional expansion center location. 
@@ -1059,10 +1216,14 @@ void BasisFactoryClasses(py::module &m)
          )",
 	 py::arg("center") = std::vector<double>(3, 0.0))
     .def("addFromArray",
-	 [](BasisClasses::BiorthBasis& A, Eigen::VectorXd& mass, RowMatrixXd& pos)
+	 [](BasisClasses::BiorthBasis& A,
+	    BasisClasses::BiorthBasis::MassRef<double> mass,
+	    BasisClasses::BiorthBasis::ArrayRef<double> pos, int threads)
 	 {
+	   ExecScope scope(threads);
 	   return A.addFromArray(mass, pos);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Add particle contributions to coefficients
 
@@ -1081,9 +1242,37 @@ void BasisFactoryClasses(py::module &m)
          --------
          initFromArray : initialize for coefficient contributions
          makeFromArray : create coefficients contributions
+
+         Notes
+         -----
+         Float64 and float32 numpy arrays of any stride, including
+         slices and memory-mapped arrays, are used in place without
+         a copy.  Spherical bases accumulate over threads unless a
+         particle selector is set.  The optional 'threads' argument
+         lowers the OpenMP thread count for this call only.
          )",
-	 py::arg("mass"), py::arg("pos"))
-    .def("getFields", &BasisClasses::BiorthBasis::getFields,
+	 py::arg("mass"), py::arg("pos"), py::arg("threads") = 0)
+    .def("addFromArray",
+	 [](BasisClasses::BiorthBasis& A,
+	    BasisClasses::BiorthBasis::MassRef<float> mass,
+	    BasisClasses::BiorthBasis::ArrayRef<float> pos, int threads)
+	 {
+	   ExecScope scope(threads);
+	   return A.addFromArray(mass, pos);
+	 },
+	 py::call_guard<py::gil_scoped_release>(),
+	 "Add particle contributions to coefficients from float32 arrays",
+	 py::arg("mass"), py::arg("pos"), py::arg("threads") = 0)
+    .def("getFields",
+	 [](BasisClasses::BiorthBasis& A, double x, double y, double z,
+	    bool release)
+	 {
+	   if (release) {
+	     py::gil_scoped_release nogil;
+	     return A.getFields(x, y, z);
+	   }
+	   return A.getFields(x, y, z);
+	 },
 	 R"(
          Return the field evaluations for a given cartesian position. The
          fields include density, potential, and force.  The density and
@@ -1102,6 +1291,10 @@ void BasisFactoryClasses(py::module &m)
              y-axis position
          z : float
              z-axis position
+         release : bool, default=False
+             release the GIL during the evaluation so that other
+             Python threads may run.  Only worthwhile when several
+             Python threads evaluate fields at once.
 
          Returns
          -------
@@ -1112,8 +1305,9 @@ void BasisFactoryClasses(py::module &m)
          getFieldsCoefs : get fields for each coefficient set
          __call__       : same getFields() but provides field labels in a tuple
          )",
-	 py::arg("x"), py::arg("y"), py::arg("z"))
+	 py::arg("x"), py::arg("y"), py::arg("z"), py::arg("release") = false)
     .def("getFieldsCoefs", &BasisClasses::BiorthBasis::getFieldsCoefs,
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Return the field evaluations for a given cartesian position
          for every frame in a coefficient set.  The field evaluations are
@@ -1930,7 +2124,14 @@ void BasisFactoryClasses(py::module &m)
          None
          )",
 	 py::arg("function"), py::arg("labels"))
-    .def("createFromReader", &BasisClasses::FieldBasis::createFromReader,
+    .def("createFromReader",
+	 [](BasisClasses::FieldBasis& A, PR::PRptr reader,
+	    std::vector<double> center, int threads)
+	 {
+	   ExecScope scope(threads);
+	   return A.createFromReader(reader, center);
+	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Generate the coefficients from the supplied ParticleReader
 
@@ -1940,6 +2141,9 @@ void BasisFactoryClasses(py::module &m)
              the ParticleReader instance
          center : list, default=[0, 0, 0]
 	     an optional expansion center location
+         threads : int, default=0
+             OpenMP threads for this call; 0 keeps the current count.
+             The count may only be lowered.
 
          Returns
          -------
@@ -1947,7 +2151,43 @@ void BasisFactoryClasses(py::module &m)
              the basis coefficients computed from the particles
          )",
 	 py::arg("reader"), 
-	 py::arg("center") = std::vector<double>(3, 0.0))
+	 py::arg("center") = std::vector<double>(3, 0.0),
+	 py::arg("threads") = 0)
+    .def("createFromReader_async",
+	 [](std::shared_ptr<BasisClasses::FieldBasis> A, PR::PRptr reader,
+	    std::vector<double> center, int threads)
+	 {
+	   return launchAsync([A, reader, center, threads]()
+	   {
+	     ExecScope scope(threads);
+	     return A->createFromReader(reader, center);
+	   });
+	 },
+	 R"(
+         Generate the coefficients from the supplied ParticleReader
+         on a background thread
+
+         Parameters
+         ----------
+         reader : Particle reader
+             the ParticleReader instance
+         center : list, default=[0, 0, 0]
+	     an optional expansion center location
+         threads : int, default=0
+             OpenMP threads for this call; 0 keeps the current count
+
+         Returns
+         -------
+         concurrent.futures.Future
+             resolves to the CoefStruct computed from the particles
+
+         See also
+         --------
+         createFromReader
+         )",
+	 py::arg("reader"), 
+	 py::arg("center") = std::vector<double>(3, 0.0),
+	 py::arg("threads") = 0)
     .def("initFromArray",
 	 [](BasisClasses::FieldBasis& A, std::vector<double> center)
 	 {
@@ -1982,6 +2222,7 @@ void BasisFactoryClasses(py::module &m)
 	 {
 	   return A.addFromArray(mass, ps);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Add particle contributions to coefficients
 
@@ -2007,6 +2248,7 @@ void BasisFactoryClasses(py::module &m)
 	 {
 	   return A.makeFromArray(time);
 	 },
+	 py::call_guard<py::gil_scoped_release>(),
 	 R"(
          Make the coefficients
 
@@ -2178,15 +2420,21 @@ void BasisFactoryClasses(py::module &m)
   m.def("IntegrateOrbits", 
 	[](double tinit, double tfinal, double h, Eigen::MatrixXd ps,
 	   std::vector<BasisClasses::BasisCoef> bfe,
-	   BasisClasses::AccelFunc& func, int stride)
+	   BasisClasses::AccelFunc& func, int stride, const std::string& method,
+	   int threads)
 	{
 	  Eigen::VectorXd T;
 	  Eigen::Tensor<float, 3> O;
 
 	  AccelFunctor F = [&func](double t, Eigen::MatrixXd& ps, Eigen::MatrixXd& accel, BasisCoef mod)->Eigen::MatrixXd& { return func.F(t, ps, accel, mod);};
 
-	  std::tie(T, O) =
-	    BasisClasses::IntegrateOrbits(tinit, tfinal, h, ps, bfe, F, stride);
+	  {
+	    py::gil_scoped_release release;
+	    ExecScope scope(threads);
+	    std::tie(T, O) =
+	      BasisClasses::IntegrateOrbits(tinit, tfinal, h, ps, bfe, F, stride,
+					    method);
+	  }
 
 	  py::array_t<float> ret = make_ndarray3<float>(O);
 	  return std::tuple<Eigen::VectorXd, py::array_t<float>>(T, ret);
@@ -2219,13 +2467,145 @@ void BasisFactoryClasses(py::module &m)
             the force function
         nout : int 
             the number of output points, if specified
+        method : str, default='leapfrog'
+            the integrator: 'leapfrog' (second order, one force
+            evaluation per step), 'yoshida' (fourth-order symplectic,
+            three evaluations) or 'rk4' (fourth-order Runge-Kutta,
+            four evaluations)
+        threads : int, default=0
+            OpenMP threads for this call; 0 keeps the current count.
+            The count may only be lowered.
 
         Returns
         -------
         tuple(numpy.array, numpy.ndarray)
             time and phase-space arrays
+
+        Notes
+        -----
+        The coefficients are installed once per force evaluation and
+        the accelerations for all orbits are then computed in parallel
+        over OpenMP threads.
         )",
 	py::arg("tinit"), py::arg("tfinal"), py::arg("h"),
 	py::arg("ps"), py::arg("basiscoef"), py::arg("func"),
-	py::arg("nout")=0);
+	py::arg("nout")=0, py::arg("method")="leapfrog", py::arg("threads")=0);
+
+  py::class_<BasisClasses::CrossValidation, std::shared_ptr<BasisClasses::CrossValidation>>(m, "CrossValidation")
+    .def(py::init<std::shared_ptr<BasisClasses::BiorthBasis>, int>(),
+	 R"(
+         K-fold cross validation of the basis truncation
+
+         The particles are split into partitions by their order and the
+         coefficients of each partition are computed once.  Every
+         truncation and signal-to-noise threshold is then scored from
+         these partial sums without another pass through the particles.
+
+         Parameters
+         ----------
+         basis : Basis
+             a spherical, cylindrical or disk basis
+         npart : int, default=8
+             the number of partitions
+
+         Returns
+         -------
+         CrossValidation
+
+         Notes
+         -----
+         The score is the energy-norm integrated squared error of the
+         held-out partition less a constant.  Smaller is better.
+         )", py::arg("basis"), py::arg("npart")=8)
+    .def("compute",
+	 [](BasisClasses::CrossValidation& A, PR::PRptr reader,
+	    std::vector<double> ctr)
+	 {
+	   py::gil_scoped_release release;
+	   A.compute(reader, ctr);
+	 },
+	 R"(
+         Accumulate the partition coefficients from a particle reader
+
+         Parameters
+         ----------
+         reader : ParticleReader
+             the particle reader
+         center : list(float), default=[0, 0, 0]
+             the expansion center
+
+         Returns
+         -------
+         None
+         )", py::arg("reader"), py::arg("center")=std::vector<double>(3, 0.0))
+    .def("compute",
+	 [](BasisClasses::CrossValidation& A, Eigen::VectorXd& mass,
+	    RowMatrixXd& pos, double time, std::vector<double> ctr)
+	 {
+	   py::gil_scoped_release release;
+	   A.compute(mass, pos, time, ctr);
+	 },
+	 R"(
+         Accumulate the partition coefficients from arrays
+
+         Parameters
+         ----------
+         mass : numpy.ndarray
+             the n particle masses
+         pos : numpy.ndarray
+             an n x 3 array of positions
+         time : float, default=0.0
+             the snapshot time
+         center : list(float), default=[0, 0, 0]
+             the expansion center
+
+         Returns
+         -------
+         None
+         )", py::arg("mass"), py::arg("pos"), py::arg("time")=0.0,
+	 py::arg("center")=std::vector<double>(3, 0.0))
+    .def("getCoefficients", &BasisClasses::CrossValidation::getCoefficients,
+	 R"(
+         The coefficients from all particles
+
+         Returns
+         -------
+         CoefStruct
+         )")
+    .def("truncation", &BasisClasses::CrossValidation::truncation,
+	 R"(
+         Score every truncation of the expansion
+
+         Returns
+         -------
+         numpy.ndarray
+             element (h, n) is the score for keeping harmonic indices 0
+             through h and radial indices 0 through n
+         )")
+    .def("snr", &BasisClasses::CrossValidation::snr,
+	 R"(
+         Score a list of signal-to-noise thresholds
+
+         Parameters
+         ----------
+         thresholds : list(float)
+             the thresholds to score
+         Hall : bool, default=False
+             if False, keep a coefficient whose snr is at least the
+             threshold; otherwise weight it by 1/((threshold/snr)^Hexp + 1)
+         Hexp : float, default=1.0
+             the exponent of the Hall weight
+
+         Returns
+         -------
+         numpy.ndarray
+             the score for each threshold
+
+         Notes
+         -----
+         The snr of each coefficient is computed in each fold from the
+         training partitions alone.  Requires at least 3 partitions.
+         )", py::arg("thresholds"), py::arg("Hall")=false, py::arg("Hexp")=1.0)
+    .def("partitions", &BasisClasses::CrossValidation::partitions,
+	 "The number of partitions");
 }
@@ -101,7 +101,8 @@ void CoefficientClasses(py::module &m) {
     object passed on creation, and it update the values of the
     coefficients on reconstruction, without copying. If you want to
     keep the initial set without change, we have provided a
-    'deepcopy()' member that provides a byte-by-byte copy.
+    'deepcopy()' member that provides a copy.  The copy shares the
+    snapshot data with the original until a snapshot is changed.
 
   )";
 
@@ -1087,7 +1088,12 @@ void CoefficientClasses(py::module &m) {
          CoefStruct : the coefficient structure for a single snaphot
          )",py::arg("coef"))
     .def("getCoefStruct",
-         &CoefClasses::Coefs::getCoefStruct,
+         [](CoefClasses::Coefs& A, double time)
+         {
+           // The structure may be changed from Python
+           A.invalidate();
+           return A.getCoefStruct(time);
+         },
          R"(
          Return the coefficient structure for the desired time
 
@@ -1104,6 +1110,25 @@ void CoefficientClasses(py::module &m) {
          -----
          You will get a runtime error if the entry does not exist.
          )",py::arg("time"))
+    .def("getSeries",
+         &CoefClasses::Coefs::getSeries,
+         py::return_value_policy::reference_internal,
+         R"(
+         All coefficients as one contiguous array indexed by time and
+         flattened coefficient
+
+         Returns
+         -------
+         numpy.ndarray
+             read-only view of the [time, coefficient] array; row t is
+             the flattened coefficient array at Times()[t]
+
+         Notes
+         -----
+         The array is not copied.  It stays valid until the container
+         is changed (add, setData, zerodata, clear, getCoefStruct), after
+         which getSeries() should be called again.
+         )")
     .def("Times",
             &CoefClasses::Coefs::Times,
             R"(
@@ -1169,6 +1194,14 @@ void CoefficientClasses(py::module &m) {
              -------
              numpy.ndarray: 
                  table of coefficient power values
+
+             Notes
+             -----
+             For spherical and cylindrical coefficients, the power of
+             each snapshot is cached until that snapshot changes, so
+             repeated calls and calls after add() only compute the
+             new rows.  Lazily loaded files are streamed a block at a
+             time rather than read into memory.
              )",py::arg("min")=0, py::arg("max")=std::numeric_limits<int>::max())
     .def("makeKeys",
          &CoefClasses::Coefs::makeKeys,
@@ -1237,6 +1270,10 @@ void CoefficientClasses(py::module &m) {
          filter using mSSA but keep a copy of your original
          coefficient db for comparison
 
+         The copy shares the snapshot data with the original until
+         either one changes a snapshot, so only the changed
+         snapshots take new memory.
+
          See also
          --------
          pyEXP.mssa
@@ -1272,15 +1309,163 @@ void CoefficientClasses(py::module &m) {
                    minimum time value
               tmax : float, default=inf
                    maximum time value
+              lazy : bool, default=False
+                   open and index an HDF5 spherical or cylindrical
+                   coefficient file and read snapshots on demand
 
             Returns
             -------
             Coefs
                 the newly created Coefs object
+
+            Notes
+            -----
+            In lazy mode, getData, getCoefStruct, interpolate and the
+            MSSA/Koopman channel packing read snapshots through an LRU
+            cache of blocks of consecutive snapshots (see
+            setLazyCache).  Members that need all snapshots at once,
+            such as Power or getAllCoefs, read the rest of the file.
             )",
             py::arg("file"), py::arg("stride")=1,
             py::arg("tmin")=-std::numeric_limits<double>::max(),
-            py::arg("tmax")= std::numeric_limits<double>::max())
+            py::arg("tmax")= std::numeric_limits<double>::max(),
+            py::arg("lazy")=false)
+    .def_static("setLazyCache", &CoefClasses::Coefs::setLazyCache,
+              R"(
+              Set the snapshot cache used by lazily read coefficients
+
+              Parameters
+              ----------
+              block : int
+                  number of consecutive snapshots read at once
+              nblocks : int
+                  number of blocks kept in memory
+
+              Returns
+              -------
+              None
+              )", py::arg("block"), py::arg("nblocks"))
+    .def("setH5Chunked", &CoefClasses::Coefs::setH5Chunked,
+         R"(
+         Select the layout of new HDF5 coefficient files
+
+         With window>0, spherical and cylindrical coefficients are
+         written as one extendible dataset per harmonic shaped
+         [time, nmax, 2], chunked in windows of snapshots, so that
+         appending is cheap and each coefficient series is read
+         contiguously.  Files in either layout are read by factory.
+
+         Parameters
+         ----------
+         window : int
+             snapshots per chunk (0 writes one group per snapshot)
+         level : int, default=0
+             deflate compression level (0 for none)
+         swmr : bool, default=False
+             append to chunked files in single-writer/multiple-reader
+             mode so that readers may follow them with refresh()
+
+         Returns
+         -------
+         None
+         )", py::arg("window"), py::arg("level")=0, py::arg("swmr")=false)
+    .def("setH5Compressed", &CoefClasses::Coefs::setH5Compressed,
+         R"(
+         Write new HDF5 coefficient files as a compressed archive
+
+         The mean snapshot is removed and the remainder is factored by
+         a thin SVD over time.  Only the leading components and the
+         per-snapshot projections are stored, with the residual norm
+         of each snapshot.  Archives are read by factory and
+         reconstructed on read, so getAllCoefs and interpolation work
+         as for the other layouts.  Archives cannot be extended.
+         Spherical and cylindrical coefficients only.
+
+         Parameters
+         ----------
+         rank : int
+             maximum number of components (0 for no limit)
+         tol : float, default=0
+             relative RMS residual target used to choose the number
+             of components (0 for none)
+
+         Returns
+         -------
+         None
+         )", py::arg("rank"), py::arg("tol")=0.0)
+    .def("getArchiveResidual", &CoefClasses::Coefs::getArchiveResidual,
+         R"(
+         Residual norm of each snapshot of a compressed archive
+
+         Returns
+         -------
+         dict({float: float})
+             the residual norm by snapshot time; empty unless the
+             coefficients were read from a compressed archive
+         )")
+    .def("refresh", &CoefClasses::Coefs::refresh,
+         R"(
+         Append the snapshots added to the HDF5 file since it was read
+
+         For coefficients read by factory from a spherical or
+         cylindrical HDF5 file that is still being written, e.g. by a
+         running simulation.  The stride and time range of the
+         original read are kept.  Chunked files written with swmr=True
+         are read in SWMR mode.
+
+         Returns
+         -------
+         int
+             the number of snapshots added; zero if there are none or
+             the file is busy
+         )")
+    .def("setInterpolation", &CoefClasses::Coefs::setInterpolation,
+         R"(
+         Select the interpolation scheme between snapshots
+
+         'linear' (the default) blends the two bracketing snapshots.
+         'cubic' uses a piecewise cubic Hermite interpolant with slopes
+         estimated from the neighboring snapshots, which has a
+         continuous time derivative.  The last interpolated time is
+         cached so repeated requests are free.
+
+         Parameters
+         ----------
+         method : str
+             'linear' or 'cubic'
+
+         Returns
+         -------
+         None
+         )", py::arg("method"))
+    .def("derivative",
+         [](CoefClasses::Coefs& A, double time)
+         {
+           Eigen::VectorXcd ret = A.derivative(time);
+           return ret;
+         },
+         R"(
+         Time derivative of the interpolated coefficients
+
+         Parameters
+         ----------
+         time : float
+             evaluation time
+
+         Returns
+         -------
+         numpy.ndarray
+             flattened coefficient derivative in the order used by
+             the interpolator
+         )", py::arg("time"))
+    .def("isLazy", &CoefClasses::Coefs::isLazy,
+         R"(
+         True if snapshots are read from the file on demand
+
+         Returns
+         -------
+         bool
+         )")
     .def_static("makecoefs", &CoefClasses::Coefs::makecoefs,
 		R"(
                 make a new coefficient container instance compatible
@@ -90,9 +90,41 @@ void EDMDtoolkitClasses(py::module &m) {
     "  power: true           Write partial power contributions into a file in\n"
     "                        a ascii table format if set to 'true'.  Default\n"
     "                        is 'false'\n"
+    "  randomized: true      Randomized DMD (Erichson et al. 2019): sketch\n"
+    "                        the state matrix onto nEV+oversample random\n"
+    "                        directions refined by subspace iterations and\n"
+    "                        decompose the compressed matrix\n"
+    "  GPU: true             Compute the randomized SVD (default or\n"
+    "                        'randomized: true') on the GPU with cuBLAS\n"
+    "                        and cuSOLVER.  Falls back to the CPU if no\n"
+    "                        device is available.\n"
+    "  streaming: true       Streaming DMD (Hemati et al. 2014): absorb the\n"
+    "                        snapshot pairs one at a time into bases of at\n"
+    "                        most maxRank vectors so memory does not grow\n"
+    "                        with the series length.  Uses projected modes.\n"
+    "                        The model may be extended with update().\n"
+    "  kernel: string        Kernel EDMD (Williams et al. 2015) with a\n"
+    "                        'gaussian' or 'polynomial' kernel.  The state\n"
+    "                        is replaced by Nystrom features computed against\n"
+    "                        a random subset of 'landmarks' snapshots, so the\n"
+    "                        N_time x N_time kernel matrix is never formed.\n"
+    "                        The features are decomposed by the SVD method\n"
+    "                        selected above.  May not be combined with\n"
+    "                        'streaming'.\n"
     "The following parameters take values, defaults are given in ()\n\n"
     "  output: sting         Prefix name for output files.  The default is\n"
-    "                        'exp_edmd'.\n\n"
+    "                        'exp_edmd'.\n"
+    "  oversample: int(10)   Oversampling for 'randomized: true'\n"
+    "  powerIter: int(2)     Subspace iterations for 'randomized: true'\n"
+    "  maxRank: int(nEV)     Basis size bound for 'streaming: true'\n"
+    "  landmarks: int(500)   Number of Nystrom landmarks for 'kernel'\n"
+    "  bandwidth: float      Gaussian width or polynomial scale for 'kernel';\n"
+    "                        defaults to the median landmark separation or\n"
+    "                        the mean squared landmark norm\n"
+    "  degree: int(2)        Polynomial kernel degree\n"
+    "  offset: float(1.0)    Polynomial kernel offset\n"
+    "  seed: int(11)         Random seed for the landmark choice\n"
+    "  cache: string         Prefix of an analysis cache; see Save/Restore\n\n"
     "The 'output' value is used by 'getContributions()' and 'channelDFT()'\n"
     "if the 'power' options is set.\n"
     "A simple YAML configuration for Koopman might look like this:\n"
@@ -114,6 +146,11 @@ void EDMDtoolkitClasses(py::module &m) {
     "list so it should be pretty hard to fool, but not impossible.  The\n"
     "computation is much less expensive, generally, than MSSA so saving the\n"
     "analysis is not strictly necessary, even on a laptop.\n\n"
+    "With 'cache: prefix' in the YAML parameters this is automatic: the\n"
+    "analysis is written to <prefix>_edmd.h5 when it is computed, and a\n"
+    "new instance restores it rather than recomputing when the file holds\n"
+    "a matching fingerprint of the input series, number of eigenvalues\n"
+    "and decomposition parameters.  A stale cache is replaced.\n\n"
     "Computational notes\n"
     "-------------------\n"
     "Some of the linear algebra operations can parallelize itself using\n"
@@ -133,6 +170,7 @@ void EDMDtoolkitClasses(py::module &m) {
     f(m, "Koopman");
 
   f.def(py::init<const mssaConfig&, int, const std::string>(),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Koopman operator approximatation class
 
@@ -197,6 +235,7 @@ void EDMDtoolkitClasses(py::module &m) {
         )");
 
   f.def("reconstruct", &Koopman::reconstruct,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Reconstruct the data channels with the provided list of eigenvalue indices
 
@@ -235,6 +274,29 @@ void EDMDtoolkitClasses(py::module &m) {
 	"of 2d arrays. These are intended to be plotted using 'imshow'.
         )");
 
+  f.def("update", &Koopman::update, py::arg("config"),
+	py::call_guard<py::gil_scoped_release>(),
+	R"(
+        Extend the analysis with new coefficient snapshots
+
+        Parameters
+        ----------
+        config : mssaConfig
+            the input database used for the constructor, whose Coefs
+            now hold the original times followed by new ones
+
+        Returns
+        -------
+        None
+
+        Notes
+        -----
+        With 'streaming: true' only the new snapshot pairs are
+        absorbed into the streaming model and the eigenvalues and
+        modes are recomputed from it.  Otherwise the analysis is
+        recomputed for the full series on the next request.
+        )");
+
   f.def("saveState", &Koopman::saveState,
 	R"(
         Save current EDMD state to an HDF5 file with the given prefix
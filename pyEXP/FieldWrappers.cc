@@ -7,6 +7,7 @@
 namespace py = pybind11;
 
 #include "TensorToArray.H"
+#include "ExecControl.H"
 
 void FieldGeneratorClasses(py::module &m) {
 
@@ -156,7 +157,14 @@ void FieldGeneratorClasses(py::module &m) {
            Number of scale heights above and below plane for search
         )", py::arg("colheight"));
 
-  f.def("slices", &Field::FieldGenerator::slices,
+  f.def("slices",
+	[](FieldGenerator& A, BasisClasses::BasisPtr basis,
+	   CoefClasses::CoefsPtr coefs, int threads)
+	{
+	  ExecScope scope(threads);
+	  return A.slices(basis, coefs);
+	},
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Return a dictionary of grids (2d numpy arrays) indexed by time and field type
 
@@ -166,6 +174,9 @@ void FieldGeneratorClasses(py::module &m) {
             basis instance of any geometry; geometry will be deduced by the generator
         coefs : Coefs
             coefficient container instance
+        threads : int, default=0
+            OpenMP threads for this call; 0 keeps the current count.
+            The count may only be lowered.
 
         Returns
         -------
@@ -183,9 +194,44 @@ void FieldGeneratorClasses(py::module &m) {
         points : generate fields at an array of mesh points
         lines : generate fields along a line given by its end points
         volumes : generate fields in volume given by the initializtion grid
-       )", py::arg("basis"), py::arg("coefs"));
+        slices_async : the same on a background thread
+       )", py::arg("basis"), py::arg("coefs"), py::arg("threads")=0);
+
+  f.def("slices_async",
+	[](std::shared_ptr<FieldGenerator> A, BasisClasses::BasisPtr basis,
+	   CoefClasses::CoefsPtr coefs, int threads)
+	{
+	  return launchAsync([A, basis, coefs, threads]()
+	  {
+	    ExecScope scope(threads);
+	    return A->slices(basis, coefs);
+	  });
+	},
+	R"(
+        Compute the slices on a background thread
+
+        Parameters
+        ----------
+        basis : Basis
+            basis instance of any geometry
+        coefs : Coefs
+            coefficient container instance
+        threads : int, default=0
+            OpenMP threads for this call; 0 keeps the current count
+
+        Returns
+        -------
+        concurrent.futures.Future
+            resolves to the dictionary returned by slices()
+
+        Notes
+        -----
+        Do not change the generator, basis or coefficients from Python
+        until the future is done.
+       )", py::arg("basis"), py::arg("coefs"), py::arg("threads")=0);
   
   f.def("points", &Field::FieldGenerator::points,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Return a dictionary of arrays (1d numpy arrays) indexed by time
         and field type corresponding to the mesh points
@@ -217,6 +263,7 @@ void FieldGeneratorClasses(py::module &m) {
        )", py::arg("basis"), py::arg("coefs"));
   
   f.def("lines", &Field::FieldGenerator::lines,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Return a dictionary of arrays indexed by time and field type
 
@@ -257,6 +304,7 @@ void FieldGeneratorClasses(py::module &m) {
 	py::arg("beg"), py::arg("end"), py::arg("num"));
   
   f.def("histo2d", &Field::FieldGenerator::histogram2d,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Compute a surface histogram from particlesReturn a density histogram
 
@@ -273,12 +321,17 @@ void FieldGeneratorClasses(py::module &m) {
 
         Notes
         -----
-        Range for histogram is taken from the grid ranges in the constructor
+        Range for histogram is taken from the grid ranges in the constructor.
+        Every plane with a non-zero grid size (xy, xz, yz) is filled in the
+        same pass over the particles, using all threads.
         )",
 	py::arg("reader"),
 	py::arg("center") = std::vector<double>(3, 0.0));
 
-  f.def("histo1d", &Field::FieldGenerator::histogram1d,
+  f.def("histo1d",
+	py::overload_cast<PR::PRptr, double, int, std::string,
+	std::vector<double>>(&Field::FieldGenerator::histogram1d),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Make a 1d density histogram (array) for a chosen projection
 
@@ -304,7 +357,38 @@ void FieldGeneratorClasses(py::module &m) {
 	py::arg("projection"),
 	py::arg("center") = std::vector<double>(3, 0.0));
 
+  f.def("histo1d",
+	py::overload_cast<PR::PRptr, double, int, std::vector<std::string>,
+	std::vector<double>>(&Field::FieldGenerator::histogram1d),
+	py::call_guard<py::gil_scoped_release>(),
+	R"(
+        Make 1d density histograms for several projections in one pass
+        over the particles
+
+        Parameters
+        ----------
+        reader : ParticleReader
+            particle reader instance
+        rmax : float
+            linear extent of the histogram
+        nbins : int
+            number of bins
+        projection : list(str)
+            projections from \"xy\", \"xz\", \"yz\", \"r\"
+        center : list(float, float, float), default=[0, 0, 0]
+            origin for computing the histogram
+
+        Returns
+        -------
+        dict({str: numpy.ndarray})
+            the computed 1d histogram for each projection
+        )",
+	py::arg("reader"), py::arg("rmax"), py::arg("nbins"),
+	py::arg("projection"),
+	py::arg("center") = std::vector<double>(3, 0.0));
+
   f.def("histo1dlog", &Field::FieldGenerator::histo1dlog,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Make a 1d density histogram (array) in spherical projection with
         logarithmic scaling
@@ -331,6 +415,7 @@ void FieldGeneratorClasses(py::module &m) {
 	py::arg("center") = std::vector<double>(3, 0.0));
 
   f.def("file_lines", &Field::FieldGenerator::file_lines,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Write field arrays to files using the supplied string prefix.
 
@@ -375,6 +460,7 @@ void FieldGeneratorClasses(py::module &m) {
 	py::arg("num")=1000, py::arg("filename"), py::arg("dir")=".");
 
   f.def("file_slices", &Field::FieldGenerator::file_slices,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Write 2d field grids to files using the supplied string prefix. "
 
@@ -388,6 +474,8 @@ void FieldGeneratorClasses(py::module &m) {
             file name for output
         dir : str, default='.'
             directory to write files
+        compress : bool, default=True
+            zlib compress the data (if EXP was built with zlib)
 
         Returns
         -------
@@ -395,7 +483,10 @@ void FieldGeneratorClasses(py::module &m) {
 
         Notes
         -----
-	The files will be ascii or VTK rectangular grid files (if you compiled with VTK)
+        Each time is written as binary VTK image data,
+        <filename>_surface_<n>.vti, and <filename>_surface.pvd indexes
+        them by time for ParaView.  The files are written in parallel
+        over threads and do not need the VTK library.
 
         See also
         --------
@@ -406,21 +497,35 @@ void FieldGeneratorClasses(py::module &m) {
         lines : generate fields along a line given by its end points
         )",
 	py::arg("basis"), py::arg("coefs"), py::arg("filename"),
-	py::arg("dir")=".");
+	py::arg("dir")=".", py::arg("compress")=true);
+
 
+  // Volumes to numpy arrays
+  //
+  using Volumes = std::map<double, std::map<std::string, Eigen::Tensor<float, 3>>>;
 
-  f.def("volumes", [](FieldGenerator& A,
-		      BasisClasses::BasisPtr basis, CoefClasses::CoefsPtr coefs)
+  auto volumesToArrays = [](Volumes& vols)
   {
     std::map<double, std::map<std::string, py::array_t<float>>> ret;
-    auto vols = A.volumes(basis, coefs);
     for (auto & v : vols) {
       for (auto & u : v.second) {
 	ret[v.first][u.first] = make_ndarray3<float>(u.second);
       }
     }
+    return py::cast(ret);
+  };
 
-    return ret;
+  f.def("volumes", [volumesToArrays](FieldGenerator& A,
+				     BasisClasses::BasisPtr basis,
+				     CoefClasses::CoefsPtr coefs, int threads)
+  {
+    Volumes vols;
+    {
+      py::gil_scoped_release release;
+      ExecScope scope(threads);
+      vols = A.volumes(basis, coefs);
+    }
+    return volumesToArrays(vols);
   },
 	R"(
         Volume grids (3d numpy arrays) indexed by time and field type
@@ -431,6 +536,9 @@ void FieldGeneratorClasses(py::module &m) {
             basis instance of any geometry; geometry will be deduced by the generator
         coefs : Coefs
             coefficient container instance
+        threads : int, default=0
+            OpenMP threads for this call; 0 keeps the current count.
+            The count may only be lowered.
 
         Returns
         -------
@@ -448,9 +556,40 @@ void FieldGeneratorClasses(py::module &m) {
 
         lines : generate fields along a line given by its end points
         slices : generate fields in a slice given by the initializtion grid
-        )");
+        volumes_async : the same on a background thread
+        )", py::arg("basis"), py::arg("coefs"), py::arg("threads")=0);
+
+  f.def("volumes_async",
+	[volumesToArrays](std::shared_ptr<FieldGenerator> A,
+			  BasisClasses::BasisPtr basis,
+			  CoefClasses::CoefsPtr coefs, int threads)
+	{
+	  return launchAsync([A, basis, coefs, threads]()
+	  {
+	    ExecScope scope(threads);
+	    return A->volumes(basis, coefs);
+	  }, volumesToArrays);
+	},
+	R"(
+        Compute the volumes on a background thread
+
+        Parameters
+        ----------
+        basis : Basis
+            basis instance of any geometry
+        coefs : Coefs
+            coefficient container instance
+        threads : int, default=0
+            OpenMP threads for this call; 0 keeps the current count
+
+        Returns
+        -------
+        concurrent.futures.Future
+            resolves to the dictionary returned by volumes()
+        )", py::arg("basis"), py::arg("coefs"), py::arg("threads")=0);
 
   f.def("file_volumes", &Field::FieldGenerator::file_volumes,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
 	Write 3d field grids to files using the supplied string prefix
 
@@ -464,6 +603,8 @@ void FieldGeneratorClasses(py::module &m) {
             file name for output
         dir : str, default='.'
             directory to write files
+        compress : bool, default=True
+            zlib compress the data (if EXP was built with zlib)
 
         Returns
         -------
@@ -471,7 +612,12 @@ void FieldGeneratorClasses(py::module &m) {
 
         Notes
         -----
-	The files will be ascii or VTK rectangular grid files (if you ompiled with VTK
+        Each time is written as binary VTK image data and
+        <filename>_volume.pvd indexes them by time for ParaView.  With
+        fewer times than threads, each volume is split into pieces,
+        <filename>_volume_<n>_<p>.vti with a <filename>_volume_<n>.pvti
+        index, so that the pieces are written in parallel.  The VTK
+        library is not needed.
 
         See also
         --------
@@ -479,5 +625,52 @@ void FieldGeneratorClasses(py::module &m) {
         file_slices : generate files with fields along surfaces
 	)",
 	py::arg("basis"), py::arg("coefs"), py::arg("filename"),
-	py::arg("dir")=".");
+	py::arg("dir")=".", py::arg("compress")=true);
+
+  f.def("stream_volumes", &Field::FieldGenerator::stream_volumes,
+	py::call_guard<py::gil_scoped_release>(),
+	R"(
+	Write 3d field grids for all times to a single HDF5 file
+
+        Parameters
+        ----------
+        basis : Basis
+            basis instance of any geometry; geometry will be deduced by the generator
+        coefs : Coefs
+            coefficient container instance
+        filename : str
+            HDF5 file name for output
+        stride : int, default=1
+            evaluate every stride-th grid point along each axis
+        half : bool, default=False
+            store the fields in IEEE half precision
+        tiles : int, default=1
+            number of MPI ranks that share each time, each one
+            evaluating a slab of x planes
+
+        Returns
+        -------
+        None
+
+        Notes
+        -----
+        Unlike volumes, the grids are not accumulated in memory.  Each
+        time slab is written to the chunked dataset fields/<name> of
+        shape (time, x, y, z) as soon as it is computed, and the write
+        overlaps the computation of the next time.  The times are in
+        the dataset 'times' and the grid limits and downsampled shape
+        are attributes of the file.
+
+        Under MPI, the ranks are split into groups of 'tiles' and each
+        group evaluates a contiguous block of times.  With coefficients
+        read lazily (see Coefs.factory), each rank then reads only the
+        coefficients for its own times.
+
+        See also
+        --------
+        volumes : generate fields in volume given by the initializtion grid
+        file_volumes : write the volumes to VTK or ascii files
+	)",
+	py::arg("basis"), py::arg("coefs"), py::arg("filename"),
+	py::arg("stride")=1, py::arg("half")=false, py::arg("tiles")=1);
 }
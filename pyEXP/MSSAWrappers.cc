@@ -6,6 +6,7 @@
 
 namespace py = pybind11;
 #include <TensorToArray.H>
+#include <ExecControl.H>
 
 void MSSAtoolkitClasses(py::module &m) {
 
@@ -85,10 +86,29 @@ void MSSAtoolkitClasses(py::module &m) {
     "                        In practice, 'Traj: true' is sufficiently\n"
     "                        accurate for all PC orders that are typically\n"
     "                        found to have dynamical signal.\n"
+    "  Hankel: true          Never form the trajectory matrix.  The SVD\n"
+    "                        is computed by a randomized range finder\n"
+    "                        whose products with the trajectory matrix\n"
+    "                        use FFT correlations of the channels, so\n"
+    "                        memory scales as channels x T rather than\n"
+    "                        channels x window x T.  Implies Traj: true;\n"
+    "                        uses 'rank' and ignores Jacobi and BDCSVD.\n"
+    "  MPI: true             Distribute the trajectory matrix over MPI\n"
+    "                        ranks by blocks of channels.  The SVD is the\n"
+    "                        same randomized range finder with sketches\n"
+    "                        summed over ranks and a tall-skinny QR of\n"
+    "                        the distributed factor.  Every rank gets the\n"
+    "                        full results.  Implies Traj: true; uses 'rank'\n"
+    "                        and 'HankelIter' and takes precedence over\n"
+    "                        Hankel, Jacobi and BDCSVD.\n"
     "  rank: 100             The default rank for the randomized matrix SVD.\n"
     "                        The default value will give decent accuracy with\n"
     "                        small computational overhead and will be a good\n"
     "                        choice for most applications.\n"
+    "  GPU: true             Compute the default randomized SVD on the GPU\n"
+    "                        with cuBLAS and cuSOLVER.  Falls back to the\n"
+    "                        CPU if no device is available.  Not used with\n"
+    "                        Jacobi, BDCSVD, Hankel, MPI or RedSym.\n"
     "  RedSym: true          Use the randomized symmetric eigenvalue solver\n"
     "                        RedSym rather rather than RedSVD for the co-\n"
     "                        variance matrix SVD (Traj: false). The main use\n"
@@ -105,9 +125,12 @@ void MSSAtoolkitClasses(py::module &m) {
     "  totPow: false         Detrend according to the total power in\n"
     "                        all channels\n\n"
     "The following parameters take values,\ndefaults are given in ()\n\n"
+    "  HankelIter: int(2)    Subspace iterations for 'Hankel: true' and\n"
+    "                        'MPI: true'\n"
     "  evtol: double(0.01)   Truncate by the given cumulative p-value in\n"
     "                        chatty mode\n"
-    "  output: str(exp_mssa) Prefix name for output files\n\n"
+    "  output: str(exp_mssa) Prefix name for output files\n"
+    "  cache: str            Prefix of an analysis cache; see Save/Restore\n\n"
     "The 'output' value is only used if 'writeFiles' is specified, too.\n"
     "A simple YAML configuration for expMSSA might look like this:\n"
     "---\n"
@@ -140,6 +163,11 @@ void MSSAtoolkitClasses(py::module &m) {
     "to read the MSSA analysis from the HDF5 file.  The restore step will\n"
     "check that your data has the same dimension, same parameters, and key\n"
     "list so it should be pretty hard to fool, but not impossible.\n\n"
+    "With 'cache: prefix' in the YAML parameters this is automatic: the\n"
+    "analysis is written to <prefix>_mssa.h5 when it is computed, and a\n"
+    "new instance restores it rather than recomputing when the file holds\n"
+    "a matching fingerprint of the input series, window, number of PCs\n"
+    "and decomposition parameters.  A stale cache is replaced.\n\n"
     "Computational notes\n"
     "-------------------\n"
     "Some of the linear algebra operations and the MSSA reconstruction\n"
@@ -158,7 +186,13 @@ void MSSAtoolkitClasses(py::module &m) {
 
   py::class_<MSSA::expMSSA, std::shared_ptr<MSSA::expMSSA>> f(m, "expMSSA");
 
-  f.def(py::init<const mssaConfig&, int, int, const std::string&>(),
+  f.def(py::init([](const mssaConfig& config, int window, int numpc,
+		    const std::string& flags, int threads, int device)
+  {
+    ExecScope scope(threads, device);
+    return std::make_shared<expMSSA>(config, window, numpc, flags);
+  }),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         The MSSA analysis class
 
@@ -173,6 +207,12 @@ void MSSAtoolkitClasses(py::module &m) {
              the default number of eigenvalues to compute
         flags : str, default=""
              YAML stanza of parameter values
+        threads : int, default=0
+             OpenMP threads for the analysis; 0 keeps the current
+             count.  The count may only be lowered.
+        device : int, default=-1
+             CUDA device for the decomposition with 'GPU: true' in
+             flags; -1 keeps the current device
 
         Returns
         -------
@@ -195,7 +235,54 @@ void MSSAtoolkitClasses(py::module &m) {
 	py::arg("config"),
 	py::arg("window"),
 	py::arg("numpc"),
-	py::arg("flags") = "");
+	py::arg("flags") = "",
+	py::arg("threads") = 0,
+	py::arg("device") = -1);
+
+  m.def("expMSSA_async",
+	[](const mssaConfig& config, int window, int numpc,
+	   const std::string& flags, int threads, int device)
+	{
+	  return launchAsync([config, window, numpc, flags, threads, device]()
+	  {
+	    ExecScope scope(threads, device);
+	    return std::make_shared<expMSSA>(config, window, numpc, flags);
+	  });
+	},
+	R"(
+        Construct an expMSSA analysis on a background thread
+
+        Parameters
+        ----------
+        config : mssaConfig
+             the input database of components
+        window : int
+             the length of the cross-correlation interval
+        numpc : int
+             the default number of eigenvalues to compute
+        flags : str, default=""
+             YAML stanza of parameter values
+        threads : int, default=0
+             OpenMP threads for the analysis; 0 keeps the current count
+        device : int, default=-1
+             CUDA device for 'GPU: true'; -1 keeps the current device
+
+        Returns
+        -------
+        concurrent.futures.Future
+             resolves to the expMSSA instance
+
+        Notes
+        -----
+        Do not change the input coefficients from Python until the
+        future is done.
+        )",
+	py::arg("config"),
+	py::arg("window"),
+	py::arg("numpc"),
+	py::arg("flags") = "",
+	py::arg("threads") = 0,
+	py::arg("device") = -1);
 
 
   f.def("eigenvalues", &expMSSA::eigenvalues,
@@ -289,7 +376,34 @@ void MSSAtoolkitClasses(py::module &m) {
         )");
   
 
+  f.def("update", &expMSSA::update, py::arg("config"),
+	py::call_guard<py::gil_scoped_release>(),
+	R"(
+        Extend the analysis with new coefficient snapshots
+
+        Parameters
+        ----------
+        config : mssaConfig
+            the input database used for the constructor, whose Coefs
+            now hold the original times followed by new ones (after
+            in-memory additions or rereading a file extended by
+            ExtendH5Coefs)
+
+        Returns
+        -------
+        None
+
+        Notes
+        -----
+        The new values are detrended with the original means and
+        variances.  The eigenvalues and eigenvectors are updated by a
+        rank-k SVD update with the new lagged vectors rather than
+        recomputed and the PCs are recomputed for the full series.  A
+        previous reconstruction is redone with the same group list.
+        )");
+
   f.def("reconstruct", &expMSSA::reconstruct, py::arg("evlist"),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Reconstruct the data channels with the provided group list of eigenvalue indices
 
@@ -347,6 +461,7 @@ void MSSAtoolkitClasses(py::module &m) {
 
   f.def("wCorr", &expMSSA::wCorr, py::arg("name"), py::arg("key"),
 	py::arg("nPC") = std::numeric_limits<int>::max(),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         The w-correlation matrix for the selected component and channel key
 
@@ -381,6 +496,7 @@ void MSSAtoolkitClasses(py::module &m) {
 
   f.def("wCorrKey", &expMSSA::wCorrKey, py::arg("key"),
 	py::arg("nPC") = std::numeric_limits<int>::max(),
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Get the w-correlation matrix for the selected component and channel key
 
@@ -417,6 +533,7 @@ void MSSAtoolkitClasses(py::module &m) {
   f.def("wCorrAll", &expMSSA::wCorrAll,
 	py::arg("nPC") = std::numeric_limits<int>::max(),
 
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         the w-correlation matrix for all channels in the reconstruction
 
@@ -449,6 +566,42 @@ void MSSAtoolkitClasses(py::module &m) {
         wCorrKey : return the w-correlation matrix by extended key
         )");
 
+  f.def("windowSweep", &expMSSA::windowSweep,
+	py::arg("windows"),
+	py::arg("nPC") = 10,
+	py::call_guard<py::gil_scoped_release>(),
+	R"(
+        Eigenvalue spectra and w-correlation matrices for a list of window
+        lengths in one call
+
+        Parameters
+        ----------
+        windows : list(int)
+            window lengths to analyze; lengths outside [2, numT/2] are skipped
+        nPC : int, default=10
+            number of leading components in the w-correlation matrices
+
+        Returns
+        -------
+        dict(int, tuple(numpy.ndarray, numpy.ndarray))
+            the eigenvalues and the (nPC x nPC) w-correlation matrix for all
+            channels, by window length
+
+        Notes
+        -----
+        Each window is analyzed with the implicit trajectory operator
+        used by 'Hankel: true'.  The channel data and their Fourier
+        transforms are computed once for all windows, and the randomized
+        SVD of each window starts from the singular subspace of the previous
+        one, so a sweep is much cheaper than one expMSSA instance per
+        window.  The current analysis and reconstruction are not changed.
+
+        See also
+        --------
+        wCorrAll : return the combined correlation matrix for all components and keys
+        eigenvalues : return the eigenvalues of the current analysis
+        )");
+
   f.def("wcorrPNG", &expMSSA::wcorrPNG,
 	py::arg("nPC") = std::numeric_limits<int>::max(),
 	R"(
@@ -481,6 +634,7 @@ void MSSAtoolkitClasses(py::module &m) {
   f.def("kmeans", &expMSSA::kmeans,
 	py::arg("clusters") = 4,
 	py::arg("stride") = 2,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Do a k-means analysis on the reconstructed trajectory matrices for a
         single channel (specified key value) to provide grouping insight.  A
@@ -522,6 +676,7 @@ void MSSAtoolkitClasses(py::module &m) {
 	py::arg("key"),
 	py::arg("clusters") = 4,
 	py::arg("stride") = 2,
+	py::call_guard<py::gil_scoped_release>(),
 	R"(
         Do a k-means analysis on the reconstructed trajectory matrices for a
         single channel (specified key value) to provide grouping insight.  In
@@ -1,25 +1,152 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <stdexcept>
+
 #include <ParticleReader.H>
+#include <SnapshotIndex.H>
 
 namespace py = pybind11;
 
+namespace
+{
+  //! Fields selected for the array readers
+  struct Columns
+  {
+    bool mass = false, pos = false, vel = false, indx = false;
+
+    Columns(const std::vector<std::string>& fields)
+    {
+      for (auto & f : fields) {
+	if      (f=="mass")  mass = true;
+	else if (f=="pos")   pos  = true;
+	else if (f=="vel")   vel  = true;
+	else if (f=="index") indx = true;
+	else throw std::invalid_argument
+	       ("ParticleReader: unknown field <" + f +
+		">; expected mass, pos, vel or index");
+      }
+    }
+  };
+
+  //! Hand a vector to numpy without a copy
+  template<typename T>
+  py::array_t<T> toArray(std::vector<T>&& v, size_t n, size_t cols)
+  {
+    auto *p = new std::vector<T>(std::move(v));
+    py::capsule owner(p, [](void *q) { delete static_cast<std::vector<T>*>(q); });
+    std::vector<py::ssize_t> shape {static_cast<py::ssize_t>(n)};
+    if (cols>1) shape.push_back(static_cast<py::ssize_t>(cols));
+    return py::array_t<T>(shape, p->data(), owner);
+  }
+
+  //! Contiguous column buffers filled from reader chunks
+  template<typename T>
+  struct Columnar
+  {
+    Columns sel;
+    size_t n = 0;
+    std::vector<T> mass, pos, vel;
+    std::vector<unsigned long> indx;
+
+    Columnar(const Columns& sel, size_t hint) : sel(sel)
+    {
+      if (sel.mass) mass.reserve(hint);
+      if (sel.pos)  pos .reserve(3*hint);
+      if (sel.vel)  vel .reserve(3*hint);
+      if (sel.indx) indx.reserve(hint);
+    }
+
+    void append(const PR::ParticleChunk& c)
+    {
+      if (sel.mass) mass.insert(mass.end(), c.mass, c.mass + c.size);
+      if (sel.pos)  pos .insert(pos .end(), c.pos,  c.pos  + 3*c.size);
+      if (sel.vel)  vel .insert(vel .end(), c.vel,  c.vel  + 3*c.size);
+      if (sel.indx) {
+	if (c.indx) indx.insert(indx.end(), c.indx, c.indx + c.size);
+	else        indx.resize(indx.size() + c.size, 0);
+      }
+      n += c.size;
+    }
+
+    py::dict result()
+    {
+      py::dict ret;
+      if (sel.mass) ret["mass"]  = toArray(std::move(mass), n, 1);
+      if (sel.pos)  ret["pos"]   = toArray(std::move(pos),  n, 3);
+      if (sel.vel)  ret["vel"]   = toArray(std::move(vel),  n, 3);
+      if (sel.indx) ret["index"] = toArray(std::move(indx), n, 1);
+      return ret;
+    }
+  };
+
+  //! One dictionary of arrays for a single chunk
+  py::dict chunkDict(const PR::ParticleChunk& c, const Columns& sel,
+		     bool float32)
+  {
+    if (float32) {
+      Columnar<float> buf(sel, c.size);
+      buf.append(c);
+      return buf.result();
+    }
+    Columnar<double> buf(sel, c.size);
+    buf.append(c);
+    return buf.result();
+  }
+
+  //! Python iterator over the chunks of the selected type
+  class ChunkIterator
+  {
+    PR::PRptr reader;
+    size_t size;
+    Columns sel;
+    bool float32, started = false, done = false;
+
+  public:
+
+    ChunkIterator(PR::PRptr reader, size_t size,
+		  const std::vector<std::string>& fields, bool float32) :
+      reader(reader), size(size), sel(fields), float32(float32)
+    {
+      if (size==0)
+	throw std::invalid_argument("ParticleReader.chunks: size must be positive");
+    }
+
+    py::dict next()
+    {
+      if (done) throw py::stop_iteration();
+
+      auto c = started ? reader->nextChunk(size) : reader->firstChunk(size);
+      started = true;
+
+      if (c.size==0) {
+	done = true;
+	throw py::stop_iteration();
+      }
+
+      return chunkDict(c, sel, float32);
+    }
+  };
+}
+
 void ParticleReaderClasses(py::module &m) {
 
   m.doc() = "ParticleReader class bindings\n\n"
     "This collection of classes reads and converts your phase-space\n"
     "snapshots to iterable objects for generating basis coefficients.\n"
-    "The particle fields themselves are not available in Python for\n"
-    "inspection currently.\n\n"
+    "The particle fields may be read into numpy arrays using the\n"
+    "chunks() and readAll() members.\n\n"
     "The available particle readers are:\n"
     "  1. PSPout         The monolithic EXP phase-space snapshot format\n"
     "  2. PSPspl         Like PSPout, but split into multiple file chunks\n"
-    "  3. GadgetNative   The original Gadget native format\n"
-    "  4  GadgetHDF5     The newer HDF5 Gadget format\n"
-    "  5. TipsyNative    The original Tipsy format\n"
-    "  6. TipsyXDR       The original XDR Tipsy format\n"
-    "  7. Bonsai         This is the Bonsai varient of Tipsy files\n\n"
+    "  3. PSC            Chunked, compressed EXP snapshots with an index\n"
+    "  4. PSPhdf5        EXP snapshots in a single HDF5 file\n"
+    "  5. GadgetNative   The original Gadget native format\n"
+    "  6  GadgetHDF5     The newer HDF5 Gadget format\n"
+    "  7. TipsyNative    The original Tipsy format\n"
+    "  8. TipsyXDR       The original XDR Tipsy format\n"
+    "  9. Bonsai         This is the Bonsai varient of Tipsy files\n\n"
     "We have a helper function, getReaders, to get a list to help you\n"
     "remember.  Try: pyEXP.read.ParticleReader.getReaders()\n\n"
     "Each reader can manage snapshots split into many files by parallel,\n"
@@ -216,6 +343,38 @@ void ParticleReaderClasses(py::module &m) {
     }
   };
 
+  class PyPSC : public PSC
+  {
+  public:
+
+    // Inherit the constructors
+    using PSC::PSC;
+
+    const Particle* firstParticle() override {
+      PYBIND11_OVERRIDE(const Particle*, PSC, firstParticle,);
+    }
+
+    const Particle* nextParticle() override {
+      PYBIND11_OVERRIDE(const Particle*, PSC, nextParticle,);
+    }
+  };
+
+  class PyPSPhdf5 : public PSPhdf5
+  {
+  public:
+
+    // Inherit the constructors
+    using PSPhdf5::PSPhdf5;
+
+    const Particle* firstParticle() override {
+      PYBIND11_OVERRIDE(const Particle*, PSPhdf5, firstParticle,);
+    }
+
+    const Particle* nextParticle() override {
+      PYBIND11_OVERRIDE(const Particle*, PSPhdf5, nextParticle,);
+    }
+  };
+
   class PyTipsy : public Tipsy
   {
   public:
@@ -330,6 +489,90 @@ void ParticleReaderClasses(py::module &m) {
          )",
 	 py::arg("stats")=true, py::arg("timeonly")=false);
   
+  py::class_<ChunkIterator>(m, "ParticleChunkIterator")
+    .def("__iter__", [](ChunkIterator& it) -> ChunkIterator& { return it; },
+	 py::return_value_policy::reference_internal)
+    .def("__next__", &ChunkIterator::next);
+
+  pr.def("chunks",
+	 [](std::shared_ptr<ParticleReader> A, size_t size,
+	    const std::vector<std::string>& fields, bool float32)
+	 { return ChunkIterator(A, size, fields, float32); },
+	 R"(
+         Iterate over the particles of the selected type in chunks
+
+         Each step returns a dictionary of contiguous numpy arrays
+         copied from the reader's buffers: 'mass' and 'index' have
+         shape (n,) and 'pos' and 'vel' have shape (n, 3).  Only the
+         requested fields are returned.  The last chunk may be short.
+
+         Parameters
+         ----------
+         size : int, default=16384
+             maximum number of particles in each chunk
+         fields : list(str), default=['mass', 'pos', 'vel']
+             fields to return from 'mass', 'pos', 'vel' and 'index'
+         float32 : bool, default=False
+             return single precision floating point arrays
+
+         Returns
+         -------
+         iterator(dict)
+             dictionary of numpy arrays for each chunk
+
+         See also
+         --------
+         readAll
+         )",
+	 py::arg("size")=ParticleReader::chunkSize,
+	 py::arg("fields")=std::vector<std::string>{"mass", "pos", "vel"},
+	 py::arg("float32")=false);
+
+  pr.def("readAll",
+	 [](ParticleReader& A, const std::vector<std::string>& fields,
+	    bool float32)
+	 {
+	   Columns sel(fields);
+	   auto fill = [&](auto& buf)
+	   {
+	     for (auto c=A.firstChunk(); c.size; c=A.nextChunk()) buf.append(c);
+	     return buf.result();
+	   };
+
+	   size_t hint = A.CurrentNumber();
+	   if (float32) {
+	     Columnar<float> buf(sel, hint);
+	     return fill(buf);
+	   }
+	   Columnar<double> buf(sel, hint);
+	   return fill(buf);
+	 },
+	 R"(
+         Read all particles of the selected type into numpy arrays
+
+         The arrays are filled directly from the reader's chunks in a
+         single pass and passed to numpy without a further copy.
+
+         Parameters
+         ----------
+         fields : list(str), default=['mass', 'pos', 'vel']
+             fields to return from 'mass', 'pos', 'vel' and 'index'
+         float32 : bool, default=False
+             return single precision floating point arrays
+
+         Returns
+         -------
+         dict
+             'mass' and 'index' with shape (n,) and 'pos' and 'vel'
+             with shape (n, 3) for the requested fields
+
+         See also
+         --------
+         chunks
+         )",
+	 py::arg("fields")=std::vector<std::string>{"mass", "pos", "vel"},
+	 py::arg("float32")=false);
+
   pr.def_static("parseFileList", &ParticleReader::parseFileList,
 		py::doc(R"(
                         Group files into times and segments for reader
@@ -398,11 +641,31 @@ void ParticleReaderClasses(py::module &m) {
 		py::arg("type"), py::arg("bunch"),
 		py::arg("myid")=0, py::arg("verbose")=false);
 
+  pr.def_static("setPrefetch", &ParticleReader::setPrefetch,
+		py::doc(R"(
+                        Set the number of files read ahead of use
+
+                        PSPspl and multiple-file Gadget snapshots read up to
+                        this many of the following files from background
+                        threads while the current file is processed.
+
+                        Parameters
+                        ----------
+                        depth : int
+                            number of files read ahead (0 reads each file when
+                            it is reached, default=2)
+
+                        Returns
+                        -------
+                        None
+                        )"),
+		py::arg("depth"));
+
   pr.def_static("getReaders", []()
   {
     const std::vector<std::string> formats = {
-      "PSPout", "PSPspl", "GadgetNative", "GadgetHDF5", "TipsyNative",
-      "TipsyXDR", "Bonsai"};
+      "PSPout", "PSPspl", "PSC", "PSPhdf5", "GadgetNative",
+      "GadgetHDF5", "TipsyNative", "TipsyXDR", "Bonsai"};
 
     return formats;
     },
@@ -477,6 +740,28 @@ void ParticleReaderClasses(py::module &m) {
     .def("GetTypes",        &PSPspl::GetTypes)
     .def("CurrentTime",     &PSPspl::CurrentTime);
 	 
+  py::class_<PSC, std::shared_ptr<PSC>, PyPSC, ParticleReader>(m, "PSC")
+    .def(py::init<const std::vector<std::string>&, bool>(),
+	 "Reader for chunked, compressed PSC files (master file first)")
+    .def("SelectType",      &PSC::SelectType)
+    .def("CurrentNumber",   &PSC::CurrentNumber)
+    .def("GetTypes",        &PSC::GetTypes)
+    .def("CurrentTime",     &PSC::CurrentTime)
+    .def("SetRadialRange",  &PSC::SetRadialRange,
+	 "Only read bodies with radius in [rmin, rmax).  Chunks outside "
+	 "of the range are skipped.", py::arg("rmin"), py::arg("rmax"))
+    .def("SetBox",          &PSC::SetBox,
+	 "Only read bodies in the box [lo, hi).  Chunks outside of the "
+	 "box are skipped.", py::arg("lo"), py::arg("hi"));
+	 
+  py::class_<PSPhdf5, std::shared_ptr<PSPhdf5>, PyPSPhdf5, ParticleReader>(m, "PSPhdf5")
+    .def(py::init<const std::vector<std::string>&, bool>(),
+	 "Reader for HDF5 phase-space files written by OutHDF5")
+    .def("SelectType",      &PSPhdf5::SelectType)
+    .def("CurrentNumber",   &PSPhdf5::CurrentNumber)
+    .def("GetTypes",        &PSPhdf5::GetTypes)
+    .def("CurrentTime",     &PSPhdf5::CurrentTime);
+	 
   py::class_<Tipsy, std::shared_ptr<Tipsy>, PyTipsy, ParticleReader> tipsy(m, "Tipsy");
   
   py::enum_<Tipsy::TipsyType>(tipsy, "TipsyType")
@@ -492,5 +777,76 @@ void ParticleReaderClasses(py::module &m) {
     .def("GetTypes",        &Tipsy::GetTypes)
     .def("CurrentTime",     &Tipsy::CurrentTime);
 
+  py::class_<PR::SnapshotIndex, std::shared_ptr<PR::SnapshotIndex>>(m, "SnapshotIndex")
+    .def(py::init<const std::string&,
+	 const std::vector<std::vector<std::string>>&,
+	 const std::string&, bool>(),
+	 R"(
+         Index of snapshot times and counts kept in a sidecar file
+
+         The time and the number of bodies of each type are recorded
+         for every snapshot in a YAML file, by default
+         .snapindex.<type>.yaml in the directory of the first
+         snapshot.  Only new or changed snapshots are opened, so
+         later scans of the same directory do not touch the files.
+
+         Parameters
+         ----------
+         type : str
+             the reader type, as for createReader
+         bunches : list(list(str))
+             the snapshots, as returned by parseFileList or
+             parseStringList
+         indexfile : str, default=""
+             the sidecar file; empty for the default location
+         verbose : bool, default=False
+             report on the scan
+
+         Returns
+         -------
+         SnapshotIndex
+         )",
+	 py::arg("type"), py::arg("bunches"), py::arg("indexfile")="",
+	 py::arg("verbose")=false)
+    .def("__len__", &PR::SnapshotIndex::size)
+    .def("times", &PR::SnapshotIndex::times,
+	 "The snapshot times in increasing order")
+    .def("select", &PR::SnapshotIndex::select,
+	 R"(
+         The positions of the snapshots with tmin <= time <= tmax
+
+         Parameters
+         ----------
+         tmin : float
+         tmax : float
+
+         Returns
+         -------
+         list(int)
+         )", py::arg("tmin"), py::arg("tmax"))
+    .def("nearest", &PR::SnapshotIndex::nearest,
+	 "The position of the snapshot closest in time to t",
+	 py::arg("t"))
+    .def("files",
+	 [](const PR::SnapshotIndex& A, size_t i) { return A[i].files; },
+	 "The files of snapshot i", py::arg("i"))
+    .def("counts",
+	 [](const PR::SnapshotIndex& A, size_t i) { return A[i].counts; },
+	 "The number of bodies of each type in snapshot i", py::arg("i"))
+    .def("createReader", &PR::SnapshotIndex::createReader,
+	 R"(
+         Open snapshot i
+
+         Parameters
+         ----------
+         i : int
+             position of the snapshot in time order
+
+         Returns
+         -------
+         ParticleReader
+         )", py::arg("i"))
+    .def("getIndexFile", &PR::SnapshotIndex::getIndexFile,
+	 "The path of the sidecar file");
 }
 
@@ -8,6 +8,8 @@ namespace py = pybind11;
 #include <Centering.H>
 #include <ParticleIterator.H>
 
+#include "ExecControl.H"
+
 void UtilityClasses(py::module &m) {
 
   m.doc() = "Utility class bindings\n\n"
@@ -52,7 +54,12 @@ void UtilityClasses(py::module &m) {
     "     #\n"
     "     for i in range(3): centerOfMass[i] /= totalMass\n"
     "     #\n"
-    "     #---------------------------------------------------------------\n\n";
+    "     #---------------------------------------------------------------\n\n"
+    "  5. Set the number of worker threads for the *_async calls.  These\n"
+    "     return a concurrent.futures.Future and run in the background\n"
+    "     while the interpreter continues.  Together with the 'threads'\n"
+    "     argument of the heavy calls, this avoids oversubscription when\n"
+    "     pyEXP runs inside Dask or multiprocessing workers.\n\n";
 
   using namespace Utility;
 
@@ -85,6 +92,36 @@ void UtilityClasses(py::module &m) {
 	py::arg("reader"), py::arg("stride")=1,
 	py::arg("Nsort")=0, py::arg("Ndens")=32);
 
+  m.def("getDensityCenterShrink", &getDensityCenterShrink,
+	R"(
+        Compute the center of the particle component using a shrinking
+        sphere followed by a local density estimate
+
+        A random subsample locates the center approximately by
+        shrinking a sphere until it holds Ncore subsample particles.
+        Only the particles inside that sphere are gathered for the
+        KD N-nearest neighbor density weighting, so this is much
+        cheaper than getDensityCenter for large snapshots.
+
+        Parameters
+        ----------
+        reader : ParticleReader
+            the particle-reader class instance
+        Nsub : int, default=100000
+             total size of the random subsample
+        Ncore : int, default=1000
+             number of subsample particles left in the final sphere
+        Ndens : int, default=32
+             number of particles per sample ball
+
+        Returns
+        -------
+        list(float)
+            Computed center
+        )",
+	py::arg("reader"), py::arg("Nsub")=100000,
+	py::arg("Ncore")=1000, py::arg("Ndens")=32);
+
   m.def("getCenterOfMass", &getCenterOfMass,
 	R"(
         Compute the center of mass for the particle component
@@ -127,6 +164,47 @@ void UtilityClasses(py::module &m) {
         )",
 	py::arg("reader"), py::arg("functor"));
 
+  m.def("setAsyncWorkers",
+	[](unsigned n) { AsyncPool::instance().setWorkers(n); },
+	R"(
+        Set the number of worker threads for the *_async calls
+
+        Parameters
+        ----------
+        n : int
+            number of workers (default: 1).  Workers that have already
+            started are kept, so call this before the first *_async
+            call.
+
+        Returns
+        -------
+        None
+
+        Notes
+        -----
+        Each task still uses OpenMP threads as set by its 'threads'
+        argument.  With several workers, choose 'threads' so that the
+        product does not exceed the available cores.
+        )", py::arg("n"));
+
+  m.def("getAsyncWorkers", []() { return AsyncPool::instance().getWorkers(); },
+	R"(
+        Number of worker threads for the *_async calls
+
+        Returns
+        -------
+        int
+        )");
+
+  // Finish the queued tasks before the interpreter exits
+  //
+  py::module_::import("atexit").attr("register")
+    (py::cpp_function([]()
+		      {
+			py::gil_scoped_release release;
+			AsyncPool::instance().shutdown();
+		      }));
+
   m.def("getVersionInfo",
 	[]() {
 	  const int W = 80;		// Full linewidth
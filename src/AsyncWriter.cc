@@ -0,0 +1,121 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "expand.H"
+#include <global.H>
+
+#include <AsyncWriter.H>
+
+AsyncWriter::AsyncWriter(double mbytes) : used(0)
+{
+  budget = static_cast<size_t>(mbytes*1024.0*1024.0);
+}
+
+void AsyncWriter::wait()
+{
+  if (not worker.joinable()) return;
+
+  worker.join();
+
+  if (error.size()) {
+    std::cerr << "AsyncWriter [" << myid << "]: " << error << std::endl;
+    error.clear();
+  }
+
+  // Release the staging memory between dumps
+  //
+  std::vector<char>().swap(stage);
+  segs.clear();
+  used = 0;
+
+  memtrack.set("output", "staging", 0);
+}
+
+bool AsyncWriter::reserve(size_t bytes)
+{
+  wait();
+
+  int fits = bytes <= budget, all;
+  MPI_Allreduce(&fits, &all, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+  if (all) {
+    stage.resize(bytes);
+    memtrack.set("output", "staging", bytes);
+  }
+
+  return all;
+}
+
+char* AsyncWriter::append(size_t offset, size_t len)
+{
+  if (used + len > stage.size())
+    throw std::runtime_error("AsyncWriter::append: staging buffer overflow");
+
+  segs.push_back({offset, used, len});
+  char *p = &stage[used];
+  used += len;
+
+  return p;
+}
+
+void AsyncWriter::start(const std::string& name)
+{
+  // The file name is taken from the root process
+  //
+  int len = name.size();
+  MPI_Bcast(&len, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  std::vector<char> buf(len+1, 0);
+  if (myid==0) name.copy(buf.data(), len);
+  MPI_Bcast(buf.data(), len, MPI_CHAR, 0, MPI_COMM_WORLD);
+  file = buf.data();
+
+  // Create or truncate the file before any process writes to it
+  //
+  if (myid==0) {
+    int fd = open(file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd<0)
+      std::cerr << "AsyncWriter: can't create <" << file << ">: "
+		<< strerror(errno) << std::endl;
+    else
+      close(fd);
+  }
+
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  worker = std::thread(&AsyncWriter::write, this);
+}
+
+void AsyncWriter::write()
+{
+  int fd = open(file.c_str(), O_WRONLY);
+
+  if (fd<0) {
+    error = "can't open <" + file + ">: " + strerror(errno);
+    return;
+  }
+
+  for (auto & s : segs) {
+    size_t done = 0;
+    while (done < s.len) {
+      ssize_t ret = pwrite(fd, &stage[s.pos+done], s.len-done, s.offset+done);
+      if (ret<0) {
+	if (errno==EINTR) continue;
+	error = "error writing <" + file + ">: " + strerror(errno);
+	close(fd);
+	return;
+      }
+      done += ret;
+    }
+  }
+
+  if (fsync(fd))
+    error = "error syncing <" + file + ">: " + strerror(errno);
+
+  close(fd);
+}
@@ -1271,6 +1271,47 @@ void AxisymmetricBasis::parallel_gather_coef2(void)
   
 }
 
+void AxisymmetricBasis::write_state(std::ostream& out)
+{
+  // Coefficients are not computed from the particles on playback
+  //
+  char ok = not (play_back and not play_cnew);
+  out.write(&ok, 1);
+  if (not ok) return;
+
+  int dims[3] = {multistep, static_cast<int>(expcoefN[0].size()), nmax};
+  out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+
+  for (int M=0; M<=multistep; M++) {
+    for (auto & v : expcoefL[M])
+      out.write(reinterpret_cast<const char*>(v->data()), nmax*sizeof(double));
+    for (auto & v : expcoefN[M])
+      out.write(reinterpret_cast<const char*>(v->data()), nmax*sizeof(double));
+  }
+}
+
+bool AxisymmetricBasis::read_state(std::istream& in)
+{
+  char ok = 0;
+  in.read(&ok, 1);
+  if (not in or not ok) return false;
+
+  int dims[3];
+  in.read(reinterpret_cast<char*>(dims), sizeof(dims));
+  if (not in or dims[0] != multistep or
+      dims[1] != static_cast<int>(expcoefN[0].size()) or dims[2] != nmax)
+    return false;
+
+  for (int M=0; M<=multistep; M++) {
+    for (auto & v : expcoefL[M])
+      in.read(reinterpret_cast<char*>(v->data()), nmax*sizeof(double));
+    for (auto & v : expcoefN[M])
+      in.read(reinterpret_cast<char*>(v->data()), nmax*sizeof(double));
+  }
+
+  return bool(in);
+}
+
 AxisymmetricBasis::TKType AxisymmetricBasis::setTK(const std::string& tk)
 {
   TKType ret = None;
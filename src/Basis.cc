@@ -11,8 +11,41 @@ Basis::Basis(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   use_external = false;
 }
 
+bool Basis::evaluate_fields(FieldCoord ctype, const Eigen::MatrixXd& pts,
+			    Eigen::MatrixXd& fields)
+{
+  const int n = pts.rows();
+  fields.resize(n, 7);
+
+#pragma omp parallel for schedule(static) num_threads(nthrds) if(fields_thread_safe())
+  for (int i=0; i<n; i++) {
+    double f[7];
+    switch (ctype) {
+    case FieldCoord::cartesian:
+      determine_fields_at_point(pts(i, 0), pts(i, 1), pts(i, 2),
+				&f[0], &f[1], &f[2], &f[3], &f[4], &f[5], &f[6]);
+      break;
+    case FieldCoord::spherical:
+      determine_fields_at_point_sph(pts(i, 0), pts(i, 1), pts(i, 2),
+				    &f[0], &f[1], &f[2], &f[3],
+				    &f[4], &f[5], &f[6]);
+      break;
+    case FieldCoord::cylindrical:
+      determine_fields_at_point_cyl(pts(i, 0), pts(i, 1), pts(i, 2),
+				    &f[0], &f[1], &f[2], &f[3],
+				    &f[4], &f[5], &f[6]);
+      break;
+    }
+    for (int k=0; k<7; k++) fields(i, k) = f[k];
+  }
+
+  return true;
+}
+
 void Basis::legendre_R(int lmax, double x, Eigen::MatrixXd& p)
 {
+  if (legtable and legtable->Lmax()==lmax) return legtable->eval(x, p);
+
   double fact, somx2, pll, pl1, pl2;
 
   p(0, 0) = pll = 1.0;
@@ -54,6 +87,8 @@ void Basis::legendre_R(int lmax, double x, Eigen::MatrixXd& p)
 void Basis::dlegendre_R(int lmax, double x,
 			Eigen::MatrixXd &p, Eigen::MatrixXd &dp)
 {
+  if (legtable and legtable->Lmax()==lmax) return legtable->eval(x, p, dp);
+
   double fact, somx2, pll, pl1, pl2;
   int m, l;
 
@@ -112,3 +147,135 @@ void Basis::sinecosine_R(int mmax, double phi,
 }
 
 
+
+void Basis::legendre_R(int lmax, int nb, const double* x, Eigen::MatrixXd& p)
+{
+  if (legtable and legtable->Lmax()==lmax) return legtable->eval(nb, x, p);
+
+  const int L = lmax + 1;
+
+  p.resize(nb, L*L);
+
+  // Column index for (l, m)
+  //
+  auto col = [&](int l, int m) { return &p(0, l*L + m); };
+
+  {
+    double* p00 = col(0, 0);
+#pragma omp simd
+    for (int b=0; b<nb; b++) p00[b] = 1.0;
+  }
+
+  if (lmax > 0) {
+    double fact = 1.0;
+    for (int m=1; m<=lmax; m++) {
+      double* pmm = col(m, m);
+      double* pm1 = col(m-1, m-1);
+#pragma omp simd
+      for (int b=0; b<nb; b++)
+	pmm[b] = -fact*sqrt( (1.0 - x[b])*(1.0 + x[b]) )*pm1[b];
+      fact += 2.0;
+    }
+  }
+
+  for (int m=0; m<lmax; m++) {
+    double* pl2 = col(m, m);
+    double* pl1 = col(m+1, m);
+#pragma omp simd
+    for (int b=0; b<nb; b++) pl1[b] = x[b]*(2*m+1)*pl2[b];
+
+    for (int l=m+2; l<=lmax; l++) {
+      double* pll = col(l, m);
+#pragma omp simd
+      for (int b=0; b<nb; b++)
+	pll[b] = (x[b]*(2*l-1)*pl1[b] - (l+m-1)*pl2[b])/(l-m);
+      pl2 = pl1;
+      pl1 = pll;
+    }
+  }
+}
+
+void Basis::dlegendre_R(int lmax, int nb, const double* x,
+			Eigen::MatrixXd &p, Eigen::MatrixXd &dp)
+{
+  if (legtable and legtable->Lmax()==lmax)
+    return legtable->eval(nb, x, p, dp);
+
+  const int L = lmax + 1;
+
+  legendre_R(lmax, nb, x, p);
+
+  dp.resize(nb, L*L);
+
+  // Clamp the argument away from the poles for the derivative
+  //
+  thread_local std::vector<double> xc, somx2;
+  xc   .resize(nb);
+  somx2.resize(nb);
+  for (int b=0; b<nb; b++) {
+    double xx = x[b];
+    if (1.0-fabs(xx) < MINEPS) {
+      if (xx>0) xx =   1.0 - MINEPS;
+      else      xx = -(1.0 - MINEPS);
+    }
+    xc[b]    = xx;
+    somx2[b] = 1.0/(xx*xx - 1.0);
+  }
+
+  const double* xx = xc.data();
+  const double* s  = somx2.data();
+  {
+    double* d00 = &dp(0, 0);
+#pragma omp simd
+    for (int b=0; b<nb; b++) d00[b] = 0.0;
+  }
+
+  for (int l=1; l<=lmax; l++) {
+    for (int m=0; m<=l; m++) {
+      double* d  = &dp(0, l*L + m);
+      double* p0 = &p (0, l*L + m);
+      if (m<l) {
+	double* p1 = &p(0, (l-1)*L + m);
+#pragma omp simd
+	for (int b=0; b<nb; b++)
+	  d[b] = s[b]*(xx[b]*l*p0[b] - (l+m)*p1[b]);
+      } else {
+#pragma omp simd
+	for (int b=0; b<nb; b++)
+	  d[b] = s[b]*xx[b]*l*p0[b];
+      }
+    }
+  }
+}
+
+void Basis::sinecosine_R(int mmax, int nb, const double* phi,
+			 Eigen::MatrixXd& c, Eigen::MatrixXd& s)
+{
+  c.resize(nb, mmax+1);
+  s.resize(nb, mmax+1);
+
+  for (int b=0; b<nb; b++) {
+    c(b, 0) = 1.0;
+    s(b, 0) = 0.0;
+  }
+
+  if (mmax>0) {
+    for (int b=0; b<nb; b++) {
+      c(b, 1) = cos(phi[b]);
+      s(b, 1) = sin(phi[b]);
+    }
+
+    const double* c1 = &c(0, 1);
+    for (int m=2; m<=mmax; m++) {
+      double* cm = &c(0, m);
+      double* sm = &s(0, m);
+      const double* cm1 = &c(0, m-1), *cm2 = &c(0, m-2);
+      const double* sm1 = &s(0, m-1), *sm2 = &s(0, m-2);
+#pragma omp simd
+      for (int b=0; b<nb; b++) {
+	cm[b] = 2.0*c1[b]*cm1[b] - cm2[b];
+	sm[b] = 2.0*c1[b]*sm1[b] - sm2[b];
+      }
+    }
+  }
+}
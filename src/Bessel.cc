@@ -8,7 +8,8 @@
 
 const std::set<std::string>
 Bessel::valid_keys = {
-  "rnum"
+  "rnum",
+  "cachename"
 };
 
 void Bessel::initialize()
@@ -22,6 +23,10 @@ void Bessel::initialize()
   try {
     if (conf["rnum"])      RNUM       = conf["rnum"].as<int>();
     else                   RNUM       = 1000;
+
+    // Optional persistent cache for the Bessel function zeros
+    if (conf["cachename"])
+      SphBessRoots::cache(outdir + conf["cachename"].as<std::string>());
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in Sphere: "
@@ -177,6 +182,8 @@ void Bessel::make_grid(double rmin, double rmax, int lmax, int nmax)
   double r = 0.0;
   for (int ir=0; ir<RNUM; ir++, r+=r_grid_del) r_grid[ir] = r;
 
+  std::vector<double> xb(RNUM), jb(RNUM);
+
   for (int l=0; l<=lmax; l++) {
     potl_grid[l].rw .resize(nmax, RNUM);
     potl_grid[l].rw2.resize(nmax, RNUM);
@@ -186,10 +193,19 @@ void Bessel::make_grid(double rmin, double rmax, int lmax, int nmax)
     p = std::make_shared<Roots>(l, nmax);
 
     for (int n=0; n<nmax; n++) {
-      r = 0.0;
-      for (int ir=0; ir<RNUM; ir++, r+=r_grid_del) {
-	potl_grid[l].rw(n, ir) = potl(r, n);
-	dens_grid[l].rw(n, ir) = dens(r, n);
+      // The potential and density differ only by their normalization,
+      // so evaluate j_l over the whole radial grid once
+      double alpha = p->a[n];
+      double pnorm = M_SQRT2/fabs(alpha*EXPmath::sph_bessel(l+1, alpha)) *
+	pow(rmax, -0.5);
+      double dnorm = pnorm*alpha*alpha/(rmax*rmax);
+
+      for (int ir=0; ir<RNUM; ir++) xb[ir] = alpha*r_grid[ir]/rmax;
+      SphBessRoots::eval(l, xb.data(), jb.data(), RNUM);
+
+      for (int ir=0; ir<RNUM; ir++) {
+	potl_grid[l].rw(n, ir) = pnorm*jb[ir];
+	dens_grid[l].rw(n, ir) = dnorm*jb[ir];
       }
       
       {
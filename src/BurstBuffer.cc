@@ -0,0 +1,185 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "expand.H"
+#include <global.H>
+
+#include <BurstBuffer.H>
+
+double BurstBuffer::timeout = 3600.0;
+
+BurstBuffer::BurstBuffer(const std::string& dir) : local(dir)
+{
+  if (local.size() and local.back() != '/') local += '/';
+
+  std::error_code ec;
+  std::filesystem::create_directories(local, ec);
+  if (ec) {
+    std::ostringstream sout;
+    sout << "BurstBuffer: could not create <" << local << ">: "
+	 << ec.message();
+    throw std::runtime_error(sout.str());
+  }
+}
+
+void BurstBuffer::wait()
+{
+  if (not worker.joinable()) return;
+
+  worker.join();
+
+  if (error.size()) {
+    std::cerr << "BurstBuffer [" << myid << "]: " << error << std::endl;
+    error.clear();
+  }
+}
+
+void BurstBuffer::copy(const std::string& from, const std::string& to)
+{
+  std::string part = to + ".part";
+
+  int in = open(from.c_str(), O_RDONLY);
+  if (in < 0)
+    throw std::runtime_error("could not open <" + from + ">: " +
+			     strerror(errno));
+
+  int out = open(part.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (out < 0) {
+    close(in);
+    throw std::runtime_error("could not open <" + part + ">: " +
+			     strerror(errno));
+  }
+
+  // Large sequential writes
+  //
+  std::vector<char> buf(1<<22);
+  std::string fail;
+
+  while (fail.empty()) {
+    ssize_t n = read(in, buf.data(), buf.size());
+    if (n == 0) break;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      fail = "error reading <" + from + ">: " + strerror(errno);
+      break;
+    }
+    for (ssize_t w=0; w<n; ) {
+      ssize_t m = write(out, buf.data() + w, n - w);
+      if (m < 0) {
+	if (errno == EINTR) continue;
+	fail = "error writing <" + part + ">: " + strerror(errno);
+	break;
+      }
+      w += m;
+    }
+  }
+
+  if (fail.empty() and fsync(out))
+    fail = "error syncing <" + part + ">: " + strerror(errno);
+
+  close(in);
+  close(out);
+
+  if (fail.empty() and rename(part.c_str(), to.c_str()))
+    fail = "error renaming <" + part + ">: " + strerror(errno);
+
+  if (fail.size()) {
+    unlink(part.c_str());
+    throw std::runtime_error(fail);
+  }
+}
+
+void BurstBuffer::drain(std::vector<std::string> files,
+			std::vector<std::string> others, std::string master)
+{
+  try {
+    for (auto & f : files) copy(local + f, outdir + f);
+
+    if (master.empty()) return;
+
+    // The master goes last, once the other processes have drained
+    // their pieces
+    //
+    auto beg = std::chrono::steady_clock::now();
+    std::chrono::milliseconds delay(100);
+
+    for (auto & f : others) {
+      while (not std::filesystem::exists(outdir + f)) {
+	std::chrono::duration<double> waited =
+	  std::chrono::steady_clock::now() - beg;
+	if (waited.count() > timeout)
+	  throw std::runtime_error("timed out waiting for <" + outdir + f +
+				   ">, master <" + master + "> not drained");
+	std::this_thread::sleep_for(delay);
+	delay = std::min(2*delay, std::chrono::milliseconds(2000));
+      }
+    }
+
+    copy(local + master, outdir + master);
+  }
+  catch (std::exception& e) {
+    error = e.what();
+  }
+}
+
+void BurstBuffer::start(const std::vector<std::string>& files,
+			const std::vector<std::string>& others,
+			const std::string& master)
+{
+  wait();
+
+  worker = std::thread(&BurstBuffer::drain, this, files, others, master);
+}
+
+void BurstBuffer::recover(const std::string& dir, const std::string& name)
+{
+  std::string local(dir);
+  if (local.size() and local.back() != '/') local += '/';
+
+  namespace fs = std::filesystem;
+
+  // A master in outdir is a complete global copy
+  //
+  int use = 0;
+  if (myid==0) {
+    use = not fs::exists(outdir + name) and fs::exists(local + name);
+    if (use)
+      std::cout << "BurstBuffer: restoring <" << name << "> from <"
+		<< local << ">" << std::endl;
+  }
+
+  MPI_Bcast(&use, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (not use) return;
+
+  // Each process restores the pieces that it wrote
+  //
+  int bad = 0;
+  try {
+    for (int c=0; ; c++) {
+      std::string f = name + "_" + std::to_string(c) + "-" + std::to_string(myid);
+      if (not fs::exists(local + f)) break;
+      copy(local + f, outdir + f);
+    }
+  }
+  catch (std::exception& e) {
+    std::cerr << "BurstBuffer [" << myid << "]: " << e.what() << std::endl;
+    bad = 1;
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &bad, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if (bad)
+    throw std::runtime_error("BurstBuffer::recover: could not restore <" +
+			     name + ">");
+
+  if (myid==0) copy(local + name, outdir + name);
+
+  MPI_Barrier(MPI_COMM_WORLD);
+}
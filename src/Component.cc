@@ -3,6 +3,7 @@
 #include <iomanip>
 #include <sstream>
 #include <vector>
+#include <limits>
 #include <string>
 #include <memory>
 #include <map>
@@ -18,9 +19,11 @@
 #include <SlabSL.H>
 #include <Direct.H>
 #include <Shells.H>
+#include <TreeCode.H>
 #include <NoForce.H>
 #include <Orient.H>
 #include <YamlCheck.H>
+#include <ThreadPool.H>
 
 #include "expand.H"
 
@@ -48,6 +51,7 @@ const std::set<std::string> Component::valid_keys_parm =
     "nEJkeep",
     "nEJwant",
     "nEJaccel",
+    "nEJsample",
     "EJkinE",
     "EJext",
     "EJdiag",
@@ -86,7 +90,16 @@ const std::set<std::string> Component::valid_keys_parm =
     "ctr_name",
     "noswitch",
     "freezeL",
-    "dtreset"
+    "dtreset",
+    "soa",
+    "soafloat",
+    "sfcorder",
+    "sfckey",
+    "balance",
+    "arena",
+    "bulkferry",
+    "mpiread",
+    "nranks"
   };
 
 const std::set<std::string> Component::valid_keys_force =
@@ -186,6 +199,7 @@ Component::Component(YAML::Node& CONF)
   nEJkeep     = 100;
   nEJwant     = 500;
   nEJaccel    = 0;
+  nEJsample   = 0;
   EJkinE      = true;
   EJext       = false;
   EJdiag      = false;
@@ -250,6 +264,17 @@ Component::Component(YAML::Node& CONF)
   noswitch    = false;		// Allow multistep switching at master step only
   dtreset     = true;		// Select time step from criteria over last step
   freezeLev   = false;		// Only compute new levels on first step
+  use_soa     = false;		// Use the PartMap directly
+  soa_float   = false;		// Double-precision SoA forces
+  sfcorder    = 0;		// Keep the level lists in map order
+  sfckey      = "morton";	// Ordering key for sfcorder
+  balance     = "rates";	// Balance by measured process rates
+  use_arena   = false;		// Use the global allocator for particles
+  bulkferry   = false;		// Ship particles pairwise by stanza
+  mpiread     = false;		// Read restarts on the root process
+  nranks      = 0;		// Particles on all processes
+  comm        = MPI_COMM_NULL;
+  soa_active  = false;
 
   set_default_values();
 
@@ -323,6 +348,7 @@ void Component::set_default_values()
   if (!cconf["nEJkeep"])         cconf["nEJkeep"]     = nEJkeep;
   if (!cconf["nEJwant"])         cconf["nEJwant"]     = nEJwant;
   if (!cconf["nEJaccel"])        cconf["nEJaccel"]    = nEJaccel;
+  if (!cconf["nEJsample"])       cconf["nEJsample"]   = nEJsample;
   if (!cconf["EJkinE"])          cconf["EJkinE"]      = EJkinE;
   if (!cconf["EJext"])           cconf["EJext"]       = EJext;
   if (!cconf["EJdiag"])          cconf["EJdiag"]      = EJdiag;
@@ -362,6 +388,15 @@ void Component::set_default_values()
   if (!cconf["noswitch"])        cconf["noswitch"]    = noswitch;
   if (!cconf["freezeL"])         cconf["freezeL"]     = freezeLev;
   if (!cconf["dtreset"])         cconf["dtreset"]     = dtreset;
+  if (!cconf["soa"])             cconf["soa"]         = use_soa;
+  if (!cconf["soafloat"])        cconf["soafloat"]    = soa_float;
+  if (!cconf["sfcorder"])        cconf["sfcorder"]    = sfcorder;
+  if (!cconf["sfckey"])          cconf["sfckey"]      = sfckey;
+  if (!cconf["balance"])         cconf["balance"]     = balance;
+  if (!cconf["arena"])           cconf["arena"]       = use_arena;
+  if (!cconf["bulkferry"])       cconf["bulkferry"]   = bulkferry;
+  if (!cconf["mpiread"])         cconf["mpiread"]     = mpiread;
+  if (!cconf["nranks"])          cconf["nranks"]      = nranks;
 }
 
 
@@ -473,14 +508,20 @@ void Component::reset_level_lists()
   }
 				// Particle list per level.
 				// Begin with empty lists . . .
-  levlist = std::vector< std::vector<int> > (multistep+1);
+  std::vector< std::vector<int> > newlist(multistep+1);
   for (int i=0; i<nthrds; i++) {
     for (unsigned n=0; n<=multistep; n++) {
-      levlist[n].insert(levlist[n].end(),
+      newlist[n].insert(newlist[n].end(),
 			td[i].newlist[n].begin(), 
 			td[i].newlist[n].end());
     }
   }
+				// . . . and pack them into the
+				// contiguous store
+  levlist.assign(newlist);
+
+  levchange.resize(nthrds);
+  for (auto & v : levchange) v.clear();
   
   if (VERBOSE>10 and particles.size()) {
 				// Level creation check
@@ -528,6 +569,124 @@ void Component::reset_level_lists()
 
 }
 
+void Component::update_level_lists()
+{
+  size_t nchange = 0;
+  for (auto & v : levchange) nchange += v.size();
+
+  // A rebuild is cheaper when a large fraction of the bodies change
+  // level, e.g. on the first level assignment
+  //
+  if (nchange > particles.size()/4) {
+    reset_level_lists();
+    return;
+  }
+
+  for (auto & v : levchange) {
+    for (auto indx : v) {
+      auto it = particles.find(indx);
+      if (it != particles.end()) levlist.move(indx, it->second->level);
+    }
+    v.clear();
+  }
+}
+
+//! Spread the low 21 bits of v to every third bit
+static uint64_t morton_spread3(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v <<  8) & 0x100f00f00f00f00fULL;
+  v = (v | v <<  4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v <<  2) & 0x1249249249249249ULL;
+  return v;
+}
+
+//! Spread the low 32 bits of v to every second bit
+static uint64_t morton_spread2(uint64_t v)
+{
+  v &= 0xffffffff;
+  v = (v | v << 16) & 0x0000ffff0000ffffULL;
+  v = (v | v <<  8) & 0x00ff00ff00ff00ffULL;
+  v = (v | v <<  4) & 0x0f0f0f0f0f0f0f0fULL;
+  v = (v | v <<  2) & 0x3333333333333333ULL;
+  v = (v | v <<  1) & 0x5555555555555555ULL;
+  return v;
+}
+
+void Component::sfc_reorder()
+{
+  if (particles.size()==0) return;
+
+  // Coordinates to be interleaved: Cartesian, (R, z) or r
+  //
+  int ndim = 3;
+  if (sfckey == "cylinder") ndim = 2;
+  if (sfckey == "radius"  ) ndim = 1;
+
+  auto coords = [&](const Particle* p, double* u)
+  {
+    double x[3] = {p->pos[0], p->pos[1], p->pos[2]};
+    ConvertPos(x);
+
+    if (ndim==3) {
+      for (int k=0; k<3; k++) u[k] = x[k];
+    } else if (ndim==2) {
+      u[0] = sqrt(x[0]*x[0] + x[1]*x[1]);
+      u[1] = x[2];
+    } else {
+      u[0] = sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]);
+    }
+  };
+
+  // Bounding box of the local particles
+  //
+  double lo[3], hi[3], u[3];
+  for (int k=0; k<ndim; k++) {
+    lo[k] =  std::numeric_limits<double>::max();
+    hi[k] = -std::numeric_limits<double>::max();
+  }
+
+  for (auto & v : particles) {
+    coords(v.second.get(), u);
+    for (int k=0; k<ndim; k++) {
+      lo[k] = std::min<double>(lo[k], u[k]);
+      hi[k] = std::max<double>(hi[k], u[k]);
+    }
+  }
+
+  // Quantize to 21 bits per Cartesian dimension, 32 bits per
+  // cylindrical dimension and the full radius
+  //
+  const int bits = ndim==3 ? 21 : 32;
+  const double cells = static_cast<double>((1ULL << bits) - 1);
+
+  double scale[3];
+  for (int k=0; k<ndim; k++)
+    scale[k] = hi[k]>lo[k] ? cells/(hi[k] - lo[k]) : 0.0;
+
+  auto key = [&](int indx) -> uint64_t
+  {
+    auto it = particles.find(indx);
+    if (it == particles.end()) return 0;
+
+    coords(it->second.get(), u);
+
+    uint64_t q[3];
+    for (int k=0; k<ndim; k++) q[k] = (u[k] - lo[k])*scale[k];
+
+    if (ndim==3)
+      return morton_spread3(q[0]) | morton_spread3(q[1]) << 1 |
+	morton_spread3(q[2]) << 2;
+    if (ndim==2)
+      return morton_spread2(q[0]) | morton_spread2(q[1]) << 1;
+    return q[0];
+  };
+
+  levlist.sort(key);
+}
+
 void Component::print_level_lists(double T)
 {
 				// Print out level info
@@ -687,6 +846,7 @@ Component::Component(YAML::Node& CONF, istream *in, bool SPL) : conf(CONF)
   nEJkeep     = 100;
   nEJwant     = 500;
   nEJaccel    = 0;
+  nEJsample   = 0;
   EJkinE      = true;
   EJext       = false;
   EJdiag      = false;
@@ -752,6 +912,17 @@ Component::Component(YAML::Node& CONF, istream *in, bool SPL) : conf(CONF)
   noswitch    = false;		// Allow multistep switching at master step only
   dtreset     = true;		// Select level from criteria over last step
   freezeLev   = false;		// Only compute new levels on first step
+  use_soa     = false;		// Use the PartMap directly
+  soa_float   = false;		// Double-precision SoA forces
+  sfcorder    = 0;		// Keep the level lists in map order
+  sfckey      = "morton";	// Ordering key for sfcorder
+  balance     = "rates";	// Balance by measured process rates
+  use_arena   = false;		// Use the global allocator for particles
+  bulkferry   = false;		// Ship particles pairwise by stanza
+  mpiread     = false;		// Read restarts on the root process
+  nranks      = 0;		// Particles on all processes
+  comm        = MPI_COMM_NULL;
+  soa_active  = false;
 
   configure();
 
@@ -800,6 +971,7 @@ void Component::configure(void)
     if (cconf["nEJkeep" ])    nEJkeep  = cconf["nEJkeep" ].as<int>();
     if (cconf["nEJwant" ])    nEJwant  = cconf["nEJwant" ].as<int>();
     if (cconf["nEJaccel"])   nEJaccel  = cconf["nEJaccel"].as<int>();
+    if (cconf["nEJsample"]) nEJsample  = cconf["nEJsample"].as<int>();
     if (cconf["EJx0"    ])       EJx0  = cconf["EJx0"    ].as<double>();
     if (cconf["EJy0"    ])       EJy0  = cconf["EJy0"    ].as<double>();
     if (cconf["EJz0"    ])       EJz0  = cconf["EJz0"    ].as<double>();
@@ -830,6 +1002,15 @@ void Component::configure(void)
     if (cconf["noswitch"])   noswitch  = cconf["noswitch"].as<bool>();
     if (cconf["freezeL"])   freezeLev  = cconf["freezeL" ].as<bool>();
     if (cconf["dtreset"])     dtreset  = cconf["dtreset" ].as<bool>();
+    if (cconf["soa"])         use_soa  = cconf["soa"     ].as<bool>();
+    if (cconf["soafloat"])  soa_float  = cconf["soafloat"].as<bool>();
+    if (cconf["sfcorder"])   sfcorder  = cconf["sfcorder"].as<int>();
+    if (cconf["sfckey"])       sfckey  = cconf["sfckey"  ].as<std::string>();
+    if (cconf["balance"])     balance  = cconf["balance" ].as<std::string>();
+    if (cconf["arena"])     use_arena  = cconf["arena"   ].as<bool>();
+    if (cconf["bulkferry"]) bulkferry  = cconf["bulkferry"].as<bool>();
+    if (cconf["mpiread"])     mpiread  = cconf["mpiread" ].as<bool>();
+    if (cconf["nranks"])       nranks  = cconf["nranks"  ].as<int>();
     
     if (cconf["ton"]) {
       ton = cconf["ton"].as<double>();
@@ -851,6 +1032,9 @@ void Component::configure(void)
       CF = std::make_shared<CenterFile>(cconf["centerfile"]);
     }
 
+    // Particle arena
+    if (use_arena and not pool) pool = ParticlePool::create();
+
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters for Component <"
@@ -865,6 +1049,29 @@ void Component::configure(void)
     throw std::runtime_error("Component: error parsing YAML");
   }
 
+  if (sfckey != "morton" and sfckey != "radius" and sfckey != "cylinder") {
+    std::string msg("Component: unknown sfckey <" + sfckey + ">, "
+		    "expected morton, radius or cylinder");
+    throw GenericError(msg, __FILE__, __LINE__, 1013, false);
+  }
+
+  if (balance != "rates" and balance != "level" and balance != "timed") {
+    std::string msg("Component: unknown balance <" + balance + ">, "
+		    "expected rates, level or timed");
+    throw GenericError(msg, __FILE__, __LINE__, 1013, false);
+  }
+
+  // The particles live on the first nranks processes; the collectives
+  // that only need the holders use this communicator
+  //
+  if (nranks<=0 or nranks>numprocs) nranks = numprocs;
+
+  MPI_Comm_split(MPI_COMM_WORLD, member() ? 0 : MPI_UNDEFINED, myid, &comm);
+
+  if (myid==0 and subset())
+    std::cout << "---- Component <" << name << ">: particles on processes 0-"
+	      << nranks-1 << " of " << numprocs << std::endl;
+
 
   // Instantiate the force ("reflection" by hand)
   //
@@ -898,6 +1105,9 @@ void Component::configure(void)
   else if ( !id.compare("shells") ) {
     force = new Shells(this, fconf);
   }
+  else if ( !id.compare("tree") ) {
+    force = new TreeCode(this, fconf);
+  }
   else if ( !id.compare("noforce") ) {
     force = new NoForce(this, fconf);
   }
@@ -1120,6 +1330,7 @@ void Component::initialize(void)
 		     << " nkeep="  << nEJkeep
 		     << " nwant="  << nEJwant
 		     << " naccel=" << nEJaccel
+		     << " nsample=" << nEJsample
 		     << " EJkinE=" << EJkinE
 		     << " EJext="  << EJext;
     
@@ -1129,6 +1340,7 @@ void Component::initialize(void)
 	cout << " with damping=" << EJdamp;
 	if (EJkinE)   cout << ", using particle kinetic energy";
 	if (EJext)    cout << ", using external potential";
+	if (nEJsample>0) cout << ", subsample=" << nEJsample;
 	if (EJdryrun) cout << ", dryrun";
 	cout << endl;
       }
@@ -1147,7 +1359,7 @@ void Component::initialize(void)
     if (EJext)		EJctl |= Orient::EXTERNAL;
 
     orient = new Orient(nEJkeep, nEJwant, nEJaccel,
-			EJ, EJctl, EJlogfile, EJdT, EJdamp);
+			EJ, EJctl, EJlogfile, EJdT, EJdamp, nEJsample);
     
     if (restart && (EJ & Orient::CENTER)) {
       Eigen::VectorXd::Map(&center[0], 3) = orient->currentCenter();
@@ -1243,6 +1455,10 @@ Component::~Component(void)
 {
   delete force;
 
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (comm != MPI_COMM_NULL and not finalized) MPI_Comm_free(&comm);
+
   delete orient;
 
   delete [] com;
@@ -1309,13 +1525,13 @@ void Component::read_bodies_and_distribute_ascii(void)
 				// Initialize the particle ferry
 				// instance with dynamic attribute
 				// sizes
-  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib));
+  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib, pool));
 
   if (myid==0) {
 				// Read in Node 0's particles
     for (unsigned i=1; i<=nbodies_table[0]; i++) {
 
-      PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+      PartPtr part = makeParticle();
       
       part->readAscii(aindex, i, &fin);
 				// Get the radius
@@ -1341,7 +1557,7 @@ void Component::read_bodies_and_distribute_ascii(void)
       ibufcount = 0;
       while (icount < nbodies_table[n]) {
 
-	PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+	PartPtr part = makeParticle();
 
 	int i = nbodies_index[n-1] + 1 + icount;
 	part->readAscii(aindex, i, &fin);
@@ -1579,20 +1795,23 @@ void Component::read_bodies_and_distribute_binary_out(istream *in)
 				// Initialize the particle ferry
 				// instance with dynamic attribute
 				// sizes
-  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib));
+  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib, pool));
 
 				// Form cumulative and differential
 				// bodies list
   unsigned int ipart=0;
 
-  if (myid==0) {
+  if (mpiread) {
+    rmax1 = read_binary_mpi(in);
+  }
+  else if (myid==0) {
 				// Read root node particles
     seq_cur = 0;
 
     rmax1 = 0.0;
     for (unsigned i=1; i<=nbodies_table[0]; i++)
     {
-      PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+      PartPtr part = makeParticle();
       
       part->readBinary(rsize, indexing, ++seq_cur, in);
 
@@ -1620,7 +1839,7 @@ void Component::read_bodies_and_distribute_binary_out(istream *in)
 
       icount = 0;
       while (icount < nbodies_table[n]) {
-	PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+	PartPtr part = makeParticle();
 
 	part->readBinary(rsize, indexing, ++seq_cur, in);
 
@@ -1721,6 +1940,215 @@ void Component::openNextBlob(std::ifstream& in,
 }
 
 
+size_t Component::record_size()
+{
+  Particle p(niattrib, ndattrib);
+  return p.getMPIBufSize(rsize, indexing);
+}
+
+
+void Component::load_records(const char* buf, unsigned n, unsigned long seq,
+			     double& r2max)
+{
+  for (unsigned i=0; i<n; i++) {
+    PartPtr part = makeParticle();
+
+    buf += part->readBinaryMPI(buf, rsize, indexing, seq + i);
+
+    double r2 = 0.0;
+    for (int k=0; k<3; k++) r2 += part->pos[k]*part->pos[k];
+    r2max = std::max<double>(r2, r2max);
+
+				// Load the particle
+    particles[part->indx] = part;
+
+				// Record top_seq
+    top_seq = std::max<unsigned long>(part->indx, top_seq);
+  }
+}
+
+
+double Component::read_binary_mpi(istream *in)
+{
+  // The root stream is positioned at the first record of this
+  // component
+  //
+  long long base = 0;
+  if (myid==0) base = in->tellg();
+  MPI_Bcast(&base, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+  const size_t recsz = record_size();
+
+  unsigned first = myid ? nbodies_index[myid-1] : 0;
+  unsigned count = nbodies_table[myid];
+
+  std::string file = outdir + infile;
+  MPI_File fh;
+  MPI_Status status;
+
+  int ret = MPI_File_open(MPI_COMM_WORLD, file.c_str(), MPI_MODE_RDONLY,
+			  MPI_INFO_NULL, &fh);
+
+  if (ret != MPI_SUCCESS) {
+    std::ostringstream sout;
+    sout << "Component::read_binary_mpi: can't open file <" << file << ">";
+    throw GenericError(sout.str(), __FILE__, __LINE__, 1010, true);
+  }
+
+  // Every process must join each collective read so the number of
+  // rounds is set by the largest share
+  //
+  unsigned chunk = PFbufsz;
+  unsigned nround = (count + chunk - 1)/chunk, maxround;
+  MPI_Allreduce(&nround, &maxround, 1, MPI_UNSIGNED, MPI_MAX, MPI_COMM_WORLD);
+
+  std::vector<char> buf(chunk*recsz);
+  double r2max = 0.0;
+  unsigned done = 0;
+
+  for (unsigned r=0; r<maxround; r++) {
+    unsigned n = std::min<unsigned>(chunk, count - done);
+    MPI_Offset off = base + static_cast<MPI_Offset>(first + done)*recsz;
+
+    ret = MPI_File_read_at_all(fh, off, buf.data(), n*recsz, MPI_CHAR,
+			       &status);
+
+    if (ret != MPI_SUCCESS) {
+      char err[MPI_MAX_ERROR_STRING];
+      int len;
+      MPI_Error_string(ret, err, &len);
+      std::ostringstream sout;
+      sout << "Component::read_binary_mpi: error reading <" << file
+	   << ">: " << err;
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1010, true);
+    }
+
+    load_records(buf.data(), n, first + done + 1, r2max);
+    done += n;
+  }
+
+  MPI_File_close(&fh);
+
+  nbodies = count;
+
+  // Move the root stream past this component's records
+  //
+  if (myid==0)
+    in->seekg(base + static_cast<long long>(nbodies_tot)*recsz);
+
+  double r2tot;
+  unsigned long tseq;
+  MPI_Reduce(&r2max, &r2tot, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&top_seq, &tseq, 1, MPI_UNSIGNED_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+  if (myid==0) top_seq = tseq;
+
+  return r2tot;
+}
+
+
+double Component::read_binary_mpi_spl(std::list<std::string>& parts)
+{
+  // Blob names are only known to the root
+  //
+  const size_t PBUF_SIZ = 1024;
+  int number = parts.size();
+  MPI_Bcast(&number, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<char> names(number*PBUF_SIZ, 0);
+  if (myid==0) {
+    int n = 0;
+    for (auto & v : parts)
+      v.copy(&names[PBUF_SIZ*n++], PBUF_SIZ-1);
+  }
+  MPI_Bcast(names.data(), names.size(), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  std::vector<std::string> blobs;
+  for (int n=0; n<number; n++) {
+    std::string curfile(&names[PBUF_SIZ*n]);
+    if (outdir.back() != '/') curfile = outdir + '/' + curfile;
+    else                      curfile = outdir + curfile;
+    blobs.push_back(curfile);
+  }
+
+  // The blob counts are read in parallel, each process taking every
+  // numprocs-th blob
+  //
+  std::vector<unsigned> N(number, 0), Ntot(number);
+  for (int n=myid; n<number; n+=numprocs) {
+    std::ifstream fin(blobs[n]);
+    if (fin.good()) fin.read((char*)&N[n], sizeof(unsigned int));
+    if (not fin.good()) {
+      std::ostringstream sout;
+      sout << "Could not get particle count from <" << blobs[n] << ">";
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1010, true);
+    }
+  }
+  MPI_Allreduce(N.data(), Ntot.data(), number, MPI_UNSIGNED, MPI_SUM,
+		MPI_COMM_WORLD);
+
+  const size_t recsz = record_size();
+
+  unsigned first = myid ? nbodies_index[myid-1] : 0;
+  unsigned count = nbodies_table[myid];
+  unsigned last  = first + count;
+
+  std::vector<char> buf;
+  double r2max = 0.0;
+
+  // Each process opens the blobs that overlap its share
+  //
+  unsigned beg = 0;
+  for (int n=0; n<number and beg<last; beg+=Ntot[n++]) {
+    unsigned end = beg + Ntot[n];
+    if (end <= first) continue;
+
+    unsigned b = std::max<unsigned>(beg, first);
+    unsigned e = std::min<unsigned>(end, last);
+
+    MPI_File fh;
+    MPI_Status status;
+
+    int ret = MPI_File_open(MPI_COMM_SELF, blobs[n].c_str(), MPI_MODE_RDONLY,
+			    MPI_INFO_NULL, &fh);
+
+    if (ret != MPI_SUCCESS) {
+      std::ostringstream sout;
+      sout << "Could not open SPL blob <" << blobs[n] << ">";
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1010, true);
+    }
+
+    for (unsigned i=b; i<e; i+=PFbufsz) {
+      unsigned m = std::min<unsigned>(PFbufsz, e - i);
+      buf.resize(m*recsz);
+
+      MPI_Offset off = sizeof(unsigned int) +
+	static_cast<MPI_Offset>(i - beg)*recsz;
+
+      ret = MPI_File_read_at(fh, off, buf.data(), m*recsz, MPI_CHAR, &status);
+
+      if (ret != MPI_SUCCESS) {
+	std::ostringstream sout;
+	sout << "Error reading SPL blob <" << blobs[n] << ">";
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1010, true);
+      }
+
+      load_records(buf.data(), m, i + 1, r2max);
+    }
+
+    MPI_File_close(&fh);
+  }
+
+  nbodies = count;
+
+  double r2tot;
+  unsigned long tseq;
+  MPI_Reduce(&r2max, &r2tot, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&top_seq, &tseq, 1, MPI_UNSIGNED_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+  if (myid==0) top_seq = tseq;
+
+  return r2tot;
+}
+
 void Component::read_bodies_and_distribute_binary_spl(istream *in)
 {
   // Will contain the component header
@@ -1903,13 +2331,16 @@ void Component::read_bodies_and_distribute_binary_spl(istream *in)
 				// Initialize the particle ferry
 				// instance with dynamic attribute
 				// sizes
-  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib));
+  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib, pool));
 
 				// Form cumulative and differential
 				// bodies list
   unsigned int ipart=0;
 
-  if (myid==0) {
+  if (mpiread) {
+    rmax1 = read_binary_mpi_spl(parts);
+  }
+  else if (myid==0) {
 
 				// Set iterator to beginning of split list
     auto fit = parts.begin();
@@ -1928,7 +2359,7 @@ void Component::read_bodies_and_distribute_binary_spl(istream *in)
     rmax1 = 0.0;
     for (unsigned i=1; i<=nbodies_table[0]; i++)
     {
-      PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+      PartPtr part = makeParticle();
       
       part->readBinary(rsize, indexing, ++seq_cur, &fin);
 
@@ -1962,7 +2393,7 @@ void Component::read_bodies_and_distribute_binary_spl(istream *in)
 
       icount = 0;
       while (icount < nbodies_table[n]) {
-	PartPtr part = std::make_shared<Particle>(niattrib, ndattrib);
+	PartPtr part = makeParticle();
 
 	part->readBinary(rsize, indexing, ++seq_cur, &fin);
 
@@ -2248,6 +2679,18 @@ void Component::write_binary(ostream* out, bool real4)
 }
 
 void Component::write_binary_header(ostream* out, bool real4, const std::string prefix, int nth)
+{
+  std::vector<std::string> blobs;
+  if (myid == 0) {
+    for (int n=0; n<numprocs*nth; n++)
+      blobs.push_back(prefix + "-" + std::to_string(n));
+  }
+
+  write_binary_header(out, real4, blobs);
+}
+
+void Component::write_binary_header(ostream* out, bool real4,
+				    const std::vector<std::string>& blobs)
 {
   ComponentHeader header;
 
@@ -2290,7 +2733,7 @@ void Component::write_binary_header(ostream* out, bool real4, const std::string
     else       rsize = sizeof(double);
     unsigned long cmagic = magic + rsize;
 
-    int nfiles = numprocs*nth;
+    int nfiles = blobs.size();
 
     out->write((const char*)&cmagic,  sizeof(unsigned long));
     out->write((const char*)&nfiles,  sizeof(int));
@@ -2303,10 +2746,14 @@ void Component::write_binary_header(ostream* out, bool real4, const std::string
     const size_t PBUF_SIZ = 1024;
     char buf [PBUF_SIZ];
 
-    for (int n=0; n<nfiles; n++) {
-      std::ostringstream sout;
-      sout << prefix << "-" << n << '\0';
-      sout.str().copy(buf, sout.str().size());
+    for (auto & b : blobs) {
+      if (b.size() >= PBUF_SIZ) {
+	std::string msg("Component::write_binary_header: blob name <" + b +
+			"> is too long");
+	throw GenericError(msg, __FILE__, __LINE__, 1011, true);
+      }
+      std::fill(buf, buf+PBUF_SIZ, 0);
+      b.copy(buf, b.size());
       out->write((const char*)buf, PBUF_SIZ);
     }
   }
@@ -2743,96 +3190,479 @@ void Component::write_binary_mpi_i(MPI_File& out, MPI_Offset& offset, bool real4
 }
 
 
-void Component::write_ascii(ostream* out, bool accel)
+size_t Component::stage_size(bool real4)
 {
-  int number = -1;
-  PartPtr *p = get_particles(&number);
+  if (real4) rsize = sizeof(float);
+  else       rsize = sizeof(double);
 
-  while (p) {
-    if (myid == 0) {
-      for (int k=0; k<number; k++) {
-	p[k]->writeAscii(indexing, accel, out);
-      }
-    }
+  size_t bytes = particles.size()*record_size();
 
-    p = get_particles(&number);
+  if (myid==0) {
+    ComponentHeader header;
+    bytes += sizeof(unsigned long) + header.getSize();
   }
-    
+
+  return bytes;
 }
 
 
-void Component::initialize_com_system()
+void Component::write_binary_stage(AsyncWriter& out, size_t& offset, bool real4)
 {
-  double mtot1;
-  double *com1 = new double [3];
-  double *cov1 = new double [3];
-  
+  ComponentHeader header;
+
+  if (real4) rsize = sizeof(float);
+  else       rsize = sizeof(double);
+
+  size_t hsize = sizeof(unsigned long) + header.getSize();
+
+  if (myid == 0) {
+
+    header.nbod  = nbodies_tot;
+    header.niatr = niattrib;
+    header.ndatr = ndattrib;
   
-  PartMapItr p, pend;
+    std::ostringstream outs;
+    outs << conf << std::endl;
+    strncpy(header.info.get(), outs.str().c_str(), header.ninfochar);
 
-				// Zero stuff out
-  mtot0 = mtot1 = 0.0;
-  for (int k=0; k<dim; k++) com1[k] = cov1[k] = 0.0;
+    unsigned long cmagic = magic + rsize;
 
-				// Particle loop
-  pend = particles.end();
-  for (p=particles.begin(); p != pend; p++) {
-    
-    mtot1 += p->second->mass;
+    std::ostringstream sout;
+    sout.write((const char *)&cmagic, sizeof(unsigned long));
+    if (!header.write(&sout)) {
+      std::string msg("Component::write_binary_stage: Error writing particle header");
+      throw GenericError(msg, __FILE__, __LINE__, 1011, true);
+    }
 
-    for (int k=0; k<dim; k++) com1[k] += p->second->mass*p->second->pos[k];
-    for (int k=0; k<dim; k++) cov1[k] += p->second->mass*p->second->vel[k];
-    
+    std::string hdr = sout.str();
+    memcpy(out.append(offset, hsize), hdr.data(), hsize);
   }
+
+  offset += hsize;
+
+  unsigned N = particles.size();
+  std::vector<unsigned> numP(numprocs, 0);
+
+  MPI_Allgather(&N, 1, MPI_UNSIGNED, &numP[0], 1, MPI_UNSIGNED,	MPI_COMM_WORLD);
   
-  MPI_Allreduce(&mtot1, &mtot0, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(com1, com0, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(cov1, cov0, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  
-  if (mtot0 > 0.0) {
-    for (int k=0; k<dim; k++) com0[k] /= mtot0;
-    for (int k=0; k<dim; k++) cov0[k] /= mtot0;
-  }
+  for (int i=1; i<numprocs; i++) numP[i] += numP[i-1];
+  size_t bSiz = record_size();
 
-  for (int k=0; k<dim; k++) {
-    center[k] = 0.0;
+  if (N) {
+    char *buf = out.append(offset + (myid ? numP[myid-1] : 0)*bSiz, N*bSiz);
+    for (auto & p : particles)
+      buf += p.second->writeBinaryMPI(buf, rsize, indexing);
   }
 
-  delete [] com1;
-  delete [] cov1;
+  // Position file offset at end of particles
+  //
+  offset += numP[numprocs-1] * bSiz;
 }
 
-void Component::restart_com_system()
+//! Bytes in a delta record with ndyn attributes; see DeltaHeader
+static size_t delta_record_size(int ndyn)
 {
-  MPI_Bcast(&com_restart, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  if (com_restart) {
-    MPI_Bcast(&com0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&cov0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&acc0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&center[0], 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-  }
-
+  return sizeof(unsigned long) + (6 + ndyn)*sizeof(double) + sizeof(unsigned);
 }
 
-
-struct thrd_pass_posn
+void Component::write_delta_mpi(MPI_File& out, MPI_Offset& offset,
+				const std::vector<int>& dyn)
 {
-  int id;
-  Component *c;
-  int  tidal;
-  bool consp;
-  bool com_system;
-  unsigned mlevel;
-  vector<double> com,  cov,  coa,  mtot;
-  vector<double> comE, covE, mtotE;
-};
+  MPI_Status status;
+  char err[MPI_MAX_ERROR_STRING];
+  int len;
 
+  // Attributes that this component has
+  //
+  std::vector<int> attr;
+  for (auto i : dyn) if (i>=0 and i<ndattrib) attr.push_back(i);
 
+  int ndyn = attr.size();
+  size_t hsize = sizeof(unsigned long) + (1 + ndyn)*sizeof(int);
 
-void * fix_positions_thread(void *ptr)
-{
-  int id          =   static_cast<thrd_pass_posn*>(ptr)->id;
-  Component *c    =   static_cast<thrd_pass_posn*>(ptr)->c;
+  if (myid == 0) {
+    std::vector<char> hdr(hsize);
+    unsigned long nbod = nbodies_tot;
+    char *h = hdr.data();
+    memcpy(h, &nbod, sizeof(unsigned long)); h += sizeof(unsigned long);
+    memcpy(h, &ndyn, sizeof(int));           h += sizeof(int);
+    if (ndyn) memcpy(h, attr.data(), ndyn*sizeof(int));
+
+    int ret =
+      MPI_File_write_at(out, offset, hdr.data(), hsize, MPI_CHAR, &status);
+
+    if (ret != MPI_SUCCESS) {
+      MPI_Error_string(ret, err, &len);
+      std::cout << "Component::write_delta_mpi: " << err
+		<< " at line " << __LINE__ << std::endl;
+    }
+  }
+
+  offset += hsize;
+
+  unsigned N = particles.size();
+  std::vector<unsigned> numP(numprocs, 0);
+
+  MPI_Allgather(&N, 1, MPI_UNSIGNED, &numP[0], 1, MPI_UNSIGNED, MPI_COMM_WORLD);
+
+  for (int i=1; i<numprocs; i++) numP[i] += numP[i-1];
+  size_t bSiz = delta_record_size(ndyn);
+  MPI_Offset end = offset + numP[numprocs-1]*bSiz;
+  if (myid) offset += numP[myid-1]*bSiz;
+
+  std::vector<char> buffer(pBufSiz*bSiz);
+  size_t count = 0;
+  char *buf = &buffer[0];
+
+  auto flush = [&]()
+  {
+    int ret = MPI_File_write_at(out, offset, &buffer[0], bSiz*count,
+				MPI_CHAR, &status);
+
+    if (ret != MPI_SUCCESS) {
+      MPI_Error_string(ret, err, &len);
+      std::cout << "Component::write_delta_mpi: " << err
+		<< " at line " << __LINE__ << std::endl;
+    }
+
+    offset += bSiz*count;
+    count   = 0;
+    buf     = &buffer[0];
+  };
+
+  for (auto & v : particles) {
+    auto & p = v.second;
+    unsigned long indx = p->indx;
+    memcpy(buf, &indx, sizeof(unsigned long)); buf += sizeof(unsigned long);
+    memcpy(buf, p->pos, 3*sizeof(double));      buf += 3*sizeof(double);
+    memcpy(buf, p->vel, 3*sizeof(double));      buf += 3*sizeof(double);
+    memcpy(buf, &p->level, sizeof(unsigned));   buf += sizeof(unsigned);
+    for (auto i : attr) {
+      memcpy(buf, &p->dattrib[i], sizeof(double)); buf += sizeof(double);
+    }
+
+    if (++count==pBufSiz) flush();
+  }
+
+  if (count) flush();
+
+  // Position file offset at end of particles
+  //
+  offset = end;
+}
+
+
+void Component::read_delta(std::istream* in)
+{
+  unsigned long nbod = 0;
+  int ndyn = 0;
+
+  if (myid==0) {
+    in->read((char *)&nbod, sizeof(unsigned long));
+    in->read((char *)&ndyn, sizeof(int));
+  }
+
+  MPI_Bcast(&nbod, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+  MPI_Bcast(&ndyn, 1, MPI_INT,           0, MPI_COMM_WORLD);
+
+  std::vector<int> attr(ndyn);
+  if (myid==0 and ndyn) in->read((char *)attr.data(), ndyn*sizeof(int));
+  if (ndyn) MPI_Bcast(attr.data(), ndyn, MPI_INT, 0, MPI_COMM_WORLD);
+
+  int bad = 0;
+  if (myid==0 and in->fail()) bad = 1;
+  MPI_Bcast(&bad, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  if (bad) {
+    std::ostringstream sout;
+    sout << "Component::read_delta: error reading the delta header for <"
+	 << name << ">";
+    throw GenericError(sout.str(), __FILE__, __LINE__, 1011, true);
+  }
+
+  if (nbod != nbodies_tot) {
+    std::ostringstream sout;
+    sout << "Component::read_delta: <" << name << "> has " << nbodies_tot
+	 << " bodies in the base phase space but " << nbod
+	 << " in the checkpoint";
+    throw GenericError(sout.str(), __FILE__, __LINE__, 1011, true);
+  }
+
+  for (auto i : attr) {
+    if (i >= ndattrib) {
+      std::ostringstream sout;
+      sout << "Component::read_delta: <" << name << "> has no attribute "
+	   << i;
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1011, true);
+    }
+  }
+
+  // The root reads blocks of records and every process updates the
+  // bodies that it holds
+  //
+  size_t bSiz = delta_record_size(ndyn);
+  std::vector<char> buffer(pBufSiz*bSiz);
+  unsigned long found = 0;
+
+  for (unsigned long done=0; done<nbod; ) {
+    int count = std::min<unsigned long>(pBufSiz, nbod - done);
+
+    if (myid==0) {
+      in->read(&buffer[0], count*bSiz);
+      bad = in->fail() ? 1 : 0;
+    }
+
+    MPI_Bcast(&bad, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (bad) {
+      std::ostringstream sout;
+      sout << "Component::read_delta: error reading bodies for <"
+	   << name << ">";
+      throw GenericError(sout.str(), __FILE__, __LINE__, 1011, true);
+    }
+
+    MPI_Bcast(&buffer[0], count*bSiz, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    const char *buf = &buffer[0];
+    for (int n=0; n<count; n++, buf+=bSiz) {
+      unsigned long indx;
+      memcpy(&indx, buf, sizeof(unsigned long));
+
+      auto it = particles.find(indx);
+      if (it == particles.end()) continue;
+
+      auto & p = it->second;
+      const char *b = buf + sizeof(unsigned long);
+      memcpy(p->pos, b, 3*sizeof(double));    b += 3*sizeof(double);
+      memcpy(p->vel, b, 3*sizeof(double));    b += 3*sizeof(double);
+      memcpy(&p->level, b, sizeof(unsigned)); b += sizeof(unsigned);
+      for (auto i : attr) {
+	memcpy(&p->dattrib[i], b, sizeof(double)); b += sizeof(double);
+      }
+      found++;
+    }
+
+    done += count;
+  }
+
+  unsigned long total = 0;
+  MPI_Allreduce(&found, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  if (total != nbod) {
+    std::ostringstream sout;
+    sout << "Component::read_delta: only " << total << " of " << nbod
+	 << " bodies of <" << name << "> are in the base phase space";
+    throw GenericError(sout.str(), __FILE__, __LINE__, 1011, true);
+  }
+
+  reset_level_lists();
+}
+
+std::string Component::format_ascii(bool accel)
+{
+  // Index order within this process
+  //
+  std::vector<Particle*> pts;
+  pts.reserve(particles.size());
+  for (auto & p : particles) pts.push_back(p.second.get());
+  std::sort(pts.begin(), pts.end(),
+	    [](const Particle* a, const Particle* b)
+	    { return a->indx < b->indx; });
+
+  // Each thread formats a contiguous range into its own buffer; the
+  // buffers are joined in thread order
+  //
+  std::vector<std::string> bufs(nthrds);
+  const size_t N = pts.size();
+
+#pragma omp parallel num_threads(nthrds)
+  {
+    int id = omp_get_thread_num(), nt = omp_get_num_threads();
+    size_t beg = N*id/nt, end = N*(id+1)/nt;
+    if (end > beg)
+      bufs[id].reserve((end - beg)*
+		       (200 + 10*niattrib + 18*ndattrib));
+    for (size_t i=beg; i<end; i++)
+      pts[i]->formatAscii(indexing, accel, bufs[id]);
+  }
+
+  size_t total = 0;
+  for (auto & b : bufs) total += b.size();
+
+  std::string ret;
+  ret.reserve(total);
+  for (auto & b : bufs) ret += b;
+
+  return ret;
+}
+
+void Component::write_ascii(ostream* out, bool accel)
+{
+  // Assign indices to new particles before formatting.  Collective.
+  //
+  seq_new_particles();
+
+  std::string buf = format_ascii(accel);
+
+  // Root writes its own buffer and then those of the other processes
+  // in rank order, in pieces that fit an MPI count
+  //
+  const size_t maxChunk = std::numeric_limits<int>::max();
+
+  unsigned long len = buf.size();
+  std::vector<unsigned long> lens(numprocs);
+  MPI_Gather(&len, 1, MPI_UNSIGNED_LONG, lens.data(), 1, MPI_UNSIGNED_LONG,
+	     0, MPI_COMM_WORLD);
+
+  if (myid==0) {
+    out->write(buf.data(), buf.size());
+
+    std::vector<char> rbuf;
+    for (int n=1; n<numprocs; n++) {
+      rbuf.resize(std::min<size_t>(lens[n], maxChunk));
+      for (size_t done=0; done<lens[n]; ) {
+	int cnt = std::min<size_t>(lens[n] - done, maxChunk);
+	MPI_Recv(rbuf.data(), cnt, MPI_CHAR, n, 1003, MPI_COMM_WORLD,
+		 MPI_STATUS_IGNORE);
+	out->write(rbuf.data(), cnt);
+	done += cnt;
+      }
+    }
+  } else {
+    for (size_t done=0; done<len; ) {
+      int cnt = std::min<size_t>(len - done, maxChunk);
+      MPI_Send(buf.data() + done, cnt, MPI_CHAR, 0, 1003, MPI_COMM_WORLD);
+      done += cnt;
+    }
+  }
+}
+
+void Component::write_ascii_mpi(MPI_File& out, MPI_Offset& offset, bool accel)
+{
+  char err[MPI_MAX_ERROR_STRING];
+  int len;
+
+  // Assign indices to new particles before formatting.  Collective.
+  //
+  seq_new_particles();
+
+  std::string buf = format_ascii(accel);
+
+  // File position of this process from the prefix sum of the buffer
+  // sizes
+  //
+  unsigned long bsiz = buf.size();
+  std::vector<unsigned long> numB(numprocs, 0);
+
+  MPI_Allgather(&bsiz, 1, MPI_UNSIGNED_LONG, &numB[0], 1, MPI_UNSIGNED_LONG,
+		MPI_COMM_WORLD);
+
+  for (int i=1; i<numprocs; i++) numB[i] += numB[i-1];
+
+  MPI_Offset pos = offset;
+  if (myid) pos += numB[myid-1];
+
+  // Collective writes in pieces that fit an MPI count; every process
+  // makes the same number of calls
+  //
+  const size_t maxChunk = std::numeric_limits<int>::max();
+
+  unsigned long nchunk = (bsiz + maxChunk - 1)/maxChunk, nmax;
+  MPI_Allreduce(&nchunk, &nmax, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+  size_t done = 0;
+  for (unsigned long n=0; n<nmax; n++) {
+    int cnt = std::min<size_t>(bsiz - done, maxChunk);
+
+    int ret = MPI_File_write_at_all(out, pos + done, buf.data() + done, cnt,
+				    MPI_CHAR, MPI_STATUS_IGNORE);
+
+    if (ret != MPI_SUCCESS) {
+      MPI_Error_string(ret, err, &len);
+      std::cout << "Component::write_ascii_mpi: " << err
+		<< " at line " << __LINE__ << std::endl;
+    }
+
+    done += cnt;
+  }
+
+  // Position file offset at end of particles
+  //
+  offset += numB[numprocs-1];
+}
+
+
+void Component::initialize_com_system()
+{
+  double mtot1;
+  double *com1 = new double [3];
+  double *cov1 = new double [3];
+  
+  
+  PartMapItr p, pend;
+
+				// Zero stuff out
+  mtot0 = mtot1 = 0.0;
+  for (int k=0; k<dim; k++) com1[k] = cov1[k] = 0.0;
+
+				// Particle loop
+  pend = particles.end();
+  for (p=particles.begin(); p != pend; p++) {
+    
+    mtot1 += p->second->mass;
+
+    for (int k=0; k<dim; k++) com1[k] += p->second->mass*p->second->pos[k];
+    for (int k=0; k<dim; k++) cov1[k] += p->second->mass*p->second->vel[k];
+    
+  }
+  
+  MPI_Allreduce(&mtot1, &mtot0, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(com1, com0, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(cov1, cov0, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  
+  if (mtot0 > 0.0) {
+    for (int k=0; k<dim; k++) com0[k] /= mtot0;
+    for (int k=0; k<dim; k++) cov0[k] /= mtot0;
+  }
+
+  for (int k=0; k<dim; k++) {
+    center[k] = 0.0;
+  }
+
+  delete [] com1;
+  delete [] cov1;
+}
+
+void Component::restart_com_system()
+{
+  MPI_Bcast(&com_restart, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (com_restart) {
+    MPI_Bcast(&com0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&cov0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&acc0[0],   3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&center[0], 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  }
+
+}
+
+
+struct thrd_pass_posn
+{
+  int id;
+  Component *c;
+  int  tidal;
+  bool consp;
+  bool com_system;
+  unsigned mlevel;
+  vector<double> com,  cov,  coa,  mtot, angm;
+  vector<double> comE, covE, mtotE;
+};
+
+
+
+void * fix_positions_thread(void *ptr)
+{
+  int id          =   static_cast<thrd_pass_posn*>(ptr)->id;
+  Component *c    =   static_cast<thrd_pass_posn*>(ptr)->c;
 
   int  tidal      =   static_cast<thrd_pass_posn*>(ptr)->tidal;
   bool consp      =   static_cast<thrd_pass_posn*>(ptr)->consp;
@@ -2844,7 +3674,7 @@ void * fix_positions_thread(void *ptr)
   double *cov     = &(static_cast<thrd_pass_posn*>(ptr)->cov[0]);
   double *coa     = &(static_cast<thrd_pass_posn*>(ptr)->coa[0]);
   double *mtot    = &(static_cast<thrd_pass_posn*>(ptr)->mtot[0]);
-
+  double *angm    = &(static_cast<thrd_pass_posn*>(ptr)->angm[0]);
 
   double *comE, *covE, *mtotE;
 
@@ -2866,6 +3696,18 @@ void * fix_positions_thread(void *ptr)
       unsigned long n = c->levlist[mm][q];
       Particle     *p = c->Part(n);
 
+      // Angular momentum of every particle in the field, in the same
+      // pass
+      //
+      bool frozen = c->freeze(n);
+
+      if (not frozen) {
+	double mass = p->mass, *pos = p->pos, *vel = p->vel;
+	angm[3*mm + 0] += mass*(pos[1]*vel[2] - pos[2]*vel[1]);
+	angm[3*mm + 1] += mass*(pos[2]*vel[0] - pos[0]*vel[2]);
+	angm[3*mm + 2] += mass*(pos[0]*vel[1] - pos[1]*vel[0]);
+      }
+
       if (consp and tidal>=0) {
 	if (c->escape_com(*p) && p->iattrib[tidal]==0) {
 				// Set flag indicating escaped particle
@@ -2885,7 +3727,7 @@ void * fix_positions_thread(void *ptr)
 	if (p->iattrib[tidal]==1) continue;
       }
 
-      if (c->freeze(n)) continue;
+      if (frozen) continue;
 
       mtot[mm] += p->mass;
 
@@ -2917,7 +3759,8 @@ void Component::fix_positions_cpu(unsigned mlevel)
   for (unsigned mm=mlevel; mm<=multistep; mm++) {
     com_mas[mm] = 0.0;
     for (unsigned k=0; k<3; k++) 
-      com_lev[3*mm+k] = cov_lev[3*mm+k] = coa_lev[3*mm+k] = 0.0;
+      com_lev[3*mm+k] = cov_lev[3*mm+k] = coa_lev[3*mm+k] =
+	angmom_lev[3*mm+k] = 0.0;
   }
 
   vector<thrd_pass_posn> data(nthrds);
@@ -2936,6 +3779,7 @@ void Component::fix_positions_cpu(unsigned mlevel)
     data[0].cov  = vector<double>(3*(multistep+1), 0.0);
     data[0].coa  = vector<double>(3*(multistep+1), 0.0);
     data[0].mtot = vector<double>(multistep+1, 0.0);
+    data[0].angm = vector<double>(3*(multistep+1), 0.0);
 
     if (consp && com_system) {
       data[0].comE  = vector<double>(3*(multistep+1), 0.0);
@@ -2950,6 +3794,7 @@ void Component::fix_positions_cpu(unsigned mlevel)
 	com_lev[3*mm + k] += data[0].com[3*mm + k];
 	cov_lev[3*mm + k] += data[0].cov[3*mm + k];
 	coa_lev[3*mm + k] += data[0].coa[3*mm + k];
+	angmom_lev[3*mm + k] += data[0].angm[3*mm + k];
       }
       com_mas[mm] += data[0].mtot[mm];
 
@@ -2980,6 +3825,7 @@ void Component::fix_positions_cpu(unsigned mlevel)
       data[i].cov  = vector<double>(3*(multistep+1), 0.0);
       data[i].coa  = vector<double>(3*(multistep+1), 0.0);
       data[i].mtot = vector<double>(multistep+1, 0.0);
+      data[i].angm = vector<double>(3*(multistep+1), 0.0);
 
       if (consp && com_system) {
 	data[i].comE  = vector<double>(3*(multistep+1), 0.0);
@@ -3015,6 +3861,7 @@ void Component::fix_positions_cpu(unsigned mlevel)
 	  com_lev[3*mm + k] += data[i].com[3*mm + k];
 	  cov_lev[3*mm + k] += data[i].cov[3*mm + k];
 	  coa_lev[3*mm + k] += data[i].coa[3*mm + k];
+	  angmom_lev[3*mm + k] += data[i].angm[3*mm + k];
 	}
 	com_mas[mm] += data[i].mtot[mm];
       }
@@ -3033,25 +3880,45 @@ void Component::fix_positions_cpu(unsigned mlevel)
   }
 
   //
-  // Sum levels
+  // Sum levels into a single buffer for one reduction: mass, com,
+  // cov, coa and angular momentum, followed by the escaper sums
+  // (mass, com, cov) when conserving momentum
   //
-  vector<double> com1(3, 0.0), cov1(3, 0.0), coa1(3, 0.0);
-  double         mtot1 = 0.0;
+  const bool escape = consp && com_system;
+  std::vector<double> buf(escape ? 20 : 13, 0.0);
 
   for (unsigned mm=0; mm<=multistep; mm++) {
+    buf[0] += com_mas[mm];
     for (int k=0; k<3; k++) {
-      com1[k] += com_lev[3*mm + k];
-      cov1[k] += cov_lev[3*mm + k];
-      coa1[k] += coa_lev[3*mm + k];
+      buf[ 1+k] += com_lev   [3*mm + k];
+      buf[ 4+k] += cov_lev   [3*mm + k];
+      buf[ 7+k] += coa_lev   [3*mm + k];
+      buf[10+k] += angmom_lev[3*mm + k];
     }
-    mtot1 += com_mas[mm];
   }
 
-  MPI_Allreduce(&mtot1, &mtot, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(&com1[0], com, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(&cov1[0], cov, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(&coa1[0], coa, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    
+  if (escape) {
+    for (unsigned mm=mlevel; mm<=multistep; mm++) {
+      buf[13] += comE_mas[mm];
+      for (int k=0; k<3; k++) {
+	buf[14+k] += comE_lev[3*mm + k];
+	buf[17+k] += covE_lev[3*mm + k];
+      }
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, buf.data(), buf.size(), MPI_DOUBLE, MPI_SUM,
+		MPI_COMM_WORLD);
+
+  mtot = buf[0];
+  for (int k=0; k<3; k++) {
+    com   [k] = buf[ 1+k];
+    cov   [k] = buf[ 4+k];
+    coa   [k] = buf[ 7+k];
+    angmom[k] = buf[10+k];
+  }
+
+
   if (VERBOSE>5) {
 				// Check for NaN
     bool com_nan = false, cov_nan = false, coa_nan = false;
@@ -3069,25 +3936,9 @@ void Component::fix_positions_cpu(unsigned mlevel)
       cerr << "Component [" << name << "] coa has a NaN" << endl;
   }
 
-  if (consp && com_system) {
+  if (escape) {
     
-    vector<double> comE(3), covE(3);
-    double         mtotE;
-    
-    mtot1 = 0.0;
-    for (int k=0; k<3; k++) com1[k] = cov1[k] = 0.0;
-
-    for (unsigned mm=mlevel; mm<=multistep; mm++) {
-      for (int k=0; k<3; k++) {
-	com1[k] += comE_lev[3*mm + k];
-	cov1[k] += covE_lev[3*mm + k];
-      }
-      mtot1 += comE_mas[mm];
-    }
-
-    MPI_Allreduce(&mtot1,   &mtotE,   1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&com1[0], &comE[0], 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    MPI_Allreduce(&cov1[0], &covE[0], 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    double mtotE = buf[13], *comE = &buf[14], *covE = &buf[17];
     
     for (int i=0; i<3; i++) {
       com0[i] = (mtot0*com0[i] - comE[i])/(mtot0 - mtotE);
@@ -3340,14 +4191,16 @@ void Component::setup_distribution(void)
     orates = vector<double>(numprocs);
     trates = vector<double>(numprocs);
 
+    auto rates = subset_rates();
+
     for (int n=0; n<numprocs; n++) {
 
       if (n == 0)
 	nbodies_table[n] = nbodies_index[n] = 
-	  max<int>(1, min<int>((int)(comp->rates[n] * nbodies_tot), nbodies_tot));
+	  max<int>(1, min<int>((int)(rates[n] * nbodies_tot), nbodies_tot));
       else {
-	if (n < numprocs-1)
-	  nbodies_index[n] = (int)(comp->rates[n] * nbodies_tot) + 
+	if (n < nranks-1)
+	  nbodies_index[n] = (int)(rates[n] * nbodies_tot) + 
 	    nbodies_index[n-1];
 	else
 	  nbodies_index[n] = nbodies_tot;
@@ -3379,8 +4232,8 @@ void Component::setup_distribution(void)
       
       for (int n=0; n<numprocs; n++)
 	out << "  "
-	    << setw(15) << comp->rates[n]
-	    << setw(15) << 1.0 - comp->rates[n]*nbodies_tot/nbodies_table[n]
+	    << setw(15) << rates[n]
+	    << setw(15) << (nbodies_table[n] ? 1.0 - rates[n]*nbodies_tot/nbodies_table[n] : 0.0)
 	    << setw(15) << nbodies_index[n]
 	    << setw(15) << nbodies_table[n]
 	    << endl;
@@ -3412,7 +4265,7 @@ void Component::update_indices(void)
   // Cumulate
   //
   nbodies_index[0] = nbodies_table[0];
-  for (int n=0; n<numprocs; n++)
+  for (int n=1; n<numprocs; n++)
     nbodies_index[n] = nbodies_index[n-1] + nbodies_table[n];
 
 }
@@ -3426,19 +4279,25 @@ void Component::load_balance(void)
 
   update_indices();		// Refresh particle counts
 
+  bool costmodel = balance != "rates";
+
+  if (costmodel) cost_partition(nbodies_index1, nbodies_table1);
+
   if (myid == 0) {
 
     std::vector<double> orates1(numprocs);
     std::vector<double> trates1(numprocs);
 
-    for (int n=0; n<numprocs; n++) {
+    auto rates = subset_rates();
+
+    for (int n=0; n<numprocs and not costmodel; n++) {
 
       if (n == 0)
 	nbodies_table1[n] = nbodies_index1[n] = 
-	  std::max<int>(1, min<int>((int)(comp->rates[n] * nbodies_tot), nbodies_tot));
+	  std::max<int>(1, min<int>((int)(rates[n] * nbodies_tot), nbodies_tot));
       else {
-	if (n < numprocs-1)
-	  nbodies_index1[n] = (int)(comp->rates[n] * nbodies_tot) +  nbodies_index1[n-1];
+	if (n < nranks-1)
+	  nbodies_index1[n] = (int)(rates[n] * nbodies_tot) +  nbodies_index1[n-1];
 	else
 	  nbodies_index1[n] = nbodies_tot;
       
@@ -3468,7 +4327,9 @@ void Component::load_balance(void)
 
     if (out) {
       out << "# " << endl;
-      out << "# Time=" << tnow << " Component=" << name << endl;
+      out << "# Time=" << tnow << " Component=" << name;
+      if (costmodel) out << " Balance=" << balance;
+      out << endl;
       out << "# " 
 	  << setw(15) << "Norm rate"
 	  << setw(15) << "Delta rate"
@@ -3488,8 +4349,8 @@ void Component::load_balance(void)
       
       for (int n=0; n<numprocs; n++)
 	out << "  "
-	    << setw(15) << comp->rates[n]
-	    << setw(15) << 1.0 - comp->rates[n]*nbodies_tot/nbodies_table1[n]
+	    << setw(15) << rates[n]
+	    << setw(15) << (nbodies_table1[n] ? 1.0 - rates[n]*nbodies_tot/nbodies_table1[n] : 0.0)
 	    << setw(15) << nbodies_index1[n]
 	    << setw(15) << nbodies_table1[n]
 	    << setw(15) << nbodies_index[n]
@@ -3583,6 +4444,32 @@ void Component::load_balance(void)
 
   std::vector<PartPtr> nlist;
 
+  // The cost model partitions each process block in level order, so
+  // the boundary slices are taken from a snapshot of that order
+  //
+  std::vector<int> order;
+  if (costmodel) {
+    auto run = levlist.range(0, multistep);
+    order.assign(run.begin(), run.end());
+  }
+
+  // In bulk mode the slices are only collected here and shipped
+  // together after the loop, so the map is walked from a running
+  // position instead of from its start
+  //
+  std::vector<std::vector<PartPtr>> send;
+  if (bulkferry) send.resize(numprocs);
+  PartMapItr pit = particles.begin();
+
+  auto ship = [&](int from, int to)
+  {
+    if (bulkferry) {
+      if (myid==from)
+	send[to].insert(send[to].end(), nlist.begin(), nlist.end());
+    } else
+      add_particles(from, to, nlist);
+  };
+
   for (int i=0; i<2*numprocs-2; i++) {
 
 				// Assign new interval
@@ -3602,37 +4489,59 @@ void Component::load_balance(void)
     
     if (inew==iold || nump==0) 
       msg << "Do nothing";
-    else if (inew>iold) {
+    else if (costmodel) {
+      msg << "Add " << nump << " from #" << iold << " to #" << inew;
+
+      nlist.clear();
+
+      if (myid==iold) {
+	unsigned first = loadb[i].top;
+	if (iold>0) first -= nbodies_index[iold-1];
+	for (int n=0; n<nump; n++)
+	  nlist.push_back(particles[order[first+n]]);
+      }
+
+      ship(iold, inew);
+
+    } else if (inew>iold) {
       msg << "Add " << nump << " from #" << iold << " to #" << inew;
       
       nlist.clear();
 
-      PartMap::iterator it = particles.begin();
-      for (int n=0; n<nump; n++) {
-	nlist.push_back(it->second);
-	it++;
+      PartMap::iterator it = bulkferry ? pit : particles.begin();
+      if (myid==iold or not bulkferry) {
+	for (int n=0; n<nump; n++) {
+	  nlist.push_back(it->second);
+	  it++;
+	}
       }
+      if (bulkferry and myid==iold) pit = it;
       
-      add_particles(iold, inew, nlist);
+      ship(iold, inew);
       
     } else if (iold>inew) {
       msg << "Add " << nump << " from #" << iold << " to #" << inew;
 
       nlist.clear();
 
-      PartMapItr it = particles.begin();
-      for (int n=0; n<nump; n++) {
-	nlist.push_back(it->second);
-	it++;
+      PartMapItr it = bulkferry ? pit : particles.begin();
+      if (myid==iold or not bulkferry) {
+	for (int n=0; n<nump; n++) {
+	  nlist.push_back(it->second);
+	  it++;
+	}
       }
+      if (bulkferry and myid==iold) pit = it;
 
-      add_particles(iold, inew, nlist);
+      ship(iold, inew);
 
     }
 
     if (myid==0 && log.good()) log << setw(10) << msg.str() << endl;
   }
 
+  if (bulkferry) exchange_particles(send);
+
   
 				// update indices
   nbodies = nbodies_table1[myid];
@@ -3653,15 +4562,206 @@ void Component::load_balance(void)
 }
 
 
-template< typename T >
-typename std::vector<T>::iterator 
-insert_sorted( std::vector<T> & vec, T const& item )
+double Component::cost_imbalance()
+{
+  double w = 0.0, wmax, wsum;
+  for (unsigned lev=0; lev<=multistep; lev++)
+    w += std::ldexp(static_cast<double>(levlist[lev].size()), lev);
+
+  MPI_Allreduce(&w, &wmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(&w, &wsum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  if (wsum<=0.0) return 0.0;
+  return wmax*nranks/wsum - 1.0;
+}
+
+bool Component::adaptive_balance(int nsteps)
+{
+  // Time per step and body count of every process
+  //
+  double t = balance_time/std::max<int>(nsteps, 1);
+  balance_time = 0.0;
+
+  std::vector<double> times(numprocs);
+  MPI_Allgather(&t, 1, MPI_DOUBLE, times.data(), 1, MPI_DOUBLE,
+		MPI_COMM_WORLD);
+
+  update_indices();
+
+  // Throughput of each process.  The step waits for the slowest
+  // process; balanced in proportion to the throughput, every process
+  // would take tbal.
+  //
+  double tmax = 0.0, through = 0.0, ntot = 0.0;
+  std::vector<double> r(numprocs, 0.0);
+  bool measured = true;
+
+  for (int n=0; n<nranks; n++) {
+    tmax = std::max<double>(tmax, times[n]);
+    ntot += nbodies_table[n];
+    if (times[n]>0.0) r[n] = nbodies_table[n]/times[n];
+    else if (nbodies_table[n]) measured = false;
+    through += r[n];
+  }
+
+  if (not measured or through<=0.0) return false;
+
+  double tbal = ntot/through;
+  double imbalance = tbal>0.0 ? tmax/tbal - 1.0 : 0.0;
+  double gain = std::max<double>(tmax - tbal, 0.0) * balancehorizon;
+
+  // Bodies leaving the processes above their share, priced at the
+  // measured cost per body of the previous rebalance.  Until one has
+  // been measured, the first rebalance is taken on the imbalance
+  // alone.
+  //
+  double moved = 0.0;
+  for (int n=0; n<nranks; n++)
+    moved += std::max<double>(nbodies_table[n] - ntot*r[n]/through, 0.0);
+
+  double cost = migrate_cost>0.0 ? migrate_cost*moved : 0.0;
+
+  bool go = imbalance > dbthresh and gain > cost;
+
+  std::string rateslog =
+    outdir + "current.processor.rates.log." + name + "." + runtag;
+
+  if (myid==0) {
+    std::ofstream log(rateslog, ios::out | ios::app);
+    if (log) {
+      log << std::setw(72) << std::setfill('.') << ".\n" << std::setfill(' ');
+      log << "Adaptive balance: Step=" << this_step << " Time=" << tnow
+	  << " Component=" << name << std::endl
+	  << "  Slowest=" << tmax << " Balanced=" << tbal
+	  << " Imbalance=" << imbalance << std::endl
+	  << "  Gain over " << balancehorizon << " steps=" << gain
+	  << " Bodies to move=" << static_cast<unsigned long>(moved)
+	  << " Cost=";
+      if (migrate_cost>0.0) log << cost;
+      else                  log << "unmeasured";
+      log << std::endl
+	  << "  Decision=" << (go ? "rebalance" : "skip") << std::endl;
+    }
+  }
+
+  if (not go) return false;
+
+  // Rates from the throughput of this component
+  //
+  if (balance == "rates") crates = r;
+
+  std::vector<unsigned> before = nbodies_table;
+
+  double t0 = MPI_Wtime();
+  load_balance();
+  if (sfcorder) sfc_reorder();
+  double dt = MPI_Wtime() - t0, dtmax;
+
+  MPI_Allreduce(&dt, &dtmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  double actual = 0.0;
+  for (int n=0; n<nranks; n++)
+    actual += std::max<double>(static_cast<double>(before[n]) - nbodies_table[n], 0.0);
+
+  if (actual>0.0) migrate_cost = dtmax/actual;
+
+  if (myid==0) {
+    std::ofstream log(rateslog, ios::out | ios::app);
+    if (log)
+      log << "Adaptive balance: moved " << static_cast<unsigned long>(actual)
+	  << " bodies in " << dtmax << " s, cost per body=" << migrate_cost
+	  << std::endl;
+  }
+
+  return true;
+}
+
+std::vector<double> Component::subset_rates()
+{
+  std::vector<double> r(numprocs, 0.0);
+
+  const auto & rates = crates.size() ? crates : comp->rates;
+
+  double norm = 0.0;
+  for (int n=0; n<nranks; n++) norm += rates[n];
+  for (int n=0; n<nranks; n++)
+    r[n] = norm>0.0 ? rates[n]/norm : 1.0/nranks;
+
+  return r;
+}
+
+void Component::cost_partition(std::vector<unsigned>& index,
+			       std::vector<unsigned>& table)
 {
-  return vec.insert
-    ( 
-     std::upper_bound( vec.begin(), vec.end(), item ),
-     item 
-      );
+  // Level populations of every process
+  //
+  const int nlev = multistep + 1;
+  std::vector<unsigned> mine(nlev), counts(nlev*numprocs);
+  for (int lev=0; lev<nlev; lev++) mine[lev] = levlist[lev].size();
+
+  MPI_Gather(mine.data(), nlev, MPI_UNSIGNED,
+	     counts.data(), nlev, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  if (myid==0) {
+
+    // A body on level l is evaluated 2^l times per master step
+    //
+    std::vector<double> wlev(nlev), wproc(numprocs, 0.0);
+    for (int lev=0; lev<nlev; lev++) wlev[lev] = std::ldexp(1.0, lev);
+
+    double wtot = 0.0;
+    for (int n=0; n<numprocs; n++) {
+      for (int lev=0; lev<nlev; lev++)
+	wproc[n] += wlev[lev]*counts[n*nlev+lev];
+      wtot += wproc[n];
+    }
+
+    // Share of the weight per process: equal, or in proportion to
+    // the measured weight per unit step time
+    //
+    std::vector<double> share(numprocs, 0.0);
+    for (int n=0; n<nranks; n++) share[n] = 1.0;
+    if (balance == "timed" and static_cast<int>(comp->steptime.size())==numprocs) {
+      for (int n=0; n<nranks; n++)
+	if (comp->steptime[n]>0.0 and wproc[n]>0.0)
+	  share[n] = wproc[n]/comp->steptime[n];
+    }
+    double norm = 0.0;
+    for (auto v : share) norm += v;
+    for (auto & v : share) v /= norm;
+
+    // Walk the weighted prefix sum over the process blocks, each in
+    // level order, and cut at the target weights
+    //
+    int next = 0;
+    double target = wtot*share[0], wcum = 0.0;
+    unsigned pos = 0;
+
+    for (int n=0; n<numprocs and next<nranks-1; n++) {
+      for (int lev=0; lev<nlev and next<nranks-1; lev++) {
+	unsigned c = counts[n*nlev+lev];
+	double   w = wlev[lev];
+	while (next<nranks-1 and target <= wcum + c*w) {
+	  unsigned k = std::min<unsigned>(c, std::floor((target - wcum)/w + 0.5));
+	  index[next] = pos + k;
+	  target += wtot*share[++next];
+	}
+	pos  += c;
+	wcum += c*w;
+      }
+    }
+
+    // Any cuts beyond the last body, and the processes outside the
+    // subset
+    //
+    for (; next<numprocs-1; next++) index[next] = nbodies_tot;
+    index[numprocs-1] = nbodies_tot;
+
+    for (int n=0; n<numprocs; n++) {
+      if (n>0 and index[n]<index[n-1]) index[n] = index[n-1];
+      table[n] = n ? index[n] - index[n-1] : index[n];
+    }
+  }
 }
 
 void Component::add_particles(int from, int to, std::vector<PartPtr>& plist)
@@ -3684,15 +4784,7 @@ void Component::add_particles(int from, int to, std::vector<PartPtr>& plist)
 
 	// Remove particle from lev list
 	//
-	bool success = false;	// Sanity check
-	for (auto & v : levlist) {
-	  auto jt = std::find(v.begin(), v.end(), (*it)->indx);
-	  if (jt != v.end()) {
-	    v.erase(jt);
-	    success = true;
-	    break;
-	  }
-	}
+	bool success = levlist.erase((*it)->indx); // Sanity check
 
 	// Levlist sanity check
 	//
@@ -3722,11 +4814,14 @@ void Component::add_particles(int from, int to, std::vector<PartPtr>& plist)
 
   if (myid == to) {
   
+    std::vector<LevelList::Entry> arrivals;
+    arrivals.reserve(number);
+
     while (counter < number) {
 
       while (PartPtr temp=pf->RecvParticle()) {
 	particles[temp->indx] = temp;
-	insert_sorted<int>(levlist[temp->level], temp->indx);
+	arrivals.push_back({temp->indx, temp->level});
 	counter++;
       }
 
@@ -3738,14 +4833,62 @@ void Component::add_particles(int from, int to, std::vector<PartPtr>& plist)
 
     }
 
+    // Add the arrivals to the level lists in one pass
+    //
+    levlist.insert(arrivals);
+
   }
 
 }
 
 
+void Component::exchange_particles(std::vector<std::vector<PartPtr>>& send)
+{
+  // Initialize the particle ferry instance with dynamic attribute sizes
+  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib, pool));
+
+  std::vector<PartPtr> recv;
+  pf->Exchange(send, recv);
+
+  // The outgoing particles are only released once packed
+  //
+  for (auto & v : send) {
+    for (auto & p : v) {
+      if (not levlist.erase(p->indx)) {
+	std::cout << "***ERROR*** "
+		  << "Component::exchange_particles: could not find indx="
+		  << p->indx << " in levlist in any of "
+		  << multistep+1 << " levels" << std::endl;
+      }
+      particles.erase(p->indx);
+    }
+    v.clear();
+  }
+
+  std::vector<LevelList::Entry> arrivals;
+  arrivals.reserve(recv.size());
+
+  for (auto & p : recv) {
+    particles[p->indx] = p;
+    arrivals.push_back({p->indx, p->level});
+  }
+
+  levlist.insert(arrivals);
+}
+
+
 bool Component::freeze(unsigned indx)
 {
   double r2 = 0.0;
+  if (soa_active) {
+    int s = soa->active(indx);
+    if (s>=0) {
+      for (int i=0; i<3; i++) r2 +=
+				(soa->pos[i][s] - com0[i] - center[i])*
+				(soa->pos[i][s] - com0[i] - center[i]);
+      return r2 > rtrunc*rtrunc;
+    }
+  }
   for (int i=0; i<3; i++) r2 += 
 			    (particles[indx]->pos[i] - com0[i] - center[i])*
 			    (particles[indx]->pos[i] - com0[i] - center[i]);
@@ -3772,12 +4915,53 @@ double Component::Adiabatic()
 }
 
 
+void Component::first_touch()
+{
+  if (pool or particles.empty()) return;
+
+  std::vector<PartPtr> old, copy(particles.size());
+  old.reserve(particles.size());
+  for (auto & p : particles) old.push_back(p.second);
+
+  // Contiguous slices of the particle list, one per thread
+  //
+  const size_t N = old.size();
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    size_t beg = N*id/nthrds, end = N*(id+1)/nthrds;
+    for (size_t n=beg; n<end; n++)
+      copy[n] = std::make_shared<Particle>(*old[n]);
+  });
+
+  old.clear();
+  for (auto & p : copy) particles[p->indx] = p;
+}
+
 void Component::redistributeByList(vector<int>& redist)
 {
   // Initialize the particle ferry instance with dynamic attribute sizes
-  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib));
+  if (not pf) pf = ParticleFerryPtr(new ParticleFerry(niattrib, ndattrib, pool));
 
 
+  // Collect this process' outgoing particles by destination and
+  // exchange them at once
+  //
+  if (bulkferry) {
+    std::vector<std::vector<PartPtr>> send(numprocs);
+    vector<int>::iterator it = redist.begin();
+    while (it != redist.end()) {
+      int curnode = *(it++);
+      int M       = *(it++);
+      for (int m=0; m<M; m++) {
+	int indx   = *(it++);
+	int tonode = *(it++);
+	if (myid==curnode) send[tonode].push_back(particles[indx]);
+      }
+    }
+    exchange_particles(send);
+    return;
+  }
+
   vector<int>::iterator it = redist.begin();
   vector<unsigned> tlist;
 
@@ -3841,7 +5025,7 @@ Particle* Component::GetNewPart()
 {
   // Create new particle
   //
-  PartPtr newp = std::make_shared<Particle>(niattrib, ndattrib);
+  PartPtr newp = makeParticle();
 
   // Denote unsequenced particle
   //
@@ -3885,9 +5069,8 @@ void Component::seq_new_particles()
 	p->indx  = ++top_seq;
 	p->level = multistep;
 	particles[p->indx] = p;
-				// Add to level list:
-				// last element by construction
-	levlist[p->level].push_back(p->indx); 
+				// Add to level list
+	levlist.insert(p->indx, p->level);
       }
     }
 
@@ -3923,15 +5106,7 @@ void Component::DestroyPart(PartPtr p)
 
   // Remove from level list
   //
-  bool success = false;		// For sanity check . . .
-  for (auto & v : levlist) {
-    auto it = std::find(v.begin(), v.end(), p->indx);
-    if (it != v.end()) {
-      v.erase(it);
-      success = true;
-      break;
-    }
-  }
+  bool success = levlist.erase(p->indx); // For sanity check . . .
 
   // Levlist sanity check
   //
@@ -3948,6 +5123,32 @@ void Component::DestroyPart(PartPtr p)
   modified++;
 }
 
+void Component::ParticlesToSoA(unsigned mlevel, int maxlev, bool zero)
+{
+  if (not use_soa) return;
+
+  if (not soa) {
+    soa = std::make_shared<ParticleSoA>(niattrib, ndattrib);
+    soa->single = soa_float;
+  }
+
+  // Flush any previous pass that was not closed
+  //
+  if (soa_active) SoAToParticles();
+
+  unsigned hi = maxlev<0 ? multistep : std::min<unsigned>(maxlev, multistep);
+  soa->gather(particles, levlist, mlevel, hi, zero);
+  soa_active = true;
+}
+
+void Component::SoAToParticles()
+{
+  if (not soa_active) return;
+
+  soa->scatter();
+  soa_active = false;
+}
+
 void Component::AddPart(PartPtr p)
 {
   particles[p->indx] = p;
@@ -3976,3 +5177,57 @@ Eigen::Vector3d& Component::getPseudoAccel(double* pos, double* vel)
 
   return pseudo;
 }
+
+void Component::bodyCache(unsigned lo)
+{
+  const unsigned nlev = levlist.size();
+  const bool rotate = (EJ & Orient::AXIS) and not EJdryrun;
+
+  // Everything the transformation depends on besides the particle
+  //
+  std::array<double, 16> key;
+  key.fill(0.0);
+  for (int k=0; k<3; k++) {
+    if (com_system) key[k] = com0[k];
+    key[3+k] = center[k];
+  }
+  if (rotate) {
+    Eigen::Map<Eigen::Matrix3d> B(&key[6]);
+    B = orient->transformBody();
+    key[15] = 1.0;
+  }
+
+  if (posGen.size() < nlev) posGen.resize(nlev, 0);
+
+  // A new order, center or orientation invalidates every level
+  //
+  if (bodyStale or key != bodyKey or bodyOrder != levlist.generation() or
+      bodyGen.size() != nlev) {
+    bodypos.resize(3*levlist.count());
+    bodyGen.assign(nlev, std::numeric_limits<uint64_t>::max());
+    bodyKey   = key;
+    bodyOrder = levlist.generation();
+    bodyStale = false;
+  }
+
+  for (unsigned lev=lo; lev<nlev; lev++) {
+
+    if (bodyGen[lev] == posGen[lev]) continue;
+
+    const auto & L = levlist[lev];
+    const int n = L.size();
+    double* b = &bodypos[3*levlist.offset(lev)];
+
+#pragma omp parallel for
+    for (int i=0; i<n; i++) {
+      double* p = b + 3*i;
+      Pos(p, L[i], Local | Centered);
+      if (rotate) {
+	Eigen::Map<Eigen::Vector3d> P(p);
+	P = (orient->transformBody() * P).eval();
+      }
+    }
+
+    bodyGen[lev] = posGen[lev];
+  }
+}
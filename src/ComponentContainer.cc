@@ -6,9 +6,16 @@
 
 #include <algorithm>
 #include <vector>
+#include <map>
 #include <memory>
+#include <thread>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 #include <ComponentContainer.H>
+#include <SphericalBasis.H>
 #include <ExternalCollection.H>
 #include <StringTok.H>
 
@@ -17,6 +24,7 @@
 #endif
 
 #include <NVTX.H>
+#include <BurstBuffer.H>
 
 long ComponentContainer::tinterval = 300;	// Seconds between timer dumps
 
@@ -29,6 +37,7 @@ ComponentContainer::ComponentContainer(void)
   timing        = false;
   thread_timing = false;
   state         = NONE;
+  balance_wall  = 0.0;
 }
 
 void ComponentContainer::initialize(void)
@@ -49,6 +58,10 @@ void ComponentContainer::initialize(void)
   bool SPL = false;		// Indicate whether file has SPL prefix
   unsigned char ir  = 0;
   unsigned char is = 0;
+				// A checkpoint left in the burst
+				// buffer by an interrupted drain
+  if (burstdir.size()) BurstBuffer::recover(burstdir, infile);
+
 				// Look for a restart file
   if (myid==0) {
     string resfile = outdir + infile;
@@ -75,10 +88,14 @@ void ComponentContainer::initialize(void)
   restart = ir ? true : false;
   SPL     = is ? true : false;
 
+  prefetch_caches();
+
   if (restart) {
 
     struct MasterHeader master;
-    ifstream in;
+    struct DeltaHeader delta;
+    ifstream in, din;
+    int incremental = 0;
 
 				// Open file
     if (myid==0) {
@@ -89,6 +106,38 @@ void ComponentContainer::initialize(void)
 	throw FileOpenError(resfile, __FILE__, __LINE__);
       }
 
+				// An incremental checkpoint: read the
+				// bodies from its base phase space
+      unsigned long tag = 0;
+      in.read((char *)&tag, sizeof(unsigned long));
+      in.seekg(0);
+
+      if (tag == DeltaHeader::magic) {
+	in.read((char *)&delta, sizeof(DeltaHeader));
+	if (in.fail()) {
+	  std::ostringstream sout;
+	  sout << "ComponentContainer::initialize: "
+	       << "could not read incremental checkpoint header from <"
+	       << resfile << ">";
+	  throw GenericError(sout.str(), __FILE__, __LINE__);
+	}
+
+	delta.base[DeltaHeader::namesize-1] = 0;
+	resfile = delta.base;
+	std::swap(in, din);
+
+	in.open(resfile);
+	if (in.fail()) {
+	  throw FileOpenError(resfile, __FILE__, __LINE__);
+	}
+
+	cout << "Incremental checkpoint at Tnow=" << delta.time
+	     << " with base <" << resfile << ">" << endl;
+
+	incremental = 1;
+	is = delta.spl;
+      }
+
       in.read((char *)&master, sizeof(MasterHeader));
       if (in.fail()) {
 	std::ostringstream sout;
@@ -114,8 +163,25 @@ void ComponentContainer::initialize(void)
       
       ntot  = master.ntot;
       ncomp = master.ncomp;
+
+      if (incremental) {
+	if (master.time != delta.basetime or master.ncomp != delta.ncomp) {
+	  std::ostringstream sout;
+	  sout << "ComponentContainer::initialize: base phase space <"
+	       << delta.base << "> at T=" << master.time
+	       << " does not match the incremental checkpoint <"
+	       << outdir + infile << "> with base T=" << delta.basetime;
+	  throw GenericError(sout.str(), __FILE__, __LINE__);
+	}
+
+	if (not ignore_info) tnow = delta.time;
+      }
     }
 
+    MPI_Bcast(&incremental, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&is, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+    SPL = is ? true : false;
+
     MPI_Bcast(&tnow,  1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
     MPI_Bcast(&ntot,  1, MPI_INT,    0, MPI_COMM_WORLD);
@@ -132,6 +198,12 @@ void ComponentContainer::initialize(void)
 	// Could reassign "comp[ncomp] = cur" to capture defaults
       }
     }
+
+				// Apply the incremental state
+    if (incremental) {
+      for (auto c : components) c->read_delta(&din);
+      levels_restored = true;
+    }
       
     try {
       in.close();
@@ -170,11 +242,18 @@ void ComponentContainer::initialize(void)
 
   }
 
+  for (auto & t : cacheReaders) t.join();
+  cacheReaders.clear();
+
   // Sum up all bodies
   //
   ntot = 0;
   for (auto c : components) ntot += c->NewTotal();
 
+  // Rehome the particles on the pinned threads
+  //
+  if (pin_threads) for (auto c : components) c->first_touch();
+
   // Initialize interactions between components
   //
   // First, check that all listed interactions speficy a known component
@@ -437,8 +516,71 @@ void ComponentContainer::initialize(void)
 }
 
 
+void ComponentContainer::prefetch_caches()
+{
+  // The cache files of the basis forces.  Sphere and FlatDisk look
+  // for theirs in the output directory.
+  //
+  std::vector<std::string> files;
+
+  const YAML::Node comp = parse["Components"];
+
+  if (comp.IsSequence()) {
+    for (std::size_t i=0; i<comp.size(); i++) {
+      try {
+	const YAML::Node force = comp[i]["force"];
+	if (not force or not force["id"]) continue;
+
+	std::string id = force["id"].as<std::string>();
+	const YAML::Node par = force["parameters"];
+
+	if (id == "slabSL")
+	  files.push_back(".slgrid_slab_cache");
+	else if (par and par["cachename"]) {
+	  std::string name = par["cachename"].as<std::string>();
+	  if (id == "sphereSL" or id == "flatdisk") name = outdir + name;
+	  files.push_back(name);
+	}
+      }
+      catch (YAML::Exception & error) {
+	// Reported by the Component constructor
+      }
+    }
+  }
+
+  // Read on one process per node; the contents are discarded and
+  // the constructors then find the files in the page cache
+  //
+  MPI_Comm node;
+  int noderank;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myid,
+		      MPI_INFO_NULL, &node);
+  MPI_Comm_rank(node, &noderank);
+  MPI_Comm_free(&node);
+
+  if (noderank) return;
+
+  for (auto & f : files) {
+    if (not std::filesystem::exists(f)) continue;
+
+    cacheReaders.emplace_back([f]()
+    {
+      std::ifstream in(f, std::ios::binary);
+      std::vector<char> buf(1 << 22);
+      while (in.read(buf.data(), buf.size())) {}
+    });
+  }
+
+  if (myid==0 and cacheReaders.size())
+    std::cout << "---- ComponentContainer: reading " << cacheReaders.size()
+	      << " basis cache(s) ahead" << std::endl;
+}
+
+
 ComponentContainer::~ComponentContainer(void)
 {
+  for (auto & t : cacheReaders) if (t.joinable()) t.join();
+
   for (auto p1 : components) {
 #ifdef DEBUG
     cout << "Process " << myid 
@@ -453,6 +595,8 @@ ComponentContainer::~ComponentContainer(void)
 
 void ComponentContainer::compute_potential(unsigned mlevel)
 {
+  ProfRegion prof("potential L" + std::to_string(mlevel));
+
   nvTracerPtr tPtr, tPtr1;
   if (cuda_prof)
     tPtr = std::make_shared<nvTracer>("ComponentContainer::compute_potential");
@@ -501,6 +645,8 @@ void ComponentContainer::compute_potential(unsigned mlevel)
 
   for (auto c : components) {
 
+    ProfRegion prof(c->name);
+
     if (cuda_prof) {
       std::ostringstream sout; sout << "ComponentContainer, init [" << c->name << "]";
       tPtr1.reset();
@@ -512,14 +658,23 @@ void ComponentContainer::compute_potential(unsigned mlevel)
       timer_zero.start();
     }
 
+    // A self force on the contiguous particle store starts from zero
+    // outputs in the store and assigns them when the store is written
+    // back, so the particles need no zeroing pass.  The interaction
+    // and external forces that follow add to these values.
+    //
+    bool soa = c->UseSoA() and c->force->soaAware();
+    bool soa_zero = soa and not use_cuda;
+
     // BEG: zero pot and accel loop
 #if HAVE_LIBCUDA==1
     if (use_cuda) {		// GPU device version
       c->ZeroPotAccel(mlevel);
+      c->CudaInvalidate(Component::cudaAcc | Component::cudaPot);
       fetched[c] = false;
     } else
 #endif
-      {
+      if (not soa_zero) {
 				// Look for particles at this and
 				// successive levels
 	for (int lev=mlevel; lev<=multistep; lev++) {
@@ -564,8 +719,12 @@ void ComponentContainer::compute_potential(unsigned mlevel)
 
 #if HAVE_LIBCUDA==1
     if (use_cuda and not c->force->cudaAware() and not fetched[c]) {
-      c->CudaToParticles();
-      fetched[c] = true;
+      if (cuda_resident) {
+	c->CudaFetch(Component::cudaPhase | Component::cudaForce);
+      } else {
+	c->CudaToParticles();
+	fetched[c] = true;
+      }
     }
 #endif
 
@@ -579,17 +738,27 @@ void ComponentContainer::compute_potential(unsigned mlevel)
 
     if (use_cuda and not c->force->cudaAware()) {
 #if HAVE_LIBCUDA==1
-      c->CudaToParticles();
+      if (cuda_resident)
+	c->CudaFetch(Component::cudaPhase | Component::cudaForce);
+      else
+	c->CudaToParticles();
 #endif
       c->force->get_acceleration_and_potential(c);
 #if HAVE_LIBCUDA==1
-      c->ParticlesToCuda();
+      if (cuda_resident)
+	c->ParticlesFieldsToCuda(Component::cudaForce);
+      else
+	c->ParticlesToCuda();
 #endif
     } else {
+      // Use the contiguous particle store if the force supports it
+      if (soa) c->ParticlesToSoA(mlevel, -1, soa_zero);
       c->force->get_acceleration_and_potential(c);
+      if (soa) c->SoAToParticles();
     }
 
     c->time_so_far.stop();
+    c->balance_time += c->time_so_far.getTime();
     if (timing) {
       timer_accel.stop();
       timer_wait.start();
@@ -656,12 +825,51 @@ void ComponentContainer::compute_potential(unsigned mlevel)
   //   check in the cuda-aware force.
   //
 
+  // A target of more than one spherical expansion gets all of their
+  // forces in a single pass over its particles, below
+  //
+  std::map<Component*, std::vector<SphericalBasis*>> fused;
+
+  if (not use_cuda) {
+    for (auto inter : interaction) {
+      auto s = dynamic_cast<SphericalBasis*>(inter->c->force);
+      if (s and s->fusable()) {
+	for (auto other : inter->l) fused[other].push_back(s);
+      }
+    }
+
+    for (auto it=fused.begin(); it!=fused.end(); ) {
+      if (it->second.size() < 2) it = fused.erase(it);
+      else it++;
+    }
+  }
+
+  auto isFused = [&fused](Component* source, Component* target)
+  {
+    auto it = fused.find(target);
+    if (it == fused.end()) return false;
+    for (auto s : it->second) if (s == source->force) return true;
+    return false;
+  };
+
   for (auto inter : interaction) {
 				// Iterate through the list 
     for (auto other : inter->l) {
+
+      if (isFused(inter->c, other)) {
+	if (timing) itmr++;
+	continue;
+      }
+
+      ProfRegion prof(inter->c->name + " -> " + other->name);
+
 #if HAVE_LIBCUDA==1
       if (use_cuda) {
-	if (not inter->c->force->cudaAware() and not fetched[other]) {
+	if (cuda_resident) {
+	  if (not inter->c->force->cudaAware())
+	    other->CudaFetch(Component::cudaPhase | Component::cudaForce);
+	}
+	else if (not inter->c->force->cudaAware() and not fetched[other]) {
 	  if (other->force->cudaAware()) {
 	    other->CudaToParticles();
 	    fetched[other] = true;
@@ -696,6 +904,18 @@ void ComponentContainer::compute_potential(unsigned mlevel)
       inter->c->force->ClearExternal();
       other->time_so_far.stop();
 
+#if HAVE_LIBCUDA==1
+      // In resident mode, host forces are pushed back right away so
+      // that the device copy stays authoritative
+      //
+      if (use_cuda and cuda_resident) {
+	if (inter->c->force->cudaAware())
+	  other->CudaInvalidate(Component::cudaAcc | Component::cudaPot);
+	else
+	  other->ParticlesFieldsToCuda(Component::cudaForce);
+      }
+#endif
+
       if (false) {	     // Some deep debugging for playback . . .
 	std::vector<double> cen1 = inter->c->getCenter(Component::Local);
 	std::vector<double> cen2 = other->getCenter(Component::Local);
@@ -726,6 +946,20 @@ void ComponentContainer::compute_potential(unsigned mlevel)
     }
   }
 
+  for (auto & v : fused) {
+
+    ProfRegion prof("fused -> " + v.first->name);
+
+    if (timing) timer_accel.start();
+    v.first->time_so_far.start();
+
+    for (auto s : v.second) s->set_multistep_level(mlevel);
+    SphericalBasis::external_forces(v.second, v.first);
+
+    v.first->time_so_far.stop();
+    if (timing) timer_accel.stop();
+  }
+
   if (timing) timer_inter.stop();
       
 #ifdef USE_GPTL
@@ -753,34 +987,44 @@ void ComponentContainer::compute_potential(unsigned mlevel)
     timer_extrn.start();
 				// Initialize external force timers?
 				// [One for each in external force list]
-    if (external->force_list.size() != timer_sext.size()) {
+    if (external->eval_list.size() != timer_sext.size()) {
       timer_sext.clear();	// Clear the list
-      for (auto ext : external->force_list) {
+      for (auto ext : external->eval_list) {
 	timer_sext.push_back( pair<string, Timer>(ext->id, Timer()) );
       }
     }
   }
-  if (!external->force_list.empty()) {
+  if (!external->eval_list.empty()) {
     
     unsigned cnt=0;
 
     for (auto c : components) {
       c->time_so_far.start();
       if (timing) itmr = timer_sext.begin();
-      for (auto ext : external->force_list) {
+      for (auto ext : external->eval_list) {
+	ProfRegion prof(ext->id + " -> " + c->name);
 	if (timing) itmr->second.start();
 	ext->set_multistep_level(mlevel);
 
 	if (use_cuda and not ext->cudaAware()) {
 #if HAVE_LIBCUDA==1
-	  c->CudaToParticles();
+	  if (cuda_resident)	// Only the fields a host force needs
+	    c->CudaFetch(Component::cudaPhase | Component::cudaForce);
+	  else
+	    c->CudaToParticles();
 #endif
 	  ext->get_acceleration_and_potential(c);
 #if HAVE_LIBCUDA==1
-	  c->ParticlesToCuda();
+	  if (cuda_resident)
+	    c->ParticlesFieldsToCuda(Component::cudaForce);
+	  else
+	    c->ParticlesToCuda();
 #endif
 	} else {
 	  ext->get_acceleration_and_potential(c);
+#if HAVE_LIBCUDA==1
+	  if (use_cuda) c->CudaInvalidate(Component::cudaAcc | Component::cudaPot);
+#endif
 	}
 
 	if (timing) (itmr++)->second.stop();
@@ -800,6 +1044,10 @@ void ComponentContainer::compute_potential(unsigned mlevel)
   GPTLstart("ComponentContainer::centering");
 #endif
 
+  // Arrival skew of the force evaluation (barrier telemetry)
+  //
+  (*barrier)("ComponentContainer::compute_potential: forces L" +
+	     std::to_string(mlevel), __FILE__, __LINE__);
 
   if (cuda_prof) {
     tPtr1.reset();
@@ -821,6 +1069,9 @@ void ComponentContainer::compute_potential(unsigned mlevel)
   for (auto c : components) {
     c->seq_new_particles();	// Add new particles to active lists
     this->ntot += c->CurTotal();
+    memtrack.set("particles", c->name, c->Number()*
+		 (sizeof(Particle) + c->niattrib*sizeof(int) +
+		  c->ndattrib*sizeof(double)));
   }
 
   //
@@ -828,6 +1079,8 @@ void ComponentContainer::compute_potential(unsigned mlevel)
   //
   if (mactive[mstep][centerlevl]) {
 
+    ProfRegion prof("centering");
+
     if (timing) timer_posn.start();
     fix_positions();
     if (timing) timer_posn.stop();
@@ -851,11 +1104,16 @@ void ComponentContainer::compute_potential(unsigned mlevel)
 #endif
 
     //
-    // Compute angular momentum for each component
+    // Compute angular momentum for each component.  The CPU centering
+    // pass has already done this.
     //
-    if (timing) timer_angmom.start();
-    for (auto c : components) c->get_angmom();
-    if (timing) timer_angmom.stop();
+#if HAVE_LIBCUDA==1
+    if (use_cuda) {
+      if (timing) timer_angmom.start();
+      for (auto c : components) c->get_angmom();
+      if (timing) timer_angmom.stop();
+    }
+#endif
     
 #ifdef DEBUG
     cout << "Process " << myid << ": angmom computed\n";
@@ -1026,7 +1284,9 @@ void ComponentContainer::compute_potential(unsigned mlevel)
   }
 
 #if HAVE_LIBCUDA==1
-  if (use_cuda) {
+  // Host changes were already pushed in resident mode
+  //
+  if (use_cuda and not cuda_resident) {
     for (auto c : components) {
       if (fetched[c]) {
 	c->ParticlesToCuda();
@@ -1046,6 +1306,8 @@ void ComponentContainer::compute_potential(unsigned mlevel)
 
 void ComponentContainer::compute_expansion(unsigned mlevel)
 {
+  ProfRegion prof("expansion L" + std::to_string(mlevel));
+
 #ifdef USE_GPTL
   GPTLstart("ComponentContainer::compute_expansion");
 #endif
@@ -1062,8 +1324,12 @@ void ComponentContainer::compute_expansion(unsigned mlevel)
   if (use_cuda) {
     for (auto c : comp->components) {
       if (use_cuda and not c->force->cudaAware() and not fetched[c]) {
-	c->CudaToParticles();
-	fetched[c] = true;
+	if (cuda_resident) {
+	  c->CudaFetch(Component::cudaPhase);
+	} else {
+	  c->CudaToParticles();
+	  fetched[c] = true;
+	}
       } else {
 	fetched[c] = false;
       }
@@ -1071,32 +1337,110 @@ void ComponentContainer::compute_expansion(unsigned mlevel)
   }
 #endif
 
+#if HAVE_LIBCUDA==1
+  // Start the device passes of the GPU components on helper threads.
+  // Each component has its own stream, so their kernels overlap with
+  // each other and with the host passes below.  MPI stays on this
+  // thread: the launched components are finished after the others,
+  // in the same order on every process.
+  //
+  std::vector<Component*> ahead;
+  std::vector<std::thread> launchers;
+  std::vector<std::exception_ptr> errors;
+
+  if (use_cuda and cuda_concurrent) {
+    for (auto c : components) {
+      if (c->force->cudaAware() and c->force->launchesCoefficients()) {
+	c->force->set_multistep_level(mlevel);
+	ahead.push_back(c);
+      }
+    }
+
+    errors.resize(ahead.size());
+    for (size_t k=0; k<ahead.size(); k++) {
+      launchers.push_back
+	(std::thread([&, k]() {
+	  try {
+	    ProfRegion prof("launch " + ahead[k]->name);
+	    ahead[k]->force->launch_coefficients();
+	  }
+	  catch (...) {
+	    errors[k] = std::current_exception();
+	  }
+	}));
+    }
+  }
+#endif
+
   // Compute expansion for each component
   //
-  for (auto c : components) {
+  auto expand = [&](Component* c) {
+    ProfRegion prof(c->name);
 #ifdef DEBUG
     cout << "Process " << myid << ": about to compute coefficients <"
 	 << c->id << "> for mlevel=" << mlevel << endl;
 #endif
-				// Compute coefficients
+				// Compute coefficients; the reduction
+				// may complete after the remaining
+				// components have been accumulated
+    double t0 = MPI_Wtime();
+
     c->force->set_multistep_level(mlevel);
+    c->force->deferCoefficients(true);
 
     if (use_cuda and not c->force->cudaAware()) {
 #if HAVE_LIBCUDA==1
-      c->CudaToParticles();
+      if (cuda_resident)	// Coefficients only read the phase space
+	c->CudaFetch(Component::cudaPhase);
+      else
+	c->CudaToParticles();
 #endif
       c->force->determine_coefficients(c);
 #if HAVE_LIBCUDA==1
-      c->ParticlesToCuda();
+      if (not cuda_resident) c->ParticlesToCuda();
 #endif
     } else {
+      // Use the contiguous particle store if the force supports it;
+      // only the current level contributes to the coefficients
+      bool soa = c->UseSoA() and c->force->soaAware();
+      if (soa) c->ParticlesToSoA(mlevel, mlevel);
       c->force->determine_coefficients(c);
+      if (soa) c->SoAToParticles();
     }
 
+    c->force->deferCoefficients(false);
+
+    c->balance_time += MPI_Wtime() - t0;
+
 #ifdef DEBUG
     cout << "Process " << myid << ": coefficients <"
 	 << c->id << "> for mlevel=" << mlevel << " done" << endl;
 #endif
+  };
+
+#if HAVE_LIBCUDA==1
+  for (auto c : components) {
+    if (std::find(ahead.begin(), ahead.end(), c) == ahead.end()) expand(c);
+  }
+
+  for (auto & t : launchers) t.join();
+  for (auto & e : errors) if (e) std::rethrow_exception(e);
+
+  for (auto c : ahead) expand(c);
+#else
+  for (auto c : components) expand(c);
+#endif
+
+  // Arrival skew of the coefficient accumulation (barrier telemetry)
+  //
+  (*barrier)("ComponentContainer::compute_expansion: coefficients L" +
+	     std::to_string(mlevel), __FILE__, __LINE__);
+
+  // Wait for the posted coefficient reductions
+  //
+  {
+    ProfRegion prof("reduce");
+    for (auto c : components) c->force->finish_coefficients();
   }
 
 #ifdef USE_GPTL
@@ -1259,18 +1603,24 @@ void ComponentContainer::fix_positions()
     for (int k=0; k<3; k++) gcov1[k] += c->cov[k];
 
     if (c->EJ && (gottapot || restart)) {
+      ProfRegion prof("orient " + c->name);
       c->orient->accumulate(tnow, c);
       c->orient->logEntry  (tnow, c);
     }
     
   }
 
-  MPI_Barrier(MPI_COMM_WORLD);
-  mtot0 = 0.0;
-  MPI_Allreduce(&mtot1, &mtot0, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  // One reduction for the mass, com and cov
+  //
+  double buf[7] = {mtot1, gcom1[0], gcom1[1], gcom1[2],
+		   gcov1[0], gcov1[1], gcov1[2]};
+  MPI_Allreduce(MPI_IN_PLACE, buf, 7, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  mtot0 = buf[0];
   mtot = mtot0;
-  MPI_Allreduce(gcom1, gcom, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-  MPI_Allreduce(gcov1, gcov, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  for (int k=0; k<3; k++) {
+    gcom[k] = buf[1+k];
+    gcov[k] = buf[4+k];
+  }
 
   if (global_cov) {
 
@@ -1386,6 +1736,22 @@ void ComponentContainer::load_balance(void)
   MPI_Allreduce(&rates1[0], &trates[0], numprocs, 
 		MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
 
+  steptime = trates;		// For the cost-model balancer
+
+				// With barrier telemetry, use the wall
+				// time less the barrier waits instead
+  if (BarrierWrapper::telemetry) {
+    double now = MPI_Wtime(), wait = barrier->getWait();
+    if (balance_wall > 0.0) {
+      std::vector<double> waits(numprocs);
+      MPI_Allgather(&wait, 1, MPI_DOUBLE, waits.data(), 1, MPI_DOUBLE,
+		    MPI_COMM_WORLD);
+      for (int n=0; n<numprocs; n++)
+	steptime[n] = std::max<double>(now - balance_wall - waits[n], 0.0);
+    }
+    balance_wall = now;
+  }
+
 				// Compute normalized rate vector
   double norm = 0.0;
   for (int i=0; i<numprocs; i++) {
@@ -1407,6 +1773,13 @@ void ComponentContainer::load_balance(void)
   }
 #endif
 
+				// Adaptive trigger: each component
+				// decides from its own telemetry
+  if (balancehorizon>0) {
+    for (auto c : components) c->adaptive_balance(nbalance);
+    return;
+  }
+
 				// Compare relative difference with threshold
   bool toobig = false;
   double curdif;
@@ -1461,7 +1834,20 @@ void ComponentContainer::load_balance(void)
     rates = rates1;
 
 				// Initiate load balancing for each component
-    for (auto c : components) c->load_balance();
+    for (auto c : components) {
+      c->load_balance();
+      if (c->sfcorder) c->sfc_reorder();
+    }
+
+  } else {
+				// Cost-model components may be
+				// unbalanced at equal rates
+    for (auto c : components) {
+      if (c->balance != "rates" and c->cost_imbalance() > dbthresh) {
+	c->load_balance();
+	if (c->sfcorder) c->sfc_reorder();
+      }
+    }
 
   }
 
@@ -1498,3 +1884,111 @@ bool ComponentContainer::bad_values()
   }
   return bad;
 }
+
+// Warm restart file: a header followed by one record per component
+// holding its name and the bytes from its force's write_state()
+//
+static const unsigned stateMagic = 0x57524d31;
+
+void ComponentContainer::write_state(const std::string& file)
+{
+  if (myid) return;
+
+  std::string temp = file + ".tmp";
+  std::ofstream out(temp, std::ios::binary);
+  if (not out) {
+    std::cerr << "ComponentContainer::write_state: can not open <"
+	      << temp << ">" << std::endl;
+    return;
+  }
+
+  int nc = components.size();
+  out.write(reinterpret_cast<const char*>(&stateMagic), sizeof(unsigned));
+  out.write(reinterpret_cast<const char*>(&tnow),       sizeof(double));
+  out.write(reinterpret_cast<const char*>(&multistep),  sizeof(int));
+  out.write(reinterpret_cast<const char*>(&nc),         sizeof(int));
+
+  for (auto c : components) {
+    std::ostringstream sout;
+    c->force->write_state(sout);
+    std::string blob = sout.str();
+
+    unsigned nlen = c->name.size();
+    uint64_t blen = blob.size();
+    out.write(reinterpret_cast<const char*>(&nlen), sizeof(unsigned));
+    out.write(c->name.data(), nlen);
+    out.write(reinterpret_cast<const char*>(&blen), sizeof(uint64_t));
+    out.write(blob.data(), blen);
+  }
+
+  out.close();
+
+  // Replace the previous state only once this one is complete
+  //
+  if (out) std::filesystem::rename(temp, file);
+  else {
+    std::cerr << "ComponentContainer::write_state: error writing <"
+	      << temp << ">" << std::endl;
+  }
+}
+
+bool ComponentContainer::read_state(const std::string& file)
+{
+  std::ifstream in;
+  int ok = 0;
+
+  if (myid==0) {
+    in.open(file, std::ios::binary);
+    if (in) {
+      unsigned magic;
+      double time;
+      int mstep, nc;
+      in.read(reinterpret_cast<char*>(&magic), sizeof(unsigned));
+      in.read(reinterpret_cast<char*>(&time),  sizeof(double));
+      in.read(reinterpret_cast<char*>(&mstep), sizeof(int));
+      in.read(reinterpret_cast<char*>(&nc),    sizeof(int));
+      ok = in and magic==stateMagic and time==tnow and mstep==multistep and
+	nc==static_cast<int>(components.size());
+    }
+  }
+
+  MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (not ok) return false;
+
+  for (auto c : components) {
+    std::string blob;
+    uint64_t blen = 0;
+
+    if (myid==0) {
+      unsigned nlen = 0;
+      std::string name;
+      in.read(reinterpret_cast<char*>(&nlen), sizeof(unsigned));
+      if (in) {
+	name.resize(nlen);
+	in.read(&name[0], nlen);
+	in.read(reinterpret_cast<char*>(&blen), sizeof(uint64_t));
+      }
+      if (in) {
+	blob.resize(blen);
+	in.read(&blob[0], blen);
+      }
+      if (not in or name != c->name) blen = 0;
+    }
+
+    MPI_Bcast(&blen, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    if (blen==0) return false;
+
+    blob.resize(blen);
+    MPI_Bcast(&blob[0], blen, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+    std::istringstream sin(blob);
+    ok = c->force->read_state(sin);
+
+    // Every process sees the same bytes, but be safe
+    //
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (not ok) return false;
+  }
+
+  return true;
+}
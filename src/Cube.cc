@@ -5,6 +5,7 @@
 #include <cmath>
 
 #include <Cube.H>
+#include <NodeShared.H>
 
 const std::set<std::string>
 Cube::valid_keys = {
@@ -14,7 +15,9 @@ Cube::valid_keys = {
   "nmaxx",
   "nmaxy",
   "nmaxz",
-  "method"
+  "method",
+  "nufft",
+  "nuffttol"
 };
 
 //@{
@@ -32,12 +35,16 @@ Cube::Cube(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   coef_dump  = true;
   byPlanes   = true;
   cuMethod   = "planes";
+  nufft      = false;
+  nuffttol   = 1.0e-8;
 
   // Default parameter values
   //
   nminx = nminy = nminz = 0;
   nmaxx = nmaxy = nmaxz = 16;
 
+  chunk_aware = true;
+
 #if HAVE_LIBCUDA==1
   cuda_aware = true;
 #endif
@@ -53,6 +60,12 @@ Cube::Cube(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   imz   = 1 + 2*nmaxz;		// number of x wave numbers
   osize = imx * imy * imz;	// total number of coefficients
 
+  // Spreading grids and plans for the non-uniform FFT.  The force
+  // pass evaluates the potential and three acceleration components.
+  //
+  if (nufft)
+    nuft = std::make_shared<NUFFT3d>(nmaxx, nmaxy, nmaxz, nthrds, nuffttol, 4);
+
   // Allocate storage
   //
   expcoef.resize(nthrds);
@@ -84,6 +97,14 @@ Cube::Cube(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
     expcoefN[i] -> setZero();
     expcoefL[i] -> setZero();
   }
+
+  // Multistep histories, per-thread differences and accumulators and
+  // the MPI buffers
+  //
+  memtrack.set("coefficients", component->name,
+	       ((2 + nthrds)*(multistep+1) + nthrds)*osize*
+	       sizeof(std::complex<double>) +
+	       2*sz*sizeof(std::complex<double>));
     
   // Constant factors
   //
@@ -114,6 +135,8 @@ void Cube::initialize(void)
     if (conf["nmaxy" ])  nmaxy      = conf["nmaxy" ].as<int>();
     if (conf["nmaxz" ])  nmaxz      = conf["nmaxz" ].as<int>();
     if (conf["method"])  cuMethod   = conf["method"].as<std::string>();
+    if (conf["nufft" ])  nufft      = conf["nufft" ].as<bool>();
+    if (conf["nuffttol"]) nuffttol  = conf["nuffttol"].as<double>();
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in Cube: "
@@ -138,16 +161,13 @@ void * Cube::determine_coefficients_thread(void * arg)
 
   use[id] = 0;
 
-  // If we are multistepping, compute accel only at or above <mlevel>
+  // If we are multistepping, compute accel only at or above <mlevel>.
+  // The scheduler hands out ranges from these levels.
   //
-  for (int lev=mlevel; lev<=multistep; lev++) {
+  unsigned lev;
+  int nbeg, nend;
 
-    unsigned nbodies = cC->levlist[lev].size();
-
-    if (nbodies==0) continue;
-
-    int nbeg = nbodies*(id  )/nthrds;
-    int nend = nbodies*(id+1)/nthrds;
+  while (sched.next(id, lev, nbeg, nend)) {
 
     for (int q=nbeg; q<nend; q++) {
 
@@ -168,6 +188,14 @@ void * Cube::determine_coefficients_thread(void * arg)
       if (y<0.0 or y>1.0) continue;
       if (z<0.0 or z>1.0) continue;
       
+      // Spread onto this thread's grid; the sums are done by
+      // nufft_coefs()
+      //
+      if (nuft) {
+	nuft->spread(id, x, y, z, mass);
+	continue;
+      }
+
       // Recursion multipliers
       //
       std::complex<double> stepx = std::exp(-kfac*x);
@@ -206,7 +234,7 @@ void * Cube::determine_coefficients_thread(void * arg)
     }
     // END: particle loop
   }
-  // END: level loop
+  // END: chunk loop
     
   return (NULL);
 }
@@ -240,6 +268,8 @@ void Cube::determine_coefficients(void)
   use1 = 0;
   if (multistep==0) used = 0;
     
+  if (nuft) nuft->reset();
+
 #if HAVE_LIBCUDA==1
   (*barrier)("Cube::entering cuda coefficients", __FILE__, __LINE__);
   if (component->cudaDevice>=0 and use_cuda) {
@@ -267,15 +297,17 @@ void Cube::determine_coefficients(void)
 
   for (int i=1; i<nthrds; i++) expcoef[0] += expcoef[i];
   
+  if (nuft) nufft_coefs();
+
   if (multistep) {
 
-    MPI_Allreduce( expcoef[0].data(), expcoefN[mlevel]->data(),
-		   expcoef[0].size(),
-		   MPI_CXX_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+    NodeSharedComm::allreduce( expcoef[0].data(), expcoefN[mlevel]->data(),
+			       expcoef[0].size(),
+			       MPI_CXX_DOUBLE_COMPLEX, MPI_SUM);
   } else {
     
-    MPI_Allreduce( MPI_IN_PLACE, expcoef[0].data(), expcoef[0].size(),
-		   MPI_CXX_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+    NodeSharedComm::allreduce( MPI_IN_PLACE, expcoef[0].data(), expcoef[0].size(),
+			       MPI_CXX_DOUBLE_COMPLEX, MPI_SUM);
   }
 
   // Last level?
@@ -340,80 +372,160 @@ void Cube::determine_coefficients(void)
   }
 }
 
+void Cube::nufft_coefs()
+{
+  coefType F;
+  nuft->transform(F);
+
+  for (int ix=0; ix<imx; ix++) {
+    for (int iy=0; iy<imy; iy++) {
+      for (int iz=0; iz<imz; iz++) {
+
+	int ii = ix-nmaxx;
+	int jj = iy-nmaxy;
+	int kk = iz-nmaxz;
+	    
+	if (ii==0 and jj==0 and kk==0) continue;
+	    
+	double norm = 1.0/sqrt(M_PI*(ii*ii + jj*jj + kk*kk));
+	    
+	expcoef[0](ix, iy, iz) += - F(ix, iy, iz) * norm;
+      }
+    }
+  }
+}
+
+void Cube::nufft_prepare()
+{
+  // Potential and acceleration series with the same wave number
+  // selection as the direct sum in the force thread
+  //
+  std::vector<coefType> a(4);
+  for (auto & v : a) {
+    v.resize(imx, imy, imz);
+    v.setZero();
+  }
+
+  for (int ix=0; ix<imx; ix++) {
+    for (int iy=0; iy<imy; iy++) {
+      for (int iz=0; iz<imz; iz++) {
+
+	int ii = ix-nmaxx;
+	int jj = iy-nmaxy;
+	int kk = iz-nmaxz;
+	  
+	if (ii==0 && jj==0 && kk==0) continue;
+	if (abs(ii)<nminx || abs(jj)<nminy || abs(kk)<nminz) continue;
+	  
+	double norm = 1.0/sqrt(M_PI*(ii*ii + jj*jj + kk*kk));
+	std::complex<double> fac = expcoef[0](ix, iy, iz)*norm;
+
+	a[0](ix, iy, iz) = fac;
+	a[1](ix, iy, iz) = -std::complex<double>(0.0, dfac*ii)*fac;
+	a[2](ix, iy, iz) = -std::complex<double>(0.0, dfac*jj)*fac;
+	a[3](ix, iy, iz) = -std::complex<double>(0.0, dfac*kk)*fac;
+      }
+    }
+  }
+
+  nuft->prepare(a);
+}
+
+void Cube::schedule(bool coef)
+{
+  // The coefficients use the active levels; the force is evaluated
+  // for every particle
+  //
+  sched.reset(cC->levlist, coef ? mlevel : 0, multistep, nthrds, worksteal);
+}
+
 void * Cube::determine_acceleration_and_potential_thread(void * arg)
 {
-  unsigned nbodies = cC->Number();
   int id = *((int*)arg);
-  int nbeg = nbodies*id/nthrds;
-  int nend = nbodies*(id+1)/nthrds;
 
-  PartMapItr it = cC->Particles().begin();
-  unsigned long i;
+  unsigned lev;
+  int nbeg, nend;
+
+  while (sched.next(id, lev, nbeg, nend)) {
 
-  for (int q=0; q<nbeg; q++) it++;
-  for (int q=nbeg; q<nend; q++) {
+    for (int q=nbeg; q<nend; q++) {
     
-    i = it->first; it++;
+      int i = cC->levlist[lev][q];
 
-    std::complex<double> accx(0), accy(0), accz(0), dens(0), potl(0);
+      std::complex<double> accx(0), accy(0), accz(0), dens(0), potl(0);
     
-    // Get positions
-    double x = cC->Pos(i, 0);
-    double y = cC->Pos(i, 1);
-    double z = cC->Pos(i, 2);
-
-    // Recursion multipliers
-    auto stepx = std::exp(kfac*x);
-    auto stepy = std::exp(kfac*y);
-    auto stepz = std::exp(kfac*z);
+      // Get positions
+      double x = cC->Pos(i, 0);
+      double y = cC->Pos(i, 1);
+      double z = cC->Pos(i, 2);
+
+      // Interpolate the series loaded by nufft_prepare()
+      if (nuft) {
+	double f[4];
+	nuft->interpolate(x, y, z, f);
+
+	cC->AddAcc(i, 0, f[1]);
+	cC->AddAcc(i, 1, f[2]);
+	cC->AddAcc(i, 2, f[3]);
+
+	cC->AddPot(i, f[0]);
+	continue;
+      }
+
+      // Recursion multipliers
+      auto stepx = std::exp(kfac*x);
+      auto stepy = std::exp(kfac*y);
+      auto stepz = std::exp(kfac*z);
     
-    // Initial values (note sign change)
-    auto startx = std::exp(-kfac*(x*nmaxx));
-    auto starty = std::exp(-kfac*(y*nmaxy));
-    auto startz = std::exp(-kfac*(z*nmaxz));
+      // Initial values (note sign change)
+      auto startx = std::exp(-kfac*(x*nmaxx));
+      auto starty = std::exp(-kfac*(y*nmaxy));
+      auto startz = std::exp(-kfac*(z*nmaxz));
     
-    std::complex<double> facx, facy, facz;
-    int ix, iy, iz;
+      std::complex<double> facx, facy, facz;
+      int ix, iy, iz;
 
-    for (facx=startx, ix=0; ix<imx; ix++, facx*=stepx) {
-      for (facy=starty, iy=0; iy<imy; iy++, facy*=stepy) {
-	for (facz=startz, iz=0; iz<imz; iz++, facz*=stepz) {
+      for (facx=startx, ix=0; ix<imx; ix++, facx*=stepx) {
+	for (facy=starty, iy=0; iy<imy; iy++, facy*=stepy) {
+	  for (facz=startz, iz=0; iz<imz; iz++, facz*=stepz) {
 	  
-	  std::complex<double> fac = facx*facy*facz*expcoef[0](ix, iy, iz);
-	  dens += fac;
+	    std::complex<double> fac = facx*facy*facz*expcoef[0](ix, iy, iz);
+	    dens += fac;
 	  
-	  // Compute wavenumber; recall that the coefficients are
-	  // stored as follows: -nmax,-nmax+1,...,0,...,nmax-1,nmax
-	  //
-	  int ii = ix-nmaxx;
-	  int jj = iy-nmaxy;
-	  int kk = iz-nmaxz;
+	    // Compute wavenumber; recall that the coefficients are
+	    // stored as follows: -nmax,-nmax+1,...,0,...,nmax-1,nmax
+	    //
+	    int ii = ix-nmaxx;
+	    int jj = iy-nmaxy;
+	    int kk = iz-nmaxz;
 	  
-	  // No contribution to acceleration and potential ("swindle")
-	  // for zero wavenumber
-	  if (ii==0 && jj==0 && kk==0) continue;
+	    // No contribution to acceleration and potential ("swindle")
+	    // for zero wavenumber
+	    if (ii==0 && jj==0 && kk==0) continue;
 	  
-	  // Limit to minimum wave number
-	  if (abs(ii)<nminx || abs(jj)<nminy || abs(kk)<nminz) continue;
+	    // Limit to minimum wave number
+	    if (abs(ii)<nminx || abs(jj)<nminy || abs(kk)<nminz) continue;
 	  
-	  // Normalization
-	  double norm = 1.0/sqrt(M_PI*(ii*ii + jj*jj + kk*kk));;
+	    // Normalization
+	    double norm = 1.0/sqrt(M_PI*(ii*ii + jj*jj + kk*kk));;
 
-	  potl += fac*norm;
+	    potl += fac*norm;
 	  
-	  accx -= std::complex<double>(0.0, dfac*ii)*fac*norm;
-	  accy -= std::complex<double>(0.0, dfac*jj)*fac*norm;
-	  accz -= std::complex<double>(0.0, dfac*kk)*fac*norm;
+	    accx -= std::complex<double>(0.0, dfac*ii)*fac*norm;
+	    accy -= std::complex<double>(0.0, dfac*jj)*fac*norm;
+	    accz -= std::complex<double>(0.0, dfac*kk)*fac*norm;
 	  
+	  }
 	}
       }
-    }
     
-    cC->AddAcc(i, 0, accx.real());
-    cC->AddAcc(i, 1, accy.real());
-    cC->AddAcc(i, 2, accz.real());
+      cC->AddAcc(i, 0, accx.real());
+      cC->AddAcc(i, 1, accy.real());
+      cC->AddAcc(i, 2, accz.real());
+
+      cC->AddPot(i, potl.real());
+    }
 
-    cC->AddPot(i, potl.real());
   }
   
   return (NULL);
@@ -450,6 +562,8 @@ void Cube::determine_acceleration_and_potential(void)
 
   }
 
+  if (nuft) nufft_prepare();
+
 #if HAVE_LIBCUDA==1
   if (use_cuda and cC->cudaDevice>=0 and cC->force->cudaAware()) {
     if (cudaAccelOverride) {
@@ -562,8 +676,8 @@ void Cube::multistep_update_finish()
       }
   }
 
-  MPI_Allreduce (pack.data(), unpack.data(), sz, 
-		 MPI_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(pack.data(), unpack.data(), sz,
+			    MPI_DOUBLE_COMPLEX, MPI_SUM);
   
   // Update the local coefficients
   //
@@ -8,6 +8,7 @@
 #include <string>
 
 #include <CylEXP.H>
+#include <NodeShared.H>
 
 CylEXP::CylEXP(int numr, int lmax, int mmax, int nord,
 	       double ascale, double hscale, int Nodd,
@@ -81,11 +82,9 @@ void CylEXP::multistep_update_finish()
     }
   }
 
-  MPI_Allreduce (&workC1[0], &workC[0], sz,
-		 MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(&workC1[0], &workC[0], sz, MPI_DOUBLE, MPI_SUM);
 
-  MPI_Allreduce (&workS1[0], &workS[0], sz, 
-		 MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(&workS1[0], &workS[0], sz, MPI_DOUBLE, MPI_SUM);
 
   //  +--- Deep debugging
   //  |
@@ -188,6 +187,51 @@ void CylEXP::multistep_update(int from, int to, double r, double z, double phi,
 }
 
 
+void CylEXP::multistep_update_batch(int from, int to,
+				    const std::vector<double>& r,
+				    const std::vector<double>& z,
+				    const std::vector<double>& phi,
+				    const std::vector<double>& mass, int id)
+{
+  double norm = -4.0*M_PI;
+
+  // Every particle of the batch leaves level <from> and joins level
+  // <to>, so the contributions are summed once and applied to both
+  //
+  Eigen::MatrixXd SC = Eigen::MatrixXd::Zero(MMAX+1, rank3);
+  Eigen::MatrixXd SS = Eigen::MatrixXd::Zero(MMAX+1, rank3);
+  Eigen::VectorXd wc(MMAX+1), ws(MMAX+1);
+
+  for (size_t k=0; k<r.size(); k++) {
+
+    double rr = sqrt(r[k]*r[k]+z[k]*z[k]);
+    if (rr/ASCALE>Rtable) continue;
+
+    get_pot(vc[id], vs[id], r[k], z[k]);
+
+    // Azimuthal factors by recursion
+    //
+    double c1 = cos(phi[k]), s1 = sin(phi[k]), fac = norm*mass[k];
+    wc[0] = fac;
+    ws[0] = 0.0;
+    for (int mm=1; mm<=MMAX; mm++) {
+      wc[mm] = wc[mm-1]*c1 - ws[mm-1]*s1;
+      ws[mm] = ws[mm-1]*c1 + wc[mm-1]*s1;
+    }
+
+    SC.noalias() += wc.asDiagonal()*vc[id].topRows(MMAX+1);
+    SS.noalias() += ws.asDiagonal()*vs[id].topRows(MMAX+1);
+  }
+
+  differC1[id][from] -= SC;
+  differC1[id][to  ] += SC;
+
+  SS.row(0).setZero();
+  differS1[id][from] -= SS;
+  differS1[id][to  ] += SS;
+}
+
+
 
 void CylEXP::compute_multistep_coefficients(unsigned mlevel)
 {
@@ -334,3 +378,62 @@ void CylEXP::multistep_debug()
   }
 }
 
+
+void CylEXP::write_state(std::ostream& out)
+{
+  int dims[3] = {static_cast<int>(multistep), MMAX, rank3};
+  out.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+
+  // The sums over threads and processes are in the thread-0 entries
+  //
+  for (unsigned M=0; M<=multistep; M++) {
+    for (int mm=0; mm<=MMAX; mm++) {
+      out.write(reinterpret_cast<const char*>(cosL(M)[0][mm].data()),
+		rank3*sizeof(double));
+      out.write(reinterpret_cast<const char*>(cosN(M)[0][mm].data()),
+		rank3*sizeof(double));
+      if (mm) {
+	out.write(reinterpret_cast<const char*>(sinL(M)[0][mm].data()),
+		  rank3*sizeof(double));
+	out.write(reinterpret_cast<const char*>(sinN(M)[0][mm].data()),
+		  rank3*sizeof(double));
+      }
+    }
+  }
+
+  out.write(reinterpret_cast<const char*>(&cylmass), sizeof(double));
+}
+
+bool CylEXP::read_state(std::istream& in)
+{
+  int dims[3];
+  in.read(reinterpret_cast<char*>(dims), sizeof(dims));
+  if (not in or dims[0] != static_cast<int>(multistep) or
+      dims[1] != MMAX or dims[2] != rank3) return false;
+
+  if (accum_cos.size()==0) setup_accumulation();
+
+  for (unsigned M=0; M<=multistep; M++) {
+    for (int mm=0; mm<=MMAX; mm++) {
+      in.read(reinterpret_cast<char*>(cosL(M)[0][mm].data()),
+	      rank3*sizeof(double));
+      in.read(reinterpret_cast<char*>(cosN(M)[0][mm].data()),
+	      rank3*sizeof(double));
+      if (mm) {
+	in.read(reinterpret_cast<char*>(sinL(M)[0][mm].data()),
+		rank3*sizeof(double));
+	in.read(reinterpret_cast<char*>(sinN(M)[0][mm].data()),
+		rank3*sizeof(double));
+      }
+    }
+  }
+
+  in.read(reinterpret_cast<char*>(&cylmass), sizeof(double));
+  if (not in) return false;
+
+  cylmass_made = true;
+  coefs_reduced.clear();
+  std::fill(coefs_made.begin(), coefs_made.end(), true);
+
+  return true;
+}
@@ -1,5 +1,7 @@
 #include <filesystem>
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <iomanip>
 #include <sstream>
 #include <chrono>
@@ -30,6 +32,8 @@ Cylinder::valid_keys = {
   "acyl",
   "hcyl",
   "hexp",
+  "hallreuse",
+  "halltol",
   "snr",
   "evcut",
   "nmaxfid",
@@ -72,8 +76,20 @@ Cylinder::valid_keys = {
   "playback",
   "coefCompute",
   "coefMaster",
+  "coefShare",
   "pyname",
-  "dumpbasis"
+  "dumpbasis",
+  "packtable",
+  "nodeshared",
+  "batch",
+  "cudampi",
+  "asyncrecomp",
+  "mmapcache",
+  "tabtol",
+  "floattable",
+  "coefFloat",
+  "binned",
+  "sparseTol"
 };
 
 Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
@@ -123,6 +139,8 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   npca0           = 0;
   defSampT        = 1;
   hexp            = 1.0;
+  hallreuse       = 1;
+  halltol         = 0.0;
   snr             = 1.0;
   rem             = -1.0;
   self_consistent = true;
@@ -139,16 +157,32 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   nvtk            = 1;
   pcainit         = true;
   coef_dump       = true;
+  chunk_aware     = true;
   try_cache       = true;
   dump_basis      = false;
   compute         = false;
   firstime_coef   = true;
   coefMaster      = true;
+  coefShare       = false;
   lastPlayTime    = -std::numeric_limits<double>::max();
   EVEN_M          = false;
+  packtable       = true;
+  nodeshared      = false;
+  mmapcache       = false;
+  tabtol          = 0.0;
+  floattable      = false;
+  coefFloat       = false;
+  binned          = false;
+  sparseTol       = 0.0;
+  nbatch          = 64;
+  asyncrecomp     = false;
+  eofstage        = EOFStage::Idle;
+  eof_ready       = false;
+  eofaccum        = 0;
   cachename       = "";
 #if HAVE_LIBCUDA==1
   cuda_aware      = true;
+  cuda_mpi        = false;
 #endif
 
   initialize();
@@ -168,6 +202,12 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   EmpCylSL::CMAPZ       = cmapZ;
   EmpCylSL::logarithmic = logarithmic;
   EmpCylSL::VFLAG       = vflag;
+  EmpCylSL::PACKED      = packtable;
+  EmpCylSL::NODESHARED  = nodeshared;
+  EmpCylSL::MMAPCACHE   = mmapcache;
+  EmpCylSL::TABTOL      = tabtol;
+  EmpCylSL::FLOATTABLE  = floattable;
+  EmpCylSL::FLOATREDUCE = coefFloat;
 
   if (cachename.size()==0)
     throw std::runtime_error("EmpCylSL: you must specify a cachename");
@@ -176,11 +216,21 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   //
   ortho = std::make_shared<CylEXP>
     (nmaxfid, lmaxfid, mmax, nmax, acyl, hcyl, ncylodd, cachename);
+
+  // Potential, density and force tables in cos and sin on the
+  // meridional grid, and the per-thread, per-level accumulators
+  //
+  memtrack.set("basis tables", component->name,
+	       4*(2*mmax+1)*nmax*(ncylnx+1)*(ncylny+1)*
+	       (floattable ? sizeof(float) : sizeof(double)));
+  memtrack.set("coefficients", component->name,
+	       2*(nthrds+2)*(multistep+1)*(mmax+1)*nmax*sizeof(double));
   
   // Set azimuthal harmonic order restriction?
   //
   if (mlim>=0)  ortho->set_mlim(mlim);
   if (EVEN_M)   ortho->setEven(EVEN_M);
+  if (binned)   ortho->setBinned(binned);
   ortho->setSampT(defSampT);
 
   try {
@@ -337,6 +387,7 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 		<< std::endl << sep << "nvtk="        << nvtk
 		<< std::endl << sep << "npca="        << npca
 		<< std::endl << sep << "npca0="       << npca0
+		<< std::endl << sep << "hallreuse="   << hallreuse
 		<< std::endl << sep << "pcadiag="     << pcadiag
 		<< std::endl << sep << "cachename="   << cachename
 		<< std::endl << sep << "selfgrav="    << std::boolalpha << self_consistent
@@ -365,6 +416,7 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 	      << std::endl << sep << "nvtk="        << nvtk
 	      << std::endl << sep << "npca="        << npca
 	      << std::endl << sep << "npca0="       << npca0
+	      << std::endl << sep << "hallreuse="   << hallreuse
 	      << std::endl << sep << "pcadiag="     << pcadiag
 	      << std::endl << sep << "cachename="   << cachename
 	      << std::endl << sep << "selfgrav="    << std::boolalpha << self_consistent
@@ -386,6 +438,7 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 
   pos.resize(nthrds);
   frc.resize(nthrds);
+  batchwork.resize(nthrds);
 
 #ifdef DEBUG
   offgrid.resize(nthrds);
@@ -395,7 +448,9 @@ Cylinder::Cylinder(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 
 Cylinder::~Cylinder()
 {
-  // Nothing
+  // Wait for a background eigensolve to finish
+  //
+  if (eof_thread.joinable()) eof_thread.join();
 }
 
 void Cylinder::initialize()
@@ -415,6 +470,8 @@ void Cylinder::initialize()
     if (conf["acyl"      ])       acyl  = conf["acyl"      ].as<double>();
     if (conf["hcyl"      ])       hcyl  = conf["hcyl"      ].as<double>();
     if (conf["hexp"      ])       hexp  = conf["hexp"      ].as<double>();
+    if (conf["hallreuse" ])  hallreuse  = conf["hallreuse" ].as<int>();
+    if (conf["halltol"   ])    halltol  = conf["halltol"   ].as<double>();
     if (conf["snr"       ])        snr  = conf["snr"       ].as<double>();
     if (conf["evcut"     ])        rem  = conf["evcut"     ].as<double>();
     if (conf["nmaxfid"   ])    nmaxfid  = conf["nmaxfid"   ].as<int>();
@@ -452,6 +509,19 @@ void Cylinder::initialize()
     if (conf["cmapr"     ])      cmapR  = conf["cmapr"     ].as<int>();
     if (conf["cmapz"     ])      cmapZ  = conf["cmapz"     ].as<int>();
     if (conf["vflag"     ])      vflag  = conf["vflag"     ].as<int>();
+    if (conf["packtable" ])  packtable  = conf["packtable" ].as<bool>();
+    if (conf["nodeshared"]) nodeshared  = conf["nodeshared"].as<bool>();
+    if (conf["mmapcache" ])  mmapcache  = conf["mmapcache" ].as<bool>();
+    if (conf["tabtol"    ])     tabtol  = conf["tabtol"    ].as<double>();
+    if (conf["floattable"]) floattable  = conf["floattable"].as<bool>();
+    if (conf["coefFloat" ])  coefFloat  = conf["coefFloat" ].as<bool>();
+    if (conf["binned"    ])     binned  = conf["binned"    ].as<bool>();
+    if (conf["sparseTol" ])  sparseTol  = conf["sparseTol" ].as<double>();
+    if (conf["batch"     ])     nbatch  = std::max<int>(1, conf["batch"].as<int>());
+    if (conf["asyncrecomp"]) asyncrecomp = conf["asyncrecomp"].as<bool>();
+#if HAVE_LIBCUDA==1
+    if (conf["cudampi"   ])  cuda_mpi   = conf["cudampi"   ].as<bool>();
+#endif
     
     // Deprecation warning
     if (conf["expcond"]) {
@@ -507,7 +577,14 @@ void Cylinder::initialize()
 	}
       }
 
-      playback = std::dynamic_pointer_cast<CoefClasses::CylCoefs>(CoefClasses::Coefs::factory(file));
+      // Snapshots are read from H5 files on demand as playback
+      // advances
+      //
+      playback = std::dynamic_pointer_cast<CoefClasses::CylCoefs>
+	(CoefClasses::Coefs::factory(file, 1,
+				      -std::numeric_limits<double>::max(),
+				       std::numeric_limits<double>::max(),
+				      true));
 
       if (not playback) {
 	throw GenericError("Cylinder: failure in downcasting",
@@ -543,12 +620,23 @@ void Cylinder::initialize()
 
       if (conf["coefMaster"]) coefMaster = conf["coefMaster"].as<bool>();
 
+      // Each node holds the coefficients once and every process
+      // interpolates them locally, so nothing is broadcast per step
+      if (conf["coefShare"]) coefShare = conf["coefShare"].as<bool>();
+
+      if (coefShare) {
+	playback->shareSeries();
+	coefMaster = false;
+      }
+
       if (myid==0) {
 	std::cout << "---- Playback is ON for Component " << component->name
 		  << " using Force " << component->id << std::endl;
 
 	if (coefMaster)
 	  std::cout << "---- Playback will use MPI master" << std::endl;
+	if (coefShare)
+	  std::cout << "---- Playback will use node-shared coefficients" << std::endl;
 
 	if (play_cnew)
 	  std::cout << "---- New coefficients will be computed from particles on playback" << std::endl;
@@ -568,6 +656,16 @@ void Cylinder::initialize()
 			   << std::string(60, '-') << std::endl;
     throw std::runtime_error("Cylinder::initialize: error parsing YAML");
   }
+
+#if HAVE_LIBCUDA==1
+  if (cuda_mpi and not cuda_aware_mpi()) {
+    if (myid==0)
+      std::cout << "---- Cylinder: MPI library does not accept device "
+		<< "pointers; coefficients will be reduced on the host"
+		<< std::endl;
+    cuda_mpi = false;
+  }
+#endif
 }
 
 void Cylinder::get_acceleration_and_potential(Component* C)
@@ -631,8 +729,12 @@ void Cylinder::get_acceleration_and_potential(Component* C)
       ncompcyl++;
       if (ncompcyl == ncylrecomp) {
 	ncompcyl = 0;
-	eof = 1;
-	determine_coefficients();
+	if (asyncrecomp) {
+	  if (eofstage == EOFStage::Idle) eofstage = EOFStage::Requested;
+	} else {
+	  eof = 1;
+	  determine_coefficients_eof();
+	}
       }
     }
 
@@ -750,71 +852,67 @@ void * Cylinder::determine_coefficients_thread(void * arg)
 
   } else {
 
-    nbodies = cC->levlist[mlevel].size();
-    
-    if (nbodies==0) {
-      thread_timing_end(id);
-      return (NULL);
-    }
-    nbeg = nbodies*id/nthrds;
-    nend = nbodies*(id+1)/nthrds;
-
     double adb = component->Adiabatic();
 
-    for (int i=nbeg; i<nend; i++) {
+    unsigned lev;
 
-      indx = cC->levlist[mlevel][i];
+    while (sched.next(id, lev, nbeg, nend)) {
 
-      // Frozen particles don't contribute to field
-      //
-      if (cC->freeze(indx)) continue;
-    
-      for (int j=0; j<3; j++) 
-	pos[id][j] = cC->Pos(indx, j, Component::Local | Component::Centered);
+      for (int i=nbeg; i<nend; i++) {
 
-      if ( (cC->EJ & Orient::AXIS) && !cC->EJdryrun) 
-	pos[id] = cC->orient->transformBody() * pos[id];
+	indx = cC->levlist[lev][i];
 
-      xx = pos[id][0];
-      yy = pos[id][1];
-      zz = pos[id][2];
+	// Frozen particles don't contribute to field
+	//
+	if (cC->freeze(indx)) continue;
+    
+	cC->BodyPos(pos[id].data(), lev, i);
 
-      r2 = xx*xx + yy*yy;
-      r = sqrt(r2);
-      R2 = r2 + zz*zz;
+	xx = pos[id][0];
+	yy = pos[id][1];
+	zz = pos[id][2];
+
+	r2 = xx*xx + yy*yy;
+	r = sqrt(r2);
+	R2 = r2 + zz*zz;
     
-      if ( R2 < Rmax2) {
+	if ( R2 < Rmax2) {
 
-	mas = cC->Mass(indx) * adb;
-	phi = atan2(yy, xx);
+	  mas = cC->Mass(indx) * adb;
+	  phi = atan2(yy, xx);
 
-	ortho->accumulate(r, zz, phi, mas, indx, id, mlevel, compute);
+	  ortho->accumulate(r, zz, phi, mas, indx, id, mlevel, compute);
 
-	use[id]++;
-	cylmass0[id] += mas;
-	
-      } else {
+	  if (eofaccum)
+	    eofaccum->accumulate_eof(r, zz, phi, cC->Mass(indx), id, lev);
 
-	if (VERBOSE>6) {
-	  cout << "Process " << myid 
-	       << ": r^2=" << R2
-	       << " max r^2=" << Rmax2 
-	       << " r2=" << r2 
-	       << " z2=" << zz*zz 
-	       << " m=" << cylmass0[id] 
-	       << " eof=" << eof
-	       << endl;
-
-	  if (std::isnan(R2)) {
-	    cout << endl
-		 << cC->orient->transformBody() << endl
-		 << cC->orient->currentAxis()   << endl;
-	    throw GenericError("Squared radius is NaN",
-			       __FILE__, __LINE__, -1, true);
+	  use[id]++;
+	  cylmass0[id] += mas;
+	
+	} else {
+
+	  if (VERBOSE>6) {
+	    cout << "Process " << myid 
+		 << ": r^2=" << R2
+		 << " max r^2=" << Rmax2 
+		 << " r2=" << r2 
+		 << " z2=" << zz*zz 
+		 << " m=" << cylmass0[id] 
+		 << " eof=" << eof
+		 << endl;
+
+	    if (std::isnan(R2)) {
+	      cout << endl
+		   << cC->orient->transformBody() << endl
+		   << cC->orient->currentAxis()   << endl;
+	      throw GenericError("Squared radius is NaN",
+				 __FILE__, __LINE__, -1, true);
+	    }
 	  }
 	}
-      }
       
+      }
+
     }
   }
 
@@ -910,12 +1008,25 @@ void Cylinder::determine_coefficients_particles(void)
     }
   }
 
+  // Advance a background basis recomputation at the start of a full
+  // coefficient cycle
+  //
+  if (asyncrecomp and eofstage != EOFStage::Idle and
+      mlevel==0 and (multistep==0 || mstep==0) and !initializing)
+    async_eof();
+
+  eofaccum = 0;
+  if (eofstage == EOFStage::Accumulating and (multistep==0 || mstep==0))
+    eofaccum = ortho_next.get();
+
   if ( (pcavar or pcaeof) and pcainit) {
     EmpCylSL::PCAVAR = pcavar;
     EmpCylSL::PCAEOF = pcaeof;
     EmpCylSL::PCAVTK = pcavtk;
     EmpCylSL::VTKFRQ = nvtk;
     EmpCylSL::HEXP   = hexp;
+    EmpCylSL::HALLREUSE = hallreuse;
+    EmpCylSL::HALLTOL   = halltol;
     std::ostringstream sout;
     if (pcadiag) 
       sout << runtag << ".pcadiag." << cC->id << "." << cC->name;
@@ -967,6 +1078,8 @@ void Cylinder::determine_coefficients_particles(void)
   if (component->cudaDevice>=0 and use_cuda) {
     if (cudaAccumOverride) {
       component->CudaToParticles();
+      component->touchPositions();
+      cC->bodyCache(mlevel);
       exp_thread_fork(true);
     } else {
       start1 = std::chrono::high_resolution_clock::now();
@@ -976,13 +1089,18 @@ void Cylinder::determine_coefficients_particles(void)
       }
       determine_coefficients_cuda(compute);
       DtoH_coefs(mlevel);
+      if (cuda_mpi) ortho->set_coefs_reduced(mlevel);
+      if (eofaccum) determine_eof_cuda(eofaccum, mlevel, false);
       finish1 = std::chrono::high_resolution_clock::now();
     }
   } else {    
+    cC->bodyCache(mlevel);
     exp_thread_fork(true);
   }
 #else
-				// Threaded coefficient accumulation loop
+				// Body-frame positions and threaded
+				// coefficient accumulation loop
+  cC->bodyCache(mlevel);
   exp_thread_fork(true);
 #endif
 				// Accumulate counts and mass used to
@@ -1114,6 +1232,14 @@ void Cylinder::determine_coefficients_eof(void)
 
   cylmass0.resize(nthrds);
 
+#if HAVE_LIBCUDA==1
+  if (component->cudaDevice>=0 and use_cuda) {
+    std::fill(use.begin(), use.end(), 0);
+    std::fill(cylmass0.begin(), cylmass0.end(), 0.0);
+    determine_eof_cuda(ortho.get(), 0, true);
+    flush_eof_cuda();
+  } else
+#endif
 				// Threaded coefficient accumulation loop
   exp_thread_fork(true);
 
@@ -1150,6 +1276,88 @@ void Cylinder::determine_coefficients_eof(void)
 }
 
 
+void Cylinder::async_eof(void)
+{
+  switch (eofstage) {
+
+  case EOFStage::Requested:
+    // Make a new basis instance with the current parameters.  The
+    // covariance is accumulated alongside the regular coefficients in
+    // the coming cycle.
+    //
+    ortho_next = std::make_shared<CylEXP>
+      (nmaxfid, lmaxfid, mmax, nmax, acyl, hcyl, ncylodd, cachename);
+
+    if (mlim>=0)  ortho_next->set_mlim(mlim);
+    if (EVEN_M)   ortho_next->setEven(EVEN_M);
+    if (binned)   ortho_next->setBinned(binned);
+    ortho_next->setSampT(defSampT);
+    if (conf["tk_type"]) ortho_next->setTK(conf["tk_type"].as<std::string>());
+
+    ortho_next->setup_eof();
+    ortho_next->setup_accumulation();
+
+    eof_ready = false;
+    eofstage  = EOFStage::Accumulating;
+
+    if (myid==0)
+      std::cout << "Cylinder: accumulating new basis at T=" << tnow
+		<< std::endl;
+    break;
+
+  case EOFStage::Accumulating:
+    // The covariance is complete.  Reduce it and solve the
+    // eigenproblems on a helper thread on the root process while the
+    // simulation continues with the current basis.
+    //
+#if HAVE_LIBCUDA==1
+    flush_eof_cuda();
+#endif
+    ortho_next->reduce_eof();
+
+    if (myid==0) {
+      eof_thread = std::thread([this]() {
+	ortho_next->solve_eof_local();
+	eof_ready = true;
+      });
+    }
+
+    eofstage = EOFStage::Solving;
+    break;
+
+  case EOFStage::Solving:
+    {
+      int ready = eof_ready ? 1 : 0;
+      MPI_Bcast(&ready, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      if (not ready) break;
+
+      if (eof_thread.joinable()) eof_thread.join();
+
+      // Distribute the new tables and swap them in.  The coefficients
+      // for the new basis are computed in this cycle.
+      //
+      ortho_next->share_eof();
+      ortho = ortho_next;
+      ortho_next.reset();
+
+      if (pcavar or pcaeof) pcainit = true;
+#if HAVE_LIBCUDA==1
+      initialize_cuda_cyl = true;
+#endif
+      eofstage = EOFStage::Idle;
+
+      if (myid==0)
+	std::cout << "Cylinder: new basis in use at T=" << tnow
+		  << std::endl;
+    }
+    break;
+
+  default:
+    break;
+  }
+}
+
+
 void check_force_values(double phi, double p, double fr, double fz, double fp)
 {
   if (
@@ -1168,7 +1376,7 @@ void * Cylinder::determine_acceleration_and_potential_thread(void * arg)
 {
   double r, r2, r3, phi;
   double xx, yy, zz;
-  double p, p0, fr, fz, fp, pa;
+  double p, fr, pa;
 
   constexpr double ratmin = 0.75;
   constexpr double maxerf = 3.0;
@@ -1187,6 +1395,12 @@ void * Cylinder::determine_acceleration_and_potential_thread(void * arg)
 
   int id = *((int*)arg);
 
+  // Particles are evaluated in blocks of up to <nbatch>; the points
+  // on the grid are handed to EmpCylSL in one call per block
+  //
+  BatchWork & w = batchwork[id];
+  w.resize(nbatch);
+
 #ifdef DEBUG
   static bool firstime = true;
   std::ofstream out;
@@ -1196,144 +1410,181 @@ void * Cylinder::determine_acceleration_and_potential_thread(void * arg)
 
   thread_timing_beg(id);
 
-  // If we are multistepping, compute accel only at or below <mlevel>
+  // If we are multistepping, compute accel only at or below <mlevel>.
+  // The scheduler hands out ranges from these levels.
   //
-  for (unsigned lev=mlevel; lev<=multistep; lev++) {
-
-    unsigned nbodies = cC->levlist[lev].size();
+  unsigned lev;
+  int nbeg, nend;
 
-    if (nbodies==0) continue;
+  while (sched.next(id, lev, nbeg, nend)) {
 
-    int nbeg = nbodies*id/nthrds;
-    int nend = nbodies*(id+1)/nthrds;
-    
 #ifdef DEBUG
     cout << "Process " << myid << " id=" << id 
-	 << ": nbodies=" << nbodies
 	 << " lev=" << lev
 	 << " nbeg=" << nbeg
 	 << " nend=" << nend << endl;
 #endif
 
-    for (int q=nbeg; q<nend; q++) {
+    for (int q=nbeg; q<nend; ) {
 
-      unsigned indx = cC->levlist[lev][q];
+      int qbeg = q, nb = 0, ne = 0;
 
-      // Deep debug
-      /*
-      if (indx<1 || indx>cC->CurTotal()) {
-	cout << "Process " << myid << " id=" << id 
-	     << ": index error in Cylinder q=" << q
-	     << " indx=" << indx << endl;
-      }
-      */
+      // Gather the block
+      //
+      for (; q<nend and nb<nbatch; q++, nb++) {
 
-      if (mix) {
+	unsigned indx = cC->levlist[lev][q];
 
-	if (use_external) {
-	  cC->Pos(pos[id].data(), indx, Component::Inertial);
-	  component->ConvertPos(pos[id].data(), Component::Local);
-	} else
-	  cC->Pos(pos[id].data(), indx, Component::Local);
+	if (mix) {
 
-	// Only apply this fraction of the force
-	mfactor = mix->Mixture(pos[id].data());
-	for (int k=0; k<3; k++) pos[id][k] -= ctr[k];
+	  if (use_external) {
+	    cC->Pos(pos[id].data(), indx, Component::Inertial);
+	    component->ConvertPos(pos[id].data(), Component::Local);
+	  } else
+	    cC->Pos(pos[id].data(), indx, Component::Local);
 
-      } else {
+	  // Only apply this fraction of the force
+	  mfactor = mix->Mixture(pos[id].data());
+	  for (int k=0; k<3; k++) pos[id][k] -= ctr[k];
+
+	} else if (use_external) {
 
-	if (use_external) {
 	  cC->Pos(pos[id].data(), indx, Component::Inertial);
 	  component->ConvertPos(pos[id].data(), Component::Local | Component::Centered);
-	} else
-	  cC->Pos(pos[id].data(), indx, Component::Local | Component::Centered);
 
-      }
+	} else {
 
-      if ( (component->EJ & Orient::AXIS) && !component->EJdryrun) 
-	pos[id] = component->orient->transformBody() * pos[id];
+	  // Already rotated into the body frame
+	  //
+	  cC->BodyPos(pos[id].data(), lev, q);
 
-      xx    = pos[id][0];
-      yy    = pos[id][1];
-      zz    = pos[id][2];
+	}
+
+	if ( (mix or use_external) and
+	     (component->EJ & Orient::AXIS) && !component->EJdryrun) 
+	  pos[id] = component->orient->transformBody() * pos[id];
+
+	xx    = pos[id][0];
+	yy    = pos[id][1];
+	zz    = pos[id][2];
       
-      r2    = xx*xx + yy*yy;
-      r     = sqrt(r2) + DSMALL;
-      phi   = atan2(yy, xx);
-      pa    = 0.0;
-
-      ratio = sqrt( (r2 + zz*zz)/R2 );
-
-      if (ratio >= 1.0) {
-	frac       = 0.0;
-	cfrac      = 1.0;
-	frc[id][0] = 0.0;
-	frc[id][1] = 0.0;
-	frc[id][2] = 0.0;
-      } else if (ratio > ratmin) {
-	frac  = 0.5*(1.0 - erf( (ratio - midpt)/rsmth ));
-	cfrac = 1.0 - frac;
-      } else {
-	cfrac = 0.0;
-	frac  = 1.0;
-      }
+	r2    = xx*xx + yy*yy;
+	r     = sqrt(r2) + DSMALL;
+	phi   = atan2(yy, xx);
+
+	ratio = sqrt( (r2 + zz*zz)/R2 );
+
+	if (ratio >= 1.0) {
+	  frac  = 0.0;
+	  cfrac = 1.0;
+	} else if (ratio > ratmin) {
+	  frac  = 0.5*(1.0 - erf( (ratio - midpt)/rsmth ));
+	  cfrac = 1.0 - frac;
+	} else {
+	  cfrac = 0.0;
+	  frac  = 1.0;
+	}
 	
-      cfrac *= mfactor;
-      frac  *= mfactor;
+	w.indx [nb] = indx;
+	w.x    [nb] = xx;
+	w.y    [nb] = yy;
+	w.z    [nb] = zz;
+	w.r    [nb] = r;
+	w.ratio[nb] = ratio;
+	w.frac [nb] = frac  * mfactor;
+	w.cfrac[nb] = cfrac * mfactor;
+	w.slot [nb] = -1;
+
+	// Points on the grid
+	//
+	if (ratio < 1.0) {
+	  w.R  [ne] = r;
+	  w.Z  [ne] = zz;
+	  w.phi[ne] = phi;
+	  w.slot[nb] = ne++;
+	}
+      }
 
-      if (ratio < 1.0) {
+      ortho->accumulated_eval_batch(ne, w.R.data(), w.Z.data(), w.phi.data(),
+				    w.p0.data(), w.p.data(), w.fr.data(),
+				    w.fz.data(), w.fp.data());
 
-	ortho->accumulated_eval(r, zz, phi, p0, p, fr, fz, fp);
+      // Apply the forces for the block
+      //
+      for (int b=0; b<nb; b++) {
+
+	unsigned indx = w.indx[b];
+
+	xx    = w.x[b];
+	yy    = w.y[b];
+	zz    = w.z[b];
+	r     = w.r[b];
+	r2    = xx*xx + yy*yy;
+	ratio = w.ratio[b];
+	frac  = w.frac[b];
+	cfrac = w.cfrac[b];
+	pa    = 0.0;
+
+	if (ratio >= 1.0) {
+	  frc[id][0] = 0.0;
+	  frc[id][1] = 0.0;
+	  frc[id][2] = 0.0;
+	}
+
+	if (ratio < 1.0) {
+
+	  int k = w.slot[b];
 #ifdef DEBUG
-	check_force_values(phi, p, fr, fz, fp);
+	  check_force_values(w.phi[k], w.p[k], w.fr[k], w.fz[k], w.fp[k]);
 #endif
-	frc[id][0] = ( fr*xx/r - fp*yy/r2 ) * frac;
-	frc[id][1] = ( fr*yy/r + fp*xx/r2 ) * frac;
-	frc[id][2] = fz * frac;
-	pa         = p  * frac;
+	  frc[id][0] = ( w.fr[k]*xx/r - w.fp[k]*yy/r2 ) * frac;
+	  frc[id][1] = ( w.fr[k]*yy/r + w.fp[k]*xx/r2 ) * frac;
+	  frc[id][2] = w.fz[k] * frac;
+	  pa         = w.p[k]  * frac;
 	
 #ifdef DEBUG
-	flg = 1;
+	  flg = 1;
 #endif
-      }
+	}
 
-      if (ratio > ratmin) {
+	if (ratio > ratmin) {
 
-	r3 = r2 + zz*zz;
-	p = -cylmass/sqrt(r3);	// -M/r
-	fr = p/r3;		// -M/r^3
+	  r3 = r2 + zz*zz;
+	  p = -cylmass/sqrt(r3);	// -M/r
+	  fr = p/r3;		// -M/r^3
 
-	frc[id][0] += xx*fr * cfrac;
-	frc[id][1] += yy*fr * cfrac;
-	frc[id][2] += zz*fr * cfrac;
-	pa         += p     * cfrac;
+	  frc[id][0] += xx*fr * cfrac;
+	  frc[id][1] += yy*fr * cfrac;
+	  frc[id][2] += zz*fr * cfrac;
+	  pa         += p     * cfrac;
 
 #ifdef DEBUG
-	offgrid[id]++;
-	flg = 2;
+	  offgrid[id]++;
+	  flg = 2;
 #endif
-      }
+	}
     
-      cC->AddPot(indx, pa);
+	cC->AddPot(indx, pa);
 
-      if ( (component->EJ & Orient::AXIS) && !component->EJdryrun) 
-	frc[id] = component->orient->transformOrig() * frc[id];
+	if ( (component->EJ & Orient::AXIS) && !component->EJdryrun) 
+	  frc[id] = component->orient->transformOrig() * frc[id];
 
-      for (int j=0; j<3; j++) cC->AddAcc(indx, j, frc[id][j]);
+	for (int j=0; j<3; j++) cC->AddAcc(indx, j, frc[id][j]);
 
 #ifdef DEBUG
-      if (firstime && myid==0 && id==0 && q < 5) {
-	out << setw(9)  << q          << endl
-	    << setw(9)  << indx       << endl
-	    << setw(9)  << flg        << endl
-	    << setw(18) << xx         << endl
-	    << setw(18) << yy         << endl
-	    << setw(18) << zz         << endl
-	    << setw(18) << frc[0][0]  << endl
-	    << setw(18) << frc[0][1]  << endl
-	    << setw(18) << frc[0][2]  << endl;
-      }
+	if (firstime && myid==0 && id==0 && qbeg+b < 5) {
+	  out << setw(9)  << qbeg+b     << endl
+	      << setw(9)  << indx       << endl
+	      << setw(9)  << flg        << endl
+	      << setw(18) << xx         << endl
+	      << setw(18) << yy         << endl
+	      << setw(18) << zz         << endl
+	      << setw(18) << frc[0][0]  << endl
+	      << setw(18) << frc[0][1]  << endl
+	      << setw(18) << frc[0][2]  << endl;
+	}
 #endif
+      }
     }
   }
 
@@ -1378,10 +1629,16 @@ void Cylinder::determine_acceleration_and_potential(void)
   cout << "Process " << myid << ": about to fork" << endl;
 #endif
 
+  // Sum only the significant terms in the host force pass
+  //
+  ortho->set_active(sparseTol);
+
 #if HAVE_LIBCUDA==1
   if (use_cuda and cC->cudaDevice>=0 and cC->force->cudaAware()) {
     if (cudaAccelOverride) {
       cC->CudaToParticles();
+      cC->touchPositions();
+      if (not use_external and not mix) cC->bodyCache(mlevel);
       exp_thread_fork(false);
       cC->ParticlesToCuda();
     } else {
@@ -1397,12 +1654,18 @@ void Cylinder::determine_acceleration_and_potential(void)
       finish1 = std::chrono::high_resolution_clock::now();
     }
   } else {
+    if (not use_external and not mix) cC->bodyCache(mlevel);
     exp_thread_fork(false);
   }
 #else
+  // Body-frame positions for the threads
+  //
+  if (not use_external and not mix) cC->bodyCache(mlevel);
   exp_thread_fork(false);
 #endif
 
+  ortho->clear_active();
+
 #ifdef DEBUG
   cout << "Cylinder: process " << myid << " returned from fork" << endl;
   int offtot=0;
@@ -1523,7 +1786,7 @@ void Cylinder::dump_coefs(ostream& out)
 
 // Dump coefficients to an HDF5 file
 
-void Cylinder::dump_coefs_h5(const std::string& file)
+CoefClasses::CoefStrPtr Cylinder::current_coefs()
 {
   // Add the current coefficients
   auto cur = std::make_shared<CoefClasses::CylStruct>();
@@ -1557,23 +1820,38 @@ void Cylinder::dump_coefs_h5(const std::string& file)
   //
   cur->ctr = component->getCenter(Component::Local | Component::Centered);
 
+  return cur;
+}
+
+void Cylinder::dump_coefs_h5(const std::string& file)
+{
+  append_coefs_h5(file, {current_coefs()});
+}
+
+void Cylinder::append_coefs_h5(const std::string& file,
+                               const std::vector<CoefClasses::CoefStrPtr>& snaps)
+{
+  if (snaps.empty()) return;
+
+  cylCoefs.setH5Chunked(h5window, h5deflate, h5swmr);
+
   // Check if file exists
   //
   if (std::filesystem::exists(file)) {
     cylCoefs.clear();
-    cylCoefs.add(cur);
+    for (auto & c : snaps) cylCoefs.add(c);
     cylCoefs.ExtendH5Coefs(file);
   } else {
     // Copy the YAML config.  We only need this on the first call.
     std::ostringstream sout; sout << conf;
-    cur->buf = sout.str();	// Copy to CoefStruct buffer
+    snaps.front()->buf = sout.str(); // Copy to CoefStruct buffer
 
     // Add the name attribute.  We only need this on the first call.
     cylCoefs.setName(component->name);
 
     // Add the new coefficients and write the new HDF5
     cylCoefs.clear();
-    cylCoefs.add(cur);
+    for (auto & c : snaps) cylCoefs.add(c);
     cylCoefs.WriteH5Coefs(file);
   }
 }
@@ -1665,6 +1943,38 @@ void Cylinder::multistep_update(int from, int to, Component* c, int i, int id)
 #endif
 }
 
+void Cylinder::multistep_update_batch(int from, int to, Component* c,
+				      const std::vector<int>& idx, int id)
+{
+  if (play_back)        return;
+  if (!self_consistent) return;
+
+  std::vector<double> R, Z, Phi, Mass;
+  R.reserve(idx.size());
+  Z.reserve(idx.size());
+  Phi.reserve(idx.size());
+  Mass.reserve(idx.size());
+
+  for (auto i : idx) {
+    if (c->freeze(i)) continue;
+
+    double xx = c->Pos(i, 0, Component::Local | Component::Centered);
+    double yy = c->Pos(i, 1, Component::Local | Component::Centered);
+    double zz = c->Pos(i, 2, Component::Local | Component::Centered);
+
+    R   .push_back(sqrt(xx*xx + yy*yy));
+    Z   .push_back(zz);
+    Phi .push_back(atan2(yy, xx));
+    Mass.push_back(c->Mass(i) * component->Adiabatic());
+  }
+
+  ortho->multistep_update_batch(from, to, R, Z, Phi, Mass, id);
+
+#ifdef CYL_UPDATE_TABLE
+  occt[from][to] += R.size();
+#endif
+}
+
 void Cylinder::compute_multistep_coefficients() 
 {
   if (play_back and not play_cnew) return;
@@ -1688,6 +1998,85 @@ void Cylinder::multistep_reset()
 }
 
 
+void Cylinder::write_state(std::ostream& out)
+{
+  // A background recomputation has no consistent state to save
+  //
+  char ok = eofstage == EOFStage::Idle and not (play_back and not play_cnew);
+  out.write(&ok, 1);
+  if (not ok) return;
+
+  out.write(reinterpret_cast<const char*>(&ncompcyl), sizeof(int));
+  out.write(reinterpret_cast<const char*>(&cylmass),  sizeof(double));
+  out.write(reinterpret_cast<const char*>(&resetT),   sizeof(double));
+
+  // The cache is rewritten by every recomputation, so it may be newer
+  // than the particles by the time of the restart: keep a copy
+  //
+  std::string cache;
+  if (ncylrecomp>0) {
+    std::ifstream in(cachename, std::ios::binary);
+    cache.assign(std::istreambuf_iterator<char>(in),
+		 std::istreambuf_iterator<char>());
+  }
+
+  uint64_t len = cache.size();
+  out.write(reinterpret_cast<const char*>(&len), sizeof(uint64_t));
+  out.write(cache.data(), len);
+
+  ortho->write_state(out);
+}
+
+bool Cylinder::read_state(std::istream& in)
+{
+  char ok = 0;
+  in.read(&ok, 1);
+  if (not in or not ok) return false;
+
+  int ncomp;
+  double cmass, rT;
+  uint64_t len;
+
+  in.read(reinterpret_cast<char*>(&ncomp), sizeof(int));
+  in.read(reinterpret_cast<char*>(&cmass), sizeof(double));
+  in.read(reinterpret_cast<char*>(&rT),    sizeof(double));
+  in.read(reinterpret_cast<char*>(&len),   sizeof(uint64_t));
+
+  std::string cache(len, '\0');
+  in.read(&cache[0], len);
+  if (not in) return false;
+
+  // Reinstate the basis of the checkpoint
+  //
+  if (len) {
+    if (myid==0) {
+      std::ofstream out(cachename, std::ios::binary);
+      out.write(cache.data(), len);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  if (len or (not precond and firstime)) {
+    if (not ortho->read_cache()) {
+      if (myid==0)
+	std::cerr << "Cylinder: can not read cache file on restart" << endl;
+      throw std::runtime_error("Cylinder: cache read error");
+    }
+    eof = 0;
+    firstime = false;
+  }
+
+  if (not ortho->read_state(in)) return false;
+
+  ncompcyl      = ncomp;
+  cylmass       = cmass;
+  resetT        = rT;
+  firstime_coef = false;
+
+  return true;
+}
+
+
 static int idbg = 0;
 void Cylinder::multistep_debug() 
 {
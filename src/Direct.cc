@@ -18,7 +18,8 @@ Direct::valid_keys = {
   "pm_model",
   "diverge",
   "diverge_rfac",
-  "pmmodel_file"
+  "pmmodel_file",
+  "allgather"
 };
 
 Direct::Direct(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
@@ -43,9 +44,15 @@ Direct::Direct(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   diverge      = 0;	            // Use analytic divergence (true/false)
   diverge_rfac = 1.0;               // Exponent for profile divergence
 
+  allgather    = false;		    // Use the ring by default
+
   initialize();
 
-  if (pm_model) pmmodel = new SphericalModelTable(pmmodel_file, diverge, diverge_rfac);
+  if (pm_model) {
+    pmmodel = new SphericalModelTable(pmmodel_file, diverge, diverge_rfac);
+    pm_rmax = pmmodel->get_max_radius();
+    pm_mtot = pmmodel->get_mass(pm_rmax);
+  }
 
 				// Assign the ring topology
   to_proc = (myid+1) % numprocs;
@@ -100,6 +107,8 @@ void Direct::initialize(void)
     if (conf["diverge"])          diverge      = conf["diverge"].as<int>();
     if (conf["diverge_rfac"])     diverge_rfac = conf["diverge_rfac"].as<double>();
     if (conf["pmmodel_file"])     pmmodel_file = conf["pmmodel_file"].as<std::string>();
+
+    if (conf["allgather"])        allgather    = conf["allgather"].as<bool>();
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in Direct: "
@@ -157,11 +166,13 @@ void Direct::determine_acceleration_and_potential(void)
   delete [] bod_buffer;
 
   int buffer_size = max_bodies*ndim;
+  if (allgather) buffer_size = used*ndim;
+
   tmp_buffer = new double [buffer_size];
   bod_buffer = new double [buffer_size];
   
   // Load body buffer with local interactors
-  double *p = bod_buffer;
+  double *p = allgather ? tmp_buffer : bod_buffer;
   unsigned long i;
   PartMapItr it = component->Particles().begin();
 
@@ -174,47 +185,194 @@ void Direct::determine_acceleration_and_potential(void)
     if (!fixed_soft) *(p++) = component->Part(i)->dattrib[soft_indx];
   }
 
-				// Do the local interactors
-  exp_thread_fork(false);
+  // Small components: gather every body on every process and skip
+  // the ring
+  //
+  if (allgather) {
+    std::vector<int> cnts(numprocs), disp(numprocs, 0);
+    int nsend = ninteract*ndim;
+    MPI_Allgather(&nsend, 1, MPI_INT, cnts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    for (int n=1; n<numprocs; n++) disp[n] = disp[n-1] + cnts[n-1];
+
+    MPI_Allgatherv(tmp_buffer, nsend, MPI_DOUBLE,
+		   bod_buffer, cnts.data(), disp.data(), MPI_DOUBLE,
+		   MPI_COMM_WORLD);
+
+    ninteract = used;
+    stage_sources();
+    exp_thread_fork(false);
 
-				// Do the ring . . . 
-  for (int n=1; n<numprocs; n++) {
-      
-    MPI_Request req1, req2;
-    MPI_Status stat;
-    
-				// Copy current to temp buffer
-    memcpy(tmp_buffer, bod_buffer, buffer_size*sizeof(double));
+    use_external = false;
+    return;
+  }
 
-				// Get NEW buffer from right
-    MPI_Irecv(bod_buffer, buffer_size, MPI_DOUBLE, from_proc, MSGTAG, 
-	      MPI_COMM_WORLD, &req1);
+  // The ring is double buffered: the bodies for the next hop are in
+  // flight to tmp_buffer while the threads work on bod_buffer
+  //
+  for (int n=0; n<numprocs; n++) {
 
-				// Send OLD buffer to left
-    MPI_Isend(tmp_buffer, ninteract*ndim, MPI_DOUBLE, to_proc, MSGTAG, 
-	      MPI_COMM_WORLD, &req2);
+    MPI_Request req[2];
+    bool hop = n < numprocs-1;
 
-    MPI_Wait(&req2, &stat);
-    MPI_Wait(&req1, &stat);
+    if (hop) {
+				// Get NEW buffer from right
+      MPI_Irecv(tmp_buffer, buffer_size, MPI_DOUBLE, from_proc, MSGTAG, 
+		MPI_COMM_WORLD, &req[0]);
 
-				// How many particles did we get?
-    MPI_Get_count(&stat, MPI_DOUBLE, &ninteract);
-    ninteract /= ndim;
-	
+				// Send current buffer to left
+      MPI_Isend(bod_buffer, ninteract*ndim, MPI_DOUBLE, to_proc, MSGTAG, 
+		MPI_COMM_WORLD, &req[1]);
+    }
 				// Accumulate the interactions
+    stage_sources();
     exp_thread_fork(false);
 
+    if (hop) {
+      MPI_Status stat[2];
+      MPI_Waitall(2, req, stat);
+
+				// How many particles did we get?
+      MPI_Get_count(&stat[0], MPI_DOUBLE, &ninteract);
+      ninteract /= ndim;
+
+      std::swap(bod_buffer, tmp_buffer);
+    }
   }
 				// Clear external potential flag
   use_external = false;
 }
 
+void Direct::stage_sources()
+{
+  src_m.resize(ninteract);
+  src_x.resize(ninteract);
+  src_y.resize(ninteract);
+  src_z.resize(ninteract);
+  src_e.resize(ninteract, soft);
+
+  double *p = bod_buffer;
+  for (int n=0; n<ninteract; n++) {
+    src_m[n] = *(p++);
+    src_x[n] = *(p++);
+    src_y[n] = *(p++);
+    src_z[n] = *(p++);
+    src_e[n] = fixed_soft ? soft : *(p++);
+  }
+}
+
+template<class K>
+void * Direct::tiled_interactions(const K& kern, int id)
+{
+  alignas(64) double x[tile_size], y[tile_size], z[tile_size];
+  alignas(64) double ax[tile_size], ay[tile_size], az[tile_size];
+  alignas(64) double pt[tile_size];
+  unsigned long indx[tile_size];
+
+  const double *sm = src_m.data(), *se = src_e.data();
+  const double *sx = src_x.data(), *sy = src_y.data(), *sz = src_z.data();
+
+#ifdef DEBUG
+  double tclausius = 0.0;
+  unsigned ncnt = 0;
+#endif
+
+  double adb = component->Adiabatic();
+
+  // If we are multistepping, compute accel only at or above <mlevel>
+  //
+  for (int lev=mlevel; lev<=multistep; lev++) {
+
+    unsigned nbodies = cC->levlist[lev].size();
+    int nbeg = nbodies*id/nthrds;
+    int nend = nbodies*(id+1)/nthrds;
+
+    int i = nbeg;
+    while (i<nend) {
+				// Stage the next tile of local particles
+      int nt = 0;
+      for (; i<nend and nt<tile_size; i++) {
+	unsigned long j = cC->levlist[lev][i];
+				// Don't need acceleration for frozen particles
+	if (cC->freeze(j)) continue;
+
+	indx[nt] = j;
+	x[nt] = cC->Pos(j, 0);
+	y[nt] = cC->Pos(j, 1);
+	z[nt] = cC->Pos(j, 2);
+	ax[nt] = ay[nt] = az[nt] = pt[nt] = 0.0;
+	nt++;
+      }
+				// Sum the ring buffer bodies over the tile
+      for (int n=0; n<ninteract; n++) {
+	const double mass = sm[n] * adb, eps = se[n];
+	const double px = sx[n], py = sy[n], pz = sz[n];
+
+#pragma omp simd
+	for (int t=0; t<nt; t++) {
+	  double dx = x[t] - px;
+	  double dy = y[t] - py;
+	  double dz = z[t] - pz;
+	  double rr = sqrt(dx*dx + dy*dy + dz*dz);
+
+	  // Reject particle at current location by zeroing its mass
+	  // so that the loop has no branches
+	  //
+	  bool   use  = rr>rtol;
+	  double rs   = use ? rr : 1.0;
+	  double ms   = use ? mass : 0.0;
+	  auto   f    = kern.eval(rs, eps);
+	  double rfac = ms * f.first/(rs*rs*rs);
+
+	  ax[t] -= dx * rfac;
+	  ay[t] -= dy * rfac;
+	  az[t] -= dz * rfac;
+	  pt[t] += ms * f.second;
+	}
+      }
+				// Return the tile sums to the particles
+      for (int t=0; t<nt; t++) {
+	cC->AddAcc(indx[t], 0, ax[t]);
+	cC->AddAcc(indx[t], 1, ay[t]);
+	cC->AddAcc(indx[t], 2, az[t]);
+	cC->AddPot(indx[t], pt[t]);
+#ifdef DEBUG
+	tclausius += ax[t]*x[t] + ay[t]*y[t] + az[t]*z[t];
+#endif
+      }
+#ifdef DEBUG
+      ncnt += nt*ninteract;
+#endif
+    }
+  }
+
+#ifdef DEBUG
+  if (use_external) {
+    pthread_mutex_lock(&iolock);
+    cout << "Process " << myid << ", id=" << id << ": ninteract=" << ninteract
+	 << "  nexternal=" << ncnt << "  VC=" << tclausius << endl;
+    pthread_mutex_unlock(&iolock);
+  }
+#endif
+
+  return (NULL);
+}
+
 void * Direct::determine_acceleration_and_potential_thread(void * arg)
 {
   double pos[3], eps = soft;
 
   int id = *((int*)arg);
 
+  // Point-mass interactions use the tiled summation with the
+  // smoothing kernel fixed at compile time
+  //
+  if (not mn_model and not pm_model) {
+    if (auto k = dynamic_cast<SplineSoft*>(kernel.get()))
+      return tiled_interactions(*k, id);
+    if (auto k = dynamic_cast<PlummerSoft*>(kernel.get()))
+      return tiled_interactions(*k, id);
+  }
+
 #ifdef DEBUG
   double tclausius[nthrds];
   for (int i=0; i<nthrds; i++) tclausius[id] = 0.0;
@@ -309,10 +467,9 @@ void * Direct::determine_acceleration_and_potential_thread(void * arg)
                                 // Given model provides normalized mass distrbution
 	    double pot = 0.0;
 	  
-	    if (pm_model && pmmodel->get_max_radius() > rr) {
-	      double mass_frac =
-		pmmodel->get_mass(rr) / pmmodel->get_mass(pmmodel->get_max_radius());
-	      pot = pmmodel->get_pot(rr)/pmmodel->get_mass(pmmodel->get_max_radius());
+	    if (pm_model && pm_rmax > rr) {
+	      double mass_frac = pmmodel->get_mass(rr) / pm_mtot;
+	      pot = pmmodel->get_pot(rr) / pm_mtot;
 	      mass *= mass_frac;
 	    } else {
 	      auto y = (*kernel)(rr, eps);
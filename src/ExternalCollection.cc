@@ -13,6 +13,7 @@
 #include <string> 
 
 #include <ExternalCollection.H>
+#include <ExternalComposite.H>
 
 #include <tidalField.H>
 #include <externalShock.H>
@@ -119,9 +120,51 @@ void ExternalCollection::initialize()
 		<< std::string(72, '-') << std::endl;
   }
 
+  make_eval_list();
+
   (*barrier)("ExternalCollection::initialize: FINISH", __FILE__, __LINE__);
 }
 
+void ExternalCollection::make_eval_list()
+{
+  eval_list.clear();
+
+  // The composite is a host force, so leave device-aware forces alone
+  //
+  auto fusable = [](ExternalForce *f)
+  {
+    return fuse_external and f->batchAware() and
+      not (use_cuda and f->cudaAware());
+  };
+
+  std::vector<ExternalForce*> run;
+
+  auto flush = [&]()
+  {
+    if (run.size()==1) {
+      eval_list.push_back(run[0]);
+    } else if (run.size()>1) {
+      ExternalForce *f = new ExternalComposite(run);
+      composites.push_back(f);
+      eval_list.push_back(f);
+      if (myid==0)
+	std::cout << "---- ExternalCollection: " << f->id
+		  << " evaluated in a single pass" << std::endl;
+    }
+    run.clear();
+  };
+
+  for (auto f : force_list) {
+    if (fusable(f)) {
+      run.push_back(f);
+    } else {
+      flush();
+      eval_list.push_back(f);
+    }
+  }
+  flush();
+}
+
 ExternalCollection::~ExternalCollection(void)
 {
 
@@ -137,6 +180,8 @@ ExternalCollection::~ExternalCollection(void)
 #endif
   }
 
+  for (auto f : composites) delete f;
+
 				// close all the dynamic libs we opened
   i = 0;
   for(itr=dl_list.begin(); itr!=dl_list.end(); itr++) {
@@ -0,0 +1,100 @@
+#include "expand.H"
+
+#include <ExternalComposite.H>
+
+// PotAccel keeps a reference to its configuration
+//
+static const YAML::Node empty_conf;
+
+ExternalComposite::ExternalComposite(const std::vector<ExternalForce*>& forces) :
+  ExternalForce(empty_conf), members(forces)
+{
+  id = "Composite[";
+  for (size_t n=0; n<members.size(); n++) {
+    if (n) id += ", ";
+    id += members[n]->id;
+  }
+  id += "]";
+
+  chunk_aware = true;		// Ranges come from sched
+  soa_aware   = true;		// Particles only through the accessors
+}
+
+void ExternalComposite::determine_acceleration_and_potential(void)
+{
+  active.clear();
+  for (auto f : members) {
+    if (f->batch_begin(cC)) active.push_back(f);
+  }
+
+  if (active.empty()) return;
+
+#if HAVE_LIBCUDA==1		// Cuda compatibility
+  getParticlesCuda(cC);
+#endif
+
+  exp_thread_fork(false);
+
+  print_timings(id + ": acceleration timings");
+}
+
+
+void * ExternalComposite::determine_acceleration_and_potential_thread(void * arg)
+{
+  int id = *((int*)arg);
+
+  thread_timing_beg(id);
+
+  std::vector<double> x(bsize), y(bsize), z(bsize);
+  std::vector<double> ax(bsize), ay(bsize), az(bsize), pot(bsize);
+  std::vector<int> indx(bsize);
+
+  // Levels mlevel through multistep, as handed out by the scheduler
+  //
+  unsigned lev;
+  int nbeg, nend;
+
+  while (sched.next(id, lev, nbeg, nend)) {
+
+    for (int q0=nbeg; q0<nend; q0+=bsize) {
+
+      int n = std::min<int>(bsize, nend - q0);
+
+      // Gather
+      //
+      for (int j=0; j<n; j++) {
+	int i = indx[j] = cC->levlist[lev][q0+j];
+	x[j] = cC->Pos(i, 0);
+	y[j] = cC->Pos(i, 1);
+	z[j] = cC->Pos(i, 2);
+      }
+
+      std::fill(ax.begin(),  ax.begin()  + n, 0.0);
+      std::fill(ay.begin(),  ay.begin()  + n, 0.0);
+      std::fill(az.begin(),  az.begin()  + n, 0.0);
+      std::fill(pot.begin(), pot.begin() + n, 0.0);
+
+      // Evaluate
+      //
+      for (auto f : active)
+	f->eval_batch(n, x.data(), y.data(), z.data(),
+		      ax.data(), ay.data(), az.data(), pot.data());
+
+      // Scatter
+      //
+      for (int j=0; j<n; j++) {
+	int i = indx[j];
+	cC->AddAccExt(i, 0, ax[j]);
+	cC->AddAccExt(i, 1, ay[j]);
+	cC->AddAccExt(i, 2, az[j]);
+	cC->AddPotExt(i, pot[j]);
+      }
+
+      use[id] += n;
+    }
+  }
+
+  thread_timing_end(id);
+
+  return (NULL);
+}
@@ -4,7 +4,7 @@
 
 ExternalForce::ExternalForce(const YAML::Node& conf) : PotAccel(0, conf)
 {
-				// Do nothing
+  batch_aware = false;
 }
 
 void ExternalForce::get_acceleration_and_potential(Component *C)
@@ -59,7 +59,9 @@ void ExternalForce::print_divider(void)
 void ExternalForce::getParticlesCuda(Component *c)
 {
   if (use_cuda and not cudaAware()) {
-    if (not comp->fetched[c]) {
+    if (cuda_resident) {
+      c->CudaFetch(Component::cudaPhase | Component::cudaForce);
+    } else if (not comp->fetched[c]) {
       c->CudaToParticles();
       comp->fetched[c] = true;
     }
@@ -103,11 +103,17 @@ void FlatDisk::initialize()
     throw std::runtime_error("FlatDisk::initialize: error in parsing YAML");
   }
 
+  // Threads for the EmpCyl2d tables
+  EmpCyl2d::threads = nthrds;
+
   // Create the BiorthCyl instance
   ortho = std::make_shared<BiorthCyl>(conf);
 
   if (dump_basis) ortho->dump_basis(runtag);
 
+  // Per-thread density work space for the fused evaluation
+  dscr.resize(nthrds);
+
   // Set background model
   if (M0_back) setBackground();
 }
@@ -209,9 +215,7 @@ void FlatDisk::get_dpotl(double r, double z,
 			 Eigen::MatrixXd& dpr,
 			 Eigen::MatrixXd& dpz, int tid)
 {
-  ortho->get_pot   (p,   r, z);
-  ortho->get_rforce(dpr, r, z);
-  ortho->get_zforce(dpz, r, z);
+  ortho->get_all(dscr[tid], p, dpr, dpz, r, z);
 }
 
 void FlatDisk::get_potl(double r, double z, Eigen::MatrixXd& p, int tid)
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <fstream>
 #include <string>
+#include <algorithm>
 
 #ifdef USE_DMALLOC
 #include <dmalloc.h>
@@ -85,7 +86,7 @@ HaloBulge::HaloBulge(const YAML::Node& conf) : ExternalForce(conf)
 
 void * HaloBulge::determine_acceleration_and_potential_thread(void * arg)
 {
-  double r, potl, dpot, potlB, dpotB;
+  const int bsize = 256;
 
   unsigned nbodies = cC->Number();
   int id = *((int*)arg);
@@ -93,28 +94,40 @@ void * HaloBulge::determine_acceleration_and_potential_thread(void * arg)
   int nend = nbodies*(id+1)/nthrds;
 
   PartMapItr it = cC->Particles().begin();
-  unsigned long i;
+  std::advance(it, nbeg);
 
-  for (int q=nbeg; q<nend; q++) {
+  std::vector<unsigned long> indx(bsize);
+  std::vector<double> r(bsize), rh(bsize), rb(bsize);
+  std::vector<double> potl(bsize), dpot(bsize), potlB(bsize), dpotB(bsize);
 
-    i = it->first; it++;
+  // Evaluate the two profiles a block of bodies at a time
+  //
+  for (int q0=nbeg; q0<nend; q0+=bsize) {
+
+    int n = std::min<int>(bsize, nend - q0);
 
-    r = 0.0;
-    for (int k=0; k<3; k++) r += cC->Pos(i, k)*cC->Pos(i, k);
-    r = sqrt(r);
+    for (int j=0; j<n; j++) {
+      unsigned long i = indx[j] = (it++)->first;
+      double rr = 0.0;
+      for (int k=0; k<3; k++) rr += cC->Pos(i, k)*cC->Pos(i, k);
+      r[j]  = sqrt(rr);
+      rh[j] = r[j]/RHALO;
+      rb[j] = r[j]/RBULGE;
+    }
 
-    model->get_pot_dpot(r/RHALO, potl, dpot);
-    potl *= MHALO/RHALO;
-    dpot *= MHALO/RHALO/RHALO;
+    model ->get_pot_dpot_batch(rh.data(), n, potl.data(),  dpot.data());
+    bmodel->get_pot_dpot_batch(rb.data(), n, potlB.data(), dpotB.data());
 
-    bmodel->get_pot_dpot(r/RBULGE, potlB, dpotB);
-    potlB *= MBULGE/RBULGE;
-    dpotB *= MBULGE/RBULGE/RBULGE;
+    for (int j=0; j<n; j++) {
+      unsigned long i = indx[j];
 
-    for (int k=0; k<3; k++)
-      cC->AddAcc(i, k, -(dpot + dpotB)*cC->Pos(i, k)/r );
-    cC->AddPotExt(i,  potl + potlB );
+      double pot  = potl[j]*MHALO/RHALO + potlB[j]*MBULGE/RBULGE;
+      double dpt  = dpot[j]*MHALO/RHALO/RHALO + dpotB[j]*MBULGE/RBULGE/RBULGE;
 
+      for (int k=0; k<3; k++)
+	cC->AddAcc(i, k, -dpt*cC->Pos(i, k)/r[j] );
+      cC->AddPotExt(i, pot );
+    }
   }
 
   return (NULL);
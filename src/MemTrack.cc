@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include <MemTrack.H>
+
+void MemTrack::set(const std::string& subsystem, const std::string& owner,
+		   size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(lock);
+
+  auto & e = tags[subsystem + "/" + owner];
+
+  total      = total - e.current + bytes;
+  total_peak = std::max<size_t>(total_peak, total);
+  e.current  = bytes;
+  e.peak     = std::max<size_t>(e.peak, bytes);
+}
+
+void MemTrack::print(std::ostream& out)
+{
+  std::vector<std::pair<std::string, Entry>> list;
+  size_t cur, pk;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    list.assign(tags.begin(), tags.end());
+    cur = total;
+    pk  = total_peak;
+  }
+
+  std::sort(list.begin(), list.end(),
+	    [](const auto& a, const auto& b)
+	    { return a.second.current > b.second.current; });
+
+  const double MB = 1024.0*1024.0;
+
+  out << std::setw(40) << std::left << "Tracked memory [MB]"
+      << std::setw(14) << std::right << "Current"
+      << std::setw(14) << std::right << "Peak" << std::endl
+      << std::string(68, '-') << std::endl;
+
+  for (auto & v : list)
+    out << std::setw(40) << std::left  << v.first
+	<< std::setw(14) << std::right << std::fixed << std::setprecision(2)
+	<< v.second.current/MB
+	<< std::setw(14) << std::right << v.second.peak/MB << std::endl;
+
+  out << std::string(68, '-') << std::endl
+      << std::setw(40) << std::left  << "Total"
+      << std::setw(14) << std::right << cur/MB
+      << std::setw(14) << std::right << pk/MB << std::endl
+      << std::defaultfloat << std::setprecision(6);
+}
@@ -3,6 +3,10 @@
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 #include <expand.H>
 
@@ -21,6 +25,7 @@ OrbTrace::valid_keys = {
   "use_pot",
   "use_lev",
   "local",
+  "buffer",
   "name"
 };
 
@@ -35,6 +40,8 @@ OrbTrace::OrbTrace(const YAML::Node& conf) : Output(conf)
   use_pot = false;
   use_lev = false;
   local   = false;
+  buffer  = 0;
+  nslot   = 0;
 
   filename = outdir + "ORBTRACE." + runtag;
   orbitlist = "";
@@ -99,7 +106,13 @@ OrbTrace::OrbTrace(const YAML::Node& conf) : Output(conf)
 
   pbuf = vector<double>(nbuf);
 
-  if (myid==0 && norb) {
+  if (buffer) {
+				// Buffered binary output
+    binfile = filename + ".bin";
+    if (myid==0 && norb) open_binary();
+    make_slots();
+
+  } else if (myid==0 && norb) {
 
     if (restart) {
       
@@ -228,6 +241,7 @@ void OrbTrace::initialize()
     if (conf["use_pot"])     use_pot   = conf["use_pot"].as<bool>();
     if (conf["use_lev"])     use_lev   = conf["use_lev"].as<bool>();
     if (conf["local"])       local     = conf["local"].as<bool>();
+    if (conf["buffer"])      buffer    = conf["buffer"].as<unsigned>();
     
 				// Sanity check
     if (nintsub <= 0) nintsub = 1;
@@ -254,9 +268,19 @@ void OrbTrace::initialize()
 
 void OrbTrace::Run(int n, int mstep, bool last)
 {
-  if (n % nint && !last && !tcomp && norb) return;
-  if (mstep % nintsub !=0 && !tcomp && norb) return;
-  if (tnow <= prev) return;
+  if (buffer) {
+    if (norb==0) return;
+    if (n % nint && !last) return;
+    if (mstep % nintsub !=0 && !last) return;
+    if (tnow <= prev) {
+      if (last) Flush();
+      return;
+    }
+  } else {
+    if (n % nint && !last && !tcomp && norb) return;
+    if (mstep % nintsub !=0 && !tcomp && norb) return;
+    if (tnow <= prev) return;
+  }
 
   prev = tnow;			// Record current time
 
@@ -264,13 +288,19 @@ void OrbTrace::Run(int n, int mstep, bool last)
 
 #ifdef HAVE_LIBCUDA
   if (use_cuda) {
-    if (tcomp->force->cudaAware() and not comp->fetched[tcomp]) {
+    if ((tcomp->force->cudaAware() or cuda_resident) and not comp->fetched[tcomp]) {
       comp->fetched[tcomp] = true;
       tcomp->CudaToParticles();
     }
   }
 #endif
 
+  if (buffer) {
+    sample();
+    if (tbuf.size() >= buffer or last) Flush();
+    return;
+  }
+
 				// Open output file
   std::ofstream out;
   if (myid==0) {
@@ -339,3 +369,176 @@ void OrbTrace::Run(int n, int mstep, bool last)
   
   if (myid==0 && out) out << std::endl;
 }
+
+void OrbTrace::open_binary()
+{
+  const int32_t magic = 0x0b7ace;
+
+  int32_t head[3] = {magic, norb, nbuf};
+  std::vector<int64_t> ids(orblist.begin(), orblist.end());
+
+  size_t hsize = sizeof(head) + ids.size()*sizeof(int64_t);
+  size_t rsize = (1 + static_cast<size_t>(norb)*nbuf)*sizeof(double);
+
+  if (restart and std::filesystem::exists(binfile)) {
+
+    // Keep the records up to the restart time if the file has the
+    // same layout; otherwise, back it up and begin a new one
+    //
+    std::ifstream in(binfile, std::ios::binary);
+    int32_t old[3] = {0, 0, 0};
+    std::vector<int64_t> oids(ids.size());
+    in.read(reinterpret_cast<char*>(old), sizeof(old));
+    in.read(reinterpret_cast<char*>(oids.data()), oids.size()*sizeof(int64_t));
+
+    if (in and std::equal(old, old+3, head) and oids == ids) {
+      size_t nrec = 0;
+      double t;
+      while (in.seekg(hsize + nrec*rsize) and
+	     in.read(reinterpret_cast<char*>(&t), sizeof(double)) and
+	     t <= tnow) nrec++;
+      in.close();
+
+      std::filesystem::resize_file(binfile, hsize + nrec*rsize);
+      return;
+    }
+
+    in.close();
+
+    std::string backupfile = binfile + ".bak";
+    if (rename(binfile.c_str(), backupfile.c_str())) {
+      perror("OrbTrace");
+      std::ostringstream message;
+      message << "OrbTrace: error creating backup file <" 
+	      << backupfile << ">";
+      throw GenericError(message.str(), __FILE__, __LINE__, 1035, true);
+    }
+  }
+
+  std::ofstream out(binfile, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::ostringstream message;
+    message << "OrbTrace: error opening new trace file <" 
+	    << binfile << "> for writing";
+    throw GenericError(message.str(), __FILE__, __LINE__, 1035, true);
+  }
+
+  out.write(reinterpret_cast<const char*>(head), sizeof(head));
+  out.write(reinterpret_cast<const char*>(ids.data()), ids.size()*sizeof(int64_t));
+}
+
+void OrbTrace::make_slots()
+{
+  slots.clear();
+
+  for (int i=0; i<norb; i++) {
+    auto it = tcomp->particles.find(orblist[i]);
+    if (it != tcomp->particles.end()) slots.push_back({i, it->second});
+  }
+
+  int n = slots.size();
+  MPI_Allreduce(&n, &nslot, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+}
+
+void OrbTrace::sample()
+{
+  // A particle that left this process in a load balancing step drops
+  // its last reference here, so its slot expires.  A change in the
+  // total number of live slots triggers a new search on every process
+  // to find where it went.
+  //
+  int n = 0, tot;
+  for (auto & s : slots) if (not s.p.expired()) n++;
+
+  MPI_Allreduce(&n, &tot, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  if (tot != nslot or n != static_cast<int>(slots.size())) make_slots();
+
+  int step = tbuf.size();
+  tbuf.push_back(tnow);
+
+  ParticleSoA *soa = tcomp->SoA();
+
+  for (auto & s : slots) {
+
+    PartPtr p = s.p.lock();
+    if (not p) continue;
+
+    double ps[3], vs[3], as[3];
+
+    if (soa) {
+      tcomp->Pos(ps, p->indx, flags);
+      tcomp->Vel(vs, p->indx, flags);
+      for (int k=0; k<3; k++) as[k] = tcomp->Acc(p->indx, k, flags);
+    } else {
+      for (int k=0; k<3; k++) {
+	ps[k] = p->pos[k];
+	vs[k] = p->vel[k];
+	as[k] = p->acc[k];
+	if (tcomp->com_system and flags & Component::Inertial)
+	  as[k] += tcomp->acc0[k];
+      }
+      tcomp->ConvertPos(ps, flags);
+      tcomp->ConvertVel(vs, flags);
+    }
+
+    sbuf.push_back(step);
+    sbuf.push_back(s.orb);
+    for (int k=0; k<3; k++) sbuf.push_back(ps[k]);
+    for (int k=0; k<3; k++) sbuf.push_back(vs[k]);
+    if (use_acc) for (int k=0; k<3; k++) sbuf.push_back(as[k]);
+    if (use_pot) sbuf.push_back(p->pot + p->potext);
+    if (use_lev) sbuf.push_back(p->level);
+  }
+}
+
+void OrbTrace::Flush()
+{
+  // Every process holds the same number of samples
+  //
+  if (buffer==0 or tbuf.empty()) return;
+
+  // Collect the local samples to the root in one collective
+  //
+  int len = sbuf.size();
+  std::vector<int> lens(numprocs), offs(numprocs, 0);
+  MPI_Gather(&len, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::vector<double> all;
+  if (myid==0) {
+    for (int i=1; i<numprocs; i++) offs[i] = offs[i-1] + lens[i-1];
+    all.resize(offs[numprocs-1] + lens[numprocs-1]);
+  }
+
+  MPI_Gatherv(sbuf.data(), len, MPI_DOUBLE,
+	      all.data(), lens.data(), offs.data(), MPI_DOUBLE,
+	      0, MPI_COMM_WORLD);
+
+  if (myid==0) {
+				// One record in flight at a time
+    if (writer.joinable()) writer.join();
+
+    // Records of the time and the fields of every orbit
+    //
+    size_t rlen = 1 + static_cast<size_t>(norb)*nbuf;
+    wbuf.assign(tbuf.size()*rlen, std::numeric_limits<double>::quiet_NaN());
+
+    for (size_t t=0; t<tbuf.size(); t++) wbuf[t*rlen] = tbuf[t];
+
+    for (size_t j=0; j<all.size(); j+=2+nbuf) {
+      size_t t = all[j], o = all[j+1];
+      std::copy(&all[j+2], &all[j+2]+nbuf, &wbuf[t*rlen + 1 + o*nbuf]);
+    }
+
+    writer = std::thread([this]() {
+      std::ofstream out(binfile, std::ios::binary | std::ios::app);
+      if (out) out.write(reinterpret_cast<const char*>(wbuf.data()),
+			 wbuf.size()*sizeof(double));
+      if (!out)
+	std::cerr << "OrbTrace: error writing <" << binfile << ">"
+		  << std::endl;
+    });
+  }
+
+  tbuf.clear();
+  sbuf.clear();
+}
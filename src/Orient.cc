@@ -5,6 +5,7 @@
 #include <sstream>
 #include <cmath>
 #include <cstdlib>
+#include <unordered_set>
 
 #include "expand.H"
 
@@ -37,7 +38,7 @@ void EL3::debug() const
 }
 
 Orient::Orient(int n, int nwant, int naccel, unsigned Oflg, unsigned Cflg,
-	       string Logfile, double dt, double damping)
+	       string Logfile, double dt, double damping, int Nsample)
 {
   keep    = n;
   current = 0;
@@ -47,8 +48,14 @@ Orient::Orient(int n, int nwant, int naccel, unsigned Oflg, unsigned Cflg,
   logfile = Logfile;
   deltaT  = dt;
   Nlast   = 0;
+  selected= false;
   damp    = damping;
   linear  = false;
+  nsample = Nsample;
+  turnover= 0.0;
+  sigErr  = 0.0;
+
+  gen.seed(11 + myid);		// Per-process subsample stream
 
   pos = vector<double>(3);
   psa = vector<double>(3);
@@ -266,13 +273,16 @@ Orient::Orient(int n, int nwant, int naccel, unsigned Oflg, unsigned Cflg,
 	    << setw(15) << "| Omega_Z"		// 30
 	    << setw(15) << "| dOmega/dt_X"	// 31
 	    << setw(15) << "| dOmega/dt_Y"	// 32
-	    << setw(15) << "| dOmega/dt_Z"	// 33
-	    << endl;
+	    << setw(15) << "| dOmega/dt_Z";	// 33
+	if (nsample>0)
+	  out << setw(15) << "| Turnover"	// 34
+	      << setw(15) << "| Center err";	// 35
+	out << endl;
 	out.fill('-');
 
-	int icnt = 1;
+	int icnt = 1, ncol = nsample>0 ? 34 : 32;
 	out << "# " << setw(13) << icnt++;
-	for (int i=0; i<32; i++) out << "| " << setw(13) << icnt++;
+	for (int i=0; i<ncol; i++) out << "| " << setw(13) << icnt++;
 	out << endl;
 
 	out.close();
@@ -334,83 +344,255 @@ Orient::Orient(int n, int nwant, int naccel, unsigned Oflg, unsigned Cflg,
       
 }
 
-void Orient::accumulate_cpu(double time, Component *c)
+double Orient::select_threshold(const std::vector<double>& E, long k)
 {
-  double energy, mass, v2;
-  unsigned nbodies = c->Number();
-  PartMapItr it = c->Particles().begin();
-  unsigned tkeep = many/numprocs;
-  set<EL3, ltEL3>::reverse_iterator el3last = angm.rbegin();
+  const int    nbin = 1024;	// Histogram bins per pass
+  const long   ngat = 8192;	// Gather and sort below this many
 
-  for (unsigned q=0; q<nbodies; q++) {
+  long below = 0;		// Bodies known to be below the candidates
 
-    unsigned long i = (it++)->first;
-    Particle     *p = c->Part(i);
-
-    v2 = 0.0;
-    for (int k=0; k<3; k++) {
-      pos[k] = c->Pos(i, k, Component::Local);
-      if (std::isnan(pos[k])) {
-	cerr << "Orient: process " << myid << " index=" << i
-	     << " has NaN on component ";
-	for (int s=0; s<3; s++)
-	  cerr << setw(16) << p->pos[s];
-	for (int s=0; s<3; s++)
-	  cerr << setw(16) << p->vel[s];
-	for (int s=0; s<3; s++)
-	  cerr << setw(16) << p->acc[s];
-	cerr << endl;
-      }
-      vel[k] = c->Vel(i, k, Component::Local);
-      psa[k] = pos[k] - center[k];
-      v2 += vel[k]*vel[k];
+  // Start with the bodies on the same side of the last threshold as
+  // the new one
+  //
+  std::vector<double> cand;
+
+  long nE = E.size(), ntot;
+  MPI_Allreduce(&nE, &ntot, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  if (Nlast>0 and ntot>k) {
+    long c = 0;
+    for (auto e : E) if (e <= Elast) c++;
+    MPI_Allreduce(MPI_IN_PLACE, &c, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (c > k) {
+      for (auto e : E) if (e <= Elast) cand.push_back(e);
+    } else {
+      for (auto e : E) if (e >  Elast) cand.push_back(e);
+      below = c;
     }
+  } else {
+    cand = E;
+  }
 
-    energy = p->pot;
-    
-    if (cflags & KE) energy += 0.5*v2;
+  while (true) {
+
+    // Range and size of the candidates
+    //
+    double ext[2] = {std::numeric_limits<double>::max(),
+		     std::numeric_limits<double>::max()};
+    for (auto e : cand) {
+      ext[0] = std::min(ext[0],  e);
+      ext[1] = std::min(ext[1], -e);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, ext, 2, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+
+    double lo = ext[0], hi = -ext[1];
+
+    long m = cand.size();
+    MPI_Allreduce(MPI_IN_PLACE, &m, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    if (m==0) return 0.0;	// No bodies at all
+
+    // No more bodies than wanted: use the largest energy
+    //
+    if (below + m <= k) return hi;
+
+    if (hi <= lo) return lo;	// Remaining candidates are identical
+
+    // Few enough to finish exactly
+    //
+    if (m <= ngat) {
+      int sz = cand.size();
+      std::vector<int> cnts(numprocs), disp(numprocs, 0);
+      MPI_Allgather(&sz, 1, MPI_INT, cnts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+      for (int n=1; n<numprocs; n++) disp[n] = disp[n-1] + cnts[n-1];
+      std::vector<double> all(m);
+      MPI_Allgatherv(cand.data(), sz, MPI_DOUBLE, all.data(), cnts.data(),
+		     disp.data(), MPI_DOUBLE, MPI_COMM_WORLD);
+      std::nth_element(all.begin(), all.begin()+(k-below), all.end());
+      return all[k-below];
+    }
+
+    // Histogram and keep the bin holding the threshold
+    //
+    auto bin = [&](double e) {
+      return std::min<int>(nbin-1, static_cast<int>((e - lo)/(hi - lo)*nbin));
+    };
+
+    std::vector<long> hist(nbin, 0);
+    for (auto e : cand) hist[bin(e)]++;
+    MPI_Allreduce(MPI_IN_PLACE, hist.data(), nbin, MPI_LONG, MPI_SUM,
+		  MPI_COMM_WORLD);
 
-    if (cflags & EXTERNAL) energy += p->potext;
+    int b = 0;
+    while (below + hist[b] <= k) below += hist[b++];
+
+    std::vector<double> next;
+    for (auto e : cand) if (bin(e)==b) next.push_back(e);
+    cand.swap(next);
+  }
+}
 
-    unsigned size0 = angm.size();
-    bool test1 = (size0 <= tkeep);
-    bool test2 = true;
+double Orient::bodyEnergy(Component *c, unsigned long i)
+{
+  Particle *p = c->Part(i);
+
+  double v2 = 0.0;
+  for (int k=0; k<3; k++) {
+    pos[k] = c->Pos(i, k, Component::Local);
+    if (std::isnan(pos[k])) {
+      cerr << "Orient: process " << myid << " index=" << i
+	   << " has NaN on component ";
+      for (int s=0; s<3; s++)
+	cerr << setw(16) << p->pos[s];
+      for (int s=0; s<3; s++)
+	cerr << setw(16) << p->vel[s];
+      for (int s=0; s<3; s++)
+	cerr << setw(16) << p->acc[s];
+      cerr << endl;
+    }
+    vel[k] = c->Vel(i, k, Component::Local);
+    v2 += vel[k]*vel[k];
+  }
 
-    if (size0) test2 = (energy < el3last->E);
+  double E = p->pot;
     
-    if (test1 || test2) {
+  if (cflags & KE) E += 0.5*v2;
 
-      mass = p->mass;
+  if (cflags & EXTERNAL) E += p->potext;
 
-      t.E = energy;
-      t.T = time;
-      t.M = mass;
+  return E;
+}
 
-      t.L[0] = mass*(psa[1]*vel[2] - psa[2]*vel[1]);
-      t.L[1] = mass*(psa[2]*vel[0] - psa[0]*vel[2]);
-      t.L[2] = mass*(psa[0]*vel[1] - psa[1]*vel[0]);
+void Orient::insertBody(double time, Component *c, unsigned long i, double E)
+{
+  for (int k=0; k<3; k++) {
+    pos[k] = c->Pos(i, k, Component::Local);
+    vel[k] = c->Vel(i, k, Component::Local);
+    psa[k] = pos[k] - center[k];
+  }
 
-      t.R[0] = mass*pos[0];
-      t.R[1] = mass*pos[1];
-      t.R[2] = mass*pos[2];
+  double mass = c->Part(i)->mass;
 
-      // Trim the list by removing the element with the largest energy
-      //
-      if (test2 && !test1) angm.erase(*el3last);
+  t.E = E;
+  t.T = time;
+  t.M = mass;
 
-      // Insert the new element
-      //
-      angm.insert(t);
+  t.L[0] = mass*(psa[1]*vel[2] - psa[2]*vel[1]);
+  t.L[1] = mass*(psa[2]*vel[0] - psa[0]*vel[2]);
+  t.L[2] = mass*(psa[0]*vel[1] - psa[1]*vel[0]);
 
-      // Reset the iterator at the top of the heap
-      //
-      el3last = angm.rbegin();
+  t.R[0] = mass*pos[0];
+  t.R[1] = mass*pos[1];
+  t.R[2] = mass*pos[2];
+
+  angm.insert(t);
 
 #ifdef DEBUG      
-      t.debug();
+  t.debug();
 #endif
+}
+
+void Orient::accumulate_cpu(double time, Component *c)
+{
+  unsigned nbodies = c->Number();
+  PartMapItr it = c->Particles().begin();
+
+  std::vector<double> energy(nbodies);
+  std::vector<unsigned long> indx(nbodies);
+
+  for (unsigned q=0; q<nbodies; q++) {
+    unsigned long i = (it++)->first;
+    energy[q] = bodyEnergy(c, i);
+    indx[q]   = i;
+  }
+
+  // Global threshold for the most bound bodies
+  //
+  Ecurr    = select_threshold(energy, many);
+  selected = true;
+
+  // Keep the bodies below threshold
+  //
+  for (unsigned q=0; q<nbodies; q++) {
+    if (energy[q] < Ecurr) insertBody(time, c, indx[q], energy[q]);
+  }
+}
+
+void Orient::accumulate_sample(double time, Component *c)
+{
+  auto all = c->levlist.range(0, multistep);
+
+  // Seed the candidates from every body on the first call
+  //
+  long nc = cands.size();
+  MPI_Allreduce(MPI_IN_PLACE, &nc, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  std::vector<unsigned long> work;
+  std::unordered_set<unsigned long> prev;
+
+  if (nc==0) {
+    work.assign(all.begin(), all.end());
+  } else {
+    // Candidates still on this process
+    //
+    for (auto i : cands) {
+      if (c->Particles().find(i) != c->Particles().end()) {
+	work.push_back(i);
+	prev.insert(i);
+      }
+    }
+
+    // This process' share of the subsample, one body drawn from each
+    // of nstrat equal strata of the level list
+    //
+    long nloc = all.size(), ntot;
+    MPI_Allreduce(&nloc, &ntot, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+    long nstrat = 0;
+    if (ntot>0)
+      nstrat = std::min<long>(nloc, std::ceil(double(nsample)*nloc/ntot));
+
+    if (nstrat>0) {
+      std::uniform_real_distribution<double> unif(0.0, 1.0);
+      std::unordered_set<unsigned long> seen(prev);
+      double width = double(nloc)/nstrat;
+      for (long j=0; j<nstrat; j++) {
+	long p = std::min<long>(nloc-1, (j + unif(gen))*width);
+	unsigned long i = all[p];
+	if (seen.insert(i).second) work.push_back(i);
+      }
     }
   }
+
+  std::vector<double> energy(work.size());
+  for (size_t q=0; q<work.size(); q++) energy[q] = bodyEnergy(c, work[q]);
+
+  // Global threshold for the most bound bodies in the sample
+  //
+  Ecurr    = select_threshold(energy, many);
+  selected = true;
+
+  for (size_t q=0; q<work.size(); q++) {
+    if (energy[q] < Ecurr) insertBody(time, c, work[q], energy[q]);
+  }
+
+  // Keep the 2*many most bound as the next candidate set and count
+  // the newcomers
+  //
+  double Ecand = select_threshold(energy, 2L*many);
+
+  long cnt[2] = {0, 0};
+  cands.clear();
+  for (size_t q=0; q<work.size(); q++) {
+    if (energy[q] <= Ecand) {
+      cands.push_back(work[q]);
+      if (prev.find(work[q]) == prev.end()) cnt[0]++;
+    }
+  }
+  cnt[1] = cands.size();
+  MPI_Allreduce(MPI_IN_PLACE, cnt, 2, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  turnover = cnt[1]>0 ? double(cnt[0])/cnt[1] : 0.0;
 }
 
 
@@ -438,43 +620,52 @@ void Orient::accumulate(double time, Component *c)
     accumulate_gpu(time, c);
   else
 #endif
+  if (nsample>0)
+    accumulate_sample(time, c);
+  else
     accumulate_cpu(time, c);
 
   comp->timer_orient.stop();
 
-  unsigned tkeep = many/numprocs;
+  // The CPU path has already found the global threshold
+  //
+  if (not selected) {
+
+    unsigned tkeep = many/numprocs;
 
-  std::vector<double> ee;
-  for (auto it = angm.begin(); it != angm.end(); it++) ee.push_back(it->E);
+    std::vector<double> ee;
+    for (auto it = angm.begin(); it != angm.end(); it++) ee.push_back(it->E);
   
-  for (int n=1; n<numprocs; n++) {
-    if (n==myid) {
-      unsigned nsiz = ee.size();
-      // Size trim approximation; 3x the target size
-      nsiz = std::min<unsigned>(nsiz, 3.0*tkeep);
-      // Send to root node for sorting
-      MPI_Send(&nsiz,     1, MPI_UNSIGNED, 0, 331, MPI_COMM_WORLD);
-      MPI_Send(&ee[0], nsiz, MPI_DOUBLE,   0, 332, MPI_COMM_WORLD);
-    }
-    if (0==myid) {
-      unsigned nsiz;
-      MPI_Recv(&nsiz, 1, MPI_UNSIGNED, n, 331, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-      std::vector<double> tt(nsiz);
-      MPI_Recv(&tt[0], nsiz, MPI_DOUBLE, n, 332, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-      ee.insert(ee.end(), tt.begin(), tt.end());
+    for (int n=1; n<numprocs; n++) {
+      if (n==myid) {
+        unsigned nsiz = ee.size();
+        // Size trim approximation; 3x the target size
+        nsiz = std::min<unsigned>(nsiz, 3.0*tkeep);
+        // Send to root node for sorting
+        MPI_Send(&nsiz,     1, MPI_UNSIGNED, 0, 331, MPI_COMM_WORLD);
+        MPI_Send(&ee[0], nsiz, MPI_DOUBLE,   0, 332, MPI_COMM_WORLD);
+      }
+      if (0==myid) {
+        unsigned nsiz;
+        MPI_Recv(&nsiz, 1, MPI_UNSIGNED, n, 331, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        std::vector<double> tt(nsiz);
+        MPI_Recv(&tt[0], nsiz, MPI_DOUBLE, n, 332, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        ee.insert(ee.end(), tt.begin(), tt.end());
+      }
     }
-  }
 
-  if (myid==0) {
-    std::sort(ee.begin(), ee.end());
-    if (ee.size()<=many) Ecurr = ee.back();
-    else                 Ecurr = *(ee.begin()+many);
-  }
+    if (myid==0) {
+      std::sort(ee.begin(), ee.end());
+      if (ee.size()<=many) Ecurr = ee.back();
+      else                 Ecurr = *(ee.begin()+many);
+    }
 
-  // Propagate minimum energy and current cached low energy particles
-  // within nodes
+    // Propagate minimum energy and current cached low energy particles
+    // within nodes
 
-  MPI_Bcast(&Ecurr, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&Ecurr, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  }
+  selected = false;
 
 				// Compute values for this step
   axis1  .setZero();
@@ -548,6 +739,18 @@ void Orient::accumulate(double time, Component *c)
     center1 /= mtot;
     if (oflags & AXIS)   sumsA.push_back(DV(time, axis1  ));
     if (oflags & CENTER) sumsC.push_back(DV(time, center1));
+
+    // Standard error of the center from the mass-weighted scatter of
+    // the bodies used
+    //
+    if (nsample>0) {
+      double s2 = 0.0;
+      for (auto i=angm.begin(); i!=angm.end() && i->E<Ecurr; i++) {
+	if (i->M>0.0) s2 += (i->R/i->M - center1).squaredNorm()*i->M;
+      }
+      MPI_Allreduce(MPI_IN_PLACE, &s2, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+      sigErr = used>0 ? sqrt(s2/mtot/used) : 0.0;
+    }
   }
 
   if ((cflags & DIAG) && myid==0) {
@@ -561,6 +764,10 @@ void Orient::accumulate(double time, Component *c)
 	      << axis1[0] << ", "
 	      << axis1[1] << ", "
 	      << axis1[2] << std::endl;
+    if (nsample>0)
+      std::cout << " Orient info [" << time << ", " << c->name << "]: "
+		<< "candidate turnover=" << turnover
+		<< " center error=" << sigErr << std::endl;
   }
 
   if (static_cast<int>(sumsA.size()) > keep + 1) {
@@ -776,6 +983,9 @@ void Orient::logEntry(double time, Component *c)
     // Columns 31 - 33
     for (int k=0; k<3; k++) outl << setw(15) << domdt[k];
 
+    // Columns 34 - 35
+    if (nsample>0) outl << setw(15) << turnover << setw(15) << sigErr;
+
     outl << endl;
   }
 }
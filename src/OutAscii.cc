@@ -108,6 +108,10 @@ void OutAscii::initialize()
       }
     }
   }
+
+  // All processes open the output file
+  //
+  MPI_Bcast(&nbeg, 1, MPI_INT, 0, MPI_COMM_WORLD);
 }
 
 
@@ -122,68 +126,86 @@ void OutAscii::Run(int n, int mstep, bool last)
 
 #ifdef HAVE_LIBCUDA
   if (use_cuda) {
-    if (c0->force->cudaAware() and not comp->fetched[c0]) {
+    if ((c0->force->cudaAware() or cuda_resident) and not comp->fetched[c0]) {
       comp->fetched[c0] = true;
       c0->CudaToParticles();
     }
   }
 #endif
 
-  std::ofstream out;
+  // Output name
+  //
+  std::ostringstream fname;
+  fname << filename << "." << setw(5) << setfill('0') << nbeg++;
 
-  int nOK = 0;
+  // Open the file on all processes
+  //
+  MPI_File file;
+  char err[MPI_MAX_ERROR_STRING];
+  int len, nOK = 0;
 
-  if (myid==0) {
-				// Output name
-    std::ostringstream fname;
-    fname << filename << "." << setw(5) << setfill('0') << nbeg++;
+  MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
 
-				// Open file and write master header
-    out.open(fname.str());
+  int ret =
+    MPI_File_open(MPI_COMM_WORLD, fname.str().c_str(),
+		  MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_UNIQUE_OPEN,
+		  MPI_INFO_NULL, &file);
 
-    if (out.fail()) {
-      std::cerr << "OutAscii: can't open file <" << fname.str() 
-		<< "> . . . quitting\n";
-      nOK = 1;
-    }
-    
+  if (ret != MPI_SUCCESS) {
+    std::cerr << "OutAscii: rank [" << myid << "] can't open file <"
+	      << fname.str() << "> . . . quitting" << std::endl;
+    nOK = 1;
   }
 
-  // Check that root has a good stream
-  //
-  MPI_Bcast(&nOK, 1, MPI_INT, 0, MPI_COMM_WORLD);
-  if (nOK) {
+  int badCount = 0;
+  MPI_Allreduce(&nOK, &badCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (badCount) {
     throw std::runtime_error("OutAscii::Run: I/O error");
   }
 
+  // A longer file may already exist under this name
+  //
+  MPI_File_set_size(file, 0);
+
   // Update total particle number
   //
   c0->NewTotal();
 
   // Write the header
   //
-  if (nOK == 0) {
-      out << "# Time=" << tnow << "\n";
-      out << setw(10) << c0->CurTotal()
-	  << setw(10) << c0->niattrib
-	  << setw(10) << c0->ndattrib << "\n";
+  std::ostringstream header;
+  header << "# Time=" << tnow << "\n";
+  header << setw(10) << c0->CurTotal()
+	 << setw(10) << c0->niattrib
+	 << setw(10) << c0->ndattrib << "\n";
+
+  if (myid==0) {
+    ret = MPI_File_write_at(file, 0, header.str().c_str(), header.str().size(),
+			    MPI_CHAR, MPI_STATUS_IGNORE);
+
+    if (ret != MPI_SUCCESS) {
+      MPI_Error_string(ret, err, &len);
+      std::cout << "OutAscii: WRITE header " << err
+		<< " at line " << __LINE__ << std::endl;
+    }
   }
-  
-  // Dump the phase-space info into the file
+
+  // Dump the phase-space info into the file.  Each process formats
+  // its particles and writes them collectively after those of the
+  // lower ranks.
   //
-  c0->write_ascii(&out, accel);
+  MPI_Offset offset = header.str().size();
+  c0->write_ascii_mpi(file, offset, accel);
 
   // Close file and done
   //
-  if (myid==0) {
-    try {
-      out.close();
-    }
-    catch (const ofstream::failure& e) {
-      std::cout << "OutAscii: exception closing file: "
-		<< e.what() << std::endl;
-    }
-  }
+  ret = MPI_File_close(&file);
 
+  if (ret != MPI_SUCCESS) {
+    MPI_Error_string(ret, err, &len);
+    std::cout << "OutAscii: CLOSE " << err
+	      << " at line " << __LINE__ << std::endl;
+  }
 }
 
@@ -20,7 +20,11 @@ OutCHKPT::valid_keys = {
   "nint",
   "nintsub",
   "timer",
-  "nagg"
+  "nagg",
+  "async",
+  "asyncmb",
+  "incremental",
+  "dynamic"
 };
 
 OutCHKPT::OutCHKPT(const YAML::Node& conf) : Output(conf)
@@ -76,6 +80,28 @@ void OutCHKPT::initialize()
       nagg = Output::conf["nagg"].as<std::string>();
     else
       nagg = "1";
+
+    if (Output::conf["async"])
+      async = Output::conf["async"].as<bool>();
+    else
+      async = false;
+
+    if (Output::conf["asyncmb"])
+      asyncmb = Output::conf["asyncmb"].as<double>();
+    else
+      asyncmb = 2048.0;
+
+    if (async) writer = std::make_shared<AsyncWriter>(asyncmb);
+
+    if (Output::conf["incremental"])
+      incremental = Output::conf["incremental"].as<bool>();
+    else
+      incremental = false;
+
+    if (Output::conf["dynamic"])
+      dynamic = Output::conf["dynamic"].as<std::vector<int>>();
+
+    basetime = -1.0;		// No base phase space yet
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutCHKPT: "
@@ -97,6 +123,10 @@ void OutCHKPT::Run(int n, int mstep, bool last)
     if (multistep>1 and mstep % nintsub !=0) return;
   }
 
+  // The previous checkpoint must be complete before it is renamed
+  //
+  if (writer) writer->wait();
+
   int returnStatus = 1;
 
   if (myid==0) {
@@ -146,6 +176,87 @@ void OutCHKPT::Run(int n, int mstep, bool last)
   std::chrono::high_resolution_clock::time_point beg, end;
   if (timer) beg = std::chrono::high_resolution_clock::now();
   
+  // Write only the dynamical state relative to a base phase space
+  //
+  if (incremental and write_incremental()) {
+
+    // The force state for a warm restart, which needs the levels in
+    // the incremental checkpoint, at the end of a full step only
+    //
+    if (multistep and (last or mstep==std::numeric_limits<int>::max()))
+      comp->write_state(filename + ".state");
+
+    chktimer.mark();
+
+    dump_signal  = 0;
+    flush_signal = 1;
+
+    if (timer) {
+      end = std::chrono::high_resolution_clock::now();
+      std::chrono::duration<double> intvl = end - beg;
+      if (myid==0)
+	std::cout << "OutCHKPT [T=" << tnow << "] incremental timing="
+		  << intvl.count() << std::endl;
+    }
+
+    return;
+  }
+
+  // Stage the checkpoint and write it in the background if it fits
+  //
+  if (async) {
+    bool staged = async_dump(filename, false);
+
+    if (not staged and myid==0)
+      std::cout << "OutCHKPT: checkpoint exceeds the staging budget, "
+		<< "writing synchronously" << std::endl;
+
+    if (staged) {
+      if (last) writer->wait();
+
+      chktimer.mark();
+
+      dump_signal  = 0;
+      flush_signal = 1;
+
+      if (timer) {
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> intvl = end - beg;
+	if (myid==0)
+	  std::cout << "OutCHKPT [T=" << tnow << "] staging=" << intvl.count()
+		    << std::endl;
+      }
+
+      return;
+    }
+  }
+
+  write_full(filename);
+
+  chktimer.mark();
+
+  // Clear the dump signal to prevent an out of sequence *real* output
+  // of a *double* output exists
+  //
+  dump_signal = 0;
+
+  // Buffered output should reach disk with the checkpoint
+  //
+  flush_signal = 1;
+
+  if (timer) {
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> intvl = end - beg;
+    if (myid==0)
+      std::cout << "OutCHKPT [T=" << tnow << "] timing=" << intvl.count()
+		<< std::endl;
+  }
+}
+
+
+
+void OutCHKPT::write_full(const std::string& target)
+{
   if (mpio) {
     static bool firsttime = true;
 
@@ -171,13 +282,13 @@ void OutCHKPT::Run(int n, int mstep, bool last)
     // Open shared file
     //
     int ret =
-      MPI_File_open(MPI_COMM_WORLD, filename.c_str(),
+      MPI_File_open(MPI_COMM_WORLD, target.c_str(),
 		    MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_UNIQUE_OPEN,
 		    info, &file);
     
     if (ret != MPI_SUCCESS) {
       std::cerr << "OutCHKPT:run: rank [" << myid << "] can't open file <"
-		<< filename << "> . . . quitting" << std::endl;
+		<< target << "> . . . quitting" << std::endl;
       nOK = 1;
     }
     
@@ -185,7 +296,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
     MPI_Allreduce(&nOK, &badCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
 
     if (badCount) {
-      throw std::runtime_error("OutCHKPT::Run: error in I/O");
+      throw std::runtime_error("OutCHKPT::write_full: error in I/O");
     }
 
     MPI_Info_free(&info);
@@ -203,7 +314,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
       if (ret != MPI_SUCCESS) {
 	MPI_Error_string(ret, err, &len);
-	std::cout << "OutCHKPT::run: WRITE header " << err
+	std::cout << "OutCHKPT::write_full: WRITE header " << err
 		  << " at line " << __LINE__ << std::endl;
       }
     }
@@ -212,13 +323,13 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
     for (auto c : comp->components) {
       if (firsttime and myid==0 and not c->Indexing())
-	std::cout << "OutCHKPT::run: component <" << c->name
+	std::cout << "OutCHKPT::write_full: component <" << c->name
 		  << "> has not set 'indexing' so PSP particle sequence will be lost." << std::endl
 		  << "If this is NOT what you want, set the component flag 'indexing=1'." << std::endl;
 
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
@@ -233,7 +344,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
     if (ret != MPI_SUCCESS) {
       MPI_Error_string(ret, err, &len);
-      std::cout << "OutCHKPT::run: SYNC " << err
+      std::cout << "OutCHKPT::write_full: SYNC " << err
 		<< " at line " << __LINE__ << std::endl;
     }
 
@@ -243,7 +354,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
     if (ret != MPI_SUCCESS) {
       MPI_Error_string(ret, err, &len);
-      std::cout << "OutCHKPT::run: SYNC " << err
+      std::cout << "OutCHKPT::write_full: SYNC " << err
 		<< " at line " << __LINE__ << std::endl;
     }
 
@@ -251,7 +362,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
     if (ret != MPI_SUCCESS) {
       MPI_Error_string(ret, err, &len);
-      std::cout << "OutCHKPT::run: CLOSE " << err
+      std::cout << "OutCHKPT::write_full: CLOSE " << err
 		<< " at line " << __LINE__ << std::endl;
     }
 
@@ -262,10 +373,10 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 
     if (myid==0) {
 				// Open file and write master header
-      out.open(filename);
+      out.open(target);
 
       if (out.fail()) {
-	std::cerr << "OutCHKPT: can't open file <" << filename
+	std::cerr << "OutCHKPT: can't open file <" << target
 	     << "> . . . quitting\n";
 	nOK = 1;
       }
@@ -285,7 +396,7 @@ void OutCHKPT::Run(int n, int mstep, bool last)
     
     MPI_Bcast(&nOK, 1, MPI_INT, 0, MPI_COMM_WORLD);
     if (nOK) {
-      throw std::runtime_error("OutCHKPT::Run: error in I/O");
+      throw std::runtime_error("OutCHKPT::write_full: error in I/O");
     }
 
     for (auto c : comp->components) {
@@ -304,26 +415,62 @@ void OutCHKPT::Run(int n, int mstep, bool last)
 	out.close();
       }
       catch (const ofstream::failure& e) {
-	std::cout << "OutCHKPT: exception closing file <" << filename
+	std::cout << "OutCHKPT: exception closing file <" << target
 		  << ": " << e.what() << std::endl;
       }
     }
+  }
+}
+
 
+bool OutCHKPT::write_incremental()
+{
+  // The delta is matched to the base by particle index
+  //
+  for (auto c : comp->components) {
+    if (not c->Indexing()) {
+      if (myid==0)
+	std::cout << "OutCHKPT: component <" << c->name << "> has not set "
+		  << "'indexing', incremental checkpoints are disabled"
+		  << std::endl;
+      incremental = false;
+      return false;
+    }
   }
 
-  chktimer.mark();
+  std::vector<unsigned> nbod;
+  for (auto c : comp->components) nbod.push_back(c->CurTotal());
 
-  // Clear the dump signal to prevent an out of sequence *real* output
-  // of a *double* output exists
+  // A new base is needed on the first checkpoint of the run and when
+  // bodies have been created or destroyed.  The two base slots
+  // alternate so that the base of the previous checkpoint survives.
   //
-  dump_signal = 0;
+  if (basetime < 0.0 or nbod != basenum) {
+
+    if (basetime < 0.0) {
+      slot = 0;
+      if (myid==0) {
+	std::string prev = delta_base(filename + ".bak");
+	if (prev == filename + ".base0") slot = 1;
+      }
+      MPI_Bcast(&slot, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    } else {
+      slot = 1 - slot;
+    }
+
+    base = filename + ".base" + std::to_string(slot);
+
+    write_full(base);
+
+    basetime = tnow;
+    basenum  = nbod;
 
-  if (timer) {
-    end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> intvl = end - beg;
     if (myid==0)
-      std::cout << "OutCHKPT [T=" << tnow << "] timing=" << intvl.count()
-		<< std::endl;
+      std::cout << "OutCHKPT: wrote base phase space <" << base
+		<< "> at T=" << tnow << std::endl;
   }
-}
 
+  delta_dump(filename, base, basetime, false, dynamic);
+
+  return true;
+}
@@ -21,6 +21,8 @@ OutCHKPTQ::valid_keys = {
   "nint",
   "nintsub",
   "timer",
+  "incremental",
+  "dynamic"
 };
 
 
@@ -70,6 +72,23 @@ void OutCHKPTQ::initialize()
       timer = Output::conf["timer"].as<bool>();
     else
       timer = false;
+
+    if (Output::conf["incremental"])
+      incremental = Output::conf["incremental"].as<bool>();
+    else
+      incremental = false;
+
+    if (Output::conf["dynamic"])
+      dynamic = Output::conf["dynamic"].as<std::vector<int>>();
+
+    basetime = -1.0;		// No base phase space yet
+
+    if (burstdir.size()) {
+      burst = std::make_shared<BurstBuffer>(burstdir);
+      if (myid==0)
+	std::cout << "OutCHKPTQ: checkpoints are written to <" << burstdir
+		  << "> and drained to <" << outdir << ">" << std::endl;
+    }
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutCHKPTQ: "
@@ -90,6 +109,14 @@ void OutCHKPTQ::Run(int n, int mstep, bool last)
     if (multistep>1 and mstep % nintsub !=0) return;
   }
   
+  // The previous checkpoint must be drained on all processes before
+  // it is renamed
+  //
+  if (burst) {
+    burst->wait();
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
   int returnStatus = 1;
   
   if (myid==0) {
@@ -208,13 +235,55 @@ void OutCHKPTQ::Run(int n, int mstep, bool last)
   std::chrono::high_resolution_clock::time_point beg, end;
   if (timer) beg = std::chrono::high_resolution_clock::now();
   
+  // Write only the dynamical state relative to a base phase space
+  //
+  if (not incremental or not write_incremental()) {
+    write_full(filename, burst);
+				// The final checkpoint must reach
+				// outdir before the run ends
+    if (burst and last) burst->wait();
+  }
+
+  chktimer.mark();
+
+  // Clear the dump signal to prevent an out of sequence *real* output
+  // of a *double* output exists
+  //
+  dump_signal = 0;
+
+  // Buffered output should reach disk with the checkpoint
+  //
+  flush_signal = 1;
+
+  if (timer) {
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> intvl = end - beg;
+    if (myid==0)
+      std::cout << "OutCHKPTQ [T=" << tnow << "] timing=" << intvl.count()
+		<< std::endl;
+  }
+}
+
+
+
+void OutCHKPTQ::write_full(const std::string& target,
+			   std::shared_ptr<BurstBuffer> buffer)
+{
   int nOK = 0;
 
   std::ofstream out;
 
+				// Files go to the burst buffer or
+				// directly to outdir
+  auto path = [&](const std::string& name) {
+    return buffer ? buffer->path(name) : outdir + name;
+  };
+
+  std::vector<std::string> files, pieces;
+
   if (myid==0) {
 				// Open file and write master header
-    std::string master = outdir + filename;
+    std::string master = path(target);
     out.open(master);
 
     if (out.fail()) {
@@ -235,14 +304,14 @@ void OutCHKPTQ::Run(int n, int mstep, bool last)
   
   MPI_Bcast(&nOK, 1, MPI_INT, 0, MPI_COMM_WORLD);
   if (nOK) {
-    throw std::runtime_error("OutCHKPTQ::Run: error in I/O");
+    throw std::runtime_error("OutCHKPTQ::write_full: error in I/O");
   }
 
   int count = 0;
   for (auto c : comp->components) {
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
@@ -253,16 +322,22 @@ void OutCHKPTQ::Run(int n, int mstep, bool last)
 
 				// Component file
     std::ostringstream cname;
-    cname << filename << "_" << count++;
+    cname << target << "_" << count++;
     
     if (myid==0) {
       c->write_binary_header(&out, false, cname.str());
     }
 
+    if (buffer and myid==0) {
+      for (int n=1; n<numprocs; n++)
+	pieces.push_back(cname.str() + "-" + std::to_string(n));
+    }
+
     cname << "-" << myid;
     
 				// Open file and write component header
-    std::string blobfile = outdir + cname.str();
+    std::string blobfile = path(cname.str());
+    if (buffer) files.push_back(cname.str());
     std::ofstream pout(blobfile);
 
     if (pout.fail()) {
@@ -283,38 +358,78 @@ void OutCHKPTQ::Run(int n, int mstep, bool last)
     MPI_Allreduce(&nOK, &sumOK, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
 
     if (sumOK) {
-      throw std::runtime_error("OutCHKPTQ::Run: error in I/O");
+      throw std::runtime_error("OutCHKPTQ::write_full: error in I/O");
     }
   }
 
   if (myid==0) {
     if (out.fail()) {
       std::cout << "OutCHKPTQ: error writing component to master <"
-		<< outdir + filename << std::endl;
+		<< path(target) << std::endl;
     }
 
     try {
       out.close();
     }
     catch (const ofstream::failure& e) {
-      std::cout << "OutCHKPTQ: exception closing file <" << outdir + filename
+      std::cout << "OutCHKPTQ: exception closing file <" << path(target)
 		<< ": " << e.what() << std::endl;
     }
   }
 
-  chktimer.mark();
+				// Drain to outdir in the background
+  if (buffer) buffer->start(files, pieces, myid==0 ? target : "");
+}
 
-  // Clear the dump signal to prevent an out of sequence *real* output
-  // of a *double* output exists
+
+bool OutCHKPTQ::write_incremental()
+{
+  // The delta is matched to the base by particle index
   //
-  dump_signal = 0;
+  for (auto c : comp->components) {
+    if (not c->Indexing()) {
+      if (myid==0)
+	std::cout << "OutCHKPTQ: component <" << c->name << "> has not set "
+		  << "'indexing', incremental checkpoints are disabled"
+		  << std::endl;
+      incremental = false;
+      return false;
+    }
+  }
+
+  std::vector<unsigned> nbod;
+  for (auto c : comp->components) nbod.push_back(c->CurTotal());
+
+  // A new base is needed on the first checkpoint of the run and when
+  // bodies have been created or destroyed.  The two base slots
+  // alternate so that the base of the previous checkpoint survives.
+  //
+  if (basetime < 0.0 or nbod != basenum) {
+
+    if (basetime < 0.0) {
+      slot = 0;
+      if (myid==0) {
+	std::string prev = delta_base(outdir + filename + ".bak");
+	if (prev == outdir + filename + ".base0") slot = 1;
+      }
+      MPI_Bcast(&slot, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    } else {
+      slot = 1 - slot;
+    }
+
+    base = filename + ".base" + std::to_string(slot);
+
+    write_full(base);
+
+    basetime = tnow;
+    basenum  = nbod;
 
-  if (timer) {
-    end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> intvl = end - beg;
     if (myid==0)
-      std::cout << "OutCHKPTQ [T=" << tnow << "] timing=" << intvl.count()
-		<< std::endl;
+      std::cout << "OutCHKPTQ: wrote base phase space <" << outdir + base
+		<< "> at T=" << tnow << std::endl;
   }
-}
 
+  delta_dump(outdir + filename, outdir + base, basetime, true, dynamic);
+
+  return true;
+}
@@ -39,7 +39,7 @@ void OutCalbr::set_energies()
 #ifdef HAVE_LIBCUDA
 				// Get particles from device on first call
     if (use_cuda) {
-      if (tcomp->force->cudaAware() and not comp->fetched[tcomp]) {
+      if ((tcomp->force->cudaAware() or cuda_resident) and not comp->fetched[tcomp]) {
 	comp->fetched[tcomp] = true;
 	tcomp->CudaToParticles();
       }
@@ -188,7 +188,7 @@ void OutCalbr::Run(int ns, int mstep, bool last)
 
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {		// Get particles from device
-      if (tcomp->force->cudaAware() and not comp->fetched[tcomp]) {
+      if ((tcomp->force->cudaAware() or cuda_resident) and not comp->fetched[tcomp]) {
 	comp->fetched[tcomp] = true;
 	tcomp->CudaToParticles();
       }
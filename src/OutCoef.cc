@@ -12,6 +12,10 @@ OutCoef::valid_keys = {
   "nint",
   "nintsub",
   "native",
+  "chunked",
+  "compress",
+  "buffer",
+  "swmr",
   "name"
 };
 
@@ -20,10 +24,18 @@ OutCoef::OutCoef(const YAML::Node& conf) : Output(conf)
   nint    = 10;
   nintsub = std::numeric_limits<int>::max();
   native  = false;
+  window  = 0;
+  level   = 0;
+  buffer  = 0;
+  swmr    = false;
   tcomp   = NULL;
 
   initialize();
 
+  tcomp->force->setH5Layout(window, level, swmr);
+
+  if (buffer and not native) pending.reserve(buffer);
+
   if (!(tcomp->force->HaveCoefDump())) {
     if (myid==0) {
       cerr << "OutCoef: no coefficients for this force\n";
@@ -43,6 +55,10 @@ void OutCoef::initialize()
   try {
     if (conf["nint"])         nint     = conf["nint"].as<int>();
     if (conf["native"])       native   = conf["native"].as<bool>();
+    if (conf["chunked"])      window   = conf["chunked"].as<unsigned>();
+    if (conf["compress"])     level    = conf["compress"].as<int>();
+    if (conf["buffer"])       buffer   = conf["buffer"].as<unsigned>();
+    if (conf["swmr"])         swmr     = conf["swmr"].as<bool>();
     if (conf["nintsub"]) {
       nintsub  = conf["nintsub"].as<int>();
       if (nintsub <= 0) nintsub = 1;
@@ -104,7 +120,10 @@ void OutCoef::Run(int n, int mstep, bool last)
 
   // Check for repeat time
   //
-  if (tnow <= prev) return;
+  if (tnow <= prev) {
+    if (last) Flush();
+    return;
+  }
 
   prev = tnow;
 
@@ -131,9 +150,28 @@ void OutCoef::Run(int n, int mstep, bool last)
       
       tcomp->force->dump_coefs(out);
 
+    } else if (buffer) {
+
+      auto cur = tcomp->force->current_coefs();
+
+      if (cur) {
+	pending.push_back(cur);
+	if (pending.size() >= buffer or last) Flush();
+      } else {
+	tcomp->force->dump_coefs_h5(filename);
+      }
+
     } else {
       tcomp->force->dump_coefs_h5(filename);
     }
   }
 
 }
+
+void OutCoef::Flush()
+{
+  if (myid or pending.empty()) return;
+
+  tcomp->force->append_coefs_h5(filename, pending);
+  pending.clear();
+}
@@ -5,7 +5,6 @@
 
 #include "expand.H"
 
-#include <AxisymmetricBasis.H>
 #include <OutDiag.H>
 
 const std::set<std::string>
@@ -132,9 +131,6 @@ void OutDiag::Run(int n, int mstep, bool last)
   prev = tnow;
 
 
-  double r, dr, dens, dens0;
-  double potl0, potl, potr, pott, potp;
-    
   ostringstream outs;
   outs << outdir << filename.c_str() << "." << n;
   ofstream out(outs.str().c_str());
@@ -145,27 +141,35 @@ void OutDiag::Run(int n, int mstep, bool last)
 
   header(out);
 
-  // Determine potential and acceleration
+  // The diagnostic points along the ray
+  //
+  double dr = (RMAX - RMIN)/(double)NUM;
+  Eigen::MatrixXd pts(NUM+1, 3);
+  for (int i=0; i<=NUM; i++) {
+    pts(i, 0) = RMIN + dr*i;
+    pts(i, 1) = THETA;
+    pts(i, 2) = PHI;
+  }
+
+  // Determine potential and acceleration for all points at once for
+  // each component
+  //
+  std::vector<Eigen::MatrixXd> fields;
+  for (auto c : lcomp) {
+    fields.emplace_back();
+    if (not c->force->evaluate_fields(PotAccel::FieldCoord::spherical,
+				      pts, fields.back()))
+      fields.back() = Eigen::MatrixXd::Zero(NUM+1, 7);
+  }
 
-  dr = (RMAX - RMIN)/(double)NUM;
   for (int i=0; i<=NUM; i++) {
-    r = RMIN + dr*i;
 
-    out << setw(15) << r;
+    out << setw(15) << pts(i, 0);
     
-    for (auto c : lcomp) {
-      AxisymmetricBasis * q = (AxisymmetricBasis *)(c->force);
-      q->determine_fields_at_point_sph(r, THETA, PHI,
-				       &dens0, &potl0, 
-				       &dens, &potl, &potr, &pott, &potp);
-      out << setw(15) << dens
-	  << setw(15) << potl
-	  << setw(15) << potr
-	  << setw(15) << pott
-	  << setw(15) << potp;
+    for (auto & f : fields) {
+      for (int k=2; k<7; k++) out << setw(15) << f(i, k);
     }
     out << endl;
   }
 
 }
-
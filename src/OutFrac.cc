@@ -7,6 +7,7 @@
 
 #include <expand.H>
 #include <Timer.H>
+#include <DistQuantile.H>
 #include <OutFrac.H>
 
 
@@ -172,6 +173,8 @@ void OutFrac::initialize()
     // Get quantiles
     if (Output::conf["frac"])
       Quant = Output::conf["frac"].as<std::vector<double>>();
+
+    numQuant = Quant.size();
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutFrac: "
@@ -194,15 +197,13 @@ void OutFrac::Run(int n, int mstep, bool last)
 
   prev = tnow;
 
-  MPI_Status status;
-
   Timer timer;
 
   if (myid==0) timer.start();
 
 #ifdef HAVE_LIBCUDA
   if (use_cuda) {
-    if (tcomp->force->cudaAware() and not comp->fetched[tcomp]) {
+    if ((tcomp->force->cudaAware() or cuda_resident) and not comp->fetched[tcomp]) {
       comp->fetched[tcomp] = true;
       tcomp->CudaToParticles();
     }
@@ -219,7 +220,7 @@ void OutFrac::Run(int n, int mstep, bool last)
     }
   }
   
-				// Compute R and rank by radius
+				// Compute R for the local bodies
   double r, pos[3];
   vector<double> rad(tcomp->Number());
   PartMapItr it = tcomp->Particles().begin();
@@ -233,54 +234,22 @@ void OutFrac::Run(int n, int mstep, bool last)
     rad[n] = sqrt(r);
   }
 
-				// Send arrays to master
-  int nbodies = tcomp->Number();
-  int max_nbodies, cur_bodies;
-  MPI_Reduce(&nbodies, &max_nbodies,
-	     1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
-
-  vector<double> rtot;
-  if (myid==0) {
-    rtot = rad;
-    rad = vector<double>(max_nbodies);
-  }
-
-  for (int n=1; n<numprocs; n++) {
-    if (myid==n) {
-      MPI_Send(&nbodies, 1, MPI_INT, 0, 153, MPI_COMM_WORLD);
-      MPI_Send(&rad[0], nbodies, MPI_DOUBLE, 0, 154, MPI_COMM_WORLD);
-    }
-    if (myid==0) {
-      MPI_Recv(&cur_bodies, 1, MPI_INT, n, 153, MPI_COMM_WORLD, &status);
-      MPI_Recv(&rad[0], cur_bodies, MPI_DOUBLE, n, 154, MPI_COMM_WORLD, &status);
-      rtot.insert(rtot.end(), rad.begin(), rad.begin()+cur_bodies);
-    }
-    MPI_Barrier(MPI_COMM_WORLD);
-  }
+				// Quantiles by distributed selection
+  unsigned long ntot;
+  DistQuantile dq;
+  vector<double> rq = dq.quantiles(rad, Quant, &ntot);
 
   if (myid==0) {
 
-    if (tcomp->CurTotal() != rtot.size()) {
+    if (tcomp->CurTotal() != ntot) {
       cerr << "OutFrac: body count mismatch!\n";
     }
 
     out.setf(ios::left);
     out << setw(18) << tnow;
     
-				// Sort the radii
-    sort(rtot.begin(), rtot.end());
-    
-				// Send all radii to 
 				// Put quantiles into file
-    int indx;
-
-    for (int i=0; i<numQuant; i++) {
-				// get the index (nearest integer)
-      indx = (int)(Quant[i]*rtot.size()+0.5);
-      if (indx >= rtot.size()) indx = rtot.size()-1;
-
-      out << setw(18) << rtot[indx];
-    }
+    for (int i=0; i<numQuant; i++) out << setw(18) << rq[i];
     out << setw(18) << timer.stop();
     out << endl;
   }
@@ -0,0 +1,365 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+#include <highfive/highfive.hpp>
+
+#include "expand.H"
+#include <global.H>
+
+#include <OutHDF5.H>
+
+const std::set<std::string>
+OutHDF5::valid_keys = {
+  "filename",
+  "nint",
+  "nintsub",
+  "nbeg",
+  "real4",
+  "chunk",
+  "timer"
+};
+
+
+OutHDF5::OutHDF5(const YAML::Node& conf) : Output(conf)
+{
+  initialize();
+}
+
+void OutHDF5::initialize()
+{
+  // Remove matched keys
+  //
+  for (auto v : valid_keys) current_keys.erase(v);
+  
+  // Assign values from YAML
+  //
+  try {
+				// Get file name
+    if (Output::conf["filename"])
+      filename = Output::conf["filename"].as<std::string>();
+    else {
+      filename.erase();
+      filename = "OUT." + runtag;
+    }
+
+    if (Output::conf["nint"])
+      nint = Output::conf["nint"].as<int>();
+    else
+      nint = 100;
+    
+    if (Output::conf["nintsub"]) {
+#ifdef ALLOW_NINTSUB
+      nintsub = Output::conf["nintsub"].as<int>();
+      if (nintsub <= 0) nintsub = 1;
+#else
+      nintsub_warning("OutHDF5");
+      nintsub = std::numeric_limits<int>::max();
+#endif
+    } else
+      nintsub = std::numeric_limits<int>::max();
+
+    if (Output::conf["nbeg"])
+      nbeg = Output::conf["nbeg"].as<int>();
+    else
+      nbeg = 0;
+
+    if (Output::conf["real4"])
+      real4 = Output::conf["real4"].as<bool>();
+    else
+      real4 = true;
+
+    if (Output::conf["chunk"])
+      chunk = Output::conf["chunk"].as<int>();
+    else
+      chunk = 1048576;
+
+    if (Output::conf["timer"])
+      timer = Output::conf["timer"].as<bool>();
+    else
+      timer = false;
+  }
+  catch (YAML::Exception & error) {
+    if (myid==0) std::cout << "Error parsing parameters in OutHDF5: "
+			   << error.what() << std::endl
+			   << std::string(60, '-') << std::endl
+			   << "Config node"        << std::endl
+			   << std::string(60, '-') << std::endl
+			   << conf                 << std::endl
+			   << std::string(60, '-') << std::endl;
+    throw std::runtime_error("OutHDF5::initialize: error parsing YAML");
+  }
+
+  chunk = std::max<int>(chunk, 1);
+
+				// Determine last file
+  if (restart && nbeg==0) {
+    if (myid==0) {
+
+      for (nbeg=0; nbeg<100000; nbeg++) {
+
+				// Output name
+	ostringstream fname;
+	fname << outdir << filename << "." << setw(5) << setfill('0') << nbeg;
+
+				// See if we can open file
+	ifstream in(fname.str().c_str());
+	
+	if (!in) {
+	  cout << "OutHDF5: will begin with nbeg=" << nbeg << endl;
+	  break;
+	}
+      }
+    }
+				// All nodes open the same file
+    MPI_Bcast(&nbeg, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  }
+
+}
+
+
+//! Create a chunked dataset of total x ncol values (if create is
+//! true) and write the slab of count rows starting at row first
+template<typename T>
+static void writeSlab(HighFive::Group& grp, const std::string& name,
+		      const std::vector<T>& v, size_t ncol,
+		      size_t total, size_t first, size_t count,
+		      size_t chunk, bool create,
+		      const HighFive::DataTransferProps& xfer)
+{
+  std::vector<size_t> dims {total}, offs {first}, cnts {count};
+  if (ncol>1) {
+    dims.push_back(ncol);
+    offs.push_back(0);
+    cnts.push_back(ncol);
+  }
+
+  HighFive::DataSet ds;
+
+  if (create) {
+    HighFive::DataSetCreateProps props;
+    if (total) {
+      std::vector<hsize_t> cdim {std::min<hsize_t>(chunk, total)};
+      if (ncol>1) cdim.push_back(ncol);
+      props.add(HighFive::Chunking(cdim));
+    }
+    ds = grp.createDataSet<T>(name, HighFive::DataSpace(dims), props);
+  } else {
+    ds = grp.getDataSet(name);
+  }
+
+  // Every process takes part in a collective write, even with an
+  // empty slab
+  //
+  ds.select(offs, cnts).write_raw(v.data(), HighFive::AtomicType<T>(), xfer);
+}
+
+//! Write the slab of the bodies in plist into a component group
+template<typename T>
+static void writeFields(HighFive::Group& grp, Component* c,
+			size_t total, size_t first, size_t chunk,
+			bool create, const HighFive::DataTransferProps& xfer)
+{
+  std::vector<PartPtr> plist;
+  for (auto & v : c->Particles()) plist.push_back(v.second);
+
+  const size_t N = plist.size();
+  const int niatr = c->niattrib, ndatr = c->ndattrib;
+
+  std::vector<unsigned long> indx(N);
+  std::vector<T> mass(N), pos(3*N), vel(3*N), pot(N), potext(N);
+  std::vector<T> dattrib(N*ndatr);
+  std::vector<int> iattrib(N*niatr);
+
+  for (size_t n=0; n<N; n++) {
+    auto & p = plist[n];
+    indx  [n] = p->indx;
+    mass  [n] = p->mass;
+    pot   [n] = p->pot;
+    potext[n] = p->potext;
+    for (int k=0; k<3; k++) {
+      pos[3*n+k] = p->pos[k];
+      vel[3*n+k] = p->vel[k];
+    }
+    for (int k=0; k<niatr; k++) iattrib[n*niatr+k] = p->iattrib[k];
+    for (int k=0; k<ndatr; k++) dattrib[n*ndatr+k] = p->dattrib[k];
+  }
+
+  writeSlab(grp, "indx",   indx,   1, total, first, N, chunk, create, xfer);
+  writeSlab(grp, "mass",   mass,   1, total, first, N, chunk, create, xfer);
+  writeSlab(grp, "pos",    pos,    3, total, first, N, chunk, create, xfer);
+  writeSlab(grp, "vel",    vel,    3, total, first, N, chunk, create, xfer);
+  writeSlab(grp, "pot",    pot,    1, total, first, N, chunk, create, xfer);
+  writeSlab(grp, "potext", potext, 1, total, first, N, chunk, create, xfer);
+  if (niatr)
+    writeSlab(grp, "iattrib", iattrib, niatr, total, first, N, chunk, create, xfer);
+  if (ndatr)
+    writeSlab(grp, "dattrib", dattrib, ndatr, total, first, N, chunk, create, xfer);
+}
+
+//! Create (if create is true) the groups, attributes and datasets of
+//! every component and write the slab of this process.  With parallel
+//! HDF5 all processes call this together so that the metadata calls
+//! are collective and identical on every process.
+static void writeComponents(HighFive::File& file, bool create, bool real4,
+			    size_t chunk,
+			    const std::vector<unsigned long>& total,
+			    const std::vector<unsigned long>& first,
+			    const HighFive::DataTransferProps& xfer)
+{
+  if (create) {
+    double time = tnow;
+    int ncomp = comp->ncomp;
+    file.createAttribute<double>("Time",  HighFive::DataSpace::From(time)).write(time);
+    file.createAttribute<int>   ("Ncomp", HighFive::DataSpace::From(ncomp)).write(ncomp);
+  }
+
+  int count = 0;
+  for (auto c : comp->components) {
+
+    std::string gname = "Component_" + std::to_string(count);
+    HighFive::Group grp;
+
+    if (create) {
+      grp = file.createGroup(gname);
+
+      std::ostringstream outs;
+      outs << c->conf;
+
+      std::string cname = c->name, config = outs.str();
+      int niatr = c->niattrib, ndatr = c->ndattrib, r4 = real4;
+      unsigned long nbod = total[count];
+
+      grp.createAttribute<std::string>("name",   HighFive::DataSpace::From(cname)).write(cname);
+      grp.createAttribute<std::string>("config", HighFive::DataSpace::From(config)).write(config);
+      grp.createAttribute<int>("niatr", HighFive::DataSpace::From(niatr)).write(niatr);
+      grp.createAttribute<int>("ndatr", HighFive::DataSpace::From(ndatr)).write(ndatr);
+      grp.createAttribute<int>("real4", HighFive::DataSpace::From(r4)).write(r4);
+      grp.createAttribute<unsigned long>("nbod", HighFive::DataSpace::From(nbod)).write(nbod);
+    } else {
+      grp = file.getGroup(gname);
+    }
+
+    if (real4)
+      writeFields<float >(grp, c, total[count], first[count], chunk, create, xfer);
+    else
+      writeFields<double>(grp, c, total[count], first[count], chunk, create, xfer);
+
+    count++;
+  }
+}
+
+
+void OutHDF5::Run(int n, int mstep, bool last)
+{
+  if (!dump_signal and !last) {
+    if (n % nint) return;
+    if (restart && n==0) return;
+    if (multistep>1 && mstep % nintsub !=0 ) return;
+  }
+
+  std::chrono::high_resolution_clock::time_point beg, end;
+  if (timer) beg = std::chrono::high_resolution_clock::now();
+
+  std::ostringstream fname;
+  fname << outdir << filename << "." << setw(5) << setfill('0') << nbeg++;
+
+  // Slab offsets: the bodies of each component are stored in process
+  // order
+  //
+  std::vector<unsigned long> total, first;
+
+  for (auto c : comp->components) {
+
+#ifdef HAVE_LIBCUDA
+    if (use_cuda) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
+	comp->fetched[c] = true;
+	c->CudaToParticles();
+      }
+    }
+#endif
+
+    unsigned long mine = c->Particles().size(), tot = 0, off = 0;
+    MPI_Allreduce(&mine, &tot, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Exscan   (&mine, &off, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (myid==0) off = 0;	// Exscan leaves the root undefined
+
+    total.push_back(tot);
+    first.push_back(off);
+  }
+
+  int nOK = 0;
+
+#ifdef H5_HAVE_PARALLEL
+  try {
+    HighFive::FileAccessProps fapl;
+    fapl.add(HighFive::MPIOFileAccess{MPI_COMM_WORLD, MPI_INFO_NULL});
+
+    HighFive::File file(fname.str(),
+			HighFive::File::ReadWrite | HighFive::File::Create |
+			HighFive::File::Truncate, fapl);
+
+    HighFive::DataTransferProps xfer;
+    xfer.add(HighFive::UseCollectiveIO{});
+
+    writeComponents(file, true, real4, chunk, total, first, xfer);
+
+  } catch (HighFive::Exception& err) {
+    std::cerr << "[" << myid << "] OutHDF5: error writing <"
+	      << fname.str() << ">: " << err.what() << std::endl;
+    nOK = 1;
+  }
+#else
+  // Without MPI-IO support in HDF5, the root creates the file and the
+  // other processes add their slabs in turn
+  //
+  HighFive::DataTransferProps xfer;
+
+  for (int id=0; id<numprocs; id++) {
+    int bad = 0;
+    MPI_Allreduce(&nOK, &bad, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (bad) break;
+
+    if (id==myid) {
+      try {
+	if (myid==0) {
+	  HighFive::File file(fname.str(),
+			      HighFive::File::ReadWrite | HighFive::File::Create |
+			      HighFive::File::Truncate);
+	  writeComponents(file, true, real4, chunk, total, first, xfer);
+	} else {
+	  HighFive::File file(fname.str(), HighFive::File::ReadWrite);
+	  writeComponents(file, false, real4, chunk, total, first, xfer);
+	}
+      } catch (HighFive::Exception& err) {
+	std::cerr << "[" << myid << "] OutHDF5: error writing <"
+		  << fname.str() << ">: " << err.what() << std::endl;
+	nOK = 1;
+      }
+    }
+  }
+#endif
+
+  int badCount = 0;
+  MPI_Allreduce(&nOK, &badCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (badCount) {
+    throw std::runtime_error("OutHDF5::Run: error in I/O");
+  }
+
+  chktimer.mark();
+
+  dump_signal = 0;
+
+  if (timer) {
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> intvl = end - beg;
+    if (myid==0)
+      std::cout << "OutHDF5 [T=" << tnow << "] timing=" << intvl.count()
+		<< std::endl;
+  }
+}
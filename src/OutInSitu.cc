@@ -0,0 +1,283 @@
+#include <filesystem>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+#include <H5public.h>
+
+#include <highfive/highfive.hpp>
+#include <highfive/eigen.hpp>
+
+#include <ParticleReader.H>
+#include <Centering.H>
+
+#include <expand.H>
+
+#include <OutInSitu.H>
+
+const std::set<std::string>
+OutInSitu::valid_keys = {
+  "name",
+  "nint",
+  "nintsub",
+  "basis",
+  "center",
+  "ndens",
+  "fields",
+  "filename",
+  "async"
+};
+
+namespace
+{
+  //! Particle reader view of the particles of a component on this
+  //! process.  The expui accumulation reduces over the processes.
+  class ComponentReader : public PR::ParticleReader
+  {
+    Component *c;
+    PartMapItr it;
+
+  public:
+
+    ComponentReader(Component *c) : c(c) {}
+
+    void SelectType(const std::string& type) { it = c->Particles().begin(); }
+
+    unsigned long CurrentNumber() { return c->Number(); }
+
+    std::vector<std::string> GetTypes() { return {c->name}; }
+
+    double CurrentTime() { return tnow; }
+
+    const Particle* firstParticle()
+    {
+      it = c->Particles().begin();
+      return nextParticle();
+    }
+
+    const Particle* nextParticle()
+    {
+      if (it == c->Particles().end()) return 0;
+      return (it++)->second.get();
+    }
+  };
+}
+
+OutInSitu::OutInSitu(const YAML::Node& conf) : Output(conf)
+{
+  // Defaults
+  //
+  nint    = 10;
+  nintsub = std::numeric_limits<int>::max();
+  tcomp   = NULL;
+  center  = "none";
+  ndens   = 32;
+  async   = true;
+
+  // Retrieve parameters
+  //
+  initialize();
+
+  // Create the basis
+  //
+  basis = BasisClasses::Basis::factory(conf["basis"]);
+}
+
+void OutInSitu::initialize()
+{
+  // Remove matched keys
+  //
+  for (auto v : valid_keys) current_keys.erase(v);
+
+  // Assign values from YAML
+  //
+  try {
+    if (conf["nint"])         nint     = conf["nint"  ].as<int>();
+    if (conf["center"])       center   = conf["center"].as<std::string>();
+    if (conf["ndens"])        ndens    = conf["ndens" ].as<int>();
+    if (conf["async"])        async    = conf["async" ].as<bool>();
+
+    if (conf["nintsub"]) {
+      nintsub  = conf["nintsub"].as<int>();
+      if (nintsub <= 0) nintsub = 1;
+    }
+
+    if (not conf["basis"]) {
+      std::string message = "OutInSitu: no basis specified. Please "
+	"provide an expui basis configuration with 'id' and 'parameters'";
+      throw std::runtime_error(message);
+    }
+
+    if (center != "none" and center != "com" and center != "density") {
+      std::string message = "OutInSitu: center must be one of 'none', "
+	"'com' or 'density'";
+      throw std::runtime_error(message);
+    }
+
+    if (conf["fields"]) {
+      pmin = conf["fields"]["pmin"].as<std::vector<double>>();
+      pmax = conf["fields"]["pmax"].as<std::vector<double>>();
+      grid = conf["fields"]["grid"].as<std::vector<int>>();
+      if (pmin.size() != 3 or pmax.size() != 3 or grid.size() != 3) {
+	std::string message = "OutInSitu: fields needs three values "
+	  "each for 'pmin', 'pmax' and 'grid'";
+	throw std::runtime_error(message);
+      }
+    }
+
+    // Search for desired component
+    //
+    if (conf["name"]) {
+      std::string tmp = conf["name"].as<std::string>();
+      for (auto c : comp->components) {
+	if (!(c->name.compare(tmp))) tcomp  = c;
+      }
+    }
+
+    // Success is required!
+    //
+    if (!tcomp) {
+      std::string message = "OutInSitu: no component to analyze. Please "
+	"specify the component name using the 'name' parameter.";
+      throw std::runtime_error(message);
+    }
+
+    if (conf["filename"])
+      filename = outdir + conf["filename"].as<std::string>();
+    else
+      filename = outdir + "insitu." + tcomp->name + "." + runtag;
+
+    fieldfile = filename + ".fields";
+
+    // The background writer needs a thread-safe HDF5 library since
+    // other outputs may use HDF5 at the same time
+    //
+    hbool_t safe = 0;
+    if (async and (H5is_library_threadsafe(&safe) < 0 or not safe)) {
+      if (myid==0) std::cout << "OutInSitu: the HDF5 library is not thread "
+			     << "safe; writing synchronously" << std::endl;
+      async = false;
+    }
+  }
+  catch (YAML::Exception & error) {
+    if (myid==0) std::cout << "Error parsing parameters in OutInSitu: "
+			   << error.what() << std::endl
+			   << std::string(60, '-') << std::endl
+			   << "Config node"        << std::endl
+			   << std::string(60, '-') << std::endl
+			   << conf                 << std::endl
+			   << std::string(60, '-') << std::endl;
+    throw std::runtime_error("OutInSitu::initialize: error parsing YAML");
+  }
+}
+
+void OutInSitu::Run(int n, int mstep, bool last)
+{
+  // Skip this master step
+  //
+  if (n % nint != 0 && !last) return;
+
+  // Skip this sub step
+  //
+  if (mstep < std::numeric_limits<int>::max() and mstep % nintsub != 0) return;
+
+  // Don't duplicate times
+  //
+  if (tnow <= prev) return;
+
+  // Record current time
+  //
+  prev = tnow;
+
+#ifdef HAVE_LIBCUDA
+  // Get particles from device
+  //
+  if (use_cuda) {
+    if ((tcomp->force->cudaAware() or cuda_resident) and not comp->fetched[tcomp]) {
+      comp->fetched[tcomp] = true;
+      tcomp->CudaToParticles();
+    }
+  }
+#endif
+
+  // The previous output must be written before the containers are
+  // reused
+  //
+  if (writer.joinable()) writer.join();
+
+  auto reader = std::make_shared<ComponentReader>(tcomp);
+
+  // Expansion center.  Collective.
+  //
+  std::vector<double> ctr(3, 0.0);
+  if (center == "com")
+    ctr = Utility::getCenterOfMass(reader);
+  else if (center == "density")
+    ctr = Utility::getDensityCenter(reader, 1, 0, ndens);
+
+  // Make the coefficients.  Collective.
+  //
+  auto coef = basis->createFromReader(reader, ctr);
+
+  if (coefs) coefs->clear();
+  else       coefs = CoefClasses::Coefs::makecoefs(coef, tcomp->name);
+  coefs->add(coef);
+
+  // Field slices from the new coefficients.  Collective.
+  //
+  if (grid.size()) {
+    Field::FieldGenerator fg({tnow}, pmin, pmax, grid);
+    auto db = fg.slices(basis, coefs);
+    if (myid==0 and db.size()) {
+      tslice = db.begin()->first;
+      slices = db.begin()->second;
+    }
+  }
+
+  // Only root node writes
+  //
+  if (myid==0) {
+    if (async and not last) writer = std::thread(&OutInSitu::write, this);
+    else write();
+  }
+}
+
+void OutInSitu::write()
+{
+  // Coefficients: extend the existing HDF5 file or write a new one
+  //
+  if (std::filesystem::exists(filename))
+    coefs->ExtendH5Coefs(filename);
+  else
+    coefs->WriteH5Coefs(filename);
+
+  if (slices.empty()) return;
+
+  // Fields: one group per output
+  //
+  try {
+    HighFive::File file(fieldfile,
+			HighFive::File::ReadWrite | HighFive::File::Create);
+
+    if (not file.exist("snapshots")) file.createGroup("snapshots");
+    auto snaps = file.getGroup("snapshots");
+
+    // Continue the numbering of an existing file on restart
+    //
+    if (nfields==0) nfields = snaps.getNumberObjects();
+
+    std::ostringstream sout;
+    sout << std::setw(8) << std::setfill('0') << std::right << nfields++;
+
+    auto stanza = snaps.createGroup(sout.str());
+    stanza.createAttribute<double>("Time", HighFive::DataSpace::From(tslice)).write(tslice);
+
+    for (auto & v : slices) stanza.createDataSet(v.first, v.second);
+  }
+  catch (HighFive::Exception& err) {
+    std::cerr << "OutInSitu: error writing <" << fieldfile << ">: "
+	      << err.what() << std::endl;
+  }
+
+  slices.clear();
+}
@@ -1,10 +1,12 @@
 #include <filesystem>
 #include <sstream>
+#include <algorithm>
 #include <cstdio>
 
 using namespace std;
 
 #include "expand.H"
+#include <ThreadPool.H>
 
 #include <OutLog.H>
 
@@ -59,16 +61,18 @@ OutLog::valid_keys = {
   "freq",
   "nint",
   "nintsub",
-  "precision"
+  "precision",
+  "dtime"
 };
 
 
 OutLog::OutLog(const YAML::Node& conf) : Output(conf)
 {
-  ektotxy=0.0;
   lastwtime = MPI_Wtime();
   laststep = -1;
   firstime = true;
+  dtime = 0.0;
+  tlast = -std::numeric_limits<double>::max();
 
   initialize();
 }
@@ -103,6 +107,9 @@ void OutLog::initialize()
     } else
       nintsub = std::numeric_limits<int>::max();
 
+    if (Output::conf["dtime"])
+      dtime = Output::conf["dtime"].as<double>();
+
     if (Output::conf["precision"]) {
       precision = Output::conf["precision"].as<int>();
     } else
@@ -156,56 +163,31 @@ void OutLog::Run(int n, int mstep, bool last)
     firstime = false;
 
     nbodies  = std::vector<int>(comp->ncomp);
-    nbodies1 = std::vector<int>(comp->ncomp);
-
     used     = std::vector<int>(comp->ncomp);
-    used1    = std::vector<int>(comp->ncomp);
-
     mtot     = std::vector<double>(comp->ncomp);
-    mtot1    = std::vector<double>(comp->ncomp);
-
     com      = std::vector<dvector>(comp->ncomp);
-    com1     = std::vector<dvector>(comp->ncomp);
-
     cov      = std::vector<dvector>(comp->ncomp);
-    cov1     = std::vector<dvector>(comp->ncomp);
-
     angm     = std::vector<dvector>(comp->ncomp);
-    angm1    = std::vector<dvector>(comp->ncomp);
-
-    ctr = std::vector<dvector>(comp->ncomp);
+    ctr      = std::vector<dvector>(comp->ncomp);
 
     for (int i=0; i<comp->ncomp; i++) {
       com   [i] = std::vector<double>(3);
-      com1  [i] = std::vector<double>(3);
       cov   [i] = std::vector<double>(3);
-      cov1  [i] = std::vector<double>(3);
       angm  [i] = std::vector<double>(3);
-      angm1 [i] = std::vector<double>(3);
       ctr   [i] = std::vector<double>(3);
     }
 
     com0      = std::vector<double>(3);
     cov0      = std::vector<double>(3);
-    angmG     = std::vector<double>(3);
     angm0     = std::vector<double>(3);
-    pos0      = std::vector<double>(3);
-    vel0      = std::vector<double>(3);
-
-    posL      = std::vector<double>(3);
-    velL      = std::vector<double>(3);
-
-    comG      = std::vector<double>(3);
-    covG      = std::vector<double>(3);
 
     ektot     = std::vector<double>(comp->ncomp);
-    ektot1    = std::vector<double>(comp->ncomp);
     eptot     = std::vector<double>(comp->ncomp);
-    eptot1    = std::vector<double>(comp->ncomp);
     eptotx    = std::vector<double>(comp->ncomp);
-    eptotx1   = std::vector<double>(comp->ncomp);
     clausius  = std::vector<double>(comp->ncomp);
-    clausius1 = std::vector<double>(comp->ncomp);
+
+    moments .resize(comp->ncomp*nmom);
+    moments0.resize(comp->ncomp*nmom);
 
     if (myid==0) {
 
@@ -393,8 +375,13 @@ void OutLog::Run(int n, int mstep, bool last)
   } // END: firstime
 
 
-  if (n % nint && !last) return;
-  if (multistep>1 and mstep % nintsub !=0) return;
+  if (dtime>0.0) {
+    if (tnow < tlast + dtime && !last) return;
+    tlast = tnow;
+  } else {
+    if (n % nint && !last) return;
+    if (multistep>1 and mstep % nintsub !=0) return;
+  }
 
 
 				// Use MPI wall clock to time step
@@ -407,135 +394,61 @@ void OutLog::Run(int n, int mstep, bool last)
     laststep = n;
   }
 
-				// Zero out accumulators
-  for (int i=0; i<comp->ncomp; i++) {
-
-    nbodies [i] = nbodies1 [i] = 0;
-    used    [i] = used1    [i] = 0;
-    mtot    [i] = mtot1    [i] = 0.0;
-    ektot   [i] = ektot1   [i] = 0.0;
-    eptot   [i] = eptot1   [i] = 0.0;
-    eptotx  [i] = eptotx1  [i] = 0.0;
-    clausius[i] = clausius1[i] = 0.0;
-
-    for (int j=0; j<3; j++) {
-      com [i][j] = com1 [i][j] = 0.0;
-      cov [i][j] = cov1 [i][j] = 0.0;
-      angm[i][j] = angm1[i][j] = 0.0;
-    }
-
-  }
-
-				// Global
-  for (int j=0; j<3; j++) {
-    comG [j] = com0 [j] = 0.0;
-    covG [j] = cov0 [j] = 0.0;
-    angmG[j] = angm0[j] = 0.0;
-  }
+				// Accumulate all moments of each
+				// component in one threaded pass
+  std::fill(moments.begin(), moments.end(), 0.0);
 
-				// Collect info
-  unsigned ntot;
   int indx = 0;
 
   for (auto c : comp->components) {
 
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if (cuda_resident) {	// Only what the log needs
+	c->CudaFetch(Component::cudaPhase | Component::cudaAcc |
+		     Component::cudaPot);
+      } else if (c->force->cudaAware() and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
     }
 #endif
 
-    nbodies1[indx] = c->Number();
-
-    PartMapItr it = c->Particles().begin();
-    unsigned long i;
-
-    for (int q=0; q<nbodies1[indx]; q++) {
-
-      i = (it++)->first;
-
-      if (c->freeze(i)) continue;
-
-      Particle *p = c->Part(i);
-
-      mtot1[indx] +=  p->mass;
-
-      for (int k=0; k<3; k++) {
-	pos0[k] = c->Pos(i, k, Component::Inertial);
-	vel0[k] = c->Vel(i, k, Component::Inertial);
-	posL[k] = c->Pos(i, k, Component::Local);
-	velL[k] = c->Vel(i, k, Component::Local);
-      }
-
-      for (int k=0; k<3; k++) {
-	com1[indx][k] += p->mass*posL[k];
-	cov1[indx][k] += p->mass*velL[k];
-	comG[k] += p->mass*pos0[k];
-	covG[k] += p->mass*vel0[k];
-      }
-
-      angm1[indx][0] += p->mass*(posL[1]*velL[2] - posL[2]*velL[1]);
-      angm1[indx][1] += p->mass*(posL[2]*velL[0] - posL[0]*velL[2]);
-      angm1[indx][2] += p->mass*(posL[0]*velL[1] - posL[1]*velL[0]);
-
-      angmG[0] += p->mass*(pos0[1]*vel0[2] - pos0[2]*vel0[1]);
-      angmG[1] += p->mass*(pos0[2]*vel0[0] - pos0[0]*vel0[2]);
-      angmG[2] += p->mass*(pos0[0]*vel0[1] - pos0[1]*vel0[0]);
-
-      for (int k=0; k<3; k++) pos0[k] = c->Pos(i, k, Component::Centered);
-
-      eptot1[indx]  += 0.5*p->mass*p->pot;
-      eptotx1[indx] += p->mass*p->potext;
-      for (int k=0; k<3; k++) {
-	ektot1[indx]    += 0.5*p->mass*velL[k]*velL[k];
-	clausius1[indx] += p->mass*posL[k]*p->acc[k];
-      }
-    }
+    accumulate(c, &moments[indx*nmom]);
 
     for (int k=0; k<3; k++) ctr[indx][k] = c->center[k];
 
-    used1[indx] = c->force->Used();
+    moments[indx*nmom + 1] = c->force->Used();
 
     indx++;
   }
 				// Send back to Process 0
+  MPI_Reduce(moments.data(), moments0.data(), moments.size(), MPI_DOUBLE,
+	     MPI_SUM, 0, MPI_COMM_WORLD);
 
-  MPI_Reduce(&nbodies1[0], &nbodies[0], comp->ncomp, MPI_INT, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-
-  MPI_Reduce(&mtot1[0], &mtot[0], comp->ncomp, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
+				// Unpack
+  for (int j=0; j<3; j++) com0[j] = cov0[j] = angm0[j] = 0.0;
 
   for (int i=0; i<comp->ncomp; i++) {
-    MPI_Reduce(&com1[i][0], &com[i][0], 3, MPI_DOUBLE, MPI_SUM,
-	       0, MPI_COMM_WORLD);
-    MPI_Reduce(&cov1[i][0], &cov[i][0], 3, MPI_DOUBLE, MPI_SUM,
-	       0, MPI_COMM_WORLD);
-    MPI_Reduce(&angm1[i][0], &angm[i][0], 3, MPI_DOUBLE, MPI_SUM,
-	       0, MPI_COMM_WORLD);
-  }
-
-  MPI_Reduce(&comG[0], &com0[0], 3, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-  MPI_Reduce(&covG[0], &cov0[0], 3, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-  MPI_Reduce(&angmG[0], &angm0[0], 3, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
+    const double *m = &moments0[i*nmom];
 
-  MPI_Reduce(&ektot1[0], &ektot[0], comp->ncomp, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-  MPI_Reduce(&eptot1[0], &eptot[0], comp->ncomp, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-  MPI_Reduce(&eptotx1[0], &eptotx[0], comp->ncomp, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
-  MPI_Reduce(&clausius1[0], &clausius[0], comp->ncomp, MPI_DOUBLE, MPI_SUM,
-	     0, MPI_COMM_WORLD);
+    nbodies [i] = static_cast<int>(m[0]);
+    used    [i] = static_cast<int>(m[1]);
+    mtot    [i] = m[2];
+    ektot   [i] = m[12];
+    eptot   [i] = m[13];
+    eptotx  [i] = m[14];
+    clausius[i] = m[15];
 
-  MPI_Reduce(&used1[0], &used[0], comp->ncomp, MPI_INT, MPI_SUM,
-	     0, MPI_COMM_WORLD);
+    for (int j=0; j<3; j++) {
+      com [i][j] = m[3+j];
+      cov [i][j] = m[6+j];
+      angm[i][j] = m[9+j];
+      com0 [j]  += m[16+j];
+      cov0 [j]  += m[19+j];
+      angm0[j]  += m[22+j];
+    }
+  }
 
 
   if (myid == 0) {
@@ -661,3 +574,98 @@ void OutLog::Run(int n, int mstep, bool last)
   }
 
 }
+
+void OutLog::accumulate(Component* c, double* mom)
+{
+  // All local bodies are in the level list
+  //
+  auto lev = c->levlist.range(0, multistep);
+  const int *seq = lev.begin();
+  const int nbod = lev.size();
+
+  ParticleSoA *soa = c->SoA();
+
+  std::vector<std::vector<double>> acc(nthrds, std::vector<double>(nmom, 0.0));
+
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    double *a = acc[id].data();
+    double pos[3], vel[3], ac[3], posL[3], velL[3], mass, pot, potx;
+
+    int nbeg = static_cast<int>(static_cast<long>(nbod)*id/nthrds);
+    int nend = static_cast<int>(static_cast<long>(nbod)*(id+1)/nthrds);
+
+    for (int q=nbeg; q<nend; q++) {
+
+      unsigned long i = seq[q];
+
+      if (c->freeze(i)) continue;
+
+      // Read the body once, from the SoA store if it is there
+      //
+      int s = soa ? soa->active(i) : -1;
+
+      if (s>=0) {
+	mass = soa->mass[s];
+	pot  = soa->getPot(s);
+	potx = soa->getPotExt(s);
+	for (int k=0; k<3; k++) {
+	  pos[k] = soa->pos[k][s];
+	  vel[k] = soa->vel[k][s];
+	  ac [k] = soa->getAcc(k, s);
+	}
+      } else {
+	auto it = c->Particles().find(i);
+	if (it == c->Particles().end()) continue;
+	Particle *p = it->second.get();
+	mass = p->mass;
+	pot  = p->pot;
+	potx = p->potext;
+	for (int k=0; k<3; k++) {
+	  pos[k] = p->pos[k];
+	  vel[k] = p->vel[k];
+	  ac [k] = p->acc[k];
+	}
+      }
+
+      for (int k=0; k<3; k++) {
+	posL[k] = pos[k];
+	velL[k] = vel[k];
+      }
+      c->ConvertPos(posL, Component::Local);
+      c->ConvertVel(velL, Component::Local);
+
+      a[0] += 1.0;
+      a[2] += mass;
+
+      for (int k=0; k<3; k++) {
+	a[3+k]  += mass*posL[k];
+	a[6+k]  += mass*velL[k];
+	a[16+k] += mass*pos[k];
+	a[19+k] += mass*vel[k];
+      }
+
+      a[9]  += mass*(posL[1]*velL[2] - posL[2]*velL[1]);
+      a[10] += mass*(posL[2]*velL[0] - posL[0]*velL[2]);
+      a[11] += mass*(posL[0]*velL[1] - posL[1]*velL[0]);
+
+      a[22] += mass*(pos[1]*vel[2] - pos[2]*vel[1]);
+      a[23] += mass*(pos[2]*vel[0] - pos[0]*vel[2]);
+      a[24] += mass*(pos[0]*vel[1] - pos[1]*vel[0]);
+
+      a[13] += 0.5*mass*pot;
+      a[14] += mass*potx;
+      for (int k=0; k<3; k++) {
+	a[12] += 0.5*mass*velL[k]*velL[k];
+	a[15] += mass*posL[k]*ac[k];
+      }
+    }
+  });
+
+  for (auto & a : acc)
+    for (int j=0; j<nmom; j++) mom[j] += a[j];
+
+  // The body count includes frozen bodies, as before
+  //
+  mom[0] = c->Number();
+}
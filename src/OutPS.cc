@@ -121,7 +121,7 @@ void OutPS::Run(int n, int mstep, bool last)
   for (auto c : comp->components) {
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
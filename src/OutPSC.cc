@@ -0,0 +1,365 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+#include <highfive/highfive.hpp>
+
+#include "expand.H"
+#include <global.H>
+
+#include <OutPSC.H>
+
+const std::set<std::string>
+OutPSC::valid_keys = {
+  "filename",
+  "nint",
+  "nintsub",
+  "nbeg",
+  "real4",
+  "chunk",
+  "level",
+  "timer"
+};
+
+
+OutPSC::OutPSC(const YAML::Node& conf) : Output(conf)
+{
+  initialize();
+}
+
+void OutPSC::initialize()
+{
+  // Remove matched keys
+  //
+  for (auto v : valid_keys) current_keys.erase(v);
+  
+  // Assign values from YAML
+  //
+  try {
+				// Get file name
+    if (Output::conf["filename"])
+      filename = Output::conf["filename"].as<std::string>();
+    else {
+      filename.erase();
+      filename = "OUT." + runtag;
+    }
+
+    if (Output::conf["nint"])
+      nint = Output::conf["nint"].as<int>();
+    else
+      nint = 100;
+    
+    if (Output::conf["nintsub"]) {
+#ifdef ALLOW_NINTSUB
+      nintsub = Output::conf["nintsub"].as<int>();
+      if (nintsub <= 0) nintsub = 1;
+#else
+      nintsub_warning("OutPSC");
+      nintsub = std::numeric_limits<int>::max();
+#endif
+    } else
+      nintsub = std::numeric_limits<int>::max();
+
+    if (Output::conf["nbeg"])
+      nbeg = Output::conf["nbeg"].as<int>();
+    else
+      nbeg = 0;
+
+    if (Output::conf["real4"])
+      real4 = Output::conf["real4"].as<bool>();
+    else
+      real4 = true;
+
+    if (Output::conf["chunk"])
+      chunk = Output::conf["chunk"].as<int>();
+    else
+      chunk = 1048576;
+
+    if (Output::conf["level"])
+      level = Output::conf["level"].as<int>();
+    else
+      level = 4;
+
+    if (Output::conf["timer"])
+      timer = Output::conf["timer"].as<bool>();
+    else
+      timer = false;
+  }
+  catch (YAML::Exception & error) {
+    if (myid==0) std::cout << "Error parsing parameters in OutPSC: "
+			   << error.what() << std::endl
+			   << std::string(60, '-') << std::endl
+			   << "Config node"        << std::endl
+			   << std::string(60, '-') << std::endl
+			   << conf                 << std::endl
+			   << std::string(60, '-') << std::endl;
+    throw std::runtime_error("OutPSC::initialize: error parsing YAML");
+  }
+
+  chunk = std::max<int>(chunk, 1);
+  level = std::max<int>(0, std::min<int>(9, level));
+
+				// Determine last file
+  if (restart && nbeg==0) {
+    if (myid==0) {
+
+      for (nbeg=0; nbeg<100000; nbeg++) {
+
+				// Output name
+	ostringstream fname;
+	fname << outdir << filename << "." << setw(5) << setfill('0') << nbeg;
+
+				// See if we can open file
+	ifstream in(fname.str().c_str());
+	
+	if (!in) {
+	  cout << "OutPSC: will begin with nbeg=" << nbeg << endl;
+	  break;
+	}
+      }
+    }
+				// All nodes need nbeg for the blob names
+    MPI_Bcast(&nbeg, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  }
+
+}
+
+
+//! Write one field as a chunked, shuffled and deflated dataset with
+//! mult values per body
+template<typename T>
+static void writeField(HighFive::Group& grp, const std::string& name,
+		       const std::vector<T>& v, size_t chunk, int mult,
+		       int level)
+{
+  HighFive::DataSetCreateProps props;
+  props.add(HighFive::Chunking(std::vector<hsize_t>
+			       {std::min<hsize_t>(chunk*mult, v.size())}));
+  props.add(HighFive::Shuffle());
+  props.add(HighFive::Deflate(level));
+
+  grp.createDataSet<T>(name, HighFive::DataSpace({v.size()}), props).write(v);
+}
+
+//! Copy the fields of the bodies in plist into a blob group
+template<typename T>
+static void writeFields(HighFive::Group& grp, std::vector<PartPtr>& plist,
+			int niatr, int ndatr, size_t chunk, int level)
+{
+  size_t N = plist.size();
+
+  std::vector<unsigned long> indx(N);
+  std::vector<T> mass(N), pos(3*N), vel(3*N), pot(N), dattrib(N*ndatr);
+  std::vector<int> iattrib(N*niatr);
+
+  for (size_t n=0; n<N; n++) {
+    auto & p = plist[n];
+    indx[n] = p->indx;
+    mass[n] = p->mass;
+    pot [n] = p->pot + p->potext;
+    for (int k=0; k<3; k++) {
+      pos[3*n+k] = p->pos[k];
+      vel[3*n+k] = p->vel[k];
+    }
+    for (int k=0; k<niatr; k++) iattrib[n*niatr+k] = p->iattrib[k];
+    for (int k=0; k<ndatr; k++) dattrib[n*ndatr+k] = p->dattrib[k];
+  }
+
+  writeField(grp, "indx", indx, chunk, 1, level);
+  writeField(grp, "mass", mass, chunk, 1, level);
+  writeField(grp, "pos",  pos,  chunk, 3, level);
+  writeField(grp, "vel",  vel,  chunk, 3, level);
+  writeField(grp, "pot",  pot,  chunk, 1, level);
+  if (niatr) writeField(grp, "iattrib", iattrib, chunk, niatr, level);
+  if (ndatr) writeField(grp, "dattrib", dattrib, chunk, ndatr, level);
+}
+
+
+void OutPSC::Run(int n, int mstep, bool last)
+{
+  if (!dump_signal and !last) {
+    if (n % nint) return;
+    if (restart && n==0) return;
+    if (multistep>1 && mstep % nintsub !=0 ) return;
+  }
+
+  std::chrono::high_resolution_clock::time_point beg, end;
+  if (timer) beg = std::chrono::high_resolution_clock::now();
+
+  // Output names: the blob names are relative to the master
+  //
+  std::ostringstream fname;
+  fname << filename << "." << setw(5) << setfill('0') << nbeg++;
+
+  std::ostringstream bname;
+  bname << fname.str() << "-" << myid;
+
+  // Chunk index entries: blob, first, count, rmin, rmax, xmin, xmax,
+  // ymin, ymax, zmin, zmax
+  //
+  const int nidx = 11;
+
+  int nOK = 0;
+
+  try {
+    HighFive::File blob(outdir + bname.str(),
+			HighFive::File::ReadWrite | HighFive::File::Create |
+			HighFive::File::Truncate);
+
+    std::shared_ptr<HighFive::File> master;
+    if (myid==0) {
+      master = std::make_shared<HighFive::File>
+	(outdir + fname.str(),
+	 HighFive::File::ReadWrite | HighFive::File::Create |
+	 HighFive::File::Truncate);
+
+      std::vector<std::string> blobs;
+      for (int i=0; i<numprocs; i++)
+	blobs.push_back(fname.str() + "-" + std::to_string(i));
+
+      double time = tnow;
+      int ncomp = comp->ncomp, nchunk = chunk;
+      master->createAttribute<double>("Time",  HighFive::DataSpace::From(time)).write(time);
+      master->createAttribute<int>   ("Ncomp", HighFive::DataSpace::From(ncomp)).write(ncomp);
+      master->createAttribute<int>   ("Chunk", HighFive::DataSpace::From(nchunk)).write(nchunk);
+      master->createAttribute<std::string>("Blobs", HighFive::DataSpace::From(blobs)).write(blobs);
+    }
+
+    int count = 0;
+    for (auto c : comp->components) {
+
+#ifdef HAVE_LIBCUDA
+      if (use_cuda) {
+	if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
+	  comp->fetched[c] = true;
+	  c->CudaToParticles();
+	}
+      }
+#endif
+
+      std::string gname = "Component_" + std::to_string(count++);
+
+      // Order the local bodies by radius so that the chunks are
+      // radial shells
+      //
+      std::vector<std::pair<double, PartPtr>> work;
+      for (auto & v : c->Particles()) {
+	auto & p = v.second;
+	double r2 = 0.0;
+	for (int k=0; k<3; k++) r2 += p->pos[k]*p->pos[k];
+	work.push_back({r2, p});
+      }
+      std::sort(work.begin(), work.end(),
+		[](const std::pair<double, PartPtr>& a,
+		   const std::pair<double, PartPtr>& b)
+		{ return a.first < b.first; });
+
+      std::vector<PartPtr> plist;
+      for (auto & v : work) plist.push_back(v.second);
+
+      HighFive::Group grp = blob.createGroup(gname);
+
+      if (plist.size()) {
+	if (real4)
+	  writeFields<float >(grp, plist, c->niattrib, c->ndattrib, chunk, level);
+	else
+	  writeFields<double>(grp, plist, c->niattrib, c->ndattrib, chunk, level);
+      }
+
+      // Summarize the chunks
+      //
+      std::vector<double> index;
+      for (size_t first=0; first<plist.size(); first+=chunk) {
+	size_t n = std::min<size_t>(chunk, plist.size() - first);
+	double lo[3], hi[3];
+	for (int k=0; k<3; k++) {
+	  lo[k] =  std::numeric_limits<double>::max();
+	  hi[k] = -std::numeric_limits<double>::max();
+	}
+	for (size_t j=first; j<first+n; j++) {
+	  for (int k=0; k<3; k++) {
+	    lo[k] = std::min<double>(lo[k], plist[j]->pos[k]);
+	    hi[k] = std::max<double>(hi[k], plist[j]->pos[k]);
+	  }
+	}
+	index.push_back(myid);
+	index.push_back(first);
+	index.push_back(n);
+	index.push_back(sqrt(work[first].first));
+	index.push_back(sqrt(work[first+n-1].first));
+	for (int k=0; k<3; k++) {
+	  index.push_back(lo[k]);
+	  index.push_back(hi[k]);
+	}
+      }
+
+      // Gather the chunk index to the root
+      //
+      int mine = index.size();
+      std::vector<int> sizes(numprocs), displ(numprocs);
+      MPI_Gather(&mine, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+      std::vector<double> all;
+      if (myid==0) {
+	int tot = 0;
+	for (int i=0; i<numprocs; i++) {
+	  displ[i] = tot;
+	  tot += sizes[i];
+	}
+	all.resize(tot);
+      }
+
+      MPI_Gatherv(index.data(), mine, MPI_DOUBLE,
+		  all.data(), sizes.data(), displ.data(), MPI_DOUBLE,
+		  0, MPI_COMM_WORLD);
+
+      if (myid==0) {
+	HighFive::Group cgrp = master->createGroup(gname);
+
+	std::ostringstream outs;
+	outs << c->conf;
+
+	std::string cname = c->name, config = outs.str();
+	int niatr = c->niattrib, ndatr = c->ndattrib, r4 = real4;
+	unsigned long nbod = c->CurTotal(), nchunks = all.size()/nidx;
+
+	cgrp.createAttribute<std::string>("name",   HighFive::DataSpace::From(cname)).write(cname);
+	cgrp.createAttribute<std::string>("config", HighFive::DataSpace::From(config)).write(config);
+	cgrp.createAttribute<int>("niatr", HighFive::DataSpace::From(niatr)).write(niatr);
+	cgrp.createAttribute<int>("ndatr", HighFive::DataSpace::From(ndatr)).write(ndatr);
+	cgrp.createAttribute<int>("real4", HighFive::DataSpace::From(r4)).write(r4);
+	cgrp.createAttribute<unsigned long>("nbod", HighFive::DataSpace::From(nbod)).write(nbod);
+	cgrp.createAttribute<unsigned long>("nchunks", HighFive::DataSpace::From(nchunks)).write(nchunks);
+
+	if (nchunks) cgrp.createDataSet("chunks", all);
+      }
+    }
+
+  } catch (HighFive::Exception& err) {
+    std::cerr << "[" << myid << "] OutPSC: error writing <"
+	      << outdir + bname.str() << ">: " << err.what() << std::endl;
+    nOK = 1;
+  }
+
+  int badCount = 0;
+  MPI_Allreduce(&nOK, &badCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (badCount) {
+    throw std::runtime_error("OutPSC::Run: error in I/O");
+  }
+
+  chktimer.mark();
+
+  dump_signal = 0;
+
+  if (timer) {
+    end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> intvl = end - beg;
+    if (myid==0)
+      std::cout << "OutPSC [T=" << tnow << "] timing=" << intvl.count()
+		<< std::endl;
+  }
+}
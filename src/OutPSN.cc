@@ -18,6 +18,8 @@ OutPSN::valid_keys = {
   "nbeg",
   "real4",
   "timer",
+  "async",
+  "asyncmb"
 };
 
 OutPSN::OutPSN(const YAML::Node& conf) : Output(conf)
@@ -72,6 +74,18 @@ void OutPSN::initialize()
       timer = Output::conf["timer"].as<bool>();
     else
       timer = false;
+
+    if (Output::conf["async"])
+      async = Output::conf["async"].as<bool>();
+    else
+      async = false;
+
+    if (Output::conf["asyncmb"])
+      asyncmb = Output::conf["asyncmb"].as<double>();
+    else
+      asyncmb = 2048.0;
+
+    if (async) writer = std::make_shared<AsyncWriter>(asyncmb);
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutPSN: "
@@ -123,6 +137,41 @@ void OutPSN::Run(int n, int mstep, bool last)
 
   int nOK = 0;
 
+  // Stage the dump and write it in the background if it fits.  The
+  // name is only known to the root.
+  //
+  if (async) {
+    if (myid==0)
+      fname << filename << "." << setw(5) << setfill('0') << nbeg;
+
+    bool staged = async_dump(fname.str(), real4);
+
+    if (not staged and myid==0)
+      std::cout << "OutPSN: dump exceeds the staging budget, "
+		<< "writing synchronously" << std::endl;
+
+    fname.str("");
+
+    if (staged) {
+      if (myid==0) nbeg++;
+      if (last) writer->wait();
+
+      chktimer.mark();
+
+      dump_signal = 0;
+
+      if (timer) {
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> intvl = end - beg;
+	if (myid==0)
+	  std::cout << "OutPSN [T=" << tnow << "] staging=" << intvl.count()
+		    << std::endl;
+      }
+
+      return;
+    }
+  }
+
   if (myid==0) {
 				// Output name
     fname << filename << "." << setw(5) << setfill('0') << nbeg++;
@@ -158,7 +207,7 @@ void OutPSN::Run(int n, int mstep, bool last)
   for (auto c : comp->components) {
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
@@ -18,7 +18,9 @@ OutPSP::valid_keys = {
   "nbeg",
   "real4",
   "timer",
-  "nagg"
+  "nagg",
+  "async",
+  "asyncmb"
 };
 
 
@@ -79,6 +81,18 @@ void OutPSP::initialize()
       nagg = Output::conf["nagg"].as<std::string>();
     else
       nagg = "1";
+
+    if (Output::conf["async"])
+      async = Output::conf["async"].as<bool>();
+    else
+      async = false;
+
+    if (Output::conf["asyncmb"])
+      asyncmb = Output::conf["asyncmb"].as<double>();
+    else
+      asyncmb = 2048.0;
+
+    if (async) writer = std::make_shared<AsyncWriter>(asyncmb);
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutPSP: "
@@ -144,6 +158,34 @@ void OutPSP::Run(int n, int mstep, bool last)
   ostringstream fname;
   fname << filename << "." << setw(5) << setfill('0') << nbeg++;
 
+  // Stage the dump and write it in the background if it fits
+  //
+  if (async) {
+    bool staged = async_dump(fname.str(), real4);
+
+    if (not staged and myid==0)
+      std::cout << "OutPSP: dump exceeds the staging budget, "
+		<< "writing synchronously" << std::endl;
+
+    if (staged) {
+      if (last) writer->wait();
+
+      chktimer.mark();
+
+      dump_signal = 0;
+
+      if (timer) {
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> intvl = end - beg;
+	if (myid==0)
+	  std::cout << "OutPSP [T=" << tnow << "] staging=" << intvl.count()
+		    << std::endl;
+      }
+
+      return;
+    }
+  }
+
   // return info about errors (for debugging)
   MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN); 
 
@@ -18,7 +18,9 @@ OutPSQ::valid_keys = {
   "nbeg",
   "real4",
   "timer",
-  "threads"
+  "threads",
+  "aggregate",
+  "align"
 };
 
 OutPSQ::OutPSQ(const YAML::Node& conf) : Output(conf)
@@ -26,6 +28,11 @@ OutPSQ::OutPSQ(const YAML::Node& conf) : Output(conf)
   initialize();
 }
 
+OutPSQ::~OutPSQ()
+{
+  if (aggregate) MPI_Comm_free(&aggComm);
+}
+
 void OutPSQ::initialize()
 {
   // Remove matched keys
@@ -78,6 +85,16 @@ void OutPSQ::initialize()
       threads = Output::conf["threads"].as<int>();
     else
       threads = 0;
+
+    if (Output::conf["aggregate"])
+      aggregate = Output::conf["aggregate"].as<int>();
+    else
+      aggregate = 0;
+
+    if (Output::conf["align"])
+      align = std::max<int>(1, Output::conf["align"].as<int>());
+    else
+      align = 4096;
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutPSQ: "
@@ -90,6 +107,20 @@ void OutPSQ::initialize()
     throw std::runtime_error("OutPSQ::initialize: error parsing YAML");
   }
 
+  // Group the processes for aggregated writes: by node or by blocks
+  // of consecutive ranks
+  //
+  if (aggregate) {
+    if (aggregate < 0)
+      MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myid,
+			  MPI_INFO_NULL, &aggComm);
+    else
+      MPI_Comm_split(MPI_COMM_WORLD, myid/aggregate, myid, &aggComm);
+
+    aggRoot = myid;
+    MPI_Bcast(&aggRoot, 1, MPI_INT, 0, aggComm);
+  }
+
 
   // Determine last file
   // 
@@ -154,8 +185,10 @@ void OutPSQ::Run(int n, int mstep, bool last)
 		<< "> . . . quitting" << std::endl;
       nOK = 1;
     }
-				// Used by OutCHKPT to not duplicate a dump
-    if (not real4) lastPSQ = fname.str();
+				// Used by OutCHKPT to not duplicate a
+				// dump; OutCHKPTQ links per-process
+				// pieces, so not for aggregated files
+    if (not real4 and not aggregate) lastPSQ = fname.str();
 				// Open file and write master header
     if (nOK==0) {
       struct MasterHeader header;
@@ -178,7 +211,7 @@ void OutPSQ::Run(int n, int mstep, bool last)
 
 #ifdef HAVE_LIBCUDA
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
@@ -191,32 +224,56 @@ void OutPSQ::Run(int n, int mstep, bool last)
     std::ostringstream cname;
     cname << fname.str() << "_" << count++;
     
-    if (myid==0) {
+    if (myid==0 and not aggregate) {
       c->write_binary_header(&out, real4, cname.str());
     }
 
-    cname << "-" << myid;
+    std::string blob;
+
+    if (aggregate) {
+      blob = writeAggregated(c, cname.str(), nOK);
+    } else {
+
+      cname << "-" << myid;
     
 				// Open particle file and write
-    std::string blobfile = outdir + cname.str();
-    std::ofstream pout(blobfile);
+      std::string blobfile = outdir + cname.str();
+      std::ofstream pout(blobfile);
 
-    if (pout.fail()) {
-      std::cerr << "[" << myid << "] OutPSQ: can't open file <" << cname.str() 
-		<< "> . . . quitting" << std::endl;
-      nOK = 1;
-    } else {
-      if (threads)
-	c->write_binary_particles(&pout, threads, real4);
-      else
-	c->write_binary_particles(&pout, real4);
       if (pout.fail()) {
-	std::cout << "OutPSQ: error writing binary particles to <"
-		  << blobfile << std::endl;
+	std::cerr << "[" << myid << "] OutPSQ: can't open file <" << cname.str() 
+		  << "> . . . quitting" << std::endl;
+	nOK = 1;
+      } else {
+	if (threads)
+	  c->write_binary_particles(&pout, threads, real4);
+	else
+	  c->write_binary_particles(&pout, real4);
+	if (pout.fail()) {
+	  std::cout << "OutPSQ: error writing binary particles to <"
+		    << blobfile << std::endl;
+	}
+      }
+    }
+
+				// The root lists the blobs of all
+				// processes in the header
+    if (aggregate) {
+      const int PBUF_SIZ = 1024;
+      std::vector<char> names;
+      if (myid==0) names.resize(PBUF_SIZ*numprocs);
+      blob.resize(PBUF_SIZ, '\0');
+      MPI_Gather(blob.data(), PBUF_SIZ, MPI_CHAR,
+		 names.data(), PBUF_SIZ, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+      if (myid==0) {
+	std::vector<std::string> blobs;
+	for (int n=0; n<numprocs; n++)
+	  blobs.push_back(std::string(&names[PBUF_SIZ*n]));
+	c->write_binary_header(&out, real4, blobs);
       }
     }
 
-    
 				// Check for errors in all file opening
     int sumOK;
     MPI_Allreduce(&nOK, &sumOK, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
@@ -255,3 +312,83 @@ void OutPSQ::Run(int n, int mstep, bool last)
   }
 }
 
+
+std::string OutPSQ::writeAggregated(Component* c, const std::string& prefix,
+				    int& nOK)
+{
+  // Serialize this process' particles, padded to the alignment
+  //
+  std::ostringstream sout;
+  if (threads)
+    c->write_binary_particles(&sout, threads, real4);
+  else
+    c->write_binary_particles(&sout, real4);
+
+  std::string data = sout.str();
+  data.resize((data.size() + align - 1)/align*align, '\0');
+
+  // Offsets of the blobs in the group file follow from rank order
+  //
+  int gid, gsize;
+  MPI_Comm_rank(aggComm, &gid);
+  MPI_Comm_size(aggComm, &gsize);
+
+  unsigned long size = data.size(), offset = 0;
+  std::vector<unsigned long> sizes(gsize);
+  MPI_Allgather(&size, 1, MPI_UNSIGNED_LONG, sizes.data(), 1,
+		MPI_UNSIGNED_LONG, aggComm);
+  for (int n=0; n<gid; n++) offset += sizes[n];
+
+  std::string file = prefix + "-" + std::to_string(aggRoot);
+
+  // Messages are sent in pieces that fit an int count
+  //
+  const unsigned long maxMsg = 1ul << 30;
+
+  if (gid) {
+    for (unsigned long b=0; b<size; b+=maxMsg)
+      MPI_Send(&data[b], std::min(maxMsg, size-b), MPI_CHAR, 0, 122, aggComm);
+    return file + "@" + std::to_string(offset);
+  }
+
+  // The writer: receive each member's buffer while the previous one
+  // is written
+  //
+  std::ofstream pout(outdir + file, std::ios::binary);
+  if (pout.fail()) {
+    std::cerr << "[" << myid << "] OutPSQ: can't open file <" << file
+	      << "> . . . quitting" << std::endl;
+    nOK = 1;
+  }
+
+  std::string next;
+  std::vector<MPI_Request> req;
+
+  auto post = [&](int n) {
+    next.resize(sizes[n]);
+    req.clear();
+    for (unsigned long b=0; b<sizes[n]; b+=maxMsg) {
+      req.emplace_back();
+      MPI_Irecv(&next[b], std::min(maxMsg, sizes[n]-b), MPI_CHAR, n, 122,
+		aggComm, &req.back());
+    }
+  };
+
+  if (gsize>1) post(1);
+
+  for (int n=0; n<gsize; n++) {
+    if (n) {
+      MPI_Waitall(req.size(), req.data(), MPI_STATUSES_IGNORE);
+      data.swap(next);
+      if (n+1<gsize) post(n+1);
+    }
+    if (nOK==0) pout.write(data.data(), data.size());
+  }
+
+  if (nOK==0 and pout.fail()) {
+    std::cout << "OutPSQ: error writing binary particles to <"
+	      << file << std::endl;
+  }
+
+  return file + "@0";
+}
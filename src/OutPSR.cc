@@ -207,7 +207,7 @@ void OutPSR::Run(int n, int mstep, bool last)
 #ifdef HAVE_LIBCUDA
   for (auto c : comp->components) {
     if (use_cuda) {
-      if (c->force->cudaAware() and not comp->fetched[c]) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
 	comp->fetched[c] = true;
 	c->CudaToParticles();
       }
@@ -3,6 +3,8 @@
 #include <fstream>
 #include <iomanip>
 
+#include <H5public.h>
+
 #include <expand.H>
 
 #include <OutVel.H>
@@ -21,7 +23,8 @@ OutVel::valid_keys = {
   "delta",
   "lmax",
   "nmax",
-  "model"
+  "model",
+  "async"
 };
 
 OutVel::OutVel(const YAML::Node& conf) : Output(conf)
@@ -32,6 +35,7 @@ OutVel::OutVel(const YAML::Node& conf) : Output(conf)
   nintsub = std::numeric_limits<int>::max();
   tcomp   = NULL;
   dof     = 3;
+  async   = true;
 
   // Retrieve parameters
   //
@@ -87,6 +91,7 @@ void OutVel::initialize()
   try {
     if (conf["dof"])          dof      = conf["dof"  ].as<int>();
     if (conf["nint"])         nint     = conf["nint" ].as<int>();
+    if (conf["async"])        async    = conf["async"].as<bool>();
 
     if (conf["nintsub"]) {
       nintsub  = conf["nintsub"].as<int>();
@@ -121,6 +126,15 @@ void OutVel::initialize()
 
     if (conf["modelname"]) modelname = conf["modelname"].as<std::string>();
 
+    // The background writer needs a thread-safe HDF5 library since
+    // other outputs may use HDF5 at the same time
+    //
+    hbool_t safe = 0;
+    if (async and (H5is_library_threadsafe(&safe) < 0 or not safe)) {
+      if (myid==0) std::cout << "OutVel: the HDF5 library is not thread "
+			     << "safe; writing synchronously" << std::endl;
+      async = false;
+    }
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in OutVel: "
@@ -152,68 +166,72 @@ void OutVel::Run(int n, int mstep, bool last)
   //
   prev = tnow;
 
-  // Zero coefficients
+  // Zero coefficients and start a new coefficient structure, so that
+  // the one being written is not modified
   //
-  basis->reset_coefs();
+  basis->initFromArray();
     
-  // Compute coefficients
-  //
-  PartMapItr ibeg = tcomp->Particles().begin();
-  PartMapItr iend = tcomp->Particles().end();
-
-  constexpr std::complex<double> I(0.0, 1.0);
-
-#pragma omp parallel
-  {
-    for (PartMapItr it=ibeg; it!=iend; ++it) {
-      
-      // Execute block for one particle at a time...
-#pragma omp single nowait
-      {
-	double M = it->second->mass;
-
-	double x = it->second->pos[0];
-	double y = it->second->pos[1];
-	double z = it->second->pos[2];
-	
-	double u = it->second->vel[0];
-	double v = it->second->vel[1];
-	double w = it->second->vel[2];
-	
-	basis->accumulate(M, x, y, z, u, v, w);
-      }
+  // Gather the particles for the batched accumulation
+  //
+  auto & parts = tcomp->Particles();
+  std::vector<double> mass, pos, vel;
+  mass.reserve(parts.size());
+  pos .reserve(3*parts.size());
+  vel .reserve(3*parts.size());
+
+  for (auto & p : parts) {
+    mass.push_back(p.second->mass);
+    for (int k=0; k<3; k++) {
+      pos.push_back(p.second->pos[k]);
+      vel.push_back(p.second->vel[k]);
     }
   }
+
+  // Compute coefficients over the threads
+  //
+  basis->accumulate(mass.size(), mass.data(), pos.data(), vel.data());
   
-  // Make coefficients and enter in coefficient DB
+  // Make coefficients.  Collective.
   //
-  coefs->add(basis->makeFromArray(tnow));
+  auto coef = basis->makeFromArray(tnow);
 
   // Only root node writes the coefficient file
   //
   if (myid==0) {
+				// One write in flight at a time
+    if (writer.joinable()) writer.join();
 
-    // Check if file exists and extend the existing HDF5 file
-    //
-    if (std::filesystem::exists(outfile)) {
-      if (dof==2)
-	std::dynamic_pointer_cast<CoefClasses::CylFldCoefs>(coefs)->
-	  ExtendH5Coefs(outfile);
-      else
-	std::dynamic_pointer_cast<CoefClasses::SphFldCoefs>(coefs)->
-	  ExtendH5Coefs(outfile);
-    }
-    // Otherwise, write a new HDF5 coefficient file
+    // The container holds only the new coefficients so that each
+    // write appends one time
     //
-    else {
-      if (dof==2)
-	std::dynamic_pointer_cast<CoefClasses::CylFldCoefs>(coefs)->
-	  WriteH5Coefs(outfile);
-      else
-	std::dynamic_pointer_cast<CoefClasses::SphFldCoefs>(coefs)->
-	  WriteH5Coefs(outfile);
-    }
+    coefs->clear();
+    coefs->add(coef);
+
+    if (async and not last) writer = std::thread(&OutVel::write, this);
+    else write();
   }
-  // END: write to file
 }
 
+void OutVel::write()
+{
+  // Check if file exists and extend the existing HDF5 file
+  //
+  if (std::filesystem::exists(outfile)) {
+    if (dof==2)
+      std::dynamic_pointer_cast<CoefClasses::CylFldCoefs>(coefs)->
+	ExtendH5Coefs(outfile);
+    else
+      std::dynamic_pointer_cast<CoefClasses::SphFldCoefs>(coefs)->
+	ExtendH5Coefs(outfile);
+  }
+  // Otherwise, write a new HDF5 coefficient file
+  //
+  else {
+    if (dof==2)
+      std::dynamic_pointer_cast<CoefClasses::CylFldCoefs>(coefs)->
+	WriteH5Coefs(outfile);
+    else
+      std::dynamic_pointer_cast<CoefClasses::SphFldCoefs>(coefs)->
+	WriteH5Coefs(outfile);
+  }
+}
@@ -1,3 +1,6 @@
+#include <cstring>
+#include <fstream>
+
 #include "expand.H"
 #include <Output.H>
 
@@ -7,3 +10,142 @@ Output::Output(const YAML::Node& CONF) : conf(CONF)
   nint = 50;			// Default interval
   nintsub = std::numeric_limits<int>::max();
 }
+
+bool Output::async_dump(const std::string& fname, bool real4)
+{
+  // Staged bytes on this process
+  //
+  size_t bytes = myid ? 0 : sizeof(MasterHeader);
+
+  for (auto c : comp->components) {
+#ifdef HAVE_LIBCUDA
+    if (use_cuda) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
+	comp->fetched[c] = true;
+	c->CudaToParticles();
+      }
+    }
+#endif
+    bytes += c->stage_size(real4);
+  }
+
+  if (not writer->reserve(bytes)) return false;
+
+  // Master header
+  //
+  if (myid==0) {
+    struct MasterHeader header;
+    header.time  = tnow;
+    header.ntot  = comp->ntot;
+    header.ncomp = comp->ncomp;
+
+    memcpy(writer->append(0, sizeof(MasterHeader)), &header,
+	   sizeof(MasterHeader));
+  }
+
+  size_t offset = sizeof(MasterHeader);
+
+  for (auto c : comp->components)
+    c->write_binary_stage(*writer, offset, real4);
+
+  writer->start(fname);
+
+  return true;
+}
+
+void Output::delta_dump(const std::string& fname, const std::string& base,
+			double basetime, bool spl, const std::vector<int>& dyn)
+{
+  char err[MPI_MAX_ERROR_STRING];
+  MPI_Status status;
+  MPI_File   file;
+  int        len;
+  int        nOK = 0;
+
+  MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
+
+  int ret =
+    MPI_File_open(MPI_COMM_WORLD, fname.c_str(),
+		  MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_UNIQUE_OPEN,
+		  MPI_INFO_NULL, &file);
+
+  if (ret != MPI_SUCCESS) {
+    std::cerr << "Output::delta_dump: rank [" << myid << "] can't open file <"
+	      << fname << "> . . . quitting" << std::endl;
+    nOK = 1;
+  }
+
+  int badCount = 0;
+  MPI_Allreduce(&nOK, &badCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (badCount) {
+    throw std::runtime_error("Output::delta_dump: error in I/O");
+  }
+
+  // A shorter file may already exist under this name
+  //
+  MPI_File_set_size(file, 0);
+
+  if (myid==0) {
+    DeltaHeader header;
+    memset(&header, 0, sizeof(DeltaHeader));
+    header.tag      = DeltaHeader::magic;
+    header.time     = tnow;
+    header.basetime = basetime;
+    header.ntot     = comp->ntot;
+    header.ncomp    = comp->ncomp;
+    header.spl      = spl ? 1 : 0;
+    strncpy(header.base, base.c_str(), DeltaHeader::namesize-1);
+
+    ret = MPI_File_write_at(file, 0, &header, sizeof(DeltaHeader),
+			    MPI_CHAR, &status);
+
+    if (ret != MPI_SUCCESS) {
+      MPI_Error_string(ret, err, &len);
+      std::cout << "Output::delta_dump: WRITE header " << err
+		<< " at line " << __LINE__ << std::endl;
+    }
+  }
+
+  MPI_Offset offset = sizeof(DeltaHeader);
+
+  for (auto c : comp->components) {
+#ifdef HAVE_LIBCUDA
+    if (use_cuda) {
+      if ((c->force->cudaAware() or cuda_resident) and not comp->fetched[c]) {
+	comp->fetched[c] = true;
+	c->CudaToParticles();
+      }
+    }
+#endif
+    c->write_delta_mpi(file, offset, dyn);
+  }
+
+  ret = MPI_File_sync(file);
+
+  if (ret != MPI_SUCCESS) {
+    MPI_Error_string(ret, err, &len);
+    std::cout << "Output::delta_dump: SYNC " << err
+	      << " at line " << __LINE__ << std::endl;
+  }
+
+  ret = MPI_File_close(&file);
+
+  if (ret != MPI_SUCCESS) {
+    MPI_Error_string(ret, err, &len);
+    std::cout << "Output::delta_dump: CLOSE " << err
+	      << " at line " << __LINE__ << std::endl;
+  }
+}
+
+std::string Output::delta_base(const std::string& fname)
+{
+  std::ifstream in(fname);
+  DeltaHeader header;
+
+  in.read((char *)&header, sizeof(DeltaHeader));
+  if (in.fail() or header.tag != DeltaHeader::magic) return "";
+
+  header.base[DeltaHeader::namesize-1] = 0;
+  return header.base;
+}
@@ -10,8 +10,11 @@
 #include <OutPSN.H>
 #include <OutPSP.H>
 #include <OutPSQ.H>
+#include <OutPSC.H>
+#include <OutHDF5.H>
 #include <OutPSR.H>
 #include <OutVel.H>
+#include <OutInSitu.H>
 #include <OutAscii.H>
 #include <OutCHKPT.H>
 #include <OutCHKPTQ.H>
@@ -71,6 +74,14 @@ void OutputContainer::initialize(void)
 	out.push_back(new OutPSQ (node));
       }
     
+      else if ( !name.compare("outpsc") ) {
+	out.push_back(new OutPSC (node));
+      }
+    
+      else if ( !name.compare("outhdf5") ) {
+	out.push_back(new OutHDF5 (node));
+      }
+    
       else if ( !name.compare("outpsr") ) {
 	out.push_back(new OutPSR (node));
       }
@@ -79,6 +90,10 @@ void OutputContainer::initialize(void)
 	out.push_back(new OutVel (node));
       }
     
+      else if ( !name.compare("outinsitu") ) {
+	out.push_back(new OutInSitu (node));
+      }
+    
       else if ( !name.compare("outascii") ) {
 	out.push_back(new OutAscii(node));
       }
@@ -159,9 +174,30 @@ void OutputContainer::Run(int nstep, int mstep, bool final)
   
   cproc.clear();		// Delete the threads
 
+  // At a multistep sub step, the levels that are not synchronized
+  // have drifted past tnow.  With posnsync, their positions are
+  // predicted at tnow for the outputs that read them and restored
+  // afterwards.
+  //
+  bool sync = false;
+  if (posnsync and multistep and mstep>0 and mstep<Mstep) {
+    for (auto it : out) if (it->readsSubstep(nstep, mstep)) sync = true;
+  }
+
+  if (sync) predict_positions(mstep, -1);
+
   // Loop through all instances
   //
   for (auto it : out) it->Run(nstep, mstep, final);
+
+  if (sync) {
+    // Writer threads read the host particles
+    //
+    for (auto v : cproc) v->join();
+    cproc.clear();
+
+    predict_positions(mstep, 1);
+  }
   
   // Root node output
   //
@@ -177,6 +213,13 @@ void OutputContainer::Run(int nstep, int mstep, bool final)
     if (final) cout << "\n";
   }
 
+  // Write buffered output after a checkpoint or on a signal
+  //
+  if (flush_signal) {
+    for (auto it : out) it->Flush();
+    flush_signal = 0;
+  }
+
   // Mark: step ran at this time
   //
   last = tnow;
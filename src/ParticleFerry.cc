@@ -2,6 +2,7 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 #include "global.H"
 #include "ParticleFerry.H"
@@ -267,7 +268,8 @@ void ParticleFerry::particleUnpack(PartPtr out, char* buffer)
 
 // Constructor
 //
-ParticleFerry::ParticleFerry(int nimax, int ndmax) : nimax(nimax), ndmax(ndmax)
+ParticleFerry::ParticleFerry(int nimax, int ndmax, ParticlePoolPtr pool) :
+  nimax(nimax), ndmax(ndmax), pool(pool)
 {
 				// Determine size of buffer for a
 				// single particle
@@ -278,13 +280,19 @@ ParticleFerry::ParticleFerry(int nimax, int ndmax) : nimax(nimax), ndmax(ndmax)
 
   bufpos    = 0;
   ibufcount = 0;
+				// Packed particle type for the bulk
+				// exchange
+  MPI_Type_contiguous(bufsiz, MPI_CHAR, &ptype);
+  MPI_Type_commit(&ptype);
 }
 
 // Destructor
 //
 ParticleFerry::~ParticleFerry()
 {
-  // Does nothing
+  int finalized;
+  MPI_Finalized(&finalized);
+  if (not finalized) MPI_Type_free(&ptype);
 }
 
 // Set up for sending <total> number of Particles to node <to> from
@@ -339,7 +347,8 @@ PartPtr ParticleFerry::RecvParticle()
   bufpos -= bufsiz;
   ibufcount--;
 
-  part = std::make_shared<Particle>(nimax, ndmax);
+  if (pool) part = pool->Get(nimax, ndmax);
+  else      part = std::make_shared<Particle>(nimax, ndmax);
   particleUnpack(part, &buf[bufpos]);
   if (part->indx==0 || part->mass<=0.0 || std::isnan(part->mass)) {
     std::cout << "BAD MASS! [indx=" << part->indx
@@ -381,3 +390,111 @@ void ParticleFerry::BufferRecv()
   bufferKeyCheck();
 #endif
 }
+
+void ParticleFerry::Exchange(const std::vector<std::vector<PartPtr>>& send,
+			     std::vector<PartPtr>& recv)
+{
+  // Number of rounds needed by the busiest sender
+  //
+  size_t ntot = 0;
+  for (auto & v : send) ntot += v.size();
+
+  unsigned nround = (ntot + PFbufsz - 1)/PFbufsz, maxround;
+  MPI_Allreduce(&nround, &maxround, 1, MPI_UNSIGNED, MPI_MAX, MPI_COMM_WORLD);
+
+  if (maxround==0) return;
+
+  std::vector<size_t> next(numprocs, 0);
+  std::vector<int> scnt[2], sdsp[2], rcnt[2], rdsp[2];
+  for (int k=0; k<2; k++) {
+    scnt[k].resize(numprocs);
+    sdsp[k].resize(numprocs);
+    rcnt[k].resize(numprocs);
+    rdsp[k].resize(numprocs);
+  }
+
+  MPI_Request req = MPI_REQUEST_NULL;
+  MPI_Status  status;
+  int last = -1;
+
+  // Unpack a completed round
+  //
+  auto unpack = [&](int k)
+  {
+    size_t nrecv = 0;
+    for (auto c : rcnt[k]) nrecv += c;
+
+    for (size_t j=0; j<nrecv; j++) {
+      PartPtr part;
+      if (pool) part = pool->Get(nimax, ndmax);
+      else      part = std::make_shared<Particle>(nimax, ndmax);
+      particleUnpack(part, &rbuf[k][j*bufsiz]);
+      if (part->indx==0 || part->mass<=0.0 || std::isnan(part->mass)) {
+	std::cout << "BAD MASS! [indx=" << part->indx
+		  << ", mass=" << part->mass << "]" << std::endl;
+      }
+      recv.push_back(part);
+    }
+  };
+
+  for (unsigned r=0; r<maxround; r++) {
+
+    int k = r % 2;
+
+    // Fill this round with at most PFbufsz particles, visiting the
+    // destinations in an order rotated by rank so that the first
+    // rounds are not all aimed at process 0
+    //
+    unsigned quota = PFbufsz;
+    std::fill(scnt[k].begin(), scnt[k].end(), 0);
+    for (int m=0; m<numprocs and quota; m++) {
+      int n = (myid + 1 + m) % numprocs;
+      unsigned c = std::min<size_t>(quota, send[n].size() - next[n]);
+      scnt[k][n] = c;
+      quota -= c;
+    }
+
+    size_t nsend = 0;
+    for (int n=0; n<numprocs; n++) {
+      sdsp[k][n] = nsend;
+      nsend  += scnt[k][n];
+    }
+
+    sbuf[k].resize(std::max<size_t>(nsend, 1)*bufsiz);
+
+    for (int n=0; n<numprocs; n++) {
+      char *p = &sbuf[k][sdsp[k][n]*bufsiz];
+      for (int j=0; j<scnt[k][n]; j++, p+=bufsiz)
+	particlePack(send[n][next[n]+j], p);
+      next[n] += scnt[k][n];
+    }
+
+    MPI_Alltoall(scnt[k].data(), 1, MPI_INT, rcnt[k].data(), 1, MPI_INT,
+		 MPI_COMM_WORLD);
+
+    size_t nrecv = 0;
+    for (int n=0; n<numprocs; n++) {
+      rdsp[k][n] = nrecv;
+      nrecv     += rcnt[k][n];
+    }
+
+    rbuf[k].resize(std::max<size_t>(nrecv, 1)*bufsiz);
+
+    // The previous round must be complete before its buffers are
+    // reused; this also bounds the number of rounds in flight to one
+    //
+    if (last>=0) MPI_Wait(&req, &status);
+
+    MPI_Ialltoallv(sbuf[k].data(), scnt[k].data(), sdsp[k].data(), ptype,
+		   rbuf[k].data(), rcnt[k].data(), rdsp[k].data(), ptype,
+		   MPI_COMM_WORLD, &req);
+
+    // Unpack the previous round while this one is in flight
+    //
+    if (last>=0) unpack(last);
+    last = k;
+  }
+
+  MPI_Wait(&req, &status);
+  unpack(last);
+}
@@ -10,6 +10,8 @@
 
 #include <PolarBasis.H>
 #include <MixtureBasis.H>
+#include <ThreadPool.H>
+#include <NodeShared.H>
 
 // #define TMP_DEBUG
 // #define MULTI_DEBUG
@@ -24,10 +26,6 @@ static bool cudaAccelOverride = false;
 static pthread_mutex_t io_lock;
 #endif
 
-pthread_mutex_t PolarBasis::used_lock;
-pthread_mutex_t PolarBasis::cos_coef_lock;
-pthread_mutex_t PolarBasis::sin_coef_lock;
-
 bool PolarBasis::NewCoefs = true;
 
 const std::set<std::string>
@@ -46,7 +44,8 @@ PolarBasis::valid_keys = {
   "mlim",
   "ssfrac",
   "playback",
-  "coefMaster"
+  "coefMaster",
+  "coefShare"
 };
 
 PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) : 
@@ -68,6 +67,7 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   mix              = m;
   geometry         = cylinder;
   coef_dump        = true;
+  chunk_aware      = true;
   NO_M0            = false;
   NO_M1            = false;
   EVEN_M           = false;
@@ -77,6 +77,7 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   ssfrac           = 0.0;
   subset           = false;
   coefMaster       = true;
+  coefShare        = false;
   lastPlayTime     = -std::numeric_limits<double>::max();
 #if HAVE_LIBCUDA==1
   cuda_aware       = true;
@@ -141,7 +142,14 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
       }
 
       // This creates the Coefs instance
-      playback = std::dynamic_pointer_cast<CoefClasses::CylCoefs>(CoefClasses::Coefs::factory(file));
+      // Snapshots are read from H5 files on demand as playback
+      // advances
+      //
+      playback = std::dynamic_pointer_cast<CoefClasses::CylCoefs>
+	(CoefClasses::Coefs::factory(file, 1,
+				      -std::numeric_limits<double>::max(),
+				       std::numeric_limits<double>::max(),
+				      true));
 
       // Check to make sure that has been created
       if (not playback) {
@@ -174,11 +182,22 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 
       if (conf["coefMaster"]) coefMaster = conf["coefMaster"].as<bool>();
 
+      // Each node holds the coefficients once and every process
+      // interpolates them locally, so nothing is broadcast per step
+      if (conf["coefShare"]) coefShare = conf["coefShare"].as<bool>();
+
+      if (coefShare) {
+	playback->shareSeries();
+	coefMaster = false;
+      }
+
       if (myid==0) {
 	std::cout << "---- Playback is ON for Component " << component->name
 		  << " using Force " << component->id << std::endl;
 	if (coefMaster)
 	  std::cout << "---- Playback will use MPI master" << std::endl;
+	if (coefShare)
+	  std::cout << "---- Playback will use node-shared coefficients" << std::endl;
 
 	if (play_cnew)
 	  std::cout << "---- New coefficients will be computed from particles on playback" << std::endl;
@@ -233,6 +252,12 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
       v->setZero();
     }
   }
+
+  // Multistep histories, per-thread differences and the MPI buffers
+  //
+  memtrack.set("coefficients", component->name,
+	       (2 + nthrds)*(multistep+1)*(2*Mmax+1)*nmax*sizeof(double) +
+	       2*sz*sizeof(double));
     
   expcoef .resize(2*Mmax+1);
   expcoef1.resize(2*Mmax+1);
@@ -256,8 +281,6 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
   if (pcavar) {
     muse1 = vector<double>(nthrds, 0.0);
     muse0 = 0.0;
-
-    pthread_mutex_init(&cc_lock, NULL);
   }
 
   // Potential and deriv matrices
@@ -332,10 +355,6 @@ PolarBasis::PolarBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) :
 
 PolarBasis::~PolarBasis()
 {
-  if (pcavar) {
-    pthread_mutex_destroy(&cc_lock);
-  }
-
 #if HAVE_LIBCUDA==1
   if (component->cudaDevice>=0) destroy_cuda();
 #endif
@@ -397,6 +416,15 @@ void PolarBasis::get_acceleration_and_potential(Component* C)
 }
 
 
+void PolarBasis::schedule(bool coef)
+{
+  if (coef and subset)
+    sched.reset(component->levlist, mlevel, mlevel, nthrds, worksteal,
+		ChunkScheduler::default_chunk, ssfrac);
+  else
+    PotAccel::schedule(coef);
+}
+
 void * PolarBasis::determine_coefficients_thread(void * arg)
 {
   // For biorthogonal density component and normalization
@@ -419,10 +447,7 @@ void * PolarBasis::determine_coefficients_thread(void * arg)
   double r, r2, facL=1.0, fac1, fac2, phi, mass;
   double xx, yy, zz;
 
-  unsigned nbodies = component->levlist[mlevel].size();
   int id = *((int*)arg);
-  int nbeg = nbodies*id/nthrds;
-  int nend = nbodies*(id+1)/nthrds;
   double adb = component->Adiabatic();
 
 #ifdef DEBUG
@@ -439,126 +464,129 @@ void * PolarBasis::determine_coefficients_thread(void * arg)
   vector<double> ctr;
   if (mix) mix->getCenter(ctr);
 
-				// Compute potential using a 
-				// subset of particles
-  if (subset) nend = (int)floor(ssfrac*nend);
-
   unsigned whch = 0;		// For PCA jacknife
 
-  for (int i=nbeg; i<nend; i++) {
+  unsigned lev;
+  int nbeg, nend;
+
+  while (sched.next(id, lev, nbeg, nend)) {
 
-    int indx = component->levlist[mlevel][i];
+    for (int i=nbeg; i<nend; i++) {
 
-    if (component->freeze(indx)) continue;
+      int indx = component->levlist[lev][i];
+
+      if (component->freeze(indx)) continue;
     
     
-    mass = component->Mass(indx) * adb;
+      mass = component->Mass(indx) * adb;
 				// Adjust mass for subset
-    if (subset) mass /= ssfrac;
+      if (subset) mass /= ssfrac;
     
-    if (mix) {
-      xx = component->Pos(indx, 0, Component::Local) - ctr[0];
-      yy = component->Pos(indx, 1, Component::Local) - ctr[1];
-      zz = component->Pos(indx, 2, Component::Local) - ctr[2];
-    } else {
-      xx = component->Pos(indx, 0, Component::Local | Component::Centered);
-      yy = component->Pos(indx, 1, Component::Local | Component::Centered);
-      zz = component->Pos(indx, 2, Component::Local | Component::Centered);
-    }
+      if (mix) {
+	xx = component->Pos(indx, 0, Component::Local) - ctr[0];
+	yy = component->Pos(indx, 1, Component::Local) - ctr[1];
+	zz = component->Pos(indx, 2, Component::Local) - ctr[2];
+      } else {
+	xx = component->Pos(indx, 0, Component::Local | Component::Centered);
+	yy = component->Pos(indx, 1, Component::Local | Component::Centered);
+	zz = component->Pos(indx, 2, Component::Local | Component::Centered);
+      }
 
-    r2  = (xx*xx + yy*yy);
-    r   = sqrt(r2) + DSMALL;
+      r2  = (xx*xx + yy*yy);
+      r   = sqrt(r2) + DSMALL;
       
-    if (r < getRtable() and fabs(zz) < getRtable()) {
+      if (r < getRtable() and fabs(zz) < getRtable()) {
 
-      use[id]++;
-      phi = atan2(yy, xx);
+	use[id]++;
+	phi = atan2(yy, xx);
 	
-      sinecosine_R(Mmax, phi, cosm[id], sinm[id]);
+	sinecosine_R(Mmax, phi, cosm[id], sinm[id]);
 
-      // If we have a flat disk, project to the disk plane
-      //
-      if (cC == component and is_flat)
-	get_potl(r, 0.0, potd[id], id);
-      //
-      // Otherwise do the 3d evaluation
-      //
-      else
-	get_potl(r, zz, potd[id], id);
+	// If we have a flat disk, project to the disk plane
+	//
+	if (cC == component and is_flat)
+	  get_potl(r, 0.0, potd[id], id);
+	//
+	// Otherwise do the 3d evaluation
+	//
+	else
+	  get_potl(r, zz, potd[id], id);
       
-      if (compute) {
-	muse1[id] += mass;
-	if (pcavar) {
-	  whch = indx % sampT;
-	  pthread_mutex_lock(&cc_lock);
-	  massT1[whch][0] += mass;
-	  pthread_mutex_unlock(&cc_lock);
+	if (compute) {
+	  muse1[id] += mass;
+	  if (pcavar) {
+	    whch = indx % sampT;
+	    massT0[id][whch] += mass;
+	  }
 	}
-      }
-
-      //		m loop
-      for (int m=0, moffset=0; m<=Mmax; m++) {
 
-	if (NO_M1 && m==1) {
-	  moffset += 2;
-	  continue;
-	}
+	//		m loop
+	for (int m=0, moffset=0; m<=Mmax; m++) {
 
-	if (m==0) {
-	  u[id] = potd[id].row(m)*mass*norm0;
-	  *expcoef0[id][moffset] += u[id];
-
-	  if (compute and pcavar) {
-	    pthread_mutex_lock(&cc_lock);
-	    *expcoefT1[whch][m] += u[id];
-	    *expcoefM1[whch][m] += u[id]*u[id].transpose()/mass;
-	    pthread_mutex_unlock(&cc_lock);
+	  if (NO_M1 && m==1) {
+	    moffset += 2;
+	    continue;
 	  }
 
-	  if (compute) {
-	    pthread_mutex_lock(&cc_lock);
-	    tvar[0][m] += u[id]*u[id].transpose()/mass;
-	    pthread_mutex_unlock(&cc_lock);
-	  }
+	  if (m==0) {
+	    u[id] = potd[id].row(m)*mass*norm0;
+	    *expcoef0[id][moffset] += u[id];
 
-	  moffset++;
-	}
-	else {
-	  if (not M0_only) {
+	    if (compute and pcavar) {
+	      expcoefT0[id][whch][m] += u[id];
+	      expcoefM0[id][whch][m].noalias() += u[id]*u[id].transpose()/mass;
+	    }
 
-	    fac1 = cosm[id][m];
-	    fac2 = sinm[id][m];
+	    if (compute) {
+	      pcabuf[id][m].add(u[id], 1.0/mass, tvar0[id][m]);
+	    }
 
-	    u[id] = potd[id].row(m)*mass*norm1;
+	    moffset++;
+	  }
+	  else {
+	    if (not M0_only) {
 
-	    *expcoef0[id][moffset  ] += u[id]*fac1;
-	    *expcoef0[id][moffset+1] += u[id]*fac2;
+	      fac1 = cosm[id][m];
+	      fac2 = sinm[id][m];
 
+	      u[id] = potd[id].row(m)*mass*norm1;
 
-	    if (compute and pcavar) {
-	      pthread_mutex_lock(&cc_lock);
-	      *expcoefT1[whch][m] += u[id]*facL;
-	      *expcoefM1[whch][m] += u[id]*u[id].transpose()*facL*facL/mass;
-	      pthread_mutex_unlock(&cc_lock);
-	    }
+	      *expcoef0[id][moffset  ] += u[id]*fac1;
+	      *expcoef0[id][moffset+1] += u[id]*fac2;
+
+
+	      if (compute and pcavar) {
+		expcoefT0[id][whch][m] += u[id]*facL;
+		expcoefM0[id][whch][m].noalias() +=
+		  u[id]*u[id].transpose()*(facL*facL/mass);
+	      }
 	    
-	    if (compute) {
-	      pthread_mutex_lock(&cc_lock);
-	      tvar[m][0] += u[id]*u[id].transpose()/mass;
-	      pthread_mutex_unlock(&cc_lock);
+	      if (compute) {
+		pcabuf[id][m].add(u[id], 1.0/mass, tvar0[id][m]);
+	      }
 	    }
-	  }
 
-	  moffset+=2;
-	} // m!=0
+	    moffset+=2;
+	  } // m!=0
+
+	} // m loop
+
+	cylmass1[id] += mass;
 
-      } // m loop
+      } // r < rmax
 
-      cylmass1[id] += mass;
+    } // particle loop
 
-    } // r < rmax
+  } // chunk loop
 
-  } // particle loop
+  // Apply the pending covariance updates
+  //
+  if (compute) {
+    for (int m=0; m<=Mmax; m++) {
+      pcabuf[id][m].flush(tvar0[id][m]);
+      SyrkBuffer::symmetrize(tvar0[id][m]);
+    }
+  }
 
   thread_timing_end(id);
 
@@ -708,7 +736,21 @@ void PolarBasis::determine_coefficients_particles(void)
 	for (auto & t : expcoefM1) { for (auto & v : t) v->setZero(); }
 	for (auto & v : massT1)    { for (auto & u : v) u = 0;        }
       }
+
+      tvar.resize(1);
+      tvar[0].resize(Mmax+1);
+      for (auto & v : tvar[0]) v.setZero(nmax, nmax);
     }
+
+    if (tvar.size()==0) {
+      tvar.resize(1);
+      tvar[0].resize(Mmax+1);
+      for (auto & v : tvar[0]) v.setZero(nmax, nmax);
+    }
+
+    // Per-thread accumulators for this pass
+    //
+    zero_thread_pca();
   }
 
   // Set up for mass on grid
@@ -796,47 +838,38 @@ void PolarBasis::determine_coefficients_particles(void)
 
   // Thread reduce
   //
-  for (int i=1; i<nthrds; i++) {
-    for (int m=0; m<=2*Mmax; m++) *expcoef0[0][m] += *expcoef0[i][m];
+  reduce_threads();
+
+  if (compute) {
+    if (pcavar) {
+      for (unsigned T=0; T<sampT; T++) {
+	massT1[0][T] += massT0[0][T];
+	for (int m=0; m<=Mmax; m++) {
+	  *expcoefT1[T][m] += expcoefT0[0][T][m];
+	  *expcoefM1[T][m] += expcoefM0[0][T][m];
+	}
+      }
+    }
+
+    for (int m=0; m<=Mmax; m++) tvar[0][m] += tvar0[0][m];
   }
 
-  // MPI reduce
+  // MPI reduce: all harmonics in one packed buffer
   //
-  for (int m=0, moffset=0; m<=Mmax; m++) {
+  {
+    int ncoef = (2*Mmax+1)*nmax;
+    std::vector<double> pack0(ncoef), pack1(ncoef);
 
-    if (m==0) {
-	  
-      if (multistep)
-	MPI_Allreduce ( (*expcoef0[0][moffset]).data(),
-			(*expcoefN[mlevel][moffset]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-      else
-	MPI_Allreduce ( (*expcoef0[0][moffset]).data(),
-			(*expcoef[moffset]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-      
-      moffset++;
-      
-    } else {
-	
-      if (multistep) {
-	MPI_Allreduce ( (*expcoef0[0][moffset]).data(),
-			(*expcoefN[mlevel][moffset]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	  
-	MPI_Allreduce ( (*expcoef0[0][moffset+1]).data(),
-			(*expcoefN[mlevel][moffset+1]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-      } else {
-	MPI_Allreduce ( (*expcoef0[0][moffset]).data(),
-			(*expcoef[moffset]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	
-	MPI_Allreduce ( (*expcoef0[0][moffset+1]).data(),
-			(*expcoef[moffset+1]).data(),
-			nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-      }
-      moffset+=2;
+    for (int k=0; k<2*Mmax+1; k++)
+      Eigen::Map<Eigen::VectorXd>(&pack0[k*nmax], nmax) = *expcoef0[0][k];
+
+    NodeSharedComm::allreduce(pack0.data(), pack1.data(), ncoef,
+			      MPI_DOUBLE, MPI_SUM);
+
+    for (int k=0; k<2*Mmax+1; k++) {
+      Eigen::Map<Eigen::VectorXd> v(&pack1[k*nmax], nmax);
+      if (multistep) *expcoefN[mlevel][k] = v;
+      else           *expcoef[k]          = v;
     }
   }
   
@@ -945,6 +978,78 @@ void PolarBasis::determine_coefficients_particles(void)
   firstime_coef = false;
 }
 
+void PolarBasis::zero_thread_pca()
+{
+  if (pcavar) {
+    massT0   .resize(nthrds);
+    expcoefT0.resize(nthrds);
+    expcoefM0.resize(nthrds);
+
+    for (int id=0; id<nthrds; id++) {
+      massT0[id].assign(sampT, 0.0);
+
+      expcoefT0[id].resize(sampT);
+      expcoefM0[id].resize(sampT);
+      for (unsigned T=0; T<sampT; T++) {
+	expcoefT0[id][T].resize(Mmax+1);
+	expcoefM0[id][T].resize(Mmax+1);
+	for (auto & v : expcoefT0[id][T]) v.setZero(nmax);
+	for (auto & v : expcoefM0[id][T]) v.setZero(nmax, nmax);
+      }
+    }
+  }
+
+  tvar0.resize(nthrds);
+  for (auto & t : tvar0) {
+    t.resize(Mmax+1);
+    for (auto & v : t) v.setZero(nmax, nmax);
+  }
+
+  pcabuf.resize(nthrds);
+  for (auto & t : pcabuf) {
+    t.resize(Mmax+1);
+    for (auto & v : t) v.resize(nmax);
+  }
+
+  // Per-thread subsample coefficients and covariance
+  //
+  size_t bytes = nthrds*(Mmax+1)*nmax*nmax*sizeof(double);
+  if (pcavar) bytes += nthrds*sampT*(Mmax+1)*(nmax + nmax*nmax)*sizeof(double);
+  memtrack.set("pca", component->name, bytes);
+}
+
+void PolarBasis::reduce_pair(int i, int j)
+{
+  for (int m=0; m<=2*Mmax; m++) *expcoef0[i][m] += *expcoef0[j][m];
+
+  if (not compute) return;
+
+  if (pcavar) {
+    for (unsigned T=0; T<sampT; T++) {
+      massT0[i][T] += massT0[j][T];
+      for (int m=0; m<=Mmax; m++) {
+	expcoefT0[i][T][m] += expcoefT0[j][T][m];
+	expcoefM0[i][T][m] += expcoefM0[j][T][m];
+      }
+    }
+  }
+
+  for (int m=0; m<=Mmax; m++) tvar0[i][m] += tvar0[j][m];
+}
+
+void PolarBasis::reduce_threads()
+{
+  // At each stage, thread i absorbs thread i+stride for every i that
+  // is a multiple of 2*stride.  The pairs in a stage are independent
+  // and are summed in parallel.
+  //
+  for (int stride=1; stride<nthrds; stride*=2) {
+    int npair = (nthrds - stride + 2*stride - 1)/(2*stride);
+    ThreadPool::instance().run(npair, [this, stride](int k)
+    { reduce_pair(2*stride*k, 2*stride*k + stride); });
+  }
+}
+
 void PolarBasis::multistep_reset()
 {
   if (play_back and not play_cnew) return;
@@ -995,8 +1100,7 @@ void PolarBasis::multistep_update_finish()
     }
   }
 
-  MPI_Allreduce (&pack[0], &unpack[0], sz, 
-		 MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(&pack[0], &unpack[0], sz, MPI_DOUBLE, MPI_SUM);
   
   //  +--- Deep debugging
   //  |
@@ -1133,6 +1237,95 @@ void PolarBasis::multistep_update(int from, int to, Component *c, int i, int id)
 }
 
 
+void PolarBasis::multistep_update_batch(int from, int to, Component *c,
+					const std::vector<int>& idx, int id)
+{
+  if (play_back and not play_cnew) return;
+
+  constexpr double norm0_3d = 2.0*M_PI * 0.5*M_2_SQRTPI/M_SQRT2;
+  constexpr double norm1_3d = 2.0*M_PI * 0.5*M_2_SQRTPI;
+
+  constexpr double norm0_2d = 1.0;
+  constexpr double norm1_2d = M_SQRT2;
+
+  const double norm0 = is_flat ? norm0_2d : norm0_3d;
+  const double norm1 = is_flat ? norm1_2d : norm1_3d;
+
+  // Block size for the table evaluation
+  //
+  constexpr int nblock = 64;
+
+  // Every particle of the batch leaves level <from> and joins level
+  // <to>, so the contributions are summed once and applied to both
+  //
+  Eigen::MatrixXd S = Eigen::MatrixXd::Zero(2*Mmax+1, nmax);
+
+  std::vector<double> mass(nblock), phi(nblock);
+  std::vector<Eigen::MatrixXd> P(Mmax+1);
+  Eigen::MatrixXd C, Sn;
+
+  for (size_t k=0; k<idx.size(); ) {
+
+    // Gather the next block
+    //
+    int nb = 0;
+
+    for (int m=0; m<=Mmax; m++) P[m].resize(nblock, nmax);
+
+    for (; k<idx.size() and nb<nblock; k++) {
+      int i = idx[k];
+      if (c->freeze(i)) continue;
+
+      double xx = c->Pos(i, 0, Component::Local | Component::Centered);
+      double yy = c->Pos(i, 1, Component::Local | Component::Centered);
+      double zz = c->Pos(i, 2, Component::Local | Component::Centered);
+
+      double r = sqrt(xx*xx + yy*yy) + DSMALL;
+      if (r>=rmax) continue;
+
+      mass[nb] = c->Mass(i) * component->Adiabatic();
+      phi [nb] = atan2(yy, xx);
+
+      get_potl(r, zz, potd[id], id);
+      for (int m=0; m<=Mmax; m++)
+	P[m].row(nb) = potd[id].row(m)*mass[nb];
+
+      nb++;
+    }
+
+    if (nb==0) continue;
+
+    sinecosine_R(Mmax, nb, phi.data(), C, Sn);
+
+    // Sum over the block for each m
+    //
+    for (int m=0, moffset=0; m<=Mmax; m++) {
+
+      if (NO_M1 && m==1) {
+	moffset += 2;
+	continue;
+      }
+
+      auto Pm = P[m].topRows(nb);
+
+      if (m==0) {
+	S.row(moffset).noalias() += Pm.colwise().sum()*norm0;
+	moffset++;
+      } else {
+	S.row(moffset  ).noalias() += C .col(m).transpose()*Pm*norm1;
+	S.row(moffset+1).noalias() += Sn.col(m).transpose()*Pm*norm1;
+	moffset += 2;
+      }
+    }
+  }
+				// Adjust mass for subset
+  if (subset) S /= ssfrac;
+
+  differ1[id][from] -= S;
+  differ1[id][  to] += S;
+}
+
+
 void PolarBasis::compute_multistep_coefficients()
 {
   if (play_back and not play_cnew) return;
@@ -1375,16 +1568,13 @@ void * PolarBasis::determine_acceleration_and_potential_thread(void * arg)
 
   thread_timing_beg(id);
 
-  // If we are multistepping, compute accel only at or above <mlevel>
+  // If we are multistepping, compute accel only at or above <mlevel>.
+  // The scheduler hands out ranges from these levels.
   //
-  for (int lev=mlevel; lev<=multistep; lev++) {
-
-    unsigned nbodies = cC->levlist[lev].size();
-
-    if (nbodies==0) continue;
+  unsigned lev;
+  int nbeg, nend;
 
-    int nbeg = nbodies*(id  )/nthrds;
-    int nend = nbodies*(id+1)/nthrds;
+  while (sched.next(id, lev, nbeg, nend)) {
 
 #ifdef DEBUG
     pthread_mutex_lock(&io_lock);
@@ -1790,7 +1980,7 @@ void PolarBasis::dump_coefs(ostream& out)
 
 // Dump coefficients to an HDF5 file
 
-void PolarBasis::dump_coefs_h5(const std::string& file)
+CoefClasses::CoefStrPtr PolarBasis::current_coefs()
 {
   // Add the current coefficients
   auto cur = std::make_shared<CoefClasses::CylStruct>();
@@ -1822,11 +2012,26 @@ void PolarBasis::dump_coefs_h5(const std::string& file)
   //
   cur->ctr = component->getCenter(Component::Local | Component::Centered);
 
+  return cur;
+}
+
+void PolarBasis::dump_coefs_h5(const std::string& file)
+{
+  append_coefs_h5(file, {current_coefs()});
+}
+
+void PolarBasis::append_coefs_h5(const std::string& file,
+                                 const std::vector<CoefClasses::CoefStrPtr>& snaps)
+{
+  if (snaps.empty()) return;
+
+  cylCoefs.setH5Chunked(h5window, h5deflate, h5swmr);
+
   // Check if file exists
   //
   if (std::filesystem::exists(file)) {
     cylCoefs.clear();
-    cylCoefs.add(cur);
+    for (auto & c : snaps) cylCoefs.add(c);
     cylCoefs.ExtendH5Coefs(file);
   }
   // Otherwise, extend the existing HDF5 file
@@ -1834,14 +2039,14 @@ void PolarBasis::dump_coefs_h5(const std::string& file)
   else {
     // Copy the YAML config.  We only need this on the first call.
     std::ostringstream sout; sout << conf;
-    cur->buf = sout.str();	// Copy to CoefStruct buffer
+    snaps.front()->buf = sout.str(); // Copy to CoefStruct buffer
 
     // Add the name attribute.  We only need this on the first call.
     cylCoefs.setName(component->name);
 
     // And the new coefficients and write the new HDF5
     cylCoefs.clear();
-    cylCoefs.add(cur);
+    for (auto & c : snaps) cylCoefs.add(c);
     cylCoefs.WriteH5Coefs(file);
   }
 }
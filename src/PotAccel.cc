@@ -4,6 +4,7 @@
 
 #include "expand.H"
 #include <PotAccel.H>
+#include <ThreadPool.H>
 
 extern "C"
 void *
@@ -30,10 +31,25 @@ std::map<PotAccel::Geometry, std::string> PotAccel::geoname =
     {PotAccel::other,    "other"   }
   };
 
+void PotAccel::schedule(bool coef)
+{
+  Component *c = coef ? component : cC;
+  if (c == 0) c = component;
+  if (c == 0) return;
+
+  if (coef) sched.reset(c->levlist, mlevel, mlevel,    nthrds, worksteal);
+  else      sched.reset(c->levlist, mlevel, multistep, nthrds, worksteal);
+}
+
 void PotAccel::exp_thread_fork(bool coef)
 {
   //
-  // If only one thread, skip pthread call
+  // Partition the particle lists for this pass
+  //
+  if (chunk_aware) schedule(coef);
+
+  //
+  // If only one thread, skip the thread pool
   //
   if (nthrds==1) {
 
@@ -48,11 +64,7 @@ void PotAccel::exp_thread_fork(bool coef)
     return;
   }
 
-  int errcode;
-  void *retval;
-  
   td = new thrd_pass_PotAccel [nthrds];
-  t = new pthread_t [nthrds];
 
   if (!td) {
     std::ostringstream sout;
@@ -60,12 +72,6 @@ void PotAccel::exp_thread_fork(bool coef)
 	 << ": exp_thread_fork: error allocating memory for thread counters";
     throw GenericError(sout.str(), __FILE__, __LINE__, 1027, true);
   }
-  if (!t) {
-    std::ostringstream sout;
-    sout << "Process " << myid
-	 << ": exp_thread_fork: error allocating memory for thread\n";
-    throw GenericError(sout.str(), __FILE__, __LINE__, 1027, true);
-  }
 
   //
   // For determining time in threaded routines
@@ -88,42 +94,27 @@ void PotAccel::exp_thread_fork(bool coef)
 
   }
 
-				// Make the <nthrds> threads
   for (int i=0; i<nthrds; i++) {
     td[i].t = this;
     td[i].coef = coef;
     td[i].id = i;
+  }
 
-    errcode =  pthread_create(&t[i], 0, call_any_threads_thread_call, &td[i]);
-    if (errcode) {
-      std::ostringstream sout;
-      sout << "Process " << myid;
-      if (coef)	sout << ", make_coefficients";
-      else sout << ", determine_acceleration";
-      sout << " thread: cannot make thread " << i
-	   << ", errcode=" << errcode;
-      throw GenericError(sout.str(), __FILE__, __LINE__, 1027, true);
-    }
-#ifdef DEBUG
-    else {
-      cout << "Process " << myid << ": thread <" << i << "> created\n";
-    }
-#endif
+				// Dispatch to the persistent pool
+  try {
+    ThreadPool::instance().run(nthrds, [this](int i)
+    { call_any_threads_thread_call(&td[i]); });
   }
-    
-				// Collapse the threads
-  for (int i=0; i<nthrds; i++) {
-    if ((errcode=pthread_join(t[i], &retval))) {
-      std::ostringstream sout;
-      sout << "Process " << myid;
-      if (coef)	sout << ", make_coefficients";
-      else sout << ", determine_acceleration";
-      sout << " thread: thread join " << i
-	   << " failed, errcode=" << errcode;
-      throw GenericError(sout.str(), __FILE__, __LINE__, 1027, true);
-    }
+  catch (std::exception& e) {
+    std::ostringstream sout;
+    sout << "Process " << myid;
+    if (coef)	sout << ", make_coefficients";
+    else sout << ", determine_acceleration";
+    sout << " thread: " << e.what();
+    delete [] td;
+    throw GenericError(sout.str(), __FILE__, __LINE__, 1027, true);
   }
-  
+
   //
   // For determining time in threaded routines
   //
@@ -146,7 +137,6 @@ void PotAccel::exp_thread_fork(bool coef)
   }
 
   delete [] td;
-  delete [] t;
 
 }
 
@@ -187,12 +177,18 @@ PotAccel::PotAccel(Component* c0, const YAML::Node& CONF) : conf(CONF)
   geometry     = other;
   use_external = false;
   coef_dump    = false;
+  h5window     = 0;
+  h5deflate    = 0;
+  h5swmr       = false;
   play_back    = false;
   play_cnew    = false;
   compute      = false;
   dof          = 3;
   mlevel       = 0;
   scale        = 1.0;
+  soa_aware    = false;
+  chunk_aware  = false;
+  defer_coefs  = false;
 #if HAVE_LIBCUDA==1
   cuda_aware   = false;
 #endif
@@ -207,6 +203,8 @@ PotAccel::PotAccel(Component* c0, const YAML::Node& CONF) : conf(CONF)
 
   if (VERBOSE>5) {
     timer_list = vector<std::time_t>(2*nthrds);
+    busy_list  = vector<double>(nthrds, 0.0);
+    busy_start = vector<std::chrono::steady_clock::time_point>(nthrds);
   }
 
   // Add keys
@@ -232,6 +230,7 @@ void PotAccel::thread_timing_beg(int id)
     auto const now = std::chrono::system_clock::now();
     std::time_t newt = std::chrono::system_clock::to_time_t(now);
     timer_list[2*id] = newt;
+    busy_start[id] = std::chrono::steady_clock::now();
   }
 }
 
@@ -241,6 +240,8 @@ void PotAccel::thread_timing_end(int id)
     auto const now = std::chrono::system_clock::now();
     std::time_t newt = std::chrono::system_clock::to_time_t(now);
     timer_list[2*id+1] = newt;
+    busy_list[id] = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - busy_start[id]).count();
   }
 }
 
@@ -350,10 +351,38 @@ void PotAccel::print_timings(const string& label, TList& tlist)
 	     << endl;
       }
     }
+    // Per-thread busy time in the last pass over all nodes
+    //
+    std::vector<double> busy(busy_list), bfrom(nthrds);
+    for (int np=1; np<numprocs; np++) {
+      MPI_Recv(&bfrom[0], nthrds, MPI_DOUBLE, np, 38, MPI_COMM_WORLD,
+	       MPI_STATUS_IGNORE);
+      busy.insert(busy.end(), bfrom.begin(), bfrom.end());
+    }
+
+    if (busy.size()) {
+      double bmin = *std::min_element(busy.begin(), busy.end());
+      double bmax = *std::max_element(busy.begin(), busy.end());
+      double bavg = 0.0;
+      for (auto v : busy) bavg += v;
+      bavg /= busy.size();
+
+      cout << "Busy min  = " << setw(12) << setprecision(6) << bmin
+	   << "     " << setw(12)
+	   << "Busy max  = " << setw(12) << setprecision(6) << bmax
+	   << endl
+	   << "Busy mean = " << setw(12) << setprecision(6) << bavg
+	   << "     " << setw(12)
+	   << "Max/mean  = " << setw(12) << setprecision(6)
+	   << bmax/(bavg + 1.0e-14)
+	   << (worksteal ? "  [work stealing]" : "") << endl;
+    }
+
     cout << setw(70) << setfill('=') << "=" << endl << setfill(' ');
     
   } else {
     MPI_Send(&tlist[0], 2*nthrds, MPI_DOUBLE, 0, 37, MPI_COMM_WORLD);
+    MPI_Send(&busy_list[0], nthrds, MPI_DOUBLE, 0, 38, MPI_COMM_WORLD);
   }
 }
 
@@ -0,0 +1,269 @@
+#include <fstream>
+#include <sstream>
+#include <set>
+
+#include <sys/resource.h>
+
+#include "expand.H"
+
+#include <Profiler.H>
+
+Profiler::Profiler()
+{
+  last = std::chrono::steady_clock::now();
+}
+
+Profiler::Buffer* Profiler::local()
+{
+  static thread_local Buffer *mine = nullptr;
+
+  if (mine == nullptr) {
+    std::lock_guard<std::mutex> guard(lock);
+    buffers.push_back(std::make_shared<Buffer>());
+    mine = buffers.back().get();
+  }
+
+  return mine;
+}
+
+void Profiler::reset()
+{
+  std::lock_guard<std::mutex> guard(lock);
+  for (auto & b : buffers) b->stats.clear();
+}
+
+// Escape a path for a JSON string
+//
+static std::string jsonString(const std::string& s)
+{
+  std::string r("\"");
+  for (auto c : s) {
+    if (c=='"' or c=='\\') r += '\\';
+    r += c;
+  }
+  return r + "\"";
+}
+
+// The sorted union over processes of a list of names, on every
+// process
+//
+static std::vector<std::string> unionNames(const std::vector<std::string>& list)
+{
+  std::string mine;
+  for (auto & v : list) mine += v + '\n';
+
+  int len = mine.size();
+  std::vector<int> lens(numprocs), disp(numprocs, 0);
+  MPI_Gather(&len, 1, MPI_INT, lens.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  std::string all;
+  if (myid==0) {
+    for (int n=1; n<numprocs; n++) disp[n] = disp[n-1] + lens[n-1];
+    all.resize(disp[numprocs-1] + lens[numprocs-1]);
+  }
+
+  MPI_Gatherv(mine.data(), len, MPI_CHAR,
+	      &all[0], lens.data(), disp.data(), MPI_CHAR,
+	      0, MPI_COMM_WORLD);
+
+  if (myid==0) {
+    std::set<std::string> names;
+    std::istringstream sin(all);
+    std::string line;
+    while (std::getline(sin, line)) names.insert(line);
+    all.clear();
+    for (auto & s : names) all += s + '\n';
+  }
+
+  len = all.size();
+  MPI_Bcast(&len, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  all.resize(len);
+  MPI_Bcast(&all[0], len, MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  std::vector<std::string> names;
+  std::istringstream sin(all);
+  std::string line;
+  while (std::getline(sin, line)) names.push_back(line);
+
+  return names;
+}
+
+void Profiler::report(int step)
+{
+  // Combine the thread buffers
+  //
+  std::map<std::string, Stat> local;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    for (auto & b : buffers) {
+      for (auto & v : b->stats) {
+	local[v.first].time  += v.second.time;
+	local[v.first].count += v.second.count;
+      }
+    }
+  }
+
+  // The union of the paths over processes
+  //
+  std::vector<std::string> names;
+  for (auto & v : local) names.push_back(v.first);
+  names = unionNames(names);
+
+  // Reduce
+  //
+  int nreg = names.size();
+  std::vector<double> t(nreg, 0.0), tmin(nreg), tmax(nreg), tsum(nreg);
+  std::vector<unsigned long> cnt(nreg, 0), csum(nreg);
+
+  for (int j=0; j<nreg; j++) {
+    auto it = local.find(names[j]);
+    if (it != local.end()) {
+      t[j]   = it->second.time;
+      cnt[j] = it->second.count;
+    }
+  }
+
+  MPI_Reduce(t.data(), tmin.data(), nreg, MPI_DOUBLE, MPI_MIN, 0,
+	     MPI_COMM_WORLD);
+  MPI_Reduce(t.data(), tmax.data(), nreg, MPI_DOUBLE, MPI_MAX, 0,
+	     MPI_COMM_WORLD);
+  MPI_Reduce(t.data(), tsum.data(), nreg, MPI_DOUBLE, MPI_SUM, 0,
+	     MPI_COMM_WORLD);
+  MPI_Reduce(cnt.data(), csum.data(), nreg, MPI_UNSIGNED_LONG, MPI_SUM, 0,
+	     MPI_COMM_WORLD);
+
+  // Memory high-water mark in kB (the peak so far, not per interval)
+  //
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  long rss = usage.ru_maxrss, rssmin, rssmax, rsssum;
+  MPI_Reduce(&rss, &rssmin, 1, MPI_LONG, MPI_MIN, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&rss, &rssmax, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&rss, &rsssum, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  // Tracked allocations (see MemTrack): per tag, the largest current
+  // and peak sizes over processes and the sum of the current sizes;
+  // per process, the current and peak totals
+  //
+  auto mem = memtrack.snapshot();
+  std::vector<std::string> tags;
+  for (auto & v : mem) tags.push_back(v.first);
+  tags = unionNames(tags);
+
+  int ntag = tags.size();
+  std::vector<double> mcur(ntag, 0.0), mpk(ntag, 0.0);
+  std::vector<double> mcurmax(ntag), mpkmax(ntag), mcursum(ntag);
+  for (int j=0; j<ntag; j++) {
+    auto it = mem.find(tags[j]);
+    if (it != mem.end()) {
+      mcur[j] = it->second.current;
+      mpk[j]  = it->second.peak;
+    }
+  }
+
+  MPI_Reduce(mcur.data(), mcurmax.data(), ntag, MPI_DOUBLE, MPI_MAX, 0,
+	     MPI_COMM_WORLD);
+  MPI_Reduce(mpk.data(), mpkmax.data(), ntag, MPI_DOUBLE, MPI_MAX, 0,
+	     MPI_COMM_WORLD);
+  MPI_Reduce(mcur.data(), mcursum.data(), ntag, MPI_DOUBLE, MPI_SUM, 0,
+	     MPI_COMM_WORLD);
+
+  double mtot[2] = {double(memtrack.current()), double(memtrack.peak())};
+  std::vector<double> mrank(2*numprocs);
+  MPI_Gather(mtot, 2, MPI_DOUBLE, mrank.data(), 2, MPI_DOUBLE, 0,
+	     MPI_COMM_WORLD);
+
+  auto now  = std::chrono::steady_clock::now();
+  double wall = std::chrono::duration<double>(now - last).count();
+  last = now;
+
+  // Write
+  //
+  if (myid==0) {
+
+    std::string base = outdir + "profile." + runtag;
+
+    std::ofstream json(base + ".json", std::ios::app);
+    if (json) {
+      json << "{\"step\": " << step << ", \"first\": " << last_step + 1
+	   << ", \"time\": " << tnow << ", \"wall\": " << wall
+	   << ", \"nprocs\": " << numprocs << ", \"nthrds\": " << nthrds
+	   << ", \"maxrss\": {\"min\": " << rssmin << ", \"max\": " << rssmax
+	   << ", \"sum\": " << rsssum << "}, \"memory\": [";
+      for (int j=0; j<ntag; j++) {
+	if (j) json << ", ";
+	json << "{\"name\": "     << jsonString(tags[j])
+	     << ", \"current\": " << mcurmax[j]
+	     << ", \"peak\": "    << mpkmax[j]
+	     << ", \"sum\": "     << mcursum[j] << "}";
+      }
+      json << "], \"memory_by_rank\": [";
+      for (int n=0; n<numprocs; n++) {
+	if (n) json << ", ";
+	json << "[" << mrank[2*n] << ", " << mrank[2*n+1] << "]";
+      }
+      json << "], \"regions\": [";
+      for (int j=0; j<nreg; j++) {
+	if (j) json << ", ";
+	json << "{\"name\": " << jsonString(names[j])
+	     << ", \"count\": " << csum[j]
+	     << ", \"min\": "   << tmin[j]
+	     << ", \"max\": "   << tmax[j]
+	     << ", \"mean\": "  << tsum[j]/numprocs << "}";
+      }
+      json << "]}" << std::endl;
+    } else {
+      std::cerr << "Profiler: could not open <" << base << ".json>"
+		<< std::endl;
+    }
+
+    bool fresh = not std::ifstream(base + ".csv").good();
+
+    std::ofstream csv(base + ".csv", std::ios::app);
+    if (csv) {
+      if (fresh)
+	csv << "step,time,region,count,min,max,mean" << std::endl;
+      for (int j=0; j<nreg; j++) {
+	csv << step << "," << tnow << ",\"" << names[j] << "\","
+	    << csum[j] << "," << tmin[j] << "," << tmax[j] << ","
+	    << tsum[j]/numprocs << std::endl;
+      }
+    } else {
+      std::cerr << "Profiler: could not open <" << base << ".csv>"
+		<< std::endl;
+    }
+  }
+
+  last_step = step;
+
+  reset();
+}
+
+
+ProfRegion::ProfRegion(const std::string& name) : buf(nullptr)
+{
+  if (cuda_prof) nv = std::make_shared<nvTracer>(name.c_str());
+
+  if (not profiler.enabled) return;
+
+  buf = profiler.local();
+
+  if (buf->stack.empty()) buf->stack.push_back(name);
+  else                    buf->stack.push_back(buf->stack.back() + "/" + name);
+
+  beg = std::chrono::steady_clock::now();
+}
+
+ProfRegion::~ProfRegion()
+{
+  if (buf == nullptr) return;
+
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - beg;
+
+  auto & s = buf->stats[buf->stack.back()];
+  s.time += dt.count();
+  s.count++;
+
+  buf->stack.pop_back();
+}
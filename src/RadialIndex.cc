@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <limits>
+
+#include "expand.H"
+
+#include <RadialIndex.H>
+
+void RadialIndex::update(std::vector<Entry>& entries)
+{
+  const size_t n = entries.size();
+
+  auto less = [](const Entry& a, const Entry& b) { return a.r < b.r; };
+
+  // Entries in their previous order, then those that are new
+  //
+  std::vector<long> slot(sorted.size(), -1);
+  std::vector<Entry> seq, moved;
+  seq.reserve(n);
+
+  for (size_t i=0; i<n; i++) {
+    auto it = rank.find(entries[i].indx);
+    if (it != rank.end()) slot[it->second] = i;
+    else moved.push_back(entries[i]);
+  }
+
+  for (auto s : slot) if (s>=0) seq.push_back(entries[s]);
+
+  // Keep a sorted subsequence, setting aside both members of each
+  // pair found out of order
+  //
+  std::vector<Entry> kept;
+  kept.reserve(seq.size());
+
+  for (auto & e : seq) {
+    if (kept.size() and e.r < kept.back().r) {
+      moved.push_back(kept.back());
+      moved.push_back(e);
+      kept.pop_back();
+    } else {
+      kept.push_back(e);
+    }
+  }
+
+  // Sort what was set aside and merge, or sort everything if much of
+  // the order was lost
+  //
+  sorted.resize(n);
+
+  if (moved.size() > n/4) {
+    std::copy(entries.begin(), entries.end(), sorted.begin());
+    std::sort(sorted.begin(), sorted.end(), less);
+  } else {
+    std::sort(moved.begin(), moved.end(), less);
+    std::merge(kept.begin(), kept.end(), moved.begin(), moved.end(),
+	       sorted.begin(), less);
+  }
+
+  rank.clear();
+  rank.reserve(n);
+  for (size_t i=0; i<n; i++) rank[sorted[i].indx] = i;
+}
+
+void RadialIndex::makeEdges(int nbins, long total)
+{
+  const long n = sorted.size();
+
+  // Regular samples of the local order, each standing for n/s
+  // entries
+  //
+  long s = std::min<long>(n, 4L*nbins/numprocs + 16);
+  std::vector<double> samp(s);
+  for (long j=0; j<s; j++) samp[j] = sorted[(2*j+1)*n/(2*s)].r;
+
+  int ns = s;
+  double w = s ? static_cast<double>(n)/s : 0.0;
+
+  std::vector<int> cnts(numprocs), disp(numprocs, 0);
+  std::vector<double> wts(numprocs);
+
+  MPI_Allgather(&ns, 1, MPI_INT,    cnts.data(), 1, MPI_INT,    MPI_COMM_WORLD);
+  MPI_Allgather(&w,  1, MPI_DOUBLE, wts.data(),  1, MPI_DOUBLE, MPI_COMM_WORLD);
+
+  for (int i=1; i<numprocs; i++) disp[i] = disp[i-1] + cnts[i-1];
+
+  std::vector<double> all(disp.back() + cnts.back());
+  MPI_Allgatherv(samp.data(), ns, MPI_DOUBLE,
+		 all.data(), cnts.data(), disp.data(), MPI_DOUBLE,
+		 MPI_COMM_WORLD);
+
+  // Weighted samples in radial order
+  //
+  std::vector<std::pair<double, double>> ws(all.size());
+  for (int i=0; i<numprocs; i++) {
+    for (int j=0; j<cnts[i]; j++)
+      ws[disp[i]+j] = {all[disp[i]+j], wts[i]};
+  }
+
+  std::sort(ws.begin(), ws.end());
+
+  // Edges at equal steps of the cumulative weight; coincident edges
+  // are dropped
+  //
+  edges.assign(1, 0.0);
+
+  double cum = 0.0, step = static_cast<double>(total)/nbins;
+  int next = 1;
+
+  for (auto & v : ws) {
+    cum += v.second;
+    while (next < nbins and cum >= step*next) {
+      if (v.first > edges.back()) edges.push_back(v.first);
+      next++;
+    }
+  }
+}
+
+void RadialIndex::profile(int nbins, std::vector<double>& r,
+			  std::vector<double>& m, std::vector<double>& mr)
+{
+  long n = sorted.size(), total;
+  double rmax = n ? sorted.back().r : 0.0;
+
+  MPI_Allreduce(&n, &total, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &rmax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  r .assign(1, 0.0);
+  m .assign(1, 0.0);
+  mr.assign(1, 0.0);
+
+  if (total==0) return;
+
+  nbins = std::max<long>(1, std::min<long>(nbins, total));
+
+  // Edges from a previous step are kept unless the number of bins
+  // asked for has changed
+  //
+  bool fresh = false;
+  if (edges.empty() or
+      std::abs(static_cast<double>(edges.size()) - nbins) > 0.5*nbins) {
+    makeEdges(nbins, total);
+    fresh = true;
+  }
+
+  // Count, mass and mass/r per bin
+  //
+  std::vector<double> sums;
+
+  while (true) {
+
+    const size_t nb = edges.size();
+    sums.assign(3*nb, 0.0);
+
+    size_t b = 0;
+    for (auto & e : sorted) {
+      while (b+1<nb and e.r >= edges[b+1]) b++;
+      sums[3*b+0] += 1.0;
+      sums[3*b+1] += e.m;
+      if (e.r > 0.0) sums[3*b+2] += e.m/e.r;
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, sums.data(), sums.size(), MPI_DOUBLE,
+		  MPI_SUM, MPI_COMM_WORLD);
+
+    if (fresh) break;
+
+    // New edges if the occupation has drifted
+    //
+    double target = static_cast<double>(total)/nbins;
+    bool drifted = false;
+    for (size_t b=0; b<nb; b++) {
+      double c = sums[3*b];
+      if (c > drift*target + 1.0 or c < target/drift - 1.0) {
+	drifted = true;
+	break;
+      }
+    }
+
+    if (not drifted) break;
+
+    makeEdges(nbins, total);
+    fresh = true;
+  }
+
+  // Cumulative values at the outer edge of each bin; a last edge at
+  // or inside the previous one is merged with it
+  //
+  const size_t nb = edges.size();
+  for (size_t b=0; b<nb; b++) {
+    double rb = b+1<nb ? edges[b+1] : rmax;
+    double mb = m.back() + sums[3*b+1], pb = mr.back() + sums[3*b+2];
+    if (rb > r.back()) {
+      r .push_back(rb);
+      m .push_back(mb);
+      mr.push_back(pb);
+    } else {
+      m .back() = mb;
+      mr.back() = pb;
+    }
+  }
+}
@@ -11,11 +11,6 @@
 
 #include <ScatterMFP.H>
 
-bool less_rpair(const rpair& one, const rpair& two)
-{
-  return (one.first < two.first);
-}
-
 const std::set<std::string>
 ScatterMFP::valid_keys =  {
   "tautab",
@@ -124,17 +119,19 @@ void ScatterMFP::get_acceleration_and_potential(Component* C)
   for (int j=0; j<tautab; j++) dtau[j] = dtau1[j] = 0.0;
 
 				// Accumulate table
-  int ind;
-  double rrr, vvv, RR;
-  rr2.clear();
+  std::vector<RadialIndex::Entry> entries;
+  entries.reserve(nbodies);
 
-  for (int i=1; i<=nbodies; i++) {
-    RR = 0.0;
+  for (auto & v : cC->Particles()) {
+    int i = v.first;
+    double RR = 0.0;
     for (int j=0; j<3; j++) 
       RR += cC->Pos(i, j) * cC->Pos(i, j);
     RR = sqrt(RR);
 
-    ind = (int)(RR/dr);
+    entries.push_back({RR, cC->Mass(i), i});
+
+    int ind = (int)(RR/dr);
     if (ind>=tautab) continue;
     dtau1[ind] += cC->Mass(i);
   }
@@ -147,8 +144,9 @@ void ScatterMFP::get_acceleration_and_potential(Component* C)
     dtau[j] /= 4.0*M_PI/3.0*(pow(dr*(j+1), 3.0) - pow(dr*j, 3.0));
 
 
-				// Compute index
-  sort(rr2.begin(), rr2.end(), less_rpair);
+				// Order by radius, starting from the
+				// order of the last step
+  index.update(entries);
 
 				// Reset counter
   for (int j=0; j<nthrds; j++) cntr[j] = 0;
@@ -208,18 +206,22 @@ void * ScatterMFP::determine_acceleration_and_potential_thread(void * arg)
   double rm, rp, rtst1, rtst=0.0;
 #endif
 
-  unsigned nbodies = cC->Number();
+  const auto & rr2 = index.local();
+  int nbodies = rr2.size();
   int id = *((int*)arg);
   int nbeg = nbodies*id/nthrds;
   int nend = nbodies*(id+1)/nthrds;
 
+				// Need a neighbor to scatter with
+  if (nbodies<2) return (NULL);
+
   for (int j=nbeg; j<nend; j++) {
     
-    i = rr2[j].second;
+    i = rr2[j].indx;
     
     if (c->freeze(i)) continue;
 
-    ind = (int)(rr2[i].first/dr);
+    ind = (int)(rr2[j].r/dr);
     if (ind>=tautab) continue;
 
     v2 = 0.0;
@@ -235,23 +237,26 @@ void * ScatterMFP::determine_acceleration_and_potential_thread(void * arg)
 				// Initialize optical depth
       p->dattrib[mfp_index] = 0.0;
 
-				// Choose a buddy
-      if (j==1)
-	k = rr2[2].second;
+				// Choose a buddy: the radial neighbor
+				// nearest in radius
+      if (j==0)
+	k = rr2[1].indx;
+      else if (j==nbodies-1)
+	k = rr2[j-1].indx;
 #ifdef DEBUG      
-      else if ((rp=fabs(rr2[j].first-rr2[rr2[j+1].second].first)) > 
-	       (rm=fabs(rr2[j].first-rr2[rr2[j-1].second].first)))
+      else if ((rp=fabs(rr2[j].r-rr2[j+1].r)) > 
+	       (rm=fabs(rr2[j].r-rr2[j-1].r)))
 #else
 
-      else if (fabs(rr2[j].first-rr2[rr2[j+1].second].first) > 
-	       fabs(rr2[j].first-rr2[rr2[j-1].second].first) )
+      else if (fabs(rr2[j].r-rr2[j+1].r) > 
+	       fabs(rr2[j].r-rr2[j-1].r) )
 #endif
-	k = rr2[j-1].second;
+	k = rr2[j-1].indx;
       else
-	k = rr2[j+1].second;
+	k = rr2[j+1].indx;
 
 #ifdef DEBUG
-      if (j>1 && rtst<(rtst1=min<double>(rm, rp))) rtst = rtst1;
+      if (j>0 && j<nbodies-1 && rtst<(rtst1=min<double>(rm, rp))) rtst = rtst1;
 #endif
 
       Particle *q = cC->Part(k);
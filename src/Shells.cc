@@ -17,10 +17,8 @@ Shells::Shells(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   initialize();
 
 				// For accumulation
-  rgridT.resize(nthrds);
-  mgridT.resize(nthrds);
-  igridT.resize(nthrds);
-  usedT .resize(nthrds);
+  sampleT.resize(nthrds);
+  usedT  .resize(nthrds);
 
 				// For Alltoallv calls
   sdispl.resize(numprocs);
@@ -37,8 +35,7 @@ Shells::Shells(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   rnumbr.resize(numprocs);
 
 				// For storage of samples at each level
-  rgrid.resize(multistep+1);
-  mgrid.resize(multistep+1);
+  records.resize(multistep+1);
 
   update_fr.resize(nthrds);
   update_to.resize(nthrds);
@@ -173,156 +170,51 @@ void * Shells::determine_acceleration_and_potential_thread(void * arg)
 
 void Shells::determine_coefficients(void) 
 {
-				// For error info
-  char msg[MPI_MAX_ERROR_STRING];
-  int msglen;
 				// Clear the data arrays
   for (int i=0; i<nthrds; i++) {
-    rgridT[i].clear();
-    mgridT[i].clear();
-    igridT[i].clear();
+    sampleT[i].clear();
     usedT[i] = 0;
   }
 				// Make the radius--mass lists
   exp_thread_fork(true);
   
-  used1  = usedT[0];
-  rgrid1 = rgridT[0];
-  mgrid1 = mgridT[0];
-  igrid1 = igridT[0];
-  for (int i=1; i<nthrds; i++) {
-    rgrid1.insert(rgrid1.end(), rgridT[i].begin(), rgridT[i].end());
-    mgrid1.insert(mgrid1.end(), mgridT[i].begin(), mgridT[i].end());
-    igrid1.insert(igrid1.end(), igridT[i].begin(), igridT[i].end());
+				// Replace the samples of this level
+  auto & rec = records[mlevel];
+  rec.clear();
+
+  used1 = 0;
+  for (int i=0; i<nthrds; i++) {
+    for (auto & e : sampleT[i]) rec[e.indx] = e;
     used1 += usedT[i];
   }
 
-
   MPI_Allreduce(&used1, &used, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
 
-  if (used) {
-
-    int pn = rgrid1.size();
-
-    if (int ret=
-	MPI_Alltoallv(&pn, &sndcts[0], &sdispl[0], MPI_INT, 
-		      &rnumbr[0], &sndcts[0], &rcvcts[0], MPI_INT, 
-		      MPI_COMM_WORLD)
-	) 
-      {
-	MPI_Error_string(ret, msg, &msglen);
-	cout << "Shells::determine_coefficients: " << msg << endl;
-      }
-  
-    int nsum = 0;
-    for (int n=0; n<numprocs; n++) {
-      snumbr[n] = pn;
-      rdispl[n] = nsum;
-      nsum += rnumbr[n];
-    }
-				// Share the lists will all processes
-
-    vector<double> rgridX(nsum);
-    vector<double> mgridX(nsum);
-    vector<int   > igridX(nsum);
-
-    rgrid[mlevel].clear();
-    mgrid[mlevel].clear();
-
-    if (int ret=
-	MPI_Alltoallv(&rgrid1[0], &snumbr[0], &sdispl[0], MPI_DOUBLE, 
-		      &rgridX[0], &rnumbr[0], &rdispl[0], MPI_DOUBLE,
-		      MPI_COMM_WORLD)
-	)
-      {
-	MPI_Error_string(ret, msg, &msglen);
-	cout << "Shells::determine_coefficients: " << msg << endl;
-      }
-
-    
-    if (int ret=
-	MPI_Alltoallv(&mgrid1[0], &snumbr[0], &sdispl[0], MPI_DOUBLE, 
-		      &mgridX[0], &rnumbr[0], &rdispl[0], MPI_DOUBLE,
-		      MPI_COMM_WORLD)
-	)
-      {
-	MPI_Error_string(ret, msg, &msglen);
-	cout << "Shells::determine_coefficients: " << msg << endl;
-      }
-
-    if (int ret=
-	MPI_Alltoallv(&igrid1[0], &snumbr[0], &sdispl[0], MPI_INT, 
-		      &igridX[0], &rnumbr[0], &rdispl[0], MPI_INT,
-		      MPI_COMM_WORLD)
-	)
-      {
-	MPI_Error_string(ret, msg, &msglen);
-	cout << "Shells::determine_coefficients: " << msg << endl;
-      }
-
-    for (int i=0; i<nsum; i++) {
-      rgrid[mlevel][igridX[i]] = rgridX[i];
-      mgrid[mlevel][igridX[i]] = mgridX[i];
-    }
-  }
-
-				// Make and sort the list
-
+				// All local samples, in radial order
   double mfac = 1.0;
   if (nsample>1) mfac *= nsample;
-  grid.clear();
-  map<int, double>::iterator ri, mi;
-  for (int m=0; m<=multistep; m++) {
-    ri = rgrid[m].begin();
-    mi = mgrid[m].begin();
-    while (ri != rgrid[m].end() && mi != mgrid[m].end())
-      grid.push_back(Dpair((ri++)->second, (mi++)->second*mfac));
-  }
-  
-  if (grid.size()) {
-
-    sort(grid.begin(), grid.end());
-
-    int ntot = grid.size();
-  
-    rgrid0.clear();
-    mgrid0.clear();
-    pgrid0.clear();
-
-    double rL=0.0, rC, mL=0.0, mC;
-    vector<double> vval(3, 0.0);
-
-    for (int i=0; i<ntot; i++) {
-      rC = grid[i].first;
-      mC = grid[i].second;
-
-      vval[0] = rC;
-      vval[1] += 0.5*(mL + mC);
-      if (rL > 0.0)
-	vval[2] += 0.5*(mL/rL + mC/rC);
-      else
-	vval[2] += 0.5*(0.0   + mC/rC);
-      
-      if ( (i % nselect) == 0) {
-	rgrid0.push_back(vval[0]);
-	mgrid0.push_back(vval[1]);
-	pgrid0.push_back(vval[2]);
-      }
 
-      rL = rC;
-      mL = mC;
+  std::vector<RadialIndex::Entry> entries;
+  for (auto & v : records) {
+    for (auto & e : v) {
+      entries.push_back(e.second);
+      entries.back().m *= mfac;
     }
+  }
 
-    double potlF = pgrid0.back();
-    for (unsigned i=0; i<pgrid0.size(); i++) pgrid0[i] -= potlF;
+  index.update(entries);
 
-  }  else {
+				// Cumulative mass and potential over
+				// bins of nselect samples
+  long nloc = entries.size(), ntot;
+  MPI_Allreduce(&nloc, &ntot, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
 
-    rgrid0.push_back(0.0);
-    mgrid0.push_back(0.0);
-    pgrid0.push_back(0.0);
+  int nbins = std::max<long>(1, ntot/std::max<int>(nselect, 1));
 
-  }
+  index.profile(nbins, rgrid0, mgrid0, pgrid0);
+
+  double potlF = pgrid0.back();
+  for (unsigned i=0; i<pgrid0.size(); i++) pgrid0[i] -= potlF;
 }
 
 void * Shells::determine_coefficients_thread(void *arg) 
@@ -352,9 +244,7 @@ void * Shells::determine_coefficients_thread(void *arg)
 	      cC->Pos(j, 2)*cC->Pos(j, 2) 
 	      );
 				// Load vectors
-    rgridT[id].push_back(rr);
-    mgridT[id].push_back(cC->Mass(j));
-    igridT[id].push_back(j);
+    sampleT[id].push_back({rr, cC->Mass(j), static_cast<int>(j)});
     usedT[id]++;
   }
 
@@ -429,20 +319,16 @@ void Shells::multistep_update_finish()
 		MPI_COMM_WORLD);
 
   //
-  // Each process performs the update
+  // Each process moves the samples that it holds; a particle may
+  // have been sampled on another process before a redistribution
   //
-  map<int, double>::iterator rr, mm;
-
   for (int i=0; i<nsum; i++) {
 
-    rr = rgrid[fr[i]].find(ii[i]);
-    mm = mgrid[fr[i]].find(ii[i]);
+    auto it = records[fr[i]].find(ii[i]);
+    if (it == records[fr[i]].end()) continue;
 
-    rgrid[to[i]][ii[i]] = rr->second;
-    mgrid[to[i]][ii[i]] = mm->second;
-
-    rgrid[fr[i]].erase(rr);
-    mgrid[fr[i]].erase(mm);
+    records[to[i]][ii[i]] = it->second;
+    records[fr[i]].erase(it);
   }
 
 }
@@ -454,10 +340,8 @@ void Shells::multistep_update_finish()
 //
 void Shells::multistep_update(int fr, int to, Component *c, int ii, int id)
 {
-  if (rgrid[fr].find(ii) != rgrid[fr].end()) {
-    update_fr[id].push_back(fr);
-    update_to[id].push_back(to);
-    update_ii[id].push_back(ii);
-  }
+  update_fr[id].push_back(fr);
+  update_to[id].push_back(to);
+  update_ii[id].push_back(ii);
 }
 
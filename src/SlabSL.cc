@@ -3,6 +3,8 @@
 
 #include "expand.H"
 
+#include <ThreadPool.H>
+#include <NodeShared.H>
 #include <SlabSL.H>
 
 const std::set<std::string>
@@ -15,7 +17,9 @@ SlabSL::valid_keys = {
   "hslab",
   "zmax",
   "ngrid",
-  "type"
+  "type",
+  "nufft",
+  "nufftTol"
 };
 
 //@{
@@ -40,6 +44,7 @@ SlabSL::SlabSL(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   initialize();
 
   SLGridSlab::mpi  = 1;
+  SLGridSlab::threads = nthrds;
   SLGridSlab::ZBEG = 0.0;
   SLGridSlab::ZEND = 0.1;
   SLGridSlab::H    = hslab;
@@ -134,6 +139,20 @@ SlabSL::SlabSL(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
     expccofN[i] -> setZero();
     expccofL[i] -> setZero();
   }
+
+  // Non-uniform FFT workspace.  The transforms are planned here,
+  // before any threads use them.
+  //
+  if (nufft) {
+    nuRec.resize(nthrds);
+    nuMs.resize(multistep+1);
+    for (auto & v : nuMs) v.resize(nthrds);
+
+    for (int n=0; n<nthrds; n++)
+      nuGrid.push_back(std::make_shared<NUFFT2d>(nmaxx, nmaxy, 3, nufftTol));
+
+    nuStart.resize(2*(grid->numZ()-1)+1);
+  }
     
 }
 
@@ -162,6 +181,8 @@ void SlabSL::initialize()
     if (conf["hslab"])          hslab       = conf["hslab"].as<double>();
     if (conf["zmax" ])          zmax        = conf["zmax" ].as<double>();
     if (conf["type" ])          type        = conf["type" ].as<std::string>();
+    if (conf["nufft"])          nufft       = conf["nufft"].as<bool>();
+    if (conf["nufftTol"])       nufftTol    = conf["nufftTol"].as<double>();
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in SlabSL: "
@@ -192,6 +213,8 @@ void SlabSL::determine_coefficients(void)
     expccof[i].setZero();
   }
 
+  if (nufft) for (auto & v : nuRec) v.clear();
+
   // Swap interpolation arrays
   //
   if (multistep) {
@@ -224,6 +247,12 @@ void SlabSL::determine_coefficients(void)
   exp_thread_fork(true);
 #endif
 
+  // Transform the contributions recorded by the threads (none when
+  // the coefficients came from the device)
+  //
+  if (nufft)
+    nufft_accumulate(nuRec, [this](int id) -> coefType& { return expccof[id]; });
+
   int used1 = 0, rank = expccof[0].size();
   used = 0;
   for (int i=1; i<nthrds; i++) {
@@ -236,13 +265,13 @@ void SlabSL::determine_coefficients(void)
 
   if (multistep) {
 
-    MPI_Allreduce( expccof[0].data(), expccofN[mlevel]->data(),
-		   expccof[0].size(),
-		   MPI_CXX_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+    NodeSharedComm::allreduce( expccof[0].data(), expccofN[mlevel]->data(),
+			       expccof[0].size(),
+			       MPI_CXX_DOUBLE_COMPLEX, MPI_SUM);
   } else {
     
-    MPI_Allreduce( MPI_IN_PLACE, expccof[0].data(), expccof[0].size(),
-		   MPI_CXX_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+    NodeSharedComm::allreduce( MPI_IN_PLACE, expccof[0].data(), expccof[0].size(),
+			       MPI_CXX_DOUBLE_COMPLEX, MPI_SUM);
   }
 
   // Last level?
@@ -285,6 +314,10 @@ void * SlabSL::determine_coefficients_thread(void * arg)
     else
       cC->AddPos(i, 1, -floor(cC->Pos(i, 1)) );
     
+    if (nufft) {
+      nufft_record(nuRec[id], cC, i, -4.0*M_PI * cC->Mass(i) * adb);
+      continue;
+    }
 
 				// Recursion multipliers
     stepx = exp(-kfac*cC->Pos(i, 0));
@@ -528,12 +561,25 @@ void SlabSL::multistep_update_begin()
   for (int n=0; n<nthrds; n++) {
     for (int M=mfirst[mdrft]; M<=multistep; M++) differ1[n][M].setZero();
   }
+
+  if (nufft) {
+    for (int M=mfirst[mdrft]; M<=multistep; M++)
+      for (auto & v : nuMs[M]) v.clear();
+  }
 }
 
 void SlabSL::multistep_update_finish()
 {
   if (play_back and not play_cnew) return;
 
+  // Transform the recorded level changes
+  //
+  if (nufft) {
+    for (int M=mfirst[mdrft]; M<=multistep; M++)
+      nufft_accumulate(nuMs[M],
+		       [this, M](int id) -> coefType& { return differ1[id][M]; });
+  }
+
   // Combine the update matricies from all nodes
   //
   unsigned sz = (multistep - mfirst[mdrft] + 1)*jmax;
@@ -554,8 +600,8 @@ void SlabSL::multistep_update_finish()
       }
   }
 
-  MPI_Allreduce (pack.data(), unpack.data(), sz, 
-		 MPI_DOUBLE_COMPLEX, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(pack.data(), unpack.data(), sz,
+			    MPI_DOUBLE_COMPLEX, MPI_SUM);
   
   // Update the local coefficients
   //
@@ -575,6 +621,12 @@ void SlabSL::multistep_update(int from, int to, Component *c, int i, int id)
 
   double mass = -4.0 * M_PI * c->Mass(i) * component->Adiabatic();
 
+  if (nufft) {
+    nufft_record(nuMs[from][id], c, i, -mass);
+    nufft_record(nuMs[  to][id], c, i,  mass);
+    return;
+  }
+
   double x = c->Pos(i, 0);
   double y = c->Pos(i, 1);
   double z = c->Pos(i, 2);
@@ -622,6 +674,69 @@ void SlabSL::multistep_update(int from, int to, Component *c, int i, int id)
   // END: x horizontal loop
 }
 
+void SlabSL::multistep_update_batch(int from, int to, Component *c,
+				    const std::vector<int>& idx, int id)
+{
+  if (play_back and not play_cnew) return;
+
+  if (nufft) {
+    for (auto i : idx) multistep_update(from, to, c, i, id);
+    return;
+  }
+
+  // Every particle of the batch leaves level <from> and joins level
+  // <to>, so the contributions are summed once and applied to both
+  //
+  coefType D(imx, imy, imz);
+  D.setZero();
+
+  for (auto i : idx) {
+    if (c->freeze(i)) continue;
+
+    double mass = -4.0 * M_PI * c->Mass(i) * component->Adiabatic();
+
+    double x = c->Pos(i, 0);
+    double y = c->Pos(i, 1);
+    double z = c->Pos(i, 2);
+
+    if (x<0.0)  x += floor(x) + 1.0;
+    else        x -= floor(x);
+
+    if (y<0.0)  y += floor(y) + 1.0;
+    else        y -= floor(y);
+
+    // Recursion multipliers
+    std::complex<double> stepx = std::exp(-kfac*x);
+    std::complex<double> stepy = std::exp(-kfac*y);
+
+    // Initial values for recursion
+    std::complex<double> startx = std::exp(kfac*(x*nmaxx));
+    std::complex<double> starty = std::exp(kfac*(y*nmaxy));
+
+    std::complex<double> facx, facy;
+    int ix, iy;
+
+    for (facx=startx, ix=0; ix<imx; ix++, facx*=stepx) {
+
+      int iix = abs(ix - nmaxx);
+
+      for (facy=starty, iy=0; iy<imy; iy++, facy*=stepy) {
+
+	int iiy = abs(iy - nmaxy);
+
+	if (iix>=iiy) grid->get_pot(zpot[id], z, iix, iiy);
+	else          grid->get_pot(zpot[id], z, iiy, iix);
+
+	std::complex<double> fac = mass*facx*facy;
+	for (int iz = 0; iz<imz; iz++) D(ix, iy, iz) += fac*zpot[id][iz];
+      }
+    }
+  }
+
+  differ1[id][from] -= D;
+  differ1[id][  to] += D;
+}
+
 void SlabSL::compute_multistep_coefficients()
 {
   if (play_back and not play_cnew) return;
@@ -668,3 +783,91 @@ void SlabSL::compute_multistep_coefficients()
     }
   }
 }
+
+void SlabSL::nufft_record(std::vector<NuRec>& rec, Component* c, int i, double w)
+{
+  NuRec r;
+
+  r.x = c->Pos(i, 0);
+  r.y = c->Pos(i, 1);
+  r.w = w;
+
+  grid->pot_cell(c->Pos(i, 2), r.indx, r.x1, r.x2, r.sign);
+
+  rec.push_back(r);
+}
+
+void SlabSL::nufft_accumulate(std::vector<std::vector<NuRec>>& rec,
+			      const std::function<coefType&(int)>& out)
+{
+  // The vertical factor of each basis function is the product of
+  // two linear interpolants in the table cell of the particle (see
+  // SLGridSlab::pot_cell), so the coefficients are, per cell and
+  // sign, three in-plane sums with the weights w*x1^2, w*x1*x2 and
+  // w*x2^2 contracted with the table values at the cell ends.
+
+  // Sort the contributions by cell and sign
+  //
+  int nkey = nuStart.size() - 1;
+  auto key = [](const NuRec& r) { return 2*r.indx + (r.sign<0 ? 1 : 0); };
+
+  std::fill(nuStart.begin(), nuStart.end(), 0);
+  size_t total = 0;
+  for (auto & v : rec) {
+    for (auto & r : v) nuStart[key(r)+1]++;
+    total += v.size();
+  }
+
+  if (total==0) return;
+
+  for (int k=0; k<nkey; k++) nuStart[k+1] += nuStart[k];
+
+  nuSort.resize(total);
+  std::vector<int> next(nuStart.begin(), nuStart.end()-1);
+  for (auto & v : rec) {
+    for (auto & r : v) nuSort[next[key(r)]++] = r;
+  }
+
+  std::vector<int> cells;
+  for (int k=0; k<nkey; k++) if (nuStart[k+1] > nuStart[k]) cells.push_back(k);
+
+  int ncell = cells.size();
+
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    std::vector<Eigen::MatrixXcd> F;
+    coefType & coef = out(id);
+    auto & nu = *nuGrid[id];
+
+    for (int c=id; c<ncell; c+=nthrds) {
+      int k = cells[c], j = k/2;
+      double sgn = (k % 2) ? -1.0 : 1.0;
+
+      nu.reset();
+      for (int q=nuStart[k]; q<nuStart[k+1]; q++) {
+	auto & r = nuSort[q];
+	double w[3] = {r.w*r.x1*r.x1, r.w*r.x1*r.x2, r.w*r.x2*r.x2};
+	nu.spread(r.x, r.y, w);
+      }
+      nu.transform(F);
+
+      double p0 = grid->pot_p0(j), p1 = grid->pot_p0(j+1);
+
+      for (int ix=0; ix<imx; ix++) {
+	int kx = abs(ix - nmaxx);
+	for (int iy=0; iy<imy; iy++) {
+	  int ky = abs(iy - nmaxy);
+	  double s = 1.0;
+	  for (int iz=0; iz<imz; iz++) {
+	    double e0 = grid->pot_ef(kx, ky, iz, j);
+	    double e1 = grid->pot_ef(kx, ky, iz, j+1);
+	    coef(ix, iy, iz) += s*(F[0](ix, iy)*e0*p0 +
+				   F[1](ix, iy)*(e0*p1 + e1*p0) +
+				   F[2](ix, iy)*e1*p1);
+	    s *= sgn;
+	  }
+	}
+      }
+    }
+  });
+}
@@ -53,6 +53,8 @@ Sphere::Sphere(Component* c0, const YAML::Node& conf, MixtureBasis* m) :
   }
 				// Enable MPI code for more than one node
   if (numprocs>1) SLGridSph::mpi = 1;
+				// Threads for the eigenproblems
+  SLGridSph::threads = nthrds;
 
   std::string modelname = model_file;
   std::string cachename = outdir  + cache_file;
@@ -68,6 +70,10 @@ Sphere::Sphere(Component* c0, const YAML::Node& conf, MixtureBasis* m) :
   rmin  = ortho->getRmin();
   rmax  = ortho->getRmax();
 
+				// Potential, force and density tables
+  memtrack.set("basis tables", component->name,
+	       3*(Lmax+1)*nmax*numr*sizeof(double));
+
   if (myid==0) {
     std::string sep("----    ");
     std::cout << "---- Sphere parameters: "
@@ -146,6 +152,13 @@ void Sphere::get_dpotl(int lmax, int nmax, double r, Eigen::MatrixXd& p,
   ortho->get_force(dp, r);
 }
 
+void Sphere::get_dpotl_batch(int lmax, int nmax, int nb, const double* r,
+			     Eigen::MatrixXd& p, Eigen::MatrixXd& dp, int tid)
+{
+  ortho->get_pot_batch  (p,  r, nb);
+  ortho->get_force_batch(dp, r, nb);
+}
+
 void Sphere::get_potl(int lmax, int nmax, double r, Eigen::MatrixXd& p, int tid)
 {
   ortho->get_pot(p, r);
@@ -2,12 +2,15 @@
 
 #include <filesystem>
 #include <sstream>
+#include <numeric>
 #include <chrono>
 #include <string>
 #include <vector>
 #include <set>
 
 #include <SphericalBasis.H>
+#include <ThreadPool.H>
+#include <NodeShared.H>
 #include <MixtureBasis.H>
 
 // #define TMP_DEBUG
@@ -41,10 +44,24 @@ SphericalBasis::valid_keys = {
   "noise_model_file",
   "seedN",
   "ssfrac",
+  "sstarget",
+  "ssmin",
+  "predict",
+  "predictTol",
+  "predictSkip",
+  "coefFloat",
   "playback",
   "coefCompute",
   "coefMaster",
-  "orthocheck"
+  "coefShare",
+  "orthocheck",
+  "batch",
+  "binned",
+  "binnr",
+  "sparseTol",
+  "legTol",
+  "factorCache",
+  "cudampi"
 };
 
 SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBasis *m) : 
@@ -66,6 +83,8 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
   mix              = m;
   geometry         = sphere;
   coef_dump        = true;
+  soa_aware        = true;
+  chunk_aware      = true;
   NO_L0            = false;
   NO_L1            = false;
   EVEN_L           = false;
@@ -75,12 +94,31 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
   noiseN           = 1.0e-6;
   noise_model_file = "SLGridSph.model";
   ssfrac           = 0.0;
+  sstarget         = 0.0;
+  ssmin            = 0.05;
+  predict          = 0;
+  predictTol       = 1.0e-3;
+  predictSkip      = 1;
+  coefFloat        = false;
+  sparseTol        = 0.0;
+  legTol           = 0.0;
+  factorCache      = 0.0;
+  nbatch           = 64;
+  binned           = false;
+  binpass          = false;
+  binnr            = 1024;
   subset           = false;
   setup_noise      = true;
   coefMaster       = true;
+  coefShare        = false;
   lastPlayTime     = -std::numeric_limits<double>::max();
 #if HAVE_LIBCUDA==1
   cuda_aware       = true;
+  cuda_mpi         = false;
+  dev_pending      = false;
+  dev_current      = false;
+  launched         = false;
+  launched_use     = 0;
 #endif
   ortho_check      = false;
 
@@ -137,6 +175,23 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
       if (ssfrac>0.0 && ssfrac<1.0) subset = true;
     }
 
+    if (conf["sstarget"]) sstarget = conf["sstarget"].as<double>();
+    if (conf["ssmin"])    ssmin    = conf["ssmin"].as<double>();
+
+    // Start from the configured fraction, or all particles
+    //
+    ssmin = std::min<double>(std::max<double>(ssmin, 0.0), 1.0);
+    ssfracL.resize(multistep+1, subset ? std::max<double>(ssfrac, ssmin) : 1.0);
+
+    if (conf["predict"])     predict     = conf["predict"].as<int>();
+    if (conf["predictTol"])  predictTol  = conf["predictTol"].as<double>();
+    if (conf["predictSkip"]) predictSkip = conf["predictSkip"].as<int>();
+    if (conf["coefFloat"])   coefFloat   = conf["coefFloat"].as<bool>();
+
+    predHist .resize(multistep+1);
+    predErr  .resize(multistep+1, std::numeric_limits<double>::max());
+    predSkips.resize(multistep+1, 0);
+
     if (conf["playback"]) {
       std::string file = conf["playback"].as<std::string>();
 				// Check the file exists
@@ -149,8 +204,13 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
 	}
       }
 
-      // This creates the Coefs instance
-      playback = std::dynamic_pointer_cast<CoefClasses::SphCoefs>(CoefClasses::Coefs::factory(file));
+      // This creates the Coefs instance.  Snapshots are read from H5
+      // files on demand as playback advances.
+      playback = std::dynamic_pointer_cast<CoefClasses::SphCoefs>
+	(CoefClasses::Coefs::factory(file, 1,
+				      -std::numeric_limits<double>::max(),
+				       std::numeric_limits<double>::max(),
+				      true));
 
       // Check to make sure that has been created
       if (not playback) {
@@ -185,11 +245,22 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
 
       if (conf["coefMaster"]) coefMaster = conf["coefMaster"].as<bool>();
 
+      // Each node holds the coefficients once and every process
+      // interpolates them locally, so nothing is broadcast per step
+      if (conf["coefShare"]) coefShare = conf["coefShare"].as<bool>();
+
+      if (coefShare) {
+	playback->shareSeries();
+	coefMaster = false;
+      }
+
       if (myid==0) {
 	std::cout << "---- Playback is ON for Component " << component->name
 		  << " using Force " << component->id << std::endl;
 	if (coefMaster)
 	  std::cout << "---- Playback will use MPI master" << std::endl;
+	if (coefShare)
+	  std::cout << "---- Playback will use node-shared coefficients" << std::endl;
 
 	if (play_cnew)
 	  std::cout << "---- New coefficients will be computed from particles on playback" << std::endl;
@@ -198,6 +269,21 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
     // END: playback config
 
     if (conf["orthocheck"]) ortho_check = conf["orthocheck"].as<bool>();
+
+    if (conf["batch"]) nbatch = std::max<int>(1, conf["batch"].as<int>());
+
+    if (conf["sparseTol"]) sparseTol = conf["sparseTol"].as<double>();
+
+    if (conf["legTol"]) legTol = conf["legTol"].as<double>();
+
+    if (conf["factorCache"]) factorCache = conf["factorCache"].as<double>();
+
+    if (conf["binned"]) binned = conf["binned"].as<bool>();
+    if (conf["binnr"])  binnr  = std::max<int>(2, conf["binnr"].as<int>());
+
+#if HAVE_LIBCUDA==1
+    if (conf["cudampi"]) cuda_mpi = conf["cudampi"].as<bool>();
+#endif
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in SphericalBasis: "
@@ -212,17 +298,50 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
 
   if (nthrds<1) nthrds=1;
 
+  if (legTol>0.0) {
+    legtable = std::make_shared<LegendreTable>(Lmax, legTol);
+    if (myid==0)
+      std::cout << "---- SphericalBasis: Legendre table with "
+		<< legtable->Nodes() << " nodes, relative error "
+		<< legtable->error() << std::endl;
+  }
+
+  if (factorCache>0.0 and myid==0)
+    std::cout << "---- SphericalBasis: particle factor cache of "
+	      << factorCache << " MB per level" << std::endl;
+
+  if (binned and sstarget>0.0) {
+    if (myid==0)
+      std::cout << "---- SphericalBasis: binned coefficients do not "
+		<< "provide the variance for sstarget; binning is off"
+		<< std::endl;
+    binned = false;
+  }
+
+#if HAVE_LIBCUDA==1
+  if (cuda_mpi and not cuda_aware_mpi()) {
+    if (myid==0)
+      std::cout << "---- SphericalBasis: MPI library does not accept "
+		<< "device pointers; coefficients will be reduced on the host"
+		<< std::endl;
+    cuda_mpi = false;
+  }
+#endif
+
   initialize();
 
   // Allocate coefficient matrix (one for each multistep level)
   // and zero-out contents
   //
+  // Each thread allocates and first touches its own differences
+  //
   differ1 = std::vector< std::vector<Eigen::MatrixXd> >(nthrds);
-  for (int n=0; n<nthrds; n++) {
+  ThreadPool::instance().run(nthrds, [&](int n)
+  {
     differ1[n].resize(multistep+1);
     for (int i=0; i<=multistep; i++)
-      differ1[n][i].resize((Lmax+1)*(Lmax+1), nmax);
-  }
+      differ1[n][i].setZero((Lmax+1)*(Lmax+1), nmax);
+  });
 
   // MPI buffer space
   //
@@ -253,11 +372,24 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
   for (auto & v : expcoef ) v = std::make_shared<Eigen::VectorXd>(nmax);
   for (auto & v : expcoef1) v = std::make_shared<Eigen::VectorXd>(nmax);
   
+  // Per-thread storage is allocated and first touched by its thread
+  // (see ThreadPool)
+  //
   expcoef0.resize(nthrds);
-  for (auto & t : expcoef0) {
-    t.resize((Lmax+1)*(Lmax+1));
-    for (auto & v : t) v = std::make_shared<Eigen::VectorXd>(nmax);
-  }
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    expcoef0[id].resize((Lmax+1)*(Lmax+1));
+    for (auto & v : expcoef0[id])
+      v = std::make_shared<Eigen::VectorXd>(Eigen::VectorXd::Zero(nmax));
+  });
+
+  // Multistep histories, per-thread differences and accumulators and
+  // the MPI buffers
+  //
+  memtrack.set("coefficients", component->name,
+	       ((2 + nthrds)*(multistep+1) + nthrds + 2)*
+	       (Lmax+1)*(Lmax+1)*nmax*sizeof(double) +
+	       2*sz*sizeof(double));
 
   // Allocate normalization matrix
 
@@ -285,8 +417,9 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
   potd.resize(nthrds);
   dpot.resize(nthrds);
 
-  for (auto & v : potd) v.resize(Lmax+1, nmax);
-  for (auto & v : dpot) v.resize(Lmax+1, nmax);
+  batchwork.resize(nthrds);
+
+  fieldwork.resize(nthrds);
 
   // Sin, cos, legendre
   //
@@ -295,18 +428,35 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
   legs .resize(nthrds);
   dlegs.resize(nthrds);
 
-  for (auto & v : cosm)  v.resize(Lmax+1);
-  for (auto & v : sinm)  v.resize(Lmax+1);
-  for (auto & v : legs)  v.resize(Lmax+1, Lmax+1);
-  for (auto & v : dlegs) v.resize(Lmax+1, Lmax+1);
-
   // Work vectors
   //
   u. resize(nthrds);
   du.resize(nthrds);
 
-  for (auto & v : u)  v.resize(nmax+1);
-  for (auto & v : du) v.resize(nmax+1);
+  // Each thread allocates and first touches its own work space
+  //
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    potd[id].setZero(Lmax+1, nmax);
+    dpot[id].setZero(Lmax+1, nmax);
+
+    auto & w = fieldwork[id];
+    w.dend .setZero(Lmax+1, nmax);
+    w.potd .setZero(Lmax+1, nmax);
+    w.dpot .setZero(Lmax+1, nmax);
+    w.legs .setZero(Lmax+1, Lmax+1);
+    w.dlegs.setZero(Lmax+1, Lmax+1);
+    w.cosm .setZero(Lmax+1);
+    w.sinm .setZero(Lmax+1);
+
+    cosm [id].setZero(Lmax+1);
+    sinm [id].setZero(Lmax+1);
+    legs [id].setZero(Lmax+1, Lmax+1);
+    dlegs[id].setZero(Lmax+1, Lmax+1);
+
+    u [id].setZero(nmax+1);
+    du[id].setZero(nmax+1);
+  });
 
   // Factorial matrix
   //
@@ -321,6 +471,8 @@ SphericalBasis::SphericalBasis(Component* c0, const YAML::Node& conf, MixtureBas
 
   firstime_coef  = true;
   firstime_accel = true;
+  coef_pending   = false;
+  coef_hier      = false;
 
 #ifdef DEBUG
   pthread_mutex_init(&io_lock, NULL);
@@ -411,18 +563,24 @@ void SphericalBasis::get_acceleration_and_potential(Component* C)
 }
 
 
+void SphericalBasis::schedule(bool coef)
+{
+  if (coef and ssfraction(mlevel)<1.0)
+    sched.reset(component->levlist, mlevel, mlevel, nthrds, worksteal,
+		ChunkScheduler::default_chunk, ssfraction(mlevel));
+  else
+    PotAccel::schedule(coef);
+}
+
 void * SphericalBasis::determine_coefficients_thread(void * arg)
 {
   // Biorthgonal normalization factor
   //
   double fac0=-4.0*M_PI;
 
-  // Partition bodies and get features
+  // Get features; the particle ranges come from the scheduler
   //
-  unsigned nbodies = component->levlist[mlevel].size();
   int id = *((int*)arg);
-  int nbeg = nbodies*id/nthrds;
-  int nend = nbodies*(id+1)/nthrds;
   double adb = component->Adiabatic();
   std::vector<double> wk(nmax);
 
@@ -440,141 +598,160 @@ void * SphericalBasis::determine_coefficients_thread(void * arg)
   vector<double> ctr;
   if (mix) mix->getCenter(ctr);
 
-				// Compute potential using a 
-				// subset of particles
-  if (subset) nend = (int)floor(ssfrac*nend);
-
   unsigned whch = 0;		// For PCA jacknife
 
-  for (int i=nbeg; i<nend; i++) {
+  unsigned lev;
+  int nbeg, nend;
+
+  while (sched.next(id, lev, nbeg, nend)) {
+
+    double frac = ssfraction(lev);
+
+    for (int i=nbeg; i<nend; i++) {
 
-    int indx = component->levlist[mlevel][i];
+      int indx = component->levlist[lev][i];
 
-    if (component->freeze(indx)) continue;
+      if (component->freeze(indx)) continue;
 
     
-    double mass = component->Mass(indx) * adb;
+      double mass = component->Mass(indx) * adb;
 				// Adjust mass for subset
-    if (subset) mass /= ssfrac;
+      if (frac<1.0) mass /= frac;
     
-    double xx, yy, zz;
-    if (mix) {
-      xx = component->Pos(indx, 0, Component::Local) - ctr[0];
-      yy = component->Pos(indx, 1, Component::Local) - ctr[1];
-      zz = component->Pos(indx, 2, Component::Local) - ctr[2];
-    } else {
-      xx = component->Pos(indx, 0, Component::Local | Component::Centered);
-      yy = component->Pos(indx, 1, Component::Local | Component::Centered);
-      zz = component->Pos(indx, 2, Component::Local | Component::Centered);
-    }
+      double xx, yy, zz;
+      if (mix) {
+	xx = component->Pos(indx, 0, Component::Local) - ctr[0];
+	yy = component->Pos(indx, 1, Component::Local) - ctr[1];
+	zz = component->Pos(indx, 2, Component::Local) - ctr[2];
+      } else {
+	xx = component->Pos(indx, 0, Component::Local | Component::Centered);
+	yy = component->Pos(indx, 1, Component::Local | Component::Centered);
+	zz = component->Pos(indx, 2, Component::Local | Component::Centered);
+      }
 
-    double r2 = (xx*xx + yy*yy + zz*zz);
-    double r  = sqrt(r2) + DSMALL;
+      double r2 = (xx*xx + yy*yy + zz*zz);
+      double r  = sqrt(r2) + DSMALL;
       
-    if (r>=rmin and r<=rmax) {
+      if (r>=rmin and r<=rmax) {
 
-      use[id]++;
-      double costh = zz/r;
-      double phi = atan2(yy,xx);
-      double rs = r/scale;
+	use[id]++;
+	double costh = zz/r;
+	double phi = atan2(yy,xx);
+	double rs = r/scale;
       
-      legendre_R(Lmax, costh, legs[id]);
-      sinecosine_R(Lmax, phi, cosm[id], sinm[id]);
-
-      get_potl(Lmax, nmax, rs, potd[id], id);
-
-      if (compute) {
-	muse1[id] += mass;
-	if (pcavar) {
-	  whch = indx % sampT;
-	  pthread_mutex_lock(&cc_lock);
-	  massT1[whch] += mass;
-	  pthread_mutex_unlock(&cc_lock);
+	// Keep the factors with their derivatives for the force pass?
+	//
+	bool keep = lev < fcslots.size() and i < fcslots[lev];
+
+	if (keep) dlegendre_R(Lmax, costh, legs[id], dlegs[id]);
+	else      legendre_R (Lmax, costh, legs[id]);
+	sinecosine_R(Lmax, phi, cosm[id], sinm[id]);
+
+	if (binpass) {
+	  if (compute) muse1[id] += mass;
+	  bin_deposit(id, mass, r);
+	  continue;
 	}
-      }
 
-      //		l loop
-      for (int l=0, loffset=0, iC=0; l<=Lmax; loffset+=(2*l+1), l++) {
-	//		m loop
-	for (int m=0, moffset=0; m<=l; m++) {
+	if (keep) {
+	  get_dpotl(Lmax, nmax, rs, potd[id], dpot[id], id);
+	  cache_factors(lev, i, indx, xx, yy, zz, id);
+	} else
+	  get_potl(Lmax, nmax, rs, potd[id], id);
+
+	if (compute) {
+	  muse1[id] += mass;
+	  if (pcavar) {
+	    whch = indx % sampT;
+	    massT0[id][whch] += mass;
+	  }
+	}
 
-	  double facL = factorial(l, m) * legs[id](l, m);
+	//		l loop
+	for (int l=0, loffset=0, iC=0; l<=Lmax; loffset+=(2*l+1), l++) {
+	  //		m loop
+	  for (int m=0, moffset=0; m<=l; m++) {
 
-	  if (m==0) {
-	    for (int n=0; n<nmax; n++) {
-	      wk[n] = potd[id](l, n)*facL*mass*fac0/sqnorm(l, n);
-	      (*expcoef0[id][loffset+moffset])[n] += wk[n];
-	    }
+	    double facL = factorial(l, m) * legs[id](l, m);
 
-	    if (compute and pcavar) {
-	      pthread_mutex_lock(&cc_lock);
+	    if (m==0) {
 	      for (int n=0; n<nmax; n++) {
-		(*expcoefT1[whch][iC])[n] += wk[n];
-		for (int o=0; o<nmax; o++)
-		  (*expcoefM1[whch][iC])(n, o) += wk[n]*wk[o]/mass;
+		wk[n] = potd[id](l, n)*facL*mass*fac0/sqnorm(l, n);
+		(*expcoef0[id][loffset+moffset])[n] += wk[n];
 	      }
-	      pthread_mutex_unlock(&cc_lock);
-	    }
 
-	    if (compute and pcaeof) {
-	      pthread_mutex_lock(&cc_lock);
-	      for (int n=0; n<nmax; n++) {
-		for (int o=0; o<nmax; o++) {
-		  (*tvar[iC])(n, o) += wk[n]*wk[o]/mass;
-		}
+	      if (sstarget>0.0) {
+		for (int n=0; n<nmax; n++) ssvar[id] += wk[n]*wk[n];
 	      }
-	      pthread_mutex_unlock(&cc_lock);
+
+	      if (compute and pcavar) {
+		Eigen::Map<Eigen::VectorXd> w(wk.data(), nmax);
+		expcoefT0[id][whch][iC] += w;
+		expcoefM0[id][whch][iC].noalias() += w*w.transpose()/mass;
+	      }
+
+	      if (compute and pcaeof) {
+		Eigen::Map<Eigen::VectorXd> w(wk.data(), nmax);
+		pcabuf[id][iC].add(w, 1.0/mass, tvar0[id][iC]);
+	      }
+
+	      iC++;
+	      moffset++;
 	    }
+	    else {
+	      if (not M0_only) {
 
-	    iC++;
-	    moffset++;
-	  }
-	  else {
-	    if (not M0_only) {
+		double fac1 = facL*cosm[id][m];
+		double fac2 = facL*sinm[id][m];
 
-	      double fac1 = facL*cosm[id][m];
-	      double fac2 = facL*sinm[id][m];
+		for (int n=0; n<nmax; n++) {
 
-	      for (int n=0; n<nmax; n++) {
+		  wk[n] = potd[id](l, n)*mass*fac0/sqnorm(l, n);
 
-		wk[n] = potd[id](l, n)*mass*fac0/sqnorm(l, n);
+		  (*expcoef0[id][loffset+moffset  ])[n] += wk[n]*fac1;
+		  (*expcoef0[id][loffset+moffset+1])[n] += wk[n]*fac2;
+		}
 
-		(*expcoef0[id][loffset+moffset  ])[n] += wk[n]*fac1;
-		(*expcoef0[id][loffset+moffset+1])[n] += wk[n]*fac2;
-	      }
+		if (sstarget>0.0) {
+		  double fac = fac1*fac1 + fac2*fac2;
+		  for (int n=0; n<nmax; n++) ssvar[id] += wk[n]*wk[n]*fac;
+		}
 
-	      if (compute and pcavar) {
-		pthread_mutex_lock(&cc_lock);
-		for (int n=0; n<nmax; n++) {
-		  (*expcoefT1[whch][iC])[n] += wk[n]*facL;
-		  for (int o=0; o<nmax; o++)
-		    (*expcoefM1[whch][iC])(n, o) += wk[n]*wk[o]*facL*facL/mass;
+		if (compute and pcavar) {
+		  Eigen::Map<Eigen::VectorXd> w(wk.data(), nmax);
+		  expcoefT0[id][whch][iC] += w*facL;
+		  expcoefM0[id][whch][iC].noalias() +=
+		    w*w.transpose()*(facL*facL/mass);
 		}
-		pthread_mutex_unlock(&cc_lock);
-	      }
 	    
-	      if (compute and pcaeof) {
-		pthread_mutex_lock(&cc_lock);
-		for (int n=0; n<nmax; n++) {
-		  for (int o=0; o<nmax; o++) {
-		    (*tvar[iC])(n, o) += wk[n]*wk[o]/mass;
-		  }
+		if (compute and pcaeof) {
+		  Eigen::Map<Eigen::VectorXd> w(wk.data(), nmax);
+		  pcabuf[id][iC].add(w, 1.0/mass, tvar0[id][iC]);
 		}
-		pthread_mutex_unlock(&cc_lock);
 	      }
-	    }
 
-	    iC++;
-	    moffset+=2;
-	  } // m!=0
+	      iC++;
+	      moffset+=2;
+	    } // m!=0
+
+	  } // m loop
+
+	} // l loop
 
-	} // m loop
+      } // r < rmax
 
-      } // l loop
+    } // particle loop
 
-    } // r < rmax
+  } // chunk loop
 
-  } // particle loop
+  // Apply the pending covariance updates
+  //
+  if (compute and pcaeof) {
+    for (size_t iC=0; iC<tvar0[id].size(); iC++) {
+      pcabuf[id][iC].flush(tvar0[id][iC]);
+      SyrkBuffer::symmetrize(tvar0[id][iC]);
+    }
+  }
 
   thread_timing_end(id);
 
@@ -582,6 +759,75 @@ void * SphericalBasis::determine_coefficients_thread(void * arg)
 }
 
 
+void SphericalBasis::bin_deposit(int id, double mass, double r)
+{
+  // Linear weights in x = r/(r+scale)
+  //
+  double x = (r/(r + scale) - bxmin)/bdx;
+  int i = std::min<int>(std::max<int>(static_cast<int>(x), 0), binnr-2);
+  double w1 = std::min<double>(std::max<double>(x - i, 0.0), 1.0);
+  double w0 = 1.0 - w1;
+
+  const int nL = (Lmax+1)*(Lmax+1);
+  double *g0 = &bingrid[id][i*nL], *g1 = g0 + nL;
+
+  // The same (l, m) slots as expcoef0
+  //
+  for (int l=0, loffset=0; l<=Lmax; loffset+=(2*l+1), l++) {
+    for (int m=0, moffset=0; m<=l; m++) {
+      double facL = factorial(l, m) * legs[id](l, m) * mass;
+      if (m==0) {
+	g0[loffset+moffset] += w0*facL;
+	g1[loffset+moffset] += w1*facL;
+	moffset++;
+      } else {
+	if (not M0_only) {
+	  double fac1 = facL*cosm[id][m], fac2 = facL*sinm[id][m];
+	  g0[loffset+moffset  ] += w0*fac1;
+	  g1[loffset+moffset  ] += w1*fac1;
+	  g0[loffset+moffset+1] += w0*fac2;
+	  g1[loffset+moffset+1] += w1*fac2;
+	}
+	moffset+=2;
+      }
+    }
+  }
+}
+
+void SphericalBasis::bin_project()
+{
+  const double fac0 = -4.0*M_PI;
+  const int nL = (Lmax+1)*(Lmax+1);
+
+  std::vector<double>& g = bingrid[0];
+  for (int n=1; n<nthrds; n++) {
+    for (size_t k=0; k<g.size(); k++) g[k] += bingrid[n][k];
+  }
+
+  for (int i=0; i<binnr; i++) {
+
+    const double *gi = &g[i*nL];
+    bool empty = true;
+    for (int L=0; L<nL and empty; L++) if (gi[L] != 0.0) empty = false;
+    if (empty) continue;
+
+    double x = bxmin + bdx*i;
+    double r = scale*x/(1.0 - x);
+    r = std::min<double>(std::max<double>(r, rmin), rmax);
+
+    get_potl(Lmax, nmax, r/scale, potd[0], 0);
+
+    for (int l=0, L=0; l<=Lmax; l++) {
+      for (int k=0; k<2*l+1; k++, L++) {
+	if (gi[L] == 0.0) continue;
+	auto & c = *expcoef0[0][L];
+	for (int n=0; n<nmax; n++)
+	  c[n] += potd[0](l, n)*fac0/sqnorm(l, n)*gi[L];
+      }
+    }
+  }
+}
+
 void SphericalBasis::determine_coefficients(void)
 {
   if (play_back) {
@@ -672,6 +918,15 @@ void SphericalBasis::determine_coefficients_particles(void)
 
   start0 = std::chrono::high_resolution_clock::now();
 
+  // Complete a reduction left over from the previous call
+  //
+  finish_coefficients();
+
+#if HAVE_LIBCUDA==1
+  bool prelaunched = launched;
+  launched = false;
+#endif
+
   // Return if we should leave the coefficients fixed
   //
   if (!self_consistent && !firstime_coef && !initializing) return;
@@ -684,6 +939,11 @@ void SphericalBasis::determine_coefficients_particles(void)
   }
 
 
+  // Use the extrapolated coefficients for this level if the
+  // corrector allows it
+  //
+  if (predict_coefficients()) return;
+
   int loffset, moffset, use1;
 
   if (compute) {
@@ -738,6 +998,10 @@ void SphericalBasis::determine_coefficients_particles(void)
 	for (auto & v : tvar) v->setZero();
       }
     }
+
+    // Per-thread accumulators for this pass
+    //
+    zero_thread_pca();
   }
 
 #ifdef DEBUG
@@ -756,6 +1020,8 @@ void SphericalBasis::determine_coefficients_particles(void)
   for (auto & v : expcoefN[mlevel]) v->setZero();
     
   for (auto & v : expcoef0) { for (auto & u : v) u->setZero(); }
+
+  if (sstarget>0.0) ssvar.assign(nthrds, 0.0);
     
   use1 = 0;
   if (multistep==0) used = 0;
@@ -792,14 +1058,34 @@ void SphericalBasis::determine_coefficients_particles(void)
     
   std::fill(use.begin(), use.end(), 0);
 
+  // Binned deposit on this pass?
+  //
+  binpass = binned and not (compute and (pcavar or pcaeof));
+
+  size_factors();
+
+  if (binpass) {
+    size_t ngrid = binnr*(Lmax+1)*(Lmax+1);
+    bingrid.resize(nthrds);
+    for (auto & v : bingrid) v.assign(ngrid, 0.0);
+
+    bxmin = rmin/(rmin + scale);
+    bdx   = (rmax/(rmax + scale) - bxmin)/(binnr - 1);
+  }
+
 #if HAVE_LIBCUDA==1
   if (component->cudaDevice>=0 and use_cuda) {
     if (cudaAccumOverride) {
       component->CudaToParticles();
       exp_thread_fork(true);
     } else {
+      binpass = false;		// The device pass is not binned
       start1  = std::chrono::high_resolution_clock::now();
-      determine_coefficients_cuda(compute);
+      if (prelaunched)		// Ran in launch_coefficients()
+	use[0] += launched_use;
+      else
+	determine_coefficients_cuda(compute);
+      if (dev_pending) post_device_reduction();
       DtoH_coefs(expcoef0[0]);
       finish1 = std::chrono::high_resolution_clock::now();
     }
@@ -817,53 +1103,148 @@ void SphericalBasis::determine_coefficients_particles(void)
   // Sum up the results from each thread
   //
   for (int i=0; i<nthrds; i++) use1 += use[i];
-  for (int i=1; i<nthrds; i++) {
-    for (int l=0; l<(Lmax+1)*(Lmax+1); l++) (*expcoef0[0][l]) += (*expcoef0[i][l]);
+
+  reduce_threads();
+
+  if (binpass) bin_project();
+
+  if (compute) {
+    if (pcavar) {
+      for (unsigned T=0; T<sampT; T++) {
+	massT1[T] += massT0[0][T];
+	for (size_t iC=0; iC<expcoefT1[T].size(); iC++) {
+	  *expcoefT1[T][iC] += expcoefT0[0][T][iC];
+	  *expcoefM1[T][iC] += expcoefM0[0][T][iC];
+	}
+      }
+    }
+
+    if (pcaeof) {
+      for (size_t iC=0; iC<tvar.size(); iC++) *tvar[iC] += tvar0[0][iC];
+    }
   }
   
   if (multistep==0 or tnow==resetT) {
     used += use1;
   }
   
-  for (int l=0, loffset=0; l<=Lmax; loffset+=(2*l+1), l++) {
-    
-    for (int m=0, moffset=0; m<=l; m++) {
+  // Pack the coefficients from all (l, m) blocks into a single buffer
+  // and post one non-blocking reduction.  The reduction completes in
+  // finish_coefficients(), which the caller may defer until the other
+  // components have accumulated their coefficients.
+  //
+#if HAVE_LIBCUDA==1
+  if (dev_pending) {
+    coef_pending = true;	// Posted on the device sums by
+				// determine_coefficients_cuda()
+  } else
+#endif
+  {
+    int ncoef = (Lmax+1)*(Lmax+1)*nmax;
 
-      if (m==0) {
-	  
-	if (multistep)
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset]).data(),
-			  (*expcoefN[mlevel][loffset+moffset]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	else
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset]).data(),
-			  (*expcoef[loffset+moffset]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	
-	moffset++;
-	  
-      } else {
-	
-	if (multistep) {
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset]).data(),
-			  (*expcoefN[mlevel][loffset+moffset]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	  
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset+1]).data(),
-			  (*expcoefN[mlevel][loffset+moffset+1]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	} else {
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset]).data(),
-			  (*expcoef[loffset+moffset]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	  
-	  MPI_Allreduce ( (*expcoef0[0][loffset+moffset+1]).data(),
-			  (*expcoef[loffset+moffset+1]).data(),
-			  nmax, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-	}
-	moffset+=2;
-      }
+    // The sum of squared contributions for adaptive subsampling
+    // rides along in one extra element
+    //
+    int nbuf  = ncoef + (sstarget>0.0 ? 1 : 0);
+    coefbuf0.resize(nbuf);
+    coefbuf1.resize(nbuf);
+
+    for (int L=0; L<(Lmax+1)*(Lmax+1); L++)
+      Eigen::Map<Eigen::VectorXd>(&coefbuf0[L*nmax], nmax) = *expcoef0[0][L];
+
+    if (sstarget>0.0)
+      coefbuf0[ncoef] = std::accumulate(ssvar.begin(), ssvar.end(), 0.0);
+
+    // A component on a subset of the processes reduces over its own
+    // communicator; the sums are broadcast in finish_coefficients()
+    //
+    MPI_Comm comm = component->subset() ? component->comm : MPI_COMM_WORLD;
+
+    if (component->subset() and not component->member())
+      coef_req = MPI_REQUEST_NULL;
+    else if (coefFloat) {
+      freduce.pack(mlevel, coefbuf0.data(), nbuf);
+      freduce.post(comm, &coef_req);
     }
+    else if (NodeSharedComm::hierarchical and comm==MPI_COMM_WORLD) {
+      coef_req  = MPI_REQUEST_NULL;
+      coef_hier = true;		// Reduced in finish_coefficients()
+    }
+    else
+      MPI_Iallreduce(coefbuf0.data(), coefbuf1.data(), nbuf,
+		     MPI_DOUBLE, MPI_SUM, comm, &coef_req);
+    coef_pending = true;
+  }
+
+#if HAVE_LIBCUDA==1
+  if (component->timers) {
+    auto finish0 = std::chrono::high_resolution_clock::now();
+  
+    std::chrono::duration<double> duration0 = finish0 - start0;
+    std::chrono::duration<double> duration1 = finish1 - start1;
+
+    std::cout << std::string(60, '=') << std::endl;
+    std::cout << "== Coefficient evaluation [SphericalBasis] level="
+	      << mlevel << std::endl;
+    std::cout << std::string(60, '=') << std::endl;
+    std::cout << "Time in CPU: " << duration0.count()-duration1.count() << std::endl;
+    if (component->cudaDevice>=0 and use_cuda) {
+      std::cout << "Time in GPU: " << duration1.count() << std::endl;
+    }
+    std::cout << std::string(60, '=') << std::endl;
+  }
+#endif
+
+  if (not defer_coefs) finish_coefficients();
+}
+
+void SphericalBasis::finish_coefficients()
+{
+  if (not coef_pending) return;
+
+  MPI_Wait(&coef_req, MPI_STATUS_IGNORE);
+  coef_pending = false;
+
+  // The node-aware reduction is blocking and so is deferred to here
+  //
+  if (coef_hier) {
+    NodeSharedComm::allreduce(coefbuf0.data(), coefbuf1.data(),
+			      coefbuf0.size(), MPI_DOUBLE, MPI_SUM);
+    coef_hier = false;
+  }
+
+  bool bcast = component->subset();
+  bool adapt = sstarget>0.0;
+  bool fltr  = coefFloat;
+
+#if HAVE_LIBCUDA==1
+  dev_current = false;
+  if (dev_pending) {
+    DtoH_reduced(coefbuf1);
+    bcast = false;		// Reduced over all processes on the device
+    adapt = false;		// No sum of squares from the device
+    fltr  = false;
+  }
+#endif
+
+  if (fltr) freduce.unpack(coefbuf1.data());
+
+  // The other processes (and the other components' particles on
+  // them) get the coefficients from the subset root
+  //
+  if (bcast) {
+    coefbuf1.resize((Lmax+1)*(Lmax+1)*nmax + (adapt ? 1 : 0));
+    MPI_Bcast(coefbuf1.data(), coefbuf1.size(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  }
+
+  if (adapt) ssupdate(coefbuf1);
+
+  if (predict>0 and multistep and mlevel<multistep) predict_record(coefbuf1);
+
+  for (int L=0; L<(Lmax+1)*(Lmax+1); L++) {
+    Eigen::Map<Eigen::VectorXd> v(&coefbuf1[L*nmax], nmax);
+    if (multistep) *expcoefN[mlevel][L] = v;
+    else           *expcoef[L]          = v;
   }
   
   //======================================
@@ -893,25 +1274,6 @@ void SphericalBasis::determine_coefficients_particles(void)
 
   print_timings("SphericalBasis: coefficient timings");
 
-#if HAVE_LIBCUDA==1
-  if (component->timers) {
-    auto finish0 = std::chrono::high_resolution_clock::now();
-  
-    std::chrono::duration<double> duration0 = finish0 - start0;
-    std::chrono::duration<double> duration1 = finish1 - start1;
-
-    std::cout << std::string(60, '=') << std::endl;
-    std::cout << "== Coefficient evaluation [SphericalBasis] level="
-	      << mlevel << std::endl;
-    std::cout << std::string(60, '=') << std::endl;
-    std::cout << "Time in CPU: " << duration0.count()-duration1.count() << std::endl;
-    if (component->cudaDevice>=0 and use_cuda) {
-      std::cout << "Time in GPU: " << duration1.count() << std::endl;
-    }
-    std::cout << std::string(60, '=') << std::endl;
-  }
-#endif
-
   //================================
   // Dump coefficients for debugging
   //================================
@@ -962,6 +1324,94 @@ void SphericalBasis::determine_coefficients_particles(void)
   firstime_coef = false;
 }
 
+#if HAVE_LIBCUDA==1
+bool SphericalBasis::launchesCoefficients()
+{
+  return use_cuda and component->cudaDevice>=0 and not cudaAccumOverride
+    and not initialize_cuda_sph and not (pcavar or pcaeof)
+    and not play_back and (self_consistent or initializing);
+}
+#endif
+
+void SphericalBasis::zero_thread_pca()
+{
+  int nC = (Lmax+1)*(Lmax+2)/2;
+
+  if (pcavar) {
+    massT0   .resize(nthrds);
+    expcoefT0.resize(nthrds);
+    expcoefM0.resize(nthrds);
+
+    for (int id=0; id<nthrds; id++) {
+      massT0[id].assign(sampT, 0.0);
+
+      expcoefT0[id].resize(sampT);
+      expcoefM0[id].resize(sampT);
+      for (unsigned T=0; T<sampT; T++) {
+	expcoefT0[id][T].resize(nC);
+	expcoefM0[id][T].resize(nC);
+	for (auto & v : expcoefT0[id][T]) v.setZero(nmax);
+	for (auto & v : expcoefM0[id][T]) v.setZero(nmax, nmax);
+      }
+    }
+  }
+
+  if (pcaeof) {
+    tvar0.resize(nthrds);
+    for (auto & t : tvar0) {
+      t.resize(tvar.size());
+      for (auto & v : t) v.setZero(nmax, nmax);
+    }
+
+    pcabuf.resize(nthrds);
+    for (auto & t : pcabuf) {
+      t.resize(tvar.size());
+      for (auto & v : t) v.resize(nmax);
+    }
+  }
+
+  // Per-thread subsample coefficients and covariance
+  //
+  size_t bytes = 0;
+  if (pcavar) bytes += nthrds*sampT*nC*(nmax + nmax*nmax)*sizeof(double);
+  if (pcaeof) bytes += (nthrds + 1)*tvar.size()*nmax*nmax*sizeof(double);
+  memtrack.set("pca", component->name, bytes);
+}
+
+void SphericalBasis::reduce_pair(int i, int j)
+{
+  for (int l=0; l<(Lmax+1)*(Lmax+1); l++) (*expcoef0[i][l]) += (*expcoef0[j][l]);
+
+  if (not compute) return;
+
+  if (pcavar) {
+    for (unsigned T=0; T<sampT; T++) {
+      massT0[i][T] += massT0[j][T];
+      for (size_t iC=0; iC<expcoefT0[i][T].size(); iC++) {
+	expcoefT0[i][T][iC] += expcoefT0[j][T][iC];
+	expcoefM0[i][T][iC] += expcoefM0[j][T][iC];
+      }
+    }
+  }
+
+  if (pcaeof) {
+    for (size_t iC=0; iC<tvar0[i].size(); iC++) tvar0[i][iC] += tvar0[j][iC];
+  }
+}
+
+void SphericalBasis::reduce_threads()
+{
+  // At each stage, thread i absorbs thread i+stride for every i that
+  // is a multiple of 2*stride.  The pairs in a stage are independent
+  // and are summed in parallel.
+  //
+  for (int stride=1; stride<nthrds; stride*=2) {
+    int npair = (nthrds - stride + 2*stride - 1)/(2*stride);
+    ThreadPool::instance().run(npair, [this, stride](int k)
+    { reduce_pair(2*stride*k, 2*stride*k + stride); });
+  }
+}
+
 void SphericalBasis::multistep_reset()
 {
   if (play_back and not play_cnew) return;
@@ -1021,8 +1471,8 @@ void SphericalBasis::multistep_update_finish()
     }
   }
 
-  MPI_Allreduce (pack.data(), unpack.data(), sz, 
-		 MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  NodeSharedComm::allreduce(pack.data(), unpack.data(), sz,
+			    MPI_DOUBLE, MPI_SUM);
   
   // Update the local coefficients
   //
@@ -1114,6 +1564,106 @@ void SphericalBasis::multistep_update_finish()
 #endif
 }
 
+void SphericalBasis::ssupdate(const std::vector<double>& buf)
+{
+  int ncoef = (Lmax+1)*(Lmax+1)*nmax;
+
+  // The sampled contributions carry the weight 1/f, so the sum of
+  // their squares over the whole level is about f*S.  Sampling a
+  // fraction f of N contributions w_i with weight 1/f gives a
+  // variance of (1/f - 1)*sum(w_i^2) for each coefficient sum, and
+  // requiring that to be sstarget^2 times the mean square gives the
+  // new fraction.
+  //
+  double f = ssfracL[mlevel];
+  double S = buf[ncoef]*f;
+  double A = 0.0;
+  for (int j=0; j<ncoef; j++) A += buf[j]*buf[j];
+
+  if (S<=0.0 or A<=0.0) return;	// Empty level
+
+  double fnew = 1.0/(1.0 + sstarget*sstarget*A/S);
+
+  fnew = std::min<double>(fnew, 2.0*f);
+  fnew = std::max<double>(fnew, 0.5*f);
+  fnew = std::min<double>(std::max<double>(fnew, ssmin), 1.0);
+
+  ssfracL[mlevel] = fnew;
+}
+
+Eigen::VectorXd SphericalBasis::predict_extrapolate(unsigned M, double T)
+{
+  auto & H = predHist[M];
+
+  // Lagrange form of the interpolating polynomial
+  //
+  Eigen::VectorXd ret = Eigen::VectorXd::Zero(H.front().second.size());
+
+  for (size_t j=0; j<H.size(); j++) {
+    double w = 1.0;
+    for (size_t k=0; k<H.size(); k++) {
+      if (k != j) w *= (T - H[k].first)/(H[j].first - H[k].first);
+    }
+    ret += w*H[j].second;
+  }
+
+  return ret;
+}
+
+bool SphericalBasis::predict_coefficients()
+{
+  if (predict<=0 or multistep==0 or mlevel>=multistep or compute)
+    return false;
+
+#if HAVE_LIBCUDA==1
+  if (component->cudaDevice>=0 and use_cuda) return false;
+#endif
+
+  if (predHist[mlevel].size() < static_cast<size_t>(predict+1) or
+      predErr[mlevel] > predictTol or predSkips[mlevel] >= predictSkip)
+    return false;
+
+  auto c = predict_extrapolate(mlevel, tnow);
+
+  // Swap interpolation arrays as in a full pass
+  //
+  auto p = expcoefL[mlevel];
+  expcoefL[mlevel] = expcoefN[mlevel];
+  expcoefN[mlevel] = p;
+
+  for (int L=0; L<(Lmax+1)*(Lmax+1); L++)
+    *expcoefN[mlevel][L] = c.segment(L*nmax, nmax);
+
+  predSkips[mlevel]++;
+
+  return true;
+}
+
+void SphericalBasis::predict_record(const std::vector<double>& buf)
+{
+  int ncoef = (Lmax+1)*(Lmax+1)*nmax;
+  Eigen::Map<const Eigen::VectorXd> c(buf.data(), ncoef);
+
+  auto & H = predHist[mlevel];
+
+  // A repeated pass at the same time (e.g. at initialization)
+  // replaces the last entry
+  //
+  if (H.size() and H.back().first == tnow) H.pop_back();
+
+  // Corrector: error of the prediction for this pass
+  //
+  if (H.size() == static_cast<size_t>(predict+1)) {
+    double norm = c.norm();
+    if (norm>0.0)
+      predErr[mlevel] = (predict_extrapolate(mlevel, tnow) - c).norm()/norm;
+    H.pop_front();
+  }
+
+  H.push_back({tnow, c});
+  predSkips[mlevel] = 0;
+}
+
 void SphericalBasis::multistep_update(int from, int to, Component *c, int i, int id)
 {
   if (play_back and not play_cnew) return;
@@ -1124,8 +1674,10 @@ void SphericalBasis::multistep_update(int from, int to, Component *c, int i, int
 #ifdef SPH_UPDATE_TABLE
   occt[from][to]++;
 #endif
-				// Adjust mass for subset
-  if (subset) mass /= ssfrac;
+				// Adjust mass for subset: the
+				// contribution leaves the sum of
+				// one level and joins that of another
+  double wfrom = 1.0/ssfraction(from), wto = 1.0/ssfraction(to);
 
   double xx = c->Pos(i, 0, Component::Local | Component::Centered);
   double yy = c->Pos(i, 1, Component::Local | Component::Centered);
@@ -1162,8 +1714,8 @@ void SphericalBasis::multistep_update(int from, int to, Component *c, int i, int
 	  for (int n=0; n<nmax; n++) {
 	    double val = potd[id](l, n)*facL*mass*fac0/sqnorm(l, n);
 	    
-	    differ1[id][from](loffset+moffset, n) -= val;
-	    differ1[id][  to](loffset+moffset, n) += val;
+	    differ1[id][from](loffset+moffset, n) -= val*wfrom;
+	    differ1[id][  to](loffset+moffset, n) += val*wto;
 	  }
 	  moffset++;
 
@@ -1175,17 +1727,119 @@ void SphericalBasis::multistep_update(int from, int to, Component *c, int i, int
 	    double val1 = potd[id](l, n)*fac1*mass*fac0/sqnorm(l, n);
 	    double val2 = potd[id](l, n)*fac2*mass*fac0/sqnorm(l, n);
 
-	    differ1[id][from](loffset+moffset  , n) -= val1;
-	    differ1[id][from](loffset+moffset+1, n) -= val2;
-	    differ1[id][  to](loffset+moffset  , n) += val1;
-	    differ1[id][  to](loffset+moffset+1, n) += val2;
+	    differ1[id][from](loffset+moffset  , n) -= val1*wfrom;
+	    differ1[id][from](loffset+moffset+1, n) -= val2*wfrom;
+	    differ1[id][  to](loffset+moffset  , n) += val1*wto;
+	    differ1[id][  to](loffset+moffset+1, n) += val2*wto;
+	  }
+	  moffset+=2;
+	}
+      }
+    }
+  }
+  
+}
+
+
+void SphericalBasis::multistep_update_batch(int from, int to, Component *c,
+					    const std::vector<int>& idx, int id)
+{
+  if (play_back and not play_cnew) return;
+
+  const int L = Lmax + 1;
+  const double fac0 = -4.0*M_PI;
+
+  // The batch arrays of the force evaluation are free here
+  //
+  BatchWork & w = batchwork[id];
+  w.resize(nbatch);
+
+  // Every particle of the batch leaves level <from> and joins level
+  // <to>, so the contributions are summed once and applied to both
+  //
+  Eigen::MatrixXd S = Eigen::MatrixXd::Zero(L*L, nmax);
+  Eigen::MatrixXd Y;
+
+  for (size_t k=0; k<idx.size(); ) {
+
+    // Gather the next block
+    //
+    int nb = 0;
+
+    for (; k<idx.size() and nb<nbatch; k++) {
+      int i = idx[k];
+      if (c->freeze(i)) continue;
+
+      double xx = c->Pos(i, 0, Component::Local | Component::Centered);
+      double yy = c->Pos(i, 1, Component::Local | Component::Centered);
+      double zz = c->Pos(i, 2, Component::Local | Component::Centered);
+
+      double r = sqrt(xx*xx + yy*yy + zz*zz) + DSMALL;
+      if (r>=rmax) continue;
+
+      w.mfac [nb] = c->Mass(i) * component->Adiabatic() * fac0;
+      w.costh[nb] = zz/r;
+      w.phi  [nb] = atan2(yy, xx);
+      w.rs   [nb] = r/scale;
+      nb++;
+    }
+
+    if (nb==0) continue;
+
+#ifdef SPH_UPDATE_TABLE
+    occt[from][to] += nb;
+#endif
+
+    legendre_R  (Lmax, nb, w.costh.data(), w.legs);
+    sinecosine_R(Lmax, nb, w.phi.data(),   w.cosm, w.sinm);
+
+    // Radial functions with the mass and normalization, one row per
+    // particle
+    //
+    w.potd.resize(nb, L*nmax);
+    for (int b=0; b<nb; b++) {
+      get_potl(Lmax, nmax, w.rs[b], potd[id], id);
+      for (int l=0; l<=Lmax; l++)
+	for (int n=0; n<nmax; n++)
+	  w.potd(b, l*nmax+n) = potd[id](l, n)*w.mfac[b]/sqnorm(l, n);
+    }
+
+    // Angular factors in the coefficient row order
+    //
+    Y.resize(nb, L*L);
+    for (int l=0, loffset=0; l<=Lmax; loffset+=(2*l+1), l++) {
+      for (int m=0, moffset=0; m<=l; m++) {
+	double fac = factorial(l, m);
+	const double* p = &w.legs(0, l*L + m);
+	double* y1 = &Y(0, loffset+moffset);
+	if (m==0) {
+	  for (int b=0; b<nb; b++) y1[b] = fac*p[b];
+	  moffset++;
+	} else {
+	  double* y2 = &Y(0, loffset+moffset+1);
+	  const double* cm = &w.cosm(0, m);
+	  const double* sm = &w.sinm(0, m);
+	  for (int b=0; b<nb; b++) {
+	    y1[b] = fac*p[b]*cm[b];
+	    y2[b] = fac*p[b]*sm[b];
 	  }
-	  moffset+=2;
+	  moffset += 2;
 	}
       }
     }
-  }
-  
+
+    // Sum over the block for each l as one matrix product
+    //
+    for (int l=0, loffset=0; l<=Lmax; loffset+=(2*l+1), l++)
+      S.middleRows(loffset, 2*l+1).noalias() +=
+	Y.block(0, loffset, nb, 2*l+1).transpose() *
+	w.potd.block(0, l*nmax, nb, nmax);
+  }
+				// Adjust mass for subset: the
+				// contribution leaves the sum of
+				// one level and joins that of another
+  differ1[id][from] -= S/ssfraction(from);
+  differ1[id][  to] += S/ssfraction(to);
 }
 
 
@@ -1434,37 +2088,209 @@ void SphericalBasis::compute_multistep_coefficients()
 #endif
 }
 
-void * SphericalBasis::determine_acceleration_and_potential_thread(void * arg)
+void SphericalBasis::get_dpotl_batch(int lmax, int nmax, int nb,
+				     const double* r,
+				     Eigen::MatrixXd& p, Eigen::MatrixXd& dp,
+				     int tid)
+{
+  p .resize(nb, (lmax+1)*nmax);
+  dp.resize(nb, (lmax+1)*nmax);
+
+  for (int b=0; b<nb; b++) {
+    get_dpotl(lmax, nmax, r[b], potd[tid], dpot[tid], tid);
+    for (int l=0; l<=lmax; l++) {
+      for (int n=0; n<nmax; n++) {
+	p (b, l*nmax+n) = potd[tid](l, n);
+	dp(b, l*nmax+n) = dpot[tid](l, n);
+      }
+    }
+  }
+}
+
+void SphericalBasis::gather(BatchWork& w, int b, int indx,
+			    double xx, double yy, double zz, double mfactor)
 {
-  // Density basis is 4piG times physical density
+  double r = sqrt(xx*xx + yy*yy + zz*zz) + DSMALL;
+
+  w.indx [b] = indx;
+  w.x    [b] = xx;
+  w.y    [b] = yy;
+  w.z    [b] = zz;
+  w.mfac [b] = mfactor;
+  w.costh[b] = zz/r;
+  w.phi  [b] = atan2(yy, xx);
+
+  // Outside the expansion radius, use the external multipole
+  // solution with the field evaluated at rmax
   //
-  double dfac=0.25/M_PI;
+  if (r>rmax) {
+    w.ext[b] = 1.0;
+    w.r0 [b] = r;
+    w.rat[b] = rmax/r;
+    r = rmax;
+  } else {
+    w.ext[b] = 0.0;
+    w.r0 [b] = r;
+    w.rat[b] = 1.0;
+  }
+  w.r [b] = r;
+  w.rs[b] = r/scale;
+}
+
+void SphericalBasis::gather_shared(BatchWork& w, const BatchWork& from, int nb)
+{
+  for (int b=0; b<nb; b++) {
+    w.indx [b] = from.indx [b];
+    w.x    [b] = from.x    [b];
+    w.y    [b] = from.y    [b];
+    w.z    [b] = from.z    [b];
+    w.mfac [b] = from.mfac [b];
+    w.costh[b] = from.costh[b];
+    w.phi  [b] = from.phi  [b];
+
+    // The unclamped radius is common; the expansion radius and scale
+    // are not
+    //
+    double r = from.r0[b];
+    w.r0[b] = r;
+    if (r>rmax) {
+      w.ext[b] = 1.0;
+      w.rat[b] = rmax/r;
+      r = rmax;
+    } else {
+      w.ext[b] = 0.0;
+      w.rat[b] = 1.0;
+    }
+    w.r [b] = r;
+    w.rs[b] = r/scale;
+  }
+}
+
+void SphericalBasis::external_forces(const std::vector<SphericalBasis*>& src,
+				     Component* C)
+{
+  if (src.empty()) return;
+
+  for (auto s : src) {
+    s->SetExternal();
+    s->begin_partner(C);
+  }
+
+  // Group the sources by their center offset: the Local|Centered
+  // conversion of each source component
+  //
+  std::vector<std::vector<double>> offset;
+  std::vector<int> group(src.size());
 
-  // Local variables
+  for (size_t k=0; k<src.size(); k++) {
+    auto ctr = src[k]->component->getCenter(Component::Local | Component::Centered);
+    auto it  = std::find(offset.begin(), offset.end(), ctr);
+    group[k] = it - offset.begin();
+    if (it == offset.end()) offset.push_back(ctr);
+  }
+
+  const int ngroup = offset.size();
+
+  // Block size that fits every source's work arrays
+  //
+  int nblock = src[0]->nbatch;
+  for (auto s : src) nblock = std::min<int>(nblock, s->nbatch);
+
+  // The active particles of the target
   //
-  double r0=0.0, dp;
-  double potr, potl, pott, potp, p, pc, dpc, ps, dps, facp, facdp;
+  auto active = C->levlist.range(src[0]->mlevel, multistep);
+  const int N = active.size();
+
+  ThreadPool::instance().run(nthrds, [&](int id)
+  {
+    for (auto s : src) s->batchwork[id].resize(s->nbatch);
+
+    std::vector<int> indx(nblock);
+    std::vector<double> pos(3*nblock);
+    std::vector<int> first(ngroup);
+
+    int nbeg = N*id/nthrds, nend = N*(id+1)/nthrds;
+
+    for (int i=nbeg; i<nend; ) {
+
+      // Read the next block of particles once
+      //
+      int nb = 0;
+      for (; i<nend and nb<nblock; i++) {
+	int n = active[i];
+	if (C->freeze(n)) continue;
+	C->Pos(&pos[3*nb], n, Component::Inertial);
+	indx[nb++] = n;
+      }
+
+      if (nb==0) continue;
+
+      // The first source of each group computes the geometry and the
+      // others copy it
+      //
+      std::fill(first.begin(), first.end(), -1);
+
+      for (size_t k=0; k<src.size(); k++) {
+	auto s = src[k];
+	auto & w = s->batchwork[id];
+	int g = group[k];
+
+	if (first[g]<0) {
+	  const auto & o = offset[g];
+	  for (int b=0; b<nb; b++)
+	    s->gather(w, b, indx[b],
+		      pos[3*b+0] - o[0], pos[3*b+1] - o[1], pos[3*b+2] - o[2],
+		      1.0);
+	  first[g] = k;
+	} else
+	  s->gather_shared(w, src[first[g]]->batchwork[id], nb);
 
+	s->force_block(w, nb, id);
+      }
+    }
+  });
+
+  for (auto s : src) {
+    s->end_partner();
+    s->ClearExternal();
+  }
+}
+
+void * SphericalBasis::determine_acceleration_and_potential_thread(void * arg)
+{
   double pos[3];
-  double xx, yy, zz, mfactor=1.0;
 
-  vector<double> ctr;
+  vector<double> ctr, pctr;
   if (mix) mix->getCenter(ctr);
+  if (partner) partner->mix->getCenter(pctr);
 
   int id = *((int*)arg);
 
-  thread_timing_beg(id);
+  // The particles are evaluated in blocks of up to <nbatch>.  The
+  // per-block arrays have the block index fastest so that the table
+  // lookups, recursions and coefficient sums vectorize over the block.
+  //
+  BatchWork & w = batchwork[id];
+  w.resize(nbatch);
 
-  // If we are multistepping, compute accel only at or above <mlevel>
+  // In the fused two-center mode, the partner block holds the same
+  // particles relative to the partner center
   //
-  for (int lev=mlevel; lev<=multistep; lev++) {
+  BatchWork * v = 0;
+  if (partner) {
+    v = &partner->batchwork[id];
+    v->resize(nbatch);
+  }
 
-    unsigned nbodies = cC->levlist[lev].size();
+  thread_timing_beg(id);
 
-    if (nbodies==0) continue;
+  // If we are multistepping, compute accel only at or above <mlevel>.
+  // The scheduler hands out ranges from these levels.
+  //
+  unsigned lev;
+  int nbeg, nend;
 
-    int nbeg = nbodies*(id  )/nthrds;
-    int nend = nbodies*(id+1)/nthrds;
+  while (sched.next(id, lev, nbeg, nend)) {
 
 #ifdef DEBUG
     pthread_mutex_lock(&io_lock);
@@ -1475,164 +2301,349 @@ void * SphericalBasis::determine_acceleration_and_potential_thread(void * arg)
     pthread_mutex_unlock(&io_lock);
 #endif
 
-    for (int i=nbeg; i<nend; i++) {
+    for (int i=nbeg; i<nend; ) {
+
+      // Gather the next block
+      //
+      int nb = 0;
 
-      int indx = cC->levlist[lev][i];
+      for (; i<nend and nb<nbatch; i++) {
 
-      if (cC->freeze(indx)) continue;
+	int indx = cC->levlist[lev][i];
 
-      if (mix) {
-	if (use_external) {
-	  cC->Pos(pos, indx, Component::Inertial);
-	  component->ConvertPos(pos, Component::Local);
-	} else
-	  cC->Pos(pos, indx, Component::Local);
+	if (cC->freeze(indx)) continue;
 
-	mfactor = mix->Mixture(pos);
-	xx = pos[0] - ctr[0];
-	yy = pos[1] - ctr[1];
-	zz = pos[2] - ctr[2];
-      } else {
-	if (use_external) {
-	  cC->Pos(pos, indx, Component::Inertial);
-	  component->ConvertPos(pos, Component::Local | Component::Centered);
-	} else
-	  cC->Pos(pos, indx, Component::Local | Component::Centered);
+	if (mix) {
+	  if (use_external) {
+	    cC->Pos(pos, indx, Component::Inertial);
+	    component->ConvertPos(pos, Component::Local);
+	  } else
+	    cC->Pos(pos, indx, Component::Local);
+
+	  // The mixture function is evaluated once per particle; the
+	  // partner weight is its complement
+	  //
+	  double mfactor = mix->Mixture(pos);
+
+	  gather(w, nb, indx, pos[0] - ctr[0], pos[1] - ctr[1], pos[2] - ctr[2],
+		 mfactor);
+
+	  if (partner)
+	    partner->gather(*v, nb, indx,
+			    pos[0] - pctr[0], pos[1] - pctr[1], pos[2] - pctr[2],
+			    1.0 - mfactor);
+	} else {
+	  if (use_external) {
+	    cC->Pos(pos, indx, Component::Inertial);
+	    component->ConvertPos(pos, Component::Local | Component::Centered);
+	  } else
+	    cC->Pos(pos, indx, Component::Local | Component::Centered);
 	
-	xx = pos[0];
-	yy = pos[1];
-	zz = pos[2];
-      }	
+	  gather(w, nb, indx, pos[0], pos[1], pos[2], 1.0);
+	}	
 
-      double r = sqrt(xx*xx + yy*yy + zz*zz) + DSMALL;
-      double costh = zz/r;
-      double rs = r/scale;
-      double phi = atan2(yy, xx);
-
-      dlegendre_R (Lmax, costh, legs[id], dlegs[id]);
-      sinecosine_R(Lmax, phi,   cosm[id], sinm [id]);
-
-      int ioff = 0;
-      if (r>rmax) {
-	ioff = 1;
-	r0   = r;
-	r    = rmax;
-	rs   = r/scale;
+	w.slot[nb] = i;
+	nb++;
       }
 
-      // Zero coefficient accumulated field values
-      //
-      potl = potr = pott = potp = 0.0;
-      
-      get_dpotl(Lmax, nmax, rs, potd[id], dpot[id], id);
+      if (nb==0) continue;
 
-      if (!NO_L0) {
-	get_pot_coefs_safe(0, *expcoef[0], p, dp, potd[id], dpot[id]);
-	if (ioff) {
-	  p *= rmax/r0;
-	  dp = -p/r0;
-	}
-	double facL = mfactor * factorial(0, 0);
-	potl = facL * p;
-	potr = facL * dp;
+      force_block(w, nb, id, cached_factors(w, nb, lev));
+      if (partner) partner->force_block(*v, nb, id);
+    }
+
+  }
+
+  thread_timing_end(id);
+
+  return (NULL);
+}
+
+void SphericalBasis::force_block(BatchWork& w, int nb, int id, bool cached)
+{
+  const int L = Lmax + 1;
+
+  if (not cached) {
+    dlegendre_R (Lmax, nb, w.costh.data(), w.legs, w.dlegs);
+    sinecosine_R(Lmax, nb, w.phi.data(),   w.cosm, w.sinm );
+
+    get_dpotl_batch(Lmax, nmax, nb, w.rs.data(), w.potd, w.dpot, id);
+  }
+
+  double *potl = w.potl.data(), *potr = w.potr.data();
+  double *pott = w.pott.data(), *potp = w.potp.data();
+  double *p    = w.p   .data(), *dp   = w.dp  .data();
+  double *pc   = w.pc  .data(), *dpc  = w.dpc .data();
+  double *ps   = w.ps  .data(), *dps  = w.dps .data();
+  double *ext  = w.ext .data(), *rat  = w.rat .data();
+  double *r0   = w.r0  .data(), *fpow = w.fpow.data();
+  double *mfac = w.mfac.data();
+
+  // Sum of the significant coefficients k over radial order for
+  // harmonic l
+  //
+  auto coefsum = [&](int l, int k, double* q, double* dq)
+  {
+    const Eigen::VectorXd& coef = *expcoef[k];
+    for (int b=0; b<nb; b++) q[b] = dq[b] = 0.0;
+    for (int n : nzcoef[k]) {
+      const double c = coef[n];
+      const double* pd = &w.potd(0, l*nmax+n);
+      const double* dd = &w.dpot(0, l*nmax+n);
+#pragma omp simd
+      for (int b=0; b<nb; b++) {
+	q [b] += pd[b]*c;
+	dq[b] += dd[b]*c;
       }
-      
-      //		l loop
-      //		------
-      for (int l=1, loffset=1; l<=Lmax; loffset+=(2*l+1), l++) {
+    }
+  };
+
+  // Zero coefficient accumulated field values
+  //
+  for (int b=0; b<nb; b++) {
+    potl[b] = potr[b] = pott[b] = potp[b] = 0.0;
+    fpow[b] = rat[b];
+  }
+
+  if (!NO_L0 and nzcoef[0].size()) {
+    coefsum(0, 0, p, dp);
+    const double facL0 = factorial(0, 0);
+#pragma omp simd
+    for (int b=0; b<nb; b++) {
+      if (ext[b]>0.0) {
+	p [b] *= fpow[b];
+	dp[b]  = -p[b]/r0[b];
+      }
+      double facL = mfac[b] * facL0;
+      potl[b] = facL * p [b];
+      potr[b] = facL * dp[b];
+    }
+  }
+
+  //		l loop
+  //		------
+  for (int l=1, loffset=1; l<=Lmax; loffset+=(2*l+1), l++) {
+
+				// (rmax/r0)^(l+1) for the external
+				// solution
+    for (int b=0; b<nb; b++) fpow[b] *= rat[b];
 
 				// Suppress L=1 terms?
-	if (NO_L1 && l==1) continue;
-	
+    if (NO_L1 && l==1) continue;
+
 				// Suppress odd L terms?
-	if (EVEN_L && (l/2)*2 != l) continue;
+    if (EVEN_L && (l/2)*2 != l) continue;
 
-	//		m loop
-	//		------
-	for (int m=0, moffset=0; m<=l; m++) {
-	  
-	  double facL = factorial(l, m) *  legs[id](l, m) * mfactor;
-	  double facD = factorial(l, m) * dlegs[id](l, m) * mfactor;
+    //		m loop
+    //		------
+    for (int m=0, moffset=0; m<=l; m++) {
 
 				// Suppress odd M terms?
-	  if (EVEN_M && (m/2)*2 != m) continue;
+      if (EVEN_M && (m/2)*2 != m) continue;
 
 				// Suppress all asymmetric terms
-	  if (M0_only and m!=0) continue;
+      if (M0_only and m!=0) continue;
 
-	  if (m==0) {
-	    get_pot_coefs_safe(l, *expcoef[loffset+moffset], p, dp,
-			       potd[id], dpot[id]);
-	    if (ioff) {
-	      p *= pow(rmax/r0,(double)(l+1));
-	      dp = -p/r0 * (l+1);
-	    }
-	    potl += facL * p;
-	    potr += facL * dp;
-	    pott += facD * p;
-	    moffset++;
+      const double  fact = factorial(l, m);
+      const double* lg   = &w.legs (0, l*L+m);
+      const double* dlg  = &w.dlegs(0, l*L+m);
+
+      const int k = loffset + moffset;
+
+      if (m==0) {
+	if (nzcoef[k].empty()) {
+	  moffset++;
+	  continue;
+	}
+	coefsum(l, k, p, dp);
+#pragma omp simd
+	for (int b=0; b<nb; b++) {
+	  double facL = fact *  lg[b] * mfac[b];
+	  double facD = fact * dlg[b] * mfac[b];
+	  if (ext[b]>0.0) {
+	    p [b] *= fpow[b];
+	    dp[b]  = -p[b]/r0[b] * (l+1);
 	  }
-	  else {
-	    get_pot_coefs_safe(l, *expcoef[loffset+moffset], pc, dpc,
-			       potd[id], dpot[id]);
-
-	    get_pot_coefs_safe(l, *expcoef[loffset+moffset+1], ps, dps,
-			       potd[id], dpot[id]);
-	    if (ioff) {		// Factors for external multipole solution
-	      facp  = pow(rmax/r0,(double)(l+1));
-	      facdp = -1.0/r0 * (l+1);
+	  potl[b] += facL * p [b];
+	  potr[b] += facL * dp[b];
+	  pott[b] += facD * p [b];
+	}
+	moffset++;
+      }
+      else {
+	if (nzcoef[k].empty() and nzcoef[k+1].empty()) {
+	  moffset += 2;
+	  continue;
+	}
+	coefsum(l, k,   pc, dpc);
+	coefsum(l, k+1, ps, dps);
+
+	const double* cm = &w.cosm(0, m);
+	const double* sm = &w.sinm(0, m);
+#pragma omp simd
+	for (int b=0; b<nb; b++) {
+	  double facL = fact *  lg[b] * mfac[b];
+	  double facD = fact * dlg[b] * mfac[b];
+	  if (ext[b]>0.0) {	// Factors for external multipole solution
+	    double facdp = -1.0/r0[b] * (l+1);
 				// Apply the factors
-	      pc   *= facp;
-	      ps   *= facp;
-	      dpc   = pc * facdp;
-	      dps   = ps * facdp;
-	    }
-	    potl += facL * (pc *cosm[id][m] + ps *sinm[id][m] );
-	    potr += facL * (dpc*cosm[id][m] + dps*sinm[id][m] );
-	    pott += facD * (pc *cosm[id][m] + ps *sinm[id][m] );
-	    potp += facL * (-pc*sinm[id][m] + ps *cosm[id][m] )*m;
-	    moffset +=2;
+	    pc [b] *= fpow[b];
+	    ps [b] *= fpow[b];
+	    dpc[b]  = pc[b] * facdp;
+	    dps[b]  = ps[b] * facdp;
 	  }
+	  potl[b] += facL * (pc [b]*cm[b] + ps [b]*sm[b] );
+	  potr[b] += facL * (dpc[b]*cm[b] + dps[b]*sm[b] );
+	  pott[b] += facD * (pc [b]*cm[b] + ps [b]*sm[b] );
+	  potp[b] += facL * (-pc[b]*sm[b] + ps [b]*cm[b] )*m;
 	}
+	moffset +=2;
       }
+    }
+  }
+
+  // Apply the accelerations and potentials for the block
+  //
+  for (int b=0; b<nb; b++) {
+    int    indx = w.indx[b];
+    double xx   = w.x[b], yy = w.y[b], zz = w.z[b], r = w.r[b];
+    double fac  = xx*xx + yy*yy;
+
+    double pr = potr[b]/(scale*scale);
+    double pl = potl[b]/scale;
+    double pt = pott[b]/scale;
+    double pp = potp[b]/scale;
+
+    cC->AddAcc(indx, 0, -(pr*xx/r - pt*xx*zz/(r*r*r)) );
+    cC->AddAcc(indx, 1, -(pr*yy/r - pt*yy*zz/(r*r*r)) );
+    cC->AddAcc(indx, 2, -(pr*zz/r + pt*fac/(r*r*r))   );
+    if (fac > DSMALL) {
+      cC->AddAcc(indx, 0,  pp*yy/fac );
+      cC->AddAcc(indx, 1, -pp*xx/fac );
+    }
+    cC->AddPot(indx, pl);
+  }
+}
 
-      double fac = xx*xx + yy*yy;
 
-      potr /= scale*scale;
-      potl /= scale;
-      pott /= scale;
-      potp /= scale;
+void SphericalBasis::size_factors()
+{
+  if (factorCache<=0.0) return;
 
-      cC->AddAcc(indx, 0, -(potr*xx/r - pott*xx*zz/(r*r*r)) );
-      cC->AddAcc(indx, 1, -(potr*yy/r - pott*yy*zz/(r*r*r)) );
-      cC->AddAcc(indx, 2, -(potr*zz/r + pott*fac/(r*r*r))   );
-      if (fac > DSMALL) {
-	cC->AddAcc(indx, 0,  potp*yy/fac );
-	cC->AddAcc(indx, 1, -potp*xx/fac );
-      }
-      cC->AddPot(indx, potl);
-    }
+  const int L = Lmax + 1;
+  fcStride = 3 + L*(L+1) + 2*L + 2*L*nmax;
 
+  if (fcslots.size() != multistep+1) {
+    fcache .resize(multistep+1);
+    fcindx .resize(multistep+1);
+    fcslots.assign(multistep+1, 0);
   }
 
-  thread_timing_end(id);
+  // The binned pass does not compute the radial functions per
+  // particle
+  //
+  size_t cap = factorCache*1048576.0/(fcStride*sizeof(double) + sizeof(int));
+  size_t num = binpass ? 0 : std::min<size_t>(component->levlist[mlevel].size(), cap);
 
-  return (NULL);
+  fcslots[mlevel] = num;
+  fcache [mlevel].resize(num*fcStride);
+  fcindx [mlevel].assign(num, -1);
 }
 
+void SphericalBasis::clear_factors()
+{
+  for (auto & v : fcindx) std::fill(v.begin(), v.end(), -1);
+}
 
-void SphericalBasis::determine_acceleration_and_potential(void)
+void SphericalBasis::cache_factors(unsigned lev, int i, int indx,
+				   double xx, double yy, double zz, int id)
 {
-  nvTracerPtr tPtr;
-  if (cuda_prof)
-    tPtr = std::make_shared<nvTracer>("SphericalBasis::determine_acceleration");
+  const int L = Lmax + 1;
+  double *f = &fcache[lev][i*fcStride];
 
-  std::chrono::high_resolution_clock::time_point start0, start1, finish0, finish1;
-  start0 = std::chrono::high_resolution_clock::now();
+  *f++ = xx;
+  *f++ = yy;
+  *f++ = zz;
 
-#ifdef DEBUG
-  cout << "Process " << myid << ": in determine_acceleration_and_potential\n";
-#endif
+  for (int l=0; l<L; l++) {
+    for (int m=0; m<=l; m++) {
+      f[0] = legs [id](l, m);
+      f[1] = dlegs[id](l, m);
+      f += 2;
+    }
+  }
+
+  for (int m=0; m<L; m++) {
+    *f++ = cosm[id][m];
+    *f++ = sinm[id][m];
+  }
+
+  for (int l=0; l<L; l++) {
+    for (int n=0; n<nmax; n++) {
+      f[0] = potd[id](l, n);
+      f[1] = dpot[id](l, n);
+      f += 2;
+    }
+  }
+
+  fcindx[lev][i] = indx;
+}
+
+bool SphericalBasis::cached_factors(BatchWork& w, int nb, unsigned lev)
+{
+  if (lev >= fcslots.size() or cC != component or use_external) return false;
+
+  // Every body of the block must be in the cache at its current
+  // position
+  //
+  for (int b=0; b<nb; b++) {
+    int i = w.slot[b];
+    if (i >= static_cast<int>(fcslots[lev]) or fcindx[lev][i] != w.indx[b])
+      return false;
+    const double *f = &fcache[lev][i*fcStride];
+    if (f[0] != w.x[b] or f[1] != w.y[b] or f[2] != w.z[b]) return false;
+  }
+
+  const int L = Lmax + 1;
+
+  w.legs .resize(nb, L*L);
+  w.dlegs.resize(nb, L*L);
+  w.cosm .resize(nb, L);
+  w.sinm .resize(nb, L);
+  w.potd .resize(nb, L*nmax);
+  w.dpot .resize(nb, L*nmax);
+
+  for (int b=0; b<nb; b++) {
+    const double *f = &fcache[lev][w.slot[b]*fcStride] + 3;
+
+    for (int l=0; l<L; l++) {
+      for (int m=0; m<=l; m++) {
+	w.legs (b, l*L+m) = f[0];
+	w.dlegs(b, l*L+m) = f[1];
+	f += 2;
+      }
+    }
+
+    for (int m=0; m<L; m++) {
+      w.cosm(b, m) = *f++;
+      w.sinm(b, m) = *f++;
+    }
+
+    for (int k=0; k<L*nmax; k++) {
+      w.potd(b, k) = f[0];
+      w.dpot(b, k) = f[1];
+      f += 2;
+    }
+  }
+
+  return true;
+}
+
+void SphericalBasis::prepare_force()
+{
+  // The coefficients must be complete before evaluating the force
+  //
+  finish_coefficients();
 
   if (play_back) {
     swap_coefs(expcoefP, expcoef);
@@ -1646,6 +2657,64 @@ void SphericalBasis::determine_acceleration_and_potential(void)
 
   }
 
+  make_active();
+}
+
+void SphericalBasis::make_active()
+{
+  const int K = (Lmax+1)*(Lmax+1);
+
+  double tol = 0.0;
+  if (sparseTol>0.0) {
+    for (int k=0; k<K; k++)
+      tol = std::max<double>(tol, expcoef[k]->cwiseAbs().maxCoeff());
+    tol *= sparseTol;
+  }
+
+  // NaN values are kept so that they still show in the forces
+  //
+  nzcoef.resize(K);
+  for (int k=0; k<K; k++) {
+    nzcoef[k].clear();
+    for (int n=0; n<nmax; n++)
+      if (not (fabs((*expcoef[k])[n]) <= tol)) nzcoef[k].push_back(n);
+  }
+}
+
+void SphericalBasis::begin_partner(Component* C)
+{
+  cC = C;
+  nbodies = cC->Number();
+
+  if (NOISE) update_noise();
+
+  prepare_force();
+}
+
+void SphericalBasis::end_partner()
+{
+  if (play_back) {
+    swap_coefs(expcoef, expcoefP);
+  }
+
+  use_external = false;
+}
+
+void SphericalBasis::determine_acceleration_and_potential(void)
+{
+  nvTracerPtr tPtr;
+  if (cuda_prof)
+    tPtr = std::make_shared<nvTracer>("SphericalBasis::determine_acceleration");
+
+  std::chrono::high_resolution_clock::time_point start0, start1, finish0, finish1;
+  start0 = std::chrono::high_resolution_clock::now();
+
+#ifdef DEBUG
+  cout << "Process " << myid << ": in determine_acceleration_and_potential\n";
+#endif
+
+  prepare_force();
+
 #if HAVE_LIBCUDA==1
   if (use_cuda and cC->cudaDevice>=0 and cC->force->cudaAware()) {
     if (cudaAccelOverride) {
@@ -1655,9 +2724,10 @@ void SphericalBasis::determine_acceleration_and_potential(void)
     } else {
       start1 = std::chrono::high_resolution_clock::now();
       //
-      // Copy coefficients from this component to device
+      // Copy coefficients from this component to device unless the
+      // device reduction left them there
       //
-      HtoD_coefs(expcoef);
+      if (not dev_current) HtoD_coefs(expcoef);
       //
       // Do the force computation
       //
@@ -1859,7 +2929,7 @@ void SphericalBasis::dump_coefs(ostream& out)
 
 // Dump coefficients to an HDF5 file
 
-void SphericalBasis::dump_coefs_h5(const std::string& file)
+CoefClasses::CoefStrPtr SphericalBasis::current_coefs()
 {
   // Add the current coefficients
   auto cur = std::make_shared<CoefClasses::SphStruct>();
@@ -1895,11 +2965,26 @@ void SphericalBasis::dump_coefs_h5(const std::string& file)
   //
   cur->ctr = component->getCenter(Component::Local | Component::Centered);
 
+  return cur;
+}
+
+void SphericalBasis::dump_coefs_h5(const std::string& file)
+{
+  append_coefs_h5(file, {current_coefs()});
+}
+
+void SphericalBasis::append_coefs_h5(const std::string& file,
+                                     const std::vector<CoefClasses::CoefStrPtr>& snaps)
+{
+  if (snaps.empty()) return;
+
+  sphCoefs.setH5Chunked(h5window, h5deflate, h5swmr);
+
   // Check if file exists
   //
   if (std::filesystem::exists(file)) {
     sphCoefs.clear();
-    sphCoefs.add(cur);
+    for (auto & c : snaps) sphCoefs.add(c);
     sphCoefs.ExtendH5Coefs(file);
   }
   // Otherwise, extend the existing HDF5 file
@@ -1907,14 +2992,14 @@ void SphericalBasis::dump_coefs_h5(const std::string& file)
   else {
     // Copy the YAML config.  We only need this on the first call.
     std::ostringstream sout; sout << conf;
-    cur->buf = sout.str();	// Copy to CoefStruct buffer
+    snaps.front()->buf = sout.str(); // Copy to CoefStruct buffer
 
     // Add the name attribute.  We only need this on the first call.
     sphCoefs.setName(component->name);
 
     // And the new coefficients and write the new HDF5
     sphCoefs.clear();
-    sphCoefs.add(cur);
+    for (auto & c : snaps) sphCoefs.add(c);
     sphCoefs.WriteH5Coefs(file);
   }
 }
@@ -1927,7 +3012,7 @@ void SphericalBasis::determine_fields_at_point
  double *tpotX,  double *tpotY, double *tpotZ)
 {
   double R2 = x*x + y*y;
-  double R  = sqrt(R) + DSMALL;
+  double R  = sqrt(R2) + DSMALL;
   double r  = sqrt(R2 + z*z) + DSMALL;
   double r2 = R2 + z*z + DSMALL;
   double r3 = r2*r;
@@ -1979,29 +3064,70 @@ void SphericalBasis::determine_fields_at_point_sph
  double *tdens, double *tpotl, 
  double *tpotr, double *tpott, double *tpotp)
 {
-  double dp, potr, potl, pott, potp, p, pc, dpc, ps, dps, dens;
+  double f[7];
+  fields_sph(0, r, theta, phi, f);
+
+  *tdens0 = f[0];
+  *tpotl0 = f[1];
+  *tdens  = f[2];
+  *tpotl  = f[3];
+  *tpotr  = f[4];
+  *tpott  = f[5];
+  *tpotp  = f[6];
+}
+
+void SphericalBasis::fields_sph(int tid, double r, double theta, double phi,
+				double* f)
+{
+  double dens, potl, potr, pott, potp;
   double dfac=0.25/M_PI;
 
+  auto & w = fieldwork[tid];
+
+  // Recompute the tables only for a new radius or new angles
+  //
   double rs = r/scale;
-  double costh = cos(theta);
+  if (rs != w.rs) {
+    get_dens(Lmax, nmax, rs, w.dend, tid);
+    get_dpotl(Lmax, nmax, rs, w.potd, w.dpot, tid);
+    w.rs = rs;
+  }
+
+  if (theta != w.theta) {
+    dlegendre_R(Lmax, cos(theta), w.legs, w.dlegs);
+    w.theta = theta;
+  }
+
+  if (phi != w.phi) {
+    sinecosine_R(Lmax, phi, w.cosm, w.sinm);
+    w.phi = phi;
+  }
 
-  dlegendre_R(Lmax, costh, legs[0], dlegs[0]);
-  sinecosine_R(Lmax, phi, cosm[0], sinm[0]);
+  // Radial sums for one coefficient vector
+  //
+  auto rsum = [&](int l, const Eigen::VectorXd& coef,
+		  double& d, double& p, double& dp)
+  {
+    d = p = dp = 0.0;
+    for (int i=0; i<nmax; i++) {
+      d  += w.dend(l, i) * coef[i];
+      p  += w.potd(l, i) * coef[i];
+      dp += w.dpot(l, i) * coef[i];
+    }
+  };
 
-  double facL = factorial(0, 0) * legs[0](0, 0);
+  double d, p, dp, dc, pc, dpc, ds, ps, dps;
 
-  get_dens(Lmax, nmax, rs, dend, 0);
-  get_dpotl(Lmax, nmax, rs, potd[0], dpot[0], 0);
-  get_dens_coefs(0, *expcoef[0], dens);
-  dens *= dfac * facL;
+  double facL = factorial(0, 0) * w.legs(0, 0);
 
-  get_pot_coefs(0, *expcoef[0], p, dp);
+  rsum(0, *expcoef[0], d, p, dp);
+  dens = dfac * facL * d;
   potl = facL * p;
   potr = facL * dp;
   pott = potp = 0.0;
   
-  *tdens0 = dens;
-  *tpotl0 = potl;
+  f[0] = dens;
+  f[1] = potl;
 
   // l loop
   //
@@ -2011,43 +3137,108 @@ void SphericalBasis::determine_fields_at_point_sph
     //
     for (int m=0, moffset=0; m<=l; m++) {
 
-      double facL = factorial(l, m) * legs[0](l, m);
-      double facD = factorial(l, m) * dlegs[0](l, m);
+      double facL = factorial(l, m) * w.legs(l, m);
+      double facD = factorial(l, m) * w.dlegs(l, m);
 
       if (m==0) {
-	get_dens_coefs(l, *expcoef[loffset+moffset], p);
-	dens += dfac*facL*p;
-	get_pot_coefs(l, *expcoef[loffset+moffset], p, dp);
+	rsum(l, *expcoef[loffset+moffset], d, p, dp);
+	dens += dfac*facL*d;
 	potl += facL * p;
 	potr += facL * dp;
 	pott += facD * p;
 	moffset++;
       }
       else {
-	get_dens_coefs(l, *expcoef[loffset+moffset], pc);
-	get_dens_coefs(l, *expcoef[loffset+moffset+1], ps);
-	dens += dfac * facL * (pc*cosm[0][m] + ps*sinm[0][m]);
-	
-	get_pot_coefs(l, *expcoef[loffset+moffset], pc, dpc);
-	get_pot_coefs(l, *expcoef[loffset+moffset+1], ps, dps);
-	potl += facL * (pc*cosm[0][m] + ps*sinm[0][m]);
-	potr += facL * (dpc*cosm[0][m] + dps*sinm[0][m]);
-	pott += facD * (pc*cosm[0][m] + ps*sinm[0][m]);
-	potp += facL * (-pc*sinm[0][m] + ps*cosm[0][m])*m;
+	rsum(l, *expcoef[loffset+moffset],   dc, pc, dpc);
+	rsum(l, *expcoef[loffset+moffset+1], ds, ps, dps);
+
+	double c = w.cosm[m], s = w.sinm[m];
+
+	dens += dfac * facL * (dc*c + ds*s);
+	potl += facL * (pc*c + ps*s);
+	potr += facL * (dpc*c + dps*s);
+	pott += facD * (pc*c + ps*s);
+	potp += facL * (-pc*s + ps*c)*m;
 	moffset +=2;
       }
     }
   }
 
-  *tdens0 /= scale*scale*scale;
-  *tpotl0 /= scale;
+  f[0] /= scale*scale*scale;
+  f[1] /= scale;
 
-  *tdens = dens/(scale*scale*scale);
-  *tpotl = potl/scale;
-  *tpotr = potr/(scale*scale);
-  *tpott = pott/scale;
-  *tpotp = potp/scale;
-  
+  f[2] = dens/(scale*scale*scale);
+  f[3] = potl/scale;
+  f[4] = potr/(scale*scale);
+  f[5] = pott/scale;
+  f[6] = potp/scale;
+}
+
+bool SphericalBasis::evaluate_fields(FieldCoord ctype,
+				     const Eigen::MatrixXd& pts,
+				     Eigen::MatrixXd& fields)
+{
+  const int n = pts.rows();
+  fields.resize(n, 7);
+
+  // Contiguous blocks of points per thread so that neighbouring grid
+  // points share the tables
+  //
+#pragma omp parallel num_threads(nthrds)
+  {
+    int tid = omp_get_thread_num(), nt = omp_get_num_threads();
+    double f[7];
+
+    for (int i=n*tid/nt; i<n*(tid+1)/nt; i++) {
+
+      switch (ctype) {
+
+      case FieldCoord::spherical:
+	fields_sph(tid, pts(i, 0), pts(i, 1), pts(i, 2), f);
+	break;
+
+      case FieldCoord::cylindrical:
+	{
+	  double R = pts(i, 0), z = pts(i, 1);
+	  double r = sqrt(R*R + z*z) + 1.0e-18;
+	  double theta = acos(z/r);
+
+	  fields_sph(tid, r, theta, pts(i, 2), f);
+
+	  double potr = f[4], pott = f[5];
+	  f[4] = potr*sin(theta) - pott*cos(theta)/r;
+	  f[5] = potr*cos(theta) + pott*sin(theta)/r;
+	}
+	break;
+
+      case FieldCoord::cartesian:
+	{
+	  double x = pts(i, 0), y = pts(i, 1), z = pts(i, 2);
+	  double R2 = x*x + y*y;
+	  double R  = sqrt(R2) + DSMALL;
+	  double r  = sqrt(R2 + z*z) + DSMALL;
+	  double r3 = (R2 + z*z + DSMALL)*r;
+
+	  fields_sph(tid, r, acos(z/r), atan2(y, x), f);
+
+	  double potr = f[4], pott = f[5], potp = f[6];
+	  f[4] = potr*x/r - pott*x*z/r3;
+	  f[5] = potr*y/r - pott*y*z/r3;
+	  f[6] = potr*z/r + pott*R2/r3;
+
+	  if (R > DSMALL) {
+	    f[4] +=  potp*y/R;
+	    f[5] += -potp*x/R;
+	  }
+	}
+	break;
+      }
+
+      for (int k=0; k<7; k++) fields(i, k) = f[k];
+    }
+  }
+
+  return true;
 }
 
 
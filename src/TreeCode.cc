@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <limits>
+
+#include "expand.H"
+
+#include <TreeCode.H>
+
+const std::set<std::string>
+TreeCode::valid_keys = {
+  "theta",
+  "ncrit",
+  "soft",
+  "type"
+};
+
+TreeCode::TreeCode(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
+{
+  theta = 0.6;
+  ncrit = 8;
+  soft  = 0.01;
+
+  initialize();
+}
+
+void TreeCode::initialize(void)
+{
+  // Remove matched keys
+  //
+  for (auto v : valid_keys) current_keys.erase(v);
+
+  // Assign values from YAML
+  //
+  try {
+    if (conf["theta"])            theta        = conf["theta"].as<double>();
+    if (conf["ncrit"])            ncrit        = conf["ncrit"].as<int>();
+    if (conf["soft"])             soft         = conf["soft"].as<double>();
+
+    if (conf["type"]) {
+      std::string type = conf["type"].as<std::string>();
+      if (type.compare("Spline") == 0) kernel = std::make_shared<SplineSoft>();
+      else                             kernel = std::make_shared<PlummerSoft>();
+    } else {
+      kernel = std::make_shared<SplineSoft>();
+      if (myid==0) std::cout << "TreeCode: using SplineSoft" << std::endl;
+    }
+  }
+  catch (YAML::Exception & error) {
+    if (myid==0) std::cout << "Error parsing parameters in TreeCode: "
+			   << error.what() << std::endl
+			   << std::string(60, '-') << std::endl
+			   << "Config node"        << std::endl
+			   << std::string(60, '-') << std::endl
+			   << conf                 << std::endl
+			   << std::string(60, '-') << std::endl;
+    throw std::runtime_error("TreeCode::initialize: error parsing YAML");
+  }
+
+  if (ncrit < 1) ncrit = 1;
+}
+
+void TreeCode::get_acceleration_and_potential(Component* C)
+{
+  cC = C;
+  nbodies = cC->Number();
+
+  /*======================================*/
+  /* Determine potential and acceleration */
+  /*======================================*/
+
+  determine_acceleration_and_potential();
+}
+
+void TreeCode::determine_acceleration_and_potential(void)
+{
+  int nlocal = component->Number();
+  MPI_Allreduce(&nlocal, &used, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+  if (used==0) return;
+
+  exchange();
+
+  exp_thread_fork(false);
+				// Clear external potential flag
+  use_external = false;
+}
+
+void TreeCode::build()
+{
+  nodes.clear();
+
+  int N = bm.size();
+  if (N==0) return;
+
+  // Bounding cube
+  //
+  double lo[3], hi[3];
+  for (int k=0; k<3; k++) {
+    lo[k] =  std::numeric_limits<double>::max();
+    hi[k] = -std::numeric_limits<double>::max();
+  }
+
+  for (int i=0; i<N; i++) {
+    lo[0] = std::min(lo[0], bx[i]); hi[0] = std::max(hi[0], bx[i]);
+    lo[1] = std::min(lo[1], by[i]); hi[1] = std::max(hi[1], by[i]);
+    lo[2] = std::min(lo[2], bz[i]); hi[2] = std::max(hi[2], bz[i]);
+  }
+
+  Node root;
+  root.half = 0.0;
+  for (int k=0; k<3; k++) {
+    root.ctr[k] = 0.5*(lo[k] + hi[k]);
+    root.half   = std::max(root.half, 0.5*(hi[k] - lo[k]));
+  }
+  root.half *= 1.0 + 1.0e-10;	// Keep the extreme bodies inside
+  root.beg   = 0;
+  root.end   = N;
+
+  order.resize(N);
+  for (int i=0; i<N; i++) order[i] = i;
+
+  nodes.push_back(root);
+  split(0, 0);
+
+  // Put the bodies in tree order so that each cell is contiguous
+  //
+  auto reorder = [&](std::vector<double>& v) {
+    std::vector<double> t(N);
+    for (int i=0; i<N; i++) t[i] = v[order[i]];
+    v.swap(t);
+  };
+
+  reorder(bm);
+  reorder(bx);
+  reorder(by);
+  reorder(bz);
+
+  moments(0);
+}
+
+void TreeCode::split(int n, int depth)
+{
+  nodes[n].child  = -1;
+  nodes[n].nchild = 0;
+
+  int beg = nodes[n].beg, end = nodes[n].end;
+  if (end - beg <= ncrit or depth >= maxdepth) return;
+
+  double ctr[3] = {nodes[n].ctr[0], nodes[n].ctr[1], nodes[n].ctr[2]};
+  double half   = nodes[n].half;
+
+  auto octant = [&](int i) {
+    return
+      (bx[i] > ctr[0] ? 1 : 0) +
+      (by[i] > ctr[1] ? 2 : 0) +
+      (bz[i] > ctr[2] ? 4 : 0) ;
+  };
+
+  // Counting sort of this cell's bodies by octant
+  //
+  int cnt[8] = {0, 0, 0, 0, 0, 0, 0, 0}, off[9];
+  for (int i=beg; i<end; i++) cnt[octant(order[i])]++;
+
+  off[0] = beg;
+  for (int o=0; o<8; o++) off[o+1] = off[o] + cnt[o];
+
+  std::vector<int> tmp(order.begin()+beg, order.begin()+end);
+  int pos[8];
+  for (int o=0; o<8; o++) pos[o] = off[o];
+  for (auto i : tmp) order[pos[octant(i)]++] = i;
+
+  // The children of a cell are contiguous
+  //
+  int first = nodes.size();
+  for (int o=0; o<8; o++) {
+    if (cnt[o]==0) continue;
+
+    Node c;
+    c.half = 0.5*half;
+    c.ctr[0] = ctr[0] + (o & 1 ? c.half : -c.half);
+    c.ctr[1] = ctr[1] + (o & 2 ? c.half : -c.half);
+    c.ctr[2] = ctr[2] + (o & 4 ? c.half : -c.half);
+    c.beg = off[o];
+    c.end = off[o+1];
+    nodes.push_back(c);
+  }
+
+  nodes[n].child  = first;
+  nodes[n].nchild = nodes.size() - first;
+
+  for (int c=first; c<first+nodes[n].nchild; c++) split(c, depth+1);
+}
+
+void TreeCode::moments(int n)
+{
+  double mass = 0.0, com[3] = {0.0, 0.0, 0.0};
+
+  if (nodes[n].child < 0) {
+    for (int i=nodes[n].beg; i<nodes[n].end; i++) {
+      mass   += bm[i];
+      com[0] += bm[i]*bx[i];
+      com[1] += bm[i]*by[i];
+      com[2] += bm[i]*bz[i];
+    }
+  } else {
+    for (int c=nodes[n].child; c<nodes[n].child+nodes[n].nchild; c++) {
+      moments(c);
+      mass += nodes[c].mass;
+      for (int k=0; k<3; k++) com[k] += nodes[c].mass*nodes[c].com[k];
+    }
+  }
+
+  nodes[n].mass = mass;
+  for (int k=0; k<3; k++)
+    nodes[n].com[k] = mass>0.0 ? com[k]/mass : nodes[n].ctr[k];
+}
+
+void TreeCode::essential(const std::array<double, 6>& box,
+			 std::vector<double>& out)
+{
+  if (nodes.size()==0 or box[0] > box[3]) return;
+
+  std::vector<int> stack(1, 0);
+
+  while (stack.size()) {
+    const Node& c = nodes[stack.back()];
+    stack.pop_back();
+
+    // Distance from the center of mass to the nearest point of the box
+    //
+    double d2 = 0.0;
+    for (int k=0; k<3; k++) {
+      double d = std::max(0.0, std::max(box[k] - c.com[k], c.com[k] - box[k+3]));
+      d2 += d*d;
+    }
+
+    double s = 2.0*c.half;
+
+    if (s*s < theta*theta*d2) {
+      out.insert(out.end(), {c.mass, c.com[0], c.com[1], c.com[2]});
+    } else if (c.child < 0) {
+      for (int i=c.beg; i<c.end; i++)
+	out.insert(out.end(), {bm[i], bx[i], by[i], bz[i]});
+    } else {
+      for (int n=c.child; n<c.child+c.nchild; n++) stack.push_back(n);
+    }
+  }
+}
+
+void TreeCode::exchange()
+{
+  // Local bodies
+  //
+  double adb = component->Adiabatic();
+
+  int nlocal = component->Number();
+  bm.resize(nlocal);
+  bx.resize(nlocal);
+  by.resize(nlocal);
+  bz.resize(nlocal);
+
+  int q = 0;
+  for (auto & v : component->Particles()) {
+    bm[q] = v.second->mass * adb;
+    bx[q] = v.second->pos[0];
+    by[q] = v.second->pos[1];
+    bz[q] = v.second->pos[2];
+    q++;
+  }
+
+  build();
+
+  if (numprocs==1) return;
+
+  // Bounding box of the active particles on this process (empty if
+  // lo > hi)
+  //
+  std::array<double, 6> box;
+  for (int k=0; k<3; k++) {
+    box[k]   =  std::numeric_limits<double>::max();
+    box[k+3] = -std::numeric_limits<double>::max();
+  }
+
+  for (int lev=mlevel; lev<=multistep; lev++) {
+    for (auto j : cC->levlist[lev]) {
+      if (cC->freeze(j)) continue;
+      for (int k=0; k<3; k++) {
+	box[k]   = std::min(box[k],   cC->Pos(j, k));
+	box[k+3] = std::max(box[k+3], cC->Pos(j, k));
+      }
+    }
+  }
+
+  std::vector<std::array<double, 6>> boxes(numprocs);
+  MPI_Allgather(box.data(), 6, MPI_DOUBLE, boxes[0].data(), 6, MPI_DOUBLE,
+		MPI_COMM_WORLD);
+
+  // Build the export lists for every other process
+  //
+  std::vector<double> sbuf;
+  std::vector<int> scnt(numprocs, 0), sdsp(numprocs, 0);
+
+  for (int n=0; n<numprocs; n++) {
+    sdsp[n] = sbuf.size();
+    if (n != myid) essential(boxes[n], sbuf);
+    scnt[n] = sbuf.size() - sdsp[n];
+  }
+
+  std::vector<int> rcnt(numprocs), rdsp(numprocs, 0);
+  MPI_Alltoall(scnt.data(), 1, MPI_INT, rcnt.data(), 1, MPI_INT,
+	       MPI_COMM_WORLD);
+  for (int n=1; n<numprocs; n++) rdsp[n] = rdsp[n-1] + rcnt[n-1];
+
+  std::vector<double> rbuf(rdsp[numprocs-1] + rcnt[numprocs-1]);
+  MPI_Alltoallv(sbuf.data(), scnt.data(), sdsp.data(), MPI_DOUBLE,
+		rbuf.data(), rcnt.data(), rdsp.data(), MPI_DOUBLE,
+		MPI_COMM_WORLD);
+
+  // Add the imports to the bodies and rebuild
+  //
+  for (size_t i=0; i<rbuf.size(); i+=4) {
+    bm.push_back(rbuf[i+0]);
+    bx.push_back(rbuf[i+1]);
+    by.push_back(rbuf[i+2]);
+    bz.push_back(rbuf[i+3]);
+  }
+
+  build();
+}
+
+template<class K>
+void * TreeCode::walk(const K& kern, int id)
+{
+  if (nodes.size()==0) return (NULL);
+
+  std::vector<int> stack;
+  stack.reserve(8*maxdepth);
+
+  const double theta2 = theta*theta;
+
+  // If we are multistepping, compute accel only at or above <mlevel>
+  //
+  for (int lev=mlevel; lev<=multistep; lev++) {
+
+    unsigned nbodies = cC->levlist[lev].size();
+    int nbeg = nbodies*id/nthrds;
+    int nend = nbodies*(id+1)/nthrds;
+
+    for (int i=nbeg; i<nend; i++) {
+
+				// Index of the current local particle
+      unsigned long j = cC->levlist[lev][i];
+
+				// Don't need acceleration for frozen particles
+      if (cC->freeze(j)) continue;
+
+      double x = cC->Pos(j, 0), y = cC->Pos(j, 1), z = cC->Pos(j, 2);
+      double ax = 0.0, ay = 0.0, az = 0.0, pot = 0.0;
+
+      // Accumulate a point mass at separation (dx, dy, dz)
+      //
+      auto add = [&](double m, double dx, double dy, double dz)
+      {
+	double rr = sqrt(dx*dx + dy*dy + dz*dz);
+				// Reject particle at current location
+	if (rr > rtol) {
+	  auto f = kern.eval(rr, soft);
+	  double rfac = m * f.first/(rr*rr*rr);
+	  ax  -= dx * rfac;
+	  ay  -= dy * rfac;
+	  az  -= dz * rfac;
+	  pot += m * f.second;
+	}
+      };
+
+      stack.clear();
+      stack.push_back(0);
+
+      while (stack.size()) {
+	const Node& c = nodes[stack.back()];
+	stack.pop_back();
+
+	double dx = x - c.com[0], dy = y - c.com[1], dz = z - c.com[2];
+	double s  = 2.0*c.half;
+
+	if (s*s < theta2*(dx*dx + dy*dy + dz*dz)) {
+	  add(c.mass, dx, dy, dz);
+	} else if (c.child < 0) {
+	  for (int k=c.beg; k<c.end; k++)
+	    add(bm[k], x - bx[k], y - by[k], z - bz[k]);
+	} else {
+	  for (int n=c.child; n<c.child+c.nchild; n++) stack.push_back(n);
+	}
+      }
+
+      cC->AddAcc(j, 0, ax);
+      cC->AddAcc(j, 1, ay);
+      cC->AddAcc(j, 2, az);
+      cC->AddPot(j, pot);
+    }
+  }
+
+  return (NULL);
+}
+
+void * TreeCode::determine_acceleration_and_potential_thread(void * arg)
+{
+  int id = *((int*)arg);
+
+  if (auto k = dynamic_cast<SplineSoft*>(kernel.get()))
+    return walk(*k, id);
+  if (auto k = dynamic_cast<PlummerSoft*>(kernel.get()))
+    return walk(*k, id);
+
+  return (NULL);
+}
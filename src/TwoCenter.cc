@@ -8,14 +8,15 @@
 
 const std::set<std::string> TwoCenter::valid_keys = {
   "nhisto",
-  "basis"
-
+  "basis",
+  "fused"
 };
 
 
 TwoCenter::TwoCenter(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
 {
   nhisto = 0;
+  fused  = true;
   inner  = vector<double>(3, 0);
   outer  = vector<double>(3, 0);
 
@@ -64,6 +65,23 @@ TwoCenter::TwoCenter(Component* c0, const YAML::Node& conf) : PotAccel(c0, conf)
   }
 
   dof = exp_in->dof;
+
+  // The outer expansion drives the fused force pass and applies the
+  // inner one with the complementary mixture weight
+  //
+  sph_in = sph_out = 0;
+  if (fused) {
+    sph_in  = dynamic_cast<SphericalBasis*>(exp_in );
+    sph_out = dynamic_cast<SphericalBasis*>(exp_out);
+    if (sph_in and sph_out) sph_out->setPartner(sph_in);
+    else {
+      sph_in = sph_out = 0;
+      if (myid==0)
+	std::cout << "---- TwoCenter: basis <" << basis << "> does not "
+		  << "support the fused force pass, using one pass per center"
+		  << std::endl;
+    }
+  }
 }
 
 
@@ -80,6 +98,7 @@ void TwoCenter::initialize()
   try {
     if (conf["nhisto"])         nhisto     = conf["nhisto"].as<int>();
     if (conf["basis"])          basis      = conf["basis"].as<string>();
+    if (conf["fused"])          fused      = conf["fused"].as<bool>();
   }
   catch (YAML::Exception & error) {
     if (myid==0) std::cout << "Error parsing parameters in TwoCenter: "
@@ -155,16 +174,32 @@ void TwoCenter::get_acceleration_and_potential(Component* curComp)
       outer[k] = component->com[k];
   }
 
-  if (use_external) exp_in -> SetExternal();
-  exp_in->get_acceleration_and_potential(cC);
-  exp_in->ClearExternal();
+  if (sph_out) {
+				// One pass over the particles for
+				// both centers
+    if (use_external) {
+      exp_in  -> SetExternal();
+      exp_out -> SetExternal();
+    }
+    sph_in ->begin_partner(cC);
+    sph_out->get_acceleration_and_potential(cC);
+    sph_in ->end_partner();
+    exp_in ->ClearExternal();
+    exp_out->ClearExternal();
+
+  } else {
+
+    if (use_external) exp_in -> SetExternal();
+    exp_in->get_acceleration_and_potential(cC);
+    exp_in->ClearExternal();
 
 				// Reset external force flag
-  use_external = use_external1;
+    use_external = use_external1;
 
-  if (use_external) exp_out -> SetExternal();
-  exp_out->get_acceleration_and_potential(cC);
-  exp_out->ClearExternal();
+    if (use_external) exp_out -> SetExternal();
+    exp_out->get_acceleration_and_potential(cC);
+    exp_out->ClearExternal();
+  }
 
 
   // Clear external potential flag
@@ -0,0 +1,160 @@
+/*
+  Start-up tuning of the thread count
+  -----------------------------------
+
+  Times the coefficient and force evaluation of the initial phase
+  space with a decreasing number of threads per process and keeps the
+  fastest.  The choice is cached by hardware signature in
+  <homedir>/autotune.yml so that later runs on the same kind of node
+  skip the trials.  Only the thread count is tuned: table sizes such
+  as EmpCylSL's NUMX and NUMY change the accuracy as well as the speed
+  and stay as configured.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+
+#include <expand.H>
+#include <ComponentContainer.H>
+
+#if HAVE_LIBCUDA==1
+#include <cuda_runtime.h>
+#endif
+
+namespace
+{
+  // CPU model, cores, processes per node, processes and GPU.  The
+  // best count depends on all of these.
+  std::string signature()
+  {
+    std::string model("unknown");
+    std::ifstream cpu("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpu, line)) {
+      if (line.find("model name") == 0) {
+	auto p = line.find(':');
+	if (p != std::string::npos) model = line.substr(p+2);
+	break;
+      }
+    }
+
+    std::ostringstream sout;
+    sout << model << " | cores=" << std::thread::hardware_concurrency()
+	 << " | ranks/node=" << siblingList.size()
+	 << " | ranks=" << numprocs;
+
+#if HAVE_LIBCUDA==1
+    if (use_cuda and cudaGlobalDevice>=0) {
+      cudaDeviceProp prop;
+      if (cudaGetDeviceProperties(&prop, cudaGlobalDevice) == cudaSuccess)
+	sout << " | gpu=" << prop.name;
+    }
+#endif
+
+    return sout.str();
+  }
+
+  // One full evaluation at every level, timed on the slowest process
+  double trial()
+  {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto beg = std::chrono::steady_clock::now();
+
+    if (multistep) comp->multistep_reset();
+    for (int M=0; M<=multistep; M++) comp->compute_expansion(M);
+    comp->compute_potential(0);
+
+    double t = std::chrono::duration<double>
+      (std::chrono::steady_clock::now() - beg).count();
+
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return t;
+  }
+}
+
+void autotune(bool trials)
+{
+  if (not autotune_threads) return;
+
+  std::string sig = signature(), file = homedir + "autotune.yml";
+  int best = 0, nmax = nthrds;
+
+  // A cached choice for this hardware
+  //
+  if (myid==0) {
+    try {
+      std::ifstream in(file);
+      if (in) {
+	YAML::Node cache = YAML::Load(in);
+	if (cache[sig] and cache[sig]["nthrds"])
+	  best = cache[sig]["nthrds"].as<int>();
+      }
+    }
+    catch (YAML::Exception& e) {
+      std::cout << "---- autotune: ignoring unreadable <" << file << ">: "
+		<< e.what() << std::endl;
+    }
+  }
+
+  MPI_Bcast(&best, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  if (best>0) {
+
+    // Never more than the per-thread storage was sized for
+    //
+    nthrds = std::min<int>(best, nmax);
+
+    if (myid==0)
+      std::cout << "---- autotune: nthrds=" << nthrds << " from <" << file
+		<< "> for [" << sig << "]" << std::endl;
+
+  } else if (trials) {
+
+    // Halve the count from the configured maximum; per-thread storage
+    // is sized for the maximum so the trials only go down
+    //
+    std::map<int, double> times;
+    for (int n=nmax; n>=1; n/=2) {
+      nthrds   = n;
+      times[n] = trial();
+      if (myid==0)
+	std::cout << "---- autotune: nthrds=" << std::setw(4) << n
+		  << "  time=" << times[n] << std::endl;
+    }
+
+    best = nmax;
+    for (auto v : times) if (v.second < times[best]) best = v.first;
+
+    nthrds = best;
+
+    if (myid==0) {
+      std::cout << "---- autotune: chose nthrds=" << best
+		<< " for [" << sig << "]" << std::endl;
+
+      YAML::Node cache;
+      try {
+	std::ifstream in(file);
+	if (in) cache = YAML::Load(in);
+      }
+      catch (YAML::Exception& e) {}
+
+      cache[sig]["nthrds"] = best;
+      cache[sig]["time"]   = times[best];
+
+      std::ofstream out(file);
+      if (out) out << cache << std::endl;
+      else std::cout << "---- autotune: could not write <" << file << ">"
+		     << std::endl;
+    }
+
+    // Leave the initial state as computed with the chosen count
+    //
+    if (best != 1) trial();
+  }
+
+  // Recorded in the parameter dump
+  //
+  parse["Global"]["nthrds"] = nthrds;
+}
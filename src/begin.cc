@@ -9,10 +9,14 @@
 
 #include <sys/types.h>
 #include <unistd.h>		// For getpid
+#include <sched.h>		// For thread affinity
 
 #include <expand.H>
 #include <ExternalCollection.H>
 #include <OutputContainer.H>
+#include <ThreadPool.H>
+#include <HugePages.H>
+#include <NodeShared.H>
 
 void begin_run(void)
 {
@@ -22,6 +26,26 @@ void begin_run(void)
 
   initialize_cuda();
 
+  //===================================
+  // Pin the threads before any
+  // per-thread storage is allocated
+  //===================================
+
+  initialize_affinity();
+
+  //===================================
+  // Page size for the large tables
+  //===================================
+
+  HugePages::mode = huge_pages;
+
+  //===================================
+  // Node-aware coefficient reductions
+  //===================================
+
+  NodeSharedComm::hierarchical = node_reduce;
+  if (node_reduce) NodeSharedComm::nodeComm(); // Collective set up
+
   //===================================
   // Make the instance containers
   //===================================
@@ -79,11 +103,24 @@ void begin_run(void)
 
   initializing = true;
   
+  //================================================
+  // Warm restart: the levels of an incremental
+  // checkpoint and the coefficient stacks saved
+  // with it replace the initial coefficient passes
+  //================================================
+
+  bool warm = multistep and restart and not ignore_info and
+    comp->levels_restored and comp->read_state(outdir + infile + ".state");
+
+  if (warm and myid==0)
+    std::cout << "---- Warm restart: coefficient state read from <"
+	      << outdir + infile + ".state" << ">" << std::endl;
+
   //================================
   // Multistep level initialization
   //================================
 
-  if (multistep) {
+  if (multistep and not warm) {
 
     comp->multistep_reset();
 
@@ -120,12 +157,23 @@ void begin_run(void)
   // Compute coefficients (again if multistep)
   //===========================================
 
-  if (multistep) comp->multistep_reset();
+  if (not warm) {
 
-  for (int M=0; M<=multistep; M++) comp->compute_expansion(M);
+    if (multistep) comp->multistep_reset();
+
+    for (int M=0; M<=multistep; M++) comp->compute_expansion(M);
+  }
 
   comp->compute_potential(0);
 
+  //=================================================
+  // Choose the thread count by timed trials (these
+  // recompute the coefficients, so not on a warm
+  // restart) or from the cache
+  //=================================================
+
+  autotune(not warm);
+
   initializing = false;
 
   //===================================
@@ -150,6 +198,7 @@ void initialize_cuda()
   int deviceCount = 0;
 
   cudaGlobalDevice = -1;
+  cudaGlobalDevices.clear();
 
   if (use_cuda) {
 
@@ -174,9 +223,16 @@ void initialize_cuda()
 	curCount++;
       }
       
-      // Allow GPU to be used by multiple MPI processes
+      // Allow GPU to be used by multiple MPI processes.  A process
+      // driving several devices takes a contiguous block of them.
       //
-      if (myCount < totalCount) cudaGlobalDevice = myCount % deviceCount;
+      int myGpus = std::min<int>(gpus_per_rank, deviceCount);
+
+      if (myCount*myGpus < totalCount) {
+	for (int k=0; k<myGpus; k++)
+	  cudaGlobalDevices.push_back((myCount*myGpus + k) % deviceCount);
+	cudaGlobalDevice = cudaGlobalDevices[0];
+      }
       
       // Set device; exit on failure
       //
@@ -191,6 +247,21 @@ void initialize_cuda()
 		  << cudaGlobalDevice << "/" << deviceCount << "]"
 		  << std::endl;
 
+	// Peer access from the first device lets partial results be
+	// combined on device
+	//
+	for (int k=1; k<cudaGlobalDevices.size(); k++) {
+	  int canAccess = 0;
+	  cudaDeviceCanAccessPeer(&canAccess, cudaGlobalDevice, cudaGlobalDevices[k]);
+	  if (canAccess) cudaDeviceEnablePeerAccess(cudaGlobalDevices[k], 0);
+
+	  std::cout << "---- Process <" << pid << ">: "
+		    << "adding CUDA device [" << cudaGlobalDevices[k]
+		    << "/" << deviceCount << "] on Rank [" << myid << "]"
+		    << (canAccess ? "" : " without peer access")
+		    << std::endl;
+	}
+
       } else {
 	
 	std::cout << "---- Component <" << pid << ">: "
@@ -209,3 +280,62 @@ void initialize_cuda()
   }
 #endif
 }
+
+
+void initialize_affinity()
+{
+#ifdef __linux__
+  if (not pin_threads) return;
+
+  // The cores this process may use
+  //
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask)) {
+    if (myid==0) perror("initialize_affinity");
+    return;
+  }
+
+  std::vector<int> cores;
+  for (int c=0; c<CPU_SETSIZE; c++) if (CPU_ISSET(c, &mask)) cores.push_back(c);
+
+  // Not bound by the launcher: share the node's cores between the
+  // ranks on it in contiguous blocks, which follow the sockets on
+  // the usual numbering
+  //
+  int nsib = siblingList.size(), mine = 0;
+  for (int i=0; i<nsib; i++) if (siblingList[i]==myid) mine = i;
+
+  if (nsib>1 and cores.size() == std::thread::hardware_concurrency()) {
+    size_t n = cores.size();
+    std::vector<int> block(cores.begin() + n*mine/nsib,
+			   cores.begin() + n*(mine+1)/nsib);
+    if (block.size()) cores.swap(block);
+  }
+
+  // The main thread may use all of the rank's cores; so may the
+  // threads that it starts, e.g. for OpenMP.  It also first touches
+  // the shared tables, which are then local to the rank's socket.
+  //
+  CPU_ZERO(&mask);
+  for (auto c : cores) CPU_SET(c, &mask);
+  sched_setaffinity(0, sizeof(mask), &mask);
+
+  // Each pool worker gets one core
+  //
+  ThreadPool::instance().pin(cores);
+
+  std::ostringstream sout;
+  sout << "---- Rank [" << myid << "] on [" << processor_name << "]: "
+       << cores.size() << " cores [" << cores.front() << "-"
+       << cores.back() << "] for " << nthrds << " threads";
+  if (static_cast<int>(cores.size()) < nthrds) sout << " (oversubscribed)";
+
+  // Report from every rank in order
+  //
+  for (int n=0; n<numprocs; n++) {
+    if (n==myid) std::cout << sout.str() << std::endl;
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+#endif
+}
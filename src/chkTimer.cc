@@ -20,6 +20,10 @@ extern "C" {
 time_t CheckpointTimer::delta = 600;
 				// 2 hours between diagnostic messages
 time_t CheckpointTimer::diag  = 7200;
+				// 1 minute minimum margin
+time_t CheckpointTimer::reserve = 60;
+				// Margin on the measured dump time
+double CheckpointTimer::safety  = 1.5;
 
 CheckpointTimer::CheckpointTimer()
 {
@@ -31,10 +35,19 @@ CheckpointTimer::CheckpointTimer()
   mean = var = 0;
   nsteps = 0;
   firstime = true;
+
+  tstep = tmark = std::chrono::steady_clock::now();
+  marked = false;
+  scount = 0;
+  smean = svar = cost = 0.0;
+  nnodes = 0;
 }
 
 void  CheckpointTimer::mark()
 {
+  tmark  = std::chrono::steady_clock::now();
+  marked = true;
+
   if (runtime<0.0) return;
 
   if (firstime && myid==0) {
@@ -91,6 +104,58 @@ std::ostream& operator<<(std::ostream& out, Time const& T)
 	     << setw(3) << sec << "s ";
 }
 
+void CheckpointTimer::step()
+{
+  if (nnodes==0) {
+    MPI_Comm node;
+    int local, first;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myid,
+			MPI_INFO_NULL, &node);
+    MPI_Comm_rank(node, &local);
+    MPI_Comm_free(&node);
+    first = local==0;
+    MPI_Allreduce(&first, &nnodes, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    // The first step includes the start up
+    //
+    tstep  = std::chrono::steady_clock::now();
+    marked = false;
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  double dt = std::chrono::duration<double>(now - tstep).count();
+  tstep = now;
+
+  // The excess over a typical step is the cost of the dump; the
+  // latest measurement is weighted most
+  //
+  if (marked) {
+    if (scount) {
+      double c = std::max<double>(dt - smean, 0.0);
+      cost = cost>0.0 ? 0.5*(cost + c) : c;
+    }
+    marked = false;
+    return;
+  }
+
+  scount++;
+  double d = dt - smean;
+  smean += d/scount;
+  svar  += d*(dt - smean);
+}
+
+bool CheckpointTimer::due()
+{
+  if (node_mtbf<=0.0 or cost<=0.0 or nnodes<1) return false;
+
+  double M = node_mtbf*3600.0/nnodes;
+  double T = sqrt(2.0*cost*M);
+
+  auto now = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(now - tmark).count() >= T;
+}
+
 bool CheckpointTimer::done()
 {
   if (runtime<0.0) return false;
@@ -102,7 +167,14 @@ bool CheckpointTimer::done()
   // The root node decides
   //
   if (myid==0) {
-    if (last == 0)                           flg = 0;
+    if (cost>0.0 and scount>1) {
+				// The next step, with two standard
+				// deviations, and the final dump
+      double sdev   = sqrt(svar/(scount-1));
+      double margin = smean + 2.0*sdev + safety*cost;
+      if (time(0) + std::max<double>(margin, reserve) > final) flg = 1;
+    }
+    else if (last == 0)                      flg = 0;
     else if (time(0) + tr + delta > final)   flg = 1;
     // Zero otherwise
   }
@@ -141,6 +213,7 @@ bool CheckpointTimer::done()
 	   << "Remaining: " << Time(final-time(0)) << endl
 	   << "Mean step: " << Time(mean)          << endl
 	   << "Root var:  " << Time(sqrt(var))     << endl
+	   << "Dump cost: " << Time(cost)          << endl
 	   << "-------------------------------------------"
 	   << "---------------------------"        << endl;
       last_diag = right_now;
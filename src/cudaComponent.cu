@@ -71,7 +71,8 @@ Component::cudaStreamData::~cudaStreamData()
 
 void Component::cuda_initialize()
 {
-  cuStream = std::make_shared<cudaStreamData>();
+  cuStream   = std::make_shared<cudaStreamData>();
+  hostFields = 0;
 }
 
 
@@ -713,6 +714,229 @@ void Component::CudaToParticles(hostPartItr beg, hostPartItr end)
   if (step_timing and use_cuda) comp->timer_cuda.stop();
 }
 
+// Number of cuFP_t values per particle for a field selection
+//
+static int cudaFieldCount(unsigned fields)
+{
+  int nf = 0;
+  if (fields & Component::cudaMass ) nf += 1;
+  if (fields & Component::cudaPos  ) nf += 3;
+  if (fields & Component::cudaVel  ) nf += 3;
+  if (fields & Component::cudaAcc  ) nf += 3;
+  if (fields & Component::cudaPot  ) nf += 2;
+  if (fields & Component::cudaLev  ) nf += 1;
+  if (fields & Component::cudaDtreq) nf += 1;
+  return nf;
+}
+
+// Pack the selected fields into a flat array, one particle per row,
+// in device order along with the particle sequence index
+//
+__global__ void
+packFieldsKernel(dArray<cudaParticle> P, dArray<cuFP_t> B, dArray<unsigned> I,
+		 unsigned fields, int nf, int stride)
+{
+  const int tid = blockDim.x * blockIdx.x + threadIdx.x;
+
+  for (int n=0; n<stride; n++) {
+    int i = tid*stride + n;
+
+    if (i < P._s) {
+
+      cudaParticle & p = P._v[i];
+      cuFP_t * b = &B._v[i*nf];
+
+      I._v[i] = p.indx;
+
+      if (fields & Component::cudaMass) *(b++) = p.mass;
+      if (fields & Component::cudaPos)
+	for (int k=0; k<3; k++) *(b++) = p.pos[k];
+      if (fields & Component::cudaVel)
+	for (int k=0; k<3; k++) *(b++) = p.vel[k];
+      if (fields & Component::cudaAcc)
+	for (int k=0; k<3; k++) *(b++) = p.acc[k];
+      if (fields & Component::cudaPot) {
+	*(b++) = p.pot;
+	*(b++) = p.potext;
+      }
+      if (fields & Component::cudaLev)   *(b++) = p.lev[0];
+      if (fields & Component::cudaDtreq) *(b++) = p.dtreq;
+    }
+  }
+}
+
+// Inverse of packFieldsKernel
+//
+__global__ void
+unpackFieldsKernel(dArray<cudaParticle> P, dArray<cuFP_t> B,
+		   unsigned fields, int nf, int stride)
+{
+  const int tid = blockDim.x * blockIdx.x + threadIdx.x;
+
+  for (int n=0; n<stride; n++) {
+    int i = tid*stride + n;
+
+    if (i < P._s) {
+
+      cudaParticle & p = P._v[i];
+      cuFP_t * b = &B._v[i*nf];
+
+      if (fields & Component::cudaMass) p.mass = *(b++);
+      if (fields & Component::cudaPos)
+	for (int k=0; k<3; k++) p.pos[k] = *(b++);
+      if (fields & Component::cudaVel)
+	for (int k=0; k<3; k++) p.vel[k] = *(b++);
+      if (fields & Component::cudaAcc)
+	for (int k=0; k<3; k++) p.acc[k] = *(b++);
+      if (fields & Component::cudaPot) {
+	p.pot    = *(b++);
+	p.potext = *(b++);
+      }
+      if (fields & Component::cudaLev) p.lev[0] = p.lev[1] = *(b++);
+      if (fields & Component::cudaDtreq) p.dtreq = *(b++);
+    }
+  }
+}
+
+void Component::CudaFetch(unsigned fields)
+{
+  unsigned need = fields & ~hostFields;
+
+  if (need == 0) return;
+
+  if (need & cudaAttr) CudaToParticles();
+  else                 CudaFieldsToParticles(need);
+}
+
+void Component::CudaFieldsToParticles(unsigned fields)
+{
+  auto cr = cuStream;
+
+  unsigned int N  = cr->cuda_particles.size();
+  int          nf = cudaFieldCount(fields);
+
+  if (N==0 or nf==0) {
+    hostFields |= fields;
+    return;
+  }
+
+  if (step_timing and use_cuda) comp->timer_cuda.start();
+
+  cudaDeviceProp deviceProp;
+  cudaGetDeviceProperties(&deviceProp, cudaDevice);
+  cuda_check_last_error_mpi("cudaGetDeviceProperties", __FILE__, __LINE__, myid);
+
+  unsigned int stride   = N/BLOCK_SIZE/deviceProp.maxGridSize[0] + 1;
+  unsigned int gridSize = N/BLOCK_SIZE/stride;
+
+  if (N > gridSize*BLOCK_SIZE*stride) gridSize++;
+
+  thrust::device_vector<cuFP_t>   buf(N*nf);
+  thrust::device_vector<unsigned> idx(N);
+
+  packFieldsKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
+    (toKernel(cr->cuda_particles), toKernel(buf), toKernel(idx),
+     fields, nf, stride);
+
+  cudaStreamSynchronize(cr->stream);
+  cuda_check_last_error_mpi("cudaStreamSynchronize", __FILE__, __LINE__, myid);
+
+  thrust::host_vector<cuFP_t>   hbuf = buf;
+  thrust::host_vector<unsigned> hidx = idx;
+
+  for (unsigned int i=0; i<N; i++) {
+    auto & p = particles[hidx[i]];
+    cuFP_t * b = &hbuf[i*nf];
+
+    if (fields & cudaMass) p->mass = *(b++);
+    if (fields & cudaPos)
+      for (int k=0; k<3; k++) p->pos[k] = *(b++);
+    if (fields & cudaVel)
+      for (int k=0; k<3; k++) p->vel[k] = *(b++);
+    if (fields & cudaAcc)
+      for (int k=0; k<3; k++) p->acc[k] = *(b++);
+    if (fields & cudaPot) {
+      p->pot    = *(b++);
+      p->potext = *(b++);
+    }
+    if (fields & cudaLev)   p->level = static_cast<unsigned>(*(b++));
+    if (fields & cudaDtreq) p->dtreq = *(b++);
+  }
+
+  if (fields & cudaLev) MakeLevlist();
+
+  hostFields |= fields;
+
+  if (step_timing and use_cuda) comp->timer_cuda.stop();
+}
+
+void Component::ParticlesFieldsToCuda(unsigned fields)
+{
+  auto cr = cuStream;
+
+  unsigned int N  = cr->cuda_particles.size();
+  int          nf = cudaFieldCount(fields);
+
+  if (N==0 or nf==0) return;
+
+  if (step_timing and use_cuda) comp->timer_cuda.start();
+
+  cudaDeviceProp deviceProp;
+  cudaGetDeviceProperties(&deviceProp, cudaDevice);
+  cuda_check_last_error_mpi("cudaGetDeviceProperties", __FILE__, __LINE__, myid);
+
+  unsigned int stride   = N/BLOCK_SIZE/deviceProp.maxGridSize[0] + 1;
+  unsigned int gridSize = N/BLOCK_SIZE/stride;
+
+  if (N > gridSize*BLOCK_SIZE*stride) gridSize++;
+
+  // The device order may have changed since the last copy so get the
+  // current sequence of particle indices
+  //
+  thrust::device_vector<cuFP_t>   buf(N*nf);
+  thrust::device_vector<unsigned> idx(N);
+
+  packFieldsKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
+    (toKernel(cr->cuda_particles), toKernel(buf), toKernel(idx),
+     0, nf, stride);
+
+  cudaStreamSynchronize(cr->stream);
+  cuda_check_last_error_mpi("cudaStreamSynchronize", __FILE__, __LINE__, myid);
+
+  thrust::host_vector<unsigned> hidx = idx;
+  thrust::host_vector<cuFP_t>   hbuf(N*nf);
+
+  for (unsigned int i=0; i<N; i++) {
+    auto & p = particles[hidx[i]];
+    cuFP_t * b = &hbuf[i*nf];
+
+    if (fields & cudaMass) *(b++) = p->mass;
+    if (fields & cudaPos)
+      for (int k=0; k<3; k++) *(b++) = p->pos[k];
+    if (fields & cudaVel)
+      for (int k=0; k<3; k++) *(b++) = p->vel[k];
+    if (fields & cudaAcc)
+      for (int k=0; k<3; k++) *(b++) = p->acc[k];
+    if (fields & cudaPot) {
+      *(b++) = p->pot;
+      *(b++) = p->potext;
+    }
+    if (fields & cudaLev)   *(b++) = p->level;
+    if (fields & cudaDtreq) *(b++) = p->dtreq;
+  }
+
+  buf = hbuf;
+
+  unpackFieldsKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
+    (toKernel(cr->cuda_particles), toKernel(buf), fields, nf, stride);
+
+  // A level change alters the level index
+  //
+  if (fields & cudaLev) CudaSortByLevel();
+
+  if (step_timing and use_cuda) comp->timer_cuda.stop();
+}
+
 // No longer used because we need to deal with indirection
 //
 struct cudaZeroAcc : public thrust::unary_function<cudaParticle, cudaParticle>
@@ -1116,7 +1340,7 @@ std::vector<int> Component::get_level_lists_cuda()
 // testing
 void Component::MakeLevlist()
 {
-  levlist.resize(multistep+1);
-  for (auto & v : levlist) v.clear();
-  for (auto & v : particles) levlist[v.second->level].push_back(v.first);
+  std::vector< std::vector<int> > newlist(multistep+1);
+  for (auto & v : particles) newlist[v.second->level].push_back(v.first);
+  levlist.assign(newlist);
 }
@@ -6,6 +6,10 @@
 #include <float.h>
 #include "expand.H"
 
+#include <thrust/transform_reduce.h>
+#include <thrust/count.h>
+#include <cublas_v2.h>
+
 // Define for debugging
 //
 // #define OFF_GRID_ALERT
@@ -408,7 +412,7 @@ __global__ void coefKernelCyl
 	  if (k>=tex._s)            printf("out of bounds: %s:%d\n", __FILE__, __LINE__);
 	  if ((2*n+0)*N+i>=coef._s) printf("out of bounds: %s:%d\n", __FILE__, __LINE__);
 #endif
-	  coef._v[(2*n+0)*N + i] = valC * cosp * norm * mass;
+	  if (coef._s>0) coef._v[(2*n+0)*N + i] = valC * cosp * norm * mass;
 
 	  if (m>0) {
 	    // potS tables are offset from potC tables by +3
@@ -425,14 +429,14 @@ __global__ void coefKernelCyl
 	    d11  = int2_as_double(tex3D<int2>(tex._v[k], indx+1, indy+1, 3));
 #endif
 	    valS = c00*d00 + c10*d10 + c01*d01 + c11*d11;
-	    coef._v[(2*n+1)*N + i] = valS * sinp * norm * mass;
+	    if (coef._s>0) coef._v[(2*n+1)*N + i] = valS * sinp * norm * mass;
 
 #ifdef BOUNDS_CHECK
 	    if ((2*n+1)*N+i>=coef._s) printf("out of bounds: %s:%d\n", __FILE__, __LINE__);
 #endif
 	  }
 	  // m==0
-	  else {
+	  else if (coef._s>0) {
 	    coef._v[(2*n+1)*N + i] = 0.0;
 	  }
 
@@ -467,9 +471,11 @@ __global__ void coefKernelCyl
 
       } else {
 	// No contribution from off-grid particles
-	for (int n=0; n<nmax; n++) {
-	  coef._v[(2*n+0)*N + i] = 0.0;
-	  if (m) coef._v[(2*n+1)*N + i] = 0.0;
+	if (coef._s>0) {
+	  for (int n=0; n<nmax; n++) {
+	    coef._v[(2*n+0)*N + i] = 0.0;
+	    if (m) coef._v[(2*n+1)*N + i] = 0.0;
+	  }
 	}
 
 	if (compute and tvar._s>0) {
@@ -500,6 +506,99 @@ __global__ void coefKernelCyl
 
 }
 
+// Fused accumulate-and-reduce version of coefKernelCyl: each block
+// sums its particles' contributions to the order m coefficients in
+// registers and writes one partial per block and coefficient to
+// out[j*gridDim.x + blockIdx.x].  Scratch is 2*nmax*gridDim.x rather
+// than 2*nmax*N.
+//
+__global__ void coefReduceKernelCyl
+(dArray<cuFP_t> out, dArray<cuFP_t> used, dArray<cudaTextureObject_t> tex,
+ dArray<cuFP_t> Mass, dArray<cuFP_t> Phi,
+ dArray<cuFP_t> Xfac, dArray<cuFP_t> Yfac,
+ dArray<int> indX, dArray<int> indY,
+ int stride, int m, unsigned int nmax, PII lohi)
+{
+  __shared__ typename cub::BlockReduce<cuFP_t, BLOCK_SIZE>::TempStorage tmp;
+
+  // Thread ID
+  //
+  const int tid = blockDim.x * blockIdx.x + threadIdx.x;
+
+  const cuFP_t norm = -4.0*M_PI;    // Biorthogonality factor
+
+  for (int n=0; n<nmax; n++) {
+
+    cuFP_t sumC = 0.0, sumS = 0.0;
+
+    for (int s=0; s<stride; s++) {
+
+      // Particle counter
+      //
+      int i     = tid*stride + s;
+      int npart = i + lohi.first;
+
+      if (npart < lohi.second) {
+
+	cuFP_t mass = Mass._v[i];
+
+	if (mass>0.0) {
+				// For accumulating mass of used particles
+	  if (n==0 and m==0) used._v[i] = mass;
+
+	  cuFP_t phi   = Phi._v[i];
+	  cuFP_t delx0 = Xfac._v[i];
+	  cuFP_t dely0 = Yfac._v[i];
+	  cuFP_t delx1 = 1.0 - delx0;
+	  cuFP_t dely1 = 1.0 - dely0;
+
+	  cuFP_t c00 = delx0*dely0;
+	  cuFP_t c10 = delx1*dely0;
+	  cuFP_t c01 = delx0*dely1;
+	  cuFP_t c11 = delx1*dely1;
+
+	  int   indx = indX._v[i];
+	  int   indy = indY._v[i];
+	  int   k    = m*nmax + n;
+
+#if cuREAL == 4
+	  cuFP_t d00   = tex3D<float>(tex._v[k], indx,   indy  , 0);
+	  cuFP_t d10   = tex3D<float>(tex._v[k], indx+1, indy  , 0);
+	  cuFP_t d01   = tex3D<float>(tex._v[k], indx,   indy+1, 0);
+	  cuFP_t d11   = tex3D<float>(tex._v[k], indx+1, indy+1, 0);
+#else
+	  cuFP_t d00   = int2_as_double(tex3D<int2>(tex._v[k], indx,   indy  , 0));
+	  cuFP_t d10   = int2_as_double(tex3D<int2>(tex._v[k], indx+1, indy  , 0));
+	  cuFP_t d01   = int2_as_double(tex3D<int2>(tex._v[k], indx,   indy+1, 0));
+	  cuFP_t d11   = int2_as_double(tex3D<int2>(tex._v[k], indx+1, indy+1, 0));
+#endif
+	  sumC += (c00*d00 + c10*d10 + c01*d01 + c11*d11) * cos(phi*m) * norm * mass;
+
+	  if (m>0) {
+	    // potS tables are offset from potC tables by +3
+	    //
+#if cuREAL == 4
+	    d00  = tex3D<float>(tex._v[k], indx,   indy  , 3);
+	    d10  = tex3D<float>(tex._v[k], indx+1, indy  , 3);
+	    d01  = tex3D<float>(tex._v[k], indx,   indy+1, 3);
+	    d11  = tex3D<float>(tex._v[k], indx+1, indy+1, 3);
+#else
+	    d00  = int2_as_double(tex3D<int2>(tex._v[k], indx,   indy  , 3));
+	    d10  = int2_as_double(tex3D<int2>(tex._v[k], indx+1, indy  , 3));
+	    d01  = int2_as_double(tex3D<int2>(tex._v[k], indx,   indy+1, 3));
+	    d11  = int2_as_double(tex3D<int2>(tex._v[k], indx+1, indy+1, 3));
+#endif
+	    sumS += (c00*d00 + c10*d10 + c01*d01 + c11*d11) * sin(phi*m) * norm * mass;
+	  }
+	}
+      }
+    }
+
+    blockSumStore<cuFP_t, BLOCK_SIZE>(out, sumC, 2*n+0, tmp);
+    blockSumStore<cuFP_t, BLOCK_SIZE>(out, sumS, 2*n+1, tmp);
+  }
+}
+
 __global__ void
 forceKernelCyl(dArray<cudaParticle> P, dArray<int> I,
 	       dArray<cuFP_t> coef,
@@ -822,9 +921,6 @@ void Cylinder::cudaStorage::resize_coefs
 {
   // Reserve space for coefficient reduction
   //
-  if (dN_coef.capacity() < 2*ncylorder*N)
-    dN_coef.reserve(2*ncylorder*N);
-  
   if (dc_coef.capacity() < 2*ncylorder*gridSize)
     dc_coef.reserve(2*ncylorder*gridSize);
   
@@ -865,7 +961,6 @@ void Cylinder::cudaStorage::resize_coefs
   
   // Set space for current step
   //
-  dN_coef.resize(2*ncylorder*N);
   dc_coef.resize(2*ncylorder*gridSize);
   dw_coef.resize(2*ncylorder);	// This will stay fixed
 
@@ -1120,34 +1215,41 @@ void Cylinder::determine_coefficients_cuda(bool compute)
 
     for (int m=0; m<=mmax; m++) {
 
-      coefKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
-	(toKernel(cuS.dN_coef), toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
-	 toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d), toKernel(cuS.p_d),
+      // Accumulate and reduce the contribution to the coefficients
+      // per grid block
+      //
+      coefReduceKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
+	(toKernel(cuS.dc_coef), toKernel(cuS.u_d), toKernel(t_d),
+	 toKernel(cuS.m_d), toKernel(cuS.p_d),
 	 toKernel(cuS.X_d), toKernel(cuS.Y_d), toKernel(cuS.iX_d), toKernel(cuS.iY_d),
-	 stride, m, nmax, cur, compute);
+	 stride, m, nmax, cur);
       
-      // Begin the reduction by blocks [perhaps this should use a
-      // stride?]
+      // The PCA accumulators still need the per-particle values;
+      // dN_coef is empty so only the tvar arrays are written
       //
+      if (compute and (pcavar or pcaeof)) {
+	coefKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
+	  (toKernel(cuS.dN_coef), toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
+	   toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d), toKernel(cuS.p_d),
+	   toKernel(cuS.X_d), toKernel(cuS.Y_d), toKernel(cuS.iX_d), toKernel(cuS.iY_d),
+	   stride, m, nmax, cur, compute);
+      }
+
       unsigned int gridSize1 = N/BLOCK_SIZE;
       if (N > gridSize1*BLOCK_SIZE) gridSize1++;
 
-      reduceSum<cuFP_t, BLOCK_SIZE>
-	<<<gridSize1, BLOCK_SIZE, sMemSize, cs->stream>>>
-	(toKernel(cuS.dc_coef), toKernel(cuS.dN_coef), osize, N);
-      
       // Finish the reduction for this order in parallel
       //
       thrust::counting_iterator<int> index_begin(0);
-      thrust::counting_iterator<int> index_end(gridSize1*osize);
+      thrust::counting_iterator<int> index_end(gridSize*osize);
 
       // The key_functor indexes the sum reduced series by array index
       //
       thrust::reduce_by_key
 	(
 	 thrust::cuda::par.on(cs->stream),
-	 thrust::make_transform_iterator(index_begin, key_functor(gridSize1)),
-	 thrust::make_transform_iterator(index_end,   key_functor(gridSize1)),
+	 thrust::make_transform_iterator(index_begin, key_functor(gridSize)),
+	 thrust::make_transform_iterator(index_end,   key_functor(gridSize)),
 	 cuS.dc_coef.begin(), thrust::make_discard_iterator(), cuS.dw_coef.begin()
 	 );
 
@@ -1159,7 +1261,7 @@ void Cylinder::determine_coefficients_cuda(bool compute)
 
       if (compute) {
 
-	// Reuse dN_coef and use dN_tvar to create sampT partitions
+	// Use dN_tvar to create sampT partitions
 	//
 	if (pcavar) {
 
@@ -1327,7 +1429,17 @@ void Cylinder::determine_coefficients_cuda(bool compute)
     cylmass0[0] += thrust::reduce(exec, it, last);
   }
 
-  if (Ntotal == 0) {
+  // With a CUDA-aware MPI, sum the device buffer over processes in
+  // place.  Every process must take part, even with no particles.
+  //
+  if (cuda_mpi) {
+    cudaStreamSynchronize(cs->stream);
+    cuda_check_last_error_mpi("cudaStreamSynchronize", __FILE__, __LINE__, myid);
+
+    MPI_Allreduce(MPI_IN_PLACE, thrust::raw_pointer_cast(cuS.df_coef.data()),
+		  cuS.df_coef.size(), cuMPI_FP, MPI_SUM, MPI_COMM_WORLD);
+  }
+  else if (Ntotal == 0) {
     return;
   }
 
@@ -1343,6 +1455,10 @@ void Cylinder::determine_coefficients_cuda(bool compute)
     offst += 2*nmax;
   }
 
+  if (Ntotal == 0) {
+    return;
+  }
+
   if (compute) {
 
     // Variance computation
@@ -1981,10 +2097,6 @@ void Cylinder::multistep_update_cuda()
 	cuS.resize_coefs(nmax, mmax, N, gridSize, stride,
 			 sampT, pcavar, pcaeof, subsamp);
 	
-	// Shared memory size for the reduction
-	//
-	int sMemSize = BLOCK_SIZE * sizeof(cuFP_t);
-    
 	// Compute the coordinate transformation
 	// 
 	coordKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
@@ -2002,34 +2114,24 @@ void Cylinder::multistep_update_cuda()
 
 	for (int m=0; m<=mmax; m++) {
 
-	  coefKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
-	    (toKernel(cuS.dN_coef), toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
-	     toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d), toKernel(cuS.p_d),
+	  coefReduceKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
+	    (toKernel(cuS.dc_coef), toKernel(cuS.u_d), toKernel(t_d),
+	     toKernel(cuS.m_d), toKernel(cuS.p_d),
 	     toKernel(cuS.X_d), toKernel(cuS.Y_d), toKernel(cuS.iX_d), toKernel(cuS.iY_d),
-	     stride, m, nmax, cur, false);
-
-	  // Begin the reduction per grid block [perhaps this should
-	  // use a stride?]
-	  //
-	  unsigned int gridSize1 = N/BLOCK_SIZE;
-	  if (N > gridSize1*BLOCK_SIZE) gridSize1++;
+	     stride, m, nmax, cur);
 
-	  reduceSum<cuFP_t, BLOCK_SIZE>
-	    <<<gridSize1, BLOCK_SIZE, sMemSize, cs->stream>>>
-	    (toKernel(cuS.dc_coef), toKernel(cuS.dN_coef), osize, N);
-	  
 	  // Finish the reduction for this order in parallel
 	  //
 	  thrust::counting_iterator<int> index_begin(0);
-	  thrust::counting_iterator<int> index_end(gridSize1*osize);
+	  thrust::counting_iterator<int> index_end(gridSize*osize);
 
 	  // The key_functor indexes the sum reduced series by array index
 	  //
 	  thrust::reduce_by_key
 	    (
 	     thrust::cuda::par.on(cs->stream),
-	     thrust::make_transform_iterator(index_begin, key_functor(gridSize1)),
-	     thrust::make_transform_iterator(index_end,   key_functor(gridSize1)),
+	     thrust::make_transform_iterator(index_begin, key_functor(gridSize)),
+	     thrust::make_transform_iterator(index_end,   key_functor(gridSize)),
 	     cuS.dc_coef.begin(), thrust::make_discard_iterator(), cuS.dw_coef.begin()
 	     );
 
@@ -2092,3 +2194,369 @@ void Cylinder::destroy_cuda()
 		     "cudaFreeArray", __FILE__, __LINE__);
   }
 }
+
+
+// EOF covariance on the device
+// ----------------------------
+
+//! Device storage for the EOF covariance of one basis
+struct Cylinder::cudaEOF
+{
+  //! Basis receiving the covariance (null if none in progress)
+  EmpCylSL* basis = 0;
+
+  //! Textures and mapping for the spherical basis of the EOF
+  std::vector<cudaArray_t> arr;
+  thrust::host_vector<cudaTextureObject_t> tex;
+  thrust::device_vector<cudaTextureObject_t> t_d;
+  cudaMappingConstants sl;
+
+  //! Per particle weight, cos(theta), phi and interpolation
+  thrust::device_vector<cuFP_t> W, X, Phi, A;
+  thrust::device_vector<int> Ind;
+
+  //! Basis vectors of a bunch, particle index fastest
+  thrust::device_vector<double> V;
+
+  //! Covariance blocks and l flags by 4*m + k (see
+  //! EmpCylSL::eof_block)
+  std::vector<thrust::device_vector<double>> S;
+  std::vector<thrust::device_vector<int>> F;
+  std::vector<int> nL;
+
+  cublasHandle_t handle;
+
+  cudaEOF()  { cublasCreate(&handle); }
+  ~cudaEOF() { release(); cublasDestroy(handle); }
+
+  void release()
+  {
+    for (auto t : tex) cudaDestroyTextureObject(t);
+    for (auto a : arr) cudaFreeArray(a);
+    tex.clear();
+    arr.clear();
+    S.clear();
+    basis = 0;
+  }
+};
+
+// Frame, weight and spherical-basis interpolation for the EOF
+// covariance of each particle, as in Cylinder::determine_coefficients
+// and EmpCylSL::accumulate_eof
+//
+__global__ void eofCoordKernelCyl
+(dArray<cudaParticle> P, dArray<int> I,
+ dArray<cuFP_t> W, dArray<cuFP_t> X, dArray<cuFP_t> Phi,
+ dArray<cuFP_t> Afac, dArray<int> Indx,
+ unsigned int stride, PII lohi, cuFP_t rmax, cuFP_t ascale,
+ cudaMappingConstants sl)
+{
+  const int tid = blockDim.x * blockIdx.x + threadIdx.x;
+
+  for (int n=0; n<stride; n++) {
+    int i     = tid*stride + n;	// Particle counter
+    int npart = i + lohi.first;	// Particle index
+
+    if (npart < lohi.second) {
+
+      cudaParticle & p = P._v[I._v[npart]];
+
+      cuFP_t xx=0.0, yy=0.0, zz=0.0;
+
+      if (cylOrient) {
+	for (int k=0; k<3; k++) xx += cylBody[0+k]*(p.pos[k] - cylCen[k]);
+	for (int k=0; k<3; k++) yy += cylBody[3+k]*(p.pos[k] - cylCen[k]);
+	for (int k=0; k<3; k++) zz += cylBody[6+k]*(p.pos[k] - cylCen[k]);
+      } else {
+	xx = p.pos[0] - cylCen[0];
+	yy = p.pos[1] - cylCen[1];
+	zz = p.pos[2] - cylCen[2];
+      }
+
+      cuFP_t r = sqrt(xx*xx + yy*yy + zz*zz);
+
+      // Unused particles have zero weight and finite values
+      //
+      W._v[i]    = 0.0;
+      X._v[i]    = 0.0;
+      Phi._v[i]  = 0.0;
+      Afac._v[i] = 1.0;
+      Indx._v[i] = 0;
+
+      if (r<rmax) {
+	W._v[i]   = sqrt(p.mass);
+	X._v[i]   = zz/(r + 1.0e-18);
+	Phi._v[i] = atan2(yy, xx);
+
+	// SLGridSph::get_pot mapping
+	//
+	cuFP_t x = r/ascale;
+	if      (sl.cmapR==1) x = (x/sl.rscale - 1.0)/(x/sl.rscale + 1.0);
+	else if (sl.cmapR==2) x = log(x);
+
+	cuFP_t xi = (x - sl.xmin)/sl.dxi;
+	int indx = floor(xi);
+
+	if (indx<0) indx = 0;
+	if (indx>sl.numr-2) indx = sl.numr - 2;
+
+	Afac._v[i] = cuFP_t(indx+1) - xi;
+	Indx._v[i] = indx;
+      }
+    }
+  }
+}
+
+__device__ __forceinline__
+cuFP_t eofFetchCyl(cudaTextureObject_t t, int i)
+{
+#if cuREAL == 4
+  return tex1D<float>(t, i);
+#else
+  return int2_as_double(tex1D<int2>(t, i));
+#endif
+}
+
+// Basis vector of each particle for harmonic m over the l values
+// flagged in L, scaled by the square root of the mass.  Column
+// (il*nmax + n) of V holds the n-th function of the il-th flagged l.
+// The Legendre functions follow EmpCylSL::legendre_R.
+//
+__global__ void eofVecKernelCyl
+(dArray<double> V, dArray<cuFP_t> W, dArray<cuFP_t> X, dArray<cuFP_t> Phi,
+ dArray<cuFP_t> Afac, dArray<int> Indx, dArray<cudaTextureObject_t> tex,
+ dArray<int> L, int m, bool sine, int lmax, int nmax, cuFP_t pfac, int N)
+{
+  const int i = blockDim.x * blockIdx.x + threadIdx.x;
+
+  if (i >= N) return;
+
+  cuFP_t x   = X._v[i];
+  cuFP_t a   = Afac._v[i], b = 1.0 - a;
+  int    ind = Indx._v[i];
+
+  cuFP_t trig = sine ? sin(Phi._v[i]*m) : cos(Phi._v[i]*m);
+  cuFP_t norm = W._v[i] * pfac * trig / sqrt((m>0 ? 8.0 : 4.0)*M_PI);
+
+  cuFP_t p0 =
+    a*eofFetchCyl(tex._v[0], ind) + b*eofFetchCyl(tex._v[0], ind+1);
+
+  // Diagonal P_m^m and the recursion in l
+  //
+  cuFP_t u = sqrt(1.0 - x*x), pmm = 1.0;
+  if (m>0) pmm = -sqrt(3.0)*u;
+  for (int k=2; k<=m; k++) pmm *= -u*sqrt((2.0*k+1)/(2.0*k));
+
+  cuFP_t p1 = 0.0, p2 = 0.0;	// P_{l-1}^m and P_{l-2}^m
+  int col = 0;
+
+  for (int l=m; l<=lmax; l++) {
+
+    cuFP_t plm = pmm;
+    if (l>m)
+      plm =
+	sqrt((2.0*l - 1)*(2*l + 1)/((l-m)*(l+m)))*x*p1 -
+	sqrt((2.0*l + 1)*(l+m-1)*(l-m-1)/((l-m)*(l+m)*(2*l-3)))*p2;
+
+    p2 = p1;
+    p1 = plm;
+
+    if (L._v[l]) {
+      cuFP_t fac = norm * plm * p0;
+      for (int n=0; n<nmax; n++) {
+	int k = 1 + l*nmax + n;
+	cuFP_t f = a*eofFetchCyl(tex._v[k], ind) + b*eofFetchCyl(tex._v[k], ind+1);
+	V._v[size_t(col*nmax + n)*N + i] = fac * f;
+      }
+      col++;
+    }
+  }
+}
+
+// Mass and count of the used particles from their weights
+//
+struct eofSquare
+{
+  __host__ __device__ double operator()(cuFP_t w) const { return w*w; }
+};
+
+struct eofUsed
+{
+  __host__ __device__ bool operator()(cuFP_t w) const { return w>0.0; }
+};
+
+void Cylinder::determine_eof_cuda(EmpCylSL* basis, int mlevel, bool all)
+{
+  if (not cuEOF) cuEOF = std::make_shared<cudaEOF>();
+
+  auto & e = *cuEOF;
+  auto cs  = component->cuStream;
+
+  const int nblk = 4*(mmax+1);
+
+  // Start of a pass: spherical basis textures and zero covariance
+  //
+  if (e.basis != basis) {
+    e.release();
+
+    auto sl = basis->setup_eof_cuda();
+    sl->initialize_cuda(e.arr, e.tex);
+    e.t_d = e.tex;
+    e.sl  = sl->getCudaMappingConstants();
+
+    e.S .resize(nblk);
+    e.F .resize(nblk);
+    e.nL.resize(nblk);
+
+    for (int m=0; m<=mmax; m++) {
+      for (int k=0; k<4; k++) {
+	auto L = basis->eof_block(m, k);
+	int  n = nmaxfid*L.size(), j = 4*m + k;
+
+	thrust::host_vector<int> f(lmaxfid+1, 0);
+	for (auto l : L) f[l] = 1;
+
+	e.F[j]  = f;
+	e.nL[j] = L.size();
+	e.S[j].resize(n*n);
+	thrust::fill(e.S[j].begin(), e.S[j].end(), 0.0);
+      }
+    }
+
+    e.basis = basis;
+  }
+
+  // Set component center and orientation
+  //
+  std::vector<cuFP_t> ctr;
+  for (auto v : component->getCenter(Component::Local | Component::Centered)) ctr.push_back(v);
+
+  cuda_safe_call(cudaMemcpyToSymbol(cylCen, &ctr[0], sizeof(cuFP_t)*3, size_t(0), cudaMemcpyHostToDevice),
+		 __FILE__, __LINE__, "Error copying cylCen");
+
+  bool orient = (component->EJ & Orient::AXIS) && !component->EJdryrun;
+
+  int tmp = orient ? 1 : 0;
+  cuda_safe_call(cudaMemcpyToSymbol(cylOrient, &tmp, sizeof(int), size_t(0), cudaMemcpyHostToDevice),
+		 __FILE__, __LINE__, "Error copying cylOrient");
+
+  if (orient) {
+    std::vector<cuFP_t> trans(9);
+    for (int i=0; i<3; i++)
+      for (int j=0; j<3; j++) trans[i*3+j] = component->orient->transformBody()(i, j);
+
+    cuda_safe_call(cudaMemcpyToSymbol(cylBody, &trans[0], sizeof(cuFP_t)*9, size_t(0), cudaMemcpyHostToDevice),
+		   __FILE__, __LINE__, "Error copying cylBody");
+  }
+
+  cudaDeviceProp deviceProp;
+  cudaGetDeviceProperties(&deviceProp, component->cudaDevice);
+  cuda_check_last_error_mpi("cudaGetDeviceProperties", __FILE__, __LINE__, myid);
+
+  cublasSetStream(e.handle, cs->stream);
+
+  // Particle range, the radius of the grid and the spherical basis
+  // normalization
+  //
+  PII lohi = {0, cs->cuda_particles.size()}, cur;
+  if (not all) lohi = component->CudaGetLevelRange(mlevel, mlevel);
+
+  cuFP_t rmax = std::min<double>(rcylmax*acyl,
+				 basis->get_ascale()*basis->get_rtable());
+  cuFP_t pfac = 1.0/sqrt(basis->get_ascale());
+
+  // Bunches sized so that the basis vectors take at most 2^24 values
+  //
+  unsigned int bunch = std::max<unsigned int>
+    (BLOCK_SIZE, (1u<<24)/(nmaxfid*(lmaxfid+1)));
+
+  const double one = 1.0;
+  double mass = 0.0;
+  int    used = 0;
+
+  for (cur.first=lohi.first; cur.first<lohi.second; cur.first+=bunch) {
+
+    cur.second = std::min<unsigned int>(cur.first + bunch, lohi.second);
+
+    unsigned int N        = cur.second - cur.first;
+    unsigned int stride   = N/BLOCK_SIZE/deviceProp.maxGridSize[0] + 1;
+    unsigned int gridSize = N/BLOCK_SIZE/stride;
+
+    if (N > gridSize*BLOCK_SIZE*stride) gridSize++;
+
+    if (e.W.size() < N) {
+      e.W  .resize(N);
+      e.X  .resize(N);
+      e.Phi.resize(N);
+      e.A  .resize(N);
+      e.Ind.resize(N);
+      e.V  .resize(size_t(N)*nmaxfid*(lmaxfid+1));
+    }
+
+    eofCoordKernelCyl<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
+      (toKernel(cs->cuda_particles), toKernel(cs->indx1),
+       toKernel(e.W), toKernel(e.X), toKernel(e.Phi),
+       toKernel(e.A), toKernel(e.Ind), stride, cur, rmax,
+       basis->get_ascale(), e.sl);
+
+    // One rank-N update per covariance block
+    //
+    unsigned int nthr = (N + BLOCK_SIZE - 1)/BLOCK_SIZE;
+
+    for (int m=0; m<=mmax; m++) {
+      for (int k=0; k<4; k++) {
+	int j = 4*m + k, n = nmaxfid*e.nL[j];
+	if (n==0) continue;
+
+	eofVecKernelCyl<<<nthr, BLOCK_SIZE, 0, cs->stream>>>
+	  (toKernel(e.V), toKernel(e.W), toKernel(e.X), toKernel(e.Phi),
+	   toKernel(e.A), toKernel(e.Ind), toKernel(e.t_d), toKernel(e.F[j]),
+	   m, k>1, lmaxfid, nmaxfid, pfac, N);
+
+	cublasStatus_t ret =
+	  cublasDsyrk(e.handle, CUBLAS_FILL_MODE_UPPER, CUBLAS_OP_T, n, N,
+		      &one, thrust::raw_pointer_cast(e.V.data()), N,
+		      &one, thrust::raw_pointer_cast(e.S[j].data()), n);
+
+	if (ret != CUBLAS_STATUS_SUCCESS) {
+	  std::ostringstream sout;
+	  sout << "Cylinder::determine_eof_cuda: cublasDsyrk failed with status "
+	       << ret;
+	  throw std::runtime_error(sout.str());
+	}
+      }
+    }
+
+    // Counts for the caller's diagnostics
+    //
+    if (all) {
+      auto beg = e.W.begin(), end = e.W.begin() + N;
+      mass += thrust::transform_reduce(beg, end, eofSquare(), 0.0,
+				       thrust::plus<double>());
+      used += thrust::count_if(beg, end, eofUsed());
+    }
+  }
+
+  if (all) {
+    use[0]      += used;
+    cylmass0[0] += mass;
+  }
+}
+
+void Cylinder::flush_eof_cuda()
+{
+  if (not cuEOF or not cuEOF->basis) return;
+
+  auto & e = *cuEOF;
+
+  for (int m=0; m<=mmax; m++) {
+    for (int k=0; k<4; k++) {
+      auto & S = e.S[4*m + k];
+      if (S.size()==0) continue;
+      thrust::host_vector<double> h = S;
+      e.basis->add_eof_block(m, k, h.data());
+    }
+  }
+
+  e.release();
+}
@@ -1,6 +1,7 @@
 // -*- C++ -*-
 
 #include <EmpCylSL.H>
+#include <exputils.H>
 
 #include <iostream>
 #include <iomanip>
@@ -251,3 +252,50 @@ cudaMappingConstants EmpCylSL::getCudaMappingConstants()
 
   return ret;
 }
+
+EmpCylSL::SLGridSphPtr EmpCylSL::setup_eof_cuda()
+{
+  if (not ortho) {
+    ortho = std::make_shared<SLGridSph>
+      (make_sl(), LMAX, NMAX, NUMR, RMIN, RMAX*0.99, false, 1, 1.0);
+
+    orthoTest(ortho->orthoCheck(std::max<int>(NMAX*50, 200)), "EmpCylSL[SLGridSph]", "l");
+  }
+
+  if (eof_made or (SC.size()==0 and SCe.size()==0)) setup_eof();
+
+  return ortho;
+}
+
+std::vector<int> EmpCylSL::eof_block(int m, int k)
+{
+  if (m>MMAX or (m==0 and k>1)) return {};
+
+  if (EvenOdd) return k % 2 ? lO[m] : lE[m];
+
+  if (k % 2) return {};
+  return lA[m];
+}
+
+void EmpCylSL::add_eof_block(int m, int k, const double* S)
+{
+  std::vector<std::vector<double>>* T = 0;
+
+  if (EvenOdd) {
+    switch (k) {
+    case 0: T = &SCe[0][m]; break;
+    case 1: T = &SCo[0][m]; break;
+    case 2: T = &SSe[0][m]; break;
+    case 3: T = &SSo[0][m]; break;
+    }
+  } else {
+    if (k==0) T = &SC[0][m];
+    if (k==2) T = &SS[0][m];
+  }
+
+  if (T==0) return;
+
+  const int n = T->size();
+  for (int j=0; j<n; j++)
+    for (int i=0; i<=j; i++) (*T)[i][j] += S[i + j*n];
+}
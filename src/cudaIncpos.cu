@@ -29,6 +29,33 @@ __global__ void coordDrift
   }
 }
 
+__global__ void kickDrift
+(dArray<cudaParticle> P, dArray<int> I, cuFP_t dtk, cuFP_t dt, int dim,
+ int stride, PII lohi)
+{
+  // Thread ID
+  //
+  const int tid = blockDim.x * blockIdx.x + threadIdx.x;
+
+  for (int n=0; n<stride; n++) {
+    int i     = tid*stride + n;	// Particle counter
+    int npart = i + lohi.first;	// Particle index
+
+    if (npart < lohi.second) {
+
+#ifdef BOUNDS_CHECK
+      if (npart>=P._s) printf("out of bounds: %s:%d\n", __FILE__, __LINE__);
+#endif
+      cudaParticle & p = P._v[I._v[npart]];
+    
+      for (int k=0; k<dim; k++) {
+	p.vel[k] += p.acc[k]*dtk;
+	p.pos[k] += p.vel[k]*dt;
+      }
+    }
+  }
+}
+
 __global__ void positionDebug
 (dArray<cudaParticle> P, dArray<int> I, int stride, PII lohi)
 {
@@ -120,7 +147,54 @@ void incr_position_cuda(cuFP_t dt, int mlevel)
     }
     // END: DEBUG
 
-    if (not leapfrog_cuda) c->CudaToParticles();
+    // The host copy is now stale; fetch it here only when the host
+    // particles are authoritative
+    //
+    c->CudaInvalidate(Component::cudaPos);
+    if (not leapfrog_cuda and not cuda_resident) c->CudaToParticles();
+  }
+  // END: component loop
+}
+
+
+void incr_kick_drift_cuda(cuFP_t dtk, cuFP_t dtd, int mlevel)
+{
+  for (auto c : comp->components) {
+
+    auto cr = c->cuStream;
+
+    PII lohi = {0, cr->cuda_particles.size()};
+
+    if (multistep) {		// Get particle range
+      lohi = c->CudaGetLevelRange(mlevel, mlevel);
+    }
+
+    cudaDeviceProp deviceProp;
+    cudaGetDeviceProperties(&deviceProp, c->cudaDevice);
+    cuda_check_last_error_mpi("cudaGetDeviceProperties", __FILE__, __LINE__, myid);
+
+    // Compute grid
+    //
+    unsigned int N         = lohi.second - lohi.first;
+    unsigned int stride    = N/BLOCK_SIZE/deviceProp.maxGridSize[0] + 1;
+    unsigned int gridSize  = N/BLOCK_SIZE/stride;
+    
+    if (N>0) {
+      
+      if (N > gridSize*BLOCK_SIZE*stride) gridSize++;
+
+      // Do the work
+      //
+      kickDrift<<<gridSize, BLOCK_SIZE>>>
+	(toKernel(cr->cuda_particles),
+	 toKernel(cr->indx1), dtk, dtd, c->dim, stride, lohi);
+    }
+
+    // The host copy is now stale; fetch it here only when the host
+    // particles are authoritative
+    //
+    c->CudaInvalidate(Component::cudaPos | Component::cudaVel);
+    if (not leapfrog_cuda and not cuda_resident) c->CudaToParticles();
   }
   // END: component loop
 }
@@ -128,7 +128,11 @@ void incr_velocity_cuda(cuFP_t dt, int mlevel)
     }
     // END: DEBUG
 
-    if (not leapfrog_cuda) c->CudaToParticles();
+    // The host copy is now stale; fetch it here only when the host
+    // particles are authoritative
+    //
+    c->CudaInvalidate(Component::cudaVel);
+    if (not leapfrog_cuda and not cuda_resident) c->CudaToParticles();
   }
   // END: component loop
 }
@@ -363,7 +363,7 @@ void cuda_compute_levels()
   //
   for (auto c : comp->components) {
     c->force->multistep_update_begin();
-    if (not c->force->cudaAware()) c->ParticlesToCuda();
+    if (not c->force->cudaAware() and not cuda_resident) c->ParticlesToCuda();
   }
 
   std::map<Component*, unsigned> offlo, offhi;
@@ -649,6 +649,10 @@ void cuda_compute_levels()
 
     c->fix_positions_cuda();
 
+    // Levels were assigned on the device
+    //
+    c->CudaInvalidate(Component::cudaLev | Component::cudaDtreq);
+
 #ifdef VERBOSE_TIMING
     finish = std::chrono::high_resolution_clock::now();
     duration = finish - start;
@@ -1,12 +1,17 @@
 // -*- C++ -*-
 
+#include <exception>
+#include <thread>
 #include <tuple>
 #include <list>
+#include <mutex>
 
 #include <Component.H>
 #include <SphericalBasis.H>
 #include <cudaReduce.cuH>
 
+#include <thrust/gather.h>
+
 // Define for debugging
 //
 // #define OFF_GRID_ALERT
@@ -392,8 +397,10 @@ __global__ void coefKernel
 #endif
 		      ) * p0 * plm[Ilm(l, m)] * fac0 * norm;
 	  
-	  coef._v[(2*n+0)*N + i] = v * cosp * mass;
-	  coef._v[(2*n+1)*N + i] = v * sinp * mass;
+	  if (coef._s>0) {
+	    coef._v[(2*n+0)*N + i] = v * cosp * mass;
+	    coef._v[(2*n+1)*N + i] = v * sinp * mass;
+	  }
 
 	  // Load work space
 	  //
@@ -428,9 +435,11 @@ __global__ void coefKernel
 	}
       } else {
 	// No contribution from off-grid particles
-	for (int n=0; n<nmax; n++) {
-	  coef._v[(2*n+0)*N + i] = 0.0;
-	  coef._v[(2*n+1)*N + i] = 0.0;
+	if (coef._s>0) {
+	  for (int n=0; n<nmax; n++) {
+	    coef._v[(2*n+0)*N + i] = 0.0;
+	    coef._v[(2*n+1)*N + i] = 0.0;
+	  }
 	}
 
 	if (compute and tvar._s>0) {
@@ -458,6 +467,78 @@ __global__ void coefKernel
 
 }
 
+// Fused accumulate-and-reduce version of coefKernel: each block
+// sums its particles' contributions to the (l, m) coefficients in
+// registers and writes one partial per block and coefficient to
+// out[j*gridDim.x + blockIdx.x].  Scratch is 2*nmax*gridDim.x rather
+// than 2*nmax*N.
+//
+__global__ void coefReduceKernel
+(dArray<cuFP_t> out, dArray<cuFP_t> used, dArray<cudaTextureObject_t> tex,
+ dArray<cuFP_t> Mass, dArray<cuFP_t> Afac, dArray<cuFP_t> Phi,
+ dArray<cuFP_t> Plm,  dArray<int> Indx,  int stride, 
+ int l, int m, unsigned Lmax, unsigned int nmax, cuFP_t norm,
+ PII lohi)
+{
+  __shared__ typename cub::BlockReduce<cuFP_t, BLOCK_SIZE>::TempStorage tmp;
+
+  const int tid   = blockDim.x * blockIdx.x + threadIdx.x;
+  const int psiz  = (Lmax+1)*(Lmax+2)/2;
+
+  const cuFP_t fac0 = -4.0*M_PI;
+
+  for (int n=0; n<nmax; n++) {
+
+    cuFP_t sumC = 0.0, sumS = 0.0;
+
+    for (int str=0; str<stride; str++) {
+
+      int i     = tid*stride + str;
+      int npart = i + lohi.first;
+
+      if (npart < lohi.second) {
+
+	cuFP_t mass = Mass._v[i];
+
+	if (mass>0.0) {
+				// For accumulating mass of used particles
+	  if (n==0 and l==0 and m==0) used._v[i] = mass;
+
+	  cuFP_t phi = Phi._v[i];
+	  cuFP_t a   = Afac._v[i];
+	  cuFP_t b   = 1.0 - a;
+	  int  ind   = Indx._v[i];
+	  int    k   = 1 + l*nmax + n;
+
+	  cuFP_t p0 =
+#if cuREAL == 4
+	    a*tex1D<float>(tex._v[0], ind  ) +
+	    b*tex1D<float>(tex._v[0], ind+1) ;
+#else
+	    a*int2_as_double(tex1D<int2>(tex._v[0], ind  )) +
+	    b*int2_as_double(tex1D<int2>(tex._v[0], ind+1)) ;
+#endif
+	  cuFP_t v = (
+#if cuREAL == 4
+		     a*tex1D<float>(tex._v[k], ind  ) +
+		     b*tex1D<float>(tex._v[k], ind+1)
+#else
+		     a*int2_as_double(tex1D<int2>(tex._v[k], ind  )) +
+		     b*int2_as_double(tex1D<int2>(tex._v[k], ind+1))
+#endif
+		      ) * p0 * Plm._v[psiz*i + Ilm(l, m)] * fac0 * norm * mass;
+
+	  sumC += v * cos(phi*m);
+	  sumS += v * sin(phi*m);
+	}
+      }
+    }
+
+    blockSumStore<cuFP_t, BLOCK_SIZE>(out, sumC, 2*n+0, tmp);
+    blockSumStore<cuFP_t, BLOCK_SIZE>(out, sumS, 2*n+1, tmp);
+  }
+}
+
 __global__ void
 forceKernel(dArray<cudaParticle> P, dArray<int> I, dArray<cuFP_t> coef,
 	    dArray<cudaTextureObject_t> tex, dArray<cuFP_t> L1, dArray<cuFP_t> L2,
@@ -787,9 +868,6 @@ void SphericalBasis::cudaStorage::resize_coefs
   // Create space for coefficient reduction to prevent continued
   // dynamic allocation
   //
-  if (dN_coef.capacity() < 2*nmax*N)
-    dN_coef.reserve(2*nmax*N);
-  
   if (dc_coef.capacity() < 2*nmax*gridSize)
     dc_coef.reserve(2*nmax*gridSize);
   
@@ -831,7 +909,6 @@ void SphericalBasis::cudaStorage::resize_coefs
 
   // Set needed space for current step
   //
-  dN_coef.resize(2*nmax*N);
   dc_coef.resize(2*nmax*gridSize);
 
   // This will stay fixed for the entire run
@@ -915,13 +992,173 @@ void SphericalBasis::cudaStorage::resize_acc(int Lmax, int Nthread)
 }
 
 
+void SphericalBasis::initialize_peers()
+{
+  for (size_t k=1; k<cudaGlobalDevices.size(); k++) {
+    auto p = std::make_shared<cudaPeer>();
+    p->device = cudaGlobalDevices[k];
+    p->used   = 0;
+
+    cuda_safe_call(cudaSetDevice(p->device), __FILE__, __LINE__,
+		   "cudaSetDevice failure for peer");
+    cuda_safe_call(cudaStreamCreate(&p->stream), __FILE__, __LINE__,
+		   "cudaStreamCreate failure for peer");
+
+    // Build the texture tables on this device through the members
+    // filled by initialize_cuda()
+    //
+    std::swap(tex, p->tex);
+    std::swap(cuInterpArray, p->cuArray);
+    initialize_cuda();
+    std::swap(tex, p->tex);
+    std::swap(cuInterpArray, p->cuArray);
+
+    p->t_d = p->tex;
+
+    cuPeers.push_back(p);
+  }
+
+  cuda_safe_call(cudaSetDevice(component->cudaDevice), __FILE__, __LINE__,
+		 "cudaSetDevice failure");
+}
+
+void SphericalBasis::peer_coefficients(cudaPeer& p, const std::vector<cuFP_t>& ctr)
+{
+  // The device selection belongs to the calling host thread
+  //
+  cuda_safe_call(cudaSetDevice(p.device), __FILE__, __LINE__,
+		 "cudaSetDevice failure for peer");
+
+  initialize_mapping_constants();
+
+  cuda_safe_call(cudaMemcpyToSymbol(sphCen, &ctr[0], sizeof(cuFP_t)*3,
+				    size_t(0), cudaMemcpyHostToDevice),
+		 __FILE__, __LINE__, "Error copying sphCen");
+
+  unsigned int Ntotal = p.staging.size();
+
+  p.particles.resize(Ntotal);
+  p.indx.resize(Ntotal);
+  thrust::sequence(thrust::cuda::par.on(p.stream), p.indx.begin(), p.indx.end());
+
+  cuda_safe_call(cudaMemcpyPeerAsync(thrust::raw_pointer_cast(p.particles.data()),
+				     p.device,
+				     thrust::raw_pointer_cast(p.staging.data()),
+				     component->cudaDevice,
+				     Ntotal*sizeof(cudaParticle), p.stream),
+		 __FILE__, __LINE__, "cudaMemcpyPeerAsync failure");
+
+  p.cuS.df_coef.resize((Lmax+1)*(Lmax+2)*nmax);
+  thrust::fill(thrust::cuda::par.on(p.stream),
+	       p.cuS.df_coef.begin(), p.cuS.df_coef.end(), 0.0);
+  p.used = 0;
+
+  cudaDeviceProp deviceProp;
+  cudaGetDeviceProperties(&deviceProp, p.device);
+
+  int osize    = nmax*2;
+
+  unsigned int Npacks = Ntotal/component->bunchSize + 1;
+
+  // Same bunch loop as determine_coefficients_cuda without the PCA
+  // accumulation
+  //
+  for (int n=0; n<Npacks; n++) {
+
+    PII cur;
+    cur. first = component->bunchSize*n;
+    cur.second = std::min<unsigned int>(component->bunchSize*(n+1), Ntotal);
+
+    if (cur.second <= cur.first) break;
+
+    unsigned int N         = cur.second - cur.first;
+    unsigned int stride    = N/BLOCK_SIZE/deviceProp.maxGridSize[0] + 1;
+    unsigned int gridSize  = N/BLOCK_SIZE/stride;
+
+    if (N > gridSize*BLOCK_SIZE*stride) gridSize++;
+
+    p.cuS.resize_coefs(nmax, Lmax, N, gridSize, stride,
+		       sampT, false, false, subsamp);
+
+    coordKernel<<<gridSize, BLOCK_SIZE, 0, p.stream>>>
+      (toKernel(p.particles), toKernel(p.indx),
+       toKernel(p.cuS.m_d), toKernel(p.cuS.a_d), toKernel(p.cuS.p_d),
+       toKernel(p.cuS.plm1_d), toKernel(p.cuS.i_d),
+       Lmax, stride, cur, rmax);
+
+    auto beg = p.cuS.df_coef.begin();
+    thrust::fill(thrust::cuda::par.on(p.stream),
+		 p.cuS.u_d.begin(), p.cuS.u_d.end(), 0.0);
+
+    for (int l=0; l<=Lmax; l++) {
+      for (int m=0; m<=l; m++) {
+	cuFP_t ft = factorial(l, m);
+
+	coefReduceKernel<<<gridSize, BLOCK_SIZE, 0, p.stream>>>
+	  (toKernel(p.cuS.dc_coef), toKernel(p.cuS.u_d), toKernel(p.t_d),
+	   toKernel(p.cuS.m_d), toKernel(p.cuS.a_d), toKernel(p.cuS.p_d),
+	   toKernel(p.cuS.plm1_d), toKernel(p.cuS.i_d),
+	   stride, l, m, Lmax, nmax, ft, cur);
+
+	thrust::counting_iterator<int> index_begin(0);
+	thrust::counting_iterator<int> index_end(gridSize*osize);
+
+	thrust::reduce_by_key
+	  (
+	   thrust::cuda::par.on(p.stream),
+	   thrust::make_transform_iterator(index_begin, key_functor(gridSize)),
+	   thrust::make_transform_iterator(index_end,   key_functor(gridSize)),
+	   p.cuS.dc_coef.begin(), thrust::make_discard_iterator(), p.cuS.dw_coef.begin()
+	   );
+
+	thrust::transform(thrust::cuda::par.on(p.stream),
+			  p.cuS.dw_coef.begin(), p.cuS.dw_coef.end(),
+			  beg, beg, thrust::plus<cuFP_t>());
+
+	thrust::advance(beg, osize);
+      }
+    }
+
+    // Number of particles used
+    //
+    thrust::sort(thrust::cuda::par.on(p.stream), p.cuS.m_d.begin(), p.cuS.m_d.end());
+    cudaStreamSynchronize(p.stream);
+    auto it = thrust::lower_bound(p.cuS.m_d.begin(), p.cuS.m_d.end(), 0.0);
+    p.used += thrust::distance(it, p.cuS.m_d.end());
+  }
+
+  cudaStreamSynchronize(p.stream);
+  cuda_check_last_error_mpi("cudaStreamSynchronize", __FILE__, __LINE__, myid);
+}
+
+void SphericalBasis::destroy_peers()
+{
+  for (auto & p : cuPeers) {
+    cudaSetDevice(p->device);
+    for (auto t : p->tex)     cudaDestroyTextureObject(t);
+    for (auto a : p->cuArray) cudaFreeArray(a);
+    cudaStreamDestroy(p->stream);
+  }
+
+  if (cuPeers.size()) cudaSetDevice(component->cudaDevice);
+  cuPeers.clear();
+}
+
+// The mapping and center constants are shared by every instance, so
+// concurrent passes from launch_coefficients() take turns
+//
+static std::mutex sphConstLock;
+
 void SphericalBasis::determine_coefficients_cuda(bool compute)
 {
+  std::lock_guard<std::mutex> guard(sphConstLock);
+
   // Only do this once but copying mapping coefficients and textures
   // must be done every time
   //
   if (initialize_cuda_sph) {
     initialize_cuda();
+    initialize_peers();
     initialize_cuda_sph = false;
   }
 
@@ -989,6 +1226,45 @@ void SphericalBasis::determine_coefficients_cuda(bool compute)
   //
   PII lohi = component->CudaGetLevelRange(mlevel, mlevel), cur;
   
+  // Hand equal shares from the top of the level range to the other
+  // devices of this process.  The PCA accumulation is done on the
+  // first device only.
+  //
+  std::vector<std::thread> peerThreads;
+  std::vector<std::exception_ptr> peerErrors(cuPeers.size());
+
+  if (cuPeers.size() and not (compute and (pcavar or pcaeof))) {
+
+    unsigned int Nshare = (lohi.second - lohi.first)/(cuPeers.size() + 1);
+
+    if (Nshare > 0) {
+      for (size_t k=0; k<cuPeers.size(); k++) {
+	auto & p   = *cuPeers[k];
+	auto last  = cr->indx1.begin() + lohi.second - Nshare*k;
+	auto first = last - Nshare;
+
+	p.staging.resize(Nshare);
+	thrust::gather(thrust::cuda::par.on(cr->stream), first, last,
+		       cr->cuda_particles.begin(), p.staging.begin());
+      }
+      cudaStreamSynchronize(cr->stream);
+
+      for (size_t k=0; k<cuPeers.size(); k++) {
+	peerThreads.push_back
+	  (std::thread([&, k]() {
+	    try {
+	      peer_coefficients(*cuPeers[k], ctr);
+	    }
+	    catch (...) {
+	      peerErrors[k] = std::current_exception();
+	    }
+	  }));
+      }
+
+      lohi.second -= Nshare*cuPeers.size();
+    }
+  }
+
   unsigned int Ntotal = lohi.second - lohi.first;
   unsigned int Npacks = Ntotal/component->bunchSize + 1;
 
@@ -1067,35 +1343,39 @@ void SphericalBasis::determine_coefficients_cuda(bool compute)
       for (int m=0; m<=l; m++) {
 	cuFP_t ft = factorial(l, m);
 
-	// Compute the contribution to the coefficients from each
-	// particle
+	// Accumulate and reduce the contribution to the coefficients
+	// per grid block
 	//
-	coefKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
-	  (toKernel(cuS.dN_coef), toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
-	   toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d),
-	   toKernel(cuS.a_d), toKernel(cuS.p_d), toKernel(cuS.plm1_d),
-	   toKernel(cuS.i_d), stride, l, m, Lmax, nmax, ft, cur, compute);
+	coefReduceKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
+	  (toKernel(cuS.dc_coef), toKernel(cuS.u_d), toKernel(t_d),
+	   toKernel(cuS.m_d), toKernel(cuS.a_d), toKernel(cuS.p_d),
+	   toKernel(cuS.plm1_d), toKernel(cuS.i_d),
+	   stride, l, m, Lmax, nmax, ft, cur);
 	
-	// Begin the reduction per grid block [perhaps this should use
-	// a stride?]
+	// The PCA accumulators still need the per-particle values;
+	// dN_coef is empty so only the tvar arrays are written
 	//
+	if (compute and (pcavar or pcaeof)) {
+	  coefKernel<<<gridSize, BLOCK_SIZE, 0, cr->stream>>>
+	    (toKernel(cuS.dN_coef), toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
+	     toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d),
+	     toKernel(cuS.a_d), toKernel(cuS.p_d), toKernel(cuS.plm1_d),
+	     toKernel(cuS.i_d), stride, l, m, Lmax, nmax, ft, cur, compute);
+	}
+
 	unsigned int gridSize1 = N/BLOCK_SIZE;
 	if (N > gridSize1*BLOCK_SIZE) gridSize1++;
 
-	reduceSum<cuFP_t, BLOCK_SIZE>
-	  <<<gridSize1, BLOCK_SIZE, sMemSize, cr->stream>>>
-	  (toKernel(cuS.dc_coef), toKernel(cuS.dN_coef), osize, N);
-      
 	// Finish the reduction for this order in parallel
 	//
 	thrust::counting_iterator<int> index_begin(0);
-	thrust::counting_iterator<int> index_end(gridSize1*osize);
+	thrust::counting_iterator<int> index_end(gridSize*osize);
 
 	thrust::reduce_by_key
 	  (
 	   thrust::cuda::par.on(cr->stream),
-	   thrust::make_transform_iterator(index_begin, key_functor(gridSize1)),
-	   thrust::make_transform_iterator(index_end,   key_functor(gridSize1)),
+	   thrust::make_transform_iterator(index_begin, key_functor(gridSize)),
+	   thrust::make_transform_iterator(index_end,   key_functor(gridSize)),
 	   cuS.dc_coef.begin(), thrust::make_discard_iterator(), cuS.dw_coef.begin()
 	   );
 
@@ -1270,6 +1550,42 @@ void SphericalBasis::determine_coefficients_cuda(bool compute)
     use[0] += thrust::distance(it, cuS.m_d.end());
   }
 
+  // Sum the peer partials on the first device ahead of the single
+  // copy to the host
+  //
+  for (auto & t : peerThreads) t.join();
+
+  for (size_t k=0; k<peerThreads.size(); k++) {
+    if (peerErrors[k]) std::rethrow_exception(peerErrors[k]);
+
+    auto & p = *cuPeers[k];
+    thrust::device_vector<cuFP_t> part(p.cuS.df_coef.size());
+
+    cuda_safe_call(cudaMemcpyPeer(thrust::raw_pointer_cast(part.data()),
+				  component->cudaDevice,
+				  thrust::raw_pointer_cast(p.cuS.df_coef.data()),
+				  p.device, part.size()*sizeof(cuFP_t)),
+		   __FILE__, __LINE__, "cudaMemcpyPeer failure");
+
+    thrust::transform(thrust::cuda::par.on(cr->stream),
+		      part.begin(), part.end(),
+		      cuS.df_coef.begin(), cuS.df_coef.begin(),
+		      thrust::plus<cuFP_t>());
+
+    use[0] += p.used;
+  }
+
+  // With a CUDA-aware MPI, the sums stay on the device for
+  // post_device_reduction().  finish_coefficients() completes it and
+  // loads the host.
+  //
+  if (cuda_mpi) {
+    cudaStreamSynchronize(cr->stream);
+    cuda_check_last_error_mpi("cudaStreamSynchronize", __FILE__, __LINE__, myid);
+    dev_pending = true;
+    return;
+  }
+
   // Copy back coefficient data from device and load the host
   //
   thrust::host_vector<cuFP_t> ret = cuS.df_coef;
@@ -1297,6 +1613,7 @@ void SphericalBasis::determine_acceleration_cuda()
   //
   if (initialize_cuda_sph) {
     initialize_cuda();
+    initialize_peers();
     initialize_cuda_sph = false;
   }
 
@@ -1404,6 +1721,81 @@ void SphericalBasis::HtoD_coefs(const std::vector<VectorP>& expcoef)
 }
 
 
+void SphericalBasis::post_device_reduction()
+{
+  MPI_Iallreduce(MPI_IN_PLACE, thrust::raw_pointer_cast(cuS.df_coef.data()),
+		 cuS.df_coef.size(), cuMPI_FP, MPI_SUM, MPI_COMM_WORLD,
+		 &coef_req);
+}
+
+void SphericalBasis::launch_coefficients()
+{
+  cuda_safe_call(cudaSetDevice(component->cudaDevice), __FILE__, __LINE__,
+		 "cudaSetDevice failure");
+
+  // Keep the count from the pass apart from the host accumulators
+  //
+  int use0 = use[0];
+  use[0] = 0;
+  determine_coefficients_cuda(false);
+  launched_use = use[0];
+  use[0] = use0;
+
+  launched = true;
+}
+
+void SphericalBasis::DtoH_reduced(std::vector<double>& buf)
+{
+  dev_pending = false;
+
+  buf.resize((Lmax+1)*(Lmax+1)*nmax);
+
+  // The accumulation buffer holds interleaved cosine and sine terms
+  // for each (l, m) pair
+  //
+  thrust::host_vector<cuFP_t> ret = cuS.df_coef;
+
+  int offst = 0;
+  for (int l=0, loffset=0; l<=Lmax; loffset+=(2*l+1), l++) {
+    for (int m=0, moffset=0; m<=l; m++) {
+      for (int n=0; n<nmax; n++) {
+	buf[(loffset+moffset)*nmax + n] = ret[2*n+offst];
+	if (m>0) buf[(loffset+moffset+1)*nmax + n] = ret[2*n+1+offst];
+      }
+      offst += 2*nmax;
+
+      if (m>0) moffset += 2;
+      else     moffset += 1;
+    }
+  }
+
+  // Multistep combination, PCA and noise all change the coefficients
+  // on the host, so they must be copied again before the force
+  //
+  if (multistep or play_back or NOISE or pcavar or pcaeof) return;
+
+  if (dev_perm.size()==0) {
+    thrust::host_vector<int> perm((Lmax+1)*(Lmax+1)*nmax);
+    int offst = 0;
+    for (int l=0; l<=Lmax; l++) {
+      for (int m=0; m<=l; m++) {
+	for (int n=0; n<nmax; n++) {
+	  perm[Ilmn(l, m, 'c', n, nmax)] = 2*n+offst;
+	  if (m>0) perm[Ilmn(l, m, 's', n, nmax)] = 2*n+1+offst;
+	}
+	offst += 2*nmax;
+      }
+    }
+    dev_perm = perm;
+  }
+
+  dev_coefs.resize(dev_perm.size());
+  thrust::gather(dev_perm.begin(), dev_perm.end(),
+		 cuS.df_coef.begin(), dev_coefs.begin());
+
+  dev_current = true;
+}
+
 void SphericalBasis::DtoH_coefs(std::vector<VectorP>& expcoef)
 {
   // l loop
@@ -2000,10 +2392,6 @@ void SphericalBasis::multistep_update_cuda()
 	cuS.resize_coefs(nmax, Lmax, N, gridSize, stride,
 			 sampT, pcavar, pcaeof, subsamp);
 	
-	// Shared memory size for the reduction
-	//
-	int sMemSize = BLOCK_SIZE * sizeof(cuFP_t);
-	
 	// Compute the coordinate transformation
 	// 
 #ifdef VERBOSE_TIMING
@@ -2037,12 +2425,11 @@ void SphericalBasis::multistep_update_cuda()
 #ifdef VERBOSE_TIMING
 	    start = std::chrono::high_resolution_clock::now();
 #endif
-	    coefKernel<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
-	      (toKernel(cuS.dN_coef),
-	       toKernel(cuS.dN_tvar), toKernel(cuS.dW_tvar),
-	       toKernel(cuS.u_d), toKernel(t_d), toKernel(cuS.m_d),
-	       toKernel(cuS.a_d), toKernel(cuS.p_d), toKernel(cuS.plm1_d),
-	       toKernel(cuS.i_d), stride, l, m, Lmax, nmax, ft, cur, false);
+	    coefReduceKernel<<<gridSize, BLOCK_SIZE, 0, cs->stream>>>
+	      (toKernel(cuS.dc_coef), toKernel(cuS.u_d), toKernel(t_d),
+	       toKernel(cuS.m_d), toKernel(cuS.a_d), toKernel(cuS.p_d),
+	       toKernel(cuS.plm1_d), toKernel(cuS.i_d),
+	       stride, l, m, Lmax, nmax, ft, cur);
 
 #ifdef VERBOSE_TIMING
 	    finish = std::chrono::high_resolution_clock::now();
@@ -2050,27 +2437,17 @@ void SphericalBasis::multistep_update_cuda()
 	    coefs += duration.count()*1.0e-6;
 	    start = std::chrono::high_resolution_clock::now();
 #endif	  
-	    // Begin the reduction per grid block
-	    // [perhaps this should use a stride?]
-	    //
-	    unsigned int gridSize1 = N/BLOCK_SIZE;
-	    if (N > gridSize1*BLOCK_SIZE) gridSize1++;
-
-	    reduceSum<cuFP_t, BLOCK_SIZE>
-	      <<<gridSize1, BLOCK_SIZE, sMemSize, cs->stream>>>
-	      (toKernel(cuS.dc_coef), toKernel(cuS.dN_coef), osize, N);
-	    
 	    // Finish the reduction for this order
 	    // in parallel
 	    //
 	    thrust::counting_iterator<int> index_begin(0);
-	    thrust::counting_iterator<int> index_end(gridSize1*osize);
+	    thrust::counting_iterator<int> index_end(gridSize*osize);
 
 	    thrust::reduce_by_key
 	      (
 	       thrust::cuda::par.on(cs->stream),
-	       thrust::make_transform_iterator(index_begin, key_functor(gridSize1)),
-	       thrust::make_transform_iterator(index_end,   key_functor(gridSize1)),
+	       thrust::make_transform_iterator(index_begin, key_functor(gridSize)),
+	       thrust::make_transform_iterator(index_end,   key_functor(gridSize)),
 	       cuS.dc_coef.begin(), thrust::make_discard_iterator(), cuS.dw_coef.begin()
 	       );
 	    
@@ -2136,6 +2513,8 @@ void SphericalBasis::multistep_update_cuda()
 
 void SphericalBasis::destroy_cuda()
 {
+  destroy_peers();
+
   // Deallocate the texture objects
   //
   for (size_t i=0; i<tex.size(); i++) {
@@ -0,0 +1,47 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include <tidalField.H>
+
+// Hills tide in the non-rotating frame; particles beyond rtrunc from
+// the center are frozen as in Component::freeze
+//
+struct TidalForce
+{
+  cuFP_t w2, pp, pm, c, s, rtrunc2, shift[3];
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t r2 = 0.0;
+    for (int k=0; k<3; k++)
+      r2 += (p.pos[k] - shift[k])*(p.pos[k] - shift[k]);
+    if (r2 > rtrunc2) return;
+
+    cuFP_t x = p.pos[0];
+    cuFP_t y = p.pos[1];
+    cuFP_t z = p.pos[2];
+
+    p.acc[0] += 0.5*w2*(pp*(c*x + s*y) - pm*x);
+    p.acc[1] += 0.5*w2*(pp*(s*x - c*y) - pm*y);
+    p.acc[2] += w2*z;
+
+    p.potext += 0.5*w2*z*z -
+      0.25*w2*(pp*(c+s)*x*x + pp*(s-c)*y*y - pm*(x*x+y*y));
+  }
+};
+
+void tidalField::determine_acceleration_and_potential_cuda()
+{
+  TidalForce f;
+  f.w2 = hills_omega*hills_omega;
+  f.pm = 1.0 - hills_p;
+  f.pp = 1.0 + hills_p;
+  f.c  = cos(2.0*hills_omega*tnow);
+  f.s  = sin(2.0*hills_omega*tnow);
+
+  f.rtrunc2 = cC->rtrunc*cC->rtrunc;
+  for (int k=0; k<3; k++) f.shift[k] = cC->com0[k] + cC->center[k];
+
+  cudaExternalForce(cC, mlevel, f);
+}
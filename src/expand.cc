@@ -419,14 +419,28 @@ main(int argc, char** argv)
     // MAIN LOOP 
     //===========
 
+    profiler.enabled = nprofile > 0;
+
+    BarrierWrapper::telemetry = barrier_telemetry > 0;
+
     for (this_step=1; this_step<=nsteps; this_step++) {
 
       do_step(this_step);
+
+      if (nprofile and this_step % nprofile == 0) profiler.report(this_step);
+
+      if (barrier_telemetry and this_step % barrier_telemetry == 0) {
+	std::ofstream out;
+	if (myid==0) out.open(outdir + "barrier." + runtag, std::ios::app);
+	barrier->telemetryReport(out, this_step);
+      }
     
       //
       // Checking for exit time
       //
 
+      chktimer.step();
+
       if (chktimer.done()) {
 	if (myid==0) {
 	  std::cout << "Checkpoint timer says: quit now!" << std::endl;
@@ -436,6 +450,12 @@ main(int argc, char** argv)
       }
       MPI_Bcast(&quit_signal, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);      
 
+      //
+      // Periodic dump at the interval set by the failure rate
+      //
+
+      if (myid==0 and chktimer.due()) dump_signal0 = 1;
+
       //
       // Synchronize and check for signals
       //
@@ -444,16 +464,19 @@ main(int argc, char** argv)
       //
       dump_signal = dump_signal0;
       stop_signal = stop_signal0;
+      if (flush_signal0) flush_signal = 1;
 
       // Reset static signals
       //
-      stop_signal0 = 0;
-      dump_signal0 = 0;
+      stop_signal0  = 0;
+      dump_signal0  = 0;
+      flush_signal0 = 0;
 
       // Broadcast the signals
       //
-      MPI_Bcast(&dump_signal, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
-      MPI_Bcast(&stop_signal, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+      MPI_Bcast(&dump_signal,  1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+      MPI_Bcast(&stop_signal,  1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
+      MPI_Bcast(&flush_signal, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
 
       // Break the step loop if quit flag is set
       //
@@ -503,6 +526,19 @@ main(int argc, char** argv)
 
     exit(0);
   }
+  catch (std::bad_alloc& e) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::ostringstream sout;
+    sout << "Process " << myid << ": out of memory (" << e.what()
+	 << "), peak resident set " << usage.ru_maxrss/1024 << " MB"
+	 << std::endl;
+    memtrack.print(sout);
+    std::cerr << sout.str() << std::flush;
+    if (VERBOSE>4) print_trace(std::cerr, 0, 0);
+    sleep(5);
+    MPI_Abort(MPI_COMM_WORLD, -1);
+  }
   catch (std::runtime_error& e) {
     std::cerr << "Process " << myid << ": std exception" << std::endl;
     if (myid==0) std::cerr << e.what() << std::endl;
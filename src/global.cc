@@ -14,9 +14,14 @@
 int nsteps = 500;		// Number of steps to execute
 int nscale = 20;		// Number of steps between rescaling
 int ngpus  = 0;	                // Number of GPUs per node (0 means use all available)
+int gpus_per_rank = 1;		// Number of GPUs driven by each process
 int nbalance = 0;		// Steps between load balancing
 int nreport = 0;		// Steps between particle reporting
+int nprofile = 0;		// Steps between profile reports
+Profiler profiler;		// Run profiler
+MemTrack memtrack;		// Tracked allocations
 double dbthresh = 0.05;		// Load balancing threshold (5% by default)
+int balancehorizon = 0;		// Steps to recover the balancing cost (0 for fixed cadence)
 double dtime = 0.1;		// Default time step size
 double max_mindt = 0.05;        // Below minimum time step threshold
 
@@ -36,10 +41,21 @@ bool initializing = false;	// Used by force methods to do "private things"
 
 				// Total alloted runtime: <0 means ignore
 double runtime = -1.0;
+				// Thread count trials at start up
+bool autotune_threads = false;
+				// Thread pinning and first touch
+bool pin_threads = false;
+				// Huge pages for large arrays: 0 means off
+int huge_pages = 0;
+				// Two-level coefficient reductions
+bool node_reduce = false;
+				// Node MTBF in hours: 0 means ignore
+double node_mtbf = 0.0;
 
 				// Files
 string homedir  = "./";
 string infile   = "restart.in";
+string burstdir;
 string parmfile = "config";
 string ratefile = "processor.rates";
 string ldlibdir = ".";
@@ -55,9 +71,11 @@ bool eqmotion = true;
 unsigned char stop_signal  = 0;
 unsigned char dump_signal  = 0;
 unsigned char quit_signal  = 0;
+unsigned char flush_signal = 0;
 
 int stop_signal0 = 0;		// Internal implementation of stop_signal
 int dump_signal0 = 0;		// Internal implementation of dump_signal
+int flush_signal0 = 0;		// Internal implementation of flush_signal
 
 				// Multistep variables
 unsigned        shiftlevl  = 0;
@@ -66,6 +84,7 @@ int             mdrft      = 0;
 int             mstep      = 0;
 int             Mstep      = 1;
 int             centerlevl = -1;
+bool            posnsync   = false;
 				// Timestep control
 double          dynfracS   = 1.00;
 double          dynfracD   = 1.0e32;
@@ -79,6 +98,7 @@ std::vector< vector<int> > dstepL, dstepN;
 
 #if HAVE_LIBCUDA==1
 int cudaGlobalDevice;
+std::vector<int> cudaGlobalDevices;
 #endif
 
 
@@ -128,6 +148,7 @@ bool barrier_extra = false;
 bool barrier_label = true;
 bool barrier_light = true;
 bool barrier_quiet = true;
+int  barrier_telemetry = 0;
 
 bool cuda_prof     = false;
 bool debug_wait    = false;
@@ -143,4 +164,8 @@ bool all_couples   = true;
 
 int  rlimit_val    = 0;
 bool use_cuda      = false;
+bool worksteal     = false;
 bool leapfrog_cuda = true;
+bool cuda_resident = false;
+bool cuda_concurrent = false;
+bool fuse_external = true;
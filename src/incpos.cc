@@ -10,6 +10,7 @@
 
 #ifdef HAVE_LIBCUDA
 void incr_position_cuda(cuFP_t dt, int mlevel);
+void incr_kick_drift_cuda(cuFP_t dtk, cuFP_t dtd, int mlevel);
 #endif
 
 void * incr_position_thread(void *ptr)
@@ -74,6 +75,10 @@ void incr_position(double dt, int mlevel)
 {
   if (!eqmotion) return;
 
+  // Body-frame positions at this level are now stale
+  //
+  for (auto c : comp->components) c->touchPositions(mlevel);
+
 #ifdef USE_GPTL
   GPTLstart("incr_position");
 #endif
@@ -149,6 +154,28 @@ void incr_position(double dt, int mlevel)
 
 }
 
+// A multistep level drifts by its whole step when the step begins,
+// so at sub step ms the levels that are not synchronized lead tnow.
+// Drift them back to tnow (dir<0) for a reader such as a sub-step
+// output and forward again (dir>0) when it is done.  Levels that
+// begin a step at ms are at tnow already.
+//
+void predict_positions(int ms, int dir)
+{
+  if (not multistep or ms<=0 or ms>=Mstep) return;
+
+  double dt = dtime/Mstep;	// Smallest time step
+
+  for (int M=0; M<mfirst[ms]; M++) {
+				// Sub step that began the current step
+    int s = ms;
+    while (s>0 and M < mfirst[s]) s--;
+
+    double lead = dt*(s + mintvl[M] - ms);
+    if (lead > 0.0) incr_position(dir>0 ? lead : -lead, M);
+  }
+}
+
 void incr_com_position(double dt)
 {
   for (auto c : comp->components) {
@@ -158,3 +185,155 @@ void incr_com_position(double dt)
   }
 }
 
+
+// Velocity kick by dtk followed by position drift by dt in a single
+// pass: each particle is looked up and touched once rather than once
+// per half step
+//
+void * incr_kick_drift_thread(void *ptr)
+{
+  // Drift and kick time steps
+  //
+  double dt  = static_cast<thrd_pass_posvel*>(ptr)->dt;
+  double dtk = static_cast<thrd_pass_posvel*>(ptr)->dtk;
+
+  // Current level
+  //
+  int mlevel = static_cast<thrd_pass_posvel*>(ptr)->mlevel;
+
+  // Thread ID
+  //
+  int id = static_cast<thrd_pass_posvel*>(ptr)->id;
+
+  
+  int nbeg, nend, indx;
+  unsigned ntot;
+  
+  //
+  // Component loop
+  //
+  for (auto c : comp->components) {
+
+    if (mlevel>=0)		// Use a particular level
+      ntot = c->levlist[mlevel].size();
+    else			// Use ALL levels
+      ntot = c->Number();
+      
+    if (ntot==0) continue;
+
+    //
+    // Compute the beginning and end points in particle list
+    // for each thread
+    //
+    nbeg = ntot*(id  )/nthrds;
+    nend = ntot*(id+1)/nthrds;
+
+    const int dim = c->dim;
+
+    if (mlevel>=0) {
+
+      const auto & lev = c->levlist[mlevel];
+
+      for (int q=nbeg; q<nend; q++) {
+	Particle *p = c->Part(lev[q]);
+	for (int k=0; k<dim; k++) {
+	  p->vel[k] += p->acc[k]*dtk;
+	  p->pos[k] += p->vel[k]*dt;
+	}
+      }
+
+    } else {
+
+      PartMapItr it = c->Particles().begin();
+
+      for (int q=0   ; q<nbeg; q++) it++;
+      for (int q=nbeg; q<nend; q++) {
+	Particle *p = (it++)->second.get();
+	for (int k=0; k<dim; k++) {
+	  p->vel[k] += p->acc[k]*dtk;
+	  p->pos[k] += p->vel[k]*dt;
+	}
+      }
+    }
+  }
+
+  return (NULL);
+}
+
+
+void incr_kick_drift(double dtk, double dtd, int mlevel)
+{
+  if (!eqmotion) return;
+
+  // Body-frame positions at this level are now stale
+  //
+  for (auto c : comp->components) c->touchPositions(mlevel);
+
+#ifdef USE_GPTL
+  GPTLstart("incr_kick_drift");
+#endif
+
+#ifdef HAVE_LIBCUDA
+  if (use_cuda) {
+    incr_kick_drift_cuda(static_cast<cuFP_t>(dtk),
+			 static_cast<cuFP_t>(dtd), mlevel);
+    return;
+  }
+#endif
+
+  if (nthrds==1) {
+
+    posvel_data[0].dt = dtd;
+    posvel_data[0].dtk = dtk;
+    posvel_data[0].mlevel = mlevel;
+    posvel_data[0].id = 0;
+
+    incr_kick_drift_thread(&posvel_data[0]);
+
+  } else {
+
+    //
+    // Make the <nthrds> threads
+    //
+    int errcode;
+    void *retval;
+  
+    for (int i=0; i<nthrds; i++) {
+
+      posvel_data[i].dt = dtd;
+      posvel_data[i].dtk = dtk;
+      posvel_data[i].mlevel = mlevel;
+      posvel_data[i].id = i;
+      
+      pthread_t *p = &posvel_thrd[i];
+      errcode =  pthread_create(p, 0, incr_kick_drift_thread, &posvel_data[i]);
+
+      if (errcode) {
+	std::ostringstream sout;
+	sout << "Process " << myid
+	     << " incr_kick_drift: cannot make thread " << i
+	     << ", errcode=" << errcode;
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1024, true);
+      }
+    }
+    
+    //
+    // Collapse the threads
+    //
+    for (int i=0; i<nthrds; i++) {
+      pthread_t p = posvel_thrd[i];
+      if ((errcode=pthread_join(p, &retval))) {
+	std::ostringstream sout;
+	sout << "Process " << myid
+	     << " incr_kick_drift: thread join " << i
+	     << " failed, errcode=" << errcode;
+	throw GenericError(sout.str(), __FILE__, __LINE__, 1024, true);
+      }
+    }
+  }
+  
+#ifdef USE_GPTL
+  GPTLstop("incr_kick_drift");
+#endif
+
+}
@@ -83,6 +83,13 @@ void * adjust_multistep_level_thread(void *ptr)
   //
   const double eps = 1.0e-10;
 
+  //
+  // Level changes are collected by (from, to) pair and handed to the
+  // force in batches after the loop.  The positions do not change in
+  // between, so the result is the same as updating one at a time.
+  //
+  std::map<std::pair<unsigned, unsigned>, std::vector<int>> shifts;
+
   //
   // The particle loop
   //
@@ -196,13 +203,9 @@ void * adjust_multistep_level_thread(void *ptr)
       nlev = std::max<int>(nlev, mfirst[mdrft]);
 
       if (plev != nlev) {
-	std::chrono::high_resolution_clock::time_point start1, finish1;
-	start1 = std::chrono::high_resolution_clock::now();
-	c->force->multistep_update(plev, nlev, c, n, id);
-	finish1 = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double, std::micro> duration = finish1 - start1;
-	adjtm2[id] += duration.count();
+	shifts[{plev, nlev}].push_back(n);
 	p->level = nlev;
+	c->levchange[id].push_back(n);
 	numsw[id]++;
       }
       numtt[id]++;
@@ -225,6 +228,19 @@ void * adjust_multistep_level_thread(void *ptr)
     }
   }
 
+  // Apply the level changes
+  //
+  if (shifts.size()) {
+    std::chrono::high_resolution_clock::time_point start1, finish1;
+    start1 = std::chrono::high_resolution_clock::now();
+    for (auto & v : shifts)
+      c->force->multistep_update_batch(v.first.first, v.first.second,
+				       c, v.second, id);
+    finish1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::micro> duration = finish1 - start1;
+    adjtm2[id] += duration.count();
+  }
+
   offlo1[c][id] += offlo;
   offhi1[c][id] += offhi;
   
@@ -537,7 +553,7 @@ void adjust_multistep_level()
     //
     if (apply) {
       c->force->multistep_update_finish();
-      c->reset_level_lists();
+      c->update_level_lists();
     }
     
     c->fix_positions();
@@ -89,9 +89,12 @@ void initialize(void)
     if (_G["nsteps"])	     nsteps     = _G["nsteps"].as<int>();
     if (_G["nthrds"])	     nthrds     = std::max<int>(1, _G["nthrds"].as<int>());
     if (_G["ngpus"])	     ngpus      = _G["ngpus"].as<int>();
+    if (_G["gpus_per_rank"]) gpus_per_rank = std::max<int>(1, _G["gpus_per_rank"].as<int>());
     if (_G["nreport"])	     nreport    = _G["nreport"].as<int>();
     if (_G["nbalance"])      nbalance   = _G["nbalance"].as<int>();
+    if (_G["nprofile"])      nprofile   = _G["nprofile"].as<int>();
     if (_G["dbthresh"])      dbthresh   = _G["dbthresh"].as<double>();
+    if (_G["balancehorizon"]) balancehorizon = _G["balancehorizon"].as<int>();
     
     if (_G["time"])          tnow       = _G["time"].as<double>();
     if (_G["dtime"])         dtime      = _G["dtime"].as<double>();
@@ -101,10 +104,16 @@ void initialize(void)
     if (_G["VERBOSE"])       VERBOSE    = _G["VERBOSE"].as<int>();
     if (_G["rlimit"])        rlimit_val = _G["rlimit"].as<int>();
     if (_G["runtime"])       runtime    = _G["runtime"].as<double>();
+    if (_G["node_mtbf"])     node_mtbf  = _G["node_mtbf"].as<double>();
+    if (_G["autotune"])      autotune_threads = _G["autotune"].as<bool>();
+    if (_G["pin_threads"])   pin_threads = _G["pin_threads"].as<bool>();
+    if (_G["hugepages"])     huge_pages = _G["hugepages"].as<int>();
+    if (_G["node_reduce"])   node_reduce = _G["node_reduce"].as<bool>();
     
     if (_G["multistep"])     multistep  = _G["multistep"].as<int>();
     if (_G["shiftlevl"])     shiftlevl  = _G["shiftlevl"].as<int>();
     if (_G["centerlevl"])    centerlevl = _G["centerlevl"].as<int>();
+    if (_G["posnsync"])      posnsync   = _G["posnsync"].as<bool>();
 
     if (_G["dynfracS"])	     dynfracS   = _G["dynfracS"].as<double>();
     if (_G["dynfracD"])	     dynfracD   = _G["dynfracD"].as<double>();
@@ -126,9 +135,13 @@ void initialize(void)
     if (_G["cuda_prof"])       cuda_prof     = _G["cuda_prof"].as<bool>();
     if (_G["cuda"])            use_cuda      = _G["cuda"].as<bool>();
     if (_G["use_cuda"])        use_cuda      = _G["use_cuda"].as<bool>();
+    if (_G["cuda_resident"])   cuda_resident = _G["cuda_resident"].as<bool>();
+    if (_G["cuda_concurrent"]) cuda_concurrent = _G["cuda_concurrent"].as<bool>();
 #if HAVE_LIBCUDA != 1
     use_cuda = false;
 #endif
+    if (_G["worksteal"])       worksteal     = _G["worksteal"].as<bool>();
+    if (_G["fuse_external"])   fuse_external = _G["fuse_external"].as<bool>();
     if (_G["barrier_check"])   barrier_check = _G["barrier_check"].as<bool>();
     if (_G["barrier_debug"])   barrier_debug = _G["barrier_debug"].as<bool>();
     if (_G["barrier_extra"])   barrier_extra = _G["barrier_extra"].as<bool>();
@@ -136,6 +149,7 @@ void initialize(void)
     if (_G["barrier_light"])   barrier_light = _G["barrier_light"].as<bool>();
     if (_G["barrier_quiet"])   barrier_quiet = _G["barrier_quiet"].as<bool>();
     if (_G["barrier_verbose"]) barrier_quiet = not _G["barrier_quiet"].as<bool>();
+    if (_G["barrier_telemetry"]) barrier_telemetry = _G["barrier_telemetry"].as<int>();
 
     if (_G["gdb_trace"])       gdb_trace  = _G["gdb_trace"].as<bool>();
     if (_G["main_wait"])       main_wait  = _G["main_wait"].as<bool>();
@@ -236,6 +250,7 @@ void initialize(void)
 
     if (_G["ldlibdir"])	        ldlibdir     = _G["ldlibdir"].as<std::string>();
     if (_G["infile"])		infile       = _G["infile"].as<std::string>();
+    if (_G["burstdir"])		burstdir     = _G["burstdir"].as<std::string>();
     if (_G["parmfile"])	        parmfile     = _G["parmfile"].as<std::string>();
     if (_G["ratefile"])	        ratefile     = _G["ratefile"].as<std::string>();
     if (_G["runtag"])		runtag       = _G["runtag"].as<std::string>();
@@ -341,9 +356,13 @@ void update_parm()
     if (not conf["nsteps"])        conf["nsteps"]      = nsteps;
     if (not conf["nthrds"])        conf["nthrds"]      = nthrds;
     if (not conf["ngpus"])         conf["ngpus"]       = ngpus;
+    if (not conf["gpus_per_rank"]) conf["gpus_per_rank"] = gpus_per_rank;
     if (not conf["nreport"])       conf["nreport"]     = nreport;
     if (not conf["nbalance"])      conf["nbalance"]    = nbalance;
+    if (not conf["nprofile"])      conf["nprofile"]    = nprofile;
+    if (not conf["barrier_telemetry"]) conf["barrier_telemetry"] = barrier_telemetry;
     if (not conf["dbthresh"])      conf["dbthresh"]    = dbthresh;
+    if (not conf["balancehorizon"]) conf["balancehorizon"] = balancehorizon;
     
     if (not conf["time"])          conf["time"]        = tnow;
     if (not conf["dtime"])         conf["dtime"]       = dtime;
@@ -352,9 +371,15 @@ void update_parm()
     if (not conf["VERBOSE"])       conf["VERBOSE"]     = VERBOSE;
     if (not conf["rlimit"])        conf["rlimit"]      = rlimit_val;
     if (not conf["runtime"])       conf["runtime"]     = runtime;
+    if (not conf["node_mtbf"])     conf["node_mtbf"]   = node_mtbf;
+    if (not conf["autotune"])      conf["autotune"]    = autotune_threads;
+    if (not conf["pin_threads"])   conf["pin_threads"] = pin_threads;
+    if (not conf["hugepages"])     conf["hugepages"]   = huge_pages;
+    if (not conf["node_reduce"])   conf["node_reduce"] = node_reduce;
     
     if (not conf["multistep"])     conf["multistep"]   = multistep;
     if (not conf["centerlevl"])    conf["centerlevl"]  = centerlevl;
+    if (not conf["posnsync"])      conf["posnsync"]    = posnsync;
     if (not conf["dynfracS"])      conf["dynfracS"]    = dynfracS;
     if (not conf["dynfracV"])      conf["dynfracV"]    = dynfracV;
     if (not conf["dynfracA"])      conf["dynfracA"]    = dynfracA;
@@ -363,10 +388,14 @@ void update_parm()
     if (not conf["use_cwd"])       conf["use_cwd"]     = use_cwd;
     if (not conf["eqmotion"])      conf["eqmotion"]    = eqmotion;
     if (not conf["global_cov"])    conf["global_cov"]  = global_cov;
+    if (not conf["worksteal"])     conf["worksteal"]   = worksteal;
+    if (not conf["fuse_external"]) conf["fuse_external"] = fuse_external;
 
     if (not conf["homedir"])       conf["homedir"]     = homedir;
     if (not conf["ldlibdir"])      conf["ldlibdir"]    = ldlibdir;
     if (not conf["infile"])        conf["infile"]      = infile;
+    if (not conf["burstdir"] and burstdir.size())
+                                   conf["burstdir"]    = burstdir;
     if (not conf["parmfile"])      conf["parmfile"]    = parmfile;
     if (not conf["ratefile"])      conf["ratefile"]    = ratefile;
     if (not conf["outdir"])        conf["outdir"]      = outdir;
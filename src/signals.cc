@@ -194,8 +194,9 @@ void exp_mpi_error_handler(MPI_Comm *communicator, int *error_code, ...)
 void signal_handler_stop(int sig) 
 {
   if (myid==0) {
-    stop_signal0 = 1;
-    dump_signal0 = 1;
+    stop_signal0  = 1;
+    dump_signal0  = 1;
+    flush_signal0 = 1;
     std::cout << std::endl
 	      << "Process 0: user signaled a STOP at step=" << this_step
 	      << " . . . quitting on next step after output" << std::endl;
@@ -226,7 +227,8 @@ void signal_handler_stop(int sig)
 void signal_handler_dump(int sig) 
 {
   if (myid==0) {
-    dump_signal0 = 1;
+    dump_signal0  = 1;
+    flush_signal0 = 1;
     std::cout << std::endl
 	      << "Process 0: user signaled a DUMP at step=" << this_step
 	      << std::endl;
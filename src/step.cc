@@ -81,6 +81,8 @@ void do_step(int n)
   // K_{1/2} D_1 K_{1/2}
   //========================
 
+  ProfRegion prof("step");
+
   comp->multistep_reset();
 
   check_bad("before multistep");
@@ -119,7 +121,10 @@ void do_step(int n)
 				// Write multistep output
       if (step_timing) timer_out.start();
       if (cuda_prof) tPtr = std::make_shared<nvTracer>("Data output");
-      output->Run(n, mstep);
+      {
+	ProfRegion prof("output");
+	output->Run(n, mstep);
+      }
       if (step_timing) timer_out.stop();
 
       // Compute next coefficients for particles that move on this
@@ -129,36 +134,26 @@ void do_step(int n)
 				// The timestep at level M
 	double DT = dt*mintvl[M];
 	
-	// Advance velocity by 1/2 step for active particles: First
-	// K_{1/2}
+	// Advance velocity by 1/2 step for active particles (first
+	// K_{1/2}) and then position by the whole time step at this
+	// level (D_1) in one pass
 	//
 	nvTracerPtr tPtr2;
 	if (cuda_prof) {
-	  tPtr2 = std::make_shared<nvTracer>("Velocity kick [1]");
-	}
-	if (step_timing) timer_vel.start();
-	incr_velocity(0.5*DT, M);
-#ifdef CHK_STEP
-	vel_check[M] += 0.5*DT;
-#endif
-	if (step_timing) timer_vel.stop();
-
-	check_bad("after incr_vel", M);
-
-	// Advance position by the whole time step at this level: D_1
-	//
-	if (cuda_prof) {
-	  tPtr2.reset();
-	  tPtr2 = std::make_shared<nvTracer>("Drift");
+	  tPtr2 = std::make_shared<nvTracer>("Kick and drift");
 	}
 	if (step_timing) timer_drift.start();
-	incr_position(DT, M);
+	{
+	  ProfRegion prof("kick+drift L" + std::to_string(M));
+	  incr_kick_drift(0.5*DT, DT, M);
+	}
 #ifdef CHK_STEP
+	vel_check[M] += 0.5*DT;
 	pos_check[M] += DT;
 #endif
 	if (step_timing) timer_drift.stop();
 
-	check_bad("after incr_pos", M);
+	check_bad("after kick and drift", M);
 
 	// Now, compute the coefficients for this level at the
 	// advanced position in preparation for the next kick
@@ -206,6 +201,7 @@ void do_step(int n)
 
       if (step_timing) timer_vel.start();
       for (int M=mfirst[mdrft]; M<=multistep; M++) {
+	ProfRegion prof("kick L" + std::to_string(M));
 	incr_velocity(0.5*dt*mintvl[M], M);
 #ifdef CHK_STEP
 	vel_check[M] += 0.5*dt*mintvl[M];
@@ -220,7 +216,10 @@ void do_step(int n)
 #endif
 				// Adjust particle time-step levels
       if (step_timing) timer_adj.start();
-      adjust_multistep_level();
+      {
+	ProfRegion prof("adjust");
+	adjust_multistep_level();
+      }
       if (step_timing) timer_adj.stop();
       
       // Print the level lists
@@ -233,7 +232,10 @@ void do_step(int n)
     // Write output
     if (step_timing) timer_out.start();
     if (cuda_prof) tPtr = std::make_shared<nvTracer>("Data output");
-    output->Run(n);
+    {
+      ProfRegion prof("output");
+      output->Run(n);
+    }
     if (step_timing) timer_out.stop();
 
     if (cuda_prof) {
@@ -272,20 +274,16 @@ void do_step(int n)
   else {
 				// Time at the end of the step
     tnow += dtime;
-				// Velocity by 1/2 step
+				// Velocity by 1/2 step and position
+				// by whole step
     nvTracerPtr tPtr1;
-    if (cuda_prof) tPtr1 = std::make_shared<nvTracer>("Velocity kick [1]");
-    if (step_timing) timer_vel.start();
-    incr_velocity(0.5*dtime);
-    incr_com_velocity(0.5*dtime);
-    if (step_timing) timer_vel.stop();
-				// Position by whole step
-    if (cuda_prof) {
-      tPtr1.reset();
-      tPtr1 = std::make_shared<nvTracer>("Drift");
-    }
+    if (cuda_prof) tPtr1 = std::make_shared<nvTracer>("Kick and drift");
     if (step_timing) timer_drift.start();
-    incr_position(dtime);
+    {
+      ProfRegion prof("kick+drift");
+      incr_kick_drift(0.5*dtime, dtime);
+    }
+    incr_com_velocity(0.5*dtime);
     incr_com_position(dtime);
     if (step_timing) timer_drift.stop();
 
@@ -308,7 +306,10 @@ void do_step(int n)
       tPtr1 = std::make_shared<nvTracer>("Velocity kick [2]");
     }
     if (step_timing) timer_vel.start();
-    incr_velocity(0.5*dtime);
+    {
+      ProfRegion prof("kick");
+      incr_velocity(0.5*dtime);
+    }
     incr_com_velocity(0.5*dtime);
     if (step_timing) timer_vel.stop();
 
@@ -316,7 +317,10 @@ void do_step(int n)
     if (step_timing) timer_out.start();
     nvTracerPtr tPtr;
     if (cuda_prof) tPtr = std::make_shared<nvTracer>("Data output");
-    output->Run(n);
+    {
+      ProfRegion prof("output");
+      output->Run(n);
+    }
     if (step_timing) timer_out.stop();
 
   }
@@ -325,7 +329,10 @@ void do_step(int n)
 				// Summarize processor particle load
 
   if (step_timing) timer_rpt.start();
-  comp->report_numbers();
+  {
+    ProfRegion prof("report");
+    comp->report_numbers();
+  }
   if (step_timing) timer_rpt.stop();
 
 				// Load balance
@@ -334,7 +341,12 @@ void do_step(int n)
     tPtr = std::make_shared<nvTracer>("Load balance");
   }
   if (step_timing) timer_bal.start();
-  comp->load_balance();
+  (*barrier)("do_step: balance", __FILE__, __LINE__);
+  {
+    ProfRegion prof("balance");
+    comp->load_balance();
+    for (auto c : comp->components) c->sfc_check();
+  }
   if (step_timing) timer_bal.stop();
 
 				// Stop the total step timer
@@ -15,6 +15,10 @@ tidalField::tidalField(const YAML::Node& config) : ExternalForce(config)
   hills_p = 0.5;
   
   initialize();
+
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaTidalField.cu
+#endif
 }
 
 void tidalField::initialize()
@@ -41,9 +45,21 @@ void tidalField::initialize()
   }
 }
 
+void tidalField::determine_acceleration_and_potential(void)
+{
+#if HAVE_LIBCUDA==1		// Cuda compatibility
+  if (use_cuda) {
+    determine_acceleration_and_potential_cuda();
+    return;
+  }
+#endif
+
+  ExternalForce::determine_acceleration_and_potential();
+}
+
 void * tidalField::determine_acceleration_and_potential_thread(void * arg)
 {
-  int i;
+  unsigned long i;
   double s, c, w2, pp, pm, x, y, z;
 
   w2 = hills_omega*hills_omega;
@@ -55,31 +71,31 @@ void * tidalField::determine_acceleration_and_potential_thread(void * arg)
 
   int nbeg, nend, id = *((int*)arg);
 
-  for (auto cp : comp->components) {
-
-    nbodies = cp->Number();
-    nbeg = nbodies*id/nthrds;
-    nend = nbodies*(id+1)/nthrds;
-
-    PartMapItr it = cp->Particles().begin();
-    unsigned long i;
-
-    for (int q=0   ; q<nbeg; q++) it++;
-    for (int q=nbeg; q<nend; q++) 
-      {
-	i = (it++)->first;
-
-	if (cp->freeze(i)) continue;
-	x = cp->Pos(i, 0);
-	y = cp->Pos(i, 1);
-	z = cp->Pos(i, 2);
-	cp->AddAcc(i, 0, 0.5*w2*(pp*(c*x + s*y) - pm*x) );
-	cp->AddAcc(i, 1, 0.5*w2*(pp*(s*x - c*y) - pm*y) );
-	cp->AddAcc(i, 2, w2*z );
-	cp->AddPotExt(i, 0.5*w2*z*z - 
-		      0.25*w2*(pp*(c+s)*x*x + pp*(s-c)*y*y - pm*(x*x+y*y) ) );
-      }
-  }
+  nbodies = cC->Number();
+  nbeg = nbodies*id/nthrds;
+  nend = nbodies*(id+1)/nthrds;
+
+  PartMapItr it = cC->Particles().begin();
+
+  for (int q=0   ; q<nbeg; q++) it++;
+  for (int q=nbeg; q<nend; q++) 
+    {
+      i = (it++)->first;
+				// If we are multistepping, compute accel 
+				// only at or below this level
+
+      if (multistep && (cC->Part(i)->level < mlevel)) continue;
+
+      if (cC->freeze(i)) continue;
+      x = cC->Pos(i, 0);
+      y = cC->Pos(i, 1);
+      z = cC->Pos(i, 2);
+      cC->AddAcc(i, 0, 0.5*w2*(pp*(c*x + s*y) - pm*x) );
+      cC->AddAcc(i, 1, 0.5*w2*(pp*(s*x - c*y) - pm*y) );
+      cC->AddAcc(i, 2, w2*z );
+      cC->AddPotExt(i, 0.5*w2*z*z - 
+		    0.25*w2*(pp*(c+s)*x*x + pp*(s-c)*y*y - pm*(x*x+y*y) ) );
+    }
 
   return (NULL);
 }
@@ -76,6 +76,10 @@ UserBar::UserBar(const YAML::Node &conf) : ExternalForce(conf)
   else
     c1 = NULL;
 
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaUserBar.cu
+#endif
+
   userinfo();
 
 }
@@ -187,24 +191,23 @@ void UserBar::determine_acceleration_and_potential(void)
   if (firstime) {
     
     double R=length*Fcorot;
-    double phi, theta=0.5*M_PI;
-    double dens0, potl0, dens, potl, potr, pott, potp;
     double avg=0.0;
     
+    Eigen::MatrixXd pts(8, 3), fields;
     for (int n=0; n<8; n++) {
-      phi = 2.0*M_PI/8.0 * n;
+      pts(n, 0) = R;
+      pts(n, 1) = 0.5*M_PI;
+      pts(n, 2) = 2.0*M_PI/8.0 * n;
+    }
 
-      for (auto c : comp->components) {
+    for (auto c : comp->components) {
 	
-	if (c->force->geometry == PotAccel::sphere || 
-	    c->force->geometry == PotAccel::cylinder) {
+      if (c->force->geometry == PotAccel::sphere || 
+	  c->force->geometry == PotAccel::cylinder) {
 	  
-	  ((Basis*)c->force)->
-	    determine_fields_at_point_sph(R, theta, phi, &dens0, &potl0,
-					  &dens, &potl, &potr, &pott, &potp);
-	  
-	  avg += potr/8.0;
-	}
+	if (c->force->evaluate_fields(PotAccel::FieldCoord::spherical,
+				      pts, fields))
+	  avg += fields.col(4).sum()/8.0;
       }
     }
 
@@ -390,6 +393,11 @@ void UserBar::determine_acceleration_and_potential(void)
     }
   }
 
+#if HAVE_LIBCUDA==1
+  if (use_cuda)
+    determine_acceleration_and_potential_cuda();
+  else
+#endif
   exp_thread_fork(false);
 
   if (myid==0 && update) 
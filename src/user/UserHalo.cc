@@ -54,11 +54,21 @@ UserHalo::UserHalo(const YAML::Node& conf) : ExternalForce(conf)
 
   model = new SphericalModelTable(model_file, diverge, diverge_rfac);
 
+  batch_aware = true;		// See eval_batch
+
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaUserHalo.cu
+  if (use_cuda) initialize_cuda();
+#endif
+
   userinfo();
 }
 
 UserHalo::~UserHalo()
 {
+#if HAVE_LIBCUDA==1
+  if (use_cuda) destroy_cuda();
+#endif
   delete model;
 }
 
@@ -123,7 +133,10 @@ void UserHalo::determine_acceleration_and_potential(void)
   if (c0 and cC != c0) return; // Check that this component is the target
 
 #if HAVE_LIBCUDA==1		// Cuda compatibility
-  getParticlesCuda(c0);
+  if (use_cuda) {
+    determine_acceleration_and_potential_cuda();
+    return;
+  }
 #endif
 
   exp_thread_fork(false);
@@ -229,6 +242,47 @@ void * UserHalo::determine_acceleration_and_potential_thread(void * arg)
 }
 
 
+bool UserHalo::batch_begin(Component *c)
+{
+  if (c0 and c != c0) return false;
+
+  for (int k=0; k<3; k++) ctr[k] = c0 ? c0->center[k] : 0.0;
+
+  return true;
+}
+
+void UserHalo::eval_batch(int n,
+			  const double *x, const double *y, const double *z,
+			  double *ax, double *ay, double *az, double *pot)
+{
+  const double qq[3] = {q1*q1, q2*q2, q3*q3};
+
+  thread_local std::vector<double> r, p, dp;
+  if (r.size() < static_cast<size_t>(n)) {
+    r.resize(n);
+    p.resize(n);
+    dp.resize(n);
+  }
+
+#pragma omp simd
+  for (int j=0; j<n; j++) {
+    double xx = x[j] - ctr[0], yy = y[j] - ctr[1], zz = z[j] - ctr[2];
+    r[j] = sqrt(xx*xx/qq[0] + yy*yy/qq[1] + zz*zz/qq[2]);
+  }
+
+  model->get_pot_dpot_batch(r.data(), n, p.data(), dp.data());
+
+#pragma omp simd
+  for (int j=0; j<n; j++) {
+    double fac = -dp[j]/r[j];
+    ax[j]  += fac*(x[j] - ctr[0])/qq[0];
+    ay[j]  += fac*(y[j] - ctr[1])/qq[1];
+    az[j]  += fac*(z[j] - ctr[2])/qq[2];
+    pot[j] += p[j];
+  }
+}
+
+
 extern "C" {
   ExternalForce *makerHalo(const YAML::Node& conf)
   {
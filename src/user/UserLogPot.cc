@@ -19,6 +19,12 @@ UserLogPot::UserLogPot(const YAML::Node& conf) : ExternalForce(conf)
 
   initialize();
 
+  batch_aware = true;		// See eval_batch
+
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaUserLogPot.cu
+#endif
+
   userinfo();
 }
 
@@ -73,7 +79,10 @@ void UserLogPot::initialize()
 void UserLogPot::determine_acceleration_and_potential(void)
 {
 #if HAVE_LIBCUDA==1		// Cuda compatibility
-  getParticlesCuda(cC);
+  if (use_cuda) {
+    determine_acceleration_and_potential_cuda();
+    return;
+  }
 #endif
 
   exp_thread_fork(false);
@@ -118,6 +127,29 @@ void * UserLogPot::determine_acceleration_and_potential_thread(void * arg)
 }
 
 
+bool UserLogPot::batch_begin(Component *c)
+{
+  return true;
+}
+
+void UserLogPot::eval_batch(int n,
+			    const double *x, const double *y, const double *z,
+			    double *ax, double *ay, double *az, double *pot)
+{
+  const double R2 = R*R, b2 = b*b, c2 = c*c;
+
+#pragma omp simd
+  for (int j=0; j<n; j++) {
+    double rr = R2 + x[j]*x[j] + y[j]*y[j]/b2 + z[j]*z[j]/c2;
+
+    ax[j]  += -v2*x[j]/rr;
+    ay[j]  += -v2*y[j]/(rr*b2);
+    az[j]  += -v2*z[j]/(rr*c2);
+    pot[j] += 0.5*v2*log(rr);
+  }
+}
+
+
 extern "C" {
   ExternalForce *makerLogPot(const YAML::Node& conf)
   {
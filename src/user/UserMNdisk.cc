@@ -32,6 +32,12 @@ UserMNdisk::UserMNdisk(const YAML::Node& conf) : ExternalForce(conf)
   
   initialize();
 
+  batch_aware = true;		// See eval_batch
+
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaUserMNdisk.cu
+#endif
+
   if (ctr_name.size()>0) {
 				// Look for the fiducial component for
 				// centering
@@ -118,7 +124,10 @@ void UserMNdisk::initialize()
 void UserMNdisk::determine_acceleration_and_potential(void)
 {
 #if HAVE_LIBCUDA==1		// Cuda compatibility
-  getParticlesCuda(cC);
+  if (use_cuda) {
+    determine_acceleration_and_potential_cuda();
+    return;
+  }
 #endif
 
   exp_thread_fork(false);
@@ -187,6 +196,43 @@ void * UserMNdisk::determine_acceleration_and_potential_thread(void * arg)
 }
 
 
+bool UserMNdisk::batch_begin(Component *c)
+{
+  amp =
+      0.5*(1.0 + erf( (tnow - Ton )/DeltaT ))
+    * 0.5*(1.0 - erf( (tnow - Toff)/DeltaT )) ;
+
+  for (int k=0; k<3; k++) ctr[k] = c0 ? c0->center[k] : 0.0;
+
+  return true;
+}
+
+void UserMNdisk::eval_batch(int n,
+			    const double *x, const double *y, const double *z,
+			    double *ax, double *ay, double *az, double *pot)
+{
+#pragma omp simd
+  for (int j=0; j<n; j++) {
+    double xx = x[j] - ctr[0];
+    double yy = y[j] - ctr[1];
+    double zz = z[j] - ctr[2];
+
+    double rr = sqrt( xx*xx + yy*yy );
+    double zb = sqrt( zz*zz + b * b );
+    double ab = a + zb;
+    double dn = sqrt( rr*rr + ab*ab );
+    
+    double fr  = -mass*rr/(dn*dn*dn);
+    double fz  = -mass*zz*ab/(zb*dn*dn*dn);
+
+    ax[j]  += amp * fr*xx/(rr+1.0e-10);
+    ay[j]  += amp * fr*yy/(rr+1.0e-10);
+    az[j]  += amp * fz;
+    pot[j] += -mass/dn;
+  }
+}
+
+
 extern "C" {
   ExternalForce *makerMNdisk(const YAML::Node& conf)
   {
@@ -34,6 +34,12 @@ UserMW::UserMW(const YAML::Node& conf) : ExternalForce(conf)
 
   initialize();
 
+  batch_aware = true;		// See eval_batch
+
+#if HAVE_LIBCUDA==1
+  cuda_aware = true;		// Device kernel in cudaUserMW.cu
+#endif
+
   if (ctr_name.size()>0) {
 				// Look for the fiducial component for
 				// centering
@@ -134,7 +140,10 @@ void UserMW::initialize()
 void UserMW::determine_acceleration_and_potential(void)
 {
 #if HAVE_LIBCUDA==1		// Cuda compatibility
-  getParticlesCuda(cC);
+  if (use_cuda) {
+    determine_acceleration_and_potential_cuda();
+    return;
+  }
 #endif
 
   exp_thread_fork(false);
@@ -220,6 +229,40 @@ void * UserMW::determine_acceleration_and_potential_thread(void * arg)
 }
 
 
+bool UserMW::batch_begin(Component *c)
+{
+  for (int k=0; k<3; k++) ctr[k] = c0 ? c0->center[k] : 0.0;
+
+  return true;
+}
+
+void UserMW::eval_batch(int n,
+			const double *x, const double *y, const double *z,
+			double *ax, double *ay, double *az, double *pot)
+{
+  for (int j=0; j<n; j++) {
+    double xx = x[j] - ctr[0];
+    double yy = y[j] - ctr[1];
+    double zz = z[j] - ctr[2];
+
+    double r2 = sqrt( xx*xx + yy*yy ); // R
+    double r3 = sqrt( xx*xx + yy*yy + zz*zz ); // r
+
+    double ax1, ay1, az1, ax2, ay2, az2, ax3, ay3, az3, ax4, ay4, az4;
+
+    NFW_dphi_dr(xx, yy, zz, &ax1, &ay1, &az1);
+    HN_nucl_dphi_dr(xx, yy, zz, &ax2, &ay2, &az2);
+    HN_bulge_dphi_dr(xx, yy, zz, &ax3, &ay3, &az3);
+    MN_dphi_dR_dz(xx, yy, zz, &ax4, &ay4, &az4);
+
+    ax[j]  += ax1 + ax2 + ax3 + ax4;
+    ay[j]  += ay1 + ay2 + ay3 + ay4;
+    az[j]  += az1 + az2 + az3 + az4;
+    pot[j] += NFW_pot(r3) + HN_nucl_pot(r3) + HN_bulge_pot(r3) + MN_pot(zz, r2);
+  }
+}
+
+
 extern "C" {
   ExternalForce *makerMW(const YAML::Node& conf)
   {
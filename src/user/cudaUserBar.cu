@@ -0,0 +1,57 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include "UserBar.H"
+
+// Quadrupole of the rotating bar at position angle posang, as in
+// UserBar::determine_acceleration_and_potential_thread
+//
+struct BarForce
+{
+  cuFP_t amp, b5, numfac, cos2p, sin2p, ctr[3];
+  bool soft;
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t xx = p.pos[0] - ctr[0];
+    cuFP_t yy = p.pos[1] - ctr[1];
+    cuFP_t zz = p.pos[2] - ctr[2];
+    cuFP_t rr = sqrt( xx*xx + yy*yy + zz*zz );
+
+    cuFP_t fac, ffac, nn;
+    cuFP_t pp = (xx*xx - yy*yy)*cos2p + 2.0*xx*yy*sin2p;
+
+    if (soft) {
+      fac  = 1.0 + rr/b5;
+      ffac = -amp*numfac/pow(fac, 6.0);
+      nn   = pp /( b5*rr ) ;
+    } else {
+      fac  = 1.0 + pow(rr/b5, 5.0);
+      ffac = -amp*numfac/(fac*fac);
+      nn   = pp * pow(rr/b5, 3.0)/(b5*b5);
+    }
+
+    p.acc[0] += ffac*( 2.0*( xx*cos2p + yy*sin2p)*fac - 5.0*nn*xx );
+    p.acc[1] += ffac*( 2.0*(-yy*cos2p + xx*sin2p)*fac - 5.0*nn*yy );
+    p.acc[2] += ffac*( -5.0*nn*zz );
+
+    p.potext += -ffac*pp*fac;
+  }
+};
+
+void UserBar::determine_acceleration_and_potential_cuda()
+{
+  BarForce f;
+  f.amp    = afac * amplitude/fabs(amplitude)
+    * 0.5*(1.0 + erf( (tnow - Ton )/DeltaT ))
+    * 0.5*(1.0 - erf( (tnow - Toff)/DeltaT )) ;
+  f.b5     = b5;
+  f.numfac = numfac;
+  f.cos2p  = cos(2.0*posang);
+  f.sin2p  = sin(2.0*posang);
+  f.soft   = soft;
+  for (int k=0; k<3; k++) f.ctr[k] = c0 ? c0->center[k] : 0.0;
+
+  cudaExternalForce(cC, mlevel, f);
+}
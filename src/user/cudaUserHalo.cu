@@ -0,0 +1,108 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include <massmodel.H>
+
+#include "UserHalo.H"
+
+// Potential and dPhi/dr interpolated linearly in log r from the
+// texture tables, with the Keplerian extension outside the model
+//
+struct HaloForce
+{
+  cudaTextureObject_t tpot, tdpot;
+  cuFP_t lrmin, dlr, rmin, rmax, pmax, qq[3], ctr[3];
+  int num;
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t xx = p.pos[0] - ctr[0];
+    cuFP_t yy = p.pos[1] - ctr[1];
+    cuFP_t zz = p.pos[2] - ctr[2];
+
+    cuFP_t r = sqrt(xx*xx/qq[0] + yy*yy/qq[1] + zz*zz/qq[2]);
+    cuFP_t pot, dpot;
+
+    if (r > rmax) {
+      pot  =  pmax*rmax/r;
+      dpot = -pmax*rmax/(r*r);
+    } else {
+      cuFP_t x = (log(r > rmin ? r : rmin) - lrmin)/dlr;
+      int ind  = floor(x);
+      if (ind < 0)     ind = 0;
+      if (ind > num-2) ind = num-2;
+
+      cuFP_t b = x - ind, a = 1.0 - b;
+
+      pot  = a*cudaTableFetch(tpot,  ind) + b*cudaTableFetch(tpot,  ind+1);
+      dpot = a*cudaTableFetch(tdpot, ind) + b*cudaTableFetch(tdpot, ind+1);
+    }
+
+    cuFP_t fac = -dpot/r;
+
+    p.acc[0] += fac*xx/qq[0];
+    p.acc[1] += fac*yy/qq[1];
+    p.acc[2] += fac*zz/qq[2];
+
+    p.potext += pot;
+  }
+};
+
+void UserHalo::initialize_cuda()
+{
+  // Table range: the model grid, with a floor for models that
+  // start at r=0
+  //
+  cuRmax = model->get_max_radius();
+  cuRmin = model->get_min_radius();
+  if (cuRmin <= 0.0) cuRmin = 1.0e-6*cuRmax;
+
+  double lrmin = log(cuRmin), dlr = (log(cuRmax) - lrmin)/(cuNum-1);
+
+  std::vector<double> p(cuNum), dp(cuNum);
+  for (int i=0; i<cuNum; i++)
+    model->get_pot_dpot(exp(lrmin + dlr*i), p[i], dp[i]);
+
+  cuPmax = p.back();
+
+  cuArray.resize(2);
+  tex.resize(2);
+
+  cudaMakeTable(p,  cuArray[0], tex[0]);
+  cudaMakeTable(dp, cuArray[1], tex[1]);
+}
+
+void UserHalo::destroy_cuda()
+{
+  for (size_t i=0; i<tex.size(); i++) {
+    cuda_check_error(cudaDestroyTextureObject(tex[i]),
+		     "cudaDestroyTextureObject", __FILE__, __LINE__);
+  }
+
+  for (size_t i=0; i<cuArray.size(); i++) {
+    cuda_check_error(cudaFreeArray(cuArray[i]),
+		     "cudaFreeArray", __FILE__, __LINE__);
+  }
+}
+
+void UserHalo::determine_acceleration_and_potential_cuda()
+{
+  batch_begin(cC);		// Center
+
+  HaloForce f;
+  f.tpot  = tex[0];
+  f.tdpot = tex[1];
+  f.lrmin = log(cuRmin);
+  f.dlr   = (log(cuRmax) - log(cuRmin))/(cuNum-1);
+  f.rmin  = cuRmin;
+  f.rmax  = cuRmax;
+  f.pmax  = cuPmax;
+  f.num   = cuNum;
+  f.qq[0] = q1*q1;
+  f.qq[1] = q2*q2;
+  f.qq[2] = q3*q3;
+  for (int k=0; k<3; k++) f.ctr[k] = ctr[k];
+
+  cudaExternalForce(cC, mlevel, f);
+}
@@ -0,0 +1,35 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include "UserLogPot.H"
+
+struct LogPotForce
+{
+  cuFP_t R, b, c, v2;
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t xx = p.pos[0];
+    cuFP_t yy = p.pos[1];
+    cuFP_t zz = p.pos[2];
+    cuFP_t rr = R*R + xx*xx + yy*yy/(b*b) + zz*zz/(c*c);
+
+    p.acc[0] += -v2*xx/rr;
+    p.acc[1] += -v2*yy/(rr*b*b);
+    p.acc[2] += -v2*zz/(rr*c*c);
+
+    p.potext += 0.5*v2*log(rr);
+  }
+};
+
+void UserLogPot::determine_acceleration_and_potential_cuda()
+{
+  LogPotForce f;
+  f.R  = R;
+  f.b  = b;
+  f.c  = c;
+  f.v2 = v2;
+
+  cudaExternalForce(cC, mlevel, f);
+}
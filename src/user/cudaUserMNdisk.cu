@@ -0,0 +1,45 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include "UserMNdisk.H"
+
+struct MNdiskForce
+{
+  cuFP_t a, b, mass, amp, ctr[3];
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t xx = p.pos[0] - ctr[0];
+    cuFP_t yy = p.pos[1] - ctr[1];
+    cuFP_t zz = p.pos[2] - ctr[2];
+
+    cuFP_t rr = sqrt( xx*xx + yy*yy );
+    cuFP_t zb = sqrt( zz*zz + b * b );
+    cuFP_t ab = a + zb;
+    cuFP_t dn = sqrt( rr*rr + ab*ab );
+
+    cuFP_t fr = -mass*rr/(dn*dn*dn);
+    cuFP_t fz = -mass*zz*ab/(zb*dn*dn*dn);
+
+    p.acc[0] += amp * fr*xx/(rr+1.0e-10);
+    p.acc[1] += amp * fr*yy/(rr+1.0e-10);
+    p.acc[2] += amp * fz;
+
+    p.potext += -mass/dn;
+  }
+};
+
+void UserMNdisk::determine_acceleration_and_potential_cuda()
+{
+  batch_begin(cC);		// Amplitude and center
+
+  MNdiskForce f;
+  f.a    = a;
+  f.b    = b;
+  f.mass = mass;
+  f.amp  = amp;
+  for (int k=0; k<3; k++) f.ctr[k] = ctr[k];
+
+  cudaExternalForce(cC, mlevel, f);
+}
@@ -0,0 +1,75 @@
+// -*- C++ -*-
+
+#include <cudaExternalForce.cuH>
+
+#include "UserMW.H"
+
+// NFW halo, Hernquist nucleus and bulge and Miyamoto-Nagai disk, as
+// in UserMW::eval_batch
+//
+struct MWForce
+{
+  cuFP_t G, M_halo, rs_halo, M_disk, a_disk, b_disk;
+  cuFP_t M_nucl, c_nucl, M_bulge, c_bulge, ctr[3];
+
+  __device__ void operator()(cudaParticle& p) const
+  {
+    cuFP_t xx = p.pos[0] - ctr[0];
+    cuFP_t yy = p.pos[1] - ctr[1];
+    cuFP_t zz = p.pos[2] - ctr[2];
+
+    cuFP_t r2 = sqrt( xx*xx + yy*yy ); // R
+    cuFP_t r3 = sqrt( xx*xx + yy*yy + zz*zz ); // r
+
+    // NFW halo and Hernquist nucleus and bulge
+    //
+    cuFP_t dphi =
+      (G*M_halo)/r2 * (log( 1 + (r2/rs_halo) )/r2 - (1/(rs_halo + r2))) +
+      G*M_nucl /((r2 + c_nucl )*(r2 + c_nucl )) +
+      G*M_bulge/((r2 + c_bulge)*(r2 + c_bulge)) ;
+
+    cuFP_t ax = -dphi * (xx/r2);
+    cuFP_t ay = -dphi * (yy/r2);
+    cuFP_t az = -dphi * (zz/r2);
+
+    // Miyamoto-Nagai disk
+    //
+    cuFP_t zb  = sqrt( b_disk*b_disk + zz*zz );
+    cuFP_t ab  = a_disk + zb;
+    cuFP_t dn  = r3*r3 + ab*ab;
+    cuFP_t dn3 = dn*sqrt(dn);
+
+    cuFP_t dphi_dR = (G*M_disk*r3)/dn3;
+    cuFP_t dphi_dz = (G*M_disk*zz*ab)/(zb*dn3);
+
+    p.acc[0] += ax - dphi_dR * (xx/r3);
+    p.acc[1] += ay - dphi_dR * (yy/r3);
+    p.acc[2] += az - dphi_dz;
+
+    p.potext +=
+      -(G*M_halo)/r3 * log( 1 + (r3/rs_halo) )
+      - G*M_nucl/(r3 + c_nucl) - G*M_bulge/(r3 + c_bulge)
+      - G*M_disk/sqrt(r2*r2 + (sqrt(zz*zz + b_disk*b_disk) + a_disk)*
+		      (sqrt(zz*zz + b_disk*b_disk) + a_disk));
+  }
+};
+
+void UserMW::determine_acceleration_and_potential_cuda()
+{
+  batch_begin(cC);		// Center
+
+  MWForce f;
+  f.G       = G;
+  f.M_halo  = M_halo;
+  f.rs_halo = rs_halo;
+  f.M_disk  = M_disk;
+  f.a_disk  = a_disk;
+  f.b_disk  = b_disk;
+  f.M_nucl  = M_nucl;
+  f.c_nucl  = c_nucl;
+  f.M_bulge = M_bulge;
+  f.c_bulge = c_bulge;
+  for (int k=0; k<3; k++) f.ctr[k] = ctr[k];
+
+  cudaExternalForce(cC, mlevel, f);
+}
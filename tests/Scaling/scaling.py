@@ -0,0 +1,255 @@
+#!/usr/bin/env python
+# coding: utf-8
+
+"""Strong and weak scaling runs of the Halo, Disk and Cube tests
+
+For each case and particle number, the bodies are generated once with
+the IC utilities from the build tree and exp is run for each
+combination of process and thread counts with the region profiler on
+(nprofile = nsteps).  The step time, the time per phase (the regions
+directly inside 'step', summed over levels) and the peak resident set
+size are read from the profiler output and collected into a JSON
+report.  A previous report may be given with --compare to print the
+ratios of the step times run by run.
+
+In 'strong' mode the particle numbers are used as given.  In 'weak'
+mode they are particles per core (process x thread).
+
+Example:
+
+  python scaling.py --build ../../build --cases Halo,Cube \\
+      --N 100000 --procs 1,2,4,8 --threads 1 --output scaling.json
+"""
+
+import argparse
+import datetime
+import json
+import os
+import re
+import shlex
+import shutil
+import socket
+import subprocess
+import sys
+import time
+
+import yaml
+
+here = os.path.dirname(os.path.abspath(__file__))
+tests = os.path.dirname(here)
+
+
+def ics(case, n, build, launch, wdir):
+    """Generate the bodies for a case in wdir unless they exist"""
+
+    if case == 'Halo':
+        bods, cmd = ['new.bods'], [build + '/utils/ICs/gensph',
+                                   '-N', str(n), '-i', 'SLGridSph.model']
+    elif case == 'Disk':
+        bods, cmd = ['halo.bods', 'disk.bods'], \
+            [build + '/utils/ICs/gendisk',
+             '--nhalo', str(n//2), '--ndisk', str(n//2),
+             '--halofile1', 'SLGridSph.model',
+             '--cachefile', '.eof.cache.run1',
+             '--ASCALE', '0.01', '--HSCALE', '0.001',
+             '--LMAXFID', '48', '--NMAXFID', '48',
+             '--MMAX', '6', '--NMAXD', '12', '--NODD', '3',
+             '--NUMX', '128', '--NUMY', '64', '--LMAX', '4',
+             '--NMAXH', '12', '--VFLAG', '0']
+    elif case == 'Cube':
+        bods, cmd = ['cube.bods'], [build + '/utils/ICs/cubeics',
+                                    '-N', str(n), '-z', '-d', '2,2,2',
+                                    '-s', '11', '-o', 'cube.bods']
+    else:
+        raise ValueError('unknown case <{}>'.format(case))
+
+    if all(os.path.exists(os.path.join(wdir, b)) for b in bods):
+        return
+
+    if case in ('Halo', 'Disk'):
+        shutil.copy(os.path.join(tests, 'Halo', 'SLGridSph.model'), wdir)
+
+    subprocess.run(launch(1) + cmd, cwd=wdir, check=True,
+                   stdout=subprocess.DEVNULL)
+
+
+def configure(case, wdir, runtag, nthrds, nsteps):
+    """Write the case configuration with the run parameters"""
+
+    with open(os.path.join(tests, case, 'config.yml')) as f:
+        conf = yaml.safe_load(f)
+
+    g = conf['Global']
+    g['runtag'] = runtag
+    g['outdir'] = '.'
+    g['nthrds'] = nthrds
+    g['nsteps'] = nsteps
+    g['nprofile'] = nsteps
+    g['infile'] = 'OUT.' + runtag + '.chkpt'
+    g['VERBOSE'] = 0
+
+    # Keep the log quiet and the disk free of snapshots
+    conf['Output'] = [o for o in conf.get('Output') or []
+                      if o['id'] == 'outlog']
+
+    name = 'config.' + runtag + '.yml'
+    with open(os.path.join(wdir, name), 'w') as f:
+        yaml.safe_dump(conf, f, default_flow_style=False, sort_keys=False)
+
+    return name
+
+
+def profile(wdir, runtag, nsteps):
+    """Step and phase times and memory from the last profiler report"""
+
+    with open(os.path.join(wdir, 'profile.' + runtag + '.json')) as f:
+        rec = json.loads(f.read().splitlines()[-1])
+
+    step, phases = 0.0, {}
+    for r in rec['regions']:
+        path = r['name'].split('/')
+        if path == ['step']:
+            step = r['mean']/max(r['count'], 1)
+        elif len(path) == 2 and path[0] == 'step':
+            phase = re.sub(r' L\d+$', '', path[1])
+            phases[phase] = phases.get(phase, 0.0) + r['mean']/nsteps
+
+    return step, phases, rec['maxrss']
+
+
+def main():
+    p = argparse.ArgumentParser(
+        description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--build', required=True,
+                   help='EXP build directory')
+    p.add_argument('--cases', default='Halo,Disk,Cube',
+                   help='comma-separated list of test cases')
+    p.add_argument('--N', default='100000',
+                   help='comma-separated particle numbers (per core in weak mode)')
+    p.add_argument('--procs', default='1,2,4',
+                   help='comma-separated process counts')
+    p.add_argument('--threads', default='1',
+                   help='comma-separated thread counts per process')
+    p.add_argument('--mode', choices=['strong', 'weak'], default='strong')
+    p.add_argument('--nsteps', type=int, default=20)
+    p.add_argument('--launcher', default='mpirun -np {n}',
+                   help="MPI launch command; {n} is the process count")
+    p.add_argument('--workdir', default='scaling.work',
+                   help='directory for the bodies and the run output')
+    p.add_argument('--output', default='scaling.json',
+                   help='report file')
+    p.add_argument('--compare', help='earlier report to compare against')
+    args = p.parse_args()
+
+    build = os.path.abspath(args.build)
+    exp = os.path.join(build, 'src', 'exp')
+
+    def launch(n):
+        cmd = args.launcher
+        if '{n}' not in cmd:
+            cmd += ' -np {n}'
+        return shlex.split(cmd.format(n=n))
+
+    def ints(s):
+        return [int(v) for v in s.split(',') if v]
+
+    runs = []
+
+    for case in args.cases.split(','):
+        for n0 in ints(args.N):
+            for np in ints(args.procs):
+                for nt in ints(args.threads):
+                    n = n0*np*nt if args.mode == 'weak' else n0
+                    wdir = os.path.join(args.workdir, case, str(n))
+                    os.makedirs(wdir, exist_ok=True)
+                    ics(case, n, build, launch, wdir)
+
+                    runtag = 'p{}t{}'.format(np, nt)
+                    for f in os.listdir(wdir):
+                        if f.startswith('profile.' + runtag + '.'):
+                            os.remove(os.path.join(wdir, f))
+
+                    conf = configure(case, wdir, runtag, nt, args.nsteps)
+
+                    env = dict(os.environ, OMP_NUM_THREADS=str(nt))
+                    t0 = time.time()
+                    res = subprocess.run(launch(np) + [exp, conf], cwd=wdir,
+                                         env=env, stdout=subprocess.DEVNULL)
+                    wall = time.time() - t0
+
+                    run = {'case': case, 'N': n, 'procs': np,
+                           'threads': nt, 'wall': wall,
+                           'status': res.returncode}
+
+                    if res.returncode == 0:
+                        step, phases, rss = profile(wdir, runtag,
+                                                    args.nsteps)
+                        run.update({'step': step, 'phases': phases,
+                                    'maxrss_kB': rss})
+
+                    runs.append(run)
+
+                    print('{:6s} N={:<10d} procs={:<4d} threads={:<3d} '
+                          'step={} maxrss={}'.format(
+                              case, n, np, nt,
+                              '{:.4g} s'.format(run['step'])
+                              if 'step' in run else 'FAILED',
+                              '{} MB'.format(run['maxrss_kB']['max']//1024)
+                              if 'maxrss_kB' in run else '-'),
+                          flush=True)
+
+    # Efficiency relative to the smallest core count of each series
+    #
+    for run in runs:
+        if 'step' not in run:
+            continue
+        cores = run['procs']*run['threads']
+        base = [r for r in runs if r['case'] == run['case'] and 'step' in r
+                and (r['N']//(r['procs']*r['threads'])
+                     == run['N']//cores if args.mode == 'weak'
+                     else r['N'] == run['N'])]
+        b = min(base, key=lambda r: r['procs']*r['threads'])
+        ratio = b['step']/run['step']
+        bc = b['procs']*b['threads']
+        run['efficiency'] = ratio if args.mode == 'weak' else ratio*bc/cores
+
+    report = {'mode': args.mode, 'nsteps': args.nsteps,
+              'host': socket.gethostname(),
+              'date': datetime.datetime.now().isoformat(timespec='seconds'),
+              'runs': runs}
+
+    with open(args.output, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    print()
+    print('{:6s} {:>10s} {:>6s} {:>7s} {:>10s} {:>6s}'.format(
+        'Case', 'N', 'Procs', 'Threads', 'Step [s]', 'Eff'))
+    for r in runs:
+        if 'step' in r:
+            print('{:6s} {:10d} {:6d} {:7d} {:10.4g} {:6.2f}'.format(
+                r['case'], r['N'], r['procs'], r['threads'], r['step'],
+                r['efficiency']))
+
+    if args.compare:
+        with open(args.compare) as f:
+            old = json.load(f)['runs']
+
+        def key(r):
+            return (r['case'], r['N'], r['procs'], r['threads'])
+
+        prev = {key(r): r for r in old if 'step' in r}
+
+        print()
+        print('Step time relative to <{}>'.format(args.compare))
+        for r in runs:
+            o = prev.get(key(r))
+            if o and 'step' in r:
+                print('{:6s} {:10d} {:6d} {:7d} {:8.3f}'.format(
+                    *key(r), r['step']/o['step']))
+
+    return 0 if all(r['status'] == 0 for r in runs) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -441,7 +441,7 @@ main(int argc, char **argv)
 			   << " points" << std::endl;
 
     using point3 = KDtree::point<double, 3>;
-    using tree3  = KDtree::kdtree<double, 3>;
+    using tree3  = KDtree::flatTree<double, 3>;
 
     std::vector<point3> points;
 
@@ -462,16 +462,24 @@ main(int argc, char **argv)
 
     // Share the density computation among the nodes
     //
+    std::vector<int> which;
+    std::vector<point3> query;
     for (int k=0; k<points.size(); k++) {
       if (k % numprocs == myid) {
-	auto ret = tree.nearestN(points[k], Ndens);
-	double volume = 4.0*M_PI/3.0*std::pow(std::get<2>(ret), 3.0);
-	if (volume>0.0 and KDmass>0.0)
-	  KDdens[k] = std::get<1>(ret)/volume/KDmass;
-	else badVol++;
+	which.push_back(k);
+	query.push_back(points[k]);
       }
     }
 
+    auto res = tree.nearestN(query, Ndens);
+
+    for (size_t q=0; q<which.size(); q++) {
+      double volume = 4.0*M_PI/3.0*std::pow(res[q].second, 3.0);
+      if (volume>0.0 and KDmass>0.0)
+	KDdens[which[q]] = res[q].first/volume/KDmass;
+      else badVol++;
+    }
+
     MPI_Allreduce(MPI_IN_PLACE, KDdens.data(), nbod,
 		  MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
 
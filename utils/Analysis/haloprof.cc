@@ -812,7 +812,7 @@ main(int argc, char **argv)
       //
       if (KD) {
 	using point3 = KDtree::point <double, 3>;
-	using tree3  = KDtree::kdtree<double, 3>;
+	using tree3  = KDtree::flatTree<double, 3>;
 
 	std::vector<point3> points;
 
@@ -851,12 +851,14 @@ main(int argc, char **argv)
 	tree3 tree(points.begin(), points.end());
     
 	int nbods = particles.size();
+	std::vector<point3> query(points.begin(), points.begin()+nbods);
+	auto res = tree.nearestN(query, Ndens);
+
 	for (int i=0; i<nbods; i++) {
-	  auto ret = tree.nearestN(points[i], Ndens);
-	  double volume = 4.0*M_PI/3.0*std::pow(std::get<2>(ret), 3.0);
+	  double volume = 4.0*M_PI/3.0*std::pow(res[i].second, 3.0);
 	  double density = 0.0;
 	  if (volume>0.0 and KDmass>0.0)
-	    density = std::get<1>(ret)/volume/KDmass;
+	    density = res[i].first/volume/KDmass;
 	  for (int k=0; k<3; k++) com[k] += density * points[i].get(k);
 	  mastot += density;
 	}
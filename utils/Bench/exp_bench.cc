@@ -0,0 +1,738 @@
+/*
+  Micro-benchmarks for the core EXP kernels
+
+  Each benchmark times a pass of a kernel over a fixed, seeded set of
+  particles (or radii, or abscissae) at a standard basis size and
+  reports the median time per pass as ns per item and as the nominal
+  memory traffic in GB/s.  Results are printed as a table and may be
+  written as JSON for comparison between releases.
+*/
+
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <regex>
+
+#include <unistd.h>
+
+#include <Eigen/Eigen>
+#include <yaml-cpp/yaml.h>
+
+#include <localmpi.H>
+#include <libvars.H>
+#include <massmodel.H>
+#include <SLGridMP2.H>
+#include <EmpCylSL.H>
+#include <BiorthCyl.H>
+#include <BiorthBasis.H>
+#include <ParticleReader.H>
+#include <Particle.H>
+#include <cxxopts.H>
+
+#include "Basis.H"
+#include "ParticleFerry.H"
+
+//! One benchmark
+struct Bench
+{
+  //! Name (group/kernel)
+  std::string name;
+
+  //! Size parameters for the report
+  std::string params;
+
+  //! Items (particles, radii, ...) per pass
+  size_t items;
+
+  //! Nominal bytes moved per pass
+  size_t bytes;
+
+  //! Done once before timing; returns false to skip
+  std::function<bool()> setup;
+
+  //! One timed pass
+  std::function<void()> body;
+};
+
+//! One result
+struct Result
+{
+  std::string name, params;
+  size_t items, bytes;
+  int reps;
+  double median, best;
+};
+
+//! Keeps the optimizer from discarding results
+static volatile double sink;
+
+// Legendre functions are members of the force Basis; this exposes them
+//
+class LegendreBasis : public Basis
+{
+private:
+
+  void initialize() {}
+  void determine_coefficients(void) {}
+  void * determine_coefficients_thread(void * arg) { return 0; }
+  void determine_acceleration_and_potential(void) {}
+  void * determine_acceleration_and_potential_thread(void * arg) { return 0; }
+
+public:
+
+  LegendreBasis(const YAML::Node& conf) : Basis(0, conf) {}
+
+  void get_acceleration_and_potential(Component*) {}
+
+  void determine_fields_at_point
+  (double x, double y, double z,
+   double *tdens0, double *tpotl0, double *tdens, double *tpotl,
+   double *tpotx, double *tpoty, double *tpotz) {}
+
+  void determine_fields_at_point_sph
+  (double r, double theta, double phi,
+   double *tdens0, double *dpotl0, double *tdens, double *tpotl,
+   double *tpotr, double *tpott, double *tpotp) {}
+
+  void determine_fields_at_point_cyl
+  (double r, double z, double phi,
+   double *tdens0, double *dpotl0, double *tdens, double *tpotl,
+   double *tpotr, double *tpotz, double *tpotp) {}
+};
+
+// Hernquist model table for the spherical basis
+//
+static std::shared_ptr<SphericalModelTable>
+hernquist(double rmin, double rmax, int num)
+{
+  std::vector<double> r(num), d(num), m(num), p(num);
+  double lrmin = log(rmin), dlr = (log(rmax) - lrmin)/(num-1);
+
+  for (int i=0; i<num; i++) {
+    double x = exp(lrmin + dlr*i), y = x + 1.0;
+    r[i] = x;
+    d[i] = 1.0/(2.0*M_PI*x*y*y*y);
+    m[i] = x*x/(y*y);
+    p[i] = -1.0/y;
+  }
+
+  return std::make_shared<SphericalModelTable>(r, d, m, p);
+}
+
+// Positions drawn from a Hernquist sphere truncated at rmax
+//
+static void hernquistSample(std::mt19937& gen, int N, double rmax,
+			    std::vector<double>& x, std::vector<double>& y,
+			    std::vector<double>& z)
+{
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  double mmax = rmax*rmax/((1.0 + rmax)*(1.0 + rmax));
+
+  x.resize(N); y.resize(N); z.resize(N);
+
+  for (int i=0; i<N; i++) {
+    double s  = sqrt(mmax*unit(gen));
+    double r  = s/(1.0 - s);
+    double ct = 2.0*unit(gen) - 1.0, st = sqrt(1.0 - ct*ct);
+    double ph = 2.0*M_PI*unit(gen);
+    x[i] = r*st*cos(ph);
+    y[i] = r*st*sin(ph);
+    z[i] = r*ct;
+  }
+}
+
+// Time the benchmarks that match the filter
+//
+static std::vector<Result>
+run(std::vector<Bench>& list, const std::regex& filter,
+    double mintime, int minreps)
+{
+  std::vector<Result> ret;
+
+  for (auto & b : list) {
+
+    if (not std::regex_search(b.name, filter)) continue;
+
+    if (not b.setup()) {
+      std::cout << std::setw(32) << std::left << b.name
+		<< " skipped" << std::endl;
+      continue;
+    }
+
+    b.body();			// Warm up
+
+    std::vector<double> t;
+    double total = 0.0;
+
+    while (t.size() < minreps or total < mintime) {
+      auto beg = std::chrono::steady_clock::now();
+      b.body();
+      std::chrono::duration<double> dt = std::chrono::steady_clock::now() - beg;
+      t.push_back(dt.count());
+      total += t.back();
+    }
+
+    std::sort(t.begin(), t.end());
+
+    Result r {b.name, b.params, b.items, b.bytes, int(t.size()),
+	      t[t.size()/2], t[0]};
+
+    std::cout << std::setw(32) << std::left  << r.name
+	      << std::setw(24) << std::left  << r.params
+	      << std::setw(12) << std::right << std::fixed
+	      << std::setprecision(2) << r.median/r.items*1.0e9
+	      << std::setw(12) << std::right << std::fixed
+	      << std::setprecision(3) << r.bytes/r.median*1.0e-9
+	      << std::setw(8)  << r.reps << std::endl;
+
+    ret.push_back(r);
+
+    b.body = nullptr;		// Release the captured state
+    b.setup = nullptr;
+  }
+
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  int N, seed, lmax, nmax, numr, cubeN, minreps, ndattr, niattr;
+  double mintime, rmin, rmax;
+  std::string filter, jsonfile, cylcache, flatdisk, tmpdir;
+  std::vector<std::string> readers;
+
+  // Parse command line
+  //
+  cxxopts::Options options
+    (argv[0],
+     "Micro-benchmarks for the core EXP kernels.  Each benchmark reports\n"
+     "the median time per item in ns and the nominal memory traffic in\n"
+     "GB/s.  The cylindrical, flat-disk and reader benchmarks need a\n"
+     "basis cache, configuration or snapshot and are skipped otherwise.\n");
+
+  options.add_options()
+    ("h,help",     "Print this help message")
+    ("list",       "List the benchmarks and exit")
+    ("f,filter",   "Run benchmarks whose names match this regular expression",
+     cxxopts::value<std::string>(filter)->default_value("."))
+    ("N,number",   "Number of particles per pass",
+     cxxopts::value<int>(N)->default_value("100000"))
+    ("seed",       "Random number seed",
+     cxxopts::value<int>(seed)->default_value("11"))
+    ("mintime",    "Minimum timing period per benchmark in seconds",
+     cxxopts::value<double>(mintime)->default_value("0.5"))
+    ("minreps",    "Minimum number of timed passes per benchmark",
+     cxxopts::value<int>(minreps)->default_value("5"))
+    ("lmax",       "Harmonic order for the spherical basis and Legendre functions",
+     cxxopts::value<int>(lmax)->default_value("6"))
+    ("nmax",       "Radial order for the spherical basis",
+     cxxopts::value<int>(nmax)->default_value("18"))
+    ("numr",       "Radial grid size for the spherical basis",
+     cxxopts::value<int>(numr)->default_value("2000"))
+    ("rmin",       "Inner radius for the spherical basis",
+     cxxopts::value<double>(rmin)->default_value("0.0001"))
+    ("rmax",       "Outer radius for the spherical basis and particles",
+     cxxopts::value<double>(rmax)->default_value("2.0"))
+    ("cube",       "Maximum wave number per dimension for the cube basis",
+     cxxopts::value<int>(cubeN)->default_value("6"))
+    ("niattr",     "Integer attributes per particle for the I/O benchmarks",
+     cxxopts::value<int>(niattr)->default_value("0"))
+    ("ndattr",     "Real attributes per particle for the I/O benchmarks",
+     cxxopts::value<int>(ndattr)->default_value("0"))
+    ("cylcache",   "EmpCylSL cache file for the cylindrical benchmarks",
+     cxxopts::value<std::string>(cylcache)->default_value(""))
+    ("flatdisk",   "YAML parameter file for the BiorthCyl benchmark",
+     cxxopts::value<std::string>(flatdisk)->default_value(""))
+    ("reader",     "Reader benchmark as type:file (may be repeated)",
+     cxxopts::value<std::vector<std::string>>(readers))
+    ("tmpdir",     "Directory for the scratch files of the write benchmark",
+     cxxopts::value<std::string>(tmpdir)->default_value("/tmp"))
+    ("json",       "Write the results to this file as JSON",
+     cxxopts::value<std::string>(jsonfile)->default_value(""))
+    ;
+
+  cxxopts::ParseResult vm;
+
+  try {
+    vm = options.parse(argc, argv);
+  } catch (cxxopts::OptionException& e) {
+    std::cout << "Option error: " << e.what() << std::endl;
+    return 2;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options.help() << std::endl << std::endl;
+    return 1;
+  }
+
+  //===================
+  // MPI preliminaries
+  //===================
+
+  local_init_mpi(argc, argv);
+
+  SLGridSph::mpi = 0;		// Each process times on its own
+
+  // The particle sample, shared by the benchmarks
+  //
+  std::mt19937 gen(seed);
+  std::vector<double> X, Y, Z, R, Rcyl, Phi, Cth;
+
+  hernquistSample(gen, N, rmax, X, Y, Z);
+
+  R.resize(N); Rcyl.resize(N); Phi.resize(N); Cth.resize(N);
+  for (int i=0; i<N; i++) {
+    Rcyl[i] = sqrt(X[i]*X[i] + Y[i]*Y[i]);
+    R[i]    = sqrt(Rcyl[i]*Rcyl[i] + Z[i]*Z[i]);
+    Phi[i]  = atan2(Y[i], X[i]);
+    Cth[i]  = Z[i]/(R[i] + 1.0e-18);
+  }
+
+  const double mass = 1.0/N;
+
+  std::vector<Bench> list;
+
+  std::ostringstream sout;
+
+  //====================
+  // Spherical SL basis
+  //====================
+
+  auto sph = std::make_shared<std::shared_ptr<SLGridSph>>();
+  auto sphSetup = [=]()
+  {
+    if (not *sph)
+      *sph = std::make_shared<SLGridSph>
+	(hernquist(rmin, 10.0*rmax, 4000), lmax, nmax, numr, rmin, rmax,
+	 false, 1, 1.0);
+    return true;
+  };
+
+  sout.str(""); sout << "lmax=" << lmax << " nmax=" << nmax;
+  std::string sphParam = sout.str();
+  size_t sphTab = (lmax+1)*nmax*sizeof(double);
+
+  list.push_back
+    ({"sph/get_pot", sphParam, size_t(N), 3*sphTab*N, sphSetup,
+      [=]() {
+	Eigen::MatrixXd tab;
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  (*sph)->get_pot(tab, R[i]);
+	  s += tab(0, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"sph/get_force", sphParam, size_t(N), 3*sphTab*N, sphSetup,
+      [=]() {
+	Eigen::MatrixXd tab;
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  (*sph)->get_force(tab, R[i]);
+	  s += tab(0, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"sph/get_pot_batch", sphParam, size_t(N), 3*sphTab*N, sphSetup,
+      [=]() {
+	const int nb = 256;
+	Eigen::MatrixXd tab;
+	double s = 0.0;
+	for (int i=0; i<N; i+=nb) {
+	  (*sph)->get_pot_batch(tab, &R[i], std::min(nb, N-i));
+	  s += tab(0, 0);
+	}
+	sink = s;
+      }});
+
+  //====================
+  // Legendre functions
+  //====================
+
+  YAML::Node empty;
+  auto leg = std::make_shared<LegendreBasis>(empty);
+
+  sout.str(""); sout << "lmax=" << lmax;
+  std::string legParam = sout.str();
+  size_t legTab = (lmax+1)*(lmax+1)*sizeof(double);
+
+  list.push_back
+    ({"legendre/legendre_R", legParam, size_t(N), legTab*N,
+      []() { return true; },
+      [=]() {
+	Eigen::MatrixXd p(lmax+1, lmax+1);
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  leg->legendre_R(lmax, Cth[i], p);
+	  s += p(lmax, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"legendre/dlegendre_R", legParam, size_t(N), 2*legTab*N,
+      []() { return true; },
+      [=]() {
+	Eigen::MatrixXd p(lmax+1, lmax+1), dp(lmax+1, lmax+1);
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  leg->dlegendre_R(lmax, Cth[i], p, dp);
+	  s += dp(lmax, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"legendre/legendre_R_batch", legParam, size_t(N), legTab*N,
+      []() { return true; },
+      [=]() {
+	const int nb = 256;
+	Eigen::MatrixXd p;
+	double s = 0.0;
+	for (int i=0; i<N; i+=nb) {
+	  leg->legendre_R(lmax, std::min(nb, N-i), &Cth[i], p);
+	  s += p(0, 0);
+	}
+	sink = s;
+      }});
+
+  //====================
+  // Cylindrical basis
+  //====================
+
+  auto cyl = std::make_shared<std::shared_ptr<EmpCylSL>>();
+  auto cylSetup = [=]()
+  {
+    if (cylcache.size()==0) return false;
+    if (not *cyl) {
+      *cyl = std::make_shared<EmpCylSL>(std::numeric_limits<int>::max(),
+					cylcache);
+      if ((*cyl)->read_cache()==0) {
+	std::cout << "exp_bench: could not read <" << cylcache << ">"
+		  << std::endl;
+	cyl->reset();
+	return false;
+      }
+    }
+    return true;
+  };
+
+  std::string cylParam = "cache";
+  size_t cylTab = 0;
+  if (cylcache.size()) {
+    auto info = EmpCylSL::cacheInfo(cylcache, false);
+    int mm = std::stoi(info["mmax"]), nn = std::stoi(info["nmax"]);
+    sout.str(""); sout << "mmax=" << mm << " nmax=" << nn;
+    cylParam = sout.str();
+    // Four interpolation corners of the cos and sin tables per order
+    cylTab = 4*(2*mm+1)*nn*sizeof(double);
+  }
+
+  list.push_back
+    ({"cyl/accumulate", cylParam, size_t(N), cylTab*N, cylSetup,
+      [=]() {
+	(*cyl)->setup_accumulation();
+	for (int i=0; i<N; i++)
+	  (*cyl)->accumulate(Rcyl[i], Z[i], Phi[i], mass, i, 0);
+      }});
+
+  list.push_back
+    ({"cyl/accumulated_eval", cylParam, size_t(N), 2*cylTab*N,
+      [=]() {
+	if (not cylSetup()) return false;
+	(*cyl)->setup_accumulation();
+	for (int i=0; i<N; i++)
+	  (*cyl)->accumulate(Rcyl[i], Z[i], Phi[i], mass, i, 0);
+	(*cyl)->make_coefficients();
+	return true;
+      },
+      [=]() {
+	double p0, p, fr, fz, fp, s = 0.0;
+	for (int i=0; i<N; i++) {
+	  (*cyl)->accumulated_eval(Rcyl[i], Z[i], Phi[i], p0, p, fr, fz, fp);
+	  s += p;
+	}
+	sink = s;
+      }});
+
+  //====================
+  // BiorthCyl tables
+  //====================
+
+  auto bio = std::make_shared<std::shared_ptr<BiorthCyl>>();
+  auto bioConf = std::make_shared<YAML::Node>();
+
+  auto bioSetup = [=]() {
+    if (flatdisk.size()==0) return false;
+    if (not *bio) {
+      *bioConf = YAML::LoadFile(flatdisk);
+      *bio = std::make_shared<BiorthCyl>(*bioConf);
+    }
+    return true;
+  };
+
+  list.push_back
+    ({"biorthcyl/get_pot", flatdisk.size() ? "config" : "", size_t(N),
+      0, bioSetup,
+      [=]() {
+	Eigen::MatrixXd p;
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  (*bio)->get_pot(p, Rcyl[i], Z[i]);
+	  s += p(0, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"biorthcyl/get_all", flatdisk.size() ? "config" : "", size_t(N),
+      0, bioSetup,
+      [=]() {
+	Eigen::MatrixXd d, p, fr, fz;
+	double s = 0.0;
+	for (int i=0; i<N; i++) {
+	  (*bio)->get_all(d, p, fr, fz, Rcyl[i], Z[i]);
+	  s += p(0, 0);
+	}
+	sink = s;
+      }});
+
+  list.push_back
+    ({"biorthcyl/batch", flatdisk.size() ? "config" : "", size_t(N),
+      0, bioSetup,
+      [=]() {
+	constexpr int B = 256;
+	std::vector<double> out(B*(*bio)->batchSize());
+	double s = 0.0;
+	for (int i=0; i<N; i+=B) {
+	  int n = std::min<int>(B, N-i);
+	  (*bio)->get_all(n, &Rcyl[i], &Z[i], out.data());
+	  s += out[1];
+	}
+	sink = s;
+      }});
+
+  //====================
+  // Cube basis
+  //====================
+
+  auto cube = std::make_shared<std::shared_ptr<BasisClasses::Cube>>();
+  sout.str(""); sout << "nmax=" << cubeN;
+  std::string cubeParam = sout.str();
+  size_t cubeCoef = (2*cubeN+1)*(2*cubeN+1)*(2*cubeN+1)*2*sizeof(double);
+
+  list.push_back
+    ({"cube/accumulate", cubeParam, size_t(N), cubeCoef*N,
+      [=]() {
+	if (not *cube) {
+	  std::ostringstream conf;
+	  conf << "id: cube" << std::endl
+	       << "parameters: {nmaxx: " << cubeN << ", nmaxy: " << cubeN
+	       << ", nmaxz: " << cubeN << "}" << std::endl;
+	  *cube = std::make_shared<BasisClasses::Cube>(conf.str());
+	}
+	return true;
+      },
+      [=]() {
+	(*cube)->reset_coefs();
+	for (int i=0; i<N; i++)
+	  (*cube)->accumulate(X[i]/rmax, Y[i]/rmax, Z[i]/rmax, mass);
+      }});
+
+  //====================
+  // Particle I/O
+  //====================
+
+  auto parts = std::make_shared<std::vector<PartPtr>>();
+  auto partSetup = [=]()
+  {
+    if (parts->size()) return true;
+    std::uniform_real_distribution<double> unit(-1.0, 1.0);
+    std::mt19937 pgen(seed+1);
+    for (int i=0; i<N; i++) {
+      auto p = std::make_shared<Particle>(niattr, ndattr);
+      p->mass = mass;
+      p->indx = i+1;
+      p->pos[0] = X[i]; p->pos[1] = Y[i]; p->pos[2] = Z[i];
+      for (int k=0; k<3; k++) p->vel[k] = unit(pgen);
+      for (auto & v : p->iattrib) v = i;
+      for (auto & v : p->dattrib) v = unit(pgen);
+      parts->push_back(p);
+    }
+    return true;
+  };
+
+  sout.str(""); sout << "ni=" << niattr << " nd=" << ndattr;
+  std::string ioParam = sout.str();
+
+  auto ferry = std::make_shared<ParticleFerry>(niattr, ndattr);
+  size_t fsize = ferry->getBufsize();
+  auto fbuf = std::make_shared<std::vector<char>>(fsize*N);
+
+  list.push_back
+    ({"ferry/pack", ioParam, size_t(N), 2*fsize*N, partSetup,
+      [=]() {
+	char *b = fbuf->data();
+	for (int i=0; i<N; i++) ferry->particlePack((*parts)[i], b + i*fsize);
+      }});
+
+  list.push_back
+    ({"ferry/unpack", ioParam, size_t(N), 2*fsize*N,
+      [=]() {
+	partSetup();
+	char *b = fbuf->data();
+	for (int i=0; i<N; i++) ferry->particlePack((*parts)[i], b + i*fsize);
+	return true;
+      },
+      [=]() {
+	char *b = fbuf->data();
+	for (int i=0; i<N; i++) ferry->particleUnpack((*parts)[i], b + i*fsize);
+      }});
+
+  std::string scratch = tmpdir + "/exp_bench." + std::to_string(getpid());
+
+  for (unsigned rsize : {sizeof(float), sizeof(double)}) {
+
+    Particle proto(niattr, ndattr);
+    size_t psize = proto.getMPIBufSize(rsize, true);
+
+    list.push_back
+      ({rsize==sizeof(float) ? "particle/writeBinaryBuffered/float" :
+	"particle/writeBinaryBuffered/double", ioParam, size_t(N), psize*N,
+	partSetup,
+	[=]() {
+	  std::ofstream out(scratch, std::ios::binary | std::ios::trunc);
+	  ParticleBuffer buf(rsize, true, (*parts)[0].get());
+	  for (auto & p : *parts) p->writeBinaryBuffered(rsize, true, &out, buf);
+	  buf.writeBuffer(&out, true);
+	}});
+  }
+
+  //====================
+  // Particle readers
+  //====================
+
+  for (auto & spec : readers) {
+
+    auto pos = spec.find(':');
+    if (pos == std::string::npos) {
+      std::cout << "exp_bench: reader <" << spec
+		<< "> is not of the form type:file" << std::endl;
+      continue;
+    }
+
+    std::string type = spec.substr(0, pos);
+    std::vector<std::string> files = {spec.substr(pos+1)};
+
+    size_t fbytes = 0;
+    {
+      std::ifstream in(files[0], std::ios::binary | std::ios::ate);
+      if (in) fbytes = in.tellg();
+    }
+
+    // Count the particles once; this also checks the reader
+    //
+    size_t count = 0;
+    try {
+      auto rd = PR::ParticleReader::createReader(type, files, 0, false);
+      for (auto p=rd->firstParticle(); p!=0; p=rd->nextParticle()) count++;
+    }
+    catch (std::exception& e) {
+      std::cout << "exp_bench: reader <" << spec << "> failed: "
+		<< e.what() << std::endl;
+    }
+
+    list.push_back
+      ({"reader/" + type, files[0], count, fbytes,
+	[=]() { return count > 0; },
+	[=]() {
+	  auto rd = PR::ParticleReader::createReader(type, files, 0, false);
+	  double s = 0.0;
+	  for (auto p=rd->firstParticle(); p!=0; p=rd->nextParticle())
+	    s += p->mass;
+	  sink = s;
+	}});
+  }
+
+  if (vm.count("list")) {
+    for (auto & b : list) std::cout << b.name << std::endl;
+    MPI_Finalize();
+    return 0;
+  }
+
+  //====================
+  // Run
+  //====================
+
+  // Only the root process times
+  //
+  std::vector<Result> results;
+
+  if (myid==0) {
+    std::cout << std::setw(32) << std::left  << "Benchmark"
+	      << std::setw(24) << std::left  << "Size"
+	      << std::setw(12) << std::right << "ns/item"
+	      << std::setw(12) << std::right << "GB/s"
+	      << std::setw(8)  << std::right << "Reps" << std::endl
+	      << std::string(88, '-') << std::endl;
+
+    results = run(list, std::regex(filter), mintime, minreps);
+
+    std::remove(scratch.c_str());
+  }
+
+  //====================
+  // JSON output
+  //====================
+
+  if (myid==0 and jsonfile.size()) {
+
+    std::ofstream out(jsonfile);
+    if (out) {
+      char host[256];
+      gethostname(host, 256);
+
+      out << "{" << std::endl
+	  << "  \"context\": {\"host\": \"" << host << "\", \"nthrds\": "
+	  << nthrds << ", \"seed\": " << seed << ", \"N\": " << N
+	  << "}," << std::endl
+	  << "  \"benchmarks\": [" << std::endl;
+
+      for (size_t j=0; j<results.size(); j++) {
+	auto & r = results[j];
+	out << "    {\"name\": \""   << r.name   << "\""
+	    << ", \"params\": \""    << r.params << "\""
+	    << ", \"items\": "       << r.items
+	    << ", \"reps\": "        << r.reps
+	    << ", \"median_s\": "    << r.median
+	    << ", \"best_s\": "      << r.best
+	    << ", \"ns_per_item\": " << r.median/r.items*1.0e9
+	    << ", \"GB_per_s\": "    << r.bytes/r.median*1.0e-9
+	    << "}" << (j+1<results.size() ? "," : "") << std::endl;
+      }
+
+      out << "  ]" << std::endl << "}" << std::endl;
+    } else {
+      std::cout << "exp_bench: could not open <" << jsonfile << ">"
+		<< std::endl;
+    }
+  }
+
+  MPI_Finalize();
+
+  return 0;
+}
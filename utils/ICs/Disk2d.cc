@@ -132,10 +132,16 @@ void Disk2d::setup_accum()
   potd.resize(nthrds);
   for (auto & v : potd) v.resize(2*mmax+1, nmax);
     
-  dend.resize(2*mmax+1, nmax);
-  potl.resize(2*mmax+1, nmax);
-  potr.resize(2*mmax+1, nmax);
-  potz.resize(2*mmax+1, nmax);
+  dend.resize(nthrds);
+  potl.resize(nthrds);
+  potr.resize(nthrds);
+  potz.resize(nthrds);
+  for (int i=0; i<nthrds; i++) {
+    dend[i].resize(2*mmax+1, nmax);
+    potl[i].resize(2*mmax+1, nmax);
+    potr[i].resize(2*mmax+1, nmax);
+    potz[i].resize(2*mmax+1, nmax);
+  }
 
   cylmass1.resize(nthrds);
   expcoef0.resize(nthrds);
@@ -278,20 +284,22 @@ Disk2d::accumulated_eval(double R, double z, double phi)
     
   } else {
 
-    ortho->get_dens  (dend, R, z);
-    ortho->get_pot   (potl, R, z);
-    ortho->get_rforce(potr, R, z);
-    ortho->get_zforce(potz, R, z);
+    int id = omp_get_thread_num();
+
+    ortho->get_dens  (dend[id], R, z);
+    ortho->get_pot   (potl[id], R, z);
+    ortho->get_rforce(potr[id], R, z);
+    ortho->get_zforce(potz[id], R, z);
     
     // m loop
     for (int m=0, moffset=0; m<=mmax; m++) {
 
       if (m==0) {
 	for (int n=0; n<nmax; n++) {
-	  d0 += expcoef(moffset, n)*norm0 * dend(m, n);
-	  p0 += expcoef(moffset, n)*norm0 * potl(m, n);
-	  fr += expcoef(moffset, n)*norm0 * potr(m, n);
-	  fz += expcoef(moffset, n)*norm0 * potz(m, n);
+	  d0 += expcoef(moffset, n)*norm0 * dend[id](m, n);
+	  p0 += expcoef(moffset, n)*norm0 * potl[id](m, n);
+	  fr += expcoef(moffset, n)*norm0 * potr[id](m, n);
+	  fz += expcoef(moffset, n)*norm0 * potz[id](m, n);
 	}
 	
 	moffset++;
@@ -302,15 +310,15 @@ Disk2d::accumulated_eval(double R, double z, double phi)
 
 	for (int n=0; n<nmax; n++) {
 	  d1 += ( expcoef(moffset, n)*cosm + expcoef(moffset+1, n)*sinm )*norm1*
-	    dend(m, n);
+	    dend[id](m, n);
 	  p1 += ( expcoef(moffset, n)*cosm + expcoef(moffset+1, n)*sinm )*norm1*
-	    potl(m, n);
+	    potl[id](m, n);
 	  fr += ( expcoef(moffset, n)*cosm + expcoef(moffset+1, n)*sinm )*norm1*
-	    potr(m, n);
+	    potr[id](m, n);
 	  fz += ( expcoef(moffset, n)*cosm + expcoef(moffset+1, n)*sinm )*norm1*
-	    potz(m, n);
+	    potz[id](m, n);
 	  fp += (-expcoef(moffset, n)*sinm + expcoef(moffset+1, n)*cosm )*norm1*
-	    potl(m, n);
+	    potl[id](m, n);
 	}
 
 	moffset += 2;
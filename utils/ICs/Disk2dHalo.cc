@@ -11,6 +11,9 @@
 #include <memory>
 #include <vector>
 #include <limits>
+
+#include <omp.h>
+
 				// EXP classes
 #include <interp.H>
 #include <numerical.H>
@@ -85,7 +88,6 @@ Disk2dHalo()
   DF         = false;
   MULTI      = false;
   type       = Jeans;
-  bufcnt     = 0;
 }
 
 Disk2dHalo::
@@ -169,7 +171,6 @@ Disk2dHalo(SphericalSLptr haloexp, std::shared_ptr<Disk2d> diskexp,
 
   // For buffered ascii writes
   //
-  bufcnt = 0;
 }
 
 Disk2dHalo::
@@ -298,7 +299,6 @@ Disk2dHalo(SphericalSLptr haloexp, std::shared_ptr<Disk2d> diskexp,
 
   // For buffered ascii writes
   //
-  bufcnt = 0;
 }
 
 
@@ -348,7 +348,6 @@ Disk2dHalo::Disk2dHalo(const Disk2dHalo &p)
   Xmin  = p.Xmin;
   Xmax  = p.Xmax;
 
-  bufcnt = 0;
 }
 
 double Disk2dHalo::disk_surface_density(double R)
@@ -1053,6 +1052,11 @@ epi(double xp, double yp, double zp)
 	cp[1]* epitable(iphi2, j) ;
     }
 
+    // Log the range error; epi() is called from the threaded
+    // velocity loop
+    //
+#pragma omp critical (epi_range_error)
+    {
     ostringstream sout;
     sout << "epi_range_error." << RUNTAG << "." << myid;
     ofstream out(sout.str().c_str(), ios::app);
@@ -1074,8 +1078,6 @@ epi(double xp, double yp, double zp)
 	  << "    ep6=" << epitable(iphi2, j)     << std::endl
 	  << std::endl;
 
-      return sqrt(ans);
-
     } else {
 
       out << "Process " << myid << " epi range error [unresolved]" << std::endl
@@ -1094,10 +1096,13 @@ epi(double xp, double yp, double zp)
 	  << "    ep4=" << epitable(iphi2, ir2)   << std::endl
 	  << std::endl;
 
+    }
+    }
+
+    if (not ok)
       ans = cp[0]*epitable(iphi1, nzepi) + cp[1]*epitable(iphi2, nzepi);
-      return sqrt(ans);
 
-    }
+    return sqrt(ans);
   }
 }
 
@@ -1114,6 +1119,7 @@ table_disk(vector<Particle>& part)
   epitable.resize(NDP, NDR);
   dv2table.resize(NDP, NDR);
   asytable.resize(NDP, NDR);
+  vctable .resize(NDP, NDR);
 
   dP = 2.0*M_PI/NDP;
 
@@ -1286,6 +1292,9 @@ table_disk(vector<Particle>& part)
 				// r^2*[1/r dPhi/dr]^{1/2} = r^2 * Omega
       workQ2[j]   = workQ[j] * R*R;
 
+				// R*dPhi/dR = v_c^2 for v_circ()
+      vctable(i, j) = R*(-fr + dpr);
+
       workQ3[j]   = -fr;	// For testing only
       workQ4[j]   = dpr;	// For testing only
       workQ5[j]   = pot;	// For testing only
@@ -1394,6 +1403,9 @@ table_disk(vector<Particle>& part)
       if (k == myid) Z = asytable.row(i);
       MPI_Bcast(Z.data(), NDR, MPI_DOUBLE, k, MPI_COMM_WORLD);
       if (k != myid) asytable.row(i) = Z; 
+      if (k == myid) Z = vctable.row(i);
+      MPI_Bcast(Z.data(), NDR, MPI_DOUBLE, k, MPI_COMM_WORLD);
+      if (k != myid) vctable.row(i) = Z; 
     }
   }
 
@@ -1649,7 +1661,42 @@ double Disk2dHalo::a_drift(double xp, double yp, double zp)
 double Disk2dHalo::v_circ(double xp, double yp, double zp)
 {
   double R = sqrt(xp*xp + yp*yp);
-  double vcirc2 = R*deri_pot(xp, yp, 0.0, 1);
+  double vcirc2;
+
+  // Interpolate the table made by table_disk; this is the same
+  // bilinear scheme in phi and log(R) as epi() and a_drift()
+  //
+  if (vctable.size()) {
+    double phi = atan2(yp, xp);
+    if (phi<0.0) phi = 2.0*M_PI + phi;
+
+    int iphi1 = floor( phi/dP );
+    iphi1 = std::min<int>(iphi1, NDP-1);
+    int iphi2 = iphi1 + 1;
+    if (iphi1==NDP-1) iphi2 = 0; // Modulo 2Pi
+
+    double cp[2], cr[2];
+
+    cp[1] = (phi - dP*iphi1)/dP;
+    cp[0] = 1.0 - cp[1];
+
+    double lR = log(max<double>(R, RDMIN));
+    int ir1 = floor( (lR - log(RDMIN))/dR );
+    ir1 = min<int>( ir1, NDR-2 );
+    ir1 = max<int>( ir1, 0 );
+    int ir2 = ir1 + 1;
+
+    cr[1] = (lR - log(RDMIN) - dR*ir1)/dR;
+    cr[0] = 1.0 - cr[1];
+
+    vcirc2 =
+      cp[0]*cr[0] * vctable(iphi1, ir1) +
+      cp[0]*cr[1] * vctable(iphi1, ir2) +
+      cp[1]*cr[0] * vctable(iphi2, ir1) +
+      cp[1]*cr[1] * vctable(iphi2, ir2) ;
+  }
+  else
+    vcirc2 = R*deri_pot(xp, yp, 0.0, 1);
 
 				// Sanity check
   if (vcirc2<=0.0) {
@@ -1671,10 +1718,8 @@ set_vel_disk(vector<Particle>& part)
     return;
   }
 
-  double vvZ, vvR, vvP;
   double maxVR=-1.0e20, RVR=1e20;
   double maxVP=-1.0e20, RVP=1e20;
-  double vr, vp, R, x, y, z, ac, vc, va, as, ad;
   double vel[3], vel1[3], massp, massp1;
   unsigned num_oob = 0;
 
@@ -1706,184 +1751,226 @@ set_vel_disk(vector<Particle>& part)
   }
 
 
-  for (auto &p : part) {
-				// From solution to Jeans' equations in
-				// cylindrical coordinates
-    x = p.pos[0];
-    y = p.pos[1];
-    z = p.pos[2];
-
-    R = sqrt(x*x + y*y) + std::numeric_limits<double>::min();
-
-    vvR = vr_disp2(x, y, z);
-
-    if (type == Jeans)
-      vvP = vvR/(XI*XI);
-    else
-      vvP = vp_disp2(x, y, z);
-				 // For safety; should only be a problem
-				 // on extrapolating the range
-    vvR = std::max<double>(vvR, std::numeric_limits<double>::min());
-    vvP = std::max<double>(vvP, std::numeric_limits<double>::min());
-    
-    if (maxVR < vvR) {
-      maxVR = vvR;
-      RVR   = R;
-      if (VFLAG & 8)
-	std::cout << "maxVR: vvR = " << vvR
-		  << " x=" << x << " y=" << y
-		  << " epi=" << epi(x, y, 0.0)
-		  << " sig=" << disk_surface_density(R)
-		  << std::endl;
-
-    }
-    if (maxVP < vvP) {
-      maxVP = vvP;
-      RVP   = R;
-    }
-
-    // Circular velocity
-    vc   = v_circ(x, y, z);
-
-    // No asymmetric drift correction by default
-    ac = 0.0;
-
-    switch (type) {
-    case Asymmetric:
-      // Asymmetric drift correction
-      ad = a_drift(x, y, z);
-      as = 1 + vvR*ad/(vc*vc);
-
-      if (as > 0.0 and not std::isnan(as))
-	ac = vc*(1.0-sqrt(as));
-      else {
-	if (as<0.0 or std::isnan(as)) {
-	  ac = vc;
-	  num_oob++;
-	}
+  // The velocities are drawn in parallel from the tables, each
+  // thread with its own stream seeded from the process generator.
+  // The debug output is written in order by a single thread.
+  //
+  bool debug = out.is_open();
+  std::vector<std::mt19937> tgen(omp_get_max_threads());
+  for (auto & g : tgen) g.seed(gen());
+
+#pragma omp parallel if(not debug)
+  {
+    std::mt19937& tg = tgen[omp_get_thread_num()];
+    std::uniform_real_distribution<> unif;
+    std::normal_distribution<> norm;
+
+    double vvR, vvP, vr=0.0, vp=0.0, R, x, y, z, ac, vc, va, as, ad;
+    double tmaxVR=-1.0e20, tRVR=1e20;
+    double tmaxVP=-1.0e20, tRVP=1e20;
+    double tvel[3] = {0.0, 0.0, 0.0}, tmass = 0.0;
+    unsigned toob = 0;
+
+#pragma omp for schedule(dynamic, 256)
+    for (size_t n=0; n<part.size(); n++) {
+      Particle& p = part[n];
+				  // From solution to Jeans' equations in
+				  // cylindrical coordinates
+      x = p.pos[0];
+      y = p.pos[1];
+      z = p.pos[2];
+
+      R = sqrt(x*x + y*y) + std::numeric_limits<double>::min();
+
+      vvR = vr_disp2(x, y, z);
+
+      if (type == Jeans)
+	vvP = vvR/(XI*XI);
+      else
+	vvP = vp_disp2(x, y, z);
+				   // For safety; should only be a problem
+				   // on extrapolating the range
+      vvR = std::max<double>(vvR, std::numeric_limits<double>::min());
+      vvP = std::max<double>(vvP, std::numeric_limits<double>::min());
+    
+      if (tmaxVR < vvR) {
+	tmaxVR = vvR;
+	tRVR   = R;
 	if (VFLAG & 8) {
-	  int op = std::cout.precision(3);
-	  std::cout << "ac oob:"
-		    << " as="   << std::setw(10) << as 
-		    << ", R="   << std::setw(10) << R
-		    << ", ac="  << std::setw(10) << ac
-		    << ", ad="  << std::setw(10) << ad
-		    << ", vc="  << std::setw(10) << vc
-		    << ", vvR=" << std::setw(10) << vvR
+#pragma omp critical
+	  std::cout << "maxVR: vvR = " << vvR
+		    << " x=" << x << " y=" << y
+		    << " epi=" << epi(x, y, 0.0)
+		    << " sig=" << disk_surface_density(R)
 		    << std::endl;
-	  std::cout.precision(op);
 	}
       }
+      if (tmaxVP < vvP) {
+	tmaxVP = vvP;
+	tRVP   = R;
+      }
 
-    case Jeans:
-      va = max<double>(vc - ac, std::numeric_limits<double>::min());
-     
-      vr   = rndN(gen)*sqrt(std::max<double>(vvR, std::numeric_limits<double>::min()));
-      vp   = rndN(gen)*sqrt(std::max<double>(vvP, std::numeric_limits<double>::min()));
-      
-      {
-	double omp   = vc/R;
-	double kappa = epi(x, y, z);
-	double vp2   = vc*vc +	// From radial cylindrical Jeans using
-				// epicyclic closure
-	  vvR * (1.0 - kappa*kappa/(4.0*omp*omp) - 2.0*R/scalelength);
-	if (vp2 >= 0.0) {
-	  vp += sqrt(vp2);
-	} else {
-	  num_oob++;
+      // Circular velocity
+      vc   = v_circ(x, y, z);
+
+      // No asymmetric drift correction by default
+      ac = 0.0;
+
+      switch (type) {
+      case Asymmetric:
+	// Asymmetric drift correction
+	ad = a_drift(x, y, z);
+	as = 1 + vvR*ad/(vc*vc);
+
+	if (as > 0.0 and not std::isnan(as))
+	  ac = vc*(1.0-sqrt(as));
+	else {
+	  if (as<0.0 or std::isnan(as)) {
+	    ac = vc;
+	    toob++;
+	  }
+	  if (VFLAG & 8) {
+#pragma omp critical
+	    {
+	    int op = std::cout.precision(3);
+	    std::cout << "ac oob:"
+		      << " as="   << std::setw(10) << as 
+		      << ", R="   << std::setw(10) << R
+		      << ", ac="  << std::setw(10) << ac
+		      << ", ad="  << std::setw(10) << ad
+		      << ", vc="  << std::setw(10) << vc
+		      << ", vvR=" << std::setw(10) << vvR
+		      << std::endl;
+	    std::cout.precision(op);
+	    }
+	  }
 	}
-      }
 
-      if (out) 
-	out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << vc
-	    << std::setw(14) << va  << std::setw(14) << ac  << std::setw(14) << epi(x, y, z)
-	    << std::setw(14) << vr  << std::setw(14) << vp  
-	    << std::setw(14) << vvR << std::setw(14) << vvP 
-	    << std::setw(14) << vr*x/R - vp*y/R
-	    << std::setw(14) << vr*y/R + vp*x/R
-	    << std::endl;
-      break;
+      case Jeans:
+	va = max<double>(vc - ac, std::numeric_limits<double>::min());
+     
+	vr   = norm(tg)*sqrt(std::max<double>(vvR, std::numeric_limits<double>::min()));
+	vp   = norm(tg)*sqrt(std::max<double>(vvP, std::numeric_limits<double>::min()));
       
-    case Epicyclic:
-      /*
-	Epicyclic theory provides the x position relative to the guiding
-	center for an arbitrary amplitude X for phase alpha = kappa*t:
-
-      		x     = X cos(alpha)
-		dx/dt = -kappa X sin(alpha)
-
-	The phase averaged radial velocity at the guiding center is then:
-
-      		<dx/dt> = 0, <(dx/dt)^2> = kappa*kappa*X*X/2
-
-	Choose X by equating <(dx/dt)^2> = \sigma^2_r:
-
-      		<X>   = 0
-		<X^2> = 2*\sigma^2_r/(kappa*kappa)
-
-	Strictly speaking this is not correct because the contribution
-	to \sigma^2_r comes from many guiding centers.  So this
-	equivlance probably over estimates the second moment in X.
-	Choose X ~ normal with 0 mean and variance <X^2>
-     */
-      {
-				// The normal variant
-	double Xampl = rndN(gen);	
-				// The cylindrical polar angle
-	double phi   = atan2(y, x);
-				// The radial phase (kappa*t)
-	double alpha = 2.0*M_PI*rndU(gen);
-
-				// Initial guess for iteration uses
-				// present positions
-	double kappa = epi(x, y, z);
-	double X     = sqrt(2.0*Xampl*Xampl*vvR/(kappa*kappa));
-
-				// Iterate to get values at guiding
-				// center
-	double Xl, x1, y1, R1, Omg;
-	int cnt = 0;
-	for (int i=0; i<10; i++) {
-	  Xl      = X;
-				// Guiding center estimate
-	  R1      = R - X*cos(alpha);
-				// x,y positions w.r.t. this guiding center
-	  x1      = R1*cos(phi);
-	  y1      = R1*sin(phi);
-				// Epicylic freq at guiding center
-	  kappa   = epi(x1, y1, z);
-	
-				// New amplitude
-	  X       = sqrt(2.0*Xampl*Xampl*vr_disp2(x1, y1, z)/(kappa*kappa));
-
-	  if (fabs((X-Xl)/Xl)<1.0e-6) break;
-	  cnt++;
-	}
-	if (cnt>=100) {
-	  std::cerr << "OOPS" << std::endl;
+	{
+	  double omp   = vc/R;
+	  double kappa = epi(x, y, z);
+	  double vp2   = vc*vc +	// From radial cylindrical Jeans using
+				  // epicyclic closure
+	    vvR * (1.0 - kappa*kappa/(4.0*omp*omp) - 2.0*R/scalelength);
+	  if (vp2 >= 0.0) {
+	    vp += sqrt(vp2);
+	  } else {
+	    toob++;
+	  }
 	}
-				// Aximuthal freq at guiding center
-	Omg  = v_circ(x1, y1, z)/R1;
 
-				// Compute the final velocities
-	vr   = -kappa*X*sin(alpha);
-	vp   = Omg*R1 - 2.0*Omg*X*cos(alpha);
-    
 	if (out) 
-	  out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << Omg*R1
-	      << std::setw(14) << vr  << std::setw(14) << vp
-	      << std::setw(14) << R1  << std::setw(14) << X   << std::setw(14) << kappa
+	  out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << vc
+	      << std::setw(14) << va  << std::setw(14) << ac  << std::setw(14) << epi(x, y, z)
+	      << std::setw(14) << vr  << std::setw(14) << vp  
+	      << std::setw(14) << vvR << std::setw(14) << vvP 
+	      << std::setw(14) << vr*x/R - vp*y/R
+	      << std::setw(14) << vr*y/R + vp*x/R
 	      << std::endl;
+	break;
+      
+      case Epicyclic:
+	/*
+	  Epicyclic theory provides the x position relative to the guiding
+	  center for an arbitrary amplitude X for phase alpha = kappa*t:
+
+		  x     = X cos(alpha)
+		  dx/dt = -kappa X sin(alpha)
+
+	  The phase averaged radial velocity at the guiding center is then:
+
+		  <dx/dt> = 0, <(dx/dt)^2> = kappa*kappa*X*X/2
+
+	  Choose X by equating <(dx/dt)^2> = \sigma^2_r:
+
+		  <X>   = 0
+		  <X^2> = 2*\sigma^2_r/(kappa*kappa)
+
+	  Strictly speaking this is not correct because the contribution
+	  to \sigma^2_r comes from many guiding centers.  So this
+	  equivlance probably over estimates the second moment in X.
+	  Choose X ~ normal with 0 mean and variance <X^2>
+       */
+	{
+				  // The normal variant
+	  double Xampl = norm(tg);	
+				  // The cylindrical polar angle
+	  double phi   = atan2(y, x);
+				  // The radial phase (kappa*t)
+	  double alpha = 2.0*M_PI*unif(tg);
+
+				  // Initial guess for iteration uses
+				  // present positions
+	  double kappa = epi(x, y, z);
+	  double X     = sqrt(2.0*Xampl*Xampl*vvR/(kappa*kappa));
+
+				  // Iterate to get values at guiding
+				  // center
+	  double Xl, x1, y1, R1, Omg;
+	  int cnt = 0;
+	  for (int i=0; i<10; i++) {
+	    Xl      = X;
+				  // Guiding center estimate
+	    R1      = R - X*cos(alpha);
+				  // x,y positions w.r.t. this guiding center
+	    x1      = R1*cos(phi);
+	    y1      = R1*sin(phi);
+				  // Epicylic freq at guiding center
+	    kappa   = epi(x1, y1, z);
+	
+				  // New amplitude
+	    X       = sqrt(2.0*Xampl*Xampl*vr_disp2(x1, y1, z)/(kappa*kappa));
+
+	    if (fabs((X-Xl)/Xl)<1.0e-6) break;
+	    cnt++;
+	  }
+	  if (cnt>=100) {
+	    std::cerr << "OOPS" << std::endl;
+	  }
+				  // Aximuthal freq at guiding center
+	  Omg  = v_circ(x1, y1, z)/R1;
+
+				  // Compute the final velocities
+	  vr   = -kappa*X*sin(alpha);
+	  vp   = Omg*R1 - 2.0*Omg*X*cos(alpha);
+    
+	  if (out) 
+	    out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << Omg*R1
+		<< std::setw(14) << vr  << std::setw(14) << vp
+		<< std::setw(14) << R1  << std::setw(14) << X   << std::setw(14) << kappa
+		<< std::endl;
+	}
+	break;
       }
-      break;
-    }
 
-    p.vel[0] = vr*x/R - vp*y/R;
-    p.vel[1] = vr*y/R + vp*x/R;
-    p.vel[2] = 0.0;
+      p.vel[0] = vr*x/R - vp*y/R;
+      p.vel[1] = vr*y/R + vp*x/R;
+      p.vel[2] = 0.0;
 
-    massp1 += p.mass;
-    for (int k=0; k<3; k++) vel1[k] += p.mass*p.vel[k];
+      tmass += p.mass;
+      for (int k=0; k<3; k++) tvel[k] += p.mass*p.vel[k];
+    }
+
+#pragma omp critical
+    {
+      massp1  += tmass;
+      for (int k=0; k<3; k++) vel1[k] += tvel[k];
+      num_oob += toob;
+      if (tmaxVR > maxVR) {
+	maxVR = tmaxVR;
+	RVR   = tRVR;
+      }
+      if (tmaxVP > maxVP) {
+	maxVP = tmaxVP;
+	RVP   = tRVP;
+      }
+    }
   }
 
   MPI_Allreduce(&massp1, &massp, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
@@ -2378,32 +2465,36 @@ void Disk2dHalo::set_vel_halo(vector<Particle>& part)
 	      << " Jeans=" << ncntJ << std::endl;
 }
 
-void Disk2dHalo::write_record(ostream &out, SParticle &p)
+void Disk2dHalo::write_block(ostream &out, std::vector<SParticle>& p, int n)
 {
-  bufout << " " << std::setw(16) << setprecision(8) << p.mass;
+  // Each thread formats a contiguous range; the ranges are written
+  // in order
+  //
+  std::vector<std::string> text(omp_get_max_threads());
+
+#pragma omp parallel
+  {
+    int nt = omp_get_num_threads(), id = omp_get_thread_num();
+    int ibeg = static_cast<long>(n)*id/nt;
+    int iend = static_cast<long>(n)*(id+1)/nt;
+
+    std::ostringstream sout;
+    for (int i=ibeg; i<iend; i++) {
+      sout << " " << std::setw(16) << setprecision(8) << p[i].mass;
   
-  for (int k=0; k<3; k++)
-    bufout << std::setw(24) << setprecision(15) << p.pos[k] + center_pos[k];
+      for (int k=0; k<3; k++)
+	sout << std::setw(24) << setprecision(15) << p[i].pos[k] + center_pos[k];
   
-  for (int k=0; k<3; k++)
-    bufout << std::setw(24) << setprecision(15) << p.vel[k] + center_vel[k];
+      for (int k=0; k<3; k++)
+	sout << std::setw(24) << setprecision(15) << p[i].vel[k] + center_vel[k];
   
-  bufout << std::endl;
+      sout << std::endl;
+    }
 
-  if (++bufcnt==bunchcnt) {	// Write the buffer
-    out << bufout.str();
-    bufout.str("");		// Clear the buffer
-    bufcnt = 0;
+    text[id] = sout.str();
   }
-}
 
-void Disk2dHalo::flush_buffer(ostream &out)
-{
-  // Write remaining characters in the buffer and clear
-  //
-  if (bufout.str().size()>0) out << bufout.str();
-  bufout.str("");
-  bufcnt = 0;
+  for (auto & t : text) out << t;
 }
 
 void Disk2dHalo::write_file(ostream &fou, vector<Particle>& part)
@@ -2442,8 +2533,11 @@ void Disk2dHalo::write_file(ostream &fou, vector<Particle>& part)
       else std::cout << "BAD" << std::endl;
     }
 
-    for (int i=0; i<l; i++)
-      write_record(fou, part[i]);
+    for (int i=0; i<l; i+=NBUF) {
+      int icur = std::min<int>(NBUF, l-i);
+      std::copy(part.begin()+i, part.begin()+i+icur, buf.begin());
+      write_block(fou, buf, icur);
+    }
     
     if (VFLAG & 1) {
       std::cout << "Wrote " << l  << " particles from Node 0" << std::endl;
@@ -2458,11 +2552,9 @@ void Disk2dHalo::write_file(ostream &fou, vector<Particle>& part)
       while (ccnt<imany) {
 	MPI_Recv(&icur, 1, MPI_INT, n, 11, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 	MPI_Recv(&buf[0], icur, spt(), n, 12, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-	for (int i=0; i<icur; i++) write_record(fou, buf[i]);
+	write_block(fou, buf, icur);
 	ccnt += icur;
       }
-      
-      flush_buffer(fou);
 
       if (VFLAG & 1)
 	std::cout << "Wrote " << ccnt << " particles from Node " << n << std::endl;
@@ -11,6 +11,9 @@
 #include <memory>
 #include <vector>
 #include <limits>
+
+#include <omp.h>
+
 				// EXP classes
 #include <interp.H>
 #include <numerical.H>
@@ -1130,6 +1133,7 @@ table_disk(vector<Particle>& part)
   epitable.resize(NDP, NDR);
   dv2table.resize(NDP, NDR);
   asytable.resize(NDP, NDR);
+  vctable .resize(NDP, NDR);
 
   dP = 2.0*M_PI/NDP;
 
@@ -1292,6 +1296,9 @@ table_disk(vector<Particle>& part)
 	expandh->determine_fields_at_point(R, 0.5*M_PI, phi,
 					   &dens, &potl, &dpr, &dpt, &dpp);
 
+				// Squared circular velocity in the
+				// plane for v_circ()
+      vctable(i, j) = R*(-fr + dpr);
       
       workV(0, j) = log(RDMIN) + dR*j;
 				
@@ -1507,6 +1514,9 @@ table_disk(vector<Particle>& part)
       if (k == myid) Z = asytable.row(i);
       MPI_Bcast(Z.data(), NDR, MPI_DOUBLE, k, MPI_COMM_WORLD);
       if (k != myid) asytable.row(i) = Z; 
+      if (k == myid) Z = vctable.row(i);
+      MPI_Bcast(Z.data(), NDR, MPI_DOUBLE, k, MPI_COMM_WORLD);
+      if (k != myid) vctable.row(i) = Z; 
       MPI_Bcast(disktableP[i].data(), NDR*NDZ, MPI_DOUBLE, k, MPI_COMM_WORLD);
       MPI_Bcast(disktableN[i].data(), NDR*NDZ, MPI_DOUBLE, k, MPI_COMM_WORLD);
     }
@@ -1857,12 +1867,48 @@ double DiskHalo::a_drift(double xp, double yp, double zp)
 }
 
 
-// Analytic rotation curve
+// Rotation curve: interpolated from the table_disk grid inside of its
+// radial range and evaluated from the expansions otherwise
 //
 double DiskHalo::v_circ(double xp, double yp, double zp)
 {
-  double R = sqrt(xp*xp + yp*yp);
-  double vcirc2 = R*deri_pot(xp, yp, 0.0, 1);
+  double R = sqrt(xp*xp + yp*yp), vcirc2;
+
+  double lR = log(std::max<double>(R, RDMIN)) - log(RDMIN);
+
+  if (vctable.size() and R >= RDMIN and lR <= dR*(NDR-1)) {
+				// Azimuth
+    double phi = atan2(yp, xp);
+    if (phi<0.0) phi = 2.0*M_PI + phi;
+
+    int iphi1 = floor( phi/dP );
+    iphi1 = std::min<int>(iphi1, NDP-1);
+    int iphi2 = iphi1 + 1;
+    if (iphi1==NDP-1) iphi2 = 0; // Modulo 2Pi
+
+    double cp[2], cr[2];
+
+    cp[1] = (phi - dP*iphi1)/dP;
+    cp[0] = 1.0 - cp[1];
+				// Cylindrical radius
+    int ir1 = floor( lR/dR );
+    ir1 = std::min<int>( ir1, NDR-2 );
+    int ir2 = ir1 + 1;
+
+    cr[1] = (lR - dR*ir1)/dR;
+    cr[0] = 1.0 - cr[1];
+
+    vcirc2 =
+      cp[0]*cr[0] * vctable(iphi1, ir1) +
+      cp[0]*cr[1] * vctable(iphi1, ir2) +
+      cp[1]*cr[0] * vctable(iphi2, ir1) +
+      cp[1]*cr[1] * vctable(iphi2, ir2) ;
+
+  } else {
+				// The expansions are not thread safe
+#pragma omp critical (DiskHalo_expansion)
+    vcirc2 = R*deri_pot(xp, yp, 0.0, 1);
+  }
 
 				// Sanity check
   if (vcirc2<=0.0) {
@@ -1884,11 +1930,9 @@ set_vel_disk(vector<Particle>& part)
     return;
   }
 
-  double vvZ, vvR, vvP;
   double maxVR=-1.0e20, RVR=1e20;
   double maxVP=-1.0e20, RVP=1e20;
   double maxVZ=-1.0e20, RVZ=1e20;
-  double vz, vr, vp, R, x, y, z, ac, vc, va, as, ad;
   double vel[3], vel1[3], massp, massp1;
   unsigned num_oob = 0;
 
@@ -1920,192 +1964,229 @@ set_vel_disk(vector<Particle>& part)
   }
 
 
-  for (auto &p : part) {
+				// The diagnostic file is written in
+				// particle order
+  int nthrds = (VFLAG & 4) ? 1 : omp_get_max_threads();
+  std::vector<std::mt19937> tgen = thread_gens(nthrds);
+
+#pragma omp parallel num_threads(nthrds) reduction(+:massp1, num_oob) reduction(+:vel1[:3])
+  {
+				// Per-thread generator and variates
+    std::mt19937& gen = tgen[omp_get_thread_num()];
+    std::uniform_real_distribution<> rndU;
+    std::normal_distribution<> rndN;
+
+    double vvZ, vvR, vvP;
+    double vz, vr, vp, R, x, y, z, ac, vc, va, as, ad;
+    double tmaxVR=-1.0e20, tRVR=1e20;
+    double tmaxVP=-1.0e20, tRVP=1e20;
+    double tmaxVZ=-1.0e20, tRVZ=1e20;
+
+#pragma omp for schedule(dynamic, 1024)
+    for (size_t n=0; n<part.size(); n++) {
+      auto &p = part[n];
 				// From solution to Jeans' equations in
 				// cylindrical coordinates
-    x = p.pos[0];
-    y = p.pos[1];
-    z = p.pos[2];
+      x = p.pos[0];
+      y = p.pos[1];
+      z = p.pos[2];
 
-    R = sqrt(x*x + y*y) + std::numeric_limits<double>::min();
+      R = sqrt(x*x + y*y) + std::numeric_limits<double>::min();
 
-    vvZ = vz_disp2(x, y, z);
-    vvR = vr_disp2(x, y, z);
+      vvZ = vz_disp2(x, y, z);
+      vvR = vr_disp2(x, y, z);
 
-    if (type == Jeans)
-      vvP = vvR/(XI*XI);
-    else
-      vvP = vp_disp2(x, y, z);
+      if (type == Jeans)
+	vvP = vvR/(XI*XI);
+      else
+	vvP = vp_disp2(x, y, z);
 				 // For safety; should only be a problem
 				 // on extrapolating the range
-    vvZ = std::max<double>(vvZ, std::numeric_limits<double>::min());
-    vvR = std::max<double>(vvR, std::numeric_limits<double>::min());
-    vvP = std::max<double>(vvP, std::numeric_limits<double>::min());
+      vvZ = std::max<double>(vvZ, std::numeric_limits<double>::min());
+      vvR = std::max<double>(vvR, std::numeric_limits<double>::min());
+      vvP = std::max<double>(vvP, std::numeric_limits<double>::min());
     
-    if (maxVZ < vvZ) {
-      maxVZ = vvZ;
-      RVZ   = R;
-    }
-    if (maxVR < vvR) {
-      maxVR = vvR;
-      RVR   = R;
-      if (VFLAG & 8)
-	std::cout << "maxVR: vvR = " << vvR
-		  << " x=" << x << " y=" << y
-		  << " epi=" << epi(x, y, 0.0)
-		  << " sig=" << disk_surface_density(R)
-		  << std::endl;
-
-    }
-    if (maxVP < vvP) {
-      maxVP = vvP;
-      RVP   = R;
-    }
-
-    // Circular velocity
-    vc   = v_circ(x, y, z);
-
-    // No asymmetric drift correction by default
-    ac = 0.0;
+      if (tmaxVZ < vvZ) {
+	tmaxVZ = vvZ;
+	tRVZ   = R;
+      }
+      if (tmaxVR < vvR) {
+	tmaxVR = vvR;
+	tRVR   = R;
+	if (VFLAG & 8)
+	  std::cout << "maxVR: vvR = " << vvR
+		    << " x=" << x << " y=" << y
+		    << " epi=" << epi(x, y, 0.0)
+		    << " sig=" << disk_surface_density(R)
+		    << std::endl;
 
-    switch (type) {
-    case Asymmetric:
-      // Asymmetric drift correction
-      ad = a_drift(x, y, z);
-      as = 1 + vvR*ad/(vc*vc);
+      }
+      if (tmaxVP < vvP) {
+	tmaxVP = vvP;
+	tRVP   = R;
+      }
 
-      if (as > 0.0 and not std::isnan(as))
-	ac = vc*(1.0-sqrt(as));
-      else {
-	if (as<0.0 or std::isnan(as)) {
-	  ac = vc;
-	  num_oob++;
-	}
-	if (VFLAG & 8) {
-	  int op = std::cout.precision(3);
-	  std::cout << "ac oob:"
-		    << " as="   << std::setw(10) << as 
-		    << ", R="   << std::setw(10) << R
-		    << ", ac="  << std::setw(10) << ac
-		    << ", ad="  << std::setw(10) << ad
-		    << ", vc="  << std::setw(10) << vc
-		    << ", vvR=" << std::setw(10) << vvR
-		    << std::endl;
-	  std::cout.precision(op);
+      // Circular velocity
+      vc   = v_circ(x, y, z);
+
+      // No asymmetric drift correction by default
+      ac = 0.0;
+
+      switch (type) {
+      case Asymmetric:
+	// Asymmetric drift correction
+	ad = a_drift(x, y, z);
+	as = 1 + vvR*ad/(vc*vc);
+
+	if (as > 0.0 and not std::isnan(as))
+	  ac = vc*(1.0-sqrt(as));
+	else {
+	  if (as<0.0 or std::isnan(as)) {
+	    ac = vc;
+	    num_oob++;
+	  }
+	  if (VFLAG & 8) {
+	    int op = std::cout.precision(3);
+	    std::cout << "ac oob:"
+		      << " as="   << std::setw(10) << as 
+		      << ", R="   << std::setw(10) << R
+		      << ", ac="  << std::setw(10) << ac
+		      << ", ad="  << std::setw(10) << ad
+		      << ", vc="  << std::setw(10) << vc
+		      << ", vvR=" << std::setw(10) << vvR
+		      << std::endl;
+	    std::cout.precision(op);
+	  }
 	}
-      }
 
-    case Jeans:
-      va = max<double>(vc - ac, std::numeric_limits<double>::min());
+      case Jeans:
+	va = max<double>(vc - ac, std::numeric_limits<double>::min());
      
-      vz   = rndN(gen)*sqrt(std::max<double>(vvZ, std::numeric_limits<double>::min()));
-      vr   = rndN(gen)*sqrt(std::max<double>(vvR, std::numeric_limits<double>::min()));
-      vp   = rndN(gen)*sqrt(std::max<double>(vvP, std::numeric_limits<double>::min()));
+	vz   = rndN(gen)*sqrt(std::max<double>(vvZ, std::numeric_limits<double>::min()));
+	vr   = rndN(gen)*sqrt(std::max<double>(vvR, std::numeric_limits<double>::min()));
+	vp   = rndN(gen)*sqrt(std::max<double>(vvP, std::numeric_limits<double>::min()));
       
-      {
-	double omp   = vc/R;
-	double kappa = epi(x, y, z);
-	double vp2   = vc*vc +	// From radial cylindrical Jeans using
+	{
+	  double omp   = vc/R;
+	  double kappa = epi(x, y, z);
+	  double vp2   = vc*vc +	// From radial cylindrical Jeans using
 				// epicyclic closure
-	  vvR * (1.0 - kappa*kappa/(4.0*omp*omp) - 2.0*R/scalelength);
-	if (vp2 >= 0.0) {
-	  vp += sqrt(vp2);
-	} else {
-	  num_oob++;
+	    vvR * (1.0 - kappa*kappa/(4.0*omp*omp) - 2.0*R/scalelength);
+	  if (vp2 >= 0.0) {
+	    vp += sqrt(vp2);
+	  } else {
+	    num_oob++;
+	  }
 	}
-      }
 
-      if (out) 
-	out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << vc
-	    << std::setw(14) << va  << std::setw(14) << ac  << std::setw(14) << epi(x, y, z)
-	    << std::setw(14) << vr  << std::setw(14) << vp  << std::setw(14) << vz
-	    << std::setw(14) << vvR << std::setw(14) << vvP << std::setw(14) << vvZ
-	    << std::setw(14) << vr*x/R - vp*y/R
-	    << std::setw(14) << vr*y/R + vp*x/R
-	    << std::endl;
-      break;
+	if (out) 
+	  out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << vc
+	      << std::setw(14) << va  << std::setw(14) << ac  << std::setw(14) << epi(x, y, z)
+	      << std::setw(14) << vr  << std::setw(14) << vp  << std::setw(14) << vz
+	      << std::setw(14) << vvR << std::setw(14) << vvP << std::setw(14) << vvZ
+	      << std::setw(14) << vr*x/R - vp*y/R
+	      << std::setw(14) << vr*y/R + vp*x/R
+	      << std::endl;
+	break;
       
-    case Epicyclic:
-      /*
-	Epicyclic theory provides the x position relative to the guiding
-	center for an arbitrary amplitude X for phase alpha = kappa*t:
+      case Epicyclic:
+	/*
+	  Epicyclic theory provides the x position relative to the guiding
+	  center for an arbitrary amplitude X for phase alpha = kappa*t:
 
-      		x     = X cos(alpha)
-		dx/dt = -kappa X sin(alpha)
+		  x     = X cos(alpha)
+		  dx/dt = -kappa X sin(alpha)
 
-	The phase averaged radial velocity at the guiding center is then:
+	  The phase averaged radial velocity at the guiding center is then:
 
-      		<dx/dt> = 0, <(dx/dt)^2> = kappa*kappa*X*X/2
+		  <dx/dt> = 0, <(dx/dt)^2> = kappa*kappa*X*X/2
 
-	Choose X by equating <(dx/dt)^2> = \sigma^2_r:
+	  Choose X by equating <(dx/dt)^2> = \sigma^2_r:
 
-      		<X>   = 0
-		<X^2> = 2*\sigma^2_r/(kappa*kappa)
+		  <X>   = 0
+		  <X^2> = 2*\sigma^2_r/(kappa*kappa)
 
-	Strictly speaking this is not correct because the contribution
-	to \sigma^2_r comes from many guiding centers.  So this
-	equivlance probably over estimates the second moment in X.
-	Choose X ~ normal with 0 mean and variance <X^2>
-     */
-      {
+	  Strictly speaking this is not correct because the contribution
+	  to \sigma^2_r comes from many guiding centers.  So this
+	  equivlance probably over estimates the second moment in X.
+	  Choose X ~ normal with 0 mean and variance <X^2>
+       */
+	{
 				// The normal variant
-	double Xampl = rndN(gen);	
+	  double Xampl = rndN(gen);	
 				// The cylindrical polar angle
-	double phi   = atan2(y, x);
+	  double phi   = atan2(y, x);
 				// The radial phase (kappa*t)
-	double alpha = 2.0*M_PI*rndU(gen);
+	  double alpha = 2.0*M_PI*rndU(gen);
 
 				// Initial guess for iteration uses
 				// present positions
-	double kappa = epi(x, y, z);
-	double X     = sqrt(2.0*Xampl*Xampl*vvR/(kappa*kappa));
+	  double kappa = epi(x, y, z);
+	  double X     = sqrt(2.0*Xampl*Xampl*vvR/(kappa*kappa));
 
 				// Iterate to get values at guiding
 				// center
-	double Xl, x1, y1, R1, Omg;
-	int cnt = 0;
-	for (int i=0; i<10; i++) {
-	  Xl      = X;
+	  double Xl, x1, y1, R1, Omg;
+	  int cnt = 0;
+	  for (int i=0; i<10; i++) {
+	    Xl      = X;
 				// Guiding center estimate
-	  R1      = R - X*cos(alpha);
+	    R1      = R - X*cos(alpha);
 				// x,y positions w.r.t. this guiding center
-	  x1      = R1*cos(phi);
-	  y1      = R1*sin(phi);
+	    x1      = R1*cos(phi);
+	    y1      = R1*sin(phi);
 				// Epicylic freq at guiding center
-	  kappa   = epi(x1, y1, z);
+	    kappa   = epi(x1, y1, z);
 	
 				// New amplitude
-	  X       = sqrt(2.0*Xampl*Xampl*vr_disp2(x1, y1, z)/(kappa*kappa));
-
-	  if (fabs((X-Xl)/Xl)<1.0e-6) break;
-	  cnt++;
-	}
-	if (cnt>=100) {
-	  std::cerr << "OOPS" << std::endl;
-	}
+	    X       = sqrt(2.0*Xampl*Xampl*vr_disp2(x1, y1, z)/(kappa*kappa));
+
+	    if (fabs((X-Xl)/Xl)<1.0e-6) break;
+	    cnt++;
+	  }
+	  if (cnt>=100) {
+	    std::cerr << "OOPS" << std::endl;
+	  }
 				// Aximuthal freq at guiding center
-	Omg  = v_circ(x1, y1, z)/R1;
+	  Omg  = v_circ(x1, y1, z)/R1;
 
 				// Compute the final velocities
-	vz   = rndN(gen)*sqrt(std::max<double>(vvZ, std::numeric_limits<double>::min()));
-	vr   = -kappa*X*sin(alpha);
-	vp   = Omg*R1 - 2.0*Omg*X*cos(alpha);
-    
-	if (out) 
-	  out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << Omg*R1
-	      << std::setw(14) << vr  << std::setw(14) << vp  << std::setw(14) << vz
-	      << std::setw(14) << R1  << std::setw(14) << X   << std::setw(14) << kappa
-	      << std::endl;
+	  vz   = rndN(gen)*sqrt(std::max<double>(vvZ, std::numeric_limits<double>::min()));
+	  vr   = -kappa*X*sin(alpha);
+	  vp   = Omg*R1 - 2.0*Omg*X*cos(alpha);
+    
+	  if (out) 
+	    out << std::setw(14) << R   << std::setw(14) << z   << std::setw(14) << Omg*R1
+		<< std::setw(14) << vr  << std::setw(14) << vp  << std::setw(14) << vz
+		<< std::setw(14) << R1  << std::setw(14) << X   << std::setw(14) << kappa
+		<< std::endl;
+	}
+	break;
       }
-      break;
-    }
 
-    p.vel[0] = vr*x/R - vp*y/R;
-    p.vel[1] = vr*y/R + vp*x/R;
-    p.vel[2] = vz;
+      p.vel[0] = vr*x/R - vp*y/R;
+      p.vel[1] = vr*y/R + vp*x/R;
+      p.vel[2] = vz;
 
-    massp1 += p.mass;
-    for (int k=0; k<3; k++) vel1[k] += p.mass*p.vel[k];
+      massp1 += p.mass;
+      for (int k=0; k<3; k++) vel1[k] += p.mass*p.vel[k];
+    }
+
+#pragma omp critical
+    {
+      if (tmaxVZ > maxVZ) {
+	maxVZ = tmaxVZ;
+	RVZ   = tRVZ;
+      }
+      if (tmaxVR > maxVR) {
+	maxVR = tmaxVR;
+	RVR   = tRVR;
+      }
+      if (tmaxVP > maxVP) {
+	maxVP = tmaxVP;
+	RVP   = tRVP;
+      }
+    }
   }
 
   MPI_Allreduce(&massp1, &massp, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
@@ -2532,6 +2613,13 @@ double DiskHalo::get_disp(double xp,double yp, double zp)
   return resv;
 }
 
+std::vector<std::mt19937> DiskHalo::thread_gens(int nthrds)
+{
+  std::vector<std::mt19937> ret(nthrds);
+  for (auto & g : ret) g.seed(gen());
+  return ret;
+}
+
 void DiskHalo::set_vel_halo(vector<Particle>& part)
 {
   if (!expandh) {
@@ -2539,8 +2627,7 @@ void DiskHalo::set_vel_halo(vector<Particle>& part)
     return;
   }
   
-  int nok, ncntE=0, ncntJ=0;
-  double v2r, vr, r;
+  int ncntE=0, ncntJ=0;
   double vel[3], vel1[3], massp, massp1;
   
   for (int k=0; k<3; k++) vel[k] = vel1[k] = 0.0;
@@ -2548,37 +2635,55 @@ void DiskHalo::set_vel_halo(vector<Particle>& part)
   
   table_halo(part);
   
-  for (auto &p : part) {
+				// The Eddington realization uses the
+				// global generator
+  int nthrds = DF ? 1 : omp_get_max_threads();
+  std::vector<std::mt19937> tgen = thread_gens(nthrds);
+
+#pragma omp parallel num_threads(nthrds) reduction(+:massp1, ncntE, ncntJ) reduction(+:vel1[:3])
+  {
+				// Per-thread generator and variates
+    std::mt19937& gen = tgen[omp_get_thread_num()];
+    std::uniform_real_distribution<> rndU;
+    std::normal_distribution<> rndN;
+
+    int nok;
+    double v2r, vr, r;
+
+#pragma omp for schedule(dynamic, 1024)
+    for (size_t n=0; n<part.size(); n++) {
+      auto &p = part[n];
     
-    r = sqrt(p.pos[0]*p.pos[0] + 
-	     p.pos[1]*p.pos[1] +
-	     p.pos[2]*p.pos[2]);
+      r = sqrt(p.pos[0]*p.pos[0] + 
+	       p.pos[1]*p.pos[1] +
+	       p.pos[2]*p.pos[2]);
     
 				// Reset success flag
-    nok = 1;
+      nok = 1;
     
 				// Use Eddington
     
-    if (DF && 0.5*(1.0+erf((r-R_DF)/DR_DF)) > rndU(gen)) {
-      halo2->gen_velocity(&p.pos[0], &p.vel[0], nok);
+      if (DF && 0.5*(1.0+erf((r-R_DF)/DR_DF)) > rndU(gen)) {
+	halo2->gen_velocity(&p.pos[0], &p.vel[0], nok);
       
-      if (nok) {
-	std::cout << "gen_velocity failed: "
-		  << p.pos[0] << " "
-		  << p.pos[1] << " "
-		  << p.pos[2] << "\n";
-      } else ncntE++;
-    }
+	if (nok) {
+	  std::cout << "gen_velocity failed: "
+		    << p.pos[0] << " "
+		    << p.pos[1] << " "
+		    << p.pos[2] << "\n";
+	} else ncntE++;
+      }
 				// Use Jeans
-    if (nok) {
-      v2r = get_disp(p.pos[0], p.pos[1], p.pos[2]);
-      vr = sqrt(max<double>(v2r, std::numeric_limits<double>::min()));
-      for (int k=0; k<3; k++) p.vel[k] = vr*rndN(gen);
-      ncntJ++;
-    }
+      if (nok) {
+	v2r = get_disp(p.pos[0], p.pos[1], p.pos[2]);
+	vr = sqrt(max<double>(v2r, std::numeric_limits<double>::min()));
+	for (int k=0; k<3; k++) p.vel[k] = vr*rndN(gen);
+	ncntJ++;
+      }
     
-    massp1 += p.mass;
-    for (int k=0; k<3; k++) vel1[k] += p.mass*p.vel[k];
+      massp1 += p.mass;
+      for (int k=0; k<3; k++) vel1[k] += p.mass*p.vel[k];
+    }
   }
   
 
@@ -7,6 +7,8 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <cstdint>
 #include <random>
 #include <string>
 #include <vector>
@@ -170,7 +172,17 @@ main(int ac, char **av)
 
   Linear1d Ecum(cumF, cumE), Ftop(cumE, topF);
 
-  std::mt19937 gen(seed);
+  // One generator per thread.  The streams are seeded from a
+  // sequence built from the seed so that a given seed and thread
+  // count reproduce the same bodies.
+  //
+  std::vector<std::mt19937> gen(nomp);
+  {
+    std::seed_seq seq{seed};
+    std::vector<std::uint32_t> seeds(nomp);
+    seq.generate(seeds.begin(), seeds.end());
+    for (int n=0; n<nomp; n++) gen[n].seed(seeds[n]);
+  }
   std::uniform_real_distribution<> uniform(0.0, 1.0);
 
   // Save the position and velocity vectors
@@ -189,7 +201,7 @@ main(int ac, char **av)
 
   // Generation loop with OpenMP
   //
-#pragma omp parallel for reduction(+:over)
+#pragma omp parallel for reduction(+:over) schedule(dynamic, 64)
   for (int n=0; n<N; n++) {
     // Thread id
     int tid = omp_get_thread_num();
@@ -199,22 +211,22 @@ main(int ac, char **av)
     int j;
     for (j=0; j<itmax; j++) {
 
-      E = Ecum.eval(uniform(gen));
+      E = Ecum.eval(uniform(gen[tid]));
       F = Ftop.eval(E);
-      K = Kmin + (Kmax - Kmin)*uniform(gen);
+      K = Kmin + (Kmax - Kmin)*uniform(gen[tid]);
 
       orb[tid]->new_orbit(E, K);
       double F = model->distf(E, orb[tid]->get_action(1)) / orb[tid]->get_freq(0);
-      if (F/peak > uniform(gen)) break;
+      if (F/peak > uniform(gen[tid])) break;
     }
 
     if (j==itmax) over++;
 
     double J   = orb[tid]->get_action(1);
-    double T   = 2.0*M_PI/orb[tid]->get_freq(0)*uniform(gen);
+    double T   = 2.0*M_PI/orb[tid]->get_freq(0)*uniform(gen[tid]);
     double r   = orb[tid]->get_angle(6, T);
     double w1  = orb[tid]->get_angle(1, T);
-    double phi = 2.0*M_PI*uniform(gen) + orb[tid]->get_angle(7, T);
+    double phi = 2.0*M_PI*uniform(gen[tid]) + orb[tid]->get_angle(7, T);
 
     double vt  = J/r;
     double vr  = sqrt(fabs(2.0*(E - model->get_pot(r)) - J*J/(r*r)));
@@ -281,24 +293,41 @@ main(int ac, char **av)
   out << std::setw(8) << N << std::setw(8) << 0 << std::setw(8) << 0
       << std::endl;
 
+  // Format the bodies in parallel, one contiguous block per thread,
+  // and write the blocks in order
+  //
+  std::vector<std::string> text(nomp);
   double ektot = 0.0, clausius = 0.0;
-  for (int n=0; n<N; n++) {
-    out << std::setw(18) << mass;
-    for (int k=0; k<3; k++) out << std::setw(18) << pos[n][k] - zeropos[0][k];
-    for (int k=0; k<3; k++) out << std::setw(18) << vel[n][k] - zerovel[0][k];
-    out << std::endl;
 
-    double r2 = 0.0, v2 = 0.0;
-    for (int k=0; k<3; k++) {
-      r2 += pos[n][k]*pos[n][k];
-      v2 += vel[n][k]*vel[n][k];
+#pragma omp parallel reduction(+:ektot, clausius)
+  {
+    int tid = omp_get_thread_num(), nt = omp_get_num_threads();
+    int nbeg = static_cast<long>(N)*tid/nt;
+    int nend = static_cast<long>(N)*(tid+1)/nt;
+
+    std::ostringstream sout;
+    for (int n=nbeg; n<nend; n++) {
+      sout << std::setw(18) << mass;
+      for (int k=0; k<3; k++) sout << std::setw(18) << pos[n][k] - zeropos[0][k];
+      for (int k=0; k<3; k++) sout << std::setw(18) << vel[n][k] - zerovel[0][k];
+      sout << std::endl;
+
+      double r2 = 0.0, v2 = 0.0;
+      for (int k=0; k<3; k++) {
+	r2 += pos[n][k]*pos[n][k];
+	v2 += vel[n][k]*vel[n][k];
+      }
+
+      ektot += mass*v2;
+      double r = sqrt(r2);
+      clausius += mass*model->get_dpot(r)*r;
     }
 
-    ektot += mass*v2;
-    double r = sqrt(r2);
-    clausius += mass*model->get_dpot(r)*r;
+    text[tid] = sout.str();
   }
 
+  for (auto & t : text) out << t;
+
   std::cout <<  "** 2T/VC=" << ektot/clausius << std::endl;
 
   if (vm.count("debug")) {
@@ -72,7 +72,8 @@ main(int argc, char **argv)
   double X0, Y0, Z0, U0, V0, W0, TOLE;
   double Emin0, Emax0, Kmin0, Kmax0, RBAR, MBAR, BRATIO, CRATIO, SMOOTH;
   bool LOGR, ELIMIT, VERBOSE, GRIDPOT, MODELS, EBAR, zeropos, zerovel;
-  bool VTEST;
+  bool VTEST, PHILOX;
+  int NTHRDS;
   std::string INFILE, MMFILE, OUTFILE, OUTPS, config;
 
 #ifdef DEBUG
@@ -179,6 +180,10 @@ main(int argc, char **argv)
      cxxopts::value<bool>(ELIMIT)->default_value("false"))
     ("VTEST", "Test gen_velocity() generation",
      cxxopts::value<bool>(VTEST)->default_value("false"))
+    ("PHILOX", "Draw each body from its own counter-based random stream so that the realization does not depend on the number of processes or threads",
+     cxxopts::value<bool>(PHILOX)->default_value("false"))
+    ("NTHRDS", "Number of threads per process for PHILOX realization",
+     cxxopts::value<int>(NTHRDS)->default_value("1"))
     ("Emin0", "Minimum energy (if ELIMIT=true)",
      cxxopts::value<double>(Emin0)->default_value("-3.0"))
     ("Emax0", "Maximum energy (if ELIMIT=true)",
@@ -254,6 +259,13 @@ main(int argc, char **argv)
   if (vm.count("verbose")) VERBOSE = true;
   else                     VERBOSE = false;
 
+  if (PHILOX and (ELIMIT or VTEST)) {
+    if (myid==0) std::cerr << "gensph: PHILOX does not support ELIMIT or "
+			   << "VTEST; using the sequential generator"
+			   << std::endl;
+    PHILOX = false;
+  }
+
   // Prepare output streams and create new files
   //
   std::ostringstream sout;
@@ -703,9 +715,16 @@ main(int argc, char **argv)
   std::vector<Eigen::VectorXd> PS;
   Eigen::VectorXd zz = Eigen::VectorXd::Zero(7);
 
+  // Realize this process' bodies in one pass; body n is drawn from
+  // stream n for any process and thread count
+  //
+  Eigen::MatrixXd PSR;
+  if (PHILOX) count += rmodel->realize(SEED, beg, end-beg, PSR, NTHRDS);
+
   for (int n=beg; n<end; n++) {
 
-    do {
+    if (PHILOX) ps = PSR.row(n-beg).transpose();
+    else do {
       if (ELIMIT)
 	ps = rmodel->gen_point(Emin0, Emax0, Kmin0, Kmax0, ierr);
       else if (VTEST) {
@@ -762,6 +781,12 @@ main(int argc, char **argv)
 
   if (zeropos or zerovel) {
 
+    // The center must not depend on the decomposition either
+    //
+    if (PHILOX)
+      MPI_Allreduce(MPI_IN_PLACE, zz.data(), 7, MPI_DOUBLE, MPI_SUM,
+		    MPI_COMM_WORLD);
+
     if (zz[0] > 0.0) {
       for (int i=1; i<7; i++) ps0[i] += zz[i]/zz[0];
     }
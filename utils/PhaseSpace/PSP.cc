@@ -1,8 +1,10 @@
 #include <ios>
+#include <cstring>
 #include <yaml-cpp/yaml.h>	      // YAML support
 #include <Sutils.H>		      // For trim-copy
 
 #include <PSP.H>
+#include <ThreadPool.H>
 #include <libvars.H>		// Library support
 
 bool badstatus(std::istream& in)
@@ -471,6 +473,19 @@ SParticle *PSPout::NextParticle()
     return 0;
 }
 
+void PSPout::rewindStanza()
+{
+  pcount = 0;
+  in.seekg(cur->pspos);
+}
+
+void PSPout::readRecords(size_t n)
+{
+  raw.resize(n*recordSize());
+  in.read(raw.data(), raw.size());
+  pcount += n;
+}
+
 SParticle* PSPspl::GetParticle()
 {
   pcount = 0;
@@ -551,6 +566,133 @@ SParticle* PSPspl::NextParticle()
     return 0;
 }
 
+void PSPspl::rewindStanza()
+{
+  pcount = 0;
+  fit = spos->nparts.begin();
+  openNextBlob();
+}
+
+void PSPspl::readRecords(size_t n)
+{
+  size_t rec = recordSize();
+  raw.resize(n*rec);
+
+  // A chunk may span file parts
+  //
+  char* b = raw.data();
+  while (n) {
+    if (fcount==N) openNextBlob();
+    size_t k = std::min<size_t>(n, N - fcount);
+    in.read(b, k*rec);
+    b      += k*rec;
+    n      -= k;
+    fcount += k;
+    pcount += k;
+  }
+}
+
+namespace {
+
+  //! Convert the records [beg, end) of raw into the chunk arrays
+  template <typename real>
+  void decodeRecords(const char* raw, size_t rec, bool index,
+		     PSPchunk& c, size_t beg, size_t end)
+  {
+    for (size_t i=beg; i<end; i++) {
+      const char* p = raw + i*rec;
+
+      if (index) {
+	std::memcpy(&c.indx[i], p, sizeof(unsigned long));
+	p += sizeof(unsigned long);
+      } else
+	c.indx[i] = c.first + i;
+
+      real v[8];
+      std::memcpy(v, p, 8*sizeof(real));
+      p += 8*sizeof(real);
+
+      c.mass[i] = v[0];
+      for (int k=0; k<3; k++) {
+	c.pos[3*i+k] = v[1+k];
+	c.vel[3*i+k] = v[4+k];
+      }
+      c.phi[i] = v[7];
+
+      if (c.niatr) {
+	std::memcpy(&c.iatr[i*c.niatr], p, sizeof(int)*c.niatr);
+	p += sizeof(int)*c.niatr;
+      }
+
+      for (int j=0; j<c.ndatr; j++) {
+	real d;
+	std::memcpy(&d, p, sizeof(real));
+	p += sizeof(real);
+	c.datr[i*c.ndatr+j] = d;
+      }
+    }
+  }
+
+}
+
+bool PSP::readChunk(PSPchunk& c, size_t maxn)
+{
+  size_t n = std::min<size_t>(maxn, spos->comp.nbod - pcount);
+
+  c.first = pcount;
+  c.size  = n;
+  c.niatr = spos->comp.niatr;
+  c.ndatr = spos->comp.ndatr;
+
+  if (n==0) return false;
+
+  // One read for the whole chunk
+  //
+  readRecords(n);
+
+  c.indx.resize(n);
+  c.mass.resize(n);
+  c.pos .resize(3*n);
+  c.vel .resize(3*n);
+  c.phi .resize(n);
+  c.iatr.resize(n*c.niatr);
+  c.datr.resize(n*c.ndatr);
+
+  // Convert in contiguous slices, one per thread
+  //
+  size_t rec  = recordSize();
+  bool index  = spos->index_size > 0;
+  bool single = spos->r_size == sizeof(float);
+  int  nt     = std::min<size_t>(nthrds, (n + 4095)/4096);
+
+  auto work = [&](int id)
+  {
+    size_t beg = n*id/nt, end = n*(id+1)/nt;
+    if (single) decodeRecords<float >(raw.data(), rec, index, c, beg, end);
+    else        decodeRecords<double>(raw.data(), rec, index, c, beg, end);
+  };
+
+  if (nt>1) ThreadPool::instance().run(nt, work);
+  else      work(0);
+
+  return true;
+}
+
+bool PSP::GetChunk(PSPchunk& chunk, size_t maxn)
+{
+  if (spos->comp.nbod==0) {
+    chunk.size = 0;
+    return false;
+  }
+
+  rewindStanza();
+  return readChunk(chunk, maxn);
+}
+
+bool PSP::NextChunk(PSPchunk& chunk, size_t maxn)
+{
+  return readChunk(chunk, maxn);
+}
 
 void PSP::ComputeStats()
 {
@@ -43,6 +43,7 @@
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 #include <Eigen/Eigen>
@@ -54,6 +55,7 @@
 #include <EXPini.H>		// Enhanced option parsing
 #include <libvars.H>		// EXP library globals
 #include <interp.H>
+#include <ThreadPool.H>
 
 void p_rec(std::ofstream& out, double E, double K, double V)
 {
@@ -213,7 +215,7 @@ main(int argc, char **argv)
      cxxopts::value<int>(NUM2)->default_value("60"))
     ("DIVERGE", "Flag for cusp extrapolation (non-zero means ON)",
      cxxopts::value<int>(DIVERGE)->default_value("0"))
-    ("nthrds", "Desired number of OpenMP threads",
+    ("nthrds", "Number of threads for the particle differencing",
      cxxopts::value<int>(nthrds)->default_value("1"))
     ("WHICHEK", "Choose the form of angular momentum indexing phase-space (1=first, 2=second, 3=RMS",
      cxxopts::value<int>(WHICHEK)->default_value("1"))
@@ -529,7 +531,7 @@ main(int argc, char **argv)
 
   double d1 = (I1max - I1min) / NUM1;
   double d2 = (I2max - I2min) / NUM2;
-  double Ir1, Ip1, Ir2, Ip2, I1, I2;
+  double I1, I2;
 
   double d3 = d2;
   bool Kpow = false;
@@ -558,6 +560,49 @@ main(int argc, char **argv)
   //
   int reject=0, N=0, total=0, rover=0, emiss=0, pmiss=0, Ntot=0;
 
+  // Per-thread bins, tallies and diagnostic output for the particle
+  // differencing, summed after the file loop
+  //
+  struct Bins
+  {
+    Eigen::MatrixXd histoC, histoM, histoE, histoJ, histoR, histoI, histoT;
+    Eigen::MatrixXd histo1, histo2, rapo, rperi, omega1, omega2;
+    Eigen::VectorXd histoP, histoL, histPr, histLr, histoS, histoN;
+    std::vector<Eigen::VectorXd> histo1_1d, histo2_1d;
+    int reject=0, total=0, rover=0, emiss=0, pmiss=0, Ntot=0;
+    std::ostringstream chk, dist;
+  };
+
+  nthrds = std::max<int>(1, nthrds);
+
+  std::vector<Bins> bins(nthrds);
+  std::vector<std::shared_ptr<SphericalOrbit>> orbs;
+
+  for (auto & b : bins) {
+    b.histoC = histoC;
+    b.histoM = histoM;
+    b.histoE = histoE;
+    b.histoJ = histoJ;
+    b.histoR = histoR;
+    b.histoI = histoI;
+    b.histoT = histoT;
+    b.histo1 = histo1;
+    b.histo2 = histo2;
+    b.rapo   = rapo;
+    b.rperi  = rperi;
+    b.omega1 = omega1;
+    b.omega2 = omega2;
+    b.histoP = histoP;
+    b.histoL = histoL;
+    b.histPr = histPr;
+    b.histLr = histLr;
+    b.histoS = histoS;
+    b.histoN = histoN;
+    b.histo1_1d = histo1_1d;
+    b.histo2_1d = histo2_1d;
+    orbs.push_back(std::make_shared<SphericalOrbit>(hmodel));
+  }
+
   // Times for the PSP snaps
   //
   double initl_time, final_time;
@@ -661,7 +706,7 @@ main(int argc, char **argv)
       double pos[3], vel[3];
     } tps;
     
-    std::map<int, SPS> ph;
+    std::unordered_map<int, SPS> ph;
 
     int N;
 
@@ -674,25 +719,28 @@ main(int argc, char **argv)
       }
 
       N = 0;
-      for (auto pp=psp1->firstParticle(); pp!=0; pp=psp1->nextParticle()) {
-	for (int k=0; k<3; k++) {
-	  // Add particles to map
-	  tps.pos[k] = pp->pos[k];
-	  tps.vel[k] = pp->vel[k];
-	  // Pack particles for MPI
-	  if (numprocs>1) {
-	    pos0.push_back(pp->pos[k]);
-	    vel0.push_back(pp->vel[k]);
+      for (auto c=psp1->firstChunk(); c.size; c=psp1->nextChunk()) {
+	// Add particles to map
+	for (size_t i=0; i<c.size; i++) {
+	  for (int k=0; k<3; k++) {
+	    tps.pos[k] = c.pos[3*i+k];
+	    tps.vel[k] = c.vel[3*i+k];
 	  }
+	  ph[c.indx[i]] = tps;
+	}
+
+	// Pack particles for MPI
+	if (numprocs>1) {
+	  pos0.insert(pos0.end(), c.pos, c.pos + 3*c.size);
+	  vel0.insert(vel0.end(), c.vel, c.vel + 3*c.size);
+	  ind0.insert(ind0.end(), c.indx, c.indx + c.size);
 	}
-	ph[pp->indx] = tps;
-	if (numprocs>1) ind0.push_back(pp->indx);
 
 	if (myid==0 and NREPORT) {
-	  if (!((N+1)%NREPORT))
+	  if (N/NREPORT != (N+c.size)/NREPORT)
 	    std::cout << "\rProcessed: " 
-		      << std::setw(10) << (N+1)*numprocs << std::flush;
-	  N++;
+		      << std::setw(10) << (N+c.size)*numprocs << std::flush;
+	  N += c.size;
 	}
       }
 
@@ -749,355 +797,431 @@ main(int argc, char **argv)
       std::cout << std::endl << "Particle differencing..." << std::endl;
     }
 
-    N = 0;
-    for (auto pp=psp2->firstParticle(); pp!=0; pp=psp2->nextParticle()) {
-    
-      auto ip = ph.find(pp->indx);
+    // Particles are read a chunk at a time and each chunk is
+    // differenced by a pool of threads, each with its own orbit and
+    // bins.  Chunks do not carry the integer attributes, so a TAG
+    // selection gathers the chunk from the particle iterator instead.
+    //
+    std::vector<double> gmass, gpos, gvel;
+    std::vector<unsigned long> gindx;
+    std::vector<char> tagged;
+
+    const double *mass = 0, *pos = 0, *vel = 0;
+    const unsigned long *indx = 0;
+    size_t nchunk = 0;
+
+    auto next = [&](bool first) -> bool
+    {
+      if (TAG<0) {
+	auto c = first ? psp2->firstChunk() : psp2->nextChunk();
+	nchunk = c.size;
+	mass   = c.mass;
+	pos    = c.pos;
+	vel    = c.vel;
+	indx   = c.indx;
+	return nchunk>0;
+      }
+
+      gmass.clear();
+      gpos.clear();
+      gvel.clear();
+      gindx.clear();
+      tagged.clear();
+
+      auto pp = first ? psp2->firstParticle() : psp2->nextParticle();
+      while (pp) {
+	gmass.push_back(pp->mass);
+	for (int k=0; k<3; k++) {
+	  gpos.push_back(pp->pos[k]);
+	  gvel.push_back(pp->vel[k]);
+	}
+	gindx.push_back(pp->indx);
+	tagged.push_back(pp->iattrib.size()>TAG and pp->iattrib[TAG]>0);
+	if (gmass.size() == PR::ParticleReader::chunkSize) break;
+	pp = psp2->nextParticle();
+      }
+
+      nchunk = gmass.size();
+      mass   = gmass.data();
+      pos    = gpos.data();
+      vel    = gvel.data();
+      indx   = gindx.data();
+      return nchunk>0;
+    };
+
+    auto work = [&](int id)
+    {
+      Bins & b = bins[id];
+      SphericalOrbit & orb = *orbs[id];
+      size_t beg = nchunk*id/nthrds, end = nchunk*(id+1)/nthrds;
+
+      for (size_t i=beg; i<end; i++) {
+
+	double Ir1, Ip1, I1, I2;
+
+	auto ip = ph.find(indx[i]);
     
-      if (ip != ph.end()) {
+	if (ip != ph.end()) {
       
-	double angmom1[3], angmom2[3];
-	double p10[3], p20[3], v10[3], v20[3];
+	  double angmom1[3], angmom2[3];
+	  double p10[3], p20[3], v10[3], v20[3];
       
-	if (TAG>=0 && pp->iattrib.size()>TAG) {
-	  if (pp->iattrib[TAG]>0) continue;
-	}
+	  if (tagged.size() and tagged[i]) continue;
 	
-	for (int k=0; k<3; k++) p10[k] = ip->second.pos[k] - p1[k];
-	for (int k=0; k<3; k++) p20[k] = pp->pos[k] - p2[k];
-	for (int k=0; k<3; k++) v10[k] = ip->second.vel[k];
-	for (int k=0; k<3; k++) v20[k] = pp->vel[k];
+	  for (int k=0; k<3; k++) p10[k] = ip->second.pos[k] - p1[k];
+	  for (int k=0; k<3; k++) p20[k] = pos[3*i+k] - p2[k];
+	  for (int k=0; k<3; k++) v10[k] = ip->second.vel[k];
+	  for (int k=0; k<3; k++) v20[k] = vel[3*i+k];
       
-	double rr1=0, vv1=0, rr2=0, vv2=0;
-	for (int k=0; k<3; k++) {
-	  rr1 += p10[k]*p10[k];
-	  vv1 += v10[k]*v10[k];
-	  rr2 += p20[k]*p20[k];
-	  vv2 += v20[k]*v20[k];
-	}
+	  double rr1=0, vv1=0, rr2=0, vv2=0;
+	  for (int k=0; k<3; k++) {
+	    rr1 += p10[k]*p10[k];
+	    vv1 += v10[k]*v10[k];
+	    rr2 += p20[k]*p20[k];
+	    vv2 += v20[k]*v20[k];
+	  }
       
-	if (rr1 <= RMAX*RMAX && rr1 >= RMIN*RMIN) {
+	  if (rr1 <= RMAX*RMAX && rr1 >= RMIN*RMIN) {
 	
-	  double E1 = 0.5*vv1 + hmodel->get_pot(sqrt(rr1));
+	    double E1 = 0.5*vv1 + hmodel->get_pot(sqrt(rr1));
 
-	  if (E1 < Emin or E1 > Emax) {emiss++; continue;}
+	    if (E1 < Emin or E1 > Emax) {b.emiss++; continue;}
 
-	  double E2 = 0.5*vv2 + hmodel->get_pot(sqrt(rr2));
+	    double E2 = 0.5*vv2 + hmodel->get_pot(sqrt(rr2));
 	  
-	  if (E2 < Emin or E2 > Emax) {emiss++; continue;}
+	    if (E2 < Emin or E2 > Emax) {b.emiss++; continue;}
 	  
-	  angmom1[0] = p10[1]*v10[2] - p10[2]*v10[1];
-	  angmom1[1] = p10[2]*v10[0] - p10[0]*v10[2];
-	  angmom1[2] = p10[0]*v10[1] - p10[1]*v10[0];
+	    angmom1[0] = p10[1]*v10[2] - p10[2]*v10[1];
+	    angmom1[1] = p10[2]*v10[0] - p10[0]*v10[2];
+	    angmom1[2] = p10[0]*v10[1] - p10[1]*v10[0];
 	
-	  double cosb = angmom1[2]/sqrt(angmom1[0]*angmom1[0] +
-					angmom1[1]*angmom1[1] +
-					angmom1[2]*angmom1[2] );
+	    double cosb = angmom1[2]/sqrt(angmom1[0]*angmom1[0] +
+					  angmom1[1]*angmom1[1] +
+					  angmom1[2]*angmom1[2] );
 	
-	  if (POSNEG>0 && angmom1[2]<0.0 ||
-	      POSNEG<0 && angmom1[2]>0.0) continue;
+	    if (POSNEG>0 && angmom1[2]<0.0 ||
+		POSNEG<0 && angmom1[2]>0.0) continue;
 
-	  if (cosb<BMIN || cosb>BMAX) continue;
+	    if (cosb<BMIN || cosb>BMAX) continue;
 	
-	  angmom2[0] = p20[1]*v20[2] - p20[2]*v20[1];
-	  angmom2[1] = p20[2]*v20[0] - p20[0]*v20[2];
-	  angmom2[2] = p20[0]*v20[1] - p20[1]*v20[0];
+	    angmom2[0] = p20[1]*v20[2] - p20[2]*v20[1];
+	    angmom2[1] = p20[2]*v20[0] - p20[0]*v20[2];
+	    angmom2[2] = p20[0]*v20[1] - p20[1]*v20[0];
 	  
-	  double jj = 0.0, dj = 0.0, j1 = 0.0, j2 = 0.0;
-	  for (int k=0; k<3; k++) {
-	    if (WHICHEK==1)
-	      jj += angmom1[k]*angmom1[k];
-	    else if (WHICHEK==2)
-	      jj += angmom2[k]*angmom2[k];
-	    else
-	      jj += 0.5*(angmom1[k]*angmom1[k] + angmom2[k]*angmom2[k]);
+	    double jj = 0.0, dj = 0.0, j1 = 0.0, j2 = 0.0;
+	    for (int k=0; k<3; k++) {
+	      if (WHICHEK==1)
+		jj += angmom1[k]*angmom1[k];
+	      else if (WHICHEK==2)
+		jj += angmom2[k]*angmom2[k];
+	      else
+		jj += 0.5*(angmom1[k]*angmom1[k] + angmom2[k]*angmom2[k]);
 	  
-	    j1 += angmom1[k]*angmom1[k];
-	    j2 += angmom2[k]*angmom2[k];
-	    dj += (angmom1[k] - angmom2[k])*(angmom1[k] - angmom2[k]);
-	  }
+	      j1 += angmom1[k]*angmom1[k];
+	      j2 += angmom2[k]*angmom2[k];
+	      dj += (angmom1[k] - angmom2[k])*(angmom1[k] - angmom2[k]);
+	    }
 	
-	  try {
-	    orb.new_orbit(E1, 0.5);
-	    double K1 = sqrt(j1)/orb.Jmax();
+	    try {
+	      orb.new_orbit(E1, 0.5);
+	      double K1 = sqrt(j1)/orb.Jmax();
 
-	    if (K1>1.0-KTOL) throw std::runtime_error("K1 > 1-KTOL");
-	    if (K1<KTOL)     throw std::runtime_error("K1 < KTOL");
+	      if (K1>1.0-KTOL) throw std::runtime_error("K1 > 1-KTOL");
+	      if (K1<KTOL)     throw std::runtime_error("K1 < KTOL");
 	    
-	    orb.new_orbit(E1, K1);
+	      orb.new_orbit(E1, K1);
 	  
-	    Ir1 = orb.get_action(0);
-	    Ip1 = orb.get_action(1);
+	      Ir1 = orb.get_action(0);
+	      Ip1 = orb.get_action(1);
 	  
-	    orb.new_orbit(E2, 0.5);
-	    double K2 = sqrt(j2)/orb.Jmax();
+	      orb.new_orbit(E2, 0.5);
+	      double K2 = sqrt(j2)/orb.Jmax();
 
-	    if (K2>1.0-KTOL) throw std::runtime_error("K2 > 1-KTOL");
-	    if (K2<KTOL)     throw std::runtime_error("K2 < KTOL");
+	      if (K2>1.0-KTOL) throw std::runtime_error("K2 > 1-KTOL");
+	      if (K2<KTOL)     throw std::runtime_error("K2 < KTOL");
 	  
-	    orb.new_orbit(E2, K2);
+	      orb.new_orbit(E2, K2);
 
-	    double Ir2 = orb.get_action(0);
-	    double Ip2 = orb.get_action(1);
+	      double Ir2 = orb.get_action(0);
+	      double Ip2 = orb.get_action(1);
 	  
-	    if (myid==0) {
-	      if (WHICHEK & 1) {
-		if (K1>1.0 || K1<0.0)
-		  out[12] << setw(15) << E1 << setw(15) << K1
+	      if (myid==0) {
+		if (WHICHEK & 1) {
+		  if (K1>1.0 || K1<0.0)
+		    b.chk << setw(15) << E1 << setw(15) << K1
 			  << setw(15) << E2 << setw(15) << sqrt(j1)
 			  << setw(15) << sqrt(rr1) << setw(15) << sqrt(rr2)
 			  << setw(5) << 1 << endl;
-	      }
+		}
 	    
-	      if (WHICHEK & 2) {
-		if (K2>1.0 || K2<0.0)
-		  out[12] << setw(15) << E2 << setw(15) << K2
+		if (WHICHEK & 2) {
+		  if (K2>1.0 || K2<0.0)
+		    b.chk << setw(15) << E2 << setw(15) << K2
 			  << setw(15) << E1 << setw(15) << sqrt(j2)
 			  << setw(15) << sqrt(rr1) << setw(15) << sqrt(rr2)
 			  << setw(5) << 2 << endl;
+		}
 	      }
-	    }
 	  
-	    double EE, KK;
-	    if (WHICHEK == 1) {
-	      EE = E1;
-	      KK = K1;
-	    }
-	    else if (WHICHEK == 2) {
-	      EE = E2;
-	      KK = K2;
-	    }
-	    else {
-	      EE = 0.5*(E1 + E2);
-	      KK = 0.5*(K1 + K2);
-	    }
-	    
-	    if (EE > Emax or EE < Emin) continue;
-	    if (KK > 1.0 - KTOL or KK < KTOL) continue;
-
-	    double I1_1, I2_1, I1_2, I2_2, ra, rp, O1, O2;
-	    int i1, i2, i11, i12, i21, i22;
-
-	    orb.new_orbit(EE, KK);
-	    ra = orb.apo();
-	    rp = orb.peri();
-	    O1 = orb.get_freq(0);
-	    O2 = orb.get_freq(1);
-
-	    if (actions) {
-
-	      // Get the actions
-	      //
-	      I1 = orb.get_action(0);
-	      I2 = orb.get_action(1);
-
+	      double EE, KK;
 	      if (WHICHEK == 1) {
-		I1_1 = I1;
-		I2_1 = I2;
-		orb.new_orbit(E2, K2);
-		I1_2 = orb.get_action(0);
-		I2_2 = orb.get_action(1);
-	      } else if (WHICHEK == 2) {
-		I1_2 = I1;
-		I2_2 = I2;
-		orb.new_orbit(E1, K1);
-		I1_1 = orb.get_action(0);
-		I2_1 = orb.get_action(1);
-	      } else {
-		orb.new_orbit(E1, K1);
-		I1_1 = orb.get_action(0);
-		I2_1 = orb.get_action(1);
-		orb.new_orbit(E2, K2);
-		I1_2 = orb.get_action(0);
-		I2_2 = orb.get_action(1);
+		EE = E1;
+		KK = K1;
+	      }
+	      else if (WHICHEK == 2) {
+		EE = E2;
+		KK = K2;
+	      }
+	      else {
+		EE = 0.5*(E1 + E2);
+		KK = 0.5*(K1 + K2);
 	      }
-
-	      if (I1_1 < I1min) throw std::runtime_error("I1 < I1min [1]");
-	      if (I1_1 > I1max) throw std::runtime_error("I1 > I1max [1]");
-	      if (I2_1 < I2min) throw std::runtime_error("I2 < I2min [1]");
-	      if (I2_1 > I2max) throw std::runtime_error("I2 > I2max [1]");
-
-	      if (I1_2 < I1min) throw std::runtime_error("I1 < I1min [2]");
-	      if (I1_2 > I1max) throw std::runtime_error("I1 > I1max [2]");
-	      if (I2_2 < I2min) throw std::runtime_error("I2 < I2min [2]");
-	      if (I2_2 > I2max) throw std::runtime_error("I2 > I2max [2]");
-
-	      i1 = (int)floor( (I1 - I1min) / d1 );
-	      i1 = std::max<int>(i1, 0);
-	      i1 = std::min<int>(i1, NUM1-1);
 	    
-	      i2 = (int)floor( (I2 - I2min) / d2 );
-	      i2 = std::max<int>(i2, 0);
-	      i2 = std::min<int>(i2, NUM2-1);
+	      if (EE > Emax or EE < Emin) continue;
+	      if (KK > 1.0 - KTOL or KK < KTOL) continue;
+
+	      double I1_1, I2_1, I1_2, I2_2, ra, rp, O1, O2;
+	      int i1, i2, i11, i12, i21, i22;
+
+	      orb.new_orbit(EE, KK);
+	      ra = orb.apo();
+	      rp = orb.peri();
+	      O1 = orb.get_freq(0);
+	      O2 = orb.get_freq(1);
+
+	      if (actions) {
+
+		// Get the actions
+		//
+		I1 = orb.get_action(0);
+		I2 = orb.get_action(1);
+
+		if (WHICHEK == 1) {
+		  I1_1 = I1;
+		  I2_1 = I2;
+		  orb.new_orbit(E2, K2);
+		  I1_2 = orb.get_action(0);
+		  I2_2 = orb.get_action(1);
+		} else if (WHICHEK == 2) {
+		  I1_2 = I1;
+		  I2_2 = I2;
+		  orb.new_orbit(E1, K1);
+		  I1_1 = orb.get_action(0);
+		  I2_1 = orb.get_action(1);
+		} else {
+		  orb.new_orbit(E1, K1);
+		  I1_1 = orb.get_action(0);
+		  I2_1 = orb.get_action(1);
+		  orb.new_orbit(E2, K2);
+		  I1_2 = orb.get_action(0);
+		  I2_2 = orb.get_action(1);
+		}
+
+		if (I1_1 < I1min) throw std::runtime_error("I1 < I1min [1]");
+		if (I1_1 > I1max) throw std::runtime_error("I1 > I1max [1]");
+		if (I2_1 < I2min) throw std::runtime_error("I2 < I2min [1]");
+		if (I2_1 > I2max) throw std::runtime_error("I2 > I2max [1]");
+
+		if (I1_2 < I1min) throw std::runtime_error("I1 < I1min [2]");
+		if (I1_2 > I1max) throw std::runtime_error("I1 > I1max [2]");
+		if (I2_2 < I2min) throw std::runtime_error("I2 < I2min [2]");
+		if (I2_2 > I2max) throw std::runtime_error("I2 > I2max [2]");
+
+		i1 = (int)floor( (I1 - I1min) / d1 );
+		i1 = std::max<int>(i1, 0);
+		i1 = std::min<int>(i1, NUM1-1);
 	    
-	      if (WHICHEK == 1) {
-		i11 = i1;
-		i21 = i2;
+		i2 = (int)floor( (I2 - I2min) / d2 );
+		i2 = std::max<int>(i2, 0);
+		i2 = std::min<int>(i2, NUM2-1);
+	    
+		if (WHICHEK == 1) {
+		  i11 = i1;
+		  i21 = i2;
 
-		i12 = (int)floor( (I1_2 - I1min) / d1 );
-		i12 = std::max<int>(i12, 0);
-		i12 = std::min<int>(i12, NUM1-1);
+		  i12 = (int)floor( (I1_2 - I1min) / d1 );
+		  i12 = std::max<int>(i12, 0);
+		  i12 = std::min<int>(i12, NUM1-1);
 		
-		i22 = (int)floor( (I2_2 - I2min) / d2 );
-		i22 = std::max<int>(i22, 0);
-		i22 = std::min<int>(i22, NUM2-1);
-	      } else if (WHICHEK == 2) {
-		i12 = i1;
-		i22 = i2;
-
-		i11 = (int)floor( (I1_1 - I1min) / d1 );
-		i11 = std::max<int>(i11, 0);
-		i11 = std::min<int>(i11, NUM1-1);
+		  i22 = (int)floor( (I2_2 - I2min) / d2 );
+		  i22 = std::max<int>(i22, 0);
+		  i22 = std::min<int>(i22, NUM2-1);
+		} else if (WHICHEK == 2) {
+		  i12 = i1;
+		  i22 = i2;
+
+		  i11 = (int)floor( (I1_1 - I1min) / d1 );
+		  i11 = std::max<int>(i11, 0);
+		  i11 = std::min<int>(i11, NUM1-1);
 		
-		i21 = (int)floor( (I2_1 - I2min) / d2 );
-		i21 = std::max<int>(i21, 0);
-		i21 = std::min<int>(i21, NUM2-1);
-	      } else {
-		i11 = (int)floor( (I1_1 - I1min) / d1 );
-		i11 = std::max<int>(i11, 0);
-		i11 = std::min<int>(i11, NUM1-1);
+		  i21 = (int)floor( (I2_1 - I2min) / d2 );
+		  i21 = std::max<int>(i21, 0);
+		  i21 = std::min<int>(i21, NUM2-1);
+		} else {
+		  i11 = (int)floor( (I1_1 - I1min) / d1 );
+		  i11 = std::max<int>(i11, 0);
+		  i11 = std::min<int>(i11, NUM1-1);
 	    
-		i21 = (int)floor( (I2_1 - I2min) / d2 );
-		i21 = std::max<int>(i21, 0);
-		i21 = std::min<int>(i21, NUM2-1);
+		  i21 = (int)floor( (I2_1 - I2min) / d2 );
+		  i21 = std::max<int>(i21, 0);
+		  i21 = std::min<int>(i21, NUM2-1);
 		
-		i12 = (int)floor( (I1_2 - I1min) / d1 );
-		i12 = std::max<int>(i12, 0);
-		i12 = std::min<int>(i12, NUM1-1);
+		  i12 = (int)floor( (I1_2 - I1min) / d1 );
+		  i12 = std::max<int>(i12, 0);
+		  i12 = std::min<int>(i12, NUM1-1);
 	    
-		i22 = (int)floor( (I2_2 - I2min) / d2 );
-		i22 = std::max<int>(i22, 0);
-		i22 = std::min<int>(i22, NUM2-1);
-	      }
+		  i22 = (int)floor( (I2_2 - I2min) / d2 );
+		  i22 = std::max<int>(i22, 0);
+		  i22 = std::min<int>(i22, NUM2-1);
+		}
 	      
-	    } else {
+	      } else {
 
-	      if (E1 < Emin) throw std::runtime_error("E1 < Emin");
-	      if (E1 > Emax) throw std::runtime_error("E1 > Emax");
-	      if (E2 < Emin) throw std::runtime_error("E2 < Emin");
-	      if (E2 > Emax) throw std::runtime_error("E2 > Emax");
+		if (E1 < Emin) throw std::runtime_error("E1 < Emin");
+		if (E1 > Emax) throw std::runtime_error("E1 > Emax");
+		if (E2 < Emin) throw std::runtime_error("E2 < Emin");
+		if (E2 > Emax) throw std::runtime_error("E2 > Emax");
 
-	      if (K1 < KTOL) throw std::runtime_error("K1 < KTOL");
-	      if (K2 < KTOL) throw std::runtime_error("K2 < KTOL");
+		if (K1 < KTOL) throw std::runtime_error("K1 < KTOL");
+		if (K2 < KTOL) throw std::runtime_error("K2 < KTOL");
 
-	      if (K1 > 1.0 - KTOL) throw std::runtime_error("K1 > 1-KTOL");
-	      if (K2 > 1.0 - KTOL) throw std::runtime_error("K2 > 1-KTOL");
+		if (K1 > 1.0 - KTOL) throw std::runtime_error("K1 > 1-KTOL");
+		if (K2 > 1.0 - KTOL) throw std::runtime_error("K2 > 1-KTOL");
 
-	      i11 = (int)floor( (E1 - Emin) / d1 );
-	      if (i11 < 0)     throw std::runtime_error("i11 < 0");
-	      if (i11 >= NUM1) throw std::runtime_error("i11 >= NUM1");
+		i11 = (int)floor( (E1 - Emin) / d1 );
+		if (i11 < 0)     throw std::runtime_error("i11 < 0");
+		if (i11 >= NUM1) throw std::runtime_error("i11 >= NUM1");
 	    
-	      i21 = (int)floor( K1 / d2 );
-	      if (i21 < 0)     throw std::runtime_error("i21 < 0");
-	      if (i21 >= NUM2) throw std::runtime_error("i21 >= NUM2");
+		i21 = (int)floor( K1 / d2 );
+		if (i21 < 0)     throw std::runtime_error("i21 < 0");
+		if (i21 >= NUM2) throw std::runtime_error("i21 >= NUM2");
 
-	      i12 = (int)floor( (E2 - Emin) / d1 );
-	      if (i12 < 0)     throw std::runtime_error("i12 < 0");
-	      if (i12 >= NUM1) throw std::runtime_error("i12 >= NUM1");
+		i12 = (int)floor( (E2 - Emin) / d1 );
+		if (i12 < 0)     throw std::runtime_error("i12 < 0");
+		if (i12 >= NUM1) throw std::runtime_error("i12 >= NUM1");
 	  
-	      i22 = (int)floor( K2 / d2 );
-	      if (i22 < 0)     throw std::runtime_error("i22 < 0");
-	      if (i22 >= NUM2) throw std::runtime_error("i22 >= NUM2");
-
-	      if (Ebins.size()) {
-		auto it = std::lower_bound(Ebins.begin(), Ebins.end(), EE);
-		if (it != Ebins.begin()) it--;
-		i1 = it - Ebins.begin();
-		i1 = max<int>(i1, 0);
-		i1 = min<int>(i1, NUM1-1);
-	      } else {
-		i1 = (int)floor( (EE - Emin) / d1 );
-		i1 = max<int>(i1, 0);
-		i1 = min<int>(i1, NUM1-1);
-	      }
+		i22 = (int)floor( K2 / d2 );
+		if (i22 < 0)     throw std::runtime_error("i22 < 0");
+		if (i22 >= NUM2) throw std::runtime_error("i22 >= NUM2");
+
+		if (Ebins.size()) {
+		  auto it = std::lower_bound(Ebins.begin(), Ebins.end(), EE);
+		  if (it != Ebins.begin()) it--;
+		  i1 = it - Ebins.begin();
+		  i1 = max<int>(i1, 0);
+		  i1 = min<int>(i1, NUM1-1);
+		} else {
+		  i1 = (int)floor( (EE - Emin) / d1 );
+		  i1 = max<int>(i1, 0);
+		  i1 = min<int>(i1, NUM1-1);
+		}
 	    
-	      if (Kpow) {
-		i2 = (int)floor( pow(KK, KPOWER) / d3 );
-		i2 = max<int>(i2, 0);
-		i2 = min<int>(i2, NUM2-1);
-	      } else {
-		i2 = (int)floor( KK / d2 );
-		i2 = max<int>(i2, 0);
-		i2 = min<int>(i2, NUM2-1);
+		if (Kpow) {
+		  i2 = (int)floor( pow(KK, KPOWER) / d3 );
+		  i2 = max<int>(i2, 0);
+		  i2 = min<int>(i2, NUM2-1);
+		} else {
+		  i2 = (int)floor( KK / d2 );
+		  i2 = max<int>(i2, 0);
+		  i2 = min<int>(i2, NUM2-1);
+		}
 	      }
-	    }
 	    
-	    double L1 = 0.0, L2 = 0.0;
-	    for (int k=0; k<3; k++) {
-	      L1 += angmom1[k]*angmom1[k];
-	      L2 += angmom2[k]*angmom2[k];
-	    }
-	    L1 = sqrt(L1);
-	    L2 = sqrt(L2);
+	      double L1 = 0.0, L2 = 0.0;
+	      for (int k=0; k<3; k++) {
+		L1 += angmom1[k]*angmom1[k];
+		L2 += angmom2[k]*angmom2[k];
+	      }
+	      L1 = sqrt(L1);
+	      L2 = sqrt(L2);
 	  
-	    histoC(i1, i2) += 1;
-	    histoM(i1, i2) += pp->mass;
-	    histoE(i1, i2) += pp->mass*(E1 - E2);
-	    histoJ(i1, i2) += pp->mass*(L1 - L2);
-	    histoR(i1, i2) += pp->mass*(Ir2 - Ir1);
-	    histoI(i1, i2) += pp->mass*(Ip2 - Ip1);
-	    histoT(i1, i2) += pp->mass*L1;
+	      b.histoC(i1, i2) += 1;
+	      b.histoM(i1, i2) += mass[i];
+	      b.histoE(i1, i2) += mass[i]*(E1 - E2);
+	      b.histoJ(i1, i2) += mass[i]*(L1 - L2);
+	      b.histoR(i1, i2) += mass[i]*(Ir2 - Ir1);
+	      b.histoI(i1, i2) += mass[i]*(Ip2 - Ip1);
+	      b.histoT(i1, i2) += mass[i]*L1;
 	    
-	    rapo  (i1, i2) += pp->mass*ra;
-	    rperi (i1, i2) += pp->mass*rp;
+	      b.rapo  (i1, i2) += mass[i]*ra;
+	      b.rperi (i1, i2) += mass[i]*rp;
 
-	    omega1(i1, i2) += pp->mass*O1;
-	    omega2(i1, i2) += pp->mass*O2;
+	      b.omega1(i1, i2) += mass[i]*O1;
+	      b.omega2(i1, i2) += mass[i]*O2;
 
-	    histo1(i11, i21) += pp->mass;
-	    histo2(i12, i22) += pp->mass;
+	      b.histo1(i11, i21) += mass[i];
+	      b.histo2(i12, i22) += mass[i];
 	    
-	    histo1_1d[0](i11) += pp->mass;
-	    histo2_1d[0](i12) += pp->mass;
-	    histo1_1d[1](i21) += pp->mass;
-	    histo2_1d[1](i22) += pp->mass;
+	      b.histo1_1d[0](i11) += mass[i];
+	      b.histo2_1d[0](i12) += mass[i];
+	      b.histo1_1d[1](i21) += mass[i];
+	      b.histo2_1d[1](i22) += mass[i];
 	      
-	    if (LZDIST and myid==0) {
-	      if (KK>KMIN && KK<KMAX && EE>EMIN && EE<EMAX)
-		dout << setw(15) << EE
-		     << setw(15) << KK
-		     << setw(15) << angmom1[2]
-		     << setw(15) << angmom2[2]
-		     << setw(15) << angmom2[2] - angmom1[2]
-		     << endl;
-	    }
+	      if (LZDIST and myid==0) {
+		if (KK>KMIN && KK<KMAX && EE>EMIN && EE<EMAX)
+		  b.dist << setw(15) << EE
+			 << setw(15) << KK
+			 << setw(15) << angmom1[2]
+			 << setw(15) << angmom2[2]
+			 << setw(15) << angmom2[2] - angmom1[2]
+			 << endl;
+	      }
 	  
-	    int ir;
-	    if (LOGR) 
-	      ir = (int)floor( (log(sqrt(rr1)) - rhmin) / dR );
-	    else
-	      ir = (int)floor( (sqrt(rr1) - rhmin) / dR );
-	    ir = max<int>(ir, 0);
-	    ir = min<int>(ir, NUMR-1);
+	      int ir;
+	      if (LOGR) 
+		ir = (int)floor( (log(sqrt(rr1)) - rhmin) / dR );
+	      else
+		ir = (int)floor( (sqrt(rr1) - rhmin) / dR );
+	      ir = max<int>(ir, 0);
+	      ir = min<int>(ir, NUMR-1);
 	  
-	    histoP[ir] += pp->mass*(E1 - E2);
-	    histoL[ir] += pp->mass*(angmom2[2] - angmom1[2]);
-	    histPr[ir] += pp->mass*(E1 - E2)*2.0/sqrt(E1*E1 + E2*E2);
-	    histLr[ir] += pp->mass*(angmom2[2] - angmom1[2])*2.0/
-	      sqrt(angmom1[2]*angmom1[2] + angmom2[2]*angmom2[2]);
-	    histoN[ir] += pp->mass;
-	    histoS[ir] += pp->mass*L1;
+	      b.histoP[ir] += mass[i]*(E1 - E2);
+	      b.histoL[ir] += mass[i]*(angmom2[2] - angmom1[2]);
+	      b.histPr[ir] += mass[i]*(E1 - E2)*2.0/sqrt(E1*E1 + E2*E2);
+	      b.histLr[ir] += mass[i]*(angmom2[2] - angmom1[2])*2.0/
+		sqrt(angmom1[2]*angmom1[2] + angmom2[2]*angmom2[2]);
+	      b.histoN[ir] += mass[i];
+	      b.histoS[ir] += mass[i]*L1;
 	    
-	    total++;
-	  }
-	  catch (const std::runtime_error& error) {
-	    if (false)		// Verbose output
-	       std::cout << "error [" << reject << "]: "
-			 << error.what() << std::endl;
-	    reject++;		// Tally grid rejections
-	  }
-	  Ntot++;
-	} else rover++;
+	      b.total++;
+	    }
+	    catch (const std::runtime_error& error) {
+	      if (false)		// Verbose output
+		 std::cout << "error [" << b.reject << "]: "
+			   << error.what() << std::endl;
+	      b.reject++;		// Tally grid rejections
+	    }
+	    b.Ntot++;
+	  } else b.rover++;
 
-      } else pmiss++;
+	} else b.pmiss++;
       
+      }
+    };
+
+    N = 0;
+    for (bool ok=next(true); ok; ok=next(false)) {
+
+      if (nthrds>1) ThreadPool::instance().run(nthrds, work);
+      else          work(0);
+
+      // Diagnostic output in particle order
+      //
+      if (myid==0) {
+	for (auto & b : bins) {
+	  out[12] << b.chk.str();
+	  b.chk.str("");
+	  if (LZDIST) dout << b.dist.str();
+	  b.dist.str("");
+	}
+      }
+
       if (myid==0 and NREPORT) {
-	if (!((N+1)%NREPORT))
+	if (N/NREPORT != (N+nchunk)/NREPORT)
 	  std::cout << "\rProcessed: " 
-		    << std::setw(10) << (N+1)*numprocs << std::flush;
-	N++;
+		    << std::setw(10) << (N+nchunk)*numprocs << std::flush;
       }
-
+      N += nchunk;
     }
     // END: particle loop
 
@@ -1105,6 +1229,40 @@ main(int argc, char **argv)
       std::cout << std::endl << std::string(40, '-') << std::endl;
   }
   // END: file loop
+
+  // Sum the thread bins
+  //
+  for (auto & b : bins) {
+    histoC += b.histoC;
+    histoM += b.histoM;
+    histoE += b.histoE;
+    histoJ += b.histoJ;
+    histoR += b.histoR;
+    histoI += b.histoI;
+    histoT += b.histoT;
+    histo1 += b.histo1;
+    histo2 += b.histo2;
+    rapo   += b.rapo;
+    rperi  += b.rperi;
+    omega1 += b.omega1;
+    omega2 += b.omega2;
+    histoP += b.histoP;
+    histoL += b.histoL;
+    histPr += b.histPr;
+    histLr += b.histLr;
+    histoS += b.histoS;
+    histoN += b.histoN;
+    for (int k=0; k<2; k++) {
+      histo1_1d[k] += b.histo1_1d[k];
+      histo2_1d[k] += b.histo2_1d[k];
+    }
+    reject += b.reject;
+    total  += b.total;
+    rover  += b.rover;
+    emiss  += b.emiss;
+    pmiss  += b.pmiss;
+    Ntot   += b.Ntot;
+  }
   
   
   // Send to root
@@ -13,12 +13,14 @@
 #include <string>
 #include <random>
 #include <list>
+#include <thread>
 
 using namespace std;
 
 #include <StringTok.H>
 #include <header.H>
 #include <PSP.H>
+#include <ThreadPool.H>
 #include <cxxopts.H>
 
 int
@@ -28,6 +30,7 @@ main(int argc, char **argv)
   double time=1e20;
   bool verbose = false;
   bool input   = false;
+  int nthrds   = std::max<int>(1, std::thread::hardware_concurrency());
   std::string cname("comp"), new_dir("./"), filename;
 
   // Parse command line
@@ -46,6 +49,8 @@ main(int argc, char **argv)
      cxxopts::value<std::string>(new_dir)->default_value("./"))
     ("f,filename", "input PSP file",
      cxxopts::value<std::string>(filename))
+    ("n,threads", "number of threads for formatting (default: all)",
+     cxxopts::value<int>(nthrds))
     ;
 
   cxxopts::ParseResult vm;
@@ -110,8 +115,12 @@ main(int argc, char **argv)
 
 				// Dump ascii for each component
 				// -----------------------------
+  nthrds = std::max<int>(1, nthrds);
+  psp->setThreads(nthrds);
+
   PSPstanza *stanza;
-  SParticle* part;
+  PSPchunk chunk;
+  std::vector<std::string> buf(nthrds);
 
   for (stanza=psp->GetStanza(); stanza!=0; stanza=psp->NextStanza()) {
     
@@ -134,34 +143,42 @@ main(int argc, char **argv)
 	<< setw(10) << stanza->comp.ndatr 
 	<< endl;
 
-    const int bunchcnt = 16384;
-    int cnt = 0;
-    std::ostringstream sout;
+				// Each thread formats a contiguous
+				// slice of the chunk; the slices are
+				// written in order
+				// ----------------------------------
+    bool index = not input and stanza->index_size;
 
-    for (part=psp->GetParticle(); part!=0; part=psp->NextParticle()) {
+    auto format = [&](int id)
+    {
+      size_t beg = chunk.size*id/nthrds, end = chunk.size*(id+1)/nthrds;
+      std::ostringstream sout;
 
-      if (not input and stanza->index_size)
-	sout << std::setw(18) << part->indx();
+      for (size_t n=beg; n<end; n++) {
 
-      sout << std::setw(18) << part->mass();
-      for (int i=0; i<3; i++) sout << std::setw(18) << part->pos(i);
-      for (int i=0; i<3; i++) sout << std::setw(18) << part->vel(i);
-      if (not input) sout << std::setw(18) << part->phi();
-      for (int i=0; i<part->niatr(); i++)
-	sout << std::setw(12) << part->iatr(i);
-      for (int i=0; i<part->ndatr(); i++)
-	sout << std::setw(18) << part->datr(i);
+	if (index)
+	  sout << std::setw(18) << chunk.indx[n];
 
-      sout << std::endl;	// End the record
+	sout << std::setw(18) << chunk.mass[n];
+	for (int i=0; i<3; i++) sout << std::setw(18) << chunk.pos[3*n+i];
+	for (int i=0; i<3; i++) sout << std::setw(18) << chunk.vel[3*n+i];
+	if (not input) sout << std::setw(18) << chunk.phi[n];
+	for (int i=0; i<chunk.niatr; i++)
+	  sout << std::setw(12) << chunk.iatr[n*chunk.niatr+i];
+	for (int i=0; i<chunk.ndatr; i++)
+	  sout << std::setw(18) << chunk.datr[n*chunk.ndatr+i];
 
-      if (++cnt==bunchcnt) {	// Write and reset the buffer
-	out << sout.str();
-	sout.str("");
-	cnt = 0;
+	sout << std::endl;	// End the record
       }
+
+      buf[id] = sout.str();
+    };
+
+    for (bool ok=psp->GetChunk(chunk); ok; ok=psp->NextChunk(chunk)) {
+      if (nthrds>1) ThreadPool::instance().run(nthrds, format);
+      else          format(0);
+      for (auto & b : buf) out << b;
     }
-				// Clear the buffer
-    if (sout.str().size()>0) out << sout.str();
     
   }
   
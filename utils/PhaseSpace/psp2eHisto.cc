@@ -19,6 +19,7 @@ using namespace std;
 #include <vector>
 #include <string>
 #include <locale>
+#include <thread>
 
 #include <Species.H>
 
@@ -28,6 +29,7 @@ using namespace std;
 #include <libvars.H>		// EXP library globals
 #include <header.H>
 #include <PSP.H>
+#include <ThreadPool.H>
 
 //
 // VTK stuff
@@ -171,7 +173,7 @@ main(int ac, char **av)
   double time, Emin, Emax, dE, Xmin, Xmax, dX, Lunit, Tunit;
   bool verbose = false, logE = false, PVD = false;
   std::string cname, rtag;
-  int comp, sindx, eindx, hindx, dim;
+  int comp, sindx, eindx, hindx, dim, nthrds;
 
   // Parse command line
   //
@@ -216,6 +218,8 @@ main(int ac, char **av)
      cxxopts::value<int>(iend)->default_value("1000000"))
     ("stride", "sequence counter stride",
      cxxopts::value<int>(istride)->default_value("1"))
+    ("n,threads", "number of threads for binning (0 for all)",
+     cxxopts::value<int>(nthrds)->default_value("0"))
     ;
 
   cxxopts::ParseResult vm;
@@ -329,6 +333,27 @@ main(int ac, char **av)
     Eelc[n].resize(nEbin);
   }
 
+  if (nthrds<=0) nthrds = std::thread::hardware_concurrency();
+  nthrds = std::max<int>(1, nthrds);
+
+  // Per-thread bins and tallies, summed after each stanza
+  //
+  struct Bins
+  {
+    I2Vector Eion, Eelc;
+    unsigned total, gridded, pout, eEout, eIout;
+  };
+
+  std::vector<Bins> bins(nthrds);
+  for (auto & b : bins) {
+    b.Eion.resize(nLbin);
+    b.Eelc.resize(nLbin);
+    for (int n=0; n<nLbin; n++) {
+      b.Eion[n].resize(nEbin);
+      b.Eelc[n].resize(nEbin);
+    }
+  }
+
   bool first = true;
   
   for (int n=ibeg; n<=iend; n+=istride) {
@@ -337,7 +362,7 @@ main(int ac, char **av)
     file << "OUT." << rtag << "." << std::setfill('0') << std::setw(5) << n;
     
     std::ifstream in(file.str());
-    if (in) {
+    if (!in) {
       cerr << "Error opening file <" << file.str() << "> for input."
 	   << std::endl
 	   << "Assuming end of sequence . . . continuing."
@@ -355,6 +380,8 @@ main(int ac, char **av)
     if (vm.count("SPL")) psp = std::make_shared<PSPspl>(file.str());
     else                 psp = std::make_shared<PSPout>(file.str());
 
+    psp->setThreads(nthrds);
+
 				// Now write a summary
 				// -------------------
     if (verbose) {
@@ -366,10 +393,8 @@ main(int ac, char **av)
 		<< psp->CurrentTime() << ">" << std::endl;
     }
 
-    vector<double> pos(3), vel(3);
-
     PSPstanza *stanza;
-    SParticle* part;
+    PSPchunk chunk;
 
     double T = psp->CurrentTime();
     if (verbose) {
@@ -380,62 +405,107 @@ main(int ac, char **av)
     
       if (stanza->name != cname) continue;
 
-      unsigned total = 0, gridded = 0, pout = 0, eEout = 0, eIout = 0;
-
 				// Clear counters
 				// --------------
-      for (int n=0; n<nLbin; n++) {
-	std::fill(Eion[n].begin(), Eion[n].end(), 0);
-	std::fill(Eelc[n].begin(), Eelc[n].end(), 0);
-      }
-
-      for (part=psp->GetParticle(); part!=0; part=psp->NextParticle()) {
-
-	total++;
-
-	int Pindx = floor( (part->pos(dim) - Xmin)/dX );
-
-	if (part->pos(dim) < Xmin or part->pos(dim) > Xmax) {
-	  pout++;
-	  continue;
+      for (auto & b : bins) {
+	for (int n=0; n<nLbin; n++) {
+	  std::fill(b.Eion[n].begin(), b.Eion[n].end(), 0);
+	  std::fill(b.Eelc[n].begin(), b.Eelc[n].end(), 0);
 	}
+	b.total = b.gridded = b.pout = b.eEout = b.eIout = 0;
+      }
 
-	if (Pindx < 0 or Pindx >= nLbin) {
-	  pout++;
-	  continue;
+				// Each thread bins a contiguous slice
+				// of the chunk into its own counters
+				// -----------------------------------
+      auto work = [&](int id)
+      {
+	Bins & b = bins[id];
+	size_t beg = chunk.size*id/nthrds, end = chunk.size*(id+1)/nthrds;
+
+	for (size_t p=beg; p<end; p++) {
+
+	  b.total++;
+
+	  double x = chunk.pos[3*p+dim];
+	  int Pindx = floor( (x - Xmin)/dX );
+
+	  if (x < Xmin or x > Xmax) {
+	    b.pout++;
+	    continue;
+	  }
+
+	  if (Pindx < 0 or Pindx >= nLbin) {
+	    b.pout++;
+	    continue;
+	  }
+
+	  b.gridded++;
+
+	  double kEe = 0.0, kEi = 0.0;
+	  for (size_t i=0; i<3; i++) {
+	    double ve = chunk.datr[p*chunk.ndatr + eindx + i];
+	    kEe += ve*ve;
+	    double vi = chunk.vel[3*p+i];
+	    kEi += vi*vi;
+	  }
+
+	  kEe *= KEfac * atomic_mass[0];
+	  kEi *= KEfac * mu;
+
+	  if (logE) {
+	    kEe = log10(kEe);
+	    kEi = log10(kEi);
+	  }
+
+	  if (kEe >= Emin and kEe < Emax) {
+	    int Eindx = floor( (kEe - Emin)/dE );
+	    if (Eindx >= 0 and Eindx < nEbin) b.Eelc[Pindx][Eindx]++;
+	    else b.eEout++;
+	  }
+
+	  if (kEi >= Emin and kEi < Emax) {
+	    int Eindx = floor( (kEi - Emin)/dE );
+	    if (Eindx >= 0 and Eindx < nEbin) b.Eion[Pindx][Eindx]++;
+	    else b.eIout++;
+	  }
 	}
+      };
 
-	gridded++;
-
-	double kEe = 0.0, kEi = 0.0;
-	for (size_t i=0; i<3; i++) {
-	  double ve = part->datr(eindx+i);
-	  kEe += ve*ve;
-	  double vi = part->vel(i);
-	  kEi += vi*vi;
-	}
+      if (stanza->comp.ndatr < eindx + 3) {
+	std::cerr << "Component <" << cname << "> has " << stanza->comp.ndatr
+		  << " real attributes; electron velocities at " << eindx
+		  << " need " << eindx + 3 << std::endl;
+	exit(-1);
+      }
 
-	kEe *= KEfac * atomic_mass[0];
-	kEi *= KEfac * mu;
+      for (bool ok=psp->GetChunk(chunk); ok; ok=psp->NextChunk(chunk)) {
+	if (nthrds>1) ThreadPool::instance().run(nthrds, work);
+	else          work(0);
+      } // END: chunk loop
 
-	if (logE) {
-	  kEe = log10(kEe);
-	  kEi = log10(kEi);
-	}
+				// Sum the thread bins
+				// -------------------
+      unsigned total = 0, gridded = 0, pout = 0, eEout = 0, eIout = 0;
 
-	if (kEe >= Emin and kEe < Emax) {
-	  int Eindx = floor( (kEe - Emin)/dE );
-	  if (Eindx >= 0 and Eindx < nEbin) Eelc[Pindx][Eindx]++;
-	  else eEout++;
-	}
+      for (int n=0; n<nLbin; n++) {
+	std::fill(Eion[n].begin(), Eion[n].end(), 0);
+	std::fill(Eelc[n].begin(), Eelc[n].end(), 0);
+      }
 
-	if (kEi >= Emin and kEi < Emax) {
-	  int Eindx = floor( (kEi - Emin)/dE );
-	  if (Eindx >= 0 and Eindx < nEbin) Eion[Pindx][Eindx]++;
-	  else eIout++;
+      for (auto & b : bins) {
+	for (int n=0; n<nLbin; n++) {
+	  for (int e=0; e<nEbin; e++) {
+	    Eion[n][e] += b.Eion[n][e];
+	    Eelc[n][e] += b.Eelc[n][e];
+	  }
 	}
-
-      } // END: Particle loop
+	total   += b.total;
+	gridded += b.gridded;
+	pout    += b.pout;
+	eEout   += b.eEout;
+	eIout   += b.eIout;
+      }
 
       std::cout << "File <" << file.str() << ">: "
 		<< gridded << " out of " << total << " with "
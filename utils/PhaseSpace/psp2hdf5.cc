@@ -2,8 +2,10 @@
 #include <fstream>
 #include <string>
 #include <memory>
+#include <thread>
 
 #include <PSP.H>
+#include <ThreadPool.H>
 #include <H5Cpp.h>
 #include <cxxopts.H>		// Option parsing
 #include <libvars.H>		// EXP library globals
@@ -22,6 +24,7 @@ main(int argc, char **argv)
   std::vector<int>         numbValue(6, 0);
   std::vector<bool>        massFixed(6, true);
   bool verbose = false;
+  int nthrds = std::max<int>(1, std::thread::hardware_concurrency());
 
 
   cxxopts::Options options(argv[0], "\nMake a Gadget2-style HDF5 file from a PSP file and a Gadget template file.\nNo cosmological parameters are set.  No subgrid parameters will be set.\nUse the numerical flags to assign component names to Gadget particle types.\n");
@@ -49,6 +52,8 @@ main(int argc, char **argv)
      cxxopts::value<std::string>(partNames[4]))
     ("5,bndry",  "PSP component name for boundary particles (not used)",
      cxxopts::value<std::string>(partNames[5]))
+    ("n,threads", "number of threads for conversion (default: all)",
+     cxxopts::value<int>(nthrds))
     ;
 
   auto vm = options.parse(argc, argv);
@@ -79,6 +84,9 @@ main(int argc, char **argv)
 
   PSPptr psp = PSP::getPSP(pspfile, dir, verbose);
 
+  nthrds = std::max<int>(1, nthrds);
+  psp->setThreads(nthrds);
+
   // Now write a summary
   // -------------------
   if (verbose) {
@@ -338,82 +346,100 @@ main(int argc, char **argv)
 
 	if (k.second.find(stanza->name) == 0) {
 
-	  // Create coordinates and indices
-	  //
-	  std::vector<float>    posv(3*stanza->comp.nbod);
-	  std::vector<float>    velv(3*stanza->comp.nbod);
-	  std::vector<unsigned> indx(  stanza->comp.nbod);
-	  std::vector<float>    masv;
-
-	  if (not massFixed[k.first]) masv.resize(stanza->comp.nbod);
-
-	  unsigned cntr=0;
-	  for (auto part=psp->GetParticle(); part!=0; part=psp->NextParticle()) {
-
-	    if (stanza->index_size) indx[cntr] = part->indx();
-	    else indx[cntr] = cntr + 1;
-
-	    for (int i=0; i<3; i++)
-	      posv[3*cntr + i] = part->pos(i);
-
-	    for (int i=0; i<3; i++)
-	      velv[3*cntr + i] = part->vel(i);
-	    
-	    if (not massFixed[k.first]) masv[cntr] = part->mass();
-
-	    cntr++;
-	  }
-      
 	  // Create the PartType group
 	  //
 	  std::ostringstream str;
 	  str << "/PartType" << k.first;
 	  auto partgrp = std::make_shared<H5::Group>(file->createGroup(str.str()));
-    
-	  hsize_t dim2[] = {static_cast<hsize_t>(stanza->comp.nbod), 3};
-      
-	  // The length of dim (which is one here)
-	  int rank = sizeof(dim2) / sizeof(hsize_t);
-	  
-	  // preparation of a dataset and a file.
-	  H5::DataSpace space(rank, dim2);
-	  
+
+	  // The datasets are chunked so that each chunk of particles
+	  // read from the PSP file is written as it arrives
+	  //
+	  hsize_t nbod = stanza->comp.nbod;
+	  hsize_t hchunk = std::min<hsize_t>(nbod, PSP::chunkSize);
+
+	  H5::DSetCreatPropList plist1, plist2;
+	  if (hchunk) {
+	    hsize_t cdim1[] = {hchunk};
+	    hsize_t cdim2[] = {hchunk, 3};
+	    plist1.setChunk(1, cdim1);
+	    plist2.setChunk(2, cdim2);
+	  }
+
+	  hsize_t dim1[] = {nbod};
+	  hsize_t dim2[] = {nbod, 3};
+	  H5::DataSpace space1(1, dim1);
+	  H5::DataSpace space2(2, dim2);
+
 	  auto dataset1 = std::make_shared<H5::DataSet>
 	    (partgrp->createDataSet("Coordinates",
 				    H5::PredType::NATIVE_FLOAT,
-				    space));
-	  
-	  dataset1->write(&posv[0], H5::PredType::NATIVE_FLOAT);
+				    space2, plist2));
 
 	  auto dataset2 = std::make_shared<H5::DataSet>
 	    (partgrp->createDataSet("Velocities",
 				    H5::PredType::NATIVE_FLOAT,
-				    space));
-	  
-	  dataset2->write(&velv[0], H5::PredType::NATIVE_FLOAT);
-
-
-	  hsize_t dim1[] = {static_cast<hsize_t>(stanza->comp.nbod)};
-      
-	  // The length of dim (which is one here)
-	  rank = sizeof(dim1) / sizeof(hsize_t);
-	  
-	  // preparation of a dataset and a file.
-	  H5::DataSpace space1(rank, dim1);
+				    space2, plist2));
 
 	  auto dataset3 = std::make_shared<H5::DataSet>
 	    (partgrp->createDataSet("ParticleIDs",
 				    H5::PredType::NATIVE_UINT,
-				    space1));
-	  
-	  dataset3->write(&indx[0], H5::PredType::NATIVE_UINT);
+				    space1, plist1));
 
-	  if (masv.size()) {
-	    auto dataset4 = std::make_shared<H5::DataSet>
-	    (partgrp->createDataSet("Masses",
-				    H5::PredType::NATIVE_FLOAT,
-				    space1));
-	    dataset4->write(&masv[0], H5::PredType::NATIVE_FLOAT);
+	  std::shared_ptr<H5::DataSet> dataset4;
+	  if (not massFixed[k.first])
+	    dataset4 = std::make_shared<H5::DataSet>
+	      (partgrp->createDataSet("Masses",
+				      H5::PredType::NATIVE_FLOAT,
+				      space1, plist1));
+
+	  // Convert and write one chunk at a time
+	  //
+	  std::vector<float>    posv, velv, masv;
+	  std::vector<unsigned> indx;
+	  PSPchunk chunk;
+
+	  for (bool ok=psp->GetChunk(chunk); ok; ok=psp->NextChunk(chunk)) {
+
+	    size_t n = chunk.size;
+	    posv.resize(3*n);
+	    velv.resize(3*n);
+	    indx.resize(n);
+	    if (dataset4) masv.resize(n);
+
+	    auto work = [&](int id)
+	    {
+	      size_t beg = n*id/nthrds, end = n*(id+1)/nthrds;
+	      for (size_t i=beg; i<end; i++) {
+		if (stanza->index_size) indx[i] = chunk.indx[i];
+		else indx[i] = chunk.first + i + 1;
+
+		for (int j=0; j<3; j++) {
+		  posv[3*i+j] = chunk.pos[3*i+j];
+		  velv[3*i+j] = chunk.vel[3*i+j];
+		}
+
+		if (dataset4) masv[i] = chunk.mass[i];
+	      }
+	    };
+
+	    if (nthrds>1) ThreadPool::instance().run(nthrds, work);
+	    else          work(0);
+
+	    hsize_t off1[] = {chunk.first}, cnt1[] = {n};
+	    hsize_t off2[] = {chunk.first, 0}, cnt2[] = {n, 3};
+
+	    H5::DataSpace mem1(1, cnt1), mem2(2, cnt2);
+	    H5::DataSpace file1 = dataset3->getSpace();
+	    H5::DataSpace file2 = dataset1->getSpace();
+	    file1.selectHyperslab(H5S_SELECT_SET, cnt1, off1);
+	    file2.selectHyperslab(H5S_SELECT_SET, cnt2, off2);
+
+	    dataset1->write(posv.data(), H5::PredType::NATIVE_FLOAT, mem2, file2);
+	    dataset2->write(velv.data(), H5::PredType::NATIVE_FLOAT, mem2, file2);
+	    dataset3->write(indx.data(), H5::PredType::NATIVE_UINT,  mem1, file1);
+	    if (dataset4)
+	      dataset4->write(masv.data(), H5::PredType::NATIVE_FLOAT, mem1, file1);
 	  }
 
 	  break;
@@ -216,7 +216,7 @@ main(int ac, char **av)
 
       if (Ndens) {
 	using point3 = KDtree::point <double, 3>;
-	using tree3  = KDtree::kdtree<double, 3>;
+	using tree3  = KDtree::flatTree<double, 3>;
 
 	std::vector<double> mass;
 	std::vector<point3> points;
@@ -228,17 +228,18 @@ main(int ac, char **av)
 	
 	tree3 tree(points.begin(), points.end());
 
-	for (int k=0; k<points.size(); k++) {
-	  // Stride the density computation
-	  if (k % iskip == 0) {
-	    auto ret = tree.nearestN(points[k], Ndens);
-
-	    double volume = 4.0*M_PI/3.0*std::pow(std::get<2>(ret), 3.0);
-	    if (volume>0.0)
-	      dens->InsertNextValue(std::get<1>(ret)/volume);
-	    else
-	      dens->InsertNextValue(1.0e-18);
-	  }
+	// Stride the density computation
+	std::vector<point3> query;
+	for (int k=0; k<points.size(); k+=iskip) query.push_back(points[k]);
+
+	auto res = tree.nearestN(query, Ndens);
+
+	for (auto & r : res) {
+	  double volume = 4.0*M_PI/3.0*std::pow(r.second, 3.0);
+	  if (volume>0.0)
+	    dens->InsertNextValue(r.first/volume);
+	  else
+	    dens->InsertNextValue(1.0e-18);
 	}
       }
 